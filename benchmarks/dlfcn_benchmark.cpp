@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+
+#include <benchmark/benchmark.h>
+
+// Repeated lookups of the same symbol in the same handle are answered from the
+// linker's per-handle cache, so most of what's left is the linker's fixed
+// per-call overhead. That includes a ScopedTrace, so with tracing disabled
+// (the usual case) this measures the cost of the systrace enabled check.
+static void BM_dlfcn_dlsym_repeated(benchmark::State& state) {
+  void* handle = dlopen("libc.so", RTLD_NOW);
+  if (handle == nullptr) {
+    handle = dlopen("libc.so.6", RTLD_NOW);
+  }
+  if (handle == nullptr) {
+    state.SkipWithError(dlerror());
+    return;
+  }
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(dlsym(handle, "strlen"));
+  }
+
+  dlclose(handle);
+}
+BENCHMARK(BM_dlfcn_dlsym_repeated);
+
+// Each name is looked up once per pass, and there are more of them than the
+// linker caches per handle, so every lookup searches all of the handle's
+// libraries (in the order the linker remembers for the handle).
+static void BM_dlfcn_dlsym_missing(benchmark::State& state) {
+  void* handle = dlopen("libc.so", RTLD_NOW);
+  if (handle == nullptr) {
+    handle = dlopen("libc.so.6", RTLD_NOW);
+  }
+  if (handle == nullptr) {
+    state.SkipWithError(dlerror());
+    return;
+  }
+
+  char names[1024][32];
+  for (size_t i = 0; i < 1024; ++i) {
+    snprintf(names[i], sizeof(names[i]), "no_such_symbol_%zu", i);
+  }
+
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(dlsym(handle, names[i++ % 1024]));
+  }
+
+  dlclose(handle);
+}
+BENCHMARK(BM_dlfcn_dlsym_missing);
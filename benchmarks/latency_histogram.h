@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BIONIC_BENCHMARKS_LATENCY_HISTOGRAM_H
+#define BIONIC_BENCHMARKS_LATENCY_HISTOGRAM_H
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <benchmark/benchmark.h>
+
+// Throughput alone hides the convoys and lost wakeups that make contended
+// locks slow in practice, so the contended benchmarks also record how long
+// each operation took and report the tail in the benchmark label.
+//
+// Every benchmark thread records into its own slot, so recording doesn't
+// add sharing of its own. Thread 0 clears the slots before its first
+// KeepRunning() and merges them after its last, relying on the benchmark
+// library holding all threads at a barrier at both points.
+class LatencyHistogram {
+ public:
+  static uint64_t NowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+  void Start(const benchmark::State& state) {
+    if (state.thread_index == 0) {
+      memset(slots_, 0, sizeof(slots_));
+    }
+  }
+
+  // Bucket i counts operations that took less than 2^i ns.
+  void Record(const benchmark::State& state, uint64_t ns) {
+    size_t bucket = (ns == 0) ? 0 : 64 - __builtin_clzll(ns);
+    if (bucket >= kBuckets) {
+      bucket = kBuckets - 1;
+    }
+    ++slots_[state.thread_index % kMaxThreads].buckets[bucket];
+  }
+
+  // 'detail', if given, is appended to the label.
+  void Finish(benchmark::State& state, const char* detail = nullptr) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    uint64_t merged[kBuckets] = {};
+    uint64_t total = 0;
+    for (size_t t = 0; t < kMaxThreads; ++t) {
+      for (size_t b = 0; b < kBuckets; ++b) {
+        merged[b] += slots_[t].buckets[b];
+        total += slots_[t].buckets[b];
+      }
+    }
+    if (total == 0) {
+      return;
+    }
+
+    char label[512];
+    snprintf(label, sizeof(label), "p50<%" PRIu64 "ns p99<%" PRIu64 "ns p99.9<%" PRIu64 "ns%s%s",
+             Percentile(merged, total, 500), Percentile(merged, total, 990),
+             Percentile(merged, total, 999), detail ? " " : "", detail ? detail : "");
+    state.SetLabel(label);
+  }
+
+ private:
+  static constexpr size_t kBuckets = 40;
+  static constexpr size_t kMaxThreads = 64;
+
+  // Returns the upper bound of the bucket holding the given per-mille rank.
+  static uint64_t Percentile(const uint64_t* buckets, uint64_t total, uint64_t per_mille) {
+    uint64_t rank = (total * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+      seen += buckets[b];
+      if (seen >= rank) {
+        return 1ULL << b;
+      }
+    }
+    return 1ULL << (kBuckets - 1);
+  }
+
+  struct alignas(64) Slot {
+    uint64_t buckets[kBuckets];
+  };
+  Slot slots_[kMaxThreads];
+};
+
+#endif  // BIONIC_BENCHMARKS_LATENCY_HISTOGRAM_H
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "loader_test_libs.h"
+
+static void* OpenLib(benchmark::State& state, const std::string& name) {
+  void* handle = dlopen(LoaderTestLibPath(name).c_str(), RTLD_NOW);
+  if (handle == nullptr) {
+    state.SkipWithError(dlerror());
+  }
+  return handle;
+}
+
+// range(0) is the number of symbols the library defines: 16, 256 or 4096.
+static std::string SymbolsLib(int64_t count) {
+  return "libtest_linker_benchmark_symbols_" + std::to_string(count) + ".so";
+}
+
+// The names of the symbols in SymbolsLib(count): see
+// tests/libs/linker_benchmark_symbols.h for how they're made up.
+static std::vector<std::string> SymbolNames(int64_t count) {
+  int digits = (count == 16) ? 1 : (count == 256) ? 2 : 3;
+  int64_t per_prefix = 1 << (3 * digits);
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < count; ++i) {
+    char name[64];
+    snprintf(name, sizeof(name), "linker_benchmark_symbol_%d%0*o",
+             static_cast<int>(1 + i / per_prefix), digits, static_cast<unsigned>(i % per_prefix));
+    names.push_back(name);
+  }
+  return names;
+}
+
+#define SYMBOL_COUNTS Arg(16)->Arg(256)->Arg(4096)
+
+// Loads and unloads a library that isn't otherwise loaded, so every
+// iteration maps, relocates and unmaps it.
+static void BM_linker_dlopen_cold(benchmark::State& state) {
+  std::string path = LoaderTestLibPath(SymbolsLib(state.range(0)));
+  while (state.KeepRunning()) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW);
+    if (handle == nullptr) {
+      state.SkipWithError(dlerror());
+      break;
+    }
+    dlclose(handle);
+  }
+}
+BENCHMARK(BM_linker_dlopen_cold)->SYMBOL_COUNTS;
+
+// Opens a library that's already loaded, which only has to find it.
+static void BM_linker_dlopen_warm(benchmark::State& state) {
+  void* handle = OpenLib(state, SymbolsLib(16));
+  if (handle == nullptr) return;
+
+  std::string path = LoaderTestLibPath(SymbolsLib(16));
+  while (state.KeepRunning()) {
+    dlclose(dlopen(path.c_str(), RTLD_NOW));
+  }
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dlopen_warm);
+
+// Loads and unloads a chain of range(0) libraries, each needing the next.
+static void BM_linker_dlopen_chain(benchmark::State& state) {
+  std::string path = LoaderTestLibPath("libtest_linker_benchmark_chain_" +
+                             std::to_string(state.range(0) - 1) + ".so");
+  while (state.KeepRunning()) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW);
+    if (handle == nullptr) {
+      state.SkipWithError(dlerror());
+      break;
+    }
+    dlclose(handle);
+  }
+  state.SetItemsProcessed(uint64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_linker_dlopen_chain)->Arg(1)->Arg(4)->Arg(8);
+
+// Loads and unloads a library with 4096 symbol relocations against a library
+// that stays loaded, so the time is mostly symbol lookup for relocation.
+static void BM_linker_relocate(benchmark::State& state) {
+  void* symbols = OpenLib(state, SymbolsLib(4096));
+  if (symbols == nullptr) return;
+
+  std::string path = LoaderTestLibPath("libtest_linker_benchmark_relocs.so");
+  while (state.KeepRunning()) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW);
+    if (handle == nullptr) {
+      state.SkipWithError(dlerror());
+      break;
+    }
+    dlclose(handle);
+  }
+  state.SetItemsProcessed(uint64_t(state.iterations()) * 4096);
+
+  dlclose(symbols);
+}
+BENCHMARK(BM_linker_relocate);
+
+// Looks up each of the library's symbols in turn. The linker caches dlsym
+// results per handle, so the smaller libraries are measuring that cache
+// once it's warm; the 4096 symbols are more than it holds.
+static void BM_linker_dlsym_hit(benchmark::State& state) {
+  void* handle = OpenLib(state, SymbolsLib(state.range(0)));
+  if (handle == nullptr) return;
+
+  std::vector<std::string> names = SymbolNames(state.range(0));
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(dlsym(handle, names[i++ % names.size()].c_str()));
+  }
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dlsym_hit)->SYMBOL_COUNTS;
+
+// Looks up names the library doesn't have, more of them than are cached, so
+// every lookup searches the library and its dependencies.
+static void BM_linker_dlsym_miss(benchmark::State& state) {
+  void* handle = OpenLib(state, SymbolsLib(state.range(0)));
+  if (handle == nullptr) return;
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < 1024; ++i) {
+    names.push_back("linker_benchmark_missing_" + std::to_string(i));
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(dlsym(handle, names[i++ % names.size()].c_str()));
+  }
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dlsym_miss)->SYMBOL_COUNTS;
+
+// Finds the library and symbol containing an address, which means searching
+// the library's symbol table.
+static void BM_linker_dladdr(benchmark::State& state) {
+  void* handle = OpenLib(state, SymbolsLib(state.range(0)));
+  if (handle == nullptr) return;
+
+  void* addr = dlsym(handle, SymbolNames(state.range(0)).back().c_str());
+  if (addr == nullptr) {
+    state.SkipWithError(dlerror());
+    dlclose(handle);
+    return;
+  }
+
+  Dl_info info;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(dladdr(addr, &info));
+  }
+
+  dlclose(handle);
+}
+BENCHMARK(BM_linker_dladdr)->SYMBOL_COUNTS;
+
+static int CountPhdrs(dl_phdr_info* info, size_t, void* data) {
+  *reinterpret_cast<size_t*>(data) += info->dlpi_phnum;
+  return 0;
+}
+
+// Unwinders call dl_iterate_phdr for every exception thrown, from any number
+// of threads at once.
+static void BM_linker_dl_iterate_phdr(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    size_t count = 0;
+    dl_iterate_phdr(CountPhdrs, &count);
+    benchmark::DoNotOptimize(count);
+  }
+}
+BENCHMARK(BM_linker_dl_iterate_phdr)->ThreadRange(1, 8)->UseRealTime();
+
+// As above, but the first thread loads and unloads a library instead, so the
+// others contend with changes to the list of loaded libraries.
+static void BM_linker_dl_iterate_phdr_dlopen(benchmark::State& state) {
+  std::string path = LoaderTestLibPath(SymbolsLib(16));
+  while (state.KeepRunning()) {
+    if (state.thread_index == 0) {
+      void* handle = dlopen(path.c_str(), RTLD_NOW);
+      if (handle == nullptr) {
+        state.SkipWithError(dlerror());
+        break;
+      }
+      dlclose(handle);
+    } else {
+      size_t count = 0;
+      dl_iterate_phdr(CountPhdrs, &count);
+      benchmark::DoNotOptimize(count);
+    }
+  }
+}
+BENCHMARK(BM_linker_dl_iterate_phdr_dlopen)->ThreadRange(2, 8)->UseRealTime();
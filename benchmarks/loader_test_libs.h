@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BIONIC_BENCHMARKS_LOADER_TEST_LIBS_H
+#define BIONIC_BENCHMARKS_LOADER_TEST_LIBS_H
+
+#include <stdlib.h>
+
+#include <string>
+
+// The linker and startup benchmarks use libraries and executables from
+// tests/libs, which are installed with the other loader test libraries. Set
+// BIONIC_BENCHMARK_LIBS to the directory they're in to use them from
+// somewhere else (when running on the host, say).
+static inline std::string LoaderTestLibPath(const std::string& name) {
+  const char* dir = getenv("BIONIC_BENCHMARK_LIBS");
+  if (dir == nullptr) {
+#if defined(__LP64__)
+    dir = "/data/nativetest64/bionic-loader-test-libs";
+#else
+    dir = "/data/nativetest/bionic-loader-test-libs";
+#endif
+  }
+  return std::string(dir) + "/" + name;
+}
+
+#endif  // BIONIC_BENCHMARKS_LOADER_TEST_LIBS_H
@@ -0,0 +1,393 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#if defined(__BIONIC__)
+#include <sys/system_properties.h>
+#endif
+
+#include <benchmark/benchmark.h>
+
+// The allocator in use is chosen once at process start. To compare the
+// default allocator against malloc debug, run the same binary twice:
+//   adb shell bionic-benchmarks64 --benchmark_filter=BM_malloc
+//   adb shell LIBC_DEBUG_MALLOC_OPTIONS=backtrace bionic-benchmarks64 --benchmark_filter=BM_malloc
+// Every benchmark here labels its results with the allocator that was active,
+// whether malloc debug was enabled by the environment or by the
+// libc.debug.malloc.options and libc.debug.malloc.program properties.
+
+constexpr auto KB = 1024;
+
+// Covers the small, medium and large size classes of the default allocator.
+#define AT_SIZE_CLASSES \
+    Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(512)-> \
+    Arg(1*KB)->Arg(4*KB)->Arg(16*KB)->Arg(64*KB)->Arg(256*KB)->Arg(1024*KB)
+
+// The options malloc debug was enabled with, or "" if it wasn't. This makes
+// the same checks as malloc_init_impl in libc.
+static std::string GetMallocDebugOptions() {
+  const char* options = getenv("LIBC_DEBUG_MALLOC_OPTIONS");
+  if (options != nullptr && options[0] != '\0') {
+    return options;
+  }
+#if defined(__BIONIC__)
+  char value[PROP_VALUE_MAX];
+  char program[PROP_VALUE_MAX];
+  if (__system_property_get("libc.debug.malloc.options", value) == 0) {
+    return "";
+  }
+  if (__system_property_get("libc.debug.malloc.program", program) != 0 &&
+      strstr(getprogname(), program) == nullptr) {
+    return "";
+  }
+  return value;
+#else
+  return "";
+#endif
+}
+
+static void SetAllocatorLabel(benchmark::State& state) {
+  static const std::string options = GetMallocDebugOptions();
+  if (!options.empty()) {
+    state.SetLabel("malloc_debug:" + options);
+  } else {
+    state.SetLabel("default");
+  }
+}
+
+static void BM_malloc_malloc_free(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+
+  while (state.KeepRunning()) {
+    void* ptr = malloc(nbytes);
+    benchmark::DoNotOptimize(ptr);
+    free(ptr);
+  }
+
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_malloc_free)->AT_SIZE_CLASSES;
+
+// Keeps many allocations live at once so that the allocator has to deal with
+// more than a single hot slot in each size class.
+static void BM_malloc_malloc_free_batch(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  constexpr size_t kBatch = 256;
+  void* ptrs[kBatch];
+
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < kBatch; ++i) {
+      ptrs[i] = malloc(nbytes);
+    }
+    benchmark::DoNotOptimize(ptrs);
+    for (size_t i = 0; i < kBatch; ++i) {
+      free(ptrs[i]);
+    }
+  }
+
+  state.SetItemsProcessed(uint64_t(state.iterations()) * kBatch);
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_malloc_free_batch)->AT_SIZE_CLASSES;
+
+static void BM_malloc_calloc_free(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+
+  while (state.KeepRunning()) {
+    void* ptr = calloc(1, nbytes);
+    benchmark::DoNotOptimize(ptr);
+    free(ptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_calloc_free)->AT_SIZE_CLASSES;
+// Sizes like these come from image decoders. The pages are fresh from the
+// kernel, so a calloc that zeroes them anyway shows up here.
+BENCHMARK(BM_malloc_calloc_free)->Arg(4*1024*KB)->Arg(16*1024*KB);
+
+static void BM_malloc_posix_memalign_free(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t alignment = state.range(1);
+
+  while (state.KeepRunning()) {
+    void* ptr;
+    if (posix_memalign(&ptr, alignment, nbytes) != 0) {
+      state.SkipWithError("posix_memalign failed");
+      break;
+    }
+    benchmark::DoNotOptimize(ptr);
+    free(ptr);
+  }
+
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_posix_memalign_free)
+    ->Args({64, 16})->Args({64, 64})->Args({64, 4*KB})
+    ->Args({4*KB, 16})->Args({4*KB, 64})->Args({4*KB, 4*KB})
+    ->Args({64*KB, 64})->Args({64*KB, 4*KB});
+
+// Grows a buffer from a small size to range(0) by a fixed increment per step,
+// the pattern std::string and hand-written append loops produce.
+static void BM_malloc_realloc_grow_linear(benchmark::State& state) {
+  const size_t max_bytes = state.range(0);
+  const size_t step = 16;
+
+  while (state.KeepRunning()) {
+    void* ptr = nullptr;
+    for (size_t size = step; size <= max_bytes; size += step) {
+      ptr = realloc(ptr, size);
+    }
+    benchmark::DoNotOptimize(ptr);
+    free(ptr);
+  }
+
+  state.SetItemsProcessed(uint64_t(state.iterations()) * (max_bytes / step));
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_realloc_grow_linear)->Arg(1*KB)->Arg(4*KB)->Arg(16*KB);
+
+// Grows a buffer by doubling, the pattern std::vector produces.
+static void BM_malloc_realloc_grow_doubling(benchmark::State& state) {
+  const size_t max_bytes = state.range(0);
+  size_t steps = 0;
+
+  while (state.KeepRunning()) {
+    void* ptr = nullptr;
+    steps = 0;
+    for (size_t size = 16; size <= max_bytes; size *= 2) {
+      ptr = realloc(ptr, size);
+      ++steps;
+    }
+    benchmark::DoNotOptimize(ptr);
+    free(ptr);
+  }
+
+  state.SetItemsProcessed(uint64_t(state.iterations()) * steps);
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_realloc_grow_doubling)->Arg(64*KB)->Arg(1024*KB)->Arg(16*1024*KB);
+
+// Repeatedly shrinks and regrows the same allocation within a size class.
+static void BM_malloc_realloc_in_place(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  void* ptr = malloc(nbytes);
+
+  while (state.KeepRunning()) {
+    ptr = realloc(ptr, nbytes / 2);
+    ptr = realloc(ptr, nbytes);
+  }
+  free(ptr);
+
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_realloc_in_place)->Arg(64)->Arg(1*KB)->Arg(64*KB)->Arg(1024*KB);
+
+// Allocations are made on the benchmark thread and handed to a consumer
+// thread that frees them, so every free is a remote free into another
+// thread's cache or arena.
+class CrossThreadFreeQueue {
+ public:
+  CrossThreadFreeQueue() {
+    pthread_mutex_init(&lock_, nullptr);
+    pthread_cond_init(&cond_, nullptr);
+    pthread_create(&consumer_, nullptr, ConsumerThread, this);
+  }
+
+  ~CrossThreadFreeQueue() {
+    pthread_mutex_lock(&lock_);
+    done_ = true;
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&lock_);
+    pthread_join(consumer_, nullptr);
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&lock_);
+  }
+
+  void Push(std::vector<void*>* batch) {
+    pthread_mutex_lock(&lock_);
+    pending_.insert(pending_.end(), batch->begin(), batch->end());
+    pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&lock_);
+    batch->clear();
+  }
+
+  // Waits until the consumer has freed everything handed to it so far.
+  void Drain() {
+    pthread_mutex_lock(&lock_);
+    while (!pending_.empty() || freeing_) {
+      pthread_cond_wait(&cond_, &lock_);
+    }
+    pthread_mutex_unlock(&lock_);
+  }
+
+ private:
+  static void* ConsumerThread(void* arg) {
+    CrossThreadFreeQueue* queue = reinterpret_cast<CrossThreadFreeQueue*>(arg);
+    std::vector<void*> to_free;
+    pthread_mutex_lock(&queue->lock_);
+    while (true) {
+      while (queue->pending_.empty() && !queue->done_) {
+        pthread_cond_wait(&queue->cond_, &queue->lock_);
+      }
+      if (queue->pending_.empty()) {
+        break;
+      }
+      to_free.swap(queue->pending_);
+      queue->freeing_ = true;
+      pthread_mutex_unlock(&queue->lock_);
+      for (void* ptr : to_free) {
+        free(ptr);
+      }
+      to_free.clear();
+      pthread_mutex_lock(&queue->lock_);
+      queue->freeing_ = false;
+      pthread_cond_broadcast(&queue->cond_);
+    }
+    pthread_mutex_unlock(&queue->lock_);
+    return nullptr;
+  }
+
+  pthread_mutex_t lock_;
+  pthread_cond_t cond_;
+  pthread_t consumer_;
+  std::vector<void*> pending_;
+  bool freeing_ = false;
+  bool done_ = false;
+};
+
+static void BM_malloc_cross_thread_free(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  constexpr size_t kBatch = 64;
+  std::vector<void*> batch;
+  batch.reserve(kBatch);
+
+  CrossThreadFreeQueue queue;
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < kBatch; ++i) {
+      batch.push_back(malloc(nbytes));
+    }
+    queue.Push(&batch);
+  }
+  queue.Drain();
+
+  state.SetItemsProcessed(uint64_t(state.iterations()) * kBatch);
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_cross_thread_free)->Arg(16)->Arg(64)->Arg(512)->Arg(4*KB)->UseRealTime();
+
+// The benchmark threads are paired off: the even thread of each pair
+// allocates batches of buffers and the odd thread frees them, like network
+// threads handing buffers to workers. Each pair has its own queue, so as
+// the thread count grows the only shared state is the allocator's.
+struct ProducerConsumerQueue {
+  static constexpr size_t kMaxPending = 16;
+
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+  std::vector<std::vector<void*>> pending;
+
+  void Push(std::vector<void*>* batch) {
+    pthread_mutex_lock(&lock);
+    while (pending.size() >= kMaxPending) {
+      pthread_cond_wait(&cond, &lock);
+    }
+    pending.emplace_back();
+    pending.back().swap(*batch);
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+  }
+
+  void Pop(std::vector<void*>* batch) {
+    pthread_mutex_lock(&lock);
+    while (pending.empty()) {
+      pthread_cond_wait(&cond, &lock);
+    }
+    batch->swap(pending.back());
+    pending.pop_back();
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+  }
+};
+
+static std::vector<ProducerConsumerQueue>* g_producer_consumer_queues;
+
+static void BM_malloc_producer_consumer(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  constexpr size_t kBatch = 64;
+
+  if (state.thread_index == 0) {
+    g_producer_consumer_queues = new std::vector<ProducerConsumerQueue>(state.threads / 2);
+  }
+  // Both threads of a pair run the same number of iterations, so every
+  // batch pushed is popped.
+  const bool producer = (state.thread_index % 2) == 0;
+  std::vector<void*> batch;
+  batch.reserve(kBatch);
+
+  while (state.KeepRunning()) {
+    ProducerConsumerQueue& queue = (*g_producer_consumer_queues)[state.thread_index / 2];
+    if (producer) {
+      batch.reserve(kBatch);
+      for (size_t i = 0; i < kBatch; ++i) {
+        batch.push_back(malloc(nbytes));
+      }
+      queue.Push(&batch);
+    } else {
+      queue.Pop(&batch);
+      for (void* ptr : batch) {
+        free(ptr);
+      }
+      batch.clear();
+    }
+  }
+
+  if (producer) {
+    state.SetItemsProcessed(uint64_t(state.iterations()) * kBatch);
+  }
+  if (state.thread_index == 0) {
+    delete g_producer_consumer_queues;
+    g_producer_consumer_queues = nullptr;
+  }
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_producer_consumer)
+    ->Arg(64)->Arg(1*KB)->Arg(16*KB)->ThreadRange(2, 32)->UseRealTime();
+
+// Every benchmark thread runs the same malloc/free loop, which measures
+// contention on shared allocator state.
+static void BM_malloc_malloc_free_multithreaded(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+
+  while (state.KeepRunning()) {
+    void* ptr = malloc(nbytes);
+    benchmark::DoNotOptimize(ptr);
+    free(ptr);
+  }
+
+  SetAllocatorLabel(state);
+}
+BENCHMARK(BM_malloc_malloc_free_multithreaded)
+    ->Arg(16)->Arg(512)->Arg(16*KB)->ThreadRange(1, 8)->UseRealTime();
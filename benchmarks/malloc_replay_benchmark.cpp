@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/stringprintf.h>
+
+#include <benchmark/benchmark.h>
+
+// Replays an allocation trace written by malloc debug's record_allocs option
+// against the allocator in use. Pass the trace in text form, converting
+// record_allocs_stream files with malloc_debug_record_to_text first:
+//   adb shell setprop libc.debug.malloc.options record_allocs
+//   ... run the workload, then kill -47 <pid> to dump the trace ...
+//   adb shell BIONIC_MALLOC_REPLAY_TRACE=/data/local/tmp/record_allocs.txt
+//       bionic-benchmarks64 --benchmark_filter=BM_malloc_replay
+//
+// Every recorded thread is replayed on its own thread. An operation on a
+// pointer that another thread allocated waits until that allocation has
+// been replayed, so cross thread frees happen in the recorded order.
+//
+// The label reports the peak RSS increase during a replay, the peak number
+// of bytes the trace itself keeps live, and their ratio as a measure of
+// fragmentation and allocator overhead. The RSS is taken from the first
+// replay in the process, later ones reuse pages the allocator kept around.
+
+enum ReplayType : uint8_t {
+  REPLAY_MALLOC,
+  REPLAY_CALLOC,
+  REPLAY_MEMALIGN,
+  REPLAY_REALLOC,
+  REPLAY_FREE,
+};
+
+static constexpr size_t kNoSlot = SIZE_MAX;
+
+struct ReplayAction {
+  ReplayType type;
+  // The slot holding the pointer this action consumes, or kNoSlot.
+  size_t in_slot;
+  // The slot receiving the pointer this action returns, or kNoSlot.
+  size_t out_slot;
+  size_t size;
+  // nmemb for calloc, alignment for memalign.
+  size_t arg;
+};
+
+struct ReplayTrace {
+  std::vector<std::vector<ReplayAction>> threads;
+  size_t num_slots = 0;
+  size_t peak_live_bytes = 0;
+  std::string error;
+};
+
+struct ReplaySlot {
+  std::atomic<void*> pointer;
+  std::atomic<bool> ready;
+};
+
+static bool ParseTrace(const char* file_name, ReplayTrace* trace) {
+  FILE* fp = fopen(file_name, "re");
+  if (fp == nullptr) {
+    trace->error = android::base::StringPrintf("cannot open %s: %s", file_name, strerror(errno));
+    return false;
+  }
+
+  std::map<int, size_t> thread_indexes;
+  // Maps each recorded pointer that is still live to its slot and size.
+  std::unordered_map<uintptr_t, std::pair<size_t, size_t>> live;
+  size_t live_bytes = 0;
+
+  char line[256];
+  size_t line_number = 0;
+  while (fgets(line, sizeof(line), fp) != nullptr) {
+    line_number++;
+    int tid;
+    char name[32];
+    int consumed;
+    if (sscanf(line, "%d: %31s%n", &tid, name, &consumed) != 2) {
+      trace->error = android::base::StringPrintf("%s:%zu: malformed line", file_name, line_number);
+      fclose(fp);
+      return false;
+    }
+    const char* args = &line[consumed];
+
+    ReplayAction action = {};
+    action.in_slot = kNoSlot;
+    action.out_slot = kNoSlot;
+    uintptr_t pointer = 0;
+    uintptr_t old_pointer = 0;
+    bool matched;
+    if (strcmp(name, "malloc") == 0) {
+      action.type = REPLAY_MALLOC;
+      matched = sscanf(args, "%" SCNxPTR " %zu", &pointer, &action.size) == 2;
+    } else if (strcmp(name, "calloc") == 0) {
+      action.type = REPLAY_CALLOC;
+      matched = sscanf(args, "%" SCNxPTR " %zu %zu", &pointer, &action.arg, &action.size) == 3;
+    } else if (strcmp(name, "memalign") == 0) {
+      action.type = REPLAY_MEMALIGN;
+      matched = sscanf(args, "%" SCNxPTR " %zu %zu", &pointer, &action.arg, &action.size) == 3;
+    } else if (strcmp(name, "realloc") == 0) {
+      action.type = REPLAY_REALLOC;
+      matched = sscanf(args, "%" SCNxPTR " %" SCNxPTR " %zu", &pointer, &old_pointer,
+                       &action.size) == 3;
+    } else if (strcmp(name, "free") == 0) {
+      action.type = REPLAY_FREE;
+      matched = sscanf(args, "%" SCNxPTR, &old_pointer) == 1;
+    } else if (strcmp(name, "thread_done") == 0) {
+      continue;
+    } else {
+      matched = false;
+    }
+    if (!matched) {
+      trace->error = android::base::StringPrintf("%s:%zu: malformed %s", file_name, line_number,
+                                                 name);
+      fclose(fp);
+      return false;
+    }
+
+    if (old_pointer != 0) {
+      auto entry = live.find(old_pointer);
+      if (entry == live.end()) {
+        // Allocated before the recording started, nothing to replay.
+        if (action.type == REPLAY_FREE) {
+          continue;
+        }
+      } else {
+        action.in_slot = entry->second.first;
+        live_bytes -= entry->second.second;
+        live.erase(entry);
+      }
+    } else if (action.type == REPLAY_FREE) {
+      continue;
+    }
+    if (pointer != 0) {
+      size_t bytes = (action.type == REPLAY_CALLOC) ? action.arg * action.size : action.size;
+      action.out_slot = trace->num_slots++;
+      live[pointer] = std::make_pair(action.out_slot, bytes);
+      live_bytes += bytes;
+      if (live_bytes > trace->peak_live_bytes) {
+        trace->peak_live_bytes = live_bytes;
+      }
+    }
+
+    auto thread = thread_indexes.find(tid);
+    if (thread == thread_indexes.end()) {
+      thread = thread_indexes.emplace(tid, trace->threads.size()).first;
+      trace->threads.emplace_back();
+    }
+    trace->threads[thread->second].push_back(action);
+  }
+  fclose(fp);
+
+  if (trace->threads.empty()) {
+    trace->error = android::base::StringPrintf("%s: no allocations to replay", file_name);
+    return false;
+  }
+  return true;
+}
+
+static void* WaitForSlot(ReplaySlot* slot) {
+  while (!slot->ready.load(std::memory_order_acquire)) {
+    sched_yield();
+  }
+  return slot->pointer.load(std::memory_order_relaxed);
+}
+
+static void ReplayThread(const std::vector<ReplayAction>* actions, ReplaySlot* slots) {
+  for (const ReplayAction& action : *actions) {
+    void* in = nullptr;
+    if (action.in_slot != kNoSlot) {
+      in = WaitForSlot(&slots[action.in_slot]);
+      // This is the only action consuming the slot, clear it so that the
+      // pointer is not freed again at the end of the replay.
+      slots[action.in_slot].pointer.store(nullptr, std::memory_order_relaxed);
+    }
+    void* out = nullptr;
+    switch (action.type) {
+      case REPLAY_MALLOC:
+        out = malloc(action.size);
+        break;
+      case REPLAY_CALLOC:
+        out = calloc(action.arg, action.size);
+        break;
+      case REPLAY_MEMALIGN:
+        out = memalign(action.arg, action.size);
+        break;
+      case REPLAY_REALLOC:
+        out = realloc(in, action.size);
+        break;
+      case REPLAY_FREE:
+        free(in);
+        break;
+    }
+    if (action.out_slot != kNoSlot) {
+      // Write the memory as the recorded program presumably did, so that
+      // the RSS reflects the bytes the trace keeps live.
+      if (out != nullptr) {
+        memset(out, 1, (action.type == REPLAY_CALLOC) ? action.arg * action.size : action.size);
+      }
+      slots[action.out_slot].pointer.store(out, std::memory_order_relaxed);
+      slots[action.out_slot].ready.store(true, std::memory_order_release);
+    }
+  }
+}
+
+static size_t GetRssKb(const char* field) {
+  FILE* fp = fopen("/proc/self/status", "re");
+  if (fp == nullptr) {
+    return 0;
+  }
+  size_t value = 0;
+  size_t field_len = strlen(field);
+  char line[256];
+  while (fgets(line, sizeof(line), fp) != nullptr) {
+    if (strncmp(line, field, field_len) == 0 && line[field_len] == ':') {
+      value = strtoul(&line[field_len + 1], nullptr, 10);
+      break;
+    }
+  }
+  fclose(fp);
+  return value;
+}
+
+static void ResetPeakRss() {
+  // Writing 5 resets VmHWM to the current RSS.
+  int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+  if (fd != -1) {
+    TEMP_FAILURE_RETRY(write(fd, "5", 1));
+    close(fd);
+  }
+}
+
+static void BM_malloc_replay(benchmark::State& state) {
+  const char* file_name = getenv("BIONIC_MALLOC_REPLAY_TRACE");
+  if (file_name == nullptr) {
+    state.SkipWithError("set BIONIC_MALLOC_REPLAY_TRACE to a record_allocs file");
+    return;
+  }
+  static ReplayTrace* trace = nullptr;
+  if (trace == nullptr) {
+    trace = new ReplayTrace;
+    ParseTrace(file_name, trace);
+  }
+  if (!trace->error.empty()) {
+    state.SkipWithError(trace->error.c_str());
+    return;
+  }
+
+  static size_t peak_rss_kb = 0;
+  static bool peak_rss_measured = false;
+
+  std::unique_ptr<ReplaySlot[]> slots(new ReplaySlot[trace->num_slots]);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    for (size_t i = 0; i < trace->num_slots; i++) {
+      slots[i].pointer.store(nullptr, std::memory_order_relaxed);
+      slots[i].ready.store(false, std::memory_order_relaxed);
+    }
+    size_t start_rss_kb = GetRssKb("VmRSS");
+    ResetPeakRss();
+    state.ResumeTiming();
+
+    std::vector<std::thread> threads;
+    for (const auto& actions : trace->threads) {
+      threads.emplace_back(ReplayThread, &actions, slots.get());
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    state.PauseTiming();
+    if (!peak_rss_measured) {
+      size_t hwm_kb = GetRssKb("VmHWM");
+      peak_rss_kb = (hwm_kb > start_rss_kb) ? hwm_kb - start_rss_kb : 0;
+      peak_rss_measured = true;
+    }
+    // Free whatever the trace never freed, so every iteration starts the same.
+    for (size_t i = 0; i < trace->num_slots; i++) {
+      free(slots[i].pointer.load(std::memory_order_relaxed));
+    }
+    state.ResumeTiming();
+  }
+
+  size_t peak_live_kb = trace->peak_live_bytes / 1024;
+  state.SetLabel(android::base::StringPrintf(
+      "peak_rss=%zuKB peak_live=%zuKB rss/live=%.2f", peak_rss_kb, peak_live_kb,
+      peak_live_kb ? static_cast<double>(peak_rss_kb) / peak_live_kb : 0.0));
+}
+BENCHMARK(BM_malloc_replay)->UseRealTime();
@@ -16,6 +16,7 @@
 
 #include <fenv.h>
 #include <math.h>
+#include <string.h>
 
 #include <benchmark/benchmark.h>
 
@@ -154,6 +155,44 @@ static void BM_math_sin_fast(benchmark::State& state) {
 }
 BENCHMARK(BM_math_sin_fast);
 
+static void BM_math_sin_cos_fast(benchmark::State& state) {
+  d = 1.0;
+  while (state.KeepRunning()) {
+    d += sin(d) + cos(d);
+  }
+}
+BENCHMARK(BM_math_sin_cos_fast);
+
+static void BM_math_sincos_fast(benchmark::State& state) {
+  d = 1.0;
+  while (state.KeepRunning()) {
+    double s, c;
+    sincos(d, &s, &c);
+    d += s + c;
+  }
+}
+BENCHMARK(BM_math_sincos_fast);
+
+static void BM_math_sincosf_fast(benchmark::State& state) {
+  d = 1.0;
+  while (state.KeepRunning()) {
+    float s, c;
+    sincosf(d, &s, &c);
+    d += s + c;
+  }
+}
+BENCHMARK(BM_math_sincosf_fast);
+
+static void BM_math_sincosl_fast(benchmark::State& state) {
+  d = 1.0;
+  while (state.KeepRunning()) {
+    long double s, c;
+    sincosl(d, &s, &c);
+    d += s + c;
+  }
+}
+BENCHMARK(BM_math_sincosl_fast);
+
 static void BM_math_sin_feupdateenv(benchmark::State& state) {
   d = 1.0;
   while (state.KeepRunning()) {
@@ -178,6 +217,25 @@ static void BM_math_sin_fesetenv(benchmark::State& state) {
 }
 BENCHMARK(BM_math_sin_fesetenv);
 
+static void BM_math_feholdexcept_feupdateenv(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    fenv_t __libc_save_rm;
+    feholdexcept(&__libc_save_rm);
+    fesetround(FE_TONEAREST);
+    feupdateenv(&__libc_save_rm);
+  }
+}
+BENCHMARK(BM_math_feholdexcept_feupdateenv);
+
+static void BM_math_nearbyint(benchmark::State& state) {
+  d = 0.0;
+  v = 1234.5;
+  while (state.KeepRunning()) {
+    d += nearbyint(v);
+  }
+}
+BENCHMARK(BM_math_nearbyint);
+
 static void BM_math_fpclassify(benchmark::State& state) {
   d = 0.0;
   v = values[state.range(0)];
@@ -227,3 +285,117 @@ static void BM_math_fabs(benchmark::State& state) {
   SetLabel(state);
 }
 BENCHMARK_COMMON_VALS(BM_math_fabs);
+
+static const size_t kArrayLength = 1024;
+
+template <typename T>
+static void FillArray(T* array, T lo, T hi) {
+  for (size_t i = 0; i < kArrayLength; ++i) {
+    array[i] = lo + (hi - lo) * i / kArrayLength;
+  }
+}
+
+// The float functions over arrays of arguments from their common ranges, so
+// that table lookups and branches see more than one value.
+static void BM_math_expf(benchmark::State& state) {
+  static float in[kArrayLength];
+  FillArray<float>(in, -20.0f, 20.0f);
+  float sum = 0.0f;
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < kArrayLength; ++i) sum += expf(in[i]);
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(uint64_t(state.iterations()) * kArrayLength);
+}
+BENCHMARK(BM_math_expf);
+
+static void BM_math_logf(benchmark::State& state) {
+  static float in[kArrayLength];
+  FillArray<float>(in, 0.01f, 1000.0f);
+  float sum = 0.0f;
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < kArrayLength; ++i) sum += logf(in[i]);
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(uint64_t(state.iterations()) * kArrayLength);
+}
+BENCHMARK(BM_math_logf);
+
+static void BM_math_powf(benchmark::State& state) {
+  static float x[kArrayLength], y[kArrayLength];
+  FillArray<float>(x, 0.1f, 10.0f);
+  FillArray<float>(y, -8.0f, 8.0f);
+  float sum = 0.0f;
+  while (state.KeepRunning()) {
+    // Pair each x with a y from elsewhere in its array.
+    for (size_t i = 0; i < kArrayLength; ++i) sum += powf(x[i], y[(i * 7) % kArrayLength]);
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(uint64_t(state.iterations()) * kArrayLength);
+}
+BENCHMARK(BM_math_powf);
+
+static void BM_math_sinf(benchmark::State& state) {
+  static float in[kArrayLength];
+  FillArray<float>(in, -10.0f, 10.0f);
+  float sum = 0.0f;
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < kArrayLength; ++i) sum += sinf(in[i]);
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(uint64_t(state.iterations()) * kArrayLength);
+}
+BENCHMARK(BM_math_sinf);
+
+#if defined(__BIONIC__) && \
+    (defined(__x86_64__) || (defined(__aarch64__) && __has_attribute(aarch64_vector_pcs)))
+// The vector variants against the scalar functions, over arrays of arguments
+// that the vector code handles without falling back to the scalar functions.
+typedef float vector_float __attribute__((__vector_size__(16)));
+typedef double vector_double __attribute__((__vector_size__(16)));
+
+#if defined(__x86_64__)
+#define VECTOR_ATTRS
+#define VECTOR_FN(name, n) _ZGVbN ## n ## v_ ## name
+#else
+#define VECTOR_ATTRS __attribute__((aarch64_vector_pcs))
+#define VECTOR_FN(name, n) _ZGVnN ## n ## v_ ## name
+#endif
+
+#define BENCHMARK_VECTOR_MATH(name, T, V, n, lo, hi) \
+  extern "C" VECTOR_ATTRS V VECTOR_FN(name, n)(V); \
+  static void BM_math_ ## name ## _array(benchmark::State& state) { \
+    static T in[kArrayLength], out[kArrayLength]; \
+    FillArray<T>(in, lo, hi); \
+    while (state.KeepRunning()) { \
+      for (size_t i = 0; i < kArrayLength; ++i) out[i] = name(in[i]); \
+      benchmark::DoNotOptimize(out); \
+    } \
+    state.SetItemsProcessed(uint64_t(state.iterations()) * kArrayLength); \
+  } \
+  BENCHMARK(BM_math_ ## name ## _array); \
+  static void BM_math_ ## name ## _vector_array(benchmark::State& state) { \
+    static T in[kArrayLength], out[kArrayLength]; \
+    FillArray<T>(in, lo, hi); \
+    while (state.KeepRunning()) { \
+      for (size_t i = 0; i < kArrayLength; i += n) { \
+        V v; \
+        memcpy(&v, &in[i], sizeof(v)); \
+        v = VECTOR_FN(name, n)(v); \
+        memcpy(&out[i], &v, sizeof(v)); \
+      } \
+      benchmark::DoNotOptimize(out); \
+    } \
+    state.SetItemsProcessed(uint64_t(state.iterations()) * kArrayLength); \
+  } \
+  BENCHMARK(BM_math_ ## name ## _vector_array)
+
+BENCHMARK_VECTOR_MATH(sinf, float, vector_float, 4, -100.0f, 100.0f);
+BENCHMARK_VECTOR_MATH(cosf, float, vector_float, 4, -100.0f, 100.0f);
+BENCHMARK_VECTOR_MATH(expf, float, vector_float, 4, -80.0f, 80.0f);
+BENCHMARK_VECTOR_MATH(logf, float, vector_float, 4, 0x1p-100f, 0x1p100f);
+BENCHMARK_VECTOR_MATH(sin, double, vector_double, 2, -100.0, 100.0);
+BENCHMARK_VECTOR_MATH(cos, double, vector_double, 2, -100.0, 100.0);
+BENCHMARK_VECTOR_MATH(exp, double, vector_double, 2, -700.0, 700.0);
+BENCHMARK_VECTOR_MATH(log, double, vector_double, 2, 0x1p-1000, 0x1p1000);
+#endif
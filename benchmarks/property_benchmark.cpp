@@ -20,6 +20,7 @@
 #include <unistd.h>
 
 #include <string>
+#include <vector>
 
 #if defined(__BIONIC__)
 
@@ -147,6 +148,43 @@ static void BM_property_get(benchmark::State& state) {
 }
 BENCHMARK(BM_property_get)->TEST_NUM_PROPS;
 
+// The same names resolved one at a time with __system_property_get, as a
+// baseline for BM_property_get_many.
+static void BM_property_get_each(benchmark::State& state) {
+  const size_t nprops = state.range(0);
+
+  LocalPropertyTestState pa(nprops);
+  if (!pa.valid) return;
+
+  char value[PROP_VALUE_MAX];
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < nprops; ++i) {
+      __system_property_get(pa.names[i], value);
+    }
+  }
+  state.SetItemsProcessed(uint64_t(state.iterations()) * nprops);
+}
+BENCHMARK(BM_property_get_each)->TEST_NUM_PROPS;
+
+static void BM_property_get_many(benchmark::State& state) {
+  const size_t nprops = state.range(0);
+
+  LocalPropertyTestState pa(nprops);
+  if (!pa.valid) return;
+
+  std::vector<std::vector<char>> values(nprops, std::vector<char>(PROP_VALUE_MAX));
+  std::vector<char*> value_ptrs;
+  for (size_t i = 0; i < nprops; ++i) {
+    value_ptrs.push_back(values[i].data());
+  }
+
+  while (state.KeepRunning()) {
+    __system_property_get_many(pa.names, value_ptrs.data(), nprops);
+  }
+  state.SetItemsProcessed(uint64_t(state.iterations()) * nprops);
+}
+BENCHMARK(BM_property_get_many)->TEST_NUM_PROPS;
+
 static void BM_property_find(benchmark::State& state) {
   const size_t nprops = state.range(0);
 
@@ -203,4 +241,19 @@ static void BM_property_serial(benchmark::State& state) {
 }
 BENCHMARK(BM_property_serial)->TEST_NUM_PROPS;
 
+// The steady state of a cached flag check: the value hasn't changed.
+static void BM_property_cache_serial(benchmark::State& state) {
+  const size_t nprops = state.range(0);
+
+  LocalPropertyTestState pa(nprops);
+  if (!pa.valid) return;
+
+  prop_cache* cache = __system_property_cache_create(pa.names[random() % nprops]);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(__system_property_cache_serial(cache));
+  }
+  __system_property_cache_destroy(cache);
+}
+BENCHMARK(BM_property_cache_serial)->TEST_NUM_PROPS;
+
 #endif  // __BIONIC__
@@ -15,9 +15,14 @@
  */
 
 #include <pthread.h>
+#include <stdint.h>
+
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
+#include "latency_histogram.h"
+
 // Stop GCC optimizing out our pure function.
 /* Must not be static! */ pthread_t (*pthread_self_fp)() = pthread_self;
 
@@ -65,6 +70,40 @@ static void BM_pthread_once(benchmark::State& state) {
 }
 BENCHMARK(BM_pthread_once);
 
+// The compiler inlines the check of a function-local static's guard variable and only calls
+// __cxa_guard_acquire before the first initialization completes, so this is the
+// already-initialized cost to compare BM_pthread_once against.
+struct StaticLocal {
+  StaticLocal() : value(1) {}
+  int value;
+};
+
+static __attribute__((noinline)) StaticLocal& GetStaticLocal() {
+  static StaticLocal instance;
+  return instance;
+}
+
+static void BM_pthread_once_cxa_guard(benchmark::State& state) {
+  GetStaticLocal();
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(GetStaticLocal().value);
+  }
+}
+BENCHMARK(BM_pthread_once_cxa_guard);
+
+// Completed onces are read-only, so checking one shouldn't slow down as threads are added.
+static pthread_once_t g_shared_once = PTHREAD_ONCE_INIT;
+
+static void BM_pthread_once_multithreaded(benchmark::State& state) {
+  pthread_once(&g_shared_once, DummyPthreadOnceInitFunction);
+
+  while (state.KeepRunning()) {
+    pthread_once(&g_shared_once, DummyPthreadOnceInitFunction);
+  }
+}
+BENCHMARK(BM_pthread_once_multithreaded)->ThreadRange(1, 8)->UseRealTime();
+
 static void BM_pthread_mutex_lock(benchmark::State& state) {
   pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -95,6 +134,16 @@ static void BM_pthread_mutex_lock_RECURSIVE(benchmark::State& state) {
 }
 BENCHMARK(BM_pthread_mutex_lock_RECURSIVE);
 
+static void BM_pthread_mutex_lock_ADAPTIVE(benchmark::State& state) {
+  pthread_mutex_t mutex = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+
+  while (state.KeepRunning()) {
+    pthread_mutex_lock(&mutex);
+    pthread_mutex_unlock(&mutex);
+  }
+}
+BENCHMARK(BM_pthread_mutex_lock_ADAPTIVE);
+
 static void BM_pthread_rwlock_read(benchmark::State& state) {
   pthread_rwlock_t lock;
   pthread_rwlock_init(&lock, NULL);
@@ -121,6 +170,184 @@ static void BM_pthread_rwlock_write(benchmark::State& state) {
 }
 BENCHMARK(BM_pthread_rwlock_write);
 
+// The contended benchmarks below run on 1 to 8 threads that all share one
+// primitive. Items per second gives the aggregate throughput, and the label
+// gives the tail of the per-operation latency.
+#define CONTENDED_THREADS ThreadRange(1, 8)->UseRealTime()
+
+static volatile uint64_t g_shared_counter;
+
+// Simulates a critical section of roughly `length` dependent stores.
+static inline void CriticalSection(int64_t length) {
+  for (int64_t i = 0; i < length; ++i) {
+    g_shared_counter = g_shared_counter + 1;
+  }
+}
+
+static pthread_mutex_t g_contended_normal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_contended_adaptive_mutex = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+static LatencyHistogram g_mutex_latency;
+
+static void ContendedMutexLoop(benchmark::State& state, pthread_mutex_t* mutex) {
+  const int64_t length = state.range(0);
+
+  g_mutex_latency.Start(state);
+  while (state.KeepRunning()) {
+    uint64_t start = LatencyHistogram::NowNs();
+    pthread_mutex_lock(mutex);
+    CriticalSection(length);
+    pthread_mutex_unlock(mutex);
+    g_mutex_latency.Record(state, LatencyHistogram::NowNs() - start);
+  }
+  state.SetItemsProcessed(state.iterations());
+  g_mutex_latency.Finish(state);
+}
+
+static void BM_pthread_mutex_lock_contended(benchmark::State& state) {
+  ContendedMutexLoop(state, &g_contended_normal_mutex);
+}
+BENCHMARK(BM_pthread_mutex_lock_contended)->Arg(0)->Arg(16)->Arg(256)->CONTENDED_THREADS;
+
+static void BM_pthread_mutex_lock_contended_ADAPTIVE(benchmark::State& state) {
+  ContendedMutexLoop(state, &g_contended_adaptive_mutex);
+}
+BENCHMARK(BM_pthread_mutex_lock_contended_ADAPTIVE)->Arg(0)->Arg(16)->Arg(256)->CONTENDED_THREADS;
+
+// range(0) is the percentage of operations that are reads, and range(1) is
+// the critical section length.
+static pthread_rwlock_t g_contended_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+static LatencyHistogram g_rwlock_latency;
+
+static void ContendedRwlockLoop(benchmark::State& state, pthread_rwlock_t* rwlock) {
+  const int64_t read_percent = state.range(0);
+  const int64_t length = state.range(1);
+  // A per-thread LCG spreads the writes out rather than bunching them up.
+  uint32_t seed = 0x9e3779b9u * (state.thread_index + 1);
+
+  g_rwlock_latency.Start(state);
+  while (state.KeepRunning()) {
+    seed = seed * 1103515245u + 12345u;
+    bool read = ((seed >> 16) % 100) < static_cast<uint32_t>(read_percent);
+
+    uint64_t start = LatencyHistogram::NowNs();
+    if (read) {
+      pthread_rwlock_rdlock(rwlock);
+      for (int64_t i = 0; i < length; ++i) {
+        benchmark::DoNotOptimize(g_shared_counter);
+      }
+    } else {
+      pthread_rwlock_wrlock(rwlock);
+      CriticalSection(length);
+    }
+    pthread_rwlock_unlock(rwlock);
+    g_rwlock_latency.Record(state, LatencyHistogram::NowNs() - start);
+  }
+  state.SetItemsProcessed(state.iterations());
+  g_rwlock_latency.Finish(state);
+}
+
+#define RWLOCK_CONTENDED_ARGS \
+    Args({50, 16})->Args({90, 16})->Args({99, 16})->Args({100, 16})->Args({90, 256})
+
+static void BM_pthread_rwlock_contended(benchmark::State& state) {
+  ContendedRwlockLoop(state, &g_contended_rwlock);
+}
+BENCHMARK(BM_pthread_rwlock_contended)->RWLOCK_CONTENDED_ARGS->CONTENDED_THREADS;
+
+#if defined(__BIONIC__)
+// There is no static initializer for a scalable-readers rwlock, so it's set up on first use.
+static pthread_rwlock_t* GetScalableReadersRwlock() {
+  static pthread_rwlock_t* rwlock = []() {
+    static pthread_rwlock_t lock;
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_SCALABLE_READERS_NP);
+    pthread_rwlock_init(&lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    return &lock;
+  }();
+  return rwlock;
+}
+
+static void BM_pthread_rwlock_contended_SCALABLE_READERS(benchmark::State& state) {
+  ContendedRwlockLoop(state, GetScalableReadersRwlock());
+}
+BENCHMARK(BM_pthread_rwlock_contended_SCALABLE_READERS)->RWLOCK_CONTENDED_ARGS->CONTENDED_THREADS;
+#endif
+
+// Measures how long it takes a pthread_cond_broadcast to get range(0) waiters
+// all awake and through the mutex, which is what a thread pool or barrier pays
+// every time it releases its workers.
+struct BroadcastFanOut {
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t wake_cond = PTHREAD_COND_INITIALIZER;
+  pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+  uint64_t generation = 0;
+  int waiters = 0;
+  int awake = 0;
+  bool stop = false;
+};
+
+static void* BroadcastWaiterThread(void* arg) {
+  BroadcastFanOut* fan_out = reinterpret_cast<BroadcastFanOut*>(arg);
+  uint64_t seen = 0;
+
+  pthread_mutex_lock(&fan_out->mutex);
+  while (true) {
+    while (fan_out->generation == seen && !fan_out->stop) {
+      pthread_cond_wait(&fan_out->wake_cond, &fan_out->mutex);
+    }
+    if (fan_out->stop) {
+      break;
+    }
+    seen = fan_out->generation;
+    if (++fan_out->awake == fan_out->waiters) {
+      pthread_cond_signal(&fan_out->done_cond);
+    }
+  }
+  pthread_mutex_unlock(&fan_out->mutex);
+  return NULL;
+}
+
+static void BM_pthread_cond_broadcast_fan_out(benchmark::State& state) {
+  BroadcastFanOut fan_out;
+  fan_out.waiters = state.range(0);
+
+  std::vector<pthread_t> threads(fan_out.waiters);
+  for (auto& thread : threads) {
+    pthread_create(&thread, NULL, BroadcastWaiterThread, &fan_out);
+  }
+
+  LatencyHistogram latency;
+  latency.Start(state);
+  while (state.KeepRunning()) {
+    uint64_t start = LatencyHistogram::NowNs();
+    pthread_mutex_lock(&fan_out.mutex);
+    fan_out.awake = 0;
+    ++fan_out.generation;
+    pthread_cond_broadcast(&fan_out.wake_cond);
+    while (fan_out.awake < fan_out.waiters) {
+      pthread_cond_wait(&fan_out.done_cond, &fan_out.mutex);
+    }
+    pthread_mutex_unlock(&fan_out.mutex);
+    latency.Record(state, LatencyHistogram::NowNs() - start);
+  }
+  state.SetItemsProcessed(state.iterations() * fan_out.waiters);
+  latency.Finish(state);
+
+  pthread_mutex_lock(&fan_out.mutex);
+  fan_out.stop = true;
+  pthread_cond_broadcast(&fan_out.wake_cond);
+  pthread_mutex_unlock(&fan_out.mutex);
+  for (auto& thread : threads) {
+    pthread_join(thread, NULL);
+  }
+}
+// A broadcast that woke all 64 waiters at once would send 63 of them straight back
+// to sleep on the mutex; the larger counts show how well that is avoided.
+BENCHMARK(BM_pthread_cond_broadcast_fan_out)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)
+    ->Arg(32)->Arg(64)->UseRealTime();
+
 static void* IdleThread(void*) {
   return NULL;
 }
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <regex.h>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+// Arg(0) is the classic engine, Arg(1) is REG_LINEAR where it exists.
+static int Cflags(benchmark::State& state) {
+#if defined(REG_LINEAR)
+  if (state.range(0)) return REG_EXTENDED | REG_LINEAR;
+#endif
+  return REG_EXTENDED;
+}
+
+static void RegexBenchmark(benchmark::State& state, const char* pattern,
+                           const std::string& text) {
+  regex_t re;
+  if (regcomp(&re, pattern, Cflags(state)) != 0) {
+    state.SkipWithError("regcomp failed");
+    return;
+  }
+  regmatch_t match[2];
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(regexec(&re, text.c_str(), 2, match, 0));
+  }
+  regfree(&re);
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// The match is at the very end, after a long prefix that every start could
+// have begun. The classic engine retries from each of those starts, so this
+// is quadratic in the length of the prefix.
+static void BM_regex_regexec_late_match(benchmark::State& state) {
+  RegexBenchmark(state, "(a+c|b)", std::string(state.range(1), 'a') + "b");
+}
+BENCHMARK(BM_regex_regexec_late_match)->Args({0, 1024})->Args({1, 1024})
+    ->Args({0, 8192})->Args({1, 8192});
+
+// Something more like real use: pulling a field out of a log line, with
+// the same regex_t reused for every line.
+static void BM_regex_regexec_log_line(benchmark::State& state) {
+  RegexBenchmark(state, "pid=([0-9]+) (uid|gid)=[0-9]+ comm=\"[^\"]*\"",
+                 "type=AVC msg=audit(1495412042.583:123): avc: denied { read } for "
+                 "pid=1234 uid=1000 comm=\"system_server\" name=\"wakeup\" dev=\"sysfs\"");
+}
+BENCHMARK(BM_regex_regexec_log_line)->Arg(0)->Arg(1);
+
+// A search that fails, so only the first pass runs. No literal string is
+// needed for a match, so the "must" prescreen can't skip it.
+static void BM_regex_regexec_no_match(benchmark::State& state) {
+  RegexBenchmark(state, "[a-z]+[0-9]+[xy]", std::string(4096, 'q'));
+}
+BENCHMARK(BM_regex_regexec_no_match)->Arg(0)->Arg(1);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <stddef.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "seccomp_policy.h"
+
+// Measures what the zygote's seccomp policy adds to a syscall, by making the
+// same syscall with and without it. A filter can't be removed once installed,
+// and only applies to the thread that installs it (and its children), so each
+// run happens on a new thread.
+
+static bool InstallPolicy() {
+  const sock_filter* policy;
+  size_t policy_size;
+  get_seccomp_filter(policy, policy_size);
+
+  // The generated policy expects the syscall number to have been loaded, and
+  // falls through to the next statement for syscalls it doesn't allow.
+  std::vector<sock_filter> f;
+  f.push_back(BPF_STMT(BPF_LD|BPF_W|BPF_ABS, offsetof(struct seccomp_data, nr)));
+  f.insert(f.end(), policy, policy + policy_size);
+  f.push_back(BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_TRAP));
+
+  sock_fprog prog = { static_cast<unsigned short>(f.size()), &f[0] };
+  return prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+         prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0;
+}
+
+template <typename Fn>
+static void RunOnThread(benchmark::State& state, bool filtered, Fn fn) {
+  std::thread t([&]() {
+    if (filtered && !InstallPolicy()) {
+      state.SkipWithError("installing the seccomp policy failed");
+      return;
+    }
+    while (state.KeepRunning()) {
+      fn();
+    }
+  });
+  t.join();
+}
+
+// read is near the top of SECCOMP_PROFILE.TXT, so it's checked before the
+// binary search of the policy.
+static void ReadBadFd() {
+  syscall(__NR_read, -1, nullptr, 0);
+}
+
+// getppid isn't, so it goes through the whole binary search.
+static void Getppid() {
+  syscall(__NR_getppid);
+}
+
+static void BM_seccomp_hot_syscall_unfiltered(benchmark::State& state) {
+  RunOnThread(state, false, ReadBadFd);
+}
+BENCHMARK(BM_seccomp_hot_syscall_unfiltered);
+
+static void BM_seccomp_hot_syscall_filtered(benchmark::State& state) {
+  RunOnThread(state, true, ReadBadFd);
+}
+BENCHMARK(BM_seccomp_hot_syscall_filtered);
+
+static void BM_seccomp_cold_syscall_unfiltered(benchmark::State& state) {
+  RunOnThread(state, false, Getppid);
+}
+BENCHMARK(BM_seccomp_cold_syscall_unfiltered);
+
+static void BM_seccomp_cold_syscall_filtered(benchmark::State& state) {
+  RunOnThread(state, true, Getppid);
+}
+BENCHMARK(BM_seccomp_cold_syscall_filtered);
@@ -22,6 +22,8 @@
 
 #include <benchmark/benchmark.h>
 
+#include "latency_histogram.h"
+
 static void BM_semaphore_sem_getvalue(benchmark::State& state) {
   sem_t semaphore;
   sem_init(&semaphore, 1, 1);
@@ -44,6 +46,55 @@ static void BM_semaphore_sem_wait_sem_post(benchmark::State& state) {
 }
 BENCHMARK(BM_semaphore_sem_wait_sem_post);
 
+// Bounces a token between this thread and a partner through a pair of
+// semaphores, so every iteration is a full post/wake/wait round trip in each
+// direction. Unlike semaphore_sem_post below, this includes the wakeup latency.
+struct SemaphorePingPong {
+  sem_t ping;
+  sem_t pong;
+  atomic_bool stop;
+};
+
+static void* SemaphorePongThread(void* arg) {
+  SemaphorePingPong* ping_pong = reinterpret_cast<SemaphorePingPong*>(arg);
+  while (true) {
+    sem_wait(&ping_pong->ping);
+    if (ping_pong->stop) {
+      break;
+    }
+    sem_post(&ping_pong->pong);
+  }
+  return NULL;
+}
+
+static void BM_semaphore_ping_pong(benchmark::State& state) {
+  SemaphorePingPong ping_pong;
+  sem_init(&ping_pong.ping, 0, 0);
+  sem_init(&ping_pong.pong, 0, 0);
+  ping_pong.stop = false;
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, SemaphorePongThread, &ping_pong);
+
+  LatencyHistogram latency;
+  latency.Start(state);
+  while (state.KeepRunning()) {
+    uint64_t start = LatencyHistogram::NowNs();
+    sem_post(&ping_pong.ping);
+    sem_wait(&ping_pong.pong);
+    latency.Record(state, LatencyHistogram::NowNs() - start);
+  }
+  state.SetItemsProcessed(state.iterations());
+  latency.Finish(state);
+
+  ping_pong.stop = true;
+  sem_post(&ping_pong.ping);
+  pthread_join(thread, NULL);
+  sem_destroy(&ping_pong.ping);
+  sem_destroy(&ping_pong.pong);
+}
+BENCHMARK(BM_semaphore_ping_pong)->UseRealTime();
+
 // This test reports the overhead of the underlying futex wake syscall on
 // the producer. It does not report the overhead from issuing the wake to the
 // point where the posted consumer thread wakes up. It suffers from
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// A DNS query is about this size.
+static constexpr size_t kMessageSize = 64;
+
+// A pair of UDP sockets on loopback, each connected to the other.
+struct UdpPair {
+  int tx = -1;
+  int rx = -1;
+
+  bool Open() {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    sockaddr_in tx_addr, rx_addr;
+
+    tx = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    rx = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (tx == -1 || rx == -1) return false;
+    if (bind(tx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 ||
+        bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+      return false;
+    }
+    if (getsockname(tx, reinterpret_cast<sockaddr*>(&tx_addr), &len) == -1) return false;
+    len = sizeof(rx_addr);
+    if (getsockname(rx, reinterpret_cast<sockaddr*>(&rx_addr), &len) == -1) return false;
+    return connect(tx, reinterpret_cast<sockaddr*>(&rx_addr), sizeof(rx_addr)) == 0 &&
+        connect(rx, reinterpret_cast<sockaddr*>(&tx_addr), sizeof(tx_addr)) == 0;
+  }
+
+  ~UdpPair() {
+    if (tx != -1) close(tx);
+    if (rx != -1) close(rx);
+  }
+};
+
+static void BM_socket_udp_send_recv(benchmark::State& state) {
+  const size_t batch = state.range(0);
+  UdpPair pair;
+  if (!pair.Open()) {
+    state.SkipWithError("couldn't open loopback UDP sockets");
+    return;
+  }
+  char buf[kMessageSize] = {};
+
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < batch; i++) {
+      send(pair.tx, buf, sizeof(buf), 0);
+    }
+    for (size_t i = 0; i < batch; i++) {
+      recv(pair.rx, buf, sizeof(buf), 0);
+    }
+  }
+  state.SetItemsProcessed(uint64_t(state.iterations()) * batch);
+}
+BENCHMARK(BM_socket_udp_send_recv)->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+
+static void BM_socket_udp_sendmmsg_recvmmsg(benchmark::State& state) {
+  const size_t batch = state.range(0);
+  UdpPair pair;
+  if (!pair.Open()) {
+    state.SkipWithError("couldn't open loopback UDP sockets");
+    return;
+  }
+  std::vector<char> bufs(batch * kMessageSize);
+  std::vector<iovec> iovs(batch);
+  std::vector<mmsghdr> msgs(batch);
+  for (size_t i = 0; i < batch; i++) {
+    iovs[i].iov_base = &bufs[i * kMessageSize];
+    iovs[i].iov_len = kMessageSize;
+    memset(&msgs[i], 0, sizeof(msgs[i]));
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  while (state.KeepRunning()) {
+    sendmmsg(pair.tx, msgs.data(), batch, 0);
+    recvmmsg(pair.rx, msgs.data(), batch, MSG_WAITFORONE, nullptr);
+  }
+  state.SetItemsProcessed(uint64_t(state.iterations()) * batch);
+}
+BENCHMARK(BM_socket_udp_sendmmsg_recvmmsg)->Arg(1)->Arg(2)->Arg(8)->Arg(32);
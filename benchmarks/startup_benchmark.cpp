@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "latency_histogram.h"
+#include "loader_test_libs.h"
+
+// Measures how long it takes from posix_spawn to reaping a process whose
+// main does next to nothing: that's the kernel's exec, the linker's startup
+// (including loading and relocating any libraries), libc's initialization,
+// and exit.
+//
+// The helpers run with LIBC_STARTUP_TRACE=1 and write the phases it records
+// to stdout as "name time_ns" lines. Each phase is charged with the time since
+// the one before it, or since posix_spawn was called for the first ("start"),
+// and the time from main to being reaped is charged to "exit". The label
+// shows the latency percentiles and the mean time of each phase.
+static LatencyHistogram g_startup_latency;
+
+class StartupPhases {
+ public:
+  void Add(const std::string& name, uint64_t ns) {
+    for (auto& phase : phases_) {
+      if (phase.first == name) {
+        phase.second += ns;
+        return;
+      }
+    }
+    phases_.emplace_back(name, ns);
+  }
+
+  std::string Describe(uint64_t runs) const {
+    std::string result;
+    for (const auto& phase : phases_) {
+      char buf[128];
+      snprintf(buf, sizeof(buf), "%s%s=%" PRIu64 "us", result.empty() ? "" : " ",
+               phase.first.c_str(), phase.second / runs / 1000);
+      result += buf;
+    }
+    return result;
+  }
+
+ private:
+  // Kept in the order they're first seen, which is the order they happen.
+  std::vector<std::pair<std::string, uint64_t>> phases_;
+};
+
+static bool RunHelper(const std::string& path, char** envp, uint64_t start_ns,
+                      StartupPhases* phases) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) return false;
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+  char* argv[] = { const_cast<char*>(path.c_str()), nullptr };
+  pid_t pid;
+  int error = posix_spawn(&pid, path.c_str(), &actions, nullptr, argv, envp);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[1]);
+  if (error != 0) {
+    close(fds[0]);
+    return false;
+  }
+
+  std::string output;
+  char buf[1024];
+  ssize_t n;
+  while ((n = TEMP_FAILURE_RETRY(read(fds[0], buf, sizeof(buf)))) > 0) {
+    output.append(buf, n);
+  }
+  close(fds[0]);
+
+  int status;
+  if (TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)) != pid ||
+      !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return false;
+  }
+  uint64_t end_ns = LatencyHistogram::NowNs();
+
+  uint64_t previous_ns = start_ns;
+  char name[64];
+  int64_t time_ns;
+  int consumed;
+  for (const char* p = output.c_str();
+       sscanf(p, "%63s %" SCNd64 "\n%n", name, &time_ns, &consumed) == 2; p += consumed) {
+    phases->Add(name, time_ns - previous_ns);
+    previous_ns = time_ns;
+  }
+  phases->Add("exit", end_ns - previous_ns);
+  return true;
+}
+
+// Runs tests/libs/startup_benchmark_helper.cpp built as 'helper', with the
+// first 'preloads' libraries of the linker benchmark chain in LD_PRELOAD.
+static void StartupLoop(benchmark::State& state, const std::string& helper, int64_t preloads) {
+  std::string path = LoaderTestLibPath(helper + "/" + helper);
+  if (access(path.c_str(), X_OK) == -1) {
+    state.SkipWithError((path + ": " + strerror(errno)).c_str());
+    return;
+  }
+
+  std::string preload = "LD_PRELOAD=";
+  for (int64_t i = 0; i < preloads; ++i) {
+    if (i > 0) preload += ":";
+    preload += LoaderTestLibPath("libtest_linker_benchmark_chain_" + std::to_string(i) + ".so");
+  }
+  std::vector<char*> envp;
+  envp.push_back(const_cast<char*>("LIBC_STARTUP_TRACE=1"));
+  if (preloads > 0) envp.push_back(const_cast<char*>(preload.c_str()));
+  envp.push_back(nullptr);
+
+  StartupPhases phases;
+  g_startup_latency.Start(state);
+  while (state.KeepRunning()) {
+    uint64_t start_ns = LatencyHistogram::NowNs();
+    if (!RunHelper(path, envp.data(), start_ns, &phases)) {
+      state.SkipWithError(("couldn't run " + path).c_str());
+      break;
+    }
+    g_startup_latency.Record(state, LatencyHistogram::NowNs() - start_ns);
+  }
+  if (state.iterations() > 0) {
+    g_startup_latency.Finish(state, phases.Describe(state.iterations()).c_str());
+  }
+}
+
+static void BM_startup_static(benchmark::State& state) {
+  StartupLoop(state, "startup_benchmark_helper_static", 0);
+}
+BENCHMARK(BM_startup_static)->UseRealTime();
+
+// range(0) is the number of libraries in LD_PRELOAD.
+static void BM_startup_dynamic(benchmark::State& state) {
+  StartupLoop(state, "startup_benchmark_helper", state.range(0));
+}
+BENCHMARK(BM_startup_dynamic)->Arg(0)->Arg(4)->Arg(8)->UseRealTime();
+
+// range(0) is the number of libraries the executable needs, directly or not.
+static void BM_startup_dynamic_needed(benchmark::State& state) {
+  StartupLoop(state, "startup_benchmark_helper_needed_" + std::to_string(state.range(0)), 0);
+}
+BENCHMARK(BM_startup_dynamic_needed)->Arg(1)->Arg(8)->UseRealTime();
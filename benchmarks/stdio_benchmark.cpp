@@ -14,9 +14,14 @@
  * limitations under the License.
  */
 
+#include <locale.h>
 #include <stdio.h>
 #include <stdio_ext.h>
 #include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#include <string>
 
 #include <benchmark/benchmark.h>
 
@@ -67,6 +72,26 @@ void BM_stdio_fwrite_unbuffered(benchmark::State& state) {
 }
 BENCHMARK(BM_stdio_fwrite_unbuffered)->AT_COMMON_SIZES;
 
+// Big writes with a partial line already buffered, as from a logger that writes a header and
+// then a payload.
+static void BM_stdio_fwrite_large(benchmark::State& state) {
+  size_t chunk_size = state.range(0);
+  FILE* fp = fopen("/dev/null", "we");
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  char* buf = new char[chunk_size];
+  memset(buf, 'x', chunk_size);
+
+  while (state.KeepRunning()) {
+    fputs("header: ", fp);
+    fwrite(buf, chunk_size, 1, fp);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(chunk_size));
+  delete[] buf;
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fwrite_large)->Arg(16*KB)->Arg(64*KB)->Arg(256*KB)->Arg(1024*KB);
+
 static void FopenFgetsFclose(benchmark::State& state, bool no_locking) {
   char buf[1024];
   while (state.KeepRunning()) {
@@ -86,3 +111,268 @@ void BM_stdio_fopen_fgets_fclose_no_locking(benchmark::State& state) {
   FopenFgetsFclose(state, true);
 }
 BENCHMARK(BM_stdio_fopen_fgets_fclose_no_locking);
+
+// A file big enough that reading it is dominated by the cost of the reads, not fopen.
+static FILE* MakeLargeFile(size_t size) {
+  FILE* fp = tmpfile();
+  if (fp == nullptr) abort();
+  // Short lines like a typical text file, for fgets.
+  char line[80];
+  memset(line, 'x', sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\n';
+  for (size_t i = 0; i < size; i += sizeof(line)) {
+    if (fwrite(line, sizeof(line), 1, fp) != 1) abort();
+  }
+  if (fflush(fp) != 0) abort();
+  return fp;
+}
+
+constexpr size_t kLargeFileSize = 16 * 1024 * KB;
+
+static void BM_stdio_fread_large_file(benchmark::State& state) {
+  size_t chunk_size = state.range(0);
+  FILE* fp = MakeLargeFile(kLargeFileSize);
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  char* buf = new char[chunk_size];
+
+  int64_t bytes = 0;
+  while (state.KeepRunning()) {
+    rewind(fp);
+    size_t n;
+    while ((n = fread(buf, 1, chunk_size, fp)) > 0) bytes += n;
+  }
+
+  state.SetBytesProcessed(bytes);
+  delete[] buf;
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fread_large_file)->Arg(64)->Arg(1*KB)->Arg(4*KB)->Arg(64*KB);
+
+static void BM_stdio_fgets_large_file(benchmark::State& state) {
+  FILE* fp = MakeLargeFile(kLargeFileSize);
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  char buf[1024];
+
+  int64_t bytes = 0;
+  while (state.KeepRunning()) {
+    rewind(fp);
+    while (fgets(buf, sizeof(buf), fp) != nullptr) bytes += strlen(buf);
+  }
+
+  state.SetBytesProcessed(bytes);
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fgets_large_file);
+
+static void BM_stdio_getline_large_file(benchmark::State& state) {
+  FILE* fp = MakeLargeFile(kLargeFileSize);
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  char* buf = nullptr;
+  size_t buf_size = 0;
+
+  int64_t bytes = 0;
+  while (state.KeepRunning()) {
+    rewind(fp);
+    ssize_t n;
+    while ((n = getline(&buf, &buf_size, fp)) != -1) bytes += n;
+  }
+
+  state.SetBytesProcessed(bytes);
+  free(buf);
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_getline_large_file);
+
+// Mostly ASCII with the occasional multibyte character, like most real text.
+static FILE* MakeLargeWideFile(size_t size) {
+  FILE* fp = tmpfile();
+  if (fp == nullptr) abort();
+  std::wstring line(77, L'x');
+  line += L"é\n";
+  for (size_t i = 0; i < size; i += line.size() + 1) {
+    if (fputws(line.c_str(), fp) == -1) abort();
+  }
+  if (fflush(fp) != 0) abort();
+  return fp;
+}
+
+static void BM_stdio_fgetws_large_file(benchmark::State& state) {
+  setlocale(LC_CTYPE, "C.UTF-8");
+  FILE* fp = MakeLargeWideFile(kLargeFileSize);
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  wchar_t buf[1024];
+
+  int64_t bytes = 0;
+  while (state.KeepRunning()) {
+    rewind(fp);
+    while (fgetws(buf, sizeof(buf) / sizeof(*buf), fp) != nullptr) bytes += wcslen(buf);
+  }
+
+  state.SetBytesProcessed(bytes);
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fgetws_large_file);
+
+static void BM_stdio_fputws(benchmark::State& state) {
+  setlocale(LC_CTYPE, "C.UTF-8");
+  FILE* fp = fopen("/dev/null", "we");
+  if (fp == nullptr) abort();
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  std::wstring line(state.range(0) - 1, L'x');
+  line += L'é';
+
+  while (state.KeepRunning()) {
+    fputws(line.c_str(), fp);
+  }
+
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(state.range(0)));
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fputws)->AT_COMMON_SIZES;
+
+#if defined(__BIONIC__)
+static void BM_stdio_getdelim_view_large_file(benchmark::State& state) {
+  FILE* fp = MakeLargeFile(kLargeFileSize);
+  __fsetlocking(fp, FSETLOCKING_BYCALLER);
+  const char* line;
+  char* buf = nullptr;
+  size_t buf_size = 0;
+
+  int64_t bytes = 0;
+  while (state.KeepRunning()) {
+    rewind(fp);
+    ssize_t n;
+    while ((n = getdelim_view(&line, &buf, &buf_size, '\n', fp)) != -1) bytes += n;
+  }
+
+  state.SetBytesProcessed(bytes);
+  free(buf);
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_getdelim_view_large_file);
+#endif
+
+// snprintf's fast path handles formats like these. The "_general" variants add a field
+// width that doesn't change the output, which forces the general vfprintf path for comparison.
+static void SnprintfD(benchmark::State& state, const char* fmt) {
+  char buf[32];
+  int i = 0;
+  while (state.KeepRunning()) {
+    snprintf(buf, sizeof(buf), fmt, i++);
+    benchmark::DoNotOptimize(buf);
+  }
+}
+
+static void BM_stdio_snprintf_d(benchmark::State& state) {
+  SnprintfD(state, "%d");
+}
+BENCHMARK(BM_stdio_snprintf_d);
+
+static void BM_stdio_snprintf_d_general(benchmark::State& state) {
+  SnprintfD(state, "%1d");
+}
+BENCHMARK(BM_stdio_snprintf_d_general);
+
+static void SnprintfMixed(benchmark::State& state, const char* fmt) {
+  char buf[128];
+  size_t n = 0;
+  while (state.KeepRunning()) {
+    snprintf(buf, sizeof(buf), fmt, "/data/local/tmp", 1234, n++, &buf);
+    benchmark::DoNotOptimize(buf);
+  }
+}
+
+static void BM_stdio_snprintf_mixed(benchmark::State& state) {
+  SnprintfMixed(state, "path=%s pid=%d count=%zu at %p");
+}
+BENCHMARK(BM_stdio_snprintf_mixed);
+
+static void BM_stdio_snprintf_mixed_general(benchmark::State& state) {
+  SnprintfMixed(state, "path=%1s pid=%d count=%zu at %p");
+}
+BENCHMARK(BM_stdio_snprintf_mixed_general);
+
+static void SnprintfDouble(benchmark::State& state, const char* fmt) {
+  char buf[64];
+  double d = 0.1;
+  while (state.KeepRunning()) {
+    snprintf(buf, sizeof(buf), fmt, d);
+    benchmark::DoNotOptimize(buf);
+    d += 1.375;
+  }
+}
+
+static void BM_stdio_snprintf_f(benchmark::State& state) {
+  SnprintfDouble(state, "%f");
+}
+BENCHMARK(BM_stdio_snprintf_f);
+
+static void BM_stdio_snprintf_g17(benchmark::State& state) {
+  SnprintfDouble(state, "%.17g");
+}
+BENCHMARK(BM_stdio_snprintf_g17);
+
+static void BM_stdio_strtod(benchmark::State& state) {
+  const char* numbers[] = { "0.10000000000000001", "123456.789", "-2.5e-7", "1.7976931348623157" };
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strtod(numbers[i++ % 4], nullptr));
+  }
+}
+BENCHMARK(BM_stdio_strtod);
+
+// sscanf's fast path handles formats like this. The "_general" variant adds a conversion
+// with no input left for it, which doesn't change the result but forces the FILE-based path.
+static void SscanfMixed(benchmark::State& state, const char* fmt) {
+  int pid, uid;
+  char name[32];
+  while (state.KeepRunning()) {
+    sscanf("1234 10057 com.android.phone", fmt, &pid, &uid, name);
+    benchmark::DoNotOptimize(name);
+  }
+}
+
+static void BM_stdio_sscanf_mixed(benchmark::State& state) {
+  SscanfMixed(state, "%d %d %31s");
+}
+BENCHMARK(BM_stdio_sscanf_mixed);
+
+static void BM_stdio_sscanf_mixed_general(benchmark::State& state) {
+  SscanfMixed(state, "%d %d %31s%*e");
+}
+BENCHMARK(BM_stdio_sscanf_mixed_general);
+
+// Builds 1MiB of output in memory, a line at a time.
+static void FillMemoryStream(FILE* fp) {
+  for (size_t i = 0; i < 16 * KB; ++i) {
+    fputs("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde\n", fp);
+  }
+}
+
+static void BM_stdio_open_memstream(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    char* p;
+    size_t size;
+    FILE* fp = open_memstream(&p, &size);
+    FillMemoryStream(fp);
+    fclose(fp);
+    free(p);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * 1024 * KB);
+}
+BENCHMARK(BM_stdio_open_memstream);
+
+#if defined(__BIONIC__)
+static void BM_stdio_open_iovstream(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    FILE* fp = open_iovstream();
+    FillMemoryStream(fp);
+    const struct iovec* iov;
+    int iovcnt;
+    benchmark::DoNotOptimize(iovstream_getiov(fp, &iov, &iovcnt));
+    fclose(fp);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * 1024 * KB);
+}
+BENCHMARK(BM_stdio_open_iovstream);
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <search.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Each benchmark sorts an array of state.range(0) elements with keys in the given order.
+// The 24-byte elements take qsort's generic path; 4 and 8 bytes have their own.
+
+enum class Order { kSorted, kReversed, kRandom, kFewKeys };
+
+template <typename T>
+static int CompareKeys(const void* lhs, const void* rhs) {
+  uint32_t a = reinterpret_cast<const T*>(lhs)->key;
+  uint32_t b = reinterpret_cast<const T*>(rhs)->key;
+  return (a > b) - (a < b);
+}
+
+struct Key4 { uint32_t key; };
+struct Key8 { uint32_t key; uint32_t value; };
+struct Key24 { uint32_t key; char value[20]; };
+
+template <typename T>
+static void Qsort(benchmark::State& state, Order order) {
+  size_t n = state.range(0);
+  std::vector<T> original(n);
+  srandom(1);
+  for (size_t i = 0; i < n; ++i) {
+    memset(&original[i], 0, sizeof(T));
+    switch (order) {
+      case Order::kSorted: original[i].key = i; break;
+      case Order::kReversed: original[i].key = n - i; break;
+      case Order::kRandom: original[i].key = random(); break;
+      case Order::kFewKeys: original[i].key = random() % 16; break;
+    }
+  }
+
+  std::vector<T> v(n);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    v = original;
+    state.ResumeTiming();
+    qsort(v.data(), n, sizeof(T), CompareKeys<T>);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define QSORT_BENCHMARKS(T) \
+  static void BM_stdlib_qsort_sorted_##T(benchmark::State& s) { Qsort<T>(s, Order::kSorted); } \
+  BENCHMARK(BM_stdlib_qsort_sorted_##T)->Arg(16)->Arg(1024)->Arg(64*1024); \
+  static void BM_stdlib_qsort_reversed_##T(benchmark::State& s) { Qsort<T>(s, Order::kReversed); } \
+  BENCHMARK(BM_stdlib_qsort_reversed_##T)->Arg(16)->Arg(1024)->Arg(64*1024); \
+  static void BM_stdlib_qsort_random_##T(benchmark::State& s) { Qsort<T>(s, Order::kRandom); } \
+  BENCHMARK(BM_stdlib_qsort_random_##T)->Arg(16)->Arg(1024)->Arg(64*1024); \
+  static void BM_stdlib_qsort_few_keys_##T(benchmark::State& s) { Qsort<T>(s, Order::kFewKeys); } \
+  BENCHMARK(BM_stdlib_qsort_few_keys_##T)->Arg(16)->Arg(1024)->Arg(64*1024)
+
+QSORT_BENCHMARKS(Key4);
+QSORT_BENCHMARKS(Key8);
+QSORT_BENCHMARKS(Key24);
+
+static int CompareInts(const void* lhs, const void* rhs) {
+  int a = *reinterpret_cast<const int*>(lhs);
+  int b = *reinterpret_cast<const int*>(rhs);
+  return (a > b) - (a < b);
+}
+
+// Inserting keys in order is the worst case for an unbalanced tree.
+static void BM_search_tsearch_sorted(benchmark::State& state) {
+  std::vector<int> keys(state.range(0));
+  for (size_t i = 0; i < keys.size(); ++i) keys[i] = i;
+  while (state.KeepRunning()) {
+    void* root = nullptr;
+    for (int& key : keys) tsearch(&key, &root, CompareInts);
+    state.PauseTiming();
+    tdestroy(root, [](void*) {});
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_search_tsearch_sorted)->Arg(1024)->Arg(16*1024);
+
+static void BM_search_hsearch_r(benchmark::State& state) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < state.range(0); ++i) keys.push_back("key" + std::to_string(i));
+  hsearch_data table = {};
+  hcreate_r(keys.size(), &table);
+  for (std::string& key : keys) {
+    ENTRY* e;
+    hsearch_r(ENTRY{ &key[0], nullptr }, ENTER, &e, &table);
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    ENTRY* e;
+    hsearch_r(ENTRY{ &keys[i][0], nullptr }, FIND, &e, &table);
+    if (++i == keys.size()) i = 0;
+  }
+  hdestroy_r(&table);
+}
+BENCHMARK(BM_search_hsearch_r)->Arg(1024)->Arg(64*1024);
+
+#if defined(__BIONIC__)
+// arc4random_buf from several threads at once, as in request ID generators. Each
+// thread has its own generator, so this should scale with the number of threads.
+static void BM_stdlib_arc4random_buf(benchmark::State& state) {
+  uint8_t buf[16];
+  while (state.KeepRunning()) {
+    arc4random_buf(buf, sizeof(buf));
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(buf));
+}
+BENCHMARK(BM_stdlib_arc4random_buf)->ThreadRange(1, 8)->UseRealTime();
+#endif
+
+// Looks up a variable that isn't set, which is what tzset's getenv("TZ")
+// usually does, in an environment with state.range(0) other variables.
+static void BM_stdlib_getenv(benchmark::State& state) {
+  std::vector<std::string> strings;
+  std::vector<char*> env;
+  for (int i = 0; i < state.range(0); ++i) {
+    strings.push_back("VARIABLE_" + std::to_string(i) + "=/some/path/" + std::to_string(i));
+  }
+  for (std::string& s : strings) env.push_back(&s[0]);
+  env.push_back(nullptr);
+
+  char** old_environ = environ;
+  environ = env.data();
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(getenv("TZ"));
+  }
+  environ = old_environ;
+}
+BENCHMARK(BM_stdlib_getenv)->Arg(10)->Arg(300);
+
+// Decodes an ASCII string a character at a time, checking MB_CUR_MAX as
+// code that sizes its buffers by it tends to.
+static void BM_stdlib_mbrtowc_ascii(benchmark::State& state) {
+  std::string s(state.range(0), 'x');
+  while (state.KeepRunning()) {
+    mbstate_t mbs = {};
+    size_t n = 0;
+    for (size_t i = 0; i < s.size(); i += mbrtowc(nullptr, &s[i], MB_CUR_MAX, &mbs)) {
+      ++n;
+    }
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(uint64_t(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_stdlib_mbrtowc_ascii)->Arg(1024);
+
+// Protocol and file parsers mostly parse short decimal numbers.
+static void BM_stdlib_strtoul_short(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strtoul("8080", nullptr, 10));
+  }
+}
+BENCHMARK(BM_stdlib_strtoul_short);
+
+static void BM_stdlib_strtoll_long(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strtoll("-1234567890123456789", nullptr, 10));
+  }
+}
+BENCHMARK(BM_stdlib_strtoll_long);
+
+static void BM_stdlib_strtoul_hex(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strtoul("0x7fffdeadbeef", nullptr, 0));
+  }
+}
+BENCHMARK(BM_stdlib_strtoul_hex);
+
+static void BM_stdlib_atoi(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(atoi("  12345"));
+  }
+}
+BENCHMARK(BM_stdlib_atoi);
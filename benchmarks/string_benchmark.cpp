@@ -17,6 +17,9 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <memory>
+#include <string>
+
 #include <benchmark/benchmark.h>
 
 constexpr auto KB = 1024;
@@ -24,7 +27,91 @@ constexpr auto KB = 1024;
 #define AT_COMMON_SIZES \
     Arg(8)->Arg(64)->Arg(512)->Arg(1*KB)->Arg(8*KB)->Arg(16*KB)->Arg(32*KB)->Arg(64*KB)
 
-// TODO: test unaligned operation too? (currently everything will be 8-byte aligned by malloc.)
+// The benchmarks that just take a size use new[]'s 8- or 16-byte alignment. The
+// _aligned variants below take the offset from a 64-byte boundary of their buffers
+// too, so the cost of misalignment can be seen per function, and the _cold variants
+// show the cost of the data not being in any cache.
+
+constexpr size_t kAlignment = 64;
+
+// A buffer of nbytes whose start is offset bytes past a 64-byte boundary.
+class AlignedBuffer {
+ public:
+  AlignedBuffer(size_t nbytes, size_t offset) : storage_(new char[nbytes + 2 * kAlignment]) {
+    uintptr_t p = reinterpret_cast<uintptr_t>(storage_.get());
+    p = (p + kAlignment - 1) & ~(kAlignment - 1);
+    ptr_ = reinterpret_cast<char*>(p + offset);
+  }
+
+  char* get() { return ptr_; }
+
+ private:
+  std::unique_ptr<char[]> storage_;
+  char* ptr_;
+};
+
+// Far bigger than any last-level cache. Each call gets its own page-aligned piece,
+// and consecutive calls get different pages so that the prefetchers, which don't
+// cross pages, can't get ahead of the function either.
+constexpr size_t kColdBytes = 64 * 1024 * KB;
+
+class ColdBuffer {
+ public:
+  ColdBuffer(size_t nbytes, char fill) {
+    stride_ = (nbytes + 4 * KB - 1) & ~(4 * KB - 1);
+    count_ = (kColdBytes > stride_) ? kColdBytes / stride_ : 1;
+    storage_.reset(new char[stride_ * count_]);
+    // Touch every page, or reads would all come from the shared zero page.
+    memset(storage_.get(), fill, stride_ * count_);
+    next_ = 0;
+  }
+
+  char* next() {
+    char* result = storage_.get() + next_ * stride_;
+    if (++next_ == count_) next_ = 0;
+    return result;
+  }
+
+  size_t count() const { return count_; }
+
+ private:
+  std::unique_ptr<char[]> storage_;
+  size_t stride_;
+  size_t count_;
+  size_t next_;
+};
+
+// range(0) is the size, and range(1) and range(2) are the offsets of the source and
+// destination from a 64-byte boundary. Each offset is swept with the other aligned.
+static void AlignmentPairArgs(benchmark::internal::Benchmark* b) {
+  for (int nbytes : {16, 512, 8 * KB}) {
+    for (int offset = 0; offset < static_cast<int>(kAlignment); ++offset) {
+      b->Args({nbytes, offset, 0});
+    }
+    for (int offset = 1; offset < static_cast<int>(kAlignment); ++offset) {
+      b->Args({nbytes, 0, offset});
+    }
+  }
+}
+
+// range(0) is the size and range(1) the offset of the only buffer.
+static void AlignmentArgs(benchmark::internal::Benchmark* b) {
+  for (int nbytes : {16, 512, 8 * KB}) {
+    for (int offset = 0; offset < static_cast<int>(kAlignment); ++offset) {
+      b->Args({nbytes, offset});
+    }
+  }
+}
+
+// Every size up to 128, where the head and tail handling dominates.
+static void SmallSizeArgs(benchmark::internal::Benchmark* b) {
+  for (int nbytes = 1; nbytes <= 128; ++nbytes) {
+    b->Arg(nbytes);
+  }
+}
+
+#define AT_COLD_SIZES \
+    Arg(8)->Arg(64)->Arg(512)->Arg(4*KB)->Arg(64*KB)
 
 static void BM_string_memcmp(benchmark::State& state) {
   const size_t nbytes = state.range(0);
@@ -42,6 +129,24 @@ static void BM_string_memcmp(benchmark::State& state) {
   delete[] dst;
 }
 BENCHMARK(BM_string_memcmp)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memcmp)->Apply(SmallSizeArgs);
+
+static void BM_string_memchr(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 'y';
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (memchr(s, 'y', nbytes) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_memchr)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memchr)->Apply(SmallSizeArgs);
 
 static void BM_string_memcpy(benchmark::State& state) {
   const size_t nbytes = state.range(0);
@@ -57,6 +162,62 @@ static void BM_string_memcpy(benchmark::State& state) {
   delete[] dst;
 }
 BENCHMARK(BM_string_memcpy)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memcpy)->Apply(SmallSizeArgs);
+// Big enough for the copy to miss in (some of) the caches.
+BENCHMARK(BM_string_memcpy)->Arg(256*KB)->Arg(1024*KB)->Arg(4096*KB);
+
+// The _chk variants are what FORTIFY calls when it can't prove at compile-time
+// that the destination is big enough; comparing them with the plain functions on
+// small sizes shows what the header's folding to the unchecked routines saves.
+extern "C" void* __memcpy_chk(void*, const void*, size_t, size_t);
+extern "C" char* __strcpy_chk(char*, const char*, size_t);
+
+static void BM_string_memcpy_chk(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* src = new char[nbytes]; char* dst = new char[nbytes];
+  memset(src, 'x', nbytes);
+
+  while (state.KeepRunning()) {
+    __memcpy_chk(dst, src, nbytes, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_memcpy_chk)->Apply(SmallSizeArgs);
+
+static void BM_string_strcpy(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* src = new char[nbytes]; char* dst = new char[nbytes];
+  memset(src, 'x', nbytes);
+  src[nbytes - 1] = '\0';
+
+  while (state.KeepRunning()) {
+    strcpy(dst, src);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_strcpy)->Apply(SmallSizeArgs);
+
+static void BM_string_strcpy_chk(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* src = new char[nbytes]; char* dst = new char[nbytes];
+  memset(src, 'x', nbytes);
+  src[nbytes - 1] = '\0';
+
+  while (state.KeepRunning()) {
+    __strcpy_chk(dst, src, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_strcpy_chk)->Apply(SmallSizeArgs);
 
 static void BM_string_memmove(benchmark::State& state) {
   const size_t nbytes = state.range(0);
@@ -71,6 +232,39 @@ static void BM_string_memmove(benchmark::State& state) {
   delete[] buf;
 }
 BENCHMARK(BM_string_memmove)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memmove)->Apply(SmallSizeArgs);
+
+// With the destination above the source, a memmove has to copy backwards.
+static void BM_string_memmove_backward(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* buf = new char[nbytes + 64];
+  memset(buf, 'x', nbytes + 64);
+
+  while (state.KeepRunning()) {
+    memmove(buf + 1, buf, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] buf;
+}
+BENCHMARK(BM_string_memmove_backward)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memmove_backward)->Apply(SmallSizeArgs);
+
+// The common case of a memmove that could have been a memcpy.
+static void BM_string_memmove_disjoint(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* src = new char[nbytes]; char* dst = new char[nbytes];
+  memset(src, 'x', nbytes);
+
+  while (state.KeepRunning()) {
+    memmove(dst, src, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_memmove_disjoint)->AT_COMMON_SIZES;
 
 static void BM_string_memset(benchmark::State& state) {
   const size_t nbytes = state.range(0);
@@ -84,6 +278,7 @@ static void BM_string_memset(benchmark::State& state) {
   delete[] dst;
 }
 BENCHMARK(BM_string_memset)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memset)->Apply(SmallSizeArgs);
 
 static void BM_string_strlen(benchmark::State& state) {
   const size_t nbytes = state.range(0);
@@ -100,3 +295,353 @@ static void BM_string_strlen(benchmark::State& state) {
   delete[] s;
 }
 BENCHMARK(BM_string_strlen)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_strlen)->Apply(SmallSizeArgs);
+
+static void BM_string_strrchr(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[0] = 'y';
+  s[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (strrchr(s, 'y') != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strrchr)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_strrchr)->Apply(SmallSizeArgs);
+
+static void BM_string_strspn(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* s = new char[nbytes];
+  for (size_t i = 0; i < nbytes; ++i) {
+    s[i] = "abcdefgh"[i % 8];
+  }
+  s[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += strspn(s, "abcdefgh");
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strspn)->AT_COMMON_SIZES;
+
+static void BM_string_strchr(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (strchr(s, 'y') != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strchr)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_strchr)->Apply(SmallSizeArgs);
+
+static void BM_string_strncmp(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  char* s1 = new char[nbytes]; char* s2 = new char[nbytes];
+  memset(s1, 'x', nbytes);
+  memset(s2, 'x', nbytes);
+  s1[nbytes - 1] = 0;
+  s2[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += strncmp(s1, s2, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+  delete[] s1;
+  delete[] s2;
+}
+BENCHMARK(BM_string_strncmp)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_strncmp)->Apply(SmallSizeArgs);
+
+static void BM_string_memcpy_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer src(nbytes, state.range(1));
+  AlignedBuffer dst(nbytes, state.range(2));
+  memset(src.get(), 'x', nbytes);
+
+  while (state.KeepRunning()) {
+    memcpy(dst.get(), src.get(), nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memcpy_aligned)->Apply(AlignmentPairArgs);
+
+static void BM_string_memmove_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer src(nbytes, state.range(1));
+  AlignedBuffer dst(nbytes, state.range(2));
+  memset(src.get(), 'x', nbytes);
+
+  while (state.KeepRunning()) {
+    memmove(dst.get(), src.get(), nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memmove_aligned)->Apply(AlignmentPairArgs);
+
+static void BM_string_memcmp_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer src(nbytes, state.range(1));
+  AlignedBuffer dst(nbytes, state.range(2));
+  memset(src.get(), 'x', nbytes);
+  memset(dst.get(), 'x', nbytes);
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += memcmp(dst.get(), src.get(), nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memcmp_aligned)->Apply(AlignmentPairArgs);
+
+static void BM_string_strcpy_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer src(nbytes, state.range(1));
+  AlignedBuffer dst(nbytes, state.range(2));
+  memset(src.get(), 'x', nbytes);
+  src.get()[nbytes - 1] = 0;
+
+  while (state.KeepRunning()) {
+    strcpy(dst.get(), src.get());
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_strcpy_aligned)->Apply(AlignmentPairArgs);
+
+static void BM_string_strncmp_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer s1(nbytes, state.range(1));
+  AlignedBuffer s2(nbytes, state.range(2));
+  memset(s1.get(), 'x', nbytes);
+  memset(s2.get(), 'x', nbytes);
+  s1.get()[nbytes - 1] = 0;
+  s2.get()[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += strncmp(s1.get(), s2.get(), nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_strncmp_aligned)->Apply(AlignmentPairArgs);
+
+static void BM_string_memset_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer dst(nbytes, state.range(1));
+
+  while (state.KeepRunning()) {
+    memset(dst.get(), 0, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memset_aligned)->Apply(AlignmentArgs);
+
+static void BM_string_memchr_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer s(nbytes, state.range(1));
+  memset(s.get(), 'x', nbytes);
+  s.get()[nbytes - 1] = 'y';
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (memchr(s.get(), 'y', nbytes) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memchr_aligned)->Apply(AlignmentArgs);
+
+static void BM_string_strlen_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer s(nbytes, state.range(1));
+  memset(s.get(), 'x', nbytes);
+  s.get()[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += strlen(s.get());
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_strlen_aligned)->Apply(AlignmentArgs);
+
+static void BM_string_strchr_aligned(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  AlignedBuffer s(nbytes, state.range(1));
+  memset(s.get(), 'x', nbytes);
+  s.get()[nbytes - 1] = 0;
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (strchr(s.get(), 'y') != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_strchr_aligned)->Apply(AlignmentArgs);
+
+static void BM_string_memcpy_cold(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  ColdBuffer src(nbytes, 'x');
+  ColdBuffer dst(nbytes, 0);
+
+  while (state.KeepRunning()) {
+    memcpy(dst.next(), src.next(), nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memcpy_cold)->AT_COLD_SIZES;
+
+static void BM_string_memset_cold(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  ColdBuffer dst(nbytes, 0);
+
+  while (state.KeepRunning()) {
+    memset(dst.next(), 0, nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memset_cold)->AT_COLD_SIZES;
+
+static void BM_string_memcmp_cold(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  ColdBuffer s1(nbytes, 'x');
+  ColdBuffer s2(nbytes, 'x');
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += memcmp(s1.next(), s2.next(), nbytes);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memcmp_cold)->AT_COLD_SIZES;
+
+static void BM_string_memchr_cold(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  ColdBuffer s(nbytes, 'x');
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (memchr(s.next(), 'y', nbytes) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_memchr_cold)->AT_COLD_SIZES;
+
+static void BM_string_strlen_cold(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  ColdBuffer s(nbytes, 'x');
+  for (size_t i = 0; i < s.count(); ++i) {
+    s.next()[nbytes - 1] = 0;
+  }
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += strlen(s.next());
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BENCHMARK(BM_string_strlen_cold)->AT_COLD_SIZES;
+
+// A log-line-like haystack of mostly lowercase words. range(0) is its size and range(1) the
+// needle length; the needle isn't in it, but its first and last bytes often are.
+static std::string MakeHaystack(size_t nbytes) {
+  std::string haystack;
+  for (size_t i = 0; haystack.size() < nbytes; ++i) {
+    haystack += "abcdefghij"[i % 10];
+    if (i % 7 == 6) haystack += ' ';
+  }
+  haystack.resize(nbytes);
+  return haystack;
+}
+
+static std::string MakeNeedle(size_t length) {
+  std::string needle(length, 'e');
+  needle.front() = 'a';
+  needle.back() = 'z';
+  return needle;
+}
+
+static void BM_string_memmem(benchmark::State& state) {
+  std::string haystack = MakeHaystack(state.range(0));
+  std::string needle = MakeNeedle(state.range(1));
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (memmem(haystack.data(), haystack.size(), needle.data(), needle.size()) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(haystack.size()));
+}
+BENCHMARK(BM_string_memmem)->Args({4*KB, 4})->Args({4*KB, 16})->Args({4*KB, 256})
+    ->Args({64*KB, 4})->Args({64*KB, 256});
+
+static void BM_string_strstr(benchmark::State& state) {
+  std::string haystack = MakeHaystack(state.range(0));
+  std::string needle = MakeNeedle(state.range(1));
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (strstr(haystack.c_str(), needle.c_str()) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(haystack.size()));
+}
+BENCHMARK(BM_string_strstr)->Args({4*KB, 4})->Args({4*KB, 16})->Args({4*KB, 256})
+    ->Args({64*KB, 4})->Args({64*KB, 256});
+
+// The worst case for naive algorithms: every position nearly matches.
+static void BM_string_memmem_near_misses(benchmark::State& state) {
+  std::string haystack(state.range(0), 'a');
+  std::string needle = std::string(state.range(1) - 1, 'a') + "b";
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (memmem(haystack.data(), haystack.size(), needle.data(), needle.size()) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(haystack.size()));
+}
+BENCHMARK(BM_string_memmem_near_misses)->Args({4*KB, 16})->Args({64*KB, 256});
+
+static void BM_string_strstr_near_misses(benchmark::State& state) {
+  std::string haystack(state.range(0), 'a');
+  std::string needle = std::string(state.range(1) - 1, 'a') + "b";
+
+  volatile int c __attribute__((unused)) = 0;
+  while (state.KeepRunning()) {
+    c += (strstr(haystack.c_str(), needle.c_str()) != nullptr);
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(haystack.size()));
+}
+BENCHMARK(BM_string_strstr_near_misses)->Args({4*KB, 16})->Args({64*KB, 256});
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <sched.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
 #include <time.h>
@@ -21,6 +22,10 @@
 
 #include <benchmark/benchmark.h>
 
+#if defined(__BIONIC__)
+#include <android/strftime.h>
+#endif
+
 static void BM_time_clock_gettime(benchmark::State& state) {
   timespec t;
   while (state.KeepRunning()) {
@@ -37,6 +42,22 @@ static void BM_time_clock_gettime_syscall(benchmark::State& state) {
 }
 BENCHMARK(BM_time_clock_gettime_syscall);
 
+static void BM_time_clock_gettime_MONOTONIC_COARSE(benchmark::State& state) {
+  timespec t;
+  while (state.KeepRunning()) {
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &t);
+  }
+}
+BENCHMARK(BM_time_clock_gettime_MONOTONIC_COARSE);
+
+static void BM_time_clock_gettime_REALTIME_COARSE(benchmark::State& state) {
+  timespec t;
+  while (state.KeepRunning()) {
+    clock_gettime(CLOCK_REALTIME_COARSE, &t);
+  }
+}
+BENCHMARK(BM_time_clock_gettime_REALTIME_COARSE);
+
 static void BM_time_gettimeofday(benchmark::State& state) {
   timeval tv;
   while (state.KeepRunning()) {
@@ -60,6 +81,46 @@ void BM_time_time(benchmark::State& state) {
 }
 BENCHMARK(BM_time_time);
 
+void BM_time_time_syscall(benchmark::State& state) {
+  timeval tv;
+  while (state.KeepRunning()) {
+    // Not every architecture has __NR_time, so measure what time used to cost.
+    syscall(__NR_gettimeofday, &tv, nullptr);
+  }
+}
+BENCHMARK(BM_time_time_syscall);
+
+static void BM_time_clock_getres(benchmark::State& state) {
+  timespec t;
+  while (state.KeepRunning()) {
+    clock_getres(CLOCK_MONOTONIC, &t);
+  }
+}
+BENCHMARK(BM_time_clock_getres);
+
+static void BM_time_clock_getres_syscall(benchmark::State& state) {
+  timespec t;
+  while (state.KeepRunning()) {
+    syscall(__NR_clock_getres, CLOCK_MONOTONIC, &t);
+  }
+}
+BENCHMARK(BM_time_clock_getres_syscall);
+
+static void BM_time_sched_getcpu(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    sched_getcpu();
+  }
+}
+BENCHMARK(BM_time_sched_getcpu);
+
+static void BM_time_getcpu_syscall(benchmark::State& state) {
+  unsigned cpu;
+  while (state.KeepRunning()) {
+    syscall(__NR_getcpu, &cpu, nullptr, nullptr);
+  }
+}
+BENCHMARK(BM_time_getcpu_syscall);
+
 void BM_time_localtime(benchmark::State& state) {
   time_t t = time(nullptr);
   while (state.KeepRunning()) {
@@ -76,3 +137,45 @@ void BM_time_localtime_r(benchmark::State& state) {
   }
 }
 BENCHMARK(BM_time_localtime_r);
+
+// Like a logger stamping each line: the time moves forward a little per call.
+void BM_time_localtime_r_advancing(benchmark::State& state) {
+  time_t t = time(nullptr);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    struct tm tm;
+    time_t now = t + (i++ / 64);
+    localtime_r(&now, &tm);
+  }
+}
+BENCHMARK(BM_time_localtime_r_advancing);
+
+void BM_time_strftime(benchmark::State& state) {
+  time_t t = time(nullptr);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    struct tm tm;
+    char buf[64];
+    time_t now = t + (i++ / 64);
+    localtime_r(&now, &tm);
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %Z", &tm);
+  }
+}
+BENCHMARK(BM_time_strftime);
+
+#if defined(__BIONIC__)
+void BM_time_android_strftime_format(benchmark::State& state) {
+  time_t t = time(nullptr);
+  size_t i = 0;
+  android_strftime_plan* plan = android_strftime_compile("%Y-%m-%d %H:%M:%S %Z");
+  while (state.KeepRunning()) {
+    struct tm tm;
+    char buf[64];
+    time_t now = t + (i++ / 64);
+    localtime_r(&now, &tm);
+    android_strftime_format(buf, sizeof(buf), plan, &tm);
+  }
+  android_strftime_plan_free(plan);
+}
+BENCHMARK(BM_time_android_strftime_format);
+#endif
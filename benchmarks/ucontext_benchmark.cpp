@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <signal.h>
+#include <ucontext.h>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#if !defined(__mips__)
+
+static void BM_ucontext_getcontext(benchmark::State& state) {
+  ucontext_t uc;
+  while (state.KeepRunning()) {
+    getcontext(&uc);
+  }
+}
+BENCHMARK(BM_ucontext_getcontext);
+
+static ucontext_t g_main_context;
+static ucontext_t g_coroutine_context;
+
+static void Coroutine() {
+  while (true) {
+    swapcontext(&g_coroutine_context, &g_main_context);
+  }
+}
+
+// Each iteration is a round trip: into the coroutine and back.
+static void BM_ucontext_swapcontext(benchmark::State& state) {
+  std::vector<char> stack(64 * 1024);
+  getcontext(&g_coroutine_context);
+  g_coroutine_context.uc_stack.ss_sp = stack.data();
+  g_coroutine_context.uc_stack.ss_size = stack.size();
+  g_coroutine_context.uc_link = nullptr;
+  makecontext(&g_coroutine_context, Coroutine, 0);
+
+  while (state.KeepRunning()) {
+    swapcontext(&g_main_context, &g_coroutine_context);
+  }
+}
+BENCHMARK(BM_ucontext_swapcontext);
+
+// The same, but with the coroutine's signal mask different from ours, so that
+// every switch has to change it.
+static void BM_ucontext_swapcontext_different_masks(benchmark::State& state) {
+  std::vector<char> stack(64 * 1024);
+  getcontext(&g_coroutine_context);
+  g_coroutine_context.uc_stack.ss_sp = stack.data();
+  g_coroutine_context.uc_stack.ss_size = stack.size();
+  g_coroutine_context.uc_link = nullptr;
+  sigaddset(&g_coroutine_context.uc_sigmask, SIGUSR1);
+  makecontext(&g_coroutine_context, Coroutine, 0);
+
+  while (state.KeepRunning()) {
+    swapcontext(&g_main_context, &g_coroutine_context);
+  }
+}
+BENCHMARK(BM_ucontext_swapcontext_different_masks);
+
+#endif
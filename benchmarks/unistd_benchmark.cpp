@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#include <spawn.h>
+#include <string.h>
+#include <sys/auxv.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <benchmark/benchmark.h>
@@ -54,4 +59,83 @@ void BM_unistd_gettid_syscall(benchmark::State& state) {
 }
 BENCHMARK(BM_unistd_gettid_syscall);
 
+// fork runs every pthread_atfork handler (including the allocator's) in the
+// parent and child, while vfork runs none, which is the cost a child that
+// just calls exec can avoid.
+static void BM_unistd_fork_exit(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    pid_t pid = fork();
+    if (pid == 0) _exit(0);
+    waitpid(pid, nullptr, 0);
+  }
+}
+BENCHMARK(BM_unistd_fork_exit);
+
+static void BM_unistd_vfork_exit(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    pid_t pid = vfork();
+    if (pid == 0) _exit(0);
+    waitpid(pid, nullptr, 0);
+  }
+}
+BENCHMARK(BM_unistd_vfork_exit);
+
+// Starting "true" with fork+exec copies the parent's page tables, so it gets
+// slower as the parent grows; posix_spawn shares the parent's memory until the
+// exec and shouldn't. The argument is how many MiB the parent has dirtied.
+static void* DirtyMemory(size_t mib) {
+  if (mib == 0) return nullptr;
+  void* p = mmap(nullptr, mib << 20, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  memset(p, 1, mib << 20);
+  return p;
+}
+
+static void BM_unistd_fork_exec_true(benchmark::State& state) {
+  size_t mib = state.range(0);
+  void* p = DirtyMemory(mib);
+  char* const argv[] = { const_cast<char*>("true"), nullptr };
+  while (state.KeepRunning()) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      execvp("true", argv);
+      _exit(127);
+    }
+    waitpid(pid, nullptr, 0);
+  }
+  if (p != nullptr) munmap(p, mib << 20);
+}
+BENCHMARK(BM_unistd_fork_exec_true)->Arg(0)->Arg(256);
+
+static void BM_unistd_posix_spawn_true(benchmark::State& state) {
+  size_t mib = state.range(0);
+  void* p = DirtyMemory(mib);
+  char* const argv[] = { const_cast<char*>("true"), nullptr };
+  while (state.KeepRunning()) {
+    pid_t pid;
+    if (posix_spawnp(&pid, "true", nullptr, nullptr, argv, environ) != 0) {
+      state.SkipWithError("posix_spawnp failed");
+      break;
+    }
+    waitpid(pid, nullptr, 0);
+  }
+  if (p != nullptr) munmap(p, mib << 20);
+}
+BENCHMARK(BM_unistd_posix_spawn_true)->Arg(0)->Arg(256);
+
+// Thread pools often ask this every time they're given work.
+static void BM_unistd_sysconf_nprocessors_onln(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(sysconf(_SC_NPROCESSORS_ONLN));
+  }
+}
+BENCHMARK(BM_unistd_sysconf_nprocessors_onln);
+
+// CPU feature checks and ifunc resolvers ask for AT_HWCAP.
+static void BM_unistd_getauxval(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(getauxval(AT_HWCAP));
+  }
+}
+BENCHMARK(BM_unistd_getauxval);
+
 BENCHMARK_MAIN()
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#undef _FORTIFY_SOURCE
+#include <string.h>
+
+#include "string_neon.h"
+
+void* memrchr(const void* s, int ch, size_t n) {
+  if (n == 0) return nullptr;
+  uintptr_t start = reinterpret_cast<uintptr_t>(s);
+  uintptr_t end = start + n;
+  const uint8_t* p = __neon_block(end - 1);
+  uint8x16_t c = vdupq_n_u8(ch);
+  uint64_t valid = __neon_bytes_below(end - reinterpret_cast<uintptr_t>(p));
+  while (true) {
+    bool first_block = (reinterpret_cast<uintptr_t>(p) <= start);
+    if (first_block) valid &= __neon_bytes_from(start - reinterpret_cast<uintptr_t>(p));
+    uint64_t matches = __neon_byte_mask(vceqq_u8(vld1q_u8(p), c)) & valid;
+    if (matches != 0) return const_cast<uint8_t*>(p + __neon_last_byte(matches));
+    if (first_block) return nullptr;
+    p -= 16;
+    valid = ~0ULL;
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#ifndef _STRING_NEON_H
+#define _STRING_NEON_H
+
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Helpers for the C++ string functions that scan 16 bytes at a time with AdvSIMD.
+//
+// They only ever load aligned 16-byte blocks, which can't cross into a page that the
+// string doesn't reach, and mask off the bytes of the first or last block that aren't
+// part of it.
+//
+// AdvSIMD has no equivalent of SSE's movemask, but narrowing each 16-bit lane of a
+// comparison result by 4 bits gives a 64-bit mask of 4 bits per byte that works as well
+// with ctz and clz.
+
+static inline uint64_t __neon_byte_mask(uint8x16_t v) {
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+
+// The offset of the first or last byte in a non-zero mask.
+static inline size_t __neon_first_byte(uint64_t mask) {
+  return __builtin_ctzll(mask) >> 2;
+}
+
+static inline size_t __neon_last_byte(uint64_t mask) {
+  return 15 - (__builtin_clzll(mask) >> 2);
+}
+
+// Masks selecting the bytes at offsets of at least n (n < 16), or below n (n <= 16).
+static inline uint64_t __neon_bytes_from(size_t n) {
+  return ~0ULL << (4 * n);
+}
+
+static inline uint64_t __neon_bytes_below(size_t n) {
+  return (n >= 16) ? ~0ULL : (1ULL << (4 * n)) - 1;
+}
+
+static inline const uint8_t* __neon_block(uintptr_t p) {
+  return reinterpret_cast<const uint8_t*>(p & ~static_cast<uintptr_t>(15));
+}
+
+#endif
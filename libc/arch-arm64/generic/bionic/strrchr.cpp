@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#undef _FORTIFY_SOURCE
+#include <string.h>
+
+#include "string_neon.h"
+
+char* strrchr(const char* s, int ch) {
+  uintptr_t start = reinterpret_cast<uintptr_t>(s);
+  const uint8_t* p = __neon_block(start);
+  uint8x16_t c = vdupq_n_u8(ch);
+  uint8x16_t zero = vdupq_n_u8(0);
+  uint64_t valid = __neon_bytes_from(start & 15);
+  const uint8_t* last = nullptr;
+  for (;; p += 16, valid = ~0ULL) {
+    uint8x16_t v = vld1q_u8(p);
+    uint64_t matches = __neon_byte_mask(vceqq_u8(v, c)) & valid;
+    uint64_t nuls = __neon_byte_mask(vceqq_u8(v, zero)) & valid;
+    if (nuls != 0) {
+      // Only count matches up to and including the terminator, which matches if ch is 0.
+      matches &= (nuls ^ (nuls - 1));
+      if (matches != 0) last = p + __neon_last_byte(matches);
+      return const_cast<char*>(reinterpret_cast<const char*>(last));
+    }
+    if (matches != 0) last = p + __neon_last_byte(matches);
+  }
+}
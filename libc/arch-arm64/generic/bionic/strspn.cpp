@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#undef _FORTIFY_SOURCE
+#include <string.h>
+
+#include "string_neon.h"
+
+// All three of these look for the first byte that is (or isn't) in a set. The set is
+// tested 16 bytes at a time with two table lookups: each distinct high nibble among the
+// set's bytes gets a bit, hi[h] is the bit for high nibble h, and lo[l] has the bits of
+// every h for which (h << 4 | l) is in the set, so a byte is in the set exactly when
+// lo[its low nibble] & hi[its high nibble] is non-zero. That needs the set's bytes to
+// have no more than 8 distinct high nibbles, which covers every set of ASCII characters;
+// other sets use a bitmap a byte at a time instead.
+
+namespace {
+
+struct ByteSet {
+  bool neon;
+  uint8x16_t lo;
+  uint8x16_t hi;
+  uint64_t bitmap[4];
+
+  explicit ByteSet(const char* set) {
+    uint8_t lo_bits[16] = {};
+    uint8_t hi_bits[16] = {};
+    size_t hi_count = 0;
+    neon = true;
+    for (const uint8_t* p = reinterpret_cast<const uint8_t*>(set); *p != 0; ++p) {
+      uint8_t h = *p >> 4;
+      if (hi_bits[h] == 0) {
+        if (hi_count == 8) {
+          neon = false;
+          break;
+        }
+        hi_bits[h] = 1 << hi_count++;
+      }
+      lo_bits[*p & 0xf] |= hi_bits[h];
+    }
+    if (neon) {
+      lo = vld1q_u8(lo_bits);
+      hi = vld1q_u8(hi_bits);
+    } else {
+      bitmap[0] = bitmap[1] = bitmap[2] = bitmap[3] = 0;
+      for (const uint8_t* p = reinterpret_cast<const uint8_t*>(set); *p != 0; ++p) {
+        bitmap[*p >> 6] |= 1ULL << (*p & 63);
+      }
+    }
+  }
+
+  bool contains(uint8_t c) const {
+    return (bitmap[c >> 6] & (1ULL << (c & 63))) != 0;
+  }
+
+  uint8x16_t contains(uint8x16_t v) const {
+    uint8x16_t l = vqtbl1q_u8(lo, vandq_u8(v, vdupq_n_u8(0xf)));
+    uint8x16_t h = vqtbl1q_u8(hi, vshrq_n_u8(v, 4));
+    return vtstq_u8(l, h);
+  }
+};
+
+}  // namespace
+
+// Returns the length of the prefix of s whose bytes are all in (or, if !in, all not in) set.
+static size_t __span(const char* s, const ByteSet& set, bool in) {
+  if (!set.neon) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+    if (in) {
+      while (*p != 0 && set.contains(*p)) ++p;
+    } else {
+      while (*p != 0 && !set.contains(*p)) ++p;
+    }
+    return p - reinterpret_cast<const uint8_t*>(s);
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(s);
+  const uint8_t* p = __neon_block(start);
+  uint8x16_t zero = vdupq_n_u8(0);
+  uint64_t valid = __neon_bytes_from(start & 15);
+  for (;; p += 16, valid = ~0ULL) {
+    uint8x16_t v = vld1q_u8(p);
+    uint8x16_t member = set.contains(v);
+    // A NUL is never in the set, so it always ends a span of members.
+    uint8x16_t stop = in ? vmvnq_u8(member) : vorrq_u8(member, vceqq_u8(v, zero));
+    uint64_t mask = __neon_byte_mask(stop) & valid;
+    if (mask != 0) return (p + __neon_first_byte(mask)) - reinterpret_cast<const uint8_t*>(s);
+  }
+}
+
+size_t strspn(const char* s, const char* accept) {
+  return __span(s, ByteSet(accept), true);
+}
+
+size_t strcspn(const char* s, const char* reject) {
+  return __span(s, ByteSet(reject), false);
+}
+
+char* strpbrk(const char* s, const char* accept) {
+  s += __span(s, ByteSet(accept), false);
+  return (*s != 0) ? const_cast<char*>(s) : nullptr;
+}
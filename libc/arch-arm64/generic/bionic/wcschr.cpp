@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <wchar.h>
+
+#include "string_neon.h"
+
+wchar_t* wcschr(const wchar_t* s, wchar_t ch) {
+  uintptr_t start = reinterpret_cast<uintptr_t>(s);
+  // A misaligned wchar_t* would split characters across blocks.
+  if ((start & 3) != 0) {
+    for (;; ++s) {
+      if (*s == ch) return const_cast<wchar_t*>(s);
+      if (*s == 0) return nullptr;
+    }
+  }
+
+  const uint8_t* p = __neon_block(start);
+  uint32x4_t c = vdupq_n_u32(ch);
+  uint32x4_t zero = vdupq_n_u32(0);
+  uint64_t valid = __neon_bytes_from(start & 15);
+  for (;; p += 16, valid = ~0ULL) {
+    uint32x4_t v = vld1q_u32(reinterpret_cast<const uint32_t*>(p));
+    uint32x4_t stop = vorrq_u32(vceqq_u32(v, c), vceqq_u32(v, zero));
+    uint64_t mask = __neon_byte_mask(vreinterpretq_u8_u32(stop)) & valid;
+    if (mask != 0) {
+      // This is the terminator unless it's what we're looking for.
+      const wchar_t* found = reinterpret_cast<const wchar_t*>(p + __neon_first_byte(mask));
+      return (*found == ch) ? const_cast<wchar_t*>(found) : nullptr;
+    }
+  }
+}
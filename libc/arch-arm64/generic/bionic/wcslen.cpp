@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <wchar.h>
+
+#include "string_neon.h"
+
+size_t wcslen(const wchar_t* s) {
+  uintptr_t start = reinterpret_cast<uintptr_t>(s);
+  // A misaligned wchar_t* would split characters across blocks.
+  if ((start & 3) != 0) {
+    const wchar_t* p = s;
+    while (*p != 0) ++p;
+    return p - s;
+  }
+
+  const uint8_t* p = __neon_block(start);
+  uint32x4_t zero = vdupq_n_u32(0);
+  uint64_t valid = __neon_bytes_from(start & 15);
+  for (;; p += 16, valid = ~0ULL) {
+    uint32x4_t v = vld1q_u32(reinterpret_cast<const uint32_t*>(p));
+    uint64_t nuls = __neon_byte_mask(vreinterpretq_u8_u32(vceqq_u32(v, zero))) & valid;
+    if (nuls != 0) return ((p + __neon_first_byte(nuls)) - reinterpret_cast<const uint8_t*>(s)) / 4;
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <wchar.h>
+
+#include "string_neon.h"
+
+wchar_t* wmemchr(const wchar_t* s, wchar_t ch, size_t n) {
+  if (n == 0) return nullptr;
+  uintptr_t start = reinterpret_cast<uintptr_t>(s);
+  // A misaligned wchar_t* would split characters across blocks.
+  if ((start & 3) != 0) {
+    for (; n != 0; ++s, --n) {
+      if (*s == ch) return const_cast<wchar_t*>(s);
+    }
+    return nullptr;
+  }
+
+  const uint8_t* p = __neon_block(start);
+  uint32x4_t c = vdupq_n_u32(ch);
+  size_t skipped = (start & 15) / 4;
+  uint64_t valid = __neon_bytes_from(start & 15);
+  // n counts the characters left from the first of the current block that's in the buffer.
+  for (;; p += 16, valid = ~0ULL, skipped = 0) {
+    uint32x4_t v = vld1q_u32(reinterpret_cast<const uint32_t*>(p));
+    uint64_t matches = __neon_byte_mask(vreinterpretq_u8_u32(vceqq_u32(v, c))) & valid;
+    size_t here = 4 - skipped;
+    if (n <= here) {
+      matches &= __neon_bytes_below(4 * (skipped + n));
+      return (matches != 0) ? reinterpret_cast<wchar_t*>(const_cast<uint8_t*>(p + __neon_first_byte(matches))) : nullptr;
+    }
+    if (matches != 0) return reinterpret_cast<wchar_t*>(const_cast<uint8_t*>(p + __neon_first_byte(matches)));
+    n -= here;
+  }
+}
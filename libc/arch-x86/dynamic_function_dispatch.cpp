@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <cpuid.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+// x86 CPUs differ in which SSE extensions they have, so rather than choosing the string
+// functions when libc is built, libc.so and libc.a choose them with IFUNCs when they're
+// relocated. The resolvers run before libc is initialized, so they mustn't use anything
+// but cpuid. The dynamic linker can't call an IFUNC before it has relocated itself, so
+// libc_nomalloc uses the fixed choices in static_function_dispatch.S instead.
+//
+// The variants are hidden so that taking their addresses doesn't need relocating.
+
+static bool __x86_cpu_has(unsigned int ecx_bit) {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  return (ecx & ecx_bit) != 0;
+}
+
+extern "C" {
+
+typedef int memcmp_func(const void*, const void*, size_t);
+__LIBC_HIDDEN__ memcmp_func memcmp_generic, memcmp_atom, memcmp_sse4;
+__LIBC_HIDDEN__ memcmp_func* memcmp_resolver() {
+  if (__x86_cpu_has(bit_SSE4_1)) return memcmp_sse4;
+  if (__x86_cpu_has(bit_SSSE3)) return memcmp_atom;
+  return memcmp_generic;
+}
+int memcmp(const void*, const void*, size_t) __attribute__((ifunc("memcmp_resolver")));
+
+typedef int strcmp_func(const char*, const char*);
+__LIBC_HIDDEN__ strcmp_func strcmp_generic, strcmp_ssse3;
+__LIBC_HIDDEN__ strcmp_func* strcmp_resolver() {
+  return __x86_cpu_has(bit_SSSE3) ? strcmp_ssse3 : strcmp_generic;
+}
+int strcmp(const char*, const char*) __attribute__((ifunc("strcmp_resolver")));
+
+typedef int strncmp_func(const char*, const char*, size_t);
+__LIBC_HIDDEN__ strncmp_func strncmp_generic, strncmp_ssse3;
+__LIBC_HIDDEN__ strncmp_func* strncmp_resolver() {
+  return __x86_cpu_has(bit_SSSE3) ? strncmp_ssse3 : strncmp_generic;
+}
+int strncmp(const char*, const char*, size_t) __attribute__((ifunc("strncmp_resolver")));
+
+typedef char* strcat_func(char*, const char*);
+__LIBC_HIDDEN__ strcat_func strcat_generic, strcat_ssse3;
+__LIBC_HIDDEN__ strcat_func* strcat_resolver() {
+  return __x86_cpu_has(bit_SSSE3) ? strcat_ssse3 : strcat_generic;
+}
+char* strcat(char*, const char*) __attribute__((ifunc("strcat_resolver")));
+
+}  // extern "C"
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <cpuid.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+#include "string/cache.h"
+
+// The x86_64 string functions are chosen with IFUNCs when libc.so or libc.a is relocated,
+// so that CPUs with AVX2 get versions that use it. The resolvers run before libc is
+// initialized, so they mustn't use anything but cpuid and xgetbv. The dynamic linker can't
+// call an IFUNC before it has relocated itself, so libc_nomalloc uses the fixed choices in
+// static_function_dispatch.S instead.
+//
+// The variants are hidden so that taking their addresses doesn't need relocating.
+
+// cpuid.h doesn't have a name for this everywhere: CPUID.(EAX=7,ECX=0):EBX.ERMS[bit 9].
+#define X86_FEATURE_ERMS (1 << 9)
+
+namespace {
+
+struct X86Features {
+  bool avx2;
+  bool erms;
+};
+
+}  // namespace
+
+static X86Features __x86_64_features() {
+  X86Features result = {};
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, nullptr) < 7 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return result;
+  // AVX can only be used if the kernel saves and restores the YMM registers.
+  bool avx = false;
+  if ((ecx & (bit_AVX | bit_OSXSAVE)) == (bit_AVX | bit_OSXSAVE)) {
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    avx = (xcr0_lo & 0x6) == 0x6;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  result.avx2 = avx && (ebx & bit_AVX2) != 0;
+  result.erms = (ebx & X86_FEATURE_ERMS) != 0;
+  return result;
+}
+
+// Sets and copies that are too big for the last-level cache use non-temporal stores, so that
+// they don't evict everything else from it for no gain. The resolvers for the functions that
+// do that measure the cache.
+extern "C" {
+__LIBC_HIDDEN__ size_t __x86_64_shared_cache_size = DEFAULT_SHARED_CACHE_SIZE;
+__LIBC_HIDDEN__ size_t __x86_64_shared_cache_size_half = DEFAULT_SHARED_CACHE_SIZE / 2;
+}
+
+// Returns 0 if the CPU doesn't say.
+static size_t __x86_64_last_level_cache_size() {
+  unsigned int eax, ebx, ecx, edx;
+  size_t result = 0;
+  // Intel describes each cache in a subleaf of leaf 4. The biggest one is the last level.
+  if (__get_cpuid_max(0, nullptr) >= 4) {
+    for (unsigned int i = 0; i < 16; ++i) {
+      __cpuid_count(4, i, eax, ebx, ecx, edx);
+      unsigned int type = eax & 0x1f;
+      if (type == 0) break;
+      if (type == 2) continue;  // Instruction cache.
+      size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+      size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+      size_t line_size = (ebx & 0xfff) + 1;
+      size_t sets = static_cast<size_t>(ecx) + 1;
+      size_t size = ways * partitions * line_size * sets;
+      if (size > result) result = size;
+    }
+  }
+  // AMD gives the L2 size in KiB and the L3 size in 512KiB units instead.
+  if (result == 0 && __get_cpuid_max(0x80000000, nullptr) >= 0x80000006) {
+    __cpuid(0x80000006, eax, ebx, ecx, edx);
+    size_t l2 = static_cast<size_t>(ecx >> 16) * 1024;
+    size_t l3 = static_cast<size_t>(edx >> 18) * 512 * 1024;
+    result = (l3 > l2) ? l3 : l2;
+  }
+  return result;
+}
+
+static void __x86_64_init_cache_size() {
+  size_t size = __x86_64_last_level_cache_size();
+  if (size != 0) {
+    __x86_64_shared_cache_size = size;
+    __x86_64_shared_cache_size_half = size / 2;
+  }
+}
+
+extern "C" {
+
+typedef void* memmove_func(void*, const void*, size_t);
+__LIBC_HIDDEN__ memmove_func memmove_generic, memmove_avx2, memmove_avx2_erms;
+__LIBC_HIDDEN__ memmove_func* memmove_resolver() {
+  __x86_64_init_cache_size();
+  X86Features features = __x86_64_features();
+  if (!features.avx2) return memmove_generic;
+  return features.erms ? memmove_avx2_erms : memmove_avx2;
+}
+void* memmove(void*, const void*, size_t) __attribute__((ifunc("memmove_resolver")));
+
+typedef void* memcpy_func(void*, const void*, size_t);
+__LIBC_HIDDEN__ memcpy_func memcpy_generic, memcpy_avx2, memcpy_avx2_erms;
+__LIBC_HIDDEN__ memcpy_func* memcpy_resolver() {
+  __x86_64_init_cache_size();
+  X86Features features = __x86_64_features();
+  if (!features.avx2) return memcpy_generic;
+  return features.erms ? memcpy_avx2_erms : memcpy_avx2;
+}
+void* memcpy(void*, const void*, size_t) __attribute__((ifunc("memcpy_resolver")));
+
+typedef void* memset_func(void*, int, size_t);
+__LIBC_HIDDEN__ memset_func memset_generic, memset_avx2;
+__LIBC_HIDDEN__ memset_func* memset_resolver() {
+  __x86_64_init_cache_size();
+  return __x86_64_features().avx2 ? memset_avx2 : memset_generic;
+}
+void* memset(void*, int, size_t) __attribute__((ifunc("memset_resolver")));
+
+typedef void* memchr_func(const void*, int, size_t);
+__LIBC_HIDDEN__ memchr_func memchr_generic, memchr_avx2;
+__LIBC_HIDDEN__ memchr_func* memchr_resolver() {
+  return __x86_64_features().avx2 ? memchr_avx2 : memchr_generic;
+}
+void* memchr(const void*, int, size_t) __attribute__((ifunc("memchr_resolver")));
+
+typedef int memcmp_func(const void*, const void*, size_t);
+__LIBC_HIDDEN__ memcmp_func memcmp_generic, memcmp_avx2;
+__LIBC_HIDDEN__ memcmp_func* memcmp_resolver() {
+  return __x86_64_features().avx2 ? memcmp_avx2 : memcmp_generic;
+}
+int memcmp(const void*, const void*, size_t) __attribute__((ifunc("memcmp_resolver")));
+
+typedef size_t strlen_func(const char*);
+__LIBC_HIDDEN__ strlen_func strlen_generic, strlen_avx2;
+__LIBC_HIDDEN__ strlen_func* strlen_resolver() {
+  return __x86_64_features().avx2 ? strlen_avx2 : strlen_generic;
+}
+size_t strlen(const char*) __attribute__((ifunc("strlen_resolver")));
+
+}  // extern "C"
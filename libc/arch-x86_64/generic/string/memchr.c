@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2016 The Android Open Source Project
+ * Copyright (C) 2017 The Android Open Source Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -26,9 +26,7 @@
  * SUCH DAMAGE.
  */
 
-#include "private/icu.h"
 
-// We don't have dlopen/dlsym for static binaries yet.
-void* __find_icu_symbol(const char*) {
-  return nullptr;
-}
+/* The portable memchr, under the name the x86_64 IFUNC resolver uses for it. */
+#define memchr memchr_generic
+#include "../../../upstream-openbsd/lib/libc/string/memchr.c"
@@ -29,8 +29,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 /* Values are optimized for Silvermont */
-#define SHARED_CACHE_SIZE	(1024*1024)			/* Silvermont L2 Cache */
 #define DATA_CACHE_SIZE		(24*1024)			/* Silvermont L1 Data Cache */
 
-#define SHARED_CACHE_SIZE_HALF	(SHARED_CACHE_SIZE / 2)
 #define DATA_CACHE_SIZE_HALF	(DATA_CACHE_SIZE / 2)
+
+/* The size of the last-level cache is measured at startup, and sets above
+   __x86_64_shared_cache_size bytes (and copies above half that) use
+   non-temporal stores. Until then, and in the dynamic linker, this is used. */
+#define DEFAULT_SHARED_CACHE_SIZE	(1024*1024)		/* Silvermont L2 Cache */
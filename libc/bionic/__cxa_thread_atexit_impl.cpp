@@ -13,38 +13,68 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <stdlib.h>
 #include <sys/cdefs.h>
 
 #include "pthread_internal.h"
 
+// Destructors are stored newest first in blocks, each twice the size of the
+// one before (up to a limit), so a thread with many thread_local objects makes
+// a handful of allocations instead of one per object.
 class thread_local_dtor {
  public:
-  void (*func) (void *);
-  void *arg;
-  void *dso_handle; // unused...
+  struct entry {
+    void (*func) (void *);
+    void *arg;
+    void *dso_handle; // unused...
+  };
+
   thread_local_dtor* next;
+  size_t count;
+  size_t capacity;
+  entry entries[];
 };
 
+static constexpr size_t kFirstBlockCapacity = 4;
+static constexpr size_t kMaxBlockCapacity = 256;
+
 extern "C" int __cxa_thread_atexit_impl(void (*func) (void *), void *arg, void *dso_handle) {
-  thread_local_dtor* dtor = new thread_local_dtor();
+  pthread_internal_t* thread = __get_thread();
+  thread_local_dtor* block = thread->thread_local_dtors;
+  if (block == nullptr || block->count == block->capacity) {
+    size_t capacity = kFirstBlockCapacity;
+    if (block != nullptr) {
+      capacity = (block->capacity < kMaxBlockCapacity) ? block->capacity * 2 : kMaxBlockCapacity;
+    }
+    thread_local_dtor* new_block = reinterpret_cast<thread_local_dtor*>(
+        malloc(sizeof(thread_local_dtor) + capacity * sizeof(thread_local_dtor::entry)));
+    if (new_block == nullptr) return -1;
+    new_block->next = block;
+    new_block->count = 0;
+    new_block->capacity = capacity;
+    thread->thread_local_dtors = block = new_block;
+  }
 
+  thread_local_dtor::entry* dtor = &block->entries[block->count++];
   dtor->func = func;
   dtor->arg = arg;
   dtor->dso_handle = dso_handle;
-
-  pthread_internal_t* thread = __get_thread();
-  dtor->next = thread->thread_local_dtors;
-  thread->thread_local_dtors = dtor;
   return 0;
 }
 
 extern "C" __LIBC_HIDDEN__ void __cxa_thread_finalize() {
   pthread_internal_t* thread = __get_thread();
+  // A destructor may register more, which go in the newest block, so look at
+  // the head again after each call.
   while (thread->thread_local_dtors != nullptr) {
-    thread_local_dtor* current = thread->thread_local_dtors;
-    thread->thread_local_dtors = current->next;
+    thread_local_dtor* block = thread->thread_local_dtors;
+    if (block->count == 0) {
+      thread->thread_local_dtors = block->next;
+      free(block);
+      continue;
+    }
 
-    current->func(current->arg);
-    delete current;
+    thread_local_dtor::entry current = block->entries[--block->count];
+    current.func(current.arg);
   }
 }
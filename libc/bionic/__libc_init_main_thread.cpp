@@ -28,13 +28,27 @@
 
 #include "libc_init_common.h"
 
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
 #include "private/KernelArgumentBlock.h"
 #include "private/bionic_arc4random.h"
 #include "private/bionic_auxv.h"
+#include "private/bionic_elf_tls.h"
 #include "private/bionic_globals.h"
+#include "private/bionic_page.h"
+#include "private/bionic_prctl.h"
 #include "private/bionic_ssp.h"
+#include "private/libc_logging.h"
 #include "pthread_internal.h"
 
+#if defined(__i386__)
+#include <asm/ldt.h>
+extern "C" int __set_thread_area(struct user_desc*);
+void __init_user_desc(struct user_desc*, bool, void*);
+#endif
+
 extern "C" int __set_tls(void* ptr);
 extern "C" int __set_tid_address(int* tid_address);
 
@@ -59,13 +73,18 @@ void __libc_init_global_stack_chk_guard(KernelArgumentBlock& args) {
 // thread's TLS (which stack protector relies on).
 
 void __libc_init_main_thread(KernelArgumentBlock& args) {
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
 #if defined(__i386__)
   __libc_init_sysinfo(args);
 #endif
 
   static pthread_internal_t main_thread;
 
+  // The main thread's static TLS block can't be laid out until the linker has loaded
+  // the libraries it needs, so until __libc_init_main_thread_final its TLS slots are here.
+  static void* temp_tcb[BIONIC_TLS_SLOTS - MIN_TLS_SLOT];
+  main_thread.tls = &temp_tcb[-MIN_TLS_SLOT];
+
   // The -fstack-protector implementation uses TLS, so make sure that's
   // set up before we call any function that might get a stack check inserted.
   // TLS also needs to be set up before errno (and therefore syscalls) can be used.
@@ -95,6 +114,7 @@ void __libc_init_main_thread(KernelArgumentBlock& args) {
   __init_thread_stack_guard(&main_thread);
 
   __init_thread(&main_thread);
+  __init_rseq(&main_thread);
 
   // Store a pointer to the kernel argument block in a TLS slot to be
   // picked up by the libc constructor.
@@ -102,3 +122,35 @@ void __libc_init_main_thread(KernelArgumentBlock& args) {
 
   __init_alternate_signal_stack(&main_thread);
 }
+
+// Moves the main thread's TLS slots into a static TLS block, once the executable and
+// the libraries loaded with it have been given their places in the static TLS layout.
+void __libc_init_main_thread_final() {
+  pthread_internal_t* main_thread = __get_thread();
+  const StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+
+  // Segment alignments are at most a page, so a new mapping is aligned enough.
+  size_t map_size = PAGE_END(layout.size());
+  void* map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    __libc_fatal("failed to allocate static TLS: %s", strerror(errno));
+  }
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, map_size, "static TLS");
+
+  void** tls = reinterpret_cast<void**>(static_cast<char*>(map) + layout.tcb_offset());
+  __init_static_tls(tls);
+  memcpy(&tls[MIN_TLS_SLOT], &main_thread->tls[MIN_TLS_SLOT], BIONIC_TCB_SIZE);
+  tls[TLS_SLOT_SELF] = tls;
+  main_thread->tls = tls;
+
+#if defined(__i386__)
+  // Repoint the GDT entry we already have rather than using up another, and reload
+  // %gs so that its cached base is updated.
+  user_desc tls_descriptor;
+  __init_user_desc(&tls_descriptor, false, tls);
+  __set_thread_area(&tls_descriptor);
+  __asm__ __volatile__("movw %%gs, %%ax\n\tmovw %%ax, %%gs" : : : "ax");
+#else
+  __set_tls(tls);
+#endif
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_asymmetric_fence.h"
+
+#include <sys/membarrier.h>
+#include <sys/prctl.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/bionic_membarrier.h"
+
+atomic_int __bionic_membarrier_state = ATOMIC_VAR_INIT(BIONIC_MEMBARRIER_UNKNOWN);
+
+// Readers only skip the real fence once the state says we're registered, and every heavy fence
+// after that uses membarrier, so it doesn't matter that several threads may race to register.
+// Registration survives fork, and exec starts over with a fresh state anyway.
+//
+// Seccomp policies that predate membarrier trap it rather than failing it, so like rseq
+// registration we don't try it at all in a process with a seccomp filter.
+static bool membarrier_registered() {
+  int state = atomic_load_explicit(&__bionic_membarrier_state, memory_order_acquire);
+  if (__predict_false(state == BIONIC_MEMBARRIER_UNKNOWN)) {
+    bool supported = false;
+    if (prctl(PR_GET_SECCOMP) == 0) {
+      int commands = membarrier(MEMBARRIER_CMD_QUERY, 0);
+      supported = (commands != -1) && (commands & BIONIC_MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0 &&
+          membarrier(BIONIC_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    }
+    state = supported ? BIONIC_MEMBARRIER_REGISTERED : BIONIC_MEMBARRIER_UNSUPPORTED;
+    atomic_store_explicit(&__bionic_membarrier_state, state, memory_order_release);
+  }
+  return state == BIONIC_MEMBARRIER_REGISTERED;
+}
+
+void __asymmetric_fence_heavy() {
+  ErrnoRestorer errno_restorer;
+
+  // Order our earlier stores before the barriers the other threads run.
+  atomic_thread_fence(memory_order_seq_cst);
+  if (membarrier_registered() &&
+      membarrier(BIONIC_MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == -1) {
+    // The kernel has no reason to fail this once we're registered. If it ever does, readers go
+    // back to real fences from their next light fence on.
+    atomic_store_explicit(&__bionic_membarrier_state, BIONIC_MEMBARRIER_UNSUPPORTED,
+                          memory_order_relaxed);
+  }
+  atomic_thread_fence(memory_order_seq_cst);
+}
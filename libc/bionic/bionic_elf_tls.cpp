@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_elf_tls.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+#include "private/bionic_globals.h"
+#include "private/bionic_macros.h"
+#include "private/bionic_page.h"
+#include "private/bionic_tls.h"
+#include "private/kernel_sigset_t.h"
+#include "private/libc_logging.h"
+
+extern "C" int __rt_sigprocmask(int, const kernel_sigset_t*, kernel_sigset_t*, size_t);
+
+bool __bionic_get_tls_segment(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                              ElfW(Addr) load_bias, TlsSegment* out) {
+  for (size_t i = 0; i < phdr_count; ++i) {
+    const ElfW(Phdr)& phdr = phdr_table[i];
+    if (phdr.p_type != PT_TLS) continue;
+
+    // Bigger alignments than a page would complicate allocating the blocks for no benefit.
+    size_t alignment = MAX(phdr.p_align, 1);
+    if (!powerof2(alignment) || alignment > PAGE_SIZE || phdr.p_filesz > phdr.p_memsz) {
+      out->alignment = 0;
+      return false;
+    }
+    out->size = phdr.p_memsz;
+    out->alignment = alignment;
+    out->init_ptr = reinterpret_cast<void*>(load_bias + phdr.p_vaddr);
+    out->init_size = phdr.p_filesz;
+    return true;
+  }
+  return false;
+}
+
+static size_t round_up_with_overflow_check(size_t value, size_t alignment) {
+  size_t result;
+  if (__builtin_add_overflow(value, alignment - 1, &result)) {
+    __libc_fatal("static TLS layout overflowed");
+  }
+  return result & ~(alignment - 1);
+}
+
+size_t StaticTlsLayout::reserve(size_t size, size_t alignment) {
+  if (finished_) __libc_fatal("static TLS layout is already finished");
+  size_t offset = round_up_with_overflow_check(offset_, alignment);
+  if (__builtin_add_overflow(offset, size, &offset_)) {
+    __libc_fatal("static TLS layout overflowed");
+  }
+  alignment_ = MAX(alignment_, alignment);
+  return offset;
+}
+
+size_t StaticTlsLayout::reserve_exe_segment_and_tcb(const TlsSegment* exe_segment,
+                                                    const char* progname __unused) {
+  size_t exe_size = 0;
+  size_t exe_alignment = 1;
+  if (exe_segment != nullptr) {
+#if defined(__mips__)
+    __libc_fatal("\"%s\": ELF TLS is not supported on MIPS", progname);
+#endif
+    exe_size = round_up_with_overflow_check(exe_segment->size, exe_segment->alignment);
+    exe_alignment = exe_segment->alignment;
+  }
+  // The thread pointer has to be aligned for the executable's segment to be.
+  size_t tp_alignment = MAX(exe_alignment, sizeof(void*));
+
+#if defined(__arm__) || defined(__aarch64__)
+  // Variant 1: the slots below the thread pointer, then the thread pointer, then the
+  // executable's segment, after the two words the ABI reserves for the TCB rounded up
+  // to the segment's alignment. That has to leave room for the slots above it too.
+  tcb_offset_ = round_up_with_overflow_check(-MIN_TLS_SLOT * sizeof(void*), tp_alignment);
+  offset_ = tcb_offset_;
+  alignment_ = MAX(alignment_, tp_alignment);
+  size_t exe_offset = tcb_offset_ + round_up_with_overflow_check(2 * sizeof(void*), exe_alignment);
+  if (exe_segment != nullptr && exe_offset - tcb_offset_ < BIONIC_TLS_SLOTS * sizeof(void*)) {
+    __libc_fatal("\"%s\": executable's TLS segment is underaligned: alignment is %zu, "
+                 "needs to be at least %zu for ARM Bionic", progname, exe_alignment,
+                 BIONIC_TLS_SLOTS * sizeof(void*));
+  }
+  reserve(BIONIC_TLS_SLOTS * sizeof(void*), 1);
+  if (exe_segment == nullptr) return offset_;
+  offset_ = exe_offset;
+  return reserve(exe_size, 1);
+#else
+  // Variant 2: the executable's segment ends at the thread pointer, where the slots begin.
+  reserve(exe_size, 1);
+  tcb_offset_ = reserve(BIONIC_TCB_SIZE, tp_alignment);
+  return tcb_offset_ - exe_size;
+#endif
+}
+
+size_t StaticTlsLayout::reserve_solib_segment(const TlsSegment& segment) {
+  return reserve(segment.size, segment.alignment);
+}
+
+void StaticTlsLayout::finish_layout() {
+  finished_ = true;
+}
+
+void __init_static_tls(void** tls) {
+  const StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+  TlsModules& modules = __libc_tls_globals.tls_modules;
+  char* block = reinterpret_cast<char*>(tls) - layout.tcb_offset();
+
+  memset(&tls[MIN_TLS_SLOT], 0, BIONIC_TCB_SIZE);
+
+  pthread_rwlock_rdlock(&modules.rwlock);
+  for (size_t i = 0; i < modules.module_count; ++i) {
+    const TlsModule& module = modules.module_table[i];
+    if (module.static_offset == kTlsNoStaticOffset) continue;
+    char* segment = block + module.static_offset;
+    memcpy(segment, module.segment.init_ptr, module.segment.init_size);
+    memset(segment + module.segment.init_size, 0, module.segment.size - module.segment.init_size);
+  }
+  pthread_rwlock_unlock(&modules.rwlock);
+}
+
+// Blocks of modules that aren't in static TLS get a mapping of their own, with this
+// just before the block, because that works the same whether it's the linker or
+// libc.so that allocates or frees it (their mallocs aren't the same).
+struct DynamicTlsBlockHeader {
+  void* map;
+  size_t map_size;
+};
+
+static void* allocate_dynamic_tls_block(const TlsSegment& segment) {
+  size_t map_size = PAGE_END(sizeof(DynamicTlsBlockHeader) + segment.alignment - 1 + segment.size);
+  void* map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    __libc_fatal("failed to allocate %zu bytes of dynamic TLS: %s", segment.size, strerror(errno));
+  }
+  uintptr_t block = BIONIC_ALIGN(reinterpret_cast<uintptr_t>(map) + sizeof(DynamicTlsBlockHeader),
+                                 segment.alignment);
+  DynamicTlsBlockHeader* header = reinterpret_cast<DynamicTlsBlockHeader*>(block) - 1;
+  header->map = map;
+  header->map_size = map_size;
+  // The rest of the block is already zeroed.
+  memcpy(reinterpret_cast<void*>(block), segment.init_ptr, segment.init_size);
+  return reinterpret_cast<void*>(block);
+}
+
+static void free_dynamic_tls_block(void* block) {
+  DynamicTlsBlockHeader* header = static_cast<DynamicTlsBlockHeader*>(block) - 1;
+  munmap(header->map, header->map_size);
+}
+
+static inline TlsDtv* __get_dtv(void** tls) {
+  return static_cast<TlsDtv*>(tls[TLS_SLOT_DTV]);
+}
+
+// Makes sure this thread's DTV has an entry for every module, and frees the blocks of
+// modules that have been unloaded since it was last brought up to date. Called with
+// the modules' lock held and signals blocked.
+static TlsDtv* update_dtv(void** tls, const TlsModules& modules, size_t generation) {
+  TlsDtv* dtv = __get_dtv(tls);
+  if (dtv == nullptr || dtv->count < modules.module_count) {
+    size_t map_size = PAGE_END(sizeof(TlsDtv) + modules.module_count * sizeof(void*));
+    void* map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      __libc_fatal("failed to allocate DTV: %s", strerror(errno));
+    }
+    TlsDtv* new_dtv = static_cast<TlsDtv*>(map);
+    new_dtv->count = (map_size - sizeof(TlsDtv)) / sizeof(void*);
+    if (dtv != nullptr) {
+      new_dtv->generation = dtv->generation;
+      memcpy(new_dtv->modules, dtv->modules, dtv->count * sizeof(void*));
+    }
+    new_dtv->next = dtv;
+    tls[TLS_SLOT_DTV] = new_dtv;
+    dtv = new_dtv;
+  }
+
+  if (dtv->generation != generation) {
+    for (size_t i = 0; i < dtv->count; ++i) {
+      if (dtv->modules[i] == nullptr) continue;
+      // Modules in static TLS are never unloaded, so a stale block is always dynamic.
+      const TlsModule* module = (i < modules.module_count) ? &modules.module_table[i] : nullptr;
+      if (module == nullptr || module->first_generation == 0 ||
+          module->first_generation > dtv->generation) {
+        free_dynamic_tls_block(dtv->modules[i]);
+        dtv->modules[i] = nullptr;
+      }
+    }
+    dtv->generation = generation;
+  }
+  return dtv;
+}
+
+__attribute__((noinline)) static void* tls_get_addr_slow_path(const TlsIndex* ti) {
+  const StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+  TlsModules& modules = __libc_tls_globals.tls_modules;
+  void** tls = __get_tls();
+
+  // A signal handler that uses TLS mustn't find the DTV half updated, or wait for a
+  // lock its thread holds.
+  kernel_sigset_t all;
+  kernel_sigset_t old;
+  memset(static_cast<void*>(&all), 0xff, sizeof(all));
+  __rt_sigprocmask(SIG_SETMASK, &all, &old, sizeof(all));
+  pthread_rwlock_rdlock(&modules.rwlock);
+
+  size_t generation = atomic_load_explicit(&modules.generation, memory_order_relaxed);
+  TlsDtv* dtv = update_dtv(tls, modules, generation);
+
+  size_t index = ti->module_id - 1;
+  if (ti->module_id == kTlsUninitializedModuleId || index >= modules.module_count ||
+      modules.module_table[index].first_generation == 0) {
+    __libc_fatal("invalid TLS module ID %zu", ti->module_id);
+  }
+  void* block = dtv->modules[index];
+  if (block == nullptr) {
+    const TlsModule& module = modules.module_table[index];
+    if (module.static_offset != kTlsNoStaticOffset) {
+      block = reinterpret_cast<char*>(tls) - layout.tcb_offset() + module.static_offset;
+    } else {
+      block = allocate_dynamic_tls_block(module.segment);
+    }
+    dtv->modules[index] = block;
+  }
+
+  pthread_rwlock_unlock(&modules.rwlock);
+  __rt_sigprocmask(SIG_SETMASK, &old, nullptr, sizeof(old));
+  return static_cast<char*>(block) + ti->offset;
+}
+
+void* __tls_get_addr(const TlsIndex* ti) {
+  TlsDtv* dtv = __get_dtv(__get_tls());
+  size_t generation = atomic_load_explicit(&__libc_tls_globals.tls_modules.generation,
+                                           memory_order_relaxed);
+  if (__predict_true(dtv != nullptr && dtv->generation == generation)) {
+    size_t index = ti->module_id - 1;
+    if (__predict_true(index < dtv->count && dtv->modules[index] != nullptr)) {
+      return static_cast<char*>(dtv->modules[index]) + ti->offset;
+    }
+  }
+  return tls_get_addr_slow_path(ti);
+}
+
+#if defined(__i386__)
+void* ___tls_get_addr(const TlsIndex* ti) {
+  return __tls_get_addr(ti);
+}
+#endif
+
+void __free_dynamic_tls(void** tls) {
+  TlsDtv* dtv = __get_dtv(tls);
+  if (dtv == nullptr) return;
+
+  // Only the newest DTV has every block, and blocks in the static TLS block aren't ours to free.
+  const StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+  char* static_tls = reinterpret_cast<char*>(tls) - layout.tcb_offset();
+  for (size_t i = 0; i < dtv->count; ++i) {
+    char* block = static_cast<char*>(dtv->modules[i]);
+    if (block != nullptr && (block < static_tls || block >= static_tls + layout.size())) {
+      free_dynamic_tls_block(block);
+    }
+  }
+  while (dtv != nullptr) {
+    TlsDtv* next = dtv->next;
+    munmap(dtv, PAGE_END(sizeof(TlsDtv) + dtv->count * sizeof(void*)));
+    dtv = next;
+  }
+  tls[TLS_SLOT_DTV] = nullptr;
+}
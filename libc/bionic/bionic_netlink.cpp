@@ -96,3 +96,36 @@ bool NetlinkConnection::ReadResponses(void callback(void*, nlmsghdr*), void* con
   // We only get here if recv fails before we see a NLMSG_DONE.
   return false;
 }
+
+int NetlinkSubscribe(uint32_t groups) {
+  int fd = socket(PF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+  if (fd == -1) return -1;
+
+  sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = groups;
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+    ErrnoRestorer errno_restorer;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool NetlinkChanged(int fd) {
+  ErrnoRestorer errno_restorer;
+
+  // We only care whether anything arrived, so let recv truncate the messages.
+  bool changed = false;
+  char buf[64];
+  while (true) {
+    ssize_t bytes_read = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (bytes_read == -1 && errno == EAGAIN) return changed;
+    if (bytes_read == -1 && errno == EINTR) continue;
+    // ENOBUFS means the kernel dropped some notifications. Anything else is
+    // unexpected, so assume the worst rather than trust what we've got.
+    if (bytes_read == -1 && errno != ENOBUFS) return true;
+    changed = true;
+  }
+}
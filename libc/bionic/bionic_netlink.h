@@ -29,6 +29,7 @@
 #ifndef BIONIC_NETLINK_H
 #define BIONIC_NETLINK_H
 
+#include <stdint.h>
 #include <sys/types.h>
 
 #include <linux/netlink.h>
@@ -50,4 +51,17 @@ class NetlinkConnection {
   size_t size_;
 };
 
+// Opens a non-blocking NETLINK_ROUTE socket subscribed to the RTMGRP_* `groups`,
+// for noticing when something previously dumped has changed. Returns -1 on failure.
+int NetlinkSubscribe(uint32_t groups);
+
+// Discards any notifications waiting on a socket from NetlinkSubscribe, and returns
+// true if there were any (or if some were lost).
+bool NetlinkChanged(int fd);
+
+// For if_nameindex: calls `callback` with the index and name (which may be null)
+// of each interface from the same cached dump as getifaddrs. Returns false with
+// errno set if the interfaces couldn't be dumped.
+bool __getifaddrs_links(void callback(void*, unsigned, const char*), void* context);
+
 #endif
@@ -17,6 +17,8 @@
 #include <cutils/trace.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -33,54 +35,85 @@
 constexpr char SYSTRACE_PROPERTY_NAME[] = "debug.atrace.tags.enableflags";
 
 static Lock g_lock;
-static const prop_info* g_pinfo;
-static uint32_t g_property_serial = -1;
-static uint32_t g_property_area_serial = -1;
-static uint64_t g_tags;
-static int g_trace_marker_fd = -1;
-
-static bool should_trace() {
-  bool result = false;
-  g_lock.lock();
+static _Atomic(const prop_info*) g_pinfo;
+static atomic_uint_least32_t g_property_area_serial = -1;
+// The serial of the last value of the property we parsed in the top 32 bits,
+// and whether that value enabled ATRACE_TAG_BIONIC in the bottom bit. Keeping
+// both in one word lets the fast path check them with a single load. The
+// initial serial can't match a real one, because it implies a value length of 255.
+static atomic_uint_fast64_t g_tags_word = UINT64_C(0xffffffff) << 32;
+static atomic_int g_trace_marker_fd = -1;
+
+static const prop_info* find_systrace_property() {
   // debug.atrace.tags.enableflags is set to a safe non-tracing value during property
   // space initialization, so it should only be null in two cases, if there are
   // insufficient permissions for this process to access the property, in which
   // case an audit will be logged, and during boot before the property server has
   // been started, in which case we store the global property_area serial to prevent
   // the costly find operation until we see a changed property_area.
-  if (g_pinfo == nullptr && g_property_area_serial != __system_property_area_serial()) {
-    g_property_area_serial = __system_property_area_serial();
-    g_pinfo = __system_property_find(SYSTRACE_PROPERTY_NAME);
+  uint32_t area_serial = __system_property_area_serial();
+  if (area_serial == atomic_load_explicit(&g_property_area_serial, memory_order_relaxed)) {
+    return nullptr;
   }
 
-  if (g_pinfo) {
-    // Find out which tags have been enabled on the command line and set
-    // the value of tags accordingly.  If the value of the property changes,
-    // the serial will also change, so the costly system_property_read function
-    // can be avoided by calling the much cheaper system_property_serial
-    // first.  The values within pinfo may change, but its location is guaranteed
-    // not to move.
-    uint32_t cur_serial = __system_property_serial(g_pinfo);
-    if (cur_serial != g_property_serial) {
-      __system_property_read_callback(g_pinfo,
-              [] (void*, const char*, const char* value, uint32_t serial) {
-                g_property_serial = serial;
-                g_tags = strtoull(value, nullptr, 0);
-              }, nullptr);
+  g_lock.lock();
+  const prop_info* pinfo = atomic_load_explicit(&g_pinfo, memory_order_relaxed);
+  if (pinfo == nullptr) {
+    pinfo = __system_property_find(SYSTRACE_PROPERTY_NAME);
+    if (pinfo != nullptr) {
+      atomic_store_explicit(&g_pinfo, pinfo, memory_order_release);
+    } else {
+      atomic_store_explicit(&g_property_area_serial, area_serial, memory_order_relaxed);
     }
-    result = ((g_tags & ATRACE_TAG_BIONIC) != 0);
   }
   g_lock.unlock();
-  return result;
+  return pinfo;
+}
+
+static bool should_trace() {
+  const prop_info* pinfo = atomic_load_explicit(&g_pinfo, memory_order_acquire);
+  if (pinfo == nullptr) {
+    pinfo = find_systrace_property();
+    if (pinfo == nullptr) {
+      return false;
+    }
+  }
+
+  // Find out which tags have been enabled on the command line and set
+  // the value of tags accordingly.  If the value of the property changes,
+  // the serial will also change, so the costly system_property_read function
+  // can be avoided by calling the much cheaper system_property_serial
+  // first.  The values within pinfo may change, but its location is guaranteed
+  // not to move.
+  uint32_t cur_serial = __system_property_serial(pinfo);
+  uint_fast64_t tags_word = atomic_load_explicit(&g_tags_word, memory_order_relaxed);
+  if ((tags_word >> 32) != cur_serial) {
+    // Threads that race here all store a consistent word, and any of them
+    // being stale just means the next call parses the property again.
+    __system_property_read_callback(pinfo,
+            [] (void* cookie, const char*, const char* value, uint32_t serial) {
+              bool enabled = (strtoull(value, nullptr, 0) & ATRACE_TAG_BIONIC) != 0;
+              *reinterpret_cast<uint_fast64_t*>(cookie) = (uint_fast64_t(serial) << 32) | enabled;
+            }, &tags_word);
+    atomic_store_explicit(&g_tags_word, tags_word, memory_order_relaxed);
+  }
+  return (tags_word & 1) != 0;
 }
 
 static int get_trace_marker_fd() {
+  int fd = atomic_load_explicit(&g_trace_marker_fd, memory_order_relaxed);
+  if (fd != -1) {
+    return fd;
+  }
+
   g_lock.lock();
-  if (g_trace_marker_fd == -1) {
-    g_trace_marker_fd = open("/sys/kernel/debug/tracing/trace_marker", O_CLOEXEC | O_WRONLY);
+  fd = atomic_load_explicit(&g_trace_marker_fd, memory_order_relaxed);
+  if (fd == -1) {
+    fd = open("/sys/kernel/debug/tracing/trace_marker", O_CLOEXEC | O_WRONLY);
+    atomic_store_explicit(&g_trace_marker_fd, fd, memory_order_relaxed);
   }
   g_lock.unlock();
-  return g_trace_marker_fd;
+  return fd;
 }
 
 void bionic_trace_begin(const char* message) {
@@ -117,6 +150,24 @@ void bionic_trace_end() {
   TEMP_FAILURE_RETRY(write(trace_marker_fd, "E", 1));
 }
 
+void bionic_trace_counter(const char* name, int64_t value) {
+  if (!should_trace()) {
+    return;
+  }
+
+  int trace_marker_fd = get_trace_marker_fd();
+  if (trace_marker_fd == -1) {
+    return;
+  }
+
+  // Room for the "C|pid|" prefix, the separator and the widest int64_t.
+  int length = strlen(name);
+  char buf[length + WRITE_OFFSET + 21];
+  size_t len = snprintf(buf, sizeof(buf), "C|%d|%s|%" PRId64, getpid(), name, value);
+
+  TEMP_FAILURE_RETRY(write(trace_marker_fd, buf, len));
+}
+
 ScopedTrace::ScopedTrace(const char* message) : called_end_(false) {
   bionic_trace_begin(message);
 }
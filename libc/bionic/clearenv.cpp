@@ -29,7 +29,10 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "private/bionic_env_index.h"
+
 int clearenv() {
+  __bionic_env_index_invalidate();
   char** e = environ;
   if (e != NULL) {
     for (; *e; ++e) {
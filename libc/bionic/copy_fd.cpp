@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/copy_fd.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+// The most that the kernel moves in one read, write, sendfile or splice.
+#define MAX_RW_COUNT 0x7ffff000
+
+// Big enough that the read/write fallback makes few calls, small enough not to matter.
+#define COPY_BUFFER_SIZE (128 * 1024)
+
+enum CopyMethod {
+  kCopyFileRange,
+  kSendfile,
+  kSplice,
+  kReadWrite,
+};
+
+static ssize_t read_write(int out_fd, int in_fd, size_t count, char* buffer) {
+  if (count > COPY_BUFFER_SIZE) count = COPY_BUFFER_SIZE;
+  ssize_t bytes = TEMP_FAILURE_RETRY(read(in_fd, buffer, count));
+  for (ssize_t written = 0; written < bytes;) {
+    ssize_t n = TEMP_FAILURE_RETRY(write(out_fd, buffer + written, bytes - written));
+    if (n == -1) return -1;
+    written += n;
+  }
+  return bytes;
+}
+
+static ssize_t copy_some(CopyMethod method, int out_fd, int in_fd, size_t count, char* buffer) {
+  if (count > MAX_RW_COUNT) count = MAX_RW_COUNT;
+  switch (method) {
+    case kCopyFileRange:
+      return TEMP_FAILURE_RETRY(copy_file_range(in_fd, nullptr, out_fd, nullptr, count, 0));
+    case kSendfile:
+      return TEMP_FAILURE_RETRY(sendfile(out_fd, in_fd, nullptr, count));
+    case kSplice:
+      return TEMP_FAILURE_RETRY(splice(in_fd, nullptr, out_fd, nullptr, count, SPLICE_F_MOVE));
+    default:
+      return read_write(out_fd, in_fd, count, buffer);
+  }
+}
+
+// Whether a failure of a method's first call means that the method doesn't work
+// for this kind of file (or this kernel), rather than that the copy failed. A
+// genuinely bad fd gets the same error again from read or write.
+static bool is_unsupported(int error) {
+  return error == ENOSYS || error == EINVAL || error == EXDEV || error == EOPNOTSUPP ||
+         error == EBADF;
+}
+
+ssize_t android_copy_fd(int out_fd, int in_fd, size_t count) {
+  size_t copied = 0;
+  char* buffer = nullptr;
+  ssize_t result = 0;
+
+  for (int method = kCopyFileRange; method <= kReadWrite && copied < count; ++method) {
+    if (method == kReadWrite && (buffer = static_cast<char*>(malloc(COPY_BUFFER_SIZE))) == nullptr) {
+      result = -1;
+      break;
+    }
+
+    bool used = false;
+    while (copied < count) {
+      result = copy_some(static_cast<CopyMethod>(method), out_fd, in_fd, count - copied, buffer);
+      if (result > 0) {
+        used = true;
+        copied += result;
+        continue;
+      }
+      if (!used && method != kReadWrite) {
+        // Some kernels' copy_file_range returns 0 straight away for files like those in
+        // /proc, whose size isn't known up front, so an immediate 0 isn't trusted either.
+        if ((result == -1 && is_unsupported(errno)) || (result == 0 && method == kCopyFileRange)) {
+          break;
+        }
+      }
+      // The end of in_fd, or an error.
+      used = true;
+      break;
+    }
+    if (used) break;
+  }
+
+  free(buffer);
+  if (result == -1 && copied == 0) return -1;
+  return copied;
+}
@@ -27,6 +27,7 @@
  */
 
 #include <dirent.h>
+#include <android/dirent.h>
 
 #include <errno.h>
 #include <fcntl.h>
@@ -54,8 +55,14 @@ struct DIR {
   pthread_mutex_t mutex_;
   dirent buff_[15];
   long current_pos_;
+  // Directories that don't fit in buff_ are read through this larger buffer.
+  dirent* large_buff_;
 };
 
+// buff_ holds about 4KiB of entries, which is plenty for most directories.
+// Once a directory needs more than one buffer's worth, we switch to this much.
+static constexpr size_t kLargeBufferSize = 32 * 1024;
+
 static DIR* __allocate_DIR(int fd) {
   DIR* d = reinterpret_cast<DIR*>(malloc(sizeof(DIR)));
   if (d == NULL) {
@@ -65,6 +72,7 @@ static DIR* __allocate_DIR(int fd) {
   d->available_bytes_ = 0;
   d->next_ = NULL;
   d->current_pos_ = 0L;
+  d->large_buff_ = NULL;
   pthread_mutex_init(&d->mutex_, NULL);
   return d;
 }
@@ -93,12 +101,22 @@ DIR* opendir(const char* path) {
 }
 
 static bool __fill_DIR(DIR* d) {
-  int rc = TEMP_FAILURE_RETRY(__getdents64(d->fd_, d->buff_, sizeof(d->buff_)));
+  // If the last getdents64 (nearly) filled buff_, this is a big directory.
+  // (Failing to allocate just means carrying on with buff_.)
+  if (d->large_buff_ == NULL && d->next_ != NULL &&
+      reinterpret_cast<char*>(d->next_) - reinterpret_cast<char*>(d->buff_) >
+          static_cast<ptrdiff_t>(sizeof(d->buff_) / 2)) {
+    d->large_buff_ = reinterpret_cast<dirent*>(malloc(kLargeBufferSize));
+  }
+
+  dirent* buff = (d->large_buff_ != NULL) ? d->large_buff_ : d->buff_;
+  size_t size = (d->large_buff_ != NULL) ? kLargeBufferSize : sizeof(d->buff_);
+  int rc = TEMP_FAILURE_RETRY(__getdents64(d->fd_, buff, size));
   if (rc <= 0) {
     return false;
   }
   d->available_bytes_ = rc;
-  d->next_ = d->buff_;
+  d->next_ = buff;
   return true;
 }
 
@@ -143,6 +161,32 @@ int readdir_r(DIR* d, dirent* entry, dirent** result) {
 }
 __strong_alias(readdir64_r, readdir_r);
 
+ssize_t android_readdir_batch(DIR* d, android_dirent_record* records, size_t count) {
+  ScopedPthreadMutexLocker locker(&d->mutex_);
+
+  // Only hand out entries from the current buffer, so that all the names
+  // stay valid until the next call.
+  ErrnoRestorer errno_restorer;
+  errno = 0;
+  if (d->available_bytes_ == 0 && !__fill_DIR(d)) {
+    if (errno != 0) {
+      errno_restorer.override(errno);
+      return -1;
+    }
+    return 0;
+  }
+
+  size_t n = 0;
+  while (n < count && d->available_bytes_ != 0) {
+    dirent* entry = __readdir_locked(d);
+    records[n].d_ino = entry->d_ino;
+    records[n].d_type = entry->d_type;
+    records[n].d_name = entry->d_name;
+    ++n;
+  }
+  return n;
+}
+
 int closedir(DIR* d) {
   if (d == NULL) {
     errno = EINVAL;
@@ -151,6 +195,7 @@ int closedir(DIR* d) {
 
   int fd = d->fd_;
   pthread_mutex_destroy(&d->mutex_);
+  free(d->large_buff_);
   free(d);
   return close(fd);
 }
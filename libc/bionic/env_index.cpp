@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_env_index.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "private/bionic_page.h"
+
+// getenv is called on hot paths (tzset wants "TZ" for every localtime), and
+// environments with hundreds of entries aren't unusual, so rather than
+// scanning environ every time we keep an open-addressed hash of the first
+// entry for each name.
+//
+// The index is allocated with mmap rather than malloc because malloc
+// implementations call getenv while they initialize. It's published with
+// a compare-and-swap so concurrent getenv callers don't need a lock; one
+// replaced by a getenv caller may still be in use by another thread, so it
+// isn't unmapped until the next setenv/putenv/unsetenv/clearenv, which
+// mustn't race with getenv anyway. A program that keeps assigning environ
+// without ever calling those would pile up retired indexes, so once there
+// are kMaxRetiredIndexes of them lookups just scan environ until the next
+// change through setenv and friends frees them.
+//
+// Building an index costs a scan and a couple of system calls, so after
+// each change through setenv and friends the first few lookups just scan
+// environ: that keeps programs that alternate setenv and getenv no slower.
+//
+// Programs may also assign environ directly (POSIX allows that, but not
+// changing the array environ points to). Every lookup checks that environ,
+// its length, and its first, middle and last entries are what the index was
+// built from, so a new array is noticed even if it's at the old address, as
+// well as that each entry it examines is still the pointer it indexed; if
+// not, the index is rebuilt. Entries are compared by content, so changing
+// the value in a string passed to putenv is seen as it should be.
+
+struct env_slot {
+  const char* entry;  // NULL if the slot is empty.
+  uint32_t hash;
+  uint32_t index;     // In environ.
+};
+
+struct env_index {
+  env_index* retired_next;
+  size_t map_size;
+  char** environ;
+  size_t count;       // Of entries in environ.
+  char* first;        // environ[0], environ[count / 2] and environ[count - 1].
+  char* middle;
+  char* last;
+  size_t mask;        // Slots - 1.
+  env_slot slots[0];
+};
+
+static constexpr unsigned kUnindexedLookups = 8;
+static constexpr unsigned kMaxRetiredIndexes = 8;
+
+static _Atomic(env_index*) g_env_index;
+static _Atomic(env_index*) g_env_retired;
+static atomic_uint g_env_retired_count;
+static atomic_uint g_env_unindexed_lookups;
+
+static uint32_t env_hash(const char* name, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    h = (h ^ static_cast<unsigned char>(name[i])) * 16777619u;
+  }
+  return h;
+}
+
+static bool env_entry_is(const char* entry, const char* name, size_t len) {
+  return strncmp(entry, name, len) == 0 && entry[len] == '=';
+}
+
+static env_index* env_index_build(char** env) {
+  size_t count = 0;
+  while (env[count] != nullptr) ++count;
+  if (count > UINT32_MAX) return nullptr;
+
+  size_t slots = 16;
+  while (slots < 2 * count) slots *= 2;
+  size_t size = PAGE_END(sizeof(env_index) + slots * sizeof(env_slot));
+  void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) return nullptr;
+
+  env_index* index = reinterpret_cast<env_index*>(map);
+  index->map_size = size;
+  index->environ = env;
+  index->count = count;
+  if (count > 0) {
+    index->first = env[0];
+    index->middle = env[count / 2];
+    index->last = env[count - 1];
+  }
+  index->mask = slots - 1;
+  for (size_t i = 0; i < count; ++i) {
+    const char* entry = env[i];
+    const char* eq = strchr(entry, '=');
+    if (eq == nullptr) continue;  // getenv never finds these.
+    size_t len = eq - entry;
+    uint32_t hash = env_hash(entry, len);
+    size_t j = hash & index->mask;
+    while (index->slots[j].entry != nullptr &&
+           !(index->slots[j].hash == hash && env_entry_is(index->slots[j].entry, entry, len))) {
+      j = (j + 1) & index->mask;
+    }
+    // Later duplicates are hidden by the first, as they are from getenv.
+    if (index->slots[j].entry == nullptr) {
+      index->slots[j].entry = entry;
+      index->slots[j].hash = hash;
+      index->slots[j].index = i;
+    }
+  }
+  return index;
+}
+
+static void env_index_retire(env_index* index) {
+  atomic_fetch_add_explicit(&g_env_retired_count, 1, memory_order_relaxed);
+  index->retired_next = atomic_load_explicit(&g_env_retired, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&g_env_retired, &index->retired_next, index,
+                                                memory_order_release, memory_order_relaxed)) {
+  }
+}
+
+// Whether 'index' was built from environ as it is now, as far as can be
+// seen without looking at every entry.
+static bool env_index_current(const env_index* index, char** env) {
+  if (index == nullptr || index->environ != env || env[index->count] != nullptr) return false;
+  size_t count = index->count;
+  return count == 0 || (env[0] == index->first && env[count / 2] == index->middle &&
+                        env[count - 1] == index->last);
+}
+
+// Returns 1 if found, 0 if not, and -1 if an entry has been changed under us.
+static int env_index_lookup(const env_index* index, const char* name, size_t len, char** value) {
+  uint32_t hash = env_hash(name, len);
+  for (size_t j = hash & index->mask; index->slots[j].entry != nullptr; j = (j + 1) & index->mask) {
+    const env_slot& slot = index->slots[j];
+    if (slot.hash != hash) continue;
+    char* entry = index->environ[slot.index];
+    if (entry != slot.entry) return -1;
+    if (env_entry_is(entry, name, len)) {
+      *value = entry + len + 1;
+      return 1;
+    }
+  }
+  *value = nullptr;
+  return 0;
+}
+
+bool __bionic_env_index_find(const char* name, size_t len, char** value) {
+  char** env = environ;
+  if (env == nullptr) {
+    *value = nullptr;
+    return true;
+  }
+
+  env_index* index = atomic_load_explicit(&g_env_index, memory_order_acquire);
+  if (index == nullptr &&
+      atomic_fetch_add_explicit(&g_env_unindexed_lookups, 1, memory_order_relaxed) < kUnindexedLookups) {
+    return false;
+  }
+  for (int attempt = 0; ; ++attempt) {
+    if (env_index_current(index, env) && env_index_lookup(index, name, len, value) != -1) {
+      return true;
+    }
+    // Give up if environ is changing faster than we can index it, or has
+    // changed so often behind our back that the old indexes need freeing.
+    if (attempt == 2 ||
+        atomic_load_explicit(&g_env_retired_count, memory_order_relaxed) >= kMaxRetiredIndexes) {
+      return false;
+    }
+
+    env_index* fresh = env_index_build(env);
+    if (fresh == nullptr) return false;
+    if (atomic_compare_exchange_strong_explicit(&g_env_index, &index, fresh,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+      if (index != nullptr) env_index_retire(index);
+      index = fresh;
+    } else {
+      // Another thread got there first; 'index' is now theirs.
+      munmap(fresh, fresh->map_size);
+    }
+  }
+}
+
+void __bionic_env_index_invalidate() {
+  atomic_store_explicit(&g_env_unindexed_lookups, 0, memory_order_relaxed);
+  env_index* index = atomic_exchange_explicit(&g_env_index, nullptr, memory_order_acq_rel);
+  if (index != nullptr) munmap(index, index->map_size);
+  index = atomic_exchange_explicit(&g_env_retired, nullptr, memory_order_acq_rel);
+  atomic_store_explicit(&g_env_retired_count, 0, memory_order_relaxed);
+  while (index != nullptr) {
+    env_index* next = index->retired_next;
+    munmap(index, index->map_size);
+    index = next;
+  }
+}
@@ -47,6 +47,7 @@ int fork() {
     // Update the cached pid, since clone() will not set it directly (as
     // self->tid is updated by the kernel).
     self->set_cached_pid(gettid());
+    __thread_mapping_caches_reset_after_fork();
     __bionic_atfork_run_child();
   } else {
     __bionic_atfork_run_parent();
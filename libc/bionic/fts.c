@@ -163,7 +163,8 @@ fts_open(char * const *argv, int options,
 	 * and ".." are all fairly nasty problems.  Note, if we can't get the
 	 * descriptor we run anyway, just more slowly.
 	 */
-	if (!ISSET(FTS_NOCHDIR) && (sp->fts_rfd = open(".", O_RDONLY, 0)) < 0)
+	if (!ISSET(FTS_NOCHDIR) &&
+	    (sp->fts_rfd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0)) < 0)
 		SET(FTS_NOCHDIR);
 
 	if (nitems == 0)
@@ -552,6 +553,7 @@ fts_build(FTS *sp, int type)
 	void *oldaddr;
 	size_t len, maxlen;
 	int nitems, cderrno, descend, level, nlinks, nostat = 0, doadjust;
+	int dfd;
 	int saved_errno;
 	char *cp = NULL;
 
@@ -562,11 +564,15 @@ fts_build(FTS *sp, int type)
 	 * Open the directory for reading.  If this fails, we're done.
 	 * If being called from fts_read, set the fts_info field.
 	 */
-	if ((dirp = opendir(cur->fts_accpath)) == NULL) {
+	if ((dfd = open(cur->fts_accpath,
+	    O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0)) < 0 ||
+	    (dirp = fdopendir(dfd)) == NULL) {
 		if (type == BREAD) {
 			cur->fts_info = FTS_DNR;
 			cur->fts_errno = errno;
 		}
+		if (dfd >= 0)
+			(void)close(dfd);
 		return (NULL);
 	}
 
@@ -574,6 +580,8 @@ fts_build(FTS *sp, int type)
 	 * Nlinks is the number of possible entries of type directory in the
 	 * directory if we're cheating on stat calls, 0 if we're not doing
 	 * any stat calls at all, -1 if we're doing stats on everything.
+	 * Nostat is set if we can also skip the stat calls for entries whose
+	 * type the directory entry itself tells us.
 	 */
 	if (type == BNAMES)
 		nlinks = 0;
@@ -582,7 +590,7 @@ fts_build(FTS *sp, int type)
 		nostat = 1;
 	} else {
 		nlinks = -1;
-		nostat = 0;
+		nostat = ISSET(FTS_NOSTAT);
 	}
 
 #ifdef notdef
@@ -607,7 +615,7 @@ fts_build(FTS *sp, int type)
 	 */
 	cderrno = 0;
 	if (nlinks || type == BREAD) {
-		if (fts_safe_changedir(sp, cur, dirfd(dirp), NULL)) {
+		if (fts_safe_changedir(sp, cur, dfd, NULL)) {
 			if (nlinks && type == BREAD)
 				cur->fts_errno = errno;
 			cur->fts_flags |= FTS_DONTCHDIR;
@@ -709,7 +717,8 @@ mem1:				saved_errno = errno;
 		} else if (nlinks == 0
 #ifdef DT_DIR
 		    || (nostat &&
-		    dp->d_type != DT_DIR && dp->d_type != DT_UNKNOWN)
+		    dp->d_type != DT_DIR && dp->d_type != DT_UNKNOWN &&
+		    (ISSET(FTS_PHYSICAL) || dp->d_type != DT_LNK))
 #endif
 		    ) {
 			p->fts_accpath =
@@ -720,10 +729,10 @@ mem1:				saved_errno = errno;
 			if (ISSET(FTS_NOCHDIR)) {
 				p->fts_accpath = p->fts_path;
 				memmove(cp, p->fts_name, p->fts_namelen + 1);
-				p->fts_info = fts_stat(sp, p, 0, dirfd(dirp));
+				p->fts_info = fts_stat(sp, p, 0, dfd);
 			} else {
 				p->fts_accpath = p->fts_name;
-				p->fts_info = fts_stat(sp, p, 0, -1);
+				p->fts_info = fts_stat(sp, p, 0, dfd);
 			}
 
 			/* Decrement link count if applicable. */
@@ -1030,7 +1039,8 @@ fts_safe_changedir(FTS *sp, FTSENT *p, int fd, char *path)
 	newfd = fd;
 	if (ISSET(FTS_NOCHDIR))
 		return (0);
-	if (fd < 0 && (newfd = open(path, O_RDONLY, 0)) < 0)
+	if (fd < 0 &&
+	    (newfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0)) < 0)
 		return (-1);
 	if (fstat(newfd, &sb)) {
 		ret = -1;
@@ -18,13 +18,22 @@
  * Materiel Command, USAF, under agreement number F39502-99-1-0512.
  */
 
+#include <android/ftw.h>
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <fts.h>
 #include <ftw.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "private/bionic_work_queue.h"
+
 static int do_nftw(const char *path,
                    int (*ftw_fn)(const char*, const struct stat*, int),
                    int (*nftw_fn)(const char*, const struct stat*, int, FTW*),
@@ -122,3 +131,208 @@ int nftw(const char* path, int (*nftw_fn)(const char*, const struct stat*, int,
          int nfds, int nftw_flags) {
   return do_nftw(path, nullptr, nftw_fn, nfds, nftw_flags);
 }
+
+// android_nftw_parallel reads each directory in a work item on libc's worker pool,
+// and queues another work item for each subdirectory it finds. Each directory is
+// reported by the work item that reads it, so that FTW_DNR comes from the open
+// itself rather than an extra access(2).
+struct ParallelWalk {
+  WorkGroup group;
+  int (*fn)(const char*, const struct stat*, int, FTW*);
+  int flags;
+  dev_t root_dev;
+  // The first non-zero result, and errno to go with it if it's our own error.
+  _Atomic(int) result;
+  int result_errno;
+};
+
+struct ParallelDir {
+  ParallelWalk* walk;
+  // Kept alive by its children, for cycle detection in logical walks.
+  ParallelDir* parent;
+  atomic_int refs;
+  struct stat st;
+  int level;
+  int base;
+  bool descend;
+  char path[0];
+};
+
+// The DT_ constants are the S_IF ones shifted down, as on every Linux architecture.
+static mode_t dtype_to_mode(unsigned char d_type) {
+  return static_cast<mode_t>(d_type) << 12;
+}
+
+static void parallel_stop(ParallelWalk* walk, int result, int error) {
+  int expected = 0;
+  if (atomic_compare_exchange_strong(&walk->result, &expected, result)) {
+    walk->result_errno = error;
+  }
+}
+
+static bool parallel_stopped(ParallelWalk* walk) {
+  return atomic_load_explicit(&walk->result, memory_order_relaxed) != 0;
+}
+
+static void parallel_report(ParallelWalk* walk, const char* path, const struct stat* st,
+                            int fn_flag, int base, int level) {
+  FTW ftw;
+  ftw.base = base;
+  ftw.level = level;
+  int result = walk->fn(path, st, fn_flag, &ftw);
+  if (result != 0) parallel_stop(walk, result, errno);
+}
+
+static void parallel_release(ParallelDir* dir) {
+  while (dir != nullptr && atomic_fetch_sub(&dir->refs, 1) == 1) {
+    ParallelDir* parent = dir->parent;
+    free(dir);
+    dir = parent;
+  }
+}
+
+static void parallel_walk_dir(void* arg);
+
+static bool parallel_queue_dir(ParallelWalk* walk, ParallelDir* parent, const char* path,
+                               size_t path_len, const struct stat& st, int base, int level) {
+  ParallelDir* dir = reinterpret_cast<ParallelDir*>(malloc(sizeof(ParallelDir) + path_len + 1));
+  if (dir == nullptr) {
+    parallel_stop(walk, -1, ENOMEM);
+    return false;
+  }
+  dir->walk = walk;
+  dir->parent = parent;
+  atomic_init(&dir->refs, 1);
+  dir->st = st;
+  dir->level = level;
+  dir->base = base;
+  dir->descend = !(walk->flags & FTW_MOUNT) || st.st_dev == walk->root_dev;
+  memcpy(dir->path, path, path_len + 1);
+  if (parent != nullptr) atomic_fetch_add(&parent->refs, 1);
+  walk->group.submit(parallel_walk_dir, dir);
+  return true;
+}
+
+static void parallel_read_dir(ParallelDir* dir) {
+  ParallelWalk* walk = dir->walk;
+  bool physical = (walk->flags & FTW_PHYS) != 0;
+  bool nostat = (walk->flags & ANDROID_FTW_NOSTAT) != 0;
+
+  int fd = -1;
+  if (dir->descend) fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  parallel_report(walk, dir->path, &dir->st, (dir->descend && fd == -1) ? FTW_DNR : FTW_D,
+                  dir->base, dir->level);
+  if (fd == -1) return;
+  DIR* dirp = fdopendir(fd);
+  if (dirp == nullptr) {
+    close(fd);
+    return;
+  }
+
+  // Like fts, don't double the slash after a root given with a trailing one.
+  size_t dir_len = strlen(dir->path);
+  char path[PATH_MAX];
+  memcpy(path, dir->path, dir_len);
+  if (dir_len == 0 || path[dir_len - 1] != '/') path[dir_len++] = '/';
+  int base = dir_len;
+  int level = dir->level + 1;
+
+  dirent* e;
+  while (!parallel_stopped(walk) && (e = readdir(dirp)) != nullptr) {
+    if (e->d_name[0] == '.' &&
+        (e->d_name[1] == '\0' || (e->d_name[1] == '.' && e->d_name[2] == '\0'))) {
+      continue;
+    }
+    size_t name_len = strlen(e->d_name);
+    if (base + name_len >= sizeof(path)) {
+      parallel_stop(walk, -1, ENAMETOOLONG);
+      break;
+    }
+    memcpy(path + base, e->d_name, name_len + 1);
+
+    // Directories are always stat'ed, for FTW_MOUNT and cycle detection, and so are
+    // symbolic links that a logical walk follows. Otherwise, with ANDROID_FTW_NOSTAT,
+    // the type from getdents is enough.
+    struct stat st;
+    int fn_flag;
+    if (nostat && e->d_type != DT_UNKNOWN && e->d_type != DT_DIR &&
+        (physical || e->d_type != DT_LNK)) {
+      memset(&st, 0, sizeof(st));
+      st.st_ino = e->d_ino;
+      st.st_mode = dtype_to_mode(e->d_type);
+      fn_flag = (e->d_type == DT_LNK) ? FTW_SL : FTW_F;
+    } else if (fstatat(fd, e->d_name, &st, physical ? AT_SYMLINK_NOFOLLOW : 0) == 0) {
+      fn_flag = S_ISLNK(st.st_mode) ? FTW_SL : FTW_F;
+    } else if (!physical && fstatat(fd, e->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+      fn_flag = FTW_SLN;
+    } else {
+      memset(&st, 0, sizeof(st));
+      fn_flag = FTW_NS;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+      if (!physical) {
+        for (ParallelDir* p = dir; p != nullptr; p = p->parent) {
+          if (p->st.st_dev == st.st_dev && p->st.st_ino == st.st_ino) {
+            parallel_stop(walk, -1, ELOOP);
+            break;
+          }
+        }
+      }
+      if (parallel_stopped(walk) ||
+          !parallel_queue_dir(walk, dir, path, base + name_len, st, base, level)) {
+        break;
+      }
+    } else {
+      parallel_report(walk, path, &st, fn_flag, base, level);
+    }
+  }
+  closedir(dirp);
+}
+
+static void parallel_walk_dir(void* arg) {
+  ParallelDir* dir = reinterpret_cast<ParallelDir*>(arg);
+  if (!parallel_stopped(dir->walk)) parallel_read_dir(dir);
+  parallel_release(dir);
+}
+
+int android_nftw_parallel(const char* path,
+                          int (*fn)(const char*, const struct stat*, int, FTW*),
+                          int flags) {
+  if ((flags & ~(FTW_PHYS | FTW_MOUNT | ANDROID_FTW_NOSTAT)) != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Like nftw, follow the root even in a physical walk.
+  struct stat st;
+  bool dangling = false;
+  if (stat(path, &st) == -1) {
+    if (lstat(path, &st) == -1) return -1;
+    dangling = true;
+  }
+  size_t path_len = strlen(path);
+  if (path_len >= PATH_MAX) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+
+  ParallelWalk walk;
+  walk.group.init();
+  walk.fn = fn;
+  walk.flags = flags;
+  walk.root_dev = st.st_dev;
+  atomic_init(&walk.result, 0);
+  walk.result_errno = 0;
+
+  if (S_ISDIR(st.st_mode)) {
+    parallel_queue_dir(&walk, nullptr, path, path_len, st, 0, 0);
+    walk.group.wait();
+  } else {
+    parallel_report(&walk, path, &st, dangling ? FTW_SLN : FTW_F, 0, 0);
+  }
+
+  int result = atomic_load(&walk.result);
+  if (result == -1) errno = walk.result_errno;
+  return result;
+}
@@ -27,6 +27,7 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/cdefs.h>
 #include <sys/auxv.h>
 #include <private/bionic_auxv.h>
@@ -35,10 +36,39 @@
 
 __LIBC_HIDDEN__ ElfW(auxv_t)* __libc_auxv = NULL;
 
+// ifunc resolvers, sysconf(_SC_PAGESIZE) and CPU feature checks call
+// getauxval repeatedly, so the types the kernel actually uses (all small) are
+// copied into a table indexed by type when the auxiliary vector is found.
+// Anything else still comes from a scan of the vector.
+static constexpr unsigned long kAuxvIndexSize = 64;
+static unsigned long g_auxv_index[kAuxvIndexSize];
+static uint64_t g_auxv_index_present;
+static bool g_auxv_indexed;
+
+void __libc_init_auxv(ElfW(auxv_t)* auxv) {
+  __libc_auxv = auxv;
+  g_auxv_index_present = 0;
+  for (ElfW(auxv_t)* v = auxv; v->a_type != AT_NULL; ++v) {
+    unsigned long type = v->a_type;
+    // As with the scan, the first entry of a type is the one that counts.
+    if (type < kAuxvIndexSize && (g_auxv_index_present & (1ULL << type)) == 0) {
+      g_auxv_index[type] = v->a_un.a_val;
+      g_auxv_index_present |= 1ULL << type;
+    }
+  }
+  g_auxv_indexed = true;
+}
+
 extern "C" unsigned long int getauxval(unsigned long int type) {
-  for (ElfW(auxv_t)* v = __libc_auxv; v->a_type != AT_NULL; ++v) {
-    if (v->a_type == type) {
-      return v->a_un.a_val;
+  if (g_auxv_indexed && type < kAuxvIndexSize) {
+    if (g_auxv_index_present & (1ULL << type)) {
+      return g_auxv_index[type];
+    }
+  } else {
+    for (ElfW(auxv_t)* v = __libc_auxv; v->a_type != AT_NULL; ++v) {
+      if (v->a_type == type) {
+        return v->a_un.a_val;
+      }
     }
   }
   errno = ENOENT;
@@ -39,6 +39,7 @@
 
 #include "private/android_filesystem_config.h"
 #include "private/bionic_macros.h"
+#include "private/bionic_once.h"
 #include "private/grp_pwd.h"
 #include "private/ErrnoRestorer.h"
 #include "private/libc_logging.h"
@@ -74,71 +75,104 @@ static group_state_t* __group_state() {
   return result;
 }
 
-static int do_getpw_r(int by_name, const char* name, uid_t uid,
-                      passwd* dst, char* buf, size_t byte_count,
-                      passwd** result) {
-  // getpwnam_r and getpwuid_r don't modify errno, but library calls we
-  // make might.
-  ErrnoRestorer errno_restorer;
-  *result = NULL;
-
-  // Our implementation of getpwnam(3) and getpwuid(3) use thread-local
-  // storage, so we can call them as long as we copy everything out
-  // before returning.
-  const passwd* src = by_name ? getpwnam(name) : getpwuid(uid); // NOLINT: see above.
+// Hash tables over android_ids, by name and by id, so lookups don't have to scan
+// the whole array. They're built on first use. Each slot is an index into
+// android_ids plus one, or 0 if empty; where android_ids has two entries with the
+// same name or id, the first wins, as it did with a linear scan.
+static constexpr size_t aid_table_size(size_t n) {
+  return (n <= 1) ? 1 : 2 * aid_table_size((n + 1) / 2);
+}
+static constexpr size_t kAidTableSize = aid_table_size(2 * android_id_count);
+static uint16_t g_aid_by_name[kAidTableSize];
+static uint16_t g_aid_by_id[kAidTableSize];
+static pthread_once_t g_aid_tables_once = PTHREAD_ONCE_INIT;
 
-  // POSIX allows failure to find a match to be considered a non-error.
-  // Reporting success (0) but with *result NULL is glibc's behavior.
-  if (src == NULL) {
-    return (errno == ENOENT) ? 0 : errno;
+static uint32_t aid_name_hash(const char* name, size_t length) {
+  uint32_t hash = 2166136261u;  // FNV-1a.
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
   }
+  return hash;
+}
 
-  // Work out where our strings will go in 'buf', and whether we've got
-  // enough space.
-  size_t required_byte_count = 0;
-  dst->pw_name = buf;
-  required_byte_count += strlen(src->pw_name) + 1;
-  dst->pw_dir = buf + required_byte_count;
-  required_byte_count += strlen(src->pw_dir) + 1;
-  dst->pw_shell = buf + required_byte_count;
-  required_byte_count += strlen(src->pw_shell) + 1;
-  if (byte_count < required_byte_count) {
-    return ERANGE;
-  }
+static uint32_t aid_id_hash(unsigned id) {
+  return id * 2654435761u;
+}
 
-  // Copy the strings.
-  snprintf(buf, byte_count, "%s%c%s%c%s", src->pw_name, 0, src->pw_dir, 0, src->pw_shell);
+static void aid_table_insert(uint16_t* table, uint32_t hash, size_t n, bool is_name) {
+  for (size_t i = hash % kAidTableSize; ; i = (i + 1) % kAidTableSize) {
+    if (table[i] == 0) {
+      table[i] = static_cast<uint16_t>(n + 1);
+      return;
+    }
+    const android_id_info* other = &android_ids[table[i] - 1];
+    if (is_name ? !strcmp(other->name, android_ids[n].name) : other->aid == android_ids[n].aid) {
+      return;
+    }
+  }
+}
 
-  // pw_passwd and pw_gecos are non-POSIX and unused (always NULL) in bionic.
-  // Note: On LP32, we define pw_gecos to pw_passwd since they're both NULL.
-  dst->pw_passwd = NULL;
-#if defined(__LP64__)
-  dst->pw_gecos = NULL;
-#endif
+static void init_aid_tables() {
+  static_assert(android_id_count < UINT16_MAX, "android_ids too large for the AID tables");
+  for (size_t n = 0; n < android_id_count; ++n) {
+    const char* name = android_ids[n].name;
+    aid_table_insert(g_aid_by_name, aid_name_hash(name, strlen(name)), n, true);
+    aid_table_insert(g_aid_by_id, aid_id_hash(android_ids[n].aid), n, false);
+  }
+}
 
-  // Copy the integral fields.
-  dst->pw_gid = src->pw_gid;
-  dst->pw_uid = src->pw_uid;
+// Finds the android_ids entry named by the first 'length' characters of 'name'.
+static const android_id_info* find_android_id_by_name(const char* name, size_t length) {
+  __bionic_once(&g_aid_tables_once, init_aid_tables);
+  for (size_t i = aid_name_hash(name, length) % kAidTableSize; g_aid_by_name[i] != 0;
+       i = (i + 1) % kAidTableSize) {
+    const android_id_info* iinfo = &android_ids[g_aid_by_name[i] - 1];
+    if (!strncmp(iinfo->name, name, length) && iinfo->name[length] == '\0') {
+      return iinfo;
+    }
+  }
+  return NULL;
+}
 
-  *result = dst;
-  return 0;
+static const android_id_info* find_android_id(unsigned id) {
+  __bionic_once(&g_aid_tables_once, init_aid_tables);
+  for (size_t i = aid_id_hash(id) % kAidTableSize; g_aid_by_id[i] != 0;
+       i = (i + 1) % kAidTableSize) {
+    const android_id_info* iinfo = &android_ids[g_aid_by_id[i] - 1];
+    if (iinfo->aid == id) {
+      return iinfo;
+    }
+  }
+  return NULL;
 }
 
-int getpwnam_r(const char* name, passwd* pwd,
-               char* buf, size_t byte_count, passwd** result) {
-  return do_getpw_r(1, name, -1, pwd, buf, byte_count, result);
+// Appends a string or a number to a name being built in a fixed-size buffer,
+// truncating like snprintf. These run for every app uid lookup, so they avoid
+// snprintf's overhead.
+static char* append_name(char* p, char* end, const char* s) {
+  while (p + 1 < end && *s != '\0') {
+    *p++ = *s++;
+  }
+  *p = '\0';
+  return p;
 }
 
-int getpwuid_r(uid_t uid, passwd* pwd,
-               char* buf, size_t byte_count, passwd** result) {
-  return do_getpw_r(0, NULL, uid, pwd, buf, byte_count, result);
+static char* append_name(char* p, char* end, unsigned value) {
+  char digits[16];
+  char* d = digits + sizeof(digits);
+  *--d = '\0';
+  do {
+    *--d = '0' + (value % 10);
+    value /= 10;
+  } while (value != 0);
+  return append_name(p, end, d);
 }
 
 static passwd* android_iinfo_to_passwd(passwd_state_t* state,
                                        const android_id_info* iinfo) {
-  snprintf(state->name_buffer_, sizeof(state->name_buffer_), "%s", iinfo->name);
-  snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/");
-  snprintf(state->sh_buffer_, sizeof(state->sh_buffer_), "/system/bin/sh");
+  strlcpy(state->name_buffer_, iinfo->name, sizeof(state->name_buffer_));
+  strlcpy(state->dir_buffer_, "/", sizeof(state->dir_buffer_));
+  strlcpy(state->sh_buffer_, "/system/bin/sh", sizeof(state->sh_buffer_));
 
   passwd* pw = &state->passwd_;
   pw->pw_name  = state->name_buffer_;
@@ -151,7 +185,7 @@ static passwd* android_iinfo_to_passwd(passwd_state_t* state,
 
 static group* android_iinfo_to_group(group_state_t* state,
                                      const android_id_info* iinfo) {
-  snprintf(state->group_name_buffer_, sizeof(state->group_name_buffer_), "%s", iinfo->name);
+  strlcpy(state->group_name_buffer_, iinfo->name, sizeof(state->group_name_buffer_));
 
   group* gr = &state->group_;
   gr->gr_name   = state->group_name_buffer_;
@@ -161,39 +195,23 @@ static group* android_iinfo_to_group(group_state_t* state,
 }
 
 static passwd* android_id_to_passwd(passwd_state_t* state, unsigned id) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (android_ids[n].aid == id) {
-      return android_iinfo_to_passwd(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id(id);
+  return (iinfo != NULL) ? android_iinfo_to_passwd(state, iinfo) : NULL;
 }
 
 static passwd* android_name_to_passwd(passwd_state_t* state, const char* name) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (!strcmp(android_ids[n].name, name)) {
-      return android_iinfo_to_passwd(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id_by_name(name, strlen(name));
+  return (iinfo != NULL) ? android_iinfo_to_passwd(state, iinfo) : NULL;
 }
 
 static group* android_id_to_group(group_state_t* state, unsigned id) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (android_ids[n].aid == id) {
-      return android_iinfo_to_group(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id(id);
+  return (iinfo != NULL) ? android_iinfo_to_group(state, iinfo) : NULL;
 }
 
 static group* android_name_to_group(group_state_t* state, const char* name) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (!strcmp(android_ids[n].name, name)) {
-      return android_iinfo_to_group(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id_by_name(name, strlen(name));
+  return (iinfo != NULL) ? android_iinfo_to_group(state, iinfo) : NULL;
 }
 
 // Translate a user/group name to the corresponding user/group id.
@@ -247,13 +265,12 @@ static id_t app_id_from_name(const char* name, bool is_group) {
     // end will point to \0 if the strtoul below succeeds.
     appid = strtoul(end+2, &end, 10) + AID_ISOLATED_START;
   } else {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (!strcmp(android_ids[n].name, end + 1)) {
-        appid = android_ids[n].aid;
-        // Move the end pointer to the null terminator.
-        end += strlen(android_ids[n].name) + 1;
-        break;
-      }
+    size_t length = strlen(end + 1);
+    const android_id_info* iinfo = find_android_id_by_name(end + 1, length);
+    if (iinfo != NULL) {
+      appid = iinfo->aid;
+      // Move the end pointer to the null terminator.
+      end += length + 1;
     }
   }
 
@@ -278,20 +295,40 @@ static id_t app_id_from_name(const char* name, bool is_group) {
   return (appid + userid*AID_USER_OFFSET);
 }
 
+// Writes "u<userid>_" followed by 'prefix', 'id' and 'suffix', or the name of 'id'
+// if 'prefix' is NULL. If 'id' has no name, writes an empty string.
+static void print_app_name(char* buffer, const int bufferlen, uid_t userid,
+                           const char* prefix, uid_t id, const char* suffix) {
+  const android_id_info* iinfo = NULL;
+  if (prefix == NULL) {
+    iinfo = find_android_id(id);
+    if (iinfo == NULL) {
+      buffer[0] = '\0';
+      return;
+    }
+  }
+  char* end = buffer + bufferlen;
+  char* p = append_name(buffer, end, "u");
+  p = append_name(p, end, userid);
+  p = append_name(p, end, "_");
+  if (iinfo != NULL) {
+    append_name(p, end, iinfo->name);
+    return;
+  }
+  p = append_name(p, end, prefix);
+  p = append_name(p, end, id);
+  append_name(p, end, suffix);
+}
+
 static void print_app_name_from_uid(const uid_t uid, char* buffer, const int bufferlen) {
   const uid_t appid = uid % AID_USER_OFFSET;
   const uid_t userid = uid / AID_USER_OFFSET;
   if (appid >= AID_ISOLATED_START) {
-    snprintf(buffer, bufferlen, "u%u_i%u", userid, appid - AID_ISOLATED_START);
+    print_app_name(buffer, bufferlen, userid, "i", appid - AID_ISOLATED_START, "");
   } else if (appid < AID_APP_START) {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (android_ids[n].aid == appid) {
-        snprintf(buffer, bufferlen, "u%u_%s", userid, android_ids[n].name);
-        return;
-      }
-    }
+    print_app_name(buffer, bufferlen, userid, NULL, appid, "");
   } else {
-    snprintf(buffer, bufferlen, "u%u_a%u", userid, appid - AID_APP_START);
+    print_app_name(buffer, bufferlen, userid, "a", appid - AID_APP_START, "");
   }
 }
 
@@ -299,20 +336,16 @@ static void print_app_name_from_gid(const gid_t gid, char* buffer, const int buf
   const uid_t appid = gid % AID_USER_OFFSET;
   const uid_t userid = gid / AID_USER_OFFSET;
   if (appid >= AID_ISOLATED_START) {
-    snprintf(buffer, bufferlen, "u%u_i%u", userid, appid - AID_ISOLATED_START);
+    print_app_name(buffer, bufferlen, userid, "i", appid - AID_ISOLATED_START, "");
   } else if (userid == 0 && appid >= AID_SHARED_GID_START && appid <= AID_SHARED_GID_END) {
-    snprintf(buffer, bufferlen, "all_a%u", appid - AID_SHARED_GID_START);
+    char* end = buffer + bufferlen;
+    append_name(append_name(buffer, end, "all_a"), end, appid - AID_SHARED_GID_START);
   } else if (appid >= AID_CACHE_GID_START && appid <= AID_CACHE_GID_END) {
-    snprintf(buffer, bufferlen, "u%u_a%u_cache", userid, appid - AID_CACHE_GID_START);
+    print_app_name(buffer, bufferlen, userid, "a", appid - AID_CACHE_GID_START, "_cache");
   } else if (appid < AID_APP_START) {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (android_ids[n].aid == appid) {
-        snprintf(buffer, bufferlen, "u%u_%s", userid, android_ids[n].name);
-        return;
-      }
-    }
+    print_app_name(buffer, bufferlen, userid, NULL, appid, "");
   } else {
-    snprintf(buffer, bufferlen, "u%u_a%u", userid, appid - AID_APP_START);
+    print_app_name(buffer, bufferlen, userid, "a", appid - AID_APP_START, "");
   }
 }
 
@@ -343,9 +376,10 @@ static passwd* oem_id_to_passwd(uid_t uid, passwd_state_t* state) {
     return NULL;
   }
 
-  snprintf(state->name_buffer_, sizeof(state->name_buffer_), "oem_%u", uid);
-  snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/");
-  snprintf(state->sh_buffer_, sizeof(state->sh_buffer_), "/system/bin/sh");
+  char* end = state->name_buffer_ + sizeof(state->name_buffer_);
+  append_name(append_name(state->name_buffer_, end, "oem_"), end, uid);
+  strlcpy(state->dir_buffer_, "/", sizeof(state->dir_buffer_));
+  strlcpy(state->sh_buffer_, "/system/bin/sh", sizeof(state->sh_buffer_));
 
   passwd* pw = &state->passwd_;
   pw->pw_name  = state->name_buffer_;
@@ -361,8 +395,8 @@ static group* oem_id_to_group(gid_t gid, group_state_t* state) {
     return NULL;
   }
 
-  snprintf(state->group_name_buffer_, sizeof(state->group_name_buffer_),
-           "oem_%u", gid);
+  char* end = state->group_name_buffer_ + sizeof(state->group_name_buffer_);
+  append_name(append_name(state->group_name_buffer_, end, "oem_"), end, gid);
 
   group* gr = &state->group_;
   gr->gr_name   = state->group_name_buffer_;
@@ -384,15 +418,20 @@ static passwd* app_id_to_passwd(uid_t uid, passwd_state_t* state) {
   }
 
   print_app_name_from_uid(uid, state->name_buffer_, sizeof(state->name_buffer_));
+  if (state->name_buffer_[0] == '\0') {
+    // Another user's copy of an id that android_ids doesn't name.
+    errno = ENOENT;
+    return NULL;
+  }
 
   const uid_t appid = uid % AID_USER_OFFSET;
   if (appid < AID_APP_START) {
-      snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/");
+      strlcpy(state->dir_buffer_, "/", sizeof(state->dir_buffer_));
   } else {
-      snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/data");
+      strlcpy(state->dir_buffer_, "/data", sizeof(state->dir_buffer_));
   }
 
-  snprintf(state->sh_buffer_, sizeof(state->sh_buffer_), "/system/bin/sh");
+  strlcpy(state->sh_buffer_, "/system/bin/sh", sizeof(state->sh_buffer_));
 
   passwd* pw = &state->passwd_;
   pw->pw_name  = state->name_buffer_;
@@ -412,6 +451,10 @@ static group* app_id_to_group(gid_t gid, group_state_t* state) {
   }
 
   print_app_name_from_gid(gid, state->group_name_buffer_, sizeof(state->group_name_buffer_));
+  if (state->group_name_buffer_[0] == '\0') {
+    errno = ENOENT;
+    return NULL;
+  }
 
   group* gr = &state->group_;
   gr->gr_name   = state->group_name_buffer_;
@@ -420,12 +463,7 @@ static group* app_id_to_group(gid_t gid, group_state_t* state) {
   return gr;
 }
 
-passwd* getpwuid(uid_t uid) { // NOLINT: implementing bad function.
-  passwd_state_t* state = get_passwd_tls_buffer();
-  if (state == NULL) {
-    return NULL;
-  }
-
+static passwd* getpwuid_internal(uid_t uid, passwd_state_t* state) {
   passwd* pw = android_id_to_passwd(state, uid);
   if (pw != NULL) {
     return pw;
@@ -438,12 +476,7 @@ passwd* getpwuid(uid_t uid) { // NOLINT: implementing bad function.
   return app_id_to_passwd(uid, state);
 }
 
-passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
-  passwd_state_t* state = get_passwd_tls_buffer();
-  if (state == NULL) {
-    return NULL;
-  }
-
+static passwd* getpwnam_internal(const char* login, passwd_state_t* state) {
   passwd* pw = android_name_to_passwd(state, login);
   if (pw != NULL) {
     return pw;
@@ -456,6 +489,82 @@ passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
   return app_id_to_passwd(app_id_from_name(login, false), state);
 }
 
+passwd* getpwuid(uid_t uid) { // NOLINT: implementing bad function.
+  passwd_state_t* state = get_passwd_tls_buffer();
+  if (state == NULL) {
+    return NULL;
+  }
+  return getpwuid_internal(uid, state);
+}
+
+passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
+  passwd_state_t* state = get_passwd_tls_buffer();
+  if (state == NULL) {
+    return NULL;
+  }
+  return getpwnam_internal(login, state);
+}
+
+static int do_getpw_r(int by_name, const char* name, uid_t uid,
+                      passwd* dst, char* buf, size_t byte_count,
+                      passwd** result) {
+  // getpwnam_r and getpwuid_r don't modify errno, but library calls we
+  // make might.
+  ErrnoRestorer errno_restorer;
+  *result = NULL;
+
+  // Look the entry up into a state on our stack rather than the thread's,
+  // so we don't clobber getpwnam(3)/getpwuid(3) results and don't need TLS.
+  passwd_state_t state;
+  errno = 0;
+  const passwd* src = by_name ? getpwnam_internal(name, &state) : getpwuid_internal(uid, &state);
+
+  // POSIX allows failure to find a match to be considered a non-error.
+  // Reporting success (0) but with *result NULL is glibc's behavior.
+  if (src == NULL) {
+    return (errno == ENOENT || errno == 0) ? 0 : errno;
+  }
+
+  // Work out where our strings will go in 'buf', and whether we've got
+  // enough space.
+  size_t name_length = strlen(src->pw_name) + 1;
+  size_t dir_length = strlen(src->pw_dir) + 1;
+  size_t shell_length = strlen(src->pw_shell) + 1;
+  if (byte_count < name_length + dir_length + shell_length) {
+    return ERANGE;
+  }
+
+  // Copy the strings.
+  dst->pw_name = static_cast<char*>(memcpy(buf, src->pw_name, name_length));
+  dst->pw_dir = static_cast<char*>(memcpy(buf + name_length, src->pw_dir, dir_length));
+  dst->pw_shell = static_cast<char*>(memcpy(buf + name_length + dir_length, src->pw_shell,
+                                            shell_length));
+
+  // pw_passwd and pw_gecos are non-POSIX and unused (always NULL) in bionic.
+  // Note: On LP32, we define pw_gecos to pw_passwd since they're both NULL.
+  dst->pw_passwd = NULL;
+#if defined(__LP64__)
+  dst->pw_gecos = NULL;
+#endif
+
+  // Copy the integral fields.
+  dst->pw_gid = src->pw_gid;
+  dst->pw_uid = src->pw_uid;
+
+  *result = dst;
+  return 0;
+}
+
+int getpwnam_r(const char* name, passwd* pwd,
+               char* buf, size_t byte_count, passwd** result) {
+  return do_getpw_r(1, name, -1, pwd, buf, byte_count, result);
+}
+
+int getpwuid_r(uid_t uid, passwd* pwd,
+               char* buf, size_t byte_count, passwd** result) {
+  return do_getpw_r(0, NULL, uid, pwd, buf, byte_count, result);
+}
+
 // All users are in just one group, the one passed in.
 int getgrouplist(const char* /*user*/, gid_t group, gid_t* groups, int* ngroups) {
   if (*ngroups < 1) {
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE 1
+#include <search.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// An open-addressing hash table with linear probing. Entries are never removed, so
+// an empty key ends every probe sequence. The table doubles when it gets more than
+// half full, which moves the entries.
+
+struct __hsearch {
+  ENTRY* entries;
+  size_t mask;
+  size_t used;
+};
+
+static constexpr size_t kMinSize = 8;
+
+static size_t hash(const char* s) {
+  // FNV-1a.
+  size_t h = (sizeof(size_t) == 8) ? static_cast<size_t>(0xcbf29ce484222325ULL) : 0x811c9dc5;
+  size_t prime = (sizeof(size_t) == 8) ? static_cast<size_t>(0x100000001b3ULL) : 0x01000193;
+  for (; *s != '\0'; ++s) {
+    h = (h ^ static_cast<unsigned char>(*s)) * prime;
+  }
+  return h;
+}
+
+static ENTRY* lookup(const __hsearch* tab, const char* key, size_t h) {
+  for (size_t i = h & tab->mask;; i = (i + 1) & tab->mask) {
+    ENTRY* e = &tab->entries[i];
+    if (e->key == nullptr || strcmp(e->key, key) == 0) return e;
+  }
+}
+
+// Makes room for at least n entries while staying at most half full.
+static bool resize(__hsearch* tab, size_t n) {
+  size_t size = kMinSize;
+  while (size / 2 < n) {
+    if (size > SIZE_MAX / 2 / sizeof(ENTRY)) {
+      errno = ENOMEM;
+      return false;
+    }
+    size *= 2;
+  }
+  if (tab->entries != nullptr && size <= tab->mask + 1) return true;
+
+  ENTRY* entries = static_cast<ENTRY*>(calloc(size, sizeof(ENTRY)));
+  if (entries == nullptr) return false;
+
+  ENTRY* old_entries = tab->entries;
+  size_t old_size = (old_entries != nullptr) ? tab->mask + 1 : 0;
+  tab->entries = entries;
+  tab->mask = size - 1;
+  for (size_t i = 0; i < old_size; ++i) {
+    if (old_entries[i].key != nullptr) {
+      *lookup(tab, old_entries[i].key, hash(old_entries[i].key)) = old_entries[i];
+    }
+  }
+  free(old_entries);
+  return true;
+}
+
+int hcreate_r(size_t n, hsearch_data* htab) {
+  if (htab->__hsearch != nullptr) {
+    errno = EINVAL;
+    return 0;
+  }
+  __hsearch* tab = static_cast<__hsearch*>(calloc(1, sizeof(__hsearch)));
+  if (tab == nullptr) return 0;
+  if (!resize(tab, n)) {
+    free(tab);
+    return 0;
+  }
+  htab->__hsearch = tab;
+  return 1;
+}
+
+void hdestroy_r(hsearch_data* htab) {
+  __hsearch* tab = htab->__hsearch;
+  if (tab == nullptr) return;
+  free(tab->entries);
+  free(tab);
+  htab->__hsearch = nullptr;
+}
+
+int hsearch_r(ENTRY item, ACTION action, ENTRY** result, hsearch_data* htab) {
+  __hsearch* tab = htab->__hsearch;
+  *result = nullptr;
+  if (tab == nullptr) {
+    errno = ESRCH;
+    return 0;
+  }
+
+  size_t h = hash(item.key);
+  ENTRY* e = lookup(tab, item.key, h);
+  if (e->key != nullptr) {
+    *result = e;
+    return 1;
+  }
+  if (action == FIND) {
+    errno = ESRCH;
+    return 0;
+  }
+
+  if (tab->used + 1 > (tab->mask + 1) / 2) {
+    if (!resize(tab, tab->used + 1)) return 0;
+    e = lookup(tab, item.key, h);
+  }
+  *e = item;
+  ++tab->used;
+  *result = e;
+  return 1;
+}
+
+static hsearch_data g_hsearch_data;
+
+int hcreate(size_t n) {
+  return hcreate_r(n, &g_hsearch_data);
+}
+
+void hdestroy() {
+  hdestroy_r(&g_hsearch_data);
+}
+
+ENTRY* hsearch(ENTRY item, ACTION action) {
+  ENTRY* result;
+  hsearch_r(item, action, &result, &g_hsearch_data);
+  return result;
+}
@@ -32,6 +32,8 @@
 #include <linux/if_packet.h>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,6 +41,7 @@
 #include <unistd.h>
 
 #include "private/ErrnoRestorer.h"
+#include "private/ScopedPthreadMutexLocker.h"
 
 #include "bionic_netlink.h"
 
@@ -53,6 +56,9 @@ struct ifaddrs_storage {
   // earlier RTM_NEWLINK messages (to copy the interface flags).
   int interface_index;
 
+  // Whether this came from an RTM_NEWLINK message, for if_nameindex.
+  bool is_link;
+
   // Storage for the pointers in `ifa`.
   sockaddr_storage addr;
   sockaddr_storage netmask;
@@ -116,6 +122,14 @@ struct ifaddrs_storage {
     ifa.ifa_netmask = reinterpret_cast<sockaddr*>(&netmask);
   }
 
+  // Fixes up the pointers into this storage after it's been copied `delta` bytes away.
+  void Relocate(ptrdiff_t delta) {
+    ifa.ifa_name = Relocate(ifa.ifa_name, delta);
+    ifa.ifa_addr = Relocate(ifa.ifa_addr, delta);
+    ifa.ifa_netmask = Relocate(ifa.ifa_netmask, delta);
+    ifa.ifa_broadaddr = Relocate(ifa.ifa_broadaddr, delta);
+  }
+
   void SetPacketAttributes(int ifindex, unsigned short hatype, unsigned char halen) {
     sockaddr_ll* sll = reinterpret_cast<sockaddr_ll*>(&addr);
     sll->sll_ifindex = ifindex;
@@ -124,6 +138,10 @@ struct ifaddrs_storage {
   }
 
  private:
+  template <typename T> static T* Relocate(T* p, ptrdiff_t delta) {
+    return (p == nullptr) ? nullptr : reinterpret_cast<T*>(reinterpret_cast<char*>(p) + delta);
+  }
+
   sockaddr* CopyAddress(int family, const void* data, size_t byteCount, sockaddr_storage* ss) {
     // Netlink gives us the address family in the header, and the
     // sockaddr_in or sockaddr_in6 bytes as the payload. We need to
@@ -166,6 +184,7 @@ static void __getifaddrs_callback(void* context, nlmsghdr* hdr) {
     // Create a new ifaddr entry, and set the interface index and flags.
     ifaddrs_storage* new_addr = new ifaddrs_storage(out);
     new_addr->interface_index = ifi->ifi_index;
+    new_addr->is_link = true;
     new_addr->ifa.ifa_flags = ifi->ifi_flags;
 
     // Go through the various bits of information and find the name.
@@ -233,28 +252,156 @@ static void __getifaddrs_callback(void* context, nlmsghdr* hdr) {
   }
 }
 
-int getifaddrs(ifaddrs** out) {
-  // We construct the result directly into `out`, so terminate the list.
-  *out = nullptr;
+// The list we return is a single allocation: an array of ifaddrs_storage in list
+// order. That makes freeifaddrs a single free, and lets us hand out copies of a
+// cached list with one malloc and memcpy.
+struct ifaddrs_list {
+  ifaddrs_storage* entries;
+  size_t count;
+};
+
+// Packs a list built by __getifaddrs_callback into `packed`, freeing the list.
+static bool PackList(ifaddrs* list, ifaddrs_list* packed) {
+  size_t count = 0;
+  for (ifaddrs* it = list; it != nullptr; it = it->ifa_next) ++count;
+
+  packed->count = count;
+  packed->entries = nullptr;
+  if (count > 0) {
+    packed->entries = reinterpret_cast<ifaddrs_storage*>(malloc(count * sizeof(ifaddrs_storage)));
+  }
+
+  ifaddrs_storage* out = packed->entries;
+  while (list != nullptr) {
+    ifaddrs_storage* current = reinterpret_cast<ifaddrs_storage*>(list);
+    list = list->ifa_next;
+    if (out != nullptr) {
+      memcpy(out, current, sizeof(*out));
+      out->Relocate(reinterpret_cast<char*>(out) - reinterpret_cast<char*>(current));
+      out->ifa.ifa_next = (list != nullptr) ? &out[1].ifa : nullptr;
+      ++out;
+    }
+    delete current;
+  }
+  if (count > 0 && packed->entries == nullptr) {
+    errno = ENOMEM;
+    return false;
+  }
+  return true;
+}
 
+static ifaddrs* CopyList(const ifaddrs_list& list) {
+  if (list.count == 0) return nullptr;
+
+  size_t size = list.count * sizeof(ifaddrs_storage);
+  ifaddrs_storage* copy = reinterpret_cast<ifaddrs_storage*>(malloc(size));
+  if (copy == nullptr) return nullptr;
+  memcpy(copy, list.entries, size);
+
+  ptrdiff_t delta = reinterpret_cast<char*>(copy) - reinterpret_cast<char*>(list.entries);
+  for (size_t i = 0; i < list.count; ++i) {
+    copy[i].Relocate(delta);
+    copy[i].ifa.ifa_next = (i + 1 < list.count) ? &copy[i + 1].ifa : nullptr;
+  }
+  return &copy->ifa;
+}
+
+static bool DumpList(ifaddrs_list* packed) {
   // Open the netlink socket and ask for all the links and addresses.
+  ifaddrs* list = nullptr;
   NetlinkConnection nc;
-  bool okay = nc.SendRequest(RTM_GETLINK) && nc.ReadResponses(__getifaddrs_callback, out) &&
-              nc.SendRequest(RTM_GETADDR) && nc.ReadResponses(__getifaddrs_callback, out);
+  bool okay = nc.SendRequest(RTM_GETLINK) && nc.ReadResponses(__getifaddrs_callback, &list) &&
+              nc.SendRequest(RTM_GETADDR) && nc.ReadResponses(__getifaddrs_callback, &list);
   if (!okay) {
-    freeifaddrs(*out);
-    // Ensure that callers crash if they forget to check for success.
-    *out = nullptr;
-    return -1;
+    ErrnoRestorer errno_restorer;
+    while (list != nullptr) {
+      ifaddrs_storage* current = reinterpret_cast<ifaddrs_storage*>(list);
+      list = list->ifa_next;
+      delete current;
+    }
+    return false;
   }
+  return PackList(list, packed);
+}
+
+// The last dump, reused until g_ifaddrs_monitor reports a link or address change.
+// If we can't subscribe to changes, every call dumps afresh.
+static pthread_mutex_t g_ifaddrs_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_ifaddrs_monitor = -1;
+static pid_t g_ifaddrs_monitor_pid;
+static ifaddrs_list g_ifaddrs_cache;
+static bool g_ifaddrs_cache_valid;
+
+// Calls `callback` with the current list, dumping it if necessary.
+static bool WithList(bool callback(void*, const ifaddrs_list&), void* context) {
+  ScopedPthreadMutexLocker locker(&g_ifaddrs_lock);
+
+  pid_t pid = getpid();
+  if (g_ifaddrs_monitor_pid != pid) {
+    // After a fork, we'd be sharing the socket with our parent.
+    if (g_ifaddrs_monitor != -1) close(g_ifaddrs_monitor);
+    g_ifaddrs_monitor = NetlinkSubscribe(RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR);
+    g_ifaddrs_monitor_pid = pid;
+    g_ifaddrs_cache_valid = false;
+  } else if (g_ifaddrs_monitor != -1 && NetlinkChanged(g_ifaddrs_monitor)) {
+    g_ifaddrs_cache_valid = false;
+  }
+
+  if (g_ifaddrs_monitor == -1) {
+    ifaddrs_list list;
+    if (!DumpList(&list)) return false;
+    bool result = callback(context, list);
+    free(list.entries);
+    return result;
+  }
+
+  if (!g_ifaddrs_cache_valid) {
+    // Anything that changes during the dump will be waiting on the monitor next time.
+    free(g_ifaddrs_cache.entries);
+    g_ifaddrs_cache.entries = nullptr;
+    g_ifaddrs_cache.count = 0;
+    if (!DumpList(&g_ifaddrs_cache)) return false;
+    g_ifaddrs_cache_valid = true;
+  }
+  return callback(context, g_ifaddrs_cache);
+}
+
+static bool __getifaddrs_copy(void* context, const ifaddrs_list& list) {
+  ifaddrs** out = reinterpret_cast<ifaddrs**>(context);
+  *out = CopyList(list);
+  if (*out == nullptr && list.count != 0) {
+    errno = ENOMEM;
+    return false;
+  }
+  return true;
+}
 
-  return 0;
+int getifaddrs(ifaddrs** out) {
+  // Ensure that callers crash if they forget to check for success.
+  *out = nullptr;
+  return WithList(__getifaddrs_copy, out) ? 0 : -1;
 }
 
 void freeifaddrs(ifaddrs* list) {
-  while (list != nullptr) {
-    ifaddrs* current = list;
-    list = list->ifa_next;
-    free(current);
+  // The whole list is one allocation.
+  free(list);
+}
+
+struct links_context {
+  void (*callback)(void*, unsigned, const char*);
+  void* context;
+};
+
+static bool __getifaddrs_links_callback(void* context, const ifaddrs_list& list) {
+  links_context* links = reinterpret_cast<links_context*>(context);
+  for (size_t i = 0; i < list.count; ++i) {
+    const ifaddrs_storage& entry = list.entries[i];
+    if (entry.is_link) links->callback(links->context, entry.interface_index, entry.ifa.ifa_name);
   }
+  return true;
+}
+
+bool __getifaddrs_links(void callback(void*, unsigned, const char*), void* context) {
+  links_context links = { callback, context };
+  return WithList(__getifaddrs_links_callback, &links);
 }
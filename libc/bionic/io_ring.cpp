@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/io_ring.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/bionic_io_uring.h"
+
+// Each operation in flight has a slot, which holds what the kernel may still
+// read after submission (the iovec for a read or write) and maps the slot index
+// that we pass as the io_uring user_data back to the caller's.
+struct IoSlot {
+  uint64_t user_data;
+  iovec iov;
+  unsigned next_free;
+};
+
+struct android_io_ring {
+  // -1 if the kernel doesn't have io_uring, in which case submitted operations
+  // are kept in 'queued' and run by android_io_ring_wait.
+  int fd;
+  unsigned capacity;
+  unsigned in_flight;
+
+  void* sq_ring;
+  size_t sq_ring_size;
+  void* cq_ring;
+  size_t cq_ring_size;
+  bionic_io_uring_sqe* sqes;
+  size_t sqes_size;
+
+  unsigned* sq_tail;
+  unsigned sq_mask;
+  unsigned* sq_array;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned cq_mask;
+  bionic_io_uring_cqe* cqes;
+
+  IoSlot* slots;
+  unsigned free_slot;
+
+  android_io_op* queued;
+  pollfd* pollfds;
+};
+
+template <typename T>
+static T* ring_ptr(void* ring, unsigned offset) {
+  return reinterpret_cast<T*>(reinterpret_cast<char*>(ring) + offset);
+}
+
+static bool op_is_valid(const android_io_op& op) {
+  return op.opcode >= ANDROID_IO_READ && op.opcode <= ANDROID_IO_POLL;
+}
+
+// Runs anything but a poll synchronously, for rings without io_uring.
+static int run_op(const android_io_op& op) {
+  ErrnoRestorer errno_restorer;
+  long result;
+  switch (op.opcode) {
+    case ANDROID_IO_READ:
+      result = pread64(op.fd, op.buf, op.len, op.offset);
+      break;
+    case ANDROID_IO_WRITE:
+      result = pwrite64(op.fd, op.buf, op.len, op.offset);
+      break;
+    case ANDROID_IO_FSYNC:
+      result = fsync(op.fd);
+      break;
+    default:
+      result = fdatasync(op.fd);
+      break;
+  }
+  return (result == -1) ? -errno : static_cast<int>(result);
+}
+
+static void complete_queued(android_io_ring* ring, size_t i, int result,
+                            android_io_completion* completion) {
+  completion->user_data = ring->queued[i].user_data;
+  completion->result = result;
+  --ring->in_flight;
+  memmove(&ring->queued[i], &ring->queued[i + 1], (ring->in_flight - i) * sizeof(android_io_op));
+}
+
+// Without io_uring, android_io_ring_wait runs the queued operations in order,
+// except for polls, which are all waited for together with a single poll(2).
+// That only blocks if nothing else has completed and 'min_count' hasn't been met.
+static ssize_t wait_queued(android_io_ring* ring, android_io_completion* completions,
+                           size_t count, size_t min_count) {
+  size_t copied = 0;
+  for (size_t i = 0; i < ring->in_flight && copied < count;) {
+    if (ring->queued[i].opcode == ANDROID_IO_POLL) {
+      ++i;
+    } else {
+      complete_queued(ring, i, run_op(ring->queued[i]), &completions[copied++]);
+    }
+  }
+
+  while (copied < count && ring->in_flight != 0) {
+    // Everything left is a poll.
+    for (size_t i = 0; i < ring->in_flight; ++i) {
+      ring->pollfds[i] = { ring->queued[i].fd, ring->queued[i].poll_events, 0 };
+    }
+    int ready = poll(ring->pollfds, ring->in_flight, (copied >= min_count) ? 0 : -1);
+    if (ready == -1) return (copied == 0) ? -1 : static_cast<ssize_t>(copied);
+
+    // Walk backwards so that completing an entry doesn't move the ones still to check.
+    for (size_t i = ring->in_flight; i > 0 && copied < count; --i) {
+      short revents = ring->pollfds[i - 1].revents;
+      if (revents != 0) {
+        // io_uring fails a poll of a bad fd rather than reporting POLLNVAL.
+        int result = (revents & POLLNVAL) ? -EBADF : revents;
+        complete_queued(ring, i - 1, result, &completions[copied++]);
+      }
+    }
+    if (copied >= min_count) break;
+  }
+  return copied;
+}
+
+static void prep_sqe(android_io_ring* ring, bionic_io_uring_sqe* sqe, const android_io_op& op,
+                     unsigned slot) {
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->fd = op.fd;
+  sqe->user_data = slot;
+  ring->slots[slot].user_data = op.user_data;
+  switch (op.opcode) {
+    case ANDROID_IO_READ:
+    case ANDROID_IO_WRITE:
+      sqe->opcode = (op.opcode == ANDROID_IO_READ) ? BIONIC_IORING_OP_READV
+                                                   : BIONIC_IORING_OP_WRITEV;
+      ring->slots[slot].iov.iov_base = op.buf;
+      ring->slots[slot].iov.iov_len = op.len;
+      sqe->addr = reinterpret_cast<uintptr_t>(&ring->slots[slot].iov);
+      sqe->len = 1;
+      sqe->off = op.offset;
+      break;
+    case ANDROID_IO_FSYNC:
+    case ANDROID_IO_FDATASYNC:
+      sqe->opcode = BIONIC_IORING_OP_FSYNC;
+      if (op.opcode == ANDROID_IO_FDATASYNC) sqe->fsync_flags = BIONIC_IORING_FSYNC_DATASYNC;
+      break;
+    default:
+      sqe->opcode = BIONIC_IORING_OP_POLL_ADD;
+      sqe->poll_events = op.poll_events;
+      break;
+  }
+}
+
+static bool map_rings(android_io_ring* ring, const bionic_io_uring_params& p) {
+  ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->sq_ring = mmap(nullptr, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, BIONIC_IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) return false;
+  ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(bionic_io_uring_cqe);
+  ring->cq_ring = mmap(nullptr, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, BIONIC_IORING_OFF_CQ_RING);
+  if (ring->cq_ring == MAP_FAILED) return false;
+  ring->sqes_size = p.sq_entries * sizeof(bionic_io_uring_sqe);
+  void* sqes = mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, BIONIC_IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) return false;
+  ring->sqes = reinterpret_cast<bionic_io_uring_sqe*>(sqes);
+
+  ring->sq_tail = ring_ptr<unsigned>(ring->sq_ring, p.sq_off.tail);
+  ring->sq_mask = *ring_ptr<unsigned>(ring->sq_ring, p.sq_off.ring_mask);
+  ring->sq_array = ring_ptr<unsigned>(ring->sq_ring, p.sq_off.array);
+  ring->cq_head = ring_ptr<unsigned>(ring->cq_ring, p.cq_off.head);
+  ring->cq_tail = ring_ptr<unsigned>(ring->cq_ring, p.cq_off.tail);
+  ring->cq_mask = *ring_ptr<unsigned>(ring->cq_ring, p.cq_off.ring_mask);
+  ring->cqes = ring_ptr<bionic_io_uring_cqe>(ring->cq_ring, p.cq_off.cqes);
+  return true;
+}
+
+android_io_ring* android_io_ring_create(unsigned entries) {
+  if (entries == 0) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  android_io_ring* ring = reinterpret_cast<android_io_ring*>(calloc(1, sizeof(android_io_ring)));
+  if (ring == nullptr) return nullptr;
+  ring->sq_ring = ring->cq_ring = MAP_FAILED;
+  ring->sqes = reinterpret_cast<bionic_io_uring_sqe*>(MAP_FAILED);
+
+  // The seccomp policy applied to apps predates io_uring and traps syscalls it doesn't
+  // know rather than failing them, so only try io_uring without a seccomp filter.
+  bionic_io_uring_params p = {};
+  bool sandboxed = (prctl(PR_GET_SECCOMP) != 0);
+  ring->fd = sandboxed ? -1 : syscall(__NR_io_uring_setup, entries, &p);
+  if (ring->fd == -1) {
+    // Kernels without io_uring (or with it turned off) get the synchronous fallback.
+    if (!sandboxed && errno != ENOSYS && errno != EPERM) {
+      android_io_ring_destroy(ring);
+      return nullptr;
+    }
+    ring->capacity = entries;
+    ring->queued = reinterpret_cast<android_io_op*>(calloc(entries, sizeof(android_io_op)));
+    ring->pollfds = reinterpret_cast<pollfd*>(calloc(entries, sizeof(pollfd)));
+    if (ring->queued == nullptr || ring->pollfds == nullptr) {
+      android_io_ring_destroy(ring);
+      return nullptr;
+    }
+    return ring;
+  }
+
+  // The kernel rounds 'entries' up to a power of two, and makes the completion
+  // queue twice as big. Never having more than sq_entries in flight means that
+  // the completion queue can't overflow.
+  ring->capacity = p.sq_entries;
+  ring->slots = reinterpret_cast<IoSlot*>(calloc(ring->capacity, sizeof(IoSlot)));
+  if (ring->slots == nullptr || !map_rings(ring, p)) {
+    android_io_ring_destroy(ring);
+    return nullptr;
+  }
+  for (unsigned i = 0; i < ring->capacity; ++i) {
+    ring->slots[i].next_free = i + 1;
+  }
+  ring->free_slot = 0;
+  return ring;
+}
+
+void android_io_ring_destroy(android_io_ring* ring) {
+  ErrnoRestorer errno_restorer;
+  if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring != MAP_FAILED) munmap(ring->cq_ring, ring->cq_ring_size);
+  if (ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+  if (ring->fd != -1) close(ring->fd);
+  free(ring->slots);
+  free(ring->queued);
+  free(ring->pollfds);
+  free(ring);
+}
+
+ssize_t android_io_ring_submit(android_io_ring* ring, const android_io_op* ops, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!op_is_valid(ops[i])) {
+      errno = EINVAL;
+      return -1;
+    }
+  }
+  size_t n = ring->capacity - ring->in_flight;
+  if (n > count) n = count;
+  if (n == 0) {
+    if (count == 0) return 0;
+    errno = EBUSY;
+    return -1;
+  }
+
+  if (ring->fd == -1) {
+    memcpy(&ring->queued[ring->in_flight], ops, n * sizeof(android_io_op));
+    ring->in_flight += n;
+    return n;
+  }
+
+  // We're the only writer of the tail, and without SQPOLL the kernel only reads
+  // the queue during io_uring_enter, so anything it doesn't take can be taken back.
+  unsigned tail = *ring->sq_tail;
+  for (size_t i = 0; i < n; ++i) {
+    unsigned index = (tail + i) & ring->sq_mask;
+    unsigned slot = ring->free_slot;
+    ring->free_slot = ring->slots[slot].next_free;
+    prep_sqe(ring, &ring->sqes[index], ops[i], slot);
+    ring->sq_array[index] = index;
+  }
+  __atomic_store_n(ring->sq_tail, tail + n, __ATOMIC_RELEASE);
+
+  int submitted = TEMP_FAILURE_RETRY(
+      syscall(__NR_io_uring_enter, ring->fd, n, 0, 0, nullptr, _NSIG / 8));
+  size_t taken = (submitted == -1) ? 0 : submitted;
+  if (taken < n) {
+    // Return the slots in reverse so that the free list ends up as it was.
+    for (size_t i = n; i > taken; --i) {
+      unsigned slot = ring->sqes[(tail + i - 1) & ring->sq_mask].user_data;
+      ring->slots[slot].next_free = ring->free_slot;
+      ring->free_slot = slot;
+    }
+    __atomic_store_n(ring->sq_tail, tail + taken, __ATOMIC_RELEASE);
+  }
+  ring->in_flight += taken;
+  return (submitted == -1) ? -1 : static_cast<ssize_t>(taken);
+}
+
+ssize_t android_io_ring_wait(android_io_ring* ring, android_io_completion* completions,
+                             size_t count, size_t min_count) {
+  if (min_count > count) min_count = count;
+
+  if (ring->fd == -1) return wait_queued(ring, completions, count, min_count);
+
+  size_t copied = 0;
+  while (true) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && copied < count) {
+      const bionic_io_uring_cqe& cqe = ring->cqes[head & ring->cq_mask];
+      unsigned slot = cqe.user_data;
+      completions[copied].user_data = ring->slots[slot].user_data;
+      completions[copied].result = cqe.res;
+      ring->slots[slot].next_free = ring->free_slot;
+      ring->free_slot = slot;
+      ++head;
+      ++copied;
+      --ring->in_flight;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    if (copied >= min_count || ring->in_flight == 0) return copied;
+    size_t wanted = min_count - copied;
+    if (wanted > ring->in_flight) wanted = ring->in_flight;
+    if (syscall(__NR_io_uring_enter, ring->fd, 0, wanted, BIONIC_IORING_ENTER_GETEVENTS, nullptr,
+                _NSIG / 8) == -1) {
+      return (copied == 0) ? -1 : static_cast<ssize_t>(copied);
+    }
+  }
+}
@@ -31,9 +31,19 @@ int je_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*), void*);
 void je_malloc_disable();
 void je_malloc_enable();
 int je_mallctl(const char *name, void *oldp, size_t *oldlenp, void *newp, size_t newlen);
+int je_mallctlnametomib(const char* name, size_t* mibp, size_t* miblenp);
+int je_mallctlbymib(const size_t* mib, size_t miblen, void* oldp, size_t* oldlenp, void* newp,
+                    size_t newlen);
 void* je_memalign_round_up_boundary(size_t, size_t);
 void* je_pvalloc(size_t);
 
+// Huge page policy (jemalloc_huge_pages.cpp).
+int je_mallopt_huge_page_threshold(int);
+int je_mallopt_huge_page_arena(int);
+int je_mallopt_huge_page_limit(int);
+void je_huge_page_arena_created(unsigned arena);
+size_t je_huge_page_bytes(unsigned arena);
+
 __END_DECLS
 
 #endif  // LIBC_BIONIC_DLMALLOC_H_
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#include "jemalloc.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+// jemalloc gets memory from the system a chunk at a time through per-arena
+// hooks. Once a huge page policy is set, every arena's hooks are wrapped so
+// that chunks of at least M_HUGE_PAGE_THRESHOLD bytes, or any chunk of an
+// arena chosen with M_HUGE_PAGE_ARENA, are advised MADV_HUGEPAGE. Huge pages
+// can make sparsely used memory cost far more RSS, so the advised ranges are
+// recorded: that bounds them by M_HUGE_PAGE_LIMIT and lets malloc_stats_arena
+// report them.
+//
+// The hooks can be called with jemalloc's locks held, so they only take
+// g_ranges_lock, and nothing holding g_ranges_lock calls into jemalloc.
+
+static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+static constexpr unsigned kMaxArenas = 64;
+static constexpr size_t kMaxRanges = 256;
+
+struct HugePageRange {
+  uintptr_t start;
+  uintptr_t end;
+  unsigned arena;
+};
+
+static pthread_mutex_t g_policy_lock = PTHREAD_MUTEX_INITIALIZER;
+static chunk_hooks_t g_default_hooks;  // Written before any arena uses our hooks.
+static bool g_hooks_enabled;
+static atomic_size_t g_threshold;      // 0 if size alone doesn't qualify.
+static atomic_size_t g_limit = ATOMIC_VAR_INIT(SIZE_MAX);
+static atomic_uint_least64_t g_arena_mask;
+
+static pthread_mutex_t g_ranges_lock = PTHREAD_MUTEX_INITIALIZER;
+static HugePageRange g_ranges[kMaxRanges];
+static size_t g_range_count;
+static size_t g_total_bytes;
+static size_t g_arena_bytes[kMaxArenas];
+
+static bool wants_huge_pages(size_t size, unsigned arena) {
+  if (size < kHugePageSize) {
+    return false;
+  }
+  size_t threshold = atomic_load_explicit(&g_threshold, memory_order_relaxed);
+  if (threshold != 0 && size >= threshold) {
+    return true;
+  }
+  return arena < kMaxArenas &&
+      (atomic_load_explicit(&g_arena_mask, memory_order_relaxed) & (1ULL << arena)) != 0;
+}
+
+static void subtract_bytes(unsigned arena, size_t bytes) {
+  g_total_bytes -= bytes;
+  if (arena < kMaxArenas) {
+    g_arena_bytes[arena] -= bytes;
+  }
+}
+
+static void advise_huge_pages(void* chunk, size_t size, unsigned arena) {
+  ScopedPthreadMutexLocker locker(&g_ranges_lock);
+  size_t limit = atomic_load_explicit(&g_limit, memory_order_relaxed);
+  if (g_range_count == kMaxRanges || size > limit || g_total_bytes > limit - size) {
+    return;
+  }
+  if (madvise(chunk, size, MADV_HUGEPAGE) == -1) {
+    return;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(chunk);
+  g_ranges[g_range_count++] = { start, start + size, arena };
+  g_total_bytes += size;
+  if (arena < kMaxArenas) {
+    g_arena_bytes[arena] += size;
+  }
+}
+
+// jemalloc splits and merges chunks, so what's returned needn't be what was
+// allocated: drop whatever parts of the recorded ranges it covers.
+static void forget_huge_pages(void* chunk, size_t size) {
+  ScopedPthreadMutexLocker locker(&g_ranges_lock);
+  uintptr_t start = reinterpret_cast<uintptr_t>(chunk);
+  uintptr_t end = start + size;
+  for (size_t i = 0; i < g_range_count;) {
+    HugePageRange& range = g_ranges[i];
+    uintptr_t lo = (range.start > start) ? range.start : start;
+    uintptr_t hi = (range.end < end) ? range.end : end;
+    if (lo >= hi) {
+      ++i;
+      continue;
+    }
+    subtract_bytes(range.arena, hi - lo);
+    if (range.start < lo && hi < range.end) {
+      if (g_range_count < kMaxRanges) {
+        g_ranges[g_range_count++] = { hi, range.end, range.arena };
+      } else {
+        // No room to track the tail separately, so stop counting it.
+        subtract_bytes(range.arena, range.end - hi);
+      }
+      range.end = lo;
+      ++i;
+    } else if (range.start < lo) {
+      range.end = lo;
+      ++i;
+    } else if (hi < range.end) {
+      range.start = hi;
+      ++i;
+    } else {
+      range = g_ranges[--g_range_count];
+    }
+  }
+}
+
+static void* huge_page_chunk_alloc(void* new_addr, size_t size, size_t alignment, bool* zero,
+                                   bool* commit, unsigned arena) {
+  void* chunk = g_default_hooks.alloc(new_addr, size, alignment, zero, commit, arena);
+  if (chunk != nullptr && wants_huge_pages(size, arena)) {
+    advise_huge_pages(chunk, size, arena);
+  }
+  return chunk;
+}
+
+static bool huge_page_chunk_dalloc(void* chunk, size_t size, bool committed, unsigned arena) {
+  // A chunk that isn't unmapped is kept for reuse, and stays advised.
+  bool retained = g_default_hooks.dalloc(chunk, size, committed, arena);
+  if (!retained) {
+    forget_huge_pages(chunk, size);
+  }
+  return retained;
+}
+
+static bool install_hooks(unsigned arena) {
+  char name[64];
+  snprintf(name, sizeof(name), "arena.%u.chunk_hooks", arena);
+  chunk_hooks_t hooks;
+  size_t len = sizeof(hooks);
+  if (je_mallctl(name, &hooks, &len, nullptr, 0) != 0) {
+    return false;
+  }
+  if (hooks.alloc == huge_page_chunk_alloc) {
+    return true;
+  }
+  if (!g_hooks_enabled) {
+    g_default_hooks = hooks;
+    g_hooks_enabled = true;
+  }
+  hooks.alloc = huge_page_chunk_alloc;
+  hooks.dalloc = huge_page_chunk_dalloc;
+  return je_mallctl(name, nullptr, nullptr, &hooks, sizeof(hooks)) == 0;
+}
+
+// Arenas are created lazily, and an arena that doesn't exist yet has no
+// hooks to replace, so have the calling thread create any that are missing
+// by switching to them briefly.
+static bool install_all_hooks() {
+  unsigned narenas;
+  size_t len = sizeof(narenas);
+  if (je_mallctl("arenas.narenas", &narenas, &len, nullptr, 0) != 0) {
+    return false;
+  }
+  unsigned old_arena;
+  len = sizeof(old_arena);
+  if (je_mallctl("thread.arena", &old_arena, &len, nullptr, 0) != 0) {
+    return false;
+  }
+  bool switched = false;
+  for (unsigned i = 0; i < narenas; i++) {
+    if (install_hooks(i)) {
+      continue;
+    }
+    if (je_mallctl("thread.arena", nullptr, nullptr, &i, sizeof(i)) != 0 || !install_hooks(i)) {
+      return false;
+    }
+    switched = true;
+  }
+  if (switched) {
+    je_mallctl("thread.arena", nullptr, nullptr, &old_arena, sizeof(old_arena));
+  }
+  return true;
+}
+
+static void reset_ranges_lock_in_child() {
+  // Another thread may have held it when we forked.
+  g_ranges_lock = PTHREAD_MUTEX_INITIALIZER;
+}
+
+static int enable_policy() {
+  if (!g_hooks_enabled) {
+    pthread_atfork(nullptr, nullptr, reset_ranges_lock_in_child);
+  }
+  return install_all_hooks() ? 1 : 0;
+}
+
+int je_mallopt_huge_page_threshold(int value) {
+  if (value < 0 || (value > 0 && static_cast<size_t>(value) < kHugePageSize)) {
+    return 0;
+  }
+  ScopedPthreadMutexLocker locker(&g_policy_lock);
+  atomic_store_explicit(&g_threshold, value, memory_order_relaxed);
+  return (value == 0 && !g_hooks_enabled) ? 1 : enable_policy();
+}
+
+int je_mallopt_huge_page_arena(int value) {
+  unsigned arena;
+  if (value < 0) {
+    size_t len = sizeof(arena);
+    if (je_mallctl("thread.arena", &arena, &len, nullptr, 0) != 0) {
+      return 0;
+    }
+  } else {
+    arena = value;
+  }
+  if (arena >= kMaxArenas) {
+    return 0;
+  }
+  ScopedPthreadMutexLocker locker(&g_policy_lock);
+  atomic_fetch_or_explicit(&g_arena_mask, 1ULL << arena, memory_order_relaxed);
+  return enable_policy();
+}
+
+int je_mallopt_huge_page_limit(int value) {
+  if (value < 0) {
+    return 0;
+  }
+  size_t limit = static_cast<size_t>(value) * 1024 * 1024;
+  if (limit / (1024 * 1024) != static_cast<size_t>(value)) {
+    limit = SIZE_MAX;
+  }
+  atomic_store_explicit(&g_limit, limit, memory_order_relaxed);
+  return 1;
+}
+
+void je_huge_page_arena_created(unsigned arena) {
+  ScopedPthreadMutexLocker locker(&g_policy_lock);
+  if (g_hooks_enabled) {
+    install_hooks(arena);
+  }
+}
+
+size_t je_huge_page_bytes(unsigned arena) {
+  ScopedPthreadMutexLocker locker(&g_ranges_lock);
+  return (arena < kMaxArenas) ? g_arena_bytes[arena] : 0;
+}
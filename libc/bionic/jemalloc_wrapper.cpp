@@ -14,12 +14,21 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
 #include <malloc.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/eventfd.h>
 #include <sys/param.h>
 #include <unistd.h>
 
 #include "jemalloc.h"
 #include "private/bionic_macros.h"
+#include "private/libc_logging.h"
+#include "private/ScopedPthreadMutexLocker.h"
+#include "private/bionic_vdso.h"
 
 void* je_pvalloc(size_t bytes) {
   size_t pagesize = getpagesize();
@@ -48,8 +57,217 @@ void* je_memalign_round_up_boundary(size_t boundary, size_t size) {
   return je_memalign(boundary, size);
 }
 
+static int je_mallopt_thread_arena(int value) {
+  unsigned arena;
+  if (value < 0) {
+    size_t sz = sizeof(unsigned);
+    if (je_mallctl("arenas.extend", &arena, &sz, nullptr, 0) != 0) {
+      return 0;
+    }
+    je_huge_page_arena_created(arena);
+  } else {
+    arena = value;
+  }
+  // Switching arenas only affects new allocations, flush the thread cache
+  // so that cached objects from the old arena are not handed out.
+  je_mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+  if (je_mallctl("thread.arena", nullptr, nullptr, &arena, sizeof(arena)) != 0) {
+    return 0;
+  }
+  return 1;
+}
+
+// Arenas created for M_THREAD_ARENA_NODE, indexed by node; 0 means none yet,
+// since arena 0 is never one of ours.
+static constexpr unsigned kMaxNodeArenas = 64;
+static unsigned g_node_arenas[kMaxNodeArenas];
+static pthread_mutex_t g_node_arenas_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// jemalloc arenas carve their chunks out of fresh mappings, and the kernel
+// places those pages on the node of the thread that first touches them, so an
+// arena only used by threads on one node keeps its memory on that node.
+static int je_mallopt_thread_arena_node(int value) {
+  unsigned node;
+  if (value < 0) {
+    unsigned cpu;
+    if (__getcpu(&cpu, &node, nullptr) != 0) {
+      return 0;
+    }
+  } else {
+    node = value;
+  }
+  if (node >= kMaxNodeArenas) {
+    return 0;
+  }
+
+  pthread_mutex_lock(&g_node_arenas_lock);
+  unsigned arena = g_node_arenas[node];
+  if (arena == 0) {
+    size_t sz = sizeof(unsigned);
+    if (je_mallctl("arenas.extend", &arena, &sz, nullptr, 0) != 0) {
+      pthread_mutex_unlock(&g_node_arenas_lock);
+      return 0;
+    }
+    g_node_arenas[node] = arena;
+    je_huge_page_arena_created(arena);
+  }
+  pthread_mutex_unlock(&g_node_arenas_lock);
+  return je_mallopt_thread_arena(arena);
+}
+
+// M_PURGE_ON_MEMORY_PRESSURE starts a thread that waits on a pressure stall
+// trigger and purges when it fires. Each mallopt call opens a new trigger
+// (the kernel allows one per file) and hands it to the thread through
+// g_pressure_pending_fd, waking it with an eventfd; the thread owns and
+// closes the trigger it's waiting on. Unprivileged processes can only use
+// windows that are a multiple of two seconds.
+static constexpr unsigned kPressureWindowUs = 2000000;
+static constexpr int kNoPendingFd = -2;
+static pthread_mutex_t g_pressure_lock = PTHREAD_MUTEX_INITIALIZER;
+static pid_t g_pressure_pid;  // The process the thread was started in.
+static int g_pressure_wake_fd = -1;
+static int g_pressure_pending_fd = kNoPendingFd;
+
+static int open_pressure_trigger(int stall_ms) {
+  if (stall_ms > static_cast<int>(kPressureWindowUs / 1000)) {
+    return -1;
+  }
+  int fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd == -1) {
+    return -1;
+  }
+  char trigger[64];
+  int len = snprintf(trigger, sizeof(trigger), "some %u %u", stall_ms * 1000, kPressureWindowUs);
+  if (write(fd, trigger, len + 1) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void* pressure_thread(void*) {
+  int trigger_fd = -1;
+  while (true) {
+    pollfd fds[2] = { { g_pressure_wake_fd, POLLIN, 0 }, { trigger_fd, POLLPRI, 0 } };
+    if (poll(fds, trigger_fd == -1 ? 1 : 2, -1) == -1) {
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      eventfd_t ignored;
+      eventfd_read(g_pressure_wake_fd, &ignored);
+      ScopedPthreadMutexLocker locker(&g_pressure_lock);
+      if (g_pressure_pending_fd != kNoPendingFd) {
+        if (trigger_fd != -1) close(trigger_fd);
+        trigger_fd = g_pressure_pending_fd;
+        g_pressure_pending_fd = kNoPendingFd;
+      }
+      continue;
+    }
+    if (fds[1].revents & POLLERR) {
+      // The trigger's gone, which happens if our cgroup is removed.
+      close(trigger_fd);
+      trigger_fd = -1;
+    } else if (fds[1].revents & POLLPRI) {
+      size_t released = malloc_purge();
+      __libc_format_log(ANDROID_LOG_INFO, "libc", "memory pressure: purged %zu bytes", released);
+    }
+  }
+  return nullptr;
+}
+
+static bool start_pressure_thread() {
+  // Don't deliver the process's signals to our thread.
+  sigset_t set, old_set;
+  sigfillset(&set);
+  pthread_sigmask(SIG_SETMASK, &set, &old_set);
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  pthread_t thread;
+  int rc = pthread_create(&thread, &attr, pressure_thread, nullptr);
+  pthread_attr_destroy(&attr);
+  pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+  if (rc != 0) {
+    return false;
+  }
+  pthread_setname_np(thread, "malloc-pressure");
+  return true;
+}
+
+static int je_mallopt_purge_on_memory_pressure(int value) {
+  if (value < 0) {
+    return 0;
+  }
+  int trigger_fd = -1;
+  if (value > 0 && (trigger_fd = open_pressure_trigger(value)) == -1) {
+    return 0;
+  }
+
+  ScopedPthreadMutexLocker locker(&g_pressure_lock);
+  // The thread doesn't survive fork, so a child starts its own.
+  if (g_pressure_wake_fd == -1 || g_pressure_pid != getpid()) {
+    if (trigger_fd == -1) {
+      return 1;
+    }
+    if (g_pressure_wake_fd != -1) close(g_pressure_wake_fd);
+    if (g_pressure_pending_fd >= 0) close(g_pressure_pending_fd);
+    g_pressure_pending_fd = kNoPendingFd;
+    g_pressure_wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (g_pressure_wake_fd == -1 || !start_pressure_thread()) {
+      if (g_pressure_wake_fd != -1) close(g_pressure_wake_fd);
+      g_pressure_wake_fd = -1;
+      close(trigger_fd);
+      return 0;
+    }
+    g_pressure_pid = getpid();
+  }
+  if (g_pressure_pending_fd >= 0) close(g_pressure_pending_fd);
+  g_pressure_pending_fd = trigger_fd;
+  eventfd_write(g_pressure_wake_fd, 1);
+  return 1;
+}
+
 int je_mallopt(int param, int value) {
-  // The only parameter we currently understand is M_DECAY_TIME.
+  if (param == M_PURGE) {
+    // Flush first, so that what the cache was holding can be purged too.
+    je_mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+    unsigned narenas;
+    size_t sz = sizeof(unsigned);
+    if (je_mallctl("arenas.narenas", &narenas, &sz, nullptr, 0) != 0) {
+      return 0;
+    }
+    // Using the arena count as the index purges every arena.
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), "arena.%u.purge", narenas);
+    if (je_mallctl(buffer, nullptr, nullptr, nullptr, 0) != 0) {
+      return 0;
+    }
+    return 1;
+  } else if (param == M_THREAD_ARENA) {
+    return je_mallopt_thread_arena(value);
+  } else if (param == M_THREAD_ARENA_NODE) {
+    return je_mallopt_thread_arena_node(value);
+  } else if (param == M_THREAD_CACHE) {
+    bool enabled = value != 0;
+    if (je_mallctl("thread.tcache.enabled", nullptr, nullptr, &enabled, sizeof(enabled)) != 0) {
+      return 0;
+    }
+    return 1;
+  } else if (param == M_THREAD_CACHE_FLUSH) {
+    if (je_mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0) != 0) {
+      return 0;
+    }
+    return 1;
+  } else if (param == M_PURGE_ON_MEMORY_PRESSURE) {
+    return je_mallopt_purge_on_memory_pressure(value);
+  } else if (param == M_HUGE_PAGE_THRESHOLD) {
+    return je_mallopt_huge_page_threshold(value);
+  } else if (param == M_HUGE_PAGE_ARENA) {
+    return je_mallopt_huge_page_arena(value);
+  } else if (param == M_HUGE_PAGE_LIMIT) {
+    return je_mallopt_huge_page_limit(value);
+  }
+
   if (param == M_DECAY_TIME) {
     // Only support setting the value to 1 or 0.
     ssize_t decay_time;
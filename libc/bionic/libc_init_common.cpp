@@ -45,15 +45,13 @@
 #include "private/WriteProtected.h"
 #include "private/bionic_auxv.h"
 #include "private/bionic_globals.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/libc_logging.h"
 #include "private/thread_private.h"
 #include "pthread_internal.h"
 
 extern "C" abort_msg_t** __abort_message_ptr;
-extern "C" int __system_properties_init(void);
-
-__LIBC_HIDDEN__ WriteProtected<libc_globals> __libc_globals;
 
 // Not public, but well-known in the BSDs.
 const char* __progname;
@@ -78,14 +76,21 @@ __LIBC_HIDDEN__ extern "C" void* __kernel_syscall() {
 }
 #endif
 
-void __libc_init_globals(KernelArgumentBlock& args) {
+void __libc_init_local_globals(KernelArgumentBlock& args) {
 #if defined(__i386__)
   __libc_init_sysinfo(args);
 #endif
   // Initialize libc globals that are needed in both the linker and in libc.
-  // In dynamic binaries, this is run at least twice for different copies of the
+  // In dynamic binaries, this is run twice for different copies of these
   // globals, once for the linker's copy and once for the one in libc.so.
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
+}
+
+void __libc_init_globals(KernelArgumentBlock& args) {
+  __libc_init_local_globals(args);
+
+  // There's only one __libc_globals per process, so this is only run by the
+  // linker, or by a static executable.
   __libc_globals.initialize();
   __libc_globals.mutate([&args](libc_globals* globals) {
     __libc_init_vdso(globals, args);
@@ -107,6 +112,12 @@ static void arc4random_fork_handler() {
   _thread_arc4_lock();
 }
 
+static void arc4random_fork_child_handler() {
+  // Zero means a per-thread generator hasn't been keyed yet.
+  if (++_rs_fork_generation == 0) _rs_fork_generation = 1;
+  _thread_arc4_unlock();
+}
+
 void __libc_init_common(KernelArgumentBlock& args) {
   // Initialize various globals.
   environ = args.envp;
@@ -123,9 +134,11 @@ void __libc_init_common(KernelArgumentBlock& args) {
   __pthread_internal_add(main_thread);
 
   // Register atfork handlers to take and release the arc4random lock.
-  pthread_atfork(arc4random_fork_handler, _thread_arc4_unlock, _thread_arc4_unlock);
+  pthread_atfork(arc4random_fork_handler, _thread_arc4_unlock, arc4random_fork_child_handler);
+  __bionic_atfork_init_trace();
 
-  __system_properties_init(); // Requires 'environ'.
+  // The system properties are mapped on first use, not here.
+  __libc_startup_phase("libc_common");
 }
 
 __noreturn static void __early_abort(int line) {
@@ -313,7 +326,7 @@ static void __initialize_personality() {
 }
 
 void __libc_init_AT_SECURE(KernelArgumentBlock& args) {
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
   __abort_message_ptr = args.abort_message_ptr;
 
   // Check that the kernel provided a value for AT_SECURE.
@@ -53,6 +53,7 @@ __END_DECLS
 class KernelArgumentBlock;
 
 __LIBC_HIDDEN__ void __libc_init_globals(KernelArgumentBlock& args);
+__LIBC_HIDDEN__ void __libc_init_local_globals(KernelArgumentBlock& args);
 
 __LIBC_HIDDEN__ void __libc_init_common(KernelArgumentBlock& args);
 
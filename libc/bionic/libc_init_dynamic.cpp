@@ -53,6 +53,8 @@
 
 #include "private/bionic_globals.h"
 #include "private/bionic_ssp.h"
+#include "private/bionic_stats.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
 
@@ -79,12 +81,20 @@ __attribute__((constructor)) static void __libc_preinit() {
   // thread's TLS slot with that value. Initialize the local global stack guard with its value.
   __stack_chk_guard = reinterpret_cast<uintptr_t>(tls[TLS_SLOT_STACK_GUARD]);
 
-  __libc_init_globals(*args);
+  // Carry on with the linker's startup trace, if there is one.
+  __libc_startup_trace = args->startup_trace;
+  __libc_linker_stats = args->linker_stats;
+
+  // __libc_globals itself is the linker's, which it has already initialized.
+  __libc_init_local_globals(*args);
+  __libc_startup_phase("libc_globals");
   __libc_init_common(*args);
 
   // Hooks for various libraries to let them know that we're starting up.
   __libc_globals.mutate(__libc_init_malloc);
+  __libc_startup_phase("libc_malloc");
   netdClientInit();
+  __libc_startup_phase("libc_netd");
 }
 
 // This function is called from the executable's _start entry point
@@ -111,6 +121,7 @@ __noreturn void __libc_init(void* raw_args,
     __cxa_atexit(__libc_fini,structors->fini_array,NULL);
   }
 
+  __libc_startup_phase("main");
   exit(slingshot(args.argc, args.argv, args.envp));
 }
 
@@ -41,7 +41,9 @@
 
 #include "private/bionic_globals.h"
 #include "private/bionic_page.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
+#include "private/libc_logging.h"
 #include "private/KernelArgumentBlock.h"
 
 extern "C" int __cxa_atexit(void (*)(void *), void *, void *);
@@ -70,6 +72,57 @@ static void apply_gnu_relro() {
   }
 }
 
+// Static executables have no dynamic linker to handle their IRELATIVE relocations, so the
+// static linker gathers them between these symbols for us. Each one's target has to be set
+// to what its resolver returns before anything calls through it.
+#if defined(__aarch64__) || defined(__x86_64__)
+extern __LIBC_HIDDEN__ __attribute__((weak)) ElfW(Rela) __rela_iplt_start[], __rela_iplt_end[];
+
+static void call_ifunc_resolvers() {
+  typedef ElfW(Addr) (*ifunc_resolver_t)(void);
+  for (ElfW(Rela)* r = __rela_iplt_start; r != __rela_iplt_end; ++r) {
+    ElfW(Addr)* offset = reinterpret_cast<ElfW(Addr)*>(r->r_offset);
+    ElfW(Addr) resolver = r->r_addend;
+    *offset = reinterpret_cast<ifunc_resolver_t>(resolver)();
+  }
+}
+#else
+extern __LIBC_HIDDEN__ __attribute__((weak)) ElfW(Rel) __rel_iplt_start[], __rel_iplt_end[];
+
+static void call_ifunc_resolvers() {
+  typedef ElfW(Addr) (*ifunc_resolver_t)(void);
+  for (ElfW(Rel)* r = __rel_iplt_start; r != __rel_iplt_end; ++r) {
+    // REL relocations keep the addend, here the resolver's address, in the target.
+    ElfW(Addr)* offset = reinterpret_cast<ElfW(Addr)*>(r->r_offset);
+    ElfW(Addr) resolver = *offset;
+    *offset = reinterpret_cast<ifunc_resolver_t>(resolver)();
+  }
+}
+#endif
+
+// A static executable's TLS segment is the only one there is, and never moves.
+static TlsModule g_exe_tls_module;
+
+static void layout_static_tls(KernelArgumentBlock& args) {
+  StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+  TlsModules& modules = __libc_tls_globals.tls_modules;
+
+  TlsSegment segment;
+  if (__bionic_get_tls_segment(reinterpret_cast<ElfW(Phdr)*>(getauxval(AT_PHDR)),
+                               getauxval(AT_PHNUM), 0, &segment)) {
+    g_exe_tls_module.segment = segment;
+    g_exe_tls_module.static_offset = layout.reserve_exe_segment_and_tcb(&segment, args.argv[0]);
+    g_exe_tls_module.first_generation = atomic_load(&modules.generation);
+    modules.module_count = 1;
+    modules.module_table = &g_exe_tls_module;
+  } else if (segment.alignment == 0) {
+    __libc_fatal("\"%s\": invalid PT_TLS segment", args.argv[0]);
+  } else {
+    layout.reserve_exe_segment_and_tcb(nullptr, args.argv[0]);
+  }
+  layout.finish_layout();
+}
+
 // The program startup function __libc_init() defined here is
 // used for static executables only (i.e. those that don't depend
 // on shared libraries). It is called from arch-$ARCH/bionic/crtbegin_static.S
@@ -82,14 +135,24 @@ __noreturn void __libc_init(void* raw_args,
                             void (*onexit)(void) __unused,
                             int (*slingshot)(int, char**, char**),
                             structors_array_t const * const structors) {
+  // This has to come before anything that might call a function that's chosen by an IFUNC,
+  // such as memcpy, so the resolvers can't rely on TLS or anything else being set up.
+  call_ifunc_resolvers();
+
   KernelArgumentBlock args(raw_args);
   __libc_init_main_thread(args);
+  __libc_init_startup_trace(args);
+
+  layout_static_tls(args);
+  __libc_init_main_thread_final();
 
   // Initializing the globals requires TLS to be available for errno.
   __init_thread_stack_guard(__get_thread());
   __libc_init_globals(args);
+  __libc_startup_phase("libc_globals");
 
   __libc_init_AT_SECURE(args);
+  __libc_startup_phase("libc_at_secure");
   __libc_init_common(args);
 
   apply_gnu_relro();
@@ -99,6 +162,7 @@ __noreturn void __libc_init(void* raw_args,
 
   call_array(structors->preinit_array);
   call_array(structors->init_array);
+  __libc_startup_phase("constructors");
 
   // The executable may have its own destructors listed in its .fini_array
   // so we need to ensure that these are called when the program exits
@@ -107,9 +171,14 @@ __noreturn void __libc_init(void* raw_args,
     __cxa_atexit(__libc_fini,structors->fini_array,NULL);
   }
 
+  __libc_startup_phase("main");
   exit(slingshot(args.argc, args.argv, args.envp));
 }
 
 uint32_t bionic_get_application_target_sdk_version() {
   return __ANDROID_API__;
 }
+
+// libc.so uses the linker's copy of these; see bionic_globals.h.
+WriteProtected<libc_globals> __libc_globals;
+libc_tls_globals __libc_tls_globals;
@@ -36,6 +36,7 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -449,6 +450,8 @@ static int __libc_write_stderr(const char* tag, const char* msg) {
   return result;
 }
 
+static constexpr char kLogdSocketPath[] = "/dev/socket/logdw";
+
 static int __libc_open_log_socket() {
   // ToDo: Ideally we want this to fail if the gid of the current
   // process is AID_LOGD, but will have to wait until we have
@@ -467,7 +470,7 @@ static int __libc_open_log_socket() {
   } u;
   memset(&u, 0, sizeof(u));
   u.addrUn.sun_family = AF_UNIX;
-  strlcpy(u.addrUn.sun_path, "/dev/socket/logdw", sizeof(u.addrUn.sun_path));
+  strlcpy(u.addrUn.sun_path, kLogdSocketPath, sizeof(u.addrUn.sun_path));
 
   if (TEMP_FAILURE_RETRY(connect(log_fd, &u.addr, sizeof(u.addrUn))) != 0) {
     close(log_fd);
@@ -477,6 +480,51 @@ static int __libc_open_log_socket() {
   return log_fd;
 }
 
+// The socket to logd is opened on first use and then kept, since opening and
+// connecting one for every message costs far more than the write itself. This
+// must work from signal handlers and after fork, so there's no lock: the first
+// socket to be published wins. Callers may have closed or replaced the fd behind
+// our back (daemons that close every fd, say), so before using it we check that
+// it's still connected to logd.
+static atomic_int g_log_fd = ATOMIC_VAR_INIT(-1);
+
+static bool __libc_is_log_socket(int fd) {
+  union {
+    struct sockaddr    addr;
+    struct sockaddr_un addrUn;
+  } u;
+  memset(&u, 0, sizeof(u));
+  socklen_t len = sizeof(u) - 1;
+  return getpeername(fd, &u.addr, &len) == 0 && u.addr.sa_family == AF_UNIX &&
+      strcmp(u.addrUn.sun_path, kLogdSocketPath) == 0;
+}
+
+// Returns the shared log socket, opening a new one if there's none or the one we
+// had is no longer connected. A socket that logd has disconnected is passed as
+// 'stale', and closed once it's been replaced.
+static int __libc_get_log_socket(int stale) {
+  int fd = atomic_load_explicit(&g_log_fd, memory_order_acquire);
+  if (fd != -1 && fd != stale && __libc_is_log_socket(fd)) {
+    return fd;
+  }
+
+  int new_fd = __libc_open_log_socket();
+  if (new_fd == -1) {
+    return -1;
+  }
+  // Any other old fd isn't ours any more, so it's left alone.
+  if (atomic_compare_exchange_strong_explicit(&g_log_fd, &fd, new_fd,
+                                              memory_order_acq_rel, memory_order_acquire)) {
+    if (fd != -1 && fd == stale) {
+      close(fd);
+    }
+    return new_fd;
+  }
+  // Another thread got there first.
+  close(new_fd);
+  return fd;
+}
+
 struct cache {
   const prop_info* pinfo;
   uint32_t serial;
@@ -540,38 +588,116 @@ struct log_time { // Wire format
   uint32_t tv_nsec;
 };
 
+// The fixed fields of a message. Each is sent as its own iovec.
+struct log_header {
+  char log_id;
+  uint16_t tid;
+  log_time realtime_ts;
+  char priority;
+};
+
+static constexpr size_t kLogIovecs = 6;
+
+static void __libc_log_record_iovecs(const __libc_log_record& record, log_header& header,
+                                     iovec* vec) {
+  header.log_id = (record.priority == ANDROID_LOG_FATAL) ? LOG_ID_CRASH : LOG_ID_MAIN;
+  vec[0].iov_base = &header.log_id;
+  vec[0].iov_len = sizeof(header.log_id);
+  header.tid = record.tid;
+  vec[1].iov_base = &header.tid;
+  vec[1].iov_len = sizeof(header.tid);
+  header.realtime_ts.tv_sec = record.ts.tv_sec;
+  header.realtime_ts.tv_nsec = record.ts.tv_nsec;
+  vec[2].iov_base = &header.realtime_ts;
+  vec[2].iov_len = sizeof(header.realtime_ts);
+
+  header.priority = record.priority;
+  vec[3].iov_base = &header.priority;
+  vec[3].iov_len = 1;
+  vec[4].iov_base = const_cast<char*>(record.tag);
+  vec[4].iov_len = strlen(record.tag) + 1;
+  vec[5].iov_base = const_cast<char*>(record.msg);
+  vec[5].iov_len = strlen(record.msg) + 1;
+}
+
+void __libc_log_record_init(__libc_log_record* record, int priority, const char* tag,
+                            const char* msg) {
+  record->priority = priority;
+  record->tid = gettid();
+  clock_gettime(__android_log_clockid(), &record->ts);
+  record->tag = tag;
+  record->msg = msg;
+}
+
+int __libc_open_log() {
+  return (__libc_get_log_socket(-1) == -1) ? -1 : 0;
+}
+
 int __libc_write_log(int priority, const char* tag, const char* msg) {
-  int main_log_fd = __libc_open_log_socket();
+  int main_log_fd = __libc_get_log_socket(-1);
   if (main_log_fd == -1) {
     // Try stderr instead.
     return __libc_write_stderr(tag, msg);
   }
 
-  iovec vec[6];
-  char log_id = (priority == ANDROID_LOG_FATAL) ? LOG_ID_CRASH : LOG_ID_MAIN;
-  vec[0].iov_base = &log_id;
-  vec[0].iov_len = sizeof(log_id);
-  uint16_t tid = gettid();
-  vec[1].iov_base = &tid;
-  vec[1].iov_len = sizeof(tid);
-  timespec ts;
-  clock_gettime(__android_log_clockid(), &ts);
-  log_time realtime_ts;
-  realtime_ts.tv_sec = ts.tv_sec;
-  realtime_ts.tv_nsec = ts.tv_nsec;
-  vec[2].iov_base = &realtime_ts;
-  vec[2].iov_len = sizeof(realtime_ts);
+  __libc_log_record record;
+  __libc_log_record_init(&record, priority, tag, msg);
+  log_header header;
+  iovec vec[kLogIovecs];
+  __libc_log_record_iovecs(record, header, vec);
+
+  int result = TEMP_FAILURE_RETRY(writev(main_log_fd, vec, kLogIovecs));
+  if (result == -1 && (errno == ECONNREFUSED || errno == ENOTCONN)) {
+    // logd has restarted since we connected. Reconnect and try once more.
+    main_log_fd = __libc_get_log_socket(main_log_fd);
+    if (main_log_fd != -1) {
+      result = TEMP_FAILURE_RETRY(writev(main_log_fd, vec, kLogIovecs));
+    }
+  }
+  return result;
+}
 
-  vec[3].iov_base = &priority;
-  vec[3].iov_len = 1;
-  vec[4].iov_base = const_cast<char*>(tag);
-  vec[4].iov_len = strlen(tag) + 1;
-  vec[5].iov_base = const_cast<char*>(msg);
-  vec[5].iov_len = strlen(msg) + 1;
+int __libc_write_log_records(const __libc_log_record* records, size_t count) {
+  // Each message is a datagram of its own, so they're sent with sendmmsg.
+  static constexpr size_t kBatch = 16;
+  log_header headers[kBatch];
+  iovec vecs[kBatch][kLogIovecs];
+  mmsghdr msgs[kBatch];
+  bool reconnected = false;
 
-  int result = TEMP_FAILURE_RETRY(writev(main_log_fd, vec, sizeof(vec) / sizeof(vec[0])));
-  close(main_log_fd);
-  return result;
+  int fd = __libc_get_log_socket(-1);
+  while (count > 0) {
+    if (fd == -1) {
+      while (count-- > 0) {
+        __libc_write_stderr(records->tag, records->msg);
+        ++records;
+      }
+      return -1;
+    }
+
+    size_t n = (count < kBatch) ? count : kBatch;
+    memset(msgs, 0, n * sizeof(msgs[0]));
+    for (size_t i = 0; i < n; ++i) {
+      __libc_log_record_iovecs(records[i], headers[i], vecs[i]);
+      msgs[i].msg_hdr.msg_iov = vecs[i];
+      msgs[i].msg_hdr.msg_iovlen = kLogIovecs;
+    }
+    int sent = TEMP_FAILURE_RETRY(sendmmsg(fd, msgs, n, 0));
+    if (sent == -1 && (errno == ECONNREFUSED || errno == ENOTCONN) && !reconnected) {
+      // See __libc_write_log.
+      fd = __libc_get_log_socket(fd);
+      reconnected = true;
+      continue;
+    }
+    if (sent <= 0) {
+      // Typically EAGAIN: logd is behind, and like __libc_write_log we drop what's left
+      // rather than block.
+      return -1;
+    }
+    records += sent;
+    count -= sent;
+  }
+  return 0;
 }
 
 int __libc_format_log_va_list(int priority, const char* tag, const char* format, va_list args) {
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/libc_stats.h>
+
+#include <string.h>
+
+#include "private/bionic_stats.h"
+#include "pthread_internal.h"
+
+libc_linker_stats* __libc_linker_stats;
+
+void __libc_stats_add(int stat, uint64_t n) {
+  pthread_internal_t* thread = __get_thread();
+  if (thread != nullptr) {
+    uint64_t* counter = &thread->stats.counters[stat];
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+  }
+}
+
+size_t android_libc_get_stats(android_libc_stats* stats, size_t size) {
+  libc_thread_stats sum = {};
+  __pthread_internal_sum_stats(&sum);
+
+  android_libc_stats result = {};
+  result.mutex_contentions = sum.counters[LIBC_STAT_MUTEX_CONTENTIONS];
+  result.futex_waits = sum.counters[LIBC_STAT_FUTEX_WAITS];
+  result.stdio_flushes = sum.counters[LIBC_STAT_STDIO_FLUSHES];
+  result.malloc_calls = sum.counters[LIBC_STAT_MALLOC_CALLS];
+  result.free_calls = sum.counters[LIBC_STAT_FREE_CALLS];
+  result.resolver_cache_hits = sum.counters[LIBC_STAT_RESOLVER_CACHE_HITS];
+  result.resolver_cache_misses = sum.counters[LIBC_STAT_RESOLVER_CACHE_MISSES];
+  result.property_lookups = sum.counters[LIBC_STAT_PROPERTY_LOOKUPS];
+
+  libc_linker_stats* linker = __libc_linker_stats;
+  if (linker != nullptr) {
+    // Timing dlopen and dlsym costs two clock reads a call, so it only starts
+    // once somebody is looking.
+    __atomic_store_n(&linker->timing_enabled, 1, __ATOMIC_RELAXED);
+    result.dlopen_calls = __atomic_load_n(&linker->dlopen_calls, __ATOMIC_RELAXED);
+    result.dlopen_time_ns = __atomic_load_n(&linker->dlopen_time_ns, __ATOMIC_RELAXED);
+    result.dlsym_calls = __atomic_load_n(&linker->dlsym_calls, __ATOMIC_RELAXED);
+    result.dlsym_time_ns = __atomic_load_n(&linker->dlsym_time_ns, __ATOMIC_RELAXED);
+  }
+
+  memcpy(stats, &result, (size < sizeof(result)) ? size : sizeof(result));
+  return sizeof(result);
+}
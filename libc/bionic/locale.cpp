@@ -36,6 +36,7 @@
 #include <wchar.h>
 
 #include "private/bionic_macros.h"
+#include "private/bionic_once.h"
 
 #include "bionic/pthread_internal.h"
 
@@ -43,6 +44,7 @@
 // and the "C.UTF-8" locale (also known as "en_US.UTF-8").
 
 static bool __bionic_current_locale_is_utf8 = true;
+static size_t __bionic_current_mb_cur_max = 4;
 
 struct __locale_t {
   size_t mb_cur_max;
@@ -52,7 +54,7 @@ struct __locale_t {
 
   explicit __locale_t(const __locale_t* other) {
     if (other == LC_GLOBAL_LOCALE) {
-      mb_cur_max = __bionic_current_locale_is_utf8 ? 4 : 1;
+      mb_cur_max = __bionic_current_mb_cur_max;
     } else {
       mb_cur_max = other->mb_cur_max;
     }
@@ -61,13 +63,13 @@ struct __locale_t {
   DISALLOW_COPY_AND_ASSIGN(__locale_t);
 };
 
+// MB_CUR_MAX expands to a call of this, so loops over multibyte strings call
+// it a lot. uselocale keeps the thread's value in its TLS, where it's a single
+// load; a thread that hasn't chosen a locale of its own has 0 there, and gets
+// the global locale's value, which setlocale keeps up to date.
 size_t __ctype_get_mb_cur_max() {
-  locale_t l = uselocale(NULL);
-  if (l == LC_GLOBAL_LOCALE) {
-    return __bionic_current_locale_is_utf8 ? 4 : 1;
-  } else {
-    return l->mb_cur_max;
-  }
+  size_t mb_cur_max = __get_bionic_tls().locale_mb_cur_max;
+  return (mb_cur_max != 0) ? mb_cur_max : __bionic_current_mb_cur_max;
 }
 
 static pthread_once_t g_locale_once = PTHREAD_ONCE_INIT;
@@ -116,7 +118,7 @@ static bool __is_utf8_locale(const char* locale_name) {
 }
 
 lconv* localeconv() {
-  pthread_once(&g_locale_once, __locale_init);
+  __bionic_once(&g_locale_once, __locale_init);
   return &g_locale;
 }
 
@@ -158,14 +160,15 @@ char* setlocale(int category, const char* locale_name) {
       return NULL;
     }
     __bionic_current_locale_is_utf8 = __is_utf8_locale(locale_name);
+    __bionic_current_mb_cur_max = __bionic_current_locale_is_utf8 ? 4 : 1;
   }
 
   return const_cast<char*>(__bionic_current_locale_is_utf8 ? "C.UTF-8" : "C");
 }
 
 locale_t uselocale(locale_t new_locale) {
-  locale_t* locale_storage = &__get_bionic_tls().locale;
-  locale_t old_locale = *locale_storage;
+  bionic_tls& tls = __get_bionic_tls();
+  locale_t old_locale = tls.locale;
 
   // If this is the first call to uselocale(3) on this thread, we return LC_GLOBAL_LOCALE.
   if (old_locale == NULL) {
@@ -173,7 +176,8 @@ locale_t uselocale(locale_t new_locale) {
   }
 
   if (new_locale != NULL) {
-    *locale_storage = new_locale;
+    tls.locale = new_locale;
+    tls.locale_mb_cur_max = (new_locale == LC_GLOBAL_LOCALE) ? 0 : new_locale->mb_cur_max;
   }
 
   return old_locale;
@@ -40,13 +40,19 @@
 //   free_malloc_leak_info: Frees the data allocated by the call to
 //                          get_malloc_leak_info.
 
+#include <fcntl.h>
 #include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <private/bionic_config.h>
 #include <private/bionic_globals.h>
 #include <private/bionic_malloc_dispatch.h>
 
 #include "jemalloc.h"
+#include "pthread_internal.h"
 #define Malloc(function)  je_ ## function
 
 static constexpr MallocDispatch __libc_malloc_default_dispatch
@@ -78,6 +84,7 @@ int gMallocLeakZygoteChild = 0;
 // Allocation functions
 // =============================================================================
 extern "C" void* calloc(size_t n_elements, size_t elem_size) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _calloc = __libc_globals->malloc_dispatch.calloc;
   if (__predict_false(_calloc != nullptr)) {
     return _calloc(n_elements, elem_size);
@@ -86,6 +93,7 @@ extern "C" void* calloc(size_t n_elements, size_t elem_size) {
 }
 
 extern "C" void free(void* mem) {
+  __libc_stats_inc(LIBC_STAT_FREE_CALLS);
   auto _free = __libc_globals->malloc_dispatch.free;
   if (__predict_false(_free != nullptr)) {
     _free(mem);
@@ -111,6 +119,7 @@ extern "C" int mallopt(int param, int value) {
 }
 
 extern "C" void* malloc(size_t bytes) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _malloc = __libc_globals->malloc_dispatch.malloc;
   if (__predict_false(_malloc != nullptr)) {
     return _malloc(bytes);
@@ -127,6 +136,7 @@ extern "C" size_t malloc_usable_size(const void* mem) {
 }
 
 extern "C" void* memalign(size_t alignment, size_t bytes) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _memalign = __libc_globals->malloc_dispatch.memalign;
   if (__predict_false(_memalign != nullptr)) {
     return _memalign(alignment, bytes);
@@ -135,6 +145,7 @@ extern "C" void* memalign(size_t alignment, size_t bytes) {
 }
 
 extern "C" int posix_memalign(void** memptr, size_t alignment, size_t size) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _posix_memalign = __libc_globals->malloc_dispatch.posix_memalign;
   if (__predict_false(_posix_memalign != nullptr)) {
     return _posix_memalign(memptr, alignment, size);
@@ -143,6 +154,7 @@ extern "C" int posix_memalign(void** memptr, size_t alignment, size_t size) {
 }
 
 extern "C" void* realloc(void* old_mem, size_t bytes) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _realloc = __libc_globals->malloc_dispatch.realloc;
   if (__predict_false(_realloc != nullptr)) {
     return _realloc(old_mem, bytes);
@@ -152,6 +164,7 @@ extern "C" void* realloc(void* old_mem, size_t bytes) {
 
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 extern "C" void* pvalloc(size_t bytes) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _pvalloc = __libc_globals->malloc_dispatch.pvalloc;
   if (__predict_false(_pvalloc != nullptr)) {
     return _pvalloc(bytes);
@@ -160,6 +173,7 @@ extern "C" void* pvalloc(size_t bytes) {
 }
 
 extern "C" void* valloc(size_t bytes) {
+  __libc_stats_inc(LIBC_STAT_MALLOC_CALLS);
   auto _valloc = __libc_globals->malloc_dispatch.valloc;
   if (__predict_false(_valloc != nullptr)) {
     return _valloc(bytes);
@@ -175,23 +189,32 @@ extern "C" void* valloc(size_t bytes) {
 #include <dlfcn.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <private/bionic_mutex_contention.h>
 #include <private/libc_logging.h>
+#include <private/ScopedPthreadMutexLocker.h>
 #include <sys/system_properties.h>
 
+#include "malloc_tagged.h"
+
 extern "C" int __cxa_atexit(void (*func)(void *), void *arg, void *dso);
 
 static const char* DEBUG_SHARED_LIB = "libc_malloc_debug.so";
 static const char* DEBUG_MALLOC_PROPERTY_OPTIONS = "libc.debug.malloc.options";
 static const char* DEBUG_MALLOC_PROPERTY_PROGRAM = "libc.debug.malloc.program";
 static const char* DEBUG_MALLOC_ENV_OPTIONS = "LIBC_DEBUG_MALLOC_OPTIONS";
+static const char* POINTER_TAG_PROPERTY = "libc.malloc.pointer_tag";
+static const char* POINTER_TAG_ENV = "LIBC_MALLOC_POINTER_TAG";
 
 static void* libc_malloc_impl_handle = nullptr;
+static bool g_pointer_tag_enabled = false;
 
 static void (*g_debug_finalize_func)();
 static void (*g_debug_get_malloc_leak_info_func)(uint8_t**, size_t*, size_t*, size_t*, size_t*);
 static void (*g_debug_free_malloc_leak_info_func)(uint8_t*);
 static ssize_t (*g_debug_malloc_backtrace_func)(void*, uintptr_t*, size_t);
+static bool (*g_debug_malloc_write_profile_func)(int);
 
 // =============================================================================
 // Log functions
@@ -315,44 +338,30 @@ static void malloc_fini_impl(void*) {
   fclose(stdout);
   fclose(stderr);
 
+  // The contention function belongs to malloc debug, which is going away.
+  __libc_set_mutex_contention_func(nullptr, 0);
   g_debug_finalize_func();
 }
 
-// Initializes memory allocation framework once per process.
-static void malloc_init_impl(libc_globals* globals) {
-  char value[PROP_VALUE_MAX];
-
-  // If DEBUG_MALLOC_ENV_OPTIONS is set then it overrides the system properties.
-  const char* options = getenv(DEBUG_MALLOC_ENV_OPTIONS);
-  if (options == nullptr || options[0] == '\0') {
-    if (__system_property_get(DEBUG_MALLOC_PROPERTY_OPTIONS, value) == 0 || value[0] == '\0') {
-      return;
-    }
-    options = value;
-
-    // Check to see if only a specific program should have debug malloc enabled.
-    char program[PROP_VALUE_MAX];
-    if (__system_property_get(DEBUG_MALLOC_PROPERTY_PROGRAM, program) != 0 &&
-        strstr(getprogname(), program) == nullptr) {
-      return;
-    }
-  }
-
+// Loads the debug malloc shared library, initializes it with the routine
+// init_name and fills in table with its allocation functions.
+static bool load_debug_malloc(const char* options, const char* init_name,
+                              MallocDispatch* table) {
   // Load the debug malloc shared library.
   void* malloc_impl_handle = dlopen(DEBUG_SHARED_LIB, RTLD_NOW | RTLD_LOCAL);
   if (malloc_impl_handle == nullptr) {
     error_log("%s: Unable to open debug malloc shared library %s: %s",
               getprogname(), DEBUG_SHARED_LIB, dlerror());
-    return;
+    return false;
   }
 
   // Initialize malloc debugging in the loaded module.
   auto init_func = reinterpret_cast<bool (*)(const MallocDispatch*, int*, const char*)>(
-      dlsym(malloc_impl_handle, "debug_initialize"));
+      dlsym(malloc_impl_handle, init_name));
   if (init_func == nullptr) {
-    error_log("%s: debug_initialize routine not found in %s", getprogname(), DEBUG_SHARED_LIB);
+    error_log("%s: %s routine not found in %s", getprogname(), init_name, DEBUG_SHARED_LIB);
     dlclose(malloc_impl_handle);
-    return;
+    return false;
   }
 
   // Get the syms for the external functions.
@@ -360,7 +369,7 @@ static void malloc_init_impl(libc_globals* globals) {
   if (finalize_sym == nullptr) {
     error_log("%s: debug_finalize routine not found in %s", getprogname(), DEBUG_SHARED_LIB);
     dlclose(malloc_impl_handle);
-    return;
+    return false;
   }
 
   void* get_leak_info_sym = dlsym(malloc_impl_handle, "debug_get_malloc_leak_info");
@@ -368,7 +377,7 @@ static void malloc_init_impl(libc_globals* globals) {
     error_log("%s: debug_get_malloc_leak_info routine not found in %s", getprogname(),
               DEBUG_SHARED_LIB);
     dlclose(malloc_impl_handle);
-    return;
+    return false;
   }
 
   void* free_leak_info_sym = dlsym(malloc_impl_handle, "debug_free_malloc_leak_info");
@@ -376,7 +385,7 @@ static void malloc_init_impl(libc_globals* globals) {
     error_log("%s: debug_free_malloc_leak_info routine not found in %s", getprogname(),
               DEBUG_SHARED_LIB);
     dlclose(malloc_impl_handle);
-    return;
+    return false;
   }
 
   void* malloc_backtrace_sym = dlsym(malloc_impl_handle, "debug_malloc_backtrace");
@@ -384,20 +393,27 @@ static void malloc_init_impl(libc_globals* globals) {
     error_log("%s: debug_malloc_backtrace routine not found in %s", getprogname(),
               DEBUG_SHARED_LIB);
     dlclose(malloc_impl_handle);
-    return;
+    return false;
+  }
+
+  void* malloc_write_profile_sym = dlsym(malloc_impl_handle, "debug_malloc_write_profile");
+  if (malloc_write_profile_sym == nullptr) {
+    error_log("%s: debug_malloc_write_profile routine not found in %s", getprogname(),
+              DEBUG_SHARED_LIB);
+    dlclose(malloc_impl_handle);
+    return false;
   }
 
   if (!init_func(&__libc_malloc_default_dispatch, &gMallocLeakZygoteChild, options)) {
     dlclose(malloc_impl_handle);
-    return;
+    return false;
   }
 
-  MallocDispatch malloc_dispatch_table;
-  if (!InitMalloc(malloc_impl_handle, &malloc_dispatch_table, "debug")) {
+  if (!InitMalloc(malloc_impl_handle, table, "debug")) {
     auto finalize_func = reinterpret_cast<void (*)()>(finalize_sym);
     finalize_func();
     dlclose(malloc_impl_handle);
-    return;
+    return false;
   }
 
   g_debug_finalize_func = reinterpret_cast<void (*)()>(finalize_sym);
@@ -406,8 +422,19 @@ static void malloc_init_impl(libc_globals* globals) {
   g_debug_free_malloc_leak_info_func = reinterpret_cast<void (*)(uint8_t*)>(free_leak_info_sym);
   g_debug_malloc_backtrace_func = reinterpret_cast<ssize_t (*)(
       void*, uintptr_t*, size_t)>(malloc_backtrace_sym);
+  g_debug_malloc_write_profile_func = reinterpret_cast<bool (*)(int)>(malloc_write_profile_sym);
+
+  // Optional, so that an older malloc debug library still loads.
+  auto get_contention_func = reinterpret_cast<MutexContentionFunc (*)(uint32_t*)>(
+      dlsym(malloc_impl_handle, "debug_get_mutex_contention_func"));
+  if (get_contention_func != nullptr) {
+    uint32_t sample_interval;
+    MutexContentionFunc contention_func = get_contention_func(&sample_interval);
+    if (contention_func != nullptr) {
+      __libc_set_mutex_contention_func(contention_func, sample_interval);
+    }
+  }
 
-  globals->malloc_dispatch = malloc_dispatch_table;
   libc_malloc_impl_handle = malloc_impl_handle;
 
   info_log("%s: malloc debug enabled", getprogname());
@@ -420,6 +447,94 @@ static void malloc_init_impl(libc_globals* globals) {
   if (ret_value != 0) {
     error_log("failed to set atexit cleanup function: %d", ret_value);
   }
+  return true;
+}
+
+// Initializes memory allocation framework once per process.
+static void malloc_init_impl(libc_globals* globals) {
+  char value[PROP_VALUE_MAX];
+
+  // If DEBUG_MALLOC_ENV_OPTIONS is set then it overrides the system properties.
+  const char* options = getenv(DEBUG_MALLOC_ENV_OPTIONS);
+  if (options == nullptr || options[0] == '\0') {
+    // Every process gets here, so look all of the properties up in one pass.
+    char program[PROP_VALUE_MAX];
+    char pointer_tag[PROP_VALUE_MAX];
+    const char* const names[] = {
+      DEBUG_MALLOC_PROPERTY_OPTIONS, DEBUG_MALLOC_PROPERTY_PROGRAM, POINTER_TAG_PROPERTY
+    };
+    char* const values[] = { value, program, pointer_tag };
+    __system_property_get_many(names, values, 3);
+    if (value[0] == '\0') {
+      // Malloc debug wins if both are asked for, since it wraps the native
+      // allocator's functions and the tagged pointers would confuse it.
+      const char* env_pointer_tag = getenv(POINTER_TAG_ENV);
+      if (strcmp(pointer_tag, "1") == 0 ||
+          (env_pointer_tag != nullptr && strcmp(env_pointer_tag, "1") == 0)) {
+        MallocDispatch malloc_dispatch_table;
+        if (__libc_malloc_tagged_init(&malloc_dispatch_table)) {
+          globals->malloc_dispatch = malloc_dispatch_table;
+          g_pointer_tag_enabled = true;
+        } else {
+          error_log("%s: pointer tagging is not supported", getprogname());
+        }
+      }
+      return;
+    }
+    options = value;
+
+    // Check to see if only a specific program should have debug malloc enabled.
+    if (program[0] != '\0' && strstr(getprogname(), program) == nullptr) {
+      return;
+    }
+  }
+
+  MallocDispatch malloc_dispatch_table;
+  if (load_debug_malloc(options, "debug_initialize", &malloc_dispatch_table)) {
+    globals->malloc_dispatch = malloc_dispatch_table;
+  }
+}
+
+// Enables malloc debug in a process that is already running. Allocations
+// made before this call are not known to malloc debug, which passes them
+// through to the native allocator. Malloc debug cannot be disabled again.
+extern "C" bool malloc_debug_enable(const char* options) {
+  static pthread_mutex_t enable_lock = PTHREAD_MUTEX_INITIALIZER;
+  ScopedPthreadMutexLocker locker(&enable_lock);
+
+  if (options == nullptr || options[0] == '\0') {
+    return false;
+  }
+  if (libc_malloc_impl_handle != nullptr) {
+    error_log("%s: malloc debug is already enabled", getprogname());
+    return false;
+  }
+  if (g_pointer_tag_enabled) {
+    error_log("%s: malloc debug can't be enabled with pointer tagging", getprogname());
+    return false;
+  }
+
+  MallocDispatch malloc_dispatch_table;
+  if (!load_debug_malloc(options, "debug_initialize_late", &malloc_dispatch_table)) {
+    return false;
+  }
+
+  // Other threads keep allocating while the table is replaced, and they
+  // could see a partially written table. Install the functions that take
+  // an existing pointer first, so that a pointer returned by the debug
+  // malloc is never passed to the native free. Making the globals read
+  // only again flushes the TLB on every cpu, which orders the two steps.
+  __libc_globals.mutate([&malloc_dispatch_table](libc_globals* globals) {
+    MallocDispatch* dispatch = &globals->malloc_dispatch;
+    dispatch->free = malloc_dispatch_table.free;
+    dispatch->realloc = malloc_dispatch_table.realloc;
+    dispatch->malloc_usable_size = malloc_dispatch_table.malloc_usable_size;
+    dispatch->iterate = malloc_dispatch_table.iterate;
+  });
+  __libc_globals.mutate([&malloc_dispatch_table](libc_globals* globals) {
+    globals->malloc_dispatch = malloc_dispatch_table;
+  });
+  return true;
 }
 
 // Initializes memory allocation framework.
@@ -463,6 +578,108 @@ extern "C" void malloc_enable() {
   return Malloc(malloc_enable)();
 }
 
+// The copy of the process made by malloc_iterate_snapshot sends back the
+// allocations it finds in batches of (base, size) pairs.
+static constexpr size_t kSnapshotBatch = 256;
+
+struct SnapshotWriter {
+  int fd;
+  size_t count;
+  bool failed;
+  uintptr_t entries[2 * kSnapshotBatch];
+};
+
+static void SnapshotFlush(SnapshotWriter* writer) {
+  const char* data = reinterpret_cast<const char*>(writer->entries);
+  size_t bytes = writer->count * 2 * sizeof(uintptr_t);
+  while (bytes > 0 && !writer->failed) {
+    ssize_t written = TEMP_FAILURE_RETRY(write(writer->fd, data, bytes));
+    if (written <= 0) {
+      writer->failed = true;
+    } else {
+      data += written;
+      bytes -= written;
+    }
+  }
+  writer->count = 0;
+}
+
+static void SnapshotAdd(uintptr_t base, size_t size, void* arg) {
+  SnapshotWriter* writer = reinterpret_cast<SnapshotWriter*>(arg);
+  writer->entries[2 * writer->count] = base;
+  writer->entries[2 * writer->count + 1] = size;
+  if (++writer->count == kSnapshotBatch) {
+    SnapshotFlush(writer);
+  }
+}
+
+// Calls callback for every allocation in [base, base+size) that was live
+// when this was called, like malloc_iterate, but allocations are only
+// disabled while a copy of the process is forked. The copy walks its
+// frozen heap and streams the allocations back over a pipe, so the walk
+// and the callbacks run while the rest of the process keeps allocating.
+// By the time the callback hears of an allocation, it may have been freed.
+// Must not be called between malloc_disable and malloc_enable.
+extern "C" int malloc_iterate_snapshot(uintptr_t base, size_t size,
+    void (*callback)(uintptr_t base, size_t size, void* arg), void* arg) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) {
+    return -1;
+  }
+
+  pthread_internal_t* self = __get_thread();
+  malloc_disable();
+  // Not fork(), whose atfork handlers would try to take the allocator
+  // locks that malloc_disable already holds.
+  pid_t pid = clone(nullptr, nullptr, (CLONE_CHILD_SETTID | CLONE_CHILD_CLEARTID | SIGCHLD),
+                    nullptr, nullptr, nullptr, &(self->tid));
+  if (pid == 0) {
+    self->set_cached_pid(gettid());
+    close(fds[0]);
+    // This is the only thread in the copy, so release the allocator locks
+    // it inherited and take them again as its own before the walk.
+    malloc_enable();
+    malloc_disable();
+    SnapshotWriter writer;
+    writer.fd = fds[1];
+    writer.count = 0;
+    writer.failed = false;
+    int result = malloc_iterate(base, size, SnapshotAdd, &writer);
+    SnapshotFlush(&writer);
+    _exit((result == 0 && !writer.failed) ? 0 : 1);
+  }
+  malloc_enable();
+  close(fds[1]);
+  if (pid == -1) {
+    close(fds[0]);
+    return -1;
+  }
+
+  uintptr_t entries[2 * kSnapshotBatch];
+  size_t have = 0;
+  ssize_t bytes_read;
+  while ((bytes_read = TEMP_FAILURE_RETRY(read(fds[0], reinterpret_cast<char*>(entries) + have,
+                                                sizeof(entries) - have))) > 0) {
+    have += bytes_read;
+    size_t pairs = have / (2 * sizeof(uintptr_t));
+    for (size_t i = 0; i < pairs; ++i) {
+      callback(entries[2 * i], entries[2 * i + 1], arg);
+    }
+    // Keep any partial pair for the next read.
+    size_t used = pairs * 2 * sizeof(uintptr_t);
+    memmove(entries, reinterpret_cast<char*>(entries) + used, have - used);
+    have -= used;
+  }
+  close(fds[0]);
+
+  int status;
+  if (TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)) != pid || bytes_read == -1 ||
+      !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
 #ifndef LIBC_STATIC
 extern "C" ssize_t malloc_backtrace(void* pointer, uintptr_t* frames, size_t frame_count) {
   if (g_debug_malloc_backtrace_func == nullptr) {
@@ -470,8 +687,26 @@ extern "C" ssize_t malloc_backtrace(void* pointer, uintptr_t* frames, size_t fra
   }
   return g_debug_malloc_backtrace_func(pointer, frames, frame_count);
 }
+
+// Writes the live allocations, grouped by backtrace with their counts and
+// bytes, to fd as an uncompressed pprof profile. Only works when malloc
+// debug is enabled with the backtrace option.
+extern "C" bool malloc_write_profile(int fd) {
+  if (g_debug_malloc_write_profile_func == nullptr) {
+    return false;
+  }
+  return g_debug_malloc_write_profile_func(fd);
+}
 #else
 extern "C" ssize_t malloc_backtrace(void*, uintptr_t*, size_t) {
   return 0;
 }
+
+extern "C" bool malloc_write_profile(int) {
+  return false;
+}
+
+extern "C" bool malloc_debug_enable(const char*) {
+  return false;
+}
 #endif
@@ -17,7 +17,13 @@
 #include "malloc_info.h"
 
 #include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "jemalloc.h"
 #include "private/bionic_macros.h"
+#include "private/bionic_once.h"
 
 class __LIBC_HIDDEN__ Elem {
 public:
@@ -56,12 +62,177 @@ private:
   DISALLOW_COPY_AND_ASSIGN(Elem);
 };
 
+// Statistics read through mallctl. The MIBs are looked up once, and the
+// arena and bin components are filled in for each read, so that polling
+// does not have to parse mallctl names.
+enum StatId {
+  STAT_PACTIVE,
+  STAT_PDIRTY,
+  STAT_MAPPED,
+  STAT_RETAINED,
+  STAT_BIN_CURREGS,
+  STAT_BIN_CURRUNS,
+  STAT_BIN_NFILLS,
+  STAT_BIN_NFLUSHES,
+  STAT_BIN_SIZE,
+  STAT_BIN_NREGS,
+  STAT_PAGE,
+  STAT_COUNT,
+};
+
+struct StatMib {
+  const char* name;
+  // Positions of the arena and bin indexes in the MIB, or -1.
+  int arena_pos;
+  int bin_pos;
+  size_t mib[6];
+  size_t miblen;
+  // False if this jemalloc does not provide the statistic.
+  bool valid;
+};
+
+static StatMib g_stat_mibs[STAT_COUNT] = {
+  { "stats.arenas.0.pactive", 2, -1, {}, 0, false },
+  { "stats.arenas.0.pdirty", 2, -1, {}, 0, false },
+  { "stats.arenas.0.mapped", 2, -1, {}, 0, false },
+  { "stats.arenas.0.retained", 2, -1, {}, 0, false },
+  { "stats.arenas.0.bins.0.curregs", 2, 4, {}, 0, false },
+  { "stats.arenas.0.bins.0.curruns", 2, 4, {}, 0, false },
+  { "stats.arenas.0.bins.0.nfills", 2, 4, {}, 0, false },
+  { "stats.arenas.0.bins.0.nflushes", 2, 4, {}, 0, false },
+  { "arenas.bin.0.size", -1, 2, {}, 0, false },
+  { "arenas.bin.0.nregs", -1, 2, {}, 0, false },
+  { "arenas.page", -1, -1, {}, 0, false },
+};
+
+static pthread_once_t g_stat_mibs_once = PTHREAD_ONCE_INIT;
+
+static void init_stat_mibs() {
+  for (size_t i = 0; i < STAT_COUNT; i++) {
+    StatMib* stat = &g_stat_mibs[i];
+    stat->miblen = sizeof(stat->mib) / sizeof(stat->mib[0]);
+    stat->valid = je_mallctlnametomib(stat->name, stat->mib, &stat->miblen) == 0;
+  }
+}
+
+// Returns 0 if the statistic is not available.
+template <typename T>
+static T read_stat(StatId id, size_t arena = 0, size_t bin = 0) {
+  __bionic_once(&g_stat_mibs_once, init_stat_mibs);
+  const StatMib& stat = g_stat_mibs[id];
+  if (!stat.valid) {
+    return 0;
+  }
+  size_t mib[sizeof(stat.mib) / sizeof(stat.mib[0])];
+  memcpy(mib, stat.mib, sizeof(mib));
+  if (stat.arena_pos >= 0) {
+    mib[stat.arena_pos] = arena;
+  }
+  if (stat.bin_pos >= 0) {
+    mib[stat.bin_pos] = bin;
+  }
+  T value = 0;
+  size_t len = sizeof(value);
+  if (je_mallctlbymib(mib, stat.miblen, &value, &len, nullptr, 0) != 0) {
+    return 0;
+  }
+  return value;
+}
+
+static void refresh_stats() {
+  // jemalloc only updates the mallctl statistics when the epoch changes.
+  uint64_t epoch = 1;
+  size_t len = sizeof(epoch);
+  je_mallctl("epoch", &epoch, &len, &epoch, len);
+}
+
+static void get_arena_stats(size_t arena, struct malloc_arena_stats* stats) {
+  struct mallinfo mi = __mallinfo_arena_info(arena);
+  size_t page_size = read_stat<size_t>(STAT_PAGE);
+  stats->allocated_large = mi.ordblks;
+  stats->allocated_huge = mi.uordblks;
+  stats->allocated_bins = mi.fsmblks;
+  stats->active = read_stat<size_t>(STAT_PACTIVE, arena) * page_size;
+  stats->dirty = read_stat<size_t>(STAT_PDIRTY, arena) * page_size;
+  stats->mapped = read_stat<size_t>(STAT_MAPPED, arena);
+  stats->retained = read_stat<size_t>(STAT_RETAINED, arena);
+  stats->huge_page = je_huge_page_bytes(arena);
+}
+
+static void get_bin_stats(size_t arena, size_t bin, struct malloc_bin_stats* stats) {
+  struct mallinfo mi = __mallinfo_bin_info(arena, bin);
+  stats->size = read_stat<size_t>(STAT_BIN_SIZE, arena, bin);
+  stats->allocated = mi.ordblks;
+  stats->nmalloc = mi.uordblks;
+  stats->ndalloc = mi.fordblks;
+  stats->regions = read_stat<size_t>(STAT_BIN_CURREGS, arena, bin);
+  stats->capacity = read_stat<size_t>(STAT_BIN_CURRUNS, arena, bin) *
+      read_stat<uint32_t>(STAT_BIN_NREGS, arena, bin);
+  stats->nfills = read_stat<uint64_t>(STAT_BIN_NFILLS, arena, bin);
+  stats->nflushes = read_stat<uint64_t>(STAT_BIN_NFLUSHES, arena, bin);
+}
+
+size_t malloc_stats_narenas() {
+  refresh_stats();
+  return __mallinfo_narenas();
+}
+
+size_t malloc_stats_nbins() {
+  return __mallinfo_nbins();
+}
+
+int malloc_stats_arena(size_t arena, struct malloc_arena_stats* stats) {
+  if (arena >= __mallinfo_narenas()) {
+    errno = EINVAL;
+    return -1;
+  }
+  get_arena_stats(arena, stats);
+  return 0;
+}
+
+int malloc_stats_bins(size_t arena, struct malloc_bin_stats* bins, size_t bin_count) {
+  if (arena >= __mallinfo_narenas()) {
+    errno = EINVAL;
+    return -1;
+  }
+  size_t nbins = __mallinfo_nbins();
+  if (bin_count > nbins) {
+    bin_count = nbins;
+  }
+  for (size_t i = 0; i < bin_count; i++) {
+    get_bin_stats(arena, i, &bins[i]);
+  }
+  return bin_count;
+}
+
+static size_t total_dirty_bytes() {
+  refresh_stats();
+  size_t page_size = read_stat<size_t>(STAT_PAGE);
+  size_t dirty = 0;
+  for (size_t i = 0; i < __mallinfo_narenas(); i++) {
+    dirty += read_stat<size_t>(STAT_PDIRTY, i) * page_size;
+  }
+  return dirty;
+}
+
+size_t malloc_purge() {
+  // Flush first, so that what the cache was holding can be purged too.
+  je_mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+  size_t before = total_dirty_bytes();
+  je_mallopt(M_PURGE, 0);
+  size_t after = total_dirty_bytes();
+  // Other threads may have freed memory in the meantime.
+  return before > after ? before - after : 0;
+}
+
 int malloc_info(int options, FILE* fp) {
   if (options != 0) {
     errno = EINVAL;
     return -1;
   }
 
+  refresh_stats();
+
   Elem root(fp, "malloc", "version=\"jemalloc-1\"");
 
   // Dump all of the large allocations in the arenas.
@@ -70,19 +241,32 @@ int malloc_info(int options, FILE* fp) {
     if (mi.hblkhd != 0) {
       Elem arena_elem(fp, "heap", "nr=\"%d\"", i);
       {
-        Elem(fp, "allocated-large").contents("%zu", mi.ordblks);
-        Elem(fp, "allocated-huge").contents("%zu", mi.uordblks);
-        Elem(fp, "allocated-bins").contents("%zu", mi.fsmblks);
+        struct malloc_arena_stats arena_stats;
+        get_arena_stats(i, &arena_stats);
+        Elem(fp, "allocated-large").contents("%zu", arena_stats.allocated_large);
+        Elem(fp, "allocated-huge").contents("%zu", arena_stats.allocated_huge);
+        Elem(fp, "allocated-bins").contents("%zu", arena_stats.allocated_bins);
+        Elem(fp, "active").contents("%zu", arena_stats.active);
+        Elem(fp, "dirty").contents("%zu", arena_stats.dirty);
+        Elem(fp, "mapped").contents("%zu", arena_stats.mapped);
+        Elem(fp, "retained").contents("%zu", arena_stats.retained);
+        Elem(fp, "huge-page").contents("%zu", arena_stats.huge_page);
 
         size_t total = 0;
         for (size_t j = 0; j < __mallinfo_nbins(); j++) {
-          struct mallinfo mi = __mallinfo_bin_info(i, j);
-          if (mi.ordblks != 0) {
+          struct malloc_bin_stats bin_stats;
+          get_bin_stats(i, j, &bin_stats);
+          if (bin_stats.allocated != 0) {
             Elem bin_elem(fp, "bin", "nr=\"%d\"", j);
-            Elem(fp, "allocated").contents("%zu", mi.ordblks);
-            Elem(fp, "nmalloc").contents("%zu", mi.uordblks);
-            Elem(fp, "ndalloc").contents("%zu", mi.fordblks);
-            total += mi.ordblks;
+            Elem(fp, "size").contents("%zu", bin_stats.size);
+            Elem(fp, "allocated").contents("%zu", bin_stats.allocated);
+            Elem(fp, "nmalloc").contents("%" PRIu64, bin_stats.nmalloc);
+            Elem(fp, "ndalloc").contents("%" PRIu64, bin_stats.ndalloc);
+            Elem(fp, "regions").contents("%zu", bin_stats.regions);
+            Elem(fp, "capacity").contents("%zu", bin_stats.capacity);
+            Elem(fp, "nfills").contents("%" PRIu64, bin_stats.nfills);
+            Elem(fp, "nflushes").contents("%" PRIu64, bin_stats.nflushes);
+            total += bin_stats.allocated;
           }
         }
         Elem(fp, "bins-total").contents("%zu", total);
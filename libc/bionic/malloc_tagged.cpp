@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// An allocator mode for arm64 that puts a random, non-zero 8-bit tag in the
+// top byte of every pointer it returns. The cpu ignores the top byte when
+// the pointer is dereferenced (top-byte-ignore), so the program can't tell.
+// The tag is also stored in the last usable byte of the allocation, and
+// free, realloc and malloc_usable_size check that the two match before
+// handing the allocation to jemalloc. free clears the stored tag, so a
+// double free, or a free through a stale pointer after the memory has been
+// reused, is caught with a probability of 254 in 255, for the price of one
+// byte per allocation and a couple of loads per call. That's cheap enough
+// to leave on in production, unlike malloc debug's free_track.
+//
+// Pointers with no tag were allocated before this mode was set up, and go
+// straight to jemalloc.
+//
+// Checking every access in hardware (MTE) would also need the heap to be
+// mapped PROT_MTE, which jemalloc doesn't do, so only the software check
+// is done here.
+
+#include "malloc_tagged.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+
+#include "jemalloc.h"
+#include "private/bionic_prctl.h"
+#include "private/libc_logging.h"
+#include "pthread_internal.h"
+
+#if defined(__aarch64__)
+
+static constexpr int kTagShift = 56;
+static constexpr uintptr_t kAddressMask = (static_cast<uintptr_t>(1) << kTagShift) - 1;
+
+static uint32_t g_tag_seed;
+
+static uint8_t PointerTag(const void* mem) {
+  return reinterpret_cast<uintptr_t>(mem) >> kTagShift;
+}
+
+static void* Untag(const void* mem) {
+  return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(mem) & kAddressMask);
+}
+
+// A per-thread xorshift generator: there's no lock or shared cache line to
+// fight over, and the tags only need to be hard to predict, not secret.
+static uint8_t NextTag() {
+  pthread_internal_t* thread = __get_thread();
+  uint32_t x = thread->malloc_tag_state;
+  if (x == 0) {
+    x = (g_tag_seed ^ static_cast<uint32_t>(thread->tid)) | 1;
+  }
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  thread->malloc_tag_state = x;
+  uint8_t tag = x >> 24;
+  return (tag != 0) ? tag : 1;
+}
+
+// Room for the stored tag.
+static bool AddTagByte(size_t* bytes) {
+  if (__builtin_add_overflow(*bytes, 1, bytes)) {
+    errno = ENOMEM;
+    return false;
+  }
+  return true;
+}
+
+static void* TagAllocation(void* p) {
+  if (p == nullptr) {
+    return nullptr;
+  }
+  uint8_t tag = NextTag();
+  static_cast<uint8_t*>(p)[je_malloc_usable_size(p) - 1] = tag;
+  return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(p) |
+                                 (static_cast<uintptr_t>(tag) << kTagShift));
+}
+
+// Returns where the tag of the untagged allocation p is stored, aborting if
+// it isn't the tag the caller's pointer had.
+static uint8_t* CheckedTagByte(void* p, uint8_t tag, const char* function) {
+  size_t usable = je_malloc_usable_size(p);
+  uint8_t* tag_byte = static_cast<uint8_t*>(p) + usable - 1;
+  if (usable == 0 || *tag_byte != tag) {
+    __libc_fatal("%s: pointer tag mismatch for %p (double free or use after free?)", function,
+                 reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(p) |
+                                         (static_cast<uintptr_t>(tag) << kTagShift)));
+  }
+  return tag_byte;
+}
+
+static void* tagged_malloc(size_t bytes) {
+  if (!AddTagByte(&bytes)) {
+    return nullptr;
+  }
+  return TagAllocation(je_malloc(bytes));
+}
+
+static void* tagged_calloc(size_t n_elements, size_t elem_size) {
+  size_t bytes;
+  if (__builtin_mul_overflow(n_elements, elem_size, &bytes)) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  if (!AddTagByte(&bytes)) {
+    return nullptr;
+  }
+  return TagAllocation(je_calloc(1, bytes));
+}
+
+static void* tagged_memalign(size_t alignment, size_t bytes) {
+  if (!AddTagByte(&bytes)) {
+    return nullptr;
+  }
+  return TagAllocation(je_memalign(alignment, bytes));
+}
+
+static int tagged_posix_memalign(void** memptr, size_t alignment, size_t size) {
+  if (!AddTagByte(&size)) {
+    return ENOMEM;
+  }
+  int result = je_posix_memalign(memptr, alignment, size);
+  if (result == 0) {
+    *memptr = TagAllocation(*memptr);
+  }
+  return result;
+}
+
+static void tagged_free(void* mem) {
+  uint8_t tag = PointerTag(mem);
+  if (tag == 0) {
+    je_free(mem);
+    return;
+  }
+  void* p = Untag(mem);
+  *CheckedTagByte(p, tag, "free") = 0;
+  je_free(p);
+}
+
+static void* tagged_realloc(void* old_mem, size_t bytes) {
+  if (old_mem == nullptr) {
+    return tagged_malloc(bytes);
+  }
+  if (bytes == 0) {
+    tagged_free(old_mem);
+    return nullptr;
+  }
+  if (!AddTagByte(&bytes)) {
+    return nullptr;
+  }
+
+  uint8_t tag = PointerTag(old_mem);
+  if (tag == 0) {
+    return TagAllocation(je_realloc(old_mem, bytes));
+  }
+  void* p = Untag(old_mem);
+  uint8_t* tag_byte = CheckedTagByte(p, tag, "realloc");
+  // Clear the tag first, in case the allocation moves, so that the old
+  // pointer can't be freed again.
+  *tag_byte = 0;
+  void* new_mem = je_realloc(p, bytes);
+  if (new_mem == nullptr) {
+    *tag_byte = tag;
+    return nullptr;
+  }
+  return TagAllocation(new_mem);
+}
+
+static size_t tagged_malloc_usable_size(const void* mem) {
+  uint8_t tag = PointerTag(mem);
+  if (tag == 0) {
+    return je_malloc_usable_size(mem);
+  }
+  void* p = Untag(mem);
+  CheckedTagByte(p, tag, "malloc_usable_size");
+  return je_malloc_usable_size(p) - 1;
+}
+
+bool __libc_malloc_tagged_init(MallocDispatch* table) {
+  // Without this, the kernel fails system calls that are passed a tagged
+  // pointer with EFAULT.
+  if (prctl(PR_SET_TAGGED_ADDR_CTRL, PR_TAGGED_ADDR_ENABLE, 0, 0, 0) != 0) {
+    return false;
+  }
+  g_tag_seed = arc4random();
+
+  *table = {};
+  table->calloc = tagged_calloc;
+  table->free = tagged_free;
+  table->malloc = tagged_malloc;
+  table->malloc_usable_size = tagged_malloc_usable_size;
+  table->memalign = tagged_memalign;
+  table->posix_memalign = tagged_posix_memalign;
+  table->realloc = tagged_realloc;
+  return true;
+}
+
+#else
+
+bool __libc_malloc_tagged_init(MallocDispatch*) {
+  // Only arm64 ignores the top byte of a pointer.
+  return false;
+}
+
+#endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2016 The Android Open Source Project
+ * Copyright (C) 2017 The Android Open Source Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -26,30 +26,16 @@
  * SUCH DAMAGE.
  */
 
-#ifndef _PRIVATE_ICU_H
-#define _PRIVATE_ICU_H
+#ifndef LIBC_BIONIC_MALLOC_TAGGED_H_
+#define LIBC_BIONIC_MALLOC_TAGGED_H_
 
-#include <stdint.h>
+#include <sys/cdefs.h>
 
-typedef int8_t UBool;
-typedef int32_t UChar32;
+#include <private/bionic_malloc_dispatch.h>
 
-enum UProperty {
-  UCHAR_ALPHABETIC = 0,
-  UCHAR_LOWERCASE = 22,
-  UCHAR_POSIX_ALNUM = 44,
-  UCHAR_POSIX_BLANK = 45,
-  UCHAR_POSIX_GRAPH = 46,
-  UCHAR_POSIX_PRINT = 47,
-  UCHAR_POSIX_XDIGIT = 48,
-  UCHAR_UPPERCASE = 30,
-  UCHAR_WHITE_SPACE = 31,
-};
+// Sets up the pointer tagging allocator and fills in table with its
+// functions, leaving the rest null. Returns false, leaving table alone, if
+// the cpu or kernel can't support it.
+__LIBC_HIDDEN__ bool __libc_malloc_tagged_init(MallocDispatch* table);
 
-enum UCharCategory {
-  U_CONTROL_CHAR = 15,
-};
-
-void* __find_icu_symbol(const char* symbol_name);
-
-#endif  // _PRIVATE_ICU_H
+#endif // LIBC_BIONIC_MALLOC_TAGGED_H_
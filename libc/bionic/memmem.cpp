@@ -26,34 +26,150 @@
  * SUCH DAMAGE.
  */
 
+#include <stdint.h>
 #include <string.h>
 
+// memmem first looks for positions where both the first and the last byte of the needle
+// match, a word at a time, and only compares the rest of the needle there. That's fast
+// unless the haystack is full of near misses, so it keeps count of how much comparing it
+// has done for nothing, and if that gets out of proportion to how far it has got, it
+// switches to the two-way algorithm, which is linear in the worst case.
+
+typedef unsigned long word_t;
+
+static constexpr word_t kOnes = ~static_cast<word_t>(0) / 0xff;
+static constexpr word_t kLows = kOnes * 0x7f;
+
+static inline word_t load_word(const unsigned char* p) {
+  word_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+// Sets the top bit of each byte of w that's zero, and clears every other bit. Unlike the
+// usual (w - kOnes) & ~w trick, a zero byte doesn't cause false positives above it.
+static inline word_t zero_bytes(word_t w) {
+  return ~(((w & kLows) + kLows) | w | kLows);
+}
+
+// Returns the length of the critical factorization's left half, and sets *period to the
+// period of its right half. The right half starts at the larger of the maximal suffixes
+// for the two orderings of the alphabet [Crochemore & Perrin, "Two-way string-matching"].
+static size_t critical_factorization(const unsigned char* x, size_t m, size_t* period) {
+  size_t split[2];
+  size_t periods[2];
+  for (int reverse = 0; reverse < 2; ++reverse) {
+    // The maximal suffix starts at ms + 1, and is being compared with the suffix at j + 1;
+    // ms starts at -1 as an unsigned value, so that ms + k wraps to k - 1.
+    size_t ms = SIZE_MAX;
+    size_t j = 0;
+    size_t k = 1;
+    size_t p = 1;
+    while (j + k < m) {
+      unsigned char a = x[j + k];
+      unsigned char b = x[ms + k];
+      if (reverse ? (a > b) : (a < b)) {
+        j += k;
+        k = 1;
+        p = j - ms;
+      } else if (a == b) {
+        if (k != p) {
+          ++k;
+        } else {
+          j += p;
+          k = 1;
+        }
+      } else {
+        ms = j++;
+        k = p = 1;
+      }
+    }
+    split[reverse] = ms + 1;
+    periods[reverse] = p;
+  }
+  int i = (split[1] < split[0]) ? 0 : 1;
+  *period = periods[i];
+  return split[i];
+}
+
+static void* two_way(const unsigned char* y, size_t n, const unsigned char* x, size_t m) {
+  size_t period;
+  size_t split = critical_factorization(x, m, &period);
+  size_t j = 0;
+
+  if (memcmp(x, x + period, split) == 0) {
+    // The needle is periodic. After matching the right half and failing on the left, the
+    // next possible match is a period on, and the first m - period bytes of the needle are
+    // already known to match there.
+    size_t memory = 0;
+    while (j <= n - m) {
+      size_t i = (split > memory) ? split : memory;
+      while (i < m && x[i] == y[j + i]) ++i;
+      if (i < m) {
+        j += i - split + 1;
+        memory = 0;
+        continue;
+      }
+      i = split;
+      while (i > memory && x[i - 1] == y[j + i - 1]) --i;
+      if (i <= memory) return const_cast<unsigned char*>(y + j);
+      j += period;
+      memory = m - period;
+    }
+  } else {
+    // The halves don't overlap anywhere, so a mismatch in the left half allows a shift
+    // past whichever half is longer.
+    size_t shift = ((split > m - split) ? split : m - split) + 1;
+    while (j <= n - m) {
+      size_t i = split;
+      while (i < m && x[i] == y[j + i]) ++i;
+      if (i < m) {
+        j += i - split + 1;
+        continue;
+      }
+      i = split;
+      while (i > 0 && x[i - 1] == y[j + i - 1]) --i;
+      if (i == 0) return const_cast<unsigned char*>(y + j);
+      j += shift;
+    }
+  }
+  return nullptr;
+}
+
 void* memmem(const void* void_haystack, size_t n, const void* void_needle, size_t m) {
-  const unsigned char* haystack = reinterpret_cast<const unsigned char*>(void_haystack);
-  const unsigned char* needle = reinterpret_cast<const unsigned char*>(void_needle);
+  const unsigned char* y = reinterpret_cast<const unsigned char*>(void_haystack);
+  const unsigned char* x = reinterpret_cast<const unsigned char*>(void_needle);
 
   if (n < m) return nullptr;
 
   if (m == 0) return const_cast<void*>(void_haystack);
-  if (m == 1) return memchr(haystack, needle[0], n);
+  if (m == 1) return memchr(y, x[0], n);
 
-  // This uses the "Not So Naive" algorithm, a very simple but usually effective algorithm.
-  // http://www-igm.univ-mlv.fr/~lecroq/string/
-  const unsigned char* y = haystack;
-  const unsigned char* x = needle;
+  // The positions that can start a match.
+  const size_t last = n - m;
+  const word_t first_bytes = kOnes * x[0];
+  const word_t last_bytes = kOnes * x[m - 1];
+  // Allow as much fruitless comparing as the haystack scanned so far, plus a bit so
+  // that a few early near misses don't trigger the switch to two-way.
+  size_t wasted = 0;
   size_t j = 0;
-  size_t k = 1, l = 2;
 
-  if (x[0] == x[1]) {
-    k = 2;
-    l = 1;
+  while (j + sizeof(word_t) <= last + 1) {
+    word_t hits = zero_bytes((load_word(y + j) ^ first_bytes) |
+                             (load_word(y + j + m - 1) ^ last_bytes));
+    while (hits != 0) {
+      // All of bionic's targets are little-endian.
+      size_t i = j + __builtin_ctzl(hits) / 8;
+      if (memcmp(y + i + 1, x + 1, m - 2) == 0) return const_cast<unsigned char*>(y + i);
+      wasted += m;
+      if (wasted > i + 256) return two_way(y + i, n - i, x, m);
+      hits &= hits - 1;
+    }
+    j += sizeof(word_t);
   }
-  while (j <= n-m) {
-    if (x[1] != y[j+1]) {
-      j += k;
-    } else {
-      if (!memcmp(x+2, y+j+2, m-2) && x[0] == y[j]) return const_cast<unsigned char*>(&y[j]);
-      j += l;
+  for (; j <= last; ++j) {
+    if (y[j] == x[0] && y[j + m - 1] == x[m - 1] && memcmp(y + j + 1, x + 1, m - 2) == 0) {
+      return const_cast<unsigned char*>(y + j);
     }
   }
   return nullptr;
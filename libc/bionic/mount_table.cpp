@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/mount_table.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+
+// The text of /proc/self/mountinfo, split into strings in place, and the
+// entries pointing into it. A table has two, so that a failed refresh leaves
+// the previous entries intact; once they've grown to fit, refreshing doesn't
+// allocate.
+struct MountTableBuffer {
+  char* text;
+  size_t text_capacity;
+  android_mount_entry* entries;
+  size_t entry_capacity;
+  size_t count;
+};
+
+struct android_mount_table {
+  int fd;
+  unsigned current;
+  MountTableBuffer buffers[2];
+};
+
+static bool mount_table_read(int fd, MountTableBuffer* b, size_t* length) {
+  if (lseek(fd, 0, SEEK_SET) == -1) return false;
+
+  size_t n = 0;
+  while (true) {
+    // Always leave room for a terminating NUL.
+    if (b->text_capacity - n < 2) {
+      size_t capacity = (b->text_capacity == 0) ? 16384 : 2 * b->text_capacity;
+      char* text = static_cast<char*>(realloc(b->text, capacity));
+      if (text == nullptr) return false;
+      b->text = text;
+      b->text_capacity = capacity;
+    }
+    ssize_t rc = TEMP_FAILURE_RETRY(read(fd, b->text + n, b->text_capacity - n - 1));
+    if (rc == -1) return false;
+    if (rc == 0) break;
+    n += rc;
+  }
+  b->text[n] = '\0';
+  *length = n;
+  return true;
+}
+
+// Splits off the next space-separated field.
+static char* next_field(char** cursor) {
+  char* field = *cursor;
+  char* end = strchrnul(field, ' ');
+  *cursor = (*end == ' ') ? end + 1 : end;
+  *end = '\0';
+  return field;
+}
+
+static bool parse_unsigned(const char* s, char terminator, unsigned* result, const char** end) {
+  if (*s < '0' || *s > '9') return false;
+  unsigned value = 0;
+  for (; *s >= '0' && *s <= '9'; ++s) value = value * 10 + (*s - '0');
+  if (*s != terminator) return false;
+  *result = value;
+  *end = s;
+  return true;
+}
+
+// The kernel escapes space, tab, newline and backslash as three octal digits.
+static void unescape(char* s) {
+  char* out = s;
+  while (*s != '\0') {
+    if (s[0] == '\\' && s[1] >= '0' && s[1] <= '3' && s[2] >= '0' && s[2] <= '7' &&
+        s[3] >= '0' && s[3] <= '7') {
+      *out++ = ((s[1] - '0') << 6) | ((s[2] - '0') << 3) | (s[3] - '0');
+      s += 4;
+    } else {
+      *out++ = *s++;
+    }
+  }
+  *out = '\0';
+}
+
+// Lines look like:
+// "36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw,errors=continue".
+static bool parse_line(char* line, android_mount_entry* e) {
+  char* cursor = line;
+  const char* end;
+  unsigned major, minor;
+  if (!parse_unsigned(next_field(&cursor), '\0', &e->mount_id, &end) ||
+      !parse_unsigned(next_field(&cursor), '\0', &e->parent_id, &end)) {
+    return false;
+  }
+  const char* dev = next_field(&cursor);
+  if (!parse_unsigned(dev, ':', &major, &end) || !parse_unsigned(end + 1, '\0', &minor, &end)) {
+    return false;
+  }
+  e->dev = makedev(major, minor);
+
+  char* root = next_field(&cursor);
+  char* mount_point = next_field(&cursor);
+  e->mount_options = next_field(&cursor);
+
+  // Any number of optional fields, ended by a lone "-".
+  if (cursor[0] == '-' && cursor[1] == ' ') {
+    e->propagation = "";
+    cursor += 2;
+  } else {
+    char* separator = strstr(cursor, " - ");
+    if (separator == nullptr) return false;
+    e->propagation = cursor;
+    *separator = '\0';
+    cursor = separator + 3;
+  }
+
+  char* fs_type = next_field(&cursor);
+  char* source = next_field(&cursor);
+  e->super_options = next_field(&cursor);
+  if (*mount_point == '\0' || *fs_type == '\0') return false;
+
+  unescape(root);
+  unescape(mount_point);
+  unescape(fs_type);
+  unescape(source);
+  e->root = root;
+  e->mount_point = mount_point;
+  e->fs_type = fs_type;
+  e->source = source;
+  return true;
+}
+
+static bool mount_table_parse(MountTableBuffer* b, size_t length) {
+  char* text = b->text;
+  char* text_end = text + length;
+
+  size_t lines = 0;
+  for (char* p = text; p < text_end; ++lines) {
+    char* eol = static_cast<char*>(memchr(p, '\n', text_end - p));
+    p = (eol == nullptr) ? text_end : eol + 1;
+  }
+  if (lines > b->entry_capacity) {
+    void* entries = realloc(b->entries, lines * sizeof(android_mount_entry));
+    if (entries == nullptr) return false;
+    b->entries = static_cast<android_mount_entry*>(entries);
+    b->entry_capacity = lines;
+  }
+
+  b->count = 0;
+  for (char* p = text; p < text_end; ) {
+    char* eol = static_cast<char*>(memchr(p, '\n', text_end - p));
+    char* next = (eol == nullptr) ? text_end : eol + 1;
+    if (eol != nullptr) *eol = '\0';
+    // The kernel doesn't write malformed lines, but skip rather than trust them.
+    if (parse_line(p, &b->entries[b->count])) ++b->count;
+    p = next;
+  }
+  return true;
+}
+
+static bool mount_table_load(android_mount_table* table) {
+  MountTableBuffer* spare = &table->buffers[table->current ^ 1];
+  size_t length;
+  if (!mount_table_read(table->fd, spare, &length) || !mount_table_parse(spare, length)) {
+    return false;
+  }
+  table->current ^= 1;
+  return true;
+}
+
+android_mount_table* android_mount_table_open() {
+  android_mount_table* table =
+      static_cast<android_mount_table*>(calloc(1, sizeof(android_mount_table)));
+  if (table == nullptr) return nullptr;
+
+  // The kernel notes the mount namespace's event count when the file is opened,
+  // and poll reports POLLPRI once it differs (updating the note as it does), so
+  // anything that changes after this is seen by android_mount_table_refresh.
+  table->fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+  if (table->fd == -1 || !mount_table_load(table)) {
+    android_mount_table_close(table);
+    return nullptr;
+  }
+  return table;
+}
+
+int android_mount_table_refresh(android_mount_table* table) {
+  pollfd pfd = { table->fd, POLLPRI, 0 };
+  if (TEMP_FAILURE_RETRY(poll(&pfd, 1, 0)) == -1) return -1;
+  if ((pfd.revents & POLLPRI) == 0) return 0;
+  return mount_table_load(table) ? 1 : -1;
+}
+
+int android_mount_table_fd(const android_mount_table* table) {
+  return table->fd;
+}
+
+const android_mount_entry* android_mount_table_entries(const android_mount_table* table,
+                                                       size_t* count) {
+  const MountTableBuffer& b = table->buffers[table->current];
+  *count = b.count;
+  return b.entries;
+}
+
+const android_mount_entry* android_mount_table_find(const android_mount_table* table,
+                                                    const char* path) {
+  const MountTableBuffer& b = table->buffers[table->current];
+  const android_mount_entry* result = nullptr;
+  size_t result_length = 0;
+  for (size_t i = 0; i < b.count; ++i) {
+    const android_mount_entry* e = &b.entries[i];
+    size_t length = strlen(e->mount_point);
+    if (strncmp(path, e->mount_point, length) != 0) continue;
+    // "/data" is a prefix of "/data/media" but not of "/database", and "/" is a prefix of anything.
+    if (path[length] != '\0' && path[length] != '/' && !(length == 1 && *e->mount_point == '/')) {
+      continue;
+    }
+    // A later mount on the same point hides the earlier ones, so prefer it on ties.
+    if (result == nullptr || length >= result_length) {
+      result = e;
+      result_length = length;
+    }
+  }
+  return result;
+}
+
+void android_mount_table_close(android_mount_table* table) {
+  if (table == nullptr) return;
+  ErrnoRestorer errno_restorer;
+  if (table->fd != -1) close(table->fd);
+  for (MountTableBuffer& b : table->buffers) {
+    free(b.text);
+    free(b.entries);
+  }
+  free(table);
+}
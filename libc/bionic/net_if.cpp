@@ -93,34 +93,20 @@ struct if_list {
   }
 };
 
-static void __if_nameindex_callback(void* context, nlmsghdr* hdr) {
+static void __if_nameindex_callback(void* context, unsigned index, const char* name) {
   if_list** list = reinterpret_cast<if_list**>(context);
-  if (hdr->nlmsg_type == RTM_NEWLINK) {
-    ifinfomsg* ifi = reinterpret_cast<ifinfomsg*>(NLMSG_DATA(hdr));
-
-    // Create a new entry and set the interface index.
-    if_list* new_link = new if_list(list);
-    new_link->data.if_index = ifi->ifi_index;
-
-    // Go through the various bits of information and find the name.
-    rtattr* rta = IFLA_RTA(ifi);
-    size_t rta_len = IFLA_PAYLOAD(hdr);
-    while (RTA_OK(rta, rta_len)) {
-      if (rta->rta_type == IFLA_IFNAME) {
-        new_link->data.if_name = strndup(reinterpret_cast<char*>(RTA_DATA(rta)), RTA_PAYLOAD(rta));
-      }
-      rta = RTA_NEXT(rta, rta_len);
-    }
-  }
+
+  // Create a new entry and set the interface index and name.
+  if_list* new_link = new if_list(list);
+  new_link->data.if_index = index;
+  new_link->data.if_name = (name != nullptr) ? strdup(name) : nullptr;
 }
 
 struct if_nameindex* if_nameindex() {
   if_list* list = nullptr;
 
-  // Open the netlink socket and ask for all the links;
-  NetlinkConnection nc;
-  bool okay = nc.SendRequest(RTM_GETLINK) && nc.ReadResponses(__if_nameindex_callback, &list);
-  if (!okay) {
+  // Share getifaddrs' dump of the links, which is only redone when they change.
+  if (!__getifaddrs_links(__if_nameindex_callback, &list)) {
     if_list::Free(list, true);
     return nullptr;
   }
@@ -131,17 +117,18 @@ struct if_nameindex* if_nameindex() {
     ++interface_count;
   }
 
-  // Build the array POSIX requires us to return.
+  // Build the array POSIX requires us to return, in the order we were given
+  // the interfaces (`list` is in reverse).
   struct if_nameindex* result = new struct if_nameindex[interface_count + 1];
   if (result) {
-    struct if_nameindex* out = result;
+    struct if_nameindex* out = result + interface_count;
+    out->if_index = 0;
+    out->if_name = nullptr;
     for (if_list* it = list; it != nullptr; it = it->next) {
+      --out;
       out->if_index = it->data.if_index;
       out->if_name = it->data.if_name;
-      ++out;
     }
-    out->if_index = 0;
-    out->if_name = nullptr;
   }
 
   // Free temporary storage.
@@ -55,18 +55,45 @@ extern "C" int __timer_settime(__kernel_timer_t, int, const itimerspec*, itimers
 // reason to use anything else, we use that too.
 static const int TIMER_SIGNAL = (__SIGRTMIN + 0);
 
+struct TimerDispatcher;
+
 struct PosixTimer {
   __kernel_timer_t kernel_timer_id;
 
   int sigev_notify;
 
-  // The fields below are only needed for a SIGEV_THREAD timer.
+  // The fields below are only needed for a SIGEV_THREAD or SIGEV_ANDROID_SHARED_THREAD timer.
   pthread_t callback_thread;
   void (*callback)(sigval_t);
   sigval_t callback_argument;
   atomic_bool deleted;  // Set when the timer is deleted, to prevent further calling of callback.
+
+  // The fields below are only needed for a SIGEV_ANDROID_SHARED_THREAD timer.
+  TimerDispatcher* dispatcher;
+  PosixTimer* next_deleted;
 };
 
+// SIGEV_ANDROID_SHARED_THREAD timers share a few threads rather than having one each.
+// Each timer's kernel timer signals one particular dispatcher thread, with the PosixTimer
+// as the signal's value, so a timer's callbacks are run one at a time, in order. New
+// timers go to the dispatcher with the fewest, and a new dispatcher is only started
+// when every existing one already has a timer.
+//
+// A deleted timer can't be freed by timer_delete, since its dispatcher may be about to
+// run its callback. Instead it's queued for the dispatcher, which is sent a signal of
+// its own: once that arrives, the dispatcher has seen every signal the timer sent.
+static constexpr size_t kMaxTimerDispatchers = 4;
+
+struct TimerDispatcher {
+  pthread_t thread;
+  size_t timer_count;
+  PosixTimer* deleted;  // Linked by next_deleted; freed by the thread.
+};
+
+static pthread_mutex_t g_timer_dispatchers_lock = PTHREAD_MUTEX_INITIALIZER;
+static TimerDispatcher g_timer_dispatchers[kMaxTimerDispatchers];
+static size_t g_timer_dispatcher_count;
+
 static __kernel_timer_t to_kernel_timer_id(timer_t timer) {
   return reinterpret_cast<PosixTimer*>(timer)->kernel_timer_id;
 }
@@ -107,6 +134,151 @@ static void __timer_thread_stop(PosixTimer* timer) {
   pthread_kill(timer->callback_thread, TIMER_SIGNAL);
 }
 
+static void* __timer_dispatcher_start(void* arg) {
+  TimerDispatcher* dispatcher = reinterpret_cast<TimerDispatcher*>(arg);
+
+  kernel_sigset_t sigset;
+  sigaddset(sigset.get(), TIMER_SIGNAL);
+
+  while (true) {
+    siginfo_t si;
+    memset(&si, 0, sizeof(si));
+    int rc = __rt_sigtimedwait(sigset.get(), &si, NULL, sizeof(sigset));
+    if (rc == -1) {
+      continue;
+    }
+
+    if (si.si_code == SI_TIMER) {
+      PosixTimer* timer = reinterpret_cast<PosixTimer*>(si.si_value.sival_ptr);
+      if (atomic_load(&timer->deleted) == true) {
+        continue;
+      }
+      timer->callback(timer->callback_argument);
+    } else if (si.si_code == SI_TKILL) {
+      // timer_delete has queued timers for us to free.
+      pthread_mutex_lock(&g_timer_dispatchers_lock);
+      PosixTimer* timer = dispatcher->deleted;
+      dispatcher->deleted = NULL;
+      pthread_mutex_unlock(&g_timer_dispatchers_lock);
+      while (timer != NULL) {
+        PosixTimer* next = timer->next_deleted;
+        free(timer);
+        timer = next;
+      }
+    }
+  }
+}
+
+// The dispatchers don't survive fork, and nor do the parent's timers.
+static void __timer_dispatchers_fork_prepare() {
+  pthread_mutex_lock(&g_timer_dispatchers_lock);
+}
+
+static void __timer_dispatchers_fork_parent() {
+  pthread_mutex_unlock(&g_timer_dispatchers_lock);
+}
+
+static void __timer_dispatchers_fork_child() {
+  memset(g_timer_dispatchers, 0, sizeof(g_timer_dispatchers));
+  g_timer_dispatcher_count = 0;
+  pthread_mutex_unlock(&g_timer_dispatchers_lock);
+}
+
+static void __timer_dispatchers_init() {
+  pthread_atfork(__timer_dispatchers_fork_prepare, __timer_dispatchers_fork_parent,
+                 __timer_dispatchers_fork_child);
+}
+
+// Picks the dispatcher for a new timer, starting one if need be. Returns NULL and sets
+// errno if there's none to be had.
+static TimerDispatcher* __timer_dispatcher_take() {
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once(&once, __timer_dispatchers_init);
+
+  pthread_mutex_lock(&g_timer_dispatchers_lock);
+  TimerDispatcher* dispatcher = NULL;
+  for (size_t i = 0; i < g_timer_dispatcher_count; ++i) {
+    if (dispatcher == NULL || g_timer_dispatchers[i].timer_count < dispatcher->timer_count) {
+      dispatcher = &g_timer_dispatchers[i];
+    }
+  }
+
+  if ((dispatcher == NULL || dispatcher->timer_count > 0) &&
+      g_timer_dispatcher_count < kMaxTimerDispatchers) {
+    TimerDispatcher* new_dispatcher = &g_timer_dispatchers[g_timer_dispatcher_count];
+
+    pthread_attr_t thread_attributes;
+    pthread_attr_init(&thread_attributes);
+    pthread_attr_setdetachstate(&thread_attributes, PTHREAD_CREATE_DETACHED);
+
+    // As for a SIGEV_THREAD timer's thread, the dispatcher inherits TIMER_SIGNAL blocked.
+    kernel_sigset_t sigset;
+    sigaddset(sigset.get(), TIMER_SIGNAL);
+    kernel_sigset_t old_sigset;
+    pthread_sigmask(SIG_BLOCK, sigset.get(), old_sigset.get());
+
+    int rc = pthread_create(&new_dispatcher->thread, &thread_attributes,
+                            __timer_dispatcher_start, new_dispatcher);
+
+    pthread_sigmask(SIG_SETMASK, old_sigset.get(), NULL);
+
+    if (rc == 0) {
+      char name[16]; // 16 is the kernel-imposed limit.
+      snprintf(name, sizeof(name), "POSIX timers %zu", g_timer_dispatcher_count);
+      pthread_setname_np(new_dispatcher->thread, name);
+      ++g_timer_dispatcher_count;
+      dispatcher = new_dispatcher;
+    } else if (dispatcher == NULL) {
+      pthread_mutex_unlock(&g_timer_dispatchers_lock);
+      errno = rc;
+      return NULL;
+    }
+  }
+
+  ++dispatcher->timer_count;
+  pthread_mutex_unlock(&g_timer_dispatchers_lock);
+  return dispatcher;
+}
+
+// Hands a timer whose kernel timer has been deleted back to its dispatcher, to be freed.
+static void __timer_dispatcher_release(PosixTimer* timer) {
+  atomic_store(&timer->deleted, true);
+
+  TimerDispatcher* dispatcher = timer->dispatcher;
+  pthread_mutex_lock(&g_timer_dispatchers_lock);
+  --dispatcher->timer_count;
+  timer->next_deleted = dispatcher->deleted;
+  dispatcher->deleted = timer;
+  pthread_t thread = dispatcher->thread;
+  pthread_mutex_unlock(&g_timer_dispatchers_lock);
+
+  pthread_kill(thread, TIMER_SIGNAL);
+}
+
+// Creates the kernel timer for a SIGEV_ANDROID_SHARED_THREAD timer.
+static int __timer_create_shared(clockid_t clock_id, const sigevent* evp, PosixTimer* timer) {
+  timer->dispatcher = __timer_dispatcher_take();
+  if (timer->dispatcher == NULL) {
+    free(timer);
+    return -1;
+  }
+
+  sigevent se = *evp;
+  se.sigev_value.sival_ptr = timer;
+  se.sigev_signo = TIMER_SIGNAL;
+  se.sigev_notify = SIGEV_THREAD_ID;
+  se.sigev_notify_thread_id = pthread_gettid_np(timer->dispatcher->thread);
+  if (__timer_create(clock_id, &se, &timer->kernel_timer_id) == -1) {
+    // There's no kernel timer to have sent the dispatcher anything, so we can free this now.
+    pthread_mutex_lock(&g_timer_dispatchers_lock);
+    --timer->dispatcher->timer_count;
+    pthread_mutex_unlock(&g_timer_dispatchers_lock);
+    free(timer);
+    return -1;
+  }
+  return 0;
+}
+
 // http://pubs.opengroup.org/onlinepubs/9699919799/functions/timer_create.html
 int timer_create(clockid_t clock_id, sigevent* evp, timer_t* timer_id) {
   PosixTimer* timer = reinterpret_cast<PosixTimer*>(malloc(sizeof(PosixTimer)));
@@ -117,7 +289,7 @@ int timer_create(clockid_t clock_id, sigevent* evp, timer_t* timer_id) {
   timer->sigev_notify = (evp == NULL) ? SIGEV_SIGNAL : evp->sigev_notify;
 
   // If not a SIGEV_THREAD timer, the kernel can handle it without our help.
-  if (timer->sigev_notify != SIGEV_THREAD) {
+  if (timer->sigev_notify != SIGEV_THREAD && timer->sigev_notify != SIGEV_ANDROID_SHARED_THREAD) {
     if (__timer_create(clock_id, evp, &timer->kernel_timer_id) == -1) {
       free(timer);
       return -1;
@@ -139,6 +311,15 @@ int timer_create(clockid_t clock_id, sigevent* evp, timer_t* timer_id) {
     return -1;
   }
 
+  if (timer->sigev_notify == SIGEV_ANDROID_SHARED_THREAD) {
+    // sigev_notify_attributes is ignored: the threads are shared.
+    if (__timer_create_shared(clock_id, evp, timer) == -1) {
+      return -1;
+    }
+    *timer_id = timer;
+    return 0;
+  }
+
   // Create this timer's thread.
   pthread_attr_t thread_attributes;
   if (evp->sigev_notify_attributes == NULL) {
@@ -195,6 +376,9 @@ int timer_delete(timer_t id) {
   if (timer->sigev_notify == SIGEV_THREAD) {
     // Stopping the timer's thread frees the timer data when it's safe.
     __timer_thread_stop(timer);
+  } else if (timer->sigev_notify == SIGEV_ANDROID_SHARED_THREAD) {
+    // As does its dispatcher, for a timer sharing one.
+    __timer_dispatcher_release(timer);
   } else {
     // For timers without threads, we can just free right away.
     free(timer);
@@ -27,10 +27,15 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <time.h>
 
+#include "private/bionic_constants.h"
 #include "private/bionic_macros.h"
+#include "private/bionic_work_queue.h"
+#include "private/libc_logging.h"
 
 struct atfork_t {
   atfork_t* next;
@@ -113,6 +118,79 @@ class atfork_list_t {
 static pthread_mutex_t g_atfork_list_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 static atfork_list_t g_atfork_list;
 
+// Handlers can make fork() slow: jemalloc's prepare handler, for example, takes
+// every arena and bin lock. Setting LIBC_ATFORK_TRACE to a number of
+// microseconds makes fork() log each handler that runs for at least that long,
+// and the total for each phase if that's over the limit too.
+static uint64_t g_atfork_trace_ns;
+
+#define ATFORK_TRACE_MAX_SLOW 8
+
+struct atfork_trace_t {
+  uint64_t total_ns;
+  size_t slow_count;
+  struct {
+    void (*handler)(void);
+    uint64_t ns;
+  } slow[ATFORK_TRACE_MAX_SLOW];
+};
+
+// Protected by g_atfork_list_mutex.
+static atfork_trace_t g_atfork_trace;
+
+static uint64_t atfork_now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * NS_PER_S + ts.tv_nsec;
+}
+
+static void atfork_call(void (*handler)(void)) {
+  if (__predict_true(g_atfork_trace_ns == 0)) {
+    handler();
+    return;
+  }
+
+  uint64_t start = atfork_now_ns();
+  handler();
+  uint64_t ns = atfork_now_ns() - start;
+  g_atfork_trace.total_ns += ns;
+  if (ns >= g_atfork_trace_ns && g_atfork_trace.slow_count < ATFORK_TRACE_MAX_SLOW) {
+    g_atfork_trace.slow[g_atfork_trace.slow_count].handler = handler;
+    g_atfork_trace.slow[g_atfork_trace.slow_count].ns = ns;
+    ++g_atfork_trace.slow_count;
+  }
+}
+
+// Takes what's been traced so far out of g_atfork_trace, so the caller must still hold
+// g_atfork_list_mutex. It's logged by atfork_log_trace once the lock is dropped, so
+// that other threads' fork and pthread_atfork calls don't wait on the logging.
+static atfork_trace_t atfork_take_trace() {
+  atfork_trace_t trace = g_atfork_trace;
+  g_atfork_trace.total_ns = 0;
+  g_atfork_trace.slow_count = 0;
+  return trace;
+}
+
+static void atfork_log_trace(const char* phase, const atfork_trace_t& trace) {
+  for (size_t i = 0; i < trace.slow_count; ++i) {
+    __libc_format_log(ANDROID_LOG_WARN, "libc", "fork: %s handler %p took %" PRIu64 "us",
+                      phase, trace.slow[i].handler, trace.slow[i].ns / 1000);
+  }
+  if (trace.total_ns >= g_atfork_trace_ns) {
+    __libc_format_log(ANDROID_LOG_WARN, "libc", "fork: %s handlers took %" PRIu64 "us in total",
+                      phase, trace.total_ns / 1000);
+  }
+}
+
+void __bionic_atfork_init_trace() {
+  const char* limit = getenv("LIBC_ATFORK_TRACE");
+  if (limit != nullptr) {
+    // Anything that isn't a positive number leaves tracing off.
+    long us = strtol(limit, nullptr, 10);
+    if (us > 0) g_atfork_trace_ns = static_cast<uint64_t>(us) * 1000;
+  }
+}
+
 void __bionic_atfork_run_prepare() {
   // We lock the atfork list here, unlock it in the parent, and reset it in the child.
   // This ensures that nobody can modify the handler array between the calls
@@ -124,31 +202,53 @@ void __bionic_atfork_run_prepare() {
   // handlers, so we iterate backwards.
   g_atfork_list.walk_backwards([](atfork_t* it) {
     if (it->prepare != nullptr) {
-      it->prepare();
+      atfork_call(it->prepare);
     }
   });
+
+  // libc's own fork handlers run after the user's prepare handlers, which may still
+  // want to use the things they protect, and before the user's parent and child handlers.
+  __work_queue_fork_prepare();
 }
 
 void __bionic_atfork_run_child() {
+  __work_queue_fork_child();
+
   g_atfork_list_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
   pthread_mutex_lock(&g_atfork_list_mutex);
+  // The parent reports on the prepare handlers.
+  atfork_take_trace();
   g_atfork_list.walk_forward([](atfork_t* it) {
     if (it->child != nullptr) {
-      it->child();
+      atfork_call(it->child);
     }
   });
+  atfork_trace_t child_trace = atfork_take_trace();
   pthread_mutex_unlock(&g_atfork_list_mutex);
+
+  if (__predict_false(g_atfork_trace_ns != 0)) {
+    atfork_log_trace("child", child_trace);
+  }
 }
 
 void __bionic_atfork_run_parent() {
+  __work_queue_fork_parent();
+
+  atfork_trace_t prepare_trace = atfork_take_trace();
   g_atfork_list.walk_forward([](atfork_t* it) {
     if (it->parent != nullptr) {
-      it->parent();
+      atfork_call(it->parent);
     }
   });
+  atfork_trace_t parent_trace = atfork_take_trace();
 
   pthread_mutex_unlock(&g_atfork_list_mutex);
+
+  if (__predict_false(g_atfork_trace_ns != 0)) {
+    atfork_log_trace("prepare", prepare_trace);
+    atfork_log_trace("parent", parent_trace);
+  }
 }
 
 // __register_atfork is the name used by glibc
@@ -116,7 +116,26 @@ struct pthread_cond_internal_t {
   }
 
 #if defined(__LP64__)
-  char __reserved[44];
+  // Bumped by every broadcast that requeues waiters onto their mutex, so that a waiter
+  // can tell whether it might have been requeued.
+  atomic_uint requeue_count;
+  // The mutex the current waiters are using, and how many of them there are. Only
+  // maintained when can_requeue() is true.
+  char waiter_mutex[sizeof(atomic_uintptr_t)];
+  atomic_uint waiter_count;
+  char __reserved[28];
+
+  // Broadcasts only requeue for conditions that aren't process-shared, since waiter_mutex
+  // is an address in the waiter's process. pthread_cond_t is only 4-byte aligned, so
+  // waiter_mutex can be misaligned for an atomic, and then we don't requeue either.
+  bool can_requeue() {
+    return !process_shared() &&
+        (reinterpret_cast<uintptr_t>(waiter_mutex) % alignof(atomic_uintptr_t)) == 0;
+  }
+
+  atomic_uintptr_t* waiter_mutex_ptr() {
+    return reinterpret_cast<atomic_uintptr_t*>(waiter_mutex);
+  }
 #endif
 };
 
@@ -140,6 +159,13 @@ int pthread_cond_init(pthread_cond_t* cond_interface, const pthread_condattr_t*
     init_state = (*attr & COND_FLAGS_MASK);
   }
   atomic_init(&cond->state, init_state);
+#if defined(__LP64__)
+  atomic_init(&cond->requeue_count, 0);
+  atomic_init(&cond->waiter_count, 0);
+  if (cond->can_requeue()) {
+    atomic_init(cond->waiter_mutex_ptr(), 0);
+  }
+#endif
 
   return 0;
 }
@@ -164,7 +190,35 @@ static int __pthread_cond_pulse(pthread_cond_internal_t* cond, int thread_count)
   // synchronization. And it doesn't help even if we use any fence here.
 
   // The increase of value should leave flags alone, even if the value can overflows.
-  atomic_fetch_add_explicit(&cond->state, COND_COUNTER_STEP, memory_order_relaxed);
+  unsigned int new_state =
+      atomic_fetch_add_explicit(&cond->state, COND_COUNTER_STEP, memory_order_relaxed) +
+      COND_COUNTER_STEP;
+
+#if defined(__LP64__)
+  // Waking every waiter of a broadcast just has them all fight over the mutex they're about
+  // to relock, and all but one go straight back to sleep on it. Instead, wake one and move
+  // the rest onto the mutex's futex, where each unlock wakes the next.
+  if (thread_count > 1 && cond->can_requeue()) {
+    // The acquire pairs with the release in __pthread_cond_timedwait, so if we see a waiter
+    // we see its mutex too. While there are waiters, the mutex can't be destroyed.
+    if (atomic_load_explicit(&cond->waiter_count, memory_order_acquire) != 0) {
+      pthread_mutex_t* mutex = reinterpret_cast<pthread_mutex_t*>(
+          atomic_load_explicit(cond->waiter_mutex_ptr(), memory_order_relaxed));
+      void* mutex_futex = __pthread_mutex_requeue_futex(mutex);
+      if (mutex_futex != nullptr) {
+        atomic_fetch_add_explicit(&cond->requeue_count, 1, memory_order_relaxed);
+        // This fails with -EAGAIN if another signal or broadcast changed the state since our
+        // increment, in which case we fall back to waking everyone.
+        if (__futex_cmp_requeue_ex(&cond->state, false, 1, INT_MAX, mutex_futex,
+                                   static_cast<int>(new_state)) >= 0) {
+          return 0;
+        }
+      }
+    }
+  }
+#else
+  (void) new_state;
+#endif
 
   __futex_wake_ex(&cond->state, cond->process_shared(), thread_count);
   return 0;
@@ -178,10 +232,34 @@ static int __pthread_cond_timedwait(pthread_cond_internal_t* cond, pthread_mutex
   }
 
   unsigned int old_state = atomic_load_explicit(&cond->state, memory_order_relaxed);
+#if defined(__LP64__)
+  bool can_requeue = cond->can_requeue();
+  unsigned int old_requeue_count = 0;
+  if (can_requeue) {
+    // We still hold the mutex, so any other current waiters stored the same one.
+    atomic_store_explicit(cond->waiter_mutex_ptr(), reinterpret_cast<uintptr_t>(mutex),
+                          memory_order_relaxed);
+    atomic_fetch_add_explicit(&cond->waiter_count, 1, memory_order_release);
+    old_requeue_count = atomic_load_explicit(&cond->requeue_count, memory_order_relaxed);
+  }
+#endif
   pthread_mutex_unlock(mutex);
   int status = __futex_wait_ex(&cond->state, cond->process_shared(), old_state,
                                use_realtime_clock, abs_timeout_or_null);
+#if defined(__LP64__)
+  if (can_requeue) {
+    if (atomic_load_explicit(&cond->requeue_count, memory_order_relaxed) != old_requeue_count) {
+      __pthread_mutex_lock_after_requeue(mutex);
+    } else {
+      pthread_mutex_lock(mutex);
+    }
+    atomic_fetch_sub_explicit(&cond->waiter_count, 1, memory_order_relaxed);
+  } else {
+    pthread_mutex_lock(mutex);
+  }
+#else
   pthread_mutex_lock(mutex);
+#endif
 
   if (status == -ETIMEDOUT) {
     return ETIMEDOUT;
@@ -35,7 +35,10 @@
 
 #include "pthread_internal.h"
 
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_globals.h"
 #include "private/bionic_macros.h"
+#include "private/bionic_page.h"
 #include "private/bionic_prctl.h"
 #include "private/bionic_ssp.h"
 #include "private/bionic_tls.h"
@@ -56,9 +59,18 @@ void __init_tls(pthread_internal_t* thread) {
   thread->tls[TLS_SLOT_SELF] = thread->tls;
   thread->tls[TLS_SLOT_THREAD_ID] = thread;
 
+  // Reuse the TLS of a thread that has exited if we can. It has already been set up with its
+  // guard pages, and only needs to be cleared back to the state of a fresh mapping.
+  void* allocation = __bionic_tls_cache_take();
+  if (allocation != nullptr) {
+    thread->bionic_tls = reinterpret_cast<bionic_tls*>(static_cast<char*>(allocation) + PAGE_SIZE);
+    memset(thread->bionic_tls, 0, BIONIC_TLS_SIZE);
+    return;
+  }
+
   // Add a guard page before and after.
   size_t allocation_size = BIONIC_TLS_SIZE + 2 * PAGE_SIZE;
-  void* allocation = mmap(nullptr, allocation_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  allocation = mmap(nullptr, allocation_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   if (allocation == MAP_FAILED) {
     __libc_fatal("failed to allocate TLS");
   }
@@ -76,27 +88,75 @@ void __init_thread_stack_guard(pthread_internal_t* thread) {
   thread->tls[TLS_SLOT_STACK_GUARD] = reinterpret_cast<void*>(__stack_chk_guard);
 }
 
-void __init_alternate_signal_stack(pthread_internal_t* thread) {
-  // Create and set an alternate signal stack.
-  void* stack_base = mmap(NULL, SIGNAL_STACK_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
-  if (stack_base != MAP_FAILED) {
+static void* __allocate_alternate_signal_stack() {
+  // Reuse the signal stack of a thread that has exited if we can. Its guard page and
+  // names are already in place.
+  void* stack_base = __signal_stack_cache_take();
+  if (stack_base != NULL) {
+    return stack_base;
+  }
 
-    // Create a guard page to catch stack overflows in signal handlers.
-    if (mprotect(stack_base, PAGE_SIZE, PROT_NONE) == -1) {
-      munmap(stack_base, SIGNAL_STACK_SIZE);
+  stack_base = mmap(NULL, SIGNAL_STACK_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (stack_base == MAP_FAILED) {
+    return NULL;
+  }
+
+  // Create a guard page to catch stack overflows in signal handlers.
+  if (mprotect(stack_base, PAGE_SIZE, PROT_NONE) == -1) {
+    munmap(stack_base, SIGNAL_STACK_SIZE);
+    return NULL;
+  }
+
+  // We can only use const static allocated string for mapped region name, as Android kernel
+  // uses the string pointer directly when dumping /proc/pid/maps.
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, reinterpret_cast<uint8_t*>(stack_base) + PAGE_SIZE,
+        SIGNAL_STACK_SIZE - PAGE_SIZE, "thread signal stack");
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, stack_base, PAGE_SIZE, "thread signal stack guard page");
+  return stack_base;
+}
+
+void __init_alternate_signal_stack(pthread_internal_t* thread) {
+  // Threads whose stack we allocated already have a signal stack in the same mapping.
+  void* stack_base = thread->alternate_signal_stack;
+  if (stack_base == NULL) {
+    stack_base = __allocate_alternate_signal_stack();
+    if (stack_base == NULL) {
       return;
     }
-    stack_t ss;
-    ss.ss_sp = reinterpret_cast<uint8_t*>(stack_base) + PAGE_SIZE;
-    ss.ss_size = SIGNAL_STACK_SIZE - PAGE_SIZE;
-    ss.ss_flags = 0;
-    sigaltstack(&ss, NULL);
-    thread->alternate_signal_stack = stack_base;
-
-    // We can only use const static allocated string for mapped region name, as Android kernel
-    // uses the string pointer directly when dumping /proc/pid/maps.
-    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, ss.ss_sp, ss.ss_size, "thread signal stack");
-    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, stack_base, PAGE_SIZE, "thread signal stack guard page");
+  }
+
+  stack_t ss;
+  ss.ss_sp = reinterpret_cast<uint8_t*>(stack_base) + PAGE_SIZE;
+  ss.ss_size = SIGNAL_STACK_SIZE - PAGE_SIZE;
+  ss.ss_flags = 0;
+  sigaltstack(&ss, NULL);
+  thread->alternate_signal_stack = stack_base;
+}
+
+void __init_rseq(pthread_internal_t* thread) {
+  ErrnoRestorer errno_restorer;
+
+  // The seccomp policy applied to apps predates rseq and traps syscalls it doesn't know
+  // rather than failing them, so only register in processes without a seccomp filter.
+  thread->rseq_area.cpu_id = BIONIC_RSEQ_CPU_ID_REGISTRATION_FAILED;
+  if (prctl(PR_GET_SECCOMP) != 0) {
+    return;
+  }
+
+  thread->rseq_area.cpu_id = BIONIC_RSEQ_CPU_ID_UNINITIALIZED;
+  if (syscall(__NR_rseq, &thread->rseq_area, sizeof(bionic_rseq), 0, BIONIC_RSEQ_SIG) == -1) {
+    // Most likely a kernel without rseq, or someone else registered for this thread first.
+    thread->rseq_area.cpu_id = BIONIC_RSEQ_CPU_ID_REGISTRATION_FAILED;
+  }
+}
+
+void __release_rseq(pthread_internal_t* thread) {
+  // The kernel writes to the area on every return to user space, so it has to be
+  // unregistered before the memory holding it can be unmapped.
+  if (static_cast<int>(thread->rseq_area.cpu_id) >= 0) {
+    ErrnoRestorer errno_restorer;
+    syscall(__NR_rseq, &thread->rseq_area, sizeof(bionic_rseq), BIONIC_RSEQ_FLAG_UNREGISTER,
+            BIONIC_RSEQ_SIG);
   }
 }
 
@@ -158,15 +218,24 @@ static void* __create_thread_mapped_space(size_t mmap_size, size_t stack_guard_s
 static int __allocate_thread(pthread_attr_t* attr, pthread_internal_t** threadp, void** child_stack) {
   size_t mmap_size;
   uint8_t* stack_top;
+  const StaticTlsLayout& static_tls_layout = __libc_tls_globals.static_tls_layout;
+
+  // Only a freshly mmapped pthread_internal_t is known to be zeroed.
+  bool needs_clearing = true;
 
   if (attr->stack_base == NULL) {
-    // The caller didn't provide a stack, so allocate one.
+    // The caller didn't provide a stack, so allocate one, or reuse the one of a thread that
+    // has exited.
     // Make sure the stack size and guard size are multiples of PAGE_SIZE.
-    mmap_size = BIONIC_ALIGN(attr->stack_size + sizeof(pthread_internal_t), PAGE_SIZE);
+    mmap_size = __thread_mapping_size(attr->stack_size);
     attr->guard_size = BIONIC_ALIGN(attr->guard_size, PAGE_SIZE);
-    attr->stack_base = __create_thread_mapped_space(mmap_size, attr->guard_size);
+    attr->stack_base = __thread_stack_cache_take(mmap_size, attr->guard_size);
     if (attr->stack_base == NULL) {
-      return EAGAIN;
+      attr->stack_base = __create_thread_mapped_space(mmap_size, attr->guard_size);
+      if (attr->stack_base == NULL) {
+        return EAGAIN;
+      }
+      needs_clearing = false;
     }
     stack_top = reinterpret_cast<uint8_t*>(attr->stack_base) + mmap_size;
   } else {
@@ -177,18 +246,52 @@ static int __allocate_thread(pthread_attr_t* attr, pthread_internal_t** threadp,
 
   // Mapped space(or user allocated stack) is used for:
   //   pthread_internal_t
+  //   static TLS block (TLS slots and the ELF TLS segments of the libraries loaded at startup)
+  //   signal stack and its guard page (only in space we mapped)
   //   thread stack (including guard page)
 
-  // To safely access the pthread_internal_t and thread stack, we need to find a 16-byte aligned boundary.
+  // To safely access the pthread_internal_t and thread stack, we need to find a 16-byte aligned
+  // boundary that also satisfies the rseq area in pthread_internal_t.
+  static_assert(alignof(pthread_internal_t) >= 16, "the thread stack needs 16-byte alignment");
   stack_top = reinterpret_cast<uint8_t*>(
-                (reinterpret_cast<uintptr_t>(stack_top) - sizeof(pthread_internal_t)) & ~0xf);
+                (reinterpret_cast<uintptr_t>(stack_top) - sizeof(pthread_internal_t)) &
+                ~(alignof(pthread_internal_t) - 1));
 
   pthread_internal_t* thread = reinterpret_cast<pthread_internal_t*>(stack_top);
-  if (mmap_size == 0) {
-    // If thread was not allocated by mmap(), it may not have been cleared to zero.
+  if (needs_clearing) {
+    // If thread was not freshly allocated by mmap(), it may not have been cleared to zero.
     // So assume the worst and zero it.
     memset(thread, 0, sizeof(pthread_internal_t));
   }
+
+  uintptr_t static_tls = (reinterpret_cast<uintptr_t>(stack_top) - static_tls_layout.size()) &
+                         ~(static_tls_layout.alignment() - 1);
+  thread->tls = reinterpret_cast<void**>(static_tls + static_tls_layout.tcb_offset());
+  __init_static_tls(thread->tls);
+  stack_top = reinterpret_cast<uint8_t*>(static_tls & ~(alignof(pthread_internal_t) - 1));
+
+  if (mmap_size != 0) {
+    // Put the signal stack at the top of the thread stack, rather than the bottom where
+    // pthread_getattr_np callers such as ART expect the guard region to be.
+    stack_top = reinterpret_cast<uint8_t*>(PAGE_START(reinterpret_cast<uintptr_t>(stack_top))) -
+                SIGNAL_STACK_SIZE;
+    thread->alternate_signal_stack = stack_top;
+    if (!needs_clearing) {
+      // A fresh mapping; one from the cache has the same layout, so already has this guard.
+      // The signal stack itself isn't named, so that it stays in the same VMA as the
+      // pthread_internal_t.
+      if (mprotect(stack_top, PAGE_SIZE, PROT_NONE) == -1) {
+        __libc_format_log(ANDROID_LOG_WARN, "libc",
+                          "pthread_create failed: couldn't mprotect PROT_NONE signal stack guard page: %s",
+                          strerror(errno));
+        munmap(attr->stack_base, mmap_size);
+        return EAGAIN;
+      }
+      prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, stack_top, PAGE_SIZE,
+            "thread signal stack guard page");
+    }
+  }
+
   attr->stack_size = stack_top - reinterpret_cast<uint8_t*>(attr->stack_base);
 
   thread->mmap_size = mmap_size;
@@ -210,6 +313,7 @@ static int __pthread_start(void* arg) {
   // accesses previously made by the creating thread are visible to us.
   thread->startup_handshake_lock.lock();
 
+  __init_rseq(thread);
   __init_alternate_signal_stack(thread);
 
   void* result = thread->start_routine(thread->start_routine_arg);
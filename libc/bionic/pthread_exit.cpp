@@ -35,6 +35,8 @@
 
 #include "pthread_internal.h"
 
+#include "private/bionic_elf_tls.h"
+
 extern "C" __noreturn void _exit_with_stack_teardown(void*, size_t);
 extern "C" __noreturn void __exit(int);
 extern "C" int __set_tid_address(int*);
@@ -79,6 +81,7 @@ void pthread_exit(void* return_value) {
   // a TLS key, the corresponding value will be set to NULL in this thread's TLS
   // space (see pthread_key_delete).
   pthread_key_clean_all();
+  __pthread_internal_free_key_blocks(thread);
 
   if (thread->alternate_signal_stack != NULL) {
     // Tell the kernel to stop using the alternate signal stack.
@@ -87,14 +90,25 @@ void pthread_exit(void* return_value) {
     ss.ss_flags = SS_DISABLE;
     sigaltstack(&ss, NULL);
 
-    // Free it.
-    munmap(thread->alternate_signal_stack, SIGNAL_STACK_SIZE);
+    // One in the thread's own mapping goes with it. Free any other, or keep it for the next
+    // thread.
+    if (thread->mmap_size == 0 && !__signal_stack_cache_put(thread->alternate_signal_stack)) {
+      munmap(thread->alternate_signal_stack, SIGNAL_STACK_SIZE);
+    }
     thread->alternate_signal_stack = NULL;
   }
 
-  // Unmap the bionic TLS, including guard pages.
+  // Free this thread's blocks of the ELF TLS of dlopen()ed libraries.
+  __free_dynamic_tls(thread->tls);
+
+  // Don't leave this thread's arc4random keystream behind for the next thread.
+  memset(&thread->bionic_tls->arc4random, 0, sizeof(thread->bionic_tls->arc4random));
+
+  // Unmap the bionic TLS, including guard pages, or keep it for the next thread.
   void* allocation = reinterpret_cast<char*>(thread->bionic_tls) - PAGE_SIZE;
-  munmap(allocation, BIONIC_TLS_SIZE + 2 * PAGE_SIZE);
+  if (!__bionic_tls_cache_put(allocation)) {
+    munmap(allocation, BIONIC_TLS_SIZE + 2 * PAGE_SIZE);
+  }
 
   ThreadJoinState old_state = THREAD_NOT_JOINED;
   while (old_state == THREAD_NOT_JOINED &&
@@ -102,15 +116,21 @@ void pthread_exit(void* return_value) {
   }
 
   if (old_state == THREAD_DETACHED) {
+    // pthread_internal_t is freed below with stack, not here.
+    __pthread_internal_remove(thread);
+
+    // We can't reuse our own stack while we're still running on it, but we can hand it to
+    // the stack cache, which won't give it out again until the kernel clears our tid field.
+    if (thread->mmap_size != 0 && __thread_stack_cache_put(thread)) {
+      __exit(0);
+    }
+
     // The thread is detached, no one will use pthread_internal_t after pthread_exit.
     // So we can free mapped space, which includes pthread_internal_t and thread stack.
     // First make sure that the kernel does not try to clear the tid field
     // because we'll have freed the memory before the thread actually exits.
     __set_tid_address(NULL);
 
-    // pthread_internal_t is freed below with stack, not here.
-    __pthread_internal_remove(thread);
-
     if (thread->mmap_size != 0) {
       // We need to free mapped space for detached threads when they exit.
       // That's not something we can do in C.
@@ -121,6 +141,9 @@ void pthread_exit(void* return_value) {
       sigfillset(&mask);
       sigprocmask(SIG_SETMASK, &mask, NULL);
 
+      // The rseq area is in the pthread_internal_t we're about to unmap.
+      __release_rseq(thread);
+
       _exit_with_stack_teardown(thread->attr.stack_base, thread->mmap_size);
     }
   }
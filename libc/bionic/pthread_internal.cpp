@@ -33,13 +33,20 @@
 #include <string.h>
 #include <sys/mman.h>
 
+#include "private/bionic_arc4random_tls.h"
 #include "private/bionic_futex.h"
+#include "private/bionic_globals.h"
+#include "private/bionic_macros.h"
+#include "private/bionic_prctl.h"
 #include "private/bionic_sdk_version.h"
 #include "private/bionic_tls.h"
+#include "private/bionic_tz_memo.h"
 #include "private/libc_logging.h"
 
 static pthread_internal_t* g_thread_list = nullptr;
 static pthread_rwlock_t g_thread_list_lock = PTHREAD_RWLOCK_INITIALIZER;
+// The counters of threads no longer in g_thread_list. Guarded by g_thread_list_lock.
+static libc_thread_stats g_removed_thread_stats;
 
 template <bool write> class ScopedRWLock {
  public:
@@ -75,6 +82,12 @@ pthread_t __pthread_internal_add(pthread_internal_t* thread) {
 void __pthread_internal_remove(pthread_internal_t* thread) {
   ScopedWriteLock locker(&g_thread_list_lock);
 
+  // The thread won't be found in the list any more, so keep what it counted.
+  for (size_t i = 0; i < LIBC_STAT_COUNT; ++i) {
+    g_removed_thread_stats.counters[i] +=
+        __atomic_load_n(&thread->stats.counters[i], __ATOMIC_RELAXED);
+  }
+
   if (thread->next != nullptr) {
     thread->next->prev = thread->prev;
   }
@@ -86,17 +99,226 @@ void __pthread_internal_remove(pthread_internal_t* thread) {
 }
 
 static void __pthread_internal_free(pthread_internal_t* thread) {
-  if (thread->mmap_size != 0) {
+  if (thread->mmap_size != 0 && !__thread_stack_cache_put(thread)) {
     // Free mapped space, including thread stack and pthread_internal_t.
     munmap(thread->attr.stack_base, thread->mmap_size);
   }
 }
 
+// A handful of mappings of a single kind that belonged to threads that have gone away.
+// Entries are handed out LIFO, since the most recently freed memory is the most likely to
+// still be resident.
+class ThreadMappingCache {
+ public:
+  static constexpr size_t kCapacity = 8;
+
+  // For stacks, `thread` is the pthread_internal_t at the top of the mapping. A detached
+  // thread puts its own stack here just before it exits, so the mapping can only be reused
+  // once the kernel has cleared thread->tid (CLONE_CHILD_CLEARTID) to say that the thread
+  // is really gone.
+  bool Put(void* base, pthread_internal_t* thread) {
+    LockGuard guard(lock_);
+    if (count_ == kCapacity) {
+      return false;
+    }
+    entries_[count_].base = base;
+    entries_[count_].thread = thread;
+    ++count_;
+    return true;
+  }
+
+  void* Take() {
+    LockGuard guard(lock_);
+    for (size_t i = count_; i > 0; --i) {
+      Entry& entry = entries_[i - 1];
+      if (entry.thread == nullptr || __atomic_load_n(&entry.thread->tid, __ATOMIC_ACQUIRE) == 0) {
+        void* base = entry.base;
+        entry = entries_[--count_];
+        return base;
+      }
+    }
+    return nullptr;
+  }
+
+  // Another thread may have held the lock when we forked.
+  void ResetAfterFork() {
+    lock_.init(false);
+  }
+
+ private:
+  struct Entry {
+    void* base;
+    pthread_internal_t* thread;
+  };
+
+  struct LockGuard {
+    explicit LockGuard(Lock& lock) : lock(lock) { lock.lock(); }
+    ~LockGuard() { lock.unlock(); }
+    Lock& lock;
+  };
+
+  Lock lock_;
+  size_t count_;
+  Entry entries_[kCapacity];
+};
+
+static ThreadMappingCache g_thread_stack_cache;
+static ThreadMappingCache g_bionic_tls_cache;
+static ThreadMappingCache g_signal_stack_cache;
+
+size_t __thread_mapping_size(size_t stack_size) {
+  // The static TLS layout is fixed once the executable and its dependencies are loaded, so
+  // every thread's mapping of a given stack size is the same size.
+  const StaticTlsLayout& static_tls_layout = __libc_tls_globals.static_tls_layout;
+  size_t static_tls_size = static_tls_layout.size() + static_tls_layout.alignment() - 1;
+  // The signal stack goes in the same mapping, which saves a mapping per thread.
+  return BIONIC_ALIGN(stack_size, PAGE_SIZE) +
+         BIONIC_ALIGN(sizeof(pthread_internal_t) + static_tls_size, PAGE_SIZE) +
+         SIGNAL_STACK_SIZE;
+}
+
+// Only stacks of the default size are cached, which keeps the memory held by the cache
+// bounded, and is what thread-per-task code almost always uses.
+static size_t __default_thread_mmap_size() {
+  return __thread_mapping_size(PTHREAD_STACK_SIZE_DEFAULT);
+}
+
+// A cached stack keeps this much of its top resident, which covers the pthread_internal_t
+// and the shallow stacks most short-lived threads use. Anything deeper is given back to the
+// kernel when the stack is reused.
+static constexpr size_t kCachedStackResidentSize = 64 * 1024;
+
+void* __thread_stack_cache_take(size_t mmap_size, size_t guard_size) {
+  if (mmap_size != __default_thread_mmap_size() || guard_size != PAGE_SIZE) {
+    return nullptr;
+  }
+  void* stack_base = g_thread_stack_cache.Take();
+  if (stack_base != nullptr) {
+    // The previous thread has exited, so nothing can be using its stack any more.
+    uint8_t* stack_bottom = static_cast<uint8_t*>(stack_base) + guard_size;
+    madvise(stack_bottom, mmap_size - guard_size - kCachedStackResidentSize, MADV_DONTNEED);
+  }
+  return stack_base;
+}
+
+bool __thread_stack_cache_put(pthread_internal_t* thread) {
+  if (thread->mmap_size != __default_thread_mmap_size() || thread->attr.guard_size != PAGE_SIZE) {
+    return false;
+  }
+  return g_thread_stack_cache.Put(thread->attr.stack_base, thread);
+}
+
+void* __bionic_tls_cache_take() {
+  return g_bionic_tls_cache.Take();
+}
+
+bool __bionic_tls_cache_put(void* allocation) {
+  return g_bionic_tls_cache.Put(allocation, nullptr);
+}
+
+void* __signal_stack_cache_take() {
+  return g_signal_stack_cache.Take();
+}
+
+bool __signal_stack_cache_put(void* stack_base) {
+  return g_signal_stack_cache.Put(stack_base, nullptr);
+}
+
+void __thread_mapping_caches_reset_after_fork() {
+  g_thread_stack_cache.ResetAfterFork();
+  g_bionic_tls_cache.ResetAfterFork();
+  g_signal_stack_cache.ResetAfterFork();
+}
+
 void __pthread_internal_remove_and_free(pthread_internal_t* thread) {
   __pthread_internal_remove(thread);
   __pthread_internal_free(thread);
 }
 
+// Called by pthread_key_create when it reuses a key slot, so that no thread still holds a
+// value left there for an earlier key.
+void __pthread_internal_clear_key_data(size_t key_index) {
+  ScopedReadLock locker(&g_thread_list_lock);
+  for (pthread_internal_t* t = g_thread_list; t != nullptr; t = t->next) {
+    if (key_index < BIONIC_PTHREAD_KEY_BLOCK_SIZE) {
+      t->key_data[key_index].data = nullptr;
+      continue;
+    }
+    pthread_key_data_t* block = t->key_blocks[key_index / BIONIC_PTHREAD_KEY_BLOCK_SIZE - 1];
+    if (block != nullptr) {
+      block[key_index % BIONIC_PTHREAD_KEY_BLOCK_SIZE].data = nullptr;
+    }
+  }
+}
+
+// Key blocks beyond the first are carved out of pages that are never unmapped, and kept on
+// a free list when their thread exits. malloc can't be used because malloc implementations
+// use pthread keys themselves. Both are only touched with g_thread_list_lock held for writing.
+union key_block_t {
+  key_block_t* next_free;
+  pthread_key_data_t data[BIONIC_PTHREAD_KEY_BLOCK_SIZE];
+};
+
+static key_block_t* g_free_key_blocks = nullptr;
+
+pthread_key_data_t* __pthread_internal_add_key_block(pthread_internal_t* thread, size_t block) {
+  ScopedWriteLock locker(&g_thread_list_lock);
+
+  if (g_free_key_blocks == nullptr) {
+    void* page = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (page == MAP_FAILED) {
+      return nullptr;
+    }
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, page, PAGE_SIZE, "pthread key data");
+    key_block_t* blocks = reinterpret_cast<key_block_t*>(page);
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(key_block_t); ++i) {
+      blocks[i].next_free = g_free_key_blocks;
+      g_free_key_blocks = &blocks[i];
+    }
+  }
+
+  key_block_t* result = g_free_key_blocks;
+  g_free_key_blocks = result->next_free;
+  memset(result, 0, sizeof(key_block_t));
+  thread->key_blocks[block - 1] = result->data;
+  return result->data;
+}
+
+// Called by pthread_exit once the thread's key destructors have run.
+void __pthread_internal_free_key_blocks(pthread_internal_t* thread) {
+  // Most threads never needed any, so don't take the lock for them.
+  bool has_blocks = false;
+  for (size_t i = 0; i < BIONIC_PTHREAD_KEY_BLOCK_COUNT - 1; ++i) {
+    has_blocks |= (thread->key_blocks[i] != nullptr);
+  }
+  if (!has_blocks) {
+    return;
+  }
+
+  ScopedWriteLock locker(&g_thread_list_lock);
+  for (size_t i = 0; i < BIONIC_PTHREAD_KEY_BLOCK_COUNT - 1; ++i) {
+    if (thread->key_blocks[i] != nullptr) {
+      key_block_t* block = reinterpret_cast<key_block_t*>(thread->key_blocks[i]);
+      block->next_free = g_free_key_blocks;
+      g_free_key_blocks = block;
+      thread->key_blocks[i] = nullptr;
+    }
+  }
+}
+
+void __pthread_internal_sum_stats(libc_thread_stats* sum) {
+  ScopedReadLock locker(&g_thread_list_lock);
+  for (size_t i = 0; i < LIBC_STAT_COUNT; ++i) {
+    sum->counters[i] += g_removed_thread_stats.counters[i];
+  }
+  for (pthread_internal_t* t = g_thread_list; t != nullptr; t = t->next) {
+    for (size_t i = 0; i < LIBC_STAT_COUNT; ++i) {
+      sum->counters[i] += __atomic_load_n(&t->stats.counters[i], __ATOMIC_RELAXED);
+    }
+  }
+}
+
 pthread_internal_t* __pthread_internal_find(pthread_t thread_id) {
   pthread_internal_t* thread = reinterpret_cast<pthread_internal_t*>(thread_id);
 
@@ -123,3 +345,15 @@ pthread_internal_t* __pthread_internal_find(pthread_t thread_id) {
   }
   return nullptr;
 }
+
+bionic_tz_memo* __bionic_tz_memo() {
+  pthread_internal_t* thread = __get_thread();
+  if (thread == nullptr || thread->bionic_tls == nullptr) return nullptr;
+  return &thread->bionic_tls->tz_memo;
+}
+
+bionic_arc4random_tls* __bionic_arc4random_tls() {
+  pthread_internal_t* thread = __get_thread();
+  if (thread == nullptr || thread->bionic_tls == nullptr) return nullptr;
+  return &thread->bionic_tls->arc4random;
+}
@@ -32,6 +32,8 @@
 #include <stdatomic.h>
 
 #include "private/bionic_lock.h"
+#include "private/bionic_rseq.h"
+#include "private/bionic_stats.h"
 #include "private/bionic_tls.h"
 
 /* Has the thread been detached by a pthread_join or pthread_detach call? */
@@ -92,6 +94,9 @@ class pthread_internal_t {
   void* start_routine_arg;
   void* return_value;
 
+  // The guard page at the bottom of this thread's signal stack. When pthread_create
+  // allocated the thread's stack (mmap_size != 0), the signal stack is part of the same
+  // mapping, just above the thread stack; otherwise it's a mapping of its own.
   void* alternate_signal_stack;
 
   Lock startup_handshake_lock;
@@ -100,9 +105,26 @@ class pthread_internal_t {
 
   thread_local_dtor* thread_local_dtors;
 
-  void* tls[BIONIC_TLS_SLOTS];
-
-  pthread_key_data_t key_data[BIONIC_PTHREAD_KEY_COUNT];
+  // Slot 0 of this thread's TLS slots, which is where the thread pointer points. They're
+  // part of the thread's static TLS block (see bionic_elf_tls.h), so the slot indexes
+  // run from MIN_TLS_SLOT to BIONIC_TLS_SLOTS - 1.
+  void** tls;
+
+  // Values for pthread keys, in blocks of 32 slots. The first block, which has the slots
+  // reserved for libc and malloc, is here; the others are only allocated when the thread
+  // first sets a key in them (see pthread_key.cpp), since most threads only use a few keys.
+  // Other threads only look at key_blocks with g_thread_list_lock held, so it's only
+  // changed with that lock held for writing.
+#define BIONIC_PTHREAD_KEY_BLOCK_SIZE 32
+#define BIONIC_PTHREAD_KEY_BLOCK_COUNT \
+    ((BIONIC_PTHREAD_KEY_COUNT + BIONIC_PTHREAD_KEY_BLOCK_SIZE - 1) / BIONIC_PTHREAD_KEY_BLOCK_SIZE)
+  pthread_key_data_t key_data[BIONIC_PTHREAD_KEY_BLOCK_SIZE];
+  pthread_key_data_t* key_blocks[BIONIC_PTHREAD_KEY_BLOCK_COUNT - 1];
+
+  // Bit i is set when this thread has called pthread_setspecific for key slot i, so that
+  // pthread_key_clean_all only has to look at the slots this thread actually used.
+#define BIONIC_PTHREAD_KEY_BITMAP_WORDS ((BIONIC_PTHREAD_KEY_COUNT + 31) / 32)
+  uint32_t key_used_bitmap[BIONIC_PTHREAD_KEY_BITMAP_WORDS];
 
   /*
    * The dynamic linker implements dlerror(3), which makes it hard for us to implement this
@@ -112,17 +134,58 @@ class pthread_internal_t {
   char dlerror_buffer[__BIONIC_DLERROR_BUFFER_SIZE];
 
   bionic_tls* bionic_tls;
+
+  // One more than this thread's index among the libc work queue's workers, or 0 for
+  // threads that aren't workers. See bionic_work_queue.h.
+  int work_queue_worker;
+
+  // Registered by __init_rseq so that the kernel keeps rseq_area.cpu_id current,
+  // which turns sched_getcpu into a load. See __get_current_cpu.
+  bionic_rseq rseq_area;
+
+  // State of the random tag generator used by the pointer tagging
+  // allocator, or 0 until this thread's first tagged allocation.
+  // See malloc_tagged.cpp.
+  uint32_t malloc_tag_state;
+
+  // This thread's counters for android_libc_get_stats. Added to a process-wide total by
+  // __pthread_internal_remove.
+  libc_thread_stats stats;
 };
 
 __LIBC_HIDDEN__ int __init_thread(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void __init_tls(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void __init_thread_stack_guard(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void __init_alternate_signal_stack(pthread_internal_t*);
+__LIBC_HIDDEN__ void __init_rseq(pthread_internal_t*);
+__LIBC_HIDDEN__ void __release_rseq(pthread_internal_t*);
 
 __LIBC_HIDDEN__ pthread_t           __pthread_internal_add(pthread_internal_t* thread);
 __LIBC_HIDDEN__ pthread_internal_t* __pthread_internal_find(pthread_t pthread_id);
 __LIBC_HIDDEN__ void                __pthread_internal_remove(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void                __pthread_internal_remove_and_free(pthread_internal_t* thread);
+__LIBC_HIDDEN__ void                __pthread_internal_clear_key_data(size_t key_index);
+__LIBC_HIDDEN__ pthread_key_data_t* __pthread_internal_add_key_block(pthread_internal_t* thread,
+                                                                     size_t block);
+__LIBC_HIDDEN__ void                __pthread_internal_free_key_blocks(pthread_internal_t* thread);
+// Adds the counters of every thread, live or gone, to 'sum'.
+__LIBC_HIDDEN__ void                __pthread_internal_sum_stats(libc_thread_stats* sum);
+
+// The size of the mapping pthread_create makes for a thread with a stack of 'stack_size'
+// bytes: the stack, the pthread_internal_t and static TLS, and the signal stack.
+__LIBC_HIDDEN__ size_t __thread_mapping_size(size_t stack_size);
+
+// Threads that exit hand their stack, bionic TLS and signal stack mappings to small
+// process-wide caches, so that pthread_create can skip mmap/mprotect/munmap for them.
+// The take functions return null when there's nothing to reuse, and the put functions
+// return false when the caller should unmap the mapping itself.
+__LIBC_HIDDEN__ void* __thread_stack_cache_take(size_t mmap_size, size_t guard_size);
+__LIBC_HIDDEN__ bool  __thread_stack_cache_put(pthread_internal_t* thread);
+__LIBC_HIDDEN__ void* __bionic_tls_cache_take();
+__LIBC_HIDDEN__ bool  __bionic_tls_cache_put(void* allocation);
+__LIBC_HIDDEN__ void* __signal_stack_cache_take();
+__LIBC_HIDDEN__ bool  __signal_stack_cache_put(void* stack_base);
+__LIBC_HIDDEN__ void  __thread_mapping_caches_reset_after_fork();
 
 // Make __get_thread() inlined for performance reason. See http://b/19825434.
 static inline __always_inline pthread_internal_t* __get_thread() {
@@ -139,8 +202,30 @@ static inline __always_inline bionic_tls& __get_bionic_tls() {
   return *__get_thread()->bionic_tls;
 }
 
+// Counts an event for android_libc_get_stats. The counter is only ever written by its
+// own thread, so this is a plain increment rather than an atomic one.
+static inline __always_inline void __libc_stats_inc(int stat) {
+  pthread_internal_t* thread = __get_thread();
+  if (__predict_true(thread != nullptr)) {
+    uint64_t* counter = &thread->stats.counters[stat];
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+  }
+}
+
+// Returns the CPU the calling thread was last seen running on by the kernel, or a negative
+// value if this thread couldn't register rseq. Like sched_getcpu, the answer can be stale as
+// soon as it's returned.
+static inline __always_inline int __get_current_cpu() {
+  return static_cast<int>(__atomic_load_n(&__get_thread()->rseq_area.cpu_id, __ATOMIC_RELAXED));
+}
+
 __LIBC_HIDDEN__ void pthread_key_clean_all(void);
 
+// Used by pthread_cond_broadcast to requeue waiters onto their mutex, see pthread_mutex.cpp.
+// __pthread_mutex_requeue_futex returns null for mutexes that can't be requeued onto.
+__LIBC_HIDDEN__ void* __pthread_mutex_requeue_futex(pthread_mutex_t* mutex);
+__LIBC_HIDDEN__ void  __pthread_mutex_lock_after_requeue(pthread_mutex_t* mutex);
+
 // SIGSTKSZ (8kB) is not big enough.
 // snprintf to a stack buffer of size PATH_MAX consumes ~7kB of stack.
 // Also, on 64-bit, logging uses more than 8kB by itself:
@@ -160,6 +245,7 @@ __LIBC_HIDDEN__ void pthread_key_clean_all(void);
 #define SIGNAL_STACK_SIZE (SIGNAL_STACK_SIZE_WITHOUT_GUARD_PAGE + PAGE_SIZE)
 
 /* Needed by fork. */
+__LIBC_HIDDEN__ extern void __bionic_atfork_init_trace();
 __LIBC_HIDDEN__ extern void __bionic_atfork_run_prepare();
 __LIBC_HIDDEN__ extern void __bionic_atfork_run_child();
 __LIBC_HIDDEN__ extern void __bionic_atfork_run_parent();
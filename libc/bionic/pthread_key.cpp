@@ -68,43 +68,70 @@ static inline bool KeyInValidRange(pthread_key_t key) {
   return (key < (KEY_VALID_FLAG | BIONIC_PTHREAD_KEY_COUNT));
 }
 
+// Returns the thread's value for key slot i, or null if the thread has never set a key in
+// the block i is in, in which case it has no value for the key.
+static inline pthread_key_data_t* GetKeyData(pthread_internal_t* thread, size_t i) {
+  if (__predict_true(i < BIONIC_PTHREAD_KEY_BLOCK_SIZE)) {
+    return &thread->key_data[i];
+  }
+  pthread_key_data_t* block = thread->key_blocks[i / BIONIC_PTHREAD_KEY_BLOCK_SIZE - 1];
+  return (block != NULL) ? &block[i % BIONIC_PTHREAD_KEY_BLOCK_SIZE] : NULL;
+}
+
+// Calls the destructor of key slot i if the current thread has a value for the key in it.
+// Returns whether a destructor was called.
+static bool CallKeyDestructor(pthread_key_data_t* key_data, size_t i) {
+  uintptr_t seq = atomic_load_explicit(&key_map[i].seq, memory_order_relaxed);
+  if (key_data == NULL || !SeqOfKeyInUse(seq) || seq != key_data->seq || key_data->data == NULL) {
+    return false;
+  }
+  // Other threads may be calling pthread_key_delete/pthread_key_create while current thread
+  // is exiting. So we need to ensure we read the right key_destructor.
+  // We can rely on a user-established happens-before relationship between the creation and
+  // use of pthread key to ensure that we're not getting an earlier key_destructor.
+  // To avoid using the key_destructor of the newly created key in the same slot, we need to
+  // recheck the sequence number after reading key_destructor. As a result, we either see the
+  // right key_destructor, or the sequence number must have changed when we reread it below.
+  key_destructor_t key_destructor = reinterpret_cast<key_destructor_t>(
+    atomic_load_explicit(&key_map[i].key_destructor, memory_order_relaxed));
+  if (key_destructor == NULL) {
+    return false;
+  }
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&key_map[i].seq, memory_order_relaxed) != seq) {
+    return false;
+  }
+
+  // We need to clear the key data now, this will prevent the destructor (or a later one)
+  // from seeing the old value if it calls pthread_getspecific().
+  // We don't do this if 'key_destructor == NULL' just in case another destructor
+  // function is responsible for manually releasing the corresponding data.
+  void* data = key_data->data;
+  key_data->data = NULL;
+
+  (*key_destructor)(data);
+  return true;
+}
+
 // Called from pthread_exit() to remove all pthread keys. This must call the destructor of
 // all keys that have a non-NULL data value and a non-NULL destructor.
 __LIBC_HIDDEN__ void pthread_key_clean_all() {
   // Because destructors can do funky things like deleting/creating other keys,
   // we need to implement this in a loop.
-  pthread_key_data_t* key_data = __get_thread()->key_data;
+  pthread_internal_t* thread = __get_thread();
   for (size_t rounds = PTHREAD_DESTRUCTOR_ITERATIONS; rounds > 0; --rounds) {
     size_t called_destructor_count = 0;
-    for (size_t i = 0; i < BIONIC_PTHREAD_KEY_COUNT; ++i) {
-      uintptr_t seq = atomic_load_explicit(&key_map[i].seq, memory_order_relaxed);
-      if (SeqOfKeyInUse(seq) && seq == key_data[i].seq && key_data[i].data != NULL) {
-        // Other threads may be calling pthread_key_delete/pthread_key_create while current thread
-        // is exiting. So we need to ensure we read the right key_destructor.
-        // We can rely on a user-established happens-before relationship between the creation and
-        // use of pthread key to ensure that we're not getting an earlier key_destructor.
-        // To avoid using the key_destructor of the newly created key in the same slot, we need to
-        // recheck the sequence number after reading key_destructor. As a result, we either see the
-        // right key_destructor, or the sequence number must have changed when we reread it below.
-        key_destructor_t key_destructor = reinterpret_cast<key_destructor_t>(
-          atomic_load_explicit(&key_map[i].key_destructor, memory_order_relaxed));
-        if (key_destructor == NULL) {
-          continue;
+    // Only slots this thread has set can hold data, so skip the rest. A destructor that sets
+    // a key again also sets its bit again, and it'll be seen in the next round.
+    for (size_t word = 0; word < BIONIC_PTHREAD_KEY_BITMAP_WORDS; ++word) {
+      uint32_t used = thread->key_used_bitmap[word];
+      thread->key_used_bitmap[word] = 0;
+      while (used != 0) {
+        size_t i = word * 32 + __builtin_ctz(used);
+        used &= used - 1;
+        if (CallKeyDestructor(GetKeyData(thread, i), i)) {
+          ++called_destructor_count;
         }
-        atomic_thread_fence(memory_order_acquire);
-        if (atomic_load_explicit(&key_map[i].seq, memory_order_relaxed) != seq) {
-           continue;
-        }
-
-        // We need to clear the key data now, this will prevent the destructor (or a later one)
-        // from seeing the old value if it calls pthread_getspecific().
-        // We don't do this if 'key_destructor == NULL' just in case another destructor
-        // function is responsible for manually releasing the corresponding data.
-        void* data = key_data[i].data;
-        key_data[i].data = NULL;
-
-        (*key_destructor)(data);
-        ++called_destructor_count;
       }
     }
 
@@ -120,6 +147,12 @@ int pthread_key_create(pthread_key_t* key, void (*key_destructor)(void*)) {
     uintptr_t seq = atomic_load_explicit(&key_map[i].seq, memory_order_relaxed);
     while (!SeqOfKeyInUse(seq)) {
       if (atomic_compare_exchange_weak(&key_map[i].seq, &seq, seq + SEQ_INCREMENT_STEP)) {
+        // If the slot has been used before, threads may still hold values for the old key.
+        // pthread_getspecific would notice the stale sequence number, but
+        // __pthread_getspecific_unchecked doesn't look.
+        if (seq != 0) {
+          __pthread_internal_clear_key_data(i);
+        }
         atomic_store(&key_map[i].key_destructor, reinterpret_cast<uintptr_t>(key_destructor));
         *key = i | KEY_VALID_FLAG;
         return 0;
@@ -154,7 +187,10 @@ void* pthread_getspecific(pthread_key_t key) {
   }
   key &= ~KEY_VALID_FLAG;
   uintptr_t seq = atomic_load_explicit(&key_map[key].seq, memory_order_relaxed);
-  pthread_key_data_t* data = &(__get_thread()->key_data[key]);
+  pthread_key_data_t* data = GetKeyData(__get_thread(), key);
+  if (data == NULL) {
+    return NULL;
+  }
   // It is user's responsibility to synchornize between the creation and use of pthread keys,
   // so we use memory_order_relaxed when checking the sequence number.
   if (__predict_true(SeqOfKeyInUse(seq) && data->seq == seq)) {
@@ -166,6 +202,11 @@ void* pthread_getspecific(pthread_key_t key) {
   return NULL;
 }
 
+void* __pthread_getspecific_unchecked(pthread_key_t key) {
+  pthread_key_data_t* data = GetKeyData(__get_thread(), key & ~KEY_VALID_FLAG);
+  return (data != NULL) ? data->data : NULL;
+}
+
 int pthread_setspecific(pthread_key_t key, const void* ptr) {
   if (__predict_false(!KeyInValidRange(key))) {
     return EINVAL;
@@ -173,9 +214,18 @@ int pthread_setspecific(pthread_key_t key, const void* ptr) {
   key &= ~KEY_VALID_FLAG;
   uintptr_t seq = atomic_load_explicit(&key_map[key].seq, memory_order_relaxed);
   if (__predict_true(SeqOfKeyInUse(seq))) {
-    pthread_key_data_t* data = &(__get_thread()->key_data[key]);
+    pthread_internal_t* thread = __get_thread();
+    pthread_key_data_t* data = GetKeyData(thread, key);
+    if (__predict_false(data == NULL)) {
+      data = __pthread_internal_add_key_block(thread, key / BIONIC_PTHREAD_KEY_BLOCK_SIZE);
+      if (data == NULL) {
+        return ENOMEM;
+      }
+      data += key % BIONIC_PTHREAD_KEY_BLOCK_SIZE;
+    }
     data->seq = seq;
     data->data = const_cast<void*>(ptr);
+    thread->key_used_bitmap[key / 32] |= 1u << (key % 32);
     return 0;
   }
   return EINVAL;
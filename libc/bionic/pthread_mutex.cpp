@@ -30,6 +30,7 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <sched.h>
 #include <stdatomic.h>
 #include <string.h>
 #include <sys/cdefs.h>
@@ -40,6 +41,8 @@
 
 #include "private/bionic_constants.h"
 #include "private/bionic_futex.h"
+#include "private/bionic_lock.h"
+#include "private/bionic_mutex_contention.h"
 #include "private/bionic_systrace.h"
 #include "private/bionic_time_conversions.h"
 #include "private/bionic_tls.h"
@@ -49,9 +52,11 @@
  * bits:     name       description
  * 0-3       type       type of mutex
  * 4         shared     process-shared flag
+ * 5         protocol   priority-inheritance flag
  */
-#define  MUTEXATTR_TYPE_MASK   0x000f
-#define  MUTEXATTR_SHARED_MASK 0x0010
+#define  MUTEXATTR_TYPE_MASK     0x000f
+#define  MUTEXATTR_SHARED_MASK   0x0010
+#define  MUTEXATTR_PROTOCOL_MASK 0x0020
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr)
 {
@@ -69,7 +74,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 {
     int type = (*attr & MUTEXATTR_TYPE_MASK);
 
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -79,7 +84,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type_p)
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
-    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ERRORCHECK ) {
+    if (type < PTHREAD_MUTEX_NORMAL || type > PTHREAD_MUTEX_ADAPTIVE_NP) {
         return EINVAL;
     }
 
@@ -113,6 +118,25 @@ int pthread_mutexattr_getpshared(const pthread_mutexattr_t* attr, int* pshared)
     return 0;
 }
 
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t* attr, int protocol) {
+    switch (protocol) {
+    case PTHREAD_PRIO_NONE:
+        *attr &= ~MUTEXATTR_PROTOCOL_MASK;
+        return 0;
+    case PTHREAD_PRIO_INHERIT:
+        *attr |= MUTEXATTR_PROTOCOL_MASK;
+        return 0;
+    case PTHREAD_PRIO_PROTECT:
+        return ENOTSUP;
+    }
+    return EINVAL;
+}
+
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t* attr, int* protocol) {
+    *protocol = (*attr & MUTEXATTR_PROTOCOL_MASK) ? PTHREAD_PRIO_INHERIT : PTHREAD_PRIO_NONE;
+    return 0;
+}
+
 /* a mutex contains a state value and a owner_tid.
  * The value is implemented as a 16-bit integer holding the following fields:
  *
@@ -123,6 +147,9 @@ int pthread_mutexattr_getpshared(const pthread_mutexattr_t* attr, int* pshared)
  * 1-0       state    lock state (0, 1 or 2)
  *
  * The owner_tid is used only in recursive and errorcheck mutex to hold the mutex owner thread tid.
+ * Adaptive mutexes behave like normal mutexes, except that they spin briefly before sleeping.
+ *
+ * Priority-inheritance mutexes don't use any of these fields, see PIMutex below.
  */
 
 /* Convenience macro, creates a mask of 'bits' bits that starts from
@@ -203,7 +230,7 @@ int pthread_mutexattr_getpshared(const pthread_mutexattr_t* attr, int* pshared)
 #define  MUTEX_SHARED_MASK     FIELD_MASK(MUTEX_SHARED_SHIFT,1)
 
 /* Mutex type:
- * We support normal, recursive and errorcheck mutexes.
+ * We support normal, recursive, errorcheck and adaptive mutexes.
  */
 #define  MUTEX_TYPE_SHIFT      14
 #define  MUTEX_TYPE_LEN        2
@@ -214,15 +241,48 @@ int pthread_mutexattr_getpshared(const pthread_mutexattr_t* attr, int* pshared)
 #define  MUTEX_TYPE_BITS_NORMAL      MUTEX_TYPE_TO_BITS(PTHREAD_MUTEX_NORMAL)
 #define  MUTEX_TYPE_BITS_RECURSIVE   MUTEX_TYPE_TO_BITS(PTHREAD_MUTEX_RECURSIVE)
 #define  MUTEX_TYPE_BITS_ERRORCHECK  MUTEX_TYPE_TO_BITS(PTHREAD_MUTEX_ERRORCHECK)
+#define  MUTEX_TYPE_BITS_ADAPTIVE    MUTEX_TYPE_TO_BITS(PTHREAD_MUTEX_ADAPTIVE_NP)
+
+// Normal and adaptive mutexes share the same lock/unlock code, which doesn't track an owner.
+#define  MUTEX_TYPE_IS_NORMAL_OR_ADAPTIVE(t) \
+    ((t) == MUTEX_TYPE_BITS_NORMAL || (t) == MUTEX_TYPE_BITS_ADAPTIVE)
+
+/* Priority-inheritance mutexes:
+ * The kernel implements priority inheritance on a 32-bit futex word holding the owner's tid,
+ * which it reads and updates itself, so a PI mutex can't use the 16-bit state above. Instead
+ * its state is set to MUTEX_STATE_BITS_PI once at init and never changes, and the real lock
+ * lives in a PIMutex. No other mutex ever has lock state 3, and the errorcheck type bits keep
+ * PI mutexes off the normal mutex fast paths.
+ */
+#define  MUTEX_STATE_BITS_PI  (MUTEX_TYPE_BITS_ERRORCHECK | MUTEX_STATE_TO_BITS(3))
+
+struct PIMutex {
+  // Mutex type, one of PTHREAD_MUTEX_*, constant during the lifetime of the mutex.
+  uint8_t type;
+  // Process-shared flag, constant during the lifetime of the mutex.
+  bool shared;
+  // <number of times a recursive mutex is locked by its owner> - 1.
+  uint16_t counter;
+  // The futex word used by FUTEX_LOCK_PI/FUTEX_UNLOCK_PI: the owner's tid, or 0 if unlocked,
+  // plus FUTEX_WAITERS when the kernel has threads blocked on it.
+  atomic_int owner_tid;
+};
 
 struct pthread_mutex_internal_t {
   _Atomic(uint16_t) state;
 #if defined(__LP64__)
   uint16_t __pad;
-  atomic_int owner_tid;
-  char __reserved[32];
+  union {
+    atomic_int owner_tid;
+    PIMutex pi_mutex;
+  };
+  char __reserved[28];
 #else
-  _Atomic(uint16_t) owner_tid;
+  union {
+    _Atomic(uint16_t) owner_tid;
+    // There's no room for a PIMutex on LP32, see PIMutexAllocator.
+    uint16_t pi_mutex_id;
+  };
 #endif
 } __attribute__((aligned(4)));
 
@@ -238,6 +298,281 @@ static inline pthread_mutex_internal_t* __get_internal_mutex(pthread_mutex_t* mu
   return reinterpret_cast<pthread_mutex_internal_t*>(mutex_interface);
 }
 
+#if !defined(__LP64__)
+// A 32-bit pthread_mutex_t is only 4 bytes, so PI mutexes are allocated from a process-private
+// table and the mutex holds a non-zero 16-bit id into it. That also means LP32 PI mutexes
+// can't be process-shared. An entry is only given back by pthread_mutex_destroy, so a PI
+// mutex whose memory is freed or reused without being destroyed (which POSIX doesn't allow,
+// but works for other mutexes) leaks its entry, and pthread_mutex_init fails with EAGAIN once
+// all 65535 are gone.
+class PIMutexAllocator {
+ public:
+  static uint16_t Alloc() {
+    LockGuard guard(lock_);
+    if (nodes_ == nullptr) {
+      // The table is reserved up front but only touched pages are ever backed by memory.
+      void* map = mmap(nullptr, kMaxNodes * sizeof(Node), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (map == MAP_FAILED) {
+        return 0;
+      }
+      nodes_ = reinterpret_cast<Node*>(map);
+    }
+    uint16_t id;
+    if (first_free_ != 0) {
+      id = first_free_;
+      first_free_ = nodes_[id].next_free;
+    } else if (next_unused_ < kMaxNodes) {
+      id = next_unused_++;
+    } else {
+      return 0;
+    }
+    memset(&nodes_[id], 0, sizeof(Node));
+    return id;
+  }
+
+  static PIMutex& Get(uint16_t id) {
+    return nodes_[id].mutex;
+  }
+
+  static void Free(uint16_t id) {
+    LockGuard guard(lock_);
+    nodes_[id].next_free = first_free_;
+    first_free_ = id;
+  }
+
+ private:
+  static constexpr size_t kMaxNodes = 65536;
+
+  union Node {
+    PIMutex mutex;
+    uint16_t next_free;
+  };
+
+  struct LockGuard {
+    explicit LockGuard(Lock& lock) : lock(lock) { lock.lock(); }
+    ~LockGuard() { lock.unlock(); }
+    Lock& lock;
+  };
+
+  static Lock lock_;
+  static Node* nodes_;
+  // Id 0 is never handed out, so that it can mean "no PI mutex".
+  static uint16_t first_free_;
+  static size_t next_unused_;
+};
+
+Lock PIMutexAllocator::lock_;
+PIMutexAllocator::Node* PIMutexAllocator::nodes_;
+uint16_t PIMutexAllocator::first_free_;
+size_t PIMutexAllocator::next_unused_ = 1;
+#endif
+
+static inline __always_inline PIMutex& __get_pi_mutex(pthread_mutex_internal_t* mutex) {
+#if defined(__LP64__)
+    return mutex->pi_mutex;
+#else
+    return PIMutexAllocator::Get(mutex->pi_mutex_id);
+#endif
+}
+
+static int __pthread_pi_mutex_init(pthread_mutex_internal_t* mutex, int type, bool shared) {
+#if defined(__LP64__)
+    PIMutex& pi_mutex = mutex->pi_mutex;
+#else
+    if (shared) {
+        return ENOTSUP;
+    }
+    uint16_t id = PIMutexAllocator::Alloc();
+    if (id == 0) {
+        return EAGAIN;
+    }
+    mutex->pi_mutex_id = id;
+    PIMutex& pi_mutex = PIMutexAllocator::Get(id);
+#endif
+    pi_mutex.type = type;
+    pi_mutex.shared = shared;
+    pi_mutex.counter = 0;
+    atomic_init(&pi_mutex.owner_tid, 0);
+    atomic_init(&mutex->state, MUTEX_STATE_BITS_PI);
+    return 0;
+}
+
+static inline __always_inline int __pthread_pi_mutex_trylock(PIMutex& mutex) {
+    pid_t tid = __get_thread()->tid;
+    // If exchanged successfully, an acquire fence is required to make
+    // all memory accesses made by other threads visible to the current CPU.
+    int old_owner = 0;
+    if (__predict_true(atomic_compare_exchange_strong_explicit(&mutex.owner_tid, &old_owner, tid,
+                                                               memory_order_acquire,
+                                                               memory_order_relaxed))) {
+        return 0;
+    }
+    // The kernel may have set FUTEX_WAITERS, so only compare the tid bits.
+    if (tid == (old_owner & FUTEX_TID_MASK) && mutex.type == PTHREAD_MUTEX_RECURSIVE) {
+        if (mutex.counter == 0xffff) {
+            return EAGAIN;
+        }
+        // Only the owner changes the counter, so it needs no atomic operation.
+        mutex.counter++;
+        return 0;
+    }
+    return EBUSY;
+}
+
+/* Contention profiling: malloc debug's mutex_contention option sets a function
+ * to be told about a sample of the waits in the contended paths below. The
+ * interval is published last, so a non-zero one means the function is set.
+ */
+static _Atomic(MutexContentionFunc) g_mutex_contention_func;
+static atomic_uint g_mutex_contention_interval;
+static atomic_uint g_mutex_contention_count;
+
+void __libc_set_mutex_contention_func(MutexContentionFunc func, uint32_t sample_interval) {
+    if (func == nullptr) {
+        atomic_store_explicit(&g_mutex_contention_interval, 0, memory_order_release);
+        atomic_store_explicit(&g_mutex_contention_func, nullptr, memory_order_release);
+        return;
+    }
+    atomic_store_explicit(&g_mutex_contention_func, func, memory_order_release);
+    atomic_store_explicit(&g_mutex_contention_interval, sample_interval, memory_order_release);
+}
+
+static uint64_t __mutex_contention_now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * NS_PER_S + ts.tv_nsec;
+}
+
+class ScopedMutexContention {
+  public:
+    explicit ScopedMutexContention(const void* mutex) : mutex_(mutex), start_ns_(0) {
+        unsigned interval = atomic_load_explicit(&g_mutex_contention_interval,
+                                                 memory_order_acquire);
+        if (__predict_false(interval != 0) &&
+            atomic_fetch_add_explicit(&g_mutex_contention_count, 1,
+                                      memory_order_relaxed) % interval == 0) {
+            start_ns_ = __mutex_contention_now_ns();
+        }
+    }
+
+    ~ScopedMutexContention() {
+        if (__predict_false(start_ns_ != 0)) {
+            MutexContentionFunc func = atomic_load_explicit(&g_mutex_contention_func,
+                                                            memory_order_acquire);
+            if (func != nullptr) {
+                func(mutex_, __mutex_contention_now_ns() - start_ns_);
+            }
+        }
+    }
+
+  private:
+    const void* mutex_;
+    uint64_t start_ns_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedMutexContention);
+};
+
+// FUTEX_LOCK_PI only takes CLOCK_REALTIME deadlines, and any conversion of a CLOCK_MONOTONIC
+// deadline would be thrown off by changes to the realtime clock while we wait. So a wait with
+// a monotonic deadline polls with trylock instead, sleeping a little longer each time up to a
+// millisecond. The owner isn't boosted while we wait this way.
+static int __pthread_pi_mutex_lock_monotonic(PIMutex& mutex, const timespec& abs_timeout) {
+    pid_t tid = __get_thread()->tid;
+    long sleep_ns = 10000;
+    while (true) {
+        int result = __pthread_pi_mutex_trylock(mutex);
+        if (result != EBUSY) {
+            return result;
+        }
+        // FUTEX_LOCK_PI would fail with EDEADLK rather than wait for ourselves.
+        if ((atomic_load_explicit(&mutex.owner_tid, memory_order_relaxed) & FUTEX_TID_MASK) ==
+            tid) {
+            return EDEADLK;
+        }
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > abs_timeout.tv_sec ||
+            (now.tv_sec == abs_timeout.tv_sec && now.tv_nsec >= abs_timeout.tv_nsec)) {
+            return ETIMEDOUT;
+        }
+        timespec wake = now;
+        wake.tv_nsec += sleep_ns;
+        if (wake.tv_nsec >= NS_PER_S) {
+            wake.tv_nsec -= NS_PER_S;
+            wake.tv_sec++;
+        }
+        if (wake.tv_sec > abs_timeout.tv_sec ||
+            (wake.tv_sec == abs_timeout.tv_sec && wake.tv_nsec > abs_timeout.tv_nsec)) {
+            wake = abs_timeout;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr);
+        if (sleep_ns < 1000000) {
+            sleep_ns *= 2;
+        }
+    }
+}
+
+static int __pthread_pi_mutex_lock(PIMutex& mutex, bool use_realtime_clock,
+                                   const timespec* abs_timeout_or_null) {
+    int result = __pthread_pi_mutex_trylock(mutex);
+    if (__predict_true(result != EBUSY)) {
+        return result;
+    }
+    result = check_timespec(abs_timeout_or_null, true);
+    if (result != 0) {
+        return result;
+    }
+
+    ScopedTrace trace("Contending for pthread PI mutex");
+    ScopedMutexContention contention(&mutex);
+    __libc_stats_inc(LIBC_STAT_MUTEX_CONTENTIONS);
+
+    if (abs_timeout_or_null != nullptr && !use_realtime_clock) {
+        return __pthread_pi_mutex_lock_monotonic(mutex, *abs_timeout_or_null);
+    }
+
+    // The kernel takes care of boosting the owner, and of EDEADLK if we already own a
+    // normal or errorcheck mutex.
+    return -__futex_pi_lock_ex(&mutex.owner_tid, mutex.shared, abs_timeout_or_null);
+}
+
+static int __pthread_pi_mutex_unlock(PIMutex& mutex) {
+    pid_t tid = __get_thread()->tid;
+    if ((atomic_load_explicit(&mutex.owner_tid, memory_order_relaxed) & FUTEX_TID_MASK) != tid) {
+        return EPERM;
+    }
+    if (mutex.type == PTHREAD_MUTEX_RECURSIVE && mutex.counter > 0) {
+        mutex.counter--;
+        return 0;
+    }
+    // Without waiters we can release the mutex ourselves. A release fence is required to
+    // make previous stores visible to the next lock owner.
+    int old_owner = tid;
+    if (__predict_true(atomic_compare_exchange_strong_explicit(&mutex.owner_tid, &old_owner, 0,
+                                                               memory_order_release,
+                                                               memory_order_relaxed))) {
+        return 0;
+    }
+    // FUTEX_WAITERS is set, so the kernel has to hand the mutex to the top waiter.
+    return -__futex_pi_unlock(&mutex.owner_tid, mutex.shared);
+}
+
+static int __pthread_pi_mutex_destroy(pthread_mutex_internal_t* mutex) {
+    PIMutex& pi_mutex = __get_pi_mutex(mutex);
+    // As for other mutexes, refuse to destroy a locked PI mutex.
+    int old_owner = 0;
+    if (!atomic_compare_exchange_strong_explicit(&pi_mutex.owner_tid, &old_owner, -1,
+                                                 memory_order_relaxed, memory_order_relaxed)) {
+        return EBUSY;
+    }
+    atomic_store_explicit(&mutex->state, 0xffff, memory_order_relaxed);
+#if !defined(__LP64__)
+    PIMutexAllocator::Free(mutex->pi_mutex_id);
+#endif
+    return 0;
+}
+
 int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr_t* attr) {
     pthread_mutex_internal_t* mutex = __get_internal_mutex(mutex_interface);
 
@@ -253,7 +588,15 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
         state |= MUTEX_SHARED_MASK;
     }
 
-    switch (*attr & MUTEXATTR_TYPE_MASK) {
+    int type = *attr & MUTEXATTR_TYPE_MASK;
+    if ((*attr & MUTEXATTR_PROTOCOL_MASK) != 0) {
+        if (type > PTHREAD_MUTEX_ADAPTIVE_NP) {
+            return EINVAL;
+        }
+        return __pthread_pi_mutex_init(mutex, type, (*attr & MUTEXATTR_SHARED_MASK) != 0);
+    }
+
+    switch (type) {
     case PTHREAD_MUTEX_NORMAL:
       state |= MUTEX_TYPE_BITS_NORMAL;
       break;
@@ -263,6 +606,9 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
     case PTHREAD_MUTEX_ERRORCHECK:
       state |= MUTEX_TYPE_BITS_ERRORCHECK;
       break;
+    case PTHREAD_MUTEX_ADAPTIVE_NP:
+      state |= MUTEX_TYPE_BITS_ADAPTIVE;
+      break;
     default:
         return EINVAL;
     }
@@ -273,9 +619,10 @@ int pthread_mutex_init(pthread_mutex_t* mutex_interface, const pthread_mutexattr
 }
 
 static inline __always_inline int __pthread_normal_mutex_trylock(pthread_mutex_internal_t* mutex,
+                                                                 uint16_t mtype,
                                                                  uint16_t shared) {
-    const uint16_t unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const uint16_t locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+    const uint16_t unlocked           = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_uncontended = mtype | shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
 
     uint16_t old_state = unlocked;
     if (__predict_true(atomic_compare_exchange_strong_explicit(&mutex->state, &old_state,
@@ -285,23 +632,103 @@ static inline __always_inline int __pthread_normal_mutex_trylock(pthread_mutex_i
     return EBUSY;
 }
 
+static inline __always_inline void __cpu_relax() {
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__arm__) || defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+// Spinning can only help if the owner can run at the same time as us. We don't
+// know which thread owns a normal or adaptive mutex, let alone whether it's on a
+// CPU, so the best we can do is to not spin when this process only has one CPU.
+// The affinity mask is read once, using sched_getaffinity rather than sysconf to
+// keep stdio out of static binaries.
+static bool __mutex_spin_is_useful() {
+    static atomic_int cpu_count;
+    int cpus = atomic_load_explicit(&cpu_count, memory_order_relaxed);
+    if (__predict_false(cpus == 0)) {
+        cpu_set_t set;
+        cpus = (sched_getaffinity(0, sizeof(set), &set) == 0) ? CPU_COUNT(&set) : 1;
+        if (cpus < 1) {
+            cpus = 1;
+        }
+        atomic_store_explicit(&cpu_count, cpus, memory_order_relaxed);
+    }
+    return cpus > 1;
+}
+
+// An adaptive mutex spins for at most this many polls of the lock word, waiting
+// between polls for an exponentially growing number of cpu relax instructions
+// capped at MUTEX_SPIN_MAX_BACKOFF. That bounds the spin to a few microseconds,
+// which is roughly what a futex wait and wake costs.
+#define  MUTEX_SPIN_MAX_POLLS    100
+#define  MUTEX_SPIN_MAX_BACKOFF  32
+
+/*
+ * Spin on an adaptive mutex that a trylock has just failed to acquire, in the
+ * hope that the owner is about to release it.
+ *
+ * We give up as soon as the mutex is seen in the locked_contended state: there
+ * are already threads asleep on it, so the owner's unlock is going to hand the
+ * mutex to one of them after a futex wake, and we'd rather queue up behind them.
+ *
+ * Returns 0 if the mutex was acquired, EBUSY otherwise.
+ */
+static int __pthread_adaptive_mutex_spin(pthread_mutex_internal_t* mutex, uint16_t shared) {
+    if (!__mutex_spin_is_useful()) {
+        return EBUSY;
+    }
+
+    const uint16_t unlocked           = MUTEX_TYPE_BITS_ADAPTIVE | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_uncontended = MUTEX_TYPE_BITS_ADAPTIVE | shared |
+                                        MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+
+    int backoff = 1;
+    for (int poll = 0; poll < MUTEX_SPIN_MAX_POLLS; ++poll) {
+        for (int i = 0; i < backoff; ++i) {
+            __cpu_relax();
+        }
+        if (backoff < MUTEX_SPIN_MAX_BACKOFF) {
+            backoff *= 2;
+        }
+
+        // Only poll with loads, so spinning threads don't keep stealing the
+        // cache line from the owner.
+        uint16_t old_state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+        if (old_state == unlocked) {
+            if (atomic_compare_exchange_strong_explicit(&mutex->state, &old_state,
+                                                        locked_uncontended, memory_order_acquire,
+                                                        memory_order_relaxed)) {
+                return 0;
+            }
+        } else if (MUTEX_STATE_BITS_IS_LOCKED_CONTENDED(old_state)) {
+            break;
+        }
+    }
+    return EBUSY;
+}
+
 /*
- * Lock a mutex of type NORMAL.
+ * Lock a mutex of type NORMAL or ADAPTIVE.
  *
  * As noted above, there are three states:
  *   0 (unlocked, no contention)
  *   1 (locked, no contention)
  *   2 (locked, contention)
  *
- * Non-recursive mutexes don't use the thread-id or counter fields, and the
- * "type" value is zero, so the only bits that will be set are the ones in
- * the lock state field.
+ * Non-recursive mutexes don't use the thread-id or counter fields, so the only
+ * bits that change are the ones in the lock state field.
  */
 static inline __always_inline int __pthread_normal_mutex_lock(pthread_mutex_internal_t* mutex,
+                                                              uint16_t mtype,
                                                               uint16_t shared,
                                                               bool use_realtime_clock,
                                                               const timespec* abs_timeout_or_null) {
-    if (__predict_true(__pthread_normal_mutex_trylock(mutex, shared) == 0)) {
+    if (__predict_true(__pthread_normal_mutex_trylock(mutex, mtype, shared) == 0)) {
         return 0;
     }
     int result = check_timespec(abs_timeout_or_null, true);
@@ -309,10 +736,16 @@ static inline __always_inline int __pthread_normal_mutex_lock(pthread_mutex_inte
         return result;
     }
 
+    if (mtype == MUTEX_TYPE_BITS_ADAPTIVE && __pthread_adaptive_mutex_spin(mutex, shared) == 0) {
+        return 0;
+    }
+
     ScopedTrace trace("Contending for pthread mutex");
+    ScopedMutexContention contention(mutex);
+    __libc_stats_inc(LIBC_STAT_MUTEX_CONTENTIONS);
 
-    const uint16_t unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const uint16_t locked_contended = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+    const uint16_t unlocked         = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
     // We want to go to sleep until the mutex is available, which requires
     // promoting it to locked_contended. We need to swap in the new state
@@ -337,9 +770,10 @@ static inline __always_inline int __pthread_normal_mutex_lock(pthread_mutex_inte
  * that we are in fact the owner of this lock.
  */
 static inline __always_inline void __pthread_normal_mutex_unlock(pthread_mutex_internal_t* mutex,
+                                                                 uint16_t mtype,
                                                                  uint16_t shared) {
-    const uint16_t unlocked         = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const uint16_t locked_contended = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+    const uint16_t unlocked         = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
     // We use an atomic_exchange to release the lock. If locked_contended state
     // is returned, some threads is waiting for the lock and we need to wake up
@@ -426,8 +860,13 @@ static int __pthread_mutex_lock_with_timeout(pthread_mutex_internal_t* mutex,
     uint16_t shared = (old_state & MUTEX_SHARED_MASK);
 
     // Handle common case first.
-    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) ) {
-        return __pthread_normal_mutex_lock(mutex, shared, use_realtime_clock, abs_timeout_or_null);
+    if ( __predict_true(MUTEX_TYPE_IS_NORMAL_OR_ADAPTIVE(mtype)) ) {
+        return __pthread_normal_mutex_lock(mutex, mtype, shared, use_realtime_clock,
+                                           abs_timeout_or_null);
+    }
+    if (old_state == MUTEX_STATE_BITS_PI) {
+        return __pthread_pi_mutex_lock(__get_pi_mutex(mutex), use_realtime_clock,
+                                       abs_timeout_or_null);
     }
 
     // Do we already own this recursive or error-check mutex?
@@ -456,6 +895,8 @@ static int __pthread_mutex_lock_with_timeout(pthread_mutex_internal_t* mutex,
     }
 
     ScopedTrace trace("Contending for pthread mutex");
+    ScopedMutexContention contention(mutex);
+    __libc_stats_inc(LIBC_STAT_MUTEX_CONTENTIONS);
 
     while (true) {
         if (old_state == unlocked) {
@@ -517,7 +958,7 @@ int pthread_mutex_lock(pthread_mutex_t* mutex_interface) {
     uint16_t shared = (old_state & MUTEX_SHARED_MASK);
     // Avoid slowing down fast path of normal mutex lock operation.
     if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-      if (__predict_true(__pthread_normal_mutex_trylock(mutex, shared) == 0)) {
+      if (__predict_true(__pthread_normal_mutex_trylock(mutex, mtype, shared) == 0)) {
         return 0;
       }
     }
@@ -541,10 +982,13 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex_interface) {
     uint16_t shared = (old_state & MUTEX_SHARED_MASK);
 
     // Handle common case first.
-    if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        __pthread_normal_mutex_unlock(mutex, shared);
+    if (__predict_true(MUTEX_TYPE_IS_NORMAL_OR_ADAPTIVE(mtype))) {
+        __pthread_normal_mutex_unlock(mutex, mtype, shared);
         return 0;
     }
+    if (old_state == MUTEX_STATE_BITS_PI) {
+        return __pthread_pi_mutex_unlock(__get_pi_mutex(mutex));
+    }
 
     // Do we already own this recursive or error-check mutex?
     pid_t tid = __get_thread()->tid;
@@ -588,8 +1032,11 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex_interface) {
     const uint16_t locked_uncontended = mtype | shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
 
     // Handle common case first.
-    if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        return __pthread_normal_mutex_trylock(mutex, shared);
+    if (__predict_true(MUTEX_TYPE_IS_NORMAL_OR_ADAPTIVE(mtype))) {
+        return __pthread_normal_mutex_trylock(mutex, mtype, shared);
+    }
+    if (old_state == MUTEX_STATE_BITS_PI) {
+        return __pthread_pi_mutex_trylock(__get_pi_mutex(mutex));
     }
 
     // Do we already own this recursive or error-check mutex?
@@ -637,9 +1084,48 @@ int pthread_mutex_timedlock(pthread_mutex_t* mutex_interface, const timespec* ab
                                              true, abs_timeout);
 }
 
+// pthread_cond_broadcast moves all but one of its waiters straight onto the futex of the
+// mutex they're going to lock next, so they're woken one at a time by unlocks instead of
+// all at once to fight over the mutex. That only works for mutexes whose unlock wakes
+// exactly the threads asleep on that futex, which means normal and adaptive mutexes that
+// aren't process-shared.
+void* __pthread_mutex_requeue_futex(pthread_mutex_t* mutex_interface) {
+    pthread_mutex_internal_t* mutex = __get_internal_mutex(mutex_interface);
+    uint16_t old_state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+    uint16_t mtype = (old_state & MUTEX_TYPE_MASK);
+    if (MUTEX_TYPE_IS_NORMAL_OR_ADAPTIVE(mtype) && (old_state & MUTEX_SHARED_MASK) == 0) {
+        return &mutex->state;
+    }
+    return nullptr;
+}
+
+// Relocks the mutex for a condition variable waiter that may have been moved onto the
+// mutex's futex. The unlock that woke us only knew about one waiter, so we have to take the
+// mutex as locked_contended: our own unlock then wakes the next requeued thread along.
+void __pthread_mutex_lock_after_requeue(pthread_mutex_t* mutex_interface) {
+    pthread_mutex_internal_t* mutex = __get_internal_mutex(mutex_interface);
+    uint16_t old_state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+    uint16_t mtype = (old_state & MUTEX_TYPE_MASK);
+    uint16_t shared = (old_state & MUTEX_SHARED_MASK);
+    if (!MUTEX_TYPE_IS_NORMAL_OR_ADAPTIVE(mtype)) {
+        pthread_mutex_lock(mutex_interface);
+        return;
+    }
+
+    const uint16_t unlocked         = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const uint16_t locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+    while (atomic_exchange_explicit(&mutex->state, locked_contended,
+                                    memory_order_acquire) != unlocked) {
+        __futex_wait_ex(&mutex->state, shared, locked_contended, false, nullptr);
+    }
+}
+
 int pthread_mutex_destroy(pthread_mutex_t* mutex_interface) {
     pthread_mutex_internal_t* mutex = __get_internal_mutex(mutex_interface);
     uint16_t old_state = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+    if (old_state == MUTEX_STATE_BITS_PI) {
+        return __pthread_pi_mutex_destroy(mutex);
+    }
     // Store 0xffff to make the mutex unusable. Although POSIX standard says it is undefined
     // behavior to destroy a locked mutex, we prefer not to change mutex->state in that situation.
     if (MUTEX_STATE_BITS_IS_UNLOCKED(old_state) &&
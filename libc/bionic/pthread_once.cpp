@@ -27,59 +27,81 @@
  */
 
 #include <pthread.h>
+#include <limits.h>
 #include <stdatomic.h>
 
 #include "private/bionic_futex.h"
+#include "private/bionic_once.h"
 
-#define ONCE_INITIALIZATION_NOT_YET_STARTED   0
-#define ONCE_INITIALIZATION_UNDERWAY          1
-#define ONCE_INITIALIZATION_COMPLETE          2
+static_assert(sizeof(atomic_int) == sizeof(pthread_once_t),
+              "pthread_once_t should actually be atomic_int in implementation.");
 
-/* NOTE: this implementation doesn't support a init function that throws a C++ exception
- *       or calls fork()
- */
-int pthread_once(pthread_once_t* once_control, void (*init_routine)(void)) {
-  static_assert(sizeof(atomic_int) == sizeof(pthread_once_t),
-                "pthread_once_t should actually be atomic_int in implementation.");
-
-  // We prefer casting to atomic_int instead of declaring pthread_once_t to be atomic_int directly.
-  // Because using the second method pollutes pthread.h, and causes an error when compiling libcxx.
-  atomic_int* once_control_ptr = reinterpret_cast<atomic_int*>(once_control);
-
-  // First check if the once is already initialized. This will be the common
-  // case and we want to make this as fast as possible. Note that this still
-  // requires a load_acquire operation here to ensure that all the
-  // stores performed by the initialization function are observable on
-  // this CPU after we exit.
+// Kept out of line so that pthread_once itself is just the check for completion.
+// The thread running init_routine only makes the futex wake call if another
+// thread marked the once as having waiters before parking on it.
+static __attribute__((noinline)) int __pthread_once_slow(atomic_int* once_control_ptr,
+                                                        void (*init_routine)(void)) {
   int old_value = atomic_load_explicit(once_control_ptr, memory_order_acquire);
 
   while (true) {
-    if (__predict_true(old_value == ONCE_INITIALIZATION_COMPLETE)) {
+    if (old_value == ONCE_INITIALIZATION_COMPLETE) {
       return 0;
     }
 
-    // Try to atomically set the initialization underway flag. This requires a compare exchange
-    // in a loop, and we may need to exit prematurely if the initialization is complete.
-    if (!atomic_compare_exchange_weak_explicit(once_control_ptr, &old_value,
-                                               ONCE_INITIALIZATION_UNDERWAY,
-                                               memory_order_acquire, memory_order_acquire)) {
-      continue;
-    }
-
     if (old_value == ONCE_INITIALIZATION_NOT_YET_STARTED) {
+      // Try to atomically set the initialization underway flag. We may need to exit
+      // prematurely if the initialization is complete.
+      if (!atomic_compare_exchange_weak_explicit(once_control_ptr, &old_value,
+                                                 ONCE_INITIALIZATION_UNDERWAY,
+                                                 memory_order_acquire, memory_order_acquire)) {
+        continue;
+      }
+
       // We got here first, we can handle the initialization.
       (*init_routine)();
 
-      // Do a store_release indicating that initialization is complete.
-      atomic_store_explicit(once_control_ptr, ONCE_INITIALIZATION_COMPLETE, memory_order_release);
-
-      // Wake up any waiters, if any.
-      __futex_wake_ex(once_control_ptr, 0, INT_MAX);
+      // Do a store_release indicating that initialization is complete, and wake up the
+      // waiters if there are any.
+      old_value = atomic_exchange_explicit(once_control_ptr, ONCE_INITIALIZATION_COMPLETE,
+                                           memory_order_release);
+      if (old_value == ONCE_INITIALIZATION_UNDERWAY_WITH_WAITERS) {
+        __futex_wake_ex(once_control_ptr, 0, INT_MAX);
+      }
       return 0;
     }
 
+    if (old_value == ONCE_INITIALIZATION_UNDERWAY) {
+      // Tell the initializing thread that it has to wake us before we park.
+      if (!atomic_compare_exchange_weak_explicit(once_control_ptr, &old_value,
+                                                 ONCE_INITIALIZATION_UNDERWAY_WITH_WAITERS,
+                                                 memory_order_acquire, memory_order_acquire)) {
+        continue;
+      }
+    }
+
     // The initialization is underway, wait for its finish.
-    __futex_wait_ex(once_control_ptr, 0, old_value, false, nullptr);
+    __futex_wait_ex(once_control_ptr, 0, ONCE_INITIALIZATION_UNDERWAY_WITH_WAITERS, false,
+                    nullptr);
     old_value = atomic_load_explicit(once_control_ptr, memory_order_acquire);
   }
 }
+
+/* NOTE: this implementation doesn't support a init function that throws a C++ exception
+ *       or calls fork()
+ */
+int pthread_once(pthread_once_t* once_control, void (*init_routine)(void)) {
+  // We prefer casting to atomic_int instead of declaring pthread_once_t to be atomic_int directly.
+  // Because using the second method pollutes pthread.h, and causes an error when compiling libcxx.
+  atomic_int* once_control_ptr = reinterpret_cast<atomic_int*>(once_control);
+
+  // First check if the once is already initialized. This will be the common
+  // case and we want to make this as fast as possible. Note that this still
+  // requires a load_acquire operation here to ensure that all the
+  // stores performed by the initialization function are observable on
+  // this CPU after we exit.
+  if (__predict_true(atomic_load_explicit(once_control_ptr, memory_order_acquire) ==
+                     ONCE_INITIALIZATION_COMPLETE)) {
+    return 0;
+  }
+  return __pthread_once_slow(once_control_ptr, init_routine);
+}
@@ -27,10 +27,13 @@
  */
 
 #include <errno.h>
+#include <malloc.h>
 #include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "pthread_internal.h"
+#include "private/bionic_asymmetric_fence.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_lock.h"
 #include "private/bionic_time_conversions.h"
@@ -55,19 +58,28 @@
  *  - This implementation will return EDEADLK in "write after write" and "read after
  *    write" cases and will deadlock in write after read case.
  *
+ * A PTHREAD_RWLOCK_SCALABLE_READERS_NP rwlock (a "big-reader" lock) keeps its readers out of
+ * the state word entirely. Each reader increments a counter in a cache line picked by hashing
+ * its thread, then checks the state word for a writer; if there is one, it backs out and waits
+ * like any other reader. A writer takes the state word as usual, which stops new readers, and
+ * then waits for every reader counter to drain to zero. Because the reader increments its
+ * counter before looking at the state word and the writer sets the state word before looking
+ * at the counters, at least one of them always sees the other. The fences that ensure that are
+ * asymmetric (see bionic_asymmetric_fence.h), so that readers don't pay for a full barrier.
+ *
  */
 
 // A rwlockattr is implemented as a 32-bit integer which has following fields:
 //  bits    name              description
-//   1     rwlock_kind       have rwlock preference like PTHREAD_RWLOCK_PREFER_READER_NP.
+//  2-1    rwlock_kind       have rwlock preference like PTHREAD_RWLOCK_PREFER_READER_NP.
 //   0      process_shared    set to 1 if the rwlock is shared between processes.
 
 #define RWLOCKATTR_PSHARED_SHIFT 0
 #define RWLOCKATTR_KIND_SHIFT    1
 
 #define RWLOCKATTR_PSHARED_MASK  1
-#define RWLOCKATTR_KIND_MASK     2
-#define RWLOCKATTR_RESERVED_MASK (~3)
+#define RWLOCKATTR_KIND_MASK     6
+#define RWLOCKATTR_RESERVED_MASK (~7)
 
 static inline __always_inline __always_inline bool __rwlockattr_getpshared(const pthread_rwlockattr_t* attr) {
   return (*attr & RWLOCKATTR_PSHARED_MASK) >> RWLOCKATTR_PSHARED_SHIFT;
@@ -126,7 +138,8 @@ int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t* attr, int* pref) {
 int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t* attr, int pref) {
   switch (pref) {
     case PTHREAD_RWLOCK_PREFER_READER_NP:   // Fall through.
-    case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:
+    case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:   // Fall through.
+    case PTHREAD_RWLOCK_SCALABLE_READERS_NP:
       __rwlockattr_setkind(attr, pref);
       return 0;
     default:
@@ -154,13 +167,29 @@ int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t* attr, int pref) {
 #define STATE_HAVE_PENDING_READERS_OR_WRITERS_FLAG \
           (STATE_HAVE_PENDING_READERS_FLAG | STATE_HAVE_PENDING_WRITERS_FLAG)
 
+// Reader counters of a PTHREAD_RWLOCK_SCALABLE_READERS_NP rwlock. Each counter has a cache line
+// of its own, so readers hashed to different counters don't share any cache line at all.
+#define BIG_READER_SHARD_COUNT 32
+
+struct BigReaderShard {
+  atomic_int reader_count;
+  char __pad[64 - sizeof(atomic_int)];
+};
+
+struct BigReaderShards {
+  BigReaderShard shards[BIG_READER_SHARD_COUNT];
+};
+
+static_assert(sizeof(BigReaderShard) == 64, "BigReaderShard should fill one cache line.");
+
 struct pthread_rwlock_internal_t {
   atomic_int state;
   atomic_int writer_tid;
 
   bool pshared;
   bool writer_nonrecursive_preferred;
-  uint16_t __pad;
+  bool big_reader;
+  uint8_t __pad;
 
 // When a reader thread plans to suspend on the rwlock, it will add STATE_HAVE_PENDING_READERS_FLAG
 // in state, increase pending_reader_count, and wait on pending_reader_wakeup_serial. After woken
@@ -174,10 +203,12 @@ struct pthread_rwlock_internal_t {
   uint32_t pending_reader_wakeup_serial;  // Pending reader threads wait on this address by futex_wait.
   uint32_t pending_writer_wakeup_serial;  // Pending writer threads wait on this address by futex_wait.
 
+  // Points to the BigReaderShards of a big-reader rwlock. It's kept as bytes because
+  // pthread_rwlock_t only guarantees 4-byte alignment.
+  char big_reader_shards[sizeof(BigReaderShards*)];
+
 #if defined(__LP64__)
-  char __reserved[20];
-#else
-  char __reserved[4];
+  char __reserved[12];
 #endif
 };
 
@@ -223,6 +254,39 @@ static inline __always_inline pthread_rwlock_internal_t* __get_internal_rwlock(p
   return reinterpret_cast<pthread_rwlock_internal_t*>(rwlock_interface);
 }
 
+static inline __always_inline BigReaderShards* __get_big_reader_shards(
+    const pthread_rwlock_internal_t* rwlock) {
+  BigReaderShards* shards;
+  memcpy(&shards, rwlock->big_reader_shards, sizeof(shards));
+  return shards;
+}
+
+static inline __always_inline void __set_big_reader_shards(pthread_rwlock_internal_t* rwlock,
+                                                           BigReaderShards* shards) {
+  memcpy(rwlock->big_reader_shards, &shards, sizeof(shards));
+}
+
+// A thread always uses the same shard, so it unlocks the counter it locked. This hashes the
+// thread's pthread_internal_t rather than its tid because the tid changes across fork.
+static inline __always_inline atomic_int* __big_reader_shard_for_self(
+    const pthread_rwlock_internal_t* rwlock) {
+  uintptr_t key = reinterpret_cast<uintptr_t>(__get_thread()) >> 12;
+  uint32_t hash = static_cast<uint32_t>(key) * 0x9e3779b9u;
+  size_t index = hash >> (32 - 5);
+  static_assert(BIG_READER_SHARD_COUNT == 1 << 5, "the hash above picks one of 32 shards");
+  return &__get_big_reader_shards(rwlock)->shards[index].reader_count;
+}
+
+static bool __big_reader_shards_drained(const pthread_rwlock_internal_t* rwlock) {
+  BigReaderShards* shards = __get_big_reader_shards(rwlock);
+  for (size_t i = 0; i < BIG_READER_SHARD_COUNT; ++i) {
+    if (atomic_load_explicit(&shards->shards[i].reader_count, memory_order_acquire) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 int pthread_rwlock_init(pthread_rwlock_t* rwlock_interface, const pthread_rwlockattr_t* attr) {
   pthread_rwlock_internal_t* rwlock = __get_internal_rwlock(rwlock_interface);
 
@@ -238,12 +302,28 @@ int pthread_rwlock_init(pthread_rwlock_t* rwlock_interface, const pthread_rwlock
       case PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP:
         rwlock->writer_nonrecursive_preferred = true;
         break;
+      case PTHREAD_RWLOCK_SCALABLE_READERS_NP:
+        // The reader counters live in this process's heap.
+        if (rwlock->pshared) {
+          return ENOTSUP;
+        }
+        rwlock->big_reader = true;
+        break;
       default:
         return EINVAL;
     }
     if ((*attr & RWLOCKATTR_RESERVED_MASK) != 0) {
       return EINVAL;
     }
+    if (rwlock->big_reader) {
+      void* shards = memalign(sizeof(BigReaderShard), sizeof(BigReaderShards));
+      if (shards == nullptr) {
+        rwlock->big_reader = false;
+        return ENOMEM;
+      }
+      memset(shards, 0, sizeof(BigReaderShards));
+      __set_big_reader_shards(rwlock, reinterpret_cast<BigReaderShards*>(shards));
+    }
   }
 
   atomic_init(&rwlock->state, 0);
@@ -257,6 +337,14 @@ int pthread_rwlock_destroy(pthread_rwlock_t* rwlock_interface) {
   if (atomic_load_explicit(&rwlock->state, memory_order_relaxed) != 0) {
     return EBUSY;
   }
+  if (rwlock->big_reader) {
+    if (!__big_reader_shards_drained(rwlock)) {
+      return EBUSY;
+    }
+    free(__get_big_reader_shards(rwlock));
+    __set_big_reader_shards(rwlock, nullptr);
+    rwlock->big_reader = false;
+  }
   return 0;
 }
 
@@ -269,7 +357,72 @@ static inline __always_inline bool __can_acquire_read_lock(int old_state,
   return !cannot_apply;
 }
 
+static void __pthread_rwlock_wake_pending(pthread_rwlock_internal_t* rwlock);
+
+// Drops a big-reader read lock. The last reader in a shard wakes the writer if one is waiting
+// for the shard to drain; only the writer owning the state word ever waits on a shard.
+static void __big_reader_rdunlock(pthread_rwlock_internal_t* rwlock, atomic_int* shard) {
+  int old_count = atomic_fetch_sub_explicit(shard, 1, memory_order_release);
+  __asymmetric_fence_light();
+  if (old_count == 1 &&
+      __state_owned_by_writer(atomic_load_explicit(&rwlock->state, memory_order_relaxed))) {
+    __futex_wake_ex(shard, false, 1);
+  }
+}
+
+static int __big_reader_tryrdlock(pthread_rwlock_internal_t* rwlock) {
+  atomic_int* shard = __big_reader_shard_for_self(rwlock);
+  atomic_fetch_add_explicit(shard, 1, memory_order_relaxed);
+  __asymmetric_fence_light();
+  if (__predict_true(!__state_owned_by_writer(atomic_load_explicit(&rwlock->state,
+                                                                    memory_order_acquire)))) {
+    return 0;
+  }
+  __big_reader_rdunlock(rwlock, shard);
+  return EBUSY;
+}
+
+// Called by a writer that already owns the state word, so no new reader can get in.
+static int __big_reader_wait_for_readers(pthread_rwlock_internal_t* rwlock,
+                                         const timespec* abs_timeout_or_null) {
+  __asymmetric_fence_heavy();
+  BigReaderShards* shards = __get_big_reader_shards(rwlock);
+  bool checked_timeout = false;
+  for (size_t i = 0; i < BIG_READER_SHARD_COUNT; ++i) {
+    atomic_int* shard = &shards->shards[i].reader_count;
+    int count;
+    while ((count = atomic_load_explicit(shard, memory_order_acquire)) != 0) {
+      // Like the other lock paths, the timeout only has to be valid if we have to wait.
+      if (!checked_timeout) {
+        int result = check_timespec(abs_timeout_or_null, true);
+        if (result != 0) {
+          return result;
+        }
+        checked_timeout = true;
+      }
+      int ret = __futex_wait_ex(shard, false, count, true, abs_timeout_or_null);
+      if (ret != 0 && ret != -EAGAIN && ret != -EINTR) {
+        return -ret;
+      }
+    }
+  }
+  return 0;
+}
+
+static void __pthread_rwlock_wrunlock(pthread_rwlock_internal_t* rwlock) {
+  atomic_store_explicit(&rwlock->writer_tid, 0, memory_order_relaxed);
+  int old_state = atomic_fetch_and_explicit(&rwlock->state, ~STATE_OWNED_BY_WRITER_FLAG,
+                                            memory_order_release);
+  if (__state_have_pending_readers_or_writers(old_state)) {
+    __pthread_rwlock_wake_pending(rwlock);
+  }
+}
+
 static inline __always_inline int __pthread_rwlock_tryrdlock(pthread_rwlock_internal_t* rwlock) {
+  if (__predict_false(rwlock->big_reader)) {
+    return __big_reader_tryrdlock(rwlock);
+  }
+
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
 
   while (__predict_true(__can_acquire_read_lock(old_state, rwlock->writer_nonrecursive_preferred))) {
@@ -345,7 +498,8 @@ static inline __always_inline bool __can_acquire_write_lock(int old_state) {
   return !__state_owned_by_readers_or_writer(old_state);
 }
 
-static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_internal_t* rwlock) {
+// Takes the state word, but leaves the readers of a big-reader rwlock for the caller to wait out.
+static inline __always_inline int __pthread_rwlock_trywrlock_state(pthread_rwlock_internal_t* rwlock) {
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
 
   while (__predict_true(__can_acquire_write_lock(old_state))) {
@@ -359,6 +513,18 @@ static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_inte
   return EBUSY;
 }
 
+static inline __always_inline int __pthread_rwlock_trywrlock(pthread_rwlock_internal_t* rwlock) {
+  int result = __pthread_rwlock_trywrlock_state(rwlock);
+  if (__predict_false(rwlock->big_reader) && result == 0) {
+    __asymmetric_fence_heavy();
+    if (!__big_reader_shards_drained(rwlock)) {
+      __pthread_rwlock_wrunlock(rwlock);
+      return EBUSY;
+    }
+  }
+  return result;
+}
+
 static int __pthread_rwlock_timedwrlock(pthread_rwlock_internal_t* rwlock,
                                         const timespec* abs_timeout_or_null) {
 
@@ -366,8 +532,14 @@ static int __pthread_rwlock_timedwrlock(pthread_rwlock_internal_t* rwlock,
     return EDEADLK;
   }
   while (true) {
-    int result = __pthread_rwlock_trywrlock(rwlock);
+    int result = __pthread_rwlock_trywrlock_state(rwlock);
     if (result == 0) {
+      if (__predict_false(rwlock->big_reader)) {
+        result = __big_reader_wait_for_readers(rwlock, abs_timeout_or_null);
+        if (result != 0) {
+          __pthread_rwlock_wrunlock(rwlock);
+        }
+      }
       return result;
     }
     result = check_timespec(abs_timeout_or_null, true);
@@ -451,16 +623,22 @@ int pthread_rwlock_unlock(pthread_rwlock_t* rwlock_interface) {
   pthread_rwlock_internal_t* rwlock = __get_internal_rwlock(rwlock_interface);
 
   int old_state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
-  if (__state_owned_by_writer(old_state)) {
-    if (atomic_load_explicit(&rwlock->writer_tid, memory_order_relaxed) != __get_thread()->tid) {
+  if (__state_owned_by_writer(old_state) &&
+      atomic_load_explicit(&rwlock->writer_tid, memory_order_relaxed) == __get_thread()->tid) {
+    __pthread_rwlock_wrunlock(rwlock);
+    return 0;
+
+  } else if (__predict_false(rwlock->big_reader)) {
+    // Big-reader readers hold their shard even while a writer waits for them to drain.
+    atomic_int* shard = __big_reader_shard_for_self(rwlock);
+    if (atomic_load_explicit(shard, memory_order_relaxed) == 0) {
       return EPERM;
     }
-    atomic_store_explicit(&rwlock->writer_tid, 0, memory_order_relaxed);
-    old_state = atomic_fetch_and_explicit(&rwlock->state, ~STATE_OWNED_BY_WRITER_FLAG,
-                                          memory_order_release);
-    if (!__state_have_pending_readers_or_writers(old_state)) {
-      return 0;
-    }
+    __big_reader_rdunlock(rwlock, shard);
+    return 0;
+
+  } else if (__state_owned_by_writer(old_state)) {
+    return EPERM;
 
   } else if (__state_owned_by_readers(old_state)) {
     old_state = atomic_fetch_sub_explicit(&rwlock->state, STATE_READER_COUNT_CHANGE_STEP,
@@ -473,6 +651,11 @@ int pthread_rwlock_unlock(pthread_rwlock_t* rwlock_interface) {
     return EPERM;
   }
 
+  __pthread_rwlock_wake_pending(rwlock);
+  return 0;
+}
+
+static void __pthread_rwlock_wake_pending(pthread_rwlock_internal_t* rwlock) {
   // Wake up pending readers or writers.
   rwlock->pending_lock.lock();
   if (rwlock->pending_writer_count != 0) {
@@ -491,5 +674,4 @@ int pthread_rwlock_unlock(pthread_rwlock_t* rwlock_interface) {
     // It happens when waiters are woken up by timeout.
     rwlock->pending_lock.unlock();
   }
-  return 0;
 }
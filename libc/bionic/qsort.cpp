@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// qsort is an introsort: quicksort with a median-of-three (or for bigger partitions, a
+// ninther) pivot, which falls back to heapsort if it recurses too deeply, and finishes
+// small partitions with insertion sort. Input that's already sorted, or reversed, is
+// spotted up front. Within the sort, a partition step that didn't have to move anything
+// is a hint that the partition is nearly sorted, so then both sides get a bounded
+// attempt at insertion sort. And as in pattern-defeating quicksort, a pivot equal to
+// an earlier pivot sets aside all the elements equal to it, so inputs with many
+// duplicate keys take linear time per distinct key.
+//
+// The common element sizes get their own instantiation, where swapping is a couple of
+// loads and stores rather than a loop.
+
+static constexpr size_t kInsertionSortMax = 16;
+static constexpr size_t kNintherMin = 128;
+static constexpr size_t kPartialInsertionSortMoves = 8;
+
+template <size_t kSize>
+struct FixedSize {
+  size_t size() const { return kSize; }
+
+  void swap(char* a, char* b) const {
+    char tmp[kSize];
+    memcpy(tmp, a, kSize);
+    memcpy(a, b, kSize);
+    memcpy(b, tmp, kSize);
+  }
+};
+
+struct VariableSize {
+  size_t es;
+
+  size_t size() const { return es; }
+
+  void swap(char* a, char* b) const {
+    size_t n = es;
+    for (; n >= sizeof(uint64_t); n -= sizeof(uint64_t)) {
+      uint64_t tmp;
+      memcpy(&tmp, a, sizeof(tmp));
+      memcpy(a, b, sizeof(tmp));
+      memcpy(b, &tmp, sizeof(tmp));
+      a += sizeof(tmp);
+      b += sizeof(tmp);
+    }
+    for (; n > 0; --n) {
+      char tmp = *a;
+      *a++ = *b;
+      *b++ = tmp;
+    }
+  }
+};
+
+struct Compare {
+  int (*fn)(const void*, const void*);
+
+  int operator()(const char* a, const char* b) const { return fn(a, b); }
+};
+
+struct CompareWithArg {
+  int (*fn)(const void*, const void*, void*);
+  void* arg;
+
+  int operator()(const char* a, const char* b) const { return fn(a, b, arg); }
+};
+
+template <typename Element, typename Cmp>
+class Sorter {
+ public:
+  Sorter(Element element, Cmp cmp) : element_(element), cmp_(cmp) {}
+
+  void sort(char* base, size_t n) {
+    if (n > kInsertionSortMax && presorted(base, n)) return;
+    size_t depth_limit = 0;
+    for (size_t i = n; i > 1; i >>= 1) depth_limit += 2;
+    introsort(base, n, nullptr, depth_limit);
+  }
+
+ private:
+  char* at(char* base, size_t i) const { return base + i * element_.size(); }
+
+  bool less(char* a, char* b) const { return cmp_(a, b) < 0; }
+
+  void swap(char* a, char* b) const { element_.swap(a, b); }
+
+  char* median_of_three(char* a, char* b, char* c) const {
+    return less(a, b) ? (less(b, c) ? b : (less(a, c) ? c : a))
+                      : (less(c, b) ? b : (less(c, a) ? c : a));
+  }
+
+  char* choose_pivot(char* base, size_t n) const {
+    char* lo = base;
+    char* mid = at(base, n / 2);
+    char* hi = at(base, n - 1);
+    if (n >= kNintherMin) {
+      size_t d = (n / 8) * element_.size();
+      lo = median_of_three(lo, lo + d, lo + 2 * d);
+      mid = median_of_three(mid - d, mid, mid + d);
+      hi = median_of_three(hi - 2 * d, hi - d, hi);
+    }
+    return median_of_three(lo, mid, hi);
+  }
+
+  // Returns true if base[0, n) was already in order, or in strictly descending order,
+  // which it reverses. Otherwise this usually gives up after a few comparisons.
+  bool presorted(char* base, size_t n) const {
+    size_t es = element_.size();
+    char* end = at(base, n);
+    char* p = base + es;
+    if (less(p, base)) {
+      while (p + es < end && less(p + es, p)) p += es;
+      if (p + es != end) return false;
+      for (char* lo = base, *hi = end - es; lo < hi; lo += es, hi -= es) swap(lo, hi);
+      return true;
+    }
+    while (p + es < end && !less(p + es, p)) p += es;
+    return p + es == end;
+  }
+
+  void insertion_sort(char* base, size_t n) const {
+    size_t es = element_.size();
+    char* end = at(base, n);
+    for (char* p = base + es; p < end; p += es) {
+      for (char* q = p; q > base && less(q, q - es); q -= es) {
+        swap(q, q - es);
+      }
+    }
+  }
+
+  // Like insertion_sort, but gives up (returning false) once it has moved more than a
+  // few elements, in which case the partition is left for quicksort to sort.
+  bool partial_insertion_sort(char* base, size_t n) const {
+    size_t es = element_.size();
+    char* end = at(base, n);
+    size_t moves = 0;
+    for (char* p = base + es; p < end; p += es) {
+      if (!less(p, p - es)) continue;
+      if (++moves > kPartialInsertionSortMoves) return false;
+      for (char* q = p; q > base && less(q, q - es); q -= es) {
+        swap(q, q - es);
+      }
+    }
+    return true;
+  }
+
+  void sift_down(char* base, size_t root, size_t n) const {
+    while (true) {
+      size_t child = 2 * root + 1;
+      if (child >= n) return;
+      if (child + 1 < n && less(at(base, child), at(base, child + 1))) ++child;
+      if (!less(at(base, root), at(base, child))) return;
+      swap(at(base, root), at(base, child));
+      root = child;
+    }
+  }
+
+  void heapsort(char* base, size_t n) const {
+    for (size_t i = n / 2; i > 0; --i) {
+      sift_down(base, i - 1, n);
+    }
+    for (size_t i = n - 1; i > 0; --i) {
+      swap(base, at(base, i));
+      sift_down(base, 0, i);
+    }
+  }
+
+  // Partitions around base[0], stopping on elements equal to the pivot from both sides
+  // so that runs of equal elements split evenly. Returns the pivot's final index, and
+  // sets *moved if anything other than the pivot had to move.
+  size_t partition(char* base, size_t n, bool* moved) const {
+    size_t es = element_.size();
+    char* lo = base + es;
+    char* hi = at(base, n - 1);
+    *moved = false;
+    while (true) {
+      while (lo <= hi && less(lo, base)) lo += es;
+      while (lo <= hi && less(base, hi)) hi -= es;
+      if (lo >= hi) break;
+      swap(lo, hi);
+      *moved = true;
+      lo += es;
+      hi -= es;
+    }
+    swap(base, hi);
+    return (hi - base) / es;
+  }
+
+  // Partitions around base[0], putting every element equal to the pivot on its left.
+  // Returns the pivot's final index.
+  size_t partition_equal_left(char* base, size_t n) const {
+    size_t es = element_.size();
+    char* lo = base + es;
+    char* hi = at(base, n - 1);
+    while (true) {
+      while (lo <= hi && !less(base, lo)) lo += es;
+      while (lo <= hi && less(base, hi)) hi -= es;
+      if (lo >= hi) break;
+      swap(lo, hi);
+      lo += es;
+      hi -= es;
+    }
+    swap(base, hi);
+    return (hi - base) / es;
+  }
+
+  // pred is the element just before base, a pivot from an enclosing partition step, or
+  // null if base is the start of the whole array. Everything in base[0, n) is at least
+  // *pred, so a pivot equal to *pred means all its equals can be set aside in one pass.
+  void introsort(char* base, size_t n, char* pred, size_t depth_limit) const {
+    while (n > kInsertionSortMax) {
+      if (depth_limit-- == 0) {
+        heapsort(base, n);
+        return;
+      }
+
+      swap(base, choose_pivot(base, n));
+      if (pred != nullptr && !less(pred, base)) {
+        size_t p = partition_equal_left(base, n);
+        pred = at(base, p);
+        base = pred + element_.size();
+        n -= p + 1;
+        continue;
+      }
+
+      bool moved;
+      size_t p = partition(base, n, &moved);
+      char* left = base;
+      size_t left_n = p;
+      char* right = at(base, p + 1);
+      size_t right_n = n - p - 1;
+
+      if (!moved && partial_insertion_sort(left, left_n) &&
+          partial_insertion_sort(right, right_n)) {
+        return;
+      }
+
+      // Recurse into the smaller side and loop on the bigger one, to bound stack use.
+      if (left_n < right_n) {
+        introsort(left, left_n, pred, depth_limit);
+        pred = at(base, p);
+        base = right;
+        n = right_n;
+      } else {
+        introsort(right, right_n, at(base, p), depth_limit);
+        n = left_n;
+      }
+    }
+    insertion_sort(base, n);
+  }
+
+  Element element_;
+  Cmp cmp_;
+};
+
+template <typename Cmp>
+static void sort(void* base, size_t n, size_t es, Cmp cmp) {
+  if (n < 2 || es == 0) return;
+  char* p = static_cast<char*>(base);
+  switch (es) {
+    case 4:
+      Sorter<FixedSize<4>, Cmp>(FixedSize<4>(), cmp).sort(p, n);
+      break;
+    case 8:
+      Sorter<FixedSize<8>, Cmp>(FixedSize<8>(), cmp).sort(p, n);
+      break;
+    case 16:
+      Sorter<FixedSize<16>, Cmp>(FixedSize<16>(), cmp).sort(p, n);
+      break;
+    default:
+      Sorter<VariableSize, Cmp>(VariableSize{es}, cmp).sort(p, n);
+      break;
+  }
+}
+
+void qsort(void* base, size_t n, size_t es, int (*cmp)(const void*, const void*)) {
+  sort(base, n, es, Compare{cmp});
+}
+
+void qsort_r(void* base, size_t n, size_t es, int (*cmp)(const void*, const void*, void*),
+             void* arg) {
+  sort(base, n, es, CompareWithArg{cmp, arg});
+}
@@ -34,11 +34,21 @@
 
 #include <semaphore.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
 
+#include "private/ScopedPthreadMutexLocker.h"
 #include "private/bionic_constants.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_sdk_version.h"
@@ -122,21 +132,206 @@ int sem_destroy(sem_t*) {
   return 0;
 }
 
-sem_t* sem_open(const char*, int, ...) {
-  errno = ENOSYS;
-  return SEM_FAILED;
+// Named semaphores are process-shared semaphores in files in a tmpfs,
+// mapped MAP_SHARED, so that posting and waiting work exactly as they do
+// for sem_init(sem, 1, value): only contention costs a (shared) futex
+// syscall. Without the directory, sem_open fails with ENOSYS as it used to.
+//
+// A new semaphore is initialized in a file with a temporary name and then
+// linked to its real one, so nobody can open one that isn't initialized.
+// Opening one a process already has open returns the same address, as POSIX
+// requires, so we keep a list of those with their open counts.
+
+#define SEM_DIR "/dev/shm/"
+#define SEM_PREFIX "sem."
+
+struct named_sem {
+  named_sem* next;
+  sem_t* sem;
+  dev_t dev;
+  ino_t ino;
+  size_t open_count;
+};
+
+static pthread_mutex_t g_named_sems_lock = PTHREAD_MUTEX_INITIALIZER;
+static named_sem* g_named_sems = nullptr;
+
+static bool sem_path(const char* name, char* path, size_t path_size) {
+  while (*name == '/') ++name;
+  if (*name == '\0' || strchr(name, '/') != nullptr ||
+      strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+    errno = EINVAL;
+    return false;
+  }
+  if (strlen(name) > NAME_MAX - strlen(SEM_PREFIX) ||
+      static_cast<size_t>(snprintf(path, path_size, SEM_DIR SEM_PREFIX "%s", name)) >= path_size) {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  return true;
 }
 
-int sem_close(sem_t*) {
-  errno = ENOSYS;
-  return -1;
+// Maps the semaphore in fd, or finds the mapping we already have of it.
+// Takes ownership of fd.
+static sem_t* sem_map(int fd) {
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    close(fd);
+    return SEM_FAILED;
+  }
+  if (sb.st_size < static_cast<off_t>(sizeof(sem_t))) {
+    close(fd);
+    errno = EINVAL;
+    return SEM_FAILED;
+  }
+
+  ScopedPthreadMutexLocker locker(&g_named_sems_lock);
+  for (named_sem* s = g_named_sems; s != nullptr; s = s->next) {
+    if (s->dev == sb.st_dev && s->ino == sb.st_ino) {
+      close(fd);
+      ++s->open_count;
+      return s->sem;
+    }
+  }
+
+  named_sem* s = static_cast<named_sem*>(malloc(sizeof(named_sem)));
+  if (s == nullptr) {
+    close(fd);
+    return SEM_FAILED;
+  }
+  void* map = mmap(nullptr, sizeof(sem_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    free(s);
+    return SEM_FAILED;
+  }
+
+  s->sem = static_cast<sem_t*>(map);
+  s->dev = sb.st_dev;
+  s->ino = sb.st_ino;
+  s->open_count = 1;
+  s->next = g_named_sems;
+  g_named_sems = s;
+  return s->sem;
+}
+
+// Creates an initialized semaphore with a temporary name, and links it to
+// path. Returns 1 on success, with *fd_out open to it, 0 if path already
+// exists, or -1 on error. (We keep the fd we created it with because mode
+// needn't let us open it again.)
+static int sem_create(const char* path, mode_t mode, unsigned int value, int* fd_out) {
+  char tmp_path[sizeof(SEM_DIR SEM_PREFIX) + 32];
+  int fd = -1;
+  for (int attempt = 0; fd == -1 && attempt < 100; ++attempt) {
+    snprintf(tmp_path, sizeof(tmp_path), SEM_DIR SEM_PREFIX "tmp-%08x%08x",
+             arc4random(), arc4random());
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, mode);
+    if (fd == -1 && errno != EEXIST) {
+      if (errno == ENOENT) errno = ENOSYS;  // No SEM_DIR.
+      return -1;
+    }
+  }
+  if (fd == -1) return -1;
+
+  sem_t sem;
+  memset(&sem, 0, sizeof(sem));
+  sem_init(&sem, 1, value);
+  ssize_t rc = TEMP_FAILURE_RETRY(write(fd, &sem, sizeof(sem)));
+
+  int result = -1;
+  if (rc == static_cast<ssize_t>(sizeof(sem))) {
+    if (link(tmp_path, path) == 0) {
+      result = 1;
+    } else if (errno == EEXIST) {
+      result = 0;
+    }
+  } else if (rc != -1) {
+    errno = ENOSPC;
+  }
+  int saved_errno = errno;
+  unlink(tmp_path);
+  if (result == 1) {
+    *fd_out = fd;
+  } else {
+    close(fd);
+  }
+  errno = saved_errno;
+  return result;
 }
 
-int sem_unlink(const char*) {
-  errno = ENOSYS;
+sem_t* sem_open(const char* name, int flags, ...) {
+  char path[PATH_MAX];
+  if (!sem_path(name, path, sizeof(path))) {
+    return SEM_FAILED;
+  }
+
+  mode_t mode = 0;
+  unsigned int value = 0;
+  if ((flags & O_CREAT) != 0) {
+    va_list args;
+    va_start(args, flags);
+    mode = static_cast<mode_t>(va_arg(args, int));
+    value = va_arg(args, unsigned int);
+    va_end(args);
+    if (value > SEM_VALUE_MAX) {
+      errno = EINVAL;
+      return SEM_FAILED;
+    }
+  }
+
+  // Open an existing semaphore or create a new one, trying again if someone
+  // else creates it in between.
+  while (true) {
+    if ((flags & (O_CREAT | O_EXCL)) != (O_CREAT | O_EXCL)) {
+      int fd = open(path, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+      if (fd != -1) {
+        return sem_map(fd);
+      }
+      if (errno != ENOENT || (flags & O_CREAT) == 0) {
+        return SEM_FAILED;
+      }
+    }
+
+    int fd;
+    int rc = sem_create(path, mode, value, &fd);
+    if (rc == 1) {
+      return sem_map(fd);
+    }
+    if (rc == -1) {
+      return SEM_FAILED;
+    }
+    if ((flags & O_EXCL) != 0) {
+      errno = EEXIST;
+      return SEM_FAILED;
+    }
+  }
+}
+
+int sem_close(sem_t* sem) {
+  ScopedPthreadMutexLocker locker(&g_named_sems_lock);
+  for (named_sem** p = &g_named_sems; *p != nullptr; p = &(*p)->next) {
+    named_sem* s = *p;
+    if (s->sem == sem) {
+      if (--s->open_count == 0) {
+        *p = s->next;
+        munmap(s->sem, sizeof(sem_t));
+        free(s);
+      }
+      return 0;
+    }
+  }
+  errno = EINVAL;
   return -1;
 }
 
+int sem_unlink(const char* name) {
+  char path[PATH_MAX];
+  if (!sem_path(name, path, sizeof(path))) {
+    return -1;
+  }
+  return unlink(path);
+}
+
 // Decrement a semaphore's value atomically,
 // and return the old one. As a special case,
 // this returns immediately if the value is
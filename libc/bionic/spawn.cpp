@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <spawn.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/bionic_macros.h"
+#include "private/bionic_page.h"
+#include "private/kernel_sigset_t.h"
+
+extern "C" int __rt_sigprocmask(int, const kernel_sigset_t*, kernel_sigset_t*, size_t);
+
+struct __posix_spawnattr {
+  short flags;
+  pid_t pgroup;
+  sigset_t sigmask;
+  sigset_t sigdefault;
+  int schedpolicy;
+  sched_param schedparam;
+};
+
+enum SpawnFileActionType { kOpen, kClose, kDup2 };
+
+struct SpawnFileAction {
+  SpawnFileAction* next;
+  SpawnFileActionType type;
+  int fd;
+  int new_fd;  // For kDup2.
+  int flags;   // For kOpen.
+  mode_t mode;
+  char path[];
+};
+
+struct __posix_spawn_file_actions {
+  SpawnFileAction* head;
+  SpawnFileAction* tail;
+};
+
+// Everything the child needs. It lives on the parent's stack, which the child
+// can still see because it shares the parent's memory until it calls exec.
+struct SpawnArgs {
+  const char* path;
+  char* const* argv;
+  char* const* envp;
+  const __posix_spawn_file_actions* actions;
+  const __posix_spawnattr* attr;
+  int (*exec_fn)(const char*, char* const*, char* const*);
+  kernel_sigset_t parent_mask;
+  int error;  // Set by the child if anything fails.
+};
+
+static int RunFileAction(const SpawnFileAction* action) {
+  switch (action->type) {
+    case kOpen: {
+      int fd = open(action->path, action->flags, action->mode);
+      if (fd == -1) return -1;
+      if (fd != action->fd) {
+        if (dup2(fd, action->fd) == -1) return -1;
+        close(fd);
+      }
+      return 0;
+    }
+    case kClose:
+      // POSIX allows closing an fd that isn't open to either fail or succeed.
+      close(action->fd);
+      return 0;
+    case kDup2:
+      if (action->fd == action->new_fd) {
+        // dup2 would do nothing here, so clear FD_CLOEXEC as POSIX asks.
+        int flags = fcntl(action->fd, F_GETFD);
+        if (flags == -1) return -1;
+        return fcntl(action->fd, F_SETFD, flags & ~FD_CLOEXEC);
+      }
+      return dup2(action->fd, action->new_fd) == -1 ? -1 : 0;
+  }
+  return 0;
+}
+
+static int SpawnChild(void* arg) {
+  SpawnArgs* args = reinterpret_cast<SpawnArgs*>(arg);
+  const __posix_spawnattr* attr = args->attr;
+  short flags = (attr != nullptr) ? attr->flags : 0;
+
+  // Until exec, a signal handler installed by the parent would run here on the
+  // child's stack but with the parent's memory, so reset every handler to the
+  // default before unblocking signals. Ignored signals stay ignored, unless
+  // POSIX_SPAWN_SETSIGDEF asks for them to be reset too.
+  struct sigaction dfl = {};
+  dfl.sa_handler = SIG_DFL;
+  for (int sig = 1; sig < _NSIG; ++sig) {
+    struct sigaction current;
+    if (sigaction(sig, nullptr, &current) == -1) continue;
+    bool reset = current.sa_handler != SIG_DFL && current.sa_handler != SIG_IGN;
+    if ((flags & POSIX_SPAWN_SETSIGDEF) && sigismember(&attr->sigdefault, sig) == 1) {
+      reset = true;
+    }
+    if (reset) sigaction(sig, &dfl, nullptr);
+  }
+
+  if ((flags & POSIX_SPAWN_SETSID) && setsid() == -1) goto fail;
+  if ((flags & POSIX_SPAWN_SETPGROUP) && setpgid(0, attr->pgroup) == -1) goto fail;
+  if (flags & POSIX_SPAWN_SETSCHEDULER) {
+    if (sched_setscheduler(0, attr->schedpolicy, &attr->schedparam) == -1) goto fail;
+  } else if (flags & POSIX_SPAWN_SETSCHEDPARAM) {
+    if (sched_setparam(0, &attr->schedparam) == -1) goto fail;
+  }
+  if (flags & POSIX_SPAWN_RESETIDS) {
+    if (setgid(getgid()) == -1 || setuid(getuid()) == -1) goto fail;
+  }
+
+  if (args->actions != nullptr) {
+    for (const SpawnFileAction* action = args->actions->head; action != nullptr;
+         action = action->next) {
+      if (RunFileAction(action) == -1) goto fail;
+    }
+  }
+
+  if (flags & POSIX_SPAWN_SETSIGMASK) {
+    sigprocmask(SIG_SETMASK, &attr->sigmask, nullptr);
+  } else {
+    __rt_sigprocmask(SIG_SETMASK, &args->parent_mask, nullptr, sizeof(args->parent_mask));
+  }
+
+  args->exec_fn(args->path, args->argv, (args->envp != nullptr) ? args->envp : environ);
+
+fail:
+  args->error = errno;
+  _exit(127);
+}
+
+static int PosixSpawnExecve(const char* path, char* const* argv, char* const* envp) {
+  // posix_spawn, unlike posix_spawnp, doesn't fall back to running a script with sh.
+  return execve(path, argv, envp);
+}
+
+// The child runs exec on this stack, and execvpe's buffers (a copy of $PATH, each
+// candidate path, and an argv for running a script) are all on the stack too.
+static size_t SpawnStackSize(char* const* argv, bool search_path) {
+  size_t argc = 0;
+  while (argv[argc] != nullptr) ++argc;
+  size_t size = 16 * 1024 + (argc + 2) * sizeof(char*);
+  if (search_path) {
+    const char* path = getenv("PATH");
+    size += 2 * PATH_MAX + ((path != nullptr) ? strlen(path) : 0);
+  }
+  return PAGE_END(size);
+}
+
+static int DoPosixSpawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* actions,
+                        const posix_spawnattr_t* attr, char* const argv[], char* const envp[],
+                        bool search_path) {
+  ErrnoRestorer errno_restorer;
+
+  size_t stack_size = SpawnStackSize(argv, search_path);
+  void* stack = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (stack == MAP_FAILED) return errno;
+
+  SpawnArgs args;
+  args.path = path;
+  args.argv = argv;
+  args.envp = envp;
+  args.actions = (actions != nullptr) ? *actions : nullptr;
+  args.attr = (attr != nullptr) ? *attr : nullptr;
+  args.exec_fn = search_path ? execvpe : PosixSpawnExecve;
+  args.error = 0;
+
+  // Block every signal, so that none of our handlers can run in the child
+  // before it has reset them.
+  kernel_sigset_t all;
+  memset(static_cast<void*>(&all), 0xff, sizeof(all));
+  __rt_sigprocmask(SIG_SETMASK, &all, &args.parent_mask, sizeof(all));
+
+  // CLONE_VFORK suspends us until the child execs or exits, and CLONE_VM
+  // means there's no copy of our page tables or pthread_atfork handlers to
+  // run, so this costs the same however big we are.
+  void* stack_top = reinterpret_cast<char*>(stack) + stack_size;
+  pid_t child = clone(SpawnChild, stack_top, CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+  int error = (child == -1) ? errno : args.error;
+  if (child != -1 && error != 0) {
+    // The child failed before exec, so it's already exiting. Reap it.
+    TEMP_FAILURE_RETRY(waitpid(child, nullptr, 0));
+  }
+
+  __rt_sigprocmask(SIG_SETMASK, &args.parent_mask, nullptr, sizeof(args.parent_mask));
+  munmap(stack, stack_size);
+
+  if (error == 0 && pid != nullptr) *pid = child;
+  return error;
+}
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* actions,
+                const posix_spawnattr_t* attr, char* const argv[], char* const envp[]) {
+  return DoPosixSpawn(pid, path, actions, attr, argv, envp, false);
+}
+
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* actions,
+                 const posix_spawnattr_t* attr, char* const argv[], char* const envp[]) {
+  return DoPosixSpawn(pid, file, actions, attr, argv, envp, true);
+}
+
+int posix_spawnattr_init(posix_spawnattr_t* attr) {
+  *attr = reinterpret_cast<__posix_spawnattr*>(calloc(1, sizeof(__posix_spawnattr)));
+  return (*attr == nullptr) ? errno : 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t* attr) {
+  free(*attr);
+  *attr = nullptr;
+  return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags) {
+  if ((flags & ~(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF |
+                 POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSCHEDPARAM | POSIX_SPAWN_SETSCHEDULER |
+                 POSIX_SPAWN_USEVFORK | POSIX_SPAWN_SETSID)) != 0) {
+    return EINVAL;
+  }
+  (*attr)->flags = flags;
+  return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags) {
+  *flags = (*attr)->flags;
+  return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t* attr, pid_t pgroup) {
+  (*attr)->pgroup = pgroup;
+  return 0;
+}
+
+int posix_spawnattr_getpgroup(const posix_spawnattr_t* attr, pid_t* pgroup) {
+  *pgroup = (*attr)->pgroup;
+  return 0;
+}
+
+int posix_spawnattr_setsigmask(posix_spawnattr_t* attr, const sigset_t* mask) {
+  (*attr)->sigmask = *mask;
+  return 0;
+}
+
+int posix_spawnattr_getsigmask(const posix_spawnattr_t* attr, sigset_t* mask) {
+  *mask = (*attr)->sigmask;
+  return 0;
+}
+
+int posix_spawnattr_setsigdefault(posix_spawnattr_t* attr, const sigset_t* mask) {
+  (*attr)->sigdefault = *mask;
+  return 0;
+}
+
+int posix_spawnattr_getsigdefault(const posix_spawnattr_t* attr, sigset_t* mask) {
+  *mask = (*attr)->sigdefault;
+  return 0;
+}
+
+int posix_spawnattr_setschedparam(posix_spawnattr_t* attr, const struct sched_param* param) {
+  (*attr)->schedparam = *param;
+  return 0;
+}
+
+int posix_spawnattr_getschedparam(const posix_spawnattr_t* attr, struct sched_param* param) {
+  *param = (*attr)->schedparam;
+  return 0;
+}
+
+int posix_spawnattr_setschedpolicy(posix_spawnattr_t* attr, int policy) {
+  (*attr)->schedpolicy = policy;
+  return 0;
+}
+
+int posix_spawnattr_getschedpolicy(const posix_spawnattr_t* attr, int* policy) {
+  *policy = (*attr)->schedpolicy;
+  return 0;
+}
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* actions) {
+  *actions = reinterpret_cast<__posix_spawn_file_actions*>(
+      calloc(1, sizeof(__posix_spawn_file_actions)));
+  return (*actions == nullptr) ? errno : 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* actions) {
+  SpawnFileAction* action = (*actions)->head;
+  while (action != nullptr) {
+    SpawnFileAction* next = action->next;
+    free(action);
+    action = next;
+  }
+  free(*actions);
+  *actions = nullptr;
+  return 0;
+}
+
+static int AddFileAction(posix_spawn_file_actions_t* actions, SpawnFileActionType type, int fd,
+                         int new_fd, const char* path, int flags, mode_t mode) {
+  if (fd < 0 || new_fd < 0) return EBADF;
+
+  size_t path_size = (path != nullptr) ? strlen(path) + 1 : 0;
+  SpawnFileAction* action =
+      reinterpret_cast<SpawnFileAction*>(malloc(sizeof(SpawnFileAction) + path_size));
+  if (action == nullptr) return errno;
+
+  action->next = nullptr;
+  action->type = type;
+  action->fd = fd;
+  action->new_fd = new_fd;
+  action->flags = flags;
+  action->mode = mode;
+  if (path != nullptr) memcpy(action->path, path, path_size);
+
+  if ((*actions)->tail != nullptr) {
+    (*actions)->tail->next = action;
+  } else {
+    (*actions)->head = action;
+  }
+  (*actions)->tail = action;
+  return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* actions, int fd,
+                                     const char* path, int flags, mode_t mode) {
+  return AddFileAction(actions, kOpen, fd, 0, path, flags, mode);
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* actions, int fd) {
+  return AddFileAction(actions, kClose, fd, 0, nullptr, 0, 0);
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* actions, int fd, int new_fd) {
+  return AddFileAction(actions, kDup2, fd, new_fd, nullptr, 0, 0);
+}
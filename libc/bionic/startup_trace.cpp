@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2015 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_startup_trace.h"
+
+#include <string.h>
+#include <sys/auxv.h>
+#include <time.h>
+
+#include "private/KernelArgumentBlock.h"
+#include "private/bionic_constants.h"
+
+startup_trace* __libc_startup_trace;
+
+static startup_trace g_startup_trace;
+
+void __libc_init_startup_trace(KernelArgumentBlock& args) {
+  // The environment hasn't been sanitized yet, so check AT_SECURE ourselves.
+  if (args.getauxval(AT_SECURE)) return;
+  for (char** env = args.envp; *env != nullptr; ++env) {
+    if (strcmp(*env, "LIBC_STARTUP_TRACE=1") == 0) {
+      __libc_startup_trace = args.startup_trace = &g_startup_trace;
+      __libc_record_startup_phase(&g_startup_trace, "start");
+      return;
+    }
+  }
+}
+
+void __libc_record_startup_phase(startup_trace* trace, const char* name) {
+  if (trace->count == STARTUP_TRACE_MAX_PHASES) return;
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  trace->phases[trace->count].name = name;
+  trace->phases[trace->count].time_ns = static_cast<int64_t>(ts.tv_sec) * NS_PER_S + ts.tv_nsec;
+  ++trace->count;
+}
+
+size_t android_get_startup_phases(android_startup_phase* phases, size_t count) {
+  startup_trace* trace = __libc_startup_trace;
+  if (trace == nullptr) return 0;
+  if (count > trace->count) count = trace->count;
+  memcpy(phases, trace->phases, count * sizeof(*phases));
+  return trace->count;
+}
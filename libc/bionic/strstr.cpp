@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <string.h>
+
+// memmem is fast, and linear in the worst case, but it needs to know how long the
+// haystack is, and working that out first would make finding an early match slow. So
+// this finds the end of the haystack a chunk at a time, doubling the chunk size, and
+// searches each chunk with memmem as it goes. Chunks overlap by the needle's length
+// less one, so that matches that cross from one to the next are still found.
+char* strstr(const char* haystack, const char* needle) {
+  if (needle[0] == '\0') return const_cast<char*>(haystack);
+  if (needle[1] == '\0') return strchr(haystack, needle[0]);
+
+  const size_t m = strlen(needle);
+  // Matches can't start before searched, and there's no terminator before known.
+  size_t searched = 0;
+  size_t known = strnlen(haystack, m + 256);
+  while (true) {
+    if (known >= m) {
+      void* match = memmem(haystack + searched, known - searched, needle, m);
+      if (match != nullptr) return static_cast<char*>(match);
+      searched = known - m + 1;
+    }
+    size_t more = strnlen(haystack + known, (known < 4096) ? 4096 : known);
+    if (more == 0) return nullptr;
+    known += more;
+  }
+}
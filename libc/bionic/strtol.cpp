@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <limits>
+#include <type_traits>
+
+#include "private/bionic_page.h"
+
+// The integer parsers, rewritten from OpenBSD's to share one implementation
+// and to be quicker at what protocol and file parsers mostly ask of them:
+// short runs of decimal digits. Digits and letters are recognized without
+// going through the ctype tables, decimal numbers are taken 8 digits at a
+// time where that's safe, and the accumulation is done unsigned, so that
+// overflow is checked against a single precomputed cutoff. Whitespace is
+// still skipped with isspace, and the results, errno and end pointer are
+// exactly as before (including OpenBSD's treatment of "0x" followed by
+// something other than a hex digit as no number at all).
+
+// Returns the value of the digit c, or 36 (too big for any base) if it isn't one.
+static inline unsigned DigitValue(unsigned char c) {
+  if (static_cast<unsigned>(c - '0') < 10) return c - '0';
+  c |= 0x20;  // Lower case, for letters.
+  if (static_cast<unsigned>(c - 'a') < 26) return c - 'a' + 10;
+  return 36;
+}
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HAVE_EIGHT_DIGITS 1
+
+// Whether p to p + 8 is on a single page, so that loading it can't fault
+// wherever the string ends.
+static inline bool CanLoadEightBytes(const char* p) {
+  return (reinterpret_cast<uintptr_t>(p) & (PAGE_SIZE - 1)) <= PAGE_SIZE - 8;
+}
+
+// The bytes may run past the end of the string. That's fine as long as they're
+// on the same page, and they're only used if they're all digits, which they
+// can't be if the string ends among them.
+__attribute__((no_sanitize("address")))
+static inline uint64_t LoadEightBytes(const char* p) {
+  uint64_t w;
+  __builtin_memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+static inline bool AllDigits(uint64_t w) {
+  // Each byte must be 0x3X, and still 0x3X after adding 6, so X is 0-9.
+  constexpr uint64_t kHighNibbles = 0xf0f0f0f0f0f0f0f0ULL;
+  return ((w & kHighNibbles) | (((w + 0x0606060606060606ULL) & kHighNibbles) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+// The value of eight decimal digits, the first in the lowest byte.
+static inline uint32_t EightDigitsValue(uint64_t w) {
+  w -= 0x3030303030303030ULL;
+  // Combine adjacent digits into pairs, then pairs into fours, then the fours.
+  w = (w * 10) + (w >> 8);
+  w = (((w & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32))) +
+       (((w >> 16) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32)))) >> 32;
+  return static_cast<uint32_t>(w);
+}
+#endif
+
+template <typename T>
+static T StrToI(const char* nptr, char** endptr, int base) {
+  typedef typename std::make_unsigned<T>::type U;
+  constexpr bool is_signed = std::is_signed<T>::value;
+
+  // Ensure that base is between 2 and 36 inclusive, or the special value of 0.
+  if (base < 0 || base == 1 || base > 36) {
+    if (endptr != nullptr) *endptr = const_cast<char*>(nptr);
+    errno = EINVAL;
+    return 0;
+  }
+
+  // Skip white space and pick up leading +/- sign if any. If base is 0, allow
+  // 0x for hex and 0 for octal, else assume decimal; if base is already 16,
+  // allow 0x.
+  const char* p = nptr;
+  while (isspace(static_cast<unsigned char>(*p))) ++p;
+  bool neg = false;
+  if (*p == '-') {
+    neg = true;
+    ++p;
+  } else if (*p == '+') {
+    ++p;
+  }
+  if ((base == 0 || base == 16) && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    p += 2;
+    base = 16;
+  }
+  if (base == 0) base = (*p == '0') ? 8 : 10;
+
+  // The largest magnitude that can be returned, which is one more for negative
+  // numbers when T is signed. (Negative numbers for an unsigned T are parsed as
+  // positive and then negated, as C requires.)
+  U limit = std::numeric_limits<T>::max();
+  if (is_signed && neg) ++limit;
+  const U cutoff = limit / base;
+  const unsigned cutlim = limit % base;
+
+  // any is 1 if digits have been consumed, or -1 if they overflowed.
+  U acc = 0;
+  int any = 0;
+
+  if (base == 10) {
+    // Most numbers are short, so start one digit at a time, and only try
+    // eight at a time once there have been a few.
+    for (;; ++p) {
+      unsigned digit = static_cast<unsigned char>(*p) - '0';
+      if (digit > 9) break;
+      if (acc > cutoff || (acc == cutoff && digit > cutlim)) {
+        any = -1;
+        break;
+      }
+      acc = acc * 10 + digit;
+      any = 1;
+#if defined(HAVE_EIGHT_DIGITS)
+      if (acc >= 1000) {
+        ++p;
+        while (CanLoadEightBytes(p)) {
+          uint64_t w = LoadEightBytes(p);
+          if (!AllDigits(w)) break;
+          uint32_t value = EightDigitsValue(w);
+          // Leave anything that might overflow to the loop.
+          if (acc > (limit - value) / 100000000) break;
+          acc = acc * 100000000 + value;
+          p += 8;
+        }
+        --p;
+      }
+#endif
+    }
+    if (any < 0) {
+      // Overflowed: consume the rest of the digits.
+      while (static_cast<unsigned>(static_cast<unsigned char>(*p) - '0') <= 9) ++p;
+      acc = limit;
+      errno = ERANGE;
+    }
+  } else {
+    for (;; ++p) {
+      unsigned digit = DigitValue(*p);
+      if (digit >= static_cast<unsigned>(base)) break;
+      if (any < 0) continue;
+      if (acc > cutoff || (acc == cutoff && digit > cutlim)) {
+        any = -1;
+        acc = limit;
+        errno = ERANGE;
+      } else {
+        any = 1;
+        acc = acc * base + digit;
+      }
+    }
+  }
+
+  if (endptr != nullptr) *endptr = const_cast<char*>(any ? p : nptr);
+  if (any < 0) {
+    return (is_signed && neg) ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+  }
+  return static_cast<T>(neg ? -acc : acc);
+}
+
+int atoi(const char* s) {
+  return static_cast<int>(strtol(s, nullptr, 10));
+}
+
+long atol(const char* s) {
+  return strtol(s, nullptr, 10);
+}
+
+long long atoll(const char* s) {
+  return strtoll(s, nullptr, 10);
+}
+
+intmax_t strtoimax(const char* s, char** end, int base) {
+  return StrToI<intmax_t>(s, end, base);
+}
+
+long strtol(const char* s, char** end, int base) {
+  return StrToI<long>(s, end, base);
+}
+
+long long strtoll(const char* s, char** end, int base) {
+  return StrToI<long long>(s, end, base);
+}
+
+unsigned long strtoul(const char* s, char** end, int base) {
+  return StrToI<unsigned long>(s, end, base);
+}
+
+unsigned long long strtoull(const char* s, char** end, int base) {
+  return StrToI<unsigned long long>(s, end, base);
+}
+
+uintmax_t strtoumax(const char* s, char** end, int base) {
+  return StrToI<uintmax_t>(s, end, base);
+}
+
+// Historical BSD names.
+extern "C" long long strtoq(const char*, char**, int);
+extern "C" unsigned long long strtouq(const char*, char**, int);
+__strong_alias(strtoq, strtoll);
+__strong_alias(strtouq, strtoull);
@@ -29,8 +29,12 @@
 #include <sys/sysinfo.h>
 
 #include <dirent.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "private/get_cpu_count_from_string.h"
@@ -43,7 +47,37 @@ static bool __matches_cpuN(const char* s) {
   return (sscanf(s, "cpu%u%c", &cpu, &dummy) == 1);
 }
 
-int get_nprocs_conf() {
+// Thread pools ask for the CPU count whenever they're given work, and reading it from sysfs
+// takes several system calls, so counts are remembered for a while. CPUs come and go at any
+// time (Android devices hotplug them to save power), and there's no cheap way to hear about
+// it, so a count is only trusted for this long.
+static constexpr int64_t kCpuCountLifetimeNs = 100 * 1000000LL;
+
+struct CachedCpuCount {
+  atomic_int count;  // 0 until first read.
+  _Atomic(int64_t) expiry_ns;
+};
+
+static CachedCpuCount g_nprocs;
+static CachedCpuCount g_nprocs_conf;
+
+static int __cached_cpu_count(CachedCpuCount* cache, int (*read_count)()) {
+  // The coarse clock is read from the vdso without entering the kernel.
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  int64_t now_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+
+  int count = atomic_load_explicit(&cache->count, memory_order_relaxed);
+  if (count != 0 && now_ns < atomic_load_explicit(&cache->expiry_ns, memory_order_relaxed)) {
+    return count;
+  }
+  count = read_count();
+  atomic_store_explicit(&cache->count, count, memory_order_relaxed);
+  atomic_store_explicit(&cache->expiry_ns, now_ns + kCpuCountLifetimeNs, memory_order_relaxed);
+  return count;
+}
+
+static int __read_nprocs_conf() {
   // On x86 kernels you can use /proc/cpuinfo for this, but on ARM kernels offline CPUs disappear
   // from there. This method works on both.
   ScopedReaddir reader("/sys/devices/system/cpu");
@@ -61,7 +95,7 @@ int get_nprocs_conf() {
   return result;
 }
 
-int get_nprocs() {
+static int __read_nprocs() {
   int cpu_count = 1;
   FILE* fp = fopen("/sys/devices/system/cpu/online", "re");
   if (fp != nullptr) {
@@ -76,6 +110,26 @@ int get_nprocs() {
   return cpu_count;
 }
 
+int get_nprocs_conf() {
+  return __cached_cpu_count(&g_nprocs_conf, __read_nprocs_conf);
+}
+
+int get_nprocs() {
+  return __cached_cpu_count(&g_nprocs, __read_nprocs);
+}
+
+int get_nprocs_available() {
+  // Each thread has its own affinity mask, which can change at any time, so this isn't cached;
+  // it's a single system call anyway. A cpu_set_t is only 32 bits on LP32, which is why the
+  // mask is sized here.
+  unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+  if (sched_getaffinity(0, sizeof(mask), reinterpret_cast<cpu_set_t*>(mask)) == 0) {
+    int count = CPU_COUNT_S(sizeof(mask), reinterpret_cast<cpu_set_t*>(mask));
+    if (count > 0) return count;
+  }
+  return get_nprocs();
+}
+
 long get_phys_pages() {
   struct sysinfo si;
   sysinfo(&si);
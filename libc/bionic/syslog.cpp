@@ -15,21 +15,228 @@
  */
 
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <syslog.h>
 
+#include "private/bionic_futex.h"
 #include "private/libc_logging.h"
+#include "private/ScopedPthreadMutexLocker.h"
 
 static const char* syslog_log_tag = NULL;
 static int syslog_priority_mask = 0xff;
 
+// In buffered mode (LOG_ANDROID_BUFFERED), vsyslog copies each message into a ring
+// and a background thread sends them to logd in batches. The ring is a bounded
+// multi-producer queue: each slot's sequence number says whether it's free for
+// the producer at a given position or holds a message for the flusher, so
+// producers never take a lock. When the ring is full, producers wait for the
+// flusher rather than reorder or drop messages.
+static constexpr unsigned kSyslogRingSize = 64;
+static constexpr size_t kSyslogFlushBatch = 16;
+
+struct SyslogSlot {
+  atomic_uint seq;
+  __libc_log_record record;
+  char msg[1024];
+};
+
+struct SyslogRing {
+  SyslogSlot slots[kSyslogRingSize];
+  atomic_uint tail;  // The next position to fill.
+  atomic_uint head;  // The next position to flush. Written only by the flusher.
+  atomic_int wake;  // Bumped after each message is queued; the flusher waits on it.
+  atomic_bool flusher_waiting;
+  atomic_int drain_waiters;
+};
+
+static SyslogRing* g_syslog_ring;
+static atomic_bool g_syslog_buffered = ATOMIC_VAR_INIT(false);
+static bool g_syslog_flusher_started;
+static pthread_mutex_t g_syslog_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool syslog_try_enqueue(SyslogRing* ring, int priority, const char* tag, const char* msg) {
+  unsigned pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  SyslogSlot* slot;
+  while (true) {
+    slot = &ring->slots[pos % kSyslogRingSize];
+    int diff = static_cast<int>(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // Full.
+    } else {
+      pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    }
+  }
+
+  strlcpy(slot->msg, msg, sizeof(slot->msg));
+  __libc_log_record_init(&slot->record, priority, tag, slot->msg);
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+  atomic_fetch_add(&ring->wake, 1);
+  if (atomic_load(&ring->flusher_waiting)) {
+    __futex_wake(&ring->wake, 1);
+  }
+  return true;
+}
+
+// Waits until the flusher has sent everything queued so far.
+static void syslog_drain(SyslogRing* ring) {
+  unsigned target = atomic_load(&ring->tail);
+  atomic_fetch_add(&ring->drain_waiters, 1);
+  while (true) {
+    unsigned head = atomic_load(&ring->head);
+    if (static_cast<int>(head - target) >= 0) {
+      break;
+    }
+    __futex_wait(&ring->head, static_cast<int>(head), nullptr);
+  }
+  atomic_fetch_sub(&ring->drain_waiters, 1);
+}
+
+static void* syslog_flusher(void* arg) {
+  SyslogRing* ring = reinterpret_cast<SyslogRing*>(arg);
+  __libc_log_record batch[kSyslogFlushBatch];
+
+  while (true) {
+    int wake = atomic_load(&ring->wake);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t n = 0;
+    while (n < kSyslogFlushBatch) {
+      SyslogSlot* slot = &ring->slots[(head + n) % kSyslogRingSize];
+      if (atomic_load_explicit(&slot->seq, memory_order_acquire) != head + n + 1) {
+        break;
+      }
+      batch[n++] = slot->record;
+    }
+
+    if (n == 0) {
+      // If a message is queued after 'wake' was read, the futex wait returns at once.
+      atomic_store(&ring->flusher_waiting, true);
+      __futex_wait(&ring->wake, wake, nullptr);
+      atomic_store(&ring->flusher_waiting, false);
+      continue;
+    }
+
+    __libc_write_log_records(batch, n);
+
+    for (size_t i = 0; i < n; ++i) {
+      atomic_store_explicit(&ring->slots[(head + i) % kSyslogRingSize].seq,
+                            head + i + kSyslogRingSize, memory_order_release);
+    }
+    atomic_store(&ring->head, head + n);
+    if (atomic_load(&ring->drain_waiters) > 0) {
+      __futex_wake(&ring->head, INT_MAX);
+    }
+  }
+  return nullptr;
+}
+
+static void syslog_flush_at_exit() {
+  if (atomic_load_explicit(&g_syslog_buffered, memory_order_acquire)) {
+    syslog_drain(g_syslog_ring);
+  }
+}
+
+// The flusher doesn't survive fork, and the parent's will send anything that was
+// queued, so a child starts out unbuffered with an empty ring.
+static void syslog_fork_child() {
+  atomic_store(&g_syslog_buffered, false);
+  g_syslog_flusher_started = false;
+  g_syslog_lock = PTHREAD_MUTEX_INITIALIZER;
+}
+
+static bool syslog_start_buffering() {
+  ScopedPthreadMutexLocker locker(&g_syslog_lock);
+  if (g_syslog_flusher_started) {
+    return true;
+  }
+
+  if (g_syslog_ring == nullptr) {
+    void* p = mmap(nullptr, sizeof(SyslogRing), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      return false;
+    }
+    g_syslog_ring = reinterpret_cast<SyslogRing*>(p);
+    pthread_atfork(nullptr, nullptr, syslog_fork_child);
+    atexit(syslog_flush_at_exit);
+  }
+
+  SyslogRing* ring = g_syslog_ring;
+  for (unsigned i = 0; i < kSyslogRingSize; ++i) {
+    atomic_init(&ring->slots[i].seq, i);
+  }
+  atomic_init(&ring->tail, 0U);
+  atomic_init(&ring->head, 0U);
+  atomic_init(&ring->wake, 0);
+  atomic_init(&ring->flusher_waiting, false);
+  atomic_init(&ring->drain_waiters, 0);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  // The flusher shouldn't take any of the process' signals. Block them here so it
+  // inherits the mask without a window where one could be delivered.
+  sigset_t blocked;
+  sigfillset(&blocked);
+  sigset_t old_mask;
+  pthread_sigmask(SIG_BLOCK, &blocked, &old_mask);
+
+  pthread_t thread;
+  int rc = pthread_create(&thread, &attr, syslog_flusher, ring);
+  if (rc == 0) {
+    pthread_setname_np(thread, "syslog_flusher");
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+  pthread_attr_destroy(&attr);
+  if (rc != 0) {
+    return false;
+  }
+  g_syslog_flusher_started = true;
+  return true;
+}
+
+// Queues a message for the flusher, and if it's urgent, waits for it to be sent.
+static void syslog_enqueue(int priority, const char* tag, const char* msg, bool urgent) {
+  SyslogRing* ring = g_syslog_ring;
+  while (!syslog_try_enqueue(ring, priority, tag, msg)) {
+    syslog_drain(ring);
+  }
+  if (urgent) {
+    syslog_drain(ring);
+  }
+}
+
 void closelog() {
+  if (atomic_exchange(&g_syslog_buffered, false)) {
+    syslog_drain(g_syslog_ring);
+  }
   syslog_log_tag = NULL;
 }
 
-void openlog(const char* log_tag, int /*options*/, int /*facility*/) {
+void openlog(const char* log_tag, int options, int /*facility*/) {
   syslog_log_tag = log_tag;
+
+  if ((options & LOG_NDELAY) != 0) {
+    __libc_open_log();
+  }
+
+  bool buffered = (options & LOG_ANDROID_BUFFERED) != 0 && syslog_start_buffering();
+  if (atomic_exchange(&g_syslog_buffered, buffered) && !buffered) {
+    syslog_drain(g_syslog_ring);
+  }
 }
 
 int setlogmask(int new_mask) {
@@ -118,5 +325,9 @@ void vsyslog(int priority, const char* fmt, va_list args) {
     free(const_cast<char*>(log_fmt));
   }
 
-  __libc_format_log(android_log_priority, log_tag, "%s", log_line);
+  if (atomic_load_explicit(&g_syslog_buffered, memory_order_acquire)) {
+    syslog_enqueue(android_log_priority, log_tag, log_line, priority <= LOG_ERR);
+  } else {
+    __libc_format_log(android_log_priority, log_tag, "%s", log_line);
+  }
 }
@@ -30,6 +30,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -55,6 +56,7 @@
 #include <sys/system_properties.h>
 
 #include "private/ErrnoRestorer.h"
+#include "private/bionic_stats.h"
 #include "private/bionic_futex.h"
 #include "private/bionic_lock.h"
 #include "private/bionic_macros.h"
@@ -63,11 +65,24 @@
 
 static constexpr int PROP_FILENAME_MAX = 1024;
 
+static bool is_read_only(const char* name) {
+  return strncmp(name, "ro.", 3) == 0;
+}
+
 static constexpr uint32_t PROP_AREA_MAGIC = 0x504f5250;
-static constexpr uint32_t PROP_AREA_VERSION = 0xfc6ed0ab;
+// Areas of this version carry a hash index of full property names next to the trie.
+static constexpr uint32_t PROP_AREA_VERSION = 0xfc6ed0ac;
+// Areas of this version only have the trie. They can still be read.
+static constexpr uint32_t PROP_AREA_VERSION_NO_INDEX = 0xfc6ed0ab;
 
 static constexpr size_t PA_SIZE = 128 * 1024;
 
+// Each index slot packs the top 16 bits of the name hash with the prop_info
+// offset divided by 4, so a slot is a single atomic word. Past 3/4 load the
+// index stops taking new names and lookups that miss fall back to the trie.
+static constexpr uint32_t PROP_INDEX_SLOTS = 1024;
+static_assert(PA_SIZE <= (0x10000 << 2), "prop_info offsets must fit in an index slot");
+
 #define SERIAL_DIRTY(serial) ((serial)&1)
 #define SERIAL_VALUE_LEN(serial) ((serial) >> 24)
 
@@ -130,13 +145,39 @@ struct prop_bt {
 
 class prop_area {
  public:
-  prop_area(const uint32_t magic, const uint32_t version) : magic_(magic), version_(version) {
+  prop_area(const uint32_t magic, const uint32_t version, const uint32_t size)
+      : magic_(magic), version_(version), size_(size) {
     atomic_init(&serial_, 0);
     memset(reserved_, 0, sizeof(reserved_));
     // Allocate enough space for the root node.
     bytes_used_ = sizeof(prop_bt);
+    index_offset_ = 0;
+    index_slots_ = 0;
+    index_used_ = 0;
+    atomic_init(&index_full_, 0);
+    if (version == PROP_AREA_VERSION) {
+      // The hash index follows the root node. Like the root node, it relies on
+      // the freshly truncated file being zeroed.
+      index_offset_ = bytes_used_;
+      index_slots_ = PROP_INDEX_SLOTS;
+      bytes_used_ += PROP_INDEX_SLOTS * sizeof(atomic_uint_least32_t);
+    }
+    // Room for the old value of a property while it's being changed.
+    dirty_backup_offset_ = bytes_used_;
+    bytes_used_ += PROP_VALUE_MAX;
+  }
+
+  // The size of the whole area, including this header.
+  size_t size() const {
+    // Areas from before the size was recorded were always PA_SIZE.
+    return size_ ? size_ : PA_SIZE;
+  }
+  size_t bytes_used() const {
+    return sizeof(prop_area) + bytes_used_;
   }
 
+  bool valid() const;
+
   const prop_info* find(const char* name);
   bool add(const char* name, unsigned int namelen, const char* value, unsigned int valuelen);
 
@@ -145,6 +186,13 @@ class prop_area {
   atomic_uint_least32_t* serial() {
     return &serial_;
   }
+  // Null for areas made by versions of init without it.
+  char* dirty_backup_area() {
+    if (dirty_backup_offset_ == 0 || dirty_backup_offset_ + PROP_VALUE_MAX > data_size()) {
+      return nullptr;
+    }
+    return data_ + dirty_backup_offset_;
+  }
   uint32_t magic() const {
     return magic_;
   }
@@ -153,6 +201,10 @@ class prop_area {
   }
 
  private:
+  size_t data_size() const {
+    return size() - sizeof(prop_area);
+  }
+
   void* allocate_obj(const size_t size, uint_least32_t* const off);
   prop_bt* new_prop_bt(const char* name, uint32_t namelen, uint_least32_t* const off);
   prop_info* new_prop_info(const char* name, uint32_t namelen, const char* value, uint32_t valuelen,
@@ -168,6 +220,10 @@ class prop_area {
   const prop_info* find_property(prop_bt* const trie, const char* name, uint32_t namelen,
                                  const char* value, uint32_t valuelen, bool alloc_if_needed);
 
+  atomic_uint_least32_t* index();
+  const prop_info* find_in_index(const char* name, uint32_t namelen);
+  void add_to_index(const char* name, uint32_t namelen, uint_least32_t off);
+
   bool foreach_property(prop_bt* const trie, void (*propfn)(const prop_info* pi, void* cookie),
                         void* cookie);
 
@@ -175,19 +231,51 @@ class prop_area {
   atomic_uint_least32_t serial_;
   uint32_t magic_;
   uint32_t version_;
-  uint32_t reserved_[28];
+  uint32_t index_offset_;
+  uint32_t index_slots_;
+  uint32_t index_used_;
+  atomic_uint_least32_t index_full_;
+  uint32_t size_;
+  uint32_t dirty_backup_offset_;
+  uint32_t reserved_[22];
   char data_[0];
 
   DISALLOW_COPY_AND_ASSIGN(prop_area);
 };
 
+// Read-only properties may have values of PROP_VALUE_MAX bytes or more. Those
+// are stored out of line after the prop_info, and the inline buffer holds
+// this message instead, so that readers using the fixed-size APIs get
+// something sensible rather than a truncated value.
+static constexpr char kLongLegacyError[] = "Must use __system_property_read_callback() to read";
+
 struct prop_info {
+  // Set in the serial of a property whose value is stored out of line.
+  static constexpr uint32_t kLongFlag = 1 << 16;
+  static constexpr size_t kLongLegacyErrorBufferSize = 56;
+
   atomic_uint_least32_t serial;
   // we need to keep this buffer around because the property
   // value can be modified whereas name is constant.
-  char value[PROP_VALUE_MAX];
+  union {
+    char value[PROP_VALUE_MAX];
+    struct {
+      char error_message[kLongLegacyErrorBufferSize];
+      // Offset of the long value from the start of this prop_info.
+      uint32_t offset;
+    } long_property;
+  };
   char name[0];
 
+  bool is_long() const {
+    return (atomic_load_explicit(const_cast<atomic_uint_least32_t*>(&serial),
+                                 memory_order_relaxed) & kLongFlag) != 0;
+  }
+
+  const char* long_value() const {
+    return reinterpret_cast<const char*>(this) + long_property.offset;
+  }
+
   prop_info(const char* name, uint32_t namelen, const char* value, uint32_t valuelen) {
     memcpy(this->name, name, namelen);
     this->name[namelen] = '\0';
@@ -196,20 +284,34 @@ struct prop_info {
     this->value[valuelen] = '\0';
   }
 
+  prop_info(const char* name, uint32_t namelen, uint32_t long_offset) {
+    memcpy(this->name, name, namelen);
+    this->name[namelen] = '\0';
+    // The length in the serial is that of the message, which is what the
+    // fixed-size readers copy.
+    atomic_init(&this->serial, ((sizeof(kLongLegacyError) - 1) << 24) | kLongFlag);
+    memcpy(this->long_property.error_message, kLongLegacyError, sizeof(kLongLegacyError));
+    this->long_property.offset = long_offset;
+  }
+
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(prop_info);
 };
 
+static_assert(sizeof(kLongLegacyError) <= prop_info::kLongLegacyErrorBufferSize,
+              "kLongLegacyError must fit in the inline buffer");
+
 // This is public because it was exposed in the NDK. As of 2017-01, ~60 apps reference this symbol.
 prop_area* __system_property_area__ = nullptr;
 
 static char property_filename[PROP_FILENAME_MAX] = PROP_FILENAME;
-static size_t pa_data_size;
-static size_t pa_size;
+// The serial area only needs the header, so it doesn't get a full PA_SIZE.
+static constexpr size_t PA_SERIAL_SIZE = 4096;
+static_assert(PA_SERIAL_SIZE >= sizeof(prop_area) + sizeof(prop_bt), "PA_SERIAL_SIZE too small");
 static bool initialized = false;
 
 static prop_area* map_prop_area_rw(const char* filename, const char* context,
-                                   bool* fsetxattr_failed) {
+                                   bool* fsetxattr_failed, uint32_t version, size_t size) {
   /* dev is a tmpfs that we can use to carve a shared workspace
    * out of, so let's do that...
    */
@@ -244,21 +346,18 @@ static prop_area* map_prop_area_rw(const char* filename, const char* context,
     }
   }
 
-  if (ftruncate(fd, PA_SIZE) < 0) {
+  if (ftruncate(fd, size) < 0) {
     close(fd);
     return nullptr;
   }
 
-  pa_size = PA_SIZE;
-  pa_data_size = pa_size - sizeof(prop_area);
-
-  void* const memory_area = mmap(nullptr, pa_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  void* const memory_area = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
   if (memory_area == MAP_FAILED) {
     close(fd);
     return nullptr;
   }
 
-  prop_area* pa = new (memory_area) prop_area(PROP_AREA_MAGIC, PROP_AREA_VERSION);
+  prop_area* pa = new (memory_area) prop_area(PROP_AREA_MAGIC, version, size);
 
   close(fd);
   return pa;
@@ -276,17 +375,17 @@ static prop_area* map_fd_ro(const int fd) {
     return nullptr;
   }
 
-  pa_size = fd_stat.st_size;
-  pa_data_size = pa_size - sizeof(prop_area);
-
-  void* const map_result = mmap(nullptr, pa_size, PROT_READ, MAP_SHARED, fd, 0);
+  const size_t size = fd_stat.st_size;
+  void* const map_result = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
   if (map_result == MAP_FAILED) {
     return nullptr;
   }
 
+  // The area's own idea of its size must match the file, since that's what
+  // bounds every offset we follow.
   prop_area* pa = reinterpret_cast<prop_area*>(map_result);
-  if ((pa->magic() != PROP_AREA_MAGIC) || (pa->version() != PROP_AREA_VERSION)) {
-    munmap(pa, pa_size);
+  if ((pa->magic() != PROP_AREA_MAGIC) || (pa->size() != size) || !pa->valid()) {
+    munmap(pa, size);
     return nullptr;
   }
 
@@ -305,7 +404,7 @@ static prop_area* map_prop_area(const char* filename) {
 
 void* prop_area::allocate_obj(const size_t size, uint_least32_t* const off) {
   const size_t aligned = BIONIC_ALIGN(size, sizeof(uint_least32_t));
-  if (bytes_used_ + aligned > pa_data_size) {
+  if (bytes_used_ + aligned > data_size()) {
     return nullptr;
   }
 
@@ -330,17 +429,26 @@ prop_info* prop_area::new_prop_info(const char* name, uint32_t namelen, const ch
                                     uint32_t valuelen, uint_least32_t* const off) {
   uint_least32_t new_offset;
   void* const p = allocate_obj(sizeof(prop_info) + namelen + 1, &new_offset);
-  if (p != nullptr) {
-    prop_info* info = new (p) prop_info(name, namelen, value, valuelen);
-    *off = new_offset;
-    return info;
-  }
+  if (p == nullptr) return nullptr;
 
-  return nullptr;
+  prop_info* info;
+  if (valuelen >= PROP_VALUE_MAX) {
+    uint_least32_t long_offset;
+    char* long_location = reinterpret_cast<char*>(allocate_obj(valuelen + 1, &long_offset));
+    if (long_location == nullptr) return nullptr;
+
+    memcpy(long_location, value, valuelen);
+    long_location[valuelen] = '\0';
+    info = new (p) prop_info(name, namelen, long_offset - new_offset);
+  } else {
+    info = new (p) prop_info(name, namelen, value, valuelen);
+  }
+  *off = new_offset;
+  return info;
 }
 
 void* prop_area::to_prop_obj(uint_least32_t off) {
-  if (off > pa_data_size) return nullptr;
+  if (off > data_size()) return nullptr;
 
   return (data_ + off);
 }
@@ -359,6 +467,76 @@ inline prop_bt* prop_area::root_node() {
   return reinterpret_cast<prop_bt*>(to_prop_obj(0));
 }
 
+bool prop_area::valid() const {
+  if (size() < sizeof(prop_area) + sizeof(prop_bt)) return false;
+  if (version_ == PROP_AREA_VERSION_NO_INDEX) return true;
+  if (version_ != PROP_AREA_VERSION) return false;
+
+  // The index is only trusted if it lies entirely within the data area.
+  return index_slots_ != 0 && (index_slots_ & (index_slots_ - 1)) == 0 &&
+         index_offset_ % sizeof(atomic_uint_least32_t) == 0 &&
+         index_offset_ <= data_size() &&
+         index_slots_ <= (data_size() - index_offset_) / sizeof(atomic_uint_least32_t);
+}
+
+inline atomic_uint_least32_t* prop_area::index() {
+  return reinterpret_cast<atomic_uint_least32_t*>(to_prop_obj(index_offset_));
+}
+
+// FNV-1a.
+static uint32_t prop_name_hash(const char* name, uint32_t namelen) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < namelen; ++i) {
+    hash ^= static_cast<uint8_t>(name[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+const prop_info* prop_area::find_in_index(const char* name, uint32_t namelen) {
+  atomic_uint_least32_t* const slots = index();
+  const uint32_t mask = index_slots_ - 1;
+  const uint32_t hash = prop_name_hash(name, namelen);
+  const uint32_t tag = hash >> 16;
+
+  uint32_t i = hash & mask;
+  for (uint32_t probes = 0; probes < index_slots_; ++probes, i = (i + 1) & mask) {
+    // Pairs with the release store in add_to_index, like the trie "pointers".
+    const uint_least32_t slot = atomic_load_explicit(&slots[i], memory_order_consume);
+    if (slot == 0) {
+      return nullptr;
+    }
+    if ((slot >> 16) != tag) {
+      continue;
+    }
+
+    const prop_info* pi = reinterpret_cast<prop_info*>(to_prop_obj((slot & 0xffff) << 2));
+    if (pi != nullptr && strncmp(pi->name, name, namelen) == 0 && pi->name[namelen] == '\0') {
+      return pi;
+    }
+  }
+  return nullptr;
+}
+
+void prop_area::add_to_index(const char* name, uint32_t namelen, uint_least32_t off) {
+  if (index_used_ >= index_slots_ - index_slots_ / 4) {
+    atomic_store_explicit(&index_full_, 1, memory_order_release);
+    return;
+  }
+
+  atomic_uint_least32_t* const slots = index();
+  const uint32_t mask = index_slots_ - 1;
+  const uint32_t hash = prop_name_hash(name, namelen);
+
+  // Only init writes, so the first empty slot stays empty until we fill it.
+  uint32_t i = hash & mask;
+  while (atomic_load_explicit(&slots[i], memory_order_relaxed) != 0) {
+    i = (i + 1) & mask;
+  }
+  atomic_store_explicit(&slots[i], ((hash >> 16) << 16) | (off >> 2), memory_order_release);
+  ++index_used_;
+}
+
 static int cmp_prop_name(const char* one, uint32_t one_len, const char* two, uint32_t two_len) {
   if (one_len < two_len)
     return -1;
@@ -467,6 +645,9 @@ const prop_info* prop_area::find_property(prop_bt* const trie, const char* name,
     prop_info* new_info = new_prop_info(name, namelen, value, valuelen, &new_offset);
     if (new_info) {
       atomic_store_explicit(&current->prop, new_offset, memory_order_release);
+      if (version_ == PROP_AREA_VERSION) {
+        add_to_index(name, namelen, new_offset);
+      }
     }
 
     return new_info;
@@ -680,7 +861,15 @@ bool prop_area::foreach_property(prop_bt* const trie,
 }
 
 const prop_info* prop_area::find(const char* name) {
-  return find_property(root_node(), name, strlen(name), nullptr, 0, false);
+  const uint32_t namelen = strlen(name);
+  if (version_ == PROP_AREA_VERSION) {
+    const prop_info* pi = find_in_index(name, namelen);
+    // Until the index fills up, every property in the area is in it.
+    if (pi != nullptr || atomic_load_explicit(&index_full_, memory_order_acquire) == 0) {
+      return pi;
+    }
+  }
+  return find_property(root_node(), name, namelen, nullptr, 0, false);
 }
 
 bool prop_area::add(const char* name, unsigned int namelen, const char* value,
@@ -789,6 +978,50 @@ static void list_free(List** list) {
 static prefix_node* prefixes = nullptr;
 static context_node* contexts = nullptr;
 
+/*
+ * Parsing property_contexts and walking the prefix list on every lookup is
+ * slow with thousands of prefixes. Instead, the process that creates the
+ * property areas also writes the prefixes out as a trie to a property_info
+ * file, which every other process maps read only. The trie is radix
+ * compressed, and the children of each node are sorted by the first
+ * character of their label, so a lookup costs a binary search per node
+ * instead of a strncmp per prefix.
+ */
+static constexpr uint32_t PROP_TRIE_MAGIC = 0x49525450;
+static constexpr uint32_t PROP_TRIE_VERSION = 1;
+static constexpr uint32_t PROP_TRIE_NO_CONTEXT = UINT32_MAX;
+static const char PROPERTY_INFO_FILENAME[] = "property_info";
+
+// All offsets are from the start of the file.
+struct prop_trie_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t num_contexts;
+  // An array of num_contexts offsets of context names.
+  uint32_t contexts;
+  uint32_t root;
+};
+
+struct prop_trie_node {
+  // Index of the context of the prefix that ends at this node.
+  uint32_t context;
+  uint32_t num_children;
+  // An array of num_children prop_trie_edge.
+  uint32_t children;
+};
+
+struct prop_trie_edge {
+  uint32_t label;
+  uint32_t label_len;
+  uint32_t node;
+};
+
+static const prop_trie_header* property_info = nullptr;
+static size_t property_info_size;
+// The context node of each context index in property_info.
+static context_node** property_info_contexts = nullptr;
+
 /*
  * pthread_mutex_lock() calls into system_properties in the case of contention.
  * This creates a risk of dead lock if any system_properties functions
@@ -813,7 +1046,7 @@ bool context_node::open(bool access_rw, bool* fsetxattr_failed) {
   }
 
   if (access_rw) {
-    pa_ = map_prop_area_rw(filename, context_, fsetxattr_failed);
+    pa_ = map_prop_area_rw(filename, context_, fsetxattr_failed, PROP_AREA_VERSION, PA_SIZE);
   } else {
     pa_ = map_prop_area(filename);
   }
@@ -854,7 +1087,7 @@ void context_node::unmap() {
     return;
   }
 
-  munmap(pa_, pa_size);
+  munmap(pa_, pa_->size());
   if (pa_ == __system_property_area__) {
     __system_property_area__ = nullptr;
   }
@@ -872,22 +1105,367 @@ static bool map_system_property_area(bool access_rw, bool* fsetxattr_failed) {
 
   if (access_rw) {
     __system_property_area__ =
-        map_prop_area_rw(filename, "u:object_r:properties_serial:s0", fsetxattr_failed);
+        map_prop_area_rw(filename, "u:object_r:properties_serial:s0", fsetxattr_failed,
+                         PROP_AREA_VERSION_NO_INDEX, PA_SERIAL_SIZE);
   } else {
     __system_property_area__ = map_prop_area(filename);
   }
   return __system_property_area__;
 }
 
-static prop_area* get_prop_area_for_name(const char* name) {
+// A character trie of the prefixes, only used while writing property_info.
+struct trie_builder_node {
+  trie_builder_node(trie_builder_node* next, uint8_t c)
+      : c(c), context(PROP_TRIE_NO_CONTEXT), children(nullptr), next(next) {
+  }
+  ~trie_builder_node() {
+    list_free(&children);
+  }
+
+  // Returns the child for the character, adding it if needed. Children are
+  // kept sorted by character.
+  trie_builder_node* child(uint8_t c) {
+    trie_builder_node** child = &children;
+    while (*child && (*child)->c < c) {
+      child = &(*child)->next;
+    }
+    if (!*child || (*child)->c != c) {
+      list_add(child, c);
+    }
+    return *child;
+  }
+
+  const uint8_t c;
+  uint32_t context;
+  trie_builder_node* children;
+  trie_builder_node* next;
+};
+
+class trie_writer {
+ public:
+  trie_writer() : data_(nullptr), size_(0), capacity_(0), failed_(false) {
+  }
+  ~trie_writer() {
+    free(data_);
+  }
+
+  // Returns the offset of a new zeroed, 4 byte aligned block.
+  uint32_t allocate(size_t size) {
+    size_t offset = BIONIC_ALIGN(size_, sizeof(uint32_t));
+    if (offset + size > capacity_) {
+      size_t capacity = (capacity_ == 0) ? 4096 : capacity_ * 2;
+      while (capacity < offset + size) {
+        capacity *= 2;
+      }
+      void* data = realloc(data_, capacity);
+      if (data == nullptr || capacity > UINT32_MAX) {
+        failed_ = true;
+        return 0;
+      }
+      data_ = reinterpret_cast<uint8_t*>(data);
+      capacity_ = capacity;
+    }
+    memset(data_ + size_, 0, offset + size - size_);
+    size_ = offset + size;
+    return offset;
+  }
+
+  uint32_t add_string(const char* str) {
+    size_t len = strlen(str);
+    uint32_t offset = allocate(len + 1);
+    if (!failed_) {
+      memcpy(data_ + offset, str, len + 1);
+    }
+    return offset;
+  }
+
+  uint32_t add_node(const trie_builder_node* builder_node);
+
+  template <typename T>
+  T* at(uint32_t offset) {
+    return reinterpret_cast<T*>(data_ + offset);
+  }
+
+  const uint8_t* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  bool failed() const {
+    return failed_;
+  }
+
+ private:
+  uint8_t* data_;
+  size_t size_;
+  size_t capacity_;
+  bool failed_;
+};
+
+uint32_t trie_writer::add_node(const trie_builder_node* builder_node) {
+  uint32_t num_children = 0;
+  list_foreach(builder_node->children, [&num_children](trie_builder_node*) { num_children++; });
+
+  uint32_t node = allocate(sizeof(prop_trie_node));
+  uint32_t edges = allocate(num_children * sizeof(prop_trie_edge));
+
+  uint32_t i = 0;
+  for (const trie_builder_node* child = builder_node->children; child && !failed_;
+       child = child->next, i++) {
+    // Collapse a chain of nodes that each have a single child and no
+    // context into the label of one edge.
+    const trie_builder_node* end = child;
+    uint32_t label_len = 1;
+    while (end->context == PROP_TRIE_NO_CONTEXT && end->children && !end->children->next) {
+      end = end->children;
+      label_len++;
+    }
+    uint32_t label = allocate(label_len + 1);
+    if (failed_) {
+      break;
+    }
+    uint8_t* label_chars = data_ + label;
+    for (const trie_builder_node* n = child; n != end; n = n->children) {
+      *label_chars++ = n->c;
+    }
+    *label_chars = end->c;
+
+    uint32_t end_node = add_node(end);
+    if (failed_) {
+      break;
+    }
+    prop_trie_edge* edge = at<prop_trie_edge>(edges + i * sizeof(prop_trie_edge));
+    edge->label = label;
+    edge->label_len = label_len;
+    edge->node = end_node;
+  }
+
+  if (!failed_) {
+    prop_trie_node* trie_node = at<prop_trie_node>(node);
+    trie_node->context = builder_node->context;
+    trie_node->num_children = num_children;
+    trie_node->children = edges;
+  }
+  return node;
+}
+
+static uint32_t context_index(context_node* context) {
+  uint32_t index = 0;
+  for (context_node* l = contexts; l != context; l = l->next) {
+    index++;
+  }
+  return index;
+}
+
+static uint32_t num_contexts() {
+  return context_index(nullptr);
+}
+
+// Writes the prefixes and contexts parsed from property_contexts to the
+// property_info file.
+static bool write_property_info(const char* filename) {
+  trie_builder_node root(nullptr, 0);
+  // The prefixes are sorted longest first, and when a prefix is repeated,
+  // the first one wins, as in get_prop_area_for_name.
+  list_foreach(prefixes, [&root](prefix_node* l) {
+    trie_builder_node* node = &root;
+    if (l->prefix[0] != '*') {
+      for (size_t i = 0; i < l->prefix_len; i++) {
+        node = node->child(l->prefix[i]);
+      }
+    }
+    if (node->context == PROP_TRIE_NO_CONTEXT) {
+      node->context = context_index(l->context);
+    }
+  });
+
+  trie_writer writer;
+  uint32_t header = writer.allocate(sizeof(prop_trie_header));
+  uint32_t context_count = num_contexts();
+  uint32_t context_offsets = writer.allocate(context_count * sizeof(uint32_t));
+  uint32_t i = 0;
+  list_foreach(contexts, [&writer, &i, context_offsets](context_node* l) {
+    uint32_t name = writer.add_string(l->context());
+    if (!writer.failed()) {
+      writer.at<uint32_t>(context_offsets)[i++] = name;
+    }
+  });
+  uint32_t root_offset = writer.add_node(&root);
+  if (writer.failed()) {
+    return false;
+  }
+
+  prop_trie_header* trie_header = writer.at<prop_trie_header>(header);
+  trie_header->magic = PROP_TRIE_MAGIC;
+  trie_header->version = PROP_TRIE_VERSION;
+  trie_header->size = writer.size();
+  trie_header->num_contexts = context_count;
+  trie_header->contexts = context_offsets;
+  trie_header->root = root_offset;
+
+  unlink(filename);
+  const int fd = open(filename, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC | O_EXCL, 0444);
+  if (fd < 0) {
+    return false;
+  }
+  // Every process needs to be able to read this file, like properties_serial.
+  const char* context = "u:object_r:properties_serial:s0";
+  fsetxattr(fd, XATTR_NAME_SELINUX, context, strlen(context) + 1, 0);
+
+  const uint8_t* data = writer.data();
+  size_t remaining = writer.size();
+  while (remaining > 0) {
+    ssize_t written = TEMP_FAILURE_RETRY(write(fd, data, remaining));
+    if (written <= 0) {
+      close(fd);
+      unlink(filename);
+      return false;
+    }
+    data += written;
+    remaining -= written;
+  }
+  close(fd);
+  return true;
+}
+
+// Maps the property_info file. If create_contexts is false, the context
+// nodes already parsed from property_contexts are used, otherwise they are
+// created from the names in the file.
+static bool map_property_info(bool create_contexts) {
+  char filename[PROP_FILENAME_MAX];
+  int len = __libc_format_buffer(filename, sizeof(filename), "%s/%s", property_filename,
+                                 PROPERTY_INFO_FILENAME);
+  if (len < 0 || len > PROP_FILENAME_MAX) {
+    return false;
+  }
+
+  int fd = open(filename, O_CLOEXEC | O_NOFOLLOW | O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat fd_stat;
+  if (fstat(fd, &fd_stat) < 0 || (fd_stat.st_uid != 0) || (fd_stat.st_gid != 0) ||
+      ((fd_stat.st_mode & (S_IWGRP | S_IWOTH)) != 0) ||
+      (fd_stat.st_size < static_cast<off_t>(sizeof(prop_trie_header)))) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = fd_stat.st_size;
+  void* const map_result = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map_result == MAP_FAILED) {
+    return false;
+  }
+
+  const prop_trie_header* header = reinterpret_cast<const prop_trie_header*>(map_result);
+  if (header->magic != PROP_TRIE_MAGIC || header->version != PROP_TRIE_VERSION ||
+      header->size != size || header->num_contexts > size / sizeof(uint32_t) ||
+      header->contexts > size - header->num_contexts * sizeof(uint32_t) ||
+      header->root > size - sizeof(prop_trie_node) ||
+      (!create_contexts && header->num_contexts != num_contexts())) {
+    munmap(map_result, size);
+    return false;
+  }
+
+  context_node** table =
+      reinterpret_cast<context_node**>(calloc(header->num_contexts, sizeof(context_node*)));
+  if (table == nullptr) {
+    munmap(map_result, size);
+    return false;
+  }
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(header);
+  const uint32_t* names = reinterpret_cast<const uint32_t*>(base + header->contexts);
+  for (uint32_t i = 0; i < header->num_contexts; i++) {
+    if (names[i] >= size || memchr(base + names[i], '\0', size - names[i]) == nullptr) {
+      free(table);
+      munmap(map_result, size);
+      return false;
+    }
+  }
+  if (create_contexts) {
+    // Added last to first so that the list is in context index order.
+    for (uint32_t i = header->num_contexts; i > 0; i--) {
+      list_add(&contexts, reinterpret_cast<const char*>(base + names[i - 1]), nullptr);
+      table[i - 1] = contexts;
+    }
+  } else {
+    uint32_t i = 0;
+    list_foreach(contexts, [table, &i](context_node* l) { table[i++] = l; });
+  }
+
+  property_info = header;
+  property_info_size = size;
+  property_info_contexts = table;
+  return true;
+}
+
+static void unmap_property_info() {
+  if (property_info) {
+    munmap(const_cast<prop_trie_header*>(property_info), property_info_size);
+    property_info = nullptr;
+  }
+  free(property_info_contexts);
+  property_info_contexts = nullptr;
+}
+
+// Returns the context index of the longest prefix of name, or
+// PROP_TRIE_NO_CONTEXT.
+static uint32_t find_property_info_context(const char* name) {
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(property_info);
+  const prop_trie_node* node = reinterpret_cast<const prop_trie_node*>(base + property_info->root);
+  uint32_t context = node->context;
+
+  while (*name != '\0') {
+    const prop_trie_edge* edges = reinterpret_cast<const prop_trie_edge*>(base + node->children);
+    const uint8_t c = *name;
+    const prop_trie_edge* found = nullptr;
+    uint32_t low = 0;
+    uint32_t high = node->num_children;
+    while (low < high) {
+      uint32_t mid = low + (high - low) / 2;
+      uint8_t mid_c = base[edges[mid].label];
+      if (mid_c == c) {
+        found = &edges[mid];
+        break;
+      } else if (mid_c < c) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    if (!found ||
+        strncmp(reinterpret_cast<const char*>(base + found->label), name, found->label_len)) {
+      break;
+    }
+
+    name += found->label_len;
+    node = reinterpret_cast<const prop_trie_node*>(base + found->node);
+    if (node->context != PROP_TRIE_NO_CONTEXT) {
+      context = node->context;
+    }
+  }
+  return context;
+}
+
+static context_node* get_context_for_name(const char* name) {
+  if (property_info) {
+    uint32_t context = find_property_info_context(name);
+    if (context == PROP_TRIE_NO_CONTEXT) {
+      return nullptr;
+    }
+    return property_info_contexts[context];
+  }
+
   auto entry = list_find(prefixes, [name](prefix_node* l) {
     return l->prefix[0] == '*' || !strncmp(l->prefix, name, l->prefix_len);
   });
-  if (!entry) {
-    return nullptr;
-  }
+  return entry ? entry->context : nullptr;
+}
 
-  auto cnode = entry->context;
+static prop_area* get_prop_area_for_context(context_node* cnode) {
   if (!cnode->pa()) {
     /*
      * We explicitly do not check no_access_ in this case because unlike the
@@ -899,6 +1477,39 @@ static prop_area* get_prop_area_for_name(const char* name) {
   return cnode->pa();
 }
 
+static prop_area* get_prop_area_for_info(const prop_info* pi) {
+  const char* p = reinterpret_cast<const char*>(pi);
+  prop_area* result = nullptr;
+  list_foreach(contexts, [p, &result](context_node* l) {
+    const char* start = reinterpret_cast<const char*>(l->pa());
+    if (start != nullptr && p >= start && p < start + l->pa()->size()) {
+      result = l->pa();
+    }
+  });
+  return result;
+}
+
+// Each context's area has a serial of its own that is bumped whenever a
+// property in that area is added or changed, so that a waiter interested in
+// a few properties in one area isn't woken by changes everywhere else. The
+// serial area's own serial is the global one, and is bumped by the callers.
+static void bump_area_serial(prop_area* pa) {
+  if (pa == nullptr || pa == __system_property_area__) {
+    return;
+  }
+  atomic_store_explicit(pa->serial(), atomic_load_explicit(pa->serial(), memory_order_relaxed) + 1,
+                        memory_order_release);
+  __futex_wake(pa->serial(), INT32_MAX);
+}
+
+static prop_area* get_prop_area_for_name(const char* name) {
+  context_node* cnode = get_context_for_name(name);
+  if (!cnode) {
+    return nullptr;
+  }
+  return get_prop_area_for_context(cnode);
+}
+
 /*
  * The below two functions are duplicated from label_support.c in libselinux.
  * TODO: Find a location suitable for these functions such that both libc and
@@ -1070,10 +1681,11 @@ static bool is_dir(const char* pathname) {
 }
 
 static void free_and_unmap_contexts() {
+  unmap_property_info();
   list_free(&prefixes);
   list_free(&contexts);
   if (__system_property_area__) {
-    munmap(__system_property_area__, pa_size);
+    munmap(__system_property_area__, __system_property_area__->size());
     __system_property_area__ = nullptr;
   }
 }
@@ -1087,7 +1699,7 @@ int __system_properties_init() {
     return 0;
   }
   if (is_dir(property_filename)) {
-    if (!initialize_properties()) {
+    if (!map_property_info(true) && !initialize_properties()) {
       return -1;
     }
     if (!map_system_property_area(false, nullptr)) {
@@ -1106,6 +1718,18 @@ int __system_properties_init() {
   return 0;
 }
 
+static pthread_once_t properties_init_once = PTHREAD_ONCE_INIT;
+
+static void properties_init_once_fn() {
+  if (!initialized) __system_properties_init();
+}
+
+// libc doesn't map the property areas at startup, since plenty of processes
+// never read a property. Anything that needs them calls this first.
+static inline void ensure_properties_initialized() {
+  pthread_once(&properties_init_once, properties_init_once_fn);
+}
+
 int __system_property_set_filename(const char* filename) {
   size_t len = strlen(filename);
   if (len >= sizeof(property_filename)) return -1;
@@ -1131,11 +1755,20 @@ int __system_property_area_init() {
     free_and_unmap_contexts();
     return -1;
   }
+
+  // Lookups fall back to the prefix list if property_info can't be written.
+  char filename[PROP_FILENAME_MAX];
+  int len = __libc_format_buffer(filename, sizeof(filename), "%s/%s", property_filename,
+                                 PROPERTY_INFO_FILENAME);
+  if (len >= 0 && len <= PROP_FILENAME_MAX && write_property_info(filename)) {
+    map_property_info(false);
+  }
   initialized = true;
   return fsetxattr_failed ? -2 : 0;
 }
 
 uint32_t __system_property_area_serial() {
+  ensure_properties_initialized();
   prop_area* pa = __system_property_area__;
   if (!pa) {
     return -1;
@@ -1145,6 +1778,8 @@ uint32_t __system_property_area_serial() {
 }
 
 const prop_info* __system_property_find(const char* name) {
+  __libc_stats_add(LIBC_STAT_PROPERTY_LOOKUPS, 1);
+  ensure_properties_initialized();
   if (!__system_property_area__) {
     return nullptr;
   }
@@ -1165,11 +1800,26 @@ static inline uint_least32_t load_const_atomic(const atomic_uint_least32_t* s, m
   return atomic_load_explicit(non_const_s, mo);
 }
 
-int __system_property_read(const prop_info* pi, char* name, char* value) {
+// Copies the value of a short property, which needs up to PROP_VALUE_MAX
+// bytes, and returns the serial it goes with. The writer copies the old value
+// to its area's backup before changing a property, so while the serial is
+// dirty that's read instead: readers only wait for a change to finish if the
+// area has no backup.
+static uint32_t read_mutable_value(const prop_info* pi, char* value) {
+  uint32_t serial = load_const_atomic(&pi->serial, memory_order_acquire);
   while (true) {
-    uint32_t serial = __system_property_serial(pi);  // acquire semantics
+    const char* source = pi->value;
+    if (SERIAL_DIRTY(serial)) {
+      prop_area* pa = get_prop_area_for_info(pi);
+      source = (pa != nullptr) ? pa->dirty_backup_area() : nullptr;
+      if (source == nullptr) {
+        serial = __system_property_serial(pi);  // acquire semantics
+        continue;
+      }
+    }
     size_t len = SERIAL_VALUE_LEN(serial);
-    memcpy(value, pi->value, len + 1);
+    memcpy(value, source, len);
+    value[len] = '\0';
     // TODO: Fix the synchronization scheme here.
     // There is no fully supported way to implement this kind
     // of synchronization in C++11, since the memcpy races with
@@ -1179,43 +1829,59 @@ int __system_property_read(const prop_info* pi, char* name, char* value) {
     // In practice it seems unlikely that the generated code would
     // would be any different, so this should be OK.
     atomic_thread_fence(memory_order_acquire);
-    if (serial == load_const_atomic(&(pi->serial), memory_order_relaxed)) {
-      if (name != nullptr) {
-        size_t namelen = strlcpy(name, pi->name, PROP_NAME_MAX);
-        if (namelen >= PROP_NAME_MAX) {
-          __libc_format_log(ANDROID_LOG_ERROR, "libc",
-                            "The property name length for \"%s\" is >= %d;"
-                            " please use __system_property_read_callback"
-                            " to read this property. (the name is truncated to \"%s\")",
-                            pi->name, PROP_NAME_MAX - 1, name);
-        }
-      }
-      return len;
+    if (serial == load_const_atomic(&pi->serial, memory_order_relaxed)) {
+      // A dirty serial is the old serial with the dirty bit set.
+      return serial & ~1u;
     }
+    serial = load_const_atomic(&pi->serial, memory_order_acquire);
   }
 }
 
+int __system_property_read(const prop_info* pi, char* name, char* value) {
+  size_t len = SERIAL_VALUE_LEN(read_mutable_value(pi, value));
+  if (name != nullptr) {
+    size_t namelen = strlcpy(name, pi->name, PROP_NAME_MAX);
+    if (namelen >= PROP_NAME_MAX) {
+      __libc_format_log(ANDROID_LOG_ERROR, "libc",
+                        "The property name length for \"%s\" is >= %d;"
+                        " please use __system_property_read_callback"
+                        " to read this property. (the name is truncated to \"%s\")",
+                        pi->name, PROP_NAME_MAX - 1, name);
+    }
+  }
+  return len;
+}
+
 void __system_property_read_callback(const prop_info* pi,
                                      void (*callback)(void* cookie,
                                                       const char* name,
                                                       const char* value,
                                                       uint32_t serial),
                                      void* cookie) {
-  while (true) {
-    uint32_t serial = __system_property_serial(pi);  // acquire semantics
-    size_t len = SERIAL_VALUE_LEN(serial);
-    char value_buf[len + 1];
+  // Long values never change, so they can be handed out without a copy.
+  if (pi->is_long()) {
+    uint32_t serial = load_const_atomic(&pi->serial, memory_order_acquire);
+    callback(cookie, pi->name, pi->long_value(), serial);
+    return;
+  }
 
-    memcpy(value_buf, pi->value, len);
-    value_buf[len] = '\0';
+  char value_buf[PROP_VALUE_MAX];
+  uint32_t serial = read_mutable_value(pi, value_buf);
+  callback(cookie, pi->name, value_buf, serial);
+}
 
-    // TODO: see todo in __system_property_read function
-    atomic_thread_fence(memory_order_acquire);
-    if (serial == load_const_atomic(&(pi->serial), memory_order_relaxed)) {
-      callback(cookie, pi->name, value_buf, serial);
-      return;
-    }
+const char* __system_property_read_stable(const prop_info* pi, uint32_t* serial_ptr) {
+  if (!is_read_only(pi->name)) {
+    return nullptr;
+  }
+
+  // Read-only properties are set once and never changed after that, so
+  // once the value is complete it stays valid for the life of the process.
+  uint32_t serial = __system_property_serial(pi);  // acquire semantics
+  if (serial_ptr != nullptr) {
+    *serial_ptr = serial;
   }
+  return pi->is_long() ? pi->long_value() : pi->value;
 }
 
 int __system_property_get(const char* name, char* value) {
@@ -1229,8 +1895,78 @@ int __system_property_get(const char* name, char* value) {
   }
 }
 
+size_t __system_property_get_many(const char* const names[], char* const values[], size_t count) {
+  // Names are handled in chunks so that the per-name state can live on the stack.
+  static constexpr size_t kChunkSize = 64;
+  context_node* cnodes[kChunkSize];
+  bool resolved[kChunkSize];
+  const prop_info* infos[kChunkSize];
+  uint32_t serials[kChunkSize];
+  size_t found = 0;
+
+  ensure_properties_initialized();
+  for (size_t base = 0; base < count; base += kChunkSize) {
+    const char* const* chunk_names = names + base;
+    char* const* chunk_values = values + base;
+    const size_t n = (count - base < kChunkSize) ? count - base : kChunkSize;
+
+    for (size_t i = 0; i < n; ++i) {
+      chunk_values[i][0] = '\0';
+      infos[i] = nullptr;
+      resolved[i] = false;
+      cnodes[i] = __system_property_area__ ? get_context_for_name(chunk_names[i]) : nullptr;
+    }
+    if (!__system_property_area__) {
+      continue;
+    }
+
+    // Resolve the names one context at a time, so that each area is opened
+    // and access checked once rather than once per name.
+    for (size_t i = 0; i < n; ++i) {
+      if (resolved[i]) {
+        continue;
+      }
+      context_node* cnode = cnodes[i];
+      prop_area* pa = cnode ? get_prop_area_for_context(cnode) : nullptr;
+      for (size_t j = i; j < n; ++j) {
+        if (resolved[j] || cnodes[j] != cnode) {
+          continue;
+        }
+        resolved[j] = true;
+        if (!pa) {
+          __libc_format_log(ANDROID_LOG_ERROR, "libc", "Access denied finding property \"%s\"",
+                            chunk_names[j]);
+          continue;
+        }
+        infos[j] = pa->find(chunk_names[j]);
+      }
+    }
+
+    // Copy all the values and then check all the serials behind a single fence.
+    // See the comments in __system_property_read for why this is sufficient.
+    for (size_t i = 0; i < n; ++i) {
+      if (infos[i]) {
+        serials[i] = __system_property_serial(infos[i]);  // acquire semantics
+        memcpy(chunk_values[i], infos[i]->value, SERIAL_VALUE_LEN(serials[i]) + 1);
+      }
+    }
+    atomic_thread_fence(memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+      if (infos[i]) {
+        if (serials[i] != load_const_atomic(&(infos[i]->serial), memory_order_relaxed)) {
+          // Updated while we were copying it; take the slow path for this one.
+          __system_property_read(infos[i], nullptr, chunk_values[i]);
+        }
+        ++found;
+      }
+    }
+  }
+  return found;
+}
+
 static constexpr uint32_t kProtocolVersion1 = 1;
-static constexpr uint32_t kProtocolVersion2 = 2;  // current
+static constexpr uint32_t kProtocolVersion2 = 2;
+static constexpr uint32_t kProtocolVersion3 = 3;  // current, adds PROP_MSG_SETPROP_BATCH
 
 static atomic_uint_least32_t g_propservice_protocol_version = 0;
 
@@ -1243,7 +1979,9 @@ static void detect_protocol_version() {
                       kServiceVersionPropertyName);
   } else {
     uint32_t version = static_cast<uint32_t>(atoll(value));
-    if (version >= kProtocolVersion2) {
+    if (version >= kProtocolVersion3) {
+      g_propservice_protocol_version = kProtocolVersion3;
+    } else if (version >= kProtocolVersion2) {
       g_propservice_protocol_version = kProtocolVersion2;
     } else {
       __libc_format_log(ANDROID_LOG_WARN, "libc",
@@ -1257,15 +1995,16 @@ static void detect_protocol_version() {
 int __system_property_set(const char* key, const char* value) {
   if (key == nullptr) return -1;
   if (value == nullptr) value = "";
-  if (strlen(value) >= PROP_VALUE_MAX) return -1;
+  if (strlen(value) >= PROP_VALUE_MAX && !is_read_only(key)) return -1;
 
   if (g_propservice_protocol_version == 0) {
     detect_protocol_version();
   }
 
   if (g_propservice_protocol_version == kProtocolVersion1) {
-    // Old protocol does not support long names
+    // Old protocol does not support long names or values
     if (strlen(key) >= PROP_NAME_MAX) return -1;
+    if (strlen(value) >= PROP_VALUE_MAX) return -1;
 
     prop_msg msg;
     memset(&msg, 0, sizeof msg);
@@ -1329,6 +2068,97 @@ int __system_property_set(const char* key, const char* value) {
   }
 }
 
+uint32_t __system_property_service_protocol_version() {
+  if (g_propservice_protocol_version == 0) {
+    detect_protocol_version();
+  }
+  return g_propservice_protocol_version;
+}
+
+int __system_property_set_many(const char* const keys[], const char* const values[],
+                               size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (keys[i] == nullptr) return -1;
+    if (values[i] != nullptr && strlen(values[i]) >= PROP_VALUE_MAX && !is_read_only(keys[i])) {
+      return -1;
+    }
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  if (__system_property_service_protocol_version() < kProtocolVersion3) {
+    // Older property services take one property per connection.
+    for (size_t i = 0; i < count; ++i) {
+      if (__system_property_set(keys[i], values[i]) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  PropertyServiceConnection connection;
+  if (!connection.IsValid()) {
+    errno = connection.GetLastError();
+    __libc_format_log(ANDROID_LOG_WARN,
+                      "libc",
+                      "Unable to set %zu properties starting with \"%s\": connection failed; "
+                      "errno=%d (%s)",
+                      count,
+                      keys[0],
+                      errno,
+                      strerror(errno));
+    return -1;
+  }
+
+  // The header and each pair are separate writes on the one connection, and
+  // the service only replies once it has handled the whole batch.
+  SocketWriter writer(&connection);
+  bool sent = writer.WriteUint32(PROP_MSG_SETPROP_BATCH).WriteUint32(count).Send();
+  for (size_t i = 0; sent && i < count; ++i) {
+    const char* value = (values[i] != nullptr) ? values[i] : "";
+    sent = writer.WriteString(keys[i]).WriteString(value).Send();
+  }
+  if (!sent) {
+    errno = connection.GetLastError();
+    __libc_format_log(ANDROID_LOG_WARN,
+                      "libc",
+                      "Unable to set %zu properties starting with \"%s\": write failed; "
+                      "errno=%d (%s)",
+                      count,
+                      keys[0],
+                      errno,
+                      strerror(errno));
+    return -1;
+  }
+
+  int result = -1;
+  if (!connection.RecvInt32(&result)) {
+    errno = connection.GetLastError();
+    __libc_format_log(ANDROID_LOG_WARN,
+                      "libc",
+                      "Unable to set %zu properties starting with \"%s\": recv failed; "
+                      "errno=%d (%s)",
+                      count,
+                      keys[0],
+                      errno,
+                      strerror(errno));
+    return -1;
+  }
+
+  if (result != PROP_SUCCESS) {
+    __libc_format_log(ANDROID_LOG_WARN,
+                      "libc",
+                      "Unable to set %zu properties starting with \"%s\": error code: 0x%x",
+                      count,
+                      keys[0],
+                      result);
+    return -1;
+  }
+
+  return 0;
+}
+
 int __system_property_update(prop_info* pi, const char* value, unsigned int len) {
   if (len >= PROP_VALUE_MAX) {
     return -1;
@@ -1340,7 +2170,20 @@ int __system_property_update(prop_info* pi, const char* value, unsigned int len)
     return -1;
   }
 
+  // Long values are only allowed for read-only properties, so they never change.
+  if (pi->is_long()) {
+    return -1;
+  }
+
+  prop_area* info_pa = get_prop_area_for_info(pi);
   uint32_t serial = atomic_load_explicit(&pi->serial, memory_order_relaxed);
+  // Readers that find the serial dirty read the old value from the backup,
+  // so it must be there before the dirty bit is.
+  char* backup = (info_pa != nullptr) ? info_pa->dirty_backup_area() : nullptr;
+  if (backup != nullptr) {
+    memcpy(backup, pi->value, SERIAL_VALUE_LEN(serial) + 1);
+    atomic_thread_fence(memory_order_release);
+  }
   serial |= 1;
   atomic_store_explicit(&pi->serial, serial, memory_order_relaxed);
   // The memcpy call here also races.  Again pretend it
@@ -1349,9 +2192,17 @@ int __system_property_update(prop_info* pi, const char* value, unsigned int len)
   atomic_thread_fence(memory_order_release);
   strlcpy(pi->value, value, len + 1);
 
-  atomic_store_explicit(&pi->serial, (len << 24) | ((serial + 1) & 0xffffff), memory_order_release);
+  // The counter skips the values with kLongFlag set, so that a short
+  // property never looks like a long one however often it changes.
+  uint32_t counter = (serial + 1) & 0xffffff;
+  if (counter & prop_info::kLongFlag) {
+    counter = (counter + prop_info::kLongFlag) & 0xffffff;
+  }
+  atomic_store_explicit(&pi->serial, (len << 24) | counter, memory_order_release);
   __futex_wake(&pi->serial, INT32_MAX);
 
+  bump_area_serial(info_pa);
+
   atomic_store_explicit(pa->serial(), atomic_load_explicit(pa->serial(), memory_order_relaxed) + 1,
                         memory_order_release);
   __futex_wake(pa->serial(), INT32_MAX);
@@ -1361,7 +2212,7 @@ int __system_property_update(prop_info* pi, const char* value, unsigned int len)
 
 int __system_property_add(const char* name, unsigned int namelen, const char* value,
                           unsigned int valuelen) {
-  if (valuelen >= PROP_VALUE_MAX) {
+  if (valuelen >= PROP_VALUE_MAX && !is_read_only(name)) {
     return -1;
   }
 
@@ -1385,6 +2236,8 @@ int __system_property_add(const char* name, unsigned int namelen, const char* va
     return -1;
   }
 
+  bump_area_serial(pa);
+
   // There is only a single mutator, but we want to make sure that
   // updates are visible to a reader waiting for the update.
   atomic_store_explicit(
@@ -1405,6 +2258,49 @@ uint32_t __system_property_serial(const prop_info* pi) {
   return serial;
 }
 
+bool __system_property_wait_set(const prop_info* const pis[],
+                                const uint32_t old_serials[],
+                                size_t count,
+                                size_t* changed_index,
+                                const timespec* relative_timeout) {
+  ensure_properties_initialized();
+  if (__system_property_area__ == nullptr || count == 0) {
+    return false;
+  }
+
+  // Sleep on the narrowest word that changes whenever any of the properties
+  // does: the property's own serial if there's only one, the serial of the
+  // area they all share if there is one, and the global serial otherwise.
+  atomic_uint_least32_t* wake_ptr;
+  if (count == 1) {
+    wake_ptr = const_cast<atomic_uint_least32_t*>(&pis[0]->serial);
+  } else {
+    prop_area* pa = get_prop_area_for_info(pis[0]);
+    for (size_t i = 1; pa != nullptr && i < count; ++i) {
+      if (get_prop_area_for_info(pis[i]) != pa) {
+        pa = nullptr;
+      }
+    }
+    wake_ptr = (pa != nullptr) ? pa->serial() : __system_property_area__->serial();
+  }
+
+  while (true) {
+    // Read the wake word before the serials, so that a change made after
+    // we've checked them is guaranteed to also move the wake word.
+    uint32_t wake_serial = load_const_atomic(wake_ptr, memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+      if (load_const_atomic(&pis[i]->serial, memory_order_acquire) != old_serials[i]) {
+        *changed_index = i;
+        return true;
+      }
+    }
+
+    if (__futex_wait(wake_ptr, wake_serial, relative_timeout) == -ETIMEDOUT) {
+      return false;
+    }
+  }
+}
+
 uint32_t __system_property_wait_any(uint32_t old_serial) {
   uint32_t new_serial;
   __system_property_wait(nullptr, old_serial, &new_serial, nullptr);
@@ -1418,6 +2314,7 @@ bool __system_property_wait(const prop_info* pi,
   // Are we waiting on the global serial or a specific serial?
   atomic_uint_least32_t* serial_ptr;
   if (pi == nullptr) {
+    ensure_properties_initialized();
     if (__system_property_area__ == nullptr) return -1;
     serial_ptr = __system_property_area__->serial();
   } else {
@@ -1437,6 +2334,43 @@ bool __system_property_wait(const prop_info* pi,
   return true;
 }
 
+static void add_prop_area_stats(prop_area* pa, prop_area_stats* stats) {
+  const size_t page_size = getpagesize();
+  const size_t page_count = (pa->size() + page_size - 1) / page_size;
+  unsigned char vec[page_count];
+
+  stats->areas_mapped++;
+  stats->bytes_mapped += pa->size();
+  stats->bytes_used += pa->bytes_used();
+  if (mincore(pa, pa->size(), vec) == 0) {
+    for (size_t i = 0; i < page_count; ++i) {
+      if (vec[i] & 1) {
+        stats->bytes_resident += page_size;
+      }
+    }
+  }
+}
+
+int __system_property_area_stats(prop_area_stats* stats) {
+  memset(stats, 0, sizeof(*stats));
+  ensure_properties_initialized();
+  if (!__system_property_area__) {
+    return -1;
+  }
+
+  add_prop_area_stats(__system_property_area__, stats);
+  list_foreach(contexts, [stats](context_node* l) {
+    // In the legacy single-file layout the only context is the serial area.
+    if (l->pa() != nullptr && l->pa() != __system_property_area__) {
+      add_prop_area_stats(l->pa(), stats);
+    }
+  });
+  if (property_info) {
+    stats->bytes_mapped += property_info_size;
+  }
+  return 0;
+}
+
 const prop_info* __system_property_find_nth(unsigned n) {
   struct find_nth {
     const uint32_t sought;
@@ -1454,6 +2388,7 @@ const prop_info* __system_property_find_nth(unsigned n) {
 }
 
 int __system_property_foreach(void (*propfn)(const prop_info* pi, void* cookie), void* cookie) {
+  ensure_properties_initialized();
   if (!__system_property_area__) {
     return -1;
   }
@@ -1465,3 +2400,111 @@ int __system_property_foreach(void (*propfn)(const prop_info* pi, void* cookie),
   });
   return 0;
 }
+
+struct prop_cache {
+  // Set once the property has been found. A prop_info never moves or goes away.
+  _Atomic(const prop_info*) pi;
+  // The global serial the last time we failed to find the property.
+  atomic_uint_least32_t area_serial;
+  char name[0];
+};
+
+static const prop_info* prop_cache_find(prop_cache* cache) {
+  const prop_info* pi = atomic_load_explicit(&cache->pi, memory_order_acquire);
+  if (pi != nullptr) {
+    return pi;
+  }
+
+  // __system_property_find is expensive, so only retry if a property has been
+  // added or changed since the last time we looked.
+  uint32_t area_serial = __system_property_area_serial();
+  if (area_serial == atomic_load_explicit(&cache->area_serial, memory_order_relaxed)) {
+    return nullptr;
+  }
+  pi = __system_property_find(cache->name);
+  if (pi != nullptr) {
+    atomic_store_explicit(&cache->pi, pi, memory_order_release);
+  } else {
+    atomic_store_explicit(&cache->area_serial, area_serial, memory_order_relaxed);
+  }
+  return pi;
+}
+
+prop_cache* __system_property_cache_create(const char* name) {
+  size_t name_len = strlen(name);
+  prop_cache* cache = reinterpret_cast<prop_cache*>(malloc(sizeof(prop_cache) + name_len + 1));
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  memcpy(cache->name, name, name_len + 1);
+
+  uint32_t area_serial = __system_property_area_serial();
+  atomic_init(&cache->pi, __system_property_find(name));
+  atomic_init(&cache->area_serial, area_serial);
+  return cache;
+}
+
+void __system_property_cache_destroy(prop_cache* cache) {
+  free(cache);
+}
+
+uint32_t __system_property_cache_serial(prop_cache* cache) {
+  const prop_info* pi = prop_cache_find(cache);
+  return (pi != nullptr) ? __system_property_serial(pi) : 0;
+}
+
+uint32_t __system_property_cache_read(prop_cache* cache, char* value) {
+  const prop_info* pi = prop_cache_find(cache);
+  if (pi == nullptr) {
+    value[0] = '\0';
+    return 0;
+  }
+
+  // As __system_property_read, but returning the serial that goes with the value.
+  while (true) {
+    uint32_t serial = __system_property_serial(pi);  // acquire semantics
+    size_t len = SERIAL_VALUE_LEN(serial);
+    memcpy(value, pi->value, len + 1);
+    // TODO: see todo in __system_property_read function
+    atomic_thread_fence(memory_order_acquire);
+    if (serial == load_const_atomic(&(pi->serial), memory_order_relaxed)) {
+      return serial;
+    }
+  }
+}
+
+bool __system_property_cache_wait(prop_cache* cache, uint32_t old_serial,
+                                  uint32_t* new_serial_ptr, const timespec* relative_timeout) {
+  ensure_properties_initialized();
+  if (__system_property_area__ == nullptr) {
+    return false;
+  }
+
+  while (true) {
+    // Read the global serial before looking, so that a property added after
+    // we look still wakes us up.
+    uint32_t area_serial = __system_property_area_serial();
+    const prop_info* pi = prop_cache_find(cache);
+    if (pi != nullptr) {
+      uint32_t serial = __system_property_serial(pi);
+      if (serial != old_serial) {
+        *new_serial_ptr = serial;
+        return true;
+      }
+      return __system_property_wait(pi, old_serial, new_serial_ptr, relative_timeout);
+    }
+
+    // A property that doesn't exist has serial 0.
+    if (old_serial != 0) {
+      *new_serial_ptr = 0;
+      return true;
+    }
+
+    // The property doesn't exist yet. Wait for any property to be added or
+    // changed, and then look again.
+    uint32_t new_area_serial;
+    if (!__system_property_wait(nullptr, area_serial, &new_area_serial, relative_timeout)) {
+      return false;
+    }
+  }
+}
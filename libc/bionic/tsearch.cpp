@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#define _SEARCH_PRIVATE
+#include <search.h>
+#include <stdlib.h>
+
+// The tree is kept balanced as an AVL tree, so that inserting keys in order (which
+// is how tsearch is often used, as a map) doesn't degrade it to a list.
+//
+// Callers treat the nodes we return as pointers to their key, so the key must stay the
+// first member, and a node keeps its key for as long as it's in the tree: tdelete
+// relinks nodes rather than moving keys between them.
+
+// An AVL tree with at least 2^64 bytes of nodes would be needed to go deeper than this.
+static constexpr size_t kMaxPath = 96;
+
+typedef int (*compare_fn)(const void*, const void*);
+
+static inline int height(const node_t* n) {
+  return (n != nullptr) ? n->height : 0;
+}
+
+static inline void update_height(node_t* n) {
+  int l = height(n->llink);
+  int r = height(n->rlink);
+  n->height = ((l > r) ? l : r) + 1;
+}
+
+static void rotate_left(node_t** link) {
+  node_t* n = *link;
+  node_t* r = n->rlink;
+  n->rlink = r->llink;
+  r->llink = n;
+  update_height(n);
+  update_height(r);
+  *link = r;
+}
+
+static void rotate_right(node_t** link) {
+  node_t* n = *link;
+  node_t* l = n->llink;
+  n->llink = l->rlink;
+  l->rlink = n;
+  update_height(n);
+  update_height(l);
+  *link = l;
+}
+
+// Restores the balance of the subtree at *link, whose children are balanced but
+// may differ in height by two. Returns true if the subtree's height changed.
+static bool rebalance(node_t** link) {
+  node_t* n = *link;
+  int old_height = n->height;
+  int diff = height(n->llink) - height(n->rlink);
+  if (diff > 1) {
+    if (height(n->llink->llink) < height(n->llink->rlink)) rotate_left(&n->llink);
+    rotate_right(link);
+  } else if (diff < -1) {
+    if (height(n->rlink->rlink) < height(n->rlink->llink)) rotate_right(&n->rlink);
+    rotate_left(link);
+  } else {
+    update_height(n);
+  }
+  return (*link)->height != old_height;
+}
+
+// Rebalances the subtrees at path[depth - 1] up to path[0], stopping early once one
+// of them keeps its height.
+static void rebalance_path(node_t*** path, size_t depth) {
+  while (depth-- > 0) {
+    if (!rebalance(path[depth])) break;
+  }
+}
+
+void* tfind(const void* key, void* const* root_ptr, compare_fn compare) {
+  if (root_ptr == nullptr) return nullptr;
+  node_t* n = static_cast<node_t*>(*root_ptr);
+  while (n != nullptr) {
+    int r = compare(key, n->key);
+    if (r == 0) return n;
+    n = (r < 0) ? n->llink : n->rlink;
+  }
+  return nullptr;
+}
+
+void* tsearch(const void* key, void** root_ptr, compare_fn compare) {
+  if (root_ptr == nullptr) return nullptr;
+
+  node_t** path[kMaxPath];
+  size_t depth = 0;
+  node_t** link = reinterpret_cast<node_t**>(root_ptr);
+  while (*link != nullptr) {
+    int r = compare(key, (*link)->key);
+    if (r == 0) return *link;
+    path[depth++] = link;
+    link = (r < 0) ? &(*link)->llink : &(*link)->rlink;
+  }
+
+  node_t* n = static_cast<node_t*>(malloc(sizeof(*n)));
+  if (n == nullptr) return nullptr;
+  n->key = const_cast<char*>(static_cast<const char*>(key));
+  n->llink = n->rlink = nullptr;
+  n->height = 1;
+  *link = n;
+  rebalance_path(path, depth);
+  return n;
+}
+
+// Returns the deleted node's parent, or an arbitrary non-null pointer if it was the
+// root, like the BSD implementation this replaces.
+void* tdelete(const void* __restrict key, void** __restrict root_ptr, compare_fn compare) {
+  if (root_ptr == nullptr) return nullptr;
+
+  node_t** path[kMaxPath];
+  size_t depth = 0;
+  node_t** link = reinterpret_cast<node_t**>(root_ptr);
+  node_t* parent = nullptr;
+  while (true) {
+    node_t* n = *link;
+    if (n == nullptr) return nullptr;
+    int r = compare(key, n->key);
+    if (r == 0) break;
+    path[depth++] = link;
+    parent = n;
+    link = (r < 0) ? &n->llink : &n->rlink;
+  }
+
+  node_t* deleted = *link;
+  if (deleted->llink == nullptr || deleted->rlink == nullptr) {
+    *link = (deleted->llink != nullptr) ? deleted->llink : deleted->rlink;
+  } else {
+    // Replace the deleted node with its successor, the leftmost node of its right
+    // subtree, rebalancing from where the successor was.
+    size_t deleted_depth = depth;
+    path[depth++] = link;
+    node_t** successor_link = &deleted->rlink;
+    while ((*successor_link)->llink != nullptr) {
+      path[depth++] = successor_link;
+      successor_link = &(*successor_link)->llink;
+    }
+    node_t* successor = *successor_link;
+    *successor_link = successor->rlink;
+    successor->llink = deleted->llink;
+    successor->rlink = deleted->rlink;
+    successor->height = deleted->height;
+    *link = successor;
+    // The path went through the deleted node's right link, which is now the successor's.
+    if (depth > deleted_depth + 1) path[deleted_depth + 1] = &successor->rlink;
+  }
+  free(deleted);
+  rebalance_path(path, depth);
+
+  return (parent != nullptr) ? parent : reinterpret_cast<void*>(1);
+}
+
+static void trecurse(const node_t* n, void (*action)(const void*, VISIT, int), int level) {
+  if (n->llink == nullptr && n->rlink == nullptr) {
+    action(n, leaf, level);
+    return;
+  }
+  action(n, preorder, level);
+  if (n->llink != nullptr) trecurse(n->llink, action, level + 1);
+  action(n, postorder, level);
+  if (n->rlink != nullptr) trecurse(n->rlink, action, level + 1);
+  action(n, endorder, level);
+}
+
+void twalk(const void* root, void (*action)(const void*, VISIT, int)) {
+  if (root != nullptr && action != nullptr) {
+    trecurse(static_cast<const node_t*>(root), action, 0);
+  }
+}
+
+// Destroy a tree and free all allocated resources.
+// This is a GNU extension, not available from BSD.
+void tdestroy(void* root, void (*destroy_func)(void*)) {
+  node_t* n = static_cast<node_t*>(root);
+  if (n == nullptr) return;
+  tdestroy(n->llink, destroy_func);
+  tdestroy(n->rlink, destroy_func);
+  destroy_func(n->key);
+  free(n);
+}
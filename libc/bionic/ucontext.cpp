@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ucontext.h>
+
+#include "private/bionic_ucontext.h"
+
+// getcontext, setcontext and swapcontext are in each architecture's ucontext.S.
+// Contexts made here start 'func' with __bionic_start_context as its return
+// address, and uc_link in a callee-saved register where it will still be when
+// 'func' returns, so __bionic_start_context can switch to it (or exit if it's null).
+extern "C" __LIBC_HIDDEN__ void __bionic_start_context();
+
+#define CHECK_UC_OFFSET(offset, member) \
+  static_assert((offset) == offsetof(ucontext_t, member), #offset " is wrong")
+
+#if defined(__aarch64__)
+
+CHECK_UC_OFFSET(UC_SIGMASK, uc_sigmask);
+CHECK_UC_OFFSET(UC_X0, uc_mcontext.regs[0]);
+CHECK_UC_OFFSET(UC_SP, uc_mcontext.sp);
+CHECK_UC_OFFSET(UC_PC, uc_mcontext.pc);
+CHECK_UC_OFFSET(UC_FPSIMD, uc_mcontext.__reserved);
+static_assert(UC_FPSIMD_FPSR - UC_FPSIMD == offsetof(fpsimd_context, fpsr), "UC_FPSIMD_FPSR is wrong");
+static_assert(UC_FPSIMD_V0 - UC_FPSIMD == offsetof(fpsimd_context, vregs), "UC_FPSIMD_V0 is wrong");
+static_assert(FPSIMD_CONTEXT_MAGIC == FPSIMD_MAGIC, "FPSIMD_CONTEXT_MAGIC is wrong");
+static_assert(FPSIMD_CONTEXT_SIZE == sizeof(fpsimd_context), "FPSIMD_CONTEXT_SIZE is wrong");
+
+static constexpr int kRegisterArgs = 8;
+
+#elif defined(__arm__)
+
+CHECK_UC_OFFSET(UC_R0, uc_mcontext.arm_r0);
+CHECK_UC_OFFSET(UC_SP, uc_mcontext.arm_sp);
+CHECK_UC_OFFSET(UC_LR, uc_mcontext.arm_lr);
+CHECK_UC_OFFSET(UC_PC, uc_mcontext.arm_pc);
+CHECK_UC_OFFSET(UC_SIGMASK, uc_sigmask);
+CHECK_UC_OFFSET(UC_REGSPACE, uc_regspace);
+
+static constexpr int kRegisterArgs = 4;
+
+#elif defined(__i386__)
+
+CHECK_UC_OFFSET(UC_EDI, uc_mcontext.gregs[REG_EDI]);
+CHECK_UC_OFFSET(UC_ESI, uc_mcontext.gregs[REG_ESI]);
+CHECK_UC_OFFSET(UC_EBP, uc_mcontext.gregs[REG_EBP]);
+CHECK_UC_OFFSET(UC_ESP, uc_mcontext.gregs[REG_ESP]);
+CHECK_UC_OFFSET(UC_EBX, uc_mcontext.gregs[REG_EBX]);
+CHECK_UC_OFFSET(UC_EDX, uc_mcontext.gregs[REG_EDX]);
+CHECK_UC_OFFSET(UC_ECX, uc_mcontext.gregs[REG_ECX]);
+CHECK_UC_OFFSET(UC_EAX, uc_mcontext.gregs[REG_EAX]);
+CHECK_UC_OFFSET(UC_EIP, uc_mcontext.gregs[REG_EIP]);
+CHECK_UC_OFFSET(UC_FPREGS, uc_mcontext.fpregs);
+CHECK_UC_OFFSET(UC_SIGMASK, uc_sigmask);
+CHECK_UC_OFFSET(UC_FPREGS_MEM, __fpregs_mem);
+
+static constexpr int kRegisterArgs = 0;
+
+#elif defined(__x86_64__)
+
+CHECK_UC_OFFSET(UC_R8, uc_mcontext.gregs[REG_R8]);
+CHECK_UC_OFFSET(UC_R9, uc_mcontext.gregs[REG_R9]);
+CHECK_UC_OFFSET(UC_R12, uc_mcontext.gregs[REG_R12]);
+CHECK_UC_OFFSET(UC_R13, uc_mcontext.gregs[REG_R13]);
+CHECK_UC_OFFSET(UC_R14, uc_mcontext.gregs[REG_R14]);
+CHECK_UC_OFFSET(UC_R15, uc_mcontext.gregs[REG_R15]);
+CHECK_UC_OFFSET(UC_RDI, uc_mcontext.gregs[REG_RDI]);
+CHECK_UC_OFFSET(UC_RSI, uc_mcontext.gregs[REG_RSI]);
+CHECK_UC_OFFSET(UC_RBP, uc_mcontext.gregs[REG_RBP]);
+CHECK_UC_OFFSET(UC_RBX, uc_mcontext.gregs[REG_RBX]);
+CHECK_UC_OFFSET(UC_RDX, uc_mcontext.gregs[REG_RDX]);
+CHECK_UC_OFFSET(UC_RAX, uc_mcontext.gregs[REG_RAX]);
+CHECK_UC_OFFSET(UC_RCX, uc_mcontext.gregs[REG_RCX]);
+CHECK_UC_OFFSET(UC_RSP, uc_mcontext.gregs[REG_RSP]);
+CHECK_UC_OFFSET(UC_RIP, uc_mcontext.gregs[REG_RIP]);
+CHECK_UC_OFFSET(UC_FPREGS, uc_mcontext.fpregs);
+CHECK_UC_OFFSET(UC_SIGMASK, uc_sigmask);
+CHECK_UC_OFFSET(UC_FPREGS_MEM, __fpregs_mem);
+CHECK_UC_OFFSET(UC_MXCSR, __fpregs_mem.mxcsr);
+
+static constexpr int kRegisterArgs = 6;
+
+#endif
+
+// Sets argument register 'i', for i < kRegisterArgs.
+static void set_register_arg(ucontext_t* ucp, int i, uintptr_t value) {
+#if defined(__aarch64__)
+  ucp->uc_mcontext.regs[i] = value;
+#elif defined(__arm__)
+  (&ucp->uc_mcontext.arm_r0)[i] = value;
+#elif defined(__x86_64__)
+  static constexpr int kArgRegs[kRegisterArgs] = {
+    REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9,
+  };
+  ucp->uc_mcontext.gregs[kArgRegs[i]] = value;
+#else
+  (void) ucp; (void) i; (void) value;
+#endif
+}
+
+void makecontext(ucontext_t* ucp, void (*func)(), int argc, ...) {
+  // The arguments that don't fit in registers go at the bottom of the stack,
+  // 16-byte aligned. (Which is more than arm needs, but no matter.)
+  int stack_args = (argc > kRegisterArgs) ? argc - kRegisterArgs : 0;
+  uintptr_t sp = reinterpret_cast<uintptr_t>(ucp->uc_stack.ss_sp) + ucp->uc_stack.ss_size;
+  sp = (sp - stack_args * sizeof(uintptr_t)) & ~static_cast<uintptr_t>(15);
+  uintptr_t* stack = reinterpret_cast<uintptr_t*>(sp);
+
+  // Like glibc, we read the arguments as words rather than ints, so that
+  // pointers can be passed on LP64 too.
+  va_list args;
+  va_start(args, argc);
+  for (int i = 0; i < argc; ++i) {
+    uintptr_t arg = va_arg(args, uintptr_t);
+    if (i < kRegisterArgs) {
+      set_register_arg(ucp, i, arg);
+    } else {
+      stack[i - kRegisterArgs] = arg;
+    }
+  }
+  va_end(args);
+
+  uintptr_t link = reinterpret_cast<uintptr_t>(ucp->uc_link);
+  uintptr_t start = reinterpret_cast<uintptr_t>(__bionic_start_context);
+  uintptr_t pc = reinterpret_cast<uintptr_t>(func);
+
+#if defined(__aarch64__)
+  ucp->uc_mcontext.regs[19] = link;
+  ucp->uc_mcontext.regs[29] = 0;
+  ucp->uc_mcontext.regs[30] = start;
+  ucp->uc_mcontext.sp = sp;
+  ucp->uc_mcontext.pc = pc;
+#elif defined(__arm__)
+  ucp->uc_mcontext.arm_r4 = link;
+  ucp->uc_mcontext.arm_fp = 0;
+  ucp->uc_mcontext.arm_lr = start;
+  ucp->uc_mcontext.arm_sp = sp;
+  ucp->uc_mcontext.arm_pc = pc;
+#elif defined(__i386__)
+  // The return address goes just below the arguments, where 'func' expects it.
+  *--stack = start;
+  ucp->uc_mcontext.gregs[REG_ESI] = link;
+  ucp->uc_mcontext.gregs[REG_EBP] = 0;
+  ucp->uc_mcontext.gregs[REG_ESP] = reinterpret_cast<uintptr_t>(stack);
+  ucp->uc_mcontext.gregs[REG_EIP] = pc;
+#elif defined(__x86_64__)
+  *--stack = start;
+  ucp->uc_mcontext.gregs[REG_RBX] = link;
+  ucp->uc_mcontext.gregs[REG_RBP] = 0;
+  ucp->uc_mcontext.gregs[REG_RSP] = reinterpret_cast<uintptr_t>(stack);
+  ucp->uc_mcontext.gregs[REG_RIP] = pc;
+#endif
+}
@@ -17,19 +17,24 @@
 #include "private/bionic_globals.h"
 #include "private/bionic_vdso.h"
 
+#include <sys/time.h>
+#include <time.h>
+
 #if defined(__aarch64__) || defined(__arm__) || defined(__i386__) || defined(__x86_64__)
 
 #include <limits.h>
 #include <link.h>
 #include <string.h>
 #include <sys/cdefs.h>
-#include <sys/time.h>
-#include <time.h>
 #include <unistd.h>
 #include "private/KernelArgumentBlock.h"
 
 #define AT_SYSINFO_EHDR 33 /* until we have new enough uapi headers... */
 
+// The kernel's vdso answers CLOCK_MONOTONIC_COARSE and CLOCK_REALTIME_COARSE
+// from its data page without reading the clocksource, so unlike the precise
+// clocks they don't fall back to a syscall when the clocksource isn't usable
+// from user space. That makes them the cheap choice for millisecond timestamps.
 int clock_gettime(int clock_id, timespec* tp) {
   auto vdso_clock_gettime = reinterpret_cast<decltype(&clock_gettime)>(
     __libc_globals->vdso[VDSO_CLOCK_GETTIME].fn);
@@ -48,12 +53,26 @@ int gettimeofday(timeval* tv, struct timezone* tz) {
   return __gettimeofday(tv, tz);
 }
 
+int clock_getres(int clock_id, timespec* tp) {
+  auto vdso_clock_getres = reinterpret_cast<decltype(&clock_getres)>(
+    __libc_globals->vdso[VDSO_CLOCK_GETRES].fn);
+  if (__predict_true(vdso_clock_getres)) {
+    return vdso_clock_getres(clock_id, tp);
+  }
+  return __clock_getres(clock_id, tp);
+}
+
 void __libc_init_vdso(libc_globals* globals, KernelArgumentBlock& args) {
   auto&& vdso = globals->vdso;
   vdso[VDSO_CLOCK_GETTIME] = { VDSO_CLOCK_GETTIME_SYMBOL,
                                reinterpret_cast<void*>(__clock_gettime) };
   vdso[VDSO_GETTIMEOFDAY] = { VDSO_GETTIMEOFDAY_SYMBOL,
                               reinterpret_cast<void*>(__gettimeofday) };
+  vdso[VDSO_CLOCK_GETRES] = { VDSO_CLOCK_GETRES_SYMBOL,
+                              reinterpret_cast<void*>(__clock_getres) };
+  // time has no syscall of its own on every architecture; see time below.
+  vdso[VDSO_TIME] = { VDSO_TIME_SYMBOL, nullptr };
+  vdso[VDSO_GETCPU] = { VDSO_GETCPU_SYMBOL, reinterpret_cast<void*>(__getcpu) };
 
   // Do we have a vdso?
   uintptr_t vdso_ehdr_addr = args.getauxval(AT_SYSINFO_EHDR);
@@ -106,7 +125,7 @@ void __libc_init_vdso(libc_globals* globals, KernelArgumentBlock& args) {
   // Are there any symbols we want?
   for (size_t i = 0; i < symbol_count; ++i) {
     for (size_t j = 0; j < VDSO_END; ++j) {
-      if (strcmp(vdso[j].name, strtab + symtab[i].st_name) == 0) {
+      if (vdso[j].name != nullptr && strcmp(vdso[j].name, strtab + symtab[i].st_name) == 0) {
         vdso[j].fn = reinterpret_cast<void*>(vdso_addr + symtab[i].st_value);
       }
     }
@@ -119,3 +138,20 @@ void __libc_init_vdso(libc_globals*, KernelArgumentBlock&) {
 }
 
 #endif
+
+time_t time(time_t* t) {
+  auto vdso_time = reinterpret_cast<decltype(&time)>(__libc_globals->vdso[VDSO_TIME].fn);
+  if (__predict_true(vdso_time)) {
+    return vdso_time(t);
+  }
+
+  // gettimeofday is still cheap if it came from the vdso.
+  timeval tv;
+  if (gettimeofday(&tv, nullptr) == -1) {
+    return -1;
+  }
+  if (t != nullptr) {
+    *t = tv.tv_sec;
+  }
+  return tv.tv_sec;
+}
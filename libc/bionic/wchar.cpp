@@ -27,6 +27,7 @@
  */
 
 #include <errno.h>
+#include <stdint.h>
 #include <sys/param.h>
 #include <string.h>
 #include <wchar.h>
@@ -61,32 +62,118 @@ size_t mbrtowc(wchar_t* pwc, const char* s, size_t n, mbstate_t* ps) {
   static mbstate_t __private_state;
   mbstate_t* state = (ps == NULL) ? &__private_state : ps;
 
+  // Plain ASCII is by far the most common case, so handle it without the
+  // state checks mbrtoc32 needs for the general case.
+  if (s != NULL && n > 0 && static_cast<uint8_t>(*s) < 0x80 && mbsinit(state)) {
+    if (pwc != NULL) *pwc = static_cast<uint8_t>(*s);
+    return (*s != '\0') ? 1 : 0;
+  }
+
   // Our wchar_t is UTF-32.
   return mbrtoc32(reinterpret_cast<char32_t*>(pwc), s, n, state);
 }
 
+// mbsnrtowcs handles runs of ASCII a word at a time, and decodes complete, valid
+// multibyte sequences itself. Anything else (a sequence started by an earlier call,
+// or one that's invalid or cut short) goes through mbrtowc, so the state and error
+// handling are exactly mbrtowc's.
+
+typedef unsigned long word_t;
+
+static constexpr word_t kOnes = ~static_cast<word_t>(0) / 0xff;
+static constexpr word_t kHighs = kOnes * 0x80;
+
+static inline word_t load_word(const uint8_t* p) {
+  word_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+// Returns the length of the run of non-NUL ASCII at the start of s[0, n), widening it
+// into dst unless dst is null. n is SIZE_MAX for mbsrtowcs, so words are only loaded
+// from chunks that strnlen has already measured. The chunks start small, since most
+// runs in non-English text are short, and double while the run continues.
+static size_t ascii_run(wchar_t* dst, const uint8_t* s, size_t n) {
+  size_t i = 0;
+  size_t chunk = 2 * sizeof(word_t);
+  while (i < n) {
+    size_t limit = MIN(n - i, chunk);
+    size_t end = i + strnlen(reinterpret_cast<const char*>(s + i), limit);
+    size_t start = i;
+    while (end - i >= sizeof(word_t) && (load_word(s + i) & kHighs) == 0) {
+      i += sizeof(word_t);
+    }
+    while (i < end && s[i] < 0x80) {
+      ++i;
+    }
+    if (dst != nullptr) {
+      for (size_t k = start; k < i; ++k) dst[k] = s[k];
+    }
+    if (i - start != limit) break;
+    if (chunk < 4096) chunk *= 2;
+  }
+  return i;
+}
+
+// Decodes the multibyte sequence at s, if it's complete within s[0, n) and valid by
+// the same rules as mbrtoc32. Returns its length, or 0 to leave it to mbrtowc.
+// Continuation bytes are checked in order, so this never reads past a NUL.
+static size_t decode_multibyte(wchar_t* wc, const uint8_t* s, size_t n) {
+  uint8_t ch = s[0];
+  size_t length;
+  char32_t c32;
+  char32_t lower_bound;
+  if ((ch & 0xe0) == 0xc0) {
+    length = 2;
+    c32 = ch & 0x1f;
+    lower_bound = 0x80;
+  } else if ((ch & 0xf0) == 0xe0) {
+    length = 3;
+    c32 = ch & 0x0f;
+    lower_bound = 0x800;
+  } else if ((ch & 0xf8) == 0xf0) {
+    length = 4;
+    c32 = ch & 0x07;
+    lower_bound = 0x10000;
+  } else {
+    return 0;
+  }
+  if (n < length) return 0;
+  for (size_t i = 1; i < length; ++i) {
+    if ((s[i] & 0xc0) != 0x80) return 0;
+    c32 = (c32 << 6) | (s[i] & 0x3f);
+  }
+  if (c32 < lower_bound || (c32 >= 0xd800 && c32 <= 0xdfff) || c32 == 0xfffe || c32 == 0xffff) {
+    return 0;
+  }
+  if (wc != nullptr) *wc = c32;
+  return length;
+}
+
 size_t mbsnrtowcs(wchar_t* dst, const char** src, size_t nmc, size_t len, mbstate_t* ps) {
   static mbstate_t __private_state;
   mbstate_t* state = (ps == NULL) ? &__private_state : ps;
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(*src);
   size_t i, o, r;
 
   // The fast paths in the loops below are not safe if an ASCII
   // character appears as anything but the first byte of a
   // multibyte sequence. Check now to avoid doing it in the loops.
-  if (nmc > 0 && mbstate_bytes_so_far(state) > 0 && static_cast<uint8_t>((*src)[0]) < 0x80) {
+  if (nmc > 0 && mbstate_bytes_so_far(state) > 0 && s[0] < 0x80) {
     return reset_and_return_illegal(EILSEQ, state);
   }
 
   // Measure only?
   if (dst == NULL) {
     for (i = o = 0; i < nmc; i += r, o++) {
-      if (static_cast<uint8_t>((*src)[i]) < 0x80) {
+      if (s[i] < 0x80) {
         // Fast path for plain ASCII characters.
-        if ((*src)[i] == '\0') {
+        if (s[i] == '\0') {
           return reset_and_return(o, state);
         }
-        r = 1;
-      } else {
+        r = ascii_run(NULL, s + i, nmc - i);
+        o += r - 1;
+      } else if (!mbsinit(state) || (r = decode_multibyte(NULL, s + i, nmc - i)) == 0) {
         r = mbrtowc(NULL, *src + i, nmc - i, state);
         if (r == __MB_ERR_ILLEGAL_SEQUENCE) {
           return reset_and_return_illegal(EILSEQ, state);
@@ -104,15 +191,16 @@ size_t mbsnrtowcs(wchar_t* dst, const char** src, size_t nmc, size_t len, mbstat
 
   // Actually convert, updating `dst` and `src`.
   for (i = o = 0; i < nmc && o < len; i += r, o++) {
-    if (static_cast<uint8_t>((*src)[i]) < 0x80) {
+    if (s[i] < 0x80) {
       // Fast path for plain ASCII characters.
-      dst[o] = (*src)[i];
-      r = 1;
-      if ((*src)[i] == '\0') {
+      if (s[i] == '\0') {
+        dst[o] = L'\0';
         *src = nullptr;
         return reset_and_return(o, state);
       }
-    } else {
+      r = ascii_run(dst + o, s + i, MIN(nmc - i, len - o));
+      o += r - 1;
+    } else if (!mbsinit(state) || (r = decode_multibyte(dst + o, s + i, nmc - i)) == 0) {
       r = mbrtowc(dst + o, *src + i, nmc - i, state);
       if (r == __MB_ERR_ILLEGAL_SEQUENCE) {
         *src += i;
@@ -140,6 +228,12 @@ size_t wcrtomb(char* s, wchar_t wc, mbstate_t* ps) {
   static mbstate_t __private_state;
   mbstate_t* state = (ps == NULL) ? &__private_state : ps;
 
+  if (s != NULL && static_cast<uint32_t>(wc) < 0x80 && mbsinit(state)) {
+    // Fast path for plain ASCII characters (and the null character).
+    *s = static_cast<char>(wc);
+    return 1;
+  }
+
   // Our wchar_t is UTF-32.
   return c32rtomb(s, static_cast<char32_t>(wc), state);
 }
@@ -28,47 +28,40 @@
 
 #include <wctype.h>
 
-#include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 
-#include "private/icu.h"
+// Character classes and case mappings come from a table generated from ICU by
+// libc/tools/genwctype.py, so we don't have to load ICU into every process that
+// classifies a wide character.
+#include "wctype_table.h"
 
-static bool __icu_hasBinaryProperty(wint_t wc, UProperty property, int (*fallback)(int)) {
-  typedef UBool (*FnT)(UChar32, UProperty);
-  static auto u_hasBinaryProperty = reinterpret_cast<FnT>(__find_icu_symbol("u_hasBinaryProperty"));
-  return u_hasBinaryProperty ? u_hasBinaryProperty(wc, property) : fallback(wc);
+static inline const wctype_record& __wctype_lookup(wint_t wc) {
+  if (wc >= WCTYPE_TABLE_LIMIT) return wctype_records[0];
+  size_t block = wctype_blocks[wc >> WCTYPE_BLOCK_SHIFT];
+  size_t offset = wc & ((1 << WCTYPE_BLOCK_SHIFT) - 1);
+  return wctype_records[wctype_block_records[(block << WCTYPE_BLOCK_SHIFT) | offset]];
 }
 
-int iswalnum(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_POSIX_ALNUM, isalnum); }
-int iswalpha(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_ALPHABETIC, isalpha); }
-int iswblank(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_POSIX_BLANK, isblank); }
-int iswgraph(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_POSIX_GRAPH, isgraph); }
-int iswlower(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_LOWERCASE, islower); }
-int iswprint(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_POSIX_PRINT, isprint); }
-int iswspace(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_WHITE_SPACE, isspace); }
-int iswupper(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_UPPERCASE, isupper); }
-int iswxdigit(wint_t wc) { return __icu_hasBinaryProperty(wc, UCHAR_POSIX_XDIGIT, isxdigit); }
-
-int iswcntrl(wint_t wc) {
-  typedef int8_t (*FnT)(UChar32);
-  static auto u_charType = reinterpret_cast<FnT>(__find_icu_symbol("u_charType"));
-  return u_charType ? (u_charType(wc) == U_CONTROL_CHAR) : iscntrl(wc);
+static inline int __wctype_is(wint_t wc, wctype_t char_class) {
+  return (__wctype_lookup(wc).classes >> char_class) & 1;
 }
 
-int iswdigit(wint_t wc) {
-  typedef UBool (*FnT)(UChar32);
-  static auto u_isdigit = reinterpret_cast<FnT>(__find_icu_symbol("u_isdigit"));
-  return u_isdigit ? u_isdigit(wc) : isdigit(wc);
-}
-
-int iswpunct(wint_t wc) {
-  typedef UBool (*FnT)(UChar32);
-  static auto u_ispunct = reinterpret_cast<FnT>(__find_icu_symbol("u_ispunct"));
-  return u_ispunct ? u_ispunct(wc) : ispunct(wc);
-}
+int iswalnum(wint_t wc) { return __wctype_is(wc, WC_TYPE_ALNUM); }
+int iswalpha(wint_t wc) { return __wctype_is(wc, WC_TYPE_ALPHA); }
+int iswblank(wint_t wc) { return __wctype_is(wc, WC_TYPE_BLANK); }
+int iswcntrl(wint_t wc) { return __wctype_is(wc, WC_TYPE_CNTRL); }
+int iswdigit(wint_t wc) { return __wctype_is(wc, WC_TYPE_DIGIT); }
+int iswgraph(wint_t wc) { return __wctype_is(wc, WC_TYPE_GRAPH); }
+int iswlower(wint_t wc) { return __wctype_is(wc, WC_TYPE_LOWER); }
+int iswprint(wint_t wc) { return __wctype_is(wc, WC_TYPE_PRINT); }
+int iswpunct(wint_t wc) { return __wctype_is(wc, WC_TYPE_PUNCT); }
+int iswspace(wint_t wc) { return __wctype_is(wc, WC_TYPE_SPACE); }
+int iswupper(wint_t wc) { return __wctype_is(wc, WC_TYPE_UPPER); }
+int iswxdigit(wint_t wc) { return __wctype_is(wc, WC_TYPE_XDIGIT); }
 
 int iswalnum_l(wint_t c, locale_t) { return iswalnum(c); }
 int iswalpha_l(wint_t c, locale_t) { return iswalpha(c); }
@@ -84,21 +77,8 @@ int iswupper_l(wint_t c, locale_t) { return iswupper(c); }
 int iswxdigit_l(wint_t c, locale_t) { return iswxdigit(c); }
 
 int iswctype(wint_t wc, wctype_t char_class) {
-  switch (char_class) {
-    case WC_TYPE_ALNUM: return iswalnum(wc);
-    case WC_TYPE_ALPHA: return iswalpha(wc);
-    case WC_TYPE_BLANK: return iswblank(wc);
-    case WC_TYPE_CNTRL: return iswcntrl(wc);
-    case WC_TYPE_DIGIT: return iswdigit(wc);
-    case WC_TYPE_GRAPH: return iswgraph(wc);
-    case WC_TYPE_LOWER: return iswlower(wc);
-    case WC_TYPE_PRINT: return iswprint(wc);
-    case WC_TYPE_PUNCT: return iswpunct(wc);
-    case WC_TYPE_SPACE: return iswspace(wc);
-    case WC_TYPE_UPPER: return iswupper(wc);
-    case WC_TYPE_XDIGIT: return iswxdigit(wc);
-    default: return 0;
-  }
+  if (char_class == WC_TYPE_INVALID || char_class >= WC_TYPE_MAX) return 0;
+  return __wctype_is(wc, char_class);
 }
 
 int iswctype_l(wint_t wc, wctype_t char_class, locale_t) {
@@ -106,15 +86,11 @@ int iswctype_l(wint_t wc, wctype_t char_class, locale_t) {
 }
 
 wint_t towlower(wint_t wc) {
-  typedef UChar32 (*FnT)(UChar32);
-  static auto u_tolower = reinterpret_cast<FnT>(__find_icu_symbol("u_tolower"));
-  return u_tolower ? u_tolower(wc) : tolower(wc);
+  return wc + __wctype_lookup(wc).lower_delta;
 }
 
 wint_t towupper(wint_t wc) {
-  typedef UChar32 (*FnT)(UChar32);
-  static auto u_toupper = reinterpret_cast<FnT>(__find_icu_symbol("u_toupper"));
-  return u_toupper ? u_toupper(wc) : toupper(wc);
+  return wc + __wctype_lookup(wc).upper_delta;
 }
 
 wint_t towupper_l(wint_t c, locale_t) { return towupper(c); }
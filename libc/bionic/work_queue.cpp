@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/work_queue.h>
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/sysinfo.h>
+
+#include "pthread_internal.h"
+
+#include "private/bionic_futex.h"
+#include "private/bionic_lock.h"
+#include "private/bionic_work_queue.h"
+
+// More workers than this don't help the kinds of work libc does, which are short
+// bursts of loading or relocating, so we don't use every CPU on big devices.
+#define WORK_QUEUE_MAX_WORKERS 8
+
+struct WorkItem {
+  void (*fn)(void*);
+  void* arg;
+  WorkGroup* group;
+};
+
+// A bounded ring of work items. The worker that owns a deque pushes and pops at the back,
+// which keeps the work it just created hot in its cache, and other threads steal from the
+// front. The critical sections are only a few loads and stores, so a Lock is simpler here
+// than a lock-free deque and costs about the same when uncontended.
+//
+// Like everything else in this file, a WorkDeque can be initialized by setting its memory
+// to 0, so that g_work_queue doesn't need a constructor.
+template <size_t N>
+class WorkDeque {
+ public:
+  bool push_back(const WorkItem& item) {
+    lock_.lock();
+    size_t count = atomic_load_explicit(&count_, memory_order_relaxed);
+    bool pushed = (count < N);
+    if (pushed) {
+      items_[(head_ + count) % N] = item;
+      atomic_store_explicit(&count_, count + 1, memory_order_relaxed);
+    }
+    lock_.unlock();
+    return pushed;
+  }
+
+  bool pop_back(WorkItem* item) {
+    return pop(item, false);
+  }
+
+  bool pop_front(WorkItem* item) {
+    return pop(item, true);
+  }
+
+  // A peek that doesn't take the lock, so that idle threads looking for work don't
+  // contend with the owner.
+  bool empty() const {
+    return atomic_load_explicit(&count_, memory_order_relaxed) == 0;
+  }
+
+  Lock& lock() {
+    return lock_;
+  }
+
+ private:
+  bool pop(WorkItem* item, bool front) {
+    if (empty()) {
+      return false;
+    }
+    lock_.lock();
+    size_t count = atomic_load_explicit(&count_, memory_order_relaxed);
+    bool popped = (count != 0);
+    if (popped) {
+      if (front) {
+        *item = items_[head_];
+        head_ = (head_ + 1) % N;
+      } else {
+        *item = items_[(head_ + count - 1) % N];
+      }
+      atomic_store_explicit(&count_, count - 1, memory_order_relaxed);
+    }
+    lock_.unlock();
+    return popped;
+  }
+
+  Lock lock_;
+  size_t head_;
+  _Atomic(size_t) count_;
+  WorkItem items_[N];
+};
+
+class WorkQueue {
+ public:
+  void submit(const WorkItem& item);
+
+  // Runs one queued item, if there is one. worker is the caller's worker index, or -1.
+  bool run_one(int worker);
+
+  void fork_prepare();
+  void fork_parent();
+  void fork_child();
+
+ private:
+  void ensure_started();
+  void wake_one();
+  bool has_work();
+  static void* worker_main(void* arg);
+
+  Lock start_lock_;
+  atomic_bool started_;
+  int worker_count_;
+
+  // Idle workers sleep on wake_seq_, which submitters bump when sleepers_ says there's
+  // anyone to wake.
+  atomic_uint sleepers_;
+  atomic_uint wake_seq_;
+
+  WorkDeque<256> shared_;
+  WorkDeque<128> workers_[WORK_QUEUE_MAX_WORKERS];
+};
+
+static WorkQueue g_work_queue;
+
+static inline int __current_worker() {
+  return __get_thread()->work_queue_worker - 1;
+}
+
+static int __work_queue_worker_count() {
+  int cpus = get_nprocs_available();
+  return (cpus < WORK_QUEUE_MAX_WORKERS) ? cpus : WORK_QUEUE_MAX_WORKERS;
+}
+
+void* WorkQueue::worker_main(void* arg) {
+  int worker = static_cast<int>(reinterpret_cast<intptr_t>(arg));
+  __get_thread()->work_queue_worker = worker + 1;
+
+  WorkQueue* queue = &g_work_queue;
+  while (true) {
+    if (queue->run_one(worker)) {
+      continue;
+    }
+
+    // Announce that we're about to sleep before the last look for work. A submitter
+    // either sees us in sleepers_ and bumps wake_seq_, so that the wait below
+    // returns at once, or pushed its work early enough for has_work to see it.
+    unsigned int seq = atomic_load_explicit(&queue->wake_seq_, memory_order_relaxed);
+    atomic_fetch_add_explicit(&queue->sleepers_, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!queue->has_work()) {
+      __futex_wait_ex(&queue->wake_seq_, false, seq, false, nullptr);
+    }
+    atomic_fetch_sub_explicit(&queue->sleepers_, 1, memory_order_relaxed);
+  }
+  return nullptr;
+}
+
+void WorkQueue::ensure_started() {
+  if (__predict_true(atomic_load_explicit(&started_, memory_order_acquire))) {
+    return;
+  }
+
+  start_lock_.lock();
+  if (!atomic_load_explicit(&started_, memory_order_relaxed)) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    // Workers run code for all of libc's callers, so they shouldn't take any of the
+    // process' asynchronous signals. Blocking them here lets the workers inherit the mask
+    // without a window where one could be delivered. Signals caused by the work itself
+    // are left alone so that crashes are still reported.
+    sigset_t blocked;
+    sigfillset(&blocked);
+    sigdelset(&blocked, SIGABRT);
+    sigdelset(&blocked, SIGBUS);
+    sigdelset(&blocked, SIGFPE);
+    sigdelset(&blocked, SIGILL);
+    sigdelset(&blocked, SIGSEGV);
+    sigdelset(&blocked, SIGSYS);
+    sigdelset(&blocked, SIGTRAP);
+    sigset_t old_mask;
+    pthread_sigmask(SIG_BLOCK, &blocked, &old_mask);
+
+    int wanted = __work_queue_worker_count();
+    int count = 0;
+    while (count < wanted) {
+      pthread_t thread;
+      if (pthread_create(&thread, &attr, worker_main,
+                         reinterpret_cast<void*>(static_cast<intptr_t>(count))) != 0) {
+        break;
+      }
+      pthread_setname_np(thread, "libc_worker");
+      ++count;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    pthread_attr_destroy(&attr);
+
+    // If we couldn't start any workers, submitters run their work themselves.
+    worker_count_ = count;
+    atomic_store_explicit(&started_, true, memory_order_release);
+  }
+  start_lock_.unlock();
+}
+
+bool WorkQueue::has_work() {
+  if (!shared_.empty()) {
+    return true;
+  }
+  for (size_t i = 0; i < WORK_QUEUE_MAX_WORKERS; ++i) {
+    if (!workers_[i].empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkQueue::wake_one() {
+  // Pairs with the fence in worker_main: either the worker's last look for work sees the
+  // item we just pushed, or we see it in sleepers_.
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&sleepers_, memory_order_relaxed) != 0) {
+    atomic_fetch_add_explicit(&wake_seq_, 1, memory_order_relaxed);
+    __futex_wake_ex(&wake_seq_, false, 1);
+  }
+}
+
+void WorkQueue::submit(const WorkItem& item) {
+  ensure_started();
+
+  bool queued = false;
+  if (worker_count_ > 0) {
+    int worker = __current_worker();
+    queued = (worker >= 0) ? workers_[worker].push_back(item) : shared_.push_back(item);
+  }
+  if (!queued) {
+    item.fn(item.arg);
+    item.group->finish_one();
+    return;
+  }
+  wake_one();
+}
+
+bool WorkQueue::run_one(int worker) {
+  WorkItem item;
+  bool found = (worker >= 0 && workers_[worker].pop_back(&item)) || shared_.pop_front(&item);
+
+  // Steal the oldest work from another deque. This looks at every deque rather than only
+  // those of running workers, so that a child of fork can still find work that was queued
+  // on a worker that didn't survive the fork.
+  for (int i = 1; !found && i <= WORK_QUEUE_MAX_WORKERS; ++i) {
+    int victim = (worker + i + WORK_QUEUE_MAX_WORKERS) % WORK_QUEUE_MAX_WORKERS;
+    if (victim != worker) {
+      found = workers_[victim].pop_front(&item);
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  item.fn(item.arg);
+  item.group->finish_one();
+  return true;
+}
+
+// Taking every lock before fork means the child's copies aren't left locked by threads
+// that don't exist there.
+void WorkQueue::fork_prepare() {
+  start_lock_.lock();
+  shared_.lock().lock();
+  for (size_t i = 0; i < WORK_QUEUE_MAX_WORKERS; ++i) {
+    workers_[i].lock().lock();
+  }
+}
+
+void WorkQueue::fork_parent() {
+  for (size_t i = WORK_QUEUE_MAX_WORKERS; i > 0; --i) {
+    workers_[i - 1].lock().unlock();
+  }
+  shared_.lock().unlock();
+  start_lock_.unlock();
+}
+
+void WorkQueue::fork_child() {
+  for (size_t i = 0; i < WORK_QUEUE_MAX_WORKERS; ++i) {
+    workers_[i].lock().init(false);
+  }
+  shared_.lock().init(false);
+  start_lock_.init(false);
+
+  // None of the workers exist in the child. Queued work stays queued, and the next
+  // submission starts new workers to run it.
+  worker_count_ = 0;
+  atomic_store_explicit(&sleepers_, 0, memory_order_relaxed);
+  atomic_store_explicit(&started_, false, memory_order_relaxed);
+}
+
+void WorkGroup::submit(void (*fn)(void*), void* arg) {
+  atomic_fetch_add_explicit(&pending_, 1, memory_order_relaxed);
+  g_work_queue.submit(WorkItem{fn, arg, this});
+}
+
+void WorkGroup::finish_one() {
+  // The release pairs with the acquire in wait, so the waiter sees everything the work did.
+  if (atomic_fetch_sub_explicit(&pending_, 1, memory_order_release) == 1) {
+    __futex_wake_ex(&pending_, false, INT_MAX);
+  }
+}
+
+void WorkGroup::wait() {
+  int worker = __current_worker();
+  while (true) {
+    unsigned int pending = atomic_load_explicit(&pending_, memory_order_acquire);
+    if (pending == 0) {
+      return;
+    }
+    if (g_work_queue.run_one(worker)) {
+      continue;
+    }
+    if (worker >= 0) {
+      // A worker mustn't sleep here: the work we're waiting for may be queued behind
+      // us on our own deque, or need every worker to get through it.
+      sched_yield();
+      continue;
+    }
+    __futex_wait_ex(&pending_, false, pending, false, nullptr);
+  }
+}
+
+void __work_queue_fork_prepare() {
+  g_work_queue.fork_prepare();
+}
+
+void __work_queue_fork_parent() {
+  g_work_queue.fork_parent();
+}
+
+void __work_queue_fork_child() {
+  g_work_queue.fork_child();
+}
+
+struct android_work_group {
+  WorkGroup group;
+};
+
+android_work_group* android_work_group_create() {
+  android_work_group* result =
+      reinterpret_cast<android_work_group*>(calloc(1, sizeof(android_work_group)));
+  if (result != nullptr) {
+    result->group.init();
+  }
+  return result;
+}
+
+void android_work_group_submit(android_work_group* group, void (*fn)(void*), void* arg) {
+  group->group.submit(fn, arg);
+}
+
+void android_work_group_wait(android_work_group* group) {
+  group->group.wait();
+}
+
+void android_work_group_destroy(android_work_group* group) {
+  group->group.wait();
+  free(group);
+}
@@ -44,6 +44,11 @@ void sethostent_r(FILE **);
 struct hostent	*netbsd_gethostent_r(FILE *, struct hostent *, char *, size_t, int *);
 void endhostent_r(FILE **);
 
+/* netbsd_gethostent_r, reading through a hosts_cursor */
+struct hosts_cursor;
+struct hostent	*_hf_gethostent_r(struct hosts_cursor *, struct hostent *, char *, size_t,
+    int *);
+
 /*
  * The following are internal API's and are used only for testing.
  */
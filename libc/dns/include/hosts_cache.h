@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef _HOSTS_CACHE_H_
+#define _HOSTS_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/cdefs.h>
+
+struct hosts_snapshot;
+
+/* A read position in the hosts file. Lookups use one in place of a FILE*:
+ * _hosts_gets returns lines like fgets does, but when the file has been
+ * indexed only the lines that have the looked-up name among their fields
+ * are returned, so callers must still check each line as before. */
+struct hosts_cursor {
+    struct hosts_snapshot*  snap;      /* NULL when reading 'hf' instead */
+    FILE*                   hf;
+    int                     close_hf;  /* whether _hosts_close closes 'hf' */
+    const char*             name;      /* NULL to return every line */
+    size_t                  name_len;
+    uint32_t                hash;
+    int32_t                 next;      /* next index entry, or next line offset */
+};
+
+/* opens a cursor over _PATH_HOSTS for lines that mention 'name', or every
+ * line if 'name' is NULL. The file is read and indexed once, and the index
+ * is shared by all lookups until the file's size or mtime changes. Returns
+ * 0, or -1 if the file can't be read. */
+__LIBC_HIDDEN__
+extern int  _hosts_open(struct hosts_cursor* cursor, const char* name);
+
+/* makes a cursor that reads every line of an already-open file, which
+ * _hosts_close leaves open */
+__LIBC_HIDDEN__
+extern void _hosts_open_file(struct hosts_cursor* cursor, FILE* hf);
+
+/* copies the next line into 'buf' like fgets, or returns NULL at the end */
+__LIBC_HIDDEN__
+extern char* _hosts_gets(struct hosts_cursor* cursor, char* buf, size_t len);
+
+/* releases the cursor's reference to the index, or closes the file opened
+ * by _hosts_open if the file couldn't be indexed */
+__LIBC_HIDDEN__
+extern void _hosts_close(struct hosts_cursor* cursor);
+
+#endif /* _HOSTS_CACHE_H_ */
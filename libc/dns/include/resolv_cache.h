@@ -43,7 +43,11 @@ typedef enum {
     RESOLV_CACHE_UNSUPPORTED,  /* the cache can't handle that kind of queries */
                                /* or the answer buffer is too small */
     RESOLV_CACHE_NOTFOUND,     /* the cache doesn't know about this query */
-    RESOLV_CACHE_FOUND         /* the cache found the answer */
+    RESOLV_CACHE_FOUND,        /* the cache found the answer */
+    RESOLV_CACHE_REFRESH       /* the cache found the answer, but it is about to */
+                               /* expire: the caller should send the query again */
+                               /* and pass the result to _resolv_cache_add() or */
+                               /* _resolv_cache_query_failed() */
 } ResolvCacheStatus;
 
 __LIBC_HIDDEN__
@@ -56,7 +60,7 @@ _resolv_cache_lookup( unsigned              netid,
                       int                  *answerlen );
 
 /* add a (query,answer) to the cache, only call if _resolv_cache_lookup
- * did return RESOLV_CACHE_NOTFOUND
+ * did return RESOLV_CACHE_NOTFOUND or RESOLV_CACHE_REFRESH
  */
 __LIBC_HIDDEN__
 extern void
@@ -33,6 +33,9 @@
 					 * Set to -1 to disable skipping failing
 					 * servers.
 					 */
+#define CACHE_MAX_BYTES		(1024 * 1024)	/* memory budget of each network's
+					 * DNS cache
+					 */
 
 /* per-netid configuration parameters passed from netd to the resolver */
 struct __res_params {
@@ -41,6 +44,7 @@ struct __res_params {
     uint8_t success_threshold; // 0: disable, value / 100 otherwise
     uint8_t min_samples; // min # samples needed for statistics to be considered meaningful
     uint8_t max_samples; // max # samples taken into account for statistics
+    uint32_t cache_max_bytes; // memory budget of the DNS cache, 0: CACHE_MAX_BYTES
 };
 
 #endif // _RESOLV_PARAMS_H
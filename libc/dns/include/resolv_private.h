@@ -240,7 +240,7 @@ union res_sockaddr_union {
 #define	RES_F_VC	0x00000001	/* socket is TCP */
 #define	RES_F_CONN	0x00000002	/* socket is connected */
 #define	RES_F_EDNS0ERR	0x00000004	/* EDNS0 caused errors */
-#define	RES_F__UNUSED	0x00000008	/* (unused) */
+#define	RES_F_REFRESH	0x00000008	/* res_nsend refreshes a cache entry */
 #define	RES_F_LASTMASK	0x000000F0	/* ordinal server of last res_nsend */
 #define	RES_F_LASTSHIFT	4		/* bit position of LASTMASK "flag" */
 #define	RES_GETLAST(res) (((res)._flags & RES_F_LASTMASK) >> RES_F_LASTSHIFT)
@@ -474,6 +474,20 @@ int		res_nameinquery(const char *, int, int, const u_char *,
 int		res_queriesmatch(const u_char *, const u_char *,
 				      const u_char *, const u_char *);
 __LIBC_HIDDEN__ const char *	p_section(int, int);
+/*
+ * One of several queries sent together by res_nsendN().  The caller fills in
+ * the query and the answer buffer, and res_nsendN() sets resplen to the
+ * length of the answer, or -1 if there wasn't one.
+ */
+struct res_sendq {
+	const u_char	*buf;
+	int		buflen;
+	u_char		*ans;
+	int		anssiz;
+	int		resplen;
+};
+#define	RES_MAXSENDQ	2	/* queries res_nsendN() sends at once */
+
 /* Things involving a resolver context. */
 int		res_ninit(res_state);
 int		res_nisourserver(const res_state, const struct sockaddr_in *);
@@ -488,6 +502,7 @@ int		res_nmkquery(res_state, int, const char *, int, int,
 				  const u_char *, int, const u_char *,
 				  u_char *, int);
 int		res_nsend(res_state, const u_char *, int, u_char *, int);
+__LIBC_HIDDEN__ int		res_nsendN(res_state, struct res_sendq *, int);
 int		res_nsendsigned(res_state, const u_char *, int,
 				     ns_tsig_key *, u_char *, int);
 int		res_findzonecut(res_state, const char *, ns_class, int,
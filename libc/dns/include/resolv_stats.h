@@ -46,6 +46,16 @@ struct __res_stats {
     uint8_t			sample_next;
 };
 
+/* Effectiveness and memory use of a network's DNS cache. */
+struct __res_cache_stats {
+    uint64_t			hits;       // lookups answered from the cache
+    uint64_t			misses;     // cacheable lookups the cache couldn't answer
+    uint64_t			evictions;  // unexpired entries removed to make room
+    uint32_t			entries;    // # entries stored
+    uint32_t			bytes;      // memory used by the stored entries
+    uint32_t			max_bytes;  // memory budget
+};
+
 /* Calculate the round-trip-time from start time t0 and end time t1. */
 extern int
 _res_stats_calculate_rtt(const struct timespec* t1, const struct timespec* t0);
@@ -79,6 +89,11 @@ extern void
 android_net_res_stats_get_usable_servers(const struct __res_params* params,
         struct __res_stats stats[], int nscount, bool valid_servers[])
     __attribute__((visibility ("default")));
+
+/* Returns 0 and fills in the cache statistics of the given network, or -1 if it has no cache. */
+extern int
+android_net_res_stats_get_cache_stats_for_net(unsigned netid, struct __res_cache_stats* stats)
+    __attribute__((visibility ("default")));
 __END_DECLS
 
 #endif  // _RES_STATS_H
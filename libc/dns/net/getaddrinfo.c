@@ -85,6 +85,8 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <arpa/nameser.h>
@@ -92,7 +94,10 @@
 #include <ctype.h>
 #include <errno.h>
 #include <netdb.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
 #include "NetdClientDispatch.h"
+#include "hosts_cache.h"
 #include "resolv_cache.h"
 #include "resolv_netid.h"
 #include "resolv_private.h"
@@ -200,6 +205,9 @@ static const ns_src default_dns_files[] = {
 
 #define MAXPACKET	(64*1024)
 
+/* A query: the header, the question, and room for an EDNS0 OPT record. */
+#define QUERYSIZE	(HFIXEDSZ + MAXCDNAME + 1 + QFIXEDSZ + 1 + RRFIXEDSZ)
+
 typedef union {
 	HEADER hdr;
 	u_char buf[MAXPACKET];
@@ -237,13 +245,16 @@ static int ip6_str2scopeid(char *, struct sockaddr_in6 *, u_int32_t *);
 static struct addrinfo *getanswer(const querybuf *, int, const char *, int,
 	const struct addrinfo *);
 static int _dns_getaddrinfo(void *, void *, va_list);
-static void _sethtent(FILE **);
-static void _endhtent(FILE **);
-static struct addrinfo *_gethtent(FILE **, const char *,
+static struct addrinfo *_gethtent(struct hosts_cursor *, const char *,
     const struct addrinfo *);
 static int _files_getaddrinfo(void *, void *, va_list);
 static int _find_src_addr(const struct sockaddr *, struct sockaddr *, unsigned , uid_t);
+static void _src_addr_cache_validate(void);
+static int _find_src_addr_cached(const struct sockaddr *, struct sockaddr *, unsigned , uid_t);
 
+static int getaddrinfo_netcontext(const char *, const char *,
+    const struct addrinfo *, const struct android_net_context *,
+    struct addrinfo **, FILE **);
 static int res_queryN(const char *, struct res_target *, res_state);
 static int res_searchN(const char *, struct res_target *, res_state);
 static int res_querydomainN(const char *, const char *,
@@ -375,7 +386,7 @@ _have_ipv6(unsigned mark, uid_t uid) {
 			0x20, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 		};
 	sockaddr_union addr = { .in6 = sin6_test };
-	return _find_src_addr(&addr.generic, NULL, mark, uid) == 1;
+	return _find_src_addr_cached(&addr.generic, NULL, mark, uid) == 1;
 }
 
 static int
@@ -385,7 +396,7 @@ _have_ipv4(unsigned mark, uid_t uid) {
 		.sin_addr.s_addr = __constant_htonl(0x08080808L)  // 8.8.8.8
 	};
 	sockaddr_union addr = { .in = sin_test };
-	return _find_src_addr(&addr.generic, NULL, mark, uid) == 1;
+	return _find_src_addr_cached(&addr.generic, NULL, mark, uid) == 1;
 }
 
 bool readBE32(FILE* fp, int32_t* result) {
@@ -398,19 +409,13 @@ bool readBE32(FILE* fp, int32_t* result) {
 }
 
 #if defined(__ANDROID__)
-// Returns 0 on success, else returns on error.
+// Sends a getaddrinfo request to the proxy. Returns 0 and the connection to read the
+// answer from in *proxyp, EAI_SYSTEM if there's no proxy, else another error.
 static int
-android_getaddrinfo_proxy(
+android_getaddrinfo_proxy_send(
     const char *hostname, const char *servname,
-    const struct addrinfo *hints, struct addrinfo **res, unsigned netid)
+    const struct addrinfo *hints, unsigned netid, FILE **proxyp)
 {
-	int success = 0;
-
-	// Clear this at start, as we use its non-NULLness later (in the
-	// error path) to decide if we have to free up any memory we
-	// allocated in the process (before failing).
-	*res = NULL;
-
 	// Bogus things we can't serialize.  Don't use the proxy.  These will fail - let them.
 	if ((hostname != NULL &&
 	     strcspn(hostname, " \n\r\t^'\"") != strlen(hostname)) ||
@@ -435,14 +440,32 @@ android_getaddrinfo_proxy(
 		    hints == NULL ? -1 : hints->ai_socktype,
 		    hints == NULL ? -1 : hints->ai_protocol,
 		    netid) < 0) {
-		goto exit;
+		fclose(proxy);
+		return EAI_NODATA;
 	}
 	// literal NULL byte at end, required by FrameworkListener
 	if (fputc(0, proxy) == EOF ||
 	    fflush(proxy) != 0) {
-		goto exit;
+		fclose(proxy);
+		return EAI_NODATA;
 	}
 
+	*proxyp = proxy;
+	return 0;
+}
+
+// Reads the proxy's answer to a getaddrinfo request, and closes the connection.
+// Returns 0 on success, else returns on error.
+static int
+android_getaddrinfo_proxy_recv(FILE *proxy, struct addrinfo **res)
+{
+	int success = 0;
+
+	// Clear this at start, as we use its non-NULLness later (in the
+	// error path) to decide if we have to free up any memory we
+	// allocated in the process (before failing).
+	*res = NULL;
+
 	char buf[4];
 	// read result code for gethostbyaddr
 	if (fread(buf, 1, sizeof(buf), proxy) != sizeof(buf)) {
@@ -538,9 +561,7 @@ android_getaddrinfo_proxy(
 		freeaddrinfo(ai);
 	}
 exit:
-	if (proxy != NULL) {
-		fclose(proxy);
-	}
+	fclose(proxy);
 
 	if (success) {
 		return 0;
@@ -554,6 +575,23 @@ exit:
 	}
 	return EAI_NODATA;
 }
+
+// Returns 0 on success, else returns on error.
+static int
+android_getaddrinfo_proxy(
+    const char *hostname, const char *servname,
+    const struct addrinfo *hints, struct addrinfo **res, unsigned netid)
+{
+	FILE* proxy;
+	int error;
+
+	*res = NULL;
+	error = android_getaddrinfo_proxy_send(hostname, servname, hints, netid, &proxy);
+	if (error != 0) {
+		return error;
+	}
+	return android_getaddrinfo_proxy_recv(proxy, res);
+}
 #endif
 
 int
@@ -581,6 +619,18 @@ int
 android_getaddrinfofornetcontext(const char *hostname, const char *servname,
     const struct addrinfo *hints, const struct android_net_context *netcontext,
     struct addrinfo **res)
+{
+	return getaddrinfo_netcontext(hostname, servname, hints, netcontext, res, NULL);
+}
+
+/*
+ * If proxyp isn't NULL and the name has to be looked up by the proxy, returns 0
+ * after sending the request, with the connection to read the answer from in *proxyp.
+ */
+static int
+getaddrinfo_netcontext(const char *hostname, const char *servname,
+    const struct addrinfo *hints, const struct android_net_context *netcontext,
+    struct addrinfo **res, FILE **proxyp)
 {
 	struct addrinfo sentinel;
 	struct addrinfo *cur;
@@ -725,8 +775,15 @@ android_getaddrinfofornetcontext(const char *hostname, const char *servname,
 		ERR(EAI_NONAME);
 
 #if defined(__ANDROID__)
-	int gai_error = android_getaddrinfo_proxy(
-		hostname, servname, hints, res, netcontext->app_netid);
+	int gai_error;
+	if (proxyp != NULL) {
+		*res = NULL;
+		gai_error = android_getaddrinfo_proxy_send(
+			hostname, servname, hints, netcontext->app_netid, proxyp);
+	} else {
+		gai_error = android_getaddrinfo_proxy(
+			hostname, servname, hints, res, netcontext->app_netid);
+	}
 	if (gai_error != EAI_SYSTEM) {
 		return gai_error;
 	}
@@ -787,6 +844,123 @@ android_getaddrinfofornetcontext(const char *hostname, const char *servname,
 	return error;
 }
 
+/*
+ * Asynchronous lookups.  Names that the proxy has to look up are sent to it, and
+ * the caller polls the proxy connection for the answer.  Everything else (numeric
+ * addresses, errors, and processes that look names up themselves) is answered
+ * before android_getaddrinfo_start() returns, through an eventfd that is already
+ * readable, with the result waiting in gai_async_done until it's collected.
+ */
+struct gai_async_result {
+	int fd;
+	int error;
+	struct addrinfo *res;
+	struct gai_async_result *next;
+};
+
+static struct gai_async_result *gai_async_done;
+static pthread_mutex_t gai_async_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Removes and returns the result waiting behind fd, if any. */
+static struct gai_async_result *
+gai_async_take(int fd)
+{
+	struct gai_async_result **p, *r;
+
+	pthread_mutex_lock(&gai_async_lock);
+	for (p = &gai_async_done; (r = *p) != NULL; p = &r->next) {
+		if (r->fd == fd) {
+			*p = r->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&gai_async_lock);
+	return r;
+}
+
+int
+android_getaddrinfo_start(const char *hostname, const char *servname,
+    const struct addrinfo *hints)
+{
+	struct android_net_context netcontext = {
+		.app_netid = NETID_UNSET,
+		.app_mark = MARK_UNSET,
+		.dns_netid = NETID_UNSET,
+		.dns_mark = MARK_UNSET,
+		.uid = NET_CONTEXT_INVALID_UID,
+	};
+	struct gai_async_result *r;
+	FILE *proxy = NULL;
+	int fd;
+
+	r = malloc(sizeof(*r));
+	if (r == NULL)
+		return -1;
+	r->res = NULL;
+	r->error = getaddrinfo_netcontext(hostname, servname, hints, &netcontext,
+	    &r->res, &proxy);
+	if (proxy != NULL) {
+		/* the FILE can't be handed out, so give the caller its own descriptor */
+		free(r);
+		fd = fcntl(fileno(proxy), F_DUPFD_CLOEXEC, 0);
+		fclose(proxy);
+		return fd;
+	}
+
+	r->fd = eventfd(1, EFD_CLOEXEC);
+	if (r->fd == -1) {
+		freeaddrinfo(r->res);
+		free(r);
+		return -1;
+	}
+	fd = r->fd;
+	pthread_mutex_lock(&gai_async_lock);
+	r->next = gai_async_done;
+	gai_async_done = r;
+	pthread_mutex_unlock(&gai_async_lock);
+	return fd;
+}
+
+int
+android_getaddrinfo_result(int fd, struct addrinfo **res)
+{
+	struct gai_async_result *r;
+	FILE *proxy;
+	int error;
+
+	assert(res != NULL);
+	*res = NULL;
+	r = gai_async_take(fd);
+	if (r != NULL) {
+		close(fd);
+		*res = r->res;
+		error = r->error;
+		free(r);
+		return error;
+	}
+
+#if defined(__ANDROID__)
+	proxy = fdopen(fd, "r");
+	if (proxy != NULL)
+		return android_getaddrinfo_proxy_recv(proxy, res);
+#endif
+	close(fd);
+	return EAI_SYSTEM;
+}
+
+void
+android_getaddrinfo_cancel(int fd)
+{
+	struct gai_async_result *r;
+
+	r = gai_async_take(fd);
+	if (r != NULL) {
+		freeaddrinfo(r->res);
+		free(r);
+	}
+	close(fd);
+}
+
 /*
  * FQDN hostname, DNS lookup
  */
@@ -1830,6 +2004,176 @@ _find_src_addr(const struct sockaddr *addr, struct sockaddr *src_addr, unsigned
 	return 1;
 }
 
+/*
+ * A cache of _find_src_addr results, so that sorting the results of a lookup
+ * usually needs no connect()s. Results are kept per destination /32 or /64
+ * and per mark and uid, since those are what routing depends on, and are all
+ * dropped whenever src_addr_monitor reports an address, route or rule change.
+ * Without the netlink socket nothing is cached.
+ */
+#define SRC_ADDR_CACHE_SIZE 32
+
+struct src_addr_cache_entry {
+	sa_family_t family;	/* AF_UNSPEC if unused */
+	uint8_t prefix[8];	/* the destination's /32 or /64 */
+	uint32_t scope_id;
+	unsigned mark;
+	uid_t uid;
+	int result;		/* _find_src_addr's 0 or 1 */
+	sockaddr_union src_addr;
+};
+
+static pthread_mutex_t src_addr_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct src_addr_cache_entry src_addr_cache[SRC_ADDR_CACHE_SIZE];
+static int src_addr_cache_next;		/* the next entry to replace */
+static int src_addr_monitor = -1;	/* -2 if it can't be opened */
+static pid_t src_addr_monitor_pid;
+
+static int
+_src_addr_monitor_open(void)
+{
+	struct sockaddr_nl nl;
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd == -1)
+		return -2;
+	memset(&nl, 0, sizeof(nl));
+	nl.nl_family = AF_NETLINK;
+	nl.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR |
+	    RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE |
+	    RTMGRP_IPV4_RULE | (1 << (RTNLGRP_IPV6_RULE - 1));
+	if (bind(fd, (struct sockaddr *)(void *)&nl, sizeof(nl)) == -1) {
+		close(fd);
+		return -2;
+	}
+	return fd;
+}
+
+/*
+ * Drops the cached results if routing may have changed since they were found.
+ * Called once before a batch of _find_src_addr_cached calls.
+ */
+static void
+_src_addr_cache_validate(void)
+{
+	char buf[4096];
+	ssize_t n;
+	int changed = 0;
+	pid_t pid = getpid();
+
+	pthread_mutex_lock(&src_addr_cache_lock);
+	if (src_addr_monitor_pid != pid) {
+		/* after a fork the parent would be reading the same socket */
+		if (src_addr_monitor >= 0)
+			close(src_addr_monitor);
+		src_addr_monitor = _src_addr_monitor_open();
+		src_addr_monitor_pid = pid;
+		changed = 1;
+	} else if (src_addr_monitor >= 0) {
+		for (;;) {
+			n = recv(src_addr_monitor, buf, sizeof(buf), MSG_DONTWAIT);
+			if (n > 0 || (n == -1 && (errno == EINTR || errno == ENOBUFS))) {
+				/* ENOBUFS means we missed some */
+				changed = 1;
+				continue;
+			}
+			break;
+		}
+	}
+	if (changed)
+		memset(src_addr_cache, 0, sizeof(src_addr_cache));
+	pthread_mutex_unlock(&src_addr_cache_lock);
+}
+
+static int
+_src_addr_cache_key(const struct sockaddr *addr, struct src_addr_cache_entry *key,
+    unsigned mark, uid_t uid)
+{
+	memset(key, 0, sizeof(*key));
+	switch (addr->sa_family) {
+	case AF_INET:
+		memcpy(key->prefix, &((const struct sockaddr_in *)(const void *)addr)->sin_addr, 4);
+		break;
+	case AF_INET6:
+		memcpy(key->prefix, &((const struct sockaddr_in6 *)(const void *)addr)->sin6_addr, 8);
+		key->scope_id = ((const struct sockaddr_in6 *)(const void *)addr)->sin6_scope_id;
+		break;
+	default:
+		return 0;
+	}
+	key->family = addr->sa_family;
+	key->mark = mark;
+	key->uid = uid;
+	return 1;
+}
+
+static int
+_src_addr_cache_match(const struct src_addr_cache_entry *e, const struct src_addr_cache_entry *key)
+{
+	return e->family == key->family && e->scope_id == key->scope_id &&
+	    e->mark == key->mark && e->uid == key->uid &&
+	    memcmp(e->prefix, key->prefix, sizeof(key->prefix)) == 0;
+}
+
+/*
+ * _find_src_addr, answered from the cache where possible.
+ */
+static int
+_find_src_addr_cached(const struct sockaddr *addr, struct sockaddr *src_addr, unsigned mark, uid_t uid)
+{
+	struct src_addr_cache_entry key;
+	sockaddr_union found;
+	int i, ret, caching;
+
+	if (!_src_addr_cache_key(addr, &key, mark, uid))
+		return _find_src_addr(addr, src_addr, mark, uid);
+
+	pthread_mutex_lock(&src_addr_cache_lock);
+	caching = src_addr_monitor >= 0;
+	if (caching) {
+		for (i = 0; i < SRC_ADDR_CACHE_SIZE; i++) {
+			const struct src_addr_cache_entry *e = &src_addr_cache[i];
+			if (_src_addr_cache_match(e, &key)) {
+				ret = e->result;
+				if (src_addr && ret == 1)
+					memcpy(src_addr, &e->src_addr, sizeof(e->src_addr));
+				pthread_mutex_unlock(&src_addr_cache_lock);
+				return ret;
+			}
+		}
+	}
+	pthread_mutex_unlock(&src_addr_cache_lock);
+
+	if (!caching)
+		return _find_src_addr(addr, src_addr, mark, uid);
+
+	/* always get the source address, so the entry can answer any caller */
+	memset(&found, 0, sizeof(found));
+	ret = _find_src_addr(addr, &found.generic, mark, uid);
+	if (ret == -1)
+		return ret;
+	if (src_addr && ret == 1)
+		memcpy(src_addr, &found, sizeof(found));
+
+	pthread_mutex_lock(&src_addr_cache_lock);
+	if (src_addr_monitor >= 0) {
+		for (i = 0; i < SRC_ADDR_CACHE_SIZE; i++) {
+			if (_src_addr_cache_match(&src_addr_cache[i], &key))
+				break;
+		}
+		if (i == SRC_ADDR_CACHE_SIZE) {
+			i = src_addr_cache_next;
+			src_addr_cache_next = (i + 1) % SRC_ADDR_CACHE_SIZE;
+		}
+		key.result = ret;
+		key.src_addr = found;
+		src_addr_cache[i] = key;
+	}
+	pthread_mutex_unlock(&src_addr_cache_lock);
+	return ret;
+}
+
 /*
  * Sort the linked list starting at sentinel->ai_next in RFC6724 order.
  * Will leave the list unchanged if an error occurs.
@@ -1858,13 +2202,14 @@ _rfc6724_sort(struct addrinfo *list_sentinel, unsigned mark, uid_t uid)
 	 * Convert the linked list to an array that also contains the candidate
 	 * source address for each destination address.
 	 */
+	_src_addr_cache_validate();
 	for (i = 0, cur = list_sentinel->ai_next; i < nelem; ++i, cur = cur->ai_next) {
 		int has_src_addr;
 		assert(cur != NULL);
 		elems[i].ai = cur;
 		elems[i].original_order = i;
 
-		has_src_addr = _find_src_addr(cur->ai_addr, &elems[i].src_addr.generic, mark, uid);
+		has_src_addr = _find_src_addr_cached(cur->ai_addr, &elems[i].src_addr.generic, mark, uid);
 		if (has_src_addr == -1) {
 			goto error;
 		}
@@ -1928,6 +2273,7 @@ _dns_getaddrinfo(void *rv, void	*cb_data, va_list ap)
 		q.anslen = sizeof(buf->buf);
 		int query_ipv6 = 1, query_ipv4 = 1;
 		if (pai->ai_flags & AI_ADDRCONFIG) {
+			_src_addr_cache_validate();
 			query_ipv6 = _have_ipv6(netcontext->app_mark, netcontext->uid);
 			query_ipv4 = _have_ipv4(netcontext->app_mark, netcontext->uid);
 		}
@@ -2022,28 +2368,8 @@ _dns_getaddrinfo(void *rv, void	*cb_data, va_list ap)
 	return NS_SUCCESS;
 }
 
-static void
-_sethtent(FILE **hostf)
-{
-
-	if (!*hostf)
-		*hostf = fopen(_PATH_HOSTS, "re");
-	else
-		rewind(*hostf);
-}
-
-static void
-_endhtent(FILE **hostf)
-{
-
-	if (*hostf) {
-		(void) fclose(*hostf);
-		*hostf = NULL;
-	}
-}
-
 static struct addrinfo *
-_gethtent(FILE **hostf, const char *name, const struct addrinfo *pai)
+_gethtent(struct hosts_cursor *hostc, const char *name, const struct addrinfo *pai)
 {
 	char *p;
 	char *cp, *tname, *cname;
@@ -2056,10 +2382,8 @@ _gethtent(FILE **hostf, const char *name, const struct addrinfo *pai)
 	assert(name != NULL);
 	assert(pai != NULL);
 
-	if (!*hostf && !(*hostf = fopen(_PATH_HOSTS, "re")))
-		return (NULL);
  again:
-	if (!(p = fgets(hostbuf, sizeof hostbuf, *hostf)))
+	if (!(p = _hosts_gets(hostc, hostbuf, sizeof hostbuf)))
 		return (NULL);
 	if (*p == '#')
 		goto again;
@@ -2116,7 +2440,7 @@ _files_getaddrinfo(void *rv, void *cb_data, va_list ap)
 	const struct addrinfo *pai;
 	struct addrinfo sentinel, *cur;
 	struct addrinfo *p;
-	FILE *hostf = NULL;
+	struct hosts_cursor hostc;
 
 	name = va_arg(ap, char *);
 	pai = va_arg(ap, struct addrinfo *);
@@ -2125,13 +2449,14 @@ _files_getaddrinfo(void *rv, void *cb_data, va_list ap)
 	memset(&sentinel, 0, sizeof(sentinel));
 	cur = &sentinel;
 
-	_sethtent(&hostf);
-	while ((p = _gethtent(&hostf, name, pai)) != NULL) {
+	if (_hosts_open(&hostc, name) == -1)
+		return NS_NOTFOUND;
+	while ((p = _gethtent(&hostc, name, pai)) != NULL) {
 		cur->ai_next = p;
 		while (cur && cur->ai_next)
 			cur = cur->ai_next;
 	}
-	_endhtent(&hostf);
+	_hosts_close(&hostc);
 
 	*((struct addrinfo **)rv) = sentinel.ai_next;
 	if (sentinel.ai_next == NULL)
@@ -2155,9 +2480,11 @@ static int
 res_queryN(const char *name, /* domain name */ struct res_target *target,
     res_state res)
 {
-	u_char buf[MAXPACKET];
+	u_char buf[RES_MAXSENDQ][QUERYSIZE];
+	struct res_sendq sendq[RES_MAXSENDQ];
+	struct res_target *batch[RES_MAXSENDQ];
 	HEADER *hp;
-	int n;
+	int n, i, nq;
 	struct res_target *t;
 	int rcode;
 	int ancount;
@@ -2168,63 +2495,67 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 	rcode = NOERROR;
 	ancount = 0;
 
-	for (t = target; t; t = t->next) {
-		int class, type;
-		u_char *answer;
-		int anslen;
+	/*
+	 * Send the queries in batches, so that the A and AAAA queries for a
+	 * name go out together.
+	 */
+	for (t = target; t; ) {
+		for (nq = 0; t && nq < RES_MAXSENDQ; t = t->next, nq++) {
+			int class, type;
 
-		hp = (HEADER *)(void *)t->answer;
-		hp->rcode = NOERROR;	/* default */
+			hp = (HEADER *)(void *)t->answer;
+			hp->rcode = NOERROR;	/* default */
 
-		/* make it easier... */
-		class = t->qclass;
-		type = t->qtype;
-		answer = t->answer;
-		anslen = t->anslen;
+			/* make it easier... */
+			class = t->qclass;
+			type = t->qtype;
 #ifdef DEBUG
-		if (res->options & RES_DEBUG)
-			printf(";; res_nquery(%s, %d, %d)\n", name, class, type);
+			if (res->options & RES_DEBUG)
+				printf(";; res_nquery(%s, %d, %d)\n", name, class, type);
 #endif
 
-		n = res_nmkquery(res, QUERY, name, class, type, NULL, 0, NULL,
-		    buf, sizeof(buf));
+			n = res_nmkquery(res, QUERY, name, class, type, NULL, 0,
+			    NULL, buf[nq], sizeof(buf[nq]));
 #ifdef RES_USE_EDNS0
-		if (n > 0 && (res->options & RES_USE_EDNS0) != 0)
-			n = res_nopt(res, n, buf, sizeof(buf), anslen);
-#endif
-		if (n <= 0) {
-#ifdef DEBUG
-			if (res->options & RES_DEBUG)
-				printf(";; res_nquery: mkquery failed\n");
+			if (n > 0 && (res->options & RES_USE_EDNS0) != 0)
+				n = res_nopt(res, n, buf[nq], sizeof(buf[nq]),
+				    t->anslen);
 #endif
-			h_errno = NO_RECOVERY;
-			return n;
-		}
-		n = res_nsend(res, buf, n, answer, anslen);
-#if 0
-		if (n < 0) {
+			if (n <= 0) {
 #ifdef DEBUG
-			if (res->options & RES_DEBUG)
-				printf(";; res_query: send error\n");
+				if (res->options & RES_DEBUG)
+					printf(";; res_nquery: mkquery failed\n");
 #endif
-			h_errno = TRY_AGAIN;
-			return n;
+				h_errno = NO_RECOVERY;
+				return n;
+			}
+			batch[nq] = t;
+			sendq[nq].buf = buf[nq];
+			sendq[nq].buflen = n;
+			sendq[nq].ans = t->answer;
+			sendq[nq].anssiz = t->anslen;
 		}
-#endif
 
-		if (n < 0 || hp->rcode != NOERROR || ntohs(hp->ancount) == 0) {
-			rcode = hp->rcode;	/* record most recent error */
+		(void)res_nsendN(res, sendq, nq);
+
+		for (i = 0; i < nq; i++) {
+			n = sendq[i].resplen;
+			hp = (HEADER *)(void *)batch[i]->answer;
+			if (n < 0 || hp->rcode != NOERROR ||
+			    ntohs(hp->ancount) == 0) {
+				rcode = hp->rcode;	/* record most recent error */
 #ifdef DEBUG
-			if (res->options & RES_DEBUG)
-				printf(";; rcode = %u, ancount=%u\n", hp->rcode,
-				    ntohs(hp->ancount));
+				if (res->options & RES_DEBUG)
+					printf(";; rcode = %u, ancount=%u\n",
+					    hp->rcode, ntohs(hp->ancount));
 #endif
-			continue;
-		}
+				continue;
+			}
 
-		ancount += ntohs(hp->ancount);
+			ancount += ntohs(hp->ancount);
 
-		t->n = n;
+			batch[i]->n = n;
+		}
 	}
 
 	if (ancount == 0) {
@@ -61,6 +61,7 @@
 #include <arpa/inet.h>
 #include <arpa/nameser.h>
 #include "NetdClientDispatch.h"
+#include "hosts_cache.h"
 #include "resolv_netid.h"
 #include "resolv_private.h"
 #include "resolv_cache.h"
@@ -957,6 +958,21 @@ android_gethostbyaddrfornet_proxy_internal(const void* addr, socklen_t len, int
 
 struct hostent*
 netbsd_gethostent_r(FILE *hf, struct hostent *hent, char *buf, size_t buflen, int *he)
+{
+	struct hosts_cursor hostc;
+
+	if (hf == NULL) {
+		*he = NETDB_INTERNAL;
+		errno = EINVAL;
+		return NULL;
+	}
+	_hosts_open_file(&hostc, hf);
+	return _hf_gethostent_r(&hostc, hent, buf, buflen, he);
+}
+
+struct hostent*
+_hf_gethostent_r(struct hosts_cursor *hostc, struct hostent *hent, char *buf, size_t buflen,
+    int *he)
 {
 	char *p, *name;
 	char *cp, **q;
@@ -966,11 +982,6 @@ netbsd_gethostent_r(FILE *hf, struct hostent *hent, char *buf, size_t buflen, in
 	size_t maxaliases;
 	struct in6_addr host_addr;
 
-	if (hf == NULL) {
-		*he = NETDB_INTERNAL;
-		errno = EINVAL;
-		return NULL;
-	}
 	p = NULL;
 	setup(aliases, maxaliases);
 
@@ -984,7 +995,7 @@ netbsd_gethostent_r(FILE *hf, struct hostent *hent, char *buf, size_t buflen, in
 	  goto nospc;
 	}
 	for (;;) {
-		if (!fgets(p, line_buf_size, hf)) {
+		if (!_hosts_gets(hostc, p, line_buf_size)) {
 			free(p);
 			free(aliases);
 			*he = HOST_NOT_FOUND;
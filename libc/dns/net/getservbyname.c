@@ -32,12 +32,23 @@
 
 struct servent* getservbyname(const char* name, const char* proto) {
   res_static rs = __res_get_static();
-  rs->servent_ptr = NULL;
-  struct servent* s;
-  while ((s = getservent_r(rs)) != NULL) {
-    if (strcmp(s->s_name, name) == 0 && (proto == NULL || strcmp(s->s_proto, proto) == 0)) {
-      return s;
-    }
+  const char* entry = _servent_by_name(name, proto);
+  if (entry == NULL) {
+    return NULL;
   }
-  return NULL;
+  return _servent_static(rs, entry);
+}
+
+int getservbyname_r(const char* name, const char* proto, struct servent* se, char* buf,
+                    size_t buflen, struct servent** result) {
+  *result = NULL;
+  const char* entry = _servent_by_name(name, proto);
+  if (entry == NULL) {
+    return ENOENT;
+  }
+  int error = _servent_decode_r(entry, se, buf, buflen);
+  if (error == 0) {
+    *result = se;
+  }
+  return error;
 }
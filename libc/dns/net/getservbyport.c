@@ -33,20 +33,36 @@ struct servent *
 getservbyport(int port, const char *proto)
 {
     res_static       rs = __res_get_static();
+    const char*      entry;
 
     if (rs == NULL || proto == NULL) {
         errno = EINVAL;
         return NULL;
     }
 
-    rs->servent_ptr = NULL;
-    while (1) {
-        struct servent*  s = getservent_r(rs);
-        if (s == NULL)
-            break;
-        if ( s->s_port == port && !strcmp( s->s_proto, proto ) )
-            return s;
-    }
+    entry = _servent_by_port(port, proto);
+    if (entry == NULL)
+        return NULL;
+    return _servent_static(rs, entry);
+}
+
+int
+getservbyport_r(int port, const char *proto, struct servent *se, char *buf, size_t buflen,
+    struct servent **result)
+{
+    const char*      entry;
+    int              error;
+
+    *result = NULL;
+    if (proto == NULL)
+        return EINVAL;
+
+    entry = _servent_by_port(port, proto);
+    if (entry == NULL)
+        return ENOENT;
 
-    return NULL;
+    error = _servent_decode_r(entry, se, buf, buflen);
+    if (error == 0)
+        *result = se;
+    return error;
 }
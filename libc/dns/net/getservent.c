@@ -29,6 +29,7 @@
 #include <sys/types.h>
 #include <endian.h>
 #include <malloc.h>
+#include <stdint.h>
 #include <netdb.h>
 #include "servent.h"
 #include "services.h"
@@ -48,77 +49,203 @@ endservent(void)
     /* nothing to do */
 }
 
-struct servent *
-getservent_r( res_static  rs )
+/* Each _services entry is a length-prefixed name, a big-endian port, 't' or
+ * 'u' for the protocol, then an alias count and length-prefixed aliases. */
+
+#define  SERVICES_COUNT  (sizeof(_services_by_name) / sizeof(_services_by_name[0]))
+
+static int
+servent_name_cmp( const char*  name, const char*  p )
 {
-    const char*  p;
-    const char*  q;
-    int          namelen;
-    int          nn,count;
-    int          total = 0;
-    int          port;
-    char*        p2;
+    size_t  len = (unsigned char)p[0];
+    int     ret = strncmp( name, p+1, len );
 
-    p = rs->servent_ptr;
-    if (p == NULL)
-        p = _services;
-    else if (p[0] == 0)
-        return NULL;
+    if (ret != 0)
+        return ret;
+    return name[len] != 0;
+}
+
+static int
+servent_port( const char*  p )
+{
+    p += 1 + (unsigned char)p[0];
+    return (((unsigned char*)p)[0] << 8) | ((unsigned char*)p)[1];
+}
+
+static const char*
+servent_proto( const char*  p )
+{
+    p += 1 + (unsigned char)p[0];
+    return p[2] == 't' ? "tcp" : "udp";
+}
+
+/* the buffer space decoding the entry at 'p' needs */
+static size_t
+servent_size( const char*  p )
+{
+    const char*  q;
+    size_t       total;
+    int          nn, count;
 
-    /* first compute the total size */
-    namelen = p[0];
-    total  += namelen + 1;
-    q       = p + 1 + namelen + 3;  /* skip name + port + proto */
-    count   = q[0];   /* get aliascount */
-    q      += 1;
+    total  = (unsigned char)p[0] + 1;
+    q      = p + 1 + (unsigned char)p[0] + 3;  /* skip name + port + proto */
+    count  = (unsigned char)q[0];   /* get aliascount */
+    q     += 1;
 
     total += (count+1)*sizeof(char*);
     for (nn = 0; nn < count; nn++) {
-        int  len2 = q[0];
+        int  len2 = (unsigned char)q[0];
         total += 1 + len2;
         q     += 1 + len2;
     }
+    return total;
+}
 
-    /* reallocate the thread-specific servent struct */
-    p2 = realloc( (char*)rs->servent.s_aliases, total );
-    if (p2 == NULL)
-        return NULL;
+/* the entry after the one at 'p' */
+static const char*
+servent_next( const char*  p )
+{
+    int  nn, count;
+
+    p    += 1 + (unsigned char)p[0] + 3;  /* skip name + port + proto */
+    count = (unsigned char)p[0];
+    p    += 1;
+    for (nn = 0; nn < count; nn++)
+        p += 1 + (unsigned char)p[0];
+    return p;
+}
 
-    /* now write to it */
-    rs->servent.s_aliases = (char**) p2;
-    p2                   += (count+1)*sizeof(char*);
-    rs->servent.s_name    = p2;
-    p2                   += namelen + 1;
-    rs->servent.s_proto   = p2;
+/* decodes the entry at 'p' into 'se' with its alias array at the start of
+ * 'buf', which must be pointer-aligned and servent_size(p) bytes */
+static void
+servent_decode( const char*  p, struct servent*  se, char*  buf )
+{
+    int    namelen = (unsigned char)p[0];
+    int    nn, count;
+
+    count  = (unsigned char)p[1 + namelen + 3];
+
+    se->s_aliases = (char**) buf;
+    buf          += (count+1)*sizeof(char*);
+    se->s_name    = buf;
+    buf          += namelen + 1;
 
     /* copy name + port + setup protocol */
-    memcpy( rs->servent.s_name, p+1, namelen );
-    rs->servent.s_name[namelen] = 0;
-    p += 1 + namelen;
+    memcpy( se->s_name, p+1, namelen );
+    se->s_name[namelen] = 0;
 
     /* s_port must be in network byte order */
-    port = ((((unsigned char*)p)[0] << 8) |
-             ((unsigned char*)p)[1]);
-
-    rs->servent.s_port  = htons(port);
-    rs->servent.s_proto = p[2] == 't' ? "tcp" : "udp";
-    p += 4;  /* skip port(2) + proto(1) + aliascount(1) */
+    se->s_port  = htons(servent_port(p));
+    se->s_proto = (char*) servent_proto(p);
+    p += 1 + namelen + 4;  /* skip name + port(2) + proto(1) + aliascount(1) */
 
     for (nn = 0; nn < count; nn++) {
-        int  len2 = p[0];
-        rs->servent.s_aliases[nn] = p2;
-        memcpy( p2, p+1, len2 );
-        p2[len2] = 0;
-        p2 += len2 + 1;
-        p  += len2 + 1;
+        int  len2 = (unsigned char)p[0];
+        se->s_aliases[nn] = buf;
+        memcpy( buf, p+1, len2 );
+        buf[len2] = 0;
+        buf += len2 + 1;
+        p   += len2 + 1;
     }
-    rs->servent.s_aliases[nn] = NULL;
+    se->s_aliases[nn] = NULL;
+}
 
-    rs->servent_ptr = p;
+struct servent*
+_servent_static( res_static  rs, const char*  entry )
+{
+    /* reallocate the thread-specific servent struct */
+    char*  p2 = realloc( (char*)rs->servent.s_aliases, servent_size(entry) );
+    if (p2 == NULL)
+        return NULL;
 
+    servent_decode( entry, &rs->servent, p2 );
     return &rs->servent;
 }
 
+int
+_servent_decode_r( const char*  entry, struct servent*  se, char*  buf, size_t  buflen )
+{
+    size_t  pad = (sizeof(char*) - ((uintptr_t)buf & (sizeof(char*) - 1))) & (sizeof(char*) - 1);
+
+    if (buflen < pad || buflen - pad < servent_size(entry))
+        return ERANGE;
+
+    servent_decode( entry, se, buf + pad );
+    return 0;
+}
+
+const char*
+_servent_by_name( const char*  name, const char*  proto )
+{
+    size_t  lo = 0, hi = SERVICES_COUNT;
+
+    while (lo < hi) {
+        size_t  mid = lo + (hi - lo) / 2;
+        if (servent_name_cmp( name, _services + _services_by_name[mid] ) > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* entries with the same name are in file order */
+    for ( ; lo < SERVICES_COUNT; lo++) {
+        const char*  p = _services + _services_by_name[lo];
+        if (servent_name_cmp( name, p ) != 0)
+            break;
+        if (proto == NULL || !strcmp( servent_proto(p), proto ))
+            return p;
+    }
+    return NULL;
+}
+
+const char*
+_servent_by_port( int  port, const char*  proto )
+{
+    size_t  lo = 0, hi = SERVICES_COUNT;
+
+    /* s_port is an htons() value, so nothing else can match */
+    if (port < 0 || port > 0xffff)
+        return NULL;
+    port = ntohs(port);
+
+    while (lo < hi) {
+        size_t  mid = lo + (hi - lo) / 2;
+        if (servent_port( _services + _services_by_port[mid] ) < port)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for ( ; lo < SERVICES_COUNT; lo++) {
+        const char*  p = _services + _services_by_port[lo];
+        if (servent_port(p) != port)
+            break;
+        if (proto == NULL || !strcmp( servent_proto(p), proto ))
+            return p;
+    }
+    return NULL;
+}
+
+struct servent *
+getservent_r( res_static  rs )
+{
+    const char*      p;
+    struct servent*  se;
+
+    p = rs->servent_ptr;
+    if (p == NULL)
+        p = _services;
+    else if (p[0] == 0)
+        return NULL;
+
+    se = _servent_static( rs, p );
+    if (se == NULL)
+        return NULL;
+
+    rs->servent_ptr = servent_next(p);
+    return se;
+}
+
 struct servent *
 getservent(void)
 {
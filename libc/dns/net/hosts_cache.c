@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "hosts_cache.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* The hosts file is read into memory once and every name on every line is
+ * put in a hash table, so that a lookup is a stat() and a few comparisons
+ * rather than an open() and a parse of the whole file. The snapshot is
+ * replaced when stat() shows the file changed, and is refcounted so that
+ * lookups still iterating over an old one aren't disturbed.
+ */
+
+/* one name on one line of the hosts file */
+struct hosts_name {
+    uint32_t  hash;
+    int32_t   name;  /* offset of the name in 'text' */
+    int32_t   len;
+    int32_t   line;  /* offset of the start of its line in 'text' */
+    int32_t   next;  /* next entry in the same bucket, in file order, or -1 */
+};
+
+struct hosts_snapshot {
+    int                 refs;  /* guarded by _hosts_lock */
+
+    /* identifies the version of the file this was read from */
+    dev_t               dev;
+    ino_t               ino;
+    off_t               size;
+    struct timespec     mtime;
+
+    char*               text;
+    int32_t             text_len;
+    struct hosts_name*  names;
+    int32_t             num_names;
+    int32_t*            buckets;
+    uint32_t            num_buckets;  /* a power of two */
+};
+
+static pthread_mutex_t         _hosts_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct hosts_snapshot*  _hosts_current;  /* holds a reference */
+
+/* FNV-1a, ignoring case like the lookups do */
+static uint32_t
+_hosts_hash(const char* name, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash ^= (uint32_t)tolower((unsigned char)name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int
+_hosts_is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/* finds the names on each line, the way _gethtent and netbsd_gethostent_r
+ * split lines, and records them in 'names' if it isn't NULL. Returns the
+ * number of names found. */
+static int32_t
+_hosts_scan(const char* text, int32_t text_len, struct hosts_name* names)
+{
+    int32_t count = 0;
+    int32_t line = 0;
+
+    while (line < text_len) {
+        const char* nl = memchr(text + line, '\n', (size_t)(text_len - line));
+        int32_t end = nl ? (int32_t)(nl - text) : text_len;
+        int32_t next_line = nl ? end + 1 : text_len;
+        const char* hash_mark;
+        int32_t p;
+
+        if (text[line] == '#') {
+            line = next_line;
+            continue;
+        }
+        hash_mark = memchr(text + line, '#', (size_t)(end - line));
+        if (hash_mark != NULL)
+            end = (int32_t)(hash_mark - text);
+
+        /* skip the address */
+        for (p = line; p < end && !_hosts_is_blank(text[p]); p++)
+            ;
+        while (p < end) {
+            int32_t name;
+            if (_hosts_is_blank(text[p])) {
+                p++;
+                continue;
+            }
+            for (name = p; p < end && !_hosts_is_blank(text[p]); p++)
+                ;
+            if (names != NULL) {
+                names[count].name = name;
+                names[count].len  = p - name;
+                names[count].line = line;
+                names[count].hash = _hosts_hash(text + name, (size_t)(p - name));
+                names[count].next = -1;
+            }
+            count++;
+        }
+        line = next_line;
+    }
+    return count;
+}
+
+static void
+_hosts_free(struct hosts_snapshot* snap)
+{
+    free(snap->buckets);
+    free(snap->names);
+    free(snap->text);
+    free(snap);
+}
+
+static int
+_hosts_same_file(const struct hosts_snapshot* snap, const struct stat* st)
+{
+    return snap->dev == st->st_dev &&
+           snap->ino == st->st_ino &&
+           snap->size == st->st_size &&
+           snap->mtime.tv_sec == st->st_mtim.tv_sec &&
+           snap->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* reads and indexes the hosts file, or returns NULL */
+static struct hosts_snapshot*
+_hosts_load(void)
+{
+    struct hosts_snapshot* snap;
+    struct stat st;
+    ssize_t n = 0;
+    int32_t i;
+    int fd;
+
+    fd = open(_PATH_HOSTS, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return NULL;
+    if (fstat(fd, &st) == -1 || st.st_size >= INT32_MAX) {
+        close(fd);
+        return NULL;
+    }
+
+    snap = calloc(1, sizeof(*snap));
+    if (snap == NULL || (snap->text = malloc((size_t)st.st_size + 1)) == NULL) {
+        free(snap);
+        close(fd);
+        return NULL;
+    }
+    snap->dev   = st.st_dev;
+    snap->ino   = st.st_ino;
+    snap->size  = st.st_size;
+    snap->mtime = st.st_mtim;
+
+    /* if the file is being rewritten, the next stat() will see a new mtime
+     * and this snapshot will be replaced */
+    while (snap->text_len < st.st_size) {
+        n = TEMP_FAILURE_RETRY(read(fd, snap->text + snap->text_len,
+                                    (size_t)(st.st_size - snap->text_len)));
+        if (n <= 0)
+            break;
+        snap->text_len += (int32_t)n;
+    }
+    close(fd);
+    if (n < 0)
+        goto fail;
+    snap->text[snap->text_len] = '\0';
+
+    snap->num_names = _hosts_scan(snap->text, snap->text_len, NULL);
+    snap->names = malloc(((size_t)snap->num_names + 1) * sizeof(*snap->names));
+    if (snap->names == NULL)
+        goto fail;
+    _hosts_scan(snap->text, snap->text_len, snap->names);
+
+    snap->num_buckets = 16;
+    while (snap->num_buckets < (uint32_t)snap->num_names)
+        snap->num_buckets <<= 1;
+    snap->buckets = malloc(snap->num_buckets * sizeof(*snap->buckets));
+    if (snap->buckets == NULL)
+        goto fail;
+    memset(snap->buckets, 0xff, snap->num_buckets * sizeof(*snap->buckets));
+
+    /* chain in reverse so that lookups see lines in file order, dropping a
+     * name repeated on one line so that the line is only returned once */
+    for (i = snap->num_names - 1; i >= 0; i--) {
+        struct hosts_name* e = &snap->names[i];
+        int32_t* head = &snap->buckets[e->hash & (snap->num_buckets - 1)];
+        int32_t j;
+
+        for (j = *head; j != -1 && snap->names[j].line == e->line; j = snap->names[j].next) {
+            const struct hosts_name* o = &snap->names[j];
+            if (o->hash == e->hash && o->len == e->len &&
+                strncasecmp(snap->text + o->name, snap->text + e->name, (size_t)e->len) == 0)
+                break;
+        }
+        if (j != -1 && snap->names[j].line == e->line)
+            continue;
+        e->next = *head;
+        *head = i;
+    }
+    return snap;
+
+fail:
+    _hosts_free(snap);
+    return NULL;
+}
+
+static void
+_hosts_release(struct hosts_snapshot* snap)
+{
+    int refs;
+
+    pthread_mutex_lock(&_hosts_lock);
+    refs = --snap->refs;
+    pthread_mutex_unlock(&_hosts_lock);
+    if (refs == 0)
+        _hosts_free(snap);
+}
+
+/* returns a reference to an index of the current hosts file, or NULL */
+static struct hosts_snapshot*
+_hosts_get(void)
+{
+    struct hosts_snapshot* snap;
+    struct hosts_snapshot* old;
+    struct stat st;
+
+    if (stat(_PATH_HOSTS, &st) == -1)
+        return NULL;
+
+    pthread_mutex_lock(&_hosts_lock);
+    snap = _hosts_current;
+    if (snap != NULL && _hosts_same_file(snap, &st)) {
+        snap->refs++;
+        pthread_mutex_unlock(&_hosts_lock);
+        return snap;
+    }
+    pthread_mutex_unlock(&_hosts_lock);
+
+    /* read the file without the lock held; if several threads race to do
+     * it, the last one's snapshot is kept */
+    snap = _hosts_load();
+    if (snap == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&_hosts_lock);
+    old = _hosts_current;
+    _hosts_current = snap;
+    snap->refs = 2;
+    pthread_mutex_unlock(&_hosts_lock);
+    if (old != NULL)
+        _hosts_release(old);
+    return snap;
+}
+
+int
+_hosts_open(struct hosts_cursor* cursor, const char* name)
+{
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->name = name;
+
+    cursor->snap = _hosts_get();
+    if (cursor->snap == NULL) {
+        /* fall back to reading every line */
+        cursor->hf = fopen(_PATH_HOSTS, "re");
+        if (cursor->hf == NULL)
+            return -1;
+        cursor->close_hf = 1;
+        return 0;
+    }
+
+    if (name != NULL) {
+        cursor->name_len = strlen(name);
+        cursor->hash = _hosts_hash(name, cursor->name_len);
+        cursor->next = cursor->snap->buckets[cursor->hash & (cursor->snap->num_buckets - 1)];
+    }
+    return 0;
+}
+
+void
+_hosts_open_file(struct hosts_cursor* cursor, FILE* hf)
+{
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->hf = hf;
+}
+
+/* copies at most len-1 bytes of the line at 'off' into 'buf', like fgets,
+ * and returns the number of bytes copied */
+static int32_t
+_hosts_copy_line(const struct hosts_snapshot* snap, int32_t off, char* buf, size_t len)
+{
+    const char* line = snap->text + off;
+    const char* nl = memchr(line, '\n', (size_t)(snap->text_len - off));
+    size_t n = nl ? (size_t)(nl - line) + 1 : (size_t)(snap->text_len - off);
+
+    if (n > len - 1)
+        n = len - 1;
+    memcpy(buf, line, n);
+    buf[n] = '\0';
+    return (int32_t)n;
+}
+
+char*
+_hosts_gets(struct hosts_cursor* cursor, char* buf, size_t len)
+{
+    const struct hosts_snapshot* snap = cursor->snap;
+
+    if (snap == NULL)
+        return cursor->hf ? fgets(buf, (int)len, cursor->hf) : NULL;
+    if (len < 2)
+        return NULL;
+
+    if (cursor->name == NULL) {
+        if (cursor->next >= snap->text_len)
+            return NULL;
+        cursor->next += _hosts_copy_line(snap, cursor->next, buf, len);
+        return buf;
+    }
+
+    while (cursor->next != -1) {
+        const struct hosts_name* e = &snap->names[cursor->next];
+        cursor->next = e->next;
+        if (e->hash == cursor->hash && (size_t)e->len == cursor->name_len &&
+            strncasecmp(snap->text + e->name, cursor->name, cursor->name_len) == 0) {
+            _hosts_copy_line(snap, e->line, buf, len);
+            return buf;
+        }
+    }
+    return NULL;
+}
+
+void
+_hosts_close(struct hosts_cursor* cursor)
+{
+    if (cursor->snap != NULL) {
+        _hosts_release(cursor->snap);
+        cursor->snap = NULL;
+    }
+    if (cursor->close_hf && cursor->hf != NULL) {
+        fclose(cursor->hf);
+    }
+    cursor->hf = NULL;
+}
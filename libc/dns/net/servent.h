@@ -42,3 +42,16 @@
 #include "resolv_static.h"
 
 struct servent*  getservent_r(res_static rs);
+
+/* Binary searches of the _services indexes, returning the first entry for
+ * the name or port (in network order) with the given protocol, or any
+ * protocol if proto is NULL, or NULL if there isn't one. */
+const char*  _servent_by_name(const char* name, const char* proto);
+const char*  _servent_by_port(int port, const char* proto);
+
+/* Decodes a _services entry into the thread's servent. */
+struct servent*  _servent_static(res_static rs, const char* entry);
+
+/* Decodes a _services entry into 'se', using 'buf' for its strings.
+ * Returns 0, or ERANGE if 'buf' is too small. */
+int  _servent_decode_r(const char* entry, struct servent* se, char* buf, size_t buflen);
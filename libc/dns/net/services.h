@@ -547,3 +547,119 @@ static const char  _services[] = "\
 \4fido\353\23t\0\
 \0";
 
+static const unsigned short  _services_by_name[545] = {
+  761, 780, 6860, 6873, 6886, 6900, 2749, 2764, 5544, 5557,
+  5336, 5354, 5512, 5528, 5288, 5312, 5444, 5462, 5372, 5390,
+  5602, 5618, 5570, 5586, 5408, 5426, 5480, 5496, 5897, 5908,
+  7309, 7323, 4882, 4891, 4625, 4633, 7483, 7491, 1600, 1612,
+  1578, 1589, 1554, 1566, 1624, 1635, 978, 5711, 5726, 5741,
+  5755, 5769, 5783, 1478, 1486, 6818, 7095, 2377, 7473, 509,
+  520, 487, 498, 6025, 6034, 5953, 5963, 5973, 5989, 5935,
+  5944, 7106, 4761, 4774, 6718, 157, 183, 3753, 3768, 7198,
+  1858, 1882, 1346, 1361, 1320, 1333, 1830, 1844, 4025, 4037,
+  4049, 4064, 2559, 2543, 799, 819, 7499, 6618, 6630, 3949,
+  3964, 4311, 4320, 3433, 3460, 90, 102, 6065, 2677, 2695,
+  2713, 2731, 4095, 4104, 7510, 29, 51, 4289, 4300, 6944,
+  429, 440, 11, 20, 6381, 6971, 6987, 4419, 4428, 2368,
+  4113, 4131, 4459, 4473, 1774, 1786, 6924, 7534, 577, 5634,
+  5655, 4853, 4870, 6730, 230, 222, 209, 3018, 3004, 2612,
+  2623, 4189, 4207, 4900, 4908, 7257, 3843, 3854, 5118, 5135,
+  5084, 5101, 540, 551, 4171, 4180, 3931, 3940, 3565, 3579,
+  6074, 4149, 4160, 3895, 3913, 5919, 5927, 2274, 2304, 7034,
+  7046, 720, 588, 601, 5676, 5698, 1992, 2002, 6932, 4487,
+  4495, 4225, 4239, 2779, 2788, 1226, 1241, 1710, 1720, 3051,
+  3061, 1952, 1961, 3371, 3386, 2352, 2360, 6400, 1694, 1702,
+  1520, 1528, 7141, 3071, 3080, 2106, 2117, 7429, 7441, 6850,
+  743, 7285, 7297, 3227, 3237, 627, 668, 2943, 6164, 6200,
+  6104, 6134, 3543, 3554, 2649, 6327, 2064, 2076, 6318, 6252,
+  6290, 2660, 6393, 3593, 3606, 1934, 1943, 2887, 2897, 610,
+  6440, 1096, 1114, 3723, 2393, 3269, 3294, 1376, 1386, 7230,
+  4787, 4796, 2030, 2047, 4567, 4576, 6496, 6518, 6548, 4079,
+  4087, 7086, 3345, 3358, 3319, 3332, 3689, 3698, 141, 149,
+  4503, 4511, 451, 6956, 4253, 4263, 5256, 5272, 339, 5817,
+  3247, 3258, 1162, 1178, 1132, 1147, 1194, 1210, 2579, 114,
+  2600, 1416, 1447, 3827, 3835, 6739, 6752, 1035, 2825, 2841,
+  7012, 7023, 2222, 2248, 2162, 2192, 2146, 2154, 7068, 7077,
+  2470, 1058, 1066, 4273, 4281, 6584, 6601, 7174, 7186, 3171,
+  3183, 6827, 6838, 6808, 6220, 1730, 1742, 7003, 3799, 863,
+  889, 904, 919, 3089, 3099, 6454, 6467, 4805, 4829, 6654,
+  2441, 3129, 3140, 1494, 1507, 3401, 3417, 1074, 1085, 2334,
+  2343, 1646, 1655, 126, 3619, 3630, 3641, 3665, 4519, 4535,
+  399, 414, 4437, 4448, 2797, 3738, 4551, 4559, 6788, 6797,
+  562, 322, 3195, 3211, 6666, 3151, 3161, 2480, 1798, 1814,
+  7058, 2984, 2994, 3865, 3880, 839, 851, 2128, 2137, 3487,
+  3515, 2088, 2097, 7116, 3783, 1012, 5208, 5232, 5152, 5180,
+  7417, 7379, 7392, 7405, 2416, 4409, 2925, 2934, 4585, 4593,
+  4601, 4613, 6642, 7337, 7347, 270, 1536, 1545, 1256, 1265,
+  1274, 1297, 2012, 2021, 3109, 3119, 6574, 243, 251, 6480,
+  2857, 2872, 934, 956, 709, 6425, 6410, 6706, 4367, 4377,
+  4329, 4348, 1970, 1981, 6309, 2430, 4387, 4398, 73, 377,
+  388, 459, 473, 2461, 0, 259, 3027, 3039, 2525, 7524,
+  531, 284, 303, 2504, 2907, 2916, 7163, 1906, 1920, 3707,
+  2634, 1021, 7453, 7463, 3979, 3989, 3999, 4012, 6005, 6015,
+  6043, 6054, 7274, 2960, 2972, 2403, 359, 6677, 6086, 6095,
+  4916, 4930, 4944, 4954, 4964, 4974, 4984, 4994, 5004, 5014,
+  5024, 5034, 5044, 5054, 5064, 5074, 1396, 1406, 7219, 5797,
+  5807, 4641, 4671, 4701, 4731, 7357, 7368, 6687, 6914, 6696,
+  1664, 1679, 5825, 5842, 5859, 5878, 6778, 6765, 6352, 6367,
+  6337, 7265, 7150, 1754, 1764,
+};
+
+static const unsigned short  _services_by_port[545] = {
+  0, 11, 20, 29, 51, 73, 90, 102, 114, 126,
+  141, 149, 157, 183, 209, 222, 230, 243, 251, 259,
+  270, 284, 303, 322, 339, 359, 377, 388, 399, 414,
+  429, 440, 451, 459, 473, 487, 498, 509, 520, 531,
+  540, 551, 562, 577, 588, 601, 610, 627, 668, 709,
+  6440, 720, 743, 761, 780, 799, 819, 6454, 6467, 839,
+  851, 863, 889, 904, 919, 934, 956, 978, 1012, 1021,
+  1035, 1058, 1066, 1074, 1085, 1096, 1114, 1132, 1147, 1162,
+  1178, 1194, 1210, 1226, 1241, 1256, 1265, 1274, 1297, 1320,
+  1333, 1346, 1361, 1376, 1386, 1396, 1406, 1416, 1447, 1478,
+  1486, 1494, 1507, 1520, 1528, 1536, 1545, 1554, 1566, 1578,
+  1589, 1600, 1612, 1624, 1635, 1646, 1655, 1664, 1679, 1694,
+  1702, 1710, 1720, 1730, 1742, 1754, 1764, 1774, 1786, 1798,
+  1814, 1830, 1844, 1858, 1882, 1906, 1920, 1934, 1943, 1952,
+  1961, 1970, 1981, 1992, 2002, 2012, 2021, 2030, 2047, 2064,
+  2076, 6480, 2088, 2097, 2106, 2117, 2368, 2377, 2393, 2403,
+  2416, 2430, 2441, 2461, 2470, 2480, 2504, 2525, 2543, 2559,
+  2579, 2600, 2612, 2623, 2634, 2649, 2660, 2677, 2695, 2713,
+  2731, 2749, 2764, 2779, 2788, 2128, 2137, 2797, 2825, 2841,
+  2857, 2872, 2146, 2154, 2162, 2192, 2222, 2248, 2274, 2304,
+  2334, 2343, 2352, 2360, 2887, 2897, 2907, 2916, 2925, 2934,
+  2943, 6104, 6134, 6164, 6200, 6220, 6252, 6290, 2960, 2972,
+  6496, 6518, 6548, 6574, 6584, 6601, 6410, 2984, 2994, 6309,
+  3004, 3018, 3027, 3039, 3051, 3061, 3071, 3080, 3089, 3099,
+  6618, 6630, 3109, 3119, 3129, 3140, 3151, 3161, 3195, 3211,
+  6318, 6425, 6642, 3171, 3183, 6654, 3227, 3237, 6666, 3247,
+  3258, 6677, 6687, 6696, 3269, 3294, 3319, 3332, 3345, 3358,
+  3371, 3386, 3401, 3417, 6706, 3433, 3460, 3487, 3515, 3543,
+  3554, 3565, 3579, 3593, 3606, 3619, 3630, 3641, 3665, 3689,
+  3698, 3707, 3723, 3738, 3753, 3768, 6718, 3783, 3799, 3827,
+  3835, 6327, 3843, 3854, 3865, 3880, 6337, 6352, 6367, 6381,
+  6393, 3895, 3913, 6400, 6730, 3931, 3940, 6739, 6752, 3949,
+  3964, 3979, 3989, 3999, 4012, 4025, 4037, 4049, 4064, 4079,
+  4087, 6765, 6778, 6788, 6797, 6808, 6818, 6827, 6838, 6850,
+  4095, 4104, 4113, 4131, 4149, 4160, 4171, 4180, 6860, 6873,
+  6886, 6900, 4189, 4207, 4225, 4239, 4253, 4263, 4273, 4281,
+  4289, 4300, 4311, 4320, 4329, 4348, 4367, 4377, 4387, 4398,
+  4409, 6914, 4459, 4473, 4419, 4428, 4437, 4448, 6924, 6932,
+  4487, 4495, 6944, 4503, 4511, 4519, 4535, 6956, 4551, 4559,
+  4567, 4576, 6971, 6987, 4585, 4593, 4601, 4613, 7003, 4625,
+  4633, 4641, 4671, 4701, 4731, 4761, 4774, 4787, 4796, 7012,
+  7023, 7034, 7046, 4805, 4829, 7058, 4853, 4870, 7068, 7077,
+  4882, 4891, 7086, 7095, 7106, 4900, 4908, 4916, 4930, 4944,
+  4954, 4964, 4974, 4984, 4994, 5004, 5014, 5024, 5034, 5044,
+  5054, 5064, 5074, 5084, 5101, 5118, 5135, 5152, 5180, 5208,
+  5232, 5256, 5272, 7116, 7141, 5288, 5312, 5336, 5354, 5372,
+  5390, 5408, 5426, 5444, 5462, 5480, 5496, 5512, 5528, 5544,
+  5557, 5570, 5586, 5602, 5618, 5634, 5655, 7150, 5676, 5698,
+  7163, 7174, 7186, 7198, 7219, 5711, 5726, 5741, 5755, 5769,
+  5783, 7230, 7257, 5797, 5807, 7265, 7274, 5825, 5842, 5859,
+  5878, 5897, 5908, 7285, 7297, 7309, 7323, 5817, 7337, 7347,
+  5919, 5927, 5935, 5944, 5953, 5963, 5973, 5989, 6005, 6015,
+  6025, 6034, 6043, 6054, 7357, 7368, 7379, 7392, 7405, 7417,
+  7429, 7441, 7453, 7463, 6065, 6074, 6086, 6095, 7473, 7483,
+  7491, 7499, 7510, 7524, 7534,
+};
+
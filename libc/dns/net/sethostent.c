@@ -53,6 +53,7 @@ __RCSID("$NetBSD: sethostent.c,v 1.20 2014/03/17 13:24:23 christos Exp $");
 #include <stdlib.h>
 
 #include "hostent.h"
+#include "hosts_cache.h"
 #include "resolv_private.h"
 
 #define ALIGNBYTES (sizeof(uintptr_t) - 1)
@@ -130,22 +131,20 @@ _hf_gethtbyname2(const char *name, int af, struct getnamaddr *info)
 	struct hostent *hp, hent;
 	char *buf, *ptr;
 	size_t len, anum, num, i;
-	FILE *hf;
+	struct hosts_cursor hostc;
 	char *aliases[MAXALIASES];
 	char *addr_ptrs[MAXADDRS];
 
 	_DIAGASSERT(name != NULL);
 
-	hf = NULL;
-	sethostent_r(&hf);
-	if (hf == NULL) {
+	if (_hosts_open(&hostc, name) == -1) {
 		errno = EINVAL;
 		*info->he = NETDB_INTERNAL;
 		return NULL;
 	}
 
 	if ((ptr = buf = malloc(len = info->buflen)) == NULL) {
-		endhostent_r(&hf);
+		_hosts_close(&hostc);
 		*info->he = NETDB_INTERNAL;
 		return NULL;
 	}
@@ -159,7 +158,7 @@ _hf_gethtbyname2(const char *name, int af, struct getnamaddr *info)
 		info->hp->h_addrtype = af;
 		info->hp->h_length = 0;
 
-		hp = netbsd_gethostent_r(hf, info->hp, info->buf, info->buflen,
+		hp = _hf_gethostent_r(&hostc, info->hp, info->buf, info->buflen,
 		    info->he);
 		if (hp == NULL) {
 			if (*info->he == NETDB_INTERNAL && errno == ENOSPC) {
@@ -198,7 +197,7 @@ _hf_gethtbyname2(const char *name, int af, struct getnamaddr *info)
 		    len);
 		num++;
 	}
-	endhostent_r(&hf);
+	_hosts_close(&hostc);
 
 	if (num == 0) {
 		*info->he = HOST_NOT_FOUND;
@@ -230,7 +229,7 @@ _hf_gethtbyname2(const char *name, int af, struct getnamaddr *info)
 	free(buf);
 	return hp;
 nospc:
-	endhostent_r(&hf);
+	_hosts_close(&hostc);
 	*info->he = NETDB_INTERNAL;
 	free(buf);
 	errno = ENOSPC;
@@ -244,7 +243,7 @@ _hf_gethtbyaddr(void *rv, void *cb_data, va_list ap)
 	struct hostent *hp;
 	const unsigned char *addr;
 	struct getnamaddr *info = rv;
-	FILE *hf;
+	struct hosts_cursor hostc;
 
 	_DIAGASSERT(rv != NULL);
 
@@ -252,17 +251,16 @@ _hf_gethtbyaddr(void *rv, void *cb_data, va_list ap)
 	info->hp->h_length = va_arg(ap, int);
 	info->hp->h_addrtype = va_arg(ap, int);
 
-	hf = NULL;
-	sethostent_r(&hf);
-	if (hf == NULL) {
+	/* the index is by name, so this reads every line, but from memory */
+	if (_hosts_open(&hostc, NULL) == -1) {
 		*info->he = NETDB_INTERNAL;
 		return NS_UNAVAIL;
 	}
-	while ((hp = netbsd_gethostent_r(hf, info->hp, info->buf, info->buflen,
+	while ((hp = _hf_gethostent_r(&hostc, info->hp, info->buf, info->buflen,
 	    info->he)) != NULL)
 		if (!memcmp(hp->h_addr_list[0], addr, (size_t)hp->h_length))
 			break;
-	endhostent_r(&hf);
+	_hosts_close(&hostc);
 
 	if (hp == NULL) {
 		if (errno == ENOSPC) {
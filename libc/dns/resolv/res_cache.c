@@ -35,6 +35,7 @@
 #include <string.h>
 #include <time.h>
 #include "pthread.h"
+#include <stdatomic.h>
 
 #include <errno.h>
 #include <arpa/nameser.h>
@@ -47,6 +48,7 @@
 #include "resolv_netid.h"
 #include "res_private.h"
 
+#include "private/bionic_stats.h"
 #include "private/libc_logging.h"
 
 /* This code implements a small and *simple* DNS resolver cache.
@@ -134,8 +136,33 @@
  * * Upping by 2x for IPv6
  * * Upping by another 5x for the centralized nature
  * *****************************************
+ *
+ * ******************************************
+ * * NOTE - this has changed again.
+ * * Answers vary a lot in size, so the cache is now bounded by the memory
+ * * its entries use rather than by their number: CACHE_MAX_BYTES by
+ * * default, and configurable per network through __res_params. The hash
+ * * table is sized assuming entries of about CONFIG_ENTRY_BYTES each, which
+ * * lets the default budget hold around six times the 640 entries above.
+ * *****************************************
  */
-#define  CONFIG_MAX_ENTRIES    64 * 2 * 5
+#define  CONFIG_ENTRY_BYTES    256
+
+/* RFC 2308 section 5 recommends not caching negative answers for more
+ * than a few hours, whatever their SOA record says.
+ */
+#define  CONFIG_MAX_NEGATIVE_TTL   (3 * 60 * 60)
+
+/* Hot entries, ones that are looked up more than once, are refreshed ahead
+ * of time: the lookup that finds one with less than CONFIG_REFRESH_PERCENT
+ * of its TTL left still returns the answer, and asks its caller to send the
+ * query again in the background. Until the new answer arrives, a hot entry
+ * that has expired keeps being served for up to CONFIG_MAX_STALE seconds
+ * (see RFC 8767), so popular names don't wait for a round trip when their
+ * answers expire.
+ */
+#define  CONFIG_REFRESH_PERCENT    10
+#define  CONFIG_MAX_STALE          30
 
 /****************************************************************************/
 /****************************************************************************/
@@ -999,18 +1026,23 @@ typedef struct Entry {
     const uint8_t*   answer;
     int              answerlen;
     time_t           expires;   /* time_t when the entry isn't valid any more */
+    time_t           refresh_at; /* time_t when a hot entry should be refreshed */
+    atomic_int       referenced; /* looked up since it was last considered for eviction */
+    atomic_int       refreshing; /* a lookup has asked its caller to refresh the entry */
     int              id;        /* for debugging purpose */
 } Entry;
 
 /**
  * Find the TTL for a negative DNS result.  This is defined as the minimum
- * of the SOA records TTL and the MINIMUM-TTL field (RFC-2308).
+ * of the SOA records TTL and the MINIMUM-TTL field (RFC-2308), and is
+ * capped at CONFIG_MAX_NEGATIVE_TTL.
  *
- * Return 0 if not found.
+ * Return 0 if not found, since negative answers without an SOA record
+ * must not be cached.
  */
 static u_long
 answer_getNegativeTTL(ns_msg handle) {
-    int n, nscount;
+    int n, nscount, found = 0;
     u_long result = 0;
     ns_rr rr;
 
@@ -1042,11 +1074,15 @@ answer_getNegativeTTL(ns_msg handle) {
                 rec_result = ttl;
             }
             // Now that the record is read successfully, apply the new min TTL
-            if (n == 0 || rec_result < result) {
+            if (!found || rec_result < result) {
                 result = rec_result;
+                found = 1;
             }
         }
     }
+    if (result > CONFIG_MAX_NEGATIVE_TTL) {
+        result = CONFIG_MAX_NEGATIVE_TTL;
+    }
     return result;
 }
 
@@ -1056,6 +1092,13 @@ answer_getNegativeTTL(ns_msg handle) {
  * the answer records if found or from the SOA record
  * if it's a negative result.
  *
+ * Negative results are NXDOMAIN, and NOERROR without
+ * any record of the type asked for (NODATA). Either
+ * may follow a CNAME chain, in which case the CNAME
+ * records limit the TTL too (RFC-2308 section 5).
+ * Other response codes, such as SERVFAIL, aren't
+ * cached at all.
+ *
  * The returned TTL is the number of seconds to
  * keep the answer in the cache.
  *
@@ -1066,28 +1109,42 @@ static u_long
 answer_getTTL(const void* answer, int answerlen)
 {
     ns_msg handle;
-    int ancount, n;
-    u_long result, ttl;
+    int ancount, n, rcode, qtype = -1, positive = 0;
+    u_long result, ttl, negative_ttl;
     ns_rr rr;
 
     result = 0;
     if (ns_initparse(answer, answerlen, &handle) >= 0) {
+        rcode = ns_msg_getflag(handle, ns_f_rcode);
+        if (rcode != ns_r_noerror && rcode != ns_r_nxdomain) {
+            XLOG("not caching rcode %d\n", rcode);
+            return 0;
+        }
+        if (ns_parserr(&handle, ns_s_qd, 0, &rr) == 0) {
+            qtype = ns_rr_type(rr);
+        }
+
         // get number of answer records
         ancount = ns_msg_count(handle, ns_s_an);
-
-        if (ancount == 0) {
-            // a response with no answers?  Cache this negative result.
-            result = answer_getNegativeTTL(handle);
-        } else {
-            for (n = 0; n < ancount; n++) {
-                if (ns_parserr(&handle, ns_s_an, n, &rr) == 0) {
-                    ttl = ns_rr_ttl(rr);
-                    if (n == 0 || ttl < result) {
-                        result = ttl;
-                    }
-                } else {
-                    XLOG("ns_parserr failed ancount no = %d. errno = %s\n", n, strerror(errno));
+        for (n = 0; n < ancount; n++) {
+            if (ns_parserr(&handle, ns_s_an, n, &rr) == 0) {
+                ttl = ns_rr_ttl(rr);
+                if (n == 0 || ttl < result) {
+                    result = ttl;
                 }
+                if (ns_rr_type(rr) == qtype || qtype == ns_t_any) {
+                    positive = 1;
+                }
+            } else {
+                XLOG("ns_parserr failed ancount no = %d. errno = %s\n", n, strerror(errno));
+            }
+        }
+
+        if (rcode == ns_r_nxdomain || !positive) {
+            // a negative result, possibly after some CNAMEs.  Cache it.
+            negative_ttl = answer_getNegativeTTL(handle);
+            if (ancount == 0 || negative_ttl < result) {
+                result = negative_ttl;
             }
         }
     } else {
@@ -1156,15 +1213,20 @@ entry_init_key( Entry*  e, const void*  query, int  querylen )
     return _dnsPacket_checkQuery(pack);
 }
 
+/* the memory used by an entry, which is allocated in a single block */
+static size_t
+entry_size( int  querylen, int  answerlen )
+{
+    return sizeof(Entry) + querylen + answerlen;
+}
+
 /* allocate a new entry as a cache node */
 static Entry*
 entry_alloc( const Entry*  init, const void*  answer, int  answerlen )
 {
     Entry*  e;
-    int     size;
 
-    size = sizeof(*e) + init->querylen + answerlen;
-    e    = calloc(size, 1);
+    e = calloc(entry_size(init->querylen, answerlen), 1);
     if (e == NULL)
         return e;
 
@@ -1218,13 +1280,33 @@ typedef struct pending_req_info {
     struct pending_req_info*    next;
 } PendingReqInfo;
 
-typedef struct resolv_cache {
-    int              max_entries;
+/* Each cache is split into shards by query hash, so that lookups of
+ * different names don't contend for the same locks. Cache hits only take
+ * the shard's lock for reading, which is why a hit just marks the entry as
+ * referenced rather than moving it to the front of the MRU list: eviction
+ * gives referenced entries a second chance instead.
+ */
+#define CACHE_SHARDS 8
+
+typedef struct cache_shard {
+    pthread_rwlock_t lock;         /* protects the entries and the MRU list */
+    size_t           max_bytes;    /* this shard's share of the memory budget */
+    size_t           num_bytes;    /* memory used by the entries */
+    int              num_buckets;
     int              num_entries;
     Entry            mru_list;
     int              last_id;
-    Entry*           entries;
+    Entry**          entries;
+    uint64_t         evictions;
+    atomic_uint_least64_t hits;    /* counted under the read lock */
+    atomic_uint_least64_t misses;
+    pthread_mutex_t  pending_lock; /* protects pending_requests */
     PendingReqInfo   pending_requests;
+} CacheShard;
+
+typedef struct resolv_cache {
+    atomic_int       refs;         /* the list of caches holds one */
+    CacheShard       shards[CACHE_SHARDS];
 } Cache;
 
 struct resolv_cache_info {
@@ -1246,18 +1328,52 @@ struct resolv_cache_info {
 static pthread_once_t        _res_cache_once = PTHREAD_ONCE_INIT;
 static void _res_cache_init(void);
 
-// lock protecting everything in the _resolve_cache_info structs (next ptr, etc)
-static pthread_mutex_t _res_cache_list_lock;
+// lock protecting everything in the _resolve_cache_info structs (next ptr, etc),
+// but not the contents of the caches themselves, which have their own locks
+static pthread_rwlock_t _res_cache_list_lock = PTHREAD_RWLOCK_INITIALIZER;
 
 /* gets cache associated with a network, or NULL if none exists */
 static struct resolv_cache* _find_named_cache_locked(unsigned netid);
 
+static void _resolv_cache_free(struct resolv_cache* cache);
+
+/* gets the cache associated with a network and takes a reference to it, so that it
+ * can be used without holding _res_cache_list_lock, or NULL if none exists. */
+static struct resolv_cache*
+_cache_acquire(unsigned netid)
+{
+    struct resolv_cache* cache;
+
+    pthread_rwlock_rdlock(&_res_cache_list_lock);
+    cache = _find_named_cache_locked(netid);
+    if (cache) {
+        atomic_fetch_add_explicit(&cache->refs, 1, memory_order_relaxed);
+    }
+    pthread_rwlock_unlock(&_res_cache_list_lock);
+    return cache;
+}
+
+/* drops a reference taken by _cache_acquire() */
+static void
+_cache_release(struct resolv_cache* cache)
+{
+    if (atomic_fetch_sub_explicit(&cache->refs, 1, memory_order_acq_rel) == 1) {
+        _resolv_cache_free(cache);
+    }
+}
+
+static CacheShard*
+_cache_shard(struct resolv_cache* cache, const Entry* key)
+{
+    return &cache->shards[key->hash % CACHE_SHARDS];
+}
+
 static void
-_cache_flush_pending_requests_locked( struct resolv_cache* cache )
+_cache_flush_pending_requests_locked( CacheShard* shard )
 {
     struct pending_req_info *ri, *tmp;
-    if (cache) {
-        ri = cache->pending_requests.next;
+    if (shard) {
+        ri = shard->pending_requests.next;
 
         while (ri) {
             tmp = ri;
@@ -1268,22 +1384,23 @@ _cache_flush_pending_requests_locked( struct resolv_cache* cache )
             free(tmp);
         }
 
-        cache->pending_requests.next = NULL;
+        shard->pending_requests.next = NULL;
     }
 }
 
 /* Return 0 if no pending request is found matching the key.
  * If a matching request is found the calling thread will wait until
- * the matching request completes, then update *cache and return 1. */
+ * the matching request completes, then return 1.
+ * Must be called with the shard's pending_lock held. */
 static int
-_cache_check_pending_request_locked( struct resolv_cache** cache, Entry* key, unsigned netid )
+_cache_check_pending_request_locked( CacheShard* shard, Entry* key )
 {
     struct pending_req_info *ri, *prev;
     int exist = 0;
 
-    if (*cache && key) {
-        ri = (*cache)->pending_requests.next;
-        prev = &(*cache)->pending_requests;
+    if (shard && key) {
+        ri = shard->pending_requests.next;
+        prev = &shard->pending_requests;
         while (ri) {
             if (ri->hash == key->hash) {
                 exist = 1;
@@ -1304,9 +1421,7 @@ _cache_check_pending_request_locked( struct resolv_cache** cache, Entry* key, un
             struct timespec ts = {0,0};
             XLOG("Waiting for previous request");
             ts.tv_sec = _time_now() + PENDING_REQUEST_TIMEOUT;
-            pthread_cond_timedwait(&ri->cond, &_res_cache_list_lock, &ts);
-            /* Must update *cache as it could have been deleted. */
-            *cache = _find_named_cache_locked(netid);
+            pthread_cond_timedwait(&ri->cond, &shard->pending_lock, &ts);
         }
     }
 
@@ -1316,13 +1431,13 @@ _cache_check_pending_request_locked( struct resolv_cache** cache, Entry* key, un
 /* notify any waiting thread that waiting on a request
  * matching the key has been added to the cache */
 static void
-_cache_notify_waiting_tid_locked( struct resolv_cache* cache, Entry* key )
+_cache_notify_waiting_tid_locked( CacheShard* shard, Entry* key )
 {
     struct pending_req_info *ri, *prev;
 
-    if (cache && key) {
-        ri = cache->pending_requests.next;
-        prev = &cache->pending_requests;
+    if (shard && key) {
+        ri = shard->pending_requests.next;
+        prev = &shard->pending_requests;
         while (ri) {
             if (ri->hash == key->hash) {
                 pthread_cond_broadcast(&ri->cond);
@@ -1341,63 +1456,91 @@ _cache_notify_waiting_tid_locked( struct resolv_cache* cache, Entry* key )
     }
 }
 
+static Entry** _cache_lookup_p(CacheShard* shard, const Entry* key);
+
 /* notify the cache that the query failed */
 void
 _resolv_cache_query_failed( unsigned    netid,
                    const void* query,
                    int         querylen)
 {
-    Entry    key[1];
-    Cache*   cache;
+    Entry        key[1];
+    Entry*       e;
+    Cache*       cache;
+    CacheShard*  shard;
 
     if (!entry_init_key(key, query, querylen))
         return;
 
-    pthread_mutex_lock(&_res_cache_list_lock);
-
-    cache = _find_named_cache_locked(netid);
+    cache = _cache_acquire(netid);
 
     if (cache) {
-        _cache_notify_waiting_tid_locked(cache, key);
-    }
+        shard = _cache_shard(cache, key);
+
+        /* if this was a refresh, let a later lookup try again */
+        pthread_rwlock_rdlock(&shard->lock);
+        e = *_cache_lookup_p(shard, key);
+        if (e != NULL) {
+            atomic_store_explicit(&e->refreshing, 0, memory_order_relaxed);
+        }
+        pthread_rwlock_unlock(&shard->lock);
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+        pthread_mutex_lock(&shard->pending_lock);
+        _cache_notify_waiting_tid_locked(shard, key);
+        pthread_mutex_unlock(&shard->pending_lock);
+        _cache_release(cache);
+    }
 }
 
 static struct resolv_cache_info* _find_cache_info_locked(unsigned netid);
 
 static void
-_cache_flush_locked( Cache*  cache )
+_cache_flush( Cache*  cache )
 {
-    int     nn;
+    int     nn, ss;
 
-    for (nn = 0; nn < cache->max_entries; nn++)
+    for (ss = 0; ss < CACHE_SHARDS; ss++)
     {
-        Entry**  pnode = (Entry**) &cache->entries[nn];
+        CacheShard*  shard = &cache->shards[ss];
+
+        pthread_rwlock_wrlock(&shard->lock);
+        for (nn = 0; nn < shard->num_buckets; nn++)
+        {
+            Entry**  pnode = &shard->entries[nn];
 
-        while (*pnode != NULL) {
-            Entry*  node = *pnode;
-            *pnode = node->hlink;
-            entry_free(node);
+            while (*pnode != NULL) {
+                Entry*  node = *pnode;
+                *pnode = node->hlink;
+                entry_free(node);
+            }
         }
-    }
 
-    // flush pending request
-    _cache_flush_pending_requests_locked(cache);
+        shard->mru_list.mru_next = shard->mru_list.mru_prev = &shard->mru_list;
+        shard->num_entries       = 0;
+        shard->num_bytes         = 0;
+        shard->last_id           = 0;
+        pthread_rwlock_unlock(&shard->lock);
 
-    cache->mru_list.mru_next = cache->mru_list.mru_prev = &cache->mru_list;
-    cache->num_entries       = 0;
-    cache->last_id           = 0;
+        // flush pending request
+        pthread_mutex_lock(&shard->pending_lock);
+        _cache_flush_pending_requests_locked(shard);
+        pthread_mutex_unlock(&shard->pending_lock);
+    }
 
     XLOG("*************************\n"
          "*** DNS CACHE FLUSHED ***\n"
          "*************************");
 }
 
-static int
-_res_cache_get_max_entries( void )
+/* returns the memory budget of a network's cache, given its parameters */
+static size_t
+_res_cache_get_max_bytes( const struct __res_params*  params )
 {
-    int cache_size = CONFIG_MAX_ENTRIES;
+    size_t cache_size = CACHE_MAX_BYTES;
+
+    if (params != NULL && params->cache_max_bytes != 0) {
+        cache_size = params->cache_max_bytes;
+    }
 
     const char* cache_mode = getenv("ANDROID_DNS_MODE");
     if (cache_mode == NULL || strcmp(cache_mode, "local") != 0) {
@@ -1405,30 +1548,80 @@ _res_cache_get_max_entries( void )
         cache_size = 0;
     }
 
-    XLOG("cache size: %d", cache_size);
+    XLOG("cache size: %zu bytes", cache_size);
     return cache_size;
 }
 
+/* returns each shard's share of a cache's memory budget, rounded up so
+ * that a small cache still has room in every shard */
+static size_t
+_cache_shard_max_bytes( size_t  max_bytes )
+{
+    return (max_bytes + CACHE_SHARDS - 1) / CACHE_SHARDS;
+}
+
+/* returns the number of hash buckets for a shard with the given budget */
+static int
+_cache_shard_buckets( size_t  max_bytes )
+{
+    size_t  buckets = max_bytes / CONFIG_ENTRY_BYTES;
+
+    return buckets > 0 ? (int)buckets : 1;
+}
+
 static struct resolv_cache*
 _resolv_cache_create( void )
 {
     struct resolv_cache*  cache;
+    size_t                max_bytes;
+    int                   ss;
 
     cache = calloc(sizeof(*cache), 1);
     if (cache) {
-        cache->max_entries = _res_cache_get_max_entries();
-        cache->entries = calloc(sizeof(*cache->entries), cache->max_entries);
-        if (cache->entries) {
-            cache->mru_list.mru_prev = cache->mru_list.mru_next = &cache->mru_list;
-            XLOG("%s: cache created\n", __FUNCTION__);
-        } else {
-            free(cache);
-            cache = NULL;
+        atomic_init(&cache->refs, 1);
+        /* _resolv_set_nameservers_for_net() applies the network's own budget */
+        max_bytes = _cache_shard_max_bytes(_res_cache_get_max_bytes(NULL));
+        for (ss = 0; ss < CACHE_SHARDS; ss++) {
+            CacheShard*  shard = &cache->shards[ss];
+
+            shard->max_bytes   = max_bytes;
+            shard->num_buckets = _cache_shard_buckets(max_bytes);
+            shard->entries = calloc(sizeof(*shard->entries), shard->num_buckets);
+            if (!shard->entries) {
+                while (--ss >= 0) {
+                    free(cache->shards[ss].entries);
+                }
+                free(cache);
+                return NULL;
+            }
+            shard->mru_list.mru_prev = shard->mru_list.mru_next = &shard->mru_list;
+            atomic_init(&shard->hits, 0);
+            atomic_init(&shard->misses, 0);
+            pthread_rwlock_init(&shard->lock, NULL);
+            pthread_mutex_init(&shard->pending_lock, NULL);
         }
+        XLOG("%s: cache created\n", __FUNCTION__);
     }
     return cache;
 }
 
+/* frees a cache once the last reference to it has been dropped */
+static void
+_resolv_cache_free( struct resolv_cache*  cache )
+{
+    int  ss;
+
+    _cache_flush(cache);
+    for (ss = 0; ss < CACHE_SHARDS; ss++) {
+        CacheShard*  shard = &cache->shards[ss];
+
+        pthread_rwlock_destroy(&shard->lock);
+        pthread_mutex_destroy(&shard->pending_lock);
+        free(shard->entries);
+    }
+    free(cache);
+}
+
 
 #if DEBUG
 static void
@@ -1443,13 +1636,13 @@ _dump_query( const uint8_t*  query, int  querylen )
 }
 
 static void
-_cache_dump_mru( Cache*  cache )
+_cache_dump_mru( CacheShard*  shard )
 {
     char    temp[512], *p=temp, *end=p+sizeof(temp);
     Entry*  e;
 
-    p = _bprint(temp, end, "MRU LIST (%2d): ", cache->num_entries);
-    for (e = cache->mru_list.mru_next; e != &cache->mru_list; e = e->mru_next)
+    p = _bprint(temp, end, "MRU LIST (%2d): ", shard->num_entries);
+    for (e = shard->mru_list.mru_next; e != &shard->mru_list; e = e->mru_next)
         p = _bprint(p, end, " %d", e->id);
 
     XLOG("%s", temp);
@@ -1498,6 +1691,14 @@ _dump_answer(const void* answer, int answerlen)
 #  define  XLOG_ANSWER(a,len)  ((void)0)
 #endif
 
+/* returns the index of the hash bucket for a hash value */
+static int
+_cache_bucket( unsigned int  hash, int  num_buckets )
+{
+    /* the low bits of the hash picked the shard */
+    return (hash / CACHE_SHARDS) % num_buckets;
+}
+
 /* This function tries to find a key within the hash table
  * In case of success, it will return a *pointer* to the hashed key.
  * In case of failure, it will return a *pointer* to NULL
@@ -1513,11 +1714,11 @@ _dump_answer(const void* answer, int answerlen)
  * table.
  */
 static Entry**
-_cache_lookup_p( Cache*   cache,
-                 Entry*   key )
+_cache_lookup_p( CacheShard*  shard,
+                 const Entry* key )
 {
-    int      index = key->hash % cache->max_entries;
-    Entry**  pnode = (Entry**) &cache->entries[ index ];
+    int      index = _cache_bucket(key->hash, shard->num_buckets);
+    Entry**  pnode = &shard->entries[ index ];
 
     while (*pnode != NULL) {
         Entry*  node = *pnode;
@@ -1539,17 +1740,18 @@ _cache_lookup_p( Cache*   cache,
  * newly created entry
  */
 static void
-_cache_add_p( Cache*   cache,
-              Entry**  lookup,
-              Entry*   e )
+_cache_add_p( CacheShard*  shard,
+              Entry**      lookup,
+              Entry*       e )
 {
     *lookup = e;
-    e->id = ++cache->last_id;
-    entry_mru_add(e, &cache->mru_list);
-    cache->num_entries += 1;
+    e->id = ++shard->last_id;
+    entry_mru_add(e, &shard->mru_list);
+    shard->num_entries += 1;
+    shard->num_bytes   += entry_size(e->querylen, e->answerlen);
 
     XLOG("%s: entry %d added (count=%d)", __FUNCTION__,
-         e->id, cache->num_entries);
+         e->id, shard->num_entries);
 }
 
 /* Remove an existing entry from the hash table,
@@ -1557,27 +1759,38 @@ _cache_add_p( Cache*   cache,
  * and succesful _lookup_p() call.
  */
 static void
-_cache_remove_p( Cache*   cache,
-                 Entry**  lookup )
+_cache_remove_p( CacheShard*  shard,
+                 Entry**      lookup )
 {
     Entry*  e  = *lookup;
 
     XLOG("%s: entry %d removed (count=%d)", __FUNCTION__,
-         e->id, cache->num_entries-1);
+         e->id, shard->num_entries-1);
 
     entry_mru_remove(e);
     *lookup = e->hlink;
+    shard->num_entries -= 1;
+    shard->num_bytes   -= entry_size(e->querylen, e->answerlen);
     entry_free(e);
-    cache->num_entries -= 1;
 }
 
-/* Remove the oldest entry from the hash table.
+/* Remove the least recently used entry from the hash table. Entries that
+ * have been looked up since they were last considered go back to the front
+ * of the MRU list instead (see CacheShard).
  */
 static void
-_cache_remove_oldest( Cache*  cache )
+_cache_remove_oldest( CacheShard*  shard )
 {
-    Entry*   oldest = cache->mru_list.mru_prev;
-    Entry**  lookup = _cache_lookup_p(cache, oldest);
+    Entry*   oldest = shard->mru_list.mru_prev;
+    Entry**  lookup;
+
+    while (oldest != shard->mru_list.mru_next &&
+           atomic_exchange_explicit(&oldest->referenced, 0, memory_order_relaxed)) {
+        entry_mru_remove(oldest);
+        entry_mru_add(oldest, &shard->mru_list);
+        oldest = shard->mru_list.mru_prev;
+    }
+    lookup = _cache_lookup_p(shard, oldest);
 
     if (*lookup == NULL) { /* should not happen */
         XLOG("%s: OLDEST NOT IN HTABLE ?", __FUNCTION__);
@@ -1587,117 +1800,205 @@ _cache_remove_oldest( Cache*  cache )
         XLOG("Cache full - removing oldest");
         XLOG_QUERY(oldest->query, oldest->querylen);
     }
-    _cache_remove_p(cache, lookup);
+    _cache_remove_p(shard, lookup);
+    shard->evictions += 1;
 }
 
 /* Remove all expired entries from the hash table.
  */
-static void _cache_remove_expired(Cache* cache) {
+static void _cache_remove_expired(CacheShard* shard) {
     Entry* e;
     time_t now = _time_now();
 
-    for (e = cache->mru_list.mru_next; e != &cache->mru_list;) {
+    for (e = shard->mru_list.mru_next; e != &shard->mru_list;) {
         // Entry is old, remove
         if (now >= e->expires) {
-            Entry** lookup = _cache_lookup_p(cache, e);
+            Entry** lookup = _cache_lookup_p(shard, e);
             if (*lookup == NULL) { /* should not happen */
                 XLOG("%s: ENTRY NOT IN HTABLE ?", __FUNCTION__);
                 return;
             }
             e = e->mru_next;
-            _cache_remove_p(cache, lookup);
+            _cache_remove_p(shard, lookup);
         } else {
             e = e->mru_next;
         }
     }
 }
 
-ResolvCacheStatus
-_resolv_cache_lookup( unsigned              netid,
-                      const void*           query,
-                      int                   querylen,
-                      void*                 answer,
-                      int                   answersize,
-                      int                  *answerlen )
+/* Remove expired entries, then the least recently used ones, until
+ * another 'size' bytes fit in the shard's memory budget.
+ */
+static void
+_cache_make_room( CacheShard*  shard, size_t  size )
 {
-    Entry      key[1];
-    Entry**    lookup;
-    Entry*     e;
-    time_t     now;
-    Cache*     cache;
+    if (shard->num_bytes + size <= shard->max_bytes)
+        return;
 
-    ResolvCacheStatus  result = RESOLV_CACHE_NOTFOUND;
+    _cache_remove_expired(shard);
+    while (shard->num_entries > 0 && shard->num_bytes + size > shard->max_bytes) {
+        int  count = shard->num_entries;
 
-    XLOG("%s: lookup", __FUNCTION__);
-    XLOG_QUERY(query, querylen);
-
-    /* we don't cache malformed queries */
-    if (!entry_init_key(key, query, querylen)) {
-        XLOG("%s: unsupported query", __FUNCTION__);
-        return RESOLV_CACHE_UNSUPPORTED;
+        _cache_remove_oldest(shard);
+        if (shard->num_entries == count) /* should not happen */
+            break;
     }
-    /* lookup cache */
-    pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+}
 
-    cache = _find_named_cache_locked(netid);
-    if (cache == NULL) {
-        result = RESOLV_CACHE_UNSUPPORTED;
-        goto Exit;
+/* Apply a new memory budget to a cache, resizing the hash tables to match
+ * and evicting whatever no longer fits.
+ */
+static void
+_cache_set_max_bytes( Cache*  cache, size_t  max_bytes )
+{
+    int  buckets, ss;
+
+    max_bytes = _cache_shard_max_bytes(max_bytes);
+    buckets   = _cache_shard_buckets(max_bytes);
+    for (ss = 0; ss < CACHE_SHARDS; ss++) {
+        CacheShard*  shard = &cache->shards[ss];
+
+        pthread_rwlock_wrlock(&shard->lock);
+        shard->max_bytes = max_bytes;
+        if (buckets != shard->num_buckets) {
+            Entry**  entries = calloc(sizeof(*entries), buckets);
+            Entry*   e;
+
+            /* keep the old table if there's no memory for a new one */
+            if (entries != NULL) {
+                for (e = shard->mru_list.mru_next; e != &shard->mru_list; e = e->mru_next) {
+                    int  index = _cache_bucket(e->hash, buckets);
+
+                    e->hlink = entries[index];
+                    entries[index] = e;
+                }
+                free(shard->entries);
+                shard->entries     = entries;
+                shard->num_buckets = buckets;
+            }
+        }
+        _cache_make_room(shard, 0);
+        pthread_rwlock_unlock(&shard->lock);
     }
+}
 
+/* Copies the answer to the query 'key' out of the shard, if it's there and
+ * fresh, or stale but being refreshed. Only needs the shard's lock for
+ * reading. */
+static ResolvCacheStatus
+_cache_get_answer_locked( CacheShard*  shard,
+                          const Entry* key,
+                          void*        answer,
+                          int          answersize,
+                          int         *answerlen )
+{
     /* see the description of _lookup_p to understand this.
      * the function always return a non-NULL pointer.
      */
-    lookup = _cache_lookup_p(cache, key);
-    e      = *lookup;
+    Entry*  e = *_cache_lookup_p(shard, key);
+    time_t  now;
+    int     hot;
 
     if (e == NULL) {
         XLOG( "NOT IN CACHE");
-        // calling thread will wait if an outstanding request is found
-        // that matching this query
-        if (!_cache_check_pending_request_locked(&cache, key, netid) || cache == NULL) {
-            goto Exit;
-        } else {
-            lookup = _cache_lookup_p(cache, key);
-            e = *lookup;
-            if (e == NULL) {
-                goto Exit;
-            }
-        }
+        return RESOLV_CACHE_NOTFOUND;
     }
 
+    /* stale entries are replaced by the next _resolv_cache_add(), but hot
+     * ones are served for a little longer while they are being refreshed */
     now = _time_now();
-
-    /* remove stale entries here */
-    if (now >= e->expires) {
-        XLOG( " NOT IN CACHE (STALE ENTRY %p DISCARDED)", *lookup );
+    hot = atomic_load_explicit(&e->referenced, memory_order_relaxed);
+    if (now >= e->expires && (!hot || now >= e->expires + CONFIG_MAX_STALE)) {
+        XLOG( " NOT IN CACHE (STALE ENTRY %p)", e );
         XLOG_QUERY(e->query, e->querylen);
-        _cache_remove_p(cache, lookup);
-        goto Exit;
+        return RESOLV_CACHE_NOTFOUND;
     }
 
     *answerlen = e->answerlen;
     if (e->answerlen > answersize) {
         /* NOTE: we return UNSUPPORTED if the answer buffer is too short */
-        result = RESOLV_CACHE_UNSUPPORTED;
         XLOG(" ANSWER TOO LONG");
-        goto Exit;
+        return RESOLV_CACHE_UNSUPPORTED;
     }
 
     memcpy( answer, e->answer, e->answerlen );
 
-    /* bump up this entry to the top of the MRU list */
-    if (e != cache->mru_list.mru_next) {
-        entry_mru_remove( e );
-        entry_mru_add( e, &cache->mru_list );
+    /* keep this entry from being evicted next */
+    if (!hot) {
+        atomic_store_explicit(&e->referenced, 1, memory_order_relaxed);
+    }
+
+    /* only one caller gets to refresh the entry */
+    if (hot && now >= e->refresh_at &&
+        !atomic_exchange_explicit(&e->refreshing, 1, memory_order_relaxed)) {
+        XLOG( "FOUND IN CACHE entry=%p, REFRESHING", e );
+        return RESOLV_CACHE_REFRESH;
     }
 
     XLOG( "FOUND IN CACHE entry=%p", e );
-    result = RESOLV_CACHE_FOUND;
+    return RESOLV_CACHE_FOUND;
+}
 
-Exit:
-    pthread_mutex_unlock(&_res_cache_list_lock);
+ResolvCacheStatus
+_resolv_cache_lookup( unsigned              netid,
+                      const void*           query,
+                      int                   querylen,
+                      void*                 answer,
+                      int                   answersize,
+                      int                  *answerlen )
+{
+    Entry        key[1];
+    Cache*       cache;
+    CacheShard*  shard;
+
+    ResolvCacheStatus  result = RESOLV_CACHE_NOTFOUND;
+
+    XLOG("%s: lookup", __FUNCTION__);
+    XLOG_QUERY(query, querylen);
+
+    /* we don't cache malformed queries */
+    if (!entry_init_key(key, query, querylen)) {
+        XLOG("%s: unsupported query", __FUNCTION__);
+        return RESOLV_CACHE_UNSUPPORTED;
+    }
+    /* lookup cache */
+    pthread_once(&_res_cache_once, _res_cache_init);
+    cache = _cache_acquire(netid);
+    if (cache == NULL) {
+        return RESOLV_CACHE_UNSUPPORTED;
+    }
+    shard = _cache_shard(cache, key);
+
+    pthread_rwlock_rdlock(&shard->lock);
+    result = _cache_get_answer_locked(shard, key, answer, answersize, answerlen);
+    pthread_rwlock_unlock(&shard->lock);
+
+    if (result == RESOLV_CACHE_NOTFOUND) {
+        // calling thread will wait if an outstanding request is found
+        // that matching this query. _resolv_cache_add() adds the answer
+        // before taking pending_lock to notify us, so looking again with
+        // pending_lock held can't miss both the answer and the request.
+        pthread_mutex_lock(&shard->pending_lock);
+        pthread_rwlock_rdlock(&shard->lock);
+        result = _cache_get_answer_locked(shard, key, answer, answersize, answerlen);
+        pthread_rwlock_unlock(&shard->lock);
+        if (result == RESOLV_CACHE_NOTFOUND &&
+                _cache_check_pending_request_locked(shard, key)) {
+            pthread_rwlock_rdlock(&shard->lock);
+            result = _cache_get_answer_locked(shard, key, answer, answersize, answerlen);
+            pthread_rwlock_unlock(&shard->lock);
+        }
+        pthread_mutex_unlock(&shard->pending_lock);
+    }
+
+    if (result == RESOLV_CACHE_FOUND || result == RESOLV_CACHE_REFRESH) {
+        atomic_fetch_add_explicit(&shard->hits, 1, memory_order_relaxed);
+        __libc_stats_add(LIBC_STAT_RESOLVER_CACHE_HITS, 1);
+    } else if (result == RESOLV_CACHE_NOTFOUND) {
+        atomic_fetch_add_explicit(&shard->misses, 1, memory_order_relaxed);
+        __libc_stats_add(LIBC_STAT_RESOLVER_CACHE_MISSES, 1);
+    }
+    _cache_release(cache);
     return result;
 }
 
@@ -1709,11 +2010,12 @@ _resolv_cache_add( unsigned              netid,
                    const void*           answer,
                    int                   answerlen )
 {
-    Entry    key[1];
-    Entry*   e;
-    Entry**  lookup;
-    u_long   ttl;
-    Cache*   cache = NULL;
+    Entry        key[1];
+    Entry*       e;
+    Entry**      lookup;
+    u_long       ttl;
+    Cache*       cache = NULL;
+    CacheShard*  shard;
 
     /* don't assume that the query has already been cached
      */
@@ -1722,12 +2024,13 @@ _resolv_cache_add( unsigned              netid,
         return;
     }
 
-    pthread_mutex_lock(&_res_cache_list_lock);
-
-    cache = _find_named_cache_locked(netid);
+    cache = _cache_acquire(netid);
     if (cache == NULL) {
-        goto Exit;
+        return;
     }
+    shard = _cache_shard(cache, key);
+
+    pthread_rwlock_wrlock(&shard->lock);
 
     XLOG( "%s: query:", __FUNCTION__ );
     XLOG_QUERY(query,querylen);
@@ -1737,46 +2040,47 @@ _resolv_cache_add( unsigned              netid,
     XLOG_BYTES(answer,answerlen);
 #endif
 
-    lookup = _cache_lookup_p(cache, key);
+    lookup = _cache_lookup_p(shard, key);
     e      = *lookup;
 
-    if (e != NULL) { /* should not happen */
-        XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
-             __FUNCTION__, e);
-        goto Exit;
-    }
-
-    if (cache->num_entries >= cache->max_entries) {
-        _cache_remove_expired(cache);
-        if (cache->num_entries >= cache->max_entries) {
-            _cache_remove_oldest(cache);
-        }
-        /* need to lookup again */
-        lookup = _cache_lookup_p(cache, key);
-        e      = *lookup;
-        if (e != NULL) {
-            XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
-                __FUNCTION__, e);
-            goto Exit;
-        }
+    if (e != NULL) {
+        /* lookups leave stale entries, and entries being refreshed, for us
+         * to replace */
+        _cache_remove_p(shard, lookup);
+        lookup = _cache_lookup_p(shard, key);
     }
 
     ttl = answer_getTTL(answer, answerlen);
     if (ttl > 0) {
+        size_t  size = entry_size(querylen, answerlen);
+
+        if (size > shard->max_bytes) {
+            XLOG("%s: ANSWER TOO LARGE TO CACHE", __FUNCTION__);
+            goto Exit;
+        }
+        if (shard->num_bytes + size > shard->max_bytes) {
+            _cache_make_room(shard, size);
+            /* need to lookup again */
+            lookup = _cache_lookup_p(shard, key);
+        }
         e = entry_alloc(key, answer, answerlen);
         if (e != NULL) {
-            e->expires = ttl + _time_now();
-            _cache_add_p(cache, lookup, e);
+            e->expires    = ttl + _time_now();
+            e->refresh_at = e->expires - ttl * CONFIG_REFRESH_PERCENT / 100;
+            _cache_add_p(shard, lookup, e);
         }
     }
 #if DEBUG
-    _cache_dump_mru(cache);
+    _cache_dump_mru(shard);
 #endif
 Exit:
-    if (cache != NULL) {
-      _cache_notify_waiting_tid_locked(cache, key);
-    }
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&shard->lock);
+
+    pthread_mutex_lock(&shard->pending_lock);
+    _cache_notify_waiting_tid_locked(shard, key);
+    pthread_mutex_unlock(&shard->pending_lock);
+
+    _cache_release(cache);
 }
 
 /****************************************************************************/
@@ -1820,7 +2124,6 @@ _res_cache_init(void)
     }
 
     memset(&_res_cache_list, 0, sizeof(_res_cache_list));
-    pthread_mutex_init(&_res_cache_list_lock, NULL);
 }
 
 static struct resolv_cache*
@@ -1847,11 +2150,11 @@ void
 _resolv_flush_cache_for_net(unsigned netid)
 {
     pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_wrlock(&_res_cache_list_lock);
 
     _flush_cache_for_net_locked(netid);
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
 }
 
 static void
@@ -1859,7 +2162,7 @@ _flush_cache_for_net_locked(unsigned netid)
 {
     struct resolv_cache* cache = _find_named_cache_locked(netid);
     if (cache) {
-        _cache_flush_locked(cache);
+        _cache_flush(cache);
     }
 
     // Also clear the NS statistics.
@@ -1870,7 +2173,7 @@ _flush_cache_for_net_locked(unsigned netid)
 void _resolv_delete_cache_for_net(unsigned netid)
 {
     pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_wrlock(&_res_cache_list_lock);
 
     struct resolv_cache_info* prev_cache_info = &_res_cache_list;
 
@@ -1879,9 +2182,10 @@ void _resolv_delete_cache_for_net(unsigned netid)
 
         if (cache_info->netid == netid) {
             prev_cache_info->next = cache_info->next;
-            _cache_flush_locked(cache_info->cache);
-            free(cache_info->cache->entries);
-            free(cache_info->cache);
+            // Wake anyone waiting on a pending request; the cache itself goes
+            // away once the last thread using it is done.
+            _cache_flush(cache_info->cache);
+            _cache_release(cache_info->cache);
             _free_nameservers_locked(cache_info);
             free(cache_info);
             break;
@@ -1890,7 +2194,7 @@ void _resolv_delete_cache_for_net(unsigned netid)
         prev_cache_info = prev_cache_info->next;
     }
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
 }
 
 static struct resolv_cache_info*
@@ -1944,6 +2248,7 @@ _resolv_set_default_params(struct __res_params* params) {
     params->success_threshold = SUCCESS_THRESHOLD;
     params->min_samples = 0;
     params->max_samples = 0;
+    params->cache_max_bytes = CACHE_MAX_BYTES;
 }
 
 int
@@ -1982,7 +2287,7 @@ _resolv_set_nameservers_for_net(unsigned netid, const char** servers, unsigned n
     }
 
     pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_wrlock(&_res_cache_list_lock);
 
     // creates the cache if not created
     _get_res_cache_for_net_locked(netid);
@@ -1996,6 +2301,7 @@ _resolv_set_nameservers_for_net(unsigned netid, const char** servers, unsigned n
         } else {
             _resolv_set_default_params(&cache_info->params);
         }
+        _cache_set_max_bytes(cache_info->cache, _res_cache_get_max_bytes(&cache_info->params));
 
         if (!_resolv_is_nameservers_equal_locked(cache_info, servers, numservers)) {
             // free current before adding new
@@ -2054,7 +2360,7 @@ _resolv_set_nameservers_for_net(unsigned netid, const char** servers, unsigned n
         *offset = -1; /* cache_info->dnsrch_offset has MAXDNSRCH+1 items */
     }
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
     return 0;
 }
 
@@ -2113,7 +2419,7 @@ _resolv_populate_res_for_net(res_state statp)
     }
 
     pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_rdlock(&_res_cache_list_lock);
 
     struct resolv_cache_info* info = _find_cache_info_locked(statp->netid);
     if (info != NULL) {
@@ -2154,7 +2460,7 @@ _resolv_populate_res_for_net(res_state statp)
             *pp++ = &statp->defdname[0] + *p++;
         }
     }
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
 }
 
 /* Resolver reachability statistics. */
@@ -2189,12 +2495,12 @@ android_net_res_stats_get_info_for_net(unsigned netid, int* nscount,
         struct sockaddr_storage servers[MAXNS], int* dcount, char domains[MAXDNSRCH][MAXDNSRCHPATH],
         struct __res_params* params, struct __res_stats stats[MAXNS]) {
     int revision_id = -1;
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_rdlock(&_res_cache_list_lock);
 
     struct resolv_cache_info* info = _find_cache_info_locked(netid);
     if (info) {
         if (info->nscount > MAXNS) {
-            pthread_mutex_unlock(&_res_cache_list_lock);
+            pthread_rwlock_unlock(&_res_cache_list_lock);
             XLOG("%s: nscount %d > MAXNS %d", __FUNCTION__, info->nscount, MAXNS);
             errno = EFAULT;
             return -1;
@@ -2208,19 +2514,19 @@ android_net_res_stats_get_info_for_net(unsigned netid, int* nscount,
             int addrlen = info->nsaddrinfo[i]->ai_addrlen;
             if (addrlen < (int) sizeof(struct sockaddr) ||
                     addrlen > (int) sizeof(servers[0])) {
-                pthread_mutex_unlock(&_res_cache_list_lock);
+                pthread_rwlock_unlock(&_res_cache_list_lock);
                 XLOG("%s: nsaddrinfo[%d].ai_addrlen == %d", __FUNCTION__, i, addrlen);
                 errno = EMSGSIZE;
                 return -1;
             }
             if (info->nsaddrinfo[i]->ai_addr == NULL) {
-                pthread_mutex_unlock(&_res_cache_list_lock);
+                pthread_rwlock_unlock(&_res_cache_list_lock);
                 XLOG("%s: nsaddrinfo[%d].ai_addr == NULL", __FUNCTION__, i);
                 errno = ENOENT;
                 return -1;
             }
             if (info->nsaddrinfo[i]->ai_next != NULL) {
-                pthread_mutex_unlock(&_res_cache_list_lock);
+                pthread_rwlock_unlock(&_res_cache_list_lock);
                 XLOG("%s: nsaddrinfo[%d].ai_next != NULL", __FUNCTION__, i);
                 errno = ENOTUNIQ;
                 return -1;
@@ -2248,15 +2554,45 @@ android_net_res_stats_get_info_for_net(unsigned netid, int* nscount,
         revision_id = info->revision_id;
     }
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
     return revision_id;
 }
 
+int
+android_net_res_stats_get_cache_stats_for_net(unsigned netid, struct __res_cache_stats* stats) {
+    Cache*  cache;
+    int     ss;
+
+    pthread_once(&_res_cache_once, _res_cache_init);
+    cache = _cache_acquire(netid);
+    if (cache == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (ss = 0; ss < CACHE_SHARDS; ss++) {
+        CacheShard*  shard = &cache->shards[ss];
+
+        stats->hits += atomic_load_explicit(&shard->hits, memory_order_relaxed);
+        stats->misses += atomic_load_explicit(&shard->misses, memory_order_relaxed);
+        pthread_rwlock_rdlock(&shard->lock);
+        stats->evictions += shard->evictions;
+        stats->entries += shard->num_entries;
+        stats->bytes += shard->num_bytes;
+        stats->max_bytes += shard->max_bytes;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+
+    _cache_release(cache);
+    return 0;
+}
+
 int
 _resolv_cache_get_resolver_stats( unsigned netid, struct __res_params* params,
         struct __res_stats stats[MAXNS]) {
     int revision_id = -1;
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_rdlock(&_res_cache_list_lock);
 
     struct resolv_cache_info* info = _find_cache_info_locked(netid);
     if (info) {
@@ -2265,7 +2601,7 @@ _resolv_cache_get_resolver_stats( unsigned netid, struct __res_params* params,
         revision_id = info->revision_id;
     }
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
     return revision_id;
 }
 
@@ -2274,7 +2610,7 @@ _resolv_cache_add_resolver_stats_sample( unsigned netid, int revision_id, int ns
        const struct __res_sample* sample, int max_samples) {
     if (max_samples <= 0) return;
 
-    pthread_mutex_lock(&_res_cache_list_lock);
+    pthread_rwlock_wrlock(&_res_cache_list_lock);
 
     struct resolv_cache_info* info = _find_cache_info_locked(netid);
 
@@ -2282,5 +2618,5 @@ _resolv_cache_add_resolver_stats_sample( unsigned netid, int revision_id, int ns
         _res_cache_add_stats_sample_locked(&info->nsstats[ns], sample, max_samples);
     }
 
-    pthread_mutex_unlock(&_res_cache_list_lock);
+    pthread_rwlock_unlock(&_res_cache_list_lock);
 }
@@ -96,7 +96,10 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
 #ifdef ANDROID_CHANGES
 #include "resolv_netid.h"
 #include "resolv_private.h"
@@ -104,6 +107,7 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #include <resolv.h>
 #endif
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -132,7 +136,30 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #define EXT(res) ((res)->_u._ext)
 #define DBG 0
 
-static const int highestFD = FD_SETSIZE - 1;
+/* Bounds on how long res_nsendN() waits for one server before the next. */
+#define HEDGE_MIN_MS		100
+#define HEDGE_DEFAULT_MS	300
+
+/* res_nsendN()'s bookkeeping for each of its queries. */
+struct sendq_state {
+	struct res_sendq *q;
+	ResolvCacheStatus cache_status;
+	u_int	sent;		/* servers the query went to in this try */
+	u_int	settled;	/* ... that have answered, refused or timed out */
+};
+
+/*
+ * Timeouts are measured against the monotonic clock, so that they aren't
+ * thrown off by changes to the time of day.
+ */
+static struct timespec
+mono_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts);
+}
 
 /* Forward. */
 
@@ -145,19 +172,18 @@ static int		send_dg(res_state, const u_char *, int,
 				u_char *, int, int *, int,
 				int *, int *,
 				time_t *, int *, int *);
+static int		open_dg(res_state, int, int *);
+static void		close_dg(res_state, int);
+static int		send_dg_parallel(res_state, struct sendq_state *, int,
+					 int, int *, int *);
 static void		Aerror(const res_state, FILE *, const char *, int,
 			       const struct sockaddr *, int);
 static void		Perror(const res_state, FILE *, const char *, int);
 static int		sock_eq(struct sockaddr *, struct sockaddr *);
-#ifdef NEED_PSELECT
-static int		pselect(int, void *, void *, void *,
-				struct timespec *,
-				const sigset_t *);
-#endif
 void res_pquery(const res_state, const u_char *, int, FILE *);
 static int connect_with_timeout(int sock, const struct sockaddr *nsap,
 			socklen_t salen, int sec);
-static int retrying_select(const int sock, fd_set *readset, fd_set *writeset,
+static int retrying_poll(const int sock, const short events,
 			const struct timespec *finish);
 
 /* BIONIC-BEGIN: implement source port randomization */
@@ -356,44 +382,14 @@ res_queriesmatch(const u_char *buf1, const u_char *eom1,
 	return (1);
 }
 
-int
-res_nsend(res_state statp,
-	  const u_char *buf, int buflen, u_char *ans, int anssiz)
+/*
+ * Brings our private copy of the nameserver list up to date with the
+ * resolver context, and rotates it if asked to.
+ */
+static void
+res_prepare_servers(res_state statp)
 {
-	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
-	char abuf[NI_MAXHOST];
-	ResolvCacheStatus     cache_status = RESOLV_CACHE_UNSUPPORTED;
-
-	if (anssiz < HFIXEDSZ) {
-		errno = EINVAL;
-		return (-1);
-	}
-	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
-		(stdout, ";; res_send()\n"), buf, buflen);
-	v_circuit = (statp->options & RES_USEVC) || buflen > PACKETSZ;
-	gotsomewhere = 0;
-	terrno = ETIMEDOUT;
-
-	int  anslen = 0;
-	cache_status = _resolv_cache_lookup(
-			statp->netid, buf, buflen,
-			ans, anssiz, &anslen);
-
-	if (cache_status == RESOLV_CACHE_FOUND) {
-		return anslen;
-	} else if (cache_status != RESOLV_CACHE_UNSUPPORTED) {
-		// had a cache miss for a known network, so populate the thread private
-		// data so the normal resolve path can do its thing
-		_resolv_populate_res_for_net(statp);
-	}
-	if (statp->nscount == 0) {
-		// We have no nameservers configured, so there's no point trying.
-		// Tell the cache the query failed, or any retries and anyone else asking the same
-		// question will block for PENDING_REQUEST_TIMEOUT seconds instead of failing fast.
-		_resolv_cache_query_failed(statp->netid, buf, buflen);
-		errno = ESRCH;
-		return (-1);
-	}
+	int ns;
 
 	/*
 	 * If the ns_addr_list in the resolver context has changed, then
@@ -482,6 +478,137 @@ res_nsend(res_state statp,
 		EXT(statp).nssocks[lastns] = fd;
 		EXT(statp).nstimes[lastns] = nstime;
 	}
+}
+
+/*
+ * Refreshing cache entries.  When a lookup finds a hot entry that is about
+ * to expire, the cache still answers, but returns RESOLV_CACHE_REFRESH to
+ * have the query sent again.  That happens on a detached thread, so that
+ * the caller gets the cached answer without waiting.
+ */
+#define RES_MAX_REFRESHES	4	/* refresh threads running at once */
+
+struct res_refresh {
+	unsigned netid;
+	unsigned mark;
+	int buflen;
+	int anssiz;
+	u_char buf[];			/* the query, then room for the answer */
+};
+
+static atomic_int res_refreshes;
+
+static void *
+res_refresh_thread(void *arg)
+{
+	struct res_refresh *r = arg;
+	res_state statp;
+
+	statp = __res_get_state();
+	if (statp != NULL) {
+		res_setnetid(statp, r->netid);
+		res_setmark(statp, r->mark);
+		/* res_nsend() passes the answer, or the failure, to the cache */
+		statp->_flags |= RES_F_REFRESH;
+		(void)res_nsend(statp, r->buf, r->buflen, r->buf + r->buflen,
+		    r->anssiz);
+		statp->_flags &= ~RES_F_REFRESH;
+		__res_put_state(statp);
+	} else
+		_resolv_cache_query_failed(r->netid, r->buf, r->buflen);
+	free(r);
+	atomic_fetch_sub_explicit(&res_refreshes, 1, memory_order_relaxed);
+	return (NULL);
+}
+
+static void
+res_refresh_async(res_state statp, const u_char *buf, int buflen, int anssiz)
+{
+	struct res_refresh *r;
+	pthread_attr_t attr;
+	pthread_t thread;
+	sigset_t mask, omask;
+	int saved_errno = errno;
+
+	if (atomic_fetch_add_explicit(&res_refreshes, 1,
+	    memory_order_relaxed) < RES_MAX_REFRESHES &&
+	    (r = malloc(sizeof(*r) + buflen + anssiz)) != NULL) {
+		r->netid = statp->netid;
+		r->mark = statp->_mark;
+		r->buflen = buflen;
+		r->anssiz = anssiz;
+		memcpy(r->buf, buf, buflen);
+
+		/* keep the application's signals away from our thread */
+		sigfillset(&mask);
+		pthread_sigmask(SIG_SETMASK, &mask, &omask);
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		if (pthread_create(&thread, &attr, res_refresh_thread, r) != 0) {
+			free(r);
+			r = NULL;
+		}
+		pthread_attr_destroy(&attr);
+		pthread_sigmask(SIG_SETMASK, &omask, NULL);
+		if (r != NULL) {
+			errno = saved_errno;
+			return;
+		}
+	}
+	atomic_fetch_sub_explicit(&res_refreshes, 1, memory_order_relaxed);
+	/* let a later lookup try again */
+	_resolv_cache_query_failed(statp->netid, buf, buflen);
+	errno = saved_errno;
+}
+
+int
+res_nsend(res_state statp,
+	  const u_char *buf, int buflen, u_char *ans, int anssiz)
+{
+	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
+	char abuf[NI_MAXHOST];
+	ResolvCacheStatus     cache_status = RESOLV_CACHE_UNSUPPORTED;
+
+	if (anssiz < HFIXEDSZ) {
+		errno = EINVAL;
+		return (-1);
+	}
+	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
+		(stdout, ";; res_send()\n"), buf, buflen);
+	v_circuit = (statp->options & RES_USEVC) || buflen > PACKETSZ;
+	gotsomewhere = 0;
+	terrno = ETIMEDOUT;
+
+	int  anslen = 0;
+	if (statp->_flags & RES_F_REFRESH) {
+		// the cached answer is what we're replacing
+		cache_status = RESOLV_CACHE_NOTFOUND;
+	} else {
+		cache_status = _resolv_cache_lookup(
+				statp->netid, buf, buflen,
+				ans, anssiz, &anslen);
+	}
+
+	if (cache_status == RESOLV_CACHE_FOUND) {
+		return anslen;
+	} else if (cache_status == RESOLV_CACHE_REFRESH) {
+		res_refresh_async(statp, buf, buflen, anssiz);
+		return anslen;
+	} else if (cache_status != RESOLV_CACHE_UNSUPPORTED) {
+		// had a cache miss for a known network, so populate the thread private
+		// data so the normal resolve path can do its thing
+		_resolv_populate_res_for_net(statp);
+	}
+	if (statp->nscount == 0) {
+		// We have no nameservers configured, so there's no point trying.
+		// Tell the cache the query failed, or any retries and anyone else asking the same
+		// question will block for PENDING_REQUEST_TIMEOUT seconds instead of failing fast.
+		_resolv_cache_query_failed(statp->netid, buf, buflen);
+		errno = ESRCH;
+		return (-1);
+	}
+
+	res_prepare_servers(statp);
 
 	/*
 	 * Send request, RETRY times, or until successful.
@@ -682,6 +809,117 @@ res_nsend(res_state statp,
 	return (-1);
 }
 
+/*
+ * Like res_nsend(), but for several queries at once, typically the A and
+ * AAAA queries for one name.  The queries go to each server together, on
+ * one socket, and if a server hasn't answered them within a couple of its
+ * usual round trips, the next server is asked too instead of waiting for
+ * the first to time out.  Sets each query's resplen, and returns the number
+ * of queries answered, or -1 (with errno set) if there were none.
+ */
+int
+res_nsendN(res_state statp, struct res_sendq *q, int nq)
+{
+	struct sendq_state qs[RES_MAXSENDQ];
+	int gotsomewhere, terrno, try, pending, answered, anslen, i;
+	int populate, fatal;
+
+	for (i = 0; i < nq; i++)
+		q[i].resplen = -1;
+
+	/*
+	 * Hooks, virtual circuits and more queries than we can track go
+	 * through res_nsend() one at a time.
+	 */
+	if (nq > RES_MAXSENDQ || statp->qhook || statp->rhook ||
+	    (statp->options & RES_USEVC) != 0U)
+		goto one_at_a_time;
+	for (i = 0; i < nq; i++) {
+		if (q[i].buflen > PACKETSZ || q[i].anssiz < HFIXEDSZ)
+			goto one_at_a_time;
+	}
+
+	pending = 0;
+	populate = 0;
+	for (i = 0; i < nq; i++) {
+		DprintQ((statp->options & RES_DEBUG) ||
+			(statp->pfcode & RES_PRF_QUERY),
+			(stdout, ";; res_sendN()\n"), q[i].buf, q[i].buflen);
+		qs[i].q = &q[i];
+		anslen = 0;
+		qs[i].cache_status = _resolv_cache_lookup(statp->netid,
+		    q[i].buf, q[i].buflen, q[i].ans, q[i].anssiz, &anslen);
+		if (qs[i].cache_status == RESOLV_CACHE_FOUND) {
+			q[i].resplen = anslen;
+			continue;
+		}
+		if (qs[i].cache_status == RESOLV_CACHE_REFRESH) {
+			q[i].resplen = anslen;
+			res_refresh_async(statp, q[i].buf, q[i].buflen,
+			    q[i].anssiz);
+			continue;
+		}
+		if (qs[i].cache_status != RESOLV_CACHE_UNSUPPORTED)
+			populate = 1;
+		pending++;
+	}
+	if (pending == 0)
+		return (nq);
+	if (populate)
+		_resolv_populate_res_for_net(statp);
+
+	gotsomewhere = 0;
+	terrno = ETIMEDOUT;
+	fatal = 0;
+	if (statp->nscount != 0) {
+		res_prepare_servers(statp);
+		for (try = 0; try < statp->retry && pending > 0; try++) {
+			pending = send_dg_parallel(statp, qs, nq, try,
+			    &terrno, &gotsomewhere);
+			if (pending < 0) {
+				fatal = 1;
+				break;
+			}
+		}
+	}
+
+	answered = 0;
+	for (i = 0; i < nq; i++) {
+		if (q[i].resplen > 0) {
+			answered++;
+			if (qs[i].cache_status == RESOLV_CACHE_NOTFOUND)
+				_resolv_cache_add(statp->netid, q[i].buf,
+				    q[i].buflen, q[i].ans, q[i].resplen);
+		} else {
+			_resolv_cache_query_failed(statp->netid, q[i].buf,
+			    q[i].buflen);
+		}
+	}
+	if (fatal || (statp->options & RES_STAYOPEN) == 0U)
+		res_nclose(statp);
+	if (answered > 0)
+		return (answered);
+	if (statp->nscount == 0)
+		errno = ESRCH;		/* no nameservers configured */
+	else if (fatal)
+		errno = terrno;
+	else if (!gotsomewhere)
+		errno = ECONNREFUSED;	/* no nameservers found */
+	else
+		errno = ETIMEDOUT;	/* no answer obtained */
+	return (-1);
+
+ one_at_a_time:
+	answered = 0;
+	for (i = 0; i < nq; i++) {
+		q[i].resplen = res_nsend(statp, q[i].buf, q[i].buflen,
+		    q[i].ans, q[i].anssiz);
+		if (q[i].resplen > 0)
+			answered++;
+	}
+	return (answered > 0 ? answered : -1);
+}
+
 /* Private */
 
 static int
@@ -774,7 +1012,7 @@ send_vc(res_state statp,
  same_ns:
 	truncating = 0;
 
-	struct timespec now = evNowTime();
+	struct timespec now = mono_now();
 
 	/* Are we still talking to whom we want to talk to? */
 	if (statp->_vcsock >= 0 && (statp->_flags & RES_F_VC) != 0) {
@@ -797,10 +1035,6 @@ send_vc(res_state statp,
 			res_nclose(statp);
 
 		statp->_vcsock = socket(nsap->sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
-		if (statp->_vcsock > highestFD) {
-			res_nclose(statp);
-			errno = ENOTSOCK;
-		}
 		if (statp->_vcsock < 0) {
 			switch (errno) {
 			case EPROTONOSUPPORT:
@@ -843,7 +1077,7 @@ send_vc(res_state statp,
 			 * determining whether this was really a timeout or e.g. ECONNREFUSED. Since
 			 * currently both cases are handled in the same way, there is no need to
 			 * change this (yet). If we ever need to reliably distinguish between these
-			 * cases, both connect_with_timeout() and retrying_select() need to be
+			 * cases, both connect_with_timeout() and retrying_poll() need to be
 			 * modified, though.
 			 */
 			*rcode = RCODE_TIMEOUT;
@@ -965,7 +1199,7 @@ send_vc(res_state statp,
 	 * next nameserver ought not be tried.
 	 */
 	if (resplen > 0) {
-	    struct timespec done = evNowTime();
+	    struct timespec done = mono_now();
 	    *delay = _res_stats_calculate_rtt(&done, &now);
 	    *rcode = anhp->rcode;
 	}
@@ -977,7 +1211,6 @@ static int
 connect_with_timeout(int sock, const struct sockaddr *nsap, socklen_t salen, int sec)
 {
 	int res, origflags;
-	fd_set rset, wset;
 	struct timespec now, timeout, finish;
 
 	origflags = fcntl(sock, F_GETFL, 0);
@@ -989,14 +1222,14 @@ connect_with_timeout(int sock, const struct sockaddr *nsap, socklen_t salen, int
 		goto done;
 	}
 	if (res != 0) {
-		now = evNowTime();
+		now = mono_now();
 		timeout = evConsTime((long)sec, 0L);
 		finish = evAddTime(now, timeout);
 		if (DBG) {
 			__libc_format_log(ANDROID_LOG_DEBUG, "libc", "  %d send_vc\n", sock);
 		}
 
-		res = retrying_select(sock, &rset, &wset, &finish);
+		res = retrying_poll(sock, POLLIN | POLLOUT, &finish);
 		if (res <= 0) {
 			res = -1;
 		}
@@ -1011,7 +1244,7 @@ done:
 }
 
 static int
-retrying_select(const int sock, fd_set *readset, fd_set *writeset, const struct timespec *finish)
+retrying_poll(const int sock, const short events, const struct timespec *finish)
 {
 	struct timespec now, timeout;
 	int n, error;
@@ -1020,28 +1253,20 @@ retrying_select(const int sock, fd_set *readset, fd_set *writeset, const struct
 
 retry:
 	if (DBG) {
-		__libc_format_log(ANDROID_LOG_DEBUG, "libc", "  %d retrying_select\n", sock);
+		__libc_format_log(ANDROID_LOG_DEBUG, "libc", "  %d retrying_poll\n", sock);
 	}
 
-	now = evNowTime();
-	if (readset) {
-		FD_ZERO(readset);
-		FD_SET(sock, readset);
-	}
-	if (writeset) {
-		FD_ZERO(writeset);
-		FD_SET(sock, writeset);
-	}
+	now = mono_now();
 	if (evCmpTime(*finish, now) > 0)
 		timeout = evSubTime(*finish, now);
 	else
 		timeout = evConsTime(0L, 0L);
-
-	n = pselect(sock + 1, readset, writeset, NULL, &timeout, NULL);
+	struct pollfd fds = { .fd = sock, .events = events };
+	n = ppoll(&fds, 1, &timeout, /*sigmask=*/NULL);
 	if (n == 0) {
 		if (DBG) {
 			__libc_format_log(ANDROID_LOG_DEBUG, " libc",
-				"  %d retrying_select timeout\n", sock);
+				"  %d retrying_poll timeout\n", sock);
 		}
 		errno = ETIMEDOUT;
 		return 0;
@@ -1051,17 +1276,17 @@ retry:
 			goto retry;
 		if (DBG) {
 			__libc_format_log(ANDROID_LOG_DEBUG, "libc",
-				"  %d retrying_select got error %d\n",sock, n);
+				"  %d retrying_poll got error %d\n",sock, n);
 		}
 		return n;
 	}
-	if ((readset && FD_ISSET(sock, readset)) || (writeset && FD_ISSET(sock, writeset))) {
+	if (fds.revents & (POLLIN | POLLOUT | POLLERR)) {
 		len = sizeof(error);
 		if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
 			errno = error;
 			if (DBG) {
 				__libc_format_log(ANDROID_LOG_DEBUG, "libc",
-					"  %d retrying_select dot error2 %d\n", sock, errno);
+					"  %d retrying_poll dot error2 %d\n", sock, errno);
 			}
 
 			return -1;
@@ -1069,91 +1294,117 @@ retry:
 	}
 	if (DBG) {
 		__libc_format_log(ANDROID_LOG_DEBUG, "libc",
-			"  %d retrying_select returning %d\n",sock, n);
+			"  %d retrying_poll returning %d\n",sock, n);
 	}
 
 	return n;
 }
 
+/*
+ * Opens and connects the datagram socket for server "ns", unless it is open
+ * already.  Returns 1 on success, 0 if the server should be skipped, or -1
+ * (with *terrno set) if the query can't be sent anywhere.
+ */
 static int
-send_dg(res_state statp,
-	const u_char *buf, int buflen, u_char *ans, int anssiz,
-	int *terrno, int ns, int *v_circuit, int *gotsomewhere,
-	time_t *at, int *rcode, int* delay)
+open_dg(res_state statp, int ns, int *terrno)
 {
-	*at = time(NULL);
-	*rcode = RCODE_INTERNAL_ERROR;
-	*delay = 0;
-	const HEADER *hp = (const HEADER *)(const void *)buf;
-	HEADER *anhp = (HEADER *)(void *)ans;
 	const struct sockaddr *nsap;
 	int nsaplen;
-	struct timespec now, timeout, finish, done;
-	fd_set dsmask;
-	struct sockaddr_storage from;
-	socklen_t fromlen;
-	int resplen, seconds, n, s;
 
 	nsap = get_nsaddr(statp, (size_t)ns);
 	nsaplen = get_salen(nsap);
-	if (EXT(statp).nssocks[ns] == -1) {
-		EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
-		if (EXT(statp).nssocks[ns] > highestFD) {
-			res_nclose(statp);
-			errno = ENOTSOCK;
-		}
-		if (EXT(statp).nssocks[ns] < 0) {
-			switch (errno) {
-			case EPROTONOSUPPORT:
+	if (EXT(statp).nssocks[ns] != -1)
+		return (1);
+	EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (EXT(statp).nssocks[ns] < 0) {
+		switch (errno) {
+		case EPROTONOSUPPORT:
 #ifdef EPFNOSUPPORT
-			case EPFNOSUPPORT:
+		case EPFNOSUPPORT:
 #endif
-			case EAFNOSUPPORT:
-				Perror(statp, stderr, "socket(dg)", errno);
-				return (0);
-			default:
-				*terrno = errno;
-				Perror(statp, stderr, "socket(dg)", errno);
-				return (-1);
-			}
+		case EAFNOSUPPORT:
+			Perror(statp, stderr, "socket(dg)", errno);
+			return (0);
+		default:
+			*terrno = errno;
+			Perror(statp, stderr, "socket(dg)", errno);
+			return (-1);
 		}
+	}
 
-		if (statp->_mark != MARK_UNSET) {
-			if (setsockopt(EXT(statp).nssocks[ns], SOL_SOCKET,
-					SO_MARK, &(statp->_mark), sizeof(statp->_mark)) < 0) {
-				res_nclose(statp);
-				return -1;
-			}
+	if (statp->_mark != MARK_UNSET) {
+		if (setsockopt(EXT(statp).nssocks[ns], SOL_SOCKET,
+				SO_MARK, &(statp->_mark), sizeof(statp->_mark)) < 0) {
+			close_dg(statp, ns);
+			return (-1);
 		}
+	}
 #ifndef CANNOT_CONNECT_DGRAM
-		/*
-		 * On a 4.3BSD+ machine (client and server,
-		 * actually), sending to a nameserver datagram
-		 * port with no nameserver will cause an
-		 * ICMP port unreachable message to be returned.
-		 * If our datagram socket is "connected" to the
-		 * server, we get an ECONNREFUSED error on the next
-		 * socket operation, and select returns if the
-		 * error message is received.  We can thus detect
-		 * the absence of a nameserver without timing out.
-		 */
-		if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
-			Aerror(statp, stderr, "bind(dg)", errno, nsap,
-			    nsaplen);
-			res_nclose(statp);
-			return (0);
-		}
-		if (__connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
-			Aerror(statp, stderr, "connect(dg)", errno, nsap,
-			    nsaplen);
-			res_nclose(statp);
-			return (0);
-		}
+	/*
+	 * On a 4.3BSD+ machine (client and server,
+	 * actually), sending to a nameserver datagram
+	 * port with no nameserver will cause an
+	 * ICMP port unreachable message to be returned.
+	 * If our datagram socket is "connected" to the
+	 * server, we get an ECONNREFUSED error on the next
+	 * socket operation, and poll returns if the
+	 * error message is received.  We can thus detect
+	 * the absence of a nameserver without timing out.
+	 */
+	if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
+		Aerror(statp, stderr, "bind(dg)", errno, nsap,
+		    nsaplen);
+		close_dg(statp, ns);
+		return (0);
+	}
+	if (__connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
+		Aerror(statp, stderr, "connect(dg)", errno, nsap,
+		    nsaplen);
+		close_dg(statp, ns);
+		return (0);
+	}
 #endif /* !CANNOT_CONNECT_DGRAM */
-		Dprint(statp->options & RES_DEBUG,
-		       (stdout, ";; new DG socket\n"))
+	Dprint(statp->options & RES_DEBUG,
+	       (stdout, ";; new DG socket\n"))
+	return (1);
+}
 
+/*
+ * Closes the datagram socket for server "ns", leaving any others open.
+ */
+static void
+close_dg(res_state statp, int ns)
+{
+	if (EXT(statp).nssocks[ns] != -1) {
+		(void) close(EXT(statp).nssocks[ns]);
+		EXT(statp).nssocks[ns] = -1;
 	}
+}
+
+
+static int
+send_dg(res_state statp,
+	const u_char *buf, int buflen, u_char *ans, int anssiz,
+	int *terrno, int ns, int *v_circuit, int *gotsomewhere,
+	time_t *at, int *rcode, int* delay)
+{
+	*at = time(NULL);
+	*rcode = RCODE_INTERNAL_ERROR;
+	*delay = 0;
+	const HEADER *hp = (const HEADER *)(const void *)buf;
+	HEADER *anhp = (HEADER *)(void *)ans;
+#ifdef CANNOT_CONNECT_DGRAM
+	const struct sockaddr *nsap = get_nsaddr(statp, (size_t)ns);
+	int nsaplen = get_salen(nsap);
+#endif
+	struct timespec now, timeout, finish, done;
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+	int resplen, seconds, n, s;
+
+	n = open_dg(statp, ns, terrno);
+	if (n <= 0)
+		return (n);
 	s = EXT(statp).nssocks[ns];
 #ifndef CANNOT_CONNECT_DGRAM
 	if (send(s, (const char*)buf, (size_t)buflen, 0) != buflen) {
@@ -1174,11 +1425,11 @@ send_dg(res_state statp,
 	 * Wait for reply.
 	 */
 	seconds = get_timeout(statp, ns);
-	now = evNowTime();
+	now = mono_now();
 	timeout = evConsTime((long)seconds, 0L);
 	finish = evAddTime(now, timeout);
 retry:
-	n = retrying_select(s, &dsmask, NULL, &finish);
+	n = retrying_poll(s, POLLIN, &finish);
 
 	if (n == 0) {
 		*rcode = RCODE_TIMEOUT;
@@ -1187,7 +1438,7 @@ retry:
 		return (0);
 	}
 	if (n < 0) {
-		Perror(statp, stderr, "select", errno);
+		Perror(statp, stderr, "poll", errno);
 		res_nclose(statp);
 		return (0);
 	}
@@ -1267,7 +1518,7 @@ retry:
 			ans, (resplen > anssiz) ? anssiz : resplen);
 		goto retry;;
 	}
-	done = evNowTime();
+	done = mono_now();
 	*delay = _res_stats_calculate_rtt(&done, &now);
 	if (anhp->rcode == SERVFAIL ||
 	    anhp->rcode == NOTIMP ||
@@ -1303,6 +1554,373 @@ retry:
 	return (resplen);
 }
 
+/*
+ * How long to give server "ns" before also asking the next one: a couple of
+ * its average round trips, or HEDGE_DEFAULT_MS if it hasn't answered
+ * recently enough to have one, but no longer than its timeout.
+ */
+static struct timespec
+hedge_delay(const res_state statp, struct __res_stats *stats, int ns)
+{
+	int successes, errors, timeouts, internal_errors, rtt_avg;
+	time_t last_sample_time;
+	long ms;
+
+	android_net_res_stats_aggregate(stats, &successes, &errors, &timeouts,
+	    &internal_errors, &rtt_avg, &last_sample_time);
+	ms = (rtt_avg >= 0) ? 2L * rtt_avg : HEDGE_DEFAULT_MS;
+	if (ms < HEDGE_MIN_MS)
+		ms = HEDGE_MIN_MS;
+	if (ms > get_timeout(statp, ns) * 1000L)
+		ms = get_timeout(statp, ns) * 1000L;
+	return (evConsTime(ms / 1000, (ms % 1000) * 1000000L));
+}
+
+static void
+add_sample(const res_state statp, int revision_id,
+	   const struct __res_params *params, int ns, time_t at, int rcode,
+	   int delay)
+{
+	struct __res_sample sample;
+
+	_res_stats_set_sample(&sample, at, rcode, delay);
+	_resolv_cache_add_resolver_stats_sample(statp->netid, revision_id, ns,
+	    &sample, params->max_samples);
+}
+
+/*
+ * Sends every unanswered query to server "ns".  Returns 1 if they were all
+ * sent, 0 if the server should be skipped, or -1 (with *terrno set) if the
+ * queries can't be sent anywhere.
+ */
+static int
+start_dg(res_state statp, struct sendq_state *qs, int nq, int ns,
+	 int *terrno)
+{
+	struct mmsghdr msgs[RES_MAXSENDQ];
+	struct iovec iovs[RES_MAXSENDQ];
+	int which[RES_MAXSENDQ];
+	int i, n, s, nmsgs, sent;
+#ifdef CANNOT_CONNECT_DGRAM
+	const struct sockaddr *nsap = get_nsaddr(statp, (size_t)ns);
+	int nsaplen = get_salen(nsap);
+#endif
+
+	n = open_dg(statp, ns, terrno);
+	if (n <= 0)
+		return (n);
+	s = EXT(statp).nssocks[ns];
+
+	/*
+	 * Send all the unanswered queries with one system call.
+	 */
+	memset(msgs, 0, sizeof(msgs));
+	nmsgs = 0;
+	for (i = 0; i < nq; i++) {
+		if (qs[i].q->resplen > 0)
+			continue;
+		iovs[nmsgs].iov_base = (void *)(uintptr_t)qs[i].q->buf;
+		iovs[nmsgs].iov_len = (size_t)qs[i].q->buflen;
+		msgs[nmsgs].msg_hdr.msg_iov = &iovs[nmsgs];
+		msgs[nmsgs].msg_hdr.msg_iovlen = 1;
+#ifdef CANNOT_CONNECT_DGRAM
+		msgs[nmsgs].msg_hdr.msg_name = (void *)(uintptr_t)nsap;
+		msgs[nmsgs].msg_hdr.msg_namelen = (socklen_t)nsaplen;
+#endif
+		which[nmsgs++] = i;
+	}
+	for (sent = 0; sent < nmsgs; sent += n) {
+		n = sendmmsg(s, &msgs[sent], (unsigned int)(nmsgs - sent), 0);
+		if (n <= 0 ||
+		    msgs[sent].msg_len != (unsigned int)qs[which[sent]].q->buflen) {
+#ifndef CANNOT_CONNECT_DGRAM
+			Perror(statp, stderr, "sendmmsg", errno);
+#else
+			Aerror(statp, stderr, "sendmmsg", errno, nsap, nsaplen);
+#endif
+			close_dg(statp, ns);
+			return (0);
+		}
+		for (i = sent; i < sent + n; i++)
+			qs[which[i]].sent |= 1U << ns;
+	}
+	return (1);
+}
+
+/*
+ * Returns the number of unanswered queries that aren't waiting on any live
+ * server.
+ */
+static int
+stalled(const struct sendq_state *qs, int nq, u_int live)
+{
+	int i, n;
+
+	n = 0;
+	for (i = 0; i < nq; i++) {
+		if (qs[i].q->resplen <= 0 &&
+		    (qs[i].sent & ~qs[i].settled & live) == 0)
+			n++;
+	}
+	return (n);
+}
+
+/*
+ * One try of res_nsendN(): sends the unanswered queries to the first usable
+ * server, and to each following one when the previous one is slow to answer
+ * (see hedge_delay()) or has failed, then takes the first acceptable answer
+ * to each query from any of them.  Each server gets its usual timeout.
+ * Returns the number of queries still unanswered, or -1 (with *terrno set)
+ * on a fatal error.
+ */
+static int
+send_dg_parallel(res_state statp, struct sendq_state *qs, int nq, int try,
+		 int *terrno, int *gotsomewhere)
+{
+	struct __res_stats stats[MAXNS];
+	struct __res_params params;
+	int revision_id = _resolv_cache_get_resolver_stats(statp->netid,
+	    &params, stats);
+	bool usable_servers[MAXNS];
+	int order[MAXNS], nservers, next, pending, i, n, ns, s, nfds;
+	int rcode, delay, ns2;
+	u_int live, bit;
+	time_t at[MAXNS], sample_at;
+	struct timespec start[MAXNS], finish[MAXNS];
+	struct timespec now, hedge, wake;
+	struct pollfd fds[MAXNS];
+	int fdns[MAXNS];
+	HEADER peek;
+	HEADER *anhp;
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+	int resplen;
+
+	android_net_res_stats_get_usable_servers(&params, stats,
+	    statp->nscount, usable_servers);
+	nservers = 0;
+	for (ns = 0; ns < statp->nscount; ns++) {
+		if (usable_servers[ns])
+			order[nservers++] = ns;
+	}
+
+	pending = 0;
+	for (i = 0; i < nq; i++) {
+		qs[i].sent = qs[i].settled = 0;
+		if (qs[i].q->resplen <= 0)
+			pending++;
+	}
+
+	next = 0;
+	live = 0;
+	hedge = mono_now();
+	while (pending > 0) {
+		now = mono_now();
+
+		/*
+		 * Stop waiting for servers that have timed out.
+		 */
+		for (ns = 0; ns < statp->nscount; ns++) {
+			bit = 1U << ns;
+			if ((live & bit) == 0 || evCmpTime(now, finish[ns]) < 0)
+				continue;
+			Dprint(statp->options & RES_DEBUG,
+			       (stdout, ";; timeout\n"));
+			for (i = 0; i < nq; i++) {
+				if (qs[i].q->resplen > 0 ||
+				    (qs[i].sent & ~qs[i].settled & bit) == 0)
+					continue;
+				qs[i].settled |= bit;
+				/* See res_nsend() on recording stats. */
+				if (try == 0)
+					add_sample(statp, revision_id, &params,
+					    ns, at[ns], RCODE_TIMEOUT, 0);
+			}
+			live &= ~bit;
+			*gotsomewhere = 1;
+		}
+
+		/*
+		 * Bring in the next server if the ones we've asked are taking
+		 * too long, or can no longer answer everything.
+		 */
+		if (next < nservers &&
+		    (evCmpTime(now, hedge) >= 0 || stalled(qs, nq, live) > 0)) {
+			ns = order[next++];
+			statp->_flags &= ~RES_F_LASTMASK;
+			statp->_flags |= (ns << RES_F_LASTSHIFT);
+			n = start_dg(statp, qs, nq, ns, terrno);
+			if (n < 0)
+				return (-1);
+			if (n > 0) {
+				live |= 1U << ns;
+				at[ns] = time(NULL);
+				start[ns] = now;
+				finish[ns] = evAddTime(now,
+				    evConsTime((long)get_timeout(statp, ns), 0L));
+			}
+			hedge = evAddTime(now, hedge_delay(statp, &stats[ns], ns));
+			continue;
+		}
+		if (stalled(qs, nq, live) == pending)
+			break;
+
+		/*
+		 * Wait for an answer, the next timeout, or the next hedge.
+		 */
+		wake = (next < nservers) ? hedge : evConsTime(LONG_MAX, 0L);
+		nfds = 0;
+		for (ns = 0; ns < statp->nscount; ns++) {
+			if ((live & (1U << ns)) == 0)
+				continue;
+			if (evCmpTime(finish[ns], wake) < 0)
+				wake = finish[ns];
+			fds[nfds].fd = EXT(statp).nssocks[ns];
+			fds[nfds].events = POLLIN;
+			fds[nfds].revents = 0;
+			fdns[nfds++] = ns;
+		}
+		wake = evSubTime(wake, now);
+		n = ppoll(fds, (nfds_t)nfds, &wake, /*sigmask=*/NULL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			*terrno = errno;
+			Perror(statp, stderr, "poll", errno);
+			return (-1);
+		}
+
+		for (n = 0; n < nfds; n++) {
+			if (fds[n].revents == 0)
+				continue;
+			ns = fdns[n];
+			bit = 1U << ns;
+			s = fds[n].fd;
+
+			/*
+			 * Find the query this answers from its id before
+			 * reading it into that query's answer buffer.
+			 */
+			resplen = recv(s, (char*)&peek, sizeof(peek),
+			    MSG_PEEK | MSG_DONTWAIT);
+			if (resplen < 0 &&
+			    (errno == EAGAIN || errno == EWOULDBLOCK ||
+			     errno == EINTR))
+				continue;
+			if (resplen <= 0) {
+				/* Typically ECONNREFUSED: nobody's there. */
+				Perror(statp, stderr, "recvfrom", errno);
+				for (i = 0; i < nq; i++) {
+					if (qs[i].q->resplen > 0 ||
+					    (qs[i].sent & ~qs[i].settled & bit) == 0)
+						continue;
+					qs[i].settled |= bit;
+					if (try == 0)
+						add_sample(statp, revision_id,
+						    &params, ns, at[ns],
+						    RCODE_INTERNAL_ERROR, 0);
+				}
+				close_dg(statp, ns);
+				live &= ~bit;
+				continue;
+			}
+			*gotsomewhere = 1;
+			for (i = 0; i < nq; i++) {
+				if (qs[i].q->resplen <= 0 &&
+				    (qs[i].sent & ~qs[i].settled & bit) != 0 &&
+				    ((const HEADER *)(const void *)qs[i].q->buf)->id == peek.id)
+					break;
+			}
+			if (resplen < HFIXEDSZ || i == nq) {
+				/*
+				 * Undersized, or a response to an old or
+				 * already answered query: drop it.
+				 */
+				(void) recv(s, (char*)&peek, sizeof(peek),
+				    MSG_DONTWAIT);
+				continue;
+			}
+
+			fromlen = sizeof(from);
+			resplen = recvfrom(s, (char*)qs[i].q->ans,
+			    (size_t)qs[i].q->anssiz, MSG_DONTWAIT,
+			    (struct sockaddr *)(void *)&from, &fromlen);
+			if (resplen < HFIXEDSZ)
+				continue;
+			anhp = (HEADER *)(void *)qs[i].q->ans;
+			if (!(statp->options & RES_INSECURE1) &&
+			    !res_ourserver_p(statp, (struct sockaddr *)(void *)&from)) {
+				/* Response from the wrong server: ignore it. */
+				continue;
+			}
+#ifdef RES_USE_EDNS0
+			if (anhp->rcode == FORMERR &&
+			    (statp->options & RES_USE_EDNS0) != 0U) {
+				/* See send_dg(). */
+				statp->_flags |= RES_F_EDNS0ERR;
+				qs[i].settled |= bit;
+				if (try == 0)
+					add_sample(statp, revision_id, &params,
+					    ns, at[ns], RCODE_INTERNAL_ERROR, 0);
+				continue;
+			}
+#endif
+			if (!(statp->options & RES_INSECURE2) &&
+			    !res_queriesmatch(qs[i].q->buf,
+					      qs[i].q->buf + qs[i].q->buflen,
+					      qs[i].q->ans,
+					      qs[i].q->ans + qs[i].q->anssiz)) {
+				/* Response to the wrong query: ignore it. */
+				continue;
+			}
+			now = mono_now();
+			delay = _res_stats_calculate_rtt(&now, &start[ns]);
+			rcode = anhp->rcode;
+			if ((rcode == SERVFAIL || rcode == NOTIMP ||
+			     rcode == REFUSED) && !statp->pfcode) {
+				DprintQ(statp->options & RES_DEBUG,
+					(stdout, "server rejected query:\n"),
+					qs[i].q->ans, (resplen > qs[i].q->anssiz) ?
+					qs[i].q->anssiz : resplen);
+				qs[i].settled |= bit;
+				if (try == 0)
+					add_sample(statp, revision_id, &params,
+					    ns, at[ns], rcode, delay);
+				continue;
+			}
+			sample_at = at[ns];
+			if (!(statp->options & RES_IGNTC) && anhp->tc) {
+				/*
+				 * To get the rest of the answer, use TCP
+				 * with the same server, as res_nsend() does.
+				 */
+				Dprint(statp->options & RES_DEBUG,
+				       (stdout, ";; truncated answer\n"));
+				resplen = send_vc(statp, qs[i].q->buf,
+				    qs[i].q->buflen, qs[i].q->ans,
+				    qs[i].q->anssiz, terrno, ns, &sample_at,
+				    &rcode, &delay);
+				/* send_vc() may have closed our sockets. */
+				for (ns2 = 0; ns2 < statp->nscount; ns2++) {
+					if (EXT(statp).nssocks[ns2] == -1)
+						live &= ~(1U << ns2);
+				}
+			}
+			if (try == 0)
+				add_sample(statp, revision_id, &params, ns,
+				    sample_at, rcode, delay);
+			qs[i].settled |= bit;
+			if (resplen > 0) {
+				statp->_flags &= ~RES_F_LASTMASK;
+				statp->_flags |= (ns << RES_F_LASTSHIFT);
+				qs[i].q->resplen = resplen;
+				pending--;
+			}
+		}
+	}
+	return (pending);
+}
+
 static void
 Aerror(const res_state statp, FILE *file, const char *string, int error,
        const struct sockaddr *address, int alen)
@@ -1360,29 +1978,3 @@ sock_eq(struct sockaddr *a, struct sockaddr *b) {
 		return 0;
 	}
 }
-
-#ifdef NEED_PSELECT
-/* XXX needs to move to the porting library. */
-static int
-pselect(int nfds, void *rfds, void *wfds, void *efds,
-	struct timespec *tsp, const sigset_t *sigmask)
-{
-	struct timeval tv, *tvp;
-	sigset_t sigs;
-	int n;
-
-	if (tsp) {
-		tvp = &tv;
-		tv = evTimeVal(*tsp);
-	} else
-		tvp = NULL;
-	if (sigmask)
-		sigprocmask(SIG_SETMASK, sigmask, &sigs);
-	n = select(nfds, rfds, wfds, efds, tvp);
-	if (sigmask)
-		sigprocmask(SIG_SETMASK, &sigs, NULL);
-	if (tsp)
-		*tsp = evTimeSpec(tv);
-	return (n);
-}
-#endif
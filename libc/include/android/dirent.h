@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_DIRENT_H
+#define _ANDROID_DIRENT_H
+
+#include <dirent.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+struct android_dirent_record {
+  ino64_t d_ino;
+  unsigned char d_type;
+  /* Valid until the next call on the same DIR. */
+  const char* d_name;
+};
+
+/*
+ * Reads up to 'count' directory entries at once, for callers that walk large
+ * directories and only need each entry's name, type and inode. This is cheaper
+ * than calling readdir(3) for each entry, which takes the DIR's lock every
+ * time. Entries are returned in the same order as readdir would return them,
+ * and the two can be mixed.
+ *
+ * Returns the number of records filled in, 0 at the end of the directory, or
+ * -1 with errno set on error. Fewer than 'count' records doesn't mean the end of
+ * the directory.
+ */
+ssize_t android_readdir_batch(DIR* dir, struct android_dirent_record* records, size_t count)
+    __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
@@ -104,6 +104,61 @@ enum {
    */
   ANDROID_DLEXT_USE_NAMESPACE = 0x200,
 
+  /* This flag asks the linker to start reading the loadable segments of the
+   * library and of every DT_NEEDED library it loads as soon as each file has
+   * been opened. The reads for independent dependencies overlap with each
+   * other and with the rest of the dependency walk instead of being faulted
+   * in one page at a time later. Load, relocation and constructor order are
+   * not affected.
+   */
+  ANDROID_DLEXT_READAHEAD_DEPENDENCIES = 0x400,
+
+  /* When set, dlopen does not run the constructors (DT_INIT and DT_INIT_ARRAY)
+   * of the library and of those of its dependencies that are not initialized
+   * yet. Instead the constructors of a library, and of its dependencies first,
+   * run the first time dlsym returns one of its symbols, or when a later
+   * dlopen without this flag needs the library.
+   *
+   * Only use this for libraries that are entered exclusively through dlsym:
+   * calls made directly through references from other libraries do not run
+   * the deferred constructors.
+   */
+  ANDROID_DLEXT_LAZY_CONSTRUCTORS = 0x800,
+
+  /* This flag asks the linker to place the executable segment of the library
+   * at a 2MB-aligned address and to back the 2MB-aligned part of it with
+   * anonymous transparent huge pages, reducing iTLB misses for very large
+   * libraries. The text then no longer shares page cache with other
+   * processes and is not shown as file-backed in /proc/self/maps, so only
+   * use it for a few hot libraries. If transparent huge pages are disabled
+   * or the segment is too small, the library is loaded as usual.
+   *
+   * When the load address is chosen by the caller (ANDROID_DLEXT_RESERVED_ADDRESS,
+   * ANDROID_DLEXT_FORCE_FIXED_VADDR or ANDROID_DLEXT_LOAD_AT_FIXED_ADDRESS)
+   * it is not changed, and only an already 2MB-aligned part of the text is
+   * remapped.
+   */
+  ANDROID_DLEXT_HUGEPAGE_TEXT = 0x1000,
+
+  /* This flag asks the linker to resolve the PLT (function call) relocations
+   * of the library and of the dependencies it loads on first call rather
+   * than at load time, as RTLD_LAZY does on other systems. A call to a
+   * function that can't be found aborts the process instead of failing
+   * dlopen, so only use it for large libraries most of whose imports are
+   * never called. Other relocations are still processed at load time, and
+   * libraries linked with -z now, those whose GOT is read-only after
+   * relocation, and all libraries on architectures other than arm64 and
+   * x86_64 are bound as usual. The LD_BIND_NOW environment variable
+   * overrides this flag.
+   *
+   * The first call to each imported function goes through the linker, which
+   * takes the same lock as dlopen and dlclose. A signal handler that
+   * interrupts one of those on the same thread would find the linker's state
+   * half updated, so code in these libraries must not be called from signal
+   * handlers.
+   */
+  ANDROID_DLEXT_LAZY_BINDING = 0x2000,
+
   /* Mask of valid bits */
   ANDROID_DLEXT_VALID_FLAG_BITS       = ANDROID_DLEXT_RESERVED_ADDRESS |
                                         ANDROID_DLEXT_RESERVED_ADDRESS_HINT |
@@ -114,7 +169,11 @@ enum {
                                         ANDROID_DLEXT_FORCE_LOAD |
                                         ANDROID_DLEXT_FORCE_FIXED_VADDR |
                                         ANDROID_DLEXT_LOAD_AT_FIXED_ADDRESS |
-                                        ANDROID_DLEXT_USE_NAMESPACE,
+                                        ANDROID_DLEXT_USE_NAMESPACE |
+                                        ANDROID_DLEXT_READAHEAD_DEPENDENCIES |
+                                        ANDROID_DLEXT_LAZY_CONSTRUCTORS |
+                                        ANDROID_DLEXT_HUGEPAGE_TEXT |
+                                        ANDROID_DLEXT_LAZY_BINDING,
 };
 
 struct android_namespace_t;
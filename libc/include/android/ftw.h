@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_FTW_H
+#define _ANDROID_FTW_H
+
+#include <ftw.h>
+#include <sys/cdefs.h>
+#include <sys/stat.h>
+
+__BEGIN_DECLS
+
+/*
+ * For android_nftw_parallel: don't stat entries whose type getdents(2) already
+ * gives. Their callback gets a struct stat with only st_ino and the file type
+ * bits of st_mode filled in. Directories are always stat'ed, and so are symbolic
+ * links unless the walk is physical.
+ */
+#define ANDROID_FTW_NOSTAT 0x100
+
+/*
+ * Like nftw(3), but reads directories in parallel on libc's worker threads (see
+ * <android/work_queue.h>), for walks of large trees on storage where each read
+ * is latency-bound. 'flags' can be FTW_PHYS, FTW_MOUNT and ANDROID_FTW_NOSTAT;
+ * FTW_DEPTH and FTW_CHDIR aren't supported.
+ *
+ * The callback can be called from several threads at once, and entries are
+ * reported in no particular order, except that a directory is always reported
+ * before anything in it. If the callback returns non-zero, no more directories
+ * are read, and that value is returned once the ones already being read are
+ * finished.
+ */
+int android_nftw_parallel(const char* path,
+                          int (*fn)(const char*, const struct stat*, int, struct FTW*),
+                          int flags) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_IO_RING_H
+#define _ANDROID_IO_RING_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/*
+ * A queue of I/O operations that are submitted and completed in batches, so
+ * that a process doing many small reads, writes and syncs makes a few system
+ * calls per batch rather than one per operation. This uses io_uring where the
+ * kernel has it. Otherwise the operations are run synchronously by
+ * android_io_ring_wait, so callers don't need a fallback of their own.
+ *
+ * A ring isn't thread-safe: use one per thread, or lock around it.
+ */
+typedef struct android_io_ring android_io_ring;
+
+enum {
+  ANDROID_IO_READ = 0,      /* pread64(fd, buf, len, offset) */
+  ANDROID_IO_WRITE = 1,     /* pwrite64(fd, buf, len, offset) */
+  ANDROID_IO_FSYNC = 2,     /* fsync(fd) */
+  ANDROID_IO_FDATASYNC = 3, /* fdatasync(fd) */
+  ANDROID_IO_POLL = 4,      /* waits for one of 'poll_events' on fd, like poll(2) */
+};
+
+struct android_io_op {
+  int opcode;
+  int fd;
+  /* For reads and writes, which must stay valid until the operation completes. */
+  void* buf;
+  size_t len;
+  off64_t offset;
+  /* For ANDROID_IO_POLL. */
+  short poll_events;
+  /* Returned unchanged in the operation's completion. */
+  uint64_t user_data;
+};
+
+struct android_io_completion {
+  uint64_t user_data;
+  /*
+   * What the system call would have returned, or -errno on failure. For
+   * ANDROID_IO_POLL, the revents mask.
+   */
+  int result;
+};
+
+/*
+ * Creates a ring that can have up to 'entries' operations in flight. Returns
+ * NULL and sets errno on failure.
+ */
+android_io_ring* android_io_ring_create(unsigned entries) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Frees the ring. Operations still in flight are cancelled or waited for by the
+ * kernel, and their completions are lost.
+ */
+void android_io_ring_destroy(android_io_ring* ring) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Submits up to 'count' operations with a single system call. Returns how many
+ * were submitted, which is fewer than 'count' if the ring is full: reap some
+ * completions with android_io_ring_wait and submit the rest again. Returns -1
+ * and sets errno if none could be submitted: EINVAL for an unknown opcode, EBUSY
+ * if the ring is already full, or the error from io_uring_enter(2).
+ */
+ssize_t android_io_ring_submit(android_io_ring* ring, const struct android_io_op* ops,
+                               size_t count) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Copies up to 'count' completions into 'completions', waiting until at least
+ * 'min_count' are available or nothing else is in flight. Completions come in
+ * the order the operations finished, not the order they were submitted. Returns
+ * the number copied, or -1 and sets errno if the wait failed before any were.
+ */
+ssize_t android_io_ring_wait(android_io_ring* ring, struct android_io_completion* completions,
+                             size_t count, size_t min_count) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
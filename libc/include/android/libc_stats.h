@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_LIBC_STATS_H
+#define _ANDROID_LIBC_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Counters kept by libc and the dynamic linker for the whole process since it
+ * started, including threads that have exited. Each thread counts its own
+ * events without synchronizing with any other, so the totals read while
+ * other threads are running may be a few events behind.
+ */
+struct android_libc_stats {
+  /* pthread_mutex_lock and pthread_mutex_timedlock calls that found the mutex held and had to wait. */
+  uint64_t mutex_contentions;
+  /* Times a thread slept in the kernel waiting on a libc lock, condition variable, semaphore, barrier or pthread_join. */
+  uint64_t futex_waits;
+  /* Writes of a stdio buffer to a file descriptor. */
+  uint64_t stdio_flushes;
+  /* Calls to malloc, calloc, realloc, memalign, posix_memalign, pvalloc and valloc. */
+  uint64_t malloc_calls;
+  /* Calls to free. */
+  uint64_t free_calls;
+  /* Calls to dlopen and android_dlopen_ext, whether they succeed or not, and the time spent in them. */
+  uint64_t dlopen_calls;
+  uint64_t dlopen_time_ns;
+  /* Calls to dlsym, dlvsym and the other symbol lookup functions, and the time spent in them. */
+  uint64_t dlsym_calls;
+  uint64_t dlsym_time_ns;
+  /* DNS queries answered from, or missing from, the resolver's cache. */
+  uint64_t resolver_cache_hits;
+  uint64_t resolver_cache_misses;
+  /* System property lookups by name, including those made by __system_property_get. */
+  uint64_t property_lookups;
+};
+
+/*
+ * Fills in the first 'size' bytes of '*stats', which should normally be
+ * sizeof(struct android_libc_stats). Fields added to the structure later go
+ * at the end, so callers built against this version keep working. Returns the
+ * size of the structure libc knows about.
+ *
+ * The dlopen and dlsym times are only measured once this function has been
+ * called, so that processes nobody samples don't pay for reading the clock.
+ */
+size_t android_libc_get_stats(struct android_libc_stats* stats, size_t size) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_MOUNT_TABLE_H
+#define _ANDROID_MOUNT_TABLE_H
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/* One line of /proc/self/mountinfo. See proc(5) for what each field means. */
+struct android_mount_entry {
+  unsigned mount_id;
+  unsigned parent_id;
+  dev_t dev;
+  const char* root;
+  const char* mount_point;
+  const char* mount_options;
+  /* The optional fields ("shared:1 master:2"), or "" if there are none. */
+  const char* propagation;
+  const char* fs_type;
+  const char* source;
+  const char* super_options;
+};
+
+/*
+ * A snapshot of the calling process' mount table, for callers that look at it
+ * often. Unlike getmntent(3), which parses /proc/mounts a line at a time with
+ * every call, the table is read and parsed once into memory owned by the
+ * snapshot, and android_mount_table_refresh only reads it again if the kernel
+ * says it has changed. Looking at the entries doesn't allocate or copy.
+ *
+ * Escaped characters in paths ("\040" for a space) are unescaped.
+ */
+typedef struct android_mount_table android_mount_table;
+
+/* Returns NULL with errno set on failure. */
+android_mount_table* android_mount_table_open(void) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Rereads the table if a mount or unmount in this mount namespace has happened
+ * since it was last read, without blocking. Returns 1 if it was reread, 0 if
+ * it was unchanged, or -1 with errno set on failure, in which case the old
+ * entries are still valid. Entries and strings from before a successful reread
+ * are invalidated.
+ */
+int android_mount_table_refresh(android_mount_table* table) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Returns the file descriptor for /proc/self/mountinfo, which the caller can
+ * poll(2) or epoll(7) for POLLPRI to wait for the table to change. The caller
+ * mustn't read it or close it.
+ */
+int android_mount_table_fd(const android_mount_table* table) __INTRODUCED_IN_FUTURE;
+
+/* Returns the entries in mount order, storing their number in '*count'. */
+const struct android_mount_entry* android_mount_table_entries(const android_mount_table* table,
+                                                              size_t* count)
+    __INTRODUCED_IN_FUTURE;
+
+/*
+ * Returns the entry for the mount that 'path' is on, or NULL if there isn't
+ * one. 'path' should be absolute and canonical (see realpath(3)); this only
+ * compares it with the mount points.
+ */
+const struct android_mount_entry* android_mount_table_find(const android_mount_table* table,
+                                                           const char* path)
+    __INTRODUCED_IN_FUTURE;
+
+void android_mount_table_close(android_mount_table* table) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
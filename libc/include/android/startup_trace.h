@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_STARTUP_TRACE_H
+#define _ANDROID_STARTUP_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * When a process is started with LIBC_STARTUP_TRACE=1 in its environment, the
+ * dynamic linker and libc take a CLOCK_MONOTONIC timestamp at the end of each of
+ * their initialization phases, up to the call to main. The environment variable
+ * is ignored for AT_SECURE processes.
+ */
+struct android_startup_phase {
+  /* Names the phase that just finished, such as "linker_libraries" or "main". */
+  const char* name;
+  /* CLOCK_MONOTONIC, in nanoseconds. */
+  int64_t time_ns;
+};
+
+/*
+ * Copies up to 'count' of the recorded phases, in order, into 'phases'. Returns
+ * the number of phases recorded, which is 0 if the process wasn't traced.
+ */
+size_t android_get_startup_phases(struct android_startup_phase* phases, size_t count)
+    __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
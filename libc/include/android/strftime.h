@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_STRFTIME_H
+#define _ANDROID_STRFTIME_H
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+#include <time.h>
+
+__BEGIN_DECLS
+
+/*
+ * Formats times like strftime(3), but with the format parsed once up front, for
+ * callers that format a lot of times the same way (log timestamps, say). Common
+ * numeric fields such as those in "%Y-%m-%d %H:%M:%S" are written directly; the
+ * output is always the same as strftime's for the same format and time.
+ */
+typedef struct android_strftime_plan android_strftime_plan;
+
+/* Returns NULL with errno set if out of memory. A NULL format means "%c", as for strftime. */
+android_strftime_plan* android_strftime_compile(const char* format) __INTRODUCED_IN_FUTURE;
+/* Returns the same as strftime(s, max, format, tm) for the plan's format. */
+size_t android_strftime_format(char* s, size_t max, const android_strftime_plan* plan,
+                               const struct tm* tm) __INTRODUCED_IN_FUTURE;
+void android_strftime_plan_free(android_strftime_plan* plan) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _ANDROID_WORK_QUEUE_H
+#define _ANDROID_WORK_QUEUE_H
+
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Runs functions on libc's own pool of worker threads, which it also uses for its
+ * internal parallel work. The workers are only started the first time work is
+ * submitted, so processes that never use this don't pay for it.
+ *
+ * Work is always submitted as part of a group, which can be waited for. If the
+ * work can't be queued, for example because the workers couldn't be started,
+ * android_work_group_submit runs it on the calling thread before returning.
+ *
+ * Work functions shouldn't block for long, since that holds up everyone else
+ * sharing the pool. A child of fork has no workers until it submits work; work
+ * that was running in the parent when it forked never finishes in the child.
+ */
+typedef struct android_work_group android_work_group;
+
+/* Returns NULL if out of memory. */
+android_work_group* android_work_group_create(void) __INTRODUCED_IN_FUTURE;
+void android_work_group_submit(android_work_group* group, void (*fn)(void*), void* arg)
+    __INTRODUCED_IN_FUTURE;
+/* Waits for all work submitted to the group so far, helping to run queued work meanwhile. */
+void android_work_group_wait(android_work_group* group) __INTRODUCED_IN_FUTURE;
+/* Waits for the group's work like android_work_group_wait, then frees the group. */
+void android_work_group_destroy(android_work_group* group) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif
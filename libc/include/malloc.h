@@ -19,6 +19,7 @@
 
 #include <sys/cdefs.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 __BEGIN_DECLS
@@ -68,11 +69,20 @@ struct mallinfo mallinfo(void);
  *     <allocated-large>INT</allocated-large>
  *     <allocated-huge>INT</allocated-huge>
  *     <allocated-bins>INT</allocated-bins>
+ *     <active>INT</active>
+ *     <dirty>INT</dirty>
+ *     <mapped>INT</mapped>
+ *     <retained>INT</retained>
  *     <bins-total>INT</bins-total>
  *     <bin nr="INT">
+ *       <size>INT</size>
  *       <allocated>INT</allocated>
  *       <nmalloc>INT</nmalloc>
  *       <ndalloc>INT</ndalloc>
+ *       <regions>INT</regions>
+ *       <capacity>INT</capacity>
+ *       <nfills>INT</nfills>
+ *       <nflushes>INT</nflushes>
  *     </bin>
  *     <!-- more bins -->
  *   </heap>
@@ -81,8 +91,107 @@ struct mallinfo mallinfo(void);
  */
 int malloc_info(int, FILE*) __INTRODUCED_IN(23);
 
+/*
+ * The same per-arena and per-bin statistics as malloc_info(3), without
+ * formatting or parsing XML. All sizes are in bytes.
+ */
+struct malloc_arena_stats {
+  size_t allocated_large;
+  size_t allocated_huge;
+  size_t allocated_bins;
+  size_t active;    /* Pages in use by allocations. */
+  size_t dirty;     /* Unused pages that have not been returned to the kernel yet. */
+  size_t mapped;
+  size_t retained;  /* Unmapped virtual memory kept for reuse, 0 if not tracked. */
+  size_t huge_page; /* Memory advised to use transparent huge pages (see M_HUGE_PAGE_THRESHOLD). */
+};
+
+struct malloc_bin_stats {
+  size_t size;      /* The size of every region in this bin. */
+  size_t allocated;
+  uint64_t nmalloc;
+  uint64_t ndalloc;
+  size_t regions;   /* Regions currently allocated, including those in thread caches. */
+  size_t capacity;  /* Regions in the runs currently owned by this bin. */
+  uint64_t nfills;  /* Thread cache fills from this bin. */
+  uint64_t nflushes;
+};
+
+/*
+ * Takes a new snapshot of the statistics and returns the number of arenas
+ * in it. Call this once per poll, then read each arena.
+ */
+size_t malloc_stats_narenas(void) __INTRODUCED_IN_FUTURE;
+/* Returns the number of bins of every arena. */
+size_t malloc_stats_nbins(void) __INTRODUCED_IN_FUTURE;
+/* Returns 0 on success, or -1 and sets errno to EINVAL for an invalid arena. */
+int malloc_stats_arena(size_t arena, struct malloc_arena_stats* stats) __INTRODUCED_IN_FUTURE;
+/*
+ * Fills in up to bin_count bins of the arena. Returns the number of bins
+ * written, or -1 and sets errno to EINVAL for an invalid arena.
+ */
+int malloc_stats_bins(size_t arena, struct malloc_bin_stats* bins, size_t bin_count)
+    __INTRODUCED_IN_FUTURE;
+
+/*
+ * Flushes the calling thread's cache and returns the unused dirty pages of
+ * every arena to the kernel, for use when the process is asked to trim its
+ * memory. Returns the number of bytes released, or 0 if the allocator keeps
+ * no statistics. Other threads' caches are only flushed by those threads
+ * (see M_THREAD_CACHE_FLUSH).
+ */
+size_t malloc_purge(void) __INTRODUCED_IN_FUTURE;
+
 /* mallopt options */
 #define M_DECAY_TIME -100
+/*
+ * Flush the calling thread's cache and return unused dirty pages of all
+ * arenas to the kernel. The value is ignored. See also malloc_purge.
+ */
+#define M_PURGE -101
+/*
+ * Bind the calling thread to the arena with the given index. A negative
+ * value creates a new arena dedicated to the calling thread.
+ */
+#define M_THREAD_ARENA -102
+/* Enable (1) or flush and disable (0) the calling thread's cache. */
+#define M_THREAD_CACHE -103
+/* Flush the calling thread's cache. The value is ignored. */
+#define M_THREAD_CACHE_FLUSH -104
+/*
+ * Bind the calling thread to an arena shared by all threads bound to the
+ * same NUMA node, so that memory freed by one is reused by the others
+ * rather than by threads on another node. A negative value means the node
+ * the calling thread is running on now; the caller should have restricted
+ * its affinity to that node first.
+ */
+#define M_THREAD_ARENA_NODE -105
+/*
+ * Call malloc_purge from a background thread whenever tasks in the system
+ * have been stalled waiting for memory for at least the given number of
+ * milliseconds in a two second window, as reported by the kernel's pressure
+ * stall information (/proc/pressure/memory). Each purge is logged with the
+ * number of bytes released. Zero stops purging on pressure. Fails if the
+ * kernel doesn't support pressure stall triggers.
+ */
+#define M_PURGE_ON_MEMORY_PRESSURE -106
+/*
+ * Advise the kernel to back chunks of memory of at least the given number of
+ * bytes, which must be at least 2MiB, with transparent huge pages. This
+ * affects chunks obtained from now on; zero stops advising by size.
+ */
+#define M_HUGE_PAGE_THRESHOLD -107
+/*
+ * Advise huge pages for all chunks of at least 2MiB obtained from now on by
+ * the arena with the given index, or by the calling thread's arena if the
+ * value is negative (see M_THREAD_ARENA).
+ */
+#define M_HUGE_PAGE_ARENA -108
+/*
+ * Stop advising huge pages once this many MiB of memory are advised, to
+ * bound the extra RSS they can cost. There's no limit by default.
+ */
+#define M_HUGE_PAGE_LIMIT -109
 
 int mallopt(int, int) __INTRODUCED_IN(26);
 
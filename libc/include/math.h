@@ -366,6 +366,26 @@ void sincosf(float, float*, float*);
 void sincosl(long double, long double*, long double*);
 #endif
 
+/*
+ * libm also has vector variants of these functions, named as the x86-64 and
+ * AArch64 vector function ABIs require. Telling GCC about them lets it
+ * vectorize loops that call the functions, but the variants are only accurate
+ * to a few ulp, so as with glibc this is only done for -ffast-math.
+ */
+#if __ANDROID_API__ >= __ANDROID_API_FUTURE__ && defined(__FAST_MATH__) && \
+    !defined(__clang__) && (defined(__x86_64__) || defined(__aarch64__))
+#define __BIONIC_MATH_SIMD __attribute__((__simd__("notinbranch")))
+double cos(double) __BIONIC_MATH_SIMD;
+float cosf(float) __BIONIC_MATH_SIMD;
+double exp(double) __BIONIC_MATH_SIMD;
+float expf(float) __BIONIC_MATH_SIMD;
+double log(double) __BIONIC_MATH_SIMD;
+float logf(float) __BIONIC_MATH_SIMD;
+double sin(double) __BIONIC_MATH_SIMD;
+float sinf(float) __BIONIC_MATH_SIMD;
+#undef __BIONIC_MATH_SIMD
+#endif
+
 __END_DECLS
 
 #endif /* !_MATH_H_ */
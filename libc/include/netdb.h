@@ -215,7 +215,11 @@ struct netent* getnetbyname(const char*);
 struct protoent* getprotobyname(const char*);
 struct protoent* getprotobynumber(int);
 struct servent* getservbyname(const char*, const char*);
+int getservbyname_r(const char*, const char*, struct servent*, char*, size_t, struct servent**)
+  __INTRODUCED_IN_FUTURE;
 struct servent* getservbyport(int, const char*);
+int getservbyport_r(int, const char*, struct servent*, char*, size_t, struct servent**)
+  __INTRODUCED_IN_FUTURE;
 struct servent* getservent(void);
 void herror(const char*);
 const char* hstrerror(int);
@@ -227,6 +231,22 @@ void freeaddrinfo(struct addrinfo*);
 const char* gai_strerror(int);
 void setservent(int);
 
+/*
+ * Asynchronous getaddrinfo, for event loops. android_getaddrinfo_start starts a lookup
+ * and returns a file descriptor that becomes readable once the result is available, or
+ * -1 and sets errno if the lookup couldn't be started. Pass the file descriptor to
+ * android_getaddrinfo_result to get the result, which waits for it if it isn't ready
+ * yet, or to android_getaddrinfo_cancel to abandon the lookup. Either closes it, and
+ * it mustn't be closed any other way.
+ *
+ * In processes that look names up themselves rather than through netd, the lookup is
+ * done before android_getaddrinfo_start returns.
+ */
+int android_getaddrinfo_start(const char*, const char*, const struct addrinfo*)
+  __INTRODUCED_IN_FUTURE;
+int android_getaddrinfo_result(int, struct addrinfo**) __INTRODUCED_IN_FUTURE;
+void android_getaddrinfo_cancel(int) __INTRODUCED_IN_FUTURE;
+
 __END_DECLS
 
 #endif /* !_NETDB_H_ */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _NUMAIF_H_
+#define _NUMAIF_H_
+
+/*
+ * The NUMA memory policy system calls, with the same declarations as libnuma's <numaif.h>.
+ * See mbind(2), set_mempolicy(2), get_mempolicy(2) and move_pages(2). Node masks are arrays of
+ * unsigned long with one bit per node, of which the kernel reads maxnode bits.
+ */
+
+#include <sys/cdefs.h>
+
+#include <linux/mempolicy.h>
+
+__BEGIN_DECLS
+
+long mbind(void* addr, unsigned long len, int mode, const unsigned long* nodemask,
+           unsigned long maxnode, unsigned flags) __INTRODUCED_IN_FUTURE;
+long set_mempolicy(int mode, const unsigned long* nodemask, unsigned long maxnode)
+    __INTRODUCED_IN_FUTURE;
+long get_mempolicy(int* mode, unsigned long* nodemask, unsigned long maxnode, void* addr,
+                   unsigned long flags) __INTRODUCED_IN_FUTURE;
+long move_pages(int pid, unsigned long count, void** pages, const int* nodes, int* status,
+                int flags) __INTRODUCED_IN_FUTURE;
+
+__END_DECLS
+
+#endif /* _NUMAIF_H_ */
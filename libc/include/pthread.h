@@ -47,6 +47,8 @@ enum {
     PTHREAD_MUTEX_NORMAL = 0,
     PTHREAD_MUTEX_RECURSIVE = 1,
     PTHREAD_MUTEX_ERRORCHECK = 2,
+    /* Like PTHREAD_MUTEX_NORMAL, but spins briefly before sleeping when contended. */
+    PTHREAD_MUTEX_ADAPTIVE_NP = 3,
 
     PTHREAD_MUTEX_ERRORCHECK_NP = PTHREAD_MUTEX_ERRORCHECK,
     PTHREAD_MUTEX_RECURSIVE_NP  = PTHREAD_MUTEX_RECURSIVE,
@@ -57,6 +59,7 @@ enum {
 #define PTHREAD_MUTEX_INITIALIZER { { ((PTHREAD_MUTEX_NORMAL & 3) << 14) } }
 #define PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP { { ((PTHREAD_MUTEX_RECURSIVE & 3) << 14) } }
 #define PTHREAD_ERRORCHECK_MUTEX_INITIALIZER_NP { { ((PTHREAD_MUTEX_ERRORCHECK & 3) << 14) } }
+#define PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP { { ((PTHREAD_MUTEX_ADAPTIVE_NP & 3) << 14) } }
 
 #define PTHREAD_COND_INITIALIZER  { { 0 } }
 
@@ -65,6 +68,14 @@ enum {
 enum {
   PTHREAD_RWLOCK_PREFER_READER_NP = 0,
   PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP = 1,
+  /*
+   * Readers update a per-thread shard instead of the shared lock word, so
+   * read locks scale with the number of readers; writers pay for this by
+   * waiting for every shard to drain, and new readers wait for a writer
+   * that is waiting, so a thread must not take a read lock it already holds.
+   * Only for process-private rwlocks.
+   */
+  PTHREAD_RWLOCK_SCALABLE_READERS_NP = 2,
 };
 
 #define PTHREAD_ONCE_INIT 0
@@ -85,6 +96,10 @@ enum {
 #define PTHREAD_PROCESS_PRIVATE  0
 #define PTHREAD_PROCESS_SHARED   1
 
+#define PTHREAD_PRIO_NONE     0
+#define PTHREAD_PRIO_INHERIT  1
+#define PTHREAD_PRIO_PROTECT  2
+
 #define PTHREAD_SCOPE_SYSTEM     0
 #define PTHREAD_SCOPE_PROCESS    1
 
@@ -146,9 +161,12 @@ int pthread_key_create(pthread_key_t* _Nonnull, void (*)(void*));
 int pthread_key_delete(pthread_key_t);
 
 int pthread_mutexattr_destroy(pthread_mutexattr_t* _Nonnull);
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t* _Nonnull, int* _Nonnull)
+  __INTRODUCED_IN_FUTURE;
 int pthread_mutexattr_getpshared(const pthread_mutexattr_t* _Nonnull, int* _Nonnull);
 int pthread_mutexattr_gettype(const pthread_mutexattr_t* _Nonnull, int* _Nonnull);
 int pthread_mutexattr_init(pthread_mutexattr_t* _Nonnull);
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t* _Nonnull, int) __INTRODUCED_IN_FUTURE;
 int pthread_mutexattr_setpshared(pthread_mutexattr_t* _Nonnull, int);
 int pthread_mutexattr_settype(pthread_mutexattr_t* _Nonnull, int);
 
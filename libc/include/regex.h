@@ -66,6 +66,7 @@ typedef struct {
 #define	REG_NEWLINE	0010
 #define	REG_NOSPEC	0020
 #define	REG_PEND	0040
+#define	REG_LINEAR	0100	/* match in linear time; no back references */
 #define	REG_DUMP	0200
 
 /* regerror() flags */
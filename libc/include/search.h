@@ -24,9 +24,28 @@ typedef struct node {
   char* key;
   struct node* llink;
   struct node* rlink;
+  int height;
 } node_t;
 #endif
 
+typedef struct entry {
+  char* key;
+  void* data;
+} ENTRY;
+
+typedef enum {
+  FIND,
+  ENTER
+} ACTION;
+
+#if defined(__USE_GNU)
+struct hsearch_data {
+  struct __hsearch* __hsearch;
+  unsigned int __unused1;
+  unsigned int __unused2;
+};
+#endif
+
 __BEGIN_DECLS
 
 void insque(void*, void*) __INTRODUCED_IN(21);
@@ -44,6 +63,20 @@ void* tfind(const void*, void* const*, int (*)(const void*, const void*)) __INTR
 void* tsearch(const void*, void**, int (*)(const void*, const void*)) __INTRODUCED_IN(16);
 void twalk(const void*, void (*)(const void*, VISIT, int)) __INTRODUCED_IN(21);
 
+/*
+ * The hash table grows as needed, so hcreate's size is only a hint. That means an
+ * ENTRY* returned by hsearch is only valid until the next ENTER of a new key.
+ */
+int hcreate(size_t) __INTRODUCED_IN_FUTURE;
+void hdestroy(void) __INTRODUCED_IN_FUTURE;
+ENTRY* hsearch(ENTRY, ACTION) __INTRODUCED_IN_FUTURE;
+
+#if defined(__USE_GNU)
+int hcreate_r(size_t, struct hsearch_data*) __INTRODUCED_IN_FUTURE;
+void hdestroy_r(struct hsearch_data*) __INTRODUCED_IN_FUTURE;
+int hsearch_r(ENTRY, ACTION, ENTRY**, struct hsearch_data*) __INTRODUCED_IN_FUTURE;
+#endif
+
 __END_DECLS
 
 #endif /* !_SEARCH_H_ */
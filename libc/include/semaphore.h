@@ -52,7 +52,10 @@ int sem_timedwait(sem_t*, const struct timespec*);
 int sem_trywait(sem_t*);
 int sem_wait(sem_t*);
 
-/* These aren't actually implemented. */
+/*
+ * Named semaphores live in /dev/shm, which must be a tmpfs; without it,
+ * sem_open fails with ENOSYS.
+ */
 sem_t* sem_open(const char*, int, ...);
 int sem_close(sem_t*);
 int sem_unlink(const char*);
@@ -70,6 +70,15 @@ typedef int sig_atomic_t;
 #define _NSIG (_KERNEL__NSIG + 1)
 #define NSIG _NSIG
 
+/*
+ * Android extension: a sigev_notify value for timer_create() that's like SIGEV_THREAD,
+ * except that the notifications are run by one of a few threads shared by all such
+ * timers, rather than by a thread of the timer's own. A timer's notifications still
+ * never run concurrently with one another, but one that blocks delays those of other
+ * timers sharing its thread. sigev_notify_attributes is ignored.
+ */
+#define SIGEV_ANDROID_SHARED_THREAD (SIGEV_THREAD | 0x1000)
+
 /* The kernel headers define SIG_DFL (0) and SIG_IGN (1) but not SIG_HOLD, since
  * SIG_HOLD is only used by the deprecated SysV signal API.
  */
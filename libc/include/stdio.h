@@ -136,6 +136,19 @@ int	 getchar(void);
 ssize_t getdelim(char** __restrict, size_t* __restrict, int, FILE* __restrict) __INTRODUCED_IN(18);
 ssize_t getline(char** __restrict, size_t* __restrict, FILE* __restrict) __INTRODUCED_IN(18);
 
+/*
+ * Like getdelim, but sets *line to point at the line instead of always copying it into *buf.
+ * If the whole line is already in fp's buffer, *line points there, and the line isn't
+ * NUL-terminated. Otherwise the line is copied into *buf as getdelim would, and *line
+ * points at *buf. Either way, the line is only valid until the next operation on fp
+ * or on *buf, so other threads using fp have to be kept out with flockfile until the
+ * caller is done with it. Returns the length of the line, including the delimiter if
+ * there was one, or -1 at end of file or on error.
+ */
+ssize_t getdelim_view(const char** __restrict line, char** __restrict buf,
+                      size_t* __restrict buf_size, int delim, FILE* __restrict fp)
+    __INTRODUCED_IN_FUTURE;
+
 void	 perror(const char *);
 int	 printf(const char * __restrict _Nonnull, ...) __printflike(1, 2);
 int	 putc(int, FILE *);
@@ -244,6 +257,18 @@ int putchar_unlocked(int);
 FILE* fmemopen(void*, size_t, const char*) __INTRODUCED_IN(23);
 FILE* open_memstream(char**, size_t*) __INTRODUCED_IN(23);
 
+/*
+ * Opens a write-only stream like open_memstream, but keeps what's written in a list
+ * of separate chunks, so that growing it never moves or copies what's already there.
+ * iovstream_getiov flushes the stream, points *iov at the chunks in a form suitable
+ * for writev or sendmsg, and returns the total size, or -1 on error. There may be
+ * more than IOV_MAX chunks. The chunks are freed by fclose, and the array is only
+ * valid until the next write to the stream.
+ */
+struct iovec;
+FILE* open_iovstream(void) __INTRODUCED_IN_FUTURE;
+ssize_t iovstream_getiov(FILE* fp, const struct iovec** iov, int* iovcnt) __INTRODUCED_IN_FUTURE;
+
 #if defined(__USE_BSD) || defined(__BIONIC__) /* Historically bionic exposed these. */
 int  asprintf(char** __restrict, const char* __restrict _Nonnull, ...) __printflike(2, 3);
 char* fgetln(FILE* __restrict, size_t* __restrict);
@@ -91,6 +91,9 @@ void* bsearch(const void* key, const void* base0, size_t nmemb, size_t size,
               int (*compar)(const void*, const void*));
 
 void qsort(void*, size_t, size_t, int (*)(const void*, const void*));
+/* Like qsort, but passes its last argument through to each call of the comparator. */
+void qsort_r(void*, size_t, size_t, int (*)(const void*, const void*, void*), void*)
+    __INTRODUCED_IN_FUTURE;
 
 uint32_t arc4random(void);
 uint32_t arc4random_uniform(uint32_t);
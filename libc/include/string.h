@@ -170,13 +170,25 @@ struct __bionic_zero_size_is_okay_t {};
 __BIONIC_FORTIFY_INLINE
 void* memcpy(void* _Nonnull __restrict const dst __pass_object_size0,
         const void* _Nonnull __restrict src, size_t copy_amount) __overloadable {
-    return __builtin___memcpy_chk(dst, src, copy_amount, __bos0(dst));
+    size_t bos = __bos0(dst);
+
+    if (__bos_trivially_ge(bos, copy_amount)) {
+        return __builtin_memcpy(dst, src, copy_amount);
+    }
+
+    return __builtin___memcpy_chk(dst, src, copy_amount, bos);
 }
 
 __BIONIC_FORTIFY_INLINE
 void* memmove(void* const _Nonnull dst __pass_object_size0,
         const void* _Nonnull src, size_t len) __overloadable {
-    return __builtin___memmove_chk(dst, src, len, __bos0(dst));
+    size_t bos = __bos0(dst);
+
+    if (__bos_trivially_ge(bos, len)) {
+        return __builtin_memmove(dst, src, len);
+    }
+
+    return __builtin___memmove_chk(dst, src, len, bos);
 }
 #endif /* __ANDROID_API__ >= __ANDROID_API_J_MR1__ */
 
@@ -184,7 +196,13 @@ void* memmove(void* const _Nonnull dst __pass_object_size0,
 __BIONIC_FORTIFY_INLINE
 char* stpcpy(char* _Nonnull __restrict const dst __pass_object_size,
         const char* _Nonnull __restrict src) __overloadable {
-    return __builtin___stpcpy_chk(dst, src, __bos(dst));
+    size_t bos = __bos(dst);
+
+    if (__bos_trivially_gt(bos, __builtin_strlen(src))) {
+        return __builtin_stpcpy(dst, src);
+    }
+
+    return __builtin___stpcpy_chk(dst, src, bos);
 }
 #endif /* __ANDROID_API__ >= __ANDROID_API_L__ */
 
@@ -192,7 +210,13 @@ char* stpcpy(char* _Nonnull __restrict const dst __pass_object_size,
 __BIONIC_FORTIFY_INLINE
 char* strcpy(char* _Nonnull __restrict const dst __pass_object_size,
         const char* _Nonnull __restrict src) __overloadable {
-    return __builtin___strcpy_chk(dst, src, __bos(dst));
+    size_t bos = __bos(dst);
+
+    if (__bos_trivially_gt(bos, __builtin_strlen(src))) {
+        return __builtin_strcpy(dst, src);
+    }
+
+    return __builtin___strcpy_chk(dst, src, bos);
 }
 
 __BIONIC_FORTIFY_INLINE
@@ -210,7 +234,13 @@ char* strncat(char* const _Nonnull __restrict dst __pass_object_size,
 __BIONIC_FORTIFY_INLINE
 void* memset(void* const _Nonnull s __pass_object_size0, int c, size_t n)
         __overloadable {
-    return __builtin___memset_chk(s, c, n, __bos0(s));
+    size_t bos = __bos0(s);
+
+    if (__bos_trivially_ge(bos, n)) {
+        return __builtin_memset(s, c, n);
+    }
+
+    return __builtin___memset_chk(s, c, n, bos);
 }
 #endif /* __ANDROID_API__ >= __ANDROID_API_J_MR1__ */
 
@@ -252,7 +282,7 @@ void* memchr(const void* const _Nonnull s __pass_object_size, int c, size_t n)
         __overloadable {
     size_t bos = __bos(s);
 
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
+    if (__bos_trivially_ge(bos, n)) {
         return __builtin_memchr(s, c, n);
     }
 
@@ -264,7 +294,7 @@ void* memrchr(const void* const _Nonnull s __pass_object_size, int c, size_t n)
         __overloadable {
     size_t bos = __bos(s);
 
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
+    if (__bos_trivially_ge(bos, n)) {
         return __call_bypassing_fortify(memrchr)(s, c, n);
     }
 
@@ -310,7 +340,7 @@ size_t strlcpy(char* const _Nonnull __restrict dst __pass_object_size,
         const char *_Nonnull __restrict src, size_t size) __overloadable {
     size_t bos = __bos(dst);
 
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
+    if (__bos_trivially_ge(bos, size)) {
         return __call_bypassing_fortify(strlcpy)(dst, src, size);
     }
 
@@ -322,7 +352,7 @@ size_t strlcat(char* const _Nonnull __restrict dst __pass_object_size,
         const char* _Nonnull __restrict src, size_t size) __overloadable {
     size_t bos = __bos(dst);
 
-    if (bos == __BIONIC_FORTIFY_UNKNOWN_SIZE) {
+    if (__bos_trivially_ge(bos, size)) {
         return __call_bypassing_fortify(strlcat)(dst, src, size);
     }
 
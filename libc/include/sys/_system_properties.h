@@ -45,6 +45,14 @@ __BEGIN_DECLS
 
 #define PROP_MSG_SETPROP 1
 #define PROP_MSG_SETPROP2 0x00020001
+/*
+** Sets several properties in one request: a uint32_t count follows the
+** command, then each name and value as a length-prefixed string. The service
+** applies them in order, stops at the first failure, and sends a single
+** PROP_SUCCESS or PROP_ERROR_* reply. Only services that advertise protocol
+** version 3 or later in ro.property_service.version accept it.
+*/
+#define PROP_MSG_SETPROP_BATCH 0x00030001
 
 #define PROP_SUCCESS 0
 #define PROP_ERROR_READ_CMD 0x0004
@@ -129,6 +137,43 @@ uint32_t __system_property_serial(const prop_info* pi);
  */
 int __system_properties_init();
 
+/* Returns the version of the protocol the property service speaks, which
+** is 1 if it doesn't advertise one. Callers that need a feature of a newer
+** protocol can use this to fall back.
+*/
+uint32_t __system_property_service_protocol_version();
+
+/* Sets each keys[i] to values[i] (null meaning the empty string), in order.
+** With protocol version 3 or later this is a single request and reply on
+** one connection. With an older property service, it falls back to one
+** __system_property_set call per property.
+**
+** Returns 0 if every property was set, -1 otherwise. Properties before the
+** one that failed may already have been set.
+*/
+int __system_property_set_many(const char* const keys[], const char* const values[],
+                               size_t count);
+
+/* What this process has mapped of the property areas. */
+struct prop_area_stats {
+  /* The number of property areas mapped, including the serial area. */
+  size_t areas_mapped;
+  /* The size of those mappings, and of the context lookup trie if mapped. */
+  size_t bytes_mapped;
+  /* How much of the property areas is resident in this process, as reported by mincore. */
+  size_t bytes_resident;
+  /* How much of the property areas is actually in use. */
+  size_t bytes_used;
+};
+
+/* Fills in `*stats` with this process' property mappings. Contexts
+** are mapped on first access, so this only counts the ones this process
+** has used.
+**
+** Returns 0 on success, -1 if the property areas aren't initialized.
+*/
+int __system_property_area_stats(struct prop_area_stats* stats);
+
 /* Deprecated: use __system_property_wait instead. */
 uint32_t __system_property_wait_any(uint32_t old_serial);
 
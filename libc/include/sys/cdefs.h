@@ -262,6 +262,18 @@
 
 #define __BIONIC_FORTIFY_UNKNOWN_SIZE ((size_t) -1)
 
+/*
+ * True if a check of `bos_val` against `index` can be left out entirely: either
+ * the object size isn't known, or both are known at compile-time and the access
+ * is in bounds. FORTIFY'ed functions use these to call the unchecked routine
+ * rather than the _chk one when there's nothing for the _chk one to do.
+ */
+#define __bos_dynamic_check_impl(bos_val, op, index) \
+    ((bos_val) == __BIONIC_FORTIFY_UNKNOWN_SIZE || \
+     (__builtin_constant_p(index) && __builtin_constant_p(bos_val) && (bos_val) op (index)))
+#define __bos_trivially_ge(bos_val, index) __bos_dynamic_check_impl((bos_val), >=, (index))
+#define __bos_trivially_gt(bos_val, index) __bos_dynamic_check_impl((bos_val), >, (index))
+
 #if defined(_FORTIFY_SOURCE) && _FORTIFY_SOURCE > 0 && defined(__OPTIMIZE__) && __OPTIMIZE__ > 0
 #  define __BIONIC_FORTIFY 1
 #  if _FORTIFY_SOURCE == 2
@@ -39,6 +39,14 @@ int get_nprocs_conf(void) __INTRODUCED_IN(23);
 
 int get_nprocs(void) __INTRODUCED_IN(23);
 
+/*
+ * Returns the number of online CPUs the calling thread may run on: those in
+ * its affinity mask, which also reflects the cpuset it's in. This is the
+ * number of threads worth running at once, which get_nprocs overstates for
+ * a process confined to some of the CPUs.
+ */
+int get_nprocs_available(void) __INTRODUCED_IN_FUTURE;
+
 long get_phys_pages(void) __INTRODUCED_IN(23);
 
 long get_avphys_pages(void) __INTRODUCED_IN(23);
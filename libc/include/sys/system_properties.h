@@ -53,6 +53,19 @@ int __system_property_set(const char* key, const char* value) __INTRODUCED_IN(12
  */
 const prop_info* __system_property_find(const char* name);
 
+/*
+ * Looks up `count` properties at once. The value of `names[i]` is copied to
+ * `values[i]`, which must have room for PROP_VALUE_MAX bytes, or the empty
+ * string if that property doesn't exist.
+ *
+ * This is cheaper than calling __system_property_get for each name in turn
+ * because each property area is only looked up once for the whole batch.
+ *
+ * Returns the number of properties that were found.
+ */
+size_t __system_property_get_many(const char* const names[], char* const values[], size_t count)
+    __INTRODUCED_IN_FUTURE;
+
 /*
  * Calls `callback` with a consistent trio of name, value, and serial number for property `pi`.
  */
@@ -60,6 +73,17 @@ void __system_property_read_callback(const prop_info *pi,
     void (*callback)(void* cookie, const char *name, const char *value, uint32_t serial),
     void* cookie) __INTRODUCED_IN(26);
 
+/*
+ * Returns a pointer to the value of the read-only ("ro.") property `pi`, and
+ * sets `*serial_ptr` if it's not null. Read-only properties never change once
+ * set, so the pointer stays valid and the value can be used in place, with
+ * no copy. Unlike __system_property_read, this works for values of any length.
+ *
+ * Returns null if `pi` isn't a read-only property.
+ */
+const char* __system_property_read_stable(const prop_info* pi, uint32_t* serial_ptr)
+    __INTRODUCED_IN_FUTURE;
+
 /*
  * Passes a `prop_info` for each system property to the provided
  * callback.  Use __system_property_read_callback() to read the value.
@@ -88,6 +112,80 @@ bool __system_property_wait(const prop_info* pi,
                             const struct timespec* relative_timeout)
     __INTRODUCED_IN(26);
 
+/*
+ * Waits for any of the `count` properties in `pis` to be updated past the
+ * corresponding serial in `old_serials`. Waits no longer than
+ * `relative_timeout`, or forever if `relative_timeout` is null.
+ *
+ * Unlike waiting on the global serial, this isn't woken by every property
+ * change on the system: properties that share a context are watched through
+ * that context's own serial.
+ *
+ * Returns true and sets `*changed_index` to the index of a property that
+ * changed, or false if the call timed out.
+ */
+bool __system_property_wait_set(const prop_info* const pis[],
+                                const uint32_t old_serials[],
+                                size_t count,
+                                size_t* changed_index,
+                                const struct timespec* relative_timeout)
+    __INTRODUCED_IN_FUTURE;
+
+/*
+ * A `prop_cache` is a handle to a single property for code that reads it
+ * repeatedly, such as a debug flag checked on a hot path. It remembers where
+ * the property lives so that, once the property exists, checking it costs a
+ * few loads. It can be used from any number of threads at once.
+ *
+ * The property doesn't need to exist when the handle is created.
+ *
+ * A typical caller keeps the serial of the value it last acted on:
+ *
+ *   uint32_t serial = __system_property_cache_serial(cache);
+ *   if (serial != last_serial) {
+ *     char value[PROP_VALUE_MAX];
+ *     last_serial = __system_property_cache_read(cache, value);
+ *     ...
+ *   }
+ */
+typedef struct prop_cache prop_cache;
+
+/*
+ * Returns a new handle for the property `name`, or null if out of memory.
+ */
+prop_cache* __system_property_cache_create(const char* name) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Frees a handle returned by __system_property_cache_create.
+ */
+void __system_property_cache_destroy(prop_cache* cache) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Returns the serial number of the property's current value, or 0 if the
+ * property doesn't exist.
+ */
+uint32_t __system_property_cache_serial(prop_cache* cache) __INTRODUCED_IN_FUTURE;
+
+/*
+ * Copies the property's current value into `value`, which must have room for
+ * PROP_VALUE_MAX bytes, and returns the serial number that goes with it.
+ * If the property doesn't exist, `value` is set to the empty string and 0 is
+ * returned.
+ */
+uint32_t __system_property_cache_read(prop_cache* cache, char* value) __INTRODUCED_IN_FUTURE;
+
+/*
+ * As __system_property_wait, but for the property behind `cache`, which
+ * doesn't need to exist yet. Returns true and updates `*new_serial_ptr`
+ * once the property's serial is no longer `old_serial`, or false if the call
+ * timed out.
+ */
+bool __system_property_cache_wait(prop_cache* cache,
+                                  uint32_t old_serial,
+                                  uint32_t* new_serial_ptr,
+                                  const struct timespec* relative_timeout)
+    __INTRODUCED_IN_FUTURE;
+
 /* Deprecated. In Android O and above, there's no limit on property name length. */
 #define PROP_NAME_MAX   32
 /* Deprecated. Use __system_property_read_callback instead. */
@@ -47,6 +47,24 @@ ssize_t pwritev(int, const struct iovec*, int, off_t) __INTRODUCED_IN(24);
 #endif
 ssize_t preadv64(int, const struct iovec*, int, off64_t) __INTRODUCED_IN(24);
 ssize_t pwritev64(int, const struct iovec*, int, off64_t) __INTRODUCED_IN(24);
+
+/* Flags for preadv2 and pwritev2. An offset of -1 means the current file offset. */
+#define RWF_HIPRI 0x00000001
+#define RWF_DSYNC 0x00000002
+#define RWF_SYNC 0x00000004
+#define RWF_NOWAIT 0x00000008
+
+#if defined(__USE_FILE_OFFSET64)
+ssize_t preadv2(int, const struct iovec*, int, off_t, int) __RENAME(preadv64v2)
+    __INTRODUCED_IN_FUTURE;
+ssize_t pwritev2(int, const struct iovec*, int, off_t, int) __RENAME(pwritev64v2)
+    __INTRODUCED_IN_FUTURE;
+#else
+ssize_t preadv2(int, const struct iovec*, int, off_t, int) __INTRODUCED_IN_FUTURE;
+ssize_t pwritev2(int, const struct iovec*, int, off_t, int) __INTRODUCED_IN_FUTURE;
+#endif
+ssize_t preadv64v2(int, const struct iovec*, int, off64_t, int) __INTRODUCED_IN_FUTURE;
+ssize_t pwritev64v2(int, const struct iovec*, int, off64_t, int) __INTRODUCED_IN_FUTURE;
 #endif
 
 #if defined(__USE_GNU)
@@ -77,13 +77,19 @@ __BEGIN_DECLS
 #define LOG_MASK(pri) (1 << (pri))
 #define LOG_UPTO(pri) ((1 << ((pri)+1)) - 1)
 
-/* openlog(3) flags are currently ignored on Android. */
+/* openlog(3) flags. Only LOG_NDELAY is acted on by Android. */
 #define LOG_PID    0x01
 #define LOG_CONS   0x02
 #define LOG_ODELAY 0x04
 #define LOG_NDELAY 0x08
 #define LOG_NOWAIT 0x10
 #define LOG_PERROR 0x20
+/*
+ * Android extension: syslog() queues messages for a background thread to send
+ * to logd, rather than sending each one itself. Messages at LOG_ERR and above
+ * are sent before syslog() returns, as is everything queued before them.
+ */
+#define LOG_ANDROID_BUFFERED 0x1000
 
 void closelog(void);
 void openlog(const char* _Nullable, int, int);
@@ -1 +1,52 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _UCONTEXT_H_
+#define _UCONTEXT_H_
+
+#include <sys/cdefs.h>
 #include <sys/ucontext.h>
+
+__BEGIN_DECLS
+
+#if !defined(__mips__)
+/*
+ * These save and restore the callee-saved registers (including the callee-saved
+ * floating-point state) and the signal mask. Signal mask changes go through
+ * sigprocmask, which doesn't make a system call when the mask isn't changing, so
+ * switching between contexts that share a mask costs no more than a function call.
+ */
+int getcontext(ucontext_t* _Nonnull) __INTRODUCED_IN_FUTURE;
+int setcontext(const ucontext_t* _Nonnull) __INTRODUCED_IN_FUTURE;
+void makecontext(ucontext_t* _Nonnull, void (* _Nonnull)(), int, ...) __INTRODUCED_IN_FUTURE;
+int swapcontext(ucontext_t* _Nonnull, const ucontext_t* _Nonnull) __INTRODUCED_IN_FUTURE;
+#endif
+
+__END_DECLS
+
+#endif /* _UCONTEXT_H_ */
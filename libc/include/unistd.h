@@ -196,6 +196,11 @@ ssize_t pwrite64(int __fd, const void* __buf, size_t __count, off64_t __offset)
     __INTRODUCED_IN(12) __overloadable __RENAME_CLANG(pwrite64);
 int ftruncate64(int __fd, off64_t __length) __INTRODUCED_IN(12);
 
+#if defined(__USE_GNU)
+ssize_t copy_file_range(int __fd_in, off64_t* __off_in, int __fd_out, off64_t* __off_out,
+                        size_t __length, unsigned int __flags) __INTRODUCED_IN_FUTURE;
+#endif
+
 int pause(void);
 unsigned int alarm(unsigned int __seconds);
 unsigned int sleep(unsigned int __seconds);
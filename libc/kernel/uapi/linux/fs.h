@@ -292,4 +292,5 @@ struct fscrypt_policy {
 #define RWF_DSYNC 0x00000002
 /* WARNING: DO NOT EDIT, AUTO-GENERATED CODE - SEE TOP FOR INSTRUCTIONS */
 #define RWF_SYNC 0x00000004
+#define RWF_NOWAIT 0x00000008
 #endif
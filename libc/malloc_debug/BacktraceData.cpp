@@ -49,11 +49,10 @@ static void EnableToggle(int, siginfo_t*, void*) {
   }
 }
 
-BacktraceData::BacktraceData(DebugData* debug_data, const Config& config, size_t* offset)
+BacktraceData::BacktraceData(DebugData* debug_data, const Config&, size_t* offset)
     : OptionData(debug_data) {
-  size_t hdr_len = sizeof(BacktraceHeader) + sizeof(uintptr_t) * config.backtrace_frames;
   alloc_offset_ = *offset;
-  *offset += BIONIC_ALIGN(hdr_len, MINIMUM_ALIGNMENT_BYTES);
+  *offset += BIONIC_ALIGN(sizeof(BacktraceHeader*), MINIMUM_ALIGNMENT_BYTES);
 }
 
 bool BacktraceData::Initialize(const Config& config) {
@@ -72,5 +71,44 @@ bool BacktraceData::Initialize(const Config& config) {
     info_log("%s: Run: 'kill -%d %d' to enable backtracing.", getprogname(),
              config.backtrace_signal, getpid());
   }
+
+  if (config.backtrace_sampling) {
+    int error = pthread_key_create(&sample_key_, nullptr);
+    if (error != 0) {
+      error_log("Unable to create backtrace sampling key: %s", strerror(error));
+      return false;
+    }
+    sample_bytes_ = config.backtrace_sample_bytes;
+  }
+  return true;
+}
+
+BacktraceData::~BacktraceData() {
+  if (sample_bytes_ != 0) {
+    pthread_key_delete(sample_key_);
+  }
+}
+
+bool BacktraceData::ShouldSample(size_t size) {
+  if (sample_bytes_ == 0) {
+    return true;
+  }
+
+  // Sampling at a fixed byte interval rather than every Nth call keeps
+  // the samples proportional to the memory each call site allocates.
+  uintptr_t allocated = reinterpret_cast<uintptr_t>(pthread_getspecific(sample_key_));
+  uintptr_t remaining = sample_bytes_ - allocated;
+  if (size < remaining) {
+    pthread_setspecific(sample_key_, reinterpret_cast<void*>(allocated + size));
+    return false;
+  }
+  pthread_setspecific(sample_key_, reinterpret_cast<void*>((size - remaining) % sample_bytes_));
   return true;
 }
+
+size_t BacktraceData::SampleWeight(size_t size) {
+  if (sample_bytes_ == 0 || size == 0 || size >= sample_bytes_) {
+    return 1;
+  }
+  return sample_bytes_ / size;
+}
@@ -29,6 +29,7 @@
 #ifndef DEBUG_MALLOC_BACKTRACEDATA_H
 #define DEBUG_MALLOC_BACKTRACEDATA_H
 
+#include <pthread.h>
 #include <stdint.h>
 
 #include <private/bionic_macros.h>
@@ -41,7 +42,7 @@ struct Config;
 class BacktraceData : public OptionData {
  public:
   BacktraceData(DebugData* debug_data, const Config& config, size_t* offset);
-  virtual ~BacktraceData() = default;
+  virtual ~BacktraceData();
 
   bool Initialize(const Config& config);
 
@@ -50,11 +51,24 @@ class BacktraceData : public OptionData {
   bool enabled() { return enabled_; }
   void set_enabled(bool enabled) { enabled_ = enabled; }
 
+  // Returns whether the backtrace of a new allocation of the given size
+  // should be captured. Always true unless backtrace_sample_bytes is set.
+  bool ShouldSample(size_t size);
+
+  // Returns how many allocations of the given size a single sampled one
+  // stands for.
+  size_t SampleWeight(size_t size);
+
  private:
   size_t alloc_offset_ = 0;
 
   volatile bool enabled_ = false;
 
+  // Zero when every allocation is captured.
+  size_t sample_bytes_ = 0;
+  // Per thread, the number of bytes allocated since the last sample.
+  pthread_key_t sample_key_;
+
   DISALLOW_COPY_AND_ASSIGN(BacktraceData);
 };
 
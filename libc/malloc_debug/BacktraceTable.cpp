@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "BacktraceTable.h"
+#include "malloc_debug.h"
+
+struct BacktraceTable::Entry {
+  size_t hash;
+  size_t ref_count;
+  // Must be last since the frames follow it.
+  BacktraceHeader back_header;
+};
+
+static size_t HashFrames(const uintptr_t* frames, size_t num_frames) {
+  size_t hash = num_frames;
+  for (size_t i = 0; i < num_frames; i++) {
+    hash ^= frames[i] + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+BacktraceTable::~BacktraceTable() {
+  for (const auto& entry : entries_) {
+    g_dispatch->free(entry.second);
+  }
+}
+
+BacktraceTable::Entry* BacktraceTable::GetEntry(const BacktraceHeader* back_header) {
+  uintptr_t value = reinterpret_cast<uintptr_t>(back_header);
+  return reinterpret_cast<Entry*>(value - offsetof(Entry, back_header));
+}
+
+const BacktraceHeader* BacktraceTable::Add(const uintptr_t* frames, size_t num_frames) {
+  if (num_frames == 0) {
+    return nullptr;
+  }
+  size_t hash = HashFrames(frames, num_frames);
+
+  pthread_mutex_lock(&mutex_);
+  auto range = entries_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    Entry* entry = it->second;
+    if (entry->back_header.num_frames == num_frames &&
+        memcmp(&entry->back_header.frames[0], frames, num_frames * sizeof(uintptr_t)) == 0) {
+      entry->ref_count++;
+      pthread_mutex_unlock(&mutex_);
+      return &entry->back_header;
+    }
+  }
+
+  Entry* entry = reinterpret_cast<Entry*>(
+      g_dispatch->malloc(sizeof(Entry) + num_frames * sizeof(uintptr_t)));
+  if (entry == nullptr) {
+    pthread_mutex_unlock(&mutex_);
+    return nullptr;
+  }
+  entry->hash = hash;
+  entry->ref_count = 1;
+  entry->back_header.num_frames = num_frames;
+  memcpy(&entry->back_header.frames[0], frames, num_frames * sizeof(uintptr_t));
+  entries_.emplace(hash, entry);
+  pthread_mutex_unlock(&mutex_);
+  return &entry->back_header;
+}
+
+void BacktraceTable::Release(const BacktraceHeader* back_header) {
+  if (back_header == nullptr) {
+    return;
+  }
+  Entry* entry = GetEntry(back_header);
+
+  pthread_mutex_lock(&mutex_);
+  if (--entry->ref_count == 0) {
+    auto range = entries_.equal_range(entry->hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == entry) {
+        entries_.erase(it);
+        break;
+      }
+    }
+    g_dispatch->free(entry);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+size_t BacktraceTable::size() {
+  pthread_mutex_lock(&mutex_);
+  size_t size = entries_.size();
+  pthread_mutex_unlock(&mutex_);
+  return size;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef DEBUG_MALLOC_BACKTRACETABLE_H
+#define DEBUG_MALLOC_BACKTRACETABLE_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <unordered_map>
+
+#include <private/bionic_macros.h>
+
+// Forward declarations.
+struct BacktraceHeader;
+
+// Stores every distinct backtrace once, reference counted, so that all of
+// the allocations and frees that share a call stack only keep a pointer
+// to it.
+class BacktraceTable {
+ public:
+  BacktraceTable() = default;
+  ~BacktraceTable();
+
+  // Returns the stored copy of the given frames and takes a reference to
+  // it. Returns nullptr if num_frames is zero or if out of memory.
+  const BacktraceHeader* Add(const uintptr_t* frames, size_t num_frames);
+
+  // Drops a reference taken by Add. Does nothing for nullptr.
+  void Release(const BacktraceHeader* back_header);
+
+  // Returns the number of distinct backtraces stored.
+  size_t size();
+
+  void PrepareFork() { pthread_mutex_lock(&mutex_); }
+  void PostForkParent() { pthread_mutex_unlock(&mutex_); }
+  void PostForkChild() { pthread_mutex_init(&mutex_, NULL); }
+
+ private:
+  struct Entry;
+
+  static Entry* GetEntry(const BacktraceHeader* back_header);
+
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  // Keyed by the hash of the frames.
+  std::unordered_multimap<size_t, Entry*> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(BacktraceTable);
+};
+
+#endif // DEBUG_MALLOC_BACKTRACETABLE_H
@@ -54,17 +54,36 @@ static constexpr size_t DEFAULT_GUARD_BYTES = 32;
 static constexpr size_t MAX_GUARD_BYTES = 16384;
 
 static constexpr size_t DEFAULT_BACKTRACE_FRAMES = 16;
-static constexpr size_t MAX_BACKTRACE_FRAMES = 256;
+
+static constexpr size_t DEFAULT_BACKTRACE_SAMPLE_BYTES = 512 * 1024;
+static constexpr size_t MAX_BACKTRACE_SAMPLE_BYTES = 1024 * 1024 * 1024;
 
 static constexpr size_t DEFAULT_EXPAND_BYTES = 16;
 static constexpr size_t MAX_EXPAND_BYTES = 16384;
 
 static constexpr size_t DEFAULT_FREE_TRACK_ALLOCATIONS = 100;
 static constexpr size_t MAX_FREE_TRACK_ALLOCATIONS = 16384;
+static constexpr size_t DEFAULT_FREE_TRACK_VERIFY_QUEUE_SIZE = 256;
+static constexpr size_t MAX_FREE_TRACK_VERIFY_QUEUE_SIZE = 16384;
 
 static constexpr size_t DEFAULT_RECORD_ALLOCS = 8000000;
 static constexpr size_t MAX_RECORD_ALLOCS = 50000000;
 static constexpr const char DEFAULT_RECORD_ALLOCS_FILE[] = "/data/local/tmp/record_allocs.txt";
+static constexpr size_t DEFAULT_RECORD_ALLOCS_STREAM_FILES = 4;
+static constexpr size_t MAX_RECORD_ALLOCS_STREAM_FILES = 1000;
+
+static constexpr size_t DEFAULT_GUARD_PAGES_SAMPLE_RATE = 1000;
+static constexpr size_t MAX_GUARD_PAGES_SAMPLE_RATE = 100000000;
+static constexpr size_t DEFAULT_GUARD_PAGES_SLOTS = 64;
+static constexpr size_t MAX_GUARD_PAGES_SLOTS = 16384;
+
+static constexpr size_t DEFAULT_MREMAP_REALLOC_BYTES = 131072;
+static constexpr size_t MAX_MREMAP_REALLOC_BYTES = 1073741824;
+
+static constexpr size_t DEFAULT_MUTEX_CONTENTION_SAMPLE_INTERVAL = 10;
+static constexpr size_t MAX_MUTEX_CONTENTION_SAMPLE_INTERVAL = 1000000;
+static constexpr const char DEFAULT_MUTEX_CONTENTION_FILE[] =
+    "/data/local/tmp/mutex_contention.txt";
 
 struct Option {
   Option(std::string name, uint64_t option, bool combo_option = false, bool* config = nullptr)
@@ -265,6 +284,14 @@ void PropertyParser::LogUsage() {
   error_log("    frames. The default is %zu frames, the max number of frames is %zu.",
             DEFAULT_BACKTRACE_FRAMES, MAX_BACKTRACE_FRAMES);
   error_log("");
+  error_log("  backtrace_sample_bytes[=XX]");
+  error_log("    This option only has meaning if backtrace or backtrace_enable_on_signal");
+  error_log("    is set. Only capture the backtrace of about one allocation for every");
+  error_log("    XX bytes allocated by a thread. get_malloc_leak_info weights every");
+  error_log("    sampled allocation by the number of allocations it stands for.");
+  error_log("    The default is %zu bytes, the max bytes is %zu.",
+            DEFAULT_BACKTRACE_SAMPLE_BYTES, MAX_BACKTRACE_SAMPLE_BYTES);
+  error_log("");
   error_log("  fill_on_alloc[=XX]");
   error_log("    On first allocation, fill with the value 0x%02x.", DEFAULT_FILL_ALLOC_VALUE);
   error_log("    If XX is set it will only fill up to XX bytes of the");
@@ -308,6 +335,15 @@ void PropertyParser::LogUsage() {
   error_log("    The default is to record %zu frames, the max number of frames is %zu.",
             DEFAULT_BACKTRACE_FRAMES, MAX_BACKTRACE_FRAMES);
   error_log("");
+  error_log("  free_track_verify_thread[=XX]");
+  error_log("    This option only has meaning if free_track is set. Instead of");
+  error_log("    verifying an allocation in the freeing thread when it is removed");
+  error_log("    from the free_track list, pass it to a background thread that");
+  error_log("    verifies it and then frees it. If XX is set, at most XX allocations");
+  error_log("    wait for the thread; once that many are waiting, free blocks.");
+  error_log("    The default is %zu allocations, the max allocations is %zu.",
+            DEFAULT_FREE_TRACK_VERIFY_QUEUE_SIZE, MAX_FREE_TRACK_VERIFY_QUEUE_SIZE);
+  error_log("");
   error_log("  leak_track");
   error_log("    Enable the leak tracking of memory allocations.");
   error_log("");
@@ -323,6 +359,53 @@ void PropertyParser::LogUsage() {
   error_log("    This option only has meaning if the record_allocs options has been specified.");
   error_log("    This is the name of the file to which recording information will be dumped.");
   error_log("    The default is %s.", DEFAULT_RECORD_ALLOCS_FILE);
+  error_log("");
+  error_log("  record_allocs_stream[=XX]");
+  error_log("    This option only has meaning if the record_allocs options has been specified.");
+  error_log("    Instead of waiting for the dump signal, continuously write the records in");
+  error_log("    a binary format to a ring of XX files named FILE.PID.N, where FILE is the");
+  error_log("    record_allocs_file. Each file holds the number of entries given to");
+  error_log("    record_allocs, after which the next file in the ring is overwritten.");
+  error_log("    The signal writes out the records that are still buffered.");
+  error_log("    The default is %zu files, the max files is %zu.",
+            DEFAULT_RECORD_ALLOCS_STREAM_FILES, MAX_RECORD_ALLOCS_STREAM_FILES);
+  error_log("");
+  error_log("  guard_pages[=XX]");
+  error_log("    Serve about one in every XX allocations made by a thread from a pool");
+  error_log("    of pages surrounded by inaccessible guard pages. An overflow or a use");
+  error_log("    after free of a sampled allocation crashes right away. Allocations");
+  error_log("    larger than a page are never sampled.");
+  error_log("    The default is %zu allocations, the max allocations is %zu.",
+            DEFAULT_GUARD_PAGES_SAMPLE_RATE, MAX_GUARD_PAGES_SAMPLE_RATE);
+  error_log("");
+  error_log("  guard_pages_slots[=XX]");
+  error_log("    This option only has meaning if guard_pages is set. It sets the number");
+  error_log("    of sampled allocations that can be live at once.");
+  error_log("    The default is %zu slots, the max slots is %zu.",
+            DEFAULT_GUARD_PAGES_SLOTS, MAX_GUARD_PAGES_SLOTS);
+  error_log("");
+  error_log("  mremap_realloc[=XX]");
+  error_log("    Give every allocation of at least XX bytes, including the header,");
+  error_log("    a mapping of its own, so that realloc can grow it with mremap");
+  error_log("    instead of copying it. This option only has meaning if an option");
+  error_log("    that needs a header is set.");
+  error_log("    The default is %zu bytes, the max bytes is %zu.",
+            DEFAULT_MREMAP_REALLOC_BYTES, MAX_MREMAP_REALLOC_BYTES);
+  error_log("");
+  error_log("  mutex_contention[=XX]");
+  error_log("    Record the lock address, wait time and backtrace of one in every");
+  error_log("    XX pthread mutex acquisitions that have to wait. When a specific");
+  error_log("    signal is sent to the process, the totals for each lock and");
+  error_log("    backtrace are written to a file (%s)", DEFAULT_MUTEX_CONTENTION_FILE);
+  error_log("    and cleared.");
+  error_log("    The default is %zu acquisitions, the max acquisitions is %zu.",
+            DEFAULT_MUTEX_CONTENTION_SAMPLE_INTERVAL, MAX_MUTEX_CONTENTION_SAMPLE_INTERVAL);
+  error_log("");
+  error_log("  mutex_contention_file[=FILE]");
+  error_log("    This option only has meaning if the mutex_contention option has been");
+  error_log("    specified. This is the name of the file to which the contention");
+  error_log("    information will be dumped.");
+  error_log("    The default is %s.", DEFAULT_MUTEX_CONTENTION_FILE);
 }
 
 // This function is designed to be called once. A second call will not
@@ -335,8 +418,10 @@ bool Config::Set(const char* options_str) {
   rear_guard_value = DEFAULT_REAR_GUARD_VALUE;
   backtrace_signal = SIGRTMAX - 19;
   record_allocs_signal = SIGRTMAX - 18;
+  mutex_contention_signal = SIGRTMAX - 17;
   free_track_backtrace_num_frames = 0;
   record_allocs_file.clear();
+  mutex_contention_file.clear();
 
   // Parse the options are of the format:
   //   option_name or option_name=XX
@@ -362,6 +447,10 @@ bool Config::Set(const char* options_str) {
   const OptionSizeT option_backtrace_enable_on_signal(
       "backtrace_enable_on_signal", DEFAULT_BACKTRACE_FRAMES, 1, MAX_BACKTRACE_FRAMES,
       BACKTRACE | TRACK_ALLOCS, &this->backtrace_frames, false, &this->backtrace_enable_on_signal);
+  // Only capture the backtrace of about every Nth allocated byte.
+  const OptionSizeT option_backtrace_sample_bytes(
+      "backtrace_sample_bytes", DEFAULT_BACKTRACE_SAMPLE_BYTES, 1, MAX_BACKTRACE_SAMPLE_BYTES, 0,
+      &this->backtrace_sample_bytes, false, &this->backtrace_sampling);
 
   const OptionSizeT option_fill("fill", SIZE_MAX, 1, SIZE_MAX, 0, nullptr, true);
   // Fill the allocation with an arbitrary pattern on allocation.
@@ -392,6 +481,12 @@ bool Config::Set(const char* options_str) {
   const OptionSizeT option_free_track_backtrace_num_frames(
       "free_track_backtrace_num_frames", DEFAULT_BACKTRACE_FRAMES, 0, MAX_BACKTRACE_FRAMES, 0,
       &this->free_track_backtrace_num_frames);
+  // Verify the allocations leaving the free_track list on a background
+  // thread. Value is the number of allocations that can wait for it.
+  const OptionSizeT option_free_track_verify_thread(
+      "free_track_verify_thread", DEFAULT_FREE_TRACK_VERIFY_QUEUE_SIZE, 1,
+      MAX_FREE_TRACK_VERIFY_QUEUE_SIZE, 0, &this->free_track_verify_queue_size, false,
+      &this->free_track_verify_thread);
 
   // Enable printing leaked allocations.
   const Option option_leak_track("leak_track", LEAK_TRACK | TRACK_ALLOCS);
@@ -401,15 +496,44 @@ bool Config::Set(const char* options_str) {
       &this->record_allocs_num_entries);
   const OptionString option_record_allocs_file(
       "record_allocs_file", 0, DEFAULT_RECORD_ALLOCS_FILE, &this->record_allocs_file);
+  const OptionSizeT option_record_allocs_stream(
+      "record_allocs_stream", DEFAULT_RECORD_ALLOCS_STREAM_FILES, 1,
+      MAX_RECORD_ALLOCS_STREAM_FILES, 0, &this->record_allocs_stream_files, false,
+      &this->record_allocs_stream);
+
+  // Serve a sample of allocations from guard page surrounded pages.
+  const OptionSizeT option_guard_pages(
+      "guard_pages", DEFAULT_GUARD_PAGES_SAMPLE_RATE, 1, MAX_GUARD_PAGES_SAMPLE_RATE, GUARD_PAGES,
+      &this->guard_pages_sample_rate);
+  const OptionSizeT option_guard_pages_slots(
+      "guard_pages_slots", DEFAULT_GUARD_PAGES_SLOTS, 1, MAX_GUARD_PAGES_SLOTS, 0,
+      &this->guard_pages_slots);
+
+  // Map large allocations on their own so that realloc can use mremap.
+  const OptionSizeT option_mremap_realloc(
+      "mremap_realloc", DEFAULT_MREMAP_REALLOC_BYTES, 1, MAX_MREMAP_REALLOC_BYTES, MREMAP_REALLOC,
+      &this->mremap_realloc_bytes);
+
+  // Sample contended pthread mutex acquisitions.
+  const OptionSizeT option_mutex_contention(
+      "mutex_contention", DEFAULT_MUTEX_CONTENTION_SAMPLE_INTERVAL, 1,
+      MAX_MUTEX_CONTENTION_SAMPLE_INTERVAL, MUTEX_CONTENTION,
+      &this->mutex_contention_sample_interval);
+  const OptionString option_mutex_contention_file(
+      "mutex_contention_file", 0, DEFAULT_MUTEX_CONTENTION_FILE, &this->mutex_contention_file);
 
   const Option* option_list[] = {
     &option_guard, &option_front_guard, &option_rear_guard,
-    &option_backtrace, &option_backtrace_enable_on_signal,
+    &option_backtrace, &option_backtrace_enable_on_signal, &option_backtrace_sample_bytes,
     &option_fill, &option_fill_on_alloc, &option_fill_on_free,
     &option_expand_alloc,
     &option_free_track, &option_free_track_backtrace_num_frames,
+    &option_free_track_verify_thread,
     &option_leak_track,
-    &option_record_allocs, &option_record_allocs_file,
+    &option_record_allocs, &option_record_allocs_file, &option_record_allocs_stream,
+    &option_guard_pages, &option_guard_pages_slots,
+    &option_mremap_realloc,
+    &option_mutex_contention, &option_mutex_contention_file,
   };
 
   // Set defaults for all of the options.
@@ -43,6 +43,9 @@ constexpr uint64_t FREE_TRACK = 0x40;
 constexpr uint64_t TRACK_ALLOCS = 0x80;
 constexpr uint64_t LEAK_TRACK = 0x100;
 constexpr uint64_t RECORD_ALLOCS = 0x200;
+constexpr uint64_t GUARD_PAGES = 0x400;
+constexpr uint64_t MREMAP_REALLOC = 0x800;
+constexpr uint64_t MUTEX_CONTENTION = 0x1000;
 
 // In order to guarantee posix compliance, set the minimum alignment
 // to 8 bytes for 32 bit systems and 16 bytes for 64 bit systems.
@@ -52,6 +55,9 @@ constexpr size_t MINIMUM_ALIGNMENT_BYTES = 16;
 constexpr size_t MINIMUM_ALIGNMENT_BYTES = 8;
 #endif
 
+// The most frames any backtrace option will capture.
+constexpr size_t MAX_BACKTRACE_FRAMES = 256;
+
 // If one or more of these options is set, then a special header is needed.
 constexpr uint64_t HEADER_OPTIONS = FRONT_GUARD | REAR_GUARD | BACKTRACE | FREE_TRACK | LEAK_TRACK;
 
@@ -65,6 +71,8 @@ struct Config {
   int backtrace_signal = 0;
   bool backtrace_enabled = false;
   size_t backtrace_frames = 0;
+  bool backtrace_sampling = false;
+  size_t backtrace_sample_bytes = 0;
 
   size_t fill_on_alloc_bytes = 0;
   size_t fill_on_free_bytes = 0;
@@ -73,10 +81,23 @@ struct Config {
 
   size_t free_track_allocations = 0;
   size_t free_track_backtrace_num_frames = 0;
+  bool free_track_verify_thread = false;
+  size_t free_track_verify_queue_size = 0;
 
   int record_allocs_signal = 0;
   size_t record_allocs_num_entries = 0;
   std::string record_allocs_file;
+  bool record_allocs_stream = false;
+  size_t record_allocs_stream_files = 0;
+
+  size_t guard_pages_sample_rate = 0;
+  size_t guard_pages_slots = 0;
+
+  size_t mremap_realloc_bytes = 0;
+
+  size_t mutex_contention_sample_interval = 0;
+  int mutex_contention_signal = 0;
+  std::string mutex_contention_file;
 
   uint64_t options = 0;
   uint8_t fill_alloc_value;
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+
+#include "backtrace.h"
+#include "Config.h"
+#include "ContentionData.h"
+#include "DebugData.h"
+#include "debug_log.h"
+
+static void ContentionDump(int, siginfo_t*, void*) {
+  // It's not safe to do the dump here, or in Record, which can be called
+  // with the native allocator's locks held. Wait for the next allocation.
+  if (g_debug != nullptr && g_debug->contention != nullptr) {
+    g_debug->contention->SetToDump();
+  }
+}
+
+bool ContentionData::Initialize(const Config& config) {
+  struct sigaction dump_act;
+  memset(&dump_act, 0, sizeof(dump_act));
+
+  dump_act.sa_sigaction = ContentionDump;
+  dump_act.sa_flags = SA_RESTART | SA_SIGINFO | SA_ONSTACK;
+  sigemptyset(&dump_act.sa_mask);
+  if (sigaction(config.mutex_contention_signal, &dump_act, nullptr) != 0) {
+    error_log("Unable to set up mutex contention dump signal function: %s", strerror(errno));
+    return false;
+  }
+
+  info_log("%s: Run: 'kill -%d %d' to dump the mutex contention records.", getprogname(),
+           config.mutex_contention_signal, getpid());
+
+  entries_.resize(kMaxEntries);
+  snapshot_.resize(kMaxEntries);
+  dump_file_ = config.mutex_contention_file;
+  return true;
+}
+
+void ContentionData::Record(const void* mutex, uint64_t wait_ns) {
+  // Unwind before taking the lock, so that it is only held briefly.
+  uintptr_t frames[kBacktraceFrames];
+  size_t num_frames = backtrace_get(frames, kBacktraceFrames);
+
+  uintptr_t hash = reinterpret_cast<uintptr_t>(mutex);
+  for (size_t i = 0; i < num_frames; i++) {
+    hash = hash * 31 + frames[i];
+  }
+
+  pthread_mutex_lock(&mutex_);
+  for (size_t probe = 0; probe < kMaxEntries; probe++) {
+    Entry& entry = entries_[(hash + probe) % kMaxEntries];
+    if (entry.waits == 0) {
+      if (num_used_ == kMaxEntries / 2) {
+        // Keep the table at most half full so that probes stay short.
+        break;
+      }
+      num_used_++;
+      entry.mutex = mutex;
+      entry.num_frames = num_frames;
+      memcpy(entry.frames, frames, num_frames * sizeof(uintptr_t));
+    } else if (entry.mutex != mutex || entry.num_frames != num_frames ||
+               memcmp(entry.frames, frames, num_frames * sizeof(uintptr_t)) != 0) {
+      continue;
+    }
+    entry.waits++;
+    entry.total_ns += wait_ns;
+    entry.max_ns = std::max(entry.max_ns, wait_ns);
+    pthread_mutex_unlock(&mutex_);
+    return;
+  }
+  dropped_++;
+  pthread_mutex_unlock(&mutex_);
+}
+
+void ContentionData::Dump() {
+  pthread_mutex_lock(&dump_mutex_);
+  if (!dump_.exchange(false)) {
+    // Another thread got here first.
+    pthread_mutex_unlock(&dump_mutex_);
+    return;
+  }
+
+  pthread_mutex_lock(&mutex_);
+  entries_.swap(snapshot_);
+  std::fill(entries_.begin(), entries_.end(), Entry());
+  num_used_ = 0;
+  uint64_t dropped = dropped_;
+  dropped_ = 0;
+  pthread_mutex_unlock(&mutex_);
+
+  // The worst contention first.
+  std::sort(snapshot_.begin(), snapshot_.end(), [](const Entry& a, const Entry& b) {
+    return a.total_ns > b.total_ns;
+  });
+
+  int dump_fd = open(dump_file_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                     0644);
+  if (dump_fd == -1) {
+    error_log("Cannot create mutex contention file %s: %s", dump_file_.c_str(), strerror(errno));
+    pthread_mutex_unlock(&dump_mutex_);
+    return;
+  }
+
+  std::string output;
+  if (dropped != 0) {
+    output += android::base::StringPrintf("dropped: %" PRIu64 " waits\n", dropped);
+  }
+  for (const Entry& entry : snapshot_) {
+    if (entry.waits == 0) {
+      break;
+    }
+    output += android::base::StringPrintf(
+        "mutex %p: waits %" PRIu64 " total_ns %" PRIu64 " max_ns %" PRIu64 "\n", entry.mutex,
+        entry.waits, entry.total_ns, entry.max_ns);
+    output += backtrace_string(entry.frames, entry.num_frames);
+  }
+  if (!android::base::WriteStringToFd(output, dump_fd)) {
+    error_log("Failed to write mutex contention information: %s", strerror(errno));
+  }
+  close(dump_fd);
+  pthread_mutex_unlock(&dump_mutex_);
+}
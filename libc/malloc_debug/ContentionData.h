@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef DEBUG_MALLOC_CONTENTIONDATA_H
+#define DEBUG_MALLOC_CONTENTIONDATA_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <private/bionic_macros.h>
+
+// Forward declarations.
+struct Config;
+
+// Totals the sampled waits for contended pthread mutexes by lock and
+// backtrace. libc calls Record with the lock that was waited for, possibly
+// while holding other locks, including the native allocator's, so Record
+// never allocates and only holds mutex_ while updating the table. Like
+// record_allocs, a signal asks for the totals, which are written out by the
+// next allocation call.
+class ContentionData {
+ public:
+  ContentionData() = default;
+  virtual ~ContentionData() = default;
+
+  bool Initialize(const Config& config);
+
+  void Record(const void* mutex, uint64_t wait_ns);
+
+  void SetToDump() { dump_ = true; }
+  bool ShouldDump() { return dump_; }
+  void Dump();
+
+  void PrepareFork() { pthread_mutex_lock(&mutex_); }
+  void PostForkParent() { pthread_mutex_unlock(&mutex_); }
+  void PostForkChild() { pthread_mutex_init(&mutex_, NULL); }
+
+ private:
+  static constexpr size_t kBacktraceFrames = 16;
+  static constexpr size_t kMaxEntries = 1024;
+
+  struct Entry {
+    const void* mutex = nullptr;
+    uint64_t waits = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    size_t num_frames = 0;
+    uintptr_t frames[kBacktraceFrames];
+  };
+
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  // Both are allocated by Initialize and never resized. Dump swaps them
+  // under mutex_, then writes out snapshot_ without holding it.
+  std::vector<Entry> entries_;
+  std::vector<Entry> snapshot_;
+  size_t num_used_ = 0;
+  // Samples that didn't fit in the table since the last dump.
+  uint64_t dropped_ = 0;
+
+  pthread_mutex_t dump_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  std::atomic_bool dump_{false};
+  std::string dump_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContentionData);
+};
+
+#endif // DEBUG_MALLOC_CONTENTIONDATA_H
@@ -34,14 +34,22 @@
 #include "debug_disable.h"
 #include "FreeTrackData.h"
 #include "GuardData.h"
+#include "GuardPageData.h"
 #include "malloc_debug.h"
+#include "MappedAllocData.h"
 #include "TrackData.h"
 
-bool DebugData::Initialize(const char* options) {
+bool DebugData::Initialize(const char* options, bool late_init) {
   if (!config_.Set(options)) {
     return false;
   }
 
+  // When enabled late, only allocations in the tracked set have a header,
+  // so every option that uses a header needs the allocations tracked.
+  if (late_init && (config_.options & HEADER_OPTIONS)) {
+    config_.options |= TRACK_ALLOCS;
+  }
+
   // Check to see if the options that require a header are enabled.
   if (config_.options & HEADER_OPTIONS) {
     need_header_ = true;
@@ -49,6 +57,11 @@ bool DebugData::Initialize(const char* options) {
     // Initialize all of the static header offsets.
     pointer_offset_ = BIONIC_ALIGN(sizeof(Header), MINIMUM_ALIGNMENT_BYTES);
 
+    if ((config_.options & BACKTRACE) ||
+        ((config_.options & FREE_TRACK) && config_.free_track_backtrace_num_frames > 0)) {
+      backtrace_table.reset(new BacktraceTable);
+    }
+
     if (config_.options & BACKTRACE) {
       backtrace.reset(new BacktraceData(this, config_, &pointer_offset_));
       if (!backtrace->Initialize(config_)) {
@@ -75,6 +88,10 @@ bool DebugData::Initialize(const char* options) {
     if (config_.options & TRACK_ALLOCS) {
       track.reset(new TrackData(this));
     }
+
+    if (config_.options & MREMAP_REALLOC) {
+      mapped_allocs.reset(new MappedAllocData(this, config_));
+    }
   }
 
   if (config_.options & RECORD_ALLOCS) {
@@ -84,26 +101,102 @@ bool DebugData::Initialize(const char* options) {
     }
   }
 
+  if (config_.options & GUARD_PAGES) {
+    guard_pages.reset(new GuardPageData(this, config_));
+    if (!guard_pages->Initialize(config_)) {
+      return false;
+    }
+  }
+
+  if (config_.options & MUTEX_CONTENTION) {
+    contention.reset(new ContentionData());
+    if (!contention->Initialize(config_)) {
+      return false;
+    }
+  }
+
   if (config_.options & EXPAND_ALLOC) {
     extra_bytes_ += config_.expand_alloc_bytes;
   }
   return true;
 }
 
+void DebugData::FreeHeader(const Header* header) {
+  if (mapped_allocs != nullptr && mapped_allocs->Free(header)) {
+    return;
+  }
+  g_dispatch->free(header->orig_pointer);
+}
+
 void DebugData::PrepareFork() {
+  // Taken first since freeing a tracked allocation takes the other locks.
+  if (free_track != nullptr) {
+    free_track->PrepareFork();
+  }
   if (track != nullptr) {
     track->PrepareFork();
   }
+  if (mapped_allocs != nullptr) {
+    mapped_allocs->PrepareFork();
+  }
+  if (backtrace_table != nullptr) {
+    backtrace_table->PrepareFork();
+  }
+  if (record != nullptr) {
+    record->PrepareFork();
+  }
+  if (guard_pages != nullptr) {
+    guard_pages->PrepareFork();
+  }
+  if (contention != nullptr) {
+    contention->PrepareFork();
+  }
 }
 
 void DebugData::PostForkParent() {
+  if (contention != nullptr) {
+    contention->PostForkParent();
+  }
+  if (guard_pages != nullptr) {
+    guard_pages->PostForkParent();
+  }
+  if (record != nullptr) {
+    record->PostForkParent();
+  }
+  if (backtrace_table != nullptr) {
+    backtrace_table->PostForkParent();
+  }
+  if (mapped_allocs != nullptr) {
+    mapped_allocs->PostForkParent();
+  }
   if (track != nullptr) {
     track->PostForkParent();
   }
+  if (free_track != nullptr) {
+    free_track->PostForkParent();
+  }
 }
 
 void DebugData::PostForkChild() {
+  if (contention != nullptr) {
+    contention->PostForkChild();
+  }
+  if (guard_pages != nullptr) {
+    guard_pages->PostForkChild();
+  }
+  if (record != nullptr) {
+    record->PostForkChild();
+  }
+  if (backtrace_table != nullptr) {
+    backtrace_table->PostForkChild();
+  }
+  if (mapped_allocs != nullptr) {
+    mapped_allocs->PostForkChild();
+  }
   if (track != nullptr) {
     track->PostForkChild();
   }
+  if (free_track != nullptr) {
+    free_track->PostForkChild();
+  }
 }
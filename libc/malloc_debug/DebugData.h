@@ -37,10 +37,14 @@
 #include <private/bionic_macros.h>
 
 #include "BacktraceData.h"
+#include "BacktraceTable.h"
 #include "Config.h"
+#include "ContentionData.h"
 #include "FreeTrackData.h"
 #include "GuardData.h"
+#include "GuardPageData.h"
 #include "malloc_debug.h"
+#include "MappedAllocData.h"
 #include "RecordData.h"
 #include "TrackData.h"
 
@@ -49,7 +53,9 @@ class DebugData {
   DebugData() = default;
   ~DebugData() = default;
 
-  bool Initialize(const char* options);
+  // late_init is set when malloc debug is enabled after the process has
+  // already allocated memory through the native allocator.
+  bool Initialize(const char* options, bool late_init);
 
   static bool Disabled();
 
@@ -63,9 +69,15 @@ class DebugData {
     return reinterpret_cast<Header*>(value - pointer_offset_);
   }
 
-  BacktraceHeader* GetAllocBacktrace(const Header* header) {
+  // Returns nullptr if no backtrace was captured for the allocation.
+  const BacktraceHeader* GetAllocBacktrace(const Header* header) {
     uintptr_t value = reinterpret_cast<uintptr_t>(header);
-    return reinterpret_cast<BacktraceHeader*>(value + backtrace->alloc_offset());
+    return *reinterpret_cast<const BacktraceHeader**>(value + backtrace->alloc_offset());
+  }
+
+  void SetAllocBacktrace(const Header* header, const BacktraceHeader* back_header) {
+    uintptr_t value = reinterpret_cast<uintptr_t>(header);
+    *reinterpret_cast<const BacktraceHeader**>(value + backtrace->alloc_offset()) = back_header;
   }
 
   uint8_t* GetFrontGuard(const Header* header) {
@@ -83,16 +95,26 @@ class DebugData {
   bool need_header() { return need_header_; }
   size_t extra_bytes() { return extra_bytes_; }
 
+  // Returns the memory of an allocation with a header to wherever it came
+  // from: the native allocator, or a mapping of its own.
+  void FreeHeader(const Header* header);
+
   void PrepareFork();
   void PostForkParent();
   void PostForkChild();
 
+  // Shared by the allocation and free backtraces, so it is declared
+  // first to outlive the options that reference it.
+  std::unique_ptr<BacktraceTable> backtrace_table;
   std::unique_ptr<BacktraceData> backtrace;
   std::unique_ptr<TrackData> track;
   std::unique_ptr<FrontGuardData> front_guard;
   std::unique_ptr<RearGuardData> rear_guard;
   std::unique_ptr<FreeTrackData> free_track;
   std::unique_ptr<RecordData> record;
+  std::unique_ptr<GuardPageData> guard_pages;
+  std::unique_ptr<MappedAllocData> mapped_allocs;
+  std::unique_ptr<ContentionData> contention;
 
  private:
   size_t extra_bytes_ = 0;
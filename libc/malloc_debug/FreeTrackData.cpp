@@ -26,7 +26,9 @@
  * SUCH DAMAGE.
  */
 
+#include <pthread.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "backtrace.h"
 #include "Config.h"
@@ -37,7 +39,9 @@
 #include "malloc_debug.h"
 
 FreeTrackData::FreeTrackData(DebugData* debug, const Config& config)
-    : OptionData(debug), backtrace_num_frames_(config.free_track_backtrace_num_frames) {
+    : OptionData(debug), backtrace_num_frames_(config.free_track_backtrace_num_frames),
+      verify_thread_(config.free_track_verify_thread),
+      verify_queue_size_(config.free_track_verify_queue_size) {
   cmp_mem_.resize(4096);
   memset(cmp_mem_.data(), config.fill_free_value, cmp_mem_.size());
 }
@@ -60,64 +64,196 @@ void FreeTrackData::LogFreeError(const Header* header, const uint8_t* pointer) {
   error_log(LOG_DIVIDER);
 }
 
-void FreeTrackData::VerifyAndFree(const Header* header) {
-  const void* pointer = debug_->GetPointer(header);
+// Checks, without needing any lock, that neither the header tag nor the
+// filled part of a freed allocation has changed.
+bool FreeTrackData::Unmodified(const Header* header) {
   if (header->tag != DEBUG_FREE_TAG) {
-    error_log(LOG_DIVIDER);
-    error_log("+++ ALLOCATION %p HAS CORRUPTED HEADER TAG 0x%x AFTER FREE", pointer, header->tag);
-    error_log(LOG_DIVIDER);
-  } else {
-    const uint8_t* memory = reinterpret_cast<const uint8_t*>(pointer);
-    size_t bytes = header->usable_size;
-    bytes = (bytes < debug_->config().fill_on_free_bytes) ? bytes
-        : debug_->config().fill_on_free_bytes;
-    while (bytes > 0) {
-      size_t bytes_to_cmp = (bytes < cmp_mem_.size()) ? bytes : cmp_mem_.size();
-      if (memcmp(memory, cmp_mem_.data(), bytes_to_cmp) != 0) {
-        LogFreeError(header, reinterpret_cast<const uint8_t*>(pointer));
-        break;
-      }
-      bytes -= bytes_to_cmp;
-      memory = &memory[bytes_to_cmp];
+    return false;
+  }
+  const uint8_t* memory = reinterpret_cast<const uint8_t*>(debug_->GetPointer(header));
+  size_t bytes = header->usable_size;
+  bytes = (bytes < debug_->config().fill_on_free_bytes) ? bytes
+      : debug_->config().fill_on_free_bytes;
+  while (bytes > 0) {
+    size_t bytes_to_cmp = (bytes < cmp_mem_.size()) ? bytes : cmp_mem_.size();
+    if (memcmp(memory, cmp_mem_.data(), bytes_to_cmp) != 0) {
+      return false;
+    }
+    bytes -= bytes_to_cmp;
+    memory = &memory[bytes_to_cmp];
+  }
+  return true;
+}
+
+// Must be called with mutex_ held.
+void FreeTrackData::VerifyAndFree(const Header* header) {
+  if (!Unmodified(header)) {
+    const void* pointer = debug_->GetPointer(header);
+    if (header->tag != DEBUG_FREE_TAG) {
+      error_log(LOG_DIVIDER);
+      error_log("+++ ALLOCATION %p HAS CORRUPTED HEADER TAG 0x%x AFTER FREE", pointer, header->tag);
+      error_log(LOG_DIVIDER);
+    } else {
+      LogFreeError(header, reinterpret_cast<const uint8_t*>(pointer));
     }
   }
+  Free(header);
+}
 
+// Must be called with mutex_ held.
+void FreeTrackData::Free(const Header* header) {
   auto back_iter = backtraces_.find(header);
   if (back_iter != backtraces_.end()) {
-    g_dispatch->free(reinterpret_cast<void*>(back_iter->second));
-    backtraces_.erase(header);
+    debug_->backtrace_table->Release(back_iter->second);
+    backtraces_.erase(back_iter);
   }
-  g_dispatch->free(header->orig_pointer);
+  debug_->FreeHeader(header);
 }
 
 void FreeTrackData::Add(const Header* header) {
+  const Header* verify_header = nullptr;
   pthread_mutex_lock(&mutex_);
   if (list_.size() == debug_->config().free_track_allocations) {
     const Header* old_header = list_.back();
-    VerifyAndFree(old_header);
+    if (verify_thread_) {
+      verify_header = old_header;
+    } else {
+      VerifyAndFree(old_header);
+    }
     list_.pop_back();
   }
 
   if (backtrace_num_frames_ > 0) {
-    BacktraceHeader* back_header = reinterpret_cast<BacktraceHeader*>(
-      g_dispatch->malloc(sizeof(BacktraceHeader) + backtrace_num_frames_ * sizeof(uintptr_t)));
-    if (back_header) {
-      back_header->num_frames = backtrace_get(&back_header->frames[0], backtrace_num_frames_);
+    uintptr_t frames[MAX_BACKTRACE_FRAMES];
+    size_t num_frames = backtrace_get(frames, backtrace_num_frames_);
+    const BacktraceHeader* back_header = debug_->backtrace_table->Add(frames, num_frames);
+    if (back_header != nullptr) {
       backtraces_[header] = back_header;
     }
   }
   list_.push_front(header);
 
   pthread_mutex_unlock(&mutex_);
+
+  if (verify_header != nullptr) {
+    QueueVerify(verify_header);
+  }
+}
+
+void* FreeTrackData::VerifyThread(void* arg) {
+  ScopedDisableDebugCalls disable;
+  FreeTrackData* free_track = reinterpret_cast<FreeTrackData*>(arg);
+
+  pthread_mutex_lock(&free_track->verify_lock_);
+  while (true) {
+    while (free_track->verify_queue_.empty() && !free_track->verify_thread_stop_) {
+      pthread_cond_wait(&free_track->verify_cond_, &free_track->verify_lock_);
+    }
+    if (free_track->verify_queue_.empty()) {
+      break;
+    }
+    const Header* header = free_track->verify_queue_.front();
+    free_track->verify_queue_.pop_front();
+    // Wake up any thread waiting for room in the queue.
+    pthread_cond_broadcast(&free_track->verify_cond_);
+    pthread_mutex_unlock(&free_track->verify_lock_);
+
+    // The comparison is the expensive part, so only take the lock to free
+    // the allocation, or to check it again and report what is wrong.
+    bool unmodified = free_track->Unmodified(header);
+    pthread_mutex_lock(&free_track->mutex_);
+    if (unmodified) {
+      free_track->Free(header);
+    } else {
+      free_track->VerifyAndFree(header);
+    }
+    pthread_mutex_unlock(&free_track->mutex_);
+
+    pthread_mutex_lock(&free_track->verify_lock_);
+  }
+  pthread_mutex_unlock(&free_track->verify_lock_);
+  return nullptr;
+}
+
+void FreeTrackData::QueueVerify(const Header* header) {
+  pthread_mutex_lock(&verify_lock_);
+  if (!verify_thread_started_ && !verify_thread_stop_) {
+    // Started on first use since threads cannot be created while libc
+    // is still initializing.
+    int error = pthread_create(&verify_thread_id_, nullptr, VerifyThread, this);
+    if (error != 0) {
+      error_log("Unable to create free track verify thread: %s", strerror(error));
+      verify_thread_stop_ = true;
+    } else {
+      verify_thread_started_ = true;
+    }
+  }
+  if (verify_thread_stop_) {
+    // No thread to hand it to, so do it here.
+    pthread_mutex_unlock(&verify_lock_);
+    pthread_mutex_lock(&mutex_);
+    VerifyAndFree(header);
+    pthread_mutex_unlock(&mutex_);
+    return;
+  }
+
+  while (verify_queue_.size() >= verify_queue_size_) {
+    pthread_cond_wait(&verify_cond_, &verify_lock_);
+  }
+  verify_queue_.push_back(header);
+  pthread_cond_broadcast(&verify_cond_);
+  pthread_mutex_unlock(&verify_lock_);
+}
+
+// Waits for the verify thread to work through everything queued and exit.
+void FreeTrackData::StopVerifyThread() {
+  pthread_mutex_lock(&verify_lock_);
+  verify_thread_stop_ = true;
+  bool started = verify_thread_started_;
+  verify_thread_started_ = false;
+  pthread_cond_broadcast(&verify_cond_);
+  pthread_mutex_unlock(&verify_lock_);
+  if (started) {
+    pthread_join(verify_thread_id_, nullptr);
+  }
 }
 
 void FreeTrackData::VerifyAll() {
+  if (verify_thread_) {
+    StopVerifyThread();
+  }
   for (const auto& header : list_) {
     VerifyAndFree(header);
   }
   list_.clear();
 }
 
+void FreeTrackData::PrepareFork() {
+  pthread_mutex_lock(&mutex_);
+  if (verify_thread_) {
+    pthread_mutex_lock(&verify_lock_);
+  }
+}
+
+void FreeTrackData::PostForkParent() {
+  if (verify_thread_) {
+    pthread_mutex_unlock(&verify_lock_);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+void FreeTrackData::PostForkChild() {
+  pthread_mutex_init(&mutex_, nullptr);
+  if (!verify_thread_) {
+    return;
+  }
+  // The verify thread does not exist in the child. A new one is started
+  // the next time an allocation is queued, and verifies those still queued.
+  pthread_mutex_init(&verify_lock_, nullptr);
+  pthread_cond_init(&verify_cond_, nullptr);
+  verify_thread_started_ = false;
+}
+
 void FreeTrackData::LogBacktrace(const Header* header) {
   auto back_iter = backtraces_.find(header);
   if (back_iter == backtraces_.end()) {
@@ -57,16 +57,37 @@ class FreeTrackData : public OptionData {
 
   void LogBacktrace(const Header* header);
 
+  void PrepareFork();
+  void PostForkParent();
+  void PostForkChild();
+
  private:
   void LogFreeError(const Header* header, const uint8_t* pointer);
+  bool Unmodified(const Header* header);
   void VerifyAndFree(const Header* header);
+  void Free(const Header* header);
+
+  // Used by free_track_verify_thread instead of verifying in Add.
+  void QueueVerify(const Header* header);
+  void StopVerifyThread();
+  static void* VerifyThread(void* arg);
 
   pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
   std::deque<const Header*> list_;
   std::vector<uint8_t> cmp_mem_;
-  std::unordered_map<const Header*, BacktraceHeader*> backtraces_;
+  std::unordered_map<const Header*, const BacktraceHeader*> backtraces_;
   size_t backtrace_num_frames_;
 
+  bool verify_thread_ = false;
+  size_t verify_queue_size_ = 0;
+  pthread_mutex_t verify_lock_ = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t verify_cond_ = PTHREAD_COND_INITIALIZER;
+  // Allocations that have left list_ but have not been verified yet.
+  std::deque<const Header*> verify_queue_;
+  bool verify_thread_started_ = false;
+  bool verify_thread_stop_ = false;
+  pthread_t verify_thread_id_;
+
   DISALLOW_COPY_AND_ASSIGN(FreeTrackData);
 };
 
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <private/bionic_macros.h>
+
+#include "backtrace.h"
+#include "Config.h"
+#include "DebugData.h"
+#include "debug_log.h"
+#include "GuardPageData.h"
+#include "malloc_debug.h"
+
+static void FaultHandler(int signal, siginfo_t* info, void* context) {
+  GuardPageData* guard_pages = (g_debug != nullptr) ? g_debug->guard_pages.get() : nullptr;
+  if (guard_pages == nullptr) {
+    return;
+  }
+
+  const struct sigaction& previous = guard_pages->previous_action();
+  if (guard_pages->LogFault(reinterpret_cast<uintptr_t>(info->si_addr))) {
+    // Put back the previous handler, and let the faulting instruction run
+    // again so that the crash is reported as usual.
+    sigaction(signal, &previous, nullptr);
+    return;
+  }
+
+  if (previous.sa_flags & SA_SIGINFO) {
+    previous.sa_sigaction(signal, info, context);
+  } else if (previous.sa_handler == SIG_DFL || previous.sa_handler == SIG_IGN) {
+    sigaction(signal, &previous, nullptr);
+  } else {
+    previous.sa_handler(signal);
+  }
+}
+
+GuardPageData::GuardPageData(DebugData* debug_data, const Config& config)
+    : OptionData(debug_data), sample_rate_(config.guard_pages_sample_rate),
+      page_size_(getpagesize()) {
+}
+
+bool GuardPageData::Initialize(const Config& config) {
+  size_t num_slots = config.guard_pages_slots;
+
+  // Every slot has a data page, and there is a guard page on both sides.
+  size_t pool_size = (2 * num_slots + 1) * page_size_;
+  void* pool = mmap(nullptr, pool_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                    -1, 0);
+  if (pool == MAP_FAILED) {
+    error_log("Unable to allocate the guard page pool: %s", strerror(errno));
+    return false;
+  }
+  pool_start_ = reinterpret_cast<uintptr_t>(pool);
+  pool_size_ = pool_size;
+
+  slots_.resize(num_slots);
+  for (size_t i = 0; i < num_slots; i++) {
+    free_slots_.push_back(i);
+  }
+
+  int error = pthread_key_create(&sample_key_, nullptr);
+  if (error != 0) {
+    error_log("Unable to create guard page sampling key: %s", strerror(error));
+    return false;
+  }
+  sample_key_created_ = true;
+
+  struct sigaction fault_act;
+  memset(&fault_act, 0, sizeof(fault_act));
+  fault_act.sa_sigaction = FaultHandler;
+  fault_act.sa_flags = SA_SIGINFO | SA_ONSTACK;
+  sigemptyset(&fault_act.sa_mask);
+  if (sigaction(SIGSEGV, &fault_act, &previous_action_) != 0) {
+    error_log("Unable to set up the guard page fault handler: %s", strerror(errno));
+    return false;
+  }
+  handler_installed_ = true;
+  return true;
+}
+
+GuardPageData::~GuardPageData() {
+  if (handler_installed_) {
+    sigaction(SIGSEGV, &previous_action_, nullptr);
+  }
+  if (sample_key_created_) {
+    pthread_key_delete(sample_key_);
+  }
+  if (pool_size_ != 0) {
+    munmap(reinterpret_cast<void*>(pool_start_), pool_size_);
+  }
+}
+
+uintptr_t GuardPageData::NextSampleCount() {
+  // Spread the samples randomly around the average rate, so that a fixed
+  // allocation pattern does not always hit or always miss the pool.
+  return 1 + random() % (2 * sample_rate_ - 1);
+}
+
+bool GuardPageData::ShouldSample() {
+  uintptr_t count = reinterpret_cast<uintptr_t>(pthread_getspecific(sample_key_));
+  if (count == 0) {
+    // This is the first allocation on the thread.
+    count = NextSampleCount();
+  }
+  if (count > 1) {
+    pthread_setspecific(sample_key_, reinterpret_cast<void*>(count - 1));
+    return false;
+  }
+
+  pthread_setspecific(sample_key_, reinterpret_cast<void*>(NextSampleCount()));
+  return true;
+}
+
+void* GuardPageData::Allocate(size_t size) {
+  if (size > page_size_) {
+    return nullptr;
+  }
+
+  pthread_mutex_lock(&mutex_);
+  if (free_slots_.empty()) {
+    pthread_mutex_unlock(&mutex_);
+    return nullptr;
+  }
+  size_t index = free_slots_.front();
+  free_slots_.pop_front();
+  pthread_mutex_unlock(&mutex_);
+
+  uintptr_t page = SlotPage(index);
+  if (mprotect(reinterpret_cast<void*>(page), page_size_, PROT_READ | PROT_WRITE) != 0) {
+    pthread_mutex_lock(&mutex_);
+    free_slots_.push_front(index);
+    pthread_mutex_unlock(&mutex_);
+    return nullptr;
+  }
+
+  // Put the allocation at the end of the page, the only bytes left between
+  // it and the guard page are those needed to keep the alignment.
+  Slot& slot = slots_[index];
+  slot.pointer = page + page_size_ - BIONIC_ALIGN(size, MINIMUM_ALIGNMENT_BYTES);
+  slot.size = size;
+  slot.num_alloc_frames = backtrace_get(slot.alloc_frames, kBacktraceFrames);
+  slot.num_free_frames = 0;
+  slot.allocated = true;
+  return reinterpret_cast<void*>(slot.pointer);
+}
+
+size_t GuardPageData::AddressToSlot(uintptr_t address) {
+  size_t page = (address - pool_start_) / page_size_;
+  if (page == 0) {
+    return 0;
+  }
+  return (page - 1) / 2;
+}
+
+void GuardPageData::Free(void* pointer) {
+  uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+  size_t index = AddressToSlot(value);
+  if (index >= slots_.size()) {
+    index = slots_.size() - 1;
+  }
+  Slot& slot = slots_[index];
+
+  pthread_mutex_lock(&mutex_);
+  if (!slot.allocated || slot.pointer != value) {
+    pthread_mutex_unlock(&mutex_);
+    error_log(LOG_DIVIDER);
+    if (slot.pointer == value) {
+      error_log("+++ ALLOCATION %p USED AFTER FREE (free)", pointer);
+      LogSlot(slot);
+    } else {
+      error_log("+++ ALLOCATION %p IS NOT A GUARD PAGE ALLOCATION (free)", pointer);
+    }
+    error_log("Backtrace at time of failure:");
+    uintptr_t frames[kBacktraceFrames];
+    size_t num_frames = backtrace_get(frames, kBacktraceFrames);
+    backtrace_log(frames, num_frames);
+    error_log(LOG_DIVIDER);
+    return;
+  }
+  slot.allocated = false;
+  pthread_mutex_unlock(&mutex_);
+
+  slot.num_free_frames = backtrace_get(slot.free_frames, kBacktraceFrames);
+
+  // Dropping the page also means that the next use of the slot starts out
+  // zero filled.
+  void* page = reinterpret_cast<void*>(SlotPage(index));
+  mprotect(page, page_size_, PROT_NONE);
+  madvise(page, page_size_, MADV_DONTNEED);
+
+  pthread_mutex_lock(&mutex_);
+  free_slots_.push_back(index);
+  pthread_mutex_unlock(&mutex_);
+}
+
+size_t GuardPageData::UsableSize(const void* pointer) {
+  size_t index = AddressToSlot(reinterpret_cast<uintptr_t>(pointer));
+  if (index >= slots_.size() || !slots_[index].allocated) {
+    return 0;
+  }
+  return slots_[index].size;
+}
+
+// Only uses functions that are safe to call from the fault handler, so the
+// backtraces are logged as raw pc values.
+void GuardPageData::LogSlot(const Slot& slot) {
+  if (slot.num_alloc_frames > 0) {
+    error_log("Backtrace at time of allocation:");
+    for (size_t i = 0; i < slot.num_alloc_frames; i++) {
+      error_log("          #%02zu  pc %p", i, reinterpret_cast<void*>(slot.alloc_frames[i]));
+    }
+  }
+  if (!slot.allocated && slot.num_free_frames > 0) {
+    error_log("Backtrace at time of free:");
+    for (size_t i = 0; i < slot.num_free_frames; i++) {
+      error_log("          #%02zu  pc %p", i, reinterpret_cast<void*>(slot.free_frames[i]));
+    }
+  }
+}
+
+bool GuardPageData::LogFault(uintptr_t address) {
+  if (!Contains(reinterpret_cast<void*>(address))) {
+    return false;
+  }
+
+  size_t page = (address - pool_start_) / page_size_;
+  size_t index;
+  const char* reason;
+  if (page % 2 == 1) {
+    index = page / 2;
+    reason = "USED AFTER FREE";
+  } else if (page > 0 && slots_[page / 2 - 1].pointer != 0) {
+    // The guard page after a slot that has been used.
+    index = page / 2 - 1;
+    reason = "HAS A BUFFER OVERFLOW";
+  } else {
+    index = (page / 2 < slots_.size()) ? page / 2 : slots_.size() - 1;
+    reason = "HAS A BUFFER UNDERFLOW";
+  }
+
+  const Slot& slot = slots_[index];
+  error_log(LOG_DIVIDER);
+  if (slot.pointer == 0) {
+    error_log("+++ INVALID ACCESS OF GUARD PAGE MEMORY AT %p", reinterpret_cast<void*>(address));
+  } else {
+    error_log("+++ ALLOCATION %p SIZE %zu %s AT %p", reinterpret_cast<void*>(slot.pointer),
+              slot.size, reason, reinterpret_cast<void*>(address));
+    LogSlot(slot);
+  }
+  error_log(LOG_DIVIDER);
+  return true;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef DEBUG_MALLOC_GUARDPAGEDATA_H
+#define DEBUG_MALLOC_GUARDPAGEDATA_H
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+#include <private/bionic_macros.h>
+
+#include "OptionData.h"
+
+// Forward declarations.
+struct Config;
+
+// Serves a random sample of allocations from a pool of pages that are each
+// surrounded by inaccessible guard pages. Every sampled allocation ends at
+// the end of its page, so an overflow faults right away, and the page is
+// made inaccessible when freed, so a use after free faults right away.
+class GuardPageData : public OptionData {
+ public:
+  GuardPageData(DebugData* debug_data, const Config& config);
+  virtual ~GuardPageData();
+
+  bool Initialize(const Config& config);
+
+  // Returns whether this allocation should come from the pool. About one
+  // in every guard_pages allocations made by a thread is sampled.
+  bool ShouldSample();
+
+  // Returns nullptr if the allocation does not fit in a page, or if every
+  // slot in the pool is in use.
+  void* Allocate(size_t size);
+  void Free(void* pointer);
+  size_t UsableSize(const void* pointer);
+
+  bool Contains(const void* pointer) {
+    return reinterpret_cast<uintptr_t>(pointer) - pool_start_ < pool_size_;
+  }
+
+  // Logs the allocation that a fault at the address hit. Returns false if
+  // the address is not in the pool.
+  bool LogFault(uintptr_t address);
+
+  void PrepareFork() { pthread_mutex_lock(&mutex_); }
+  void PostForkParent() { pthread_mutex_unlock(&mutex_); }
+  void PostForkChild() { pthread_mutex_init(&mutex_, NULL); }
+
+  const struct sigaction& previous_action() { return previous_action_; }
+
+ private:
+  static constexpr size_t kBacktraceFrames = 16;
+
+  struct Slot {
+    uintptr_t pointer = 0;
+    size_t size = 0;
+    bool allocated = false;
+    size_t num_alloc_frames = 0;
+    uintptr_t alloc_frames[kBacktraceFrames];
+    size_t num_free_frames = 0;
+    uintptr_t free_frames[kBacktraceFrames];
+  };
+
+  uintptr_t SlotPage(size_t slot) { return pool_start_ + (2 * slot + 1) * page_size_; }
+  // Returns the slot whose data page, or the guard page after it, holds
+  // the address.
+  size_t AddressToSlot(uintptr_t address);
+  void LogSlot(const Slot& slot);
+  uintptr_t NextSampleCount();
+
+  size_t sample_rate_;
+  size_t page_size_;
+  uintptr_t pool_start_ = 0;
+  size_t pool_size_ = 0;
+
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  std::vector<Slot> slots_;
+  // Freed slots are reused oldest first, so that a freed page stays
+  // inaccessible for as long as possible.
+  std::deque<size_t> free_slots_;
+
+  // Per thread, the number of allocations left until the next sample.
+  pthread_key_t sample_key_;
+  bool sample_key_created_ = false;
+
+  struct sigaction previous_action_;
+  bool handler_installed_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(GuardPageData);
+};
+
+#endif // DEBUG_MALLOC_GUARDPAGEDATA_H
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "HeapProfile.h"
+#include "MapData.h"
+
+// Just enough of the protocol buffer wire format to write a profile.
+class ProtoWriter {
+ public:
+  void Uint64Field(uint32_t field, uint64_t value) {
+    Tag(field, kVarint);
+    Varint(value);
+  }
+
+  void BytesField(uint32_t field, const std::string& value) {
+    Tag(field, kLengthDelimited);
+    Varint(value.size());
+    buffer_ += value;
+  }
+
+  void MessageField(uint32_t field, const ProtoWriter& message) {
+    BytesField(field, message.data());
+  }
+
+  void PackedField(uint32_t field, const std::vector<uint64_t>& values) {
+    ProtoWriter packed;
+    for (uint64_t value : values) {
+      packed.Varint(value);
+    }
+    BytesField(field, packed.data());
+  }
+
+  const std::string& data() const { return buffer_; }
+
+ private:
+  static constexpr uint32_t kVarint = 0;
+  static constexpr uint32_t kLengthDelimited = 2;
+
+  void Tag(uint32_t field, uint32_t wire_type) { Varint((field << 3) | wire_type); }
+
+  void Varint(uint64_t value) {
+    while (value >= 0x80) {
+      buffer_ += static_cast<char>((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    buffer_ += static_cast<char>(value);
+  }
+
+  std::string buffer_;
+};
+
+// Field numbers from profile.proto.
+enum ProfileField : uint32_t {
+  kProfileSampleType = 1,
+  kProfileSample = 2,
+  kProfileMapping = 3,
+  kProfileLocation = 4,
+  kProfileStringTable = 6,
+};
+enum ValueTypeField : uint32_t {
+  kValueTypeType = 1,
+  kValueTypeUnit = 2,
+};
+enum SampleField : uint32_t {
+  kSampleLocationId = 1,
+  kSampleValue = 2,
+};
+enum MappingField : uint32_t {
+  kMappingId = 1,
+  kMappingMemoryStart = 2,
+  kMappingMemoryLimit = 3,
+  kMappingFileOffset = 4,
+  kMappingFilename = 5,
+};
+enum LocationField : uint32_t {
+  kLocationId = 1,
+  kLocationMappingId = 2,
+  kLocationAddress = 3,
+};
+
+class StringTable {
+ public:
+  StringTable() { Index(""); }
+
+  uint64_t Index(const std::string& value) {
+    auto entry = indexes_.find(value);
+    if (entry != indexes_.end()) {
+      return entry->second;
+    }
+    strings_.push_back(value);
+    indexes_[value] = strings_.size() - 1;
+    return strings_.size() - 1;
+  }
+
+  const std::vector<std::string>& strings() { return strings_; }
+
+ private:
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, uint64_t> indexes_;
+};
+
+static bool WriteAll(int fd, const std::string& data) {
+  const char* p = data.data();
+  size_t bytes = data.size();
+  while (bytes > 0) {
+    ssize_t written = write(fd, p, bytes);
+    if (written == -1 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    p += written;
+    bytes -= written;
+  }
+  return true;
+}
+
+bool WriteHeapProfile(int fd, const std::vector<HeapProfileSample>& samples) {
+  ProtoWriter profile;
+  StringTable strings;
+
+  const char* const sample_types[][2] = {
+    { "inuse_objects", "count" },
+    { "inuse_space", "bytes" },
+  };
+  for (const auto& sample_type : sample_types) {
+    ProtoWriter value_type;
+    value_type.Uint64Field(kValueTypeType, strings.Index(sample_type[0]));
+    value_type.Uint64Field(kValueTypeUnit, strings.Index(sample_type[1]));
+    profile.MessageField(kProfileSampleType, value_type);
+  }
+
+  // Repeated fields don't need to be contiguous, so each mapping and
+  // location is written out the first time a frame needs it.
+  MapData maps;
+  std::unordered_map<const MapEntry*, uint64_t> mapping_ids;
+  std::unordered_map<uintptr_t, uint64_t> location_ids;
+  for (const auto& sample : samples) {
+    std::vector<uint64_t> sample_locations;
+    for (uintptr_t pc : sample.frames) {
+      auto location = location_ids.find(pc);
+      if (location != location_ids.end()) {
+        sample_locations.push_back(location->second);
+        continue;
+      }
+
+      uint64_t mapping_id = 0;
+      const MapEntry* entry = maps.find(pc);
+      if (entry != nullptr) {
+        auto mapping = mapping_ids.find(entry);
+        if (mapping != mapping_ids.end()) {
+          mapping_id = mapping->second;
+        } else {
+          mapping_id = mapping_ids.size() + 1;
+          mapping_ids[entry] = mapping_id;
+          ProtoWriter message;
+          message.Uint64Field(kMappingId, mapping_id);
+          message.Uint64Field(kMappingMemoryStart, entry->start);
+          message.Uint64Field(kMappingMemoryLimit, entry->end);
+          message.Uint64Field(kMappingFileOffset, entry->offset);
+          message.Uint64Field(kMappingFilename, strings.Index(entry->name));
+          profile.MessageField(kProfileMapping, message);
+        }
+      }
+
+      uint64_t location_id = location_ids.size() + 1;
+      location_ids[pc] = location_id;
+      ProtoWriter message;
+      message.Uint64Field(kLocationId, location_id);
+      if (mapping_id != 0) {
+        message.Uint64Field(kLocationMappingId, mapping_id);
+      }
+      message.Uint64Field(kLocationAddress, pc);
+      profile.MessageField(kProfileLocation, message);
+      sample_locations.push_back(location_id);
+    }
+
+    ProtoWriter message;
+    message.PackedField(kSampleLocationId, sample_locations);
+    message.PackedField(kSampleValue, { sample.count, sample.bytes });
+    profile.MessageField(kProfileSample, message);
+  }
+
+  for (const auto& value : strings.strings()) {
+    profile.BytesField(kProfileStringTable, value);
+  }
+
+  return WriteAll(fd, profile.data());
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Config.h"
+#include "DebugData.h"
+#include "MappedAllocData.h"
+#include "malloc_debug.h"
+
+MappedAllocData::MappedAllocData(DebugData* debug_data, const Config& config)
+    : OptionData(debug_data),
+      min_bytes_(config.mremap_realloc_bytes),
+      page_size_(getpagesize()) {
+}
+
+Header* MappedAllocData::Allocate(size_t real_size, size_t* map_size) {
+  size_t size = MapSize(real_size);
+  void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return nullptr;
+  }
+
+  pthread_mutex_lock(&mutex_);
+  mappings_[reinterpret_cast<uintptr_t>(map)] = size;
+  pthread_mutex_unlock(&mutex_);
+  *map_size = size;
+  return reinterpret_cast<Header*>(map);
+}
+
+Header* MappedAllocData::Reallocate(Header* header, size_t real_size, size_t* map_size) {
+  size_t size = MapSize(real_size);
+
+  pthread_mutex_lock(&mutex_);
+  auto entry = mappings_.find(reinterpret_cast<uintptr_t>(header));
+  if (entry == mappings_.end()) {
+    pthread_mutex_unlock(&mutex_);
+    return nullptr;
+  }
+  void* map = header;
+  if (size != entry->second) {
+    map = mremap(header, entry->second, size, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) {
+      pthread_mutex_unlock(&mutex_);
+      return nullptr;
+    }
+    mappings_.erase(entry);
+    mappings_[reinterpret_cast<uintptr_t>(map)] = size;
+  }
+  pthread_mutex_unlock(&mutex_);
+  *map_size = size;
+  return reinterpret_cast<Header*>(map);
+}
+
+bool MappedAllocData::Free(const Header* header) {
+  pthread_mutex_lock(&mutex_);
+  auto entry = mappings_.find(reinterpret_cast<uintptr_t>(header));
+  if (entry == mappings_.end()) {
+    pthread_mutex_unlock(&mutex_);
+    return false;
+  }
+  size_t size = entry->second;
+  mappings_.erase(entry);
+  pthread_mutex_unlock(&mutex_);
+
+  munmap(const_cast<Header*>(header), size);
+  return true;
+}
+
+bool MappedAllocData::Contains(const Header* header) {
+  pthread_mutex_lock(&mutex_);
+  bool found = mappings_.count(reinterpret_cast<uintptr_t>(header)) != 0;
+  pthread_mutex_unlock(&mutex_);
+  return found;
+}
+
+void MappedAllocData::Iterate(uintptr_t base, size_t size,
+                              void (*callback)(uintptr_t, size_t, void*), void* arg) {
+  pthread_mutex_lock(&mutex_);
+  for (auto entry = mappings_.lower_bound(base);
+       entry != mappings_.end() && entry->first - base < size; ++entry) {
+    callback(entry->first, entry->second, arg);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
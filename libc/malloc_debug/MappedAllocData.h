@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef DEBUG_MALLOC_MAPPEDALLOCDATA_H
+#define DEBUG_MALLOC_MAPPEDALLOCDATA_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <map>
+
+#include <private/bionic_macros.h>
+
+#include "OptionData.h"
+
+// Forward declarations.
+struct Config;
+struct Header;
+
+// Gives each large allocation a mapping of its own, with the header at the
+// start of the mapping, so that realloc can grow the allocation in place,
+// or move it, with mremap instead of copying it.
+class MappedAllocData : public OptionData {
+ public:
+  MappedAllocData(DebugData* debug_data, const Config& config);
+  virtual ~MappedAllocData() = default;
+
+  // real_size includes the header and any other extra bytes.
+  bool ShouldMap(size_t real_size) { return real_size >= min_bytes_; }
+
+  // Returns nullptr if the mapping fails. Otherwise *map_size is set to the
+  // size of the new mapping.
+  Header* Allocate(size_t real_size, size_t* map_size);
+  // Resizes the mapping that starts at header so that it holds real_size
+  // bytes, moving it if it can't grow in place. Returns nullptr, leaving
+  // the mapping as it was, if that fails.
+  Header* Reallocate(Header* header, size_t real_size, size_t* map_size);
+  // Returns false if header is not the start of one of these mappings.
+  bool Free(const Header* header);
+  bool Contains(const Header* header);
+
+  // Calls callback with the start and size of each mapping that starts in
+  // [base, base + size).
+  void Iterate(uintptr_t base, size_t size, void (*callback)(uintptr_t, size_t, void*), void* arg);
+
+  void PrepareFork() { pthread_mutex_lock(&mutex_); }
+  void PostForkParent() { pthread_mutex_unlock(&mutex_); }
+  void PostForkChild() { pthread_mutex_init(&mutex_, NULL); }
+
+ private:
+  size_t MapSize(size_t real_size) { return BIONIC_ALIGN(real_size, page_size_); }
+
+  size_t min_bytes_;
+  size_t page_size_;
+
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  // The size of each mapping, by its start.
+  std::map<uintptr_t, size_t> mappings_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedAllocData);
+};
+
+#endif // DEBUG_MALLOC_MAPPEDALLOCDATA_H
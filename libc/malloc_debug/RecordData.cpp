@@ -28,6 +28,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdint.h>
@@ -37,6 +38,7 @@
 
 #include <mutex>
 
+#include <android-base/file.h>
 #include <android-base/stringprintf.h>
 
 #include "Config.h"
@@ -45,13 +47,29 @@
 #include "DebugData.h"
 #include "RecordData.h"
 
+// The number of entries buffered before the stream thread writes them out.
+static constexpr size_t RECORD_STREAM_BUFFER_ENTRIES = 4096;
+
 RecordEntry::RecordEntry() : tid_(gettid()) {
 }
 
+static void SetBinary(RecordBinaryEntry* binary, RecordBinaryType type, pid_t tid,
+                      const void* pointer, size_t size, uint64_t arg) {
+  binary->type = type;
+  binary->tid = tid;
+  binary->pointer = reinterpret_cast<uintptr_t>(pointer);
+  binary->size = size;
+  binary->arg = arg;
+}
+
 std::string ThreadCompleteEntry::GetString() const {
   return android::base::StringPrintf("%d: thread_done 0x0\n", tid_);
 }
 
+void ThreadCompleteEntry::GetBinary(RecordBinaryEntry* binary) const {
+  SetBinary(binary, RECORD_BINARY_THREAD_DONE, tid_, nullptr, 0, 0);
+}
+
 AllocEntry::AllocEntry(void* pointer) : pointer_(pointer) {
 }
 
@@ -62,6 +80,10 @@ std::string MallocEntry::GetString() const {
   return android::base::StringPrintf("%d: malloc %p %zu\n", tid_, pointer_, size_);
 }
 
+void MallocEntry::GetBinary(RecordBinaryEntry* binary) const {
+  SetBinary(binary, RECORD_BINARY_MALLOC, tid_, pointer_, size_, 0);
+}
+
 FreeEntry::FreeEntry(void* pointer) : AllocEntry(pointer) {
 }
 
@@ -69,6 +91,10 @@ std::string FreeEntry::GetString() const {
   return android::base::StringPrintf("%d: free %p\n", tid_, pointer_);
 }
 
+void FreeEntry::GetBinary(RecordBinaryEntry* binary) const {
+  SetBinary(binary, RECORD_BINARY_FREE, tid_, pointer_, 0, 0);
+}
+
 CallocEntry::CallocEntry(void* pointer, size_t nmemb, size_t size)
     : MallocEntry(pointer, size), nmemb_(nmemb) {
 }
@@ -77,6 +103,10 @@ std::string CallocEntry::GetString() const {
   return android::base::StringPrintf("%d: calloc %p %zu %zu\n", tid_, pointer_, nmemb_, size_);
 }
 
+void CallocEntry::GetBinary(RecordBinaryEntry* binary) const {
+  SetBinary(binary, RECORD_BINARY_CALLOC, tid_, pointer_, size_, nmemb_);
+}
+
 ReallocEntry::ReallocEntry(void* pointer, size_t size, void* old_pointer)
     : MallocEntry(pointer, size), old_pointer_(old_pointer) {
 }
@@ -86,6 +116,11 @@ std::string ReallocEntry::GetString() const {
                                      old_pointer_, size_);
 }
 
+void ReallocEntry::GetBinary(RecordBinaryEntry* binary) const {
+  SetBinary(binary, RECORD_BINARY_REALLOC, tid_, pointer_, size_,
+            reinterpret_cast<uintptr_t>(old_pointer_));
+}
+
 // posix_memalign, memalgin, pvalloc, valloc all recorded with this class.
 MemalignEntry::MemalignEntry(void* pointer, size_t size, size_t alignment)
     : MallocEntry(pointer, size), alignment_(alignment) {
@@ -96,6 +131,10 @@ std::string MemalignEntry::GetString() const {
                                      alignment_, size_);
 }
 
+void MemalignEntry::GetBinary(RecordBinaryEntry* binary) const {
+  SetBinary(binary, RECORD_BINARY_MEMALIGN, tid_, pointer_, size_, alignment_);
+}
+
 struct ThreadData {
   ThreadData(RecordData* record_data, ThreadCompleteEntry* entry) : record_data(record_data), entry(entry) {}
   RecordData* record_data;
@@ -195,20 +234,188 @@ bool RecordData::Initialize(const Config& config) {
            config.record_allocs_signal, getpid());
 
   num_entries_ = config.record_allocs_num_entries;
-  entries_ = new const RecordEntry*[num_entries_];
   cur_index_ = 0;
   dump_ = false;
   dump_file_ = config.record_allocs_file;
 
+  if (config.record_allocs_stream) {
+    stream_ = true;
+    stream_files_ = config.record_allocs_stream_files;
+    stream_buffer_.reserve(RECORD_STREAM_BUFFER_ENTRIES);
+    stream_write_buffer_.reserve(RECORD_STREAM_BUFFER_ENTRIES);
+  } else {
+    entries_ = new const RecordEntry*[num_entries_];
+  }
+
   return true;
 }
 
 RecordData::~RecordData() {
+  if (stream_thread_started_) {
+    pthread_mutex_lock(&stream_lock_);
+    stream_thread_stop_ = true;
+    pthread_cond_broadcast(&stream_cond_);
+    pthread_mutex_unlock(&stream_lock_);
+    pthread_join(stream_thread_, nullptr);
+  }
+  if (stream_) {
+    WriteStreamEntries(stream_buffer_.data(), stream_buffer_.size());
+    if (stream_fd_ != -1) {
+      close(stream_fd_);
+    }
+  }
   delete [] entries_;
   pthread_key_delete(key_);
 }
 
+void RecordData::PrepareFork() {
+  if (stream_) {
+    pthread_mutex_lock(&stream_lock_);
+  }
+}
+
+void RecordData::PostForkParent() {
+  if (stream_) {
+    pthread_mutex_unlock(&stream_lock_);
+  }
+}
+
+void RecordData::PostForkChild() {
+  if (!stream_) {
+    return;
+  }
+  // The stream thread does not exist in the child. A new one is started
+  // on the next entry, writing to files named after the child's pid.
+  pthread_mutex_init(&stream_lock_, nullptr);
+  pthread_cond_init(&stream_cond_, nullptr);
+  stream_buffer_.clear();
+  stream_write_buffer_.clear();
+  stream_thread_started_ = false;
+  stream_thread_stop_ = false;
+  if (stream_fd_ != -1) {
+    close(stream_fd_);
+    stream_fd_ = -1;
+  }
+  stream_file_entries_ = 0;
+  stream_sequence_ = 0;
+}
+
+bool RecordData::OpenStreamFile() {
+  std::string file_name = android::base::StringPrintf(
+      "%s.%d.%" PRIu64, dump_file_.c_str(), getpid(), stream_sequence_ % stream_files_);
+  stream_fd_ = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                    0755);
+  if (stream_fd_ == -1) {
+    error_log("Cannot create record alloc file %s: %s", file_name.c_str(), strerror(errno));
+    return false;
+  }
+
+  RecordBinaryHeader header;
+  header.magic = RECORD_BINARY_MAGIC;
+  header.version = RECORD_BINARY_VERSION;
+  header.sequence = stream_sequence_++;
+  if (!android::base::WriteFully(stream_fd_, &header, sizeof(header))) {
+    error_log("Failed to write record alloc information: %s", strerror(errno));
+    close(stream_fd_);
+    stream_fd_ = -1;
+    return false;
+  }
+  stream_file_entries_ = 0;
+  return true;
+}
+
+void RecordData::WriteStreamEntries(const RecordBinaryEntry* entries, size_t num_entries) {
+  while (num_entries > 0) {
+    // If the file cannot be created, these entries are lost and the next
+    // batch tries again with the next file of the ring.
+    if (stream_fd_ == -1 && !OpenStreamFile()) {
+      return;
+    }
+
+    size_t to_write = num_entries_ - stream_file_entries_;
+    if (to_write > num_entries) {
+      to_write = num_entries;
+    }
+    if (!android::base::WriteFully(stream_fd_, entries, to_write * sizeof(RecordBinaryEntry))) {
+      error_log("Failed to write record alloc information: %s", strerror(errno));
+      close(stream_fd_);
+      stream_fd_ = -1;
+      return;
+    }
+    entries += to_write;
+    num_entries -= to_write;
+
+    stream_file_entries_ += to_write;
+    if (stream_file_entries_ == num_entries_) {
+      close(stream_fd_);
+      stream_fd_ = -1;
+    }
+  }
+}
+
+void* RecordData::StreamThread(void* arg) {
+  ScopedDisableDebugCalls disable;
+  RecordData* record = reinterpret_cast<RecordData*>(arg);
+
+  pthread_mutex_lock(&record->stream_lock_);
+  while (true) {
+    while (record->stream_write_buffer_.empty() && !record->stream_thread_stop_) {
+      pthread_cond_wait(&record->stream_cond_, &record->stream_lock_);
+    }
+    if (record->stream_write_buffer_.empty()) {
+      break;
+    }
+    pthread_mutex_unlock(&record->stream_lock_);
+
+    record->WriteStreamEntries(record->stream_write_buffer_.data(),
+                               record->stream_write_buffer_.size());
+
+    pthread_mutex_lock(&record->stream_lock_);
+    // Keeps the capacity, so that swapping never allocates.
+    record->stream_write_buffer_.clear();
+    pthread_cond_broadcast(&record->stream_cond_);
+  }
+  pthread_mutex_unlock(&record->stream_lock_);
+  return nullptr;
+}
+
+void RecordData::AddStreamEntry(const RecordEntry* entry) {
+  RecordBinaryEntry binary;
+  entry->GetBinary(&binary);
+  delete entry;
+
+  pthread_mutex_lock(&stream_lock_);
+  if (!stream_thread_started_) {
+    // Started on first use since threads cannot be created while libc
+    // is still initializing.
+    int error = pthread_create(&stream_thread_, nullptr, StreamThread, this);
+    if (error != 0) {
+      pthread_mutex_unlock(&stream_lock_);
+      error_log("Unable to create record alloc stream thread: %s", strerror(error));
+      return;
+    }
+    stream_thread_started_ = true;
+  }
+
+  stream_buffer_.push_back(binary);
+  bool flush = dump_.exchange(false);
+  if (stream_buffer_.size() == RECORD_STREAM_BUFFER_ENTRIES || flush) {
+    // Wait for the stream thread to finish the previous buffer.
+    while (!stream_write_buffer_.empty()) {
+      pthread_cond_wait(&stream_cond_, &stream_lock_);
+    }
+    stream_buffer_.swap(stream_write_buffer_);
+    pthread_cond_broadcast(&stream_cond_);
+  }
+  pthread_mutex_unlock(&stream_lock_);
+}
+
 void RecordData::AddEntryOnly(const RecordEntry* entry) {
+  if (stream_) {
+    AddStreamEntry(entry);
+    return;
+  }
+
   unsigned int entry_index = cur_index_.fetch_add(1);
   if (entry_index < num_entries_) {
     entries_[entry_index] = entry;
@@ -225,7 +432,7 @@ void RecordData::AddEntry(const RecordEntry* entry) {
   AddEntryOnly(entry);
 
   // Check to see if it's time to dump the entries.
-  if (dump_) {
+  if (!stream_ && dump_) {
     Dump();
   }
 }
@@ -36,9 +36,12 @@
 #include <atomic>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <private/bionic_macros.h>
 
+#include "record_binary.h"
+
 class RecordEntry {
  public:
   RecordEntry();
@@ -46,6 +49,8 @@ class RecordEntry {
 
   virtual std::string GetString() const = 0;
 
+  virtual void GetBinary(RecordBinaryEntry* binary) const = 0;
+
  protected:
   pid_t tid_;
 
@@ -60,6 +65,8 @@ class ThreadCompleteEntry : public RecordEntry {
 
   std::string GetString() const override;
 
+  void GetBinary(RecordBinaryEntry* binary) const override;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(ThreadCompleteEntry);
 };
@@ -83,6 +90,8 @@ class MallocEntry : public AllocEntry {
 
   std::string GetString() const override;
 
+  void GetBinary(RecordBinaryEntry* binary) const override;
+
  protected:
   size_t size_;
 
@@ -97,6 +106,8 @@ class FreeEntry : public AllocEntry {
 
   std::string GetString() const override;
 
+  void GetBinary(RecordBinaryEntry* binary) const override;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(FreeEntry);
 };
@@ -108,6 +119,8 @@ class CallocEntry : public MallocEntry {
 
   std::string GetString() const override;
 
+  void GetBinary(RecordBinaryEntry* binary) const override;
+
  protected:
   size_t nmemb_;
 
@@ -122,6 +135,8 @@ class ReallocEntry : public MallocEntry {
 
   std::string GetString() const override;
 
+  void GetBinary(RecordBinaryEntry* binary) const override;
+
  protected:
   void* old_pointer_;
 
@@ -137,6 +152,8 @@ class MemalignEntry : public MallocEntry {
 
   std::string GetString() const override;
 
+  void GetBinary(RecordBinaryEntry* binary) const override;
+
  protected:
   size_t alignment_;
 
@@ -160,9 +177,19 @@ class RecordData {
 
   pthread_key_t key() { return key_; }
 
+  void PrepareFork();
+  void PostForkParent();
+  void PostForkChild();
+
  private:
   void Dump();
 
+  // Used by record_allocs_stream instead of entries_ and Dump.
+  void AddStreamEntry(const RecordEntry* entry);
+  static void* StreamThread(void* arg);
+  void WriteStreamEntries(const RecordBinaryEntry* entries, size_t num_entries);
+  bool OpenStreamFile();
+
   std::mutex dump_lock_;
   pthread_key_t key_;
   const RecordEntry** entries_ = nullptr;
@@ -171,6 +198,22 @@ class RecordData {
   std::atomic_bool dump_;
   std::string dump_file_;
 
+  bool stream_ = false;
+  size_t stream_files_ = 0;
+  pthread_mutex_t stream_lock_ = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t stream_cond_ = PTHREAD_COND_INITIALIZER;
+  // Filled by the allocating threads, then swapped with stream_write_buffer_
+  // once full so that the stream thread can write it out.
+  std::vector<RecordBinaryEntry> stream_buffer_;
+  std::vector<RecordBinaryEntry> stream_write_buffer_;
+  bool stream_thread_started_ = false;
+  bool stream_thread_stop_ = false;
+  pthread_t stream_thread_;
+  // Only accessed by the stream thread, or after it has been joined.
+  int stream_fd_ = -1;
+  size_t stream_file_entries_ = 0;
+  uint64_t stream_sequence_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(RecordData);
 };
 
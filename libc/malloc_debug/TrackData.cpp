@@ -31,16 +31,16 @@
 #include <stdlib.h>
 
 #include <algorithm>
+#include <unordered_map>
 #include <vector>
 
-#include <private/ScopedPthreadMutexLocker.h>
-
 #include "backtrace.h"
 #include "BacktraceData.h"
 #include "Config.h"
 #include "DebugData.h"
 #include "debug_disable.h"
 #include "debug_log.h"
+#include "HeapProfile.h"
 #include "malloc_debug.h"
 #include "TrackData.h"
 
@@ -48,8 +48,10 @@ TrackData::TrackData(DebugData* debug_data) : OptionData(debug_data) {
 }
 
 void TrackData::GetList(std::vector<const Header*>* list) {
-  for (const auto& header : headers_) {
-    list->push_back(header);
+  for (const auto& shard : shards_) {
+    for (const auto& header : shard.headers) {
+      list->push_back(header);
+    }
   }
 
   // Sort by the size of the allocation.
@@ -60,30 +62,51 @@ void TrackData::GetList(std::vector<const Header*>* list) {
 }
 
 void TrackData::Add(const Header* header, bool backtrace_found) {
-  pthread_mutex_lock(&mutex_);
+  Shard& shard = GetShard(header);
+  pthread_mutex_lock(&shard.mutex);
   if (backtrace_found) {
-    total_backtrace_allocs_++;
+    shard.backtrace_allocs++;
   }
-  headers_.insert(header);
-  pthread_mutex_unlock(&mutex_);
+  shard.headers.insert(header);
+  pthread_mutex_unlock(&shard.mutex);
 }
 
 void TrackData::Remove(const Header* header, bool backtrace_found) {
-  pthread_mutex_lock(&mutex_);
-  headers_.erase(header);
+  Shard& shard = GetShard(header);
+  pthread_mutex_lock(&shard.mutex);
+  shard.headers.erase(header);
   if (backtrace_found) {
-    total_backtrace_allocs_--;
+    shard.backtrace_allocs--;
   }
-  pthread_mutex_unlock(&mutex_);
+  pthread_mutex_unlock(&shard.mutex);
 }
 
 bool TrackData::Contains(const Header* header) {
-  pthread_mutex_lock(&mutex_);
-  bool found = headers_.count(header);
-  pthread_mutex_unlock(&mutex_);
+  Shard& shard = GetShard(header);
+  pthread_mutex_lock(&shard.mutex);
+  bool found = shard.headers.count(header);
+  pthread_mutex_unlock(&shard.mutex);
   return found;
 }
 
+void TrackData::LockAll() {
+  for (auto& shard : shards_) {
+    pthread_mutex_lock(&shard.mutex);
+  }
+}
+
+void TrackData::UnlockAll() {
+  for (auto& shard : shards_) {
+    pthread_mutex_unlock(&shard.mutex);
+  }
+}
+
+void TrackData::PostForkChild() {
+  for (auto& shard : shards_) {
+    pthread_mutex_init(&shard.mutex, NULL);
+  }
+}
+
 void TrackData::DisplayLeaks() {
   std::vector<const Header*> list;
   GetList(&list);
@@ -93,48 +116,87 @@ void TrackData::DisplayLeaks() {
     error_log("+++ %s leaked block of size %zu at %p (leak %zu of %zu)", getprogname(),
               header->real_size(), debug_->GetPointer(header), ++track_count, list.size());
     if (debug_->config().options & BACKTRACE) {
-      BacktraceHeader* back_header = debug_->GetAllocBacktrace(header);
-      if (back_header->num_frames > 0) {
+      const BacktraceHeader* back_header = debug_->GetAllocBacktrace(header);
+      if (back_header != nullptr) {
         error_log("Backtrace at time of allocation:");
         backtrace_log(&back_header->frames[0], back_header->num_frames);
       }
     }
-    g_dispatch->free(header->orig_pointer);
+    debug_->FreeHeader(header);
   }
 }
 
 void TrackData::GetInfo(uint8_t** info, size_t* overall_size, size_t* info_size,
                         size_t* total_memory, size_t* backtrace_size) {
-  ScopedPthreadMutexLocker scoped(&mutex_);
+  LockAll();
+  GetInfoLocked(info, overall_size, info_size, total_memory, backtrace_size);
+  UnlockAll();
+}
 
-  if (headers_.size() == 0 || total_backtrace_allocs_ == 0) {
+void TrackData::GetInfoLocked(uint8_t** info, size_t* overall_size, size_t* info_size,
+                              size_t* total_memory, size_t* backtrace_size) {
+  size_t total_backtrace_allocs = 0;
+  for (const auto& shard : shards_) {
+    total_backtrace_allocs += shard.backtrace_allocs;
+  }
+  if (total_backtrace_allocs == 0) {
     return;
   }
 
   *backtrace_size = debug_->config().backtrace_frames;
   *info_size = sizeof(size_t) * 2 + sizeof(uintptr_t) * *backtrace_size;
-  *info = reinterpret_cast<uint8_t*>(g_dispatch->calloc(*info_size, total_backtrace_allocs_));
+  *info = reinterpret_cast<uint8_t*>(g_dispatch->calloc(*info_size, total_backtrace_allocs));
   if (*info == nullptr) {
     return;
   }
-  *overall_size = *info_size * total_backtrace_allocs_;
+  *overall_size = *info_size * total_backtrace_allocs;
 
   std::vector<const Header*> list;
   GetList(&list);
 
   uint8_t* data = *info;
-  size_t num_allocations = 1;
   for (const auto& header : list) {
-    BacktraceHeader* back_header = debug_->GetAllocBacktrace(header);
-    if (back_header->num_frames > 0) {
+    const BacktraceHeader* back_header = debug_->GetAllocBacktrace(header);
+    if (back_header != nullptr) {
+      // With backtrace_sample_bytes, each sampled allocation stands for
+      // all the unsampled ones of its size around it.
+      size_t num_allocations = debug_->backtrace->SampleWeight(header->real_size());
       memcpy(data, &header->size, sizeof(size_t));
       memcpy(&data[sizeof(size_t)], &num_allocations, sizeof(size_t));
       memcpy(&data[2 * sizeof(size_t)], &back_header->frames[0],
             back_header->num_frames * sizeof(uintptr_t));
 
-      *total_memory += header->real_size();
+      *total_memory += header->real_size() * num_allocations;
 
       data += *info_size;
     }
   }
 }
+
+void TrackData::GetProfile(std::vector<HeapProfileSample>* samples) {
+  // Identical backtraces share one BacktraceHeader, so it identifies the
+  // stack. The frames are copied since the header may be released as soon
+  // as the lock is dropped.
+  std::unordered_map<const BacktraceHeader*, size_t> indexes;
+  LockAll();
+  for (const auto& shard : shards_) {
+    for (const auto& header : shard.headers) {
+      const BacktraceHeader* back_header = debug_->GetAllocBacktrace(header);
+      if (back_header == nullptr) {
+        continue;
+      }
+      auto entry = indexes.find(back_header);
+      if (entry == indexes.end()) {
+        entry = indexes.emplace(back_header, samples->size()).first;
+        samples->emplace_back();
+        samples->back().frames.assign(&back_header->frames[0],
+                                      &back_header->frames[back_header->num_frames]);
+      }
+      HeapProfileSample& sample = (*samples)[entry->second];
+      size_t num_allocations = debug_->backtrace->SampleWeight(header->real_size());
+      sample.count += num_allocations;
+      sample.bytes += header->real_size() * num_allocations;
+    }
+  }
+  UnlockAll();
+}
@@ -41,9 +41,13 @@
 
 // Forward declarations.
 struct Header;
+struct HeapProfileSample;
 struct Config;
 class DebugData;
 
+// The tracked allocations are spread over independently locked shards, chosen
+// by the address of the header, so that threads allocating and freeing at the
+// same time rarely contend on the same lock.
 class TrackData : public OptionData {
  public:
   TrackData(DebugData* debug_data);
@@ -62,14 +66,35 @@ class TrackData : public OptionData {
 
   void DisplayLeaks();
 
-  void PrepareFork() { pthread_mutex_lock(&mutex_); }
-  void PostForkParent() { pthread_mutex_unlock(&mutex_); }
-  void PostForkChild() { pthread_mutex_init(&mutex_, NULL); }
+  // Adds one sample for each distinct backtrace of the live allocations.
+  void GetProfile(std::vector<HeapProfileSample>* samples);
+
+  void PrepareFork() { LockAll(); }
+  void PostForkParent() { UnlockAll(); }
+  void PostForkChild();
 
  private:
-  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
-  std::unordered_set<const Header*> headers_;
-  size_t total_backtrace_allocs_ = 0;
+  static constexpr size_t kNumShards = 64;
+
+  struct Shard {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    std::unordered_set<const Header*> headers;
+    size_t backtrace_allocs = 0;
+  };
+
+  Shard& GetShard(const Header* header) {
+    // Headers are at least 16 byte aligned, so the low bits carry no information.
+    uintptr_t value = reinterpret_cast<uintptr_t>(header) >> 4;
+    return shards_[(value ^ (value >> 8)) % kNumShards];
+  }
+
+  void LockAll();
+  void UnlockAll();
+
+  void GetInfoLocked(uint8_t** info, size_t* overall_size, size_t* info_size,
+                     size_t* total_memory, size_t* backtrace_size);
+
+  Shard shards_[kNumShards];
 
   DISALLOW_COPY_AND_ASSIGN(TrackData);
 };
@@ -28,6 +28,8 @@
 
 #include <pthread.h>
 
+#include <private/bionic_tls.h>
+
 #include "DebugData.h"
 #include "debug_disable.h"
 #include "debug_log.h"
@@ -35,7 +37,8 @@
 pthread_key_t g_disable_key;
 
 bool DebugCallsDisabled() {
-  if (g_debug == nullptr || pthread_getspecific(g_disable_key) != nullptr) {
+  // This runs on every allocation, and g_disable_key lives as long as g_debug does.
+  if (g_debug == nullptr || __pthread_getspecific_unchecked(g_disable_key) != nullptr) {
     return true;
   }
   return false;
@@ -37,12 +37,14 @@
 #include <vector>
 
 #include <private/bionic_malloc_dispatch.h>
+#include <private/bionic_mutex_contention.h>
 
 #include "backtrace.h"
 #include "Config.h"
 #include "DebugData.h"
 #include "debug_disable.h"
 #include "debug_log.h"
+#include "HeapProfile.h"
 #include "malloc_debug.h"
 
 // ------------------------------------------------------------------------
@@ -53,6 +55,10 @@ DebugData* g_debug;
 int* g_malloc_zygote_child;
 
 const MallocDispatch* g_dispatch;
+
+// Set when malloc debug was enabled after the process started, in which
+// case allocations made before that time have no header.
+static bool g_late_init;
 // ------------------------------------------------------------------------
 
 // ------------------------------------------------------------------------
@@ -64,11 +70,14 @@ __BEGIN_DECLS
 
 bool debug_initialize(const MallocDispatch* malloc_dispatch, int* malloc_zygote_child,
     const char* options);
+bool debug_initialize_late(const MallocDispatch* malloc_dispatch, int* malloc_zygote_child,
+    const char* options);
 void debug_finalize();
 void debug_get_malloc_leak_info(
     uint8_t** info, size_t* overall_size, size_t* info_size, size_t* total_memory,
     size_t* backtrace_size);
 ssize_t debug_malloc_backtrace(void* pointer, uintptr_t* frames, size_t frame_count);
+bool debug_malloc_write_profile(int fd);
 void debug_free_malloc_leak_info(uint8_t* info);
 size_t debug_malloc_usable_size(void* pointer);
 void* debug_malloc(size_t size);
@@ -83,6 +92,7 @@ int debug_iterate(uintptr_t base, size_t size,
     void (*callback)(uintptr_t base, size_t size, void* arg), void* arg);
 void debug_malloc_disable();
 void debug_malloc_enable();
+MutexContentionFunc debug_get_mutex_contention_func(uint32_t* sample_interval);
 
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
 void* debug_pvalloc(size_t bytes);
@@ -115,6 +125,26 @@ static void InitAtfork() {
   });
 }
 
+static bool IsGuardPagePointer(const void* pointer) {
+  return (g_debug->config().options & GUARD_PAGES) && g_debug->guard_pages->Contains(pointer);
+}
+
+// Returns nullptr unless the allocation was sampled for the guard page pool.
+static void* GuardPageAllocate(size_t size) {
+  if ((g_debug->config().options & GUARD_PAGES) && g_debug->guard_pages->ShouldSample()) {
+    return g_debug->guard_pages->Allocate(size);
+  }
+  return nullptr;
+}
+
+// Returns true if the pointer was allocated by the native allocator before
+// malloc debug was enabled, and so must be passed straight through to it.
+// This only does pointer arithmetic, the memory is never dereferenced.
+static bool NotOwned(void* pointer) {
+  return g_late_init && g_debug->need_header() && !IsGuardPagePointer(pointer) &&
+      !g_debug->track->Contains(g_debug->GetHeader(pointer));
+}
+
 static void LogTagError(const Header* header, const void* pointer, const char* name) {
   error_log(LOG_DIVIDER);
   if (header->tag == DEBUG_FREE_TAG) {
@@ -133,17 +163,22 @@ static void LogTagError(const Header* header, const void* pointer, const char* n
   error_log(LOG_DIVIDER);
 }
 
-static void* InitHeader(Header* header, void* orig_pointer, size_t size) {
+// map_size is only set for an allocation with a mapping of its own.
+static void* InitHeader(Header* header, void* orig_pointer, size_t size, size_t map_size = 0) {
   header->tag = DEBUG_TAG;
   header->orig_pointer = orig_pointer;
   header->size = size;
   if (*g_malloc_zygote_child) {
     header->set_zygote();
   }
-  header->usable_size = g_dispatch->malloc_usable_size(orig_pointer);
-  if (header->usable_size == 0) {
-    g_dispatch->free(orig_pointer);
-    return nullptr;
+  if (map_size != 0) {
+    header->usable_size = map_size;
+  } else {
+    header->usable_size = g_dispatch->malloc_usable_size(orig_pointer);
+    if (header->usable_size == 0) {
+      g_dispatch->free(orig_pointer);
+      return nullptr;
+    }
   }
   header->usable_size -= g_debug->pointer_offset() +
       reinterpret_cast<uintptr_t>(header) - reinterpret_cast<uintptr_t>(orig_pointer);
@@ -163,14 +198,14 @@ static void* InitHeader(Header* header, void* orig_pointer, size_t size) {
 
   bool backtrace_found = false;
   if (g_debug->config().options & BACKTRACE) {
-    BacktraceHeader* back_header = g_debug->GetAllocBacktrace(header);
-    if (g_debug->backtrace->enabled()) {
-      back_header->num_frames = backtrace_get(
-          &back_header->frames[0], g_debug->config().backtrace_frames);
-      backtrace_found = back_header->num_frames > 0;
-    } else {
-      back_header->num_frames = 0;
+    const BacktraceHeader* back_header = nullptr;
+    if (g_debug->backtrace->enabled() && g_debug->backtrace->ShouldSample(size)) {
+      uintptr_t frames[MAX_BACKTRACE_FRAMES];
+      size_t num_frames = backtrace_get(frames, g_debug->config().backtrace_frames);
+      back_header = g_debug->backtrace_table->Add(frames, num_frames);
+      backtrace_found = back_header != nullptr;
     }
+    g_debug->SetAllocBacktrace(header, back_header);
   }
 
   if (g_debug->config().options & TRACK_ALLOCS) {
@@ -180,8 +215,65 @@ static void* InitHeader(Header* header, void* orig_pointer, size_t size) {
   return g_debug->GetPointer(header);
 }
 
-bool debug_initialize(const MallocDispatch* malloc_dispatch, int* malloc_zygote_child,
-    const char* options) {
+// Returns nullptr if the allocation is too small to get a mapping of its
+// own, or if the mapping fails.
+static void* MappedAllocate(size_t size, size_t real_size) {
+  if (g_debug->mapped_allocs == nullptr || !g_debug->mapped_allocs->ShouldMap(real_size)) {
+    return nullptr;
+  }
+  size_t map_size;
+  Header* header = g_debug->mapped_allocs->Allocate(real_size, &map_size);
+  if (header == nullptr) {
+    return nullptr;
+  }
+  return InitHeader(header, header, size, map_size);
+}
+
+// Grows an allocation that has a mapping of its own with mremap, which may
+// move it, but never copies it. Returns nullptr, leaving the allocation as
+// it was, on failure.
+static void* MappedReallocate(Header* header, size_t bytes) {
+  if (g_debug->config().options & REAR_GUARD) {
+    if (!g_debug->rear_guard->Valid(header)) {
+      g_debug->rear_guard->LogFailure(header);
+    }
+  }
+
+  bool backtrace_found = false;
+  if (g_debug->config().options & TRACK_ALLOCS) {
+    if (g_debug->config().options & BACKTRACE) {
+      backtrace_found = g_debug->GetAllocBacktrace(header) != nullptr;
+    }
+    g_debug->track->Remove(header, backtrace_found);
+  }
+
+  size_t map_size;
+  Header* new_header =
+      g_debug->mapped_allocs->Reallocate(header, bytes + g_debug->extra_bytes(), &map_size);
+  if (new_header != nullptr) {
+    header = new_header;
+    header->orig_pointer = header;
+    header->size = bytes;
+    if (*g_malloc_zygote_child) {
+      header->set_zygote();
+    }
+    header->usable_size = map_size - g_debug->pointer_offset();
+    if (g_debug->config().options & REAR_GUARD) {
+      uint8_t* guard = g_debug->GetRearGuard(header);
+      memset(guard, g_debug->config().rear_guard_value, g_debug->config().rear_guard_bytes);
+      header->usable_size = header->real_size();
+    }
+  }
+
+  if (g_debug->config().options & TRACK_ALLOCS) {
+    g_debug->track->Add(header, backtrace_found);
+  }
+
+  return (new_header != nullptr) ? g_debug->GetPointer(new_header) : nullptr;
+}
+
+static bool InitializeDebug(const MallocDispatch* malloc_dispatch, int* malloc_zygote_child,
+    const char* options, bool late_init) {
   if (malloc_zygote_child == nullptr || options == nullptr) {
     return false;
   }
@@ -197,11 +289,12 @@ bool debug_initialize(const MallocDispatch* malloc_dispatch, int* malloc_zygote_
   }
 
   DebugData* debug = new DebugData();
-  if (!debug->Initialize(options)) {
+  if (!debug->Initialize(options, late_init)) {
     delete debug;
     DebugDisableFinalize();
     return false;
   }
+  g_late_init = late_init;
   g_debug = debug;
 
   // Always enable the backtrace code since we will use it in a number
@@ -211,6 +304,16 @@ bool debug_initialize(const MallocDispatch* malloc_dispatch, int* malloc_zygote_
   return true;
 }
 
+bool debug_initialize(const MallocDispatch* malloc_dispatch, int* malloc_zygote_child,
+    const char* options) {
+  return InitializeDebug(malloc_dispatch, malloc_zygote_child, options, false);
+}
+
+bool debug_initialize_late(const MallocDispatch* malloc_dispatch, int* malloc_zygote_child,
+    const char* options) {
+  return InitializeDebug(malloc_dispatch, malloc_zygote_child, options, true);
+}
+
 void debug_finalize() {
   if (g_debug == nullptr) {
     return;
@@ -230,6 +333,7 @@ void debug_finalize() {
 
   delete g_debug;
   g_debug = nullptr;
+  g_late_init = false;
 
   DebugDisableFinalize();
 }
@@ -264,7 +368,43 @@ void debug_free_malloc_leak_info(uint8_t* info) {
   g_dispatch->free(info);
 }
 
+bool debug_malloc_write_profile(int fd) {
+  ScopedDisableDebugCalls disable;
+
+  if (!(g_debug->config().options & BACKTRACE)) {
+    error_log("malloc_write_profile: Allocations not being tracked, to enable "
+              "set the option 'backtrace'.");
+    return false;
+  }
+
+  std::vector<HeapProfileSample> samples;
+  g_debug->track->GetProfile(&samples);
+  return WriteHeapProfile(fd, samples);
+}
+
+static void debug_mutex_contention(const void* mutex, uint64_t wait_ns) {
+  // Also keeps Record from being called again if its own lock is contended.
+  if (DebugCallsDisabled()) {
+    return;
+  }
+  ScopedDisableDebugCalls disable;
+
+  g_debug->contention->Record(mutex, wait_ns);
+}
+
+MutexContentionFunc debug_get_mutex_contention_func(uint32_t* sample_interval) {
+  if (g_debug == nullptr || !(g_debug->config().options & MUTEX_CONTENTION)) {
+    return nullptr;
+  }
+  *sample_interval = g_debug->config().mutex_contention_sample_interval;
+  return debug_mutex_contention;
+}
+
 static size_t internal_malloc_usable_size(void* pointer) {
+  if (IsGuardPagePointer(pointer)) {
+    return g_debug->guard_pages->UsableSize(pointer);
+  }
+
   if (g_debug->need_header()) {
     Header* header = g_debug->GetHeader(pointer);
     if (header->tag != DEBUG_TAG) {
@@ -284,6 +424,10 @@ size_t debug_malloc_usable_size(void* pointer) {
   }
   ScopedDisableDebugCalls disable;
 
+  if (NotOwned(pointer)) {
+    return g_dispatch->malloc_usable_size(pointer);
+  }
+
   return internal_malloc_usable_size(pointer);
 }
 
@@ -292,6 +436,11 @@ static void *internal_malloc(size_t size) {
     size = 1;
   }
 
+  void* guard_page_pointer = GuardPageAllocate(size);
+  if (guard_page_pointer != nullptr) {
+    return guard_page_pointer;
+  }
+
   size_t real_size = size + g_debug->extra_bytes();
   if (real_size < size) {
     // Overflow.
@@ -306,12 +455,15 @@ static void *internal_malloc(size_t size) {
       return nullptr;
     }
 
-    Header* header = reinterpret_cast<Header*>(
-        g_dispatch->memalign(MINIMUM_ALIGNMENT_BYTES, real_size));
-    if (header == nullptr) {
-      return nullptr;
+    pointer = MappedAllocate(size, real_size);
+    if (pointer == nullptr) {
+      Header* header = reinterpret_cast<Header*>(
+          g_dispatch->memalign(MINIMUM_ALIGNMENT_BYTES, real_size));
+      if (header == nullptr) {
+        return nullptr;
+      }
+      pointer = InitHeader(header, header, size);
     }
-    pointer = InitHeader(header, header, size);
   } else {
     pointer = g_dispatch->malloc(real_size);
   }
@@ -331,6 +483,10 @@ void* debug_malloc(size_t size) {
   }
   ScopedDisableDebugCalls disable;
 
+  if ((g_debug->config().options & MUTEX_CONTENTION) && g_debug->contention->ShouldDump()) {
+    g_debug->contention->Dump();
+  }
+
   void* pointer = internal_malloc(size);
 
   if (g_debug->config().options & RECORD_ALLOCS) {
@@ -341,7 +497,15 @@ void* debug_malloc(size_t size) {
 }
 
 static void internal_free(void* pointer) {
-  void* free_pointer = pointer;
+  if (NotOwned(pointer)) {
+    g_dispatch->free(pointer);
+    return;
+  }
+  if (IsGuardPagePointer(pointer)) {
+    g_debug->guard_pages->Free(pointer);
+    return;
+  }
+
   size_t bytes;
   Header* header;
   if (g_debug->need_header()) {
@@ -350,7 +514,6 @@ static void internal_free(void* pointer) {
       LogTagError(header, pointer, "free");
       return;
     }
-    free_pointer = header->orig_pointer;
 
     if (g_debug->config().options & FRONT_GUARD) {
       if (!g_debug->front_guard->Valid(header)) {
@@ -366,11 +529,14 @@ static void internal_free(void* pointer) {
     if (g_debug->config().options & TRACK_ALLOCS) {
       bool backtrace_found = false;
       if (g_debug->config().options & BACKTRACE) {
-        BacktraceHeader* back_header = g_debug->GetAllocBacktrace(header);
-        backtrace_found = back_header->num_frames > 0;
+        backtrace_found = g_debug->GetAllocBacktrace(header) != nullptr;
       }
       g_debug->track->Remove(header, backtrace_found);
     }
+    if (g_debug->config().options & BACKTRACE) {
+      g_debug->backtrace_table->Release(g_debug->GetAllocBacktrace(header));
+      g_debug->SetAllocBacktrace(header, nullptr);
+    }
     header->tag = DEBUG_FREE_TAG;
 
     bytes = header->usable_size;
@@ -391,8 +557,10 @@ static void internal_free(void* pointer) {
     // pointer from another thread, while still trying to free it in
     // this function.
     g_debug->free_track->Add(header);
+  } else if (g_debug->need_header()) {
+    g_debug->FreeHeader(header);
   } else {
-    g_dispatch->free(free_pointer);
+    g_dispatch->free(pointer);
   }
 }
 
@@ -402,6 +570,10 @@ void debug_free(void* pointer) {
   }
   ScopedDisableDebugCalls disable;
 
+  if ((g_debug->config().options & MUTEX_CONTENTION) && g_debug->contention->ShouldDump()) {
+    g_debug->contention->Dump();
+  }
+
   if (g_debug->config().options & RECORD_ALLOCS) {
     g_debug->record->AddEntry(new FreeEntry(pointer));
   }
@@ -504,6 +676,40 @@ void* debug_realloc(void* pointer, size_t bytes) {
     return nullptr;
   }
 
+  if (NotOwned(pointer)) {
+    // Move the allocation into one with a header, so that it is tracked
+    // from now on.
+    void* new_pointer = internal_malloc(bytes);
+    if (new_pointer == nullptr) {
+      errno = ENOMEM;
+      return nullptr;
+    }
+    size_t prev_size = g_dispatch->malloc_usable_size(pointer);
+    memcpy(new_pointer, pointer, (prev_size < bytes) ? prev_size : bytes);
+    g_dispatch->free(pointer);
+
+    if (g_debug->config().options & RECORD_ALLOCS) {
+      g_debug->record->AddEntry(new ReallocEntry(new_pointer, bytes, pointer));
+    }
+    return new_pointer;
+  }
+
+  if (IsGuardPagePointer(pointer)) {
+    void* new_pointer = internal_malloc(bytes);
+    if (new_pointer == nullptr) {
+      errno = ENOMEM;
+      return nullptr;
+    }
+    size_t prev_size = g_debug->guard_pages->UsableSize(pointer);
+    memcpy(new_pointer, pointer, (prev_size < bytes) ? prev_size : bytes);
+    g_debug->guard_pages->Free(pointer);
+
+    if (g_debug->config().options & RECORD_ALLOCS) {
+      g_debug->record->AddEntry(new ReallocEntry(new_pointer, bytes, pointer));
+    }
+    return new_pointer;
+  }
+
   size_t real_size = bytes;
   if (g_debug->config().options & EXPAND_ALLOC) {
     real_size += g_debug->config().expand_alloc_bytes;
@@ -551,16 +757,24 @@ void* debug_realloc(void* pointer, size_t bytes) {
       return pointer;
     }
 
-    // Allocate the new size.
-    new_pointer = internal_malloc(bytes);
-    if (new_pointer == nullptr) {
-      errno = ENOMEM;
-      return nullptr;
-    }
-
     prev_size = header->usable_size;
-    memcpy(new_pointer, pointer, prev_size);
-    internal_free(pointer);
+    if (g_debug->mapped_allocs != nullptr && g_debug->mapped_allocs->Contains(header)) {
+      new_pointer = MappedReallocate(header, bytes);
+      if (new_pointer == nullptr) {
+        errno = ENOMEM;
+        return nullptr;
+      }
+    } else {
+      // Allocate the new size.
+      new_pointer = internal_malloc(bytes);
+      if (new_pointer == nullptr) {
+        errno = ENOMEM;
+        return nullptr;
+      }
+
+      memcpy(new_pointer, pointer, prev_size);
+      internal_free(pointer);
+    }
   } else {
     prev_size = g_dispatch->malloc_usable_size(pointer);
     new_pointer = g_dispatch->realloc(pointer, real_size);
@@ -611,7 +825,15 @@ void* debug_calloc(size_t nmemb, size_t bytes) {
     return nullptr;
   }
 
-  void* pointer;
+  // Pages in the guard page pool always start out zero filled.
+  void* pointer = GuardPageAllocate(size);
+  if (pointer != nullptr) {
+    if (g_debug->config().options & RECORD_ALLOCS) {
+      g_debug->record->AddEntry(new CallocEntry(pointer, bytes, nmemb));
+    }
+    return pointer;
+  }
+
   if (g_debug->need_header()) {
     // The above check will guarantee the multiply will not overflow.
     if (size > Header::max_size()) {
@@ -619,14 +841,28 @@ void* debug_calloc(size_t nmemb, size_t bytes) {
       return nullptr;
     }
 
-    // Need to guarantee the alignment of the header.
-    Header* header = reinterpret_cast<Header*>(
-        g_dispatch->memalign(MINIMUM_ALIGNMENT_BYTES, real_size));
-    if (header == nullptr) {
-      return nullptr;
+    // A mapping of its own always starts out zero filled.
+    pointer = MappedAllocate(size, real_size);
+    if (pointer == nullptr) {
+      // Let the native calloc do the zeroing, it knows which pages came
+      // straight from the kernel and are already zero. This matters for
+      // large allocations, where a memset would also fault in every page.
+      Header* header = reinterpret_cast<Header*>(g_dispatch->calloc(1, real_size));
+      if (header != nullptr &&
+          reinterpret_cast<uintptr_t>(header) % MINIMUM_ALIGNMENT_BYTES != 0) {
+        // Need to guarantee the alignment of the header.
+        g_dispatch->free(header);
+        header = reinterpret_cast<Header*>(
+            g_dispatch->memalign(MINIMUM_ALIGNMENT_BYTES, real_size));
+        if (header != nullptr) {
+          memset(header, 0, g_dispatch->malloc_usable_size(header));
+        }
+      }
+      if (header == nullptr) {
+        return nullptr;
+      }
+      pointer = InitHeader(header, header, size);
     }
-    memset(header, 0, g_dispatch->malloc_usable_size(header));
-    pointer = InitHeader(header, header, size);
   } else {
     pointer = g_dispatch->calloc(1, real_size);
   }
@@ -667,24 +903,31 @@ int debug_iterate(uintptr_t base, size_t size,
     decltype(arg) arg;
   } ctx = { callback, arg };
 
-  return g_dispatch->iterate(base, size,
-      [](uintptr_t base, size_t size, void* arg) {
-        const iterate_ctx* ctx = reinterpret_cast<iterate_ctx*>(arg);
-        const void* pointer = reinterpret_cast<void*>(base);
-        if (g_debug->need_header()) {
-          const Header* header = reinterpret_cast<const Header*>(pointer);
-          if (g_debug->config().options & TRACK_ALLOCS) {
-            if (g_debug->track->Contains(header)) {
-              // Return just the body of the allocation if we're sure the header exists
-              ctx->callback(reinterpret_cast<uintptr_t>(g_debug->GetPointer(header)),
-                  header->usable_size, ctx->arg);
-              return;
-            }
-          }
+  auto report = [](uintptr_t base, size_t size, void* arg) {
+    const iterate_ctx* ctx = reinterpret_cast<iterate_ctx*>(arg);
+    const void* pointer = reinterpret_cast<void*>(base);
+    if (g_debug->need_header()) {
+      const Header* header = reinterpret_cast<const Header*>(pointer);
+      if (g_debug->config().options & TRACK_ALLOCS) {
+        if (g_debug->track->Contains(header)) {
+          // Return just the body of the allocation if we're sure the header exists
+          ctx->callback(reinterpret_cast<uintptr_t>(g_debug->GetPointer(header)),
+              header->usable_size, ctx->arg);
+          return;
         }
-        // Fall back to returning the whole allocation
-        ctx->callback(base, size, ctx->arg);
-      }, &ctx);
+      }
+    }
+    // Fall back to returning the whole allocation
+    ctx->callback(base, size, ctx->arg);
+  };
+
+  int result = g_dispatch->iterate(base, size, report, &ctx);
+  // The native allocator knows nothing of the allocations that have a
+  // mapping of their own.
+  if (g_debug->mapped_allocs != nullptr) {
+    g_debug->mapped_allocs->Iterate(base, size, report, &ctx);
+  }
+  return result;
 }
 
 void debug_malloc_disable() {
@@ -692,9 +935,15 @@ void debug_malloc_disable() {
   if (g_debug->track) {
     g_debug->track->PrepareFork();
   }
+  if (g_debug->mapped_allocs) {
+    g_debug->mapped_allocs->PrepareFork();
+  }
 }
 
 void debug_malloc_enable() {
+  if (g_debug->mapped_allocs) {
+    g_debug->mapped_allocs->PostForkParent();
+  }
   if (g_debug->track) {
     g_debug->track->PostForkParent();
   }
@@ -707,6 +956,10 @@ ssize_t debug_malloc_backtrace(void* pointer, uintptr_t* frames, size_t frame_co
   }
   ScopedDisableDebugCalls disable;
 
+  if (IsGuardPagePointer(pointer)) {
+    return 0;
+  }
+
   if (g_debug->need_header()) {
     Header* header;
     if (g_debug->config().options & TRACK_ALLOCS) {
@@ -721,8 +974,8 @@ ssize_t debug_malloc_backtrace(void* pointer, uintptr_t* frames, size_t frame_co
       return 0;
     }
     if (g_debug->config().options & BACKTRACE) {
-      BacktraceHeader* back_header = g_debug->GetAllocBacktrace(header);
-      if (back_header->num_frames > 0) {
+      const BacktraceHeader* back_header = g_debug->GetAllocBacktrace(header);
+      if (back_header != nullptr) {
         if (frame_count > back_header->num_frames) {
           frame_count = back_header->num_frames;
         }
@@ -38,12 +38,13 @@
 // part of the header does not exist, the other parts of the header
 // will still be in this order.
 //   Header          (Required)
-//   BacktraceHeader (Optional: For the allocation backtrace)
+//   BacktraceHeader* (Optional: For the allocation backtrace)
 //   uint8_t data    (Optional: Front guard, will be a multiple of MINIMUM_ALIGNMENT_BYTES)
 //   allocation data
 //   uint8_t data    (Optional: End guard)
 //
-// If backtracing is enabled, then both BacktraceHeaders will be present.
+// Backtraces are kept in a BacktraceTable so that identical ones are only
+// stored once, the header only holds a pointer to the shared copy.
 //
 // In the initialization function, offsets into the header will be set
 // for each different header location. The offsets are always from the
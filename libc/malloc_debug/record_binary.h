@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef DEBUG_MALLOC_RECORD_BINARY_H
+#define DEBUG_MALLOC_RECORD_BINARY_H
+
+#include <stdint.h>
+
+// The format of the files written by the record_allocs_stream option.
+// This header is shared with the host tool that converts these files into
+// the text format written by the record_allocs dump signal.
+//
+// Every file starts with a RecordBinaryHeader, followed by RecordBinaryEntry
+// values up to the end of the file. Pointers and sizes are always stored as
+// 64 bit values, in the byte order of the device, so that the recordings of
+// 32 bit and 64 bit processes have the same layout.
+
+constexpr uint32_t RECORD_BINARY_MAGIC = 0x4152444d;  // "MDRA"
+constexpr uint32_t RECORD_BINARY_VERSION = 1;
+
+enum RecordBinaryType : uint32_t {
+  RECORD_BINARY_THREAD_DONE = 0,
+  RECORD_BINARY_MALLOC = 1,
+  RECORD_BINARY_FREE = 2,
+  RECORD_BINARY_CALLOC = 3,
+  RECORD_BINARY_REALLOC = 4,
+  RECORD_BINARY_MEMALIGN = 5,
+};
+
+struct RecordBinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  // Increases by one for every file a process writes, so that the files
+  // of a ring can be put back in order.
+  uint64_t sequence;
+} __attribute__((packed));
+
+struct RecordBinaryEntry {
+  uint32_t type;
+  int32_t tid;
+  uint64_t pointer;
+  uint64_t size;
+  // The nmemb of a calloc, the old pointer of a realloc, or the alignment
+  // of a memalign. Zero otherwise.
+  uint64_t arg;
+} __attribute__((packed));
+
+#endif // DEBUG_MALLOC_RECORD_BINARY_H
@@ -15,8 +15,10 @@
  */
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <deque>
+#include <string>
 #include <vector>
 #include <utility>
 
@@ -57,3 +59,13 @@ void backtrace_log(const uintptr_t* frames, size_t frame_count) {
     error_log("  #%02zd pc %p", i, reinterpret_cast<void*>(frames[i]));
   }
 }
+
+std::string backtrace_string(const uintptr_t* frames, size_t frame_count) {
+  std::string str;
+  for (size_t i = 0; i < frame_count; i++) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "  #%02zd pc %p\n", i, reinterpret_cast<void*>(frames[i]));
+    str += buf;
+  }
+  return str;
+}
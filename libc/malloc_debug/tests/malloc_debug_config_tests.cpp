@@ -15,6 +15,7 @@
  */
 
 #include <limits.h>
+#include <signal.h>
 
 #include <memory>
 #include <string>
@@ -71,6 +72,13 @@ std::string usage_string(
   "6 malloc_debug     receives a signal. If XX is set it sets the number of backtrace\n"
   "6 malloc_debug     frames. The default is 16 frames, the max number of frames is 256.\n"
   "6 malloc_debug \n"
+  "6 malloc_debug   backtrace_sample_bytes[=XX]\n"
+  "6 malloc_debug     This option only has meaning if backtrace or backtrace_enable_on_signal\n"
+  "6 malloc_debug     is set. Only capture the backtrace of about one allocation for every\n"
+  "6 malloc_debug     XX bytes allocated by a thread. get_malloc_leak_info weights every\n"
+  "6 malloc_debug     sampled allocation by the number of allocations it stands for.\n"
+  "6 malloc_debug     The default is 524288 bytes, the max bytes is 1073741824.\n"
+  "6 malloc_debug \n"
   "6 malloc_debug   fill_on_alloc[=XX]\n"
   "6 malloc_debug     On first allocation, fill with the value 0xeb.\n"
   "6 malloc_debug     If XX is set it will only fill up to XX bytes of the\n"
@@ -108,6 +116,14 @@ std::string usage_string(
   "6 malloc_debug     is set to zero, then no backtrace will be captured.\n"
   "6 malloc_debug     The default is to record 16 frames, the max number of frames is 256.\n"
   "6 malloc_debug \n"
+  "6 malloc_debug   free_track_verify_thread[=XX]\n"
+  "6 malloc_debug     This option only has meaning if free_track is set. Instead of\n"
+  "6 malloc_debug     verifying an allocation in the freeing thread when it is removed\n"
+  "6 malloc_debug     from the free_track list, pass it to a background thread that\n"
+  "6 malloc_debug     verifies it and then frees it. If XX is set, at most XX allocations\n"
+  "6 malloc_debug     wait for the thread; once that many are waiting, free blocks.\n"
+  "6 malloc_debug     The default is 256 allocations, the max allocations is 16384.\n"
+  "6 malloc_debug \n"
   "6 malloc_debug   leak_track\n"
   "6 malloc_debug     Enable the leak tracking of memory allocations.\n"
   "6 malloc_debug \n"
@@ -123,6 +139,48 @@ std::string usage_string(
   "6 malloc_debug     This option only has meaning if the record_allocs options has been specified.\n"
   "6 malloc_debug     This is the name of the file to which recording information will be dumped.\n"
   "6 malloc_debug     The default is /data/local/tmp/record_allocs.txt.\n"
+  "6 malloc_debug \n"
+  "6 malloc_debug   record_allocs_stream[=XX]\n"
+  "6 malloc_debug     This option only has meaning if the record_allocs options has been specified.\n"
+  "6 malloc_debug     Instead of waiting for the dump signal, continuously write the records in\n"
+  "6 malloc_debug     a binary format to a ring of XX files named FILE.PID.N, where FILE is the\n"
+  "6 malloc_debug     record_allocs_file. Each file holds the number of entries given to\n"
+  "6 malloc_debug     record_allocs, after which the next file in the ring is overwritten.\n"
+  "6 malloc_debug     The signal writes out the records that are still buffered.\n"
+  "6 malloc_debug     The default is 4 files, the max files is 1000.\n"
+  "6 malloc_debug \n"
+  "6 malloc_debug   guard_pages[=XX]\n"
+  "6 malloc_debug     Serve about one in every XX allocations made by a thread from a pool\n"
+  "6 malloc_debug     of pages surrounded by inaccessible guard pages. An overflow or a use\n"
+  "6 malloc_debug     after free of a sampled allocation crashes right away. Allocations\n"
+  "6 malloc_debug     larger than a page are never sampled.\n"
+  "6 malloc_debug     The default is 1000 allocations, the max allocations is 100000000.\n"
+  "6 malloc_debug \n"
+  "6 malloc_debug   guard_pages_slots[=XX]\n"
+  "6 malloc_debug     This option only has meaning if guard_pages is set. It sets the number\n"
+  "6 malloc_debug     of sampled allocations that can be live at once.\n"
+  "6 malloc_debug     The default is 64 slots, the max slots is 16384.\n"
+  "6 malloc_debug \n"
+  "6 malloc_debug   mremap_realloc[=XX]\n"
+  "6 malloc_debug     Give every allocation of at least XX bytes, including the header,\n"
+  "6 malloc_debug     a mapping of its own, so that realloc can grow it with mremap\n"
+  "6 malloc_debug     instead of copying it. This option only has meaning if an option\n"
+  "6 malloc_debug     that needs a header is set.\n"
+  "6 malloc_debug     The default is 131072 bytes, the max bytes is 1073741824.\n"
+  "6 malloc_debug \n"
+  "6 malloc_debug   mutex_contention[=XX]\n"
+  "6 malloc_debug     Record the lock address, wait time and backtrace of one in every\n"
+  "6 malloc_debug     XX pthread mutex acquisitions that have to wait. When a specific\n"
+  "6 malloc_debug     signal is sent to the process, the totals for each lock and\n"
+  "6 malloc_debug     backtrace are written to a file (/data/local/tmp/mutex_contention.txt)\n"
+  "6 malloc_debug     and cleared.\n"
+  "6 malloc_debug     The default is 10 acquisitions, the max acquisitions is 1000000.\n"
+  "6 malloc_debug \n"
+  "6 malloc_debug   mutex_contention_file[=FILE]\n"
+  "6 malloc_debug     This option only has meaning if the mutex_contention option has been\n"
+  "6 malloc_debug     specified. This is the name of the file to which the contention\n"
+  "6 malloc_debug     information will be dumped.\n"
+  "6 malloc_debug     The default is /data/local/tmp/mutex_contention.txt.\n"
 );
 
 TEST_F(MallocDebugConfigTest, unknown_option) {
@@ -403,6 +461,33 @@ TEST_F(MallocDebugConfigTest, free_track_and_fill_on_free) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugConfigTest, backtrace_sample_bytes) {
+  ASSERT_TRUE(InitConfig("backtrace backtrace_sample_bytes=4096")) << getFakeLogPrint();
+  ASSERT_EQ(BACKTRACE | TRACK_ALLOCS, config->options);
+  ASSERT_TRUE(config->backtrace_sampling);
+  ASSERT_EQ(4096U, config->backtrace_sample_bytes);
+
+  ASSERT_TRUE(InitConfig("backtrace backtrace_sample_bytes")) << getFakeLogPrint();
+  ASSERT_TRUE(config->backtrace_sampling);
+  ASSERT_EQ(524288U, config->backtrace_sample_bytes);
+
+  ASSERT_TRUE(InitConfig("backtrace")) << getFakeLogPrint();
+  ASSERT_FALSE(config->backtrace_sampling);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, backtrace_sample_bytes_min_error) {
+  ASSERT_FALSE(InitConfig("backtrace_sample_bytes=0"));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: bad value for option 'backtrace_sample_bytes', "
+      "value must be >= 1: 0\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugConfigTest, free_track_backtrace_num_frames) {
   ASSERT_TRUE(InitConfig("free_track_backtrace_num_frames=123")) << getFakeLogPrint();
 
@@ -440,6 +525,33 @@ TEST_F(MallocDebugConfigTest, free_track_backtrace_num_frames_and_free_track) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugConfigTest, free_track_verify_thread) {
+  ASSERT_TRUE(InitConfig("free_track free_track_verify_thread=32")) << getFakeLogPrint();
+  ASSERT_EQ(FREE_TRACK | FILL_ON_FREE, config->options);
+  ASSERT_TRUE(config->free_track_verify_thread);
+  ASSERT_EQ(32U, config->free_track_verify_queue_size);
+
+  ASSERT_TRUE(InitConfig("free_track free_track_verify_thread")) << getFakeLogPrint();
+  ASSERT_TRUE(config->free_track_verify_thread);
+  ASSERT_EQ(256U, config->free_track_verify_queue_size);
+
+  ASSERT_TRUE(InitConfig("free_track")) << getFakeLogPrint();
+  ASSERT_FALSE(config->free_track_verify_thread);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, free_track_verify_thread_max_error) {
+  ASSERT_FALSE(InitConfig("free_track free_track_verify_thread=20000"));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: bad value for option 'free_track_verify_thread', "
+      "value must be <= 16384: 20000\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugConfigTest, leak_track) {
   ASSERT_TRUE(InitConfig("leak_track")) << getFakeLogPrint();
   ASSERT_EQ(LEAK_TRACK | TRACK_ALLOCS, config->options);
@@ -682,3 +794,95 @@ TEST_F(MallocDebugConfigTest, record_allocs_max_error) {
       "value must be <= 50000000: 100000000\n");
   ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
 }
+
+TEST_F(MallocDebugConfigTest, record_allocs_stream) {
+  ASSERT_TRUE(InitConfig("record_allocs record_allocs_stream=8")) << getFakeLogPrint();
+  ASSERT_EQ(RECORD_ALLOCS, config->options);
+  ASSERT_TRUE(config->record_allocs_stream);
+  ASSERT_EQ(8U, config->record_allocs_stream_files);
+
+  ASSERT_TRUE(InitConfig("record_allocs record_allocs_stream")) << getFakeLogPrint();
+  ASSERT_TRUE(config->record_allocs_stream);
+  ASSERT_EQ(4U, config->record_allocs_stream_files);
+
+  ASSERT_TRUE(InitConfig("record_allocs")) << getFakeLogPrint();
+  ASSERT_FALSE(config->record_allocs_stream);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, guard_pages) {
+  ASSERT_TRUE(InitConfig("guard_pages=500 guard_pages_slots=32")) << getFakeLogPrint();
+  ASSERT_EQ(GUARD_PAGES, config->options);
+  ASSERT_EQ(500U, config->guard_pages_sample_rate);
+  ASSERT_EQ(32U, config->guard_pages_slots);
+
+  ASSERT_TRUE(InitConfig("guard_pages")) << getFakeLogPrint();
+  ASSERT_EQ(GUARD_PAGES, config->options);
+  ASSERT_EQ(1000U, config->guard_pages_sample_rate);
+  ASSERT_EQ(64U, config->guard_pages_slots);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, guard_pages_slots_max_error) {
+  ASSERT_FALSE(InitConfig("guard_pages guard_pages_slots=20000"));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: bad value for option 'guard_pages_slots', "
+      "value must be <= 16384: 20000\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, mremap_realloc) {
+  ASSERT_TRUE(InitConfig("mremap_realloc=65536")) << getFakeLogPrint();
+  ASSERT_EQ(MREMAP_REALLOC, config->options);
+  ASSERT_EQ(65536U, config->mremap_realloc_bytes);
+
+  ASSERT_TRUE(InitConfig("mremap_realloc")) << getFakeLogPrint();
+  ASSERT_EQ(MREMAP_REALLOC, config->options);
+  ASSERT_EQ(131072U, config->mremap_realloc_bytes);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, mremap_realloc_max_error) {
+  ASSERT_FALSE(InitConfig("mremap_realloc=1073741825"));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: bad value for option 'mremap_realloc', "
+      "value must be <= 1073741824: 1073741825\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, mutex_contention) {
+  ASSERT_TRUE(InitConfig("mutex_contention=100 mutex_contention_file=/data/local/tmp/locks"))
+      << getFakeLogPrint();
+  ASSERT_EQ(MUTEX_CONTENTION, config->options);
+  ASSERT_EQ(100U, config->mutex_contention_sample_interval);
+  ASSERT_STREQ("/data/local/tmp/locks", config->mutex_contention_file.c_str());
+  ASSERT_EQ(SIGRTMAX - 17, config->mutex_contention_signal);
+
+  ASSERT_TRUE(InitConfig("mutex_contention")) << getFakeLogPrint();
+  ASSERT_EQ(MUTEX_CONTENTION, config->options);
+  ASSERT_EQ(10U, config->mutex_contention_sample_interval);
+  ASSERT_STREQ("/data/local/tmp/mutex_contention.txt", config->mutex_contention_file.c_str());
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, mutex_contention_max_error) {
+  ASSERT_FALSE(InitConfig("mutex_contention=2000000"));
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: bad value for option 'mutex_contention', "
+      "value must be <= 1000000: 2000000\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
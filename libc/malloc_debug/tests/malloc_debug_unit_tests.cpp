@@ -16,6 +16,7 @@
 
 #include <malloc.h>
 #include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/cdefs.h>
@@ -24,6 +25,7 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <map>
 #include <thread>
 #include <vector>
 #include <utility>
@@ -35,9 +37,11 @@
 
 #include <private/bionic_macros.h>
 #include <private/bionic_malloc_dispatch.h>
+#include <private/bionic_mutex_contention.h>
 
 #include "Config.h"
 #include "malloc_debug.h"
+#include "record_binary.h"
 
 #include "log_fake.h"
 #include "backtrace_fake.h"
@@ -45,6 +49,7 @@
 __BEGIN_DECLS
 
 bool debug_initialize(const MallocDispatch*, int*, const char*);
+bool debug_initialize_late(const MallocDispatch*, int*, const char*);
 void debug_finalize();
 
 void* debug_malloc(size_t);
@@ -56,6 +61,8 @@ void* debug_memalign(size_t, size_t);
 size_t debug_malloc_usable_size(void*);
 void debug_get_malloc_leak_info(uint8_t**, size_t*, size_t*, size_t*, size_t*);
 void debug_free_malloc_leak_info(uint8_t*);
+bool debug_malloc_write_profile(int);
+MutexContentionFunc debug_get_mutex_contention_func(uint32_t*);
 
 struct mallinfo debug_mallinfo();
 int debug_mallopt(int, int);
@@ -72,15 +79,16 @@ constexpr char DIVIDER[] =
 
 constexpr uint32_t BACKTRACE_HEADER = 0x1;
 
-static size_t get_tag_offset(uint32_t flags = 0, size_t backtrace_frames = 0) {
+static size_t get_tag_offset(uint32_t flags = 0) {
   size_t offset = BIONIC_ALIGN(sizeof(Header), MINIMUM_ALIGNMENT_BYTES);
   if (flags & BACKTRACE_HEADER) {
-    offset += BIONIC_ALIGN(sizeof(BacktraceHeader) + sizeof(uintptr_t) * backtrace_frames, MINIMUM_ALIGNMENT_BYTES);
+    offset += BIONIC_ALIGN(sizeof(BacktraceHeader*), MINIMUM_ALIGNMENT_BYTES);
   }
   return offset;
 }
 
 static constexpr const char RECORD_ALLOCS_FILE[] = "/data/local/tmp/record_allocs.txt";
+static constexpr const char MUTEX_CONTENTION_FILE[] = "/data/local/tmp/mutex_contention.txt";
 
 class MallocDebugTest : public ::testing::Test {
  protected:
@@ -90,6 +98,7 @@ class MallocDebugTest : public ::testing::Test {
     backtrace_fake_clear_all();
     // Delete the record data file if it exists.
     unlink(RECORD_ALLOCS_FILE);
+    unlink(MUTEX_CONTENTION_FILE);
   }
 
   void TearDown() override {
@@ -104,6 +113,12 @@ class MallocDebugTest : public ::testing::Test {
     initialized = true;
   }
 
+  void InitLate(const char* options) {
+    zygote = 0;
+    ASSERT_TRUE(debug_initialize_late(&dispatch, &zygote, options));
+    initialized = true;
+  }
+
   bool initialized;
 
   int zygote;
@@ -807,6 +822,76 @@ TEST_F(MallocDebugTest, free_track_use_after_free_finalize) {
   ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, free_track_verify_thread_use_after_free) {
+  Init("free_track=5 free_track_backtrace_num_frames=0 free_track_verify_thread=2");
+
+  uint8_t* pointers[5];
+  for (size_t i = 0; i < sizeof(pointers) / sizeof(void*); i++) {
+    pointers[i] = reinterpret_cast<uint8_t*>(debug_malloc(100 + i));
+    ASSERT_TRUE(pointers[i] != nullptr);
+    memset(pointers[i], 0, 100 + i);
+    debug_free(pointers[i]);
+  }
+
+  // Stomp on the data.
+  pointers[1][20] = 0xaf;
+
+  uint8_t* pointer_large = reinterpret_cast<uint8_t*>(debug_malloc(9000));
+  ASSERT_TRUE(pointer_large != nullptr);
+  memset(pointer_large, 0, 9000);
+  debug_free(pointer_large);
+
+  pointer_large[8200] = 0x78;
+
+  // Push all of the above off the list, through a queue smaller than the list.
+  for (size_t i = 0; i < 10; i++) {
+    void* flush_pointer = debug_malloc(100 + i);
+    ASSERT_TRUE(flush_pointer != nullptr);
+    memset(flush_pointer, 0, 100 + i);
+    debug_free(flush_pointer);
+  }
+
+  // Waits for the verify thread to finish.
+  debug_finalize();
+  initialized = false;
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string expected_log(DIVIDER);
+  expected_log += android::base::StringPrintf("6 malloc_debug +++ ALLOCATION %p USED AFTER FREE\n", pointers[1]);
+  expected_log += "6 malloc_debug   allocation[20] = 0xaf (expected 0xef)\n";
+  expected_log += DIVIDER;
+  expected_log += DIVIDER;
+  expected_log += android::base::StringPrintf("6 malloc_debug +++ ALLOCATION %p USED AFTER FREE\n", pointer_large);
+  expected_log += "6 malloc_debug   allocation[8200] = 0x78 (expected 0xef)\n";
+  expected_log += DIVIDER;
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, free_track_verify_thread_multiple_thread) {
+  Init("free_track=10 free_track_backtrace_num_frames=0 free_track_verify_thread=4");
+
+  std::vector<std::thread*> threads(100);
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i] = new std::thread([](){
+      for (size_t j = 0; j < 100; j++) {
+        void* mem = debug_malloc(100);
+        write(0, mem, 0);
+        debug_free(mem);
+      }
+    });
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  debug_finalize();
+  initialized = false;
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, free_track_use_after_free_with_backtrace) {
   Init("free_track=100");
 
@@ -1241,6 +1326,195 @@ TEST_F(MallocDebugTest, realloc_usable_size) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, calloc_zeroed_after_reuse) {
+  Init("guard backtrace");
+
+  // Dirty memory first so that the calls below are likely to reuse it.
+  for (size_t size : {100, 4096, 4 * 1024 * 1024}) {
+    void* pointer = debug_malloc(size);
+    ASSERT_TRUE(pointer != nullptr);
+    memset(pointer, 0xff, size);
+    debug_free(pointer);
+
+    uint8_t* zeroed = reinterpret_cast<uint8_t*>(debug_calloc(1, size));
+    ASSERT_TRUE(zeroed != nullptr);
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(zeroed) % MINIMUM_ALIGNMENT_BYTES);
+    for (size_t i = 0; i < size; i++) {
+      ASSERT_EQ(0, zeroed[i]) << "debug_calloc non-zero byte at " << i << " size " << size;
+    }
+    debug_free(zeroed);
+  }
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, late_init_native_pointer) {
+  // Allocated before malloc debug is enabled, so it has no header.
+  void* native_pointer = malloc(100);
+  ASSERT_TRUE(native_pointer != nullptr);
+
+  InitLate("guard");
+
+  ASSERT_EQ(malloc_usable_size(native_pointer), debug_malloc_usable_size(native_pointer));
+  debug_free(native_pointer);
+
+  void* pointer = debug_malloc(100);
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EQ(100U, debug_malloc_usable_size(pointer));
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, late_init_realloc_native_pointer) {
+  uint8_t* native_pointer = reinterpret_cast<uint8_t*>(malloc(100));
+  ASSERT_TRUE(native_pointer != nullptr);
+  memset(native_pointer, 0xaa, 100);
+
+  InitLate("guard");
+
+  // The realloc moves the data into an allocation with a header.
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_realloc(native_pointer, 200));
+  ASSERT_TRUE(pointer != nullptr);
+  for (size_t i = 0; i < 100; i++) {
+    ASSERT_EQ(0xaa, pointer[i]) << "Failed compare at byte " << i;
+  }
+  ASSERT_EQ(200U, debug_malloc_usable_size(pointer));
+
+  // Corrupting the rear guard of the new allocation is detected.
+  pointer[200] = 0;
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_TRUE(getFakeLogPrint().find("REAR GUARD") != std::string::npos);
+}
+
+TEST_F(MallocDebugTest, late_init_leak_info) {
+  void* native_pointer = malloc(100);
+  ASSERT_TRUE(native_pointer != nullptr);
+
+  InitLate("backtrace");
+
+  backtrace_fake_add(std::vector<uintptr_t> {0xbc000, 0xecd00, 0x12000});
+  void* pointer = debug_malloc(50);
+  ASSERT_TRUE(pointer != nullptr);
+
+  // Only the allocation made after enabling malloc debug is reported.
+  uint8_t* info;
+  size_t overall_size;
+  size_t info_size;
+  size_t total_memory;
+  size_t backtrace_size;
+  debug_get_malloc_leak_info(&info, &overall_size, &info_size, &total_memory, &backtrace_size);
+  ASSERT_TRUE(info != nullptr);
+  ASSERT_EQ(info_size, overall_size);
+  ASSERT_EQ(50U, total_memory);
+  debug_free_malloc_leak_info(info);
+
+  debug_free(native_pointer);
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, get_malloc_leak_info_shared_backtrace) {
+  Init("backtrace");
+
+  size_t individual_size = 2 * sizeof(size_t) + 16 * sizeof(uintptr_t);
+  std::vector<uint8_t> expected_info(individual_size);
+  memset(expected_info.data(), 0, individual_size);
+
+  InfoEntry* entry = reinterpret_cast<InfoEntry*>(expected_info.data());
+  entry->size = 200;
+  entry->num_allocations = 1;
+  entry->frames[0] = 0xa;
+  entry->frames[1] = 0xb;
+  entry->frames[2] = 0xc;
+
+  // Both allocations share a single stored backtrace, freeing the first
+  // one must leave the backtrace of the second intact.
+  backtrace_fake_add(std::vector<uintptr_t> {0xa, 0xb, 0xc});
+  backtrace_fake_add(std::vector<uintptr_t> {0xa, 0xb, 0xc});
+
+  void* pointer1 = debug_malloc(entry->size);
+  ASSERT_TRUE(pointer1 != nullptr);
+  void* pointer2 = debug_malloc(entry->size);
+  ASSERT_TRUE(pointer2 != nullptr);
+  debug_free(pointer1);
+
+  uint8_t* info;
+  size_t overall_size;
+  size_t info_size;
+  size_t total_memory;
+  size_t backtrace_size;
+
+  debug_get_malloc_leak_info(&info, &overall_size, &info_size, &total_memory, &backtrace_size);
+  ASSERT_TRUE(info != nullptr);
+  ASSERT_EQ(individual_size, overall_size);
+  ASSERT_EQ(individual_size, info_size);
+  ASSERT_EQ(200U, total_memory);
+  ASSERT_EQ(16U, backtrace_size);
+  ASSERT_TRUE(memcmp(expected_info.data(), info, overall_size) == 0);
+
+  debug_free_malloc_leak_info(info);
+
+  debug_free(pointer2);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, get_malloc_leak_info_sampled) {
+  Init("backtrace backtrace_sample_bytes=1000");
+
+  // Only the allocation that crosses the 1000 byte mark is sampled, and it
+  // stands for 1000 / 400 allocations of its size.
+  size_t individual_size = 2 * sizeof(size_t) + 16 * sizeof(uintptr_t);
+  std::vector<uint8_t> expected_info(individual_size);
+  memset(expected_info.data(), 0, individual_size);
+
+  InfoEntry* entry = reinterpret_cast<InfoEntry*>(expected_info.data());
+  entry->size = 400;
+  entry->num_allocations = 2;
+  entry->frames[0] = 0xf;
+  entry->frames[1] = 0xe;
+  entry->frames[2] = 0xd;
+
+  backtrace_fake_add(std::vector<uintptr_t> {0xf, 0xe, 0xd});
+
+  void* pointers[3];
+  for (size_t i = 0; i < 3; i++) {
+    pointers[i] = debug_malloc(entry->size);
+    ASSERT_TRUE(pointers[i] != nullptr);
+  }
+
+  uint8_t* info;
+  size_t overall_size;
+  size_t info_size;
+  size_t total_memory;
+  size_t backtrace_size;
+
+  debug_get_malloc_leak_info(&info, &overall_size, &info_size, &total_memory, &backtrace_size);
+  ASSERT_TRUE(info != nullptr);
+  ASSERT_EQ(individual_size, overall_size);
+  ASSERT_EQ(individual_size, info_size);
+  ASSERT_EQ(800U, total_memory);
+  ASSERT_EQ(16U, backtrace_size);
+  ASSERT_TRUE(memcmp(expected_info.data(), info, overall_size) == 0);
+
+  debug_free_malloc_leak_info(info);
+
+  for (size_t i = 0; i < 3; i++) {
+    debug_free(pointers[i]);
+  }
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, backtrace_enable_on_signal) {
   Init("backtrace_enable_on_signal=20");
 
@@ -1706,6 +1980,56 @@ TEST_F(MallocDebugTest, record_allocs_thread_done) {
   debug_free(pointer);
 }
 
+static void VerifyRecordStreamFile(size_t index, uint64_t sequence,
+                                   const RecordBinaryEntry* expected, size_t num_expected) {
+  std::string file_name = android::base::StringPrintf("%s.%d.%zu", RECORD_ALLOCS_FILE,
+                                                      getpid(), index);
+  std::string actual;
+  ASSERT_TRUE(android::base::ReadFileToString(file_name, &actual));
+  unlink(file_name.c_str());
+
+  ASSERT_EQ(sizeof(RecordBinaryHeader) + num_expected * sizeof(RecordBinaryEntry),
+            actual.size());
+  const RecordBinaryHeader* header = reinterpret_cast<const RecordBinaryHeader*>(actual.data());
+  ASSERT_EQ(RECORD_BINARY_MAGIC, header->magic);
+  ASSERT_EQ(RECORD_BINARY_VERSION, header->version);
+  ASSERT_EQ(sequence, header->sequence);
+  ASSERT_EQ(0, memcmp(expected, &actual[sizeof(RecordBinaryHeader)],
+                      num_expected * sizeof(RecordBinaryEntry)));
+}
+
+TEST_F(MallocDebugTest, record_allocs_stream) {
+  Init("record_allocs=4 record_allocs_stream=2");
+
+  std::vector<RecordBinaryEntry> expected;
+  void* pointers[3];
+  for (size_t i = 0; i < 3; i++) {
+    pointers[i] = debug_malloc(10 + i);
+    ASSERT_TRUE(pointers[i] != nullptr);
+    expected.push_back(RecordBinaryEntry{RECORD_BINARY_MALLOC, getpid(),
+                                         reinterpret_cast<uintptr_t>(pointers[i]), 10 + i, 0});
+  }
+  for (size_t i = 0; i < 3; i++) {
+    debug_free(pointers[i]);
+    expected.push_back(RecordBinaryEntry{RECORD_BINARY_FREE, getpid(),
+                                         reinterpret_cast<uintptr_t>(pointers[i]), 0, 0});
+  }
+
+  // Finalizing writes out everything that is still buffered.
+  debug_finalize();
+  initialized = false;
+
+  // Four entries fit in the first file, the rest go to the second one.
+  VerifyRecordStreamFile(0, 0, &expected[0], 4);
+  VerifyRecordStreamFile(1, 1, &expected[4], 2);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string expected_log = android::base::StringPrintf(
+      "4 malloc_debug malloc_testing: Run: 'kill -%d %d' to dump the allocation records.\n",
+      SIGRTMAX - 18, getpid());
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, record_allocs_file_name_fail) {
   Init("record_allocs=5");
 
@@ -1759,3 +2083,386 @@ TEST_F(MallocDebugTest, record_allocs_file_name_fail) {
       RECORD_ALLOCS_FILE);
   ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
 }
+
+TEST_F(MallocDebugTest, mutex_contention_not_enabled) {
+  Init("guard_pages");
+
+  uint32_t sample_interval;
+  ASSERT_TRUE(debug_get_mutex_contention_func(&sample_interval) == nullptr);
+}
+
+TEST_F(MallocDebugTest, mutex_contention) {
+  Init("mutex_contention=5");
+
+  uint32_t sample_interval = 0;
+  MutexContentionFunc record = debug_get_mutex_contention_func(&sample_interval);
+  ASSERT_TRUE(record != nullptr);
+  ASSERT_EQ(5U, sample_interval);
+
+  int lock1;
+  int lock2;
+  backtrace_fake_add(std::vector<uintptr_t> {0x1000, 0x2000});
+  record(&lock1, 100);
+  backtrace_fake_add(std::vector<uintptr_t> {0x1000, 0x2000});
+  record(&lock1, 300);
+  backtrace_fake_add(std::vector<uintptr_t> {0x1000, 0x3000});
+  record(&lock1, 50);
+  backtrace_fake_add(std::vector<uintptr_t> {0x4000});
+  record(&lock2, 1000);
+
+  // Dump all of the data accumulated so far.
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 17) == 0);
+  sleep(1);
+
+  // This triggers the dumping.
+  void* pointer = debug_malloc(10);
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free(pointer);
+
+  std::string expected = android::base::StringPrintf(
+      "mutex %p: waits 1 total_ns 1000 max_ns 1000\n"
+      "  #00 pc 0x4000\n"
+      "mutex %p: waits 2 total_ns 400 max_ns 300\n"
+      "  #00 pc 0x1000\n"
+      "  #01 pc 0x2000\n"
+      "mutex %p: waits 1 total_ns 50 max_ns 50\n"
+      "  #00 pc 0x1000\n"
+      "  #01 pc 0x3000\n", &lock2, &lock1, &lock1);
+  std::string actual;
+  ASSERT_TRUE(android::base::ReadFileToString(MUTEX_CONTENTION_FILE, &actual));
+  ASSERT_STREQ(expected.c_str(), actual.c_str());
+
+  // The totals are cleared by the dump.
+  ASSERT_EQ(0, unlink(MUTEX_CONTENTION_FILE));
+  backtrace_fake_add(std::vector<uintptr_t> {0x4000});
+  record(&lock2, 7);
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 17) == 0);
+  sleep(1);
+  pointer = debug_malloc(10);
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free(pointer);
+
+  expected = android::base::StringPrintf(
+      "mutex %p: waits 1 total_ns 7 max_ns 7\n"
+      "  #00 pc 0x4000\n", &lock2);
+  ASSERT_TRUE(android::base::ReadFileToString(MUTEX_CONTENTION_FILE, &actual));
+  ASSERT_STREQ(expected.c_str(), actual.c_str());
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string expected_log = android::base::StringPrintf(
+      "4 malloc_debug malloc_testing: Run: 'kill -%d %d' to dump the mutex contention records.\n",
+      SIGRTMAX - 17, getpid());
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, guard_pages_sampled) {
+  Init("guard_pages=1");
+
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_malloc(100));
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EQ(100U, debug_malloc_usable_size(pointer));
+  // The allocation ends at the end of a page.
+  uintptr_t end = reinterpret_cast<uintptr_t>(pointer) + BIONIC_ALIGN(100, MINIMUM_ALIGNMENT_BYTES);
+  ASSERT_EQ(0U, end % getpagesize());
+  memset(pointer, 0xaa, 100);
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, guard_pages_calloc_realloc) {
+  Init("guard_pages=1");
+
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_malloc(100));
+  ASSERT_TRUE(pointer != nullptr);
+  memset(pointer, 0xaa, 100);
+  debug_free(pointer);
+
+  // The freed slot is not handed out zero filled.
+  pointer = reinterpret_cast<uint8_t*>(debug_calloc(1, 100));
+  ASSERT_TRUE(pointer != nullptr);
+  for (size_t i = 0; i < 100; i++) {
+    ASSERT_EQ(0, pointer[i]) << "Failed compare at byte " << i;
+  }
+  memset(pointer, 0xbb, 100);
+
+  pointer = reinterpret_cast<uint8_t*>(debug_realloc(pointer, 200));
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EQ(200U, debug_malloc_usable_size(pointer));
+  for (size_t i = 0; i < 100; i++) {
+    ASSERT_EQ(0xbb, pointer[i]) << "Failed compare at byte " << i;
+  }
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, guard_pages_large_not_sampled) {
+  Init("guard_pages=1");
+
+  void* pointer = debug_malloc(getpagesize() + 1);
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EQ(malloc_usable_size(pointer), debug_malloc_usable_size(pointer));
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+static void WriteByte(uint8_t* pointer) {
+  *reinterpret_cast<volatile uint8_t*>(pointer) = 0;
+}
+
+TEST_F(MallocDebugTest, guard_pages_overflow) {
+  Init("guard_pages=1");
+
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_malloc(100));
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EXIT(WriteByte(&pointer[BIONIC_ALIGN(100, MINIMUM_ALIGNMENT_BYTES)]),
+              ::testing::KilledBySignal(SIGSEGV), "");
+  debug_free(pointer);
+}
+
+TEST_F(MallocDebugTest, guard_pages_use_after_free) {
+  Init("guard_pages=1");
+
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_malloc(100));
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free(pointer);
+  ASSERT_EXIT(WriteByte(pointer), ::testing::KilledBySignal(SIGSEGV), "");
+}
+
+TEST_F(MallocDebugTest, guard_pages_double_free) {
+  Init("guard_pages=1");
+
+  void* pointer = debug_malloc(100);
+  ASSERT_TRUE(pointer != nullptr);
+  debug_free(pointer);
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string expected_log(DIVIDER);
+  expected_log += android::base::StringPrintf(
+      "6 malloc_debug +++ ALLOCATION %p USED AFTER FREE (free)\n", pointer);
+  ASSERT_TRUE(getFakeLogPrint().find(expected_log) == 0) << getFakeLogPrint();
+}
+
+TEST_F(MallocDebugTest, guard_pages_slots_exhausted) {
+  Init("guard_pages=1 guard_pages_slots=1");
+
+  void* pointer = debug_malloc(100);
+  ASSERT_TRUE(pointer != nullptr);
+  // With the only slot in use, the next allocation comes from the
+  // native allocator.
+  void* native_pointer = debug_malloc(100);
+  ASSERT_TRUE(native_pointer != nullptr);
+  ASSERT_EQ(malloc_usable_size(native_pointer), debug_malloc_usable_size(native_pointer));
+  debug_free(native_pointer);
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, mremap_realloc_grow) {
+  Init("rear_guard=32 mremap_realloc=4096");
+
+  size_t size = 2 * getpagesize();
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_malloc(size));
+  ASSERT_TRUE(pointer != nullptr);
+  // The header is at the start of a mapping of its own.
+  ASSERT_EQ(0U, (reinterpret_cast<uintptr_t>(pointer) - get_tag_offset()) % getpagesize());
+  for (size_t i = 0; i < size; i++) {
+    pointer[i] = static_cast<uint8_t>(i);
+  }
+
+  size_t new_size = 256 * getpagesize();
+  pointer = reinterpret_cast<uint8_t*>(debug_realloc(pointer, new_size));
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EQ(0U, (reinterpret_cast<uintptr_t>(pointer) - get_tag_offset()) % getpagesize());
+  ASSERT_EQ(new_size, debug_malloc_usable_size(pointer));
+  for (size_t i = 0; i < size; i++) {
+    ASSERT_EQ(static_cast<uint8_t>(i), pointer[i]) << "Failed compare at byte " << i;
+  }
+  memset(pointer, 0xaa, new_size);
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, mremap_realloc_calloc) {
+  Init("rear_guard=32 mremap_realloc=4096");
+
+  size_t size = 2 * getpagesize();
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_calloc(1, size));
+  ASSERT_TRUE(pointer != nullptr);
+  ASSERT_EQ(0U, (reinterpret_cast<uintptr_t>(pointer) - get_tag_offset()) % getpagesize());
+  for (size_t i = 0; i < size; i++) {
+    ASSERT_EQ(0, pointer[i]) << "Failed compare at byte " << i;
+  }
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, mremap_realloc_rear_guard_corrupted_after_grow) {
+  Init("rear_guard=32 mremap_realloc=4096");
+
+  backtrace_fake_add(std::vector<uintptr_t> {0x100, 0x200, 0x300});
+
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(debug_malloc(8192));
+  ASSERT_TRUE(pointer != nullptr);
+  pointer = reinterpret_cast<uint8_t*>(debug_realloc(pointer, 100000));
+  ASSERT_TRUE(pointer != nullptr);
+  // The rear guard moves to the new end of the allocation.
+  pointer[100000] = 0x00;
+  debug_free(pointer);
+
+  std::string expected_log(DIVIDER);
+  expected_log += android::base::StringPrintf(
+      "6 malloc_debug +++ ALLOCATION %p SIZE 100000 HAS A CORRUPTED REAR GUARD\n", pointer);
+  expected_log += "6 malloc_debug   allocation[100000] = 0x00 (expected 0xbb)\n";
+  expected_log += "6 malloc_debug Backtrace at time of failure:\n";
+  expected_log += "6 malloc_debug   #00 pc 0x100\n";
+  expected_log += "6 malloc_debug   #01 pc 0x200\n";
+  expected_log += "6 malloc_debug   #02 pc 0x300\n";
+  expected_log += DIVIDER;
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
+
+struct ProtoField {
+  uint32_t number;
+  uint64_t value;
+  std::string bytes;
+};
+
+static uint64_t ReadVarint(const std::string& data, size_t* pos) {
+  uint64_t value = 0;
+  for (int shift = 0; *pos < data.size(); shift += 7) {
+    uint8_t byte = data[(*pos)++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  return value;
+}
+
+// Only handles the varint and length delimited fields that a profile uses.
+static std::vector<ProtoField> ParseProto(const std::string& data) {
+  std::vector<ProtoField> fields;
+  size_t pos = 0;
+  while (pos < data.size()) {
+    uint64_t tag = ReadVarint(data, &pos);
+    ProtoField field = { static_cast<uint32_t>(tag >> 3), 0, "" };
+    if ((tag & 7) == 0) {
+      field.value = ReadVarint(data, &pos);
+    } else {
+      size_t size = ReadVarint(data, &pos);
+      field.bytes = data.substr(pos, size);
+      pos += size;
+    }
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+static std::vector<uint64_t> ParsePacked(const std::string& data) {
+  std::vector<uint64_t> values;
+  size_t pos = 0;
+  while (pos < data.size()) {
+    values.push_back(ReadVarint(data, &pos));
+  }
+  return values;
+}
+
+TEST_F(MallocDebugTest, malloc_write_profile) {
+  Init("backtrace=8");
+
+  backtrace_fake_add(std::vector<uintptr_t> {0x1000, 0x2000});
+  void* pointer1 = debug_malloc(100);
+  ASSERT_TRUE(pointer1 != nullptr);
+  backtrace_fake_add(std::vector<uintptr_t> {0x1000, 0x2000});
+  void* pointer2 = debug_malloc(200);
+  ASSERT_TRUE(pointer2 != nullptr);
+  backtrace_fake_add(std::vector<uintptr_t> {0x3000});
+  void* pointer3 = debug_malloc(50);
+  ASSERT_TRUE(pointer3 != nullptr);
+
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_TRUE(debug_malloc_write_profile(fileno(fp)));
+  ASSERT_EQ(0, lseek(fileno(fp), 0, SEEK_SET));
+  std::string data;
+  ASSERT_TRUE(android::base::ReadFdToString(fileno(fp), &data));
+  fclose(fp);
+
+  std::vector<std::string> strings;
+  std::vector<ProtoField> samples;
+  std::map<uint64_t, uint64_t> addresses;
+  for (const auto& field : ParseProto(data)) {
+    if (field.number == 6) {
+      strings.push_back(field.bytes);
+    } else if (field.number == 2) {
+      samples.push_back(field);
+    } else if (field.number == 4) {
+      uint64_t id = 0;
+      uint64_t address = 0;
+      for (const auto& location_field : ParseProto(field.bytes)) {
+        if (location_field.number == 1) id = location_field.value;
+        if (location_field.number == 3) address = location_field.value;
+      }
+      addresses[id] = address;
+    }
+  }
+  ASSERT_EQ(5U, strings.size());
+  ASSERT_EQ("", strings[0]);
+  ASSERT_EQ("inuse_objects", strings[1]);
+  ASSERT_EQ("count", strings[2]);
+  ASSERT_EQ("inuse_space", strings[3]);
+  ASSERT_EQ("bytes", strings[4]);
+  ASSERT_EQ(3U, addresses.size());
+
+  // One sample per distinct backtrace.
+  ASSERT_EQ(2U, samples.size());
+  std::map<std::vector<uint64_t>, std::vector<uint64_t>> values;
+  for (const auto& sample : samples) {
+    std::vector<uint64_t> frames;
+    std::vector<uint64_t> sample_values;
+    for (const auto& sample_field : ParseProto(sample.bytes)) {
+      if (sample_field.number == 1) {
+        for (uint64_t id : ParsePacked(sample_field.bytes)) {
+          frames.push_back(addresses[id]);
+        }
+      } else if (sample_field.number == 2) {
+        sample_values = ParsePacked(sample_field.bytes);
+      }
+    }
+    values[frames] = sample_values;
+  }
+  ASSERT_EQ((std::vector<uint64_t> {2, 300}), (values[std::vector<uint64_t> {0x1000, 0x2000}]));
+  ASSERT_EQ((std::vector<uint64_t> {1, 50}), (values[std::vector<uint64_t> {0x3000}]));
+
+  debug_free(pointer1);
+  debug_free(pointer2);
+  debug_free(pointer3);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, malloc_write_profile_not_enabled) {
+  Init("fill");
+
+  ASSERT_FALSE(debug_malloc_write_profile(STDOUT_FILENO));
+  std::string expected_log(
+      "6 malloc_debug malloc_write_profile: Allocations not being tracked, to enable "
+      "set the option 'backtrace'.\n");
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
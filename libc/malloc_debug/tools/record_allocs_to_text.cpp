@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// Converts the binary files written by the record_allocs_stream option into
+// the text format written by the record_allocs dump signal.
+//
+//   malloc_debug_record_to_text record_allocs.txt.1234.* > record_allocs.txt
+//
+// The files are put back in the order they were written, so they can be
+// given in any order.
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <android-base/file.h>
+
+#include "record_binary.h"
+
+static bool PrintEntry(const RecordBinaryEntry& entry) {
+  switch (entry.type) {
+    case RECORD_BINARY_THREAD_DONE:
+      printf("%d: thread_done 0x0\n", entry.tid);
+      return true;
+    case RECORD_BINARY_MALLOC:
+      printf("%d: malloc 0x%" PRIx64 " %" PRIu64 "\n", entry.tid, entry.pointer, entry.size);
+      return true;
+    case RECORD_BINARY_FREE:
+      printf("%d: free 0x%" PRIx64 "\n", entry.tid, entry.pointer);
+      return true;
+    case RECORD_BINARY_CALLOC:
+      printf("%d: calloc 0x%" PRIx64 " %" PRIu64 " %" PRIu64 "\n", entry.tid, entry.pointer,
+             entry.arg, entry.size);
+      return true;
+    case RECORD_BINARY_REALLOC:
+      printf("%d: realloc 0x%" PRIx64 " 0x%" PRIx64 " %" PRIu64 "\n", entry.tid, entry.pointer,
+             entry.arg, entry.size);
+      return true;
+    case RECORD_BINARY_MEMALIGN:
+      printf("%d: memalign 0x%" PRIx64 " %" PRIu64 " %" PRIu64 "\n", entry.tid, entry.pointer,
+             entry.arg, entry.size);
+      return true;
+    default:
+      return false;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE...\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<std::pair<uint64_t, std::string>> files;
+  for (int i = 1; i < argc; i++) {
+    std::string contents;
+    if (!android::base::ReadFileToString(argv[i], &contents)) {
+      fprintf(stderr, "%s: cannot read: %s\n", argv[i], strerror(errno));
+      return 1;
+    }
+    RecordBinaryHeader header;
+    if (contents.size() < sizeof(header)) {
+      fprintf(stderr, "%s: file too small\n", argv[i]);
+      return 1;
+    }
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != RECORD_BINARY_MAGIC) {
+      fprintf(stderr, "%s: not a record_allocs_stream file\n", argv[i]);
+      return 1;
+    }
+    if (header.version != RECORD_BINARY_VERSION) {
+      fprintf(stderr, "%s: unsupported version %" PRIu32 "\n", argv[i], header.version);
+      return 1;
+    }
+    files.emplace_back(static_cast<uint64_t>(header.sequence), std::move(contents));
+  }
+  std::sort(files.begin(), files.end(),
+            [](const std::pair<uint64_t, std::string>& a,
+               const std::pair<uint64_t, std::string>& b) { return a.first < b.first; });
+
+  for (const auto& file : files) {
+    const std::string& contents = file.second;
+    // A file that was being written when it was copied can end with a
+    // partial entry, which is ignored.
+    for (size_t offset = sizeof(RecordBinaryHeader);
+         offset + sizeof(RecordBinaryEntry) <= contents.size();
+         offset += sizeof(RecordBinaryEntry)) {
+      RecordBinaryEntry entry;
+      memcpy(&entry, &contents[offset], sizeof(entry));
+      if (!PrintEntry(entry)) {
+        fprintf(stderr, "unknown entry type %" PRIu32 " in file %" PRIu64 "\n", entry.type,
+                file.first);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
@@ -25,6 +25,7 @@
 #include "private/bionic_macros.h"
 
 struct abort_msg_t;
+struct libc_linker_stats;
 
 // When the kernel starts the dynamic linker, it passes a pointer to a block
 // of memory containing argc, the argv array, the environment variable array,
@@ -47,6 +48,9 @@ class KernelArgumentBlock {
     ++p; // Skip the NULL itself.
 
     auxv = reinterpret_cast<ElfW(auxv_t)*>(p);
+
+    startup_trace = nullptr;
+    linker_stats = nullptr;
   }
 
   // Similar to ::getauxval but doesn't require the libc global variables to be set up,
@@ -67,6 +71,10 @@ class KernelArgumentBlock {
 
   abort_msg_t** abort_message_ptr;
 
+  struct startup_trace* startup_trace;
+
+  struct libc_linker_stats* linker_stats;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(KernelArgumentBlock);
 };
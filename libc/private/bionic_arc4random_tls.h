@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BIONIC_PRIVATE_BIONIC_ARC4RANDOM_TLS_H_
+#define __BIONIC_PRIVATE_BIONIC_ARC4RANDOM_TLS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// A thread's own ChaCha arc4random generator, keyed from the process-wide one
+// so that threads calling arc4random don't contend on its lock. It works like
+// the process-wide one: the keystream is generated a buffer at a time, the
+// first bytes of each buffer become the next key, and bytes are wiped as
+// they're handed out.
+struct bionic_arc4random_tls {
+  unsigned fork_generation;  // Of the process it was keyed in; 0 if unkeyed.
+  size_t have;               // Unused keystream bytes at the end of 'buf'.
+  size_t count;              // Bytes to hand out before rekeying from the shared generator.
+  uint32_t chacha[16];
+  unsigned char buf[1024];
+};
+
+__BEGIN_DECLS
+
+// Returns the calling thread's generator, or NULL before its TLS is set up.
+__LIBC_HIDDEN__ struct bionic_arc4random_tls* __bionic_arc4random_tls(void);
+
+__END_DECLS
+
+#endif /* __BIONIC_PRIVATE_BIONIC_ARC4RANDOM_TLS_H_ */
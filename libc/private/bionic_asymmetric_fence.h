@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BIONIC_PRIVATE_BIONIC_ASYMMETRIC_FENCE_H_
+#define __BIONIC_PRIVATE_BIONIC_ASYMMETRIC_FENCE_H_
+
+#include <stdatomic.h>
+#include <sys/cdefs.h>
+
+// Asymmetric fences are for data whose readers are frequent and whose writers are rare, where
+// each side has to see the other's store before its own load (a reader announcing itself in a
+// counter and then checking for a writer, say). A reader's __asymmetric_fence_light and a
+// writer's __asymmetric_fence_heavy order those accesses as two seq_cst fences would.
+//
+// Once the process has registered for MEMBARRIER_CMD_PRIVATE_EXPEDITED, which the first heavy
+// fence tries to do, the light fence is only a compiler barrier and the heavy fence makes the
+// kernel run a barrier on every other thread of the process that's running. Until then, or if
+// the kernel doesn't support it or the process has a seccomp filter, both are ordinary seq_cst
+// fences.
+
+#define BIONIC_MEMBARRIER_UNKNOWN 0
+#define BIONIC_MEMBARRIER_REGISTERED 1
+#define BIONIC_MEMBARRIER_UNSUPPORTED 2
+
+__LIBC_HIDDEN__ extern atomic_int __bionic_membarrier_state;
+
+static inline __always_inline void __asymmetric_fence_light() {
+  if (__predict_true(atomic_load_explicit(&__bionic_membarrier_state, memory_order_relaxed) ==
+                     BIONIC_MEMBARRIER_REGISTERED)) {
+    atomic_signal_fence(memory_order_seq_cst);
+  } else {
+    atomic_thread_fence(memory_order_seq_cst);
+  }
+}
+
+__LIBC_HIDDEN__ void __asymmetric_fence_heavy();
+
+#endif  // __BIONIC_PRIVATE_BIONIC_ASYMMETRIC_FENCE_H_
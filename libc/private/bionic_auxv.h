@@ -36,6 +36,11 @@ __BEGIN_DECLS
 
 extern ElfW(auxv_t)* __libc_auxv;
 
+// Sets __libc_auxv and indexes it for getauxval. Like everything else that
+// writes libc globals during startup, it's called by the linker for its own
+// copy and again for libc's.
+__LIBC_HIDDEN__ void __libc_init_auxv(ElfW(auxv_t)* auxv);
+
 __END_DECLS
 
 #endif /* _PRIVATE_BIONIC_AUXV_H_ */
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BIONIC_PRIVATE_BIONIC_ELF_TLS_H_
+#define __BIONIC_PRIVATE_BIONIC_ELF_TLS_H_
+
+#include <link.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// ELF TLS (PT_TLS segments and thread_local/__thread variables compiled without
+// -femulated-tls).
+//
+// Each thread has a static TLS block holding bionic's TLS slots and the TLS
+// segments of the executable and of every library loaded at startup, at offsets
+// from the thread pointer that are fixed for the life of the process, so code can
+// use the initial-exec and local-exec access models. The executable's segment is
+// where the ABI says it has to be relative to the thread pointer: just below it on
+// x86 (variant 2), just after the two-word TCB on ARM (variant 1).
+//
+// Segments of libraries loaded later by dlopen are allocated on first use, per
+// thread, by __tls_get_addr (and TLSDESC on arm64), which find them through the
+// thread's dynamic thread vector (DTV). ELF TLS isn't supported on MIPS.
+//
+// The linker computes the layout and keeps the table of modules in
+// __libc_tls_globals, which libc.so shares with it (see bionic_globals.h).
+
+struct TlsSegment {
+  size_t size = 0;
+  size_t alignment = 1;
+  const void* init_ptr = "";  // Never null, even if init_size is 0.
+  size_t init_size = 0;
+};
+
+// Finds the PT_TLS segment in a program header table, if there is one. Returns false
+// if there isn't, or if it's malformed (in which case alignment is set to 0).
+__LIBC_HIDDEN__ bool __bionic_get_tls_segment(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                                              ElfW(Addr) load_bias, TlsSegment* out);
+
+class StaticTlsLayout {
+ public:
+  constexpr StaticTlsLayout() {}
+
+  // Reserves bionic's TLS slots and the executable's segment (which may be null), and
+  // returns the offset of the latter. Must be called first.
+  size_t reserve_exe_segment_and_tcb(const TlsSegment* exe_segment, const char* progname);
+
+  // Reserves a library's segment and returns its offset.
+  size_t reserve_solib_segment(const TlsSegment& segment);
+
+  // After this, nothing more can be reserved.
+  void finish_layout();
+
+  bool is_finished() const { return finished_; }
+  size_t size() const { return offset_; }
+  size_t alignment() const { return alignment_; }
+
+  // Offsets are from the start of the block, which must be aligned to alignment().
+  // The thread pointer is at tcb_offset().
+  size_t tcb_offset() const { return tcb_offset_; }
+
+ private:
+  size_t reserve(size_t size, size_t alignment);
+
+  size_t offset_ = 0;
+  size_t alignment_ = 1;
+  size_t tcb_offset_ = 0;
+  bool finished_ = false;
+};
+
+// Module IDs start at 1, so that a zeroed TlsIndex is recognizably invalid.
+static constexpr size_t kTlsUninitializedModuleId = 0;
+
+// The static_offset of a module that isn't in the static TLS block.
+static constexpr size_t kTlsNoStaticOffset = SIZE_MAX;
+
+struct TlsModule {
+  TlsSegment segment;
+
+  // Offset of this module's segment in the static TLS block, or kTlsNoStaticOffset.
+  size_t static_offset = kTlsNoStaticOffset;
+
+  // The generation in which this module was registered, or 0 if this entry is free.
+  size_t first_generation = 0;
+
+  // The linker's soinfo, for lookups by dlsym.
+  void* soinfo_ptr = nullptr;
+};
+
+struct TlsModules {
+  constexpr TlsModules() {}
+
+  // Incremented every time a module is registered or unregistered. A DTV that's
+  // up to date with the current generation can be used without taking the lock.
+  _Atomic(size_t) generation = ATOMIC_VAR_INIT(1);
+
+  // Entry i is module i + 1. Written by the linker with rwlock held for writing.
+  size_t module_count = 0;
+  TlsModule* module_table = nullptr;
+
+  pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+};
+
+// The dynamic thread vector: each thread's map from module ID to that module's
+// TLS block, or null if the thread hasn't used it yet. Allocated with mmap, so
+// that it works the same whether the linker or libc.so allocates it. The
+// arm64 TLSDESC resolver knows this layout.
+struct TlsDtv {
+  // The TlsModules generation this DTV was last brought up to date with.
+  size_t generation;
+
+  // Entries in modules.
+  size_t count;
+
+  // The DTV this one replaced. A signal handler may have interrupted a lookup in an
+  // old DTV, so they're only freed when the thread exits.
+  TlsDtv* next;
+
+  void* modules[];
+};
+
+// What the compiler passes to __tls_get_addr.
+struct TlsIndex {
+  size_t module_id;
+  size_t offset;
+};
+
+// The argument of the arm64 TLSDESC resolver for a module that isn't in static TLS.
+struct TlsDynamicResolverArg {
+  size_t generation;
+  TlsIndex index;
+};
+
+struct libc_tls_globals {
+  StaticTlsLayout static_tls_layout;
+  TlsModules tls_modules;
+};
+
+__BEGIN_DECLS
+
+// Exported for compiler-generated code using the general-dynamic and local-dynamic
+// access models.
+void* __tls_get_addr(const TlsIndex* ti);
+#if defined(__i386__)
+// i386 code calls this one instead, with the argument in %eax.
+__attribute__((__regparm__(1))) void* ___tls_get_addr(const TlsIndex* ti);
+#endif
+
+// Copies the initialization images of the modules in static TLS into a new thread's
+// static TLS block, whose thread pointer is 'tls'.
+__LIBC_HIDDEN__ void __init_static_tls(void** tls);
+
+// Frees a thread's DTV and dynamically allocated TLS blocks. Must be called by the
+// thread itself, as it exits.
+__LIBC_HIDDEN__ void __free_dynamic_tls(void** tls);
+
+__END_DECLS
+
+#endif /* __BIONIC_PRIVATE_BIONIC_ELF_TLS_H_ */
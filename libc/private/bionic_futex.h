@@ -32,10 +32,13 @@
 #include <linux/futex.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/cdefs.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include "private/bionic_stats.h"
+
 __BEGIN_DECLS
 
 struct timespec;
@@ -62,16 +65,48 @@ static inline int __futex_wake_ex(volatile void* ftx, bool shared, int count) {
 }
 
 static inline int __futex_wait(volatile void* ftx, int value, const struct timespec* timeout) {
+  __libc_stats_add(LIBC_STAT_FUTEX_WAITS, 1);
   return __futex(ftx, FUTEX_WAIT, value, timeout, 0);
 }
 
 static inline int __futex_wait_ex(volatile void* ftx, bool shared, int value,
                                   bool use_realtime_clock, const struct timespec* abs_timeout) {
+  __libc_stats_add(LIBC_STAT_FUTEX_WAITS, 1);
   return __futex(ftx, (shared ? FUTEX_WAIT_BITSET : FUTEX_WAIT_BITSET_PRIVATE) |
                  (use_realtime_clock ? FUTEX_CLOCK_REALTIME : 0), value, abs_timeout,
                  FUTEX_BITSET_MATCH_ANY);
 }
 
+// Wakes up to wake_count threads waiting on ftx and moves up to requeue_count more onto the
+// wait queue of ftx2 without waking them, provided ftx still holds expected_value. Returns
+// -EAGAIN without touching either queue if it doesn't.
+static inline int __futex_cmp_requeue_ex(volatile void* ftx, bool shared, int wake_count,
+                                         int requeue_count, volatile void* ftx2,
+                                         int expected_value) {
+  int saved_errno = errno;
+  // The kernel takes requeue_count from the timeout argument.
+  int result = syscall(__NR_futex, ftx, shared ? FUTEX_CMP_REQUEUE : FUTEX_CMP_REQUEUE_PRIVATE,
+                       wake_count, (const struct timespec*)(intptr_t)requeue_count, ftx2,
+                       expected_value);
+  if (__predict_false(result == -1)) {
+    result = -errno;
+    errno = saved_errno;
+  }
+  return result;
+}
+
+// Like FUTEX_WAIT_BITSET, FUTEX_LOCK_PI takes an absolute timeout, but it is always measured
+// against CLOCK_REALTIME.
+static inline int __futex_pi_lock_ex(volatile void* ftx, bool shared,
+                                     const struct timespec* abs_realtime_timeout) {
+  __libc_stats_add(LIBC_STAT_FUTEX_WAITS, 1);
+  return __futex(ftx, shared ? FUTEX_LOCK_PI : FUTEX_LOCK_PI_PRIVATE, 0, abs_realtime_timeout, 0);
+}
+
+static inline int __futex_pi_unlock(volatile void* ftx, bool shared) {
+  return __futex(ftx, shared ? FUTEX_UNLOCK_PI : FUTEX_UNLOCK_PI_PRIVATE, 0, NULL, 0);
+}
+
 __END_DECLS
 
 #endif /* _BIONIC_FUTEX_H */
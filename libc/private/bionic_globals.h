@@ -31,6 +31,7 @@
 
 #include <sys/cdefs.h>
 
+#include "private/bionic_elf_tls.h"
 #include "private/bionic_malloc_dispatch.h"
 #include "private/bionic_vdso.h"
 #include "private/WriteProtected.h"
@@ -41,7 +42,18 @@ struct libc_globals {
   MallocDispatch malloc_dispatch;
 };
 
-__LIBC_HIDDEN__ extern WriteProtected<libc_globals> __libc_globals;
+// Static executables and the linker define this in libc_init_static.cpp. libc.so
+// has no copy of its own: the linker exports its copy, already initialized, so
+// a dynamic process only has one of these pages to dirty rather than two. The
+// reference from libc.so is resolved through its GOT, which is read-only after
+// relocation like the page itself.
+extern WriteProtected<libc_globals> __libc_globals
+    __attribute__((__weak__, __visibility__("default")));
+
+// Shared the same way, but not write protected, because dlopen and dlclose change
+// the TLS modules. See bionic_elf_tls.h.
+extern libc_tls_globals __libc_tls_globals
+    __attribute__((__weak__, __visibility__("default")));
 
 class KernelArgumentBlock;
 __LIBC_HIDDEN__ void __libc_init_malloc(libc_globals* globals);
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BIONIC_IO_URING_H
+#define BIONIC_IO_URING_H
+
+#include <stdint.h>
+#include <sys/syscall.h>
+
+// io_uring (Linux 5.1) is newer than our uapi headers, so the ABI bits
+// android_io_ring needs are copied here from <linux/io_uring.h>.
+
+// io_uring was the first syscall to get the same number on every architecture.
+#if !defined(__NR_io_uring_setup)
+#if defined(__arm__)
+#define __NR_io_uring_setup (__NR_SYSCALL_BASE + 425)
+#define __NR_io_uring_enter (__NR_SYSCALL_BASE + 426)
+#define __NR_io_uring_register (__NR_SYSCALL_BASE + 427)
+#elif defined(__mips__)
+#define __NR_io_uring_setup (__NR_Linux + 425)
+#define __NR_io_uring_enter (__NR_Linux + 426)
+#define __NR_io_uring_register (__NR_Linux + 427)
+#else
+#define __NR_io_uring_setup 425
+#define __NR_io_uring_enter 426
+#define __NR_io_uring_register 427
+#endif
+#endif
+
+#define BIONIC_IORING_OP_READV 1
+#define BIONIC_IORING_OP_WRITEV 2
+#define BIONIC_IORING_OP_FSYNC 3
+#define BIONIC_IORING_OP_POLL_ADD 6
+
+#define BIONIC_IORING_FSYNC_DATASYNC (1U << 0)
+
+#define BIONIC_IORING_ENTER_GETEVENTS (1U << 0)
+
+// mmap offsets of the three regions shared with the kernel.
+#define BIONIC_IORING_OFF_SQ_RING 0ULL
+#define BIONIC_IORING_OFF_CQ_RING 0x8000000ULL
+#define BIONIC_IORING_OFF_SQES 0x10000000ULL
+
+// struct io_uring_sqe.
+struct bionic_io_uring_sqe {
+  uint8_t opcode;
+  uint8_t flags;
+  uint16_t ioprio;
+  int32_t fd;
+  uint64_t off;
+  uint64_t addr;
+  uint32_t len;
+  union {
+    int32_t rw_flags;
+    uint32_t fsync_flags;
+    uint16_t poll_events;
+  };
+  uint64_t user_data;
+  union {
+    uint16_t buf_index;
+    uint64_t __pad2[3];
+  };
+};
+
+// struct io_uring_cqe.
+struct bionic_io_uring_cqe {
+  uint64_t user_data;
+  int32_t res;
+  uint32_t flags;
+};
+
+// struct io_sqring_offsets.
+struct bionic_io_sqring_offsets {
+  uint32_t head;
+  uint32_t tail;
+  uint32_t ring_mask;
+  uint32_t ring_entries;
+  uint32_t flags;
+  uint32_t dropped;
+  uint32_t array;
+  uint32_t resv1;
+  uint64_t resv2;
+};
+
+// struct io_cqring_offsets.
+struct bionic_io_cqring_offsets {
+  uint32_t head;
+  uint32_t tail;
+  uint32_t ring_mask;
+  uint32_t ring_entries;
+  uint32_t overflow;
+  uint32_t cqes;
+  uint64_t resv[2];
+};
+
+// struct io_uring_params.
+struct bionic_io_uring_params {
+  uint32_t sq_entries;
+  uint32_t cq_entries;
+  uint32_t flags;
+  uint32_t sq_thread_cpu;
+  uint32_t sq_thread_idle;
+  uint32_t resv[5];
+  bionic_io_sqring_offsets sq_off;
+  bionic_io_cqring_offsets cq_off;
+};
+
+#endif // BIONIC_IO_URING_H
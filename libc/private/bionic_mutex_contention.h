@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PRIVATE_BIONIC_MUTEX_CONTENTION_H
+#define _PRIVATE_BIONIC_MUTEX_CONTENTION_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// Called once a sampled contended pthread_mutex_lock or pthread_mutex_timedlock
+// has returned from waiting, with the mutex and how long the wait took.
+// The mutex may or may not be held: timed locks are reported too.
+typedef void (*MutexContentionFunc)(const void* mutex, uint64_t wait_ns);
+
+__BEGIN_DECLS
+
+// Sets the function to call for one in every 'sample_interval' contended
+// mutex acquisitions, or turns contention profiling off if 'func' is null.
+// Used by malloc debug's mutex_contention option.
+__LIBC_HIDDEN__ void __libc_set_mutex_contention_func(MutexContentionFunc func,
+                                                      uint32_t sample_interval);
+
+__END_DECLS
+
+#endif  // _PRIVATE_BIONIC_MUTEX_CONTENTION_H
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_ONCE_H
+#define _BIONIC_ONCE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/cdefs.h>
+
+// The values of a pthread_once_t, which is an atomic_int in the implementation.
+// PTHREAD_ONCE_INIT is 0.
+#define ONCE_INITIALIZATION_NOT_YET_STARTED           0
+#define ONCE_INITIALIZATION_UNDERWAY                  1
+#define ONCE_INITIALIZATION_COMPLETE                  2
+#define ONCE_INITIALIZATION_UNDERWAY_WITH_WAITERS     3
+
+// pthread_once for callers inside libc that run often enough for the call to matter:
+// once initialization is complete, this is a single acquire load.
+static inline __always_inline int __bionic_once(pthread_once_t* once_control,
+                                                void (*init_routine)(void)) {
+  atomic_int* once_control_ptr = reinterpret_cast<atomic_int*>(once_control);
+  if (__predict_true(atomic_load_explicit(once_control_ptr, memory_order_acquire) ==
+                     ONCE_INITIALIZATION_COMPLETE)) {
+    return 0;
+  }
+  return pthread_once(once_control, init_routine);
+}
+
+#endif // _BIONIC_ONCE_H
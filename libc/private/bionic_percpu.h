@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_PERCPU_H
+#define _BIONIC_PERCPU_H
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "private/bionic_lock.h"
+
+// Per-CPU data for statistics and caches that many threads update at once.
+// Each slot has a cache line of its own and is picked by the CPU the caller is
+// running on, which sched_getcpu reads from the thread's rseq area, so threads
+// on different CPUs don't share anything. A thread can still migrate between
+// picking a slot and using it, so slots are only ever updated atomically or
+// under their lock; that's uncontended in the common case.
+//
+// Like Lock, these classes can be initialized by setting their memory to 0.
+
+#define BIONIC_PERCPU_SLOT_COUNT 64
+
+static inline size_t __bionic_percpu_slot() {
+  int cpu = sched_getcpu();
+  return (cpu < 0) ? 0 : static_cast<size_t>(cpu) % BIONIC_PERCPU_SLOT_COUNT;
+}
+
+class PerCpuCounter {
+ public:
+  void add(int64_t delta) {
+    atomic_fetch_add_explicit(&slots_[__bionic_percpu_slot()].value, delta, memory_order_relaxed);
+  }
+
+  // Not a snapshot: adds that race with this may or may not be counted.
+  int64_t sum() const {
+    int64_t result = 0;
+    for (size_t i = 0; i < BIONIC_PERCPU_SLOT_COUNT; ++i) {
+      result += atomic_load_explicit(&slots_[i].value, memory_order_relaxed);
+    }
+    return result;
+  }
+
+ private:
+  struct alignas(64) Slot {
+    _Atomic(int64_t) value;
+  };
+  Slot slots_[BIONIC_PERCPU_SLOT_COUNT];
+};
+
+// LIFO lists of free objects, one per CPU. The first word of a pushed object is used as the
+// list link. pop() takes from the caller's CPU, and only looks at other CPUs' lists when
+// that one is empty.
+class PerCpuFreeList {
+ public:
+  void push(void* object) {
+    Slot& slot = slots_[__bionic_percpu_slot()];
+    slot.lock.lock();
+    *reinterpret_cast<void**>(object) = atomic_load_explicit(&slot.head, memory_order_relaxed);
+    atomic_store_explicit(&slot.head, object, memory_order_relaxed);
+    slot.lock.unlock();
+  }
+
+  // Returns nullptr if every list is empty.
+  void* pop() {
+    size_t home = __bionic_percpu_slot();
+    for (size_t i = 0; i < BIONIC_PERCPU_SLOT_COUNT; ++i) {
+      Slot& slot = slots_[(home + i) % BIONIC_PERCPU_SLOT_COUNT];
+      // Peek without the lock so that an empty system doesn't take 64 locks.
+      if (atomic_load_explicit(&slot.head, memory_order_relaxed) == nullptr) {
+        continue;
+      }
+      slot.lock.lock();
+      void* object = atomic_load_explicit(&slot.head, memory_order_relaxed);
+      if (object != nullptr) {
+        atomic_store_explicit(&slot.head, *reinterpret_cast<void**>(object), memory_order_relaxed);
+      }
+      slot.lock.unlock();
+      if (object != nullptr) {
+        return object;
+      }
+    }
+    return nullptr;
+  }
+
+  // Takes a particular object off whichever list it's on. This walks the lists, so it's
+  // only for rare cases. Returns false if the object wasn't on any of them.
+  bool remove(void* object) {
+    for (size_t i = 0; i < BIONIC_PERCPU_SLOT_COUNT; ++i) {
+      Slot& slot = slots_[i];
+      if (atomic_load_explicit(&slot.head, memory_order_relaxed) == nullptr) {
+        continue;
+      }
+      slot.lock.lock();
+      void* prev = nullptr;
+      void* p = atomic_load_explicit(&slot.head, memory_order_relaxed);
+      while (p != nullptr && p != object) {
+        prev = p;
+        p = *reinterpret_cast<void**>(p);
+      }
+      if (p != nullptr) {
+        void* next = *reinterpret_cast<void**>(p);
+        if (prev == nullptr) {
+          atomic_store_explicit(&slot.head, next, memory_order_relaxed);
+        } else {
+          *reinterpret_cast<void**>(prev) = next;
+        }
+      }
+      slot.lock.unlock();
+      if (p != nullptr) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  struct alignas(64) Slot {
+    Lock lock;
+    _Atomic(void*) head;
+  };
+  Slot slots_[BIONIC_PERCPU_SLOT_COUNT];
+};
+
+#endif  // _BIONIC_PERCPU_H
@@ -23,4 +23,11 @@
 #define PR_SET_VMA   0x53564d41
 #define PR_SET_VMA_ANON_NAME    0
 
+// Newer than our uapi headers: lets the kernel accept tagged pointers
+// (arm64 top-byte-ignore) as system call arguments.
+#if !defined(PR_SET_TAGGED_ADDR_CTRL)
+#define PR_SET_TAGGED_ADDR_CTRL 55
+#define PR_TAGGED_ADDR_ENABLE   (1UL << 0)
+#endif
+
 #endif // BIONIC_PRCTL_H
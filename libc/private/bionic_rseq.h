@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BIONIC_RSEQ_H
+#define BIONIC_RSEQ_H
+
+#include <stdint.h>
+#include <sys/syscall.h>
+
+// Restartable sequences (Linux 4.18) are newer than our uapi headers, so the
+// ABI bits we need are copied here from <linux/rseq.h>.
+
+#if !defined(__NR_rseq)
+#if defined(__arm__)
+#define __NR_rseq (__NR_SYSCALL_BASE + 398)
+#elif defined(__aarch64__)
+#define __NR_rseq 293
+#elif defined(__i386__)
+#define __NR_rseq 386
+#elif defined(__x86_64__)
+#define __NR_rseq 334
+#elif defined(__mips__) && !defined(__LP64__)
+#define __NR_rseq (__NR_Linux + 367)
+#elif defined(__mips__) && defined(__LP64__)
+#define __NR_rseq (__NR_Linux + 327)
+#endif
+#endif
+
+// The signature the kernel checks before jumping to an abort handler. bionic
+// doesn't define any critical sections itself, but everyone registering for a
+// thread has to agree on it, so these are the values other libcs use.
+#if defined(__arm__)
+#define BIONIC_RSEQ_SIG 0xe7f5def3
+#elif defined(__aarch64__)
+#define BIONIC_RSEQ_SIG 0xd428bc00
+#elif defined(__i386__) || defined(__x86_64__)
+#define BIONIC_RSEQ_SIG 0x53053053
+#elif defined(__mips__)
+#define BIONIC_RSEQ_SIG 0x0350004a
+#endif
+
+#define BIONIC_RSEQ_FLAG_UNREGISTER 1
+
+// Values of cpu_id while the area isn't registered.
+#define BIONIC_RSEQ_CPU_ID_UNINITIALIZED (-1)
+#define BIONIC_RSEQ_CPU_ID_REGISTRATION_FAILED (-2)
+
+// struct rseq from <linux/rseq.h>. The kernel keeps cpu_id up to date on every
+// return to user space for as long as the area is registered.
+struct bionic_rseq {
+  uint32_t cpu_id_start;
+  uint32_t cpu_id;
+  uint64_t rseq_cs;
+  uint32_t flags;
+} __attribute__((aligned(4 * sizeof(uint64_t))));
+
+#endif // BIONIC_RSEQ_H
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2015 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PRIVATE_BIONIC_STARTUP_TRACE_H
+#define _PRIVATE_BIONIC_STARTUP_TRACE_H
+
+#include <android/startup_trace.h>
+#include <sys/cdefs.h>
+
+class KernelArgumentBlock;
+
+#define STARTUP_TRACE_MAX_PHASES 32
+
+struct startup_trace {
+  size_t count;
+  android_startup_phase phases[STARTUP_TRACE_MAX_PHASES];
+};
+
+// Null unless the process asked to be traced. In a dynamic executable this
+// points at the linker's record, which libc.so adds its own phases to.
+__LIBC_HIDDEN__ extern startup_trace* __libc_startup_trace;
+
+// Starts a trace if LIBC_STARTUP_TRACE=1 is set, recording a "start" phase and
+// setting 'args.startup_trace' for libc.so to pick up. It may make system
+// calls, so it has to come after TLS is set up.
+__LIBC_HIDDEN__ void __libc_init_startup_trace(KernelArgumentBlock& args);
+
+__LIBC_HIDDEN__ void __libc_record_startup_phase(startup_trace* trace, const char* name);
+
+static inline void __libc_startup_phase(const char* name) {
+  if (__predict_false(__libc_startup_trace != nullptr)) {
+    __libc_record_startup_phase(__libc_startup_trace, name);
+  }
+}
+
+#endif  // _PRIVATE_BIONIC_STARTUP_TRACE_H
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PRIVATE_BIONIC_STATS_H
+#define _PRIVATE_BIONIC_STATS_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// The counters behind android_libc_get_stats. Those for events in libc are
+// kept per thread in pthread_internal_t, and those for the dynamic linker's
+// calls in a libc_linker_stats, updated with g_dl_mutex held.
+
+enum {
+  LIBC_STAT_MUTEX_CONTENTIONS,
+  LIBC_STAT_FUTEX_WAITS,
+  LIBC_STAT_STDIO_FLUSHES,
+  LIBC_STAT_MALLOC_CALLS,
+  LIBC_STAT_FREE_CALLS,
+  LIBC_STAT_RESOLVER_CACHE_HITS,
+  LIBC_STAT_RESOLVER_CACHE_MISSES,
+  LIBC_STAT_PROPERTY_LOOKUPS,
+  LIBC_STAT_COUNT
+};
+
+struct libc_thread_stats {
+  // Only written by the thread itself, but read by android_libc_get_stats
+  // from any thread, so both sides use relaxed atomic accesses.
+  uint64_t counters[LIBC_STAT_COUNT];
+};
+
+struct libc_linker_stats {
+  // Set by the first android_libc_get_stats call.
+  int timing_enabled;
+  uint64_t dlopen_calls;
+  uint64_t dlopen_time_ns;
+  uint64_t dlsym_calls;
+  uint64_t dlsym_time_ns;
+};
+
+__BEGIN_DECLS
+
+// Adds 'n' to one of the calling thread's counters. For C code, and for
+// callers about to make a system call anyway; hot paths in C++ use the
+// inline __libc_stats_inc from pthread_internal.h.
+__LIBC_HIDDEN__ void __libc_stats_add(int stat, uint64_t n);
+
+// The dynamic linker's counters, or null in a static executable. In the
+// linker itself this is unused; it passes its copy to libc.so in the
+// KernelArgumentBlock.
+__LIBC_HIDDEN__ extern struct libc_linker_stats* __libc_linker_stats;
+
+__END_DECLS
+
+#endif  // _PRIVATE_BIONIC_STATS_H
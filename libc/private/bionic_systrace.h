@@ -17,6 +17,8 @@
 #ifndef BIONIC_SYSTRACE_H
 #define BIONIC_SYSTRACE_H
 
+#include <stdint.h>
+
 #include "bionic_macros.h"
 
 // Tracing class for bionic. To begin a trace at a specified point:
@@ -37,4 +39,8 @@ class __LIBC_HIDDEN__ ScopedTrace {
 void bionic_trace_begin(const char* message);
 void bionic_trace_end();
 
+// Records the current value of a counter, such as an allocator or linker
+// statistic, as a "C|pid|name|value" event.
+void bionic_trace_counter(const char* name, int64_t value);
+
 #endif
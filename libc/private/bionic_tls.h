@@ -31,6 +31,7 @@
 
 #include <locale.h>
 #include <mntent.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <sys/cdefs.h>
 #include <sys/param.h>
@@ -38,6 +39,8 @@
 #include "bionic_macros.h"
 #include "__get_tls.h"
 #include "grp_pwd.h"
+#include "bionic_tz_memo.h"
+#include "bionic_arc4random_tls.h"
 
 __BEGIN_DECLS
 
@@ -53,7 +56,21 @@ __BEGIN_DECLS
  **/
 
 // Well-known TLS slots. What data goes in which slot is arbitrary unless otherwise noted.
+//
+// The thread pointer points at slot 0. On ARM, the ELF TLS ABI puts the executable's TLS
+// block at the thread pointer plus the segment's alignment (or two words, if that's more),
+// and toolchains targeting Android align TLS segments to eight words to leave room for
+// slots 0-7. Anything else has to go below the thread pointer, at a negative index.
 enum {
+#if defined(__arm__) || defined(__aarch64__)
+  // The dynamic thread vector, see bionic_elf_tls.h.
+  TLS_SLOT_DTV = -2,
+
+  // Lets TSAN avoid using pthread_getspecific for finding the current thread
+  // state.
+  TLS_SLOT_TSAN = -1,
+#endif
+
   TLS_SLOT_SELF = 0, // The kernel requires this specific slot for x86.
   TLS_SLOT_THREAD_ID,
   TLS_SLOT_ERRNO,
@@ -75,16 +92,33 @@ enum {
   // Fast storage for Thread::Current() in ART.
   TLS_SLOT_ART_THREAD_SELF,
 
+#if !defined(__arm__) && !defined(__aarch64__)
   // Lets TSAN avoid using pthread_getspecific for finding the current thread
   // state.
   TLS_SLOT_TSAN,
 
+  // The dynamic thread vector, see bionic_elf_tls.h.
+  TLS_SLOT_DTV,
+#endif
+
   BIONIC_TLS_SLOTS // Must come last!
 };
 
+#if defined(__arm__) || defined(__aarch64__)
+#define MIN_TLS_SLOT TLS_SLOT_DTV
+#else
+#define MIN_TLS_SLOT TLS_SLOT_SELF
+#endif
+
+// The slots, from MIN_TLS_SLOT to BIONIC_TLS_SLOTS - 1. The thread pointer points
+// at the one for slot 0.
+#define BIONIC_TCB_SIZE ((BIONIC_TLS_SLOTS - MIN_TLS_SLOT) * sizeof(void*))
+
 // ~3 pages.
 struct bionic_tls {
   locale_t locale;
+  // locale->mb_cur_max, or 0 if the thread uses the global locale, for MB_CUR_MAX.
+  size_t locale_mb_cur_max;
 
   char basename_buf[MAXPATHLEN];
   char dirname_buf[MAXPATHLEN];
@@ -100,6 +134,10 @@ struct bionic_tls {
 
   group_state_t group;
   passwd_state_t passwd;
+
+  bionic_tz_memo tz_memo;
+
+  bionic_arc4random_tls arc4random;
 };
 
 #define BIONIC_TLS_SIZE (BIONIC_ALIGN(sizeof(bionic_tls), PAGE_SIZE))
@@ -128,11 +166,19 @@ struct bionic_tls {
  */
 #define BIONIC_PTHREAD_KEY_COUNT (BIONIC_PTHREAD_KEY_RESERVED_COUNT + PTHREAD_KEYS_MAX)
 
+/*
+ * Like pthread_getspecific, but without checking that the key is valid and still live, which
+ * saves the loads of the global key state on hot paths. The key must have been returned by
+ * pthread_key_create and not deleted since.
+ */
+void* __pthread_getspecific_unchecked(pthread_key_t key);
+
 __END_DECLS
 
 #if defined(__cplusplus)
 class KernelArgumentBlock;
 extern void __libc_init_main_thread(KernelArgumentBlock&);
+extern void __libc_init_main_thread_final();
 #endif
 
 #endif /* __BIONIC_PRIVATE_BIONIC_TLS_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BIONIC_PRIVATE_BIONIC_TZ_MEMO_H_
+#define __BIONIC_PRIVATE_BIONIC_TZ_MEMO_H_
+
+#include <sys/cdefs.h>
+#include <time.h>
+
+// The last local time converted by localtime_r on a thread. Any time in
+// [start, end) is on the same local day with the same UTC offset, so it
+// converts to 'tm' with only the time of day changed.
+struct bionic_tz_memo {
+  unsigned generation;  // Of the local zone the memo is for; 0 if unused.
+  int type;             // Index of the zone's time type in [start, end).
+  time_t day_start;     // The local midnight that 'tm' is for.
+  time_t start;
+  time_t end;
+  struct tm tm;
+};
+
+__BEGIN_DECLS
+
+// Returns the calling thread's memo, or NULL before its TLS is set up.
+__LIBC_HIDDEN__ struct bionic_tz_memo* __bionic_tz_memo(void);
+
+__END_DECLS
+
+#endif /* __BIONIC_PRIVATE_BIONIC_TZ_MEMO_H_ */
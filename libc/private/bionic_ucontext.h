@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _PRIVATE_BIONIC_UCONTEXT_H_
+#define _PRIVATE_BIONIC_UCONTEXT_H_
+
+/*
+ * Offsets into ucontext_t for getcontext, setcontext and swapcontext, which are
+ * written in assembler. ucontext.cpp checks them against <sys/ucontext.h>.
+ */
+
+#if defined(__aarch64__)
+
+#define UC_SIGMASK       40
+#define UC_X0            184  /* uc_mcontext.regs[0]; x1-x30 follow. */
+#define UC_SP            432
+#define UC_PC            440
+/* getcontext puts a struct fpsimd_context in uc_mcontext.__reserved, as the kernel does. */
+#define UC_FPSIMD        464
+#define UC_FPSIMD_FPSR   (UC_FPSIMD + 8)
+#define UC_FPSIMD_V0     (UC_FPSIMD + 16)
+#define FPSIMD_CONTEXT_MAGIC 0x46508001
+#define FPSIMD_CONTEXT_SIZE  528
+
+#elif defined(__arm__)
+
+#define UC_R0            32   /* uc_mcontext.arm_r0; r1-r15 follow. */
+#define UC_SP            84
+#define UC_LR            88
+#define UC_PC            92
+#define UC_SIGMASK       104
+/* getcontext stores fpscr and then d8-d15 in uc_regspace. */
+#define UC_REGSPACE      232
+
+#elif defined(__i386__)
+
+#define UC_EDI           36   /* uc_mcontext.gregs[REG_EDI]. */
+#define UC_ESI           40
+#define UC_EBP           44
+#define UC_ESP           48
+#define UC_EBX           52
+#define UC_EDX           56
+#define UC_ECX           60
+#define UC_EAX           64
+#define UC_EIP           76
+#define UC_FPREGS        96   /* uc_mcontext.fpregs, which getcontext points at __fpregs_mem. */
+#define UC_SIGMASK       108
+#define UC_FPREGS_MEM    116
+
+#elif defined(__x86_64__)
+
+#define UC_R8            40   /* uc_mcontext.gregs[REG_R8]. */
+#define UC_R9            48
+#define UC_R12           72
+#define UC_R13           80
+#define UC_R14           88
+#define UC_R15           96
+#define UC_RDI           104
+#define UC_RSI           112
+#define UC_RBP           120
+#define UC_RBX           128
+#define UC_RDX           136
+#define UC_RAX           144
+#define UC_RCX           152
+#define UC_RSP           160
+#define UC_RIP           168
+#define UC_FPREGS        224  /* uc_mcontext.fpregs, which getcontext points at __fpregs_mem. */
+#define UC_SIGMASK       296
+#define UC_FPREGS_MEM    304
+#define UC_MXCSR         (UC_FPREGS_MEM + 24)
+
+#endif
+
+#endif /* _PRIVATE_BIONIC_UCONTEXT_H_ */
@@ -31,16 +31,31 @@
 
 #include <time.h>
 
+// Entries whose symbol is nullptr aren't provided by that architecture's vdso.
 #if defined(__aarch64__)
 #define VDSO_CLOCK_GETTIME_SYMBOL "__kernel_clock_gettime"
 #define VDSO_GETTIMEOFDAY_SYMBOL  "__kernel_gettimeofday"
-#elif defined(__arm__) || defined(__i386__) || defined(__x86_64__)
+#define VDSO_CLOCK_GETRES_SYMBOL  "__kernel_clock_getres"
+#define VDSO_TIME_SYMBOL          nullptr
+#define VDSO_GETCPU_SYMBOL        nullptr
+#elif defined(__arm__)
 #define VDSO_CLOCK_GETTIME_SYMBOL "__vdso_clock_gettime"
 #define VDSO_GETTIMEOFDAY_SYMBOL  "__vdso_gettimeofday"
+#define VDSO_CLOCK_GETRES_SYMBOL  "__vdso_clock_getres"
+#define VDSO_TIME_SYMBOL          nullptr
+#define VDSO_GETCPU_SYMBOL        nullptr
+#elif defined(__i386__) || defined(__x86_64__)
+#define VDSO_CLOCK_GETTIME_SYMBOL "__vdso_clock_gettime"
+#define VDSO_GETTIMEOFDAY_SYMBOL  "__vdso_gettimeofday"
+#define VDSO_CLOCK_GETRES_SYMBOL  "__vdso_clock_getres"
+#define VDSO_TIME_SYMBOL          "__vdso_time"
+#define VDSO_GETCPU_SYMBOL        "__vdso_getcpu"
 #endif
 
 extern "C" int __clock_gettime(int, timespec*);
 extern "C" int __gettimeofday(timeval*, struct timezone*);
+extern "C" int __clock_getres(int, timespec*);
+extern "C" int __getcpu(unsigned*, unsigned*, void*);
 
 struct vdso_entry {
   const char* name;
@@ -50,6 +65,9 @@ struct vdso_entry {
 enum {
   VDSO_CLOCK_GETTIME = 0,
   VDSO_GETTIMEOFDAY,
+  VDSO_CLOCK_GETRES,
+  VDSO_TIME,
+  VDSO_GETCPU,
   VDSO_END
 };
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_WORK_QUEUE_H
+#define _BIONIC_WORK_QUEUE_H
+
+#include <stdatomic.h>
+#include <sys/cdefs.h>
+
+// A process-wide pool of worker threads for libc's own parallel work, so that
+// subsystems don't each have to start threads of their own. The workers are
+// only started the first time work is submitted. Each worker has a deque of
+// its own: work submitted from a worker goes on that worker's deque, work
+// submitted from any other thread goes on a shared queue, and idle workers
+// steal from the other deques.
+//
+// Work is submitted to a WorkGroup, which tracks how much of it hasn't
+// finished yet. If the queues are full, or the workers can't be started, the
+// submitting thread runs the work itself, so submission always succeeds.
+//
+// After fork, the child has no workers. Work that was queued but not started
+// is run by workers that the child starts on demand, but work that was
+// running in the parent at the time of the fork is lost, so a child must not
+// wait on a group that had work in flight.
+class WorkGroup {
+ public:
+  // Like Lock, a WorkGroup can be initialized by setting its memory to 0.
+  void init() {
+    atomic_init(&pending_, 0);
+  }
+
+  void submit(void (*fn)(void*), void* arg);
+
+  // Waits for all the work submitted to this group so far to finish. While
+  // waiting, the caller helps by running queued work, from any group.
+  void wait();
+
+ private:
+  friend class WorkQueue;
+  void finish_one();
+
+  atomic_uint pending_;
+};
+
+__LIBC_HIDDEN__ void __work_queue_fork_prepare();
+__LIBC_HIDDEN__ void __work_queue_fork_parent();
+__LIBC_HIDDEN__ void __work_queue_fork_child();
+
+#endif // _BIONIC_WORK_QUEUE_H
@@ -33,6 +33,8 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
 
 __BEGIN_DECLS
 
@@ -92,6 +94,27 @@ int __libc_format_log_va_list(int pri, const char* _Nonnull tag, const char* _No
 #endif
 int __libc_write_log(int pri, const char* _Nonnull tag, const char* _Nonnull msg);
 
+// Connects to logd now rather than when the first message is written. Returns 0, or -1 if
+// logd can't be reached.
+int __libc_open_log(void);
+
+// A message to be written later by __libc_write_log_records. The thread and time are
+// recorded by __libc_log_record_init, when the message is generated.
+struct __libc_log_record {
+  int priority;
+  pid_t tid;
+  struct timespec ts;
+  const char* _Nonnull tag;
+  const char* _Nonnull msg;
+};
+
+void __libc_log_record_init(struct __libc_log_record* _Nonnull record, int pri,
+                            const char* _Nonnull tag, const char* _Nonnull msg);
+
+// Writes several messages to the log, sending as many as possible with each system call.
+// Returns 0, or -1 if some couldn't be written.
+int __libc_write_log_records(const struct __libc_log_record* _Nonnull records, size_t count);
+
 #define CHECK(predicate) \
   do { \
     if (!(predicate)) { \
@@ -51,6 +51,8 @@ __LIBC_HIDDEN__ void    _thread_arc4_unlock(void);
 #define _ARC4_ATFORK(f) pthread_atfork(NULL, NULL, (f))
 
 extern volatile sig_atomic_t _rs_forked;
+/* Incremented in fork children, so per-thread generators know to rekey. */
+extern volatile unsigned _rs_fork_generation;
 
 __END_DECLS
 
@@ -34,12 +34,66 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <errno.h>
+#include <sys/param.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #include "local.h"
-#include "fvwrite.h"
+#include "../upstream-openbsd/lib/libc/stdio/fvwrite.h"
 
 #define MUL_NO_OVERFLOW	(1UL << (sizeof(size_t) * 4))
 
+/*
+ * Write what's in the buffer followed by `len' bytes from `p', handing both
+ * to writev(2) together. __sfvwrite would copy into the buffer to fill it,
+ * flush it, and then write the rest one buffer's worth at a time. Returns
+ * the number of bytes from `p' that were written. On error, like __sflush,
+ * sets __SERR and keeps whatever was buffered but not written.
+ */
+static size_t
+__swritev(FILE *fp, const char *p, size_t len)
+{
+	unsigned char *pending = fp->_bf._base;
+	size_t pending_len = fp->_p - fp->_bf._base;
+	size_t written = 0;
+
+	while (pending_len > 0 || written < len) {
+		struct iovec iov[2];
+		int iovcnt = 0;
+		if (pending_len > 0) {
+			iov[iovcnt].iov_base = pending;
+			iov[iovcnt++].iov_len = pending_len;
+		}
+		if (written < len) {
+			iov[iovcnt].iov_base = (void *)(p + written);
+			iov[iovcnt++].iov_len = len - written;
+		}
+
+		/* See __swrite. */
+		if (fp->_flags & __SAPP)
+			(void) TEMP_FAILURE_RETRY(lseek64(fp->_file, 0, SEEK_END));
+		ssize_t n = TEMP_FAILURE_RETRY(writev(fp->_file, iov, iovcnt));
+		if (n <= 0) {
+			if (pending != fp->_bf._base)
+				memmove(fp->_bf._base, pending, pending_len);
+			fp->_p = fp->_bf._base + pending_len;
+			fp->_w = (fp->_flags & __SNBF) ? 0 : fp->_bf._size - pending_len;
+			fp->_flags |= __SERR;
+			return (written);
+		}
+
+		size_t from_pending = MIN((size_t) n, pending_len);
+		pending += from_pending;
+		pending_len -= from_pending;
+		written += n - from_pending;
+	}
+
+	fp->_p = fp->_bf._base;
+	fp->_w = (fp->_flags & __SNBF) ? 0 : fp->_bf._size;
+	return (written);
+}
+
 /*
  * Write `count' objects (each size `size') from memory to the given file.
  * Return the number of whole objects written.
@@ -80,6 +134,21 @@ fwrite(const void *buf, size_t size, size_t count, FILE *fp) __overloadable
 	 */
 	FLOCKFILE(fp);
 	_SET_ORIENTATION(fp, -1);
+
+	/*
+	 * Writes of at least a buffer's worth to a file descriptor skip the
+	 * buffer. Line-buffered streams still go through __sfvwrite, which
+	 * knows when to flush for a newline.
+	 */
+	if (fp->_write == __swrite && !cantwrite(fp) &&
+	    (fp->_flags & (__SLBF|__SSTR)) == 0 && n >= (size_t) fp->_bf._size) {
+		size_t written = __swritev(fp, buf, n);
+		FUNLOCKFILE(fp);
+		if (written == n)
+			return (count);
+		return (written / size);
+	}
+
 	ret = __sfvwrite(fp, &uio);
 	FUNLOCKFILE(fp);
 	if (ret == 0)
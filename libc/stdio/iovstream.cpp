@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/uio.h>
+
+#include "local.h"
+
+// An iovstream keeps what's written to it in a list of chunks that are never moved,
+// so growing it never copies what's already there. The FILE's buffer is always the
+// unused tail of the last chunk, so a flush only has to note how much of the tail is
+// now used and point the buffer at what's left: data written through the buffer is
+// copied exactly once, from the caller into the chunk.
+
+#define IOVSTREAM_MIN_CHUNK 4096
+#define IOVSTREAM_MAX_CHUNK (1024 * 1024)
+
+struct iovstream {
+  FILE* fp;
+  // The chunks' used parts. The last one is the one that's being filled.
+  struct iovec* iov;
+  size_t count;
+  size_t capacity;
+  size_t last_chunk_size;
+  size_t total;
+};
+
+static unsigned char* __iovstream_tail(iovstream* st) {
+  struct iovec* last = &st->iov[st->count - 1];
+  return static_cast<unsigned char*>(last->iov_base) + last->iov_len;
+}
+
+static size_t __iovstream_room(iovstream* st) {
+  return st->last_chunk_size - st->iov[st->count - 1].iov_len;
+}
+
+// Starts a new chunk of at least min_size bytes.
+static bool __iovstream_add_chunk(iovstream* st, size_t min_size) {
+  if (st->count == st->capacity) {
+    size_t new_capacity = (st->capacity == 0) ? 8 : st->capacity * 2;
+    void* new_iov = realloc(st->iov, new_capacity * sizeof(struct iovec));
+    if (new_iov == nullptr) return false;
+    st->iov = static_cast<struct iovec*>(new_iov);
+    st->capacity = new_capacity;
+  }
+
+  // Double the chunk size each time, up to a point, so that a large stream doesn't
+  // need a huge number of chunks, but doesn't waste much by rounding up either.
+  size_t size = IOVSTREAM_MIN_CHUNK;
+  if (st->count != 0) size = MIN(st->last_chunk_size * 2, IOVSTREAM_MAX_CHUNK);
+  size = MAX(size, min_size);
+  void* chunk = malloc(size);
+  if (chunk == nullptr) return false;
+
+  st->iov[st->count].iov_base = chunk;
+  st->iov[st->count].iov_len = 0;
+  ++st->count;
+  st->last_chunk_size = size;
+  return true;
+}
+
+static void __iovstream_set_buffer(iovstream* st) {
+  FILE* fp = st->fp;
+  fp->_bf._base = fp->_p = __iovstream_tail(st);
+  fp->_bf._size = __iovstream_room(st);
+  fp->_w = fp->_bf._size;
+}
+
+static int __iovstream_write(void* cookie, const char* buf, int n) {
+  iovstream* st = static_cast<iovstream*>(cookie);
+  FILE* fp = st->fp;
+  unsigned char* tail = __iovstream_tail(st);
+  size_t length = n;
+  size_t room = __iovstream_room(st);
+  // Unless someone called setvbuf, the buffer being flushed is the tail itself, and
+  // the data is already where we want it. fwrite writes big blocks directly, though,
+  // and those have to be copied.
+  bool own_buffer = (fp->_bf._base == tail);
+  bool in_place = own_buffer && (reinterpret_cast<const unsigned char*>(buf) == tail);
+
+  // If this fills the chunk, start the next one first, so that a failure leaves
+  // everything as it was.
+  bool fills_chunk = (length >= room);
+  if (fills_chunk && !__iovstream_add_chunk(st, length - room)) {
+    return -1;
+  }
+  struct iovec* current = &st->iov[st->count - (fills_chunk ? 2 : 1)];
+  size_t first = MIN(length, room);
+  if (!in_place) memcpy(tail, buf, first);
+  current->iov_len += first;
+  if (length > first) {
+    struct iovec* next = &st->iov[st->count - 1];
+    memcpy(next->iov_base, buf + first, length - first);
+    next->iov_len = length - first;
+  }
+  st->total += length;
+
+  if (own_buffer) __iovstream_set_buffer(st);
+  return n;
+}
+
+static int __iovstream_close(void* cookie) {
+  iovstream* st = static_cast<iovstream*>(cookie);
+  for (size_t i = 0; i < st->count; ++i) {
+    free(st->iov[i].iov_base);
+  }
+  free(st->iov);
+  free(st);
+  return 0;
+}
+
+FILE* open_iovstream() {
+  iovstream* st = static_cast<iovstream*>(calloc(1, sizeof(iovstream)));
+  if (st == nullptr) return nullptr;
+  if (!__iovstream_add_chunk(st, 0)) {
+    __iovstream_close(st);
+    return nullptr;
+  }
+
+  FILE* fp = __sfp();
+  if (fp == nullptr) {
+    __iovstream_close(st);
+    return nullptr;
+  }
+  st->fp = fp;
+
+  fp->_flags = __SWR;
+  fp->_file = -1;
+  fp->_cookie = st;
+  fp->_read = nullptr;
+  fp->_write = __iovstream_write;
+  fp->_close = __iovstream_close;
+  __iovstream_set_buffer(st);
+  _SET_ORIENTATION(fp, -1);
+  return fp;
+}
+
+ssize_t iovstream_getiov(FILE* fp, const struct iovec** iov, int* iovcnt) {
+  if (fp->_write != __iovstream_write) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  FLOCKFILE(fp);
+  if (__sflush(fp) != 0) {
+    FUNLOCKFILE(fp);
+    return -1;
+  }
+  iovstream* st = static_cast<iovstream*>(fp->_cookie);
+  // Only the last chunk can be empty.
+  size_t count = st->count;
+  if (st->iov[count - 1].iov_len == 0) --count;
+  *iov = st->iov;
+  *iovcnt = static_cast<int>(count);
+  ssize_t result = st->total;
+  FUNLOCKFILE(fp);
+  return result;
+}
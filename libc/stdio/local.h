@@ -122,6 +122,27 @@ struct __sfileext {
   // Equivalent to `_seek` but for _FILE_OFFSET_BITS=64.
   // Callers should use this but fall back to `__sFILE::_seek`.
   off64_t (*_seek64)(void*, off64_t, int);
+
+  // Adaptive read buffer sizing, see `__srefill`.
+  // The number of refills in a row that filled the whole buffer.
+  int _full_refills;
+  // Whether the buffer has already been grown past `_blksize`.
+  bool _grown_buf;
+  // 1 for a regular file, -1 for anything else, 0 if we haven't looked yet.
+  signed char _regular_file;
+
+  // For streams opened with fopen's "m" mode, the read-only mapping of the
+  // file that `__srefill` serves reads from, and the position in it that
+  // `_seek64` reports. Null for all other streams.
+  unsigned char* _mmap_base;
+  size_t _mmap_size;
+  off64_t _mmap_pos;
+
+  // Links in the list of streams that have been line buffered, see
+  // `__sregister_line_buffered`. These outlive the stream, so unlike the
+  // fields above they aren't reset by `_FILEEXT_INIT` when a FILE is reused.
+  FILE* _lbf_next;
+  bool _lbf_listed;
 };
 
 // Values for `__sFILE::_flags`.
@@ -163,6 +184,12 @@ do { \
 	pthread_mutex_init(&_FLOCK(fp), &attr); \
 	pthread_mutexattr_destroy(&attr); \
 	_EXT(fp)->_caller_handles_locking = false; \
+	_EXT(fp)->_full_refills = 0; \
+	_EXT(fp)->_grown_buf = false; \
+	_EXT(fp)->_regular_file = 0; \
+	_EXT(fp)->_mmap_base = NULL; \
+	_EXT(fp)->_mmap_size = 0; \
+	_EXT(fp)->_mmap_pos = 0; \
 } while (0)
 
 #define _FILEEXT_SETUP(f, fext) \
@@ -197,12 +224,17 @@ __LIBC32_LEGACY_PUBLIC__ int __sclose(void *);
 __LIBC32_LEGACY_PUBLIC__ int _fwalk(int (*)(FILE *));
 
 off64_t __sseek64(void*, off64_t, int);
+void	__sfp_release(FILE *);
+int	__smmap_refill(FILE *);
+void	__sregister_line_buffered(FILE *);
+int	__swalk_line_buffered(int (*)(FILE *));
 int	__sflush_locked(FILE *);
 int	__swhatbuf(FILE *, size_t *, int *);
 wint_t __fgetwc_unlock(FILE *);
 wint_t	__ungetwc(wint_t, FILE *);
 int	__vfprintf(FILE *, const char *, __va_list);
 int	__svfscanf(FILE * __restrict, const char * __restrict, __va_list);
+int	__svsscanf_simple(const char * __restrict, const char * __restrict, __va_list, int *);
 int	__vfwprintf(FILE * __restrict, const wchar_t * __restrict, __va_list);
 int	__vfwscanf(FILE * __restrict, const wchar_t * __restrict, __va_list);
 
@@ -233,8 +265,20 @@ int	__vfwscanf(FILE * __restrict, const wchar_t * __restrict, __va_list);
 	(fp)->_lb._base = NULL; \
 }
 
-#define FLOCKFILE(fp)   if (!_EXT(fp)->_caller_handles_locking) flockfile(fp)
-#define FUNLOCKFILE(fp) if (!_EXT(fp)->_caller_handles_locking) funlockfile(fp)
+/*
+ * Until the first pthread_create sets __isthreaded, no other thread can be
+ * using a FILE, so stdio's own locking is skipped. flockfile(3) itself always
+ * locks, so a thread that's created later still waits for a caller that took
+ * the lock explicitly. A thread created from a funopen() callback in the middle
+ * of a call may see that call's FUNLOCKFILE without its FLOCKFILE, which is a
+ * harmless EPERM from the recursive mutex.
+ */
+extern int __isthreaded;
+
+#define FLOCKFILE(fp) \
+	if (__isthreaded && !_EXT(fp)->_caller_handles_locking) flockfile(fp)
+#define FUNLOCKFILE(fp) \
+	if (__isthreaded && !_EXT(fp)->_caller_handles_locking) funlockfile(fp)
 
 #define FLOATING_POINT
 #define PRINTF_WIDE_CHAR
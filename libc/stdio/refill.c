@@ -32,10 +32,67 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include "local.h"
 
+#if defined(__BIONIC__)
+/*
+ * The default buffer is only st_blksize bytes, so reading a large file
+ * sequentially costs a read(2) every few KiB. Once this many refills in a
+ * row have filled the whole buffer, without a seek in between, the next
+ * refill doubles the buffer, up to READ_BUFSIZE_MAX, and the first time we
+ * ask the kernel to read ahead more.
+ * Small files and random access never get past the first refill or two.
+ */
+#define FULL_REFILLS_BEFORE_GROWING 2
+#define READ_BUFSIZE_MAX (64 * 1024)
+
+static void
+__sgrowbuf(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+
+	ext->_full_refills = 0;
+
+	/*
+	 * Only grow buffers that stdio chose the size of itself: not ones
+	 * passed to setvbuf, or sized explicitly through it.
+	 */
+	if ((fp->_flags & (__SMBF|__SLBF|__SNBF)) != __SMBF)
+		return;
+	if (!ext->_grown_buf && fp->_bf._size != fp->_blksize)
+		return;
+	if (fp->_bf._size >= READ_BUFSIZE_MAX)
+		return;
+
+	/* Pipes and devices don't benefit, and funopen() streams have no fd. */
+	if (ext->_regular_file == 0) {
+		struct stat st;
+		ext->_regular_file = (fp->_read == __sread && fp->_file >= 0 &&
+		    fstat(fp->_file, &st) == 0 && S_ISREG(st.st_mode)) ? 1 : -1;
+		if (ext->_regular_file == 1)
+			(void) posix_fadvise(fp->_file, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+	if (ext->_regular_file != 1)
+		return;
+
+	size_t new_size = fp->_bf._size * 2;
+	if (new_size > READ_BUFSIZE_MAX)
+		new_size = READ_BUFSIZE_MAX;
+	/* The buffer is empty, so there's nothing worth having realloc copy. */
+	unsigned char *p = malloc(new_size);
+	if (p == NULL)
+		return;
+	free(fp->_bf._base);
+	fp->_bf._base = p;
+	fp->_bf._size = new_size;
+	ext->_grown_buf = true;
+}
+#endif
+
 static int
 lflush(FILE *fp)
 {
@@ -100,18 +157,35 @@ __srefill(FILE *fp)
 	 * standard.
 	 */
 	if (fp->_flags & (__SLBF|__SNBF)) {
-		/* Ignore this file in _fwalk to avoid potential deadlock. */
+		/*
+		 * Only streams that have been line buffered can need this,
+		 * so don't walk every open FILE. Ignore this file in the
+		 * walk to avoid potential deadlock.
+		 */
 		fp->_flags |= __SIGN;
-		(void) _fwalk(lflush);
+		(void) __swalk_line_buffered(lflush);
 		fp->_flags &= ~__SIGN;
 
 		/* Now flush this file without locking it. */
 		if ((fp->_flags & (__SLBF|__SWR)) == (__SLBF|__SWR))
 			__sflush(fp);
 	}
+#if defined(__BIONIC__)
+	/* The whole of a mapped file is already in the buffer. */
+	if (_EXT(fp)->_mmap_base != NULL)
+		return (__smmap_refill(fp));
+	if (_EXT(fp)->_full_refills >= FULL_REFILLS_BEFORE_GROWING)
+		__sgrowbuf(fp);
+#endif
 	fp->_p = fp->_bf._base;
 	fp->_r = (*fp->_read)(fp->_cookie, (char *)fp->_p, fp->_bf._size);
 	fp->_flags &= ~__SMOD;	/* buffer contents are again pristine */
+#if defined(__BIONIC__)
+	if (fp->_r > 0 && (size_t) fp->_r == (size_t) fp->_bf._size)
+		_EXT(fp)->_full_refills++;
+	else
+		_EXT(fp)->_full_refills = 0;
+#endif
 	if (fp->_r <= 0) {
 		if (fp->_r == 0)
 			fp->_flags |= __SEOF;
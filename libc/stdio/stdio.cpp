@@ -38,15 +38,20 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <paths.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/param.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include "local.h"
 #include "glue.h"
+#include "../upstream-openbsd/lib/libc/stdio/fvwrite.h"
 #include "private/bionic_fortify.h"
+#include "private/bionic_percpu.h"
+#include "private/bionic_stats.h"
 #include "private/ErrnoRestorer.h"
 #include "private/thread_private.h"
 
@@ -126,38 +131,46 @@ static glue* moreglue(int n) {
   while (--n >= 0) {
     *p = empty;
     _FILEEXT_SETUP(p, pext);
+    pext->_lbf_next = nullptr;
+    pext->_lbf_listed = false;
     p++;
     pext++;
   }
   return g;
 }
 
+// The FILEs that are free for reuse. Every FILE with _flags == 0 is on this list,
+// apart from the ones __sfp is in the middle of handing out, so that opening a stream
+// doesn't have to scan the glue or take a global lock. __sfp_mutex is only needed
+// while adding more glue. freopen of a closed FILE takes it back off the list.
+static PerCpuFreeList __sfp_free_list;
+
+void __sfp_release(FILE* fp) {
+  fp->_flags = 0;
+  __sfp_free_list.push(fp);
+}
+
 /*
  * Find a free FILE for fopen et al.
  */
 FILE* __sfp(void) {
 	FILE *fp;
-	int n;
 	struct glue *g;
 
-	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
-	for (g = &__sglue; g != NULL; g = g->next) {
-		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
-			if (fp->_flags == 0)
-				goto found;
+	fp = reinterpret_cast<FILE*>(__sfp_free_list.pop());
+	if (fp == NULL) {
+		if ((g = moreglue(NDYNAMIC)) == NULL)
+			return (NULL);
+		_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+		lastglue->next = g;
+		lastglue = g;
+		_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+		/* keep the first one, and let everyone else have the rest */
+		fp = g->iobs;
+		for (int i = 1; i < g->niobs; i++)
+			__sfp_free_list.push(&g->iobs[i]);
 	}
-
-	/* release lock while mallocing */
-	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
-	if ((g = moreglue(NDYNAMIC)) == NULL)
-		return (NULL);
-	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
-	lastglue->next = g;
-	lastglue = g;
-	fp = g->iobs;
-found:
 	fp->_flags = 1;		/* reserve this slot; caller sets real flags */
-	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 	fp->_p = NULL;		/* no current pointer */
 	fp->_w = 0;		/* nothing to read or write */
 	fp->_r = 0;
@@ -178,6 +191,36 @@ found:
 	return fp;
 }
 
+// The streams that have ever been line buffered, which are the only ones whose
+// output __srefill has to flush before reading from a line-buffered or
+// unbuffered stream. A FILE is added the first time it becomes line buffered
+// and stays listed when it's closed and reused, since FILEs are never freed, so
+// walkers check each stream's current flags. The list is only ever pushed onto,
+// under __slbf_mutex, so walking it doesn't need the lock.
+static _Atomic(FILE*) __slbf_head;
+_THREAD_PRIVATE_MUTEX(__slbf_mutex);
+
+void __sregister_line_buffered(FILE* fp) {
+  _THREAD_PRIVATE_MUTEX_LOCK(__slbf_mutex);
+  struct __sfileext* ext = _EXT(fp);
+  if (!ext->_lbf_listed) {
+    ext->_lbf_listed = true;
+    ext->_lbf_next = atomic_load_explicit(&__slbf_head, memory_order_relaxed);
+    atomic_store_explicit(&__slbf_head, fp, memory_order_release);
+  }
+  _THREAD_PRIVATE_MUTEX_UNLOCK(__slbf_mutex);
+}
+
+// Like _fwalk, but only for the streams that have been line buffered.
+int __swalk_line_buffered(int (*function)(FILE*)) {
+  int ret = 0;
+  for (FILE* fp = atomic_load_explicit(&__slbf_head, memory_order_acquire); fp != nullptr;
+       fp = _EXT(fp)->_lbf_next) {
+    if ((fp->_flags != 0) && ((fp->_flags & __SIGN) == 0)) ret |= (*function)(fp);
+  }
+  return ret;
+}
+
 extern "C" __LIBC_HIDDEN__ void __libc_stdio_cleanup(void) {
   // Equivalent to fflush(nullptr), but without all the locking since we're shutting down anyway.
   _fwalk(__sflush);
@@ -204,6 +247,110 @@ static FILE* __fopen(int fd, int flags) {
   return fp;
 }
 
+static int __smmap_read(void* cookie, char* buf, int n) {
+  FILE* fp = reinterpret_cast<FILE*>(cookie);
+  struct __sfileext* ext = _EXT(fp);
+  if (ext->_mmap_pos >= static_cast<off64_t>(ext->_mmap_size)) return 0;
+  size_t count = MIN(ext->_mmap_size - static_cast<size_t>(ext->_mmap_pos), static_cast<size_t>(n));
+  memcpy(buf, ext->_mmap_base + ext->_mmap_pos, count);
+  ext->_mmap_pos += count;
+  return count;
+}
+
+static off64_t __smmap_seek64(void* cookie, off64_t offset, int whence) {
+  FILE* fp = reinterpret_cast<FILE*>(cookie);
+  struct __sfileext* ext = _EXT(fp);
+  off64_t base;
+  if (whence == SEEK_SET) {
+    base = 0;
+  } else if (whence == SEEK_CUR) {
+    base = ext->_mmap_pos;
+  } else if (whence == SEEK_END) {
+    base = ext->_mmap_size;
+  } else {
+    errno = EINVAL;
+    return -1;
+  }
+  // Like lseek, allow seeking past the end but not before the start.
+  off64_t result;
+  if (__builtin_add_overflow(base, offset, &result) || result < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  ext->_mmap_pos = result;
+  return result;
+}
+
+// The file's mapping serves as the stream's buffer, so one refill makes all of
+// the rest of the file readable without any reads or copies. `_mmap_pos` is
+// the offset just past the buffered data, as the fd's offset is for a stream
+// using read(2), so ftell and fseek work unchanged.
+int __smmap_refill(FILE* fp) {
+  struct __sfileext* ext = _EXT(fp);
+
+  // setvbuf may have swapped in a buffer of its own, which we don't need.
+  if (fp->_flags & __SMBF) {
+    free(fp->_bf._base);
+    fp->_flags &= ~__SMBF;
+  }
+  fp->_bf._base = ext->_mmap_base;
+  fp->_bf._size = ext->_mmap_size;
+  fp->_flags &= ~__SMOD;
+
+  if (ext->_mmap_pos >= static_cast<off64_t>(ext->_mmap_size)) {
+    fp->_p = fp->_bf._base;
+    fp->_r = 0;
+    fp->_flags |= __SEOF;
+    return EOF;
+  }
+  fp->_p = ext->_mmap_base + ext->_mmap_pos;
+  fp->_r = ext->_mmap_size - ext->_mmap_pos;
+  ext->_mmap_pos = ext->_mmap_size;
+  return 0;
+}
+
+// Implements the "m" mode flag: a stream that's only for reading a regular file
+// reads from a mapping of the file rather than with read(2). Anything else, or a
+// failure to map the file, leaves an ordinary stream. The mapping is made once,
+// so the stream doesn't see the file grow, and the fd's offset doesn't move as
+// the stream is read. As with any mapping, truncating the file while it's being
+// read causes SIGBUS.
+static void __smmap_open(FILE* fp, const char* mode) {
+  if (strchr(mode, 'm') == nullptr || (fp->_flags & (__SRD|__SWR|__SRW)) != __SRD) return;
+
+  struct stat st;
+  if (fstat(fp->_file, &st) == -1 || !S_ISREG(st.st_mode)) return;
+  // The buffer size and read count are ints, and an empty file can't be mapped.
+  if (st.st_size <= 0 || st.st_size > INT_MAX) return;
+
+  void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fp->_file, 0);
+  if (map == MAP_FAILED) return;
+
+  struct __sfileext* ext = _EXT(fp);
+  ext->_mmap_base = reinterpret_cast<unsigned char*>(map);
+  ext->_mmap_size = st.st_size;
+  ext->_mmap_pos = 0;
+  fp->_bf._base = fp->_p = ext->_mmap_base;
+  fp->_bf._size = ext->_mmap_size;
+  // Anything that bypasses the buffer still reads from the mapping.
+  fp->_read = __smmap_read;
+  _EXT(fp)->_seek64 = __smmap_seek64;
+}
+
+static void __smmap_close(FILE* fp) {
+  struct __sfileext* ext = _EXT(fp);
+  if (ext->_mmap_base != nullptr) {
+    munmap(ext->_mmap_base, ext->_mmap_size);
+    if (fp->_bf._base == ext->_mmap_base) {
+      fp->_bf._base = nullptr;
+      fp->_bf._size = 0;
+    }
+    ext->_mmap_base = nullptr;
+    ext->_mmap_size = 0;
+    ext->_mmap_pos = 0;
+  }
+}
+
 FILE* fopen(const char* file, const char* mode) {
   int oflags;
   int flags = __sflags(mode, &oflags);
@@ -230,6 +377,7 @@ FILE* fopen(const char* file, const char* mode) {
   // TODO: check in __sseek instead.
   if (oflags & O_APPEND) __sseek64(fp, 0, SEEK_END);
 
+  __smmap_open(fp, mode);
   return fp;
 }
 __strong_alias(fopen64, fopen);
@@ -284,6 +432,13 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
   // should work.  This is unnecessary if it was not a Unix file.
   int isopen, wantfd;
   if (fp->_flags == 0) {
+    // Take it back from the free list before anyone else can. If it isn't
+    // there, __sfp has just handed it out to another opener, so it isn't ours
+    // to reuse any more.
+    if (!__sfp_free_list.remove(fp)) {
+      errno = EBADF;
+      return nullptr;
+    }
     fp->_flags = __SEOF; // Hold on to it.
     isopen = 0;
     wantfd = -1;
@@ -317,6 +472,7 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
   // of any setbuffer calls, but stdio has always done this before.
   if (isopen && fd != wantfd) (*fp->_close)(fp->_cookie);
   if (fp->_flags & __SMBF) free(fp->_bf._base);
+  __smmap_close(fp);
   fp->_w = 0;
   fp->_r = 0;
   fp->_p = NULL;
@@ -328,9 +484,12 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
   WCIO_FREE(fp);
   if (HASLB(fp)) FREELB(fp);
   fp->_lb._size = 0;
+  _EXT(fp)->_full_refills = 0;
+  _EXT(fp)->_grown_buf = false;
+  _EXT(fp)->_regular_file = 0;
 
   if (fd < 0) { // Did not get it after all.
-    fp->_flags = 0; // Release.
+    __sfp_release(fp);
     errno = sverrno; // Restore errno in case _close clobbered it.
     return nullptr;
   }
@@ -347,7 +506,7 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
 
   // _file is only a short.
   if (fd > SHRT_MAX) {
-      fp->_flags = 0; // Release.
+      __sfp_release(fp);
       errno = EMFILE;
       return nullptr;
   }
@@ -367,6 +526,8 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
   // we can do about this.  (We could set __SAPP and check in
   // fseek and ftell.)
   if (oflags & O_APPEND) __sseek64(fp, 0, SEEK_END);
+
+  __smmap_open(fp, mode);
   return fp;
 }
 __strong_alias(freopen64, freopen);
@@ -378,22 +539,27 @@ int fclose(FILE* fp) {
     return EOF;
   }
 
-  ScopedFileLock sfl(fp);
-  WCIO_FREE(fp);
-  int r = fp->_flags & __SWR ? __sflush(fp) : 0;
-  if (fp->_close != NULL && (*fp->_close)(fp->_cookie) < 0) {
-    r = EOF;
+  int r;
+  {
+    ScopedFileLock sfl(fp);
+    WCIO_FREE(fp);
+    r = fp->_flags & __SWR ? __sflush(fp) : 0;
+    if (fp->_close != NULL && (*fp->_close)(fp->_cookie) < 0) {
+      r = EOF;
+    }
+    if (fp->_flags & __SMBF) free(fp->_bf._base);
+    __smmap_close(fp);
+    if (HASUB(fp)) FREEUB(fp);
+    if (HASLB(fp)) FREELB(fp);
+
+    // Poison this FILE so accesses after fclose will be obvious.
+    fp->_file = -1;
+    fp->_r = fp->_w = 0;
   }
-  if (fp->_flags & __SMBF) free(fp->_bf._base);
-  if (HASUB(fp)) FREEUB(fp);
-  if (HASLB(fp)) FREELB(fp);
 
-  // Poison this FILE so accesses after fclose will be obvious.
-  fp->_file = -1;
-  fp->_r = fp->_w = 0;
-
-  // Release this FILE for reuse.
-  fp->_flags = 0;
+  // Release this FILE for reuse. That has to wait until it's unlocked, because
+  // __sfp reinitializes the lock of the FILEs it hands out.
+  __sfp_release(fp);
   return r;
 }
 
@@ -445,6 +611,7 @@ int __sread(void* cookie, char* buf, int n) {
 
 int __swrite(void* cookie, const char* buf, int n) {
   FILE* fp = reinterpret_cast<FILE*>(cookie);
+  __libc_stats_add(LIBC_STAT_STDIO_FLUSHES, 1);
   if (fp->_flags & __SAPP) {
     // The FILE* is in append mode, but the underlying fd doesn't have O_APPEND set.
     // We need to seek manually.
@@ -545,6 +712,8 @@ int __fseeko64(FILE* fp, off64_t offset, int whence, int off_t_bits) {
   fp->_r = 0;
   /* fp->_w = 0; */	/* unnecessary (I think...) */
   fp->_flags &= ~__SEOF;
+  // Any read after a seek starts a new sequential run, see __srefill.
+  _EXT(fp)->_full_refills = 0;
   return 0;
 }
 
@@ -665,10 +834,180 @@ int fgetc(FILE* fp) {
   return getc(fp);
 }
 
+// The wide character functions below special-case ASCII, which in UTF-8 (the
+// only multibyte encoding bionic supports) is a byte per character and never
+// changes the conversion state, so it can be copied without calling
+// mbrtowc/wcrtomb for every character.
+
+wint_t __fgetwc_unlock(FILE* fp) {
+  _SET_ORIENTATION(fp, 1);
+  wchar_io_data* wcio = WCIO_GET(fp);
+  if (wcio == nullptr) {
+    errno = ENOMEM;
+    return WEOF;
+  }
+
+  // If there are ungetwc'ed characters, use them.
+  if (wcio->wcio_ungetwc_inbuf) {
+    return wcio->wcio_ungetwc_buf[--wcio->wcio_ungetwc_inbuf];
+  }
+
+  mbstate_t* st = &wcio->wcio_mbstate_in;
+  if (fp->_r > 0 && *fp->_p < 0x80 && mbsinit(st)) {
+    fp->_r--;
+    return *fp->_p++;
+  }
+
+  wchar_t wc;
+  size_t size;
+  do {
+    int ch = __sgetc(fp);
+    if (ch == EOF) return WEOF;
+    char c = ch;
+    size = mbrtowc(&wc, &c, 1, st);
+    if (size == static_cast<size_t>(-1)) {
+      fp->_flags |= __SERR;
+      return WEOF;
+    }
+  } while (size == static_cast<size_t>(-2));
+  return wc;
+}
+
+wint_t fgetwc(FILE* fp) {
+  ScopedFileLock sfl(fp);
+  return __fgetwc_unlock(fp);
+}
+
+wchar_t* fgetws(wchar_t* ws, int n, FILE* fp) {
+  ScopedFileLock sfl(fp);
+  _SET_ORIENTATION(fp, 1);
+
+  if (n <= 0) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  wchar_t* wsp = ws;
+  wchar_t* end = ws + n - 1;
+  if (wsp == end) {
+    *wsp = L'\0';
+    return ws;
+  }
+
+  wchar_io_data* wcio = WCIO_GET(fp);
+  if (wcio == nullptr) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  if (wcio->wcio_ungetwc_inbuf) {
+    *wsp = wcio->wcio_ungetwc_buf[--wcio->wcio_ungetwc_inbuf];
+    if (*wsp++ == L'\n') end = wsp;
+  }
+
+  // Decode straight out of the buffer, a buffer's worth at a time.
+  mbstate_t* st = &wcio->wcio_mbstate_in;
+  bool newline = false;
+  while (wsp < end && !newline) {
+    if (fp->_r <= 0 && __srefill(fp)) {
+      // EOF or a read error: return what we have, if anything.
+      if (wsp == ws) return nullptr;
+      break;
+    }
+
+    unsigned char* p = fp->_p;
+    unsigned char* limit = p + fp->_r;
+    while (p < limit && wsp < end && !newline) {
+      if (*p < 0x80 && mbsinit(st)) {
+        size_t max = MIN(static_cast<size_t>(limit - p), static_cast<size_t>(end - wsp));
+        size_t i = 0;
+        while (i < max && p[i] < 0x80) {
+          wsp[i] = p[i];
+          if (p[i++] == '\n') {
+            newline = true;
+            break;
+          }
+        }
+        p += i;
+        wsp += i;
+        continue;
+      }
+
+      wchar_t wc;
+      size_t size = mbrtowc(&wc, reinterpret_cast<char*>(p), limit - p, st);
+      if (size == static_cast<size_t>(-2)) {
+        // The rest of the buffer is the start of a character; st remembers it.
+        p = limit;
+        break;
+      }
+      if (size == static_cast<size_t>(-1)) {
+        // As fgetwc would, skip the offending byte and report EILSEQ.
+        fp->_r -= p + 1 - fp->_p;
+        fp->_p = p + 1;
+        fp->_flags |= __SERR;
+        memset(st, 0, sizeof(*st));
+        return nullptr;
+      }
+      p += (size == 0) ? 1 : size;
+      *wsp++ = wc;
+      newline = (wc == L'\n');
+    }
+    fp->_r -= p - fp->_p;
+    fp->_p = p;
+  }
+  *wsp = L'\0';
+  return ws;
+}
+
 int fputc(int c, FILE* fp) {
   return putc(c, fp);
 }
 
+static int __sfvwrite_bytes(FILE* fp, char* buf, size_t len) {
+  __siov iov = { buf, len };
+  __suio uio = { &iov, 1, static_cast<int>(len) };
+  return __sfvwrite(fp, &uio);
+}
+
+int fputws(const wchar_t* ws, FILE* fp) {
+  ScopedFileLock sfl(fp);
+  _SET_ORIENTATION(fp, 1);
+  if (*ws == L'\0') return 0;
+
+  wchar_io_data* wcio = WCIO_GET(fp);
+  if (wcio == nullptr) {
+    errno = ENOMEM;
+    return -1;
+  }
+  wcio->wcio_ungetwc_inbuf = 0;
+  mbstate_t* st = &wcio->wcio_mbstate_out;
+
+  // Encode into a local buffer and hand that to __sfvwrite a chunk at a time,
+  // rather than making a call per character.
+  char buf[512];
+  while (*ws != L'\0') {
+    size_t len = 0;
+    bool initial = mbsinit(st);
+    while (*ws != L'\0' && len <= sizeof(buf) - MB_LEN_MAX) {
+      if (static_cast<uint32_t>(*ws) < 0x80 && initial) {
+        buf[len++] = *ws++;
+        continue;
+      }
+      size_t size = wcrtomb(buf + len, *ws, st);
+      if (size == static_cast<size_t>(-1)) {
+        // Like fputwc in a loop, write what came before the bad character.
+        if (len > 0) __sfvwrite_bytes(fp, buf, len);
+        errno = EILSEQ;
+        return -1;
+      }
+      len += size;
+      ws++;
+      initial = mbsinit(st);
+    }
+    if (__sfvwrite_bytes(fp, buf, len)) return -1;
+  }
+  return 0;
+}
+
 int fscanf(FILE* fp, const char* fmt, ...) {
   PRINTF_IMPL(vfscanf(fp, fmt, ap));
 }
@@ -702,6 +1041,37 @@ ssize_t getline(char** buf, size_t* len, FILE* fp) {
   return getdelim(buf, len, '\n', fp);
 }
 
+ssize_t getdelim_view(const char** line, char** buf, size_t* buf_size, int delim, FILE* fp) {
+  if (line == nullptr || buf == nullptr || buf_size == nullptr) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  ScopedFileLock sfl(fp);
+  _SET_ORIENTATION(fp, -1);
+  if (fp->_r <= 0 && __srefill(fp)) {
+    return -1;
+  }
+
+  // Unlike fgetln, we don't set __SMOD here: the caller can't modify the line, so
+  // fseek can still reuse the buffer.
+  unsigned char* end = static_cast<unsigned char*>(memchr(fp->_p, delim, fp->_r));
+  if (end != nullptr) {
+    size_t length = end + 1 - fp->_p;
+    *line = reinterpret_cast<const char*>(fp->_p);
+    fp->_p += length;
+    fp->_r -= length;
+    return length;
+  }
+
+  // The line continues past what's buffered, so it has to be copied out.
+  ssize_t result = getdelim(buf, buf_size, delim, fp);
+  if (result != -1) {
+    *line = *buf;
+  }
+  return result;
+}
+
 wint_t getwc(FILE* fp) {
   return fgetwc(fp);
 }
@@ -803,6 +1173,144 @@ int vscanf(const char* fmt, va_list ap) {
   return vfscanf(stdin, fmt, ap);
 }
 
+// Where vsnprintf's fast path writes to. Output past the end of the buffer is
+// counted but dropped, so that the return value is the untruncated length.
+struct SnprintfBuffer {
+  char* p;
+  size_t room;  // Not counting the NUL.
+  size_t total;
+
+  void append(const char* s, size_t length) {
+    total += length;
+    size_t n = MIN(length, room);
+    memcpy(p, s, n);
+    p += n;
+    room -= n;
+  }
+};
+
+template <typename U>
+static char* __format_unsigned(char* end, U value, int base) {
+  if (base == 16) {
+    do {
+      *--end = "0123456789abcdef"[value & 15];
+      value >>= 4;
+    } while (value != 0);
+  } else {
+    do {
+      *--end = '0' + (value % 10);
+      value /= 10;
+    } while (value != 0);
+  }
+  return end;
+}
+
+// Formats a %d, %i, %u or %x argument of type S (or the unsigned U), formatted
+// the way __vfprintf would with no flags, width or precision.
+template <typename S, typename U>
+static char* __format_integer(char* end, va_list* args, char conversion) {
+  if (conversion == 'd' || conversion == 'i') {
+    S value = va_arg(*args, S);
+    U magnitude = (value < 0) ? -static_cast<U>(value) : static_cast<U>(value);
+    end = __format_unsigned(end, magnitude, 10);
+    if (value < 0) *--end = '-';
+    return end;
+  }
+  return __format_unsigned(end, va_arg(*args, U), (conversion == 'x') ? 16 : 10);
+}
+
+// Most snprintf calls only use literal text and a few simple conversions, for
+// which setting up a fake FILE and going through __vfprintf costs far more than
+// the formatting itself. This handles %d, %i, %u, %x, %c, %s, %p and %%, with
+// no flags, width or precision and at most an l, ll or z length modifier,
+// writing straight into the caller's buffer. It returns false as soon as it
+// sees anything else, and works on a copy of `ap`, so that the caller can start
+// again with __vfprintf.
+static bool __vsnprintf_fast(char* s, size_t n, const char* fmt, va_list ap, int* result) {
+  SnprintfBuffer out = { s, n - 1, 0 };
+  va_list args;
+  va_copy(args, ap);
+
+  bool handled = true;
+  while (handled) {
+    const char* percent = strchr(fmt, '%');
+    if (percent == nullptr) {
+      out.append(fmt, strlen(fmt));
+      break;
+    }
+    out.append(fmt, percent - fmt);
+    fmt = percent + 1;
+
+    char modifier = '\0';
+    if (*fmt == 'z') {
+      modifier = *fmt++;
+    } else if (*fmt == 'l') {
+      modifier = *fmt++;
+      if (*fmt == 'l') {
+        modifier = 'q';
+        ++fmt;
+      }
+    }
+
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    char* cp = end;
+    char conversion = *fmt++;
+    switch (conversion) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+        if (modifier == '\0') {
+          cp = __format_integer<int, unsigned int>(end, &args, conversion);
+        } else if (modifier == 'l') {
+          cp = __format_integer<long, unsigned long>(end, &args, conversion);
+        } else if (modifier == 'q') {
+          cp = __format_integer<long long, unsigned long long>(end, &args, conversion);
+        } else {
+          cp = __format_integer<ssize_t, size_t>(end, &args, conversion);
+        }
+        out.append(cp, end - cp);
+        break;
+      case 'c':
+        digits[0] = static_cast<char>(va_arg(args, int));
+        out.append(digits, 1);
+        handled = (modifier == '\0');
+        break;
+      case 's':
+        if (modifier == '\0') {
+          const char* str = va_arg(args, const char*);
+          if (str == nullptr) str = "(null)";
+          out.append(str, strlen(str));
+        } else {
+          handled = false;
+        }
+        break;
+      case 'p':
+        cp = __format_unsigned(end, reinterpret_cast<uintptr_t>(va_arg(args, void*)), 16);
+        *--cp = 'x';
+        *--cp = '0';
+        out.append(cp, end - cp);
+        handled = (modifier == '\0');
+        break;
+      case '%':
+        out.append("%", 1);
+        handled = (modifier == '\0');
+        break;
+      default:
+        handled = false;
+        break;
+    }
+  }
+  va_end(args);
+
+  // __vfprintf fails with EOVERFLOW here, so let it.
+  if (!handled || out.total > INT_MAX) return false;
+  *out.p = '\0';
+  *result = out.total;
+  return true;
+}
+
 int vsnprintf(char* s, size_t n, const char* fmt, va_list ap) {
   // stdio internals use int rather than size_t.
   static_assert(INT_MAX <= SSIZE_MAX, "SSIZE_MAX too large to fit in int");
@@ -816,6 +1324,9 @@ int vsnprintf(char* s, size_t n, const char* fmt, va_list ap) {
     n = 1;
   }
 
+  int result;
+  if (__vsnprintf_fast(s, n, fmt, ap, &result)) return result;
+
   FILE f;
   __sfileext fext;
   _FILEEXT_SETUP(&f, &fext);
@@ -824,7 +1335,7 @@ int vsnprintf(char* s, size_t n, const char* fmt, va_list ap) {
   f._bf._base = f._p = reinterpret_cast<unsigned char*>(s);
   f._bf._size = f._w = n - 1;
 
-  int result = __vfprintf(&f, fmt, ap);
+  result = __vfprintf(&f, fmt, ap);
   *f._p = '\0';
   return result;
 }
@@ -833,6 +1344,25 @@ int vsprintf(char* s, const char* fmt, va_list ap) {
   return vsnprintf(s, SSIZE_MAX, fmt, ap);
 }
 
+static int eofread(void*, char*, int) {
+  return 0;
+}
+
+int vsscanf(const char* s, const char* fmt, va_list ap) {
+  int result;
+  if (__svsscanf_simple(s, fmt, ap, &result)) return result;
+
+  FILE f;
+  __sfileext fext;
+  _FILEEXT_SETUP(&f, &fext);
+  f._flags = __SRD;
+  f._bf._base = f._p = reinterpret_cast<unsigned char*>(const_cast<char*>(s));
+  f._bf._size = f._r = strlen(s);
+  f._read = eofread;
+  f._lb._base = nullptr;
+  return __svfscanf(&f, fmt, ap);
+}
+
 int vwprintf(const wchar_t* fmt, va_list ap) {
   return vfwprintf(stdout, fmt, ap);
 }
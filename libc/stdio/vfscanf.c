@@ -32,6 +32,7 @@
  */
 
 #include <ctype.h>
+#include <errno.h>
 #include <wctype.h>
 #include <inttypes.h>
 #include <stdarg.h>
@@ -790,6 +791,419 @@ match_failure:
 	return (nassigned);
 }
 
+/*
+ * Return 1 if every conversion in the format is one __svsscanf_simple
+ * handles: the integer conversions, %n, and byte (not wide) %c, %s and %[.
+ */
+static int
+__sscanf_simple_format(const u_char *fmt)
+{
+	char ccltab[256];
+	int c, wide;
+
+	while ((c = *fmt++) != 0) {
+		if (c != '%')
+			continue;
+		wide = 0;
+		for (;;) {
+			c = *fmt++;
+			if (c == 'l') {
+				if (*fmt == 'l')
+					fmt++;
+				else
+					wide = 1;
+				continue;
+			}
+			switch (c) {
+			case '*': case 'h': case 'j': case 'q': case 't': case 'z':
+			case '0': case '1': case '2': case '3': case '4':
+			case '5': case '6': case '7': case '8': case '9':
+				continue;
+			}
+			break;
+		}
+		switch (c) {
+		case '%':
+		case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+		case 'n':
+			break;
+		case 'c': case 's':
+			if (wide)
+				return (0);
+			break;
+		case '[':
+			if (wide)
+				return (0);
+			fmt = __sccl(ccltab, (u_char *)fmt);
+			break;
+		default:
+			return (0);
+		}
+	}
+	return (1);
+}
+
+/*
+ * sscanf without the FILE: the same as __svfscanf on a string stream, but
+ * reading the string directly.  Returns 0, without touching ap, if the
+ * format has conversions this doesn't handle (see above); otherwise sets
+ * *result to what __svfscanf would have returned and returns 1.
+ */
+int
+__svsscanf_simple(const char *str, const char *fmt0, __va_list ap, int *result)
+{
+	const u_char *s = (const u_char *)str;
+	u_char *fmt = (u_char *)fmt0;
+	int c;		/* character from format, or conversion */
+	size_t width;	/* field width, or 0 */
+	char *p;	/* points into all kinds of strings */
+	size_t n;	/* handy count */
+	int flags;	/* flags as defined above */
+	int nassigned;		/* number of fields assigned */
+	int base;		/* base argument to strtoimax/strtouimax */
+	uintmax_t res;		/* integer conversion result */
+	char ccltab[256];	/* character class table for %[...] */
+	char buf[BUF];		/* buffer for numeric conversions */
+
+	static short basefix[17] =
+		{ 10, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+	if (!__sscanf_simple_format(fmt))
+		return (0);
+
+	nassigned = 0;
+	base = 0;
+	for (;;) {
+		c = *fmt++;
+		if (c == 0)
+			break;
+		if (isspace(c)) {
+			while (isspace(*s))
+				s++;
+			continue;
+		}
+		if (c != '%')
+			goto literal;
+		width = 0;
+		flags = 0;
+again:		c = *fmt++;
+		switch (c) {
+		case '%':
+literal:
+			if (*s == '\0')
+				goto input_failure;
+			if (*s != c)
+				goto match_failure;
+			s++;
+			continue;
+
+		case '*':
+			flags |= SUPPRESS;
+			goto again;
+		case 'j':
+			flags |= MAXINT;
+			goto again;
+		case 'h':
+			if (*fmt == 'h') {
+				fmt++;
+				flags |= SHORTSHORT;
+			} else {
+				flags |= SHORT;
+			}
+			goto again;
+		case 'l':
+			if (*fmt == 'l') {
+				fmt++;
+				flags |= LLONG;
+			} else {
+				flags |= LONG;
+			}
+			goto again;
+		case 'q':
+			flags |= LLONG;
+			goto again;
+		case 't':
+			flags |= PTRINT;
+			goto again;
+		case 'z':
+			flags |= SIZEINT;
+			goto again;
+
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			width = width * 10 + c - '0';
+			goto again;
+
+		case 'd':
+			c = CT_INT;
+			base = 10;
+			break;
+
+		case 'i':
+			c = CT_INT;
+			base = 0;
+			break;
+
+		case 'o':
+			c = CT_INT;
+			flags |= UNSIGNED;
+			base = 8;
+			break;
+
+		case 'u':
+			c = CT_INT;
+			flags |= UNSIGNED;
+			base = 10;
+			break;
+
+		case 'X':
+		case 'x':
+			flags |= PFXOK;
+			c = CT_INT;
+			flags |= UNSIGNED;
+			base = 16;
+			break;
+
+		case 's':
+			c = CT_STRING;
+			break;
+
+		case '[':
+			fmt = __sccl(ccltab, fmt);
+			flags |= NOSKIP;
+			c = CT_CCL;
+			break;
+
+		case 'c':
+			flags |= NOSKIP;
+			c = CT_CHAR;
+			break;
+
+		case 'n':
+			if (flags & SUPPRESS)
+				continue;
+			n = s - (const u_char *)str;
+			if (flags & SHORTSHORT)
+				*va_arg(ap, signed char *) = n;
+			else if (flags & SHORT)
+				*va_arg(ap, short *) = n;
+			else if (flags & LONG)
+				*va_arg(ap, long *) = n;
+			else if (flags & SIZEINT)
+				*va_arg(ap, ssize_t *) = n;
+			else if (flags & PTRINT)
+				*va_arg(ap, ptrdiff_t *) = n;
+			else if (flags & LLONG)
+				*va_arg(ap, long long *) = n;
+			else if (flags & MAXINT)
+				*va_arg(ap, intmax_t *) = n;
+			else
+				*va_arg(ap, int *) = n;
+			continue;
+		}
+
+		if (*s == '\0')
+			goto input_failure;
+		if ((flags & NOSKIP) == 0) {
+			while (isspace(*s))
+				s++;
+			if (*s == '\0')
+				goto input_failure;
+		}
+
+		switch (c) {
+		case CT_CHAR:
+			if (width == 0)
+				width = 1;
+			n = strnlen((const char *)s, width);
+			if ((flags & SUPPRESS) == 0) {
+				memcpy(va_arg(ap, char *), s, n);
+				nassigned++;
+			}
+			s += n;
+			break;
+
+		case CT_CCL:
+			if (width == 0)
+				width = (size_t)~0;
+			p = (flags & SUPPRESS) ? NULL : va_arg(ap, char *);
+			for (n = 0; n < width && s[n] != '\0' && ccltab[s[n]]; n++)
+				continue;
+			if (n == 0)
+				goto match_failure;
+			if (p != NULL) {
+				memcpy(p, s, n);
+				p[n] = '\0';
+				nassigned++;
+			}
+			s += n;
+			break;
+
+		case CT_STRING:
+			if (width == 0)
+				width = (size_t)~0;
+			p = (flags & SUPPRESS) ? NULL : va_arg(ap, char *);
+			for (n = 0; n < width && s[n] != '\0' && !isspace(s[n]); n++)
+				continue;
+			if (p != NULL) {
+				memcpy(p, s, n);
+				p[n] = '\0';
+				nassigned++;
+			}
+			s += n;
+			break;
+
+		case CT_INT:
+			if (base == 10) {
+				/*
+				 * Just [sign] digits: convert them here rather
+				 * than copying them for strtoimax/strtoumax,
+				 * with the same result on overflow.
+				 */
+				const u_char *t = s;
+				uintmax_t limit;
+				int neg = 0, overflow = 0;
+
+				if (width == 0 || width > sizeof(buf) - 1)
+					width = sizeof(buf) - 1;
+				if (*t == '+' || *t == '-') {
+					neg = *t++ == '-';
+					width--;
+				}
+				limit = (flags & UNSIGNED) ? UINTMAX_MAX :
+				    (uintmax_t)INTMAX_MAX + neg;
+				res = 0;
+				for (n = 0; n < width; n++) {
+					c = t[n] - '0';
+					if (c < 0 || c > 9)
+						break;
+					if (res > (limit - c) / 10)
+						overflow = 1;
+					else
+						res = res * 10 + c;
+				}
+				if (n == 0)
+					goto match_failure;
+				s = t + n;
+				if (flags & SUPPRESS)
+					break;
+				if (overflow) {
+					errno = ERANGE;
+					res = (neg && !(flags & UNSIGNED)) ?
+					    (uintmax_t)INTMAX_MIN : limit;
+				} else if (neg)
+					res = -res;
+				goto store;
+			}
+			/* the same state machine as __svfscanf */
+			if (--width > sizeof(buf) - 2)
+				width = sizeof(buf) - 2;
+			width++;
+			flags |= SIGNOK | NDIGITS | NZDIGITS;
+			for (p = buf; width && *s != '\0'; width--) {
+				c = *s;
+				switch (c) {
+				case '0':
+					if (base == 0) {
+						base = 8;
+						flags |= PFXOK;
+					}
+					if (flags & NZDIGITS)
+					    flags &= ~(SIGNOK|NZDIGITS|NDIGITS);
+					else
+					    flags &= ~(SIGNOK|PFXOK|NDIGITS);
+					goto ok;
+
+				case '1': case '2': case '3':
+				case '4': case '5': case '6': case '7':
+					base = basefix[base];
+					flags &= ~(SIGNOK | PFXOK | NDIGITS);
+					goto ok;
+
+				case '8': case '9':
+					base = basefix[base];
+					if (base <= 8)
+						break;
+					flags &= ~(SIGNOK | PFXOK | NDIGITS);
+					goto ok;
+
+				case 'A': case 'B': case 'C':
+				case 'D': case 'E': case 'F':
+				case 'a': case 'b': case 'c':
+				case 'd': case 'e': case 'f':
+					if (base <= 10)
+						break;
+					flags &= ~(SIGNOK | PFXOK | NDIGITS);
+					goto ok;
+
+				case '+': case '-':
+					if (flags & SIGNOK) {
+						flags &= ~SIGNOK;
+						flags |= HAVESIGN;
+						goto ok;
+					}
+					break;
+
+				case 'x': case 'X':
+					if ((flags & PFXOK) && p ==
+					    buf + 1 + !!(flags & HAVESIGN)) {
+						base = 16;
+						flags &= ~PFXOK;
+						goto ok;
+					}
+					break;
+				}
+				break;
+		ok:
+				*p++ = c;
+				s++;
+			}
+			/* push back a lone sign, or the `x' of [sign] '0' 'x' */
+			if (flags & NDIGITS)
+				goto match_failure;
+			c = ((u_char *)p)[-1];
+			if (c == 'x' || c == 'X') {
+				--p;
+				--s;
+			}
+			if (flags & SUPPRESS)
+				break;
+			*p = '\0';
+			if (flags & UNSIGNED)
+				res = strtoumax(buf, NULL, base);
+			else
+				res = strtoimax(buf, NULL, base);
+store:
+			if (flags & MAXINT)
+				*va_arg(ap, intmax_t *) = res;
+			else if (flags & LLONG)
+				*va_arg(ap, long long *) = res;
+			else if (flags & SIZEINT)
+				*va_arg(ap, ssize_t *) = res;
+			else if (flags & PTRINT)
+				*va_arg(ap, ptrdiff_t *) = res;
+			else if (flags & LONG)
+				*va_arg(ap, long *) = res;
+			else if (flags & SHORT)
+				*va_arg(ap, short *) = res;
+			else if (flags & SHORTSHORT)
+				*va_arg(ap, signed char *) = res;
+			else
+				*va_arg(ap, int *) = res;
+			nassigned++;
+			break;
+		}
+	}
+	*result = nassigned;
+	return (1);
+input_failure:
+	if (nassigned == 0)
+		nassigned = -1;
+match_failure:
+	*result = nassigned;
+	return (1);
+}
+
 /*
  * Fill in the given table from the scanset at the given format
  * (just after `[').  Return a pointer to the character past the
@@ -31,6 +31,7 @@
 
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -49,12 +50,24 @@ struct atexit {
 		void (*fn_ptr)(void *);
 		void *fn_arg;		/* argument for CXA callback */
 		void *fn_dso;		/* shared module handle */
+		struct atexit_fn *fn_dso_prev;	/* previous for fn_dso */
 	} fns[1];			/* the table itself */
 };
 
 static struct atexit *__atexit;
 static int restartloop;
 
+/* BEGIN android-changed: index handlers by DSO for __cxa_finalize */
+struct atexit_dso {
+	void *dso;
+	struct atexit_fn *last;		/* most recently registered */
+};
+
+static struct atexit_dso *__atexit_dsos;
+static size_t __atexit_dsos_size;	/* slots, a power of two */
+static size_t __atexit_dsos_used;
+/* END android-changed */
+
 /* BEGIN android-changed: __unregister_atfork is used by __cxa_finalize */
 extern void __unregister_atfork(void* dso);
 /* END android-changed */
@@ -67,8 +80,99 @@ extern void __unregister_atfork(void* dso);
  *
  * Outside the following functions, all pages are mprotect()'ed
  * to prevent unintentional/malicious corruption.
+ *
+ * Each handler registered for a DSO also links to the previous one
+ * registered for the same DSO, and a hash table maps each DSO to its
+ * most recent handler. This lets __cxa_finalize(dso) visit only that
+ * DSO's handlers, rather than every handler in the process, which
+ * made unloading each of many libraries cost time proportional to all
+ * of their handlers. Like the __atexit list head, the table isn't
+ * mprotect()'ed, which would double the system calls per handler.
  */
 
+/* BEGIN android-changed */
+static size_t
+atexit_dso_hash(void *dso, size_t size)
+{
+	uintptr_t h = (uintptr_t)dso >> 4;
+
+	return ((h * 0x9e3779b9u) ^ (h >> 16)) & (size - 1);
+}
+
+/* Returns the slot for 'dso', or the empty slot where it would go. */
+static struct atexit_dso *
+atexit_dso_slot(void *dso)
+{
+	size_t i;
+
+	for (i = atexit_dso_hash(dso, __atexit_dsos_size);
+	    __atexit_dsos[i].dso != NULL && __atexit_dsos[i].dso != dso;
+	    i = (i + 1) & (__atexit_dsos_size - 1))
+		continue;
+	return (&__atexit_dsos[i]);
+}
+
+static struct atexit_dso *
+atexit_dso_find(void *dso)
+{
+	struct atexit_dso *slot;
+
+	if (__atexit_dsos == NULL)
+		return (NULL);
+	slot = atexit_dso_slot(dso);
+	return (slot->dso == dso ? slot : NULL);
+}
+
+/* Returns the slot for 'dso', adding one if needed. */
+static struct atexit_dso *
+atexit_dso_add(void *dso)
+{
+	struct atexit_dso *slot, *old = __atexit_dsos;
+	size_t i, old_size = __atexit_dsos_size, new_size, live, len;
+
+	slot = atexit_dso_find(dso);
+	if (slot == NULL && (__atexit_dsos_used + 1) * 2 > old_size) {
+		/*
+		 * Rebuild the table, dropping DSOs that have been finalized,
+		 * and grow it if that still leaves it more than half full.
+		 */
+		live = 0;
+		for (i = 0; i < old_size; i++) {
+			if (old[i].last != NULL)
+				live++;
+		}
+		new_size = old_size ? old_size :
+		    getpagesize() / sizeof(struct atexit_dso);
+		while ((live + 1) * 2 > new_size)
+			new_size *= 2;
+		len = new_size * sizeof(struct atexit_dso);
+		__atexit_dsos = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		    MAP_ANON | MAP_PRIVATE, -1, 0);
+		if (__atexit_dsos == MAP_FAILED) {
+			__atexit_dsos = old;
+			return (NULL);
+		}
+		prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, __atexit_dsos, len,
+		    "atexit handlers");
+		__atexit_dsos_size = new_size;
+		__atexit_dsos_used = live;
+		for (i = 0; i < old_size; i++) {
+			if (old[i].last != NULL)
+				*atexit_dso_slot(old[i].dso) = old[i];
+		}
+		if (old != NULL)
+			munmap(old, old_size * sizeof(struct atexit_dso));
+	}
+	if (slot == NULL) {
+		slot = atexit_dso_slot(dso);
+		slot->dso = dso;
+		slot->last = NULL;
+		__atexit_dsos_used++;
+	}
+	return (slot);
+}
+/* END android-changed */
+
 /*
  * Register a function to be performed at exit or when a shared object
  * with the given dso handle is unloaded dynamically.  Also used as
@@ -81,6 +185,7 @@ __cxa_atexit(void (*func)(void *), void *arg, void *dso)
 {
 	struct atexit *p = __atexit;
 	struct atexit_fn *fnp;
+	struct atexit_dso *slot = NULL;
 	size_t pgsize = getpagesize();
 	int ret = -1;
 
@@ -113,10 +218,23 @@ __cxa_atexit(void (*func)(void *), void *arg, void *dso)
 		p->next = __atexit;
 		__atexit = p;
 	}
+/* BEGIN android-changed */
+	if (dso != NULL && (slot = atexit_dso_add(dso)) == NULL) {
+		mprotect(p, pgsize, PROT_READ);
+		goto unlock;
+	}
+/* END android-changed */
 	fnp = &p->fns[p->ind++];
 	fnp->fn_ptr = func;
 	fnp->fn_arg = arg;
 	fnp->fn_dso = dso;
+/* BEGIN android-changed */
+	fnp->fn_dso_prev = NULL;
+	if (slot != NULL) {
+		fnp->fn_dso_prev = slot->last;
+		slot->last = fnp;
+	}
+/* END android-changed */
 	if (mprotect(p, pgsize, PROT_READ))
 		goto unlock;
 	restartloop = 1;
@@ -136,12 +254,47 @@ __cxa_finalize(void *dso)
 {
 	struct atexit *p, *q;
 	struct atexit_fn fn;
+	/* BEGIN android-changed */
+	struct atexit_fn *fnp;
+	struct atexit_dso *slot;
+	/* END android-changed */
 	int n, pgsize = getpagesize();
 	static int call_depth;
 
 	_ATEXIT_LOCK();
 	call_depth++;
 
+	/* BEGIN android-changed: only visit this DSO's handlers */
+	if (dso != NULL) {
+restart_dso:
+		restartloop = 0;
+		slot = atexit_dso_find(dso);
+		for (fnp = slot ? slot->last : NULL; fnp != NULL;
+		    fnp = fnp->fn_dso_prev) {
+			if (fnp->fn_ptr == NULL)
+				continue;	/* already called */
+
+			fn = *fnp;
+			p = (struct atexit *)((uintptr_t)fnp & ~(uintptr_t)(pgsize - 1));
+			if (mprotect(p, pgsize, PROT_READ | PROT_WRITE) == 0) {
+				fnp->fn_ptr = NULL;
+				mprotect(p, pgsize, PROT_READ);
+			}
+			_ATEXIT_UNLOCK();
+			(*fn.fn_ptr)(fn.fn_arg);
+			_ATEXIT_LOCK();
+			if (restartloop)
+				goto restart_dso;
+		}
+
+		/* Every handler has been called, so forget the DSO. */
+		slot = atexit_dso_find(dso);
+		if (slot != NULL)
+			slot->last = NULL;
+		goto done;
+	}
+	/* END android-changed */
+
 restart:
 	restartloop = 0;
 	for (p = __atexit; p != NULL; p = p->next) {
@@ -168,6 +321,7 @@ restart:
 		}
 	}
 
+done:
 	call_depth--;
 
 	/*
@@ -182,6 +336,14 @@ restart:
 			munmap(q, pgsize);
 		}
 		__atexit = NULL;
+		/* BEGIN android-changed */
+		if (__atexit_dsos != NULL) {
+			munmap(__atexit_dsos,
+			    __atexit_dsos_size * sizeof(struct atexit_dso));
+			__atexit_dsos = NULL;
+			__atexit_dsos_size = __atexit_dsos_used = 0;
+		}
+		/* END android-changed */
 	}
 	_ATEXIT_UNLOCK();
 
@@ -7,6 +7,7 @@ from subprocess import Popen, PIPE
 
 
 BPF_JGE = "BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, {0}, {1}, {2})"
+BPF_JEQ = "BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, {0}, {1}, {2})"
 BPF_ALLOW = "BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_ALLOW)"
 
 
@@ -105,6 +106,19 @@ def convert_names_to_NRs(names, header_dir, extra_switches):
   return syscalls
 
 
+# Returns the (name, value) pairs of the first count syscalls named in the
+# profile that are in syscalls, hottest first. The profile lists one name per
+# line, hottest first; names the architecture doesn't allow are skipped.
+def get_hot_syscalls(profile_file, syscalls, count):
+  values = dict(syscalls)
+  hot = []
+  for line in profile_file:
+    name = line.split("#")[0].strip()
+    if name and name in values and name not in [x[0] for x in hot]:
+      hot.append((name, values[name]))
+  return hot[:count]
+
+
 def convert_NRs_to_ranges(syscalls):
   # Sort the values so we convert to ranges and binary chop
   syscalls = sorted(syscalls, lambda x, y: cmp(x[1], y[1]))
@@ -143,7 +157,7 @@ def convert_to_intermediate_bpf(ranges):
     return jump + first + second
 
 
-def convert_ranges_to_bpf(ranges):
+def convert_ranges_to_bpf(ranges, hot_syscalls=()):
   bpf = convert_to_intermediate_bpf(ranges)
 
   # Now we know the size of the tree, we can substitute the {fail} and {allow}
@@ -167,7 +181,17 @@ def convert_ranges_to_bpf(ranges):
 
   # Add check that we aren't off the bottom of the syscalls
   bpf.insert(0, BPF_JGE.format(ranges[0].begin, 0, str(len(bpf))) + ',')
-  return bpf
+
+  # Check for the hottest syscalls one by one before the tree, jumping
+  # straight to the allow statement, so that they don't pay for its depth.
+  # Every other syscall pays one statement for each of them instead.
+  hot_bpf = []
+  for i, (name, value) in enumerate(hot_syscalls):
+    distance = len(hot_syscalls) - i - 1 + len(bpf) - 1
+    if distance > 255:
+      raise RuntimeError("Filter too long for hot syscall jump - aborting " + name)
+    hot_bpf.append(BPF_JEQ.format(value, distance, 0) + ", //" + name)
+  return hot_bpf + bpf
 
 
 def convert_bpf_to_output(bpf, architecture):
@@ -190,11 +214,15 @@ def convert_bpf_to_output(bpf, architecture):
   return header + "\n".join(bpf) + footer
 
 
-def construct_bpf(syscall_files, architecture, header_dir, extra_switches):
+def construct_bpf(syscall_files, architecture, header_dir, extra_switches,
+                  profile_file=None):
   names = get_names(syscall_files, architecture)
   syscalls = convert_names_to_NRs(names, header_dir, extra_switches)
   ranges = convert_NRs_to_ranges(syscalls)
-  bpf = convert_ranges_to_bpf(ranges)
+  hot_syscalls = []
+  if profile_file:
+    hot_syscalls = get_hot_syscalls(profile_file, syscalls, HOT_SYSCALL_COUNT)
+  bpf = convert_ranges_to_bpf(ranges, hot_syscalls)
   return convert_bpf_to_output(bpf, architecture)
 
 
@@ -203,6 +231,16 @@ ANDROID_SYSCALL_FILES = ["SYSCALLS.TXT",
                          "SECCOMP_BLACKLIST.TXT"]
 
 
+# Syscalls ordered by how often they're made, hottest first.
+ANDROID_PROFILE_FILE = "SECCOMP_PROFILE.TXT"
+
+
+# How many of the hottest syscalls get checked before the tree. Getting
+# through the tree takes six to eight statements, counting the check of its
+# lower bound, and each of these adds one to every other syscall.
+HOT_SYSCALL_COUNT = 4
+
+
 POLICY_CONFIGS = [("arm", "kernel/uapi/asm-arm", []),
                   ("arm64", "kernel/uapi/asm-arm64", []),
                   ("x86", "kernel/uapi/asm-x86", ["-D__i386__"]),
@@ -220,7 +258,8 @@ def main():
   set_dir()
   for arch, header_path, switches in POLICY_CONFIGS:
     files = [open(filename) for filename in ANDROID_SYSCALL_FILES]
-    output = construct_bpf(files, arch, header_path, switches)
+    profile = open(ANDROID_PROFILE_FILE)
+    output = construct_bpf(files, arch, header_path, switches, profile)
 
     # And output policy
     existing = ""
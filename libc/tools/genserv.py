@@ -38,6 +38,13 @@ class Service:
 
         return result
 
+    def size(self):
+        # name length + name + port(2) + proto(1) + alias count(1) + aliases
+        result = 1 + len(self.name) + 4
+        for alias in self.aliases:
+            result += 1 + len(alias)
+        return result
+
 def parse(f):
     result = []  # list of Service objects
     for line in f.xreadlines():
@@ -71,4 +78,26 @@ line = '/* generated by genserv.py - do not edit */\nstatic const char  _service
 for s in services:
     line += str(s)+"\\\n"
 line += '\\0";\n'
+
+# Indexes of the blob for getservbyname/getservbyport to binary search: the
+# offsets of the entries ordered by name and by port, with entries that
+# compare equal left in file order so the first match in the file still wins.
+offsets = []
+offset  = 0
+for s in services:
+    offsets.append(offset)
+    offset += s.size()
+if offset > 65535:
+    raise Exception("_services is too big for 16-bit offsets")
+
+def index(name, key):
+    order = sorted(range(len(services)), key=lambda i: (key(services[i]), i))
+    result = "\nstatic const unsigned short  %s[%d] = {\n" % (name, len(order))
+    for n in range(0, len(order), 10):
+        result += "  " + " ".join("%d," % offsets[i] for i in order[n:n+10]) + "\n"
+    result += "};\n"
+    return result
+
+line += index("_services_by_name", lambda s: s.name)
+line += index("_services_by_port", lambda s: s.port)
 print line
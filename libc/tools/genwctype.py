@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+#
+# This tool generates the Unicode character class and case mapping table used
+# by the isw* and tow* functions (libc/bionic/wctype.cpp), so that they don't
+# need to load ICU at run time.
+#
+# The table is generated by asking ICU itself, using the same properties that
+# wctype.cpp used to look up through ICU, so behavior only changes when the
+# table is regenerated against a newer ICU.
+#
+# usage: genwctype.py [path/to/libicuuc.so] > libc/bionic/wctype_table.h
+
+from __future__ import print_function
+
+import ctypes
+import sys
+
+# ICU's UProperty and UCharCategory values.
+UCHAR_ALPHABETIC = 0
+UCHAR_LOWERCASE = 22
+UCHAR_UPPERCASE = 30
+UCHAR_WHITE_SPACE = 31
+UCHAR_POSIX_ALNUM = 44
+UCHAR_POSIX_BLANK = 45
+UCHAR_POSIX_GRAPH = 46
+UCHAR_POSIX_PRINT = 47
+UCHAR_POSIX_XDIGIT = 48
+U_CONTROL_CHAR = 15
+
+UNICODE_LIMIT = 0x110000
+
+# Each block of this many code points gets one entry in the first-level table.
+# 128 keeps both levels' indexes in a byte.
+BLOCK_SHIFT = 7
+BLOCK_SIZE = 1 << BLOCK_SHIFT
+
+
+class Icu(object):
+    def __init__(self, path):
+        self.lib = ctypes.CDLL(path)
+        self.suffix = self.find_suffix()
+
+    def find_suffix(self):
+        # Like icu.cpp, accept any version in [44, 999].
+        for version in range(999, 43, -1):
+            if hasattr(self.lib, "u_charType_%d" % version):
+                return "_%d" % version
+        raise Exception("couldn't find a versioned u_charType")
+
+    def fn(self, name, restype):
+        f = getattr(self.lib, name + self.suffix)
+        f.restype = restype
+        return f
+
+    def version(self, name):
+        info = (ctypes.c_uint8 * 4)()
+        self.fn(name, None)(info)
+        return ".".join(str(b) for b in info[:3])
+
+
+def main():
+    icu = Icu(sys.argv[1] if len(sys.argv) > 1 else "libicuuc.so")
+
+    has_binary_property = icu.fn("u_hasBinaryProperty", ctypes.c_int8)
+    char_type = icu.fn("u_charType", ctypes.c_int8)
+    is_digit = icu.fn("u_isdigit", ctypes.c_int8)
+    is_punct = icu.fn("u_ispunct", ctypes.c_int8)
+    to_lower = icu.fn("u_tolower", ctypes.c_int32)
+    to_upper = icu.fn("u_toupper", ctypes.c_int32)
+
+    # In WC_TYPE_* order, starting from WC_TYPE_ALNUM.
+    classes = [
+        ("ALNUM", lambda c: has_binary_property(c, UCHAR_POSIX_ALNUM)),
+        ("ALPHA", lambda c: has_binary_property(c, UCHAR_ALPHABETIC)),
+        ("BLANK", lambda c: has_binary_property(c, UCHAR_POSIX_BLANK)),
+        ("CNTRL", lambda c: char_type(c) == U_CONTROL_CHAR),
+        ("DIGIT", lambda c: is_digit(c)),
+        ("GRAPH", lambda c: has_binary_property(c, UCHAR_POSIX_GRAPH)),
+        ("LOWER", lambda c: has_binary_property(c, UCHAR_LOWERCASE)),
+        ("PRINT", lambda c: has_binary_property(c, UCHAR_POSIX_PRINT)),
+        ("PUNCT", lambda c: is_punct(c)),
+        ("SPACE", lambda c: has_binary_property(c, UCHAR_WHITE_SPACE)),
+        ("UPPER", lambda c: has_binary_property(c, UCHAR_UPPERCASE)),
+        ("XDIGIT", lambda c: has_binary_property(c, UCHAR_POSIX_XDIGIT)),
+    ]
+
+    # Every code point maps to a record of its classes and case mapping deltas.
+    # Record 0 is reserved for "no classes, maps to itself", which is also what
+    # the lookup returns for anything beyond the table.
+    records = {(0, 0, 0): 0}
+    record_of = []
+    for c in range(UNICODE_LIMIT):
+        mask = 0
+        for i, (_, test) in enumerate(classes):
+            if test(c):
+                mask |= 1 << (i + 1)
+        record = (mask, to_lower(c) - c, to_upper(c) - c)
+        record_of.append(records.setdefault(record, len(records)))
+
+    blocks = {}
+    block_of = []
+    for start in range(0, UNICODE_LIMIT, BLOCK_SIZE):
+        block = tuple(record_of[start:start + BLOCK_SIZE])
+        block_of.append(blocks.setdefault(block, len(blocks)))
+
+    if len(records) > 256 or len(blocks) > 256:
+        raise Exception("table indexes no longer fit in a byte")
+
+    print("/* Generated by genwctype.py from ICU %s (Unicode %s). Do not edit. */" %
+          (icu.version("u_getVersion"), icu.version("u_getUnicodeVersion")))
+    print("")
+    print("#define WCTYPE_TABLE_LIMIT 0x%x" % UNICODE_LIMIT)
+    print("#define WCTYPE_BLOCK_SHIFT %d" % BLOCK_SHIFT)
+    print("")
+    print("struct wctype_record {")
+    print("  uint16_t classes;  // Bit WC_TYPE_x is set for class x.")
+    print("  int32_t lower_delta;")
+    print("  int32_t upper_delta;")
+    print("};")
+    print("")
+
+    print("static const wctype_record wctype_records[%d] = {" % len(records))
+    for record, _ in sorted(records.items(), key=lambda item: item[1]):
+        print("  { 0x%04x, %d, %d }," % record)
+    print("};")
+    print("")
+
+    def print_bytes(name, values):
+        print("static const uint8_t %s[%d] = {" % (name, len(values)))
+        for i in range(0, len(values), 16):
+            print("  " + " ".join("%d," % v for v in values[i:i + 16]))
+        print("};")
+
+    print_bytes("wctype_blocks", block_of)
+    print("")
+    block_contents = []
+    for block, _ in sorted(blocks.items(), key=lambda item: item[1]):
+        block_contents.extend(block)
+    print_bytes("wctype_block_records", block_contents)
+
+
+if __name__ == "__main__":
+    main()
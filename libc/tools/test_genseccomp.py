@@ -172,6 +172,29 @@ int __llseek:_llseek(int, unsigned long, unsigned long, off64_t*, int) arm,mips,
                             'BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 4, 1, 0), //b',
                             'BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_ALLOW),'])
 
+  def test_get_hot_syscalls(self):
+    profile = cStringIO.StringIO(textwrap.dedent("""\
+    # comment
+    c
+    missing
+
+    a # trailing comment
+    b
+    """))
+    hot = genseccomp.get_hot_syscalls(profile, [("a", 1), ("b", 2), ("c", 3)], 2)
+    self.assertEquals(hot, [("c", 3), ("a", 1)])
+
+  def test_convert_ranges_to_bpf_with_hot_syscalls(self):
+    ranges = genseccomp.convert_NRs_to_ranges([("b", 3), ("a", 1)])
+    bpf = genseccomp.convert_ranges_to_bpf(ranges, [("b", 3), ("a", 1)])
+    self.assertEquals(bpf, ['BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 3, 5, 0), //b',
+                            'BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 1, 4, 0), //a',
+                            'BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 1, 0, 4),',
+                            'BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 3, 1, 0),',
+                            'BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 2, 2, 1), //a',
+                            'BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 4, 1, 0), //b',
+                            'BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_ALLOW),'])
+
   def test_convert_bpf_to_output(self):
     output = genseccomp.convert_bpf_to_output(["line1", "line2"], "arm")
     expected_output = textwrap.dedent("""\
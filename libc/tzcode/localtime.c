@@ -369,7 +369,8 @@ union local_storage {
   } u;
 };
 
-static int __bionic_open_tzdata(const char*, int32_t*);
+static ssize_t __bionic_read_tzdata(const char*, char*, size_t);
+static bool __bionic_load_tzstate(const char*, struct state*);
 
 /* Load tz data from the file named NAME into *SP.  Read extended
    format if DOEXTEND.  Use *LSP for temporary storage.  Return 0 on
@@ -379,10 +380,10 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	   union local_storage *lsp)
 {
 	register int			i;
-	register int			fid;
 	register int			stored;
 	register ssize_t		nread;
 #if !defined(__BIONIC__)
+	register int			fid;
 	register bool doaccess;
 	register char *fullname = lsp->fullname;
 #endif
@@ -398,8 +399,11 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	}
 
 #if defined(__BIONIC__)
-	int32_t entry_length;
-	fid = __bionic_open_tzdata(name, &entry_length);
+	nread = __bionic_read_tzdata(name, up->buf, sizeof up->buf);
+	if (nread < 0)
+	  return errno;
+	if (nread < tzheadsize)
+	  return EINVAL;
 #else
 	if (name[0] == ':')
 		++name;
@@ -421,15 +425,10 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	if (doaccess && access(name, R_OK) != 0)
 	  return errno;
 	fid = open(name, OPEN_MODE);
-#endif
 	if (fid < 0)
 	  return errno;
 
-#if defined(__BIONIC__)
-	nread = TEMP_FAILURE_RETRY(read(fid, up->buf, entry_length));
-#else
 	nread = read(fid, up->buf, sizeof up->buf);
-#endif
 	if (nread < tzheadsize) {
 	  int err = nread < 0 ? errno : EINVAL;
 	  close(fid);
@@ -437,6 +436,7 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 	}
 	if (close(fid) < 0)
 	  return errno;
+#endif
 	for (stored = 4; stored <= 8; stored *= 2) {
 		int_fast32_t ttisstdcnt = detzcode(up->tzhead.tzh_ttisstdcnt);
 		int_fast32_t ttisgmtcnt = detzcode(up->tzhead.tzh_ttisgmtcnt);
@@ -686,6 +686,10 @@ tzloadbody(char const *name, struct state *sp, bool doextend,
 static int
 tzload(char const *name, struct state *sp, bool doextend)
 {
+#if defined(__BIONIC__)
+  if (doextend && __bionic_load_tzstate(name, sp))
+    return 0;
+#endif
 #ifdef ALL_STATE
   union local_storage *lsp = malloc(sizeof *lsp);
   if (!lsp)
@@ -1279,6 +1283,120 @@ zoneinit(struct state *sp, char const *name)
   }
 }
 
+#if defined(__BIONIC__)
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h> // For __system_property_serial.
+#include <stdatomic.h>
+#include "private/bionic_tz_memo.h"
+#endif
+
+#if defined(__BIONIC__) && defined(ALL_STATE)
+// localtime_r and mktime run without the lock while the zone is one of
+// these. Loaded zones are kept for the life of the process, so a thread
+// can go on using one after another thread changes the zone. Once there
+// have been LCL_SHARED_MAX different zones, new ones are loaded into
+// lcl_spare, which is only read with the lock held.
+#define LCL_SHARED_MAX 16
+static struct {
+  char name[sizeof lcl_TZname];
+  struct state *sp;
+} lcl_shared[LCL_SHARED_MAX];
+static int lcl_shared_count;
+static struct state *lcl_spare;
+static bool lcl_is_shared;
+
+// Changes whenever lclptr is loaded with a different zone, so thread memos
+// for an old zone aren't used. Never 0.
+static unsigned lcl_generation = 1;
+
+// What the current zone was set from, so lock-free callers can tell
+// whether it's still current. The fields are written with the lock held
+// and read under lcl_view_seq, which is odd while they're being written.
+static atomic_uint lcl_view_seq;
+static struct {
+  struct state const *sp; // NULL if callers must take the lock.
+  unsigned generation;
+  bool from_env;
+  uint32_t serial;        // Of persist.sys.timezone, if !from_env.
+  char name[sizeof lcl_TZname];
+} lcl_view;
+static prop_info const *_Atomic lcl_pi;
+
+static void
+lcl_publish(bool shareable, bool from_env, uint32_t serial)
+{
+  unsigned seq = atomic_load_explicit(&lcl_view_seq, memory_order_relaxed);
+  atomic_store_explicit(&lcl_view_seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  lcl_view.sp = shareable && lcl_is_shared ? lclptr : NULL;
+  lcl_view.generation = lcl_generation;
+  lcl_view.from_env = from_env;
+  lcl_view.serial = serial;
+  strcpy(lcl_view.name, lcl_is_set > 0 ? lcl_TZname : "");
+  atomic_store_explicit(&lcl_view_seq, seq + 2, memory_order_release);
+}
+
+// Returns the current zone if it can be used without the lock, or NULL if
+// the caller must take the lock and call tzset_unlocked.
+static struct state const *
+lcl_current(unsigned *generation)
+{
+  char const *name = getenv("TZ");
+  prop_info const *pi = NULL;
+  if (name == NULL) {
+    pi = atomic_load_explicit(&lcl_pi, memory_order_acquire);
+    if (pi == NULL)
+      return NULL;
+  }
+
+  unsigned seq = atomic_load_explicit(&lcl_view_seq, memory_order_acquire);
+  if (seq & 1)
+    return NULL;
+  struct state const *sp = lcl_view.sp;
+  *generation = lcl_view.generation;
+  bool current = name != NULL
+      ? lcl_view.from_env && strncmp(lcl_view.name, name, sizeof lcl_view.name) == 0
+      : !lcl_view.from_env && lcl_view.serial == __system_property_serial(pi);
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&lcl_view_seq, memory_order_relaxed) != seq)
+    return NULL;
+  return current ? sp : NULL;
+}
+
+// Returns a state loaded for NAME, which is shared if it's in lcl_shared.
+static struct state *
+lcl_load(char const *name, int lcl)
+{
+  struct state *sp;
+  int i;
+
+  lcl_is_shared = false;
+  if (0 < lcl) {
+    for (i = 0; i < lcl_shared_count; i++)
+      if (strcmp(lcl_shared[i].name, name) == 0) {
+        lcl_is_shared = true;
+        return lcl_shared[i].sp;
+      }
+  }
+  if (0 < lcl && lcl_shared_count < LCL_SHARED_MAX) {
+    sp = malloc(sizeof *sp);
+    if (sp) {
+      strcpy(lcl_shared[lcl_shared_count].name, name);
+      lcl_shared[lcl_shared_count].sp = sp;
+      lcl_shared_count++;
+      lcl_is_shared = true;
+    }
+  } else {
+    if (! lcl_spare)
+      lcl_spare = malloc(sizeof *lcl_spare);
+    sp = lcl_spare;
+  }
+  if (sp && zoneinit(sp, name) != 0)
+    zoneinit(sp, "");
+  return sp;
+}
+#endif
+
 static void
 tzsetlcl(char const *name)
 {
@@ -1288,6 +1406,15 @@ tzsetlcl(char const *name)
       ? lcl_is_set < 0
       : 0 < lcl_is_set && strcmp(lcl_TZname, name) == 0)
     return;
+#if defined(__BIONIC__) && defined(ALL_STATE)
+  // Shared states never change, so a new zone always gets its own.
+  lcl_publish(false, false, 0);
+  if (++lcl_generation == 0)
+    lcl_generation = 1;
+  lclptr = sp = lcl_load(name, lcl);
+  if (sp && 0 < lcl)
+    strcpy(lcl_TZname, name);
+#else
 #ifdef ALL_STATE
   if (! sp)
     lclptr = sp = malloc(sizeof *lclptr);
@@ -1298,6 +1425,7 @@ tzsetlcl(char const *name)
     if (0 < lcl)
       strcpy(lcl_TZname, name);
   }
+#endif
   settzname();
   lcl_is_set = lcl;
 }
@@ -1313,29 +1441,32 @@ tzsetwall(void)
 }
 #endif
 
-#if defined(__BIONIC__)
-#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
-#include <sys/_system_properties.h> // For __system_property_serial.
-#endif
-
 static void
 tzset_unlocked(void)
 {
 #if defined(__BIONIC__)
+  static uint32_t last_serial = -1;
+
   // The TZ environment variable is meant to override the system-wide setting.
   const char* name = getenv("TZ");
+  bool from_env = (name != NULL);
+
+  // The lookup is the most expensive part by several orders of magnitude, so we cache it.
+  // We check for null more than once because the system property may not have been set
+  // yet, so our first lookup may fail.
+  static const prop_info* pi;
 
   // If that's not set, look at the "persist.sys.timezone" system property.
   if (name == NULL) {
-    // The lookup is the most expensive part by several orders of magnitude, so we cache it.
-    // We check for null more than once because the system property may not have been set
-    // yet, so our first lookup may fail.
-    static const prop_info* pi;
-    if (pi == NULL) pi = __system_property_find("persist.sys.timezone");
+    if (pi == NULL) {
+      pi = __system_property_find("persist.sys.timezone");
+#if defined(ALL_STATE)
+      atomic_store_explicit(&lcl_pi, pi, memory_order_release);
+#endif
+    }
 
     if (pi) {
       // If the property hasn't changed since the last time we read it, there's nothing else to do.
-      static uint32_t last_serial = -1;
       uint32_t serial = __system_property_serial(pi);
       if (serial == last_serial) return;
 
@@ -1355,6 +1486,9 @@ tzset_unlocked(void)
         name = buf;
       }
     }
+  } else {
+    // The zone no longer comes from the property, so read it again when TZ is unset.
+    last_serial = -1;
   }
 
   // If the system property is also not available (because you're running AOSP on a WiFi-only
@@ -1362,6 +1496,9 @@ tzset_unlocked(void)
   if (name == NULL) name = gmt;
 
   tzsetlcl(name);
+#if defined(ALL_STATE)
+  lcl_publish(from_env || pi != NULL, from_env, last_serial);
+#endif
 #else
   tzsetlcl(getenv("TZ"));
 #endif
@@ -1532,9 +1669,81 @@ localtime_rz(struct state *sp, time_t const *timep, struct tm *tmp)
 
 #endif
 
+#if defined(__BIONIC__) && defined(ALL_STATE)
+/* Like localsub for the local zone SP, whose lcl_generation is GENERATION,
+   but first try the calling thread's memo of the last conversion.  */
+static struct tm *
+localsub_memo(struct state const *sp, unsigned generation,
+	      time_t const *timep, struct tm *tmp)
+{
+  struct bionic_tz_memo *memo = __bionic_tz_memo();
+  time_t const t = *timep;
+  int_fast32_t secs;
+
+  if (memo && memo->generation == generation
+      && memo->start <= t && t < memo->end) {
+    *tmp = memo->tm;
+    secs = t - memo->day_start;
+    tmp->tm_hour = secs / SECSPERHOUR;
+    tmp->tm_min = secs / SECSPERMIN % MINSPERHOUR;
+    tmp->tm_sec = secs % SECSPERMIN;
+    update_tzname_etc(sp, &sp->ttis[memo->type]);
+    return tmp;
+  }
+
+  struct tm *result = localsub(sp, timep, true, tmp);
+  /* Leap seconds and the repeats before the first and after the last
+     transition make the memo wrong, so leave those to localsub.  */
+  if (! (result && memo && sp && sp->leapcnt == 0
+	 && ! (sp->goback && t < sp->ats[0])
+	 && ! (sp->goahead && t > sp->ats[sp->timecnt - 1])
+	 && time_t_min + SECSPERDAY <= t && t <= time_t_max - SECSPERDAY))
+    return result;
+
+  /* Find the transitions either side of T, as localsub did.  */
+  time_t start = time_t_min, end = time_t_max;
+  int type;
+  if (sp->timecnt == 0 || t < sp->ats[0]) {
+    type = sp->defaulttype;
+    if (sp->timecnt != 0)
+      end = sp->ats[0];
+  } else {
+    int lo = 1, hi = sp->timecnt;
+    while (lo < hi) {
+      int mid = (lo + hi) >> 1;
+      if (t < sp->ats[mid])
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    type = sp->types[lo - 1];
+    start = sp->ats[lo - 1];
+    if (lo < sp->timecnt)
+      end = sp->ats[lo];
+  }
+
+  time_t day_start = t - (result->tm_hour * SECSPERHOUR
+			  + result->tm_min * SECSPERMIN + result->tm_sec);
+  memo->generation = generation;
+  memo->type = type;
+  memo->day_start = day_start;
+  memo->start = start < day_start ? day_start : start;
+  memo->end = day_start + SECSPERDAY < end ? day_start + SECSPERDAY : end;
+  memo->tm = *result;
+  return result;
+}
+#endif
+
 static struct tm *
 localtime_tzset(time_t const *timep, struct tm *tmp)
 {
+#if defined(__BIONIC__) && defined(ALL_STATE)
+  unsigned generation;
+  struct state const *sp = lcl_current(&generation);
+  if (sp)
+    return localsub_memo(sp, generation, timep, tmp);
+#endif
+
   int err = lock();
   if (err) {
     errno = err;
@@ -1548,7 +1757,11 @@ localtime_tzset(time_t const *timep, struct tm *tmp)
   // behave differently than other time zone-sensitive functions in <time.h>.
   tzset_unlocked();
 
+#if defined(__BIONIC__) && defined(ALL_STATE)
+  tmp = localsub_memo(lclptr, lcl_generation, timep, tmp);
+#else
   tmp = localsub(lclptr, timep, true, tmp);
+#endif
   unlock();
   return tmp;
 }
@@ -2191,14 +2404,23 @@ mktime(struct tm *tmp)
 #endif
 
   time_t t;
-  int err = lock();
-  if (err) {
-    errno = err;
-    return -1;
+#if defined(__BIONIC__) && defined(ALL_STATE)
+  unsigned generation;
+  struct state const *sp = lcl_current(&generation);
+  if (sp) {
+    t = time1(tmp, localsub, sp, true);
+  } else
+#endif
+  {
+    int err = lock();
+    if (err) {
+      errno = err;
+      return -1;
+    }
+    tzset_unlocked();
+    t = mktime_tzname(lclptr, tmp, true);
+    unlock();
   }
-  tzset_unlocked();
-  t = mktime_tzname(lclptr, tmp, true);
-  unlock();
 
 #if defined(__BIONIC__)
   errno = (t == -1) ? EOVERFLOW : saved_errno;
@@ -2352,6 +2574,8 @@ time(time_t *p)
 #include <assert.h>
 #include <stdint.h>
 #include <arpa/inet.h> // For ntohl(3).
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #if !defined(__ANDROID__)
 static char* make_path(const char* path_prefix_variable,
@@ -2359,162 +2583,528 @@ static char* make_path(const char* path_prefix_variable,
   const char* path_prefix = getenv(path_prefix_variable);
   if (path_prefix == NULL) {
     fprintf(stderr, "%s: %s not set!\n", __FUNCTION__, path_prefix_variable);
-    return -1;
+    return NULL;
   }
   size_t path_length = strlen(path_prefix) + 1 + strlen(path_suffix) + 1;
   char* path = malloc(path_length);
   if (path == NULL) {
     fprintf(stderr, "%s: couldn't allocate %zu-byte path\n", __FUNCTION__, path_length);
-    return -1;
+    return NULL;
   }
   snprintf(path, path_length, "%s/%s", path_prefix, path_suffix);
   return path;
 }
 #endif
 
-static int __bionic_open_tzdata_path(const char* path,
-                                     const char* olson_id,
-                                     int32_t* entry_length) {
-  int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
-  if (fd == -1) {
-    return -2; // Distinguish failure to find any data from failure to find a specific id.
-  }
+// byte[12] tzdata_version  -- "tzdata2012f\0"
+// int index_offset
+// int data_offset
+// int zonetab_offset
+struct bionic_tzdata_header {
+  char tzdata_version[12];
+  int32_t index_offset;
+  int32_t data_offset;
+  int32_t zonetab_offset;
+};
 
-  // byte[12] tzdata_version  -- "tzdata2012f\0"
-  // int index_offset
-  // int data_offset
-  // int zonetab_offset
-  struct bionic_tzdata_header {
-    char tzdata_version[12];
-    int32_t index_offset;
-    int32_t data_offset;
-    int32_t zonetab_offset;
-  } header;
-  memset(&header, 0, sizeof(header));
-  ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, &header, sizeof(header)));
-  if (bytes_read != sizeof(header)) {
-    fprintf(stderr, "%s: could not read header of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
-    close(fd);
-    return -1;
-  }
+#define NAME_LENGTH 40
+struct bionic_tzdata_index_entry {
+  char buf[NAME_LENGTH];
+  int32_t start;
+  int32_t length;
+  int32_t unused; // Was raw GMT offset; always 0 since tzdata2014f (L).
+};
 
-  if (strncmp(header.tzdata_version, "tzdata", 6) != 0 || header.tzdata_version[11] != 0) {
-    fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n",
-            __FUNCTION__, path, header.tzdata_version);
-    close(fd);
-    return -1;
-  }
+// A read-only mapping of a file that's kept until the file is replaced, so
+// every lookup after the first costs a stat(2) rather than an open(2) and
+// reads of the header and the whole index.
+struct bionic_mapped_file {
+  const char* path;
+  const char* base; // NULL if the file couldn't be mapped or was rejected.
+  size_t size;
+  bool checked;     // Whether dev, ino, and mtime identify what 'base' maps.
+  dev_t dev;
+  ino_t ino;
+  struct timespec mtime;
+  bool sorted;      // Whether the index can be binary searched.
+};
 
-#if 0
-  fprintf(stderr, "version: %s\n", header.tzdata_version);
-  fprintf(stderr, "index_offset = %d\n", ntohl(header.index_offset));
-  fprintf(stderr, "data_offset = %d\n", ntohl(header.data_offset));
-  fprintf(stderr, "zonetab_offset = %d\n", ntohl(header.zonetab_offset));
+// A tzstate image holds every zone of one tzdata file already loaded, so a
+// process can set its time zone with a few copies instead of decoding the
+// TZif data and parsing its TZ string. Images are written by the platform
+// with android_tzstate_write, and are only used while they match the tzdata
+// that would be read. They're in native byte order and struct layout, so
+// each ABI has its own.
+#if defined(__LP64__)
+#define TZSTATE_NAME "tzstate64"
+#else
+#define TZSTATE_NAME "tzstate32"
 #endif
 
-  if (TEMP_FAILURE_RETRY(lseek(fd, ntohl(header.index_offset), SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: couldn't seek to index in \"%s\": %s\n",
-            __FUNCTION__, path, strerror(errno));
-    close(fd);
-    return -1;
+// Change this if struct state, or what tzload puts in it, changes.
+static const char TZSTATE_MAGIC[8] = "tzstat1";
+
+struct bionic_tzstate_header {
+  char magic[8];
+  char tzdata_version[12];
+  uint32_t state_size; // sizeof(struct state) in the libc that wrote the image.
+  uint32_t count;
+};
+
+// Sorted by name.
+struct bionic_tzstate_entry {
+  char name[NAME_LENGTH];
+  uint32_t offset; // From the start of the image.
+  uint32_t length;
+};
+
+// Followed by ats[timecnt], types[timecnt], ttis[typecnt], lsis[leapcnt],
+// and chars[charcnt].
+struct bionic_tzstate_record {
+  int32_t leapcnt;
+  int32_t timecnt;
+  int32_t typecnt;
+  int32_t charcnt;
+  int32_t defaulttype;
+  uint8_t goback;
+  uint8_t goahead;
+};
+
+#if defined(__ANDROID__)
+static struct bionic_mapped_file tzdata_files[] = {
+  { .path = "/data/misc/zoneinfo/current/tzdata" },
+  { .path = "/system/usr/share/zoneinfo/tzdata" },
+};
+static struct bionic_mapped_file tzstate_file = {
+  .path = "/data/misc/zoneinfo/current/" TZSTATE_NAME,
+};
+#else
+// On the host, we don't expect those locations to exist, and we're not
+// worried about security so we trust $ANDROID_DATA and $ANDROID_ROOT to
+// point us in the right direction.
+static struct bionic_mapped_file tzdata_files[2];
+static struct bionic_mapped_file tzstate_file;
+#endif
+
+#if THREAD_SAFE
+static pthread_mutex_t tzdata_lock = PTHREAD_MUTEX_INITIALIZER;
+static void lock_tzdata(void) { pthread_mutex_lock(&tzdata_lock); }
+static void unlock_tzdata(void) { pthread_mutex_unlock(&tzdata_lock); }
+#else
+static void lock_tzdata(void) { }
+static void unlock_tzdata(void) { }
+#endif
+
+static void __bionic_init_tzdata_paths(void) {
+#if !defined(__ANDROID__)
+  static bool initialized;
+  if (initialized) return;
+  initialized = true;
+  tzdata_files[0].path = make_path("ANDROID_DATA", "/misc/zoneinfo/current/tzdata");
+  tzdata_files[1].path = make_path("ANDROID_ROOT", "/usr/share/zoneinfo/tzdata");
+  tzstate_file.path = make_path("ANDROID_DATA", "/misc/zoneinfo/current/" TZSTATE_NAME);
+#endif
+}
+
+static int32_t __bionic_tzdata_int(const int32_t* p) {
+  // The index isn't necessarily aligned.
+  int32_t value;
+  memcpy(&value, p, sizeof(value));
+  return ntohl(value);
+}
+
+static void __bionic_unmap_file(struct bionic_mapped_file* file) {
+  if (file->base != NULL) {
+    munmap((void*) file->base, file->size);
+    file->base = NULL;
+  }
+  file->checked = false;
+}
+
+// Makes 'file' map the current contents of its path, remapping it if the
+// file has been replaced. 'check' is called on each new mapping, and a
+// rejected file isn't looked at again until it's replaced. Returns whether
+// there's a usable mapping.
+static bool __bionic_map_file(struct bionic_mapped_file* file,
+                              bool (*check)(struct bionic_mapped_file*)) {
+  struct stat sb;
+  if (file->path == NULL || stat(file->path, &sb) == -1) {
+    __bionic_unmap_file(file);
+    return false;
   }
+  if (file->checked && sb.st_dev == file->dev && sb.st_ino == file->ino &&
+      sb.st_mtim.tv_sec == file->mtime.tv_sec && sb.st_mtim.tv_nsec == file->mtime.tv_nsec) {
+    return file->base != NULL;
+  }
+  __bionic_unmap_file(file);
 
-  off_t specific_zone_offset = -1;
-  ssize_t index_size = ntohl(header.data_offset) - ntohl(header.index_offset);
-  char* index = malloc(index_size);
-  if (index == NULL) {
-    fprintf(stderr, "%s: couldn't allocate %zd-byte index for \"%s\"\n",
-            __FUNCTION__, index_size, path);
+  int fd = TEMP_FAILURE_RETRY(open(file->path, O_RDONLY | O_CLOEXEC));
+  if (fd == -1) return false;
+  if (fstat(fd, &sb) == -1) {
     close(fd);
-    return -1;
+    return false;
   }
-  if (TEMP_FAILURE_RETRY(read(fd, index, index_size)) != index_size) {
-    fprintf(stderr, "%s: could not read index of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
-    free(index);
-    close(fd);
-    return -1;
+  file->checked = true;
+  file->dev = sb.st_dev;
+  file->ino = sb.st_ino;
+  file->mtime = sb.st_mtim;
+  if (sb.st_size > 0 && (uint64_t) sb.st_size <= SIZE_MAX) {
+    void* base = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base != MAP_FAILED) {
+      file->base = base;
+      file->size = sb.st_size;
+    }
   }
+  close(fd);
 
-  static const size_t NAME_LENGTH = 40;
-  struct index_entry_t {
-    char buf[NAME_LENGTH];
-    int32_t start;
-    int32_t length;
-    int32_t unused; // Was raw GMT offset; always 0 since tzdata2014f (L).
-  };
+  if (file->base != NULL && !check(file)) {
+    munmap((void*) file->base, file->size);
+    file->base = NULL;
+  }
+  return file->base != NULL;
+}
 
-  size_t id_count = (ntohl(header.data_offset) - ntohl(header.index_offset)) / sizeof(struct index_entry_t);
-  struct index_entry_t* entry = (struct index_entry_t*) index;
-  for (size_t i = 0; i < id_count; ++i) {
-    char this_id[NAME_LENGTH + 1];
-    memcpy(this_id, entry->buf, NAME_LENGTH);
-    this_id[NAME_LENGTH] = '\0';
-
-    if (strcmp(this_id, olson_id) == 0) {
-      specific_zone_offset = ntohl(entry->start) + ntohl(header.data_offset);
-      *entry_length = ntohl(entry->length);
-      break;
+static bool __bionic_check_tzdata(struct bionic_mapped_file* file) {
+  const struct bionic_tzdata_header* header = (const struct bionic_tzdata_header*) file->base;
+  if (file->size < sizeof(*header) ||
+      strncmp(header->tzdata_version, "tzdata", 6) != 0 || header->tzdata_version[11] != 0) {
+    fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n",
+            __FUNCTION__, file->path, file->size < 6 ? "" : header->tzdata_version);
+    return false;
+  }
+
+  uint32_t index_offset = __bionic_tzdata_int(&header->index_offset);
+  uint32_t data_offset = __bionic_tzdata_int(&header->data_offset);
+  if (index_offset < sizeof(*header) || index_offset > data_offset || data_offset > file->size) {
+    fprintf(stderr, "%s: bad index offsets in \"%s\"\n", __FUNCTION__, file->path);
+    return false;
+  }
+
+  // ZoneCompactor writes the index in name order, but fall back to scanning
+  // it if this file doesn't have that.
+  const struct bionic_tzdata_index_entry* index =
+      (const struct bionic_tzdata_index_entry*) (file->base + index_offset);
+  size_t id_count = (data_offset - index_offset) / sizeof(*index);
+  file->sorted = true;
+  for (size_t i = 1; i < id_count && file->sorted; ++i) {
+    file->sorted = strncmp(index[i - 1].buf, index[i].buf, NAME_LENGTH) < 0;
+  }
+  return true;
+}
+
+static const struct bionic_tzdata_index_entry* __bionic_find_tzdata(
+    const struct bionic_mapped_file* file, const char* olson_id) {
+  if (strlen(olson_id) > NAME_LENGTH) return NULL;
+
+  const struct bionic_tzdata_header* header = (const struct bionic_tzdata_header*) file->base;
+  uint32_t index_offset = __bionic_tzdata_int(&header->index_offset);
+  uint32_t data_offset = __bionic_tzdata_int(&header->data_offset);
+  const struct bionic_tzdata_index_entry* index =
+      (const struct bionic_tzdata_index_entry*) (file->base + index_offset);
+  size_t id_count = (data_offset - index_offset) / sizeof(*index);
+
+  if (file->sorted) {
+    size_t lo = 0, hi = id_count;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      int cmp = strncmp(olson_id, index[mid].buf, NAME_LENGTH);
+      if (cmp == 0) return &index[mid];
+      if (cmp < 0) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
     }
+    return NULL;
+  }
+  for (size_t i = 0; i < id_count; ++i) {
+    if (strncmp(olson_id, index[i].buf, NAME_LENGTH) == 0) return &index[i];
+  }
+  return NULL;
+}
 
-    ++entry;
+// Returns the tzdata file that's searched first, or NULL if there isn't any.
+static struct bionic_mapped_file* __bionic_primary_tzdata(void) {
+  for (size_t i = 0; i < sizeof(tzdata_files) / sizeof(tzdata_files[0]); ++i) {
+    if (__bionic_map_file(&tzdata_files[i], __bionic_check_tzdata)) return &tzdata_files[i];
+  }
+  return NULL;
+}
+
+// Copies the TZif data for 'olson_id' into 'buf', truncated to 'buf_size'.
+// Returns the number of bytes copied, or -1 with errno set if the zone
+// isn't in any tzdata.
+static ssize_t __bionic_read_tzdata(const char* olson_id, char* buf, size_t buf_size) {
+  ssize_t result = -1;
+  bool have_tzdata = false;
+
+  lock_tzdata();
+  __bionic_init_tzdata_paths();
+  for (size_t i = 0; i < sizeof(tzdata_files) / sizeof(tzdata_files[0]) && result == -1; ++i) {
+    struct bionic_mapped_file* file = &tzdata_files[i];
+    if (!__bionic_map_file(file, __bionic_check_tzdata)) continue;
+    have_tzdata = true;
+
+    const struct bionic_tzdata_index_entry* entry = __bionic_find_tzdata(file, olson_id);
+    if (entry == NULL) continue;
+
+    const struct bionic_tzdata_header* header = (const struct bionic_tzdata_header*) file->base;
+    uint64_t start = (uint64_t) (uint32_t) __bionic_tzdata_int(&header->data_offset) +
+                     (uint32_t) __bionic_tzdata_int(&entry->start);
+    uint32_t length = __bionic_tzdata_int(&entry->length);
+    if (start > file->size || length > file->size - start) {
+      fprintf(stderr, "%s: bad entry for %s in \"%s\"\n", __FUNCTION__, olson_id, file->path);
+      continue;
+    }
+    // TODO: check that there's TZ_MAGIC at this offset, so we can fall back to the other file if not.
+    if (length > buf_size) length = buf_size;
+    memcpy(buf, file->base + start, length);
+    result = length;
+  }
+  unlock_tzdata();
+
+  if (result == -1) {
+    // Not finding any tzdata is more serious that not finding a specific zone,
+    // and worth logging.
+    if (!have_tzdata) {
+      // The first thing that 'recovery' does is try to format the current time. It doesn't have
+      // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
+      fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
+    }
+    errno = ENOENT;
   }
-  free(index);
+  return result;
+}
 
-  if (specific_zone_offset == -1) {
-    close(fd);
-    return -1;
+static bool __bionic_check_tzstate(struct bionic_mapped_file* file) {
+  const struct bionic_tzstate_header* header = (const struct bionic_tzstate_header*) file->base;
+  if (file->size < sizeof(*header) || memcmp(header->magic, TZSTATE_MAGIC, sizeof(TZSTATE_MAGIC)) != 0 ||
+      header->state_size != sizeof(struct state) ||
+      header->count > (file->size - sizeof(*header)) / sizeof(struct bionic_tzstate_entry)) {
+    return false;
+  }
+  const struct bionic_tzstate_entry* entries = (const struct bionic_tzstate_entry*) (header + 1);
+  for (size_t i = 1; i < header->count; ++i) {
+    if (strncmp(entries[i - 1].name, entries[i].name, NAME_LENGTH) >= 0) return false;
   }
+  return true;
+}
 
-  if (TEMP_FAILURE_RETRY(lseek(fd, specific_zone_offset, SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: could not seek to %ld in \"%s\": %s\n",
-            __FUNCTION__, specific_zone_offset, path, strerror(errno));
-    close(fd);
-    return -1;
+static size_t __bionic_tzstate_record_size(const struct bionic_tzstate_record* record) {
+  return sizeof(*record) + record->timecnt * (sizeof(time_t) + 1) +
+         record->typecnt * sizeof(struct ttinfo) + record->leapcnt * sizeof(struct lsinfo) +
+         record->charcnt;
+}
+
+// Writes the record for 'sp' to 'out' if it's not NULL. Returns its size.
+static size_t __bionic_pack_tzstate(const struct state* sp, char* out) {
+  struct bionic_tzstate_record record = {
+    .leapcnt = sp->leapcnt,
+    .timecnt = sp->timecnt,
+    .typecnt = sp->typecnt,
+    .charcnt = sp->charcnt,
+    .defaulttype = sp->defaulttype,
+    .goback = sp->goback,
+    .goahead = sp->goahead,
+  };
+  if (out != NULL) {
+    char* p = out;
+    memcpy(p, &record, sizeof(record));
+    p += sizeof(record);
+    memcpy(p, sp->ats, sp->timecnt * sizeof(time_t));
+    p += sp->timecnt * sizeof(time_t);
+    memcpy(p, sp->types, sp->timecnt);
+    p += sp->timecnt;
+    memcpy(p, sp->ttis, sp->typecnt * sizeof(struct ttinfo));
+    p += sp->typecnt * sizeof(struct ttinfo);
+    memcpy(p, sp->lsis, sp->leapcnt * sizeof(struct lsinfo));
+    p += sp->leapcnt * sizeof(struct lsinfo);
+    memcpy(p, sp->chars, sp->charcnt);
   }
+  return __bionic_tzstate_record_size(&record);
+}
+
+static bool __bionic_unpack_tzstate(const char* p, size_t length, struct state* sp) {
+  struct bionic_tzstate_record record;
+  if (length < sizeof(record)) return false;
+  memcpy(&record, p, sizeof(record));
+  if (record.leapcnt < 0 || record.leapcnt > TZ_MAX_LEAPS ||
+      record.timecnt < 0 || record.timecnt > TZ_MAX_TIMES ||
+      record.typecnt <= 0 || record.typecnt > TZ_MAX_TYPES ||
+      record.charcnt < 0 || (size_t) record.charcnt >= sizeof(sp->chars) ||
+      record.defaulttype < 0 || record.defaulttype >= record.typecnt ||
+      __bionic_tzstate_record_size(&record) != length) {
+    return false;
+  }
+  p += sizeof(record);
+
+  sp->leapcnt = record.leapcnt;
+  sp->timecnt = record.timecnt;
+  sp->typecnt = record.typecnt;
+  sp->charcnt = record.charcnt;
+  sp->defaulttype = record.defaulttype;
+  sp->goback = record.goback;
+  sp->goahead = record.goahead;
+  memcpy(sp->ats, p, sp->timecnt * sizeof(time_t));
+  p += sp->timecnt * sizeof(time_t);
+  memcpy(sp->types, p, sp->timecnt);
+  p += sp->timecnt;
+  memcpy(sp->ttis, p, sp->typecnt * sizeof(struct ttinfo));
+  p += sp->typecnt * sizeof(struct ttinfo);
+  memcpy(sp->lsis, p, sp->leapcnt * sizeof(struct lsinfo));
+  p += sp->leapcnt * sizeof(struct lsinfo);
+  memcpy(sp->chars, p, sp->charcnt);
+  sp->chars[sp->charcnt] = '\0';
+
+  // Check what the rest of this file relies on tzload to have checked.
+  if (record.goback > 1 || record.goahead > 1) return false;
+  for (int i = 0; i < sp->timecnt; ++i) {
+    if (sp->types[i] >= sp->typecnt || (i > 0 && sp->ats[i] <= sp->ats[i - 1])) return false;
+  }
+  for (int i = 0; i < sp->typecnt; ++i) {
+    if (sp->ttis[i].tt_abbrind < 0 || sp->ttis[i].tt_abbrind >= sp->charcnt) return false;
+  }
+  for (int i = 1; i < sp->leapcnt; ++i) {
+    if (sp->lsis[i].ls_trans <= sp->lsis[i - 1].ls_trans) return false;
+  }
+  return true;
+}
+
+// Loads 'olson_id' from the tzstate image, as tzload would with 'doextend'.
+// Returns false if there's no current image with that zone, so the caller
+// should load it from tzdata.
+static bool __bionic_load_tzstate(const char* olson_id, struct state* sp) {
+  if (olson_id == NULL || strlen(olson_id) > NAME_LENGTH) return false;
+
+  bool loaded = false;
+  lock_tzdata();
+  __bionic_init_tzdata_paths();
+  struct bionic_mapped_file* tzdata = __bionic_primary_tzdata();
+  if (tzdata != NULL && __bionic_map_file(&tzstate_file, __bionic_check_tzstate)) {
+    const struct bionic_tzstate_header* header =
+        (const struct bionic_tzstate_header*) tzstate_file.base;
+    const struct bionic_tzstate_entry* entries = (const struct bionic_tzstate_entry*) (header + 1);
+    if (memcmp(header->tzdata_version, tzdata->base, sizeof(header->tzdata_version)) == 0) {
+      size_t lo = 0, hi = header->count;
+      while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = strncmp(olson_id, entries[mid].name, NAME_LENGTH);
+        if (cmp == 0) {
+          const struct bionic_tzstate_entry* entry = &entries[mid];
+          loaded = entry->offset <= tzstate_file.size &&
+                   entry->length <= tzstate_file.size - entry->offset &&
+                   __bionic_unpack_tzstate(tzstate_file.base + entry->offset, entry->length, sp);
+          break;
+        }
+        if (cmp < 0) {
+          hi = mid;
+        } else {
+          lo = mid + 1;
+        }
+      }
+    }
+  }
+  unlock_tzdata();
+  return loaded;
+}
 
-  // TODO: check that there's TZ_MAGIC at this offset, so we can fall back to the other file if not.
+static int __bionic_tzstate_name_cmp(const void* lhs, const void* rhs) {
+  return strncmp(lhs, rhs, NAME_LENGTH);
+}
 
-  return fd;
+static int __bionic_write_fully(int fd, const void* data, size_t length) {
+  const char* p = data;
+  while (length > 0) {
+    ssize_t n = TEMP_FAILURE_RETRY(write(fd, p, length));
+    if (n == -1) return errno;
+    p += n;
+    length -= n;
+  }
+  return 0;
 }
 
-static int __bionic_open_tzdata(const char* olson_id, int32_t* entry_length) {
-  int fd;
+// Writes a tzstate image of every zone in the tzdata that's searched first to
+// 'fd'. Returns 0 on success, an errno value on failure. For the platform's
+// tzdata updater, which should replace /data/misc/zoneinfo/current/tzstate32
+// or tzstate64 (for the ABI of the calling process) with the result.
+int android_tzstate_write(int fd) {
+  struct bionic_tzstate_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TZSTATE_MAGIC, sizeof(TZSTATE_MAGIC));
+  header.state_size = sizeof(struct state);
+
+  // Take a copy of the names so the lock isn't held while loading the zones.
+  size_t id_count = 0;
+  char* names = NULL;
+  lock_tzdata();
+  __bionic_init_tzdata_paths();
+  struct bionic_mapped_file* tzdata = __bionic_primary_tzdata();
+  if (tzdata != NULL) {
+    const struct bionic_tzdata_header* tzdata_header =
+        (const struct bionic_tzdata_header*) tzdata->base;
+    uint32_t index_offset = __bionic_tzdata_int(&tzdata_header->index_offset);
+    uint32_t data_offset = __bionic_tzdata_int(&tzdata_header->data_offset);
+    const struct bionic_tzdata_index_entry* index =
+        (const struct bionic_tzdata_index_entry*) (tzdata->base + index_offset);
+    memcpy(header.tzdata_version, tzdata_header->tzdata_version, sizeof(header.tzdata_version));
+    id_count = (data_offset - index_offset) / sizeof(*index);
+    names = malloc(id_count * NAME_LENGTH + 1);
+    if (names != NULL) {
+      for (size_t i = 0; i < id_count; ++i) {
+        memcpy(names + i * NAME_LENGTH, index[i].buf, NAME_LENGTH);
+      }
+    }
+  }
+  unlock_tzdata();
+  if (tzdata == NULL) return ENOENT;
+  if (names == NULL) return ENOMEM;
+  qsort(names, id_count, NAME_LENGTH, __bionic_tzstate_name_cmp);
+
+  int err = ENOMEM;
+  union local_storage* lsp = malloc(sizeof(*lsp));
+  struct state* sp = malloc(sizeof(*sp));
+  struct bionic_tzstate_entry* entries = calloc(id_count, sizeof(*entries));
+  char* records = NULL;
+  size_t records_size = 0;
+  if (lsp == NULL || sp == NULL || entries == NULL) goto out;
 
-#if defined(__ANDROID__)
-  // On Android, try the two hard-coded locations.
-  fd = __bionic_open_tzdata_path("/data/misc/zoneinfo/current/tzdata",
-                                 olson_id, entry_length);
-  if (fd >= 0) return fd;
-
-  fd = __bionic_open_tzdata_path("/system/usr/share/zoneinfo/tzdata",
-                                 olson_id, entry_length);
-  if (fd >= 0) return fd;
-#else
-  // On the host, we don't expect those locations to exist, and we're not
-  // worried about security so we trust $ANDROID_DATA and $ANDROID_ROOT to
-  // point us in the right direction.
-  char* path = make_path("ANDROID_DATA", "/misc/zoneinfo/current/tzdata");
-  fd = __bionic_open_tzdata_path(path, olson_id, entry_length);
-  free(path);
-  if (fd >= 0) return fd;
-
-  path = make_path("ANDROID_ROOT", "/usr/share/zoneinfo/tzdata");
-  fd = __bionic_open_tzdata_path(path, olson_id, entry_length);
-  free(path);
-  if (fd >= 0) return fd;
-#endif
+  for (size_t i = 0; i < id_count; ++i) {
+    char olson_id[NAME_LENGTH + 1];
+    memcpy(olson_id, names + i * NAME_LENGTH, NAME_LENGTH);
+    olson_id[NAME_LENGTH] = '\0';
+    if (header.count > 0 &&
+        strncmp(entries[header.count - 1].name, olson_id, NAME_LENGTH) == 0) continue;
+    // Zones that don't load are left out, and will fail to load from tzdata too.
+    if (tzloadbody(olson_id, sp, true, lsp) != 0) continue;
+
+    size_t length = __bionic_pack_tzstate(sp, NULL);
+    char* new_records = realloc(records, records_size + length);
+    if (new_records == NULL) goto out;
+    records = new_records;
+    __bionic_pack_tzstate(sp, records + records_size);
+
+    struct bionic_tzstate_entry* entry = &entries[header.count++];
+    memcpy(entry->name, olson_id, NAME_LENGTH);
+    entry->offset = records_size;
+    entry->length = length;
+    records_size += length;
+  }
 
-  // Not finding any tzdata is more serious that not finding a specific zone,
-  // and worth logging.
-  if (fd == -2) {
-    // The first thing that 'recovery' does is try to format the current time. It doesn't have
-    // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
-    fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
+  size_t records_offset = sizeof(header) + header.count * sizeof(*entries);
+  for (size_t i = 0; i < header.count; ++i) {
+    entries[i].offset += records_offset;
   }
+  err = __bionic_write_fully(fd, &header, sizeof(header));
+  if (err == 0) err = __bionic_write_fully(fd, entries, header.count * sizeof(*entries));
+  if (err == 0) err = __bionic_write_fully(fd, records, records_size);
 
-  return fd;
+out:
+  free(records);
+  free(entries);
+  free(sp);
+  free(lsp);
+  free(names);
+  return err;
 }
 
 // END android-added
@@ -626,13 +626,47 @@ label:
     return pt;
 }
 
+/* "00" to "99", for writing numbers two digits at a time.  */
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
 static char *
 _conv(int n, const char *format, char *pt, const char *ptlim)
 {
 	char	buf[INT_STRLEN_MAXIMUM(int) + 1];
-
-	snprintf(buf, sizeof(buf), format, n);
-	return _add(buf, pt, ptlim, 0);
+	char	*p = buf + sizeof buf;
+	unsigned int	u = (n < 0) ? - (unsigned int) n : (unsigned int) n;
+	/*
+	** The formats are all "%d" with an optional '0' flag and
+	** a one-digit width, so do what snprintf would without it.
+	*/
+	bool	zero = format[1] == '0';
+	int	width = (format[1 + zero] == 'd') ? 0 : format[1 + zero] - '0';
+	int	len;
+
+	*--p = '\0';
+	while (u >= 100) {
+		p -= 2;
+		memcpy(p, &digit_pairs[2 * (u % 100)], 2);
+		u /= 100;
+	}
+	if (u >= 10) {
+		p -= 2;
+		memcpy(p, &digit_pairs[2 * u], 2);
+	} else	*--p = '0' + u;
+	len = (buf + sizeof buf - 1 - p) + (n < 0);
+	if (zero)
+		for ( ; len < width; ++len)
+			*--p = '0';
+	if (n < 0)
+		*--p = '-';
+	for ( ; len < width; ++len)
+		*--p = ' ';
+	return _add(p, pt, ptlim, 0);
 }
 
 static char *
@@ -710,3 +744,235 @@ _yconv(int a, int b, bool convert_top, bool convert_yy,
         pt = _conv(((trail < 0) ? -trail : trail), getformat(modifier, "%02d", "%2d", "%d", "%02d"), pt, ptlim);
     return pt;
 }
+
+// BEGIN android-added
+
+#include <android/strftime.h>
+
+// One conversion of a compiled format, or a run of literal text.
+struct strftime_op {
+    int conv;       // 0 for literal text.
+    int modifier;
+    size_t offset;  // Of the literal text in the plan's literals.
+    size_t length;
+};
+
+struct android_strftime_plan {
+    bool needs_tzset;
+    size_t op_count;
+    const char* literals;
+    struct strftime_op ops[];
+};
+
+struct plan_builder {
+    struct strftime_op* ops;
+    size_t op_count;
+    size_t op_capacity;
+    char* literals;
+    size_t literals_size;
+    size_t literals_capacity;
+    bool needs_tzset;
+    bool failed;
+};
+
+static bool _plan_reserve(void** array, size_t* capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+    size_t new_capacity = *capacity ? *capacity * 2 : 16;
+    void* new_array = realloc(*array, new_capacity * size);
+    if (new_array == NULL) return false;
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+static void _plan_op(struct plan_builder* b, int conv, int modifier) {
+    if (b->failed ||
+        !_plan_reserve((void**) &b->ops, &b->op_capacity, b->op_count, sizeof(*b->ops))) {
+        b->failed = true;
+        return;
+    }
+    struct strftime_op* op = &b->ops[b->op_count++];
+    op->conv = conv;
+    op->modifier = modifier;
+    op->offset = b->literals_size;
+    op->length = 0;
+}
+
+static void _plan_literal(struct plan_builder* b, char c) {
+    if (b->op_count == 0 || b->ops[b->op_count - 1].conv != 0) _plan_op(b, 0, 0);
+    if (b->failed ||
+        !_plan_reserve((void**) &b->literals, &b->literals_capacity, b->literals_size, 1)) {
+        b->failed = true;
+        return;
+    }
+    b->literals[b->literals_size++] = c;
+    b->ops[b->op_count - 1].length++;
+}
+
+// Parses 'format' the way _fmt does, expanding the conversions that are
+// shorthand for other formats.
+static void _plan_compile(struct plan_builder* b, const char* format) {
+    for ( ; *format; ++format) {
+        if (*format == '%') {
+            int modifier = 0;
+label:
+            switch (*++format) {
+            case '\0':
+                --format;
+                break;
+            case 'E':
+            case 'O':
+                goto label;
+            case '_':
+            case '-':
+            case '0':
+            case '^':
+            case '#':
+                modifier = *format;
+                goto label;
+            case 'c':
+                _plan_compile(b, Locale->c_fmt);
+                continue;
+            case 'D':
+                _plan_compile(b, "%m/%d/%y");
+                continue;
+            case 'F':
+                _plan_compile(b, "%Y-%m-%d");
+                continue;
+            case 'R':
+                _plan_compile(b, "%H:%M");
+                continue;
+            case 'r':
+                _plan_compile(b, "%I:%M:%S %p");
+                continue;
+            case 'T':
+                _plan_compile(b, "%H:%M:%S");
+                continue;
+            case 'v':
+                _plan_compile(b, "%e-%b-%Y");
+                continue;
+            case 'X':
+                _plan_compile(b, Locale->X_fmt);
+                continue;
+            case 'x':
+                _plan_compile(b, Locale->x_fmt);
+                continue;
+            case '+':
+                _plan_compile(b, Locale->date_fmt);
+                continue;
+            case 'n':
+                _plan_literal(b, '\n');
+                continue;
+            case 't':
+                _plan_literal(b, '\t');
+                continue;
+            case 'Z':
+                // This falls back to tzname, which strftime calls tzset for.
+                b->needs_tzset = true;
+                _plan_op(b, *format, modifier);
+                continue;
+            case 'A': case 'a': case 'B': case 'b': case 'C': case 'd':
+            case 'e': case 'G': case 'g': case 'H': case 'h': case 'I':
+            case 'j': case 'k': case 'l': case 'M': case 'm': case 'P':
+            case 'p': case 'S': case 's': case 'U': case 'u': case 'V':
+            case 'W': case 'w': case 'Y': case 'y': case 'z':
+                _plan_op(b, *format, modifier);
+                continue;
+            case '%':
+            default:
+                break;
+            }
+        }
+        _plan_literal(b, *format);
+    }
+}
+
+android_strftime_plan* android_strftime_compile(const char* format) {
+    struct plan_builder b;
+    memset(&b, 0, sizeof(b));
+    _plan_compile(&b, (format == NULL) ? "%c" : format);
+
+    android_strftime_plan* plan = NULL;
+    if (!b.failed) {
+        plan = malloc(sizeof(*plan) + b.op_count * sizeof(*b.ops) + b.literals_size);
+        if (plan != NULL) {
+            plan->needs_tzset = b.needs_tzset;
+            plan->op_count = b.op_count;
+            if (b.op_count != 0) memcpy(plan->ops, b.ops, b.op_count * sizeof(*b.ops));
+            char* literals = (char*) (plan->ops + b.op_count);
+            if (b.literals_size != 0) memcpy(literals, b.literals, b.literals_size);
+            plan->literals = literals;
+        }
+    } else {
+        errno = ENOMEM;
+    }
+    free(b.ops);
+    free(b.literals);
+    return plan;
+}
+
+static char* _plan_field(const struct strftime_op* op, const struct tm* t,
+                         char* pt, const char* ptlim) {
+    // The fields in typical timestamps, when they're in their usual ranges.
+    if (op->modifier == 0 || op->modifier == '0') {
+        int n = -1;
+        switch (op->conv) {
+        case 'd': n = t->tm_mday; break;
+        case 'H': n = t->tm_hour; break;
+        case 'M': n = t->tm_min; break;
+        case 'm': n = t->tm_mon + 1; break;
+        case 'S': n = t->tm_sec; break;
+        case 'Y':
+            if (t->tm_year >= -TM_YEAR_BASE && t->tm_year <= 9999 - TM_YEAR_BASE &&
+                ptlim - pt >= 4) {
+                int year = t->tm_year + TM_YEAR_BASE;
+                memcpy(pt, &digit_pairs[2 * (year / 100)], 2);
+                memcpy(pt + 2, &digit_pairs[2 * (year % 100)], 2);
+                return pt + 4;
+            }
+            break;
+        }
+        if (n >= 0 && n < 100 && ptlim - pt >= 2) {
+            memcpy(pt, &digit_pairs[2 * n], 2);
+            return pt + 2;
+        }
+    }
+
+    // Anything else is formatted just as strftime would.
+    char format[4];
+    size_t i = 0;
+    format[i++] = '%';
+    if (op->modifier != 0) format[i++] = op->modifier;
+    format[i++] = op->conv;
+    format[i] = '\0';
+    int warn = IN_NONE;
+    return _fmt(format, t, pt, ptlim, &warn);
+}
+
+size_t android_strftime_format(char* s, size_t maxsize, const android_strftime_plan* plan,
+                               const struct tm* t) {
+    char* pt = s;
+    const char* ptlim = s + maxsize;
+
+    if (plan->needs_tzset) tzset();
+    for (size_t i = 0; i < plan->op_count && pt < ptlim; ++i) {
+        const struct strftime_op* op = &plan->ops[i];
+        if (op->conv == 0) {
+            size_t n = op->length;
+            if (n > (size_t) (ptlim - pt)) n = ptlim - pt;
+            memcpy(pt, plan->literals + op->offset, n);
+            pt += n;
+        } else {
+            pt = _plan_field(op, t, pt, ptlim);
+        }
+    }
+    if (pt == ptlim) return 0;
+    *pt = '\0';
+    return pt - s;
+}
+
+void android_strftime_plan_free(android_strftime_plan* plan) {
+    free(plan);
+}
+
+// END android-added
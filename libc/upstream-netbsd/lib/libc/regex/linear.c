@@ -0,0 +1,778 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * The REG_LINEAR matcher.  This file is #included by regexec.c after the
+ * large-representation copy of engine.c, whose step() and dissect() it uses.
+ *
+ * fast() is replaced by a DFA built lazily from the strip: each DFA state
+ * is a set of strip states plus what the previous character was, and its
+ * transitions are filled in the first time they're taken.  The DFA lives in
+ * the re_guts and is shared by every regexec() on the regex_t, so repeated
+ * matching soon stops calling step() at all.  The slow()-from-each-coldp
+ * loop that finds where the match starts is replaced by one pass that
+ * labels every strip state with the earliest start that reaches it.  Both
+ * passes are linear in the length of the string; REG_LINEAR patterns can't
+ * have back references, so backref() is never needed.  Subexpression
+ * offsets still come from dissect(), which only looks at the matched text.
+ */
+
+/* the DFA cache may use about this much memory before it's flushed */
+#define	DFA_MAXBYTES	(256 * 1024)
+/* the cache regexec() uses while another thread has the shared one */
+#define	DFA_LOCALBYTES	(16 * 1024)
+
+/* what the character before the current position was */
+#define	LP_OUT		0	/* none, BOL allowed */
+#define	LP_OUTNOBOL	1	/* none, REG_NOTBOL */
+#define	LP_NEWLINE	2	/* '\n' under REG_NEWLINE */
+#define	LP_WORD		3	/* ISWORD */
+#define	LP_OTHER	4	/* anything else */
+
+struct dfa_state {
+	size_t hash;
+	uch props;		/* LP_* before this state */
+	uch fresh;		/* strip states are those of a fresh start */
+};
+
+struct dfa_cache {
+	size_t n;		/* states in use */
+	size_t cap;		/* states allocated */
+	size_t max;		/* flush rather than grow beyond this */
+	struct dfa_state *st;	/* [cap] */
+	char *sets;		/* [cap][nstates] */
+	int *next;		/* [cap][nclasses]: -1, or next << 1 | matched */
+	int *table;		/* [2 * cap] hash of state index + 1, or 0 */
+};
+
+struct re_dfa {
+	pthread_mutex_t lock;	/* protects cache */
+	struct dfa_cache cache;
+	size_t nclasses;	/* characters the strip can't tell apart */
+	uch classes[NC];	/* class of each (uch) character */
+	int rep[NC];		/* [nclasses] a character of each class */
+	uch props[NC];		/* [nclasses] LP_* each class leaves behind */
+	char *fresh;		/* [nstates] strip states of a fresh start */
+};
+
+/* ========= begin header generated by ./mkh ========= */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === linear.c === */
+static int linmatcher(struct re_guts *g, const char *string, size_t nmatch, regmatch_t pmatch[], int eflags);
+static int dfafast(struct lmat *m, struct re_dfa *d, struct dfa_cache *c, const char *start, const char *stop);
+static const char *tagslow(struct lmat *m, const char *start, const char *stop);
+static size_t *tstep(struct re_guts *g, sopno start, sopno stop, size_t *bef, int ch, size_t *aft);
+
+#ifdef __cplusplus
+}
+#endif
+/* ========= end header generated by ./mkh ========= */
+
+/*
+ - linflags - the empty-width steps fast() and slow() take between characters
+ * *nbe steps of *be (BOL, EOL or BOLEOL), then one of the returned BOW or
+ * EOW, if it isn't 0.
+ */
+static int
+linflags(
+    struct re_guts *g,
+    int eflags,
+    int lastc,
+    int c,
+    int *be,
+    size_t *nbe)
+{
+	int flagch;
+	size_t i;
+
+	flagch = '\0';
+	i = 0;
+	if ( (lastc == '\n' && g->cflags&REG_NEWLINE) ||
+			(lastc == OUT && !(eflags&REG_NOTBOL)) ) {
+		flagch = BOL;
+		i = g->nbol;
+	}
+	if ( (c == '\n' && g->cflags&REG_NEWLINE) ||
+			(c == OUT && !(eflags&REG_NOTEOL)) ) {
+		flagch = (flagch == BOL) ? BOLEOL : EOL;
+		i += g->neol;
+	}
+	*be = flagch;
+	*nbe = i;
+
+	if ( (flagch == BOL || (lastc != OUT && !ISWORD(lastc))) &&
+				(c != OUT && ISWORD(c)) )
+		return(BOW);
+	if ( (lastc != OUT && ISWORD(lastc)) &&
+			(flagch == EOL || (c != OUT && !ISWORD(c))) )
+		return(EOW);
+	return(0);
+}
+
+/*
+ - lpchar - a previous character, and eflags, that linflags() treats as props
+ */
+static int
+lpchar(
+    int props,
+    int *eflags)
+{
+	*eflags = (props == LP_OUTNOBOL) ? REG_NOTBOL : 0;
+	switch (props) {
+	case LP_OUT:
+	case LP_OUTNOBOL:
+		return(OUT);
+	case LP_NEWLINE:
+		return('\n');
+	case LP_WORD:
+		return('_');
+	default:
+		return(' ');
+	}
+}
+
+/*
+ - dfaboundary - apply the empty-width steps between lastc and c to a set
+ */
+static void
+dfaboundary(
+    struct re_guts *g,
+    char *st,
+    int eflags,
+    int lastc,
+    int c)
+{
+	const sopno gf = g->firststate+1;
+	const sopno gl = g->laststate;
+	int be;
+	size_t i;
+	int word;
+
+	word = linflags(g, eflags, lastc, c, &be, &i);
+	for (; i > 0; i--)
+		st = lstep(g, gf, gl, st, be, st);
+	if (word != 0)
+		st = lstep(g, gf, gl, st, word, st);
+}
+
+/*
+ - __regdfa_alloc - set up an empty DFA for a REG_LINEAR regex
+ * The strip can't distinguish characters in the same category, so the DFA
+ * only needs a transition per category, once ISWORD and newlines (which
+ * the boundaries care about) are split out.
+ */
+struct re_dfa *
+__regdfa_alloc(
+    struct re_guts *g)
+{
+	struct re_dfa *d;
+	int key[NC];
+	int c;
+	size_t k;
+	uch uc;
+
+	d = calloc(1, sizeof(*d));
+	if (d == NULL)
+		return(NULL);
+	d->fresh = calloc((size_t)g->nstates, 1);
+	if (d->fresh == NULL) {
+		free(d);
+		return(NULL);
+	}
+	pthread_mutex_init(&d->lock, NULL);
+
+	d->nclasses = 0;
+	for (c = CHAR_MIN; c <= CHAR_MAX; c++) {
+		uc = (uch)c;
+		key[uc] = g->categories[c] << 2 | (ISWORD(c) ? 1 : 0) << 1 |
+		    ((c == '\n' && g->cflags&REG_NEWLINE) ? 1 : 0);
+		for (k = 0; k < d->nclasses; k++)
+			if (key[(uch)d->rep[k]] == key[uc])
+				break;
+		if (k == d->nclasses) {
+			d->rep[k] = c;
+			if (c == '\n' && g->cflags&REG_NEWLINE)
+				d->props[k] = LP_NEWLINE;
+			else if (ISWORD(c))
+				d->props[k] = LP_WORD;
+			else
+				d->props[k] = LP_OTHER;
+			d->nclasses++;
+		}
+		d->classes[uc] = (uch)k;
+	}
+
+	d->fresh[g->firststate+1] = 1;
+	(void)lstep(g, g->firststate+1, g->laststate, d->fresh, NOTHING,
+	    d->fresh);
+	d->cache.max = DFA_MAXBYTES / ((size_t)g->nstates +
+	    d->nclasses * sizeof(int) + sizeof(struct dfa_state) +
+	    2 * sizeof(int));
+	if (d->cache.max < 4)
+		d->cache.max = 4;
+	return(d);
+}
+
+static void
+dfafree(
+    struct dfa_cache *c)
+{
+	free(c->st);
+	free(c->sets);
+	free(c->next);
+	free(c->table);
+}
+
+/*
+ - __regdfa_free - free a REG_LINEAR regex's DFA
+ */
+void
+__regdfa_free(
+    struct re_dfa *d)
+{
+	dfafree(&d->cache);
+	pthread_mutex_destroy(&d->lock);
+	free(d->fresh);
+	free(d);
+}
+
+/*
+ - dfagrow - make room for more states, or return -1
+ */
+static int
+dfagrow(
+    struct re_guts *g,
+    struct re_dfa *d,
+    struct dfa_cache *c)
+{
+	size_t cap;
+	size_t tsize;
+	size_t i;
+	size_t j;
+	void *p;
+
+	if (c->cap >= c->max)
+		return(-1);
+	cap = (c->cap == 0) ? 16 : c->cap * 2;
+	if (cap > c->max)
+		cap = c->max;
+	if ((p = realloc(c->st, cap * sizeof(*c->st))) == NULL)
+		return(-1);
+	c->st = p;
+	if ((p = realloc(c->sets, cap * (size_t)g->nstates)) == NULL)
+		return(-1);
+	c->sets = p;
+	if ((p = realloc(c->next, cap * d->nclasses * sizeof(int))) == NULL)
+		return(-1);
+	c->next = p;
+	if ((p = calloc(2 * cap, sizeof(int))) == NULL)
+		return(-1);
+	free(c->table);
+	c->table = p;
+	c->cap = cap;
+
+	tsize = 2 * cap;
+	for (i = 0; i < c->n; i++) {
+		for (j = c->st[i].hash % tsize; c->table[j] != 0;
+		    j = (j + 1) % tsize)
+			continue;
+		c->table[j] = (int)i + 1;
+	}
+	return(0);
+}
+
+/*
+ - dfaintern - find or add the DFA state for a set and props
+ * Returns its index, or -1 if no memory could be had at all.  If the cache
+ * had to be flushed to make room, *flushed is set and every other index
+ * the caller holds is stale.
+ */
+static int
+dfaintern(
+    struct re_guts *g,
+    struct re_dfa *d,
+    struct dfa_cache *c,
+    const char *set,
+    int props,
+    int *flushed)
+{
+	const size_t ns = (size_t)g->nstates;
+	size_t h;
+	size_t i;
+	size_t j;
+	size_t s;
+
+	h = 2166136261u;
+	for (i = 0; i < ns; i++)
+		h = (h ^ (uch)set[i]) * 16777619u;
+	h = (h ^ (size_t)props) * 16777619u;
+
+	if (c->cap != 0) {
+		for (j = h % (2 * c->cap); c->table[j] != 0;
+		    j = (j + 1) % (2 * c->cap)) {
+			s = (size_t)c->table[j] - 1;
+			if (c->st[s].hash == h && c->st[s].props == props &&
+			    memcmp(&c->sets[s * ns], set, ns) == 0)
+				return((int)s);
+		}
+	}
+
+	if (c->n == c->cap && dfagrow(g, d, c) != 0) {
+		if (c->cap == 0)
+			return(-1);
+		c->n = 0;
+		memset(c->table, 0, 2 * c->cap * sizeof(int));
+		*flushed = 1;
+	}
+
+	s = c->n++;
+	memcpy(&c->sets[s * ns], set, ns);
+	c->st[s].hash = h;
+	c->st[s].props = (uch)props;
+	c->st[s].fresh = memcmp(set, d->fresh, ns) == 0;
+	memset(&c->next[s * d->nclasses], 0xff, d->nclasses * sizeof(int));
+	for (j = h % (2 * c->cap); c->table[j] != 0; j = (j + 1) % (2 * c->cap))
+		continue;
+	c->table[j] = (int)s + 1;
+	return((int)s);
+}
+
+/*
+ - dfanext - work out and remember a transition of the DFA
+ * Like one trip around fast()'s loop, with the character being any member
+ * of class k.
+ */
+static int			/* next << 1 | matched, or -1 */
+dfanext(
+    struct lmat *m,
+    struct re_dfa *d,
+    struct dfa_cache *c,
+    int cur,
+    size_t k)
+{
+	struct re_guts *g = m->g;
+	const sopno gf = g->firststate+1;
+	const sopno gl = g->laststate;
+	const size_t ns = (size_t)g->nstates;
+	int eflags;
+	int lastc;
+	int hit;
+	int next;
+	int flushed;
+
+	lastc = lpchar(c->st[cur].props, &eflags);
+	memcpy(m->tmp, &c->sets[(size_t)cur * ns], ns);
+	dfaboundary(g, m->tmp, eflags, lastc, d->rep[k]);
+	hit = ISSET(m->tmp, gl) ? 1 : 0;
+	memcpy(m->st, d->fresh, ns);
+	(void)lstep(g, gf, gl, m->tmp, d->rep[k], m->st);
+
+	flushed = 0;
+	next = dfaintern(g, d, c, m->st, d->props[k], &flushed);
+	if (next < 0)
+		return(-1);
+	if (!flushed)
+		c->next[(size_t)cur * d->nclasses + k] = next << 1 | hit;
+	return(next << 1 | hit);
+}
+
+/*
+ - dfafast - fast() on the DFA
+ * Sets m->coldp as fast() does.
+ */
+static int			/* 0 match, REG_NOMATCH, or REG_ESPACE */
+dfafast(
+    struct lmat *m,
+    struct re_dfa *d,
+    struct dfa_cache *c,
+    const char *start,
+    const char *stop)
+{
+	struct re_guts *g = m->g;
+	const char *p;
+	int cur;
+	int t;
+	int eflags;
+	int lastc;
+	int flushed;
+	size_t k;
+
+	_DIAGASSERT(start == m->beginp);
+
+	flushed = 0;
+	cur = dfaintern(g, d, c, d->fresh,
+	    (m->eflags&REG_NOTBOL) ? LP_OUTNOBOL : LP_OUT, &flushed);
+	if (cur < 0)
+		return(REG_ESPACE);
+	m->coldp = NULL;
+	for (p = start; ; p++) {
+		if (c->st[cur].fresh)
+			m->coldp = p;
+		if (p == stop)
+			break;
+		k = d->classes[(uch)*p];
+		t = c->next[(size_t)cur * d->nclasses + k];
+		if (t < 0 && (t = dfanext(m, d, c, cur, k)) < 0)
+			return(REG_ESPACE);
+		if (t & 1)
+			return(0);
+		cur = t >> 1;
+	}
+
+	/* the last boundary depends on REG_NOTEOL, so it isn't cached */
+	lastc = lpchar(c->st[cur].props, &eflags);
+	memcpy(m->tmp, &c->sets[(size_t)cur * g->nstates], (size_t)g->nstates);
+	dfaboundary(g, m->tmp, eflags | (m->eflags&REG_NOTEOL), lastc, OUT);
+	return(ISSET(m->tmp, g->laststate) ? 0 : REG_NOMATCH);
+}
+
+/* keep the earlier start; 0 means the state isn't reached */
+#define	TMERGE(d, s)	((s) != 0 && ((d) == 0 || (s) < (d)) ? (d) = (s) : 0)
+#define	TFWD(dst, src, n)	TMERGE((dst)[pc+(n)], (src)[pc])
+#define	TBACK(dst, src, n)	TMERGE((dst)[pc-(n)], (src)[pc])
+
+/*
+ - tstep - step() over sets of states labelled by where their attempt started
+ * Each state carries 1 + the offset of the earliest start that reaches it,
+ * so all of slow()'s attempts from successive coldps run at once.
+ */
+static size_t *
+tstep(
+    struct re_guts *g,
+    sopno start,		/* start state within strip */
+    sopno stop,			/* state after stop state within strip */
+    size_t *bef,		/* states reachable before */
+    int ch,			/* character or NONCHAR code */
+    size_t *aft)		/* states already known reachable after */
+{
+	cset *cs;
+	sop s;
+	sopno pc;
+	sopno look;
+	size_t t;
+
+	_DIAGASSERT(g != NULL);
+
+	for (pc = start; pc != stop; pc++) {
+		s = g->strip[pc];
+		switch (OP(s)) {
+		case OEND:
+			assert(pc == stop-1);
+			break;
+		case OCHAR:
+			if (ch == (char)OPND(s))
+				TFWD(aft, bef, 1);
+			break;
+		case OBOL:
+			if (ch == BOL || ch == BOLEOL)
+				TFWD(aft, bef, 1);
+			break;
+		case OEOL:
+			if (ch == EOL || ch == BOLEOL)
+				TFWD(aft, bef, 1);
+			break;
+		case OBOW:
+			if (ch == BOW)
+				TFWD(aft, bef, 1);
+			break;
+		case OEOW:
+			if (ch == EOW)
+				TFWD(aft, bef, 1);
+			break;
+		case OANY:
+			if (!NONCHAR(ch))
+				TFWD(aft, bef, 1);
+			break;
+		case OANYOF:
+			cs = &g->sets[OPND(s)];
+			if (!NONCHAR(ch) && CHIN(cs, ch))
+				TFWD(aft, bef, 1);
+			break;
+		case OPLUS_:
+		case O_QUEST:
+		case OLPAREN:
+		case ORPAREN:
+		case O_CH:
+			TFWD(aft, aft, 1);
+			break;
+		case O_PLUS:		/* both forward and back */
+			TFWD(aft, aft, 1);
+			t = aft[pc - OPND(s)];
+			TBACK(aft, aft, OPND(s));
+			if (aft[pc - OPND(s)] != t)
+				/* an earlier start must go round again */
+				pc -= OPND(s) + 1;
+			break;
+		case OQUEST_:
+			TFWD(aft, aft, 1);
+			TFWD(aft, aft, OPND(s));
+			break;
+		case OCH_:
+			TFWD(aft, aft, 1);
+			TFWD(aft, aft, OPND(s));
+			break;
+		case OOR1:
+			if (aft[pc] != 0) {
+				for (look = 1;
+						OP(s = g->strip[pc+look]) != O_CH;
+						look += OPND(s))
+					assert(OP(s) == OOR2);
+				TFWD(aft, aft, look);
+			}
+			break;
+		case OOR2:
+			TFWD(aft, aft, 1);
+			if (OP(g->strip[pc+OPND(s)]) != O_CH)
+				TFWD(aft, aft, OPND(s));
+			break;
+		default:		/* back references were refused */
+			assert(nope);
+			break;
+		}
+	}
+
+	return(aft);
+}
+
+static void
+tboundary(
+    struct lmat *m,
+    size_t *st,
+    int lastc,
+    int c)
+{
+	struct re_guts *g = m->g;
+	const sopno gf = g->firststate+1;
+	const sopno gl = g->laststate;
+	int be;
+	size_t i;
+	int word;
+
+	word = linflags(g, m->eflags, lastc, c, &be, &i);
+	for (; i > 0; i--)
+		st = tstep(g, gf, gl, st, be, st);
+	if (word != 0)
+		st = tstep(g, gf, gl, st, word, st);
+}
+
+/*
+ - tagslow - find the leftmost-longest match in one pass
+ * Gives the same answer as calling slow() from start, start+1, ... until
+ * one succeeds.  Sets m->coldp to where the match starts.
+ */
+static const char *		/* where it ended, or NULL if out of memory */
+tagslow(
+    struct lmat *m,
+    const char *start,
+    const char *stop)
+{
+	struct re_guts *g = m->g;
+	const sopno gf = g->firststate+1;
+	const sopno gl = g->laststate;
+	const size_t ns = (size_t)g->nstates;
+	size_t *st;
+	size_t *tmp;
+	size_t *t;
+	size_t best;		/* label of the best start so far, or 0 */
+	const char *matchp;
+	const char *p = start;
+	int c = (start == m->beginp) ? OUT : *(start-1);
+	int lastc;
+	int alive;
+	size_t i;
+
+	st = calloc(2 * ns, sizeof(size_t));
+	if (st == NULL)
+		return(NULL);
+	tmp = st + ns;
+	best = 0;
+	matchp = NULL;
+	for (;;) {
+		lastc = c;
+		c = (p == m->endp) ? OUT : *p;
+
+		/* later starts can't beat one that has matched */
+		if (best == 0) {
+			TMERGE(st[gf], (size_t)(p - start) + 1);
+			st = tstep(g, gf, gl, st, NOTHING, st);
+		}
+		tboundary(m, st, lastc, c);
+		if (st[gl] != 0 && (best == 0 || st[gl] <= best)) {
+			best = st[gl];
+			matchp = p;
+		}
+		if (p == stop)
+			break;
+
+		memset(tmp, 0, ns * sizeof(size_t));
+		assert(c != OUT);
+		(void)tstep(g, gf, gl, st, c, tmp);
+		t = st;
+		st = tmp;
+		tmp = t;
+		if (best != 0) {
+			alive = 0;
+			for (i = 0; i < ns; i++) {
+				if (st[i] > best)
+					st[i] = 0;
+				else if (st[i] != 0)
+					alive = 1;
+			}
+			if (!alive)
+				break;
+		}
+		p++;
+	}
+
+	free(st < tmp ? st : tmp);
+	assert(best != 0);
+	m->coldp = start + (best - 1);
+	return(matchp);
+}
+
+/*
+ - linmatcher - matcher() for REG_LINEAR
+ */
+static int			/* 0 success, REG_NOMATCH failure */
+linmatcher(
+    struct re_guts *g,
+    const char *string,
+    size_t nmatch,
+    regmatch_t pmatch[],
+    int eflags)
+{
+	struct re_dfa *d = g->dfa;
+	struct dfa_cache local;
+	struct dfa_cache *c;
+	size_t i;
+	struct lmat mv;
+	struct lmat *m = &mv;
+	const char *dp;
+	const char *endp;
+	const sopno gf = g->firststate+1;
+	const sopno gl = g->laststate;
+	const char *start;
+	const char *stop;
+	int error = 0;
+
+	_DIAGASSERT(g != NULL);
+	_DIAGASSERT(string != NULL);
+
+	if (g->cflags&REG_NOSUB)
+		nmatch = 0;
+	if (eflags&REG_STARTEND) {
+		_DIAGASSERT(pmatch != NULL);
+		start = string + (size_t)pmatch[0].rm_so;
+		stop = string + (size_t)pmatch[0].rm_eo;
+	} else {
+		start = string;
+		stop = start + strlen(start);
+	}
+	if (stop < start)
+		return(REG_INVARG);
+
+	if (g->must != NULL) {
+		for (dp = start; dp < stop; dp++)
+			if (*dp == g->must[0] && (size_t)(stop - dp) >= g->mlen &&
+				memcmp(dp, g->must, g->mlen) == 0)
+				break;
+		if (dp == stop)
+			return(REG_NOMATCH);
+	}
+
+	m->g = g;
+	m->eflags = eflags;
+	m->pmatch = NULL;
+	m->lastpos = NULL;
+	m->offp = string;
+	m->beginp = start;
+	m->endp = stop;
+	STATESETUP(m, 4);
+	SETUP(m->st);
+	SETUP(m->fresh);
+	SETUP(m->tmp);
+	SETUP(m->empty);
+	CLEAR(m->empty);
+
+	/* if another thread is using the DFA, build a private one */
+	if (pthread_mutex_trylock(&d->lock) == 0) {
+		c = &d->cache;
+	} else {
+		memset(&local, 0, sizeof(local));
+		local.max = d->cache.max * DFA_LOCALBYTES / DFA_MAXBYTES;
+		if (local.max < 4)
+			local.max = 4;
+		c = &local;
+	}
+	error = dfafast(m, d, c, start, stop);
+	if (c == &d->cache)
+		pthread_mutex_unlock(&d->lock);
+	else
+		dfafree(&local);
+	if (error != 0 || nmatch == 0)
+		goto done;
+
+	assert(m->coldp != NULL);
+	endp = tagslow(m, m->coldp, stop);
+	if (endp == NULL) {
+		error = REG_ESPACE;
+		goto done;
+	}
+	pmatch[0].rm_so = m->coldp - m->offp;
+	pmatch[0].rm_eo = endp - m->offp;
+	if (nmatch == 1)
+		goto done;
+
+	m->pmatch = (regmatch_t *)malloc((m->g->nsub + 1) * sizeof(regmatch_t));
+	if (m->pmatch == NULL) {
+		error = REG_ESPACE;
+		goto done;
+	}
+	for (i = 1; i <= m->g->nsub; i++)
+		m->pmatch[i].rm_so = m->pmatch[i].rm_eo = (regoff_t)-1;
+	dp = ldissect(m, m->coldp, endp, gf, gl);
+	assert(dp == endp);
+	for (i = 1; i < nmatch; i++)
+		if (i <= m->g->nsub)
+			pmatch[i] = m->pmatch[i];
+		else {
+			pmatch[i].rm_so = (regoff_t)-1;
+			pmatch[i].rm_eo = (regoff_t)-1;
+		}
+
+done:
+	if (m->pmatch != NULL) {
+		free(m->pmatch);
+		m->pmatch = NULL;
+	}
+	STATETEARDOWN(m);
+	return error;
+}
@@ -228,6 +228,7 @@ static int never = 0;		/* for use in asserts; shuts lint up */
  = #define	REG_NEWLINE	0010
  = #define	REG_NOSPEC	0020
  = #define	REG_PEND	0040
+ = #define	REG_LINEAR	0100
  = #define	REG_DUMP	0200
  */
 int				/* 0 success, otherwise REG_something */
@@ -298,6 +299,9 @@ regcomp(
 	g->categories = &g->catspace[-(CHAR_MIN)];
 	(void) memset((char *)g->catspace, 0, NC*sizeof(cat_t));
 	g->backrefs = 0;
+	/* BEGIN android-added */
+	g->dfa = NULL;
+	/* END android-added */
 
 	/* do it */
 	EMIT(OEND, 0);
@@ -325,6 +329,15 @@ regcomp(
 	if (g->iflags&BAD)
 		SETERROR(REG_ASSERT);
 #endif
+	/* BEGIN android-added */
+	/* back references are what make matching exponential */
+	if ((cflags&REG_LINEAR) && p->error == 0) {
+		if (g->backrefs)
+			SETERROR(REG_BADPAT);
+		else if ((g->dfa = __regdfa_alloc(g)) == NULL)
+			SETERROR(REG_ESPACE);
+	}
+	/* END android-added */
 
 	/* win or lose, we're done */
 	if (p->error != 0)	/* lose */
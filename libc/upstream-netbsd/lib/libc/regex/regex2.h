@@ -200,10 +200,20 @@ struct re_guts {
 	size_t nsub;		/* copy of re_nsub */
 	int backrefs;		/* does it use back references? */
 	sopno nplus;		/* how deep does it nest +s? */
+	/* BEGIN android-added */
+	struct re_dfa *dfa;	/* REG_LINEAR's lazy DFA, or NULL */
+	/* END android-added */
 	/* catspace must be last */
 	cat_t catspace[1];	/* actually [NC] */
 };
 
+/* BEGIN android-added */
+/* REG_LINEAR's DFA, from linear.c */
+struct re_dfa;
+__LIBC_HIDDEN__ struct re_dfa *__regdfa_alloc(struct re_guts *);
+__LIBC_HIDDEN__ void __regdfa_free(struct re_dfa *);
+/* END android-added */
+
 /* misc utilities */
 #define	OUT	(CHAR_MAX+1)	/* a non-character value */
 #define	ISWORD(c)	(isalnum((unsigned char)c) || (c) == '_')
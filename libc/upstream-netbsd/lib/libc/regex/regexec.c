@@ -93,6 +93,9 @@ __RCSID("$NetBSD: regexec.c,v 1.22 2012/03/13 21:13:43 christos Exp $");
 #include <assert.h>
 #include <ctype.h>
 #include <limits.h>
+/* BEGIN android-added */
+#include <pthread.h>
+/* END android-added */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -184,6 +187,10 @@ __weak_alias(regexec,_regexec)
 
 #include "engine.c"
 
+/* BEGIN android-added */
+#include "linear.c"
+/* END android-added */
+
 /*
  - regexec - interface for matching
  = extern int regexec(const regex_t *, const char *, size_t, \
@@ -227,6 +234,11 @@ regexec(
 
 	s = __UNCONST(string);
 
+	/* BEGIN android-added */
+	if (g->dfa != NULL)
+		return(linmatcher(g, s, nmatch, pmatch, eflags));
+	/* END android-added */
+
 	if (g->nstates <= (sopno)(CHAR_BIT*sizeof(states1)) && !(eflags&REG_LARGE))
 		return(smatcher(g, s, nmatch, pmatch, eflags));
 	else
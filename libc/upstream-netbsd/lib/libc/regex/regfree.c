@@ -125,5 +125,9 @@ regfree(
 		free(g->setbits);
 	if (g->must != NULL)
 		free(g->must);
+	/* BEGIN android-added */
+	if (g->dfa != NULL)
+		__regdfa_free(g->dfa);
+	/* END android-added */
 	free(g);
 }
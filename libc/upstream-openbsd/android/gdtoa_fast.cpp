@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gdtoa_fast.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// gdtoa does everything it can't do exactly in double arithmetic with Bigints. For
+// printf's fixed-precision conversions and for strtod of the numbers that printf
+// produces, the exact values involved almost always fit in 128 bits, so here we do
+// the same computations with integers. Anything that doesn't fit is left to gdtoa.
+
+#if defined(__SIZEOF_INT128__)
+
+typedef unsigned __int128 uint128_t;
+
+static const uint64_t kPowersOfTen[] = {
+  1ULL,
+  10ULL,
+  100ULL,
+  1000ULL,
+  10000ULL,
+  100000ULL,
+  1000000ULL,
+  10000000ULL,
+  100000000ULL,
+  1000000000ULL,
+  10000000000ULL,
+  100000000000ULL,
+  1000000000000ULL,
+  10000000000000ULL,
+  100000000000000ULL,
+  1000000000000000ULL,
+  10000000000000000ULL,
+  100000000000000000ULL,
+  1000000000000000000ULL,
+  10000000000000000000ULL,
+};
+
+// Returns 10^n for 0 <= n <= 38, which are exactly the powers of ten below 2^128.
+static inline uint128_t __pow10_128(int n) {
+  if (n <= 19) {
+    return kPowersOfTen[n];
+  }
+  return static_cast<uint128_t>(kPowersOfTen[19]) * kPowersOfTen[n - 19];
+}
+
+static inline int __clz128(uint128_t x) {
+  uint64_t hi = static_cast<uint64_t>(x >> 64);
+  return (hi != 0) ? __builtin_clzll(hi) : 64 + __builtin_clzll(static_cast<uint64_t>(x));
+}
+
+static inline uint64_t __double_bits(double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return bits;
+}
+
+static inline double __double_from_bits(uint64_t bits) {
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+// Writes the decimal digits of x > 0 so that they end just before end, and returns
+// a pointer to the first.
+static char* __u128_to_digits(uint128_t x, char* end) {
+  char* p = end;
+  while (x > UINT64_MAX) {
+    uint64_t chunk = static_cast<uint64_t>(x % kPowersOfTen[19]);
+    x /= kPowersOfTen[19];
+    for (int i = 0; i < 19; ++i) {
+      *--p = '0' + (chunk % 10);
+      chunk /= 10;
+    }
+  }
+  uint64_t lo = static_cast<uint64_t>(x);
+  do {
+    *--p = '0' + (lo % 10);
+    lo /= 10;
+  } while (lo != 0);
+  return p;
+}
+
+int __dtoa_fast(double d, int mode, int ndigits, char* buf, int* decpt) {
+  uint64_t bits = __double_bits(d);
+  int biased_exponent = static_cast<int>((bits >> 52) & 0x7ff);
+  // Zero, subnormals, infinities and NaNs (and negative numbers, which dtoa has
+  // already made positive) are all rare enough to leave to gdtoa.
+  if ((bits >> 63) != 0 || biased_exponent == 0 || biased_exponent == 0x7ff) {
+    return -1;
+  }
+  uint64_t m = (bits & ((1ULL << 52) - 1)) | (1ULL << 52);
+  int e2 = biased_exponent - 1075;
+  // Dropping trailing zero bits makes more values fit, notably integers.
+  int tz = __builtin_ctzll(m);
+  m >>= tz;
+  e2 += tz;
+
+  // We compute D = floor(d * 10^p) and the remainder R / den, with d * 10^p = num / den.
+  // For mode 3, p = ndigits puts the last wanted digit in D's units. For mode 2, we
+  // want ndigits significant digits, and k, an estimate of floor(log10(d)) that may be
+  // one too small, gives a D with either ndigits or ndigits + 1 digits.
+  int p;
+  if (mode == 2) {
+    if (ndigits <= 0) {
+      ndigits = 1;
+    }
+    int top_bit = e2 + (63 - __builtin_clzll(m));
+    int k = (top_bit * 78913) >> 18;  // floor(top_bit * log10(2)), for |top_bit| < 2^11.
+    p = ndigits - 1 - k;
+  } else if (mode == 3 && ndigits >= 0) {
+    p = ndigits;
+  } else {
+    return -1;
+  }
+
+  uint128_t num = m;
+  uint128_t den = 1;
+  int den_shift = 0;
+  if (e2 >= 0) {
+    if (e2 > __clz128(num)) {
+      return -1;
+    }
+    num <<= e2;
+  } else {
+    den_shift = -e2;
+    if (den_shift > 127) {
+      return -1;
+    }
+  }
+  if (p >= 0) {
+    if (p > 38 || __builtin_mul_overflow(num, __pow10_128(p), &num)) {
+      return -1;
+    }
+  } else {
+    if (-p > 38) {
+      return -1;
+    }
+    den = __pow10_128(-p);
+    if (den_shift != 0) {
+      if (den_shift > __clz128(den)) {
+        return -1;
+      }
+      den <<= den_shift;
+      den_shift = 0;
+    }
+  }
+
+  uint128_t digits;
+  uint128_t remainder;
+  uint128_t divisor;
+  if (den_shift != 0) {
+    divisor = static_cast<uint128_t>(1) << den_shift;
+    digits = num >> den_shift;
+    remainder = num & (divisor - 1);
+  } else {
+    divisor = den;
+    digits = num / den;
+    remainder = num % den;
+  }
+  if (digits == 0) {
+    // For mode 3, dtoa returns "" or "1" here. For mode 2, this can't happen.
+    return -1;
+  }
+
+  char tmp[DTOA_FAST_BUFSIZE];
+  char* end = tmp + sizeof(tmp);
+  int length = static_cast<int>(end - __u128_to_digits(digits, end));
+
+  // Round to nearest, ties to even, like gdtoa does in the default rounding mode.
+  bool round_up;
+  if (mode == 2 && length > ndigits) {
+    int last = static_cast<int>(digits % 10);
+    digits /= 10;
+    --p;
+    round_up = (last > 5) || (last == 5 && (remainder != 0 || (digits & 1) != 0));
+  } else {
+    uint128_t excess = divisor - remainder;
+    round_up = (remainder > excess) || (remainder == excess && (digits & 1) != 0);
+  }
+  if (round_up) {
+    ++digits;
+  }
+
+  char* first = __u128_to_digits(digits, end);
+  length = static_cast<int>(end - first);
+  *decpt = length - p;
+  while (end[-1] == '0') {
+    --end;
+    --length;
+  }
+  memcpy(buf, first, length);
+  buf[length] = '\0';
+  return length;
+}
+
+int __strtod_fast(const char* s00, char** endptr, double* result) {
+  const char* s = s00;
+  while (*s == ' ' || (*s >= '\t' && *s <= '\r')) {
+    ++s;
+  }
+  bool negative = false;
+  if (*s == '-' || *s == '+') {
+    negative = (*s++ == '-');
+  }
+  // Hex floats are gdtoa's problem.
+  if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+    return 0;
+  }
+
+  uint64_t mantissa = 0;
+  int significant_digits = 0;
+  int exponent = 0;
+  bool any_digits = false;
+  for (; *s >= '0' && *s <= '9'; ++s) {
+    any_digits = true;
+    if (mantissa == 0 && *s == '0') {
+      continue;
+    }
+    if (++significant_digits > 19) {
+      return 0;
+    }
+    mantissa = mantissa * 10 + (*s - '0');
+  }
+  if (*s == '.') {
+    for (++s; *s >= '0' && *s <= '9'; ++s) {
+      any_digits = true;
+      --exponent;
+      if (mantissa == 0 && *s == '0') {
+        continue;
+      }
+      if (++significant_digits > 19) {
+        return 0;
+      }
+      mantissa = mantissa * 10 + (*s - '0');
+    }
+  }
+  // Let gdtoa deal with malformed input, inf and nan.
+  if (!any_digits) {
+    return 0;
+  }
+
+  if (*s == 'e' || *s == 'E') {
+    const char* t = s + 1;
+    bool negative_exponent = false;
+    if (*t == '-' || *t == '+') {
+      negative_exponent = (*t++ == '-');
+    }
+    if (*t >= '0' && *t <= '9') {
+      int explicit_exponent = 0;
+      for (; *t >= '0' && *t <= '9'; ++t) {
+        if (explicit_exponent < 100000) {
+          explicit_exponent = explicit_exponent * 10 + (*t - '0');
+        }
+      }
+      exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+      s = t;
+    }
+  }
+
+  double value;
+  if (mantissa == 0) {
+    value = 0.0;
+  } else if (exponent >= 0) {
+    uint128_t x;
+    if (exponent > 38 || __builtin_mul_overflow(static_cast<uint128_t>(mantissa),
+                                                __pow10_128(exponent), &x)) {
+      return 0;
+    }
+    // The conversion rounds correctly.
+    value = static_cast<double>(x);
+  } else if (exponent >= -21) {
+    // With the mantissa shifted to the top, the quotient has at least 55 significant
+    // bits, so or-ing in a sticky bit for the remainder makes the conversion round
+    // the same way the exact quotient would.
+    int shift = __clz128(mantissa);
+    uint128_t x = static_cast<uint128_t>(mantissa) << shift;
+    uint128_t divisor = __pow10_128(-exponent);
+    uint128_t q = x / divisor;
+    if (x % divisor != 0) {
+      q |= 1;
+    }
+    // The result is at least 10^-21, so scaling by 2^-shift is exact.
+    value = static_cast<double>(q) * __double_from_bits(static_cast<uint64_t>(1023 - shift) << 52);
+  } else {
+    return 0;
+  }
+
+  *result = negative ? -value : value;
+  if (endptr != nullptr) {
+    *endptr = const_cast<char*>(s);
+  }
+  return 1;
+}
+
+#else
+
+int __dtoa_fast(double, int, int, char*, int*) {
+  return -1;
+}
+
+int __strtod_fast(const char*, char**, double*) {
+  return 0;
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GDTOA_FAST_H
+#define _GDTOA_FAST_H
+
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Exact fast paths for gdtoa's dtoa and strtod, for the inputs that fit in
+ * 128-bit integer arithmetic. They give the same results as gdtoa, and fail
+ * for everything else, so the callers can fall back to the Bigint code.
+ */
+
+#define DTOA_FAST_BUFSIZE 48
+
+/*
+ * Handles dtoa's modes 2 and 3 for positive normal d. On success, writes the
+ * NUL-terminated digits (with trailing zeros suppressed) to buf, sets *decpt
+ * and returns the number of digits. Returns -1 otherwise.
+ */
+__LIBC_HIDDEN__ int __dtoa_fast(double d, int mode, int ndigits, char* buf, int* decpt);
+
+/*
+ * Parses plain decimal numbers with at most 19 significant digits and a small
+ * exponent. Returns 1 and sets *result and *endptr (if non-null) on success,
+ * and returns 0 otherwise.
+ */
+__LIBC_HIDDEN__ int __strtod_fast(const char* s, char** endptr, double* result);
+
+__END_DECLS
+
+#endif
@@ -36,6 +36,10 @@
 #define KEYSTREAM_ONLY
 #include "chacha_private.h"
 
+/* BEGIN android-changed */
+#include "private/bionic_arc4random_tls.h"
+/* END android-changed */
+
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #ifdef __GNUC__
 #define inline __inline
@@ -175,21 +179,114 @@ _rs_random_u32(uint32_t *val)
 	rs->rs_have -= sizeof(*val);
 }
 
+/* BEGIN android-changed: per-thread generators */
+volatile unsigned _rs_fork_generation = 1;
+
+/*
+ * Each thread has its own generator, which takes its key from the
+ * shared one, so only keying takes _ARC4_LOCK. A fork child's threads
+ * rekey before their first use, like the shared generator does.
+ */
+static void
+_rs_thread_stir(struct bionic_arc4random_tls *ts)
+{
+	u_char rnd[KEYSZ + IVSZ];
+
+	_ARC4_LOCK();
+	_rs_random_buf(rnd, sizeof(rnd));
+	_ARC4_UNLOCK();
+
+	chacha_keysetup((chacha_ctx *)ts->chacha, rnd, KEYSZ * 8, 0);
+	chacha_ivsetup((chacha_ctx *)ts->chacha, rnd + KEYSZ);
+	explicit_bzero(rnd, sizeof(rnd));
+
+	ts->have = 0;
+	memset(ts->buf, 0, sizeof(ts->buf));
+	ts->count = 1600000;
+	ts->fork_generation = _rs_fork_generation;
+}
+
+static inline void
+_rs_thread_stir_if_needed(struct bionic_arc4random_tls *ts, size_t len)
+{
+	if (ts->fork_generation != _rs_fork_generation || ts->count <= len)
+		_rs_thread_stir(ts);
+	if (ts->count <= len)
+		ts->count = 0;
+	else
+		ts->count -= len;
+}
+
+static void
+_rs_thread_rekey(struct bionic_arc4random_tls *ts)
+{
+	chacha_encrypt_bytes((chacha_ctx *)ts->chacha, ts->buf, ts->buf,
+	    sizeof(ts->buf));
+	/* immediately reinit for backtracking resistance */
+	chacha_keysetup((chacha_ctx *)ts->chacha, ts->buf, KEYSZ * 8, 0);
+	chacha_ivsetup((chacha_ctx *)ts->chacha, ts->buf + KEYSZ);
+	memset(ts->buf, 0, KEYSZ + IVSZ);
+	ts->have = sizeof(ts->buf) - KEYSZ - IVSZ;
+}
+
+static void
+_rs_thread_random_buf(struct bionic_arc4random_tls *ts, void *_buf, size_t n)
+{
+	u_char *buf = (u_char *)_buf;
+	u_char *keystream;
+	size_t m;
+
+	_rs_thread_stir_if_needed(ts, n);
+	while (n > 0) {
+		if (ts->have > 0) {
+			m = min(n, ts->have);
+			keystream = ts->buf + sizeof(ts->buf) - ts->have;
+			memcpy(buf, keystream, m);
+			memset(keystream, 0, m);
+			buf += m;
+			n -= m;
+			ts->have -= m;
+		}
+		if (ts->have == 0)
+			_rs_thread_rekey(ts);
+	}
+}
+
 uint32_t
 arc4random(void)
 {
+	struct bionic_arc4random_tls *ts = __bionic_arc4random_tls();
+	u_char *keystream;
 	uint32_t val;
 
-	_ARC4_LOCK();
-	_rs_random_u32(&val);
-	_ARC4_UNLOCK();
+	if (ts == NULL) {
+		_ARC4_LOCK();
+		_rs_random_u32(&val);
+		_ARC4_UNLOCK();
+		return val;
+	}
+
+	_rs_thread_stir_if_needed(ts, sizeof(val));
+	if (ts->have < sizeof(val))
+		_rs_thread_rekey(ts);
+	keystream = ts->buf + sizeof(ts->buf) - ts->have;
+	memcpy(&val, keystream, sizeof(val));
+	memset(keystream, 0, sizeof(val));
+	ts->have -= sizeof(val);
 	return val;
 }
 
 void
 arc4random_buf(void *buf, size_t n)
 {
-	_ARC4_LOCK();
-	_rs_random_buf(buf, n);
-	_ARC4_UNLOCK();
+	struct bionic_arc4random_tls *ts = __bionic_arc4random_tls();
+
+	if (ts == NULL) {
+		_ARC4_LOCK();
+		_rs_random_buf(buf, n);
+		_ARC4_UNLOCK();
+		return;
+	}
+	_rs_thread_random_buf(ts, buf, n);
 }
+/* END android-changed */
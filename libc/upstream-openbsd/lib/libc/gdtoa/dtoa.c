@@ -30,6 +30,7 @@ THIS SOFTWARE.
  * with " at " changed at "@" and " dot " changed to ".").	*/
 
 #include "gdtoaimp.h"
+#include "gdtoa_fast.h"
 
 /* dtoa for IEEE arithmetic (dmg): convert double to ASCII string.
  *
@@ -127,6 +128,7 @@ dtoa
 	U d, d2, eps;
 	double ds;
 	char *s, *s0;
+	char fast_buf[DTOA_FAST_BUFSIZE];
 #ifdef SET_INEXACT
 	int inexact, oldinexact;
 #endif
@@ -182,6 +184,8 @@ dtoa
 		*decpt = 1;
 		return nrv_alloc("0", rve, 1);
 		}
+	if ((i = __dtoa_fast(dval(&d), mode, ndigits, fast_buf, decpt)) >= 0)
+		return nrv_alloc(fast_buf, rve, i);
 
 #ifdef SET_INEXACT
 	try_quick = oldinexact = get_inexact();
@@ -30,6 +30,7 @@ THIS SOFTWARE.
  * with " at " changed at "@" and " dot " changed to ".").	*/
 
 #include "gdtoaimp.h"
+#include "gdtoa_fast.h"
 #ifndef NO_FENV_H
 #include <fenv.h>
 #endif
@@ -140,6 +141,8 @@ strtod
 #endif /*}}*/
 #endif /*}*/
 
+	if (__strtod_fast(s00, se, &dval(&rv)))
+		return dval(&rv);
 	sign = nz0 = nz = decpt = 0;
 	dval(&rv) = 0.;
 	for(s = s00;;s++) switch(*s) {
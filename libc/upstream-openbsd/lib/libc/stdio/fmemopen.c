@@ -151,7 +151,7 @@ fmemopen(void *buf, size_t size, const char *mode)
 	if (buf == NULL) {
 		if ((st->string = malloc(size)) == NULL) {
 			free(st);
-			fp->_flags = 0;
+			__sfp_release(fp);
 			return (NULL);
 		}
 		*st->string = '\0';
@@ -68,8 +68,10 @@ __smakebuf(FILE *fp)
 	flags |= __SMBF;
 	fp->_bf._base = fp->_p = p;
 	fp->_bf._size = size;
-	if (couldbetty && isatty(fp->_file))
+	if (couldbetty && isatty(fp->_file)) {
 		flags |= __SLBF;
+		__sregister_line_buffered(fp);
+	}
 	fp->_flags |= flags;
 }
 
@@ -142,7 +142,7 @@ open_wmemstream(wchar_t **pbuf, size_t *psize)
 	st->size = BUFSIZ * sizeof(wchar_t);
 	if ((st->string = calloc(1, st->size)) == NULL) {
 		free(st);
-		fp->_flags = 0;
+		__sfp_release(fp);
 		return (NULL);
 	}
 
@@ -133,8 +133,10 @@ nbf:
 	/*
 	 * Fix up the FILE fields.
 	 */
-	if (mode == _IOLBF)
+	if (mode == _IOLBF) {
 		flags |= __SLBF;
+		__sregister_line_buffered(fp);
+	}
 	fp->_flags = flags;
 	fp->_bf._base = fp->_p = (unsigned char *)buf;
 	fp->_bf._size = size;
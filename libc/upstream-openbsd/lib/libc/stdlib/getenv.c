@@ -31,6 +31,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* BEGIN android-added */
+#include "private/bionic_env_index.h"
+/* END android-added */
+
 char *__findenv(const char *name, int len, int *offset);
 
 /*
@@ -74,8 +78,15 @@ getenv(const char *name)
 {
 	int offset = 0;
 	const char *np;
+	/* BEGIN android-added */
+	char *value;
+	/* END android-added */
 
 	for (np = name; *np && *np != '='; ++np)
 		;
+	/* BEGIN android-added */
+	if (__bionic_env_index_find(name, (size_t)(np - name), &value))
+		return (value);
+	/* END android-added */
 	return (__findenv(name, (int)(np - name), &offset));
 }
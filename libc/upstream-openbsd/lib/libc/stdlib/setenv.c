@@ -32,6 +32,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* BEGIN android-added */
+#include "private/bionic_env_index.h"
+/* END android-added */
+
 extern char **environ;
 static char **lastenv;				/* last value of environ */
 
@@ -53,6 +57,9 @@ putenv(char *str)
 		errno = EINVAL;
 		return (-1);			/* missing `=' in string */
 	}
+	/* BEGIN android-added */
+	__bionic_env_index_invalidate();
+	/* END android-added */
 
 	if (__findenv(str, (int)(cp - str), &offset) != NULL) {
 		environ[offset++] = str;
@@ -103,6 +110,9 @@ setenv(const char *name, const char *value, int rewrite)
 		errno = EINVAL;
 		return (-1);			/* has `=' in name */
 	}
+	/* BEGIN android-added */
+	__bionic_env_index_invalidate();
+	/* END android-added */
 
 	l_value = strlen(value);
 	if ((C = __findenv(name, (int)(np - name), &offset)) != NULL) {
@@ -169,6 +179,9 @@ unsetenv(const char *name)
 		errno = EINVAL;
 		return (-1);			/* has `=' in name */
 	}
+	/* BEGIN android-added */
+	__bionic_env_index_invalidate();
+	/* END android-added */
 
 	/* could be set multiple times */
 	while (__findenv(name, (int)(np - name), &offset)) {
@@ -97,6 +97,43 @@ void __loader_android_dlwarning(void* obj, void (*f)(void*, const char*));
 __attribute__((__weak__, visibility("default")))
 struct android_namespace_t* __loader_android_get_exported_namespace(const char* name);
 
+struct android_dlopen_stats;
+
+__attribute__((__weak__, visibility("default")))
+int __loader_android_iterate_dlopen_stats(
+    int (*cb)(const struct android_dlopen_stats* stats, void* data),
+    void* data);
+
+__attribute__((__weak__, visibility("default")))
+void __loader_android_trim_dlopen_caches();
+
+__attribute__((__weak__, visibility("default")))
+int __loader_android_dlsym_many(void* handle,
+                                const char* const symbols[],
+                                void* addresses[],
+                                size_t count,
+                                const void* caller_addr);
+
+struct android_linker_memory_stats;
+struct android_library_memory;
+
+__attribute__((__weak__, visibility("default")))
+void __loader_android_get_linker_memory_stats(struct android_linker_memory_stats* stats);
+
+__attribute__((__weak__, visibility("default")))
+int __loader_android_iterate_library_memory(
+    int (*cb)(const struct android_library_memory* memory, void* data),
+    void* data);
+
+__attribute__((__weak__, visibility("default")))
+void __loader_android_dump_linker_memory(int fd);
+
+__attribute__((__weak__, visibility("default")))
+void* __loader_android_dlsym_hashed(void* handle,
+                                    const char* symbol,
+                                    uint32_t gnu_hash,
+                                    const void* caller_addr);
+
 // Proxy calls to bionic loader
 void* dlopen(const char* filename, int flag) {
   const void* caller_addr = __builtin_return_address(0);
@@ -189,3 +226,36 @@ void android_dlwarning(void* obj, void (*f)(void*, const char*)) {
 struct android_namespace_t* android_get_exported_namespace(const char* name) {
   return __loader_android_get_exported_namespace(name);
 }
+
+int android_iterate_dlopen_stats(int (*cb)(const struct android_dlopen_stats* stats, void* data),
+                                 void* data) {
+  return __loader_android_iterate_dlopen_stats(cb, data);
+}
+
+void android_trim_dlopen_caches() {
+  __loader_android_trim_dlopen_caches();
+}
+
+int android_dlsym_many(void* handle, const char* const symbols[], void* addresses[], size_t count) {
+  const void* caller_addr = __builtin_return_address(0);
+  return __loader_android_dlsym_many(handle, symbols, addresses, count, caller_addr);
+}
+
+void android_get_linker_memory_stats(struct android_linker_memory_stats* stats) {
+  __loader_android_get_linker_memory_stats(stats);
+}
+
+int android_iterate_library_memory(
+    int (*cb)(const struct android_library_memory* memory, void* data),
+    void* data) {
+  return __loader_android_iterate_library_memory(cb, data);
+}
+
+void android_dump_linker_memory(int fd) {
+  __loader_android_dump_linker_memory(fd);
+}
+
+void* android_dlsym_hashed(void* handle, const char* symbol, uint32_t gnu_hash) {
+  const void* caller_addr = __builtin_return_address(0);
+  return __loader_android_dlsym_hashed(handle, symbol, gnu_hash, caller_addr);
+}
@@ -82,23 +82,33 @@ int
 feclearexcept(int excepts)
 {
   fenv_t fenv;
+  unsigned short status;
   unsigned int mxcsr;
 
   excepts &= FE_ALL_EXCEPT;
 
-  /* Store the current x87 floating-point environment */
-  __asm__ __volatile__ ("fnstenv %0" : "=m" (fenv));
+  /*
+   * Only go through the slow fnstenv/fldenv pair when one of the requested
+   * x87 flags is actually set.
+   */
+  __asm__ __volatile__ ("fnstsw %0" : "=am" (status));
+  if (status & excepts) {
+    /* Store the current x87 floating-point environment */
+    __asm__ __volatile__ ("fnstenv %0" : "=m" (fenv));
 
-  /* Clear the requested floating-point exceptions */
-  fenv.__x87.__status &= ~excepts;
+    /* Clear the requested floating-point exceptions */
+    fenv.__x87.__status &= ~excepts;
 
-  /* Load the x87 floating-point environent */
-  __asm__ __volatile__ ("fldenv %0" : : "m" (fenv));
+    /* Load the x87 floating-point environent */
+    __asm__ __volatile__ ("fldenv %0" : : "m" (fenv));
+  }
 
   /* Same for SSE environment */
   __asm__ __volatile__ ("stmxcsr %0" : "=m" (mxcsr));
-  mxcsr &= ~excepts;
-  __asm__ __volatile__ ("ldmxcsr %0" : : "m" (mxcsr));
+  if (mxcsr & excepts) {
+    mxcsr &= ~excepts;
+    __asm__ __volatile__ ("ldmxcsr %0" : : "m" (mxcsr));
+  }
 
   return (0);
 }
@@ -158,25 +168,32 @@ int
 fesetexceptflag(const fexcept_t *flagp, int excepts)
 {
   fenv_t fenv;
-  unsigned int mxcsr;
+  unsigned short status;
+  unsigned int mxcsr, new_mxcsr;
 
   excepts &= FE_ALL_EXCEPT;
 
-  /* Store the current x87 floating-point environment */
-  __asm__ __volatile__ ("fnstenv %0" : "=m" (fenv));
+  /* Skip the slow fnstenv/fldenv pair if the x87 flags already match */
+  __asm__ __volatile__ ("fnstsw %0" : "=am" (status));
+  if ((status & excepts) != (*flagp & excepts)) {
+    /* Store the current x87 floating-point environment */
+    __asm__ __volatile__ ("fnstenv %0" : "=m" (fenv));
 
-  /* Set the requested status flags */
-  fenv.__x87.__status &= ~excepts;
-  fenv.__x87.__status |= *flagp & excepts;
+    /* Set the requested status flags */
+    fenv.__x87.__status &= ~excepts;
+    fenv.__x87.__status |= *flagp & excepts;
 
-  /* Load the x87 floating-point environent */
-  __asm__ __volatile__ ("fldenv %0" : : "m" (fenv));
+    /* Load the x87 floating-point environent */
+    __asm__ __volatile__ ("fldenv %0" : : "m" (fenv));
+  }
 
   /* Same for SSE environment */
   __asm__ __volatile__ ("stmxcsr %0" : "=m" (mxcsr));
-  mxcsr &= ~excepts;
-  mxcsr |= *flagp & excepts;
-  __asm__ __volatile__ ("ldmxcsr %0" : : "m" (mxcsr));
+  new_mxcsr = mxcsr & ~excepts;
+  new_mxcsr |= *flagp & excepts;
+  if (new_mxcsr != mxcsr) {
+    __asm__ __volatile__ ("ldmxcsr %0" : : "m" (new_mxcsr));
+  }
 
   return (0);
 }
@@ -230,8 +247,8 @@ fegetround(void)
 int
 fesetround(int round)
 {
-  unsigned short control;
-  unsigned int mxcsr;
+  unsigned short control, new_control;
+  unsigned int mxcsr, new_mxcsr;
 
   /* Check whether requested rounding direction is supported */
   if (round & ~X87_ROUND_MASK)
@@ -240,18 +257,21 @@ fesetround(int round)
   /* Store the current x87 control word register */
   __asm__ __volatile__ ("fnstcw %0" : "=m" (control));
 
-  /* Set the rounding direction */
-  control &= ~X87_ROUND_MASK;
-  control |= round;
-
-  /* Load the x87 control word register */
-  __asm__ __volatile__ ("fldcw %0" : : "m" (control));
+  /* Set the rounding direction, if it isn't already the current one */
+  new_control = control & ~X87_ROUND_MASK;
+  new_control |= round;
+  if (new_control != control) {
+    /* Load the x87 control word register */
+    __asm__ __volatile__ ("fldcw %0" : : "m" (new_control));
+  }
 
   /* Same for the SSE environment */
   __asm__ __volatile__ ("stmxcsr %0" : "=m" (mxcsr));
-  mxcsr &= ~(X87_ROUND_MASK << SSE_ROUND_SHIFT);
-  mxcsr |= round << SSE_ROUND_SHIFT;
-  __asm__ __volatile__ ("ldmxcsr %0" : : "m" (mxcsr));
+  new_mxcsr = mxcsr & ~(X87_ROUND_MASK << SSE_ROUND_SHIFT);
+  new_mxcsr |= round << SSE_ROUND_SHIFT;
+  if (new_mxcsr != mxcsr) {
+    __asm__ __volatile__ ("ldmxcsr %0" : : "m" (new_mxcsr));
+  }
 
   return (0);
 }
@@ -309,8 +329,10 @@ feholdexcept(fenv_t *envp)
   /* Mask all exceptions */
   mxcsr |= FE_ALL_EXCEPT << SSE_MASK_SHIFT;
 
-  /* Store the MXCSR register */
-  __asm__ __volatile__ ("ldmxcsr %0" : : "m" (mxcsr));
+  /* Store the MXCSR register, unless that wouldn't change it */
+  if (mxcsr != envp->__mxcsr) {
+    __asm__ __volatile__ ("ldmxcsr %0" : : "m" (mxcsr));
+  }
 
   return (0);
 }
@@ -326,11 +348,28 @@ feholdexcept(fenv_t *envp)
 int
 fesetenv(const fenv_t *envp)
 {
-  /* Load the x87 floating-point environent */
-  __asm__ __volatile__ ("fldenv %0" : : "m" (*envp));
+  unsigned short control, status;
+  unsigned int mxcsr;
 
-  /* Store the MXCSR register */
-  __asm__ __volatile__ ("ldmxcsr %0" : : "m" (envp->__mxcsr));
+  /*
+   * fldenv and ldmxcsr are slow, and most callers restore an environment
+   * that is still current, so only load what has changed. The x87 register
+   * stack is empty across calls, so the control and status words are all
+   * of the x87 environment that matters here.
+   */
+  __asm__ __volatile__ ("fnstcw %0" : "=m" (control));
+  __asm__ __volatile__ ("fnstsw %0" : "=am" (status));
+  if (control != (unsigned short) envp->__x87.__control ||
+      status != (unsigned short) envp->__x87.__status) {
+    /* Load the x87 floating-point environent */
+    __asm__ __volatile__ ("fldenv %0" : : "m" (*envp));
+  }
+
+  __asm__ __volatile__ ("stmxcsr %0" : "=m" (mxcsr));
+  if (mxcsr != envp->__mxcsr) {
+    /* Store the MXCSR register */
+    __asm__ __volatile__ ("ldmxcsr %0" : : "m" (envp->__mxcsr));
+  }
 
   return (0);
 }
@@ -359,7 +398,8 @@ feupdateenv(const fenv_t *envp)
   fesetenv(envp);
 
   /* Raise any previously accumulated exceptions */
-  feraiseexcept(status | mxcsr);
+  if ((status | mxcsr) & FE_ALL_EXCEPT)
+    feraiseexcept(status | mxcsr);
 
   return (0);
 }
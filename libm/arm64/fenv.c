@@ -60,14 +60,22 @@ int fegetenv(fenv_t* envp) {
   return 0;
 }
 
+// Writes to FPCR and FPSR are much more expensive than reads, and callers
+// usually restore an environment that is still current, so the functions
+// below only write a register when its value actually changes.
+
 int fesetenv(const fenv_t* envp) {
   fpu_control_t fpcr;
+  fpu_status_t fpsr;
 
   __get_fpcr(fpcr);
   if (envp->__control != fpcr) {
     __set_fpcr(envp->__control);
   }
-  __set_fpsr(envp->__status);
+  __get_fpsr(fpsr);
+  if (envp->__status != fpsr) {
+    __set_fpsr(envp->__status);
+  }
   return 0;
 }
 
@@ -76,8 +84,9 @@ int feclearexcept(int excepts) {
 
   excepts &= FE_ALL_EXCEPT;
   __get_fpsr(fpsr);
-  fpsr &= ~excepts;
-  __set_fpsr(fpsr);
+  if (fpsr & excepts) {
+    __set_fpsr(fpsr & ~excepts);
+  }
   return 0;
 }
 
@@ -91,13 +100,15 @@ int fegetexceptflag(fexcept_t* flagp, int excepts) {
 }
 
 int fesetexceptflag(const fexcept_t* flagp, int excepts) {
-  fpu_status_t fpsr;
+  fpu_status_t fpsr, new_fpsr;
 
   excepts &= FE_ALL_EXCEPT;
   __get_fpsr(fpsr);
-  fpsr &= ~excepts;
-  fpsr |= *flagp & excepts;
-  __set_fpsr(fpsr);
+  new_fpsr = fpsr & ~excepts;
+  new_fpsr |= *flagp & excepts;
+  if (new_fpsr != fpsr) {
+    __set_fpsr(new_fpsr);
+  }
   return 0;
 }
 
@@ -154,13 +165,14 @@ int feholdexcept(fenv_t* envp) {
   }
 
   // Clear all exceptions.
-  fpsr &= ~FE_ALL_EXCEPT;
-  __set_fpsr(fpsr);
+  if (fpsr & FE_ALL_EXCEPT) {
+    __set_fpsr(fpsr & ~FE_ALL_EXCEPT);
+  }
   return 0;
 }
 
 int feupdateenv(const fenv_t* envp) {
-  fpu_status_t fpsr;
+  fpu_status_t fpsr, new_fpsr;
   fpu_control_t fpcr;
 
   // Set FPU Control register.
@@ -171,8 +183,10 @@ int feupdateenv(const fenv_t* envp) {
 
   // Set FPU Status register to status | currently raised exceptions.
   __get_fpsr(fpsr);
-  fpsr = envp->__status | (fpsr & FE_ALL_EXCEPT);
-  __set_fpsr(fpsr);
+  new_fpsr = envp->__status | (fpsr & FE_ALL_EXCEPT);
+  if (new_fpsr != fpsr) {
+    __set_fpsr(new_fpsr);
+  }
   return 0;
 }
 
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include "float_math.h"
+
+// expf(x) = 2^(x/ln2), computed in double with __exp2f_inline. The error is
+// below 0.51 ulp for results in the normal range.
+float expf(float x) {
+  uint32_t abstop = abstop12(x);
+  if (__predict_false(abstop >= abstop12(88.0f))) {
+    // |x| >= 88 or x is NaN.
+    if (asuint(x) == asuint(-INFINITY)) return 0.0f;
+    if (abstop >= abstop12(INFINITY)) return x + x;
+    if (x > 0x1.62e42ep6f) return __float_overflow(0);
+    if (x < -0x1.9fe368p6f) return __float_underflow(0);
+  }
+  return (float)__exp2f_inline((double)x * 0x1.71547652b82fep+0);
+}
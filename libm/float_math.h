@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BIONIC_LIBM_FLOAT_MATH_H_included
+#define _BIONIC_LIBM_FLOAT_MATH_H_included
+
+// Helpers shared by the float functions that are evaluated in double (expf.c,
+// logf.c and powf.c). Working in double leaves enough precision that small
+// tables and short polynomials give results within one ulp, without the
+// extra-precision tricks that float-only code needs.
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+static inline uint32_t asuint(float f) {
+  uint32_t i;
+  memcpy(&i, &f, sizeof(i));
+  return i;
+}
+
+static inline float asfloat(uint32_t i) {
+  float f;
+  memcpy(&f, &i, sizeof(f));
+  return f;
+}
+
+static inline uint64_t asuint64(double d) {
+  uint64_t i;
+  memcpy(&i, &d, sizeof(i));
+  return i;
+}
+
+static inline double asdouble(uint64_t i) {
+  double d;
+  memcpy(&d, &i, sizeof(d));
+  return d;
+}
+
+// These return results that raise the floating-point exceptions, which the
+// compiler would fold away if the operands were constants.
+static inline float __float_overflow(uint32_t sign) {
+  volatile float huge = sign ? -0x1p97f : 0x1p97f;
+  return huge * 0x1p97f;
+}
+
+static inline float __float_underflow(uint32_t sign) {
+  volatile float tiny = sign ? -0x1p-95f : 0x1p-95f;
+  return tiny * 0x1p-95f;
+}
+
+static inline float __float_divzero(uint32_t sign) {
+  volatile float zero = 0.0f;
+  return (sign ? -1.0f : 1.0f) / zero;
+}
+
+static inline float __float_invalid(float x) {
+  return (x - x) / (x - x);
+}
+
+// The exponent and top mantissa bits of a float, without the sign.
+static inline uint32_t abstop12(float x) {
+  return (asuint(x) >> 20) & 0x7ff;
+}
+
+// 2^(i/N) is table[i] + (i << 52)/N, so that adding k << (52 - bits) to an
+// entry gives 2^(k/N) for any k with k % N == i.
+#define EXP2F_TABLE_BITS 5
+#define EXP2F_N (1 << EXP2F_TABLE_BITS)
+__LIBC_HIDDEN__ extern const uint64_t __exp2f_table[EXP2F_N];
+
+// For x with -150 < x < 128, returns 2^x with a relative error below 2^-33.
+static inline double __exp2f_inline(double x) {
+  // Rounds x to a multiple of 1/N in kd, leaving the multiple in the low bits
+  // of ki.
+  const double shift = 0x1.8p+52 / EXP2F_N;
+  double kd = x + shift;
+  uint64_t ki = asuint64(kd);
+  kd -= shift;
+  double r = x - kd;  // |r| <= 1/(2N)
+
+  uint64_t t = __exp2f_table[ki % EXP2F_N];
+  t += ki << (52 - EXP2F_TABLE_BITS);
+  double s = asdouble(t);
+
+  // 2^r, |r| <= 1/64
+  double z = 0x1.c6af84c19a6c3p-5 * r + 0x1.ebfce50faf586p-3;
+  double r2 = r * r;
+  double y = 0x1.62e42ff0c5269p-1 * r + 1;
+  return (z * r2 + y) * s;
+}
+
+// log(x) = log(c) + log(x/c): the table splits [0x1.66p-1, 0x1.66p+0) into
+// N subintervals of z, each with 1/c for a c near its middle, so that
+// |z/c - 1| < 0x1.e6p-6. The subinterval containing 1.0 uses c = 1, so that
+// results near zero keep their relative accuracy.
+#define LOGF_TABLE_BITS 4
+#define LOGF_N (1 << LOGF_TABLE_BITS)
+#define LOGF_OFF 0x3f330000
+struct logf_entry {
+  double invc;
+  double logc;
+};
+__LIBC_HIDDEN__ extern const struct logf_entry __logf_table[LOGF_N];
+__LIBC_HIDDEN__ extern const struct logf_entry __log2f_table[LOGF_N];
+
+__END_DECLS
+
+#endif
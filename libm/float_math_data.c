@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "float_math.h"
+
+// See float_math.h for how these are used. They were generated with
+// arbitrary-precision arithmetic, and the polynomial coefficients in the
+// functions that use them are minimax fits for the reduced ranges that the
+// tables leave.
+
+const uint64_t __exp2f_table[EXP2F_N] = {
+  0x3ff0000000000000,
+  0x3fefd9b0d3158574,
+  0x3fefb5586cf9890f,
+  0x3fef9301d0125b51,
+  0x3fef72b83c7d517b,
+  0x3fef54873168b9aa,
+  0x3fef387a6e756238,
+  0x3fef1e9df51fdee1,
+  0x3fef06fe0a31b715,
+  0x3feef1a7373aa9cb,
+  0x3feedea64c123422,
+  0x3feece086061892d,
+  0x3feebfdad5362a27,
+  0x3feeb42b569d4f82,
+  0x3feeab07dd485429,
+  0x3feea47eb03a5585,
+  0x3feea09e667f3bcd,
+  0x3fee9f75e8ec5f74,
+  0x3feea11473eb0187,
+  0x3feea589994cce13,
+  0x3feeace5422aa0db,
+  0x3feeb737b0cdc5e5,
+  0x3feec49182a3f090,
+  0x3feed503b23e255d,
+  0x3feee89f995ad3ad,
+  0x3feeff76f2fb5e47,
+  0x3fef199bdd85529c,
+  0x3fef3720dcef9069,
+  0x3fef5818dcfba487,
+  0x3fef7c97337b9b5f,
+  0x3fefa4afa2a490da,
+  0x3fefd0765b6e4540,
+};
+
+// { 1/c, log(c) }
+const struct logf_entry __logf_table[LOGF_N] = {
+  { 0x1.661ec6a5122f9p+0, -0x1.57bf753c8d1fbp-2 },
+  { 0x1.571ed3c506b3ap+0, -0x1.2bef07cdc9355p-2 },
+  { 0x1.49539e3b2d067p+0, -0x1.01eae5626c691p-2 },
+  { 0x1.3c995a47babe7p+0, -0x1.b31d8575bce3bp-3 },
+  { 0x1.30d190130d190p+0, -0x1.6574ebe8c1339p-3 },
+  { 0x1.25e22708092f1p+0, -0x1.1aa2b7e23f729p-3 },
+  { 0x1.1bb4a4046ed29p+0, -0x1.a4e7640b1bc38p-4 },
+  { 0x1.12358e75d3033p+0, -0x1.1973bd1465561p-4 },
+  { 0x1.0953f39010954p+0, -0x1.252f32f8d1840p-5 },
+  { 0x1.0000000000000p+0, 0.0 },
+  { 0x1.e573ac901e574p-1, 0x1.b42dd711971b9p-5 },
+  { 0x1.ca4b3055ee191p-1, 0x1.c5e548f5bc743p-4 },
+  { 0x1.b2036406c80d9p-1, 0x1.526e5e3a1b438p-3 },
+  { 0x1.9c2d14ee4a102p-1, 0x1.bc286742d8cd4p-3 },
+  { 0x1.886e5f0abb04ap-1, 0x1.1058bf9ae4ad4p-2 },
+  { 0x1.767dce434a9b1p-1, 0x1.404308686a7e4p-2 },
+};
+
+// { 1/c, log2(c) }
+const struct logf_entry __log2f_table[LOGF_N] = {
+  { 0x1.661ec6a5122f9p+0, -0x1.efec61b011f85p-2 },
+  { 0x1.571ed3c506b3ap+0, -0x1.b0b67f4f46812p-2 },
+  { 0x1.49539e3b2d067p+0, -0x1.7418acebbf18fp-2 },
+  { 0x1.3c995a47babe7p+0, -0x1.39de8e1559f6ep-2 },
+  { 0x1.30d190130d190p+0, -0x1.01d9bbcfa61d4p-2 },
+  { 0x1.25e22708092f1p+0, -0x1.97c1cb13c7ec0p-3 },
+  { 0x1.1bb4a4046ed29p+0, -0x1.2f9e32d5bfdd1p-3 },
+  { 0x1.12358e75d3033p+0, -0x1.960caf9abb7c1p-4 },
+  { 0x1.0953f39010954p+0, -0x1.a6f9c377dd31dp-5 },
+  { 0x1.0000000000000p+0, 0.0 },
+  { 0x1.e573ac901e574p-1, 0x1.3aa2fdd27f1bfp-4 },
+  { 0x1.ca4b3055ee191p-1, 0x1.476a9f983f74dp-3 },
+  { 0x1.b2036406c80d9p-1, 0x1.e840be74e6a4dp-3 },
+  { 0x1.9c2d14ee4a102p-1, 0x1.406463b1b0448p-2 },
+  { 0x1.886e5f0abb04ap-1, 0x1.88e9c72e0b224p-2 },
+  { 0x1.767dce434a9b1p-1, 0x1.ce0a4923a587dp-2 },
+};
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include "float_math.h"
+
+// logf(x) = k*ln2 + log(c) + log(z/c), with x = 2^k * z and c from
+// __logf_table. The error is below 0.51 ulp.
+float logf(float x) {
+  uint32_t ix = asuint(x);
+  // x < 0x1p-126, or x is infinite or NaN.
+  if (__predict_false(ix - 0x00800000 >= 0x7f800000 - 0x00800000)) {
+    if (ix * 2 == 0) return __float_divzero(1);
+    if (ix == 0x7f800000) return x;  // log(inf) == inf.
+    if ((ix & 0x80000000) || ix * 2 >= 0xff000000) return __float_invalid(x);
+    // Normalize subnormals.
+    ix = asuint(x * 0x1p23f);
+    ix -= 23 << 23;
+  }
+
+  // x = 2^k * z, with z in [LOGF_OFF, 2*LOGF_OFF) and exactly representable.
+  uint32_t tmp = ix - LOGF_OFF;
+  uint32_t i = (tmp >> (23 - LOGF_TABLE_BITS)) % LOGF_N;
+  int32_t k = (int32_t)tmp >> 23;
+  uint32_t iz = ix - (tmp & 0xff800000);
+  double invc = __logf_table[i].invc;
+  double logc = __logf_table[i].logc;
+  double z = (double)asfloat(iz);
+
+  // log(x) = log1p(z/c - 1) + log(c) + k*ln2
+  double r = z * invc - 1;
+  double y0 = logc + (double)k * 0x1.62e42fefa39efp-1;
+
+  // log1p(r) - r, |r| < 0x1.e6p-6
+  double r2 = r * r;
+  double y = 0x1.99f6b710965c5p-3 * r + -0x1.002fee3a791e3p-2;
+  double p = 0x1.555551fdac358p-2 * r + -0x1.fffffd501382cp-2;
+  y = y * r2 + p;
+  y = y * r2 + (y0 + r);
+  return (float)y;
+}
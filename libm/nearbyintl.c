@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <fenv.h>
+#include <math.h>
+
+// nearbyintl from s_nearbyint.c, for architectures that have their own
+// nearbyint and nearbyintf.
+long double nearbyintl(long double x) {
+  // rintl's only exception is FE_INEXACT. If that's already raised, there's
+  // nothing to hide, so skip saving and restoring the environment.
+  if (fetestexcept(FE_INEXACT)) {
+    return rintl(x);
+  }
+
+  // As in s_nearbyint.c, volatile stops the compiler assuming that rintl
+  // doesn't touch the floating-point environment.
+  volatile long double ret;
+  fenv_t env;
+  fegetenv(&env);
+  ret = rintl(x);
+  fesetenv(&env);
+  return ret;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include "float_math.h"
+
+// Returns 0 if y is not an integer, 1 if it is odd, and 2 if it is even.
+static inline int checkint(uint32_t iy) {
+  int e = iy >> 23 & 0xff;
+  if (e < 0x7f) return 0;
+  if (e > 0x7f + 23) return 2;
+  if (iy & ((1 << (0x7f + 23 - e)) - 1)) return 0;
+  if (iy & (1 << (0x7f + 23 - e))) return 1;
+  return 2;
+}
+
+// Whether x is 0, infinite or NaN.
+static inline int zeroinfnan(uint32_t ix) {
+  return 2 * ix - 1 >= 2u * 0x7f800000 - 1;
+}
+
+// log2(x) for positive normal x, with a relative error below 2^-32 in the
+// part that doesn't come from the table.
+static inline double log2_inline(uint32_t ix) {
+  // x = 2^k * z, with z in [LOGF_OFF, 2*LOGF_OFF) and exactly representable.
+  uint32_t tmp = ix - LOGF_OFF;
+  uint32_t i = (tmp >> (23 - LOGF_TABLE_BITS)) % LOGF_N;
+  uint32_t top = tmp & 0xff800000;
+  uint32_t iz = ix - top;
+  int32_t k = (int32_t)top >> 23;
+  double invc = __log2f_table[i].invc;
+  double logc = __log2f_table[i].logc;
+  double z = (double)asfloat(iz);
+
+  // log2(x) = log2(1 + r) + log2(c) + k, with r = z/c - 1
+  double r = z * invc - 1;
+  double y0 = logc + (double)k;
+
+  // log2(1 + r), |r| < 0x1.e6p-6
+  double r2 = r * r;
+  double y = 0x1.27bc077deff0cp-2 * r + -0x1.7199ae8387b0dp-2;
+  double p = 0x1.ec709832be721p-2 * r + -0x1.71547460c7b83p-1;
+  double r4 = r2 * r2;
+  double q = 0x1.71547652bc336p+0 * r + y0;
+  q = p * r2 + q;
+  return y * r4 + q;
+}
+
+// powf(x, y) = 2^(y*log2(x)), computed in double. The error is below 1 ulp
+// for results in the normal range, and exact results are exact.
+float powf(float x, float y) {
+  uint32_t sign = 0;
+  uint32_t ix = asuint(x);
+  uint32_t iy = asuint(y);
+  // x < 0x1p-126, or x is infinite or NaN, or y is 0, infinite or NaN.
+  if (__predict_false(ix - 0x00800000 >= 0x7f800000 - 0x00800000 || zeroinfnan(iy))) {
+    if (__predict_false(zeroinfnan(iy))) {
+      if (2 * iy == 0) return 1.0f;
+      if (ix == 0x3f800000) return 1.0f;
+      if (2 * ix > 2u * 0x7f800000 || 2 * iy > 2u * 0x7f800000) return x + y;
+      if (2 * ix == 2 * 0x3f800000) return 1.0f;
+      if ((2 * ix < 2 * 0x3f800000) == !(iy & 0x80000000)) {
+        return 0.0f;  // |x| < 1 and y is inf, or |x| > 1 and y is -inf.
+      }
+      return y * y;
+    }
+    if (zeroinfnan(ix)) {
+      float x2 = x * x;
+      if ((ix & 0x80000000) && checkint(iy) == 1) x2 = -x2;
+      return (iy & 0x80000000) ? 1 / x2 : x2;
+    }
+    // x and y are finite and nonzero.
+    if (ix & 0x80000000) {
+      // Negative x.
+      int yint = checkint(iy);
+      if (yint == 0) return __float_invalid(x);
+      if (yint == 1) sign = 1;
+      ix &= 0x7fffffff;
+    }
+    if (ix < 0x00800000) {
+      // Normalize subnormals.
+      ix = asuint(asfloat(ix) * 0x1p23f);
+      ix -= 23 << 23;
+    }
+  }
+
+  double ylogx = (double)y * log2_inline(ix);
+  if (__predict_false((asuint64(ylogx) >> 47 & 0xffff) >= asuint64(126.0) >> 47)) {
+    // |y*log2(x)| >= 126
+    if (ylogx > 0x1.fffffffd1d571p+6) return __float_overflow(sign);
+    if (ylogx <= -150.0) return __float_underflow(sign);
+  }
+  float result = (float)__exp2f_inline(ylogx);
+  return sign ? -result : result;
+}
@@ -27,12 +27,18 @@
 #define _GNU_SOURCE 1
 #include <math.h>
 
-// Disable sincos optimization for all functions in this file,
-// otherwise gcc would generate infinite calls.
+#if defined(__i386__) || defined(__x86_64__)
+
+// sin and cos are Intel's assembler on x86, so keep sincos consistent with
+// them rather than using the FreeBSD kernels below.
+
+// Disable sincos optimization for this function, otherwise gcc would
+// generate infinite calls.
 // Refer to gcc PR46926.
 // -fno-builtin-sin or -fno-builtin-cos can disable sincos optimization,
 // but these two options do not work inside optimize pragma in-file.
-// Thus we just enforce -O0 when compiling this file.
+// Thus we just enforce -O0 when compiling this function.
+#pragma GCC push_options
 #pragma GCC optimize ("O0")
 
 void sincos(double x, double* p_sin, double* p_cos) {
@@ -40,12 +46,99 @@ void sincos(double x, double* p_sin, double* p_cos) {
   *p_cos = cos(x);
 }
 
-void sincosf(float x, float* p_sinf, float* p_cosf) {
-  *p_sinf = sinf(x);
-  *p_cosf = cosf(x);
+#pragma GCC pop_options
+
+#else
+
+#define INLINE_REM_PIO2
+#include "math_private.h"
+#include "e_rem_pio2.c"
+
+// The coefficients of __kernel_sin and __kernel_cos (k_sin.c and k_cos.c).
+static const double
+half = 5.00000000000000000000e-01,
+S1 = -1.66666666666666324348e-01,
+S2 =  8.33333333332248946124e-03,
+S3 = -1.98412698298579493134e-04,
+S4 =  2.75573137070700676789e-06,
+S5 = -2.50507602534068634195e-08,
+S6 =  1.58969099521155010221e-10,
+C1 =  4.16666666666666019037e-02,
+C2 = -1.38888888888741095749e-03,
+C3 =  2.48015872894767294178e-05,
+C4 = -2.75573143513906633035e-07,
+C5 =  2.08757232129817482790e-09,
+C6 = -1.13596475577881948265e-11;
+
+// __kernel_sin(x, y, iy) and __kernel_cos(x, y) evaluated together, sharing
+// z = x*x and its powers. The expressions are exactly those of the two
+// kernels, so the results are identical to calling each of them.
+static inline void kernel_sincos(double x, double y, int iy, double* sn, double* cs) {
+  double hz, r, v, w, z;
+
+  z = x * x;
+  w = z * z;
+  r = S2 + z * (S3 + z * S4) + z * w * (S5 + z * S6);
+  v = z * x;
+  if (iy == 0) {
+    *sn = x + v * (S1 + z * r);
+  } else {
+    *sn = x - ((z * (half * y - v * r) - y) - v * S1);
+  }
+
+  r = z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6));
+  hz = 0.5 * z;
+  w = 1.0 - hz;
+  *cs = w + (((1.0 - w) - hz) + (z * r - x * y));
 }
 
-void sincosl(long double x, long double* p_sinl, long double* p_cosl) {
-  *p_sinl = sinl(x);
-  *p_cosl = cosl(x);
+// Like sin and cos (s_sin.c and s_cos.c), but with a single argument
+// reduction and kernel evaluation for both results.
+void sincos(double x, double* p_sin, double* p_cos) {
+  double y[2], s, c;
+  int32_t n, ix;
+
+  GET_HIGH_WORD(ix, x);
+  ix &= 0x7fffffff;
+
+  // |x| ~< pi/4
+  if (ix <= 0x3fe921fb) {
+    // |x| < 2**-27 * sqrt(2): sin(x) = x and cos(x) = 1, inexact if x != 0.
+    if (ix < 0x3e46a09e && (int) x == 0) {
+      *p_sin = x;
+      *p_cos = 1.0;
+      return;
+    }
+    kernel_sincos(x, 0.0, 0, p_sin, p_cos);
+    return;
+  }
+
+  // sin(Inf or NaN) and cos(Inf or NaN) are NaN.
+  if (ix >= 0x7ff00000) {
+    *p_sin = *p_cos = x - x;
+    return;
+  }
+
+  n = __ieee754_rem_pio2(x, y);
+  kernel_sincos(y[0], y[1], 1, &s, &c);
+  switch (n & 3) {
+    case 0:
+      *p_sin = s;
+      *p_cos = c;
+      break;
+    case 1:
+      *p_sin = c;
+      *p_cos = -s;
+      break;
+    case 2:
+      *p_sin = -s;
+      *p_cos = -c;
+      break;
+    default:
+      *p_sin = -c;
+      *p_cos = s;
+      break;
+  }
 }
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define _GNU_SOURCE 1
+#include <math.h>
+
+#define INLINE_KERNEL_COSDF
+#define INLINE_KERNEL_SINDF
+#define INLINE_REM_PIO2F
+#include "math_private.h"
+#include "e_rem_pio2f.c"
+#include "k_cosf.c"
+#include "k_sinf.c"
+
+// Small multiples of pi/2 rounded to double precision, as in s_sinf.c.
+static const double
+p1pio2 = 1*M_PI_2,
+p2pio2 = 2*M_PI_2,
+p3pio2 = 3*M_PI_2,
+p4pio2 = 4*M_PI_2;
+
+// __kernel_sindf and __kernel_cosdf evaluated together, sharing z = x*x and
+// its powers. The expressions are exactly those of k_sinf.c and k_cosf.c.
+static inline void kernel_sincosdf(double x, float* sn, float* cs) {
+  double r, s, w, z;
+
+  z = x * x;
+  w = z * z;
+  r = S3 + z * S4;
+  s = z * x;
+  *sn = (x + s * (S1 + z * S2)) + s * w * r;
+  r = C2 + z * C3;
+  *cs = ((one + z * C0) + w * C1) + (w * z) * r;
+}
+
+// Like sinf and cosf (s_sinf.c and s_cosf.c), but with a single argument
+// reduction and kernel evaluation for both results. The kernels are odd and
+// even respectively, so the results are identical to sinf and cosf.
+void sincosf(float x, float* p_sinf, float* p_cosf) {
+  float s, c;
+  double y;
+  int32_t n, hx, ix;
+
+  GET_FLOAT_WORD(hx, x);
+  ix = hx & 0x7fffffff;
+
+  // |x| ~<= pi/4
+  if (ix <= 0x3f490fda) {
+    // |x| < 2**-12: sin(x) = x and cos(x) = 1, inexact if x != 0.
+    if (ix < 0x39800000 && (int) x == 0) {
+      *p_sinf = x;
+      *p_cosf = 1.0f;
+      return;
+    }
+    kernel_sincosdf(x, p_sinf, p_cosf);
+    return;
+  }
+
+  // |x| ~<= 5*pi/4
+  if (ix <= 0x407b53d1) {
+    if (ix <= 0x4016cbe3) {
+      // |x| ~<= 3*pi/4
+      if (hx > 0) {
+        kernel_sincosdf(x - p1pio2, p_cosf, p_sinf);
+        *p_cosf = -*p_cosf;
+      } else {
+        kernel_sincosdf(x + p1pio2, p_cosf, p_sinf);
+        *p_sinf = -*p_sinf;
+      }
+    } else {
+      kernel_sincosdf(hx > 0 ? x - p2pio2 : x + p2pio2, p_sinf, p_cosf);
+      *p_sinf = -*p_sinf;
+      *p_cosf = -*p_cosf;
+    }
+    return;
+  }
+
+  // |x| ~<= 9*pi/4
+  if (ix <= 0x40e231d5) {
+    if (ix <= 0x40afeddf) {
+      // |x| ~<= 7*pi/4
+      if (hx > 0) {
+        kernel_sincosdf(x - p3pio2, p_cosf, p_sinf);
+        *p_sinf = -*p_sinf;
+      } else {
+        kernel_sincosdf(x + p3pio2, p_cosf, p_sinf);
+        *p_cosf = -*p_cosf;
+      }
+    } else {
+      kernel_sincosdf(hx > 0 ? x - p4pio2 : x + p4pio2, p_sinf, p_cosf);
+    }
+    return;
+  }
+
+  // sinf(Inf or NaN) and cosf(Inf or NaN) are NaN.
+  if (ix >= 0x7f800000) {
+    *p_sinf = *p_cosf = x - x;
+    return;
+  }
+
+  n = __ieee754_rem_pio2f(x, &y);
+  kernel_sincosdf(y, &s, &c);
+  switch (n & 3) {
+    case 0:
+      *p_sinf = s;
+      *p_cosf = c;
+      break;
+    case 1:
+      *p_sinf = c;
+      *p_cosf = -s;
+      break;
+    case 2:
+      *p_sinf = -s;
+      *p_cosf = -c;
+      break;
+    default:
+      *p_sinf = -c;
+      *p_cosf = s;
+      break;
+  }
+}
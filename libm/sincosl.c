@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define _GNU_SOURCE 1
+#include <float.h>
+#include <math.h>
+
+#include "math_private.h"
+#include "fpmath.h"
+#include "e_rem_pio2l.h"
+
+// Like sinl and cosl (s_sinl.c and s_cosl.c), but with a single argument
+// reduction for both results.
+void sincosl(long double x, long double* p_sinl, long double* p_cosl) {
+  union IEEEl2bits z;
+  int e0, sign;
+  long double y[2];
+  long double s, c;
+
+  z.e = x;
+  sign = z.bits.sign;
+  z.bits.sign = 0;
+
+  // If x = +-0 or x is a subnormal number, then sin(x) = x and cos(x) = 1.
+  if (z.bits.exp == 0) {
+    *p_sinl = x;
+    *p_cosl = 1.0;
+    return;
+  }
+
+  // If x = NaN or Inf, then sin(x) and cos(x) are NaN.
+  if (z.bits.exp == 32767) {
+    *p_sinl = *p_cosl = (x - x) / (x - x);
+    return;
+  }
+
+  // Optimize the case where x is already within range.
+  if (z.e < M_PI_4) {
+    s = __kernel_sinl(z.e, 0, 0);
+    *p_sinl = sign ? -s : s;
+    *p_cosl = __kernel_cosl(z.e, 0);
+    return;
+  }
+
+  e0 = __ieee754_rem_pio2l(x, y);
+  s = __kernel_sinl(y[0], y[1], 1);
+  c = __kernel_cosl(y[0], y[1]);
+  switch (e0 & 3) {
+    case 0:
+      *p_sinl = s;
+      *p_cosl = c;
+      break;
+    case 1:
+      *p_sinl = c;
+      *p_cosl = -s;
+      break;
+    case 2:
+      *p_sinl = -s;
+      *p_cosl = -c;
+      break;
+    default:
+      *p_sinl = -c;
+      *p_cosl = s;
+      break;
+  }
+}
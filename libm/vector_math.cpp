@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Vector variants of sin, cos, exp and log (and their float versions), named
+// as the x86-64 and AArch64 vector function ABIs require, so that compilers
+// told about them (GCC's simd attribute, or clang's -fveclib=libmvec) can call
+// them from vectorized loops.
+//
+// Each variant computes every lane with the same straight-line code, and
+// recomputes lanes it can't handle (large arguments, infinities, NaNs,
+// subnormals, results that would overflow or underflow) with the scalar
+// function, so those lanes get exactly the scalar result and errno behavior.
+// The other lanes are accurate to a few ulp, rather than the scalar
+// functions' one.
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || (defined(__aarch64__) && __has_attribute(aarch64_vector_pcs))
+
+#define ALWAYS_INLINE inline __attribute__((__always_inline__))
+
+typedef float f32x2 __attribute__((__vector_size__(8)));
+typedef uint32_t u32x2 __attribute__((__vector_size__(8)));
+typedef int32_t i32x2 __attribute__((__vector_size__(8)));
+typedef float f32x4 __attribute__((__vector_size__(16)));
+typedef uint32_t u32x4 __attribute__((__vector_size__(16)));
+typedef int32_t i32x4 __attribute__((__vector_size__(16)));
+typedef float f32x8 __attribute__((__vector_size__(32)));
+typedef uint32_t u32x8 __attribute__((__vector_size__(32)));
+typedef int32_t i32x8 __attribute__((__vector_size__(32)));
+typedef float f32x16 __attribute__((__vector_size__(64)));
+typedef uint32_t u32x16 __attribute__((__vector_size__(64)));
+typedef int32_t i32x16 __attribute__((__vector_size__(64)));
+typedef double f64x2 __attribute__((__vector_size__(16)));
+typedef uint64_t u64x2 __attribute__((__vector_size__(16)));
+typedef int64_t i64x2 __attribute__((__vector_size__(16)));
+typedef double f64x4 __attribute__((__vector_size__(32)));
+typedef uint64_t u64x4 __attribute__((__vector_size__(32)));
+typedef int64_t i64x4 __attribute__((__vector_size__(32)));
+typedef double f64x8 __attribute__((__vector_size__(64)));
+typedef uint64_t u64x8 __attribute__((__vector_size__(64)));
+typedef int64_t i64x8 __attribute__((__vector_size__(64)));
+
+template <typename V> struct VecTraits;
+#define VEC_TRAITS(V, S, U_, I_, N_) \
+  template <> struct VecTraits<V> { typedef S F; typedef U_ U; typedef I_ I; static const int N = N_; }
+VEC_TRAITS(f32x2, float, u32x2, i32x2, 2);
+VEC_TRAITS(f32x4, float, u32x4, i32x4, 4);
+VEC_TRAITS(f32x8, float, u32x8, i32x8, 8);
+VEC_TRAITS(f32x16, float, u32x16, i32x16, 16);
+VEC_TRAITS(f64x2, double, u64x2, i64x2, 2);
+VEC_TRAITS(f64x4, double, u64x4, i64x4, 4);
+VEC_TRAITS(f64x8, double, u64x8, i64x8, 8);
+#undef VEC_TRAITS
+
+template <typename To, typename From> static ALWAYS_INLINE To as(From v) {
+  static_assert(sizeof(To) == sizeof(From), "bit casts must not change the size");
+  To result;
+  memcpy(&result, &v, sizeof(result));
+  return result;
+}
+
+// Vector comparisons produce all-ones lanes where they hold; this returns them
+// as the unsigned vector type so that they can be used as bit masks.
+template <typename V, typename M> static ALWAYS_INLINE typename VecTraits<V>::U mask(M m) {
+  return as<typename VecTraits<V>::U>(m);
+}
+
+template <typename V> static ALWAYS_INLINE V vabs(V x) {
+  typedef typename VecTraits<V>::U U;
+  // -V{} has only the sign bits set.
+  return as<V>(as<U>(x) & ~as<U>(-V{}));
+}
+
+template <typename V, typename U> static ALWAYS_INLINE V select(U m, V a, V b) {
+  return as<V>((as<U>(a) & m) | (as<U>(b) & ~m));
+}
+
+template <typename U> static ALWAYS_INLINE bool any(U m) {
+  for (size_t i = 0; i < sizeof(m) / sizeof(m[0]); ++i) {
+    if (m[i]) return true;
+  }
+  return false;
+}
+
+// Replaces the lanes selected by 'special' with the scalar function's result.
+template <typename V> static ALWAYS_INLINE V fix_special(
+    V x, V result, typename VecTraits<V>::U special,
+    typename VecTraits<V>::F (*fn)(typename VecTraits<V>::F)) {
+  if (__builtin_expect(any(special), 0)) {
+    for (int i = 0; i < VecTraits<V>::N; ++i) {
+      if (special[i]) result[i] = fn(x[i]);
+    }
+  }
+  return result;
+}
+
+// expf: exp(x) = 2^n * exp(r), with n = round(x/ln2) and |r| <= ln2/2.
+template <typename V> static ALWAYS_INLINE V v_expf(V x) {
+  typedef typename VecTraits<V>::U U;
+  const float kShift = 0x1.8p23f;
+
+  V z = x * 0x1.715476p+0f + kShift;
+  V n = z - kShift;
+  V r = x - n * 0x1.62e4p-1f - n * 0x1.7f7d1cp-20f;
+  // The low bits of z hold n, so shifting them into the exponent scales 1.0.
+  V scale = as<V>((as<U>(z) << 23) + 0x3f800000);
+
+  V r2 = r * r;
+  V p = r * 0x1.0e4020p-7f + 0x1.573e2ep-5f;
+  V q = r * 0x1.555e66p-3f + 0x1.fffdb6p-2f;
+  q = p * r2 + q;
+  V poly = q * r2 + r * 0x1.ffffecp-1f;
+  V result = scale + scale * poly;
+
+  // Beyond this, 2^n isn't a normal float (and NaN fails the comparison).
+  U special = ~mask<V>(vabs(x) <= 87.0f);
+  return fix_special(x, result, special, expf);
+}
+
+// logf: log(x) = n*ln2 + log1p(r), with x = 2^n * (1 + r) and 1 + r in
+// [2/3, 4/3).
+template <typename V> static ALWAYS_INLINE V v_logf(V x) {
+  typedef typename VecTraits<V>::U U;
+  typedef typename VecTraits<V>::I I;
+  const uint32_t kOff = 0x3f2aaaab;
+
+  U u = as<U>(x);
+  // Zero, negative, subnormal, infinite and NaN inputs.
+  U special = mask<V>(u - 0x00800000 >= 0x7f800000 - 0x00800000);
+
+  u -= kOff;
+  V n = __builtin_convertvector(as<I>(u) >> 23, V);
+  V r = as<V>((u & 0x007fffff) + kOff) - 1.0f;
+
+  V r2 = r * r;
+  V y = r * -0x1.3e737cp-3f + 0x1.5a9aa2p-3f;
+  V y2 = r * -0x1.4f9934p-3f + 0x1.961348p-3f;
+  y = y * r2 + y2;
+  y2 = r * -0x1.00187cp-2f + 0x1.555d7cp-2f;
+  y = y * r2 + y2;
+  y = y * r + -0x1.ffffc8p-2f;
+  V result = y * r2 + (n * 0x1.62e43p-1f + r);
+
+  return fix_special(x, result, special, logf);
+}
+
+// sinf/cosf: x = n*pi + r, with |r| <= pi/2, and sin(x) = (-1)^n * sin(r).
+// cos(x) is computed as sin(x + pi/2), with n odd multiples of pi/2.
+template <typename V> static ALWAYS_INLINE V v_sinf_reduced(V r, typename VecTraits<V>::U sign,
+                                                           V n) {
+  typedef typename VecTraits<V>::U U;
+  // pi split so that n times each part but the last is exact for |n| < 2^13.
+  r = r - n * 0x1.92p+1f;
+  r = r - n * 0x1.fb4p-11f;
+  r = r - n * 0x1.444p-23f;
+  r = r - n * 0x1.68c234p-38f;
+
+  V r2 = r * r;
+  V y = r2 * 0x1.5b2e76p-19f + -0x1.9f42eap-13f;
+  y = y * r2 + 0x1.110df4p-7f;
+  y = y * r2 + -0x1.555548p-3f;
+  y = (y * r2) * r + r;
+  return as<V>(as<U>(y) ^ sign);
+}
+
+template <typename V> static ALWAYS_INLINE V v_sinf(V x) {
+  typedef typename VecTraits<V>::U U;
+  const float kShift = 0x1.8p23f;
+
+  V r = vabs(x);
+  U sign = as<U>(x) ^ as<U>(r);
+  V z = r * 0x1.45f306p-2f + kShift;
+  sign ^= as<U>(z) << 31;
+  V n = z - kShift;
+  V result = v_sinf_reduced(r, sign, n);
+
+  U special = ~mask<V>(r < 0x1p12f);
+  return fix_special(x, result, special, sinf);
+}
+
+template <typename V> static ALWAYS_INLINE V v_cosf(V x) {
+  typedef typename VecTraits<V>::U U;
+  const float kShift = 0x1.8p23f;
+
+  V r = vabs(x);
+  V z = (r + 0x1.921fb6p+0f) * 0x1.45f306p-2f + kShift;
+  U sign = as<U>(z) << 31;
+  V n = z - kShift - 0.5f;
+  V result = v_sinf_reduced(r, sign, n);
+
+  U special = ~mask<V>(r < 0x1p12f);
+  return fix_special(x, result, special, cosf);
+}
+
+// 2^(j/64) for j in [0, 64).
+static const double kExpTable[64] = {
+  0x1.0000000000000p+0, 0x1.02c9a3e778061p+0,
+  0x1.059b0d3158574p+0, 0x1.0874518759bc8p+0,
+  0x1.0b5586cf9890fp+0, 0x1.0e3ec32d3d1a2p+0,
+  0x1.11301d0125b51p+0, 0x1.1429aaea92de0p+0,
+  0x1.172b83c7d517bp+0, 0x1.1a35beb6fcb75p+0,
+  0x1.1d4873168b9aap+0, 0x1.2063b88628cd6p+0,
+  0x1.2387a6e756238p+0, 0x1.26b4565e27cddp+0,
+  0x1.29e9df51fdee1p+0, 0x1.2d285a6e4030bp+0,
+  0x1.306fe0a31b715p+0, 0x1.33c08b26416ffp+0,
+  0x1.371a7373aa9cbp+0, 0x1.3a7db34e59ff7p+0,
+  0x1.3dea64c123422p+0, 0x1.4160a21f72e2ap+0,
+  0x1.44e086061892dp+0, 0x1.486a2b5c13cd0p+0,
+  0x1.4bfdad5362a27p+0, 0x1.4f9b2769d2ca7p+0,
+  0x1.5342b569d4f82p+0, 0x1.56f4736b527dap+0,
+  0x1.5ab07dd485429p+0, 0x1.5e76f15ad2148p+0,
+  0x1.6247eb03a5585p+0, 0x1.6623882552225p+0,
+  0x1.6a09e667f3bcdp+0, 0x1.6dfb23c651a2fp+0,
+  0x1.71f75e8ec5f74p+0, 0x1.75feb564267c9p+0,
+  0x1.7a11473eb0187p+0, 0x1.7e2f336cf4e62p+0,
+  0x1.82589994cce13p+0, 0x1.868d99b4492edp+0,
+  0x1.8ace5422aa0dbp+0, 0x1.8f1ae99157736p+0,
+  0x1.93737b0cdc5e5p+0, 0x1.97d829fde4e50p+0,
+  0x1.9c49182a3f090p+0, 0x1.a0c667b5de565p+0,
+  0x1.a5503b23e255dp+0, 0x1.a9e6b5579fdbfp+0,
+  0x1.ae89f995ad3adp+0, 0x1.b33a2b84f15fbp+0,
+  0x1.b7f76f2fb5e47p+0, 0x1.bcc1e904bc1d2p+0,
+  0x1.c199bdd85529cp+0, 0x1.c67f12e57d14bp+0,
+  0x1.cb720dcef9069p+0, 0x1.d072d4a07897cp+0,
+  0x1.d5818dcfba487p+0, 0x1.da9e603db3285p+0,
+  0x1.dfc97337b9b5fp+0, 0x1.e502ee78b3ff6p+0,
+  0x1.ea4afa2a490dap+0, 0x1.efa1bee615a27p+0,
+  0x1.f50765b6e4540p+0, 0x1.fa7c1819e90d8p+0,
+};
+
+// exp: exp(x) = 2^(k/64) * exp(r), with k = round(x*64/ln2) and
+// |r| <= ln2/128.
+template <typename V> static ALWAYS_INLINE V v_exp(V x) {
+  typedef typename VecTraits<V>::U U;
+  const double kShift = 0x1.8p52;
+
+  V z = x * 0x1.71547652b82fep+6 + kShift;
+  U k = as<U>(z);
+  V n = z - kShift;
+  V r = x - n * 0x1.62e42fee00000p-7 - n * 0x1.a39ef35793c76p-39;
+
+  U t = {};
+  for (int i = 0; i < VecTraits<V>::N; ++i) {
+    uint64_t bits;
+    memcpy(&bits, &kExpTable[k[i] & 63], sizeof(bits));
+    t[i] = bits;
+  }
+  V scale = as<V>(t + ((k >> 6) << 52));
+
+  V r2 = r * r;
+  V p = r * (1.0 / 120) + (1.0 / 24);
+  p = p * r + (1.0 / 6);
+  p = p * r + 0.5;
+  p = p * r2 + r;
+  V result = scale + scale * p;
+
+  U special = ~mask<V>(vabs(x) <= 708.0);
+  return fix_special(x, result, special, exp);
+}
+
+// log: log(x) = k*ln2 + log(1 + f), with x = 2^k * (1 + f) and 1 + f in
+// [sqrt(2)/2, sqrt(2)), using the same approximation of log(1 + f) as
+// e_log.c.
+template <typename V> static ALWAYS_INLINE V v_log(V x) {
+  typedef typename VecTraits<V>::U U;
+  typedef typename VecTraits<V>::I I;
+  const uint64_t kOff = 0x3fe6a09e667f3bcdULL;
+  const double kShift = 0x1.8p52;
+  const double ln2_hi = 6.93147180369123816490e-01;
+  const double ln2_lo = 1.90821492927058770002e-10;
+
+  U u = as<U>(x);
+  // Zero, negative, subnormal, infinite and NaN inputs.
+  U special = mask<V>(u - 0x0010000000000000ULL >= 0x7ff0000000000000ULL - 0x0010000000000000ULL);
+
+  U tmp = u - kOff;
+  // Adding k to the significand of 0x1.8p52 converts it without needing
+  // AVX-512's 64-bit integer conversions.
+  V dk = as<V>(as<U>(as<I>(tmp) >> 52) + as<U>(V{} + kShift)) - kShift;
+  V f = as<V>(u - (tmp & (0xfffULL << 52))) - 1.0;
+
+  V s = f / (2.0 + f);
+  V z = s * s;
+  V w = z * z;
+  V t1 = w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 + w * 1.531383769920937332e-01));
+  V t2 = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 +
+      w * (1.818357216161805012e-01 + w * 1.479819860511658591e-01)));
+  V R = t2 + t1;
+  V hfsq = 0.5 * f * f;
+  V result = dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f);
+
+  return fix_special(x, result, special, log);
+}
+
+// sin/cos: x = n*pi/2 + r, with |r| <= pi/4, using the kernels from k_sin.c
+// and k_cos.c for sin(r) and cos(r).
+template <typename V> static ALWAYS_INLINE V v_sin_kernel(V r) {
+  V z = r * r;
+  V w = z * z;
+  V p = 8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 + z * 2.75573137070700676789e-06);
+  V q = z * w * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10);
+  return r + r * z * (-1.66666666666666324348e-01 + z * (p + q));
+}
+
+template <typename V> static ALWAYS_INLINE V v_cos_kernel(V r) {
+  V z = r * r;
+  V w = z * z;
+  V p = z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+      z * 2.48015872894767294178e-05));
+  V q = w * w * (-2.75573143513906633035e-07 + z * (2.08757232129817482790e-09 +
+      z * -1.13596475577881948265e-11));
+  V hz = 0.5 * z;
+  V one_minus_hz = 1.0 - hz;
+  return one_minus_hz + (((1.0 - one_minus_hz) - hz) + z * (p + q));
+}
+
+// Returns sin(x) if 'quadrant_bias' is 0, and cos(x) if it is 1.
+template <typename V> static ALWAYS_INLINE V v_sincos(V x, uint64_t quadrant_bias) {
+  typedef typename VecTraits<V>::U U;
+  const double kShift = 0x1.8p52;
+
+  V ax = vabs(x);
+  V z = ax * 6.36619772367581382433e-01 + kShift;
+  U quadrant = as<U>(z) + quadrant_bias;
+  V n = z - kShift;
+  V r = ax - n * 1.57079632673412561417e+00;
+  r = r - n * 6.07710050630396597660e-11;
+  V rlo = n * 2.02226624871116645580e-21;
+  V rhi = r - rlo;
+  rlo = (r - rhi) - rlo;
+  r = rhi - n * 8.47842766036889956997e-32 + rlo;
+
+  V s = v_sin_kernel(r);
+  V c = v_cos_kernel(r);
+  V result = select(mask<V>((quadrant & 1) != 0), c, s);
+  U sign = (quadrant & 2) << 62;
+  if (quadrant_bias == 0) sign ^= as<U>(x) ^ as<U>(ax);
+  return as<V>(as<U>(result) ^ sign);
+}
+
+template <typename V> static ALWAYS_INLINE V v_sin(V x) {
+  typedef typename VecTraits<V>::U U;
+  U special = ~mask<V>(vabs(x) < 0x1p20);
+  return fix_special(x, v_sincos(x, 0), special, sin);
+}
+
+template <typename V> static ALWAYS_INLINE V v_cos(V x) {
+  typedef typename VecTraits<V>::U U;
+  U special = ~mask<V>(vabs(x) < 0x1p20);
+  return fix_special(x, v_sincos(x, 1), special, cos);
+}
+
+#define VECTOR_VARIANTS(ATTRS, ISA, NF, VF, ND, VD) \
+  extern "C" ATTRS VF _ZGV ## ISA ## N ## NF ## v_sinf(VF x) { return v_sinf(x); } \
+  extern "C" ATTRS VF _ZGV ## ISA ## N ## NF ## v_cosf(VF x) { return v_cosf(x); } \
+  extern "C" ATTRS VF _ZGV ## ISA ## N ## NF ## v_expf(VF x) { return v_expf(x); } \
+  extern "C" ATTRS VF _ZGV ## ISA ## N ## NF ## v_logf(VF x) { return v_logf(x); } \
+  extern "C" ATTRS VD _ZGV ## ISA ## N ## ND ## v_sin(VD x) { return v_sin(x); } \
+  extern "C" ATTRS VD _ZGV ## ISA ## N ## ND ## v_cos(VD x) { return v_cos(x); } \
+  extern "C" ATTRS VD _ZGV ## ISA ## N ## ND ## v_exp(VD x) { return v_exp(x); } \
+  extern "C" ATTRS VD _ZGV ## ISA ## N ## ND ## v_log(VD x) { return v_log(x); }
+
+#if defined(__x86_64__)
+// SSE, AVX, AVX2 and AVX-512 variants, in the x86-64 vector function ABI's
+// ISA order.
+VECTOR_VARIANTS(, b, 4, f32x4, 2, f64x2)
+VECTOR_VARIANTS(__attribute__((__target__("avx"))), c, 8, f32x8, 4, f64x4)
+VECTOR_VARIANTS(__attribute__((__target__("avx2,fma"))), d, 8, f32x8, 4, f64x4)
+VECTOR_VARIANTS(__attribute__((__target__("avx512f"))), e, 16, f32x16, 8, f64x8)
+#else
+// Advanced SIMD variants, using the vector procedure call standard.
+VECTOR_VARIANTS(__attribute__((aarch64_vector_pcs)), n, 4, f32x4, 2, f64x2)
+extern "C" __attribute__((aarch64_vector_pcs)) f32x2 _ZGVnN2v_sinf(f32x2 x) { return v_sinf(x); }
+extern "C" __attribute__((aarch64_vector_pcs)) f32x2 _ZGVnN2v_cosf(f32x2 x) { return v_cosf(x); }
+extern "C" __attribute__((aarch64_vector_pcs)) f32x2 _ZGVnN2v_expf(f32x2 x) { return v_expf(x); }
+extern "C" __attribute__((aarch64_vector_pcs)) f32x2 _ZGVnN2v_logf(f32x2 x) { return v_logf(x); }
+#endif
+
+#endif
@@ -30,6 +30,7 @@
 #include "linker_cfi.h"
 #include "linker_globals.h"
 #include "linker_dlwarning.h"
+#include "linker_utils.h"
 
 #include <pthread.h>
 #include <stdio.h>
@@ -38,11 +39,36 @@
 #include <android/api-level.h>
 
 #include <bionic/pthread_internal.h>
+#include "private/bionic_globals.h"
 #include "private/bionic_tls.h"
 #include "private/ScopedPthreadMutexLocker.h"
 
 static pthread_mutex_t g_dl_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
+// Counts a dlopen or dlsym call for android_libc_get_stats, and times it once
+// anyone has asked for the stats. Must be created with g_dl_mutex held.
+class ScopedLinkerStat {
+ public:
+  ScopedLinkerStat(uint64_t* calls, uint64_t* time_ns) : time_ns_(time_ns), start_ns_(0) {
+    __atomic_store_n(calls, *calls + 1, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&g_linker_stats.timing_enabled, __ATOMIC_RELAXED)) {
+      start_ns_ = get_monotonic_time_ns();
+    }
+  }
+
+  ~ScopedLinkerStat() {
+    if (start_ns_ != 0) {
+      __atomic_store_n(time_ns_, *time_ns_ + (get_monotonic_time_ns() - start_ns_), __ATOMIC_RELAXED);
+    }
+  }
+
+ private:
+  uint64_t* time_ns_;
+  uint64_t start_ns_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedLinkerStat);
+};
+
 static char* __bionic_set_dlerror(char* new_value) {
   char** dlerror_slot = &reinterpret_cast<char**>(__get_tls())[TLS_SLOT_DLERROR];
 
@@ -68,6 +94,15 @@ char* __dlerror() {
   return old_value;
 }
 
+// Called by arch/*/lazy_bind.S with the soinfo from the PLT's GOT. g_dl_mutex is recursive
+// so that constructors run by dlopen can call lazily bound functions, which also means that
+// a signal handler on a thread in the middle of dlopen or dlclose would get in. dlext.h tells
+// callers not to call ANDROID_DLEXT_LAZY_BINDING libraries from signal handlers.
+extern "C" ElfW(Addr) lazy_bind_entry(soinfo* si, ElfW(Addr) plt_arg) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  return do_lazy_bind(si, plt_arg);
+}
+
 void __android_get_LD_LIBRARY_PATH(char* buffer, size_t buffer_size) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
   do_android_get_LD_LIBRARY_PATH(buffer, buffer_size);
@@ -83,6 +118,7 @@ static void* dlopen_ext(const char* filename,
                         const android_dlextinfo* extinfo,
                         const void* caller_addr) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLinkerStat stat(&g_linker_stats.dlopen_calls, &g_linker_stats.dlopen_time_ns);
   g_linker_logger.ResetState();
   void* result = do_dlopen(filename, flags, extinfo, caller_addr);
   if (result == nullptr) {
@@ -105,6 +141,7 @@ void* __dlopen(const char* filename, int flags, const void* caller_addr) {
 
 void* dlsym_impl(void* handle, const char* symbol, const char* version, const void* caller_addr) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLinkerStat stat(&g_linker_stats.dlsym_calls, &g_linker_stats.dlsym_time_ns);
   g_linker_logger.ResetState();
   void* result;
   if (!do_dlsym(handle, symbol, version, caller_addr, &result)) {
@@ -123,6 +160,37 @@ void* __dlvsym(void* handle, const char* symbol, const char* version, const void
   return dlsym_impl(handle, symbol, version, caller_addr);
 }
 
+int __android_dlsym_many(void* handle,
+                         const char* const symbols[],
+                         void* addresses[],
+                         size_t count,
+                         const void* caller_addr) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLinkerStat stat(&g_linker_stats.dlsym_calls, &g_linker_stats.dlsym_time_ns);
+  g_linker_logger.ResetState();
+  int result = do_dlsym_many(handle, symbols, addresses, count, caller_addr);
+  if (result == -1) {
+    __bionic_format_dlerror(linker_get_error_buffer(), nullptr);
+  }
+  return result;
+}
+
+void* __android_dlsym_hashed(void* handle,
+                             const char* symbol,
+                             uint32_t gnu_hash,
+                             const void* caller_addr) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  ScopedLinkerStat stat(&g_linker_stats.dlsym_calls, &g_linker_stats.dlsym_time_ns);
+  g_linker_logger.ResetState();
+  void* result;
+  if (!do_dlsym_hashed(handle, symbol, gnu_hash, caller_addr, &result)) {
+    __bionic_format_dlerror(linker_get_error_buffer(), nullptr);
+    return nullptr;
+  }
+
+  return result;
+}
+
 int __dladdr(const void* addr, Dl_info* info) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
   return do_dladdr(addr, info);
@@ -139,10 +207,43 @@ int __dlclose(void* handle) {
 
 // This function is needed by libgcc.a (this is why there is no prefix for this one)
 int dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
+  // The unwinder calls this on every C++ throw, so avoid g_dl_mutex unless
+  // the set of loaded libraries changed since the last call.
+  int result;
+  if (do_dl_iterate_phdr_unlocked(cb, data, &result)) {
+    return result;
+  }
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
   return do_dl_iterate_phdr(cb, data);
 }
 
+int __android_iterate_dlopen_stats(int (*cb)(const android_dlopen_stats* stats, void* data),
+                                   void* data) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  return do_android_iterate_dlopen_stats(cb, data);
+}
+
+void __android_trim_dlopen_caches() {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  do_android_trim_dlopen_caches();
+}
+
+void __android_get_linker_memory_stats(android_linker_memory_stats* stats) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  do_android_get_linker_memory_stats(stats);
+}
+
+int __android_iterate_library_memory(int (*cb)(const android_library_memory* memory, void* data),
+                                     void* data) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  return do_android_iterate_library_memory(cb, data);
+}
+
+void __android_dump_linker_memory(int fd) {
+  ScopedPthreadMutexLocker locker(&g_dl_mutex);
+  do_android_dump_linker_memory(fd);
+}
+
 #if defined(__arm__)
 _Unwind_Ptr __dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount) {
   ScopedPthreadMutexLocker locker(&g_dl_mutex);
@@ -262,11 +363,25 @@ static const char ANDROID_LIBDL_STRTAB[] =
   // 0123456 789012345678901234567890123 456789012345678901 234567890123456789012345678901234 567890123456789
     "dlvsym\0__loader_android_dlwarning\0__loader_cfi_fail\0__loader_android_link_namespaces\0__loader_androi"
   // 5*
-  // 0000000000111111111122222 22222
-  // 0123456789012345678901234 56789
-    "d_get_exported_namespace\0"
+  // 0000000000111111111122222 22222333333333344444444445555555555666 666666677777777778888888888999999999
+  // 0123456789012345678901234 56789012345678901234567890123456789012 345678901234567890123456789012345678
+    "d_get_exported_namespace\0__loader_android_iterate_dlopen_stats\0__loader_android_trim_dlopen_caches\0"
+  // 599
+    "__loader_android_dlsym_many\0"
+  // 627
+    "__libc_globals\0"
+  // 642
+    "__libc_tls_globals\0"
+  // 661
+    "__loader_android_get_linker_memory_stats\0"
+  // 702
+    "__loader_android_iterate_library_memory\0"
+  // 742
+    "__loader_android_dump_linker_memory\0"
+  // 778
+    "__loader_android_dlsym_hashed\0"
 #if defined(__arm__)
-  // 525
+  // 808
     "__loader_dl_unwind_find_exidx\0"
 #endif
     ;
@@ -295,8 +410,19 @@ static ElfW(Sym) g_libdl_symtab[] = {
   ELFW(SYM_INITIALIZER)(434, &__cfi_fail, 1),
   ELFW(SYM_INITIALIZER)(452, &__android_link_namespaces, 1),
   ELFW(SYM_INITIALIZER)(485, &__android_get_exported_namespace, 1),
+  ELFW(SYM_INITIALIZER)(525, &__android_iterate_dlopen_stats, 1),
+  ELFW(SYM_INITIALIZER)(563, &__android_trim_dlopen_caches, 1),
+  ELFW(SYM_INITIALIZER)(599, &__android_dlsym_many, 1),
+  // Not a function: libc.so uses the linker's copy of its write-protected globals.
+  ELFW(SYM_INITIALIZER)(627, &__libc_globals, 1),
+  // Nor this: the ELF TLS layout and module table (see bionic_elf_tls.h).
+  ELFW(SYM_INITIALIZER)(642, &__libc_tls_globals, 1),
+  ELFW(SYM_INITIALIZER)(661, &__android_get_linker_memory_stats, 1),
+  ELFW(SYM_INITIALIZER)(702, &__android_iterate_library_memory, 1),
+  ELFW(SYM_INITIALIZER)(742, &__android_dump_linker_memory, 1),
+  ELFW(SYM_INITIALIZER)(778, &__android_dlsym_hashed, 1),
 #if defined(__arm__)
-  ELFW(SYM_INITIALIZER)(525, &__dl_unwind_find_exidx, 1),
+  ELFW(SYM_INITIALIZER)(808, &__dl_unwind_find_exidx, 1),
 #endif
 };
 
@@ -313,9 +439,9 @@ static ElfW(Sym) g_libdl_symtab[] = {
 // Note that adding any new symbols here requires stubbing them out in libdl.
 static unsigned g_libdl_buckets[1] = { 1 };
 #if defined(__arm__)
-static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 0 };
+static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 0 };
 #else
-static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 0 };
+static unsigned g_libdl_chains[] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 0 };
 #endif
 
 static uint8_t __libdl_info_buf[sizeof(soinfo)] __attribute__((aligned(8)));
@@ -29,46 +29,65 @@
 #ifndef __LINKED_LIST_H
 #define __LINKED_LIST_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "private/bionic_macros.h"
 
+// The lists hold elements in runs of one cache line rather than one per node:
+// walking a list of dependencies touches a few contiguous lines instead of
+// chasing a pointer per element, and a library with a handful of dependencies
+// costs one allocation rather than one per edge. Entries still come from the
+// list's Allocator, so the lists in soinfo stay in the linker's protected pool.
 template<typename T>
 struct LinkedListEntry {
+  static constexpr size_t kCapacity = (64 - 2 * sizeof(void*)) / sizeof(T*);
+
   LinkedListEntry<T>* next;
-  T* element;
+  // The elements are elements[begin] to elements[end - 1]; an entry in a list
+  // is never empty.
+  uint16_t begin;
+  uint16_t end;
+  T* elements[kCapacity];
 };
 
 // ForwardInputIterator
 template<typename T>
 class LinkedListIterator {
  public:
-  LinkedListIterator() : entry_(nullptr) {}
-  LinkedListIterator(const LinkedListIterator<T>& that) : entry_(that.entry_) {}
-  explicit LinkedListIterator(LinkedListEntry<T>* entry) : entry_(entry) {}
+  LinkedListIterator() : entry_(nullptr), index_(0) {}
+  LinkedListIterator(const LinkedListIterator<T>& that) : entry_(that.entry_), index_(that.index_) {}
+  LinkedListIterator(LinkedListEntry<T>* entry, size_t index) : entry_(entry), index_(index) {}
 
   LinkedListIterator<T>& operator=(const LinkedListIterator<T>& that) {
     entry_ = that.entry_;
+    index_ = that.index_;
     return *this;
   }
 
   LinkedListIterator<T>& operator++() {
-    entry_ = entry_->next;
+    if (++index_ == entry_->end) {
+      entry_ = entry_->next;
+      index_ = entry_ != nullptr ? entry_->begin : 0;
+    }
     return *this;
   }
 
   T* const operator*() {
-    return entry_->element;
+    return entry_->elements[index_];
   }
 
   bool operator==(const LinkedListIterator<T>& that) const {
-    return entry_ == that.entry_;
+    return entry_ == that.entry_ && index_ == that.index_;
   }
 
   bool operator!=(const LinkedListIterator<T>& that) const {
-    return entry_ != that.entry_;
+    return !(*this == that);
   }
 
  private:
-  LinkedListEntry<T> *entry_;
+  LinkedListEntry<T>* entry_;
+  size_t index_;
 };
 
 /*
@@ -79,6 +98,7 @@ class LinkedList {
  public:
   typedef LinkedListIterator<T> iterator;
   typedef T* value_type;
+  typedef LinkedListEntry<T> entry_t;
 
   LinkedList() : head_(nullptr), tail_(nullptr) {}
   ~LinkedList() {
@@ -92,25 +112,28 @@ class LinkedList {
   }
 
   void push_front(T* const element) {
-    LinkedListEntry<T>* new_entry = Allocator::alloc();
-    new_entry->next = head_;
-    new_entry->element = element;
-    head_ = new_entry;
-    if (tail_ == nullptr) {
-      tail_ = new_entry;
+    if (head_ == nullptr || head_->begin == 0) {
+      entry_t* new_entry = new_entry_at(entry_t::kCapacity);
+      new_entry->next = head_;
+      head_ = new_entry;
+      if (tail_ == nullptr) {
+        tail_ = new_entry;
+      }
     }
+    head_->elements[--head_->begin] = element;
   }
 
   void push_back(T* const element) {
-    LinkedListEntry<T>* new_entry = Allocator::alloc();
-    new_entry->next = nullptr;
-    new_entry->element = element;
-    if (tail_ == nullptr) {
-      tail_ = head_ = new_entry;
-    } else {
-      tail_->next = new_entry;
+    if (tail_ == nullptr || tail_->end == entry_t::kCapacity) {
+      entry_t* new_entry = new_entry_at(0);
+      if (tail_ == nullptr) {
+        head_ = new_entry;
+      } else {
+        tail_->next = new_entry;
+      }
       tail_ = new_entry;
     }
+    tail_->elements[tail_->end++] = element;
   }
 
   T* pop_front() {
@@ -118,13 +141,15 @@ class LinkedList {
       return nullptr;
     }
 
-    LinkedListEntry<T>* entry = head_;
-    T* element = entry->element;
-    head_ = entry->next;
-    Allocator::free(entry);
+    T* element = head_->elements[head_->begin++];
+    if (head_->begin == head_->end) {
+      entry_t* entry = head_;
+      head_ = entry->next;
+      Allocator::free(entry);
 
-    if (head_ == nullptr) {
-      tail_ = nullptr;
+      if (head_ == nullptr) {
+        tail_ = nullptr;
+      }
     }
 
     return element;
@@ -135,12 +160,12 @@ class LinkedList {
       return nullptr;
     }
 
-    return head_->element;
+    return head_->elements[head_->begin];
   }
 
   void clear() {
     while (head_ != nullptr) {
-      LinkedListEntry<T>* p = head_;
+      entry_t* p = head_;
       head_ = head_->next;
       Allocator::free(p);
     }
@@ -148,7 +173,7 @@ class LinkedList {
     tail_ = nullptr;
   }
 
-  bool empty() {
+  bool empty() const {
     return (head_ == nullptr);
   }
 
@@ -162,19 +187,31 @@ class LinkedList {
 
   template<typename F>
   bool visit(F action) const {
-    for (LinkedListEntry<T>* e = head_; e != nullptr; e = e->next) {
-      if (!action(e->element)) {
-        return false;
+    for (entry_t* e = head_; e != nullptr; e = e->next) {
+      for (size_t i = e->begin; i < e->end; ++i) {
+        if (!action(e->elements[i])) {
+          return false;
+        }
       }
     }
     return true;
   }
 
+  // Removed elements leave no holes: the rest of their entry is moved up, and
+  // an entry that becomes empty is freed.
   template<typename F>
   void remove_if(F predicate) {
-    for (LinkedListEntry<T>* e = head_, *p = nullptr; e != nullptr;) {
-      if (predicate(e->element)) {
-        LinkedListEntry<T>* next = e->next;
+    for (entry_t* e = head_, *p = nullptr; e != nullptr;) {
+      size_t kept = e->begin;
+      for (size_t i = e->begin; i < e->end; ++i) {
+        if (!predicate(e->elements[i])) {
+          e->elements[kept++] = e->elements[i];
+        }
+      }
+      e->end = kept;
+
+      if (e->begin == e->end) {
+        entry_t* next = e->next;
         if (p == nullptr) {
           head_ = next;
         } else {
@@ -203,27 +240,32 @@ class LinkedList {
 
   template<typename F>
   T* find_if(F predicate) const {
-    for (LinkedListEntry<T>* e = head_; e != nullptr; e = e->next) {
-      if (predicate(e->element)) {
-        return e->element;
+    T* result = nullptr;
+    visit([&](T* element) {
+      if (predicate(element)) {
+        result = element;
+        return false;
       }
-    }
+      return true;
+    });
 
-    return nullptr;
+    return result;
   }
 
   iterator begin() const {
-    return iterator(head_);
+    return iterator(head_, head_ != nullptr ? head_->begin : 0);
   }
 
   iterator end() const {
-    return iterator(nullptr);
+    return iterator(nullptr, 0);
   }
 
   iterator find(T* value) const {
-    for (LinkedListEntry<T>* e = head_; e != nullptr; e = e->next) {
-      if (e->element == value) {
-        return iterator(e);
+    for (entry_t* e = head_; e != nullptr; e = e->next) {
+      for (size_t i = e->begin; i < e->end; ++i) {
+        if (e->elements[i] == value) {
+          return iterator(e, i);
+        }
       }
     }
 
@@ -232,20 +274,21 @@ class LinkedList {
 
   size_t copy_to_array(T* array[], size_t array_length) const {
     size_t sz = 0;
-    for (LinkedListEntry<T>* e = head_; sz < array_length && e != nullptr; e = e->next) {
-      array[sz++] = e->element;
-    }
+    visit([&](T* element) {
+      if (sz == array_length) {
+        return false;
+      }
+      array[sz++] = element;
+      return true;
+    });
 
     return sz;
   }
 
   bool contains(const T* el) const {
-    for (LinkedListEntry<T>* e = head_; e != nullptr; e = e->next) {
-      if (e->element == el) {
-        return true;
-      }
-    }
-    return false;
+    return !visit([&](T* element) {
+      return element != el;
+    });
   }
 
   static LinkedList make_list(T* const element) {
@@ -255,8 +298,16 @@ class LinkedList {
   }
 
  private:
-  LinkedListEntry<T>* head_;
-  LinkedListEntry<T>* tail_;
+  // Returns a new empty entry whose elements will start at index.
+  static entry_t* new_entry_at(size_t index) {
+    entry_t* entry = Allocator::alloc();
+    entry->next = nullptr;
+    entry->begin = entry->end = index;
+    return entry;
+  }
+
+  entry_t* head_;
+  entry_t* tail_;
   DISALLOW_COPY_AND_ASSIGN(LinkedList);
 };
 
@@ -30,22 +30,31 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <linux/memfd.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/vfs.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <new>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 // Private C library headers.
 #include "private/ScopeGuard.h"
+#include "private/bionic_asymmetric_fence.h"
+#include "private/bionic_globals.h"
 
 #include "linker.h"
 #include "linker_block_allocator.h"
@@ -53,11 +62,14 @@
 #include "linker_config.h"
 #include "linker_gdb_support.h"
 #include "linker_globals.h"
+#include "linker_link_plan.h"
 #include "linker_debug.h"
+#include "linker_dir_cache.h"
 #include "linker_dlwarning.h"
 #include "linker_main.h"
 #include "linker_namespaces.h"
 #include "linker_sleb128.h"
+#include "linker_tls.h"
 #include "linker_phdr.h"
 #include "linker_relocs.h"
 #include "linker_reloc_iterators.h"
@@ -74,11 +86,12 @@
 static android_namespace_t* g_anonymous_namespace = &g_default_namespace;
 static std::unordered_map<std::string, android_namespace_t*> g_exported_namespaces;
 
-static LinkerTypeAllocator<soinfo> g_soinfo_allocator;
-static LinkerTypeAllocator<LinkedListEntry<soinfo>> g_soinfo_links_allocator;
+// These pools are read-only outside of ProtectedDataGuard.
+static LinkerTypeAllocator<soinfo> g_soinfo_allocator(true);
+static LinkerTypeAllocator<LinkedListEntry<soinfo>> g_soinfo_links_allocator(true);
 
-static LinkerTypeAllocator<android_namespace_t> g_namespace_allocator;
-static LinkerTypeAllocator<LinkedListEntry<android_namespace_t>> g_namespace_list_allocator;
+static LinkerTypeAllocator<android_namespace_t> g_namespace_allocator(true);
+static LinkerTypeAllocator<LinkedListEntry<android_namespace_t>> g_namespace_list_allocator(true);
 
 static const char* const kLdConfigFilePath = "/system/etc/ld.config.txt";
 
@@ -233,14 +246,58 @@ void count_relocation(RelocationKind) {
 }
 #endif
 
+static linker_readahead_stats g_readahead_stats;
+
+const linker_readahead_stats& get_linker_readahead_stats() {
+  return g_readahead_stats;
+}
+
+static linker_unload_stats g_unload_stats;
+
+const linker_unload_stats& get_linker_unload_stats() {
+  return g_unload_stats;
+}
+
 #if COUNT_PAGES
 uint32_t bitmask[4096];
 #endif
 
-static void notify_gdb_of_load(soinfo* info) {
+// C++ exception unwinding calls dl_iterate_phdr on every throw, so it is served from an immutable
+// snapshot of the phdr info of all loaded objects that readers walk without g_dl_mutex. The
+// snapshot carries its own copies of the phdr tables and names, so it stays valid while objects in
+// it are unloaded; the rest of an object's memory (its PT_GNU_EH_FRAME, say) may only be read by
+// callers that know the object is in use, as was already the case for a concurrent dlclose.
+//
+// A snapshot is rebuilt under g_dl_mutex the first time it is needed after the set of loaded
+// objects changed. Replaced snapshots are freed by a later rebuild that sees no reader in flight.
+// Readers announce themselves before loading the snapshot and rebuilds publish the snapshot
+// before counting readers, with asymmetric fences between, so that readers only need a compiler
+// barrier there.
+struct dl_phdr_snapshot {
+  uint64_t generation;
+  size_t count;
+  dl_phdr_info* infos;
+  dl_phdr_snapshot* next_retired;
+};
+
+static std::atomic<dl_phdr_snapshot*> g_dl_phdr_snapshot(nullptr);
+static std::atomic<size_t> g_dl_phdr_readers(0);
+static dl_phdr_snapshot* g_dl_phdr_retired = nullptr;
+
+// Bumped whenever an object is added to or removed from solist, or finishes loading. Everything
+// derived from solist (the dl_iterate_phdr snapshot, the address index) is rebuilt when it is
+// found to be from an older generation.
+static std::atomic<uint64_t> g_loaded_objects_generation(1);
+
+static void notify_loaded_objects_changed() {
+  g_loaded_objects_generation.fetch_add(1);
+}
+
+// Fills in the link_map gdb reads for info, or returns nullptr for the linker and the main
+// executable, which gdb already knows about.
+static link_map* link_map_for_gdb(soinfo* info) {
   if (info->is_linker() || info->is_main_executable()) {
-    // gdb already knows about the linker and the main executable.
-    return;
+    return nullptr;
   }
 
   link_map* map = &(info->link_map_head);
@@ -253,11 +310,31 @@ static void notify_gdb_of_load(soinfo* info) {
   CHECK(map->l_name != nullptr);
   CHECK(map->l_name[0] != '\0');
 
-  notify_gdb_of_load(map);
+  return map;
 }
 
-static void notify_gdb_of_unload(soinfo* info) {
-  notify_gdb_of_unload(&(info->link_map_head));
+void notify_gdb_of_load(soinfo* info) {
+  notify_loaded_objects_changed();
+
+  link_map* map = link_map_for_gdb(info);
+  if (map != nullptr) {
+    notify_gdb_of_load(map);
+  }
+}
+
+// Publishes a group of newly linked libraries in a single RT_ADD/RT_CONSISTENT transition
+// rather than one per library.
+static void notify_gdb_of_loads(const soinfo_list_t& sis) {
+  notify_loaded_objects_changed();
+
+  std::vector<link_map*> maps;
+  sis.for_each([&](soinfo* si) {
+    link_map* map = link_map_for_gdb(si);
+    if (map != nullptr) {
+      maps.push_back(map);
+    }
+  });
+  notify_gdb_of_loads(maps.data(), maps.size());
 }
 
 LinkedListEntry<soinfo>* SoinfoListAllocator::alloc() {
@@ -290,6 +367,7 @@ soinfo* soinfo_alloc(android_namespace_t* ns, const char* name,
                                                        file_offset, rtld_flags);
 
   solist_add_soinfo(si);
+  notify_loaded_objects_changed();
 
   si->generate_handle();
   ns->add_soinfo(si);
@@ -298,11 +376,7 @@ soinfo* soinfo_alloc(android_namespace_t* ns, const char* name,
   return si;
 }
 
-static void soinfo_free(soinfo* si) {
-  if (si == nullptr) {
-    return;
-  }
-
+static void soinfo_unmap(soinfo* si) {
   if (si->base != 0 && si->size != 0) {
     if (!si->is_mapped_by_caller()) {
       munmap(reinterpret_cast<void*>(si->base), si->size);
@@ -312,22 +386,44 @@ static void soinfo_free(soinfo* si) {
            MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
     }
   }
+}
 
-  TRACE("name %s: freeing soinfo @ %p", si->get_realpath(), si);
-
+// Takes si out of solist and its namespaces, so that nothing can find it any more. Returns false,
+// leaving si alone, if it was not in solist.
+static bool soinfo_unlink(soinfo* si) {
   if (!solist_remove_soinfo(si)) {
     // TODO (dimitry): revisit this - for now preserving the logic
     // but it does not look right, abort if soinfo is not in the list instead?
-    return;
+    return false;
   }
+  notify_loaded_objects_changed();
 
   // clear links to/from si
   si->remove_all_links();
 
+  unregister_soinfo_tls(si);
+  return true;
+}
+
+static void soinfo_destroy(soinfo* si) {
   si->~soinfo();
   g_soinfo_allocator.free(si);
 }
 
+static void soinfo_free(soinfo* si) {
+  if (si == nullptr) {
+    return;
+  }
+
+  soinfo_unmap(si);
+
+  TRACE("name %s: freeing soinfo @ %p", si->get_realpath(), si);
+
+  if (soinfo_unlink(si)) {
+    soinfo_destroy(si);
+  }
+}
+
 static void parse_path(const char* path, const char* delimiters,
                        std::vector<std::string>* resolved_paths) {
   std::vector<std::string> paths;
@@ -378,15 +474,140 @@ _Unwind_Ptr do_dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount) {
 
 // Here, we only have to provide a callback to iterate across all the
 // loaded libraries. gcc_eh does the rest.
+static dl_phdr_snapshot* build_dl_phdr_snapshot(uint64_t generation) {
+  size_t count = 0;
+  size_t phdr_count = 0;
+  size_t names_size = 0;
+  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
+    ++count;
+    phdr_count += si->phnum;
+    if (si->link_map_head.l_name != nullptr) {
+      names_size += strlen(si->link_map_head.l_name) + 1;
+    }
+  }
+
+  // Everything lives in one block: the header, the infos, the phdr tables, then the names.
+  size_t size = sizeof(dl_phdr_snapshot) + count * sizeof(dl_phdr_info) +
+                phdr_count * sizeof(ElfW(Phdr)) + names_size;
+  char* p = reinterpret_cast<char*>(malloc(size));
+  CHECK(p != nullptr);
+
+  dl_phdr_snapshot* snapshot = reinterpret_cast<dl_phdr_snapshot*>(p);
+  snapshot->generation = generation;
+  snapshot->count = count;
+  snapshot->infos = reinterpret_cast<dl_phdr_info*>(p + sizeof(dl_phdr_snapshot));
+  snapshot->next_retired = nullptr;
+  ElfW(Phdr)* phdrs = reinterpret_cast<ElfW(Phdr)*>(snapshot->infos + count);
+  char* names = reinterpret_cast<char*>(phdrs + phdr_count);
+
+  dl_phdr_info* info = snapshot->infos;
+  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next, ++info) {
+    info->dlpi_addr = si->link_map_head.l_addr;
+    info->dlpi_name = nullptr;
+    if (si->link_map_head.l_name != nullptr) {
+      size_t name_size = strlen(si->link_map_head.l_name) + 1;
+      memcpy(names, si->link_map_head.l_name, name_size);
+      info->dlpi_name = names;
+      names += name_size;
+    }
+    info->dlpi_phdr = nullptr;
+    if (si->phdr != nullptr) {
+      memcpy(phdrs, si->phdr, si->phnum * sizeof(ElfW(Phdr)));
+      info->dlpi_phdr = phdrs;
+      phdrs += si->phnum;
+    }
+    info->dlpi_phnum = si->phdr != nullptr ? si->phnum : 0;
+  }
+  return snapshot;
+}
+
+// Must be called with g_dl_mutex held.
+static dl_phdr_snapshot* refresh_dl_phdr_snapshot() {
+  uint64_t generation = g_loaded_objects_generation.load();
+  dl_phdr_snapshot* current = g_dl_phdr_snapshot.load();
+  if (current != nullptr && current->generation == generation) {
+    return current;
+  }
+
+  dl_phdr_snapshot* snapshot = build_dl_phdr_snapshot(generation);
+  g_dl_phdr_snapshot.store(snapshot, std::memory_order_release);
+  if (current != nullptr) {
+    current->next_retired = g_dl_phdr_retired;
+    g_dl_phdr_retired = current;
+  }
+
+  // A reader that registers after this point loads the new snapshot, so if there is no reader
+  // now, nobody can be using a retired one.
+  if (g_dl_phdr_retired != nullptr) {
+    __asymmetric_fence_heavy();
+    if (g_dl_phdr_readers.load(std::memory_order_acquire) == 0) {
+      while (g_dl_phdr_retired != nullptr) {
+        dl_phdr_snapshot* next = g_dl_phdr_retired->next_retired;
+        free(g_dl_phdr_retired);
+        g_dl_phdr_retired = next;
+      }
+    }
+  }
+  return snapshot;
+}
+
+static int iterate_dl_phdr_snapshot(const dl_phdr_snapshot* snapshot,
+                                    int (*cb)(dl_phdr_info* info, size_t size, void* data),
+                                    void* data) {
+  int rv = 0;
+  for (size_t i = 0; i < snapshot->count; ++i) {
+    // Hand out a copy so that the callback cannot modify the shared snapshot.
+    dl_phdr_info dl_info = snapshot->infos[i];
+    rv = cb(&dl_info, sizeof(dl_phdr_info), data);
+    if (rv != 0) {
+      break;
+    }
+  }
+  return rv;
+}
+
+static void dl_phdr_reader_enter() {
+  g_dl_phdr_readers.fetch_add(1, std::memory_order_relaxed);
+  __asymmetric_fence_light();
+}
+
+static void dl_phdr_reader_exit() {
+  g_dl_phdr_readers.fetch_sub(1, std::memory_order_release);
+}
+
+bool do_dl_iterate_phdr_unlocked(int (*cb)(dl_phdr_info* info, size_t size, void* data),
+                                 void* data, int* result) {
+  dl_phdr_reader_enter();
+  dl_phdr_snapshot* snapshot = g_dl_phdr_snapshot.load(std::memory_order_acquire);
+  if (snapshot == nullptr || snapshot->generation != g_loaded_objects_generation.load()) {
+    dl_phdr_reader_exit();
+    return false;
+  }
+  *result = iterate_dl_phdr_snapshot(snapshot, cb, data);
+  dl_phdr_reader_exit();
+  return true;
+}
+
 int do_dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data) {
+  dl_phdr_reader_enter();
+  int rv = iterate_dl_phdr_snapshot(refresh_dl_phdr_snapshot(), cb, data);
+  dl_phdr_reader_exit();
+  return rv;
+}
+
+int do_android_iterate_dlopen_stats(int (*cb)(const android_dlopen_stats* stats, void* data),
+                                    void* data) {
   int rv = 0;
   for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
-    dl_phdr_info dl_info;
-    dl_info.dlpi_addr = si->link_map_head.l_addr;
-    dl_info.dlpi_name = si->link_map_head.l_name;
-    dl_info.dlpi_phdr = si->phdr;
-    dl_info.dlpi_phnum = si->phnum;
-    rv = cb(&dl_info, sizeof(dl_phdr_info), data);
+    const soinfo_load_times* load_times = si->get_load_times();
+    android_dlopen_stats stats;
+    stats.realpath = si->get_realpath();
+    stats.open_ns = load_times->open_ns;
+    stats.map_ns = load_times->map_ns;
+    stats.prelink_ns = load_times->prelink_ns;
+    stats.relocate_ns = load_times->relocate_ns;
+    stats.constructors_ns = load_times->constructors_ns;
+    rv = cb(&stats, data);
     if (rv != 0) {
       break;
     }
@@ -394,6 +615,103 @@ int do_dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), v
   return rv;
 }
 
+void do_android_get_linker_memory_stats(android_linker_memory_stats* stats) {
+  stats->soinfo_bytes = g_soinfo_allocator.page_count() * PAGE_SIZE;
+  stats->namespace_bytes = g_namespace_allocator.page_count() * PAGE_SIZE;
+  stats->list_bytes = (g_soinfo_links_allocator.page_count() +
+                       g_namespace_list_allocator.page_count()) * PAGE_SIZE;
+  stats->other_pool_bytes = LinkerBlockAllocator::total_page_count() * PAGE_SIZE -
+      stats->soinfo_bytes - stats->namespace_bytes - stats->list_bytes;
+  get_linker_heap_usage(&stats->heap_small_bytes, &stats->heap_small_used_bytes,
+                        &stats->heap_large_bytes);
+}
+
+static void get_library_memory(soinfo* si, android_library_memory* memory) {
+  linker_segment_usage usage;
+  phdr_table_get_segment_usage(si->phdr, si->phnum, si->load_bias, &usage);
+
+  memory->realpath = si->get_realpath();
+  memory->namespace_name = si->get_primary_namespace()->get_name();
+  memory->mapped_pages = usage.pages;
+  memory->resident_pages = usage.resident_pages;
+  memory->relocated_pages = usage.writable_pages;
+  memory->relocated_resident_pages = usage.writable_resident_pages;
+}
+
+int do_android_iterate_library_memory(int (*cb)(const android_library_memory* memory, void* data),
+                                      void* data) {
+  int rv = 0;
+  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
+    // The libdl soinfo has no segments of its own; the linker's are reported separately.
+    if (si->phdr == nullptr) {
+      continue;
+    }
+
+    android_library_memory memory;
+    get_library_memory(si, &memory);
+    rv = cb(&memory, data);
+    if (rv != 0) {
+      break;
+    }
+  }
+  return rv;
+}
+
+void do_android_dump_linker_memory(int fd) {
+  android_linker_memory_stats stats;
+  do_android_get_linker_memory_stats(&stats);
+  __libc_format_fd(fd, "linker memory (bytes):\n");
+  __libc_format_fd(fd, "  soinfo pool: %zu\n", stats.soinfo_bytes);
+  __libc_format_fd(fd, "  namespace pool: %zu\n", stats.namespace_bytes);
+  __libc_format_fd(fd, "  list pools: %zu\n", stats.list_bytes);
+  __libc_format_fd(fd, "  other pools: %zu\n", stats.other_pool_bytes);
+  __libc_format_fd(fd, "  heap, small objects: %zu (%zu allocated)\n",
+                   stats.heap_small_bytes, stats.heap_small_used_bytes);
+  __libc_format_fd(fd, "  heap, large objects: %zu\n", stats.heap_large_bytes);
+
+  struct namespace_totals {
+    android_namespace_t* ns;
+    size_t libraries;
+    android_library_memory memory;
+  };
+  std::vector<namespace_totals> totals;
+
+  __libc_format_fd(fd, "libraries (pages: mapped resident relocated relocated-resident):\n");
+  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
+    if (si->phdr == nullptr) {
+      continue;
+    }
+
+    android_library_memory memory;
+    get_library_memory(si, &memory);
+    __libc_format_fd(fd, "  %zu %zu %zu %zu %s [%s]\n", memory.mapped_pages,
+                     memory.resident_pages, memory.relocated_pages,
+                     memory.relocated_resident_pages, memory.realpath, memory.namespace_name);
+
+    android_namespace_t* ns = si->get_primary_namespace();
+    auto it = std::find_if(totals.begin(), totals.end(), [&](const namespace_totals& t) {
+      return t.ns == ns;
+    });
+    if (it == totals.end()) {
+      totals.push_back({ ns, 0, {} });
+      it = totals.end() - 1;
+    }
+    it->libraries++;
+    it->memory.mapped_pages += memory.mapped_pages;
+    it->memory.resident_pages += memory.resident_pages;
+    it->memory.relocated_pages += memory.relocated_pages;
+    it->memory.relocated_resident_pages += memory.relocated_resident_pages;
+  }
+
+  __libc_format_fd(fd, "namespaces (libraries, soinfo bytes, pages: mapped resident relocated "
+                   "relocated-resident):\n");
+  for (const namespace_totals& t : totals) {
+    __libc_format_fd(fd, "  %zu %zu %zu %zu %zu %zu %s\n", t.libraries,
+                     t.libraries * sizeof(soinfo), t.memory.mapped_pages,
+                     t.memory.resident_pages, t.memory.relocated_pages,
+                     t.memory.relocated_resident_pages, t.ns->get_name());
+  }
+}
 
 bool soinfo_do_lookup(soinfo* si_from, const char* name, const version_info* vi,
                       soinfo** si_found_in, const soinfo_list_t& global_group,
@@ -505,10 +823,9 @@ ProtectedDataGuard::~ProtectedDataGuard() {
 }
 
 void ProtectedDataGuard::protect_data(int protection) {
-  g_soinfo_allocator.protect_all(protection);
-  g_soinfo_links_allocator.protect_all(protection);
-  g_namespace_allocator.protect_all(protection);
-  g_namespace_list_allocator.protect_all(protection);
+  // The soinfo, namespace and list entry pools are all protectable, so this is one mprotect for
+  // all of them rather than one per page.
+  LinkerBlockAllocator::protect_protectable(protection);
 }
 
 size_t ProtectedDataGuard::ref_count_ = 0;
@@ -630,6 +947,10 @@ class LoadTask {
     return elf_reader.Read(realpath, fd_, file_offset_, file_size);
   }
 
+  void readahead() {
+    get_elf_reader().ReadaheadSegments();
+  }
+
   bool load() {
     ElfReader& elf_reader = get_elf_reader();
     if (!elf_reader.Load(extinfo_)) {
@@ -763,16 +1084,13 @@ static void for_each_matching_shim(const char *const path, F action) {
 // by the action and true otherwise.
 template<typename F>
 static bool walk_dependencies_tree(soinfo* root_soinfos[], size_t root_soinfos_size, F action) {
-  SoinfoLinkedList visit_list;
-  SoinfoLinkedList visited;
-
-  for (size_t i = 0; i < root_soinfos_size; ++i) {
-    visit_list.push_back(root_soinfos[i]);
-  }
+  // The queue is only ever appended to, so it's an array with a read index.
+  std::vector<soinfo*> visit_list(root_soinfos, root_soinfos + root_soinfos_size);
+  std::unordered_set<soinfo*> visited;
 
-  soinfo* si;
-  while ((si = visit_list.pop_front()) != nullptr) {
-    if (visited.contains(si)) {
+  for (size_t i = 0; i < visit_list.size(); ++i) {
+    soinfo* si = visit_list[i];
+    if (!visited.insert(si).second) {
       continue;
     }
 
@@ -782,8 +1100,6 @@ static bool walk_dependencies_tree(soinfo* root_soinfos[], size_t root_soinfos_s
       return false;
     }
 
-    visited.push_back(si);
-
     if (result != kWalkSkip) {
       si->get_children().for_each([&](soinfo* child) {
         visit_list.push_back(child);
@@ -831,17 +1147,126 @@ static const ElfW(Sym)* dlsym_handle_lookup(android_namespace_t* ns,
 }
 
 static const ElfW(Sym)* dlsym_linear_lookup(android_namespace_t* ns,
-                                            const char* name,
+                                            SymbolName& symbol_name,
                                             const version_info* vi,
                                             soinfo** found,
                                             soinfo* caller,
                                             void* handle);
 
+// Remembers the results of dlsym() on library handles, so that looking up
+// the same symbol again does not walk the dependency tree of the handle.
+// Failed lookups are remembered too, and so is the order in which the
+// libraries of each handle are searched, so that looking up another symbol
+// goes through an array rather than walking the tree again. Everything is
+// dropped as soon as any library is linked to or unlinked from another one,
+// since that may change what the walk finds (see
+// get_soinfo_links_generation()). The tables live outside of the soinfo so
+// that a lookup does not need to unprotect it.
+class DlsymCache {
+ public:
+  static constexpr size_t kMaxEntriesPerLibrary = 256;
+
+  DlsymCache() : generation_(0) {}
+
+  bool find(soinfo* si, const char* name, const version_info* vi,
+            soinfo** found, const ElfW(Sym)** symbol);
+  void insert(soinfo* si, const char* name, const version_info* vi,
+              soinfo* found, const ElfW(Sym)* symbol);
+
+  // The libraries dlsym(si, ...) searches, in order: si and its dependencies
+  // in breadth-first order, leaving out those si's namespace can't access.
+  const std::vector<soinfo*>& get_lookup_order(soinfo* si);
+ private:
+  struct entry {
+    soinfo* found;
+    const ElfW(Sym)* symbol;
+  };
+
+  typedef std::unordered_map<std::string, entry> table_t;
+
+  static std::string make_key(const char* name, const version_info* vi) {
+    std::string key(name);
+    if (vi != nullptr) {
+      key.push_back('\0');
+      key.append(vi->name);
+    }
+    return key;
+  }
+
+  void check_generation() {
+    uint64_t generation = get_soinfo_links_generation();
+    if (generation != generation_) {
+      tables_.clear();
+      lookup_orders_.clear();
+      generation_ = generation;
+    }
+  }
+
+  std::unordered_map<soinfo*, table_t> tables_;
+  std::unordered_map<soinfo*, std::vector<soinfo*>> lookup_orders_;
+  uint64_t generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(DlsymCache);
+};
+
+bool DlsymCache::find(soinfo* si, const char* name, const version_info* vi,
+                      soinfo** found, const ElfW(Sym)** symbol) {
+  check_generation();
+
+  auto table = tables_.find(si);
+  if (table == tables_.end()) {
+    return false;
+  }
+
+  auto it = table->second.find(make_key(name, vi));
+  if (it == table->second.end()) {
+    return false;
+  }
+
+  *found = it->second.found;
+  *symbol = it->second.symbol;
+  return true;
+}
+
+void DlsymCache::insert(soinfo* si, const char* name, const version_info* vi,
+                        soinfo* found, const ElfW(Sym)* symbol) {
+  check_generation();
+
+  table_t& table = tables_[si];
+  if (table.size() < kMaxEntriesPerLibrary) {
+    table[make_key(name, vi)] = { found, symbol };
+  }
+}
+
+const std::vector<soinfo*>& DlsymCache::get_lookup_order(soinfo* si) {
+  check_generation();
+
+  auto it = lookup_orders_.find(si);
+  if (it != lookup_orders_.end()) {
+    return it->second;
+  }
+
+  // The same walk as dlsym_handle_lookup() without a skip_until.
+  std::vector<soinfo*>& order = lookup_orders_[si];
+  android_namespace_t* ns = si->get_primary_namespace();
+  walk_dependencies_tree(&si, 1, [&](soinfo* current_soinfo) {
+    if (!ns->is_accessible(current_soinfo)) {
+      return kWalkSkip;
+    }
+
+    order.push_back(current_soinfo);
+    return kWalkContinue;
+  });
+  return order;
+}
+
+static DlsymCache g_dlsym_cache;
+
 // This is used by dlsym(3).  It performs symbol lookup only within the
 // specified soinfo object and its dependencies in breadth first order.
 static const ElfW(Sym)* dlsym_handle_lookup(soinfo* si,
                                             soinfo** found,
-                                            const char* name,
+                                            SymbolName& symbol_name,
                                             const version_info* vi) {
   // According to man dlopen(3) and posix docs in the case when si is handle
   // of the main executable we need to search not only in the executable and its
@@ -851,15 +1276,36 @@ static const ElfW(Sym)* dlsym_handle_lookup(soinfo* si,
   // libraries and they are loaded in breath-first (correct) order we can just execute
   // dlsym(RTLD_DEFAULT, ...); instead of doing two stage lookup.
   if (si == solist_get_somain()) {
-    return dlsym_linear_lookup(&g_default_namespace, name, vi, found, nullptr, RTLD_DEFAULT);
+    return dlsym_linear_lookup(&g_default_namespace, symbol_name, vi, found, nullptr, RTLD_DEFAULT);
+  }
+
+  const char* name = symbol_name.get_name();
+  const ElfW(Sym)* result = nullptr;
+  if (g_dlsym_cache.find(si, name, vi, found, &result)) {
+    return result;
   }
 
-  SymbolName symbol_name(name);
   // note that the namespace is not the namespace associated with caller_addr
   // we use ns associated with root si intentionally here. Using caller_ns
   // causes problems when user uses dlopen_ext to open a library in the separate
   // namespace and then calls dlsym() on the handle.
-  return dlsym_handle_lookup(si->get_primary_namespace(), si, nullptr, found, symbol_name, vi);
+  for (soinfo* current_soinfo : g_dlsym_cache.get_lookup_order(si)) {
+    if (!current_soinfo->find_symbol_by_name(symbol_name, vi, &result)) {
+      result = nullptr;
+      break;
+    }
+
+    if (result != nullptr) {
+      *found = current_soinfo;
+      break;
+    }
+  }
+  // A failure with a hash supplied by the caller may only mean the hash was
+  // wrong, which mustn't stop later lookups of the name from succeeding.
+  if (result != nullptr || !symbol_name.has_supplied_gnu_hash()) {
+    g_dlsym_cache.insert(si, name, vi, result != nullptr ? *found : nullptr, result);
+  }
+  return result;
 }
 
 /* This is used by dlsym(3) to performs a global symbol lookup. If the
@@ -868,12 +1314,11 @@ static const ElfW(Sym)* dlsym_handle_lookup(soinfo* si,
    specified soinfo (for RTLD_NEXT).
  */
 static const ElfW(Sym)* dlsym_linear_lookup(android_namespace_t* ns,
-                                            const char* name,
+                                            SymbolName& symbol_name,
                                             const version_info* vi,
                                             soinfo** found,
                                             soinfo* caller,
                                             void* handle) {
-  SymbolName symbol_name(name);
 
   auto& soinfo_list = ns->soinfo_list();
   auto start = soinfo_list.begin();
@@ -926,13 +1371,13 @@ static const ElfW(Sym)* dlsym_linear_lookup(android_namespace_t* ns,
 
   if (s != nullptr) {
     TRACE_TYPE(LOOKUP, "%s s->st_value = %p, found->base = %p",
-               name, reinterpret_cast<void*>(s->st_value), reinterpret_cast<void*>((*found)->base));
+               symbol_name.get_name(), reinterpret_cast<void*>(s->st_value), reinterpret_cast<void*>((*found)->base));
   }
 
   return s;
 }
 
-soinfo* find_containing_library(const void* p) {
+soinfo* find_containing_library_unlocked(const void* p) {
   ElfW(Addr) address = reinterpret_cast<ElfW(Addr)>(p);
   for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
     if (address >= si->base && address - si->base < si->size) {
@@ -942,50 +1387,335 @@ soinfo* find_containing_library(const void* p) {
   return nullptr;
 }
 
+// The loaded objects sorted by base address, so that find_containing_library, which dladdr and
+// every dlopen/dlsym with a caller address go through, is a binary search rather than a walk of
+// solist. Rebuilt on the first lookup after the set of loaded objects changed.
+class LibraryAddressIndex {
+ public:
+  LibraryAddressIndex() : generation_(0) {}
+
+  soinfo* find(ElfW(Addr) address) {
+    uint64_t generation = g_loaded_objects_generation.load();
+    if (generation != generation_) {
+      rebuild();
+      generation_ = generation;
+    }
+
+    // The last object that starts at or below address is the only one that can contain it.
+    auto it = std::upper_bound(libraries_.begin(), libraries_.end(), address,
+                               [](ElfW(Addr) a, const soinfo* si) { return a < si->base; });
+    if (it == libraries_.begin()) {
+      return nullptr;
+    }
+    soinfo* si = *(it - 1);
+    return address - si->base < si->size ? si : nullptr;
+  }
+
+ private:
+  void rebuild() {
+    libraries_.clear();
+    for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
+      if (si->size != 0) {
+        libraries_.push_back(si);
+      }
+    }
+    std::sort(libraries_.begin(), libraries_.end(),
+              [](const soinfo* a, const soinfo* b) { return a->base < b->base; });
+  }
+
+  uint64_t generation_;
+  std::vector<soinfo*> libraries_;
+
+  DISALLOW_COPY_AND_ASSIGN(LibraryAddressIndex);
+};
+
+static LibraryAddressIndex g_library_address_index;
+
+soinfo* find_containing_library(const void* p) {
+  return g_library_address_index.find(reinterpret_cast<ElfW(Addr)>(p));
+}
+
+// Keeps the central directories of recently used zip files (APKs) open for
+// the lifetime of the process, so that loading libraries from the same APK in
+// separate dlopen() calls does not open and index it every time. Entries are
+// keyed by the identity of the file rather than by its path, so that a zip file
+// that has been replaced (by an app update, for example) is opened anew.
+//
+// Libraries that can't be mapped from the zip file directly (because they are
+// compressed or not page aligned) are extracted, and the descriptors of the
+// extracted files are kept with the zip file, so that every load of the same
+// entry sees the same file and is recognized as the same library. For that
+// reason those of a library that is still loaded are kept even when the zip
+// file is closed.
 class ZipArchiveCache {
  public:
-  ZipArchiveCache() {}
+  static constexpr size_t kMaxEntries = 8;
+
+  ZipArchiveCache() : use_count_(0), last_(nullptr) {}
   ~ZipArchiveCache();
 
-  bool get_or_open(const char* zip_path, ZipArchiveHandle* handle);
+  // fd is a descriptor of the file at zip_path, used to look up the entry.
+  bool get_or_open(const char* zip_path, int fd, ZipArchiveHandle* handle);
+
+  // Returns a new descriptor of the uncompressed contents of zip_entry, an
+  // entry of the zip file most recently returned by get_or_open(), or -1.
+  // The contents are extracted into cache_path if it isn't empty, and into
+  // memory otherwise.
+  int get_extracted(ZipEntry* zip_entry, const std::string& cache_path);
+
+  // Closes all the zip files, and the extracted files no library is loaded from.
+  void clear();
  private:
   DISALLOW_COPY_AND_ASSIGN(ZipArchiveCache);
 
-  std::unordered_map<std::string, ZipArchiveHandle> cache_;
+  struct extracted_entry {
+    off64_t offset;  // Of the entry's data in the zip file.
+    int fd;
+  };
+
+  struct entry {
+    dev_t dev;
+    ino_t ino;
+    off64_t size;
+    timespec mtime;
+    uint64_t last_use;
+    ZipArchiveHandle handle;
+    std::vector<extracted_entry> extracted;
+  };
+
+  // Closes the zip file and moves the extracted files still in use to retained_.
+  void release_entry(entry* e);
+  static bool is_loaded(int fd);
+  static int extract_to_memory(ZipArchiveHandle handle, ZipEntry* zip_entry);
+  static int extract_to_cache(const entry& e, ZipEntry* zip_entry, const std::string& cache_path);
+
+  static bool is_same_file(const entry& e, const struct stat& st) {
+    return e.dev == st.st_dev &&
+           e.ino == st.st_ino &&
+           e.size == st.st_size &&
+           e.mtime.tv_sec == st.st_mtim.tv_sec &&
+           e.mtime.tv_nsec == st.st_mtim.tv_nsec;
+  }
+
+  std::vector<entry> entries_;
+  // The extracted files of closed zip files, with handle set to nullptr.
+  std::vector<entry> retained_;
+  uint64_t use_count_;
+  // Only valid until the next call to get_or_open() or clear().
+  entry* last_;
 };
 
-bool ZipArchiveCache::get_or_open(const char* zip_path, ZipArchiveHandle* handle) {
-  std::string key(zip_path);
+bool ZipArchiveCache::get_or_open(const char* zip_path, int fd, ZipArchiveHandle* handle) {
+  struct stat file_stat;
+  if (TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) != 0) {
+    return false;
+  }
 
-  auto it = cache_.find(key);
-  if (it != cache_.end()) {
-    *handle = it->second;
-    return true;
+  last_ = nullptr;
+  for (auto& e : entries_) {
+    if (is_same_file(e, file_stat)) {
+      e.last_use = ++use_count_;
+      *handle = e.handle;
+      last_ = &e;
+      return true;
+    }
   }
 
-  int fd = TEMP_FAILURE_RETRY(open(zip_path, O_RDONLY | O_CLOEXEC));
-  if (fd == -1) {
+  // The archive keeps its own descriptor open.
+  int archive_fd = TEMP_FAILURE_RETRY(open(zip_path, O_RDONLY | O_CLOEXEC));
+  if (archive_fd == -1) {
     return false;
   }
 
-  if (OpenArchiveFd(fd, "", handle) != 0) {
+  if (OpenArchiveFd(archive_fd, "", handle) != 0) {
     // invalid zip-file (?)
-    CloseArchive(handle);
-    close(fd);
+    CloseArchive(*handle);
     return false;
   }
 
-  cache_[key] = *handle;
+  if (entries_.size() == kMaxEntries) {
+    auto lru = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->last_use < lru->last_use) {
+        lru = it;
+      }
+    }
+    release_entry(&*lru);
+    entries_.erase(lru);
+  }
+
+  entry e;
+  e.dev = file_stat.st_dev;
+  e.ino = file_stat.st_ino;
+  e.size = file_stat.st_size;
+  e.mtime = file_stat.st_mtim;
+  e.last_use = ++use_count_;
+  e.handle = *handle;
+  for (auto it = retained_.begin(); it != retained_.end(); ++it) {
+    if (is_same_file(*it, file_stat)) {
+      e.extracted = std::move(it->extracted);
+      retained_.erase(it);
+      break;
+    }
+  }
+  entries_.push_back(std::move(e));
+  last_ = &entries_.back();
   return true;
 }
 
-ZipArchiveCache::~ZipArchiveCache() {
-  for (const auto& it : cache_) {
-    CloseArchive(it.second);
+bool ZipArchiveCache::is_loaded(int fd) {
+  struct stat file_stat;
+  if (TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) != 0) {
+    return false;
+  }
+
+  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
+    if (si->get_st_dev() == file_stat.st_dev && si->get_st_ino() == file_stat.st_ino) {
+      return true;
+    }
   }
+  return false;
 }
 
-static int open_library_in_zipfile(ZipArchiveCache* zip_archive_cache,
+void ZipArchiveCache::release_entry(entry* e) {
+  if (e->handle != nullptr) {
+    CloseArchive(e->handle);
+    e->handle = nullptr;
+  }
+
+  std::vector<extracted_entry> in_use;
+  for (const auto& x : e->extracted) {
+    if (is_loaded(x.fd)) {
+      in_use.push_back(x);
+    } else {
+      close(x.fd);
+    }
+  }
+
+  if (!in_use.empty()) {
+    entry r = *e;
+    r.extracted = std::move(in_use);
+    retained_.push_back(std::move(r));
+  }
+}
+
+int ZipArchiveCache::extract_to_memory(ZipArchiveHandle handle, ZipEntry* zip_entry) {
+  int fd = syscall(__NR_memfd_create, "linker zip entry", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd == -1) {
+    return -1;
+  }
+
+  // Seal the contents once they are written, so that the file can be mapped
+  // like any other library.
+  if (ExtractEntryToFile(handle, zip_entry, fd) != 0 ||
+      fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+int ZipArchiveCache::extract_to_cache(const entry& e, ZipEntry* zip_entry,
+                                      const std::string& cache_path) {
+  std::string cache_file = android::base::StringPrintf(
+      "%s/%" PRIx64 "-%" PRIx64 "-%" PRIx64 "-%" PRIx64 ".%09ld-%" PRIx64 ".so",
+      cache_path.c_str(),
+      static_cast<uint64_t>(e.dev),
+      static_cast<uint64_t>(e.ino),
+      static_cast<uint64_t>(e.size),
+      static_cast<uint64_t>(e.mtime.tv_sec),
+      e.mtime.tv_nsec,
+      static_cast<uint64_t>(zip_entry->offset));
+
+  int fd = TEMP_FAILURE_RETRY(open(cache_file.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd != -1) {
+    struct stat file_stat;
+    if (TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) == 0 &&
+        file_stat.st_size == static_cast<off64_t>(zip_entry->uncompressed_length)) {
+      TRACE("[ using extracted \"%s\" ]", cache_file.c_str());
+      return fd;
+    }
+    close(fd);
+    INFO("[ ignoring \"%s\": wrong size ]", cache_file.c_str());
+  } else if (errno != ENOENT) {
+    INFO("[ can't open \"%s\": %s ]", cache_file.c_str(), strerror(errno));
+    return -1;
+  }
+
+  // Write to a private file and rename it into place, so that other processes
+  // never map a partially written file.
+  std::string temp_file = android::base::StringPrintf("%s.%d.tmp", cache_file.c_str(), getpid());
+  fd = TEMP_FAILURE_RETRY(open(temp_file.c_str(),
+                               O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644));
+  if (fd == -1) {
+    INFO("[ can't create \"%s\": %s ]", temp_file.c_str(), strerror(errno));
+    return -1;
+  }
+
+  if (ExtractEntryToFile(e.handle, zip_entry, fd) != 0 ||
+      rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+    INFO("[ failed extracting \"%s\" ]", cache_file.c_str());
+    unlink(temp_file.c_str());
+    close(fd);
+    return -1;
+  }
+
+  TRACE("[ extracted \"%s\" ]", cache_file.c_str());
+  return fd;
+}
+
+int ZipArchiveCache::get_extracted(ZipEntry* zip_entry, const std::string& cache_path) {
+  if (last_ == nullptr) {
+    return -1;
+  }
+
+  entry& e = *last_;
+  int fd = -1;
+  for (const auto& x : e.extracted) {
+    if (x.offset == zip_entry->offset) {
+      fd = x.fd;
+      break;
+    }
+  }
+
+  if (fd == -1) {
+    // If the cache directory can't be used the library is still loaded, just
+    // not shared with other processes.
+    if (!cache_path.empty()) {
+      fd = extract_to_cache(e, zip_entry, cache_path);
+    }
+    if (fd == -1) {
+      fd = extract_to_memory(e.handle, zip_entry);
+    }
+    if (fd == -1) {
+      return -1;
+    }
+    e.extracted.push_back({ zip_entry->offset, fd });
+  }
+
+  return fcntl(fd, F_DUPFD_CLOEXEC, 0);
+}
+
+void ZipArchiveCache::clear() {
+  std::vector<entry> entries;
+  entries.swap(entries_);
+  entries.insert(entries.end(), retained_.begin(), retained_.end());
+  retained_.clear();
+  for (auto& e : entries) {
+    release_entry(&e);
+  }
+  last_ = nullptr;
+}
+
+ZipArchiveCache::~ZipArchiveCache() {
+  clear();
+}
+
+static ZipArchiveCache g_zip_archive_cache;
+
+static int open_library_in_zipfile(android_namespace_t* ns,
+                                   ZipArchiveCache* zip_archive_cache,
                                    const char* const input_path,
                                    off64_t* file_offset, std::string* realpath) {
   std::string normalized_path;
@@ -1021,7 +1751,7 @@ static int open_library_in_zipfile(ZipArchiveCache* zip_archive_cache,
   }
 
   ZipArchiveHandle handle;
-  if (!zip_archive_cache->get_or_open(zip_path, &handle)) {
+  if (!zip_archive_cache->get_or_open(zip_path, fd, &handle)) {
     // invalid zip-file (?)
     close(fd);
     return -1;
@@ -1035,14 +1765,6 @@ static int open_library_in_zipfile(ZipArchiveCache* zip_archive_cache,
     return -1;
   }
 
-  // Check if it is properly stored
-  if (entry.method != kCompressStored || (entry.offset % PAGE_SIZE) != 0) {
-    close(fd);
-    return -1;
-  }
-
-  *file_offset = entry.offset;
-
   if (realpath_fd(fd, realpath)) {
     *realpath += separator;
   } else {
@@ -1051,6 +1773,21 @@ static int open_library_in_zipfile(ZipArchiveCache* zip_archive_cache,
     *realpath = normalized_path;
   }
 
+  // Libraries stored uncompressed at a page aligned offset are mapped from
+  // the zip file itself, the others from a copy of their contents.
+  if (entry.method == kCompressStored && (entry.offset % PAGE_SIZE) == 0) {
+    *file_offset = entry.offset;
+    return fd;
+  }
+
+  close(fd);
+  fd = zip_archive_cache->get_extracted(&entry, ns->get_zip_cache_path());
+  if (fd == -1) {
+    DL_WARN("unable to extract \"%s\" from \"%s\"", file_path, zip_path);
+    return -1;
+  }
+
+  *file_offset = 0;
   return fd;
 }
 
@@ -1064,7 +1801,22 @@ static bool format_path(char* buf, size_t buf_size, const char* path, const char
   return true;
 }
 
-static int open_library_on_paths(ZipArchiveCache* zip_archive_cache,
+// What the directories on the search paths are known to contain. These are
+// facts about the file system, so the cache is shared by all namespaces.
+static DirectoryCache g_directory_cache;
+
+// Set up by init_link_plan() for the link of the main executable only.
+static std::string g_link_plan_dir;
+static LinkPlan g_link_plan;
+static LinkPlanBuilder* g_link_plan_builder = nullptr;
+
+void do_android_trim_dlopen_caches() {
+  g_zip_archive_cache.clear();
+  g_directory_cache.clear();
+}
+
+static int open_library_on_paths(android_namespace_t* ns,
+                                 ZipArchiveCache* zip_archive_cache,
                                  const char* name, off64_t* file_offset,
                                  const std::vector<std::string>& paths,
                                  std::string* realpath) {
@@ -1075,8 +1827,11 @@ static int open_library_on_paths(ZipArchiveCache* zip_archive_cache,
     }
 
     int fd = -1;
-    if (strstr(buf, kZipFileSeparator) != nullptr) {
-      fd = open_library_in_zipfile(zip_archive_cache, buf, file_offset, realpath);
+    bool in_zip = strstr(buf, kZipFileSeparator) != nullptr;
+    if (in_zip) {
+      fd = open_library_in_zipfile(ns, zip_archive_cache, buf, file_offset, realpath);
+    } else if (!g_directory_cache.may_contain(path, name)) {
+      continue;
     }
 
     if (fd == -1) {
@@ -1087,6 +1842,8 @@ static int open_library_on_paths(ZipArchiveCache* zip_archive_cache,
           PRINT("warning: unable to get realpath for the library \"%s\". Will use given path.", buf);
           *realpath = buf;
         }
+      } else if (!in_zip && errno == ENOENT) {
+        g_directory_cache.record_miss(path);
       }
     }
 
@@ -1109,7 +1866,7 @@ static int open_library(android_namespace_t* ns,
     int fd = -1;
 
     if (strstr(name, kZipFileSeparator) != nullptr) {
-      fd = open_library_in_zipfile(zip_archive_cache, name, file_offset, realpath);
+      fd = open_library_in_zipfile(ns, zip_archive_cache, name, file_offset, realpath);
     }
 
     if (fd == -1) {
@@ -1127,9 +1884,9 @@ static int open_library(android_namespace_t* ns,
   }
 
   // Otherwise we try LD_LIBRARY_PATH first, and fall back to the default library path
-  int fd = open_library_on_paths(zip_archive_cache, name, file_offset, ns->get_ld_library_paths(), realpath);
+  int fd = open_library_on_paths(ns, zip_archive_cache, name, file_offset, ns->get_ld_library_paths(), realpath);
   if (fd == -1 && needed_by != nullptr) {
-    fd = open_library_on_paths(zip_archive_cache, name, file_offset, needed_by->get_dt_runpath(), realpath);
+    fd = open_library_on_paths(ns, zip_archive_cache, name, file_offset, needed_by->get_dt_runpath(), realpath);
     // Check if the library is accessible
     if (fd != -1 && !ns->is_accessible(*realpath)) {
       fd = -1;
@@ -1137,13 +1894,13 @@ static int open_library(android_namespace_t* ns,
   }
 
   if (fd == -1) {
-    fd = open_library_on_paths(zip_archive_cache, name, file_offset, ns->get_default_library_paths(), realpath);
+    fd = open_library_on_paths(ns, zip_archive_cache, name, file_offset, ns->get_default_library_paths(), realpath);
   }
 
   // TODO(dimitry): workaround for http://b/26394120 (the grey-list)
   if (fd == -1 && ns->is_greylist_enabled() && is_greylisted(ns, name, needed_by)) {
     // try searching for it on default_namespace default_library_path
-    fd = open_library_on_paths(zip_archive_cache, name, file_offset,
+    fd = open_library_on_paths(ns, zip_archive_cache, name, file_offset,
                                g_default_namespace.get_default_library_paths(), realpath);
   }
   // END OF WORKAROUND
@@ -1208,6 +1965,35 @@ static bool find_loaded_library_by_inode(android_namespace_t* ns,
   return *candidate != nullptr;
 }
 
+// Looks for a copy of the file that a namespace other than ns has already loaded and linked,
+// for namespaces that share libraries. Both namespaces have to have sharing enabled, and the
+// file has to be one that ns could load itself. The copy keeps the dependencies it was linked
+// against in its own namespace, which is why this is opt-in.
+static soinfo* find_shareable_library(android_namespace_t* ns,
+                                      const struct stat& file_stat,
+                                      off64_t file_offset,
+                                      const std::string& realpath) {
+  if (!ns->is_library_sharing_enabled() || !ns->is_accessible(realpath)) {
+    return nullptr;
+  }
+
+  for (soinfo* si = solist_get_head(); si != nullptr; si = si->next) {
+    if (si->get_st_dev() != 0 &&
+        si->get_st_ino() != 0 &&
+        si->get_st_dev() == file_stat.st_dev &&
+        si->get_st_ino() == file_stat.st_ino &&
+        si->get_file_offset() == file_offset &&
+        si->is_linked() &&
+        !si->is_main_executable() &&
+        si->get_primary_namespace() != ns &&
+        si->get_primary_namespace()->is_library_sharing_enabled()) {
+      return si;
+    }
+  }
+
+  return nullptr;
+}
+
 static bool load_library(android_namespace_t* ns,
                          LoadTask* task,
                          LoadTaskList* load_tasks,
@@ -1248,6 +2034,17 @@ static bool load_library(android_namespace_t* ns,
       task->set_soinfo(si);
       return true;
     }
+
+    si = find_shareable_library(ns, file_stat, file_offset, realpath);
+    if (si != nullptr) {
+      TRACE("library \"%s\" is already loaded as \"%s\" in namespace \"%s\" - "
+            "will share it with namespace \"%s\"", name, si->get_realpath(),
+            si->get_primary_namespace()->get_name(), ns->get_name());
+      ns->add_soinfo(si);
+      si->add_secondary_namespace(ns);
+      task->set_soinfo(si);
+      return true;
+    }
   }
 
   if ((rtld_flags & RTLD_NOLOAD) != 0) {
@@ -1341,6 +2138,29 @@ static bool load_library(android_namespace_t* ns,
   return true;
 }
 
+static void record_link_plan_library(const char* name,
+                                     soinfo* needed_by,
+                                     int fd,
+                                     off64_t file_offset,
+                                     const std::string& realpath) {
+  struct stat file_stat;
+  if (file_offset != 0 ||
+      strstr(realpath.c_str(), kZipFileSeparator) != nullptr ||
+      TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) != 0) {
+    return;
+  }
+
+  // A library added to one of the directories searched before this one
+  // would change the result, so all of them have to stay the same.
+  if (needed_by != nullptr) {
+    for (const auto& path : needed_by->get_dt_runpath()) {
+      g_link_plan_builder->add_file(path);
+    }
+  }
+
+  g_link_plan_builder->add_library(name, realpath, file_stat);
+}
+
 static bool load_library(android_namespace_t* ns,
                          LoadTask* task,
                          ZipArchiveCache* zip_archive_cache,
@@ -1371,12 +2191,25 @@ static bool load_library(android_namespace_t* ns,
   }
 
   // Open the file.
-  int fd = open_library(ns, zip_archive_cache, name, needed_by, &file_offset, &realpath);
+  int fd = -1;
+  if (ns == &g_default_namespace && g_link_plan.is_loaded()) {
+    fd = g_link_plan.open_library(name, &realpath);
+    file_offset = 0;
+  }
+
+  if (fd == -1) {
+    fd = open_library(ns, zip_archive_cache, name, needed_by, &file_offset, &realpath);
+  }
+
   if (fd == -1) {
     DL_ERR("library \"%s\" not found", name);
     return false;
   }
 
+  if (g_link_plan_builder != nullptr && ns == &g_default_namespace) {
+    record_link_plan_library(name, needed_by, fd, file_offset, realpath);
+  }
+
   task->set_fd(fd, true);
   task->set_file_offset(file_offset);
 
@@ -1499,7 +2332,12 @@ static bool find_library_internal(android_namespace_t* ns,
   TRACE("[ \"%s\" find_loaded_library_by_soname failed (*candidate=%s@%p). Trying harder...]",
       task->get_name(), candidate == nullptr ? "n/a" : candidate->get_realpath(), candidate);
 
+  uint64_t open_start_ns = get_monotonic_time_ns();
   if (load_library(ns, task, zip_archive_cache, load_tasks, rtld_flags, search_linked_namespaces)) {
+    soinfo* si = task->get_soinfo();
+    if (!si->is_linked()) {
+      si->get_load_times()->open_ns = get_monotonic_time_ns() - open_start_ns;
+    }
     return true;
   }
 
@@ -1582,6 +2420,7 @@ bool find_libraries(android_namespace_t* ns,
                     bool add_as_children,
                     bool search_linked_namespaces) {
   // Step 0: prepare.
+  g_directory_cache.new_epoch();
   LoadTaskList load_tasks;
   std::unordered_map<const soinfo*, ElfReader> readers_map;
 
@@ -1620,7 +2459,8 @@ bool find_libraries(android_namespace_t* ns,
     soinfo_unload(soinfos, soinfos_count);
   });
 
-  ZipArchiveCache zip_archive_cache;
+  const bool readahead = extinfo != nullptr &&
+                         (extinfo->flags & ANDROID_DLEXT_READAHEAD_DEPENDENCIES) != 0;
 
   // Step 1: expand the list of load_tasks to include
   // all DT_NEEDED libraries (do not load them just yet)
@@ -1634,7 +2474,7 @@ bool find_libraries(android_namespace_t* ns,
 
     if (!find_library_internal(ns,
                                task,
-                               &zip_archive_cache,
+                               &g_zip_archive_cache,
                                &load_tasks,
                                rtld_flags,
                                search_linked_namespaces || is_dt_needed)) {
@@ -1643,6 +2483,12 @@ bool find_libraries(android_namespace_t* ns,
 
     soinfo* si = task->get_soinfo();
 
+    // Start the reads now so they overlap with the
+    // rest of the walk and with each other.
+    if (readahead && !si->is_linked()) {
+      task->readahead();
+    }
+
     if (is_dt_needed) {
       needed_by->add_child(si);
 
@@ -1677,17 +2523,42 @@ bool find_libraries(android_namespace_t* ns,
   }
   shuffle(&load_list);
 
+  bool any_readahead = false;
   for (auto&& task : load_list) {
+    uint64_t map_start_ns = get_monotonic_time_ns();
     if (!task->load()) {
       return false;
     }
+
+    soinfo* si = task->get_soinfo();
+    si->get_load_times()->map_ns = get_monotonic_time_ns() - map_start_ns;
+    if (si->get_primary_namespace()->is_readahead_enabled()) {
+      phdr_table_readahead_dynamic_and_relro(si->phdr, si->phnum, si->load_bias,
+                                             &g_readahead_stats);
+      any_readahead = true;
+    }
   }
 
   // Step 3: pre-link all DT_NEEDED libraries in breadth first order.
   for (auto&& task : load_tasks) {
     soinfo* si = task->get_soinfo();
-    if (!si->is_linked() && !si->prelink_image()) {
-      return false;
+    if (!si->is_linked()) {
+      uint64_t prelink_start_ns = get_monotonic_time_ns();
+      if (!si->prelink_image() || !register_soinfo_tls(si)) {
+        return false;
+      }
+      si->get_load_times()->prelink_ns = get_monotonic_time_ns() - prelink_start_ns;
+    }
+  }
+
+  // Readahead the tables relocation is going to read for all libraries
+  // first, so that their I/O overlaps rather than happening library by library.
+  if (any_readahead) {
+    for (auto&& task : load_list) {
+      soinfo* si = task->get_soinfo();
+      if (si->get_primary_namespace()->is_readahead_enabled()) {
+        si->readahead_link_regions(&g_readahead_stats);
+      }
     }
   }
 
@@ -1716,17 +2587,55 @@ bool find_libraries(android_namespace_t* ns,
     }
   });
 
+  struct rusage usage_before = {};
+  if (any_readahead) {
+    getrusage(RUSAGE_THREAD, &usage_before);
+  }
+
+  // Lazy binding is asked for either by the caller or, for RTLD_LAZY, by
+  // the namespace configuration. LD_BIND_NOW always wins.
+  bool lazy_binding = !g_ld_bind_now &&
+      ((extinfo != nullptr && (extinfo->flags & ANDROID_DLEXT_LAZY_BINDING) != 0) ||
+       (ns->is_lazy_binding_enabled() && (rtld_flags & RTLD_LAZY) != 0 &&
+        (rtld_flags & RTLD_NOW) == 0));
+
+  soinfo_list_t newly_linked;
   bool linked = local_group.visit([&](soinfo* si) {
     if (!si->is_linked()) {
-      if (!si->link_image(global_group, local_group, extinfo) ||
-          !get_cfi_shadow()->AfterLoad(si, solist_get_head())) {
+      if (lazy_binding) {
+        si->set_lazy_bind_namespace(ns);
+      }
+      uint64_t relocate_start_ns = get_monotonic_time_ns();
+      if (!si->link_image(global_group, local_group, extinfo)) {
         return false;
       }
+      si->get_load_times()->relocate_ns = get_monotonic_time_ns() - relocate_start_ns;
+      newly_linked.push_back(si);
     }
 
     return true;
   });
 
+  // The CFI shadow for the whole group is updated at once; constructors have not run yet.
+  if (linked && !get_cfi_shadow()->AfterLoad(newly_linked, solist_get_head())) {
+    linked = false;
+  }
+  // As is gdb's list, before any constructor can hit a breakpoint.
+  if (linked) {
+    notify_gdb_of_loads(newly_linked);
+  }
+  newly_linked.clear();
+
+  if (any_readahead) {
+    struct rusage usage_after;
+    getrusage(RUSAGE_THREAD, &usage_after);
+    g_readahead_stats.major_faults += usage_after.ru_majflt - usage_before.ru_majflt;
+    TRACE("[ readahead: %zu libraries, %zu regions, %zu pages (%zu not resident), "
+          "%zu major faults during relocation so far ]",
+          g_readahead_stats.libraries, g_readahead_stats.regions, g_readahead_stats.pages,
+          g_readahead_stats.nonresident_pages, g_readahead_stats.major_faults);
+  }
+
   if (linked) {
     local_group.for_each([](soinfo* si) {
       if (!si->is_linked()) {
@@ -1767,7 +2676,19 @@ static soinfo* find_library(android_namespace_t* ns,
   return si;
 }
 
-static void soinfo_unload(soinfo* root) {
+// The libraries one dlclose (or failed dlopen) unloads. Each load group has its destructors run
+// and is unlinked as it is reached, but the work that needs system calls -- clearing the CFI
+// shadow, telling gdb and returning the address space -- is done once for all of them at the end,
+// since a library often takes dozens of dependencies with it.
+struct soinfo_unload_batch {
+  soinfo_list_t unloaded;
+  // Ones that were not in solist. As before, they are unmapped but their soinfo is left alone.
+  soinfo_list_t stray;
+};
+
+static void soinfo_unload_collect(soinfo* soinfos[], size_t count, soinfo_unload_batch* batch);
+
+static void soinfo_unload_collect(soinfo* root, soinfo_unload_batch* batch) {
   if (root->is_linked()) {
     root = root->get_local_group_root();
   }
@@ -1779,10 +2700,10 @@ static void soinfo_unload(soinfo* root) {
     return;
   }
 
-  soinfo_unload(&root, 1);
+  soinfo_unload_collect(&root, 1, batch);
 }
 
-static void soinfo_unload(soinfo* soinfos[], size_t count) {
+static void soinfo_unload_collect(soinfo* soinfos[], size_t count, soinfo_unload_batch* batch) {
   // Note that the library can be loaded but not linked;
   // in which case there is no root but we still need
   // to walk the tree and unload soinfos involved.
@@ -1876,21 +2797,88 @@ static void soinfo_unload(soinfo* soinfos[], size_t count) {
     }
   }
 
+  uint64_t destructors_start_ns = get_monotonic_time_ns();
   local_unload_list.for_each([](soinfo* si) {
     si->call_destructors();
   });
+  g_unload_stats.destructors_ns += get_monotonic_time_ns() - destructors_start_ns;
 
   while ((si = local_unload_list.pop_front()) != nullptr) {
-    notify_gdb_of_unload(si);
-    get_cfi_shadow()->BeforeUnload(si);
-    soinfo_free(si);
+    if (!soinfo_unlink(si)) {
+      batch->stray.push_back(si);
+    }
+    batch->unloaded.push_back(si);
   }
 
   while ((si = external_unload_list.pop_front()) != nullptr) {
-    soinfo_unload(si);
+    soinfo_unload_collect(si, batch);
   }
 }
 
+static void soinfo_unload_release(soinfo_unload_batch* batch, uint64_t start_ns) {
+  soinfo_list_t& unloaded = batch->unloaded;
+  if (unloaded.empty()) {
+    return;
+  }
+
+  get_cfi_shadow()->BeforeUnload(unloaded);
+
+  std::vector<link_map*> maps;
+  unloaded.for_each([&](soinfo* si) {
+    maps.push_back(&si->link_map_head);
+  });
+  notify_gdb_of_unloads(maps.data(), maps.size());
+
+  // Libraries loaded one after the other usually sit next to each other, so neighbouring
+  // ranges are returned with a single munmap.
+  std::vector<std::pair<ElfW(Addr), size_t>> ranges;
+  unloaded.for_each([&](soinfo* si) {
+    if (si->base != 0 && si->size != 0 && !si->is_mapped_by_caller()) {
+      ranges.emplace_back(si->base, si->size);
+    } else {
+      soinfo_unmap(si);
+    }
+  });
+  std::sort(ranges.begin(), ranges.end());
+  for (size_t i = 0; i < ranges.size(); ) {
+    ElfW(Addr) start = ranges[i].first;
+    ElfW(Addr) end = start + ranges[i].second;
+    for (++i; i < ranges.size() && ranges[i].first == end; ++i) {
+      end += ranges[i].second;
+    }
+    munmap(reinterpret_cast<void*>(start), end - start);
+  }
+
+  size_t library_count = 0;
+  soinfo* si = nullptr;
+  while ((si = unloaded.pop_front()) != nullptr) {
+    TRACE("name %s: freeing soinfo @ %p", si->get_realpath(), si);
+    if (!batch->stray.contains(si)) {
+      soinfo_destroy(si);
+    }
+    ++library_count;
+  }
+  batch->stray.clear();
+
+  ++g_unload_stats.unloads;
+  g_unload_stats.libraries += library_count;
+  g_unload_stats.unload_ns += get_monotonic_time_ns() - start_ns;
+}
+
+static void soinfo_unload(soinfo* root) {
+  uint64_t start_ns = get_monotonic_time_ns();
+  soinfo_unload_batch batch;
+  soinfo_unload_collect(root, &batch);
+  soinfo_unload_release(&batch, start_ns);
+}
+
+static void soinfo_unload(soinfo* soinfos[], size_t count) {
+  uint64_t start_ns = get_monotonic_time_ns();
+  soinfo_unload_batch batch;
+  soinfo_unload_collect(soinfos, count, &batch);
+  soinfo_unload_release(&batch, start_ns);
+}
+
 static std::string symbol_display_name(const char* sym_name, const char* sym_ver) {
   if (sym_ver == nullptr) {
     return sym_name;
@@ -1959,6 +2947,21 @@ static std::string android_dlextinfo_to_string(const android_dlextinfo* info) {
                                         info->library_namespace : nullptr);
 }
 
+// Marks every library in the tree whose constructors have not run yet so
+// that do_dlsym() runs them the first time it returns one of their symbols.
+// Libraries that are already initialized (and hence their dependencies) are
+// left alone.
+static void defer_constructors(soinfo* root) {
+  walk_dependencies_tree(&root, 1, [](soinfo* si) {
+    if (si->constructors_called) {
+      return kWalkSkip;
+    }
+
+    si->set_constructors_deferred();
+    return kWalkContinue;
+  });
+}
+
 void* do_dlopen(const char* name, int flags,
                 const android_dlextinfo* extinfo,
                 const void* caller_addr) {
@@ -2036,10 +3039,17 @@ void* do_dlopen(const char* name, int flags,
 
   if (si != nullptr) {
     void* handle = si->to_handle();
-    LD_LOG(kLogDlopen,
-           "... dlopen calling constructors: realpath=\"%s\", soname=\"%s\", handle=%p",
-           si->get_realpath(), si->get_soname(), handle);
-    si->call_constructors();
+    if (extinfo != nullptr && (extinfo->flags & ANDROID_DLEXT_LAZY_CONSTRUCTORS) != 0) {
+      LD_LOG(kLogDlopen,
+             "... dlopen deferring constructors: realpath=\"%s\", soname=\"%s\", handle=%p",
+             si->get_realpath(), si->get_soname(), handle);
+      defer_constructors(si);
+    } else {
+      LD_LOG(kLogDlopen,
+             "... dlopen calling constructors: realpath=\"%s\", soname=\"%s\", handle=%p",
+             si->get_realpath(), si->get_soname(), handle);
+      si->call_constructors();
+    }
     failure_guard.disable();
     LD_LOG(kLogDlopen,
            "... dlopen successful: realpath=\"%s\", soname=\"%s\", handle=%p",
@@ -2086,12 +3096,27 @@ static soinfo* soinfo_from_handle(void* handle) {
   return static_cast<soinfo*>(handle);
 }
 
-bool do_dlsym(void* handle,
-              const char* sym_name,
-              const char* sym_ver,
-              const void* caller_addr,
-              void** symbol) {
+// The address dlsym returns for a symbol: for a TLS variable, that's the calling
+// thread's copy.
+static void* get_dlsym_address(const soinfo* found, const ElfW(Sym)* sym) {
+  if (ELF_ST_TYPE(sym->st_info) == STT_TLS) {
+    const soinfo_tls* tls = found->get_tls();
+    if (tls == nullptr || tls->module_id == kTlsUninitializedModuleId) {
+      return nullptr;
+    }
+    const TlsIndex ti = { tls->module_id, sym->st_value };
+    return __tls_get_addr(&ti);
+  }
+  return reinterpret_cast<void*>(found->resolve_symbol_address(sym));
+}
+
+static bool dlsym_symbol(void* handle,
+                         SymbolName& symbol_name,
+                         const char* sym_ver,
+                         const void* caller_addr,
+                         void** symbol) {
   ScopedTrace trace("dlsym");
+  const char* sym_name = symbol_name.get_name();
 #if !defined(__LP64__)
   if (handle == nullptr) {
     DL_ERR("dlsym failed: library handle is null");
@@ -2137,20 +3162,26 @@ bool do_dlsym(void* handle,
   }
 
   if (handle == RTLD_DEFAULT || handle == RTLD_NEXT) {
-    sym = dlsym_linear_lookup(ns, sym_name, vi, &found, caller, handle);
+    sym = dlsym_linear_lookup(ns, symbol_name, vi, &found, caller, handle);
   } else {
     if (si == nullptr) {
       DL_ERR("dlsym failed: invalid handle: %p", handle);
       return false;
     }
-    sym = dlsym_handle_lookup(si, &found, sym_name, vi);
+    sym = dlsym_handle_lookup(si, &found, symbol_name, vi);
   }
 
   if (sym != nullptr) {
     uint32_t bind = ELF_ST_BIND(sym->st_info);
 
     if ((bind == STB_GLOBAL || bind == STB_WEAK) && sym->st_shndx != 0) {
-      *symbol = reinterpret_cast<void*>(found->resolve_symbol_address(sym));
+      if (found->has_deferred_constructors()) {
+        LD_LOG(kLogDlsym, "... dlsym calling deferred constructors of \"%s\"",
+               found->get_realpath());
+        ProtectedDataGuard guard;
+        found->call_constructors();
+      }
+      *symbol = get_dlsym_address(found, sym);
       failure_guard.disable();
       LD_LOG(kLogDlsym,
              "... dlsym successful: sym_name=\"%s\", sym_ver=\"%s\", found in=\"%s\", address=%p",
@@ -2166,6 +3197,128 @@ bool do_dlsym(void* handle,
   return false;
 }
 
+bool do_dlsym(void* handle,
+              const char* sym_name,
+              const char* sym_ver,
+              const void* caller_addr,
+              void** symbol) {
+  SymbolName symbol_name(sym_name);
+  return dlsym_symbol(handle, symbol_name, sym_ver, caller_addr, symbol);
+}
+
+bool do_dlsym_hashed(void* handle,
+                     const char* sym_name,
+                     uint32_t gnu_hash,
+                     const void* caller_addr,
+                     void** symbol) {
+  SymbolName symbol_name(sym_name, gnu_hash);
+  return dlsym_symbol(handle, symbol_name, nullptr, caller_addr, symbol);
+}
+
+int do_dlsym_many(void* handle,
+                  const char* const sym_names[],
+                  void* symbols[],
+                  size_t count,
+                  const void* caller_addr) {
+  ScopedTrace trace("dlsym_many");
+  for (size_t i = 0; i < count; ++i) {
+    symbols[i] = nullptr;
+  }
+
+  soinfo* si = nullptr;
+  if (handle != RTLD_DEFAULT && handle != RTLD_NEXT) {
+    si = soinfo_from_handle(handle);
+    if (si == nullptr) {
+      DL_ERR("dlsym failed: invalid handle: %p", handle);
+      return -1;
+    }
+  }
+
+  int found_count = 0;
+
+  // These are not a walk of a dependency tree, see dlsym_handle_lookup().
+  if (si == nullptr || si == solist_get_somain()) {
+    for (size_t i = 0; i < count; ++i) {
+      if (do_dlsym(handle, sym_names[i], nullptr, caller_addr, &symbols[i])) {
+        ++found_count;
+      }
+    }
+    return found_count;
+  }
+
+  LD_LOG(kLogDlsym, "dlsym_many(handle=%p(\"%s\"), count=%zu) ...",
+         handle, si->get_realpath(), count);
+
+  std::vector<soinfo*> found(count, nullptr);
+  std::vector<const ElfW(Sym)*> syms(count, nullptr);
+  std::vector<std::unique_ptr<SymbolName>> pending(count);
+  size_t pending_count = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    if (sym_names[i] != nullptr &&
+        !g_dlsym_cache.find(si, sym_names[i], nullptr, &found[i], &syms[i])) {
+      pending[i].reset(new SymbolName(sym_names[i]));
+      ++pending_count;
+    }
+  }
+
+  // One pass over the libraries of the handle for all the symbols that are not
+  // cached. Each symbol is resolved to the first library in breadth-first
+  // order that has it, the same one dlsym_handle_lookup() would find.
+  if (pending_count > 0) {
+    for (soinfo* current_soinfo : g_dlsym_cache.get_lookup_order(si)) {
+      for (size_t i = 0; i < count; ++i) {
+        if (pending[i] == nullptr) {
+          continue;
+        }
+
+        const ElfW(Sym)* sym = nullptr;
+        if (!current_soinfo->find_symbol_by_name(*pending[i], nullptr, &sym) || sym != nullptr) {
+          if (sym != nullptr) {
+            found[i] = current_soinfo;
+            syms[i] = sym;
+          }
+          pending[i].reset();
+          --pending_count;
+        }
+      }
+
+      if (pending_count == 0) {
+        break;
+      }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      if (sym_names[i] != nullptr) {
+        g_dlsym_cache.insert(si, sym_names[i], nullptr, found[i], syms[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    const ElfW(Sym)* sym = syms[i];
+    if (sym == nullptr) {
+      continue;
+    }
+
+    uint32_t bind = ELF_ST_BIND(sym->st_info);
+    if ((bind != STB_GLOBAL && bind != STB_WEAK) || sym->st_shndx == 0) {
+      continue;
+    }
+
+    if (found[i]->has_deferred_constructors()) {
+      ProtectedDataGuard guard;
+      found[i]->call_constructors();
+    }
+
+    symbols[i] = get_dlsym_address(found[i], sym);
+    ++found_count;
+  }
+
+  LD_LOG(kLogDlsym, "... dlsym_many resolved %d of %zu symbols", found_count, count);
+  return found_count;
+}
+
 int do_dlclose(void* handle) {
   ScopedTrace trace("dlclose");
   ProtectedDataGuard guard;
@@ -2176,6 +3329,11 @@ int do_dlclose(void* handle) {
   }
 
   soinfo_unload(si);
+#if STATS
+  PRINT("UNLOAD STATS: %zu unloads, %zu libraries, %" PRIu64 " ns (%" PRIu64 " ns in destructors)",
+        g_unload_stats.unloads, g_unload_stats.libraries, g_unload_stats.unload_ns,
+        g_unload_stats.destructors_ns);
+#endif
   return 0;
 }
 
@@ -2250,6 +3408,11 @@ android_namespace_t* create_namespace(const void* caller_addr,
   ns->set_name(name);
   ns->set_isolated((type & ANDROID_NAMESPACE_TYPE_ISOLATED) != 0);
   ns->set_greylist_enabled((type & ANDROID_NAMESPACE_TYPE_GREYLIST_ENABLED) != 0);
+  ns->set_readahead_enabled(parent_namespace->is_readahead_enabled());
+  ns->set_library_sharing_enabled(parent_namespace->is_library_sharing_enabled());
+  ns->set_lazy_binding_enabled(parent_namespace->is_lazy_binding_enabled());
+  ns->set_relro_cache_path(parent_namespace->get_relro_cache_path());
+  ns->set_zip_cache_path(parent_namespace->get_zip_cache_path());
 
   if ((type & ANDROID_NAMESPACE_TYPE_SHARED) != 0) {
     // append parent namespace paths.
@@ -2437,6 +3600,16 @@ static bool for_each_verdef(const soinfo* si, F functor) {
   return true;
 }
 
+bool soinfo::build_verdef_index() {
+  verdef_index_.clear();
+  return for_each_verdef(this,
+    [&](size_t, const ElfW(Verdef)* verdef, const ElfW(Verdaux)* verdaux) {
+      verdef_index_.push_back({ verdef->vd_hash, verdef->vd_ndx, get_string(verdaux->vda_name) });
+      return false;
+    }
+  );
+}
+
 bool find_verdef_version_index(const soinfo* si, const version_info* vi, ElfW(Versym)* versym) {
   if (vi == nullptr) {
     *versym = kVersymNotNeeded;
@@ -2445,17 +3618,17 @@ bool find_verdef_version_index(const soinfo* si, const version_info* vi, ElfW(Ve
 
   *versym = kVersymGlobal;
 
-  return for_each_verdef(si,
-    [&](size_t, const ElfW(Verdef)* verdef, const ElfW(Verdaux)* verdaux) {
-      if (verdef->vd_hash == vi->elf_hash &&
-          strcmp(vi->name, si->get_string(verdaux->vda_name)) == 0) {
-        *versym = verdef->vd_ndx;
-        return true;
-      }
-
-      return false;
+  // This runs for every library a versioned reference is looked up in, so it uses the
+  // flattened DT_VERDEF. The hash is compared first; names are usually the same pointer
+  // when a library looks up one of its own versions, which saves the strcmp.
+  for (const verdef_index_entry& entry : si->get_verdef_index()) {
+    if (entry.hash == vi->elf_hash &&
+        (entry.name == vi->name || strcmp(entry.name, vi->name) == 0)) {
+      *versym = entry.index;
+      break;
     }
-  );
+  }
+  return true;
 }
 
 bool VersionTracker::init_verdef(const soinfo* si_from) {
@@ -2476,6 +3649,25 @@ bool VersionTracker::init(const soinfo* si_from) {
   return init_verneed(si_from) && init_verdef(si_from);
 }
 
+bool SymbolLookupCache::find(ElfW(Word) sym, soinfo** si_found_in, const ElfW(Sym)** symbol) {
+  if (sym >= entries_.size() || !entries_[sym].resolved) {
+    return false;
+  }
+
+  *si_found_in = entries_[sym].si_found_in;
+  *symbol = entries_[sym].symbol;
+  ++hit_count_;
+  return true;
+}
+
+void SymbolLookupCache::insert(ElfW(Word) sym, soinfo* si_found_in, const ElfW(Sym)* symbol) {
+  if (sym >= entries_.size()) {
+    entries_.resize(sym + 1, { nullptr, nullptr, false });
+  }
+
+  entries_[sym] = { si_found_in, symbol, true };
+}
+
 // TODO (dimitry): Methods below need to be moved out of soinfo
 // and in more isolated file in order minimize dependencies on
 // unnecessary object in the linker binary. Consider making them
@@ -2501,24 +3693,131 @@ bool soinfo::lookup_version_info(const VersionTracker& version_tracker, ElfW(Wor
   return true;
 }
 
+// Applies DT_RELR relocations. The section is a sequence of words: an even
+// word is the offset of the next place to relocate, and an odd word is a
+// bitmap whose bits 1..63 (1..31 on 32-bit) say which of the following words
+// after the last address also need relocating. Every place gets load_bias
+// added to the addend already stored there.
+static void apply_relr_relocs(const ElfW(Relr)* relr, size_t count, ElfW(Addr) load_bias) {
+  constexpr size_t kWordSize = sizeof(ElfW(Addr));
+  constexpr size_t kBitmapBits = 8 * kWordSize - 1;
+
+  ElfW(Addr)* where = nullptr;
+  for (size_t i = 0; i < count; ++i) {
+    ElfW(Relr) entry = relr[i];
+    if ((entry & 1) == 0) {
+      where = reinterpret_cast<ElfW(Addr)*>(load_bias + entry);
+      count_relocation(kRelocRelative);
+      MARK(entry);
+      *where++ += load_bias;
+      continue;
+    }
+    for (size_t bit = 0; (entry >>= 1) != 0; ++bit) {
+      if ((entry & 1) != 0) {
+        count_relocation(kRelocRelative);
+        MARK(reinterpret_cast<ElfW(Addr)>(where + bit) - load_bias);
+        where[bit] += load_bias;
+      }
+    }
+    where += kBitmapBits;
+  }
+}
+
 #if !defined(__mips__)
+// Applies the run of R_GENERIC_RELATIVE relocations that DT_RELACOUNT or
+// DT_RELCOUNT says the relocation table starts with. These need no symbol
+// lookup, so a loop that only does the stores is much cheaper per relocation
+// than relocate(). Stops at the first relocation of another type in case the
+// count is wrong, and returns the number of relocations applied; relocate()
+// takes care of the rest.
+#if defined(USE_RELA)
+static size_t apply_relative_relocs(const ElfW(Rela)* rela, size_t count, ElfW(Addr) load_bias) {
+  size_t i = 0;
+  for (; i < count && ELFW(R_TYPE)(rela[i].r_info) == R_GENERIC_RELATIVE; ++i) {
+    count_relocation(kRelocRelative);
+    MARK(rela[i].r_offset);
+    *reinterpret_cast<ElfW(Addr)*>(rela[i].r_offset + load_bias) = load_bias + rela[i].r_addend;
+  }
+  return i;
+}
+#else
+static size_t apply_relative_relocs(const ElfW(Rel)* rel, size_t count, ElfW(Addr) load_bias) {
+  size_t i = 0;
+  for (; i < count && ELFW(R_TYPE)(rel[i].r_info) == R_GENERIC_RELATIVE; ++i) {
+    count_relocation(kRelocRelative);
+    MARK(rel[i].r_offset);
+    *reinterpret_cast<ElfW(Addr)*>(rel[i].r_offset + load_bias) += load_bias;
+  }
+  return i;
+}
+#endif
+
 #if defined(USE_RELA)
 static ElfW(Addr) get_addend(ElfW(Rela)* rela, ElfW(Addr) reloc_addr __unused) {
   return rela->r_addend;
 }
 #else
 static ElfW(Addr) get_addend(ElfW(Rel)* rel, ElfW(Addr) reloc_addr) {
-  if (ELFW(R_TYPE)(rel->r_info) == R_GENERIC_RELATIVE ||
-      ELFW(R_TYPE)(rel->r_info) == R_GENERIC_IRELATIVE) {
-    return *reinterpret_cast<ElfW(Addr)*>(reloc_addr);
+  switch (ELFW(R_TYPE)(rel->r_info)) {
+    case R_GENERIC_RELATIVE:
+    case R_GENERIC_IRELATIVE:
+    case R_GENERIC_TLS_DTPREL:
+    case R_GENERIC_TLS_TPREL:
+#if defined(__i386__)
+    case R_386_TLS_TPOFF32:
+#endif
+      return *reinterpret_cast<ElfW(Addr)*>(reloc_addr);
+    default:
+      return 0;
   }
-  return 0;
 }
 #endif
 
+static bool is_tls_reloc(ElfW(Word) type) {
+  switch (type) {
+    case R_GENERIC_TLS_DTPMOD:
+    case R_GENERIC_TLS_DTPREL:
+    case R_GENERIC_TLS_TPREL:
+#if defined(__aarch64__)
+    case R_GENERIC_TLSDESC:
+#elif defined(__i386__)
+    case R_386_TLS_TPOFF32:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the TLS module of the library 'si' (which defines the symbol, if there is one)
+// for a TLS relocation in 'referrer'.
+static const TlsModule* get_tls_module(const soinfo* si, const soinfo* referrer) {
+  const soinfo_tls* si_tls = si->get_tls();
+  if (si_tls == nullptr || si_tls->module_id == kTlsUninitializedModuleId) {
+    DL_ERR("TLS relocation in \"%s\" refers to \"%s\", which has no TLS segment",
+           referrer->get_realpath(), si->get_realpath());
+    return nullptr;
+  }
+  return &__libc_tls_globals.tls_modules.module_table[si_tls->module_id - 1];
+}
+
+// Returns the offset of a module's TLS segment from the thread pointer, which only
+// exists for modules in static TLS (those loaded at startup).
+static bool get_static_tls_offset(const TlsModule* module, const soinfo* si, const char* sym_name,
+                                  const soinfo* referrer, ElfW(Addr)* result) {
+  if (module->static_offset == kTlsNoStaticOffset) {
+    DL_ERR("TLS symbol \"%s\" in dlopened \"%s\" referenced from \"%s\" using IE access model",
+           sym_name != nullptr ? sym_name : "(local)", si->get_realpath(), referrer->get_realpath());
+    return false;
+  }
+  *result = module->static_offset - __libc_tls_globals.static_tls_layout.tcb_offset();
+  return true;
+}
+
 template<typename ElfRelIteratorT>
 bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& rel_iterator,
-                      const soinfo_list_t& global_group, const soinfo_list_t& local_group) {
+                      const soinfo_list_t& global_group, const soinfo_list_t& local_group,
+                      SymbolLookupCache* lookup_cache) {
   for (size_t idx = 0; rel_iterator.has_next(); ++idx) {
     const auto rel = rel_iterator.next();
     if (rel == nullptr) {
@@ -2543,14 +3842,19 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
 
     if (sym != 0) {
       sym_name = get_string(symtab_[sym].st_name);
-      const version_info* vi = nullptr;
 
-      if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
-        return false;
-      }
+      if (!lookup_cache->find(sym, &lsi, &s)) {
+        const version_info* vi = nullptr;
 
-      if (!soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
-        return false;
+        if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
+          return false;
+        }
+
+        if (!soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
+          return false;
+        }
+
+        lookup_cache->insert(sym, lsi, s);
       }
 
       if (s == nullptr) {
@@ -2560,6 +3864,11 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
           DL_ERR("cannot locate symbol \"%s\" referenced by \"%s\"...", sym_name, get_realpath());
           return false;
         }
+        if (is_tls_reloc(type)) {
+          DL_ERR("TLS relocation refers to undefined weak symbol \"%s\" in \"%s\"",
+                 sym_name, get_realpath());
+          return false;
+        }
 
         /* IHI0044C AAELF 4.5.1.1:
 
@@ -2609,6 +3918,14 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
             DL_ERR("unknown weak reloc type %d @ %p (%zu)", type, rel, idx);
             return false;
         }
+      } else if (is_tls_reloc(type) != (ELF_ST_TYPE(s->st_info) == STT_TLS)) {
+        DL_ERR("%s relocation refers to %s symbol \"%s\" in \"%s\"",
+               is_tls_reloc(type) ? "TLS" : "non-TLS",
+               ELF_ST_TYPE(s->st_info) == STT_TLS ? "TLS" : "non-TLS", sym_name, get_realpath());
+        return false;
+      } else if (is_tls_reloc(type)) {
+        // The offset of the symbol in its module's TLS block.
+        sym_addr = s->st_value;
       } else { // We got a definition.
 #if !defined(__LP64__)
         // When relocating dso with text_relocation .text segment is
@@ -2637,6 +3954,9 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
 #endif
       }
       count_relocation(kRelocSymbol);
+    } else if (is_tls_reloc(type)) {
+      // A local-dynamic or local symbol access: the module is this library.
+      lsi = this;
     }
 
     switch (type) {
@@ -2699,6 +4019,92 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
         }
         break;
 
+      case R_GENERIC_TLS_DTPMOD:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        if (get_tls_module(lsi, this) == nullptr) {
+          return false;
+        }
+        TRACE_TYPE(RELO, "RELO TLS_DTPMOD %16p <- %zu %s\n",
+                   reinterpret_cast<void*>(reloc), lsi->get_tls()->module_id, sym_name);
+        *reinterpret_cast<ElfW(Addr)*>(reloc) = lsi->get_tls()->module_id;
+        break;
+      case R_GENERIC_TLS_DTPREL:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        TRACE_TYPE(RELO, "RELO TLS_DTPREL %16p <- %16p %s\n",
+                   reinterpret_cast<void*>(reloc),
+                   reinterpret_cast<void*>(sym_addr + addend), sym_name);
+        *reinterpret_cast<ElfW(Addr)*>(reloc) = sym_addr + addend;
+        break;
+      case R_GENERIC_TLS_TPREL:
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        {
+          const TlsModule* module = get_tls_module(lsi, this);
+          ElfW(Addr) tpoff;
+          if (module == nullptr ||
+              !get_static_tls_offset(module, lsi, sym_name, this, &tpoff)) {
+            return false;
+          }
+          TRACE_TYPE(RELO, "RELO TLS_TPREL %16p <- %16p %s\n",
+                     reinterpret_cast<void*>(reloc),
+                     reinterpret_cast<void*>(tpoff + sym_addr + addend), sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = tpoff + sym_addr + addend;
+        }
+        break;
+#if defined(__i386__)
+      case R_386_TLS_TPOFF32:
+        // Like R_386_TLS_TPOFF, but negated.
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        {
+          const TlsModule* module = get_tls_module(lsi, this);
+          ElfW(Addr) tpoff;
+          if (module == nullptr ||
+              !get_static_tls_offset(module, lsi, sym_name, this, &tpoff)) {
+            return false;
+          }
+          TRACE_TYPE(RELO, "RELO TLS_TPOFF32 %16p <- %16p %s\n",
+                     reinterpret_cast<void*>(reloc),
+                     reinterpret_cast<void*>(addend - (tpoff + sym_addr)), sym_name);
+          *reinterpret_cast<ElfW(Addr)*>(reloc) = addend - (tpoff + sym_addr);
+        }
+        break;
+#endif
+#if defined(__aarch64__)
+      case R_GENERIC_TLSDESC:
+        // The descriptor is a pair of words: a resolver function, which returns the
+        // variable's offset from the thread pointer, and its argument.
+        count_relocation(kRelocAbsolute);
+        MARK(rel->r_offset);
+        {
+          const TlsModule* module = get_tls_module(lsi, this);
+          if (module == nullptr) {
+            return false;
+          }
+          ElfW(Addr)* desc = reinterpret_cast<ElfW(Addr)*>(reloc);
+          ElfW(Addr) tpoff;
+          if (module->static_offset != kTlsNoStaticOffset &&
+              get_static_tls_offset(module, lsi, sym_name, this, &tpoff)) {
+            desc[0] = reinterpret_cast<ElfW(Addr)>(tlsdesc_resolver_static);
+            desc[1] = tpoff + sym_addr + addend;
+          } else {
+            TlsDynamicResolverArg arg;
+            arg.generation = module->first_generation;
+            arg.index.module_id = lsi->get_tls()->module_id;
+            arg.index.offset = sym_addr + addend;
+            tlsdesc_args_.push_back(arg);
+            desc[0] = reinterpret_cast<ElfW(Addr)>(tlsdesc_resolver_dynamic);
+            desc[1] = reinterpret_cast<ElfW(Addr)>(&tlsdesc_args_.back());
+          }
+          TRACE_TYPE(RELO, "RELO TLSDESC %16p <- %16p, %16p %s\n",
+                     reinterpret_cast<void*>(reloc), reinterpret_cast<void*>(desc[0]),
+                     reinterpret_cast<void*>(desc[1]), sym_name);
+        }
+        break;
+#endif
+
 #if defined(__aarch64__)
       case R_AARCH64_ABS64:
         count_relocation(kRelocAbsolute);
@@ -2799,14 +4205,6 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
          */
         DL_ERR("%s R_AARCH64_COPY relocations are not supported", get_realpath());
         return false;
-      case R_AARCH64_TLS_TPREL64:
-        TRACE_TYPE(RELO, "RELO TLS_TPREL64 *** %16llx <- %16llx - %16llx\n",
-                   reloc, (sym_addr + addend), rel->r_offset);
-        break;
-      case R_AARCH64_TLS_DTPREL32:
-        TRACE_TYPE(RELO, "RELO TLS_DTPREL32 *** %16llx <- %16llx - %16llx\n",
-                   reloc, (sym_addr + addend), rel->r_offset);
-        break;
 #elif defined(__x86_64__)
       case R_X86_64_32:
         count_relocation(kRelocRelative);
@@ -2880,6 +4278,160 @@ bool soinfo::relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& r
 }
 #endif  // !defined(__mips__)
 
+// Lazy binding. A library's PLT entries start out jumping to the PLT's first
+// entry, which calls pltgot_[2] with pltgot_[1] and a way of identifying the
+// entry: on x86-64 the index of its relocation, pushed on the stack; on arm64
+// the address of its GOT slot, in x16. The trampoline (arch/*/lazy_bind.S)
+// saves the argument registers and calls lazy_bind_entry() to look the
+// function up and store it in the slot, so later calls go straight there.
+//
+// Only function calls through the PLT are deferred; a function's address is
+// taken through a GLOB_DAT or ABS relocation, which is always resolved when the
+// library is linked, so the CFI shadow and pointer comparisons are unaffected.
+#if defined(__aarch64__) || defined(__x86_64__)
+extern "C" void lazy_bind_trampoline();
+#endif
+
+bool soinfo::can_bind_plt_lazily() const {
+#if defined(__aarch64__) || defined(__x86_64__)
+  if (g_ld_bind_now || bind_now_ || pltgot_ == nullptr || plt_rela_ == nullptr) {
+    return false;
+  }
+
+  // The GOT has to stay writable, so it mustn't be in GNU_RELRO. Linkers only
+  // leave it out without -z now, which sets DF_BIND_NOW anyway, but that's a
+  // default rather than a rule. (RELRO is protected a page at a time.)
+  ElfW(Addr) got_start = reinterpret_cast<ElfW(Addr)>(pltgot_);
+  ElfW(Addr) got_end = got_start + 3 * sizeof(ElfW(Addr));
+  for (size_t i = 0; i < plt_rela_count_; ++i) {
+    got_start = std::min(got_start, plt_rela_[i].r_offset + load_bias);
+    got_end = std::max(got_end, plt_rela_[i].r_offset + load_bias + sizeof(ElfW(Addr)));
+  }
+  for (size_t i = 0; i < phnum; ++i) {
+    if (phdr[i].p_type != PT_GNU_RELRO) continue;
+    ElfW(Addr) relro_start = PAGE_START(phdr[i].p_vaddr) + load_bias;
+    ElfW(Addr) relro_end = PAGE_END(phdr[i].p_vaddr + phdr[i].p_memsz) + load_bias;
+    if (got_start < relro_end && relro_start < got_end) {
+      return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool soinfo::setup_lazy_plt(const VersionTracker& version_tracker,
+                            const soinfo_list_t& global_group, const soinfo_list_t& local_group,
+                            SymbolLookupCache* lookup_cache) {
+#if defined(__aarch64__) || defined(__x86_64__)
+  pltgot_[1] = reinterpret_cast<ElfW(Addr)>(this);
+  pltgot_[2] = reinterpret_cast<ElfW(Addr)>(lazy_bind_trampoline);
+
+  for (size_t i = 0; i < plt_rela_count_; ++i) {
+    ElfW(Rela)* rel = &plt_rela_[i];
+    if (ELFW(R_TYPE)(rel->r_info) == R_GENERIC_JUMP_SLOT) {
+      // The static linker pointed the slot at the PLT code that calls the
+      // resolver, as if the library were loaded at 0.
+      count_relocation(kRelocRelative);
+      MARK(rel->r_offset);
+      *reinterpret_cast<ElfW(Addr)*>(rel->r_offset + load_bias) += load_bias;
+    } else if (!relocate(version_tracker, plain_reloc_iterator(rel, 1), global_group, local_group,
+                         lookup_cache)) {
+      // IRELATIVE and TLSDESC relocations can be in DT_JMPREL too.
+      return false;
+    }
+  }
+  return true;
+#else
+  (void) version_tracker; (void) global_group; (void) local_group; (void) lookup_cache;
+  return false;
+#endif
+}
+
+ElfW(Addr) soinfo::bind_lazy_plt_entry(ElfW(Addr) plt_arg) {
+#if defined(__aarch64__) || defined(__x86_64__)
+#if defined(__x86_64__)
+  // The PLT entry pushed the index of its relocation.
+  const ElfW(Rela)* rel = (plt_arg < plt_rela_count_) ? &plt_rela_[plt_arg] : nullptr;
+#else
+  // The PLT entry passed the address of its GOT slot. Slots and relocations are
+  // in the same order in everything we've seen, but search if that's wrong.
+  const ElfW(Rela)* rel = nullptr;
+  size_t index = (plt_arg - reinterpret_cast<ElfW(Addr)>(&pltgot_[3])) / sizeof(ElfW(Addr));
+  if (index < plt_rela_count_ && plt_rela_[index].r_offset + load_bias == plt_arg) {
+    rel = &plt_rela_[index];
+  } else {
+    for (size_t i = 0; i < plt_rela_count_ && rel == nullptr; ++i) {
+      if (plt_rela_[i].r_offset + load_bias == plt_arg) rel = &plt_rela_[i];
+    }
+  }
+#endif
+  if (rel == nullptr || ELFW(R_TYPE)(rel->r_info) != R_GENERIC_JUMP_SLOT) {
+    __libc_fatal("\"%s\": lazy binding called for unknown PLT entry %p",
+                 get_realpath(), reinterpret_cast<void*>(plt_arg));
+  }
+
+  ElfW(Word) sym = ELFW(R_SYM)(rel->r_info);
+  const char* sym_name = get_string(symtab_[sym].st_name);
+
+  // Look the symbol up as link_image() would have, in the global group of the
+  // namespace it was loaded in and the local group it was loaded with.
+  android_namespace_t* ns = lazy_bind_namespace_;
+  soinfo_list_t global_group = make_global_group(ns);
+  soinfo_list_t local_group;
+  soinfo* root = get_local_group_root();
+  walk_dependencies_tree(&root, 1, [&](soinfo* si) {
+    if (ns->is_accessible(si)) {
+      local_group.push_back(si);
+      return kWalkContinue;
+    }
+    return kWalkSkip;
+  });
+
+  VersionTracker version_tracker;
+  const version_info* vi = nullptr;
+  soinfo* lsi = nullptr;
+  const ElfW(Sym)* s = nullptr;
+  if (!version_tracker.init(this) ||
+      !lookup_version_info(version_tracker, sym, sym_name, &vi) ||
+      !soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
+    __libc_fatal("\"%s\": lazy binding of \"%s\" failed: %s",
+                 get_realpath(), sym_name, linker_get_error_buffer());
+  }
+
+  ElfW(Addr) sym_addr = 0;
+  if (s != nullptr) {
+    sym_addr = lsi->resolve_symbol_address(s);
+  } else if (ELF_ST_BIND(symtab_[sym].st_info) != STB_WEAK) {
+    __libc_fatal("cannot locate symbol \"%s\" referenced by \"%s\"...",
+                 sym_name, get_realpath());
+  }
+  // (A call to an undefined weak function jumps to 0, as it would have had the
+  // PLT been bound when the library was linked.)
+
+  ElfW(Addr) target = sym_addr + rel->r_addend;
+  TRACE_TYPE(RELO, "RELO JMP_SLOT %16p <- %16p %s (lazy)\n",
+             reinterpret_cast<void*>(rel->r_offset + load_bias),
+             reinterpret_cast<void*>(target), sym_name);
+  *reinterpret_cast<ElfW(Addr)*>(rel->r_offset + load_bias) = target;
+  return target;
+#else
+  __libc_fatal("\"%s\": lazy binding isn't supported on this architecture (%p)",
+               get_realpath(), reinterpret_cast<void*>(plt_arg));
+#endif
+}
+
+ElfW(Addr) do_lazy_bind(soinfo* si, ElfW(Addr) plt_arg) {
+  // The caller hasn't been entered yet, so it mustn't see any trace of this.
+  int saved_errno = errno;
+  // Making the groups to search allocates list entries.
+  ProtectedDataGuard guard;
+  ElfW(Addr) result = si->bind_lazy_plt_entry(plt_arg);
+  errno = saved_errno;
+  return result;
+}
+
 // An empty list of soinfos
 static soinfo_list_t g_empty_list;
 
@@ -2911,6 +4463,21 @@ bool soinfo::prelink_image() {
                                   &ARM_exidx, &ARM_exidx_count);
 #endif
 
+  TlsSegment tls_segment;
+  if (__bionic_get_tls_segment(phdr, phnum, load_bias, &tls_segment)) {
+    // The linker itself has no TLS segment, and couldn't allocate this yet anyway.
+    if (!relocating_linker) {
+      tls_.reset(new soinfo_tls);
+      tls_->segment = tls_segment;
+    }
+  } else if (tls_segment.alignment == 0) {
+    if (!relocating_linker) {
+      DL_ERR("invalid PT_TLS segment in \"%s\" (alignment must be a power of two no larger "
+             "than a page, and the file size no larger than the memory size)", get_realpath());
+    }
+    return false;
+  }
+
   // Extract useful information from dynamic section.
   // Note that: "Except for the DT_NULL element at the end of the array,
   // and the relative order of DT_NEEDED elements, entries may appear in any order."
@@ -3009,7 +4576,8 @@ bool soinfo::prelink_image() {
         // Used by mips and mips64.
         plt_got_ = reinterpret_cast<ElfW(Addr)**>(load_bias + d->d_un.d_ptr);
 #endif
-        // Ignore for other platforms... (because RTLD_LAZY is not supported)
+        // Used for lazy binding (see setup_lazy_plt).
+        pltgot_ = reinterpret_cast<ElfW(Addr)*>(load_bias + d->d_un.d_ptr);
         break;
 
       case DT_DEBUG:
@@ -3057,8 +4625,9 @@ bool soinfo::prelink_image() {
         }
         break;
 
-      // ignored (see DT_RELCOUNT comments for details)
+      // See DT_RELCOUNT.
       case DT_RELACOUNT:
+        relative_reloc_count_ = d->d_un.d_val;
         break;
 
       case DT_REL:
@@ -3104,9 +4673,9 @@ bool soinfo::prelink_image() {
       // "Indicates that all RELATIVE relocations have been concatenated together,
       // and specifies the RELATIVE relocation count."
       //
-      // TODO: Spec also mentions that this can be used to optimize relocation process;
-      // Not currently used by bionic linker - ignored.
+      // link_image() applies these without going through relocate().
       case DT_RELCOUNT:
+        relative_reloc_count_ = d->d_un.d_val;
         break;
 
       case DT_RELA:
@@ -3118,6 +4687,24 @@ bool soinfo::prelink_image() {
         return false;
 
 #endif
+      case DT_RELR:
+      case DT_ANDROID_RELR:
+        relr_ = reinterpret_cast<ElfW(Relr)*>(load_bias + d->d_un.d_ptr);
+        break;
+
+      case DT_RELRSZ:
+      case DT_ANDROID_RELRSZ:
+        relr_count_ = d->d_un.d_val / sizeof(ElfW(Relr));
+        break;
+
+      case DT_RELRENT:
+      case DT_ANDROID_RELRENT:
+        if (d->d_un.d_val != sizeof(ElfW(Relr))) {
+          DL_ERR("invalid DT_RELRENT: %zd", static_cast<size_t>(d->d_un.d_val));
+          return false;
+        }
+        break;
+
       case DT_INIT:
         init_func_ = reinterpret_cast<linker_ctor_function_t>(load_bias + d->d_un.d_ptr);
         DEBUG("%s constructors (DT_INIT) found at %p", get_realpath(), init_func_);
@@ -3184,10 +4771,16 @@ bool soinfo::prelink_image() {
         if (d->d_un.d_val & DF_SYMBOLIC) {
           has_DT_SYMBOLIC = true;
         }
+        if (d->d_un.d_val & DF_BIND_NOW) {
+          bind_now_ = true;
+        }
         break;
 
       case DT_FLAGS_1:
         set_dt_flags_1(d->d_un.d_val);
+        if (d->d_un.d_val & DF_1_NOW) {
+          bind_now_ = true;
+        }
 
         if ((d->d_un.d_val & ~SUPPORTED_DT_FLAGS_1) != 0) {
           DL_WARN("\"%s\" has unsupported flags DT_FLAGS_1=%p", get_realpath(), reinterpret_cast<void*>(d->d_un.d_val));
@@ -3228,8 +4821,9 @@ bool soinfo::prelink_image() {
         mips_gotsym_ = d->d_un.d_val;
         break;
 #endif
-      // Ignored: "Its use has been superseded by the DF_BIND_NOW flag"
+      // "Its use has been superseded by the DF_BIND_NOW flag"
       case DT_BIND_NOW:
+        bind_now_ = true;
         break;
 
       case DT_VERSYM:
@@ -3319,9 +4913,127 @@ bool soinfo::prelink_image() {
         get_realpath(), soname_);
     // Don't call add_dlwarning because a missing DT_SONAME isn't important enough to show in the UI
   }
+
+  // The linker parses its own dynamic section before it can allocate; its symbols
+  // are looked up through the libdl soinfo, which has no versions.
+  if (!is_linker() && !build_verdef_index()) {
+    return false;
+  }
+
+  build_elf_bloom_filter();
   return true;
 }
 
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+  // 64-bit FNV-1a.
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static uint64_t hash_soinfo_placement(uint64_t hash, const soinfo* si) {
+  const char* realpath = si->get_realpath();
+  hash = hash_bytes(hash, realpath, strlen(realpath));
+  return hash_bytes(hash, &si->load_bias, sizeof(si->load_bias));
+}
+
+// The relocated contents of a GNU_RELRO segment depend on where the library
+// itself and every library it can bind to were loaded. The cache file name is
+// derived from all of those, so that processes with the same layout share one
+// file. A collision is harmless: phdr_table_map_gnu_relro() only maps pages
+// whose contents match what this process computed.
+static uint64_t relro_cache_key(soinfo* si,
+                                const soinfo_list_t& global_group,
+                                const soinfo_list_t& local_group) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  dev_t st_dev = si->get_st_dev();
+  ino_t st_ino = si->get_st_ino();
+  off64_t file_offset = si->get_file_offset();
+  hash = hash_bytes(hash, &st_dev, sizeof(st_dev));
+  hash = hash_bytes(hash, &st_ino, sizeof(st_ino));
+  hash = hash_bytes(hash, &file_offset, sizeof(file_offset));
+  hash = hash_soinfo_placement(hash, si);
+
+  global_group.for_each([&](const soinfo* group_si) {
+    hash = hash_soinfo_placement(hash, group_si);
+  });
+  local_group.for_each([&](const soinfo* group_si) {
+    hash = hash_soinfo_placement(hash, group_si);
+  });
+
+  return hash;
+}
+
+// Shares the relocated GNU_RELRO segments of the library through the relro
+// cache directory of its namespace: maps a file written by an earlier process
+// with the same layout, or writes one for later processes. Like
+// ANDROID_DLEXT_USE_RELRO/ANDROID_DLEXT_WRITE_RELRO, but without the caller
+// having to manage the file. This is an optimization only, so failures are
+// logged and otherwise ignored.
+static void share_relro_through_cache(soinfo* si,
+                                      const soinfo_list_t& global_group,
+                                      const soinfo_list_t& local_group) {
+  bool has_relro = false;
+  for (size_t i = 0; i < si->phnum; ++i) {
+    if (si->phdr[i].p_type == PT_GNU_RELRO) {
+      has_relro = true;
+      break;
+    }
+  }
+
+  if (!has_relro) {
+    return;
+  }
+
+  std::string cache_file = android::base::StringPrintf(
+      "%s/%016" PRIx64 ".relro",
+      si->get_primary_namespace()->get_relro_cache_path().c_str(),
+      relro_cache_key(si, global_group, local_group));
+
+  int fd = TEMP_FAILURE_RETRY(open(cache_file.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd != -1) {
+    if (phdr_table_map_gnu_relro(si->phdr, si->phnum, si->load_bias, fd) < 0) {
+      INFO("[ failed mapping cached GNU RELRO \"%s\" for \"%s\": %s ]",
+           cache_file.c_str(), si->get_realpath(), strerror(errno));
+    } else {
+      TRACE("[ mapped cached GNU RELRO \"%s\" for \"%s\" ]",
+            cache_file.c_str(), si->get_realpath());
+    }
+    close(fd);
+    return;
+  }
+
+  if (errno != ENOENT) {
+    INFO("[ can't open cached GNU RELRO \"%s\" for \"%s\": %s ]",
+         cache_file.c_str(), si->get_realpath(), strerror(errno));
+    return;
+  }
+
+  // Write to a private file and rename it into place, so that other processes
+  // never map a partially written file.
+  std::string temp_file = android::base::StringPrintf("%s.%d.tmp", cache_file.c_str(), getpid());
+  fd = TEMP_FAILURE_RETRY(open(temp_file.c_str(),
+                               O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644));
+  if (fd == -1) {
+    INFO("[ can't create \"%s\" for \"%s\": %s ]",
+         temp_file.c_str(), si->get_realpath(), strerror(errno));
+    return;
+  }
+
+  if (phdr_table_serialize_gnu_relro(si->phdr, si->phnum, si->load_bias, fd) < 0 ||
+      rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+    INFO("[ failed writing cached GNU RELRO \"%s\" for \"%s\": %s ]",
+         cache_file.c_str(), si->get_realpath(), strerror(errno));
+    unlink(temp_file.c_str());
+  } else {
+    TRACE("[ wrote cached GNU RELRO \"%s\" for \"%s\" ]",
+          cache_file.c_str(), si->get_realpath());
+  }
+  close(fd);
+}
+
 bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t& local_group,
                         const android_dlextinfo* extinfo) {
 
@@ -3340,6 +5052,10 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
     return false;
   }
 
+  // Symbol lookups are only cached for the duration of this call; the groups
+  // they were resolved against can change once this library is linked.
+  SymbolLookupCache lookup_cache;
+
 #if !defined(__LP64__)
   if (has_text_relocations) {
     // Fail if app is targeting M or above.
@@ -3382,7 +5098,7 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
           version_tracker,
           packed_reloc_iterator<sleb128_decoder>(
             sleb128_decoder(packed_relocs, packed_relocs_size)),
-          global_group, local_group);
+          global_group, local_group, &lookup_cache);
 
       if (!relocated) {
         return false;
@@ -3393,33 +5109,63 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
     }
   }
 
+  if (relr_ != nullptr) {
+    DEBUG("[ relocating %s relr ]", get_realpath());
+    apply_relr_relocs(relr_, relr_count_, load_bias);
+  }
+
+  if (is_lazily_bound() && !can_bind_plt_lazily()) {
+    lazy_bind_namespace_ = nullptr;
+  }
+
 #if defined(USE_RELA)
   if (rela_ != nullptr) {
     DEBUG("[ relocating %s ]", get_realpath());
+    size_t relative_count = 0;
+#if !defined(__mips__)
+    relative_count = apply_relative_relocs(rela_,
+                                           std::min(relative_reloc_count_, rela_count_),
+                                           load_bias);
+#endif
     if (!relocate(version_tracker,
-            plain_reloc_iterator(rela_, rela_count_), global_group, local_group)) {
+            plain_reloc_iterator(rela_ + relative_count, rela_count_ - relative_count),
+            global_group, local_group, &lookup_cache)) {
       return false;
     }
   }
-  if (plt_rela_ != nullptr) {
+  if (is_lazily_bound()) {
+    DEBUG("[ setting up lazy binding of %s plt ]", get_realpath());
+    if (!setup_lazy_plt(version_tracker, global_group, local_group, &lookup_cache)) {
+      return false;
+    }
+  } else if (plt_rela_ != nullptr) {
     DEBUG("[ relocating %s plt ]", get_realpath());
     if (!relocate(version_tracker,
-            plain_reloc_iterator(plt_rela_, plt_rela_count_), global_group, local_group)) {
+            plain_reloc_iterator(plt_rela_, plt_rela_count_), global_group, local_group,
+            &lookup_cache)) {
       return false;
     }
   }
 #else
   if (rel_ != nullptr) {
     DEBUG("[ relocating %s ]", get_realpath());
+    size_t relative_count = 0;
+#if !defined(__mips__)
+    relative_count = apply_relative_relocs(rel_,
+                                           std::min(relative_reloc_count_, rel_count_),
+                                           load_bias);
+#endif
     if (!relocate(version_tracker,
-            plain_reloc_iterator(rel_, rel_count_), global_group, local_group)) {
+            plain_reloc_iterator(rel_ + relative_count, rel_count_ - relative_count),
+            global_group, local_group, &lookup_cache)) {
       return false;
     }
   }
   if (plt_rel_ != nullptr) {
     DEBUG("[ relocating %s plt ]", get_realpath());
     if (!relocate(version_tracker,
-            plain_reloc_iterator(plt_rel_, plt_rel_count_), global_group, local_group)) {
+            plain_reloc_iterator(plt_rel_, plt_rel_count_), global_group, local_group,
+            &lookup_cache)) {
       return false;
     }
   }
@@ -3431,6 +5177,8 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
   }
 #endif
 
+  TRACE("[ %s: %zu symbol lookups served from cache (%zu symtab entries) ]",
+        get_realpath(), lookup_cache.hit_count(), lookup_cache.size());
   DEBUG("[ finished linking %s ]", get_realpath());
 
 #if !defined(__LP64__)
@@ -3465,12 +5213,46 @@ bool soinfo::link_image(const soinfo_list_t& global_group, const soinfo_list_t&
              get_realpath(), strerror(errno));
       return false;
     }
+  } else if (!is_linker() && !get_primary_namespace()->get_relro_cache_path().empty()) {
+    share_relro_through_cache(this, global_group, local_group);
   }
 
-  notify_gdb_of_load(this);
+  // The caller tells gdb about the library (see notify_gdb_of_load), so that
+  // find_libraries can do it once for a whole group.
   return true;
 }
 
+// Asks the kernel to read in the relocation, hash and string tables, which
+// link_image() reads right away. See also phdr_table_readahead_dynamic_and_relro.
+void soinfo::readahead_link_regions(linker_readahead_stats* stats) {
+  stats->libraries++;
+
+#if defined(USE_RELA)
+  readahead_range(reinterpret_cast<ElfW(Addr)>(rela_), rela_count_ * sizeof(ElfW(Rela)), stats);
+  readahead_range(reinterpret_cast<ElfW(Addr)>(plt_rela_),
+                  plt_rela_count_ * sizeof(ElfW(Rela)), stats);
+#else
+  readahead_range(reinterpret_cast<ElfW(Addr)>(rel_), rel_count_ * sizeof(ElfW(Rel)), stats);
+  readahead_range(reinterpret_cast<ElfW(Addr)>(plt_rel_),
+                  plt_rel_count_ * sizeof(ElfW(Rel)), stats);
+#endif
+  readahead_range(reinterpret_cast<ElfW(Addr)>(android_relocs_), android_relocs_size_, stats);
+  readahead_range(reinterpret_cast<ElfW(Addr)>(relr_), relr_count_ * sizeof(ElfW(Relr)), stats);
+
+  if (is_gnu_hash()) {
+    // The bloom filter is immediately followed by the buckets.
+    ElfW(Addr) start = reinterpret_cast<ElfW(Addr)>(gnu_bloom_filter_);
+    ElfW(Addr) end = reinterpret_cast<ElfW(Addr)>(gnu_bucket_ + gnu_nbucket_);
+    readahead_range(start, end - start, stats);
+  } else {
+    readahead_range(reinterpret_cast<ElfW(Addr)>(bucket_), nbucket_ * sizeof(uint32_t), stats);
+    readahead_range(reinterpret_cast<ElfW(Addr)>(chain_), nchain_ * sizeof(uint32_t), stats);
+    readahead_range(reinterpret_cast<ElfW(Addr)>(symtab_), nchain_ * sizeof(ElfW(Sym)), stats);
+  }
+
+  readahead_range(reinterpret_cast<ElfW(Addr)>(strtab_), strtab_size_, stats);
+}
+
 bool soinfo::protect_relro() {
   if (phdr_table_protect_gnu_relro(phdr, phnum, load_bias) < 0) {
     DL_ERR("can't enable GNU RELRO protection for \"%s\": %s",
@@ -3540,6 +5322,11 @@ void init_default_namespace(const char* executable_path) {
   const NamespaceConfig* default_ns_config = config->default_namespace_config();
 
   g_default_namespace.set_isolated(default_ns_config->isolated());
+  g_default_namespace.set_readahead_enabled(default_ns_config->readahead());
+  g_default_namespace.set_library_sharing_enabled(default_ns_config->share_libraries());
+  g_default_namespace.set_lazy_binding_enabled(default_ns_config->lazy_binding());
+  g_default_namespace.set_relro_cache_path(default_ns_config->relro_cache_path());
+  g_default_namespace.set_zip_cache_path(default_ns_config->zip_cache_path());
   g_default_namespace.set_default_library_paths(default_ns_config->search_paths());
   g_default_namespace.set_permitted_paths(default_ns_config->permitted_paths());
 
@@ -3555,6 +5342,11 @@ void init_default_namespace(const char* executable_path) {
     android_namespace_t* ns = new (g_namespace_allocator.alloc()) android_namespace_t();
     ns->set_name(ns_config->name());
     ns->set_isolated(ns_config->isolated());
+    ns->set_readahead_enabled(ns_config->readahead());
+    ns->set_library_sharing_enabled(ns_config->share_libraries());
+    ns->set_lazy_binding_enabled(ns_config->lazy_binding());
+    ns->set_relro_cache_path(ns_config->relro_cache_path());
+    ns->set_zip_cache_path(ns_config->zip_cache_path());
     ns->set_default_library_paths(ns_config->search_paths());
     ns->set_permitted_paths(ns_config->permitted_paths());
 
@@ -3585,6 +5377,49 @@ void init_default_namespace(const char* executable_path) {
   }
 
   set_application_target_sdk_version(config->target_sdk_version());
+  g_link_plan_dir = config->link_plan_dir();
+}
+
+void init_link_plan(const char* executable_path, bool record) {
+  if (g_link_plan_dir.empty()) {
+    return;
+  }
+
+  std::string plan_path = LinkPlan::get_path(g_link_plan_dir, executable_path);
+  if (record) {
+    g_link_plan_builder = new LinkPlanBuilder();
+    g_link_plan_builder->add_file(executable_path);
+    g_link_plan_builder->add_file(kLdConfigFilePath);
+    for (const auto& path : g_default_namespace.get_default_library_paths()) {
+      g_link_plan_builder->add_file(path);
+    }
+    return;
+  }
+
+  std::string error_msg;
+  if (g_link_plan.read(plan_path.c_str(), &error_msg)) {
+    INFO("[ using link plan \"%s\" ]", plan_path.c_str());
+  } else if (!error_msg.empty()) {
+    DL_WARN("error reading link plan for \"%s\" (will search for libraries): %s",
+            executable_path, error_msg.c_str());
+  }
+}
+
+void finish_link_plan(const char* executable_path) {
+  g_link_plan.reset();
+
+  if (g_link_plan_builder == nullptr) {
+    return;
+  }
+
+  std::string plan_path = LinkPlan::get_path(g_link_plan_dir, executable_path);
+  std::string error_msg;
+  if (!g_link_plan_builder->write(plan_path.c_str(), &error_msg)) {
+    DL_WARN("error writing link plan for \"%s\": %s", executable_path, error_msg.c_str());
+  }
+
+  delete g_link_plan_builder;
+  g_link_plan_builder = nullptr;
 }
 
 // This function finds a namespace exported in ld.config.txt by its name.
@@ -87,6 +87,37 @@ class VersionTracker {
   DISALLOW_COPY_AND_ASSIGN(VersionTracker);
 };
 
+// Remembers the result of resolving each symbol referenced by the relocations
+// of a single library while it is being linked. The same symbol is usually
+// referenced by many relocations (GLOB_DAT, JUMP_SLOT, ABS), and the global
+// and local groups do not change during link_image(), so only the first
+// reference needs to walk them.
+//
+// Entries are keyed by the index of the symbol in the referencing library's
+// symtab; the name and version needed for the lookup are both determined by
+// that index.
+class SymbolLookupCache {
+ public:
+  SymbolLookupCache() : hit_count_(0) {}
+
+  bool find(ElfW(Word) sym, soinfo** si_found_in, const ElfW(Sym)** symbol);
+  void insert(ElfW(Word) sym, soinfo* si_found_in, const ElfW(Sym)* symbol);
+
+  size_t size() const { return entries_.size(); }
+  size_t hit_count() const { return hit_count_; }
+ private:
+  struct entry {
+    soinfo* si_found_in;
+    const ElfW(Sym)* symbol;
+    bool resolved;
+  };
+
+  std::vector<entry> entries_;
+  size_t hit_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(SymbolLookupCache);
+};
+
 bool soinfo_do_lookup(soinfo* si_from, const char* name, const version_info* vi,
                       soinfo** si_found_in, const soinfo_list_t& global_group,
                       const soinfo_list_t& local_group, const ElfW(Sym)** symbol);
@@ -101,9 +132,36 @@ enum RelocationKind {
 
 void count_relocation(RelocationKind kind);
 
+// Prints the statistics of the linker's internal allocator (see linker_memory.cpp).
+void print_linker_allocator_stats();
+
+// Returns the bytes the linker's malloc has mapped for small objects, how many of them are
+// allocated, and the bytes it has mapped for large objects.
+void get_linker_heap_usage(size_t* small_bytes, size_t* small_used_bytes, size_t* large_bytes);
+
+// Returns the counters for the readahead done for namespaces with readahead enabled.
+const linker_readahead_stats& get_linker_readahead_stats();
+
+// Totals for the libraries unloaded by dlclose() and by dlopen() failures.
+struct linker_unload_stats {
+  size_t unloads;           // Calls that unloaded at least one library.
+  size_t libraries;         // Libraries unloaded.
+  uint64_t unload_ns;       // Time spent unloading them, destructors included.
+  uint64_t destructors_ns;  // Time spent in DT_FINI_ARRAY and DT_FINI.
+};
+
+const linker_unload_stats& get_linker_unload_stats();
+
 soinfo* get_libdl_info(const char* linker_path);
 
+// Tells gdb about a library linked outside find_libraries (which does this for its whole
+// group at once).
+void notify_gdb_of_load(soinfo* info);
+
+// Must be called with g_dl_mutex held.
 soinfo* find_containing_library(const void* p);
+// For the few callers that cannot take g_dl_mutex; walks the whole solist.
+soinfo* find_containing_library_unlocked(const void* p);
 
 void parse_LD_SHIM_LIBS(const char* path);
 
@@ -116,8 +174,61 @@ void* do_dlopen(const char* name,
 
 int do_dlclose(void* handle);
 
+// Walks the loaded objects without taking g_dl_mutex. Returns false, without calling cb, if that
+// is not possible right now; the caller then has to call do_dl_iterate_phdr with the lock held.
+bool do_dl_iterate_phdr_unlocked(int (*cb)(dl_phdr_info* info, size_t size, void* data),
+                                 void* data, int* result);
 int do_dl_iterate_phdr(int (*cb)(dl_phdr_info* info, size_t size, void* data), void* data);
 
+// Per-library load cost, in nanoseconds. Stages that did not run for a
+// library (the main executable is opened and mapped by the kernel, for
+// example) are reported as 0. Constructor time does not include the
+// constructors of the library's dependencies.
+struct android_dlopen_stats {
+  const char* realpath;
+  uint64_t open_ns;          // Locating and opening the file and reading its ELF headers.
+  uint64_t map_ns;           // Reserving address space and mapping the segments.
+  uint64_t prelink_ns;       // Parsing the dynamic section.
+  uint64_t relocate_ns;      // Relocation, including symbol lookup and RELRO protection.
+  uint64_t constructors_ns;  // DT_INIT and DT_INIT_ARRAY.
+};
+
+int do_android_iterate_dlopen_stats(int (*cb)(const android_dlopen_stats* stats, void* data),
+                                    void* data);
+
+// The memory the linker uses for its own bookkeeping, in bytes.
+struct android_linker_memory_stats {
+  size_t soinfo_bytes;           // The pool of library descriptors.
+  size_t namespace_bytes;        // The pool of namespaces.
+  size_t list_bytes;             // The pools of soinfo and namespace list entries.
+  size_t other_pool_bytes;       // Other fixed-size pools (load tasks, for example).
+  size_t heap_small_bytes;       // Pages the linker's malloc holds for objects up to 1KiB.
+  size_t heap_small_used_bytes;  // The part of them that is allocated.
+  size_t heap_large_bytes;       // Mappings the linker's malloc made for larger objects.
+};
+
+// Page counts of a loaded library.
+struct android_library_memory {
+  const char* realpath;
+  const char* namespace_name;
+  size_t mapped_pages;              // Pages of the loadable segments.
+  size_t resident_pages;            // Those of them that are resident.
+  size_t relocated_pages;           // Pages of the writable segments (relocations, .data, .bss).
+  size_t relocated_resident_pages;  // Those of them that are resident, and so private dirty
+                                    // unless shared through a RELRO file.
+};
+
+void do_android_get_linker_memory_stats(android_linker_memory_stats* stats);
+int do_android_iterate_library_memory(int (*cb)(const android_library_memory* memory, void* data),
+                                      void* data);
+// Writes the above, and the totals for each namespace, to fd as text.
+void do_android_dump_linker_memory(int fd);
+
+// Releases what the linker caches between dlopen() calls (open zip files, the
+// libraries extracted from them that aren't loaded, and directory listings);
+// they are rebuilt as needed.
+void do_android_trim_dlopen_caches();
+
 #if defined(__arm__)
 _Unwind_Ptr do_dl_unwind_find_exidx(_Unwind_Ptr pc, int* pcount);
 #endif
@@ -127,8 +238,28 @@ bool do_dlsym(void* handle, const char* sym_name,
               const void* caller_addr,
               void** symbol);
 
+// Like do_dlsym() without a version, for callers that have already computed
+// the GNU hash of sym_name. A wrong hash makes the lookup fail.
+bool do_dlsym_hashed(void* handle,
+                     const char* sym_name,
+                     uint32_t gnu_hash,
+                     const void* caller_addr,
+                     void** symbol);
+
+// Looks up count symbols in the same way as dlsym(handle, ...) would, walking
+// the dependency tree of the handle only once. Returns the number of symbols
+// found (symbols[i] is nullptr for the others) or -1 if handle is invalid.
+int do_dlsym_many(void* handle,
+                  const char* const sym_names[],
+                  void* symbols[],
+                  size_t count,
+                  const void* caller_addr);
+
 int do_dladdr(const void* addr, Dl_info* info);
 
+// Called by the lazy binding trampoline, see soinfo::bind_lazy_plt_entry().
+ElfW(Addr) do_lazy_bind(soinfo* si, ElfW(Addr) plt_arg);
+
 // void ___cfi_slowpath(uint64_t CallSiteTypeId, void *Ptr, void *Ret);
 // void ___cfi_slowpath_diag(uint64_t CallSiteTypeId, void *Ptr, void *DiagData, void *Ret);
 void ___cfi_fail(uint64_t CallSiteTypeId, void* Ptr, void *DiagData, void *Ret);
@@ -54,10 +54,16 @@
 // For a pointer allocated using proxy-to-mmap allocator unmaps
 // the memory.
 //
-// For a pointer allocated using SmallObjectAllocator it adds
-// the block to free_blocks_list_. If the number of free pages reaches 2,
-// SmallObjectAllocator munmaps one of the pages keeping the other one
-// in reserve.
+// For a pointer allocated using SmallObjectAllocator it puts the block
+// into a small LIFO cache of recently freed blocks. The cache is consulted
+// first on alloc, which avoids the page record lookup for the common
+// free-then-alloc pattern of short lived strings and vectors. When the
+// cache fills up, half of it is returned to free_blocks_list_. If the
+// number of free pages reaches 2, SmallObjectAllocator munmaps one of the
+// pages keeping the other one in reserve.
+//
+// Every allocator keeps statistics (see linker_allocator_stats) which can
+// be retrieved with LinkerMemoryAllocator::get_stats().
 
 static const char kSignature[4] = {'L', 'M', 'A', 1};
 
@@ -82,12 +88,36 @@ static inline uint16_t log2(size_t number) {
   return result;
 }
 
+static void update_peak(size_t value, size_t* peak) {
+  if (value > *peak) {
+    *peak = value;
+  }
+}
+
 LinkerSmallObjectAllocator::LinkerSmallObjectAllocator(uint32_t type, size_t block_size)
-    : type_(type), block_size_(block_size), free_pages_cnt_(0), free_blocks_list_(nullptr) {}
+    : type_(type), block_size_(block_size), free_pages_cnt_(0), free_blocks_list_(nullptr),
+      free_block_cache_cnt_(0), stats_() {
+  stats_.block_size = block_size;
+}
 
 void* LinkerSmallObjectAllocator::alloc() {
   CHECK(block_size_ != 0);
 
+  stats_.alloc_count++;
+  stats_.allocated_blocks++;
+  update_peak(stats_.allocated_blocks, &stats_.peak_allocated_blocks);
+
+  if (free_block_cache_cnt_ != 0) {
+    stats_.cache_hit_count++;
+    void* ptr = free_block_cache_[--free_block_cache_cnt_];
+    memset(ptr, 0, block_size_);
+    return ptr;
+  }
+
+  return alloc_slow();
+}
+
+void* LinkerSmallObjectAllocator::alloc_slow() {
   if (free_blocks_list_ == nullptr) {
     alloc_page();
   }
@@ -141,17 +171,44 @@ void LinkerSmallObjectAllocator::free_page(linker_vector_t::iterator page_record
   munmap(page_start, PAGE_SIZE);
   page_records_.erase(page_record);
   free_pages_cnt_--;
+
+  stats_.pages--;
+  stats_.page_unmap_count++;
 }
 
 void LinkerSmallObjectAllocator::free(void* ptr) {
-  auto page_record = find_page_record(ptr);
-
   ssize_t offset = reinterpret_cast<uintptr_t>(ptr) - sizeof(page_info);
 
   if (offset % block_size_ != 0) {
     __libc_fatal("invalid pointer: %p (block_size=%zd)", ptr, block_size_);
   }
 
+  stats_.free_count++;
+  stats_.allocated_blocks--;
+
+  if (free_block_cache_cnt_ == kFreeBlockCacheSize) {
+    flush_free_block_cache(kFreeBlockCacheSize / 2);
+  }
+  free_block_cache_[free_block_cache_cnt_++] = ptr;
+}
+
+// Returns the oldest cached blocks to the free list, keeping the
+// keep_cnt most recently freed ones in the cache.
+void LinkerSmallObjectAllocator::flush_free_block_cache(size_t keep_cnt) {
+  CHECK(keep_cnt <= free_block_cache_cnt_);
+
+  size_t flush_cnt = free_block_cache_cnt_ - keep_cnt;
+  for (size_t i = 0; i < flush_cnt; ++i) {
+    free_slow(free_block_cache_[i]);
+  }
+
+  memmove(free_block_cache_, free_block_cache_ + flush_cnt, keep_cnt * sizeof(void*));
+  free_block_cache_cnt_ = keep_cnt;
+}
+
+void LinkerSmallObjectAllocator::free_slow(void* ptr) {
+  auto page_record = find_page_record(ptr);
+
   memset(ptr, 0, block_size_);
   small_object_block_record* block_record = reinterpret_cast<small_object_block_record*>(ptr);
 
@@ -208,6 +265,10 @@ void LinkerSmallObjectAllocator::alloc_page() {
 
   prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map_ptr, PAGE_SIZE, "linker_alloc_small_objects");
 
+  stats_.pages++;
+  stats_.page_map_count++;
+  update_peak(stats_.pages, &stats_.peak_pages);
+
   page_info* info = reinterpret_cast<page_info*>(map_ptr);
   memcpy(info->signature, kSignature, sizeof(kSignature));
   info->type = type_;
@@ -253,6 +314,13 @@ void* LinkerMemoryAllocator::alloc_mmap(size_t size) {
 
   prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map_ptr, allocated_size, "linker_alloc_lob");
 
+  large_stats_.alloc_count++;
+  large_stats_.page_map_count++;
+  large_stats_.allocated_blocks++;
+  large_stats_.pages += allocated_size / PAGE_SIZE;
+  update_peak(large_stats_.allocated_blocks, &large_stats_.peak_allocated_blocks);
+  update_peak(large_stats_.pages, &large_stats_.peak_pages);
+
   page_info* info = reinterpret_cast<page_info*>(map_ptr);
   memcpy(info->signature, kSignature, sizeof(kSignature));
   info->type = kLargeObject;
@@ -332,6 +400,10 @@ void LinkerMemoryAllocator::free(void* ptr) {
   page_info* info = get_page_info(ptr);
 
   if (info->type == kLargeObject) {
+    large_stats_.free_count++;
+    large_stats_.page_unmap_count++;
+    large_stats_.allocated_blocks--;
+    large_stats_.pages -= info->allocated_size / PAGE_SIZE;
     munmap(info, info->allocated_size);
   } else {
     LinkerSmallObjectAllocator* allocator = get_small_object_allocator(info->type);
@@ -351,3 +423,12 @@ LinkerSmallObjectAllocator* LinkerMemoryAllocator::get_small_object_allocator(ui
   initialize_allocators();
   return &allocators_[type - kSmallObjectMinSizeLog2];
 }
+
+void LinkerMemoryAllocator::get_stats(linker_allocator_stats* small_stats,
+                                      linker_allocator_stats* large_stats) {
+  initialize_allocators();
+  for (size_t i = 0; i < kSmallObjectAllocatorsCount; ++i) {
+    small_stats[i] = allocators_[i].get_stats();
+  }
+  *large_stats = large_stats_;
+}
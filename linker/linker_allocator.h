@@ -44,6 +44,10 @@ const uint32_t kSmallObjectMaxSizeLog2 = 10;
 const uint32_t kSmallObjectMinSizeLog2 = 4;
 const uint32_t kSmallObjectAllocatorsCount = kSmallObjectMaxSizeLog2 - kSmallObjectMinSizeLog2 + 1;
 
+// The number of recently freed blocks each small object allocator keeps
+// for immediate reuse without going through the page bookkeeping.
+const size_t kFreeBlockCacheSize = 16;
+
 class LinkerSmallObjectAllocator;
 
 // This structure is placed at the beginning of each addressable page
@@ -73,6 +77,21 @@ struct small_object_block_record {
   size_t free_blocks_cnt;
 };
 
+// Allocation statistics for one small object size class
+// or, when block_size is 0, for the large object allocator.
+struct linker_allocator_stats {
+  size_t block_size;
+  size_t alloc_count;
+  size_t free_count;
+  size_t cache_hit_count;
+  size_t allocated_blocks;
+  size_t peak_allocated_blocks;
+  size_t pages;
+  size_t peak_pages;
+  size_t page_map_count;
+  size_t page_unmap_count;
+};
+
 // This is implementation for std::vector allocator
 template <typename T>
 class linker_vector_allocator {
@@ -117,7 +136,11 @@ class LinkerSmallObjectAllocator {
   void free(void* ptr);
 
   size_t get_block_size() const { return block_size_; }
+  const linker_allocator_stats& get_stats() const { return stats_; }
  private:
+  void* alloc_slow();
+  void free_slow(void* ptr);
+  void flush_free_block_cache(size_t keep_cnt);
   void alloc_page();
   void free_page(linker_vector_t::iterator page_record);
   linker_vector_t::iterator find_page_record(void* ptr);
@@ -131,16 +154,26 @@ class LinkerSmallObjectAllocator {
 
   // sorted vector of page records
   linker_vector_t page_records_;
+
+  // LIFO cache of freed blocks; their page records still count them as allocated.
+  void* free_block_cache_[kFreeBlockCacheSize];
+  size_t free_block_cache_cnt_;
+
+  linker_allocator_stats stats_;
 };
 
 class LinkerMemoryAllocator {
  public:
-  constexpr LinkerMemoryAllocator() : allocators_(nullptr), allocators_buf_() {}
+  constexpr LinkerMemoryAllocator() : allocators_(nullptr), allocators_buf_(), large_stats_() {}
   void* alloc(size_t size);
 
   // Note that this implementation of realloc never shrinks allocation
   void* realloc(void* ptr, size_t size);
   void free(void* ptr);
+
+  // Fills small_stats (an array of kSmallObjectAllocatorsCount entries, smallest
+  // size class first) and large_stats with the allocator's current statistics.
+  void get_stats(linker_allocator_stats* small_stats, linker_allocator_stats* large_stats);
  private:
   void* alloc_mmap(size_t size);
   page_info* get_page_info(void* ptr);
@@ -149,6 +182,7 @@ class LinkerMemoryAllocator {
 
   LinkerSmallObjectAllocator* allocators_;
   uint8_t allocators_buf_[sizeof(LinkerSmallObjectAllocator)*kSmallObjectAllocatorsCount];
+  linker_allocator_stats large_stats_;
 };
 
 
@@ -49,9 +49,78 @@ struct FreeBlockInfo {
   size_t num_free_blocks;
 };
 
-LinkerBlockAllocator::LinkerBlockAllocator(size_t block_size)
+// The pages of protectable allocators are carved out of a few large reservations of address
+// space rather than mapped one by one, so that protect_protectable() changes the protection of
+// all of them with one mprotect per reservation. The linker makes its metadata writable and
+// read-only again around every dlopen and dlclose, and with hundreds of libraries loaded doing
+// that page by page was hundreds of system calls and TLB shootdowns each time.
+struct ProtectableArena {
+  uint8_t* start;
+  uint8_t* next;  // The first page not handed out yet.
+  uint8_t* end;
+};
+
+#if defined(__LP64__)
+static constexpr size_t kProtectableArenaSize = 32 * 1024 * 1024;
+#else
+static constexpr size_t kProtectableArenaSize = 2 * 1024 * 1024;
+#endif
+static constexpr size_t kMaxProtectableArenas = 16;
+
+// Kept outside the arenas so that pages can be handed out while the arenas are read-only.
+static ProtectableArena g_protectable_arenas[kMaxProtectableArenas];
+static size_t g_protectable_arena_count = 0;
+
+static void* alloc_protectable_page() {
+  ProtectableArena* arena = nullptr;
+  if (g_protectable_arena_count > 0) {
+    arena = &g_protectable_arenas[g_protectable_arena_count - 1];
+  }
+
+  if (arena == nullptr || arena->next == arena->end) {
+    if (g_protectable_arena_count == kMaxProtectableArenas) {
+      abort(); // oom
+    }
+    void* map = mmap(nullptr, kProtectableArenaSize, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) {
+      abort(); // oom
+    }
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, kProtectableArenaSize, "linker_alloc");
+
+    arena = &g_protectable_arenas[g_protectable_arena_count++];
+    arena->start = arena->next = reinterpret_cast<uint8_t*>(map);
+    arena->end = arena->start + kProtectableArenaSize;
+  }
+
+  void* page = arena->next;
+  if (mprotect(page, PAGE_SIZE, PROT_READ | PROT_WRITE) == -1) {
+    abort(); // oom
+  }
+  arena->next += PAGE_SIZE;
+  return page;
+}
+
+static size_t g_block_allocator_page_count = 0;
+
+size_t LinkerBlockAllocator::total_page_count() {
+  return g_block_allocator_page_count;
+}
+
+void LinkerBlockAllocator::protect_protectable(int prot) {
+  for (size_t i = 0; i < g_protectable_arena_count; ++i) {
+    ProtectableArena& arena = g_protectable_arenas[i];
+    if (arena.next != arena.start && mprotect(arena.start, arena.next - arena.start, prot) == -1) {
+      abort();
+    }
+  }
+}
+
+LinkerBlockAllocator::LinkerBlockAllocator(size_t block_size, bool protectable)
   : block_size_(
       round_up(block_size < sizeof(FreeBlockInfo) ? sizeof(FreeBlockInfo) : block_size, 16)),
+    protectable_(protectable),
+    page_count_(0),
     page_list_(nullptr),
     free_block_list_(nullptr)
 {}
@@ -105,10 +174,28 @@ void LinkerBlockAllocator::free(void* block) {
 }
 
 void LinkerBlockAllocator::protect_all(int prot) {
+  // Pages are usually mapped next to the previous one (above or below it), so runs of
+  // neighbouring pages are changed with a single mprotect.
+  uint8_t* start = nullptr;
+  uint8_t* end = nullptr;
   for (LinkerBlockAllocatorPage* page = page_list_; page != nullptr; page = page->next) {
-    if (mprotect(page, PAGE_SIZE, prot) == -1) {
+    uint8_t* p = reinterpret_cast<uint8_t*>(page);
+    if (p == end) {
+      end += PAGE_SIZE;
+      continue;
+    }
+    if (p + PAGE_SIZE == start) {
+      start = p;
+      continue;
+    }
+    if (start != nullptr && mprotect(start, end - start, prot) == -1) {
       abort();
     }
+    start = p;
+    end = p + PAGE_SIZE;
+  }
+  if (start != nullptr && mprotect(start, end - start, prot) == -1) {
+    abort();
   }
 }
 
@@ -116,14 +203,19 @@ void LinkerBlockAllocator::create_new_page() {
   static_assert(sizeof(LinkerBlockAllocatorPage) == PAGE_SIZE,
                 "Invalid sizeof(LinkerBlockAllocatorPage)");
 
-  LinkerBlockAllocatorPage* page = reinterpret_cast<LinkerBlockAllocatorPage*>(
-      mmap(nullptr, PAGE_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0));
+  LinkerBlockAllocatorPage* page;
+  if (protectable_) {
+    page = reinterpret_cast<LinkerBlockAllocatorPage*>(alloc_protectable_page());
+  } else {
+    page = reinterpret_cast<LinkerBlockAllocatorPage*>(
+        mmap(nullptr, PAGE_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0));
 
-  if (page == MAP_FAILED) {
-    abort(); // oom
-  }
+    if (page == MAP_FAILED) {
+      abort(); // oom
+    }
 
-  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, page, PAGE_SIZE, "linker_alloc");
+    prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, page, PAGE_SIZE, "linker_alloc");
+  }
 
   FreeBlockInfo* first_block = reinterpret_cast<FreeBlockInfo*>(page->bytes);
   first_block->next_block = free_block_list_;
@@ -133,6 +225,8 @@ void LinkerBlockAllocator::create_new_page() {
 
   page->next = page_list_;
   page_list_ = page;
+  ++page_count_;
+  ++g_block_allocator_page_count;
 }
 
 LinkerBlockAllocatorPage* LinkerBlockAllocator::find_page(void* block) {
@@ -44,17 +44,29 @@ struct LinkerBlockAllocatorPage;
  */
 class LinkerBlockAllocator {
  public:
-  explicit LinkerBlockAllocator(size_t block_size);
+  // The pages of protectable allocators are taken from address space shared by all of them,
+  // so that protect_protectable() can change them together.
+  explicit LinkerBlockAllocator(size_t block_size, bool protectable = false);
 
   void* alloc();
   void free(void* block);
   void protect_all(int prot);
 
+  // The number of pages this allocator has mapped, and that all of them have.
+  size_t page_count() const { return page_count_; }
+  static size_t total_page_count();
+
+  // Changes the protection of the pages of every protectable allocator, with one
+  // mprotect per reserved range rather than one per page.
+  static void protect_protectable(int prot);
+
  private:
   void create_new_page();
   LinkerBlockAllocatorPage* find_page(void* block);
 
   size_t block_size_;
+  bool protectable_;
+  size_t page_count_;
   LinkerBlockAllocatorPage* page_list_;
   void* free_block_list_;
 
@@ -81,10 +93,12 @@ class LinkerBlockAllocator {
 template<typename T>
 class LinkerTypeAllocator {
  public:
-  LinkerTypeAllocator() : block_allocator_(sizeof(T)) {}
+  explicit LinkerTypeAllocator(bool protectable = false)
+      : block_allocator_(sizeof(T), protectable) {}
   T* alloc() { return reinterpret_cast<T*>(block_allocator_.alloc()); }
   void free(T* t) { block_allocator_.free(t); }
   void protect_all(int prot) { block_allocator_.protect_all(prot); }
+  size_t page_count() const { return block_allocator_.page_count(); }
  private:
   LinkerBlockAllocator block_allocator_;
   DISALLOW_COPY_AND_ASSIGN(LinkerTypeAllocator);
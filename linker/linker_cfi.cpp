@@ -30,6 +30,7 @@
 
 #include "linker_debug.h"
 #include "linker_globals.h"
+#include "private/bionic_macros.h"
 #include "private/bionic_page.h"
 #include "private/bionic_prctl.h"
 
@@ -37,67 +38,120 @@
 #include <sys/types.h>
 #include <cstdint>
 
-// Update shadow without making it writable by preparing the data on the side and mremap-ing it in
-// place.
-class ShadowWrite {
-  char* shadow_start;
-  char* shadow_end;
-  char* aligned_start;
-  char* aligned_end;
-  char* tmp_start;
-
+// Updates shadow without making it writable by preparing private copies of the affected pages and
+// mremap-ing them in place on Commit(). All updates for a group of libraries loaded or unloaded
+// together go into one batch. Libraries loaded in sequence usually land next to each other, and one
+// shadow page covers a large range of address space, so a whole group usually costs a single
+// mremap instead of an mmap/mprotect/mremap cycle per library.
+class ShadowWriteBatch {
  public:
-  ShadowWrite(uint16_t* s, uint16_t* e) {
-    shadow_start = reinterpret_cast<char*>(s);
-    shadow_end = reinterpret_cast<char*>(e);
-    aligned_start = reinterpret_cast<char*>(PAGE_START(reinterpret_cast<uintptr_t>(shadow_start)));
-    aligned_end = reinterpret_cast<char*>(PAGE_END(reinterpret_cast<uintptr_t>(shadow_end)));
-    tmp_start =
-        reinterpret_cast<char*>(mmap(nullptr, aligned_end - aligned_start, PROT_READ | PROT_WRITE,
-                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
-    CHECK(tmp_start != MAP_FAILED);
-    memcpy(tmp_start, aligned_start, shadow_start - aligned_start);
-    memcpy(tmp_start + (shadow_end - aligned_start), shadow_end, aligned_end - shadow_end);
+  ShadowWriteBatch() : page_count_(0), last_(nullptr) {}
+
+  ~ShadowWriteBatch() {
+    Commit();
   }
 
-  uint16_t* begin() {
-    return reinterpret_cast<uint16_t*>(tmp_start + (shadow_start - aligned_start));
+  // Returns a pointer to the writable copy of the shadow element at s.
+  uint16_t* Get(uint16_t* s);
+
+  // Replaces the shadow pages with their updated copies.
+  void Commit();
+
+ private:
+  struct Page {
+    char* shadow;
+    char* copy;
+  };
+
+  static constexpr size_t kMaxPages = 16;
+
+  Page pages_[kMaxPages];
+  size_t page_count_;
+  Page* last_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShadowWriteBatch);
+};
+
+uint16_t* ShadowWriteBatch::Get(uint16_t* s) {
+  char* shadow = reinterpret_cast<char*>(PAGE_START(reinterpret_cast<uintptr_t>(s)));
+  if (last_ == nullptr || last_->shadow != shadow) {
+    last_ = nullptr;
+    for (size_t i = 0; i < page_count_; ++i) {
+      if (pages_[i].shadow == shadow) {
+        last_ = &pages_[i];
+        break;
+      }
+    }
   }
 
-  uint16_t* end() {
-    return reinterpret_cast<uint16_t*>(tmp_start + (shadow_end - aligned_start));
+  if (last_ == nullptr) {
+    if (page_count_ == kMaxPages) {
+      Commit();
+    }
+    char* copy = reinterpret_cast<char*>(mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    CHECK(copy != MAP_FAILED);
+    memcpy(copy, shadow, PAGE_SIZE);
+    last_ = &pages_[page_count_++];
+    last_->shadow = shadow;
+    last_->copy = copy;
   }
 
-  ~ShadowWrite() {
-    size_t size = aligned_end - aligned_start;
-    mprotect(tmp_start, size, PROT_READ);
-    void* res = mremap(tmp_start, size, size, MREMAP_MAYMOVE | MREMAP_FIXED,
-                       reinterpret_cast<void*>(aligned_start));
+  return reinterpret_cast<uint16_t*>(last_->copy + (reinterpret_cast<char*>(s) - shadow));
+}
+
+static bool is_zero_page(const char* page) {
+  const uintptr_t* words = reinterpret_cast<const uintptr_t*>(page);
+  for (size_t i = 0; i < PAGE_SIZE / sizeof(uintptr_t); ++i) {
+    if (words[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ShadowWriteBatch::Commit() {
+  for (size_t i = 0; i < page_count_; ++i) {
+    Page& page = pages_[i];
+    if (is_zero_page(page.copy)) {
+      // Everything on this page is kInvalidShadow now. Drop it instead so that it costs no memory
+      // and reads fault in the zero page until something in its range is loaded again.
+      munmap(page.copy, PAGE_SIZE);
+      CHECK(madvise(page.shadow, PAGE_SIZE, MADV_DONTNEED) == 0);
+      continue;
+    }
+    mprotect(page.copy, PAGE_SIZE, PROT_READ);
+    void* res = mremap(page.copy, PAGE_SIZE, PAGE_SIZE, MREMAP_MAYMOVE | MREMAP_FIXED, page.shadow);
     CHECK(res != MAP_FAILED);
   }
-};
+  page_count_ = 0;
+  last_ = nullptr;
+}
 
 void CFIShadowWriter::FixupVmaName() {
   prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, *shadow_start, kShadowSize, "cfi shadow");
 }
 
-void CFIShadowWriter::AddConstant(uintptr_t begin, uintptr_t end, uint16_t v) {
+void CFIShadowWriter::AddConstant(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end,
+                                  uint16_t v) {
   uint16_t* shadow_begin = MemToShadow(begin);
   uint16_t* shadow_end = MemToShadow(end - 1) + 1;
 
-  ShadowWrite sw(shadow_begin, shadow_end);
-  std::fill(sw.begin(), sw.end(), v);
+  for (uint16_t* p = shadow_begin; p != shadow_end; ++p) {
+    *batch->Get(p) = v;
+  }
 }
 
-void CFIShadowWriter::AddUnchecked(uintptr_t begin, uintptr_t end) {
-  AddConstant(begin, end, kUncheckedShadow);
+void CFIShadowWriter::AddUnchecked(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end) {
+  AddConstant(batch, begin, end, kUncheckedShadow);
 }
 
-void CFIShadowWriter::AddInvalid(uintptr_t begin, uintptr_t end) {
-  AddConstant(begin, end, kInvalidShadow);
+void CFIShadowWriter::AddInvalid(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end) {
+  AddConstant(batch, begin, end, kInvalidShadow);
 }
 
-void CFIShadowWriter::Add(uintptr_t begin, uintptr_t end, uintptr_t cfi_check) {
+void CFIShadowWriter::Add(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end,
+                          uintptr_t cfi_check) {
   CHECK((cfi_check & (kCfiCheckAlign - 1)) == 0);
 
   // Don't fill anything below cfi_check. We can not represent those addresses
@@ -107,7 +161,6 @@ void CFIShadowWriter::Add(uintptr_t begin, uintptr_t end, uintptr_t cfi_check) {
   uint16_t* shadow_begin = MemToShadow(begin);
   uint16_t* shadow_end = MemToShadow(end - 1) + 1;
 
-  ShadowWrite sw(shadow_begin, shadow_end);
   uint16_t sv_begin = ((begin + kShadowAlign - cfi_check) >> kCfiCheckGranularity) + kRegularShadowMin;
 
   // With each step of the loop below, __cfi_check address computation base is increased by
@@ -116,7 +169,8 @@ void CFIShadowWriter::Add(uintptr_t begin, uintptr_t end, uintptr_t cfi_check) {
   // 2**CfiCheckGranularity.
   uint16_t sv_step = 1 << (kShadowGranularity - kCfiCheckGranularity);
   uint16_t sv = sv_begin;
-  for (uint16_t& s : sw) {
+  for (uint16_t* p = shadow_begin; p != shadow_end; ++p) {
+    uint16_t& s = *batch->Get(p);
     if (sv < sv_begin) {
       // If shadow value wraps around, also fall back to unchecked. This means the binary is too
       // large. FIXME: consider using a (slow) resolution function instead.
@@ -160,7 +214,7 @@ uintptr_t CFIShadowWriter::MapShadow() {
   return reinterpret_cast<uintptr_t>(p);
 }
 
-bool CFIShadowWriter::AddLibrary(soinfo* si) {
+bool CFIShadowWriter::AddLibrary(ShadowWriteBatch* batch, soinfo* si) {
   CHECK(shadow_start != nullptr);
   if (si->base == 0 || si->size == 0) {
     return true;
@@ -169,7 +223,7 @@ bool CFIShadowWriter::AddLibrary(soinfo* si) {
   if (cfi_check == 0) {
     INFO("[ CFI add 0x%zx + 0x%zx %s ]", static_cast<uintptr_t>(si->base),
          static_cast<uintptr_t>(si->size), si->get_soname());
-    AddUnchecked(si->base, si->base + si->size);
+    AddUnchecked(batch, si->base, si->base + si->size);
     return true;
   }
 
@@ -187,7 +241,7 @@ bool CFIShadowWriter::AddLibrary(soinfo* si) {
     DL_ERR("unaligned __cfi_check in the library \"%s\"", si->get_soname());
     return false;
   }
-  Add(si->base, si->base + si->size, cfi_check);
+  Add(batch, si->base, si->base + si->size, cfi_check);
   return true;
 }
 
@@ -209,12 +263,12 @@ bool CFIShadowWriter::NotifyLibDl(soinfo* solist, uintptr_t p) {
   return true;
 }
 
-bool CFIShadowWriter::MaybeInit(soinfo* new_si, soinfo* solist) {
+bool CFIShadowWriter::MaybeInit(const soinfo_list_t* new_sis, soinfo* solist) {
   CHECK(initial_link_done);
   CHECK(shadow_start == nullptr);
   // Check if CFI shadow must be initialized at this time.
   bool found = false;
-  if (new_si == nullptr) {
+  if (new_sis == nullptr) {
     // This is the case when we've just completed the initial link. There may have been earlier
     // calls to MaybeInit that were skipped. Look though the entire solist.
     for (soinfo* si = solist; si != nullptr; si = si->next) {
@@ -224,8 +278,8 @@ bool CFIShadowWriter::MaybeInit(soinfo* new_si, soinfo* solist) {
       }
     }
   } else {
-    // See if the new library uses CFI.
-    found = soinfo_find_cfi_check(new_si);
+    // See if any of the new libraries uses CFI.
+    found = new_sis->find_if([](soinfo* si) { return soinfo_find_cfi_check(si) != 0; }) != nullptr;
   }
 
   // Nothing found.
@@ -236,37 +290,46 @@ bool CFIShadowWriter::MaybeInit(soinfo* new_si, soinfo* solist) {
   // Init shadow and add all currently loaded libraries (not just the new ones).
   if (!NotifyLibDl(solist, MapShadow()))
     return false;
+  ShadowWriteBatch batch;
   for (soinfo* si = solist; si != nullptr; si = si->next) {
-    if (!AddLibrary(si))
+    if (!AddLibrary(&batch, si))
       return false;
   }
+  batch.Commit();
   FixupVmaName();
   return true;
 }
 
-bool CFIShadowWriter::AfterLoad(soinfo* si, soinfo* solist) {
+bool CFIShadowWriter::AfterLoad(const soinfo_list_t& sis, soinfo* solist) {
   if (!initial_link_done) {
     // Too early.
     return true;
   }
 
   if (shadow_start == nullptr) {
-    return MaybeInit(si, solist);
+    return MaybeInit(&sis, solist);
   }
 
-  // Add the new library to the CFI shadow.
-  if (!AddLibrary(si))
-    return false;
+  // Add the new libraries to the CFI shadow.
+  ShadowWriteBatch batch;
+  bool added = sis.visit([&](soinfo* si) {
+    return AddLibrary(&batch, si);
+  });
+  batch.Commit();
   FixupVmaName();
-  return true;
+  return added;
 }
 
-void CFIShadowWriter::BeforeUnload(soinfo* si) {
+void CFIShadowWriter::BeforeUnload(const soinfo_list_t& sis) {
   if (shadow_start == nullptr) return;
-  if (si->base == 0 || si->size == 0) return;
-  INFO("[ CFI remove 0x%zx + 0x%zx: %s ]", static_cast<uintptr_t>(si->base),
-       static_cast<uintptr_t>(si->size), si->get_soname());
-  AddInvalid(si->base, si->base + si->size);
+  ShadowWriteBatch batch;
+  sis.for_each([&](soinfo* si) {
+    if (si->base == 0 || si->size == 0) return;
+    INFO("[ CFI remove 0x%zx + 0x%zx: %s ]", static_cast<uintptr_t>(si->base),
+         static_cast<uintptr_t>(si->size), si->get_soname());
+    AddInvalid(&batch, si->base, si->base + si->size);
+  });
+  batch.Commit();
   FixupVmaName();
 }
 
@@ -280,7 +343,7 @@ bool CFIShadowWriter::InitialLinkDone(soinfo* solist) {
 // valid CFI target, we can not use CFI shadow for lookup. This does not need to be fast, do the
 // regular symbol lookup.
 void CFIShadowWriter::CfiFail(uint64_t CallSiteTypeId, void* Ptr, void* DiagData, void* CallerPc) {
-  soinfo* si = find_containing_library(CallerPc);
+  soinfo* si = find_containing_library_unlocked(CallerPc);
   if (!si) {
     __builtin_trap();
   }
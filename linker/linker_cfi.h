@@ -36,13 +36,15 @@
 
 #include "private/CFIShadow.h"
 
+class ShadowWriteBatch;
+
 // This class keeps the contents of CFI shadow up-to-date with the current set of loaded libraries.
 // See the comment in CFIShadow.h for more context.
 // See documentation in http://clang.llvm.org/docs/ControlFlowIntegrityDesign.html#shared-library-support.
 //
 // Shadow is mapped and initialized lazily as soon as the first CFI-enabled DSO is loaded.
-// It is updated after any library is loaded (but before any constructors are ran), and
-// before any library is unloaded.
+// It is updated after any group of libraries is loaded (but before any constructors are ran), and
+// before any group of libraries is unloaded. Each update goes through a single ShadowWriteBatch.
 class CFIShadowWriter : private CFIShadow {
   // Returns pointer to the shadow element for an address.
   uint16_t* MemToShadow(uintptr_t x) {
@@ -50,27 +52,27 @@ class CFIShadowWriter : private CFIShadow {
   }
 
   // Update shadow for the address range to the given constant value.
-  void AddConstant(uintptr_t begin, uintptr_t end, uint16_t v);
+  void AddConstant(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end, uint16_t v);
 
   // Update shadow for the address range to kUncheckedShadow.
-  void AddUnchecked(uintptr_t begin, uintptr_t end);
+  void AddUnchecked(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end);
 
   // Update shadow for the address range to kInvalidShadow.
-  void AddInvalid(uintptr_t begin, uintptr_t end);
+  void AddInvalid(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end);
 
   // Update shadow for the address range to the given __cfi_check value.
-  void Add(uintptr_t begin, uintptr_t end, uintptr_t cfi_check);
+  void Add(ShadowWriteBatch* batch, uintptr_t begin, uintptr_t end, uintptr_t cfi_check);
 
   // Add a DSO to CFI shadow.
-  bool AddLibrary(soinfo* si);
+  bool AddLibrary(ShadowWriteBatch* batch, soinfo* si);
 
   // Map CFI shadow.
   uintptr_t MapShadow();
 
   // Initialize CFI shadow and update its contents for everything in solist if any loaded library is
-  // CFI-enabled. If new_si != nullptr, do an incremental check by looking only at new_si; otherwise
-  // look at the entire solist.
-  bool MaybeInit(soinfo *new_si, soinfo *solist);
+  // CFI-enabled. If new_sis != nullptr, do an incremental check by looking only at new_sis;
+  // otherwise look at the entire solist.
+  bool MaybeInit(const soinfo_list_t* new_sis, soinfo *solist);
 
   // Set a human readable name for the entire shadow region.
   void FixupVmaName();
@@ -85,15 +87,15 @@ class CFIShadowWriter : private CFIShadow {
   bool initial_link_done;
 
  public:
-  // Update shadow after loading a DSO.
+  // Update shadow after loading a group of DSOs.
   // This function will initialize the shadow if it sees a CFI-enabled DSO for the first time.
   // In that case it will retroactively update shadow for all previously loaded DSOs. "solist" is a
   // pointer to the global list.
   // This function must be called before any user code has observed the newly loaded DSO.
-  bool AfterLoad(soinfo* si, soinfo *solist);
+  bool AfterLoad(const soinfo_list_t& sis, soinfo *solist);
 
-  // Update shadow before unloading a DSO.
-  void BeforeUnload(soinfo* si);
+  // Update shadow before unloading a group of DSOs.
+  void BeforeUnload(const soinfo_list_t& sis);
 
   // This is called as soon as the initial set of libraries is linked.
   bool InitialLinkDone(soinfo *solist);
@@ -37,7 +37,11 @@
 
 #include <private/ScopeGuard.h>
 
+#include <fcntl.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <string>
 #include <unordered_map>
@@ -274,6 +278,198 @@ static bool parse_config_file(const char* ld_config_file_path,
   return true;
 }
 
+// The compiled form of an ld.config.txt file, see Config::write_compiled_config().
+//
+// It holds what parse_config_file() would extract from the text for any binary
+// - the dir.<section> properties in file order and the properties of every
+// section - already tokenized and trimmed, so that reading it takes one mmap
+// and no parsing. It is only used while the text file it was compiled from is
+// unchanged; otherwise the text is parsed as usual.
+//
+// Layout: header, dirs[], sections[], properties[] and a block of
+// NUL-terminated strings. All offsets are from the start of the file and all
+// string references are offsets into the string block.
+static constexpr uint32_t kCompiledConfigMagic = 0x4343444c; // "LDCC"
+static constexpr uint32_t kCompiledConfigVersion = 1;
+static constexpr uint32_t kCompiledConfigNoSection = UINT32_MAX;
+static constexpr const char* kCompiledConfigSuffix = ".compiled";
+
+struct compiled_config_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t file_size;
+
+  // Identity of the text file this was compiled from.
+  uint64_t source_dev;
+  uint64_t source_ino;
+  uint64_t source_size;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+
+  // Number of lines in the text file, for the "section not found" error.
+  uint32_t source_line_count;
+
+  uint32_t dir_count;
+  uint32_t dirs_offset;
+  uint32_t section_count;
+  uint32_t sections_offset;
+  uint32_t property_count;
+  uint32_t properties_offset;
+  uint32_t strings_offset;
+  uint32_t strings_size;
+  uint32_t reserved;
+};
+
+struct compiled_config_dir {
+  uint32_t path;
+  uint32_t section_name;
+  uint32_t section_index;  // kCompiledConfigNoSection if there is no such section.
+};
+
+struct compiled_config_section {
+  uint32_t name;
+  uint32_t first_property;
+  uint32_t property_count;
+};
+
+struct compiled_config_property {
+  uint32_t name;
+  uint32_t value;
+  uint32_t lineno;
+};
+
+static bool is_same_source_file(const compiled_config_header* header, const struct stat& st) {
+  return header->source_dev == static_cast<uint64_t>(st.st_dev) &&
+         header->source_ino == static_cast<uint64_t>(st.st_ino) &&
+         header->source_size == static_cast<uint64_t>(st.st_size) &&
+         header->source_mtime_sec == static_cast<int64_t>(st.st_mtim.tv_sec) &&
+         header->source_mtime_nsec == static_cast<int64_t>(st.st_mtim.tv_nsec);
+}
+
+// Returns false if there is no usable compiled config for ld_config_file_path
+// (missing, stale or malformed), in which case the text file should be parsed.
+// Otherwise *result is set to what parse_config_file() would have returned.
+static bool read_compiled_config_file(const char* ld_config_file_path,
+                                      const char* binary_realpath,
+                                      std::unordered_map<std::string, PropertyValue>* properties,
+                                      std::string* error_msg,
+                                      bool* result) {
+  std::string compiled_config_path = Config::get_compiled_config_path(ld_config_file_path);
+  int fd = TEMP_FAILURE_RETRY(open(compiled_config_path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat compiled_stat;
+  struct stat source_stat;
+  if (fstat(fd, &compiled_stat) != 0 ||
+      static_cast<size_t>(compiled_stat.st_size) < sizeof(compiled_config_header) ||
+      stat(ld_config_file_path, &source_stat) != 0) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = compiled_stat.st_size;
+  void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+
+  auto map_guard = make_scope_guard([&] {
+    munmap(map, size);
+  });
+
+  const char* base = static_cast<const char*>(map);
+  const compiled_config_header* header = reinterpret_cast<const compiled_config_header*>(base);
+
+  auto is_valid_array = [&](uint32_t offset, uint32_t count, size_t element_size) {
+    return offset % sizeof(uint32_t) == 0 &&
+           static_cast<uint64_t>(offset) + static_cast<uint64_t>(count) * element_size <= size;
+  };
+
+  if (header->magic != kCompiledConfigMagic ||
+      header->version != kCompiledConfigVersion ||
+      header->file_size != size ||
+      !is_same_source_file(header, source_stat) ||
+      !is_valid_array(header->dirs_offset, header->dir_count, sizeof(compiled_config_dir)) ||
+      !is_valid_array(header->sections_offset, header->section_count,
+                      sizeof(compiled_config_section)) ||
+      !is_valid_array(header->properties_offset, header->property_count,
+                      sizeof(compiled_config_property)) ||
+      header->strings_size == 0 ||
+      static_cast<uint64_t>(header->strings_offset) + header->strings_size > size ||
+      base[header->strings_offset + header->strings_size - 1] != '\0') {
+    return false;
+  }
+
+  const compiled_config_dir* dirs =
+      reinterpret_cast<const compiled_config_dir*>(base + header->dirs_offset);
+  const compiled_config_section* sections =
+      reinterpret_cast<const compiled_config_section*>(base + header->sections_offset);
+  const compiled_config_property* props =
+      reinterpret_cast<const compiled_config_property*>(base + header->properties_offset);
+  const char* strings = base + header->strings_offset;
+
+  auto is_valid_string = [&](uint32_t offset) {
+    return offset < header->strings_size;
+  };
+
+  const compiled_config_dir* dir = nullptr;
+  for (size_t i = 0; i < header->dir_count; ++i) {
+    if (!is_valid_string(dirs[i].path)) {
+      return false;
+    }
+
+    if (file_is_under_dir(binary_realpath, strings + dirs[i].path)) {
+      dir = &dirs[i];
+      break;
+    }
+  }
+
+  if (dir == nullptr) {
+    *result = false;
+    return true;
+  }
+
+  if (dir->section_index == kCompiledConfigNoSection) {
+    if (!is_valid_string(dir->section_name)) {
+      return false;
+    }
+
+    *error_msg = create_error_msg(ld_config_file_path,
+                                  header->source_line_count,
+                                  std::string("section \"") + (strings + dir->section_name) +
+                                  "\" not found");
+    *result = false;
+    return true;
+  }
+
+  if (dir->section_index >= header->section_count) {
+    return false;
+  }
+
+  const compiled_config_section* section = &sections[dir->section_index];
+  if (static_cast<uint64_t>(section->first_property) + section->property_count >
+      header->property_count) {
+    return false;
+  }
+
+  for (size_t i = section->first_property;
+       i < section->first_property + section->property_count; ++i) {
+    if (!is_valid_string(props[i].name) || !is_valid_string(props[i].value)) {
+      properties->clear();
+      return false;
+    }
+
+    (*properties)[strings + props[i].name] =
+        PropertyValue(std::string(strings + props[i].value), props[i].lineno);
+  }
+
+  *result = true;
+  return true;
+}
+
 static Config g_config;
 
 static constexpr const char* kDefaultConfigName = "default";
@@ -382,7 +578,13 @@ bool Config::read_binary_config(const char* ld_config_file_path,
   g_config.clear();
 
   std::unordered_map<std::string, PropertyValue> property_map;
-  if (!parse_config_file(ld_config_file_path, binary_realpath, &property_map, error_msg)) {
+  bool parsed;
+  if (!read_compiled_config_file(ld_config_file_path, binary_realpath,
+                                 &property_map, error_msg, &parsed)) {
+    parsed = parse_config_file(ld_config_file_path, binary_realpath, &property_map, error_msg);
+  }
+
+  if (!parsed) {
     return false;
   }
 
@@ -429,6 +631,7 @@ bool Config::read_binary_config(const char* ld_config_file_path,
   }
 
   g_config.set_target_sdk_version(target_sdk_version);
+  g_config.set_link_plan_dir(properties.get_string("link.plan.dir"));
 
   for (auto ns_config_it : namespace_configs) {
     auto& name = ns_config_it.first;
@@ -469,6 +672,13 @@ bool Config::read_binary_config(const char* ld_config_file_path,
 
     ns_config->set_isolated(properties.get_bool(property_name_prefix + ".isolated"));
     ns_config->set_visible(properties.get_bool(property_name_prefix + ".visible"));
+    ns_config->set_readahead(properties.get_bool(property_name_prefix + ".readahead"));
+    ns_config->set_share_libraries(properties.get_bool(property_name_prefix + ".share_libraries"));
+    ns_config->set_lazy_binding(properties.get_bool(property_name_prefix + ".lazy_binding"));
+    ns_config->set_relro_cache_path(properties.get_string(property_name_prefix +
+                                                          ".relro.cache.path"));
+    ns_config->set_zip_cache_path(properties.get_string(property_name_prefix +
+                                                        ".zip.cache.path"));
 
     // these are affected by is_asan flag
     if (is_asan) {
@@ -494,4 +704,179 @@ NamespaceConfig* Config::create_namespace_config(const std::string& name) {
 void Config::clear() {
   namespace_configs_.clear();
   namespace_configs_map_.clear();
+  link_plan_dir_.clear();
+}
+
+bool Config::write_compiled_config(const char* ld_config_file_path,
+                                   const char* compiled_config_path,
+                                   std::string* error_msg) {
+  struct stat source_stat;
+  std::string content;
+  if (stat(ld_config_file_path, &source_stat) != 0 ||
+      !android::base::ReadFileToString(ld_config_file_path, &content)) {
+    *error_msg = std::string("error reading file \"") +
+                 ld_config_file_path + "\": " + strerror(errno);
+    return false;
+  }
+
+  struct dir_entry {
+    std::string path;
+    std::string section_name;
+  };
+
+  struct section_entry {
+    std::string name;
+    std::vector<std::pair<std::string, PropertyValue>> properties;
+  };
+
+  std::vector<dir_entry> dirs;
+  std::vector<section_entry> sections;
+  std::unordered_map<std::string, size_t> section_index_map;
+  // Only valid until the next section is added.
+  section_entry* current_section = nullptr;
+
+  ConfigParser cp(std::move(content));
+  while (true) {
+    std::string name;
+    std::string value;
+    std::string error;
+
+    int result = cp.next_token(&name, &value, &error);
+    if (result == ConfigParser::kEndOfFile) {
+      break;
+    }
+
+    if (result == ConfigParser::kError) {
+      DL_WARN("error parsing %s:%zd: %s (ignoring this line)",
+              ld_config_file_path,
+              cp.lineno(),
+              error.c_str());
+      continue;
+    }
+
+    if (result == ConfigParser::kSection) {
+      // Like parse_config_file(), only the first section with a given name is used.
+      if (section_index_map.find(name) != section_index_map.end()) {
+        DL_WARN("%s:%zd: warning: section \"%s\" redefinition (ignoring this section)",
+                ld_config_file_path,
+                cp.lineno(),
+                name.c_str());
+        current_section = nullptr;
+        continue;
+      }
+
+      section_index_map[name] = sections.size();
+      sections.push_back(section_entry());
+      current_section = &sections.back();
+      current_section->name = name;
+      continue;
+    }
+
+    if (!section_index_map.empty()) {
+      if (current_section != nullptr) {
+        current_section->properties.push_back(
+            std::make_pair(name, PropertyValue(std::move(value), cp.lineno())));
+      }
+      continue;
+    }
+
+    if (!android::base::StartsWith(name, "dir.")) {
+      DL_WARN("error parsing %s:%zd: unexpected property name \"%s\", "
+              "expected format dir.<section_name> (ignoring this line)",
+              ld_config_file_path,
+              cp.lineno(),
+              name.c_str());
+      continue;
+    }
+
+    while (!value.empty() && value[value.size() - 1] == '/') {
+      value = value.substr(0, value.size() - 1);
+    }
+
+    if (value.empty()) {
+      DL_WARN("error parsing %s:%zd: property value is empty (ignoring this line)",
+              ld_config_file_path,
+              cp.lineno());
+      continue;
+    }
+
+    dirs.push_back({ value, name.substr(4) });
+  }
+
+  std::string strings;
+  auto add_string = [&](const std::string& str) {
+    uint32_t offset = strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+    return offset;
+  };
+
+  std::vector<compiled_config_dir> compiled_dirs;
+  for (const auto& dir : dirs) {
+    auto it = section_index_map.find(dir.section_name);
+    compiled_dirs.push_back({ add_string(dir.path),
+                              add_string(dir.section_name),
+                              it == section_index_map.end() ?
+                                  kCompiledConfigNoSection : static_cast<uint32_t>(it->second) });
+  }
+
+  std::vector<compiled_config_section> compiled_sections;
+  std::vector<compiled_config_property> compiled_properties;
+  for (const auto& section : sections) {
+    compiled_sections.push_back({ add_string(section.name),
+                                  static_cast<uint32_t>(compiled_properties.size()),
+                                  static_cast<uint32_t>(section.properties.size()) });
+    for (const auto& property : section.properties) {
+      compiled_properties.push_back({ add_string(property.first),
+                                      add_string(property.second.value()),
+                                      static_cast<uint32_t>(property.second.lineno()) });
+    }
+  }
+
+  compiled_config_header header = {};
+  header.magic = kCompiledConfigMagic;
+  header.version = kCompiledConfigVersion;
+  header.source_dev = source_stat.st_dev;
+  header.source_ino = source_stat.st_ino;
+  header.source_size = source_stat.st_size;
+  header.source_mtime_sec = source_stat.st_mtim.tv_sec;
+  header.source_mtime_nsec = source_stat.st_mtim.tv_nsec;
+  header.source_line_count = cp.lineno();
+  header.dir_count = compiled_dirs.size();
+  header.dirs_offset = sizeof(header);
+  header.section_count = compiled_sections.size();
+  header.sections_offset = header.dirs_offset + compiled_dirs.size() * sizeof(compiled_config_dir);
+  header.property_count = compiled_properties.size();
+  header.properties_offset = header.sections_offset +
+                             compiled_sections.size() * sizeof(compiled_config_section);
+  header.strings_offset = header.properties_offset +
+                          compiled_properties.size() * sizeof(compiled_config_property);
+  header.strings_size = strings.size();
+  header.file_size = header.strings_offset + header.strings_size;
+
+  std::string compiled;
+  compiled.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  compiled.append(reinterpret_cast<const char*>(compiled_dirs.data()),
+                  compiled_dirs.size() * sizeof(compiled_config_dir));
+  compiled.append(reinterpret_cast<const char*>(compiled_sections.data()),
+                  compiled_sections.size() * sizeof(compiled_config_section));
+  compiled.append(reinterpret_cast<const char*>(compiled_properties.data()),
+                  compiled_properties.size() * sizeof(compiled_config_property));
+  compiled.append(strings);
+
+  // Write a temporary file and rename it so that the linker never sees a partial file.
+  std::string temp_path = std::string(compiled_config_path) + ".tmp";
+  if (!android::base::WriteStringToFile(compiled, temp_path) ||
+      rename(temp_path.c_str(), compiled_config_path) != 0) {
+    *error_msg = std::string("error writing file \"") +
+                 compiled_config_path + "\": " + strerror(errno);
+    unlink(temp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+std::string Config::get_compiled_config_path(const char* ld_config_file_path) {
+  return std::string(ld_config_file_path) + kCompiledConfigSuffix;
 }
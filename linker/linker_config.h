@@ -62,7 +62,8 @@ class NamespaceLinkConfig {
 class NamespaceConfig {
  public:
   explicit NamespaceConfig(const std::string& name)
-      : name_(name), isolated_(false), visible_(false)
+      : name_(name), isolated_(false), visible_(false), readahead_(false), share_libraries_(false),
+        lazy_binding_(false)
   {}
 
   const char* name() const {
@@ -77,6 +78,26 @@ class NamespaceConfig {
     return visible_;
   }
 
+  bool readahead() const {
+    return readahead_;
+  }
+
+  bool share_libraries() const {
+    return share_libraries_;
+  }
+
+  bool lazy_binding() const {
+    return lazy_binding_;
+  }
+
+  const std::string& relro_cache_path() const {
+    return relro_cache_path_;
+  }
+
+  const std::string& zip_cache_path() const {
+    return zip_cache_path_;
+  }
+
   const std::vector<std::string>& search_paths() const {
     return search_paths_;
   }
@@ -101,6 +122,26 @@ class NamespaceConfig {
     visible_ = visible;
   }
 
+  void set_readahead(bool readahead) {
+    readahead_ = readahead;
+  }
+
+  void set_share_libraries(bool share_libraries) {
+    share_libraries_ = share_libraries;
+  }
+
+  void set_lazy_binding(bool lazy_binding) {
+    lazy_binding_ = lazy_binding;
+  }
+
+  void set_relro_cache_path(const std::string& relro_cache_path) {
+    relro_cache_path_ = relro_cache_path;
+  }
+
+  void set_zip_cache_path(const std::string& zip_cache_path) {
+    zip_cache_path_ = zip_cache_path;
+  }
+
   void set_search_paths(std::vector<std::string>&& search_paths) {
     search_paths_ = search_paths;
   }
@@ -112,6 +153,11 @@ class NamespaceConfig {
   const std::string name_;
   bool isolated_;
   bool visible_;
+  bool readahead_;
+  bool share_libraries_;
+  bool lazy_binding_;
+  std::string relro_cache_path_;
+  std::string zip_cache_path_;
   std::vector<std::string> search_paths_;
   std::vector<std::string> permitted_paths_;
   std::vector<NamespaceLinkConfig> namespace_links_;
@@ -136,6 +182,12 @@ class Config {
     return target_sdk_version_;
   }
 
+  // Directory holding the link plans of the executables this config applies
+  // to (see linker_link_plan.h); empty if link plans are not used.
+  const std::string& link_plan_dir() const {
+    return link_plan_dir_;
+  }
+
   // note that this is one time event and therefore there is no need to
   // read every section of the config. Every linker instance needs at
   // most one configuration.
@@ -146,6 +198,16 @@ class Config {
                                  bool is_asan,
                                  const Config** config,
                                  std::string* error_msg);
+
+  // Compiles the text config into the binary form read_binary_config() uses,
+  // which must be stored at get_compiled_config_path(ld_config_file_path).
+  // The compiled config is ignored as soon as the text file is changed, so
+  // this has to be rerun whenever the text file is (re)installed.
+  static bool write_compiled_config(const char* ld_config_file_path,
+                                    const char* compiled_config_path,
+                                    std::string* error_msg);
+
+  static std::string get_compiled_config_path(const char* ld_config_file_path);
  private:
   void clear();
 
@@ -153,11 +215,16 @@ class Config {
     target_sdk_version_ = target_sdk_version;
   }
 
+  void set_link_plan_dir(const std::string& link_plan_dir) {
+    link_plan_dir_ = link_plan_dir;
+  }
+
   NamespaceConfig* create_namespace_config(const std::string& name);
 
   std::vector<std::unique_ptr<NamespaceConfig>> namespace_configs_;
   std::unordered_map<std::string, NamespaceConfig*> namespace_configs_map_;
   uint32_t target_sdk_version_;
+  std::string link_plan_dir_;
 
   DISALLOW_COPY_AND_ASSIGN(Config);
 };
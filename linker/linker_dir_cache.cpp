@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "linker_dir_cache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+static bool same_directory(const struct stat& st, dev_t dev, ino_t ino, const timespec& mtime) {
+  return st.st_dev == dev &&
+         st.st_ino == ino &&
+         st.st_mtim.tv_sec == mtime.tv_sec &&
+         st.st_mtim.tv_nsec == mtime.tv_nsec;
+}
+
+// The file system only updates a directory's mtime with coarse granularity,
+// so a change made right after we list a directory may leave the mtime as it
+// was. Listings of directories modified this recently are not trusted.
+static constexpr time_t kRecentlyModifiedSeconds = 2;
+
+static bool modified_recently(const timespec& mtime) {
+  timespec now;
+  if (clock_gettime(CLOCK_REALTIME, &now) != 0) {
+    return true;
+  }
+  return now.tv_sec - mtime.tv_sec < kRecentlyModifiedSeconds;
+}
+
+bool DirectoryCache::list(const std::string& dir, entry* e) {
+  struct stat before;
+  if (stat(dir.c_str(), &before) != 0 || !S_ISDIR(before.st_mode) ||
+      modified_recently(before.st_mtim)) {
+    return false;
+  }
+
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return false;
+  }
+
+  std::unordered_set<std::string> names;
+  dirent* de;
+  while ((de = readdir(d)) != nullptr) {
+    names.insert(de->d_name);
+  }
+  closedir(d);
+
+  // The directory must not have changed while we were reading it.
+  struct stat after;
+  if (stat(dir.c_str(), &after) != 0 ||
+      !same_directory(after, before.st_dev, before.st_ino, before.st_mtim)) {
+    return false;
+  }
+
+  e->listed = true;
+  e->validated_epoch = epoch_;
+  e->dev = before.st_dev;
+  e->ino = before.st_ino;
+  e->mtime = before.st_mtim;
+  e->names.swap(names);
+  return true;
+}
+
+bool DirectoryCache::revalidate(const std::string& dir, entry* e) {
+  if (e->validated_epoch == epoch_) {
+    return true;
+  }
+
+  struct stat st;
+  if (stat(dir.c_str(), &st) != 0 || !same_directory(st, e->dev, e->ino, e->mtime)) {
+    return false;
+  }
+
+  e->validated_epoch = epoch_;
+  return true;
+}
+
+bool DirectoryCache::may_contain(const std::string& dir, const char* name) {
+  auto it = dirs_.find(dir);
+  if (it == dirs_.end() || !it->second.listed) {
+    return true;
+  }
+
+  entry* e = &it->second;
+  if (!revalidate(dir, e)) {
+    // Start over; the directory will be listed again if lookups keep failing.
+    *e = entry();
+    return true;
+  }
+
+  return e->names.find(name) != e->names.end();
+}
+
+void DirectoryCache::record_miss(const std::string& dir) {
+  entry* e = &dirs_[dir];
+  if (e->listed) {
+    return;
+  }
+
+  if (++e->misses >= kListingThreshold && !list(dir, e)) {
+    // Not a directory we can list (or it keeps changing); try again later.
+    e->misses = 0;
+  }
+}
+
+size_t DirectoryCache::listed_dir_count() const {
+  size_t count = 0;
+  for (const auto& it : dirs_) {
+    if (it.second.listed) {
+      ++count;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __LINKER_DIR_CACHE_H
+#define __LINKER_DIR_CACHE_H
+
+#include <time.h>
+#include <sys/types.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "private/bionic_macros.h"
+
+// Remembers what the directories on the library search paths contain, so
+// that looking a library up on a path does not have to try open() in every
+// directory before the one that has it.
+//
+// A directory is only listed after the lookups in it have failed
+// kListingThreshold times, so that short-lived processes do not pay for
+// reading large directories they only probe a few times. A listing is
+// trusted for as long as the directory's mtime stays the same; the mtime is
+// checked again at most once per epoch (the linker starts a new epoch for
+// every find_libraries() call). Directories modified in the last couple of
+// seconds are not listed, since a further change might not move the mtime.
+class DirectoryCache {
+ public:
+  static constexpr size_t kListingThreshold = 4;
+
+  DirectoryCache() : epoch_(1) {}
+
+  void new_epoch() { ++epoch_; }
+
+  // Returns false if dir is known not to contain name. A true result only
+  // means that the caller has to look.
+  bool may_contain(const std::string& dir, const char* name);
+
+  // Tells the cache that a lookup of a file in dir failed.
+  void record_miss(const std::string& dir);
+
+  // Forgets all the listings.
+  void clear() { dirs_.clear(); }
+
+  size_t listed_dir_count() const;
+
+ private:
+  struct entry {
+    entry() : listed(false), validated_epoch(0), misses(0), dev(0), ino(0), mtime() {}
+
+    bool listed;
+    size_t validated_epoch;
+    size_t misses;
+    dev_t dev;
+    ino_t ino;
+    timespec mtime;
+    std::unordered_set<std::string> names;
+  };
+
+  bool list(const std::string& dir, entry* e);
+  bool revalidate(const std::string& dir, entry* e);
+
+  size_t epoch_;
+  std::unordered_map<std::string, entry> dirs_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirectoryCache);
+};
+
+#endif  // __LINKER_DIR_CACHE_H
@@ -85,6 +85,26 @@ void notify_gdb_of_load(link_map* map) {
   rtld_db_dlactivity();
 }
 
+// Adds several libraries under a single RT_ADD/RT_CONSISTENT pair, so that a
+// debugger stops and rereads the list once rather than twice per library.
+void notify_gdb_of_loads(link_map* maps[], size_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  ScopedPthreadMutexLocker locker(&g__r_debug_mutex);
+
+  _r_debug.r_state = r_debug::RT_ADD;
+  rtld_db_dlactivity();
+
+  for (size_t i = 0; i < count; ++i) {
+    insert_link_map_into_debug_map(maps[i]);
+  }
+
+  _r_debug.r_state = r_debug::RT_CONSISTENT;
+  rtld_db_dlactivity();
+}
+
 void notify_gdb_of_unload(link_map* map) {
   ScopedPthreadMutexLocker locker(&g__r_debug_mutex);
 
@@ -97,6 +117,26 @@ void notify_gdb_of_unload(link_map* map) {
   rtld_db_dlactivity();
 }
 
+// Removes several libraries under a single RT_DELETE/RT_CONSISTENT pair, so that a
+// debugger stops and rereads the list once rather than twice per library.
+void notify_gdb_of_unloads(link_map* maps[], size_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  ScopedPthreadMutexLocker locker(&g__r_debug_mutex);
+
+  _r_debug.r_state = r_debug::RT_DELETE;
+  rtld_db_dlactivity();
+
+  for (size_t i = 0; i < count; ++i) {
+    remove_link_map_from_debug_map(maps[i]);
+  }
+
+  _r_debug.r_state = r_debug::RT_CONSISTENT;
+  rtld_db_dlactivity();
+}
+
 void notify_gdb_of_libraries() {
   _r_debug.r_state = r_debug::RT_ADD;
   rtld_db_dlactivity();
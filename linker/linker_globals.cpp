@@ -34,6 +34,10 @@ int g_argc = 0;
 char** g_argv = nullptr;
 char** g_envp = nullptr;
 
+bool g_ld_bind_now = false;
+
+libc_linker_stats g_linker_stats;
+
 android_namespace_t g_default_namespace;
 
 std::unordered_map<uintptr_t, soinfo*> g_soinfo_handles_map;
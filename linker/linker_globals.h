@@ -34,6 +34,7 @@
 
 #include <unordered_map>
 
+#include "private/bionic_stats.h"
 #include "private/libc_logging.h"
 
 #define DL_ERR(fmt, x...) \
@@ -64,6 +65,14 @@ extern int g_argc;
 extern char** g_argv;
 extern char** g_envp;
 
+// LD_BIND_NOW: bind the whole PLT of every library when it's linked, even where
+// lazy binding was asked for.
+extern bool g_ld_bind_now;
+
+// dlopen and dlsym counts and times for android_libc_get_stats, updated with
+// g_dl_mutex held.
+extern libc_linker_stats g_linker_stats;
+
 struct soinfo;
 struct android_namespace_t;
 
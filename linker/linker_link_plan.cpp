@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "linker_link_plan.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <android-base/file.h>
+
+static constexpr uint32_t kLinkPlanMagic = 0x504c444c; // "LDLP"
+static constexpr uint32_t kLinkPlanVersion = 1;
+static constexpr const char* kLinkPlanSuffix = ".plan";
+
+struct link_plan_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t file_size;
+  uint32_t file_count;
+  uint32_t files_offset;
+  uint32_t library_count;
+  uint32_t libraries_offset;
+  uint32_t strings_offset;
+  uint32_t strings_size;
+};
+
+static void set_identity(link_plan_file* file, bool exists, const struct stat& st) {
+  file->exists = exists ? 1 : 0;
+  if (exists) {
+    file->dev = st.st_dev;
+    file->ino = st.st_ino;
+    file->size = st.st_size;
+    file->mtime_sec = st.st_mtim.tv_sec;
+    file->mtime_nsec = st.st_mtim.tv_nsec;
+  }
+}
+
+static bool is_same_file(const link_plan_file& file, bool exists, const struct stat& st) {
+  if (!exists || file.exists == 0) {
+    return !exists && file.exists == 0;
+  }
+
+  return file.dev == static_cast<uint64_t>(st.st_dev) &&
+         file.ino == static_cast<uint64_t>(st.st_ino) &&
+         file.size == static_cast<uint64_t>(st.st_size) &&
+         file.mtime_sec == static_cast<int64_t>(st.st_mtim.tv_sec) &&
+         file.mtime_nsec == static_cast<int64_t>(st.st_mtim.tv_nsec);
+}
+
+bool LinkPlan::read(const char* path, std::string* error_msg) {
+  reset();
+
+  int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+  if (fd == -1) {
+    if (errno != ENOENT) {
+      *error_msg = std::string("unable to open \"") + path + "\": " + strerror(errno);
+    }
+    return false;
+  }
+
+  struct stat plan_stat;
+  if (fstat(fd, &plan_stat) != 0 ||
+      static_cast<size_t>(plan_stat.st_size) < sizeof(link_plan_header)) {
+    close(fd);
+    *error_msg = std::string("\"") + path + "\" is not a valid link plan";
+    return false;
+  }
+
+  size_t size = plan_stat.st_size;
+  void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    *error_msg = std::string("unable to map \"") + path + "\": " + strerror(errno);
+    return false;
+  }
+
+  map_ = map;
+  map_size_ = size;
+
+  const char* base = static_cast<const char*>(map);
+  const link_plan_header* header = reinterpret_cast<const link_plan_header*>(base);
+
+  auto is_valid_array = [&](uint32_t offset, uint32_t count, size_t element_size) {
+    return offset % sizeof(uint64_t) == 0 &&
+           static_cast<uint64_t>(offset) + static_cast<uint64_t>(count) * element_size <= size;
+  };
+
+  if (header->magic != kLinkPlanMagic ||
+      header->version != kLinkPlanVersion ||
+      header->file_size != size ||
+      !is_valid_array(header->files_offset, header->file_count, sizeof(link_plan_file)) ||
+      !is_valid_array(header->libraries_offset, header->library_count,
+                      sizeof(link_plan_library)) ||
+      header->strings_size == 0 ||
+      static_cast<uint64_t>(header->strings_offset) + header->strings_size > size ||
+      base[header->strings_offset + header->strings_size - 1] != '\0') {
+    reset();
+    *error_msg = std::string("\"") + path + "\" is not a valid link plan";
+    return false;
+  }
+
+  const link_plan_file* files = reinterpret_cast<const link_plan_file*>(base + header->files_offset);
+  for (size_t i = 0; i < header->file_count; ++i) {
+    const char* file_path = get_string(files[i].path);
+    struct stat st;
+    if (file_path == nullptr || !is_same_file(files[i], stat(file_path, &st) == 0, st)) {
+      // A stale plan is not an error, the plan just has to be written again.
+      reset();
+      return false;
+    }
+  }
+
+  const link_plan_library* libraries =
+      reinterpret_cast<const link_plan_library*>(base + header->libraries_offset);
+  for (size_t i = 0; i < header->library_count; ++i) {
+    if (get_string(libraries[i].name) == nullptr || get_string(libraries[i].file.path) == nullptr) {
+      reset();
+      *error_msg = std::string("\"") + path + "\" is not a valid link plan";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const char* LinkPlan::get_string(uint32_t offset) const {
+  const char* base = static_cast<const char*>(map_);
+  const link_plan_header* header = reinterpret_cast<const link_plan_header*>(base);
+  return offset < header->strings_size ? base + header->strings_offset + offset : nullptr;
+}
+
+const link_plan_library* LinkPlan::find_library(const char* name) const {
+  const char* base = static_cast<const char*>(map_);
+  const link_plan_header* header = reinterpret_cast<const link_plan_header*>(base);
+  const link_plan_library* libraries =
+      reinterpret_cast<const link_plan_library*>(base + header->libraries_offset);
+
+  for (size_t i = 0; i < header->library_count; ++i) {
+    if (strcmp(get_string(libraries[i].name), name) == 0) {
+      return &libraries[i];
+    }
+  }
+
+  return nullptr;
+}
+
+int LinkPlan::open_library(const char* name, std::string* realpath) {
+  if (!is_loaded()) {
+    return -1;
+  }
+
+  const link_plan_library* library = find_library(name);
+  if (library == nullptr) {
+    return -1;
+  }
+
+  const char* path = get_string(library->file.path);
+  int fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+  struct stat st;
+  if (fd == -1 || fstat(fd, &st) != 0 || !is_same_file(library->file, true, st)) {
+    if (fd != -1) {
+      close(fd);
+    }
+    // The libraries that are left may have changed too; search for all of them.
+    reset();
+    return -1;
+  }
+
+  *realpath = path;
+  return fd;
+}
+
+void LinkPlan::reset() {
+  if (map_ != nullptr) {
+    munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+  }
+}
+
+std::string LinkPlan::get_path(const std::string& dir, const char* executable_path) {
+  // Like the dalvik-cache: /system/bin/sh -> <dir>/system@bin@sh.plan
+  std::string name = executable_path[0] == '/' ? executable_path + 1 : executable_path;
+  for (auto& c : name) {
+    if (c == '/') {
+      c = '@';
+    }
+  }
+
+  return dir + "/" + name + kLinkPlanSuffix;
+}
+
+void LinkPlanBuilder::add_file(const std::string& path) {
+  for (const auto& file : files_) {
+    if (file.path == path) {
+      return;
+    }
+  }
+
+  file_entry file;
+  file.path = path;
+  file.exists = stat(path.c_str(), &file.st) == 0;
+  files_.push_back(file);
+}
+
+void LinkPlanBuilder::add_library(const char* name,
+                                  const std::string& realpath,
+                                  const struct stat& file_stat) {
+  library_entry library;
+  library.name = name;
+  library.file.path = realpath;
+  library.file.st = file_stat;
+  library.file.exists = true;
+  libraries_.push_back(library);
+}
+
+bool LinkPlanBuilder::write(const char* path, std::string* error_msg) const {
+  std::string strings;
+  auto add_string = [&](const std::string& str) {
+    uint32_t offset = strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+    return offset;
+  };
+
+  std::vector<link_plan_file> files;
+  for (const auto& file : files_) {
+    link_plan_file entry = {};
+    entry.path = add_string(file.path);
+    set_identity(&entry, file.exists, file.st);
+    files.push_back(entry);
+  }
+
+  std::vector<link_plan_library> libraries;
+  for (const auto& library : libraries_) {
+    link_plan_library entry = {};
+    entry.name = add_string(library.name);
+    entry.file.path = add_string(library.file.path);
+    set_identity(&entry.file, true, library.file.st);
+    libraries.push_back(entry);
+  }
+
+  link_plan_header header = {};
+  header.magic = kLinkPlanMagic;
+  header.version = kLinkPlanVersion;
+  header.file_count = files.size();
+  header.files_offset = sizeof(header);
+  header.library_count = libraries.size();
+  header.libraries_offset = header.files_offset + files.size() * sizeof(link_plan_file);
+  header.strings_offset = header.libraries_offset + libraries.size() * sizeof(link_plan_library);
+  header.strings_size = strings.size();
+  header.file_size = header.strings_offset + header.strings_size;
+
+  std::string plan;
+  plan.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  plan.append(reinterpret_cast<const char*>(files.data()), files.size() * sizeof(link_plan_file));
+  plan.append(reinterpret_cast<const char*>(libraries.data()),
+              libraries.size() * sizeof(link_plan_library));
+  plan.append(strings);
+
+  // Write a temporary file and rename it so that the linker never sees a partial file.
+  std::string temp_path = std::string(path) + ".tmp";
+  if (!android::base::WriteStringToFile(plan, temp_path) ||
+      rename(temp_path.c_str(), path) != 0) {
+    *error_msg = std::string("error writing file \"") + path + "\": " + strerror(errno);
+    unlink(temp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
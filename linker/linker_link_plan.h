@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __LINKER_LINK_PLAN_H
+#define __LINKER_LINK_PLAN_H
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "private/bionic_macros.h"
+
+// A link plan records where the dependencies of an executable were found,
+// so that the next time the executable is started the linker can open them
+// directly instead of searching for each one on the library paths.
+//
+// Besides the libraries, a plan records the identity (dev, inode, size and
+// mtime) of every file the result of the search depends on: the executable,
+// ld.config.txt and the directories that were searched. The plan is only
+// used while all of these are unchanged, and a library is only taken from
+// the plan if it is still the same file it was when the plan was written.
+//
+// Layout: header, files[], libraries[] and a block of NUL-terminated
+// strings. All offsets are from the start of the file.
+struct link_plan_file {
+  uint32_t path;     // Offset into the string block.
+  uint32_t exists;   // 0 if the file did not exist, the rest is 0 then too.
+  uint64_t dev;
+  uint64_t ino;
+  uint64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+};
+
+struct link_plan_library {
+  uint32_t name;     // The DT_NEEDED name, offset into the string block.
+  uint32_t reserved;
+  link_plan_file file;
+};
+
+class LinkPlan {
+ public:
+  LinkPlan() : map_(nullptr), map_size_(0) {}
+  ~LinkPlan() { reset(); }
+
+  // Maps the plan at path. Returns false if there is no plan or it is stale;
+  // *error_msg is only set if the plan exists but could not be used.
+  bool read(const char* path, std::string* error_msg);
+
+  bool is_loaded() const { return map_ != nullptr; }
+
+  // Opens the library the plan resolved name to. Returns -1 if the plan has
+  // no such library or the library has changed since the plan was written,
+  // in which case the whole plan is dropped.
+  int open_library(const char* name, std::string* realpath);
+
+  void reset();
+
+  // Returns the path of the plan for executable_path in dir.
+  static std::string get_path(const std::string& dir, const char* executable_path);
+
+ private:
+  const link_plan_library* find_library(const char* name) const;
+  const char* get_string(uint32_t offset) const;
+
+  void* map_;
+  size_t map_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinkPlan);
+};
+
+class LinkPlanBuilder {
+ public:
+  LinkPlanBuilder() {}
+
+  // Records the current identity of path (which may not exist).
+  void add_file(const std::string& path);
+  void add_library(const char* name, const std::string& realpath, const struct stat& file_stat);
+
+  bool write(const char* path, std::string* error_msg) const;
+
+ private:
+  struct file_entry {
+    std::string path;
+    struct stat st;
+    bool exists;
+  };
+
+  struct library_entry {
+    std::string name;
+    file_entry file;
+  };
+
+  std::vector<file_entry> files_;
+  std::vector<library_entry> libraries_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinkPlanBuilder);
+};
+
+#endif  // __LINKER_LINK_PLAN_H
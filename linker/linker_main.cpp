@@ -33,9 +33,11 @@
 #include "linker_gdb_support.h"
 #include "linker_globals.h"
 #include "linker_phdr.h"
+#include "linker_tls.h"
 #include "linker_utils.h"
 
 #include "private/bionic_globals.h"
+#include "private/bionic_startup_trace.h"
 #include "private/bionic_tls.h"
 #include "private/KernelArgumentBlock.h"
 
@@ -152,6 +154,7 @@ static void add_vdso(KernelArgumentBlock& args __unused) {
 
   si->prelink_image();
   si->link_image(g_empty_list, soinfo_list_t::make_list(si), nullptr);
+  notify_gdb_of_load(si);
 #endif
 }
 
@@ -218,9 +221,11 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
 
   // Sanitize the environment.
   __libc_init_AT_SECURE(args);
+  __libc_startup_phase("linker_at_secure");
 
   // Initialize system properties
   __system_properties_init(); // may use 'environ'
+  __libc_startup_phase("linker_properties");
 
   // Register the debuggerd signal handler.
 #ifdef __ANDROID__
@@ -252,6 +257,7 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
   const char* ldpath_env = nullptr;
   const char* ldpreload_env = nullptr;
   const char* ldshim_libs_env = nullptr;
+  bool record_link_plan = false;
   if (!getauxval(AT_SECURE)) {
     ldpath_env = getenv("LD_LIBRARY_PATH");
     if (ldpath_env != nullptr) {
@@ -262,6 +268,9 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
       INFO("[ LD_PRELOAD set to \"%s\" ]", ldpreload_env);
     }
     ldshim_libs_env = getenv("LD_SHIM_LIBS");
+    record_link_plan = getenv("LD_WRITE_LINK_PLAN") != nullptr;
+    const char* ld_bind_now = getenv("LD_BIND_NOW");
+    g_ld_bind_now = ld_bind_now != nullptr && *ld_bind_now != '\0';
   }
 
   struct stat file_stat;
@@ -337,10 +346,20 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
 
   init_default_namespace(executable_path);
 
+  // LD_LIBRARY_PATH, LD_PRELOAD and LD_SHIM_LIBS change what the executable
+  // is linked against, so no link plan is used or written when they are set.
+  if (ldpath_env == nullptr && ldpreload_env == nullptr && ldshim_libs_env == nullptr) {
+    init_link_plan(executable_path, record_link_plan);
+  }
+
   if (!si->prelink_image()) {
     __libc_fatal("CANNOT LINK EXECUTABLE \"%s\": %s", g_argv[0], linker_get_error_buffer());
   }
 
+  // The executable's TLS segment has to be first in the static TLS block, and has to
+  // be registered before any library is loaded.
+  linker_setup_exe_static_tls(g_argv[0]);
+
   // add somain to global group
   si->set_dt_flags_1(si->get_dt_flags_1() | DF_1_GLOBAL);
 
@@ -377,9 +396,18 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
     if (!si->link_image(g_empty_list, soinfo_list_t::make_list(si), nullptr)) {
       __libc_fatal("CANNOT LINK EXECUTABLE \"%s\": %s", g_argv[0], linker_get_error_buffer());
     }
+    notify_gdb_of_load(si);
     si->increment_ref_count();
   }
 
+  // Everything loaded from here on has its TLS allocated on demand. Now that the size
+  // of the static TLS block is known, move the main thread onto its final one.
+  linker_finalize_static_tls();
+  __libc_init_main_thread_final();
+
+  finish_link_plan(executable_path);
+  __libc_startup_phase("linker_libraries");
+
   add_vdso(args);
 
   if (!get_cfi_shadow()->InitialLinkDone(solist)) {
@@ -395,6 +423,7 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
    */
   map->l_addr = si->load_bias;
   si->call_constructors();
+  __libc_startup_phase("constructors");
 
 #if TIMING
   gettimeofday(&t1, nullptr);
@@ -408,6 +437,12 @@ static ElfW(Addr) __linker_init_post_relocation(KernelArgumentBlock& args, ElfW(
          linker_stats.count[kRelocRelative],
          linker_stats.count[kRelocCopy],
          linker_stats.count[kRelocSymbol]);
+  print_linker_allocator_stats();
+  const linker_readahead_stats& readahead_stats = get_linker_readahead_stats();
+  PRINT("READAHEAD STATS: %s: %zu libraries, %zu regions, %zu pages (%zu not resident), "
+        "%zu major faults during relocation", g_argv[0],
+        readahead_stats.libraries, readahead_stats.regions, readahead_stats.pages,
+        readahead_stats.nonresident_pages, readahead_stats.major_faults);
 #endif
 #if COUNT_PAGES
   {
@@ -526,6 +561,8 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
 
   // Initialize the main thread (including TLS, so system calls really work).
   __libc_init_main_thread(args);
+  __libc_init_startup_trace(args);
+  args.linker_stats = &g_linker_stats;
 
   // We didn't protect the linker's RELRO pages in link_image because we
   // couldn't make system calls on x86 at that point, but we can now...
@@ -533,6 +570,7 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
 
   // Initialize the linker's static libc's globals
   __libc_init_globals(args);
+  __libc_startup_phase("linker_globals");
 
   // store argc/argv/envp to use them for calling constructors
   g_argc = args.argc;
@@ -541,6 +579,7 @@ extern "C" ElfW(Addr) __linker_init(void* raw_args) {
 
   // Initialize the linker's own global variables
   linker_so.call_constructors();
+  __libc_startup_phase("linker_constructors");
 
   // If the linker is not acting as PT_INTERP entry_point is equal to
   // _start. Which means that the linker is running as an executable and
@@ -45,6 +45,13 @@ class ProtectedDataGuard {
 };
 
 void init_default_namespace(const char* executable_path);
+
+// Uses (or, if record is true, writes) the link plan for the executable if
+// ld.config.txt sets link.plan.dir. Has to be called after
+// init_default_namespace(); finish_link_plan() writes the plan once the
+// executable has been linked and stops using it for later loads.
+void init_link_plan(const char* executable_path, bool record);
+void finish_link_plan(const char* executable_path);
 soinfo* soinfo_alloc(android_namespace_t* ns, const char* name,
                      struct stat* file_stat, off64_t file_offset,
                      uint32_t rtld_flags);
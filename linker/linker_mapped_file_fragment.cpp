@@ -36,7 +36,7 @@
 #include <unistd.h>
 
 MappedFileFragment::MappedFileFragment() : map_start_(nullptr), map_size_(0),
-                                           data_(nullptr), size_ (0)
+                                           data_(nullptr), size_ (0), elf_offset_(0)
 { }
 
 MappedFileFragment::~MappedFileFragment() {
@@ -70,6 +70,15 @@ bool MappedFileFragment::Map(int fd, off64_t base_offset, size_t elf_offset, siz
 
   data_ = map_start + page_offset(offset);
   size_ = size;
+  elf_offset_ = elf_offset;
 
   return true;
 }
+
+void* MappedFileFragment::data_at(size_t elf_offset, size_t size) const {
+  if (data_ == nullptr || elf_offset < elf_offset_ || elf_offset - elf_offset_ > size_ ||
+      size > size_ - (elf_offset - elf_offset_)) {
+    return nullptr;
+  }
+  return static_cast<uint8_t*>(data_) + (elf_offset - elf_offset_);
+}
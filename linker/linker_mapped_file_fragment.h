@@ -41,11 +41,16 @@ class MappedFileFragment {
 
   void* data() const { return data_; }
   size_t size() const { return size_; }
+
+  // Returns the address of [elf_offset, elf_offset + size) of the file if
+  // this fragment covers it, or nullptr.
+  void* data_at(size_t elf_offset, size_t size) const;
  private:
   void* map_start_;
   size_t map_size_;
   void* data_;
   size_t size_;
+  size_t elf_offset_;
 
   DISALLOW_COPY_AND_ASSIGN(MappedFileFragment);
 };
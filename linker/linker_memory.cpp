@@ -27,6 +27,8 @@
  */
 
 #include "linker_allocator.h"
+#include "linker_debug.h"
+#include "linker.h"
 
 #include <stdlib.h>
 #include <sys/cdefs.h>
@@ -83,3 +85,36 @@ void free(void* ptr) {
   get_allocator().free(ptr);
 }
 
+
+void print_linker_allocator_stats() {
+  linker_allocator_stats small_stats[kSmallObjectAllocatorsCount];
+  linker_allocator_stats large_stats;
+  g_linker_allocator.get_stats(small_stats, &large_stats);
+
+  for (const linker_allocator_stats& stats : small_stats) {
+    PRINT("ALLOCATOR STATS: %zu-byte blocks: %zu allocs (%zu cached), %zu frees, "
+          "%zu in use (peak %zu), %zu pages (peak %zu), %zu maps, %zu unmaps",
+          stats.block_size, stats.alloc_count, stats.cache_hit_count, stats.free_count,
+          stats.allocated_blocks, stats.peak_allocated_blocks, stats.pages, stats.peak_pages,
+          stats.page_map_count, stats.page_unmap_count);
+  }
+  PRINT("ALLOCATOR STATS: large objects: %zu allocs, %zu frees, "
+        "%zu in use (peak %zu), %zu pages (peak %zu)",
+        large_stats.alloc_count, large_stats.free_count,
+        large_stats.allocated_blocks, large_stats.peak_allocated_blocks,
+        large_stats.pages, large_stats.peak_pages);
+}
+
+void get_linker_heap_usage(size_t* small_bytes, size_t* small_used_bytes, size_t* large_bytes) {
+  linker_allocator_stats small_stats[kSmallObjectAllocatorsCount];
+  linker_allocator_stats large_stats;
+  g_linker_allocator.get_stats(small_stats, &large_stats);
+
+  *small_bytes = 0;
+  *small_used_bytes = 0;
+  for (const linker_allocator_stats& stats : small_stats) {
+    *small_bytes += stats.pages * PAGE_SIZE;
+    *small_used_bytes += stats.allocated_blocks * stats.block_size;
+  }
+  *large_bytes = large_stats.pages * PAGE_SIZE;
+}
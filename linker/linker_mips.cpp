@@ -42,19 +42,22 @@
 template bool soinfo::relocate<plain_reloc_iterator>(const VersionTracker& version_tracker,
                                                      plain_reloc_iterator&& rel_iterator,
                                                      const soinfo_list_t& global_group,
-                                                     const soinfo_list_t& local_group);
+                                                     const soinfo_list_t& local_group,
+                                                     SymbolLookupCache* lookup_cache);
 
 template bool soinfo::relocate<packed_reloc_iterator<sleb128_decoder>>(
     const VersionTracker& version_tracker,
     packed_reloc_iterator<sleb128_decoder>&& rel_iterator,
     const soinfo_list_t& global_group,
-    const soinfo_list_t& local_group);
+    const soinfo_list_t& local_group,
+    SymbolLookupCache* lookup_cache);
 
 template <typename ElfRelIteratorT>
 bool soinfo::relocate(const VersionTracker& version_tracker,
                       ElfRelIteratorT&& rel_iterator,
                       const soinfo_list_t& global_group,
-                      const soinfo_list_t& local_group) {
+                      const soinfo_list_t& local_group,
+                      SymbolLookupCache* lookup_cache) {
   for (size_t idx = 0; rel_iterator.has_next(); ++idx) {
     const auto rel = rel_iterator.next();
 
@@ -79,14 +82,19 @@ bool soinfo::relocate(const VersionTracker& version_tracker,
 
     if (sym != 0) {
       sym_name = get_string(symtab_[sym].st_name);
-      const version_info* vi = nullptr;
 
-      if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
-        return false;
-      }
+      if (!lookup_cache->find(sym, &lsi, &s)) {
+        const version_info* vi = nullptr;
 
-      if (!soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
-        return false;
+        if (!lookup_version_info(version_tracker, sym, sym_name, &vi)) {
+          return false;
+        }
+
+        if (!soinfo_do_lookup(this, sym_name, vi, &lsi, global_group, local_group, &s)) {
+          return false;
+        }
+
+        lookup_cache->insert(sym, lsi, s);
       }
 
       if (s == nullptr) {
@@ -63,7 +63,9 @@ struct android_namespace_link_t {
 
 struct android_namespace_t {
  public:
-  android_namespace_t() : name_(nullptr), is_isolated_(false), is_greylist_enabled_(false) {}
+  android_namespace_t() : name_(nullptr), is_isolated_(false), is_greylist_enabled_(false),
+                          is_readahead_enabled_(false), is_library_sharing_enabled_(false),
+                          is_lazy_binding_enabled_(false) {}
 
   const char* get_name() const { return name_; }
   void set_name(const char* name) { name_ = name; }
@@ -74,6 +76,34 @@ struct android_namespace_t {
   bool is_greylist_enabled() const { return is_greylist_enabled_; }
   void set_greylist_enabled(bool enabled) { is_greylist_enabled_ = enabled; }
 
+  // When enabled the linker asks the kernel to read in the parts of newly
+  // loaded libraries it is about to touch (see soinfo::readahead_link_regions).
+  bool is_readahead_enabled() const { return is_readahead_enabled_; }
+  void set_readahead_enabled(bool enabled) { is_readahead_enabled_ = enabled; }
+
+  // When enabled a library that another namespace with sharing enabled has
+  // already loaded from the same file is reused rather than loaded again, as
+  // long as this namespace could load that file itself.
+  bool is_library_sharing_enabled() const { return is_library_sharing_enabled_; }
+  void set_library_sharing_enabled(bool enabled) { is_library_sharing_enabled_ = enabled; }
+
+  // When enabled dlopen(RTLD_LAZY) binds the PLT entries of the libraries it
+  // loads into this namespace the first time each is called (see
+  // soinfo::setup_lazy_plt).
+  bool is_lazy_binding_enabled() const { return is_lazy_binding_enabled_; }
+  void set_lazy_binding_enabled(bool enabled) { is_lazy_binding_enabled_ = enabled; }
+
+  // Directory used to share relocated GNU_RELRO segments between processes
+  // that load a library at the same address. Empty when disabled.
+  const std::string& get_relro_cache_path() const { return relro_cache_path_; }
+  void set_relro_cache_path(const std::string& path) { relro_cache_path_ = path; }
+
+  // Directory in which libraries that are compressed in zip files (APKs) are
+  // kept once extracted, so that they can be mapped from the page cache by
+  // later processes. Empty when each process extracts them into memory.
+  const std::string& get_zip_cache_path() const { return zip_cache_path_; }
+  void set_zip_cache_path(const std::string& path) { zip_cache_path_ = path; }
+
   const std::vector<std::string>& get_ld_library_paths() const {
     return ld_library_paths_;
   }
@@ -140,6 +170,11 @@ struct android_namespace_t {
   const char* name_;
   bool is_isolated_;
   bool is_greylist_enabled_;
+  bool is_readahead_enabled_;
+  bool is_library_sharing_enabled_;
+  bool is_lazy_binding_enabled_;
+  std::string relro_cache_path_;
+  std::string zip_cache_path_;
   std::vector<std::string> ld_library_paths_;
   std::vector<std::string> default_library_paths_;
   std::vector<std::string> permitted_paths_;
@@ -29,12 +29,15 @@
 #include "linker_phdr.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "linker.h"
 #include "linker_dlwarning.h"
 #include "linker_globals.h"
@@ -140,10 +143,10 @@ static int GetTargetElfMachine() {
                                       MAYBE_MAP_FLAG((x), PF_W, PROT_WRITE))
 
 ElfReader::ElfReader()
-    : did_read_(false), did_load_(false), fd_(-1), file_offset_(0), file_size_(0), phdr_num_(0),
+    : did_read_(false), did_load_(false), did_readahead_(false), fd_(-1), file_offset_(0), file_size_(0), phdr_num_(0),
       phdr_table_(nullptr), shdr_table_(nullptr), shdr_num_(0), dynamic_(nullptr), strtab_(nullptr),
       strtab_size_(0), load_start_(nullptr), load_size_(0), load_bias_(0), loaded_phdr_(nullptr),
-      mapped_by_caller_(false) {
+      mapped_by_caller_(false), huge_page_text_(false) {
 }
 
 bool ElfReader::Read(const char* name, int fd, off64_t file_offset, off64_t file_size) {
@@ -168,15 +171,48 @@ bool ElfReader::Read(const char* name, int fd, off64_t file_offset, off64_t file
 bool ElfReader::Load(const android_dlextinfo* extinfo) {
   CHECK(did_read_);
   CHECK(!did_load_);
+  huge_page_text_ = extinfo != nullptr && (extinfo->flags & ANDROID_DLEXT_HUGEPAGE_TEXT) != 0;
   if (ReserveAddressSpace(extinfo) &&
       LoadSegments() &&
       FindPhdr()) {
+    if (huge_page_text_) {
+      RemapTextToHugePages();
+    }
     did_load_ = true;
   }
 
   return did_load_;
 }
 
+// Asks the kernel to start reading the file contents of all loadable
+// segments into the page cache. This does not wait for the I/O to complete,
+// so calling it for several libraries in a row keeps their reads in flight
+// at the same time.
+void ElfReader::ReadaheadSegments() {
+  CHECK(did_read_);
+  if (did_readahead_) {
+    return;
+  }
+  did_readahead_ = true;
+
+  for (size_t i = 0; i < phdr_num_; ++i) {
+    const ElfW(Phdr)* phdr = &phdr_table_[i];
+    if (phdr->p_type != PT_LOAD || phdr->p_filesz == 0) {
+      continue;
+    }
+
+    ElfW(Addr) file_page_start = PAGE_START(phdr->p_offset);
+    ElfW(Addr) file_length = phdr->p_offset + phdr->p_filesz - file_page_start;
+
+    // This is only a hint, so failure is not an error.
+    int error = posix_fadvise64(fd_, file_offset_ + file_page_start, file_length,
+                                POSIX_FADV_WILLNEED);
+    if (error != 0) {
+      DEBUG("\"%s\" readahead of segment %zd failed: %s", name_.c_str(), i, strerror(error));
+    }
+  }
+}
+
 const char* ElfReader::get_string(ElfW(Word) index) const {
   CHECK(strtab_ != nullptr);
   CHECK(index < strtab_size_);
@@ -290,8 +326,54 @@ bool ElfReader::CheckFileRange(ElfW(Addr) offset, size_t size, size_t alignment)
          ((offset % alignment) == 0);
 }
 
+// The program and section header tables, .dynamic and its string table are
+// usually spread over a few pages at the start and the end of the file, and
+// mapping each of them separately costs four mmap/munmap pairs and VMAs per
+// library. When the two header tables are no further apart than this, a
+// single read-only mapping spanning them is made instead; since nothing is
+// read until it's touched, the pages in between cost only address space.
+#if defined(__LP64__)
+static constexpr size_t kMaxHeaderWindowSize = 64 * 1024 * 1024;
+#else
+static constexpr size_t kMaxHeaderWindowSize = 4 * 1024 * 1024;
+#endif
+
+void ElfReader::MapHeaderWindow() {
+  off64_t phdr_end;
+  off64_t shdr_end;
+  if (!safe_add(&phdr_end, header_.e_phoff, header_.e_phnum * sizeof(ElfW(Phdr))) ||
+      !safe_add(&shdr_end, header_.e_shoff, header_.e_shnum * sizeof(ElfW(Shdr)))) {
+    return;
+  }
+
+  off64_t start = std::min<off64_t>(header_.e_phoff, header_.e_shoff);
+  off64_t end = std::max(phdr_end, shdr_end);
+  // The checks for each table report any problem with it; here we just
+  // don't try.
+  if (end > file_size_ || static_cast<uint64_t>(end - start) > kMaxHeaderWindowSize) {
+    return;
+  }
+
+  if (!header_fragment_.Map(fd_, file_offset_, start, end - start)) {
+    DEBUG("\"%s\" header window mmap failed: %s", name_.c_str(), strerror(errno));
+  }
+}
+
+// Returns the address of [offset, offset + size) of the file: in the header
+// window if that covers it, or otherwise in a new mapping held by 'fragment'.
+const void* ElfReader::MapFileRange(MappedFileFragment* fragment, size_t offset, size_t size) {
+  const void* data = header_fragment_.data_at(offset, size);
+  if (data != nullptr) {
+    return data;
+  }
+  if (!fragment->Map(fd_, file_offset_, offset, size)) {
+    return nullptr;
+  }
+  return fragment->data();
+}
+
 // Loads the program header table from an ELF file into a read-only private
-// anonymous mmap-ed block.
+// mmap-ed block.
 bool ElfReader::ReadProgramHeaders() {
   phdr_num_ = header_.e_phnum;
 
@@ -312,12 +394,15 @@ bool ElfReader::ReadProgramHeaders() {
     return false;
   }
 
-  if (!phdr_fragment_.Map(fd_, file_offset_, header_.e_phoff, size)) {
+  MapHeaderWindow();
+
+  const void* data = MapFileRange(&phdr_fragment_, header_.e_phoff, size);
+  if (data == nullptr) {
     DL_ERR("\"%s\" phdr mmap failed: %s", name_.c_str(), strerror(errno));
     return false;
   }
 
-  phdr_table_ = static_cast<ElfW(Phdr)*>(phdr_fragment_.data());
+  phdr_table_ = static_cast<const ElfW(Phdr)*>(data);
   return true;
 }
 
@@ -338,12 +423,13 @@ bool ElfReader::ReadSectionHeaders() {
     return false;
   }
 
-  if (!shdr_fragment_.Map(fd_, file_offset_, header_.e_shoff, size)) {
+  const void* data = MapFileRange(&shdr_fragment_, header_.e_shoff, size);
+  if (data == nullptr) {
     DL_ERR("\"%s\" shdr mmap failed: %s", name_.c_str(), strerror(errno));
     return false;
   }
 
-  shdr_table_ = static_cast<const ElfW(Shdr)*>(shdr_fragment_.data());
+  shdr_table_ = static_cast<const ElfW(Shdr)*>(data);
   return true;
 }
 
@@ -427,12 +513,14 @@ bool ElfReader::ReadDynamicSection() {
     return false;
   }
 
-  if (!dynamic_fragment_.Map(fd_, file_offset_, dynamic_shdr->sh_offset, dynamic_shdr->sh_size)) {
+  const void* dynamic_data = MapFileRange(&dynamic_fragment_, dynamic_shdr->sh_offset,
+                                          dynamic_shdr->sh_size);
+  if (dynamic_data == nullptr) {
     DL_ERR("\"%s\" dynamic section mmap failed: %s", name_.c_str(), strerror(errno));
     return false;
   }
 
-  dynamic_ = static_cast<const ElfW(Dyn)*>(dynamic_fragment_.data());
+  dynamic_ = static_cast<const ElfW(Dyn)*>(dynamic_data);
 
   if (!CheckFileRange(strtab_shdr->sh_offset, strtab_shdr->sh_size, alignof(const char))) {
     DL_ERR_AND_LOG("\"%s\" has invalid offset/size of the .strtab section linked from .dynamic section",
@@ -440,13 +528,15 @@ bool ElfReader::ReadDynamicSection() {
     return false;
   }
 
-  if (!strtab_fragment_.Map(fd_, file_offset_, strtab_shdr->sh_offset, strtab_shdr->sh_size)) {
+  const void* strtab_data = MapFileRange(&strtab_fragment_, strtab_shdr->sh_offset,
+                                         strtab_shdr->sh_size);
+  if (strtab_data == nullptr) {
     DL_ERR("\"%s\" strtab section mmap failed: %s", name_.c_str(), strerror(errno));
     return false;
   }
 
-  strtab_ = static_cast<const char*>(strtab_fragment_.data());
-  strtab_size_ = strtab_fragment_.size();
+  strtab_ = static_cast<const char*>(strtab_data);
+  strtab_size_ = strtab_shdr->sh_size;
   return true;
 }
 
@@ -533,6 +623,34 @@ static void* ReserveAligned(void* hint, size_t size, size_t align) {
   return start;
 }
 
+static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Returns the first executable PT_LOAD segment, or nullptr.
+static const ElfW(Phdr)* find_text_segment(const ElfW(Phdr)* phdr_table, size_t phdr_count) {
+  for (size_t i = 0; i < phdr_count; ++i) {
+    if (phdr_table[i].p_type == PT_LOAD && (phdr_table[i].p_flags & PF_X) != 0) {
+      return &phdr_table[i];
+    }
+  }
+  return nullptr;
+}
+
+// Like ReserveAligned(), but places the range so that start + offset is aligned to kHugePageSize.
+// The range still keeps kLibraryAlignment worth of distance from any other mapping at both ends.
+static void* ReserveHugePageAligned(size_t size, size_t offset) {
+  size_t mmap_size = align_up(size, kLibraryAlignment) + kHugePageSize + 2 * kLibraryAlignment;
+  uint8_t* mmap_ptr = reinterpret_cast<uint8_t*>(
+      mmap(nullptr, mmap_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (mmap_ptr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  uint8_t* start = align_up(mmap_ptr + kLibraryAlignment + offset, kHugePageSize) - offset;
+  munmap(mmap_ptr, start - mmap_ptr);
+  munmap(start + size, mmap_ptr + mmap_size - (start + size));
+  return start;
+}
+
 // Reserve a virtual address range big enough to hold all loadable
 // segments of a program header table. This is done by creating a
 // private anonymous mmap() with PROT_NONE.
@@ -574,7 +692,12 @@ bool ElfReader::ReserveAddressSpace(const android_dlextinfo* extinfo) {
              reserved_size - load_size_, load_size_, name_.c_str());
       return false;
     }
-    start = ReserveAligned(mmap_hint, load_size_, kLibraryAlignment);
+    const ElfW(Phdr)* text = find_text_segment(phdr_table_, phdr_num_);
+    if (huge_page_text_ && mmap_hint == nullptr && text != nullptr) {
+      start = ReserveHugePageAligned(load_size_, PAGE_START(text->p_vaddr) - min_vaddr);
+    } else {
+      start = ReserveAligned(mmap_hint, load_size_, kLibraryAlignment);
+    }
     if (start == nullptr) {
       DL_ERR("couldn't reserve %zd bytes of address space for \"%s\"", load_size_, name_.c_str());
       return false;
@@ -595,6 +718,77 @@ bool ElfReader::ReserveAddressSpace(const android_dlextinfo* extinfo) {
   return true;
 }
 
+static bool is_transparent_huge_page_enabled() {
+  static int enabled = -1;
+  if (enabled == -1) {
+    // The file reads e.g. "always [madvise] never"; only "[never]" rules madvise out.
+    char buf[64] = {};
+    int fd = TEMP_FAILURE_RETRY(open("/sys/kernel/mm/transparent_hugepage/enabled",
+                                     O_RDONLY | O_CLOEXEC));
+    enabled = 0;
+    if (fd != -1) {
+      if (TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf) - 1)) > 0) {
+        enabled = strstr(buf, "[never]") == nullptr;
+      }
+      close(fd);
+    }
+  }
+  return enabled == 1;
+}
+
+// Replaces the 2MB-aligned part of the text segment with an anonymous copy backed by
+// transparent huge pages. Every failure leaves the file mapping in place.
+void ElfReader::RemapTextToHugePages() {
+  const ElfW(Phdr)* text = find_text_segment(phdr_table_, phdr_num_);
+  if (text == nullptr || !is_transparent_huge_page_enabled()) {
+    return;
+  }
+
+  // Only the part of the segment backed by the file; the zero-filled tail is anonymous already.
+  ElfW(Addr) seg_start = text->p_vaddr + load_bias_;
+  ElfW(Addr) seg_file_end = seg_start + text->p_filesz;
+  uint8_t* start = align_up(reinterpret_cast<uint8_t*>(seg_start), kHugePageSize);
+  uint8_t* end = align_down(reinterpret_cast<uint8_t*>(seg_file_end), kHugePageSize);
+  if (start >= end) {
+    DEBUG("\"%s\" text segment has no 2MB-aligned part", name_.c_str());
+    return;
+  }
+  size_t size = end - start;
+
+  // The copy has to be 2MB-aligned already for its first touch to allocate huge pages, and
+  // mremap moves those without splitting them because the destination is aligned too.
+  size_t mmap_size = size + kHugePageSize;
+  uint8_t* mmap_ptr = reinterpret_cast<uint8_t*>(
+      mmap(nullptr, mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (mmap_ptr == MAP_FAILED) {
+    DEBUG("\"%s\" huge page text: mmap failed: %s", name_.c_str(), strerror(errno));
+    return;
+  }
+  uint8_t* copy = align_up(mmap_ptr, kHugePageSize);
+  if (copy != mmap_ptr) {
+    munmap(mmap_ptr, copy - mmap_ptr);
+  }
+  if (copy + size != mmap_ptr + mmap_size) {
+    munmap(copy + size, mmap_ptr + mmap_size - (copy + size));
+  }
+
+  if (madvise(copy, size, MADV_HUGEPAGE) == -1) {
+    DEBUG("\"%s\" huge page text: madvise failed: %s", name_.c_str(), strerror(errno));
+    munmap(copy, size);
+    return;
+  }
+  memcpy(copy, start, size);
+  if (mprotect(copy, size, PFLAGS_TO_PROT(text->p_flags)) == -1 ||
+      mremap(copy, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, start) == MAP_FAILED) {
+    DEBUG("\"%s\" huge page text: remap failed: %s", name_.c_str(), strerror(errno));
+    munmap(copy, size);
+    return;
+  }
+
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, start, size, "huge page text");
+  DEBUG("\"%s\" text [%p, %p) remapped to huge pages", name_.c_str(), start, end);
+}
+
 bool ElfReader::LoadSegments() {
   for (size_t i = 0; i < phdr_num_; ++i) {
     const ElfW(Phdr)* phdr = &phdr_table_[i];
@@ -821,6 +1015,115 @@ int phdr_table_protect_gnu_relro(const ElfW(Phdr)* phdr_table,
   return _phdr_table_set_gnu_relro_prot(phdr_table, phdr_count, load_bias, PROT_READ);
 }
 
+/* Count the pages in [start, end) that are not resident, using a bounded
+ * buffer for the mincore() vector.
+ */
+static size_t count_nonresident_pages(ElfW(Addr) start, ElfW(Addr) end) {
+  unsigned char vec[256];
+  size_t count = 0;
+
+  while (start < end) {
+    size_t pages = std::min((end - start) / PAGE_SIZE, sizeof(vec));
+    if (mincore(reinterpret_cast<void*>(start), pages * PAGE_SIZE, vec) != 0) {
+      break;
+    }
+    for (size_t i = 0; i < pages; ++i) {
+      if ((vec[i] & 1) == 0) {
+        ++count;
+      }
+    }
+    start += pages * PAGE_SIZE;
+  }
+
+  return count;
+}
+
+/* Count the pages of the loadable segments of a library and how many of them
+ * are resident, with the writable segments (where the relocations, .data and
+ * .bss are) also counted on their own.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ *   load_bias   -> load bias
+ * Output:
+ *   usage       -> the page counts
+ */
+void phdr_table_get_segment_usage(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                                  ElfW(Addr) load_bias, linker_segment_usage* usage) {
+  const ElfW(Phdr)* phdr = phdr_table;
+  const ElfW(Phdr)* phdr_limit = phdr + phdr_count;
+
+  *usage = {};
+  for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
+    if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0) {
+      continue;
+    }
+
+    ElfW(Addr) seg_page_start = PAGE_START(phdr->p_vaddr + load_bias);
+    ElfW(Addr) seg_page_end = PAGE_END(phdr->p_vaddr + phdr->p_memsz + load_bias);
+    size_t pages = (seg_page_end - seg_page_start) / PAGE_SIZE;
+    size_t resident_pages = pages - count_nonresident_pages(seg_page_start, seg_page_end);
+
+    usage->pages += pages;
+    usage->resident_pages += resident_pages;
+    if ((phdr->p_flags & PF_W) != 0) {
+      usage->writable_pages += pages;
+      usage->writable_resident_pages += resident_pages;
+    }
+  }
+}
+
+/* Advise the kernel that the pages spanning a range of mapped memory are
+ * going to be accessed soon, so it can read them in with a few large I/O
+ * requests instead of one page fault at a time.
+ *
+ * Input:
+ *   start       -> start of the range
+ *   size        -> size of the range in bytes
+ *   stats       -> counters to update
+ */
+void readahead_range(ElfW(Addr) start, size_t size, linker_readahead_stats* stats) {
+  if (size == 0) {
+    return;
+  }
+
+  ElfW(Addr) page_start = PAGE_START(start);
+  ElfW(Addr) page_end = PAGE_END(start + size);
+
+  stats->regions++;
+  stats->pages += (page_end - page_start) / PAGE_SIZE;
+  stats->nonresident_pages += count_nonresident_pages(page_start, page_end);
+
+  // This is only a hint, so failure is not an error.
+  madvise(reinterpret_cast<void*>(page_start), page_end - page_start, MADV_WILLNEED);
+}
+
+/* Advise the kernel that the dynamic section and the GNU relro segments of
+ * a freshly loaded library are going to be accessed soon. The dynamic
+ * section is read by prelink_image() and the relro segments are where most
+ * relocations are applied.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ *   load_bias   -> load bias
+ *   stats       -> counters to update
+ */
+void phdr_table_readahead_dynamic_and_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                                            ElfW(Addr) load_bias, linker_readahead_stats* stats) {
+  const ElfW(Phdr)* phdr = phdr_table;
+  const ElfW(Phdr)* phdr_limit = phdr + phdr_count;
+
+  for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
+    if (phdr->p_type != PT_DYNAMIC && phdr->p_type != PT_GNU_RELRO) {
+      continue;
+    }
+
+    readahead_range(phdr->p_vaddr + load_bias, phdr->p_memsz, stats);
+  }
+}
+
 /* Serialize the GNU relro segments to the given file descriptor. This can be
  * performed after relocations to allow another process to later share the
  * relocated segment, if it was loaded at the same address.
@@ -44,6 +44,7 @@ class ElfReader {
 
   bool Read(const char* name, int fd, off64_t file_offset, off64_t file_size);
   bool Load(const android_dlextinfo* extinfo);
+  void ReadaheadSegments();
 
   const char* name() const { return name_.c_str(); }
   size_t phdr_count() const { return phdr_num_; }
@@ -58,17 +59,21 @@ class ElfReader {
  private:
   bool ReadElfHeader();
   bool VerifyElfHeader();
+  void MapHeaderWindow();
+  const void* MapFileRange(MappedFileFragment* fragment, size_t offset, size_t size);
   bool ReadProgramHeaders();
   bool ReadSectionHeaders();
   bool ReadDynamicSection();
   bool ReserveAddressSpace(const android_dlextinfo* extinfo);
   bool LoadSegments();
+  void RemapTextToHugePages();
   bool FindPhdr();
   bool CheckPhdr(ElfW(Addr));
   bool CheckFileRange(ElfW(Addr) offset, size_t size, size_t alignment);
 
   bool did_read_;
   bool did_load_;
+  bool did_readahead_;
   std::string name_;
   int fd_;
   off64_t file_offset_;
@@ -77,6 +82,11 @@ class ElfReader {
   ElfW(Ehdr) header_;
   size_t phdr_num_;
 
+  // One mapping covering the program and section header tables and, usually,
+  // .dynamic and its string table. Empty if they're too far apart, in which
+  // case each gets its own fragment below.
+  MappedFileFragment header_fragment_;
+
   MappedFileFragment phdr_fragment_;
   const ElfW(Phdr)* phdr_table_;
 
@@ -103,8 +113,43 @@ class ElfReader {
 
   // Is map owned by the caller
   bool mapped_by_caller_;
+
+  // Was ANDROID_DLEXT_HUGEPAGE_TEXT requested
+  bool huge_page_text_;
 };
 
+// Counters for the readahead hints given for freshly loaded libraries.
+struct linker_readahead_stats {
+  // Number of libraries readahead was done for.
+  size_t libraries;
+  // Number of distinct ranges passed to madvise(MADV_WILLNEED).
+  size_t regions;
+  // Number of pages in those ranges.
+  size_t pages;
+  // Number of those pages that were not resident when advised. Each of
+  // them would otherwise have been a separate page fault.
+  size_t nonresident_pages;
+  // Major faults taken while relocating the libraries readahead was done for.
+  size_t major_faults;
+};
+
+void readahead_range(ElfW(Addr) start, size_t size, linker_readahead_stats* stats);
+
+// Page counts of the loadable segments of a library.
+struct linker_segment_usage {
+  size_t pages;
+  size_t resident_pages;
+  // The part of the above in writable segments, which relocation makes private and dirty.
+  size_t writable_pages;
+  size_t writable_resident_pages;
+};
+
+void phdr_table_get_segment_usage(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                                  ElfW(Addr) load_bias, linker_segment_usage* usage);
+
+void phdr_table_readahead_dynamic_and_relro(const ElfW(Phdr)* phdr_table, size_t phdr_count,
+                                            ElfW(Addr) load_bias, linker_readahead_stats* stats);
+
 size_t phdr_table_get_load_size(const ElfW(Phdr)* phdr_table, size_t phdr_count,
                                 ElfW(Addr)* min_vaddr = nullptr, ElfW(Addr)* max_vaddr = nullptr);
 
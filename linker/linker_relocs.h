@@ -39,6 +39,10 @@
 #define R_GENERIC_GLOB_DAT  R_AARCH64_GLOB_DAT
 #define R_GENERIC_RELATIVE  R_AARCH64_RELATIVE
 #define R_GENERIC_IRELATIVE R_AARCH64_IRELATIVE
+#define R_GENERIC_TLS_DTPMOD R_AARCH64_TLS_DTPMOD64
+#define R_GENERIC_TLS_DTPREL R_AARCH64_TLS_DTPREL64
+#define R_GENERIC_TLS_TPREL  R_AARCH64_TLS_TPREL64
+#define R_GENERIC_TLSDESC    R_AARCH64_TLSDESC
 
 #elif defined (__arm__)
 
@@ -46,6 +50,9 @@
 #define R_GENERIC_GLOB_DAT  R_ARM_GLOB_DAT
 #define R_GENERIC_RELATIVE  R_ARM_RELATIVE
 #define R_GENERIC_IRELATIVE R_ARM_IRELATIVE
+#define R_GENERIC_TLS_DTPMOD R_ARM_TLS_DTPMOD32
+#define R_GENERIC_TLS_DTPREL R_ARM_TLS_DTPOFF32
+#define R_GENERIC_TLS_TPREL  R_ARM_TLS_TPOFF32
 
 #elif defined (__i386__)
 
@@ -53,6 +60,9 @@
 #define R_GENERIC_GLOB_DAT  R_386_GLOB_DAT
 #define R_GENERIC_RELATIVE  R_386_RELATIVE
 #define R_GENERIC_IRELATIVE R_386_IRELATIVE
+#define R_GENERIC_TLS_DTPMOD R_386_TLS_DTPMOD32
+#define R_GENERIC_TLS_DTPREL R_386_TLS_DTPOFF32
+#define R_GENERIC_TLS_TPREL  R_386_TLS_TPOFF
 
 #elif defined (__x86_64__)
 
@@ -60,6 +70,9 @@
 #define R_GENERIC_GLOB_DAT  R_X86_64_GLOB_DAT
 #define R_GENERIC_RELATIVE  R_X86_64_RELATIVE
 #define R_GENERIC_IRELATIVE R_X86_64_IRELATIVE
+#define R_GENERIC_TLS_DTPMOD R_X86_64_DTPMOD64
+#define R_GENERIC_TLS_DTPREL R_X86_64_DTPOFF64
+#define R_GENERIC_TLS_TPREL  R_X86_64_TPOFF64
 
 #endif
 
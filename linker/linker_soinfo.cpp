@@ -34,6 +34,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 #include "linker_debug.h"
 #include "linker_globals.h"
 #include "linker_logger.h"
@@ -44,6 +48,17 @@ bool find_verdef_version_index(const soinfo* si, const version_info* vi, ElfW(Ve
 ElfW(Addr) call_ifunc_resolver(ElfW(Addr) resolver_addr);
 uint32_t get_application_target_sdk_version();
 
+// The defined symbols of a library sorted by address, built the first time dladdr looks up an
+// address in the library. max_end[i] is the highest end address of symbols[0..i], which bounds how
+// far back a lookup has to go when symbols overlap. Kept outside soinfo so that building it does
+// not need soinfo memory to be writable.
+struct soinfo_address_index {
+  std::vector<uint32_t> symbols;
+  std::vector<ElfW(Addr)> max_end;
+};
+
+static std::unordered_map<const soinfo*, soinfo_address_index> g_soinfo_address_indexes;
+
 soinfo::soinfo(android_namespace_t* ns, const char* realpath,
                const struct stat* file_stat, off64_t file_offset,
                int rtld_flags) {
@@ -68,6 +83,8 @@ soinfo::soinfo(android_namespace_t* ns, const char* realpath,
 
 soinfo::~soinfo() {
   g_soinfo_handles_map.erase(handle_);
+  g_soinfo_address_indexes.erase(this);
+  free(elf_bloom_filter_);
 }
 
 void soinfo::set_dt_runpath(const char* path) {
@@ -129,6 +146,10 @@ size_t soinfo::get_verdef_cnt() const {
   return 0;
 }
 
+const std::vector<verdef_index_entry>& soinfo::get_verdef_index() const {
+  return verdef_index_;
+}
+
 bool soinfo::find_symbol_by_name(SymbolName& symbol_name,
                                  const version_info* vi,
                                  const ElfW(Sym)** symbol) const {
@@ -240,9 +261,79 @@ bool soinfo::gnu_lookup(SymbolName& symbol_name,
   return true;
 }
 
+// Libraries with fewer symbols than this get no bloom filter: their hash
+// chains are short, and the filter would mostly cost memory.
+static constexpr size_t kElfBloomMinSymbols = 32;
+// With two bits set per symbol this keeps false positives at about 5%.
+static constexpr size_t kElfBloomBitsPerSymbol = 8;
+static constexpr uint32_t kElfBloomShift2 = 26;
+
+static inline bool elf_bloom_filter_may_contain(const ElfW(Addr)* bloom_filter,
+                                                uint32_t maskwords,
+                                                uint32_t hash) {
+  uint32_t bloom_mask_bits = sizeof(ElfW(Addr))*8;
+  ElfW(Addr) bloom_word = bloom_filter[(hash / bloom_mask_bits) & maskwords];
+  return (1 & (bloom_word >> (hash % bloom_mask_bits)) &
+              (bloom_word >> ((hash >> kElfBloomShift2) % bloom_mask_bits))) != 0;
+}
+
+// Libraries that only have a SysV hash table (DT_HASH) have no bloom filter,
+// so every lookup for a symbol they do not define walks a hash chain and
+// compares names, touching the symbol and string tables. Build a bloom filter
+// like the one in DT_GNU_HASH from the GNU hashes of the defined symbols, so
+// that most of those lookups are rejected without touching either table.
+void soinfo::build_elf_bloom_filter() {
+  if (is_gnu_hash() || nchain_ < kElfBloomMinSymbols) {
+    return;
+  }
+
+  uint32_t bloom_mask_bits = sizeof(ElfW(Addr))*8;
+  size_t words = 1;
+  while (words * bloom_mask_bits < nchain_ * kElfBloomBitsPerSymbol) {
+    words *= 2;
+  }
+
+  ElfW(Addr)* bloom_filter = static_cast<ElfW(Addr)*>(calloc(words, sizeof(ElfW(Addr))));
+  if (bloom_filter == nullptr) {
+    return;
+  }
+
+  size_t symbol_count = 0;
+  for (size_t n = 1; n < nchain_; ++n) {
+    const ElfW(Sym)* s = symtab_ + n;
+    uint32_t bind = ELF_ST_BIND(s->st_info);
+    if ((bind != STB_GLOBAL && bind != STB_WEAK) || s->st_shndx == SHN_UNDEF) {
+      continue;
+    }
+
+    SymbolName symbol_name(get_string(s->st_name));
+    uint32_t hash = symbol_name.gnu_hash();
+    ElfW(Addr)* bloom_word = &bloom_filter[(hash / bloom_mask_bits) & (words - 1)];
+    *bloom_word |= static_cast<ElfW(Addr)>(1) << (hash % bloom_mask_bits);
+    *bloom_word |= static_cast<ElfW(Addr)>(1) << ((hash >> kElfBloomShift2) % bloom_mask_bits);
+    ++symbol_count;
+  }
+
+  TRACE("[ \"%s\": built a %zu byte bloom filter for %zu symbols ]",
+        get_realpath(), words * sizeof(ElfW(Addr)), symbol_count);
+
+  elf_bloom_filter_ = bloom_filter;
+  elf_bloom_maskwords_ = words - 1;
+}
+
 bool soinfo::elf_lookup(SymbolName& symbol_name,
                         const version_info* vi,
                         uint32_t* symbol_index) const {
+  *symbol_index = 0;
+
+  if (elf_bloom_filter_ != nullptr &&
+      !elf_bloom_filter_may_contain(elf_bloom_filter_, elf_bloom_maskwords_,
+                                    symbol_name.gnu_hash())) {
+    TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@%p (elf bloom filter)",
+               symbol_name.get_name(), get_realpath(), reinterpret_cast<void*>(base));
+    return true;
+  }
+
   uint32_t hash = symbol_name.elf_hash();
 
   TRACE_TYPE(LOOKUP, "SEARCH %s in %s@%p h=%x(elf) %zd",
@@ -283,44 +374,66 @@ bool soinfo::elf_lookup(SymbolName& symbol_name,
   return true;
 }
 
-ElfW(Sym)* soinfo::find_symbol_by_address(const void* addr) {
-  return is_gnu_hash() ? gnu_addr_lookup(addr) : elf_addr_lookup(addr);
-}
-
 static bool symbol_matches_soaddr(const ElfW(Sym)* sym, ElfW(Addr) soaddr) {
   return sym->st_shndx != SHN_UNDEF &&
       soaddr >= sym->st_value &&
       soaddr < sym->st_value + sym->st_size;
 }
 
-ElfW(Sym)* soinfo::gnu_addr_lookup(const void* addr) {
-  ElfW(Addr) soaddr = reinterpret_cast<ElfW(Addr)>(addr) - load_bias;
-
-  for (size_t i = 0; i < gnu_nbucket_; ++i) {
-    uint32_t n = gnu_bucket_[i];
-
-    if (n == 0) {
-      continue;
+void soinfo::collect_defined_symbols(std::vector<uint32_t>* symbol_indexes) const {
+  auto add = [&](uint32_t n) {
+    const ElfW(Sym)* sym = symtab_ + n;
+    // Symbols of size 0 never match an address.
+    if (sym->st_shndx != SHN_UNDEF && sym->st_size != 0) {
+      symbol_indexes->push_back(n);
     }
+  };
 
-    do {
-      ElfW(Sym)* sym = symtab_ + n;
-      if (symbol_matches_soaddr(sym, soaddr)) {
-        return sym;
+  if (is_gnu_hash()) {
+    for (size_t i = 0; i < gnu_nbucket_; ++i) {
+      uint32_t n = gnu_bucket_[i];
+
+      if (n == 0) {
+        continue;
       }
-    } while ((gnu_chain_[n++] & 1) == 0);
-  }
 
-  return nullptr;
+      do {
+        add(n);
+      } while ((gnu_chain_[n++] & 1) == 0);
+    }
+  } else {
+    for (size_t i = 0; i < nchain_; ++i) {
+      add(i);
+    }
+  }
 }
 
-ElfW(Sym)* soinfo::elf_addr_lookup(const void* addr) {
+ElfW(Sym)* soinfo::find_symbol_by_address(const void* addr) {
+  auto it = g_soinfo_address_indexes.find(this);
+  if (it == g_soinfo_address_indexes.end()) {
+    soinfo_address_index index;
+    collect_defined_symbols(&index.symbols);
+    std::stable_sort(index.symbols.begin(), index.symbols.end(), [this](uint32_t a, uint32_t b) {
+      return symtab_[a].st_value < symtab_[b].st_value;
+    });
+    index.max_end.reserve(index.symbols.size());
+    ElfW(Addr) max_end = 0;
+    for (uint32_t n : index.symbols) {
+      max_end = std::max(max_end, symtab_[n].st_value + symtab_[n].st_size);
+      index.max_end.push_back(max_end);
+    }
+    it = g_soinfo_address_indexes.emplace(this, std::move(index)).first;
+  }
+
+  const soinfo_address_index& index = it->second;
   ElfW(Addr) soaddr = reinterpret_cast<ElfW(Addr)>(addr) - load_bias;
 
-  // Search the library's symbol table for any defined symbol which
-  // contains this address.
-  for (size_t i = 0; i < nchain_; ++i) {
-    ElfW(Sym)* sym = symtab_ + i;
+  // Start at the last symbol starting at or below soaddr and go back while an earlier symbol
+  // could still reach soaddr.
+  auto pos = std::upper_bound(index.symbols.begin(), index.symbols.end(), soaddr,
+                              [this](ElfW(Addr) a, uint32_t n) { return a < symtab_[n].st_value; });
+  for (size_t i = pos - index.symbols.begin(); i > 0 && index.max_end[i - 1] > soaddr; --i) {
+    ElfW(Sym)* sym = symtab_ + index.symbols[i - 1];
     if (symbol_matches_soaddr(sym, soaddr)) {
       return sym;
     }
@@ -413,10 +526,16 @@ void soinfo::call_constructors() {
     bionic_trace_begin((std::string("calling constructors: ") + get_realpath()).c_str());
   }
 
+  // Children were handled above, so this only accounts for our own constructors
+  // (and anything they dlopen).
+  uint64_t start_ns = get_monotonic_time_ns();
+
   // DT_INIT should be called before DT_INIT_ARRAY if both are present.
   call_function("DT_INIT", init_func_, get_realpath());
   call_array("DT_INIT_ARRAY", init_array_, init_array_count_, false, get_realpath());
 
+  get_load_times()->constructors_ns = get_monotonic_time_ns() - start_ns;
+
   if (!is_linker()) {
     bionic_trace_end();
   }
@@ -427,6 +546,11 @@ void soinfo::call_destructors() {
     return;
   }
 
+  // Most dependencies have nothing to run; don't build a trace section for them.
+  if ((fini_array_ == nullptr || fini_array_count_ == 0) && fini_func_ == nullptr) {
+    return;
+  }
+
   ScopedTrace trace((std::string("calling destructors: ") + get_realpath()).c_str());
 
   // DT_FINI_ARRAY must be parsed in reverse order.
@@ -436,10 +560,17 @@ void soinfo::call_destructors() {
   call_function("DT_FINI", fini_func_, get_realpath());
 }
 
+static uint64_t g_soinfo_links_generation = 0;
+
+uint64_t get_soinfo_links_generation() {
+  return g_soinfo_links_generation;
+}
+
 void soinfo::add_child(soinfo* child) {
   if (has_min_version(0)) {
     child->parents_.push_back(this);
     this->children_.push_back(child);
+    ++g_soinfo_links_generation;
   }
 }
 
@@ -448,6 +579,8 @@ void soinfo::remove_all_links() {
     return;
   }
 
+  ++g_soinfo_links_generation;
+
   // 1. Untie connected soinfos from 'this'.
   children_.for_each([&] (soinfo* child) {
     child->parents_.remove_if([&] (const soinfo* parent) {
@@ -619,6 +752,7 @@ android_namespace_t* soinfo::get_primary_namespace() {
 void soinfo::add_secondary_namespace(android_namespace_t* secondary_ns) {
   CHECK(has_min_version(3));
   secondary_namespaces_.push_back(secondary_ns);
+  ++g_soinfo_links_generation;
 }
 
 android_namespace_list_t& soinfo::get_secondary_namespaces() {
@@ -626,6 +760,15 @@ android_namespace_list_t& soinfo::get_secondary_namespaces() {
   return secondary_namespaces_;
 }
 
+soinfo_load_times* soinfo::get_load_times() {
+  CHECK(has_min_version(3));
+  return &load_times_;
+}
+
+soinfo_tls* soinfo::get_tls() const {
+  return has_min_version(3) ? tls_.get() : nullptr;
+}
+
 ElfW(Addr) soinfo::resolve_symbol_address(const ElfW(Sym)* s) const {
   if (ELF_ST_TYPE(s->st_info) == STT_GNU_IFUNC) {
     return call_ifunc_resolver(s->st_value + load_bias);
@@ -699,6 +842,16 @@ bool soinfo::is_mapped_by_caller() const {
   return (flags_ & FLAG_MAPPED_BY_CALLER) != 0;
 }
 
+void soinfo::set_constructors_deferred() {
+  flags_ |= FLAG_DEFERRED_CONSTRUCTORS;
+}
+
+// True until the deferred constructors have been run, whether by dlsym() or
+// because a later dlopen() needed this library.
+bool soinfo::has_deferred_constructors() const {
+  return (flags_ & FLAG_DEFERRED_CONSTRUCTORS) != 0 && !constructors_called;
+}
+
 // This function returns api-level at the time of
 // dlopen/load. Note that libraries opened by system
 // will always have 'current' api level.
@@ -31,8 +31,12 @@
 
 #include <link.h>
 
+#include <deque>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "private/bionic_elf_tls.h"
 #include "linker_namespaces.h"
 
 #define FLAG_LINKED           0x00000001
@@ -40,6 +44,7 @@
 #define FLAG_LINKER           0x00000010 // The linker itself
 #define FLAG_GNU_HASH         0x00000040 // uses gnu hash
 #define FLAG_MAPPED_BY_CALLER 0x00000080 // the map is reserved by the caller
+#define FLAG_DEFERRED_CONSTRUCTORS 0x00000100 // constructors wait for the first dlsym
                                          // and should not be unmapped
 #define FLAG_NEW_SOINFO       0x40000000 // new soinfo format
 
@@ -52,7 +57,12 @@ class SymbolName {
  public:
   explicit SymbolName(const char* name)
       : name_(name), has_elf_hash_(false), has_gnu_hash_(false),
-        elf_hash_(0), gnu_hash_(0) { }
+        gnu_hash_supplied_(false), elf_hash_(0), gnu_hash_(0) { }
+
+  // For callers that have computed the GNU hash of the name ahead of time.
+  SymbolName(const char* name, uint32_t gnu_hash)
+      : name_(name), has_elf_hash_(false), has_gnu_hash_(true),
+        gnu_hash_supplied_(true), elf_hash_(0), gnu_hash_(gnu_hash) { }
 
   const char* get_name() {
     return name_;
@@ -61,10 +71,15 @@ class SymbolName {
   uint32_t elf_hash();
   uint32_t gnu_hash();
 
+  bool has_supplied_gnu_hash() const {
+    return gnu_hash_supplied_;
+  }
+
  private:
   const char* name_;
   bool has_elf_hash_;
   bool has_gnu_hash_;
+  bool gnu_hash_supplied_;
   uint32_t elf_hash_;
   uint32_t gnu_hash_;
 
@@ -79,9 +94,36 @@ struct version_info {
   const soinfo* target_si;
 };
 
+// A version defined by a library (other than the VER_FLG_BASE one), as
+// versioned symbol lookups need it. See soinfo::build_verdef_index.
+struct verdef_index_entry {
+  ElfW(Word) hash;
+  ElfW(Versym) index;
+  const char* name;
+};
+
 // TODO(dimitry): remove reference from soinfo member functions to this class.
+class SymbolLookupCache;
 class VersionTracker;
 
+struct linker_readahead_stats;
+
+// Time spent in each stage of loading a library, in nanoseconds.
+struct soinfo_load_times {
+  uint64_t open_ns;
+  uint64_t map_ns;
+  uint64_t prelink_ns;
+  uint64_t relocate_ns;
+  uint64_t constructors_ns;
+};
+
+// A library's PT_TLS segment, and the module ID it was registered with (see
+// linker_tls.h).
+struct soinfo_tls {
+  TlsSegment segment;
+  size_t module_id = kTlsUninitializedModuleId;
+};
+
 #if defined(__work_around_b_24465209__)
 #define SOINFO_NAME_LEN 128
 #endif
@@ -198,6 +240,17 @@ struct soinfo {
   bool link_image(const soinfo_list_t& global_group, const soinfo_list_t& local_group,
                   const android_dlextinfo* extinfo);
   bool protect_relro();
+  void readahead_link_regions(linker_readahead_stats* stats);
+
+  // Asks link_image() to leave the PLT to be bound as it's called, looking
+  // symbols up in 'ns', if the library and architecture allow it.
+  void set_lazy_bind_namespace(android_namespace_t* ns) { lazy_bind_namespace_ = ns; }
+  bool is_lazily_bound() const { return lazy_bind_namespace_ != nullptr; }
+  // Binds the PLT entry identified by what the PLT passed to the resolver
+  // trampoline, and returns the function's address. Fatal on failure.
+  ElfW(Addr) bind_lazy_plt_entry(ElfW(Addr) plt_arg);
+
+  void build_elf_bloom_filter();
 
   void add_child(soinfo* child);
   void remove_all_links();
@@ -256,6 +309,7 @@ struct soinfo {
   size_t get_verneed_cnt() const;
   ElfW(Addr) get_verdef_ptr() const;
   size_t get_verdef_cnt() const;
+  const std::vector<verdef_index_entry>& get_verdef_index() const;
 
   uint32_t get_target_sdk_version() const;
 
@@ -268,22 +322,35 @@ struct soinfo {
   void set_mapped_by_caller(bool reserved_map);
   bool is_mapped_by_caller() const;
 
+  void set_constructors_deferred();
+  bool has_deferred_constructors() const;
+
   uintptr_t get_handle() const;
   void generate_handle();
   void* to_handle();
 
+  soinfo_load_times* get_load_times();
+
+  // Null if the library has no PT_TLS segment.
+  soinfo_tls* get_tls() const;
+
  private:
   bool elf_lookup(SymbolName& symbol_name, const version_info* vi, uint32_t* symbol_index) const;
-  ElfW(Sym)* elf_addr_lookup(const void* addr);
   bool gnu_lookup(SymbolName& symbol_name, const version_info* vi, uint32_t* symbol_index) const;
-  ElfW(Sym)* gnu_addr_lookup(const void* addr);
+  void collect_defined_symbols(std::vector<uint32_t>* symbol_indexes) const;
+  bool build_verdef_index();
 
   bool lookup_version_info(const VersionTracker& version_tracker, ElfW(Word) sym,
                            const char* sym_name, const version_info** vi);
 
   template<typename ElfRelIteratorT>
   bool relocate(const VersionTracker& version_tracker, ElfRelIteratorT&& rel_iterator,
-                const soinfo_list_t& global_group, const soinfo_list_t& local_group);
+                const soinfo_list_t& global_group, const soinfo_list_t& local_group,
+                SymbolLookupCache* lookup_cache);
+  bool can_bind_plt_lazily() const;
+  bool setup_lazy_plt(const VersionTracker& version_tracker,
+                      const soinfo_list_t& global_group, const soinfo_list_t& local_group,
+                      SymbolLookupCache* lookup_cache);
 
  private:
   // This part of the structure is only available
@@ -337,12 +404,52 @@ struct soinfo {
   android_namespace_list_t secondary_namespaces_;
   uintptr_t handle_;
 
+  soinfo_load_times load_times_;
+
+  // GNU-style bloom filter built by build_elf_bloom_filter() for libraries
+  // that only have DT_HASH; nullptr if there is none.
+  ElfW(Addr)* elf_bloom_filter_;
+  uint32_t elf_bloom_maskwords_;
+
+  // DT_RELACOUNT/DT_RELCOUNT: the number of R_*_RELATIVE relocations at the
+  // start of DT_RELA/DT_REL.
+  size_t relative_reloc_count_;
+
+  // DT_RELR: compact relative relocations.
+  ElfW(Relr)* relr_;
+  size_t relr_count_;
+
+  std::unique_ptr<soinfo_tls> tls_;
+
+  // DT_VERDEF, flattened once by prelink_image so that versioned lookups don't walk it.
+  std::vector<verdef_index_entry> verdef_index_;
+
+#if defined(__aarch64__)
+  // Arguments of this library's TLSDESC relocations that refer to modules outside
+  // static TLS; a deque, so that their addresses stay put.
+  std::deque<TlsDynamicResolverArg> tlsdesc_args_;
+#endif
+
+  // DT_PLTGOT. When the PLT is bound lazily, pltgot_[1] is this soinfo and
+  // pltgot_[2] the resolver trampoline, which the PLT's first entry calls.
+  ElfW(Addr)* pltgot_;
+  // DT_BIND_NOW, DF_BIND_NOW or DF_1_NOW: the library asks not to be bound lazily.
+  bool bind_now_;
+  // The namespace whose groups lazily bound PLT entries are looked up in, or
+  // nullptr if the whole PLT was bound by link_image().
+  android_namespace_t* lazy_bind_namespace_;
+
   friend soinfo* get_libdl_info(const char* linker_path);
 };
 
 // This function is used by dlvsym() to calculate hash of sym_ver
 uint32_t calculate_elf_hash(const char* name);
 
+// Changes whenever a library gains or loses a parent, a child or a secondary
+// namespace, that is whenever the result of a lookup that walks the
+// dependency tree (see dlsym_handle_lookup() in linker.cpp) could change.
+uint64_t get_soinfo_links_generation();
+
 const char* fix_dt_needed(const char* dt_needed, const char* sopath);
 
 template<typename F>
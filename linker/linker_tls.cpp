@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "linker_tls.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <new>
+
+#include "private/bionic_elf_tls.h"
+#include "private/bionic_globals.h"
+#include "private/libc_logging.h"
+#include "linker_globals.h"
+#include "linker_main.h"
+#include "linker_soinfo.h"
+
+// The arm64 TLSDESC resolver reads the DTV directly.
+static_assert(offsetof(TlsDtv, generation) == 0, "TlsDtv layout changed");
+static_assert(offsetof(TlsDtv, count) == sizeof(size_t), "TlsDtv layout changed");
+static_assert(offsetof(TlsDtv, modules) == 3 * sizeof(size_t), "TlsDtv layout changed");
+static_assert(offsetof(TlsDynamicResolverArg, index) == sizeof(size_t),
+              "TlsDynamicResolverArg layout changed");
+
+// Adds a module to the table, reusing a free entry if there is one. Returns its ID.
+static size_t tls_allocate_module_id(TlsModules& modules, const TlsModule& module) {
+  size_t i = 0;
+  while (i < modules.module_count && modules.module_table[i].first_generation != 0) ++i;
+  if (i == modules.module_count) {
+    size_t new_count = modules.module_count == 0 ? 4 : modules.module_count * 2;
+    TlsModule* new_table = static_cast<TlsModule*>(
+        realloc(modules.module_table, new_count * sizeof(TlsModule)));
+    if (new_table == nullptr) return kTlsUninitializedModuleId;
+    for (size_t j = modules.module_count; j < new_count; ++j) {
+      new (&new_table[j]) TlsModule();
+    }
+    modules.module_table = new_table;
+    modules.module_count = new_count;
+  }
+
+  // Bump the generation before the entry becomes visible, so a thread with an up to
+  // date DTV can't be handed this ID without noticing its DTV is stale.
+  size_t generation = atomic_fetch_add(&modules.generation, 1) + 1;
+  modules.module_table[i] = module;
+  modules.module_table[i].first_generation = generation;
+  return i + 1;
+}
+
+static void register_tls_module(soinfo* si, size_t static_offset) {
+  soinfo_tls* si_tls = si->get_tls();
+  TlsModules& modules = __libc_tls_globals.tls_modules;
+
+  TlsModule module;
+  module.segment = si_tls->segment;
+  module.static_offset = static_offset;
+  module.soinfo_ptr = si;
+
+  pthread_rwlock_wrlock(&modules.rwlock);
+  si_tls->module_id = tls_allocate_module_id(modules, module);
+  pthread_rwlock_unlock(&modules.rwlock);
+}
+
+void linker_setup_exe_static_tls(const char* progname) {
+  soinfo* somain = solist_get_somain();
+  StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+  if (somain->get_tls() == nullptr) {
+    layout.reserve_exe_segment_and_tcb(nullptr, progname);
+  } else {
+    register_tls_module(somain, layout.reserve_exe_segment_and_tcb(&somain->get_tls()->segment,
+                                                                    progname));
+    if (somain->get_tls()->module_id == kTlsUninitializedModuleId) {
+      __libc_fatal("\"%s\": out of memory registering its TLS segment", progname);
+    }
+  }
+}
+
+void linker_finalize_static_tls() {
+  __libc_tls_globals.static_tls_layout.finish_layout();
+}
+
+bool register_soinfo_tls(soinfo* si) {
+  soinfo_tls* si_tls = si->get_tls();
+  if (si_tls == nullptr || si_tls->module_id != kTlsUninitializedModuleId) {
+    return true;
+  }
+#if defined(__mips__)
+  DL_ERR("\"%s\" has a PT_TLS segment, but ELF TLS isn't supported on MIPS", si->get_realpath());
+  return false;
+#else
+  StaticTlsLayout& layout = __libc_tls_globals.static_tls_layout;
+  size_t static_offset = kTlsNoStaticOffset;
+  if (!layout.is_finished()) {
+    static_offset = layout.reserve_solib_segment(si_tls->segment);
+  }
+  register_tls_module(si, static_offset);
+  if (si_tls->module_id == kTlsUninitializedModuleId) {
+    DL_ERR("out of memory registering the TLS segment of \"%s\"", si->get_realpath());
+    return false;
+  }
+  return true;
+#endif
+}
+
+void unregister_soinfo_tls(soinfo* si) {
+  soinfo_tls* si_tls = si->get_tls();
+  if (si_tls == nullptr || si_tls->module_id == kTlsUninitializedModuleId) {
+    return;
+  }
+
+  // Each thread frees its copy of the module's block when it next brings its DTV up
+  // to date, or when it exits.
+  TlsModules& modules = __libc_tls_globals.tls_modules;
+  pthread_rwlock_wrlock(&modules.rwlock);
+  modules.module_table[si_tls->module_id - 1] = TlsModule();
+  atomic_fetch_add(&modules.generation, 1);
+  pthread_rwlock_unlock(&modules.rwlock);
+  si_tls->module_id = kTlsUninitializedModuleId;
+}
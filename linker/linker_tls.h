@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __LINKER_TLS_H
+#define __LINKER_TLS_H
+
+#include <stddef.h>
+
+struct soinfo;
+
+// Lays out the static TLS block, starting with bionic's slots and the executable's
+// segment, and registers the executable's module.
+void linker_setup_exe_static_tls(const char* progname);
+
+// Registers a library's PT_TLS segment, if it has one, giving it a module ID. Until
+// linker_finalize_static_tls is called, segments are also given space in the static
+// TLS block, so the libraries loaded at startup can use the initial-exec model.
+bool register_soinfo_tls(soinfo* si);
+void unregister_soinfo_tls(soinfo* si);
+
+// Called once the libraries needed at startup have been loaded.
+void linker_finalize_static_tls();
+
+#if defined(__aarch64__)
+// TLSDESC resolvers (see arch/arm64/tlsdesc_resolver.S). They take a pointer to the
+// descriptor's argument word and return the variable's offset from the thread pointer.
+extern "C" size_t tlsdesc_resolver_static(size_t);
+extern "C" size_t tlsdesc_resolver_dynamic(size_t);
+#endif
+
+#endif  /* __LINKER_TLS_H */
@@ -34,6 +34,7 @@
 #include "android-base/strings.h"
 
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 void format_string(std::string* str, const std::vector<std::pair<std::string, std::string>>& params) {
@@ -243,3 +244,8 @@ void resolve_paths(std::vector<std::string>& paths,
   }
 }
 
+uint64_t get_monotonic_time_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
@@ -57,4 +57,6 @@ off64_t page_start(off64_t offset);
 size_t page_offset(off64_t offset);
 bool safe_add(off64_t* out, off64_t a, size_t b);
 
+uint64_t get_monotonic_time_ns();
+
 #endif
@@ -41,7 +41,9 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../libc/
 LOCAL_SRC_FILES := \
   linker_block_allocator_test.cpp \
   linker_config_test.cpp \
+  linker_dir_cache_test.cpp \
   linker_globals.cpp \
+  linker_link_plan_test.cpp \
   linked_list_test.cpp \
   linker_memory_allocator_test.cpp \
   linker_sleb128_test.cpp \
@@ -49,6 +51,8 @@ LOCAL_SRC_FILES := \
   ../linker_allocator.cpp \
   ../linker_block_allocator.cpp \
   ../linker_config.cpp \
+  ../linker_dir_cache.cpp \
+  ../linker_link_plan.cpp \
   ../linker_utils.cpp \
 
 # for __libc_fatal
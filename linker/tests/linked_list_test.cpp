@@ -91,8 +91,9 @@ TEST(linked_list, simple) {
     return *c == 'c';
   });
 
+  // The other elements share the entry, so it isn't freed.
   ASSERT_TRUE(!alloc_called);
-  ASSERT_TRUE(free_called);
+  ASSERT_TRUE(!free_called);
 
   ASSERT_EQ("dba", test_list_to_string(list));
   alloc_called = free_called = false;
@@ -243,3 +244,52 @@ TEST(linked_list, test_visit) {
   ASSERT_EQ("ab", ss.str());
 }
 
+// Enough elements to need several entries.
+TEST(linked_list, many_elements) {
+  static const char* const kDigits[] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+  const size_t count = 10 * test_list_t::entry_t::kCapacity + 3;
+
+  test_list_t list;
+  std::string expected;
+  for (size_t i = 0; i < count; ++i) {
+    list.push_back(kDigits[i % 10]);
+    expected += kDigits[i % 10];
+  }
+  ASSERT_EQ(expected, test_list_to_string(list));
+
+  std::string iterated;
+  for (const char* c : list) {
+    iterated += c;
+  }
+  ASSERT_EQ(expected, iterated);
+
+  // Elements pushed in front of a full entry go into a new one.
+  list.push_front("a");
+  list.push_front("b");
+  expected = "ba" + expected;
+  ASSERT_EQ(expected, test_list_to_string(list));
+
+  // Emptying whole entries frees them.
+  free_called = false;
+  list.remove_if([](const char* c) {
+    return *c != '7';
+  });
+  ASSERT_TRUE(free_called);
+  expected.clear();
+  for (size_t i = 7; i < count; i += 10) {
+    expected += "7";
+  }
+  ASSERT_EQ(expected, test_list_to_string(list));
+
+  ASSERT_TRUE(list.find(kDigits[7]) == list.begin());
+  ASSERT_TRUE(list.find(kDigits[8]) == list.end());
+
+  list.push_back("x");
+  while (list.front() != nullptr && *list.front() == '7') {
+    ASSERT_STREQ("7", list.pop_front());
+  }
+  ASSERT_EQ("x", test_list_to_string(list));
+  ASSERT_STREQ("x", list.pop_front());
+  ASSERT_TRUE(list.empty());
+  ASSERT_TRUE(list.begin() == list.end());
+}
@@ -146,3 +146,62 @@ TEST(linker_allocator, test_protect) {
   ASSERT_EXIT(protect_all(), testing::KilledBySignal(SIGSEGV), "trying to access protected page");
 }
 
+static void protect_all_pages() {
+  LinkerTypeAllocator<test_struct_larger> allocator;
+
+  // Enough allocations to span several pages; protect_all changes runs of neighbouring pages at
+  // once, and every page has to end up protected.
+  size_t n = 8 * (kPageSize/sizeof(test_struct_larger));
+  test_struct_larger* first_ptr = allocator.alloc();
+  test_struct_larger* last_ptr = first_ptr;
+  for (size_t i=0; i<n; ++i) {
+    last_ptr = allocator.alloc();
+  }
+
+  allocator.protect_all(PROT_READ);
+  allocator.protect_all(PROT_READ | PROT_WRITE);
+  first_ptr->dummy_str[13] = 11;
+  last_ptr->dummy_str[13] = 11;
+
+  allocator.protect_all(PROT_READ);
+  fprintf(stderr, "trying to access protected page");
+
+  // this should result in segmentation fault
+  last_ptr->dummy_str[11] = 7;
+}
+
+TEST(linker_allocator, test_protect_all_pages) {
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  ASSERT_EXIT(protect_all_pages(), testing::KilledBySignal(SIGSEGV),
+              "trying to access protected page");
+}
+
+static void protect_protectable() {
+  LinkerTypeAllocator<test_struct_larger> allocator1(true);
+  LinkerTypeAllocator<test_struct_larger> allocator2(true);
+
+  size_t n = 4 * (kPageSize/sizeof(test_struct_larger));
+  test_struct_larger* ptr1 = nullptr;
+  test_struct_larger* ptr2 = nullptr;
+  for (size_t i=0; i<n; ++i) {
+    ptr1 = allocator1.alloc();
+    ptr2 = allocator2.alloc();
+  }
+
+  LinkerBlockAllocator::protect_protectable(PROT_READ);
+  LinkerBlockAllocator::protect_protectable(PROT_READ | PROT_WRITE);
+  ptr1->dummy_str[13] = 11;
+  ptr2->dummy_str[13] = 11;
+
+  LinkerBlockAllocator::protect_protectable(PROT_READ);
+  fprintf(stderr, "trying to access protected page");
+
+  // this should result in segmentation fault
+  ptr2->dummy_str[11] = 7;
+}
+
+TEST(linker_allocator, test_protect_protectable) {
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  ASSERT_EXIT(protect_protectable(), testing::KilledBySignal(SIGSEGV),
+              "trying to access protected page");
+}
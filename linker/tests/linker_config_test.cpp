@@ -60,6 +60,11 @@ static const char* config_str =
   "namespace.default.link.system.shared_libs = libc.so:libm.so:libdl.so:libstdc++.so\n"
   "namespace.system.isolated = true\n"
   "namespace.system.visible = true\n"
+  "namespace.system.readahead = true\n"
+  "namespace.system.share_libraries = true\n"
+  "namespace.system.lazy_binding = true\n"
+  "namespace.system.relro.cache.path = /data/misc/shared_relro\n"
+  "namespace.system.zip.cache.path = /data/misc/zip_libraries\n"
   "namespace.system.search.paths = /system/${LIB}\n"
   "namespace.system.permitted.paths = /system/${LIB}\n"
   "namespace.system.asan.search.paths = /data:/system/${LIB}\n"
@@ -71,7 +76,7 @@ static bool write_version(const std::string& path, uint32_t version) {
   return android::base::WriteStringToFile(content, path);
 }
 
-static void run_linker_config_smoke_test(bool is_asan) {
+static void run_linker_config_smoke_test(bool is_asan, bool use_compiled_config) {
 #if defined(__LP64__)
   const std::vector<std::string> kExpectedDefaultSearchPath = is_asan ?
         std::vector<std::string>({ "/data", "/vendor/lib64"}) :
@@ -112,6 +117,18 @@ static void run_linker_config_smoke_test(bool is_asan) {
 
   android::base::WriteStringToFile(config_str, tmp_file.path);
 
+  std::string compiled_config_path = Config::get_compiled_config_path(tmp_file.path);
+  auto compiled_config_guard = make_scope_guard([&compiled_config_path] {
+    unlink(compiled_config_path.c_str());
+  });
+
+  if (use_compiled_config) {
+    std::string error_msg;
+    ASSERT_TRUE(Config::write_compiled_config(tmp_file.path,
+                                              compiled_config_path.c_str(),
+                                              &error_msg)) << error_msg;
+  }
+
   TemporaryDir tmp_dir;
 
   std::string executable_path = std::string(tmp_dir.path) + "/some-binary";
@@ -141,6 +158,11 @@ static void run_linker_config_smoke_test(bool is_asan) {
 
   ASSERT_TRUE(default_ns_config->isolated());
   ASSERT_FALSE(default_ns_config->visible());
+  ASSERT_FALSE(default_ns_config->readahead());
+  ASSERT_FALSE(default_ns_config->share_libraries());
+  ASSERT_FALSE(default_ns_config->lazy_binding());
+  ASSERT_EQ("", default_ns_config->relro_cache_path());
+  ASSERT_EQ("", default_ns_config->zip_cache_path());
   ASSERT_EQ(kExpectedDefaultSearchPath, default_ns_config->search_paths());
   ASSERT_EQ(kExpectedDefaultPermittedPath, default_ns_config->permitted_paths());
 
@@ -168,15 +190,89 @@ static void run_linker_config_smoke_test(bool is_asan) {
 
   ASSERT_TRUE(ns_system->isolated());
   ASSERT_TRUE(ns_system->visible());
+  ASSERT_TRUE(ns_system->readahead());
+  ASSERT_TRUE(ns_system->share_libraries());
+  ASSERT_TRUE(ns_system->lazy_binding());
+  ASSERT_EQ("/data/misc/shared_relro", ns_system->relro_cache_path());
+  ASSERT_EQ("/data/misc/zip_libraries", ns_system->zip_cache_path());
   ASSERT_EQ(kExpectedSystemSearchPath, ns_system->search_paths());
   ASSERT_EQ(kExpectedSystemPermittedPath, ns_system->permitted_paths());
 }
 
 TEST(linker_config, smoke) {
-  run_linker_config_smoke_test(false);
+  run_linker_config_smoke_test(false, false);
+}
+
+TEST(linker_config, compiled_smoke) {
+  run_linker_config_smoke_test(false, true);
+}
+
+TEST(linker_config, compiled_config_is_ignored_when_stale) {
+  TemporaryFile tmp_file;
+  close(tmp_file.fd);
+  tmp_file.fd = -1;
+
+  android::base::WriteStringToFile(config_str, tmp_file.path);
+
+  std::string compiled_config_path = Config::get_compiled_config_path(tmp_file.path);
+  auto compiled_config_guard = make_scope_guard([&compiled_config_path] {
+    unlink(compiled_config_path.c_str());
+  });
+
+  std::string error_msg;
+  ASSERT_TRUE(Config::write_compiled_config(tmp_file.path,
+                                            compiled_config_path.c_str(),
+                                            &error_msg)) << error_msg;
+
+  // Change the text after compiling it; the change must be picked up.
+  android::base::WriteStringToFile(std::string(config_str) +
+                                   "namespace.default.visible = true\n", tmp_file.path);
+
+  TemporaryDir tmp_dir;
+  std::string executable_path = std::string(tmp_dir.path) + "/some-binary";
+
+  const Config* config = nullptr;
+  ASSERT_TRUE(Config::read_binary_config(tmp_file.path,
+                                         executable_path.c_str(),
+                                         false,
+                                         &config,
+                                         &error_msg)) << error_msg;
+  ASSERT_TRUE(config != nullptr);
+  ASSERT_TRUE(config->default_namespace_config()->visible());
+}
+
+TEST(linker_config, compiled_config_missing_section) {
+  TemporaryFile tmp_file;
+  close(tmp_file.fd);
+  tmp_file.fd = -1;
+
+  android::base::WriteStringToFile("dir.test = /data/local/tmp\n"
+                                   "[other]\n"
+                                   "namespace.default.isolated = true\n", tmp_file.path);
+
+  std::string compiled_config_path = Config::get_compiled_config_path(tmp_file.path);
+  auto compiled_config_guard = make_scope_guard([&compiled_config_path] {
+    unlink(compiled_config_path.c_str());
+  });
+
+  std::string error_msg;
+  ASSERT_TRUE(Config::write_compiled_config(tmp_file.path,
+                                            compiled_config_path.c_str(),
+                                            &error_msg)) << error_msg;
+
+  TemporaryDir tmp_dir;
+  std::string executable_path = std::string(tmp_dir.path) + "/some-binary";
+
+  const Config* config = nullptr;
+  ASSERT_FALSE(Config::read_binary_config(tmp_file.path,
+                                          executable_path.c_str(),
+                                          false,
+                                          &config,
+                                          &error_msg));
+  ASSERT_EQ(std::string(tmp_file.path) + ":4: error: section \"test\" not found", error_msg);
 }
 
 // TODO(b/38114603) revive this test when ld.config.txt is enabled for ASAN mode
 //TEST(linker_config, asan_smoke) {
-//  run_linker_config_smoke_test(true);
+//  run_linker_config_smoke_test(true, false);
 //}
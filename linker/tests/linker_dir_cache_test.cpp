@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../linker_dir_cache.h"
+
+#include <android-base/test_utils.h>
+
+static void create_file(const std::string& path) {
+  int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+  ASSERT_NE(-1, fd) << strerror(errno);
+  close(fd);
+}
+
+// The cache does not trust listings of directories that were modified in the
+// last few seconds, so move the mtime into the past after every change.
+static void set_mtime_in_past(const std::string& dir, time_t seconds_ago) {
+  timespec times[2];
+  clock_gettime(CLOCK_REALTIME, &times[0]);
+  times[0].tv_sec -= seconds_ago;
+  times[1] = times[0];
+  ASSERT_EQ(0, utimensat(AT_FDCWD, dir.c_str(), times, 0)) << strerror(errno);
+}
+
+static void record_misses(DirectoryCache* cache, const std::string& dir, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    cache->record_miss(dir);
+  }
+}
+
+TEST(linker_dir_cache, not_listed_before_threshold) {
+  TemporaryDir tmp_dir;
+  std::string dir = tmp_dir.path;
+  set_mtime_in_past(dir, 100);
+
+  DirectoryCache cache;
+  record_misses(&cache, dir, DirectoryCache::kListingThreshold - 1);
+  ASSERT_EQ(0U, cache.listed_dir_count());
+  ASSERT_TRUE(cache.may_contain(dir, "libfoo.so"));
+}
+
+TEST(linker_dir_cache, smoke) {
+  TemporaryDir tmp_dir;
+  std::string dir = tmp_dir.path;
+  create_file(dir + "/libfoo.so");
+  set_mtime_in_past(dir, 100);
+
+  DirectoryCache cache;
+  record_misses(&cache, dir, DirectoryCache::kListingThreshold);
+  ASSERT_EQ(1U, cache.listed_dir_count());
+  ASSERT_TRUE(cache.may_contain(dir, "libfoo.so"));
+  ASSERT_FALSE(cache.may_contain(dir, "libbar.so"));
+
+  unlink((dir + "/libfoo.so").c_str());
+}
+
+TEST(linker_dir_cache, invalidated_when_directory_changes) {
+  TemporaryDir tmp_dir;
+  std::string dir = tmp_dir.path;
+  set_mtime_in_past(dir, 100);
+
+  DirectoryCache cache;
+  record_misses(&cache, dir, DirectoryCache::kListingThreshold);
+  ASSERT_FALSE(cache.may_contain(dir, "libbar.so"));
+
+  create_file(dir + "/libbar.so");
+  set_mtime_in_past(dir, 50);
+
+  // The directory is only checked again in the next epoch.
+  ASSERT_FALSE(cache.may_contain(dir, "libbar.so"));
+  cache.new_epoch();
+  ASSERT_TRUE(cache.may_contain(dir, "libbar.so"));
+  ASSERT_EQ(0U, cache.listed_dir_count());
+
+  // Lookups that keep failing list the directory again.
+  record_misses(&cache, dir, DirectoryCache::kListingThreshold);
+  ASSERT_EQ(1U, cache.listed_dir_count());
+  ASSERT_TRUE(cache.may_contain(dir, "libbar.so"));
+  ASSERT_FALSE(cache.may_contain(dir, "libbaz.so"));
+
+  unlink((dir + "/libbar.so").c_str());
+}
+
+TEST(linker_dir_cache, recently_modified_directory_is_not_listed) {
+  TemporaryDir tmp_dir;
+  std::string dir = tmp_dir.path;
+  create_file(dir + "/libfoo.so");
+
+  DirectoryCache cache;
+  record_misses(&cache, dir, DirectoryCache::kListingThreshold);
+  ASSERT_EQ(0U, cache.listed_dir_count());
+  ASSERT_TRUE(cache.may_contain(dir, "libbar.so"));
+
+  unlink((dir + "/libfoo.so").c_str());
+}
+
+TEST(linker_dir_cache, missing_directory) {
+  DirectoryCache cache;
+  record_misses(&cache, "/this/directory/does/not/exist", DirectoryCache::kListingThreshold);
+  ASSERT_EQ(0U, cache.listed_dir_count());
+  ASSERT_TRUE(cache.may_contain("/this/directory/does/not/exist", "libfoo.so"));
+}
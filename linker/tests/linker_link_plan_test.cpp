@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../linker_link_plan.h"
+
+#include <android-base/file.h>
+#include <android-base/test_utils.h>
+
+static void write_plan(const std::string& plan_path,
+                       const std::string& lib_dir,
+                       const std::string& lib_path) {
+  struct stat lib_stat;
+  ASSERT_EQ(0, stat(lib_path.c_str(), &lib_stat));
+
+  LinkPlanBuilder builder;
+  builder.add_file(lib_dir);
+  builder.add_file(lib_dir + "/libfoo_override.so");
+  builder.add_library("libfoo.so", lib_path, lib_stat);
+
+  std::string error_msg;
+  ASSERT_TRUE(builder.write(plan_path.c_str(), &error_msg)) << error_msg;
+}
+
+TEST(linker_link_plan, get_path) {
+  ASSERT_EQ("/data/plans/system@bin@sh.plan",
+            LinkPlan::get_path("/data/plans", "/system/bin/sh"));
+}
+
+TEST(linker_link_plan, smoke) {
+  TemporaryDir lib_dir;
+  TemporaryDir plan_dir;
+  std::string lib_path = std::string(lib_dir.path) + "/libfoo.so";
+  std::string plan_path = std::string(plan_dir.path) + "/test.plan";
+  ASSERT_TRUE(android::base::WriteStringToFile("foo", lib_path));
+  write_plan(plan_path, lib_dir.path, lib_path);
+
+  LinkPlan plan;
+  std::string error_msg;
+  ASSERT_TRUE(plan.read(plan_path.c_str(), &error_msg)) << error_msg;
+  ASSERT_TRUE(plan.is_loaded());
+
+  std::string realpath;
+  ASSERT_EQ(-1, plan.open_library("libbar.so", &realpath));
+  ASSERT_TRUE(plan.is_loaded());
+
+  int fd = plan.open_library("libfoo.so", &realpath);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(lib_path, realpath);
+  close(fd);
+
+  unlink(plan_path.c_str());
+  unlink(lib_path.c_str());
+}
+
+TEST(linker_link_plan, stale_when_recorded_file_changes) {
+  TemporaryDir lib_dir;
+  TemporaryDir plan_dir;
+  std::string lib_path = std::string(lib_dir.path) + "/libfoo.so";
+  std::string override_path = std::string(lib_dir.path) + "/libfoo_override.so";
+  std::string plan_path = std::string(plan_dir.path) + "/test.plan";
+  ASSERT_TRUE(android::base::WriteStringToFile("foo", lib_path));
+  write_plan(plan_path, lib_dir.path, lib_path);
+
+  // A file that did not exist when the plan was written has appeared.
+  ASSERT_TRUE(android::base::WriteStringToFile("foo", override_path));
+
+  LinkPlan plan;
+  std::string error_msg;
+  ASSERT_FALSE(plan.read(plan_path.c_str(), &error_msg));
+  ASSERT_EQ("", error_msg);
+  ASSERT_FALSE(plan.is_loaded());
+
+  unlink(override_path.c_str());
+  unlink(plan_path.c_str());
+  unlink(lib_path.c_str());
+}
+
+TEST(linker_link_plan, dropped_when_library_changes) {
+  TemporaryDir lib_dir;
+  TemporaryDir plan_dir;
+  std::string lib_path = std::string(lib_dir.path) + "/libfoo.so";
+  std::string plan_path = std::string(plan_dir.path) + "/test.plan";
+  ASSERT_TRUE(android::base::WriteStringToFile("foo", lib_path));
+  write_plan(plan_path, lib_dir.path, lib_path);
+
+  // Overwriting the file keeps the directory as it was.
+  ASSERT_TRUE(android::base::WriteStringToFile("foobar", lib_path));
+
+  LinkPlan plan;
+  std::string error_msg;
+  ASSERT_TRUE(plan.read(plan_path.c_str(), &error_msg)) << error_msg;
+
+  std::string realpath;
+  ASSERT_EQ(-1, plan.open_library("libfoo.so", &realpath));
+  ASSERT_FALSE(plan.is_loaded());
+
+  unlink(plan_path.c_str());
+  unlink(lib_path.c_str());
+}
+
+TEST(linker_link_plan, missing_and_malformed) {
+  TemporaryDir plan_dir;
+  std::string plan_path = std::string(plan_dir.path) + "/test.plan";
+
+  LinkPlan plan;
+  std::string error_msg;
+  ASSERT_FALSE(plan.read(plan_path.c_str(), &error_msg));
+  ASSERT_EQ("", error_msg);
+
+  ASSERT_TRUE(android::base::WriteStringToFile(std::string(64, 'x'), plan_path));
+  ASSERT_FALSE(plan.read(plan_path.c_str(), &error_msg));
+  ASSERT_NE("", error_msg);
+  ASSERT_FALSE(plan.is_loaded());
+
+  unlink(plan_path.c_str());
+}
@@ -213,3 +213,95 @@ TEST(linker_memory, test_large) {
 }
 
 
+
+TEST(linker_memory, test_free_block_cache_reuse) {
+  LinkerMemoryAllocator allocator;
+
+  void* ptr1 = allocator.alloc(64);
+  ASSERT_TRUE(ptr1 != nullptr);
+  memset(ptr1, 0xff, 64);
+  allocator.free(ptr1);
+
+  // The most recently freed block is handed out again, and it is zeroed.
+  void* ptr2 = allocator.alloc(64);
+  ASSERT_EQ(ptr1, ptr2);
+
+  uint8_t zeros[64];
+  memset(zeros, 0, sizeof(zeros));
+  ASSERT_TRUE(memcmp(ptr2, zeros, sizeof(zeros)) == 0);
+
+  allocator.free(ptr2);
+}
+
+TEST(linker_memory, test_free_block_cache_overflow) {
+  LinkerMemoryAllocator allocator;
+
+  const size_t n = kFreeBlockCacheSize * 4;
+  void* objects[n];
+  for (size_t i = 0; i < n; ++i) {
+    objects[i] = allocator.alloc(32);
+    ASSERT_TRUE(objects[i] != nullptr);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    allocator.free(objects[i]);
+  }
+
+  // Allocating the same number of blocks again must not hand any block out twice.
+  void* again[n];
+  for (size_t i = 0; i < n; ++i) {
+    again[i] = allocator.alloc(32);
+    for (size_t j = 0; j < i; ++j) {
+      ASSERT_NE(again[j], again[i]);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    allocator.free(again[i]);
+  }
+}
+
+TEST(linker_memory, test_stats) {
+  LinkerMemoryAllocator allocator;
+
+  void* small1 = allocator.alloc(10);
+  void* small2 = allocator.alloc(16);
+  void* medium = allocator.alloc(500);
+  void* large = allocator.alloc(sizeof(test_struct_huge));
+
+  linker_allocator_stats small_stats[kSmallObjectAllocatorsCount];
+  linker_allocator_stats large_stats;
+  allocator.get_stats(small_stats, &large_stats);
+
+  // 16-byte class.
+  ASSERT_EQ(16U, small_stats[0].block_size);
+  ASSERT_EQ(2U, small_stats[0].alloc_count);
+  ASSERT_EQ(2U, small_stats[0].allocated_blocks);
+  ASSERT_EQ(1U, small_stats[0].pages);
+  // 512-byte class.
+  ASSERT_EQ(512U, small_stats[5].block_size);
+  ASSERT_EQ(1U, small_stats[5].allocated_blocks);
+
+  ASSERT_EQ(0U, large_stats.block_size);
+  ASSERT_EQ(1U, large_stats.allocated_blocks);
+  ASSERT_EQ((sizeof(test_struct_huge) + kPageSize) / kPageSize, large_stats.pages);
+
+  allocator.free(small1);
+  allocator.free(small2);
+  allocator.free(medium);
+  allocator.free(large);
+
+  // Freed blocks are reused from the cache.
+  void* small3 = allocator.alloc(16);
+
+  allocator.get_stats(small_stats, &large_stats);
+  ASSERT_EQ(3U, small_stats[0].alloc_count);
+  ASSERT_EQ(2U, small_stats[0].free_count);
+  ASSERT_EQ(1U, small_stats[0].cache_hit_count);
+  ASSERT_EQ(1U, small_stats[0].allocated_blocks);
+  ASSERT_EQ(2U, small_stats[0].peak_allocated_blocks);
+  ASSERT_EQ(0U, small_stats[5].allocated_blocks);
+  ASSERT_EQ(0U, large_stats.allocated_blocks);
+  ASSERT_EQ(0U, large_stats.pages);
+  ASSERT_EQ(1U, large_stats.page_unmap_count);
+
+  allocator.free(small3);
+}
@@ -121,3 +121,10 @@ TEST(linker_utils, safe_add) {
   ASSERT_TRUE(safe_add(&val, 2000, 42U));
   ASSERT_EQ(2042, val);
 }
+
+TEST(linker_utils, get_monotonic_time_ns) {
+  uint64_t t0 = get_monotonic_time_ns();
+  usleep(1000);
+  uint64_t t1 = get_monotonic_time_ns();
+  ASSERT_GE(t1 - t0, 1000000U);
+}
@@ -19,6 +19,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 static std::string class_with_dtor_output;
 
@@ -125,3 +126,31 @@ TEST(__cxa_thread_atexit_impl, smoke) {
 }
 
 
+
+static std::vector<size_t> many_dtor_calls;
+static size_t many_dtor_args[1000];
+
+static void thread_atexit_record(void* arg) {
+  many_dtor_calls.push_back(*static_cast<size_t*>(arg));
+}
+
+static void* thread_main_many(void*) {
+  // Enough destructors to need several blocks.
+  for (size_t i = 0; i < 1000; ++i) {
+    many_dtor_args[i] = i;
+    __cxa_thread_atexit_impl(thread_atexit_record, &many_dtor_args[i], nullptr);
+  }
+  return nullptr;
+}
+
+TEST(__cxa_thread_atexit_impl, many) {
+  many_dtor_calls.clear();
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, nullptr, thread_main_many, nullptr));
+  ASSERT_EQ(0, pthread_join(t, nullptr));
+  ASSERT_EQ(1000U, many_dtor_calls.size());
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(999 - i, many_dtor_calls[i]);
+  }
+}
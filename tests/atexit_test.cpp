@@ -117,3 +117,35 @@ TEST(atexit, exit) {
   ASSERT_EXIT(atexit_main(), testing::ExitedWithCode(0), "123456");
 }
 
+extern "C" int __cxa_atexit(void (*func)(void*), void* arg, void* dso);
+extern "C" void __cxa_finalize(void* dso);
+
+static std::string cxa_finalize_sequence;
+// Use addresses of our own as the dso handles of two fake libraries.
+static char fake_dso1, fake_dso2;
+
+static void cxa_atexit_append(void* arg) {
+  cxa_finalize_sequence += static_cast<const char*>(arg);
+}
+
+static void cxa_atexit_append_and_register(void* arg) {
+  cxa_atexit_append(arg);
+  // Registered while its DSO is being finalized, so it runs next.
+  __cxa_atexit(cxa_atexit_append, const_cast<char*>("c"), &fake_dso1);
+}
+
+TEST(atexit, __cxa_finalize_dso) {
+  cxa_finalize_sequence.clear();
+  ASSERT_EQ(0, __cxa_atexit(cxa_atexit_append, const_cast<char*>("a"), &fake_dso1));
+  ASSERT_EQ(0, __cxa_atexit(cxa_atexit_append, const_cast<char*>("1"), &fake_dso2));
+  ASSERT_EQ(0, __cxa_atexit(cxa_atexit_append_and_register, const_cast<char*>("b"), &fake_dso1));
+  ASSERT_EQ(0, __cxa_atexit(cxa_atexit_append, const_cast<char*>("2"), &fake_dso2));
+  ASSERT_EQ(0, __cxa_atexit(cxa_atexit_append, const_cast<char*>("d"), &fake_dso1));
+
+  __cxa_finalize(&fake_dso1);
+  ASSERT_EQ("dbca", cxa_finalize_sequence);
+  __cxa_finalize(&fake_dso1);
+  ASSERT_EQ("dbca", cxa_finalize_sequence);
+  __cxa_finalize(&fake_dso2);
+  ASSERT_EQ("dbca21", cxa_finalize_sequence);
+}
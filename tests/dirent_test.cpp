@@ -20,6 +20,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -27,6 +28,13 @@
 #include <algorithm>
 #include <set>
 #include <string>
+#include <vector>
+
+#include "TemporaryFile.h"
+
+#if defined(__BIONIC__)
+#include <android/dirent.h>
+#endif
 
 static void CheckProcSelf(std::set<std::string>& names) {
   // We have a good idea of what should be in /proc/self.
@@ -216,6 +224,99 @@ TEST(dirent, readdir) {
   CheckProcSelf(name_set);
 }
 
+// Makes a directory big enough to need several getdents64 calls.
+class LargeDirectory {
+ public:
+  LargeDirectory() {
+    for (size_t i = 0; i < kFileCount; ++i) {
+      std::string name = Path(i);
+      int fd = open(name.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0600);
+      if (fd != -1) close(fd);
+    }
+  }
+
+  ~LargeDirectory() {
+    for (size_t i = 0; i < kFileCount; ++i) unlink(Path(i).c_str());
+  }
+
+  void CheckNames(const std::set<std::string>& names) {
+    ASSERT_EQ(kFileCount + 2, names.size());
+    for (size_t i = 0; i < kFileCount; ++i) {
+      ASSERT_TRUE(names.find("file_with_a_longish_name_" + std::to_string(i)) != names.end());
+    }
+  }
+
+  static constexpr size_t kFileCount = 2000;
+  TemporaryDir dir;
+
+ private:
+  std::string Path(size_t i) {
+    return std::string(dir.dirname) + "/file_with_a_longish_name_" + std::to_string(i);
+  }
+};
+
+TEST(dirent, readdir_large_directory) {
+  LargeDirectory large;
+  DIR* d = opendir(large.dir.dirname);
+  ASSERT_TRUE(d != NULL);
+  std::set<std::string> name_set;
+  std::vector<long> offsets;
+  errno = 0;
+  dirent* e;
+  while ((e = readdir(d)) != NULL) {
+    name_set.insert(e->d_name);
+    offsets.push_back(telldir(d));
+  }
+  ASSERT_EQ(0, errno);
+  large.CheckNames(name_set);
+
+  // Seeking back into the middle still works with the larger buffer.
+  seekdir(d, offsets[999]);
+  size_t rest = 0;
+  while (readdir(d) != NULL) ++rest;
+  ASSERT_EQ(offsets.size() - 1000, rest);
+  ASSERT_EQ(closedir(d), 0);
+}
+
+TEST(dirent, android_readdir_batch) {
+#if defined(__BIONIC__)
+  DIR* d = opendir("/proc/self");
+  ASSERT_TRUE(d != NULL);
+  std::set<std::string> name_set;
+  android_dirent_record records[4];
+  ssize_t n;
+  while ((n = android_readdir_batch(d, records, 4)) > 0) {
+    for (ssize_t i = 0; i < n; ++i) name_set.insert(records[i].d_name);
+  }
+  ASSERT_EQ(0, n);
+  ASSERT_EQ(closedir(d), 0);
+  CheckProcSelf(name_set);
+
+  // Mixing with readdir, across several buffers' worth of entries.
+  LargeDirectory large;
+  d = opendir(large.dir.dirname);
+  ASSERT_TRUE(d != NULL);
+  name_set.clear();
+  dirent* e = readdir(d);
+  ASSERT_TRUE(e != NULL);
+  name_set.insert(e->d_name);
+  android_dirent_record many[256];
+  while ((n = android_readdir_batch(d, many, 256)) > 0) {
+    for (ssize_t i = 0; i < n; ++i) {
+      name_set.insert(many[i].d_name);
+      ASSERT_NE(0U, many[i].d_ino);
+    }
+    if ((e = readdir(d)) == NULL) break;
+    name_set.insert(e->d_name);
+  }
+  ASSERT_GE(n, 0);
+  ASSERT_EQ(closedir(d), 0);
+  large.CheckNames(name_set);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(dirent, readdir64) {
   DIR* d = opendir("/proc/self");
   ASSERT_TRUE(d != NULL);
@@ -109,4 +109,30 @@ TEST(dl, xfail_preinit_getauxval) {
 #endif
 }
 
+TEST(dl, startup_trace) {
+#if defined(__BIONIC__)
+  std::string helper = get_testlib_root() +
+      "/startup_trace_test_helper/startup_trace_test_helper";
+  chmod(helper.c_str(), 0755); // TODO: "x" lost in CTS, b/34945607
+  ExecTestHelper eth;
+  eth.SetArgs({ helper.c_str(), nullptr });
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0, "");
+
+  eth.SetEnv({ "LIBC_STARTUP_TRACE=1", nullptr });
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0,
+          "start\n"
+          "linker_globals\n"
+          "linker_constructors\n"
+          "linker_at_secure\n"
+          "linker_properties\n"
+          "linker_libraries\n"
+          "libc_globals\n"
+          "libc_common\n"
+          "libc_malloc\n"
+          "libc_netd\n"
+          "constructors\n"
+          "main\n");
+#endif
+}
+
 // TODO: Add tests for LD_PRELOADs
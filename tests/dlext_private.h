@@ -97,6 +97,98 @@ extern bool android_link_namespaces(android_namespace_t* from,
 
 extern void android_set_application_target_sdk_version(uint32_t target);
 
+/*
+ * Per-library load cost, in nanoseconds. Stages that did not run for a
+ * library (the main executable is opened and mapped by the kernel, for
+ * example) are reported as 0. Constructor time does not include the
+ * constructors of the library's dependencies.
+ */
+struct android_dlopen_stats {
+  const char* realpath;
+  uint64_t open_ns;          /* Locating and opening the file and reading its ELF headers. */
+  uint64_t map_ns;           /* Reserving address space and mapping the segments. */
+  uint64_t prelink_ns;       /* Parsing the dynamic section. */
+  uint64_t relocate_ns;      /* Relocation, including symbol lookup and RELRO protection. */
+  uint64_t constructors_ns;  /* DT_INIT and DT_INIT_ARRAY. */
+};
+
+/*
+ * Calls cb once for every loaded library with the time the linker spent
+ * loading it, while holding the linker lock. Iteration stops as soon as cb
+ * returns non-zero, and that value is returned.
+ */
+extern int android_iterate_dlopen_stats(
+    int (*cb)(const struct android_dlopen_stats* stats, void* data),
+    void* data);
+
+/*
+ * Releases what the linker keeps around between dlopen calls to speed up
+ * later ones: the open zip files (APKs) libraries were loaded from, the
+ * extracted copies of compressed libraries that are no longer loaded and the
+ * listings of the library directories. Meant to be called when the process
+ * is asked to trim its memory; the caches are rebuilt as needed.
+ */
+extern void android_trim_dlopen_caches();
+
+/*
+ * Looks up count symbols like dlsym(handle, symbols[i]) would, but walks the
+ * dependency tree of handle only once for all of them. addresses[i] is set to
+ * the address of symbols[i], or to NULL if it was not found. Returns the
+ * number of symbols found, or -1 if handle is invalid (see dlerror()).
+ */
+extern int android_dlsym_many(void* handle,
+                              const char* const symbols[],
+                              void* addresses[],
+                              size_t count);
+
+/*
+ * What the linker's own allocations occupy, in bytes.
+ */
+struct android_linker_memory_stats {
+  size_t soinfo_bytes;           /* The pool of library descriptors. */
+  size_t namespace_bytes;        /* The pool of namespaces. */
+  size_t list_bytes;             /* The pools of soinfo and namespace list entries. */
+  size_t other_pool_bytes;       /* Other fixed-size pools. */
+  size_t heap_small_bytes;       /* Pages the linker's malloc holds for small objects. */
+  size_t heap_small_used_bytes;  /* The part of them that is allocated. */
+  size_t heap_large_bytes;       /* Mappings the linker's malloc made for larger objects. */
+};
+
+/*
+ * Page counts of a loaded library.
+ */
+struct android_library_memory {
+  const char* realpath;
+  const char* namespace_name;
+  size_t mapped_pages;              /* Pages of the loadable segments. */
+  size_t resident_pages;            /* Those of them that are resident. */
+  size_t relocated_pages;           /* Pages of the writable segments. */
+  size_t relocated_resident_pages;  /* Those of them that are resident. */
+};
+
+extern void android_get_linker_memory_stats(struct android_linker_memory_stats* stats);
+
+/*
+ * Calls cb for each loaded library, stopping if it returns non-zero, which
+ * is then returned.
+ */
+extern int android_iterate_library_memory(int (*cb)(const struct android_library_memory* memory,
+                                                    void* data),
+                                          void* data);
+
+/*
+ * Writes the above, with totals for each namespace, to fd as text.
+ */
+extern void android_dump_linker_memory(int fd);
+
+/*
+ * Like dlsym(handle, symbol), for callers that have computed the GNU hash of
+ * the name ahead of time, perhaps at compile time: h = h * 33 + c over its
+ * bytes, starting from 5381, in uint32_t arithmetic. A wrong hash makes the
+ * lookup fail.
+ */
+extern void* android_dlsym_hashed(void* handle, const char* symbol, uint32_t gnu_hash);
+
 __END_DECLS
 
 #endif /* __ANDROID_DLEXT_NAMESPACES_H__ */
@@ -21,6 +21,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <link.h>
+#include <signal.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -231,6 +233,210 @@ TEST(dlext, android_dlopen_ext_force_load_soname_exception) {
   dlclose(handle);
 }
 
+TEST(dlext, android_dlopen_ext_readahead_dependencies) {
+  // The readahead is only a hint; the dependency tree must still be
+  // loaded and relocated exactly as without the flag. See
+  // dlfcn.dlopen_check_order_reloc_siblings for the layout of this tree.
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_READAHEAD_DEPENDENCIES;
+  void* handle = android_dlopen_ext("libtest_check_order_reloc_siblings.so", RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle);
+
+  typedef int (*fn_t) (void);
+  fn_t fn = reinterpret_cast<fn_t>(dlsym(handle, "check_order_reloc_get_answer"));
+  ASSERT_DL_NOTNULL(fn);
+  ASSERT_EQ(42, fn());
+
+  dlclose(handle);
+}
+
+TEST(dlext, android_dlopen_ext_readahead_dependencies_from_fd) {
+  const std::string lib_path = get_testlib_root() + "/libdlext_test_fd/libdlext_test_fd.so";
+
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_USE_LIBRARY_FD | ANDROID_DLEXT_READAHEAD_DEPENDENCIES;
+  extinfo.library_fd = TEMP_FAILURE_RETRY(open(lib_path.c_str(), O_RDONLY | O_CLOEXEC));
+  ASSERT_TRUE(extinfo.library_fd != -1);
+  void* handle = android_dlopen_ext(lib_path.c_str(), RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle);
+  fn f = reinterpret_cast<fn>(dlsym(handle, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_EQ(4, f());
+
+  dlclose(handle);
+  close(extinfo.library_fd);
+}
+
+static uint64_t get_constructors_ns(const char* libname) {
+  std::pair<const char*, uint64_t> args(libname, UINT64_MAX);
+  android_iterate_dlopen_stats([](const android_dlopen_stats* stats, void* data) {
+    auto args = reinterpret_cast<std::pair<const char*, uint64_t>*>(data);
+    if (android::base::EndsWith(stats->realpath, std::string("/") + args->first)) {
+      args->second = stats->constructors_ns;
+      return 1;
+    }
+    return 0;
+  }, &args);
+  return args.second;
+}
+
+TEST(dlext, android_dlopen_ext_lazy_constructors) {
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_LAZY_CONSTRUCTORS;
+  void* handle = android_dlopen_ext("libtest_init_fini_order_root.so", RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle);
+
+  // Nothing has run yet, for the root or for its dependencies.
+  ASSERT_EQ(0U, get_constructors_ns("libtest_init_fini_order_root.so"));
+  ASSERT_EQ(0U, get_constructors_ns("libtest_init_fini_order_child.so"));
+  ASSERT_EQ(0U, get_constructors_ns("libtest_init_fini_order_grand_child.so"));
+
+  // The first dlsym runs the whole tree in the usual order.
+  typedef int (*get_init_order_number_t)();
+  get_init_order_number_t get_init_order_number =
+      reinterpret_cast<get_init_order_number_t>(dlsym(handle, "get_init_order_number"));
+  ASSERT_DL_NOTNULL(get_init_order_number);
+  ASSERT_EQ(321, get_init_order_number());
+  ASSERT_NE(0U, get_constructors_ns("libtest_init_fini_order_root.so"));
+
+  // The destructors report through this callback.
+  typedef void (*set_fini_callback_t)(void (*f)(const char*));
+  set_fini_callback_t set_fini_callback =
+      reinterpret_cast<set_fini_callback_t>(dlsym(handle, "set_fini_callback"));
+  ASSERT_DL_NOTNULL(set_fini_callback);
+  set_fini_callback([](const char*) {});
+
+  dlclose(handle);
+}
+
+TEST(dlext, android_dlsym_many) {
+  void* handle = dlopen("libtest_with_dependency.so", RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle);
+
+  // getRandomNumber is in the DT_NEEDED library.
+  const char* const names[] = { "getRandomNumber", "this_symbol_does_not_exist", nullptr };
+  void* addresses[3] = { &handle, &handle, &handle };
+
+  // The second call is answered from what the linker remembered from the first one.
+  for (size_t i = 0; i < 2; ++i) {
+    ASSERT_EQ(1, android_dlsym_many(handle, names, addresses, 3));
+    ASSERT_EQ(dlsym(handle, "getRandomNumber"), addresses[0]);
+    ASSERT_TRUE(addresses[1] == nullptr);
+    ASSERT_TRUE(addresses[2] == nullptr);
+  }
+
+  int (*fn)(void) = reinterpret_cast<int (*)(void)>(addresses[0]);
+  EXPECT_EQ(4, fn());
+
+  ASSERT_EQ(0, android_dlsym_many(handle, names, addresses, 0));
+
+  dlclose(handle);
+
+  void* invalid_handle = reinterpret_cast<void*>(0x1);
+  ASSERT_EQ(-1, android_dlsym_many(invalid_handle, names, addresses, 3));
+  ASSERT_TRUE(dlerror() != nullptr);
+}
+
+static constexpr uint32_t constexpr_gnu_hash(const char* name, uint32_t h = 5381) {
+  return *name == '\0' ? h : constexpr_gnu_hash(name + 1, h * 33 + static_cast<uint8_t>(*name));
+}
+
+TEST(dlext, android_dlsym_hashed) {
+  void* handle = dlopen("libtest_with_dependency.so", RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle);
+
+  constexpr uint32_t kHash = constexpr_gnu_hash("getRandomNumber");
+  // A lookup with the wrong hash may fail (that depends on the hash table
+  // style of the library), but mustn't stop later lookups from succeeding.
+  android_dlsym_hashed(handle, "getRandomNumber", kHash + 1);
+
+  void* sym = android_dlsym_hashed(handle, "getRandomNumber", kHash);
+  ASSERT_DL_NOTNULL(sym);
+  ASSERT_EQ(dlsym(handle, "getRandomNumber"), sym);
+
+  ASSERT_TRUE(android_dlsym_hashed(handle, "this_symbol_does_not_exist",
+                                   constexpr_gnu_hash("this_symbol_does_not_exist")) == nullptr);
+  ASSERT_TRUE(dlerror() != nullptr);
+
+  dlclose(handle);
+}
+
+TEST(dlext, android_linker_memory) {
+  void* handle = dlopen("libtest_with_dependency.so", RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle);
+
+  android_linker_memory_stats stats;
+  android_get_linker_memory_stats(&stats);
+  ASSERT_GT(stats.soinfo_bytes, 0U);
+  ASSERT_LE(stats.heap_small_used_bytes, stats.heap_small_bytes);
+
+  struct found_t {
+    bool found;
+    android_library_memory memory;
+  } found = { false, {} };
+  ASSERT_EQ(0, android_iterate_library_memory([](const android_library_memory* memory, void* data) {
+    found_t* f = reinterpret_cast<found_t*>(data);
+    if (android::base::EndsWith(memory->realpath, "/libtest_with_dependency.so")) {
+      f->found = true;
+      f->memory = *memory;
+    }
+    return 0;
+  }, &found));
+  ASSERT_TRUE(found.found);
+  ASSERT_GT(found.memory.mapped_pages, 0U);
+  ASSERT_LE(found.memory.resident_pages, found.memory.mapped_pages);
+  ASSERT_LE(found.memory.relocated_pages, found.memory.mapped_pages);
+  ASSERT_LE(found.memory.relocated_resident_pages, found.memory.relocated_pages);
+
+  // A non-zero return stops the iteration.
+  ASSERT_EQ(7, android_iterate_library_memory([](const android_library_memory*, void*) {
+    return 7;
+  }, nullptr));
+
+  TemporaryFile tf;
+  android_dump_linker_memory(tf.fd);
+  std::string dump;
+  ASSERT_TRUE(android::base::ReadFileToString(tf.filename, &dump));
+  ASSERT_NE(std::string::npos, dump.find("libtest_with_dependency.so")) << dump;
+
+  dlclose(handle);
+}
+
+TEST(dlext, android_iterate_dlopen_stats) {
+  void* handle = dlopen("libtest_check_order_reloc_siblings.so", RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle);
+
+  size_t library_count = 0;
+  android_dlopen_stats found = {};
+  auto cb = [](const android_dlopen_stats* stats, void* data) {
+    auto args = reinterpret_cast<std::pair<size_t*, android_dlopen_stats*>*>(data);
+    ++*args->first;
+    if (android::base::EndsWith(stats->realpath, "/libtest_check_order_reloc_siblings.so")) {
+      *args->second = *stats;
+    }
+    return 0;
+  };
+  std::pair<size_t*, android_dlopen_stats*> args(&library_count, &found);
+  ASSERT_EQ(0, android_iterate_dlopen_stats(cb, &args));
+
+  ASSERT_GT(library_count, 1U);
+  ASSERT_TRUE(found.realpath != nullptr);
+  ASSERT_GT(found.open_ns, 0U);
+  ASSERT_GT(found.map_ns, 0U);
+  ASSERT_GT(found.prelink_ns, 0U);
+  ASSERT_GT(found.relocate_ns, 0U);
+
+  // A non-zero return stops the iteration and is passed through.
+  size_t calls = 0;
+  ASSERT_EQ(7, android_iterate_dlopen_stats([](const android_dlopen_stats*, void* data) {
+    ++*reinterpret_cast<size_t*>(data);
+    return 7;
+  }, &calls));
+  ASSERT_EQ(1U, calls);
+
+  dlclose(handle);
+}
+
 TEST(dlfcn, dlopen_from_zip_absolute_path) {
   const std::string lib_zip_path = "/libdlext_test_zip/libdlext_test_zip_zipaligned.zip";
   const std::string lib_path = get_testlib_root() + lib_zip_path;
@@ -245,6 +451,52 @@ TEST(dlfcn, dlopen_from_zip_absolute_path) {
   dlclose(handle);
 }
 
+TEST(dlfcn, dlopen_from_zip_after_trim_dlopen_caches) {
+  const std::string lib_zip_path = "/libdlext_test_zip/libdlext_test_zip_zipaligned.zip";
+  const std::string lib_path = get_testlib_root() + lib_zip_path + "!/libdir/libatest_simple_zip.so";
+
+  // The first dlopen leaves the zip file open in the linker, the second one
+  // reuses it, the third one has to open it again.
+  for (size_t i = 0; i < 3; ++i) {
+    if (i == 2) {
+      android_trim_dlopen_caches();
+    }
+
+    void* handle = dlopen(lib_path.c_str(), RTLD_NOW);
+    ASSERT_TRUE(handle != nullptr) << dlerror();
+
+    uint32_t* taxicab_number =
+        reinterpret_cast<uint32_t*>(dlsym(handle, "dlopen_testlib_taxicab_number"));
+    ASSERT_DL_NOTNULL(taxicab_number);
+    EXPECT_EQ(1729U, *taxicab_number);
+
+    dlclose(handle);
+  }
+}
+
+TEST(dlfcn, dlopen_from_compressed_zip) {
+  const std::string lib_zip_path = "/libdlext_test_zip/libdlext_test_zip_compressed.zip";
+  const std::string lib_path = get_testlib_root() + lib_zip_path + "!/libdir/libatest_simple_zip.so";
+
+  void* handle = dlopen(lib_path.c_str(), RTLD_NOW);
+  ASSERT_TRUE(handle != nullptr) << dlerror();
+
+  uint32_t* taxicab_number =
+      reinterpret_cast<uint32_t*>(dlsym(handle, "dlopen_testlib_taxicab_number"));
+  ASSERT_DL_NOTNULL(taxicab_number);
+  EXPECT_EQ(1729U, *taxicab_number);
+
+  // The extracted copy outlives the linker's caches while the library is
+  // loaded, so it is still recognized as the same library.
+  android_trim_dlopen_caches();
+  void* handle2 = dlopen(lib_path.c_str(), RTLD_NOW);
+  ASSERT_TRUE(handle2 != nullptr) << dlerror();
+  EXPECT_EQ(handle, handle2);
+  dlclose(handle2);
+
+  dlclose(handle);
+}
+
 TEST(dlfcn, dlopen_from_zip_with_dt_runpath) {
   const std::string lib_zip_path = "/libdlext_test_runpath_zip/libdlext_test_runpath_zip_zipaligned.zip";
   const std::string lib_path = get_testlib_root() + lib_zip_path;
@@ -365,6 +617,69 @@ TEST_F(DlExtTest, ReservedHintTooSmall) {
   EXPECT_EQ(4, f());
 }
 
+TEST(dlext, android_dlopen_ext_lazy_binding) {
+  // Without lazy binding, the call to the undefined function stops the load.
+  void* handle = dlopen("libdlext_test_lazy_binding.so", RTLD_NOW);
+  ASSERT_TRUE(handle == nullptr);
+  ASSERT_SUBSTR("cannot locate symbol \"lazy_binding_undefined_func\"", dlerror());
+
+#if defined(__aarch64__) || defined(__x86_64__)
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_LAZY_BINDING;
+  handle = android_dlopen_ext("libdlext_test_lazy_binding.so", RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle);
+
+  // Calls that can be bound work as usual, and keep working once bound.
+  typedef bool (*fn_t)();
+  fn_t call_defined = reinterpret_cast<fn_t>(dlsym(handle, "lazy_binding_call_defined"));
+  ASSERT_DL_NOTNULL(call_defined);
+  ASSERT_TRUE(call_defined());
+  ASSERT_TRUE(call_defined());
+
+  // The one that can't be aborts when it's made.
+  typedef int (*undefined_fn_t)();
+  undefined_fn_t call_undefined =
+      reinterpret_cast<undefined_fn_t>(dlsym(handle, "lazy_binding_call_undefined"));
+  ASSERT_DL_NOTNULL(call_undefined);
+  ASSERT_EXIT(call_undefined(), testing::KilledBySignal(SIGABRT),
+              "cannot locate symbol \"lazy_binding_undefined_func\"");
+
+  dlclose(handle);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing: lazy binding is only supported on arm64 and x86_64.\n";
+#endif
+}
+
+TEST_F(DlExtTest, HugePageText) {
+  android_dlextinfo extinfo;
+  extinfo.flags = ANDROID_DLEXT_HUGEPAGE_TEXT;
+  handle_ = android_dlopen_ext(kLibName, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_EQ(4, f());
+
+  // The text segment starts on a huge page boundary whether or not the
+  // kernel has transparent huge pages to back it with.
+  uintptr_t text_start = 0;
+  dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+    if (info->dlpi_name == nullptr ||
+        !android::base::EndsWith(info->dlpi_name, std::string("/") + kLibName)) {
+      return 0;
+    }
+    for (size_t i = 0; i < info->dlpi_phnum; ++i) {
+      const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+      if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X) != 0) {
+        *reinterpret_cast<uintptr_t*>(data) = (info->dlpi_addr + phdr.p_vaddr) & ~(PAGE_SIZE - 1);
+        return 1;
+      }
+    }
+    return 0;
+  }, &text_start);
+  ASSERT_NE(0U, text_start);
+  EXPECT_EQ(0U, text_start % (2 * 1024 * 1024));
+}
+
 TEST_F(DlExtTest, LoadAtFixedAddress) {
   void* start = mmap(nullptr, kLibSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   ASSERT_TRUE(start != MAP_FAILED);
@@ -18,14 +18,17 @@
 
 #include <dlfcn.h>
 #include <limits.h>
+#include <link.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "private/ScopeGuard.h"
 
+#include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "gtest_globals.h"
 #include "dlfcn_symlink_support.h"
@@ -829,6 +832,58 @@ TEST(dlfcn, dlerror_concurrent) {
   ASSERT_SUBSTR("/main/thread", main_thread_error);
 }
 
+static bool is_library_in_phdr_list(const char* name) {
+  std::pair<const char*, bool> args(name, false);
+  dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+    auto args = reinterpret_cast<std::pair<const char*, bool>*>(data);
+    if (info->dlpi_name != nullptr && strstr(info->dlpi_name, args->first) != nullptr) {
+      args->second = true;
+      return 1;
+    }
+    return 0;
+  }, &args);
+  return args.second;
+}
+
+TEST(dlfcn, dl_iterate_phdr_concurrent_with_dlopen) {
+  std::atomic<bool> done(false);
+  std::atomic<size_t> iterations(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      while (!done) {
+        int count = 0;
+        dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) {
+          // Every object must come with a consistent phdr table.
+          for (size_t j = 0; j < info->dlpi_phnum; ++j) {
+            if (info->dlpi_phdr[j].p_type == PT_LOAD && info->dlpi_phdr[j].p_memsz == 0) {
+              return -1;
+            }
+          }
+          ++*reinterpret_cast<int*>(data);
+          return 0;
+        }, &count);
+        ASSERT_GT(count, 0);
+        ++iterations;
+      }
+    });
+  }
+  auto guard = make_scope_guard([&]() {
+    done = true;
+    for (auto&& t : threads) {
+      t.join();
+    }
+  });
+
+  for (size_t i = 0; i < 20; ++i) {
+    void* handle = dlopen("libtest_simple.so", RTLD_NOW);
+    ASSERT_TRUE(handle != nullptr) << dlerror();
+    ASSERT_TRUE(is_library_in_phdr_list("libtest_simple.so"));
+    ASSERT_EQ(0, dlclose(handle));
+    ASSERT_FALSE(is_library_in_phdr_list("libtest_simple.so"));
+  }
+}
+
 TEST(dlfcn, dlsym_failures) {
   dlerror(); // Clear any pending errors.
   void* self = dlopen(nullptr, RTLD_NOW);
@@ -965,6 +1020,24 @@ TEST(dlfcn, dladdr_libc) {
 #endif
 }
 
+TEST(dlfcn, dladdr_inside_function) {
+  void* handle = dlopen("libtest_simple.so", RTLD_NOW);
+  ASSERT_TRUE(handle != nullptr) << dlerror();
+  void* sym = dlsym(handle, "dlopen_testlib_simple_func");
+  ASSERT_TRUE(sym != nullptr) << dlerror();
+
+  // Any address within the function resolves to it, repeatedly.
+  for (size_t i = 0; i < 2; ++i) {
+    Dl_info info;
+    ASSERT_NE(0, dladdr(reinterpret_cast<char*>(sym) + 1, &info));
+    ASSERT_STREQ("dlopen_testlib_simple_func", info.dli_sname);
+    ASSERT_EQ(sym, info.dli_saddr);
+    ASSERT_SUBSTR("libtest_simple.so", info.dli_fname);
+  }
+
+  ASSERT_EQ(0, dlclose(handle));
+}
+
 TEST(dlfcn, dladdr_invalid) {
   Dl_info info;
 
@@ -1026,6 +1099,77 @@ TEST(dlfcn, dlopen_library_with_only_sysv_hash) {
   ASSERT_SUBSTR("libsysv-hash-table-library.so", dlinfo.dli_fname);
 }
 
+TEST(dlfcn, dlsym_in_library_with_only_sysv_hash_and_many_symbols) {
+  void* handle = dlopen("libsysv-hash-table-many-symbols.so", RTLD_NOW);
+  ASSERT_TRUE(handle != nullptr) << dlerror();
+  auto guard = make_scope_guard([&]() {
+    dlclose(handle);
+  });
+
+  // Every defined symbol must get past the linker's bloom filter...
+  for (int i = 10; i <= 87; ++i) {
+    if (i % 10 > 7) {
+      continue;
+    }
+    std::string name = "sysv_hash_symbol_" + std::to_string(i);
+    void* sym = dlsym(handle, name.c_str());
+    ASSERT_TRUE(sym != nullptr) << name << ": " << dlerror();
+    EXPECT_EQ(i, reinterpret_cast<int (*)()>(sym)()) << name;
+  }
+
+  // ...and the ones that are not defined must still not be found.
+  for (int i = 90; i < 200; ++i) {
+    std::string name = "sysv_hash_symbol_" + std::to_string(i);
+    ASSERT_TRUE(dlsym(handle, name.c_str()) == nullptr) << name;
+  }
+}
+
+TEST(dlfcn, elftls_in_dlopened_library) {
+#if defined(__BIONIC__) && !defined(__mips__)
+  void* handle = dlopen("libtest_elftls_dynamic.so", RTLD_NOW);
+  ASSERT_TRUE(handle != nullptr) << dlerror();
+  auto guard = make_scope_guard([&]() {
+    dlclose(handle);
+  });
+
+  auto get_data = reinterpret_cast<int* (*)()>(dlsym(handle, "get_elftls_dynamic_data"));
+  ASSERT_TRUE(get_data != nullptr) << dlerror();
+  auto bump = reinterpret_cast<int (*)()>(dlsym(handle, "bump_elftls_dynamic"));
+  ASSERT_TRUE(bump != nullptr) << dlerror();
+
+  // dlsym finds the calling thread's copy of a TLS variable.
+  int* data = get_data();
+  ASSERT_EQ(42, *data);
+  ASSERT_EQ(data, dlsym(handle, "elftls_dynamic_data"));
+  ASSERT_EQ(45, bump());
+  ASSERT_EQ(48, bump());
+
+  // Another thread gets its own copies, initialized from the library's image.
+  int* thread_data = nullptr;
+  int thread_bump = 0;
+  std::thread t([&]() {
+    thread_data = get_data();
+    thread_bump = bump();
+  });
+  t.join();
+  ASSERT_NE(data, thread_data);
+  ASSERT_EQ(45, thread_bump);
+  ASSERT_EQ(44, *data);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(dlfcn, elftls_initial_exec_in_dlopened_library) {
+#if defined(__BIONIC__) && !defined(__mips__)
+  void* handle = dlopen("libtest_elftls_dynamic_ie.so", RTLD_NOW);
+  ASSERT_TRUE(handle == nullptr);
+  ASSERT_SUBSTR("using IE access model", dlerror());
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(dlfcn, dlopen_bad_flags) {
   dlerror(); // Clear any pending errors.
   void* handle;
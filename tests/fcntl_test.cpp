@@ -21,9 +21,18 @@
 #include <string.h>
 #include <sys/utsname.h>
 #include <sys/vfs.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <android-base/file.h>
 
 #include "TemporaryFile.h"
 
+#if defined(__BIONIC__)
+#include <android/copy_fd.h>
+#endif
+
 // Glibc v2.19 doesn't include these in fcntl.h so host builds will fail without.
 #if !defined(FALLOC_FL_PUNCH_HOLE) || !defined(FALLOC_FL_KEEP_SIZE)
 #include <linux/falloc.h>
@@ -183,6 +192,81 @@ TEST(fcntl, splice) {
   close(in);
 }
 
+TEST(fcntl, copy_file_range) {
+#if defined(__BIONIC__)
+  TemporaryFile in;
+  TemporaryFile out;
+  std::string data(64 * 1024, 'x');
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), write(in.fd, data.data(), data.size()));
+
+  off64_t in_offset = 1024;
+  ssize_t bytes_copied = copy_file_range(in.fd, &in_offset, out.fd, nullptr, 4096, 0);
+  if (bytes_copied == -1 && errno == ENOSYS) {
+    GTEST_LOG_(INFO) << "This kernel doesn't have copy_file_range.\n";
+    return;
+  }
+  ASSERT_EQ(4096, bytes_copied);
+  ASSERT_EQ(1024 + 4096, in_offset);
+  ASSERT_EQ(4096, lseek(out.fd, 0, SEEK_CUR));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+#if defined(__BIONIC__)
+static void CheckCopyFd(int out_fd, int in_fd, size_t count, const std::string& expected) {
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), android_copy_fd(out_fd, in_fd, count));
+  std::string actual(expected.size(), '\0');
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), pread(out_fd, &actual[0], actual.size(), 0));
+  ASSERT_EQ(expected, actual);
+}
+#endif
+
+TEST(fcntl, android_copy_fd) {
+#if defined(__BIONIC__)
+  std::string data;
+  for (size_t i = 0; i < 3 * 1024 * 1024; ++i) data += static_cast<char>(i * 7);
+
+  // File to file, and to an O_APPEND file, which copy_file_range refuses.
+  TemporaryFile in;
+  ASSERT_EQ(static_cast<ssize_t>(data.size()), write(in.fd, data.data(), data.size()));
+  ASSERT_EQ(0, lseek(in.fd, 0, SEEK_SET));
+  TemporaryFile out;
+  CheckCopyFd(out.fd, in.fd, SIZE_MAX, data);
+
+  ASSERT_EQ(100, lseek(in.fd, 100, SEEK_SET));
+  TemporaryFile append;
+  int append_fd = open(append.filename, O_RDWR | O_APPEND);
+  ASSERT_NE(-1, append_fd);
+  CheckCopyFd(append_fd, in.fd, 1000, data.substr(100, 1000));
+  close(append_fd);
+
+  // Pipe to file.
+  int pipe_fds[2];
+  ASSERT_EQ(0, pipe(pipe_fds));
+  ASSERT_EQ(5, write(pipe_fds[1], "hello", 5));
+  close(pipe_fds[1]);
+  TemporaryFile from_pipe;
+  CheckCopyFd(from_pipe.fd, pipe_fds[0], SIZE_MAX, "hello");
+  close(pipe_fds[0]);
+
+  // A /proc file, whose size isn't known up front.
+  std::string version;
+  ASSERT_TRUE(android::base::ReadFileToString("/proc/version", &version));
+  int proc_fd = open("/proc/version", O_RDONLY);
+  ASSERT_NE(-1, proc_fd);
+  TemporaryFile from_proc;
+  CheckCopyFd(from_proc.fd, proc_fd, SIZE_MAX, version);
+  close(proc_fd);
+
+  errno = 0;
+  ASSERT_EQ(-1, android_copy_fd(out.fd, -1, 1));
+  ASSERT_EQ(EBADF, errno);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(fcntl, vmsplice) {
   int pipe_fds[2];
   ASSERT_EQ(0, pipe(pipe_fds));
@@ -17,12 +17,21 @@
 #include <ftw.h>
 
 #include <pwd.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__BIONIC__)
+#include <android/ftw.h>
+#endif
+
 #include "TemporaryFile.h"
 
 #include <android-base/stringprintf.h>
@@ -153,3 +162,99 @@ TEST(ftw, bug_28197840) {
   ASSERT_EQ(0, nftw(root.dirname, bug_28197840_nftw<struct stat>, 128, FTW_PHYS));
   ASSERT_EQ(0, nftw64(root.dirname, bug_28197840_nftw<struct stat64>, 128, FTW_PHYS));
 }
+
+#if defined(__BIONIC__)
+static pthread_mutex_t g_walk_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<std::string> g_walk_entries;
+
+static int collect_nftw(const char* fpath, const struct stat* sb, int tflag, FTW* ftwbuf) {
+  sanity_check_nftw(fpath, sb, tflag, ftwbuf);
+  pthread_mutex_lock(&g_walk_lock);
+  g_walk_entries.push_back(android::base::StringPrintf("%s %d %d", fpath, tflag, ftwbuf->level));
+  pthread_mutex_unlock(&g_walk_lock);
+  return 0;
+}
+
+static std::vector<std::string> WalkEntries(const char* root, bool parallel, int flags) {
+  g_walk_entries.clear();
+  if (parallel) {
+    EXPECT_EQ(0, android_nftw_parallel(root, collect_nftw, flags));
+  } else {
+    EXPECT_EQ(0, nftw(root, collect_nftw, 128, flags));
+  }
+  std::sort(g_walk_entries.begin(), g_walk_entries.end());
+  return g_walk_entries;
+}
+#endif
+
+TEST(ftw, android_nftw_parallel) {
+#if defined(__BIONIC__)
+  TemporaryDir root;
+  MakeTree(root.dirname);
+  // Enough directories to keep several workers busy.
+  for (int i = 0; i < 20; ++i) {
+    std::string dir = android::base::StringPrintf("%s/dir/%d", root.dirname, i);
+    ASSERT_EQ(0, mkdir(dir.c_str(), 0755)) << dir;
+    for (int j = 0; j < 20; ++j) {
+      std::string file = android::base::StringPrintf("%s/%d", dir.c_str(), j);
+      int fd = open(file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0666);
+      ASSERT_NE(-1, fd) << file;
+      ASSERT_EQ(0, close(fd));
+    }
+  }
+
+  // The same entries as nftw, if not in the same order.
+  ASSERT_EQ(WalkEntries(root.dirname, false, 0), WalkEntries(root.dirname, true, 0));
+  ASSERT_EQ(WalkEntries(root.dirname, false, FTW_PHYS),
+            WalkEntries(root.dirname, true, FTW_PHYS));
+
+  ASSERT_EQ(-1, android_nftw_parallel(root.dirname, check_nftw, FTW_DEPTH));
+  ASSERT_EQ(EINVAL, errno);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+#if defined(__BIONIC__)
+static int check_nftw_nostat(const char* fpath, const struct stat* sb, int tflag, FTW*) {
+  if (strstr(fpath, "regular") != nullptr) {
+    EXPECT_EQ(FTW_F, tflag) << fpath;
+    EXPECT_TRUE(S_ISREG(sb->st_mode)) << fpath;
+    // Only the type is filled in, without a stat call.
+    EXPECT_EQ(0, sb->st_nlink) << fpath;
+  } else if (strstr(fpath, "dangler") != nullptr) {
+    EXPECT_EQ(FTW_SL, tflag) << fpath;
+    EXPECT_TRUE(S_ISLNK(sb->st_mode)) << fpath;
+  } else if (tflag == FTW_D) {
+    // Directories are always stat'ed.
+    EXPECT_TRUE(S_ISDIR(sb->st_mode)) << fpath;
+    EXPECT_NE(0U, sb->st_nlink) << fpath;
+  }
+  return 0;
+}
+
+static int stop_nftw(const char*, const struct stat*, int tflag, FTW*) {
+  return (tflag == FTW_F) ? 123 : 0;
+}
+#endif
+
+TEST(ftw, android_nftw_parallel_nostat) {
+#if defined(__BIONIC__)
+  TemporaryDir root;
+  MakeTree(root.dirname);
+  ASSERT_EQ(0, android_nftw_parallel(root.dirname, check_nftw_nostat,
+                                     FTW_PHYS | ANDROID_FTW_NOSTAT));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(ftw, android_nftw_parallel_stop) {
+#if defined(__BIONIC__)
+  TemporaryDir root;
+  MakeTree(root.dirname);
+  ASSERT_EQ(123, android_nftw_parallel(root.dirname, stop_nftw, FTW_PHYS));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
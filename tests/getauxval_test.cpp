@@ -15,10 +15,13 @@
  */
 
 #include <errno.h>
+#include <stdio.h>
 #include <sys/cdefs.h>
 #include <sys/utsname.h>
 #include <gtest/gtest.h>
 
+#include <set>
+
 // getauxval() was only added as of glibc version 2.16.
 // See: http://lwn.net/Articles/519085/
 // Don't try to compile this code on older glibc versions.
@@ -63,6 +66,33 @@ TEST(getauxval, unexpected_values) {
 #endif
 }
 
+TEST(getauxval, matches_proc_self_auxv) {
+#if defined(GETAUXVAL_CAN_COMPILE)
+  // Every type the kernel passed should give the value of its first entry.
+  FILE* fp = fopen("/proc/self/auxv", "re");
+  ASSERT_TRUE(fp != nullptr);
+  std::set<unsigned long> seen;
+  unsigned long entry[2];
+  while (fread(entry, sizeof(entry), 1, fp) == 1 && entry[0] != AT_NULL) {
+    if (!seen.insert(entry[0]).second) continue;
+    errno = 0;
+    ASSERT_EQ(entry[1], getauxval(entry[0])) << "type " << entry[0];
+    ASSERT_EQ(0, errno) << "type " << entry[0];
+  }
+  fclose(fp);
+
+  // Small types the kernel didn't pass aren't found either.
+  for (unsigned long type = 1; type < 128; ++type) {
+    if (seen.count(type) != 0) continue;
+    errno = 0;
+    ASSERT_EQ(0UL, getauxval(type)) << "type " << type;
+    ASSERT_EQ(ENOENT, errno) << "type " << type;
+  }
+#else
+  GTEST_LOG_(INFO) << "This test requires a C library with getauxval.\n";
+#endif
+}
+
 TEST(getauxval, arm_has_AT_HWCAP2) {
 #if defined(__arm__)
   // There are no known 32-bit processors that implement any of these instructions, so rather
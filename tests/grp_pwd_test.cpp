@@ -27,6 +27,7 @@
 #include <unistd.h>
 
 #include <bitset>
+#include <string>
 
 #include <private/android_filesystem_config.h>
 
@@ -226,6 +227,54 @@ TEST(pwd, getpwent_iterate) {
   ASSERT_TRUE(application);
 }
 
+TEST(pwd, getpwnam_r_getpwuid_r_android_ids) {
+#if defined(__BIONIC__)
+  // Every name resolves to its id, and every id to a name with that id. Where two
+  // names share an id, the id maps to the first of them.
+  for (size_t n = 0; n < android_id_count; ++n) {
+    passwd pwd_storage;
+    char buf[512];
+    passwd* pwd;
+    SCOPED_TRACE(android_ids[n].name);
+    ASSERT_EQ(0, getpwnam_r(android_ids[n].name, &pwd_storage, buf, sizeof(buf), &pwd));
+    ASSERT_TRUE(pwd != NULL);
+    ASSERT_EQ(android_ids[n].aid, pwd->pw_uid);
+
+    ASSERT_EQ(0, getpwuid_r(android_ids[n].aid, &pwd_storage, buf, sizeof(buf), &pwd));
+    ASSERT_TRUE(pwd != NULL);
+    size_t first = 0;
+    while (android_ids[first].aid != android_ids[n].aid) ++first;
+    ASSERT_STREQ(android_ids[first].name, pwd->pw_name);
+
+    std::string other_user = std::string("u1_") + android_ids[n].name;
+    ASSERT_EQ(0, getpwnam_r(other_user.c_str(), &pwd_storage, buf, sizeof(buf), &pwd));
+    ASSERT_TRUE(pwd != NULL);
+    ASSERT_EQ(AID_USER_OFFSET + android_ids[n].aid, pwd->pw_uid);
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(pwd, getpwnam_r_reentrancy) {
+#if defined(__BIONIC__)
+  passwd pwd_storage;
+  char buf[512];
+  passwd* pwd_r;
+  passwd* pwd = getpwnam("system");
+  ASSERT_EQ(0, getpwnam_r("u0_a1234", &pwd_storage, buf, sizeof(buf), &pwd_r));
+  check_passwd(pwd_r, "u0_a1234", 11234, TYPE_APP);
+  // The _r lookup doesn't use getpwnam's buffer.
+  check_passwd(pwd, "system", 1000, TYPE_SYSTEM);
+
+  ASSERT_EQ(ERANGE, getpwnam_r("u0_a1234", &pwd_storage, buf, 8, &pwd_r));
+  ASSERT_EQ(0, getpwnam_r("no such user", &pwd_storage, buf, sizeof(buf), &pwd_r));
+  ASSERT_TRUE(pwd_r == NULL);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 static void check_group(const group* grp, const char* group_name, gid_t gid) {
   ASSERT_TRUE(grp != NULL);
   ASSERT_STREQ(group_name, grp->gr_name);
@@ -270,6 +270,36 @@ TEST(ifaddrs, inet6_scope_ids) {
   freeifaddrs(addrs);
 }
 
+TEST(ifaddrs, getifaddrs_repeated) {
+  // Repeated calls may be answered from a cache, but each caller still gets
+  // its own list, and nothing should change between them.
+  ifaddrs* first;
+  ASSERT_EQ(0, getifaddrs(&first));
+  ifaddrs* second;
+  ASSERT_EQ(0, getifaddrs(&second));
+  ASSERT_NE(first, second);
+
+  ifaddrs* a = first;
+  ifaddrs* b = second;
+  for (; a != nullptr && b != nullptr; a = a->ifa_next, b = b->ifa_next) {
+    ASSERT_STREQ(a->ifa_name, b->ifa_name);
+    ASSERT_NE(a->ifa_name, b->ifa_name);
+    ASSERT_EQ(a->ifa_flags, b->ifa_flags);
+    ASSERT_EQ(a->ifa_addr == nullptr, b->ifa_addr == nullptr);
+    if (a->ifa_addr != nullptr) {
+      ASSERT_EQ(a->ifa_addr->sa_family, b->ifa_addr->sa_family);
+    }
+  }
+  ASSERT_TRUE(a == nullptr && b == nullptr);
+
+  // Freeing one mustn't affect the other.
+  freeifaddrs(first);
+  for (ifaddrs* ifa = second; ifa != nullptr; ifa = ifa->ifa_next) {
+    ASSERT_TRUE(ifa->ifa_name != nullptr);
+  }
+  freeifaddrs(second);
+}
+
 TEST(ifaddrs, kernel_bug_31038971) {
   // Some kernels had a bug that would lead to an NLMSG_ERROR response,
   // but bionic wasn't setting errno based on the value in the message.
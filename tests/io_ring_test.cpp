@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "TemporaryFile.h"
+
+#if defined(__BIONIC__)
+#include <android/io_ring.h>
+#endif
+
+TEST(io_ring, write_sync_read) {
+#if defined(__BIONIC__)
+  android_io_ring* ring = android_io_ring_create(8);
+  ASSERT_TRUE(ring != nullptr);
+  TemporaryFile tf;
+
+  // More writes than fit in the ring at once.
+  constexpr size_t kBlocks = 64;
+  constexpr size_t kBlockSize = 16;
+  char blocks[kBlocks][kBlockSize];
+  android_io_op ops[kBlocks];
+  for (size_t i = 0; i < kBlocks; ++i) {
+    memset(blocks[i], 'a' + (i % 26), kBlockSize);
+    ops[i] = { ANDROID_IO_WRITE, tf.fd, blocks[i], kBlockSize,
+               static_cast<off64_t>(i * kBlockSize), 0, i };
+  }
+  size_t submitted = 0;
+  size_t completed = 0;
+  bool seen[kBlocks] = {};
+  while (completed < kBlocks) {
+    if (submitted < kBlocks) {
+      ssize_t n = android_io_ring_submit(ring, ops + submitted, kBlocks - submitted);
+      ASSERT_GT(n, 0);
+      submitted += n;
+    }
+    android_io_completion completions[8];
+    ssize_t n = android_io_ring_wait(ring, completions, 8, 1);
+    ASSERT_GT(n, 0);
+    for (ssize_t i = 0; i < n; ++i) {
+      ASSERT_LT(completions[i].user_data, kBlocks);
+      ASSERT_FALSE(seen[completions[i].user_data]);
+      seen[completions[i].user_data] = true;
+      ASSERT_EQ(static_cast<int>(kBlockSize), completions[i].result);
+    }
+    completed += n;
+  }
+
+  android_io_op fsync_op = { ANDROID_IO_FDATASYNC, tf.fd, nullptr, 0, 0, 0, 123 };
+  ASSERT_EQ(1, android_io_ring_submit(ring, &fsync_op, 1));
+  android_io_completion completion;
+  ASSERT_EQ(1, android_io_ring_wait(ring, &completion, 1, 1));
+  ASSERT_EQ(123U, completion.user_data);
+  ASSERT_EQ(0, completion.result);
+
+  char buf[kBlocks * kBlockSize];
+  android_io_op read_op = { ANDROID_IO_READ, tf.fd, buf, sizeof(buf), 0, 0, 456 };
+  ASSERT_EQ(1, android_io_ring_submit(ring, &read_op, 1));
+  ASSERT_EQ(1, android_io_ring_wait(ring, &completion, 1, 1));
+  ASSERT_EQ(456U, completion.user_data);
+  ASSERT_EQ(static_cast<int>(sizeof(buf)), completion.result);
+  ASSERT_EQ(0, memcmp(blocks, buf, sizeof(buf)));
+
+  // Nothing is in flight, so this doesn't block.
+  ASSERT_EQ(0, android_io_ring_wait(ring, &completion, 1, 1));
+
+  android_io_ring_destroy(ring);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}
+
+TEST(io_ring, poll) {
+#if defined(__BIONIC__)
+  android_io_ring* ring = android_io_ring_create(4);
+  ASSERT_TRUE(ring != nullptr);
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  android_io_op poll_op = { ANDROID_IO_POLL, fds[0], nullptr, 0, 0, POLLIN, 1 };
+  ASSERT_EQ(1, android_io_ring_submit(ring, &poll_op, 1));
+  android_io_completion completion;
+  ASSERT_EQ(0, android_io_ring_wait(ring, &completion, 1, 0));
+
+  ASSERT_EQ(1, write(fds[1], "x", 1));
+  ASSERT_EQ(1, android_io_ring_wait(ring, &completion, 1, 1));
+  ASSERT_EQ(1U, completion.user_data);
+  ASSERT_TRUE((completion.result & POLLIN) != 0);
+
+  close(fds[0]);
+  close(fds[1]);
+  android_io_ring_destroy(ring);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}
+
+TEST(io_ring, errors) {
+#if defined(__BIONIC__)
+  errno = 0;
+  ASSERT_TRUE(android_io_ring_create(0) == nullptr);
+  ASSERT_EQ(EINVAL, errno);
+
+  android_io_ring* ring = android_io_ring_create(1);
+  ASSERT_TRUE(ring != nullptr);
+
+  android_io_op bad_opcode = { 1234, 0, nullptr, 0, 0, 0, 0 };
+  errno = 0;
+  ASSERT_EQ(-1, android_io_ring_submit(ring, &bad_opcode, 1));
+  ASSERT_EQ(EINVAL, errno);
+
+  // A failed operation completes with -errno.
+  char buf[16];
+  android_io_op bad_fd[2] = {
+    { ANDROID_IO_READ, -1, buf, sizeof(buf), 0, 0, 1 },
+    { ANDROID_IO_READ, -1, buf, sizeof(buf), 0, 0, 2 },
+  };
+  ASSERT_EQ(1, android_io_ring_submit(ring, bad_fd, 2));
+
+  // The ring is full until the completion is reaped.
+  errno = 0;
+  ASSERT_EQ(-1, android_io_ring_submit(ring, &bad_fd[1], 1));
+  ASSERT_EQ(EBUSY, errno);
+
+  android_io_completion completion;
+  ASSERT_EQ(1, android_io_ring_wait(ring, &completion, 1, 1));
+  ASSERT_EQ(1U, completion.user_data);
+  ASSERT_EQ(-EBADF, completion.result);
+
+  android_io_ring_destroy(ring);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}
@@ -188,3 +188,24 @@ TEST(libc_logging, buffer_overrun) {
   GTEST_LOG_(INFO) << "This test does nothing.\n";
 #endif // __BIONIC__
 }
+
+TEST(libc_logging, log_socket_reused) {
+#if defined(__BIONIC__)
+  __libc_format_log(ANDROID_LOG_INFO, "libc_logging_test", "first");
+  int fd = atomic_load(&g_log_fd);
+  if (fd == -1) {
+    GTEST_LOG_(INFO) << "This test requires logd.\n";
+    return;
+  }
+  __libc_format_log(ANDROID_LOG_INFO, "libc_logging_test", "second");
+  ASSERT_EQ(fd, atomic_load(&g_log_fd));
+
+  // If the fd is closed behind libc's back, the next message reconnects.
+  close(fd);
+  ASSERT_FALSE(__libc_is_log_socket(fd));
+  __libc_format_log(ANDROID_LOG_INFO, "libc_logging_test", "third");
+  ASSERT_TRUE(__libc_is_log_socket(atomic_load(&g_log_fd)));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__BIONIC__)
+#include <android/libc_stats.h>
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h>
+#endif
+
+TEST(libc_stats, malloc_and_free) {
+#if defined(__BIONIC__)
+  android_libc_stats before;
+  ASSERT_EQ(sizeof(before), android_libc_get_stats(&before, sizeof(before)));
+  void* volatile p = malloc(32);
+  ASSERT_TRUE(p != nullptr);
+  free(p);
+  android_libc_stats after;
+  android_libc_get_stats(&after, sizeof(after));
+  ASSERT_GT(after.malloc_calls, before.malloc_calls);
+  ASSERT_GT(after.free_calls, before.free_calls);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(libc_stats, stdio_flushes) {
+#if defined(__BIONIC__)
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+  android_libc_stats before;
+  android_libc_get_stats(&before, sizeof(before));
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+  ASSERT_EQ(0, fflush(fp));
+  android_libc_stats after;
+  android_libc_get_stats(&after, sizeof(after));
+  ASSERT_GT(after.stdio_flushes, before.stdio_flushes);
+  fclose(fp);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(libc_stats, property_lookups) {
+#if defined(__BIONIC__)
+  android_libc_stats before;
+  android_libc_get_stats(&before, sizeof(before));
+  __system_property_find("libc_stats.test.property");
+  android_libc_stats after;
+  android_libc_get_stats(&after, sizeof(after));
+  ASSERT_GT(after.property_lookups, before.property_lookups);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(libc_stats, dlopen_and_dlsym) {
+#if defined(__BIONIC__)
+  android_libc_stats before;
+  android_libc_get_stats(&before, sizeof(before));
+  void* handle = dlopen("libc.so", RTLD_NOW);
+  ASSERT_TRUE(handle != nullptr) << dlerror();
+  ASSERT_TRUE(dlsym(handle, "strlen") != nullptr) << dlerror();
+  android_libc_stats after;
+  android_libc_get_stats(&after, sizeof(after));
+  ASSERT_GT(after.dlopen_calls, before.dlopen_calls);
+  ASSERT_GT(after.dlsym_calls, before.dlsym_calls);
+  // Timing was turned on by the first call above.
+  ASSERT_GT(after.dlopen_time_ns, before.dlopen_time_ns);
+  dlclose(handle);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(libc_stats, partial_size) {
+#if defined(__BIONIC__)
+  // Callers built against an older, smaller struct only get what they asked for.
+  android_libc_stats stats;
+  memset(&stats, 0xff, sizeof(stats));
+  size_t size = sizeof(stats.mutex_contentions);
+  ASSERT_EQ(sizeof(stats), android_libc_get_stats(&stats, size));
+  ASSERT_NE(UINT64_MAX, stats.mutex_contentions);
+  ASSERT_EQ(UINT64_MAX, stats.futex_waits);
+  ASSERT_EQ(UINT64_MAX, stats.property_lookups);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
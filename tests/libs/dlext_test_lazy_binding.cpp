@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+extern "C" bool dlopen_testlib_simple_func();
+
+// Not defined anywhere: loading this library only works if calls to it
+// aren't bound until they're made.
+extern "C" int lazy_binding_undefined_func();
+
+extern "C" bool lazy_binding_call_defined() {
+  return dlopen_testlib_simple_func();
+}
+
+extern "C" int lazy_binding_call_undefined() {
+  return lazy_binding_undefined_func();
+}
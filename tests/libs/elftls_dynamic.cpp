@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Native (not emulated) TLS in a library that's dlopened, so its variables are
+// allocated on demand rather than in the static TLS block.
+__thread int elftls_dynamic_data = 42;
+__thread int elftls_dynamic_bss;
+
+extern "C" int* get_elftls_dynamic_data() {
+  return &elftls_dynamic_data;
+}
+
+extern "C" int bump_elftls_dynamic() {
+  elftls_dynamic_bss += 2;
+  return ++elftls_dynamic_data + elftls_dynamic_bss;
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A library using the initial-exec TLS model can't be dlopened after startup:
+// its variable would have to be in the static TLS block.
+__thread int elftls_dynamic_ie_var __attribute__((tls_model("initial-exec")));
+
+extern "C" int get_elftls_dynamic_ie_var() {
+  return elftls_dynamic_ie_var;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// One link of a chain of libraries, each needing the one before it, for the
+// benchmarks of loading a deep dependency tree.
+#define CHAIN_FUNCTION_(n) linker_benchmark_chain_##n
+#define CHAIN_FUNCTION(n) CHAIN_FUNCTION_(n)
+
+#if defined(CHAIN_PREVIOUS)
+extern "C" int CHAIN_FUNCTION(CHAIN_PREVIOUS)();
+
+extern "C" int CHAIN_FUNCTION(CHAIN_INDEX)() {
+  return CHAIN_FUNCTION(CHAIN_PREVIOUS)() + 1;
+}
+#else
+extern "C" int CHAIN_FUNCTION(CHAIN_INDEX)() {
+  return 0;
+}
+#endif
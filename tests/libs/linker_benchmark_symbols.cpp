@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Libraries with symbol tables of different sizes, for the dlsym and dladdr
+// benchmarks. All the functions are the same size so that dladdr has as many
+// candidates as possible to look through.
+#include "linker_benchmark_symbols.h"
+
+#define SYMBOL(n) extern "C" int linker_benchmark_symbol_##n() { return n; }
+
+LINKER_BENCHMARK_SYMBOLS
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// Defines LINKER_BENCHMARK_SYMBOLS as SYMBOL(n) for LINKER_BENCHMARK_SYMBOL_COUNT
+// distinct numbers n. The last one is LINKER_BENCHMARK_LAST_SYMBOL.
+#define LINKER_BENCHMARK_SYMBOLS_8(n) \
+    SYMBOL(n##0) SYMBOL(n##1) SYMBOL(n##2) SYMBOL(n##3) \
+    SYMBOL(n##4) SYMBOL(n##5) SYMBOL(n##6) SYMBOL(n##7)
+#define LINKER_BENCHMARK_SYMBOLS_64(n) \
+    LINKER_BENCHMARK_SYMBOLS_8(n##0) LINKER_BENCHMARK_SYMBOLS_8(n##1) \
+    LINKER_BENCHMARK_SYMBOLS_8(n##2) LINKER_BENCHMARK_SYMBOLS_8(n##3) \
+    LINKER_BENCHMARK_SYMBOLS_8(n##4) LINKER_BENCHMARK_SYMBOLS_8(n##5) \
+    LINKER_BENCHMARK_SYMBOLS_8(n##6) LINKER_BENCHMARK_SYMBOLS_8(n##7)
+#define LINKER_BENCHMARK_SYMBOLS_512(n) \
+    LINKER_BENCHMARK_SYMBOLS_64(n##0) LINKER_BENCHMARK_SYMBOLS_64(n##1) \
+    LINKER_BENCHMARK_SYMBOLS_64(n##2) LINKER_BENCHMARK_SYMBOLS_64(n##3) \
+    LINKER_BENCHMARK_SYMBOLS_64(n##4) LINKER_BENCHMARK_SYMBOLS_64(n##5) \
+    LINKER_BENCHMARK_SYMBOLS_64(n##6) LINKER_BENCHMARK_SYMBOLS_64(n##7)
+
+#if LINKER_BENCHMARK_SYMBOL_COUNT == 16
+#define LINKER_BENCHMARK_SYMBOLS \
+    LINKER_BENCHMARK_SYMBOLS_8(1) LINKER_BENCHMARK_SYMBOLS_8(2)
+#define LINKER_BENCHMARK_LAST_SYMBOL 27
+#elif LINKER_BENCHMARK_SYMBOL_COUNT == 256
+#define LINKER_BENCHMARK_SYMBOLS \
+    LINKER_BENCHMARK_SYMBOLS_64(1) LINKER_BENCHMARK_SYMBOLS_64(2) \
+    LINKER_BENCHMARK_SYMBOLS_64(3) LINKER_BENCHMARK_SYMBOLS_64(4)
+#define LINKER_BENCHMARK_LAST_SYMBOL 477
+#elif LINKER_BENCHMARK_SYMBOL_COUNT == 4096
+#define LINKER_BENCHMARK_SYMBOLS \
+    LINKER_BENCHMARK_SYMBOLS_512(1) LINKER_BENCHMARK_SYMBOLS_512(2) \
+    LINKER_BENCHMARK_SYMBOLS_512(3) LINKER_BENCHMARK_SYMBOLS_512(4) \
+    LINKER_BENCHMARK_SYMBOLS_512(5) LINKER_BENCHMARK_SYMBOLS_512(6) \
+    LINKER_BENCHMARK_SYMBOLS_512(7) LINKER_BENCHMARK_SYMBOLS_512(8)
+#define LINKER_BENCHMARK_LAST_SYMBOL 8777
+#else
+#error "LINKER_BENCHMARK_SYMBOL_COUNT must be 16, 256 or 4096"
+#endif
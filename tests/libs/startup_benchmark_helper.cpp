@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android/startup_trace.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+// An executable for benchmarks/startup_benchmark.cpp to start: it writes
+// the startup phases out and exits. CHAIN_FUNCTION, if defined, is the
+// function in the library of the linker benchmark chain it needs.
+#if defined(CHAIN_FUNCTION)
+extern "C" int CHAIN_FUNCTION();
+#endif
+
+int main() {
+#if defined(CHAIN_FUNCTION)
+  if (CHAIN_FUNCTION() < 0) return 1;
+#endif
+  android_startup_phase phases[64];
+  size_t count = android_get_startup_phases(phases, 64);
+  if (count > 64) count = 64;
+  for (size_t i = 0; i < count; ++i) {
+    printf("%s %" PRId64 "\n", phases[i].name, phases[i].time_ns);
+  }
+  return 0;
+}
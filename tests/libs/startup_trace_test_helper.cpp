@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2012 The Android Open Source Project
+ * Copyright (C) 2017 The Android Open Source Project
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,23 +14,18 @@
  * limitations under the License.
  */
 
-#define _SEARCH_PRIVATE
-#include <search.h>
-#include <stdlib.h>
+#include <android/startup_trace.h>
+#include <stdio.h>
 
-// Destroy a tree and free all allocated resources.
-// This is a GNU extension, not available from BSD.
-void tdestroy(void* root, void (*destroy_func)(void*)) {
-  node_t* root_node = reinterpret_cast<node_t*>(root);
-  if (root_node == NULL) {
-    return;
-  }
-  if (root_node->llink) {
-    tdestroy(root_node->llink, destroy_func);
-  }
-  if (root_node->rlink) {
-    tdestroy(root_node->rlink, destroy_func);
+#include "libs_utils.h"
+
+int main() {
+  android_startup_phase phases[64];
+  size_t count = android_get_startup_phases(phases, 64);
+  CHECK(count <= 64);
+  for (size_t i = 0; i < count; ++i) {
+    if (i > 0) CHECK(phases[i].time_ns >= phases[i - 1].time_ns);
+    printf("%s\n", phases[i].name);
   }
-  (*destroy_func)(root_node->key);
-  free(root);
+  return 0;
 }
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Enough exported symbols for the linker to build a bloom filter for the
+// SysV hash table of this library.
+#define SYMBOL(n) extern "C" int sysv_hash_symbol_##n() { return n; }
+#define SYMBOLS_8(n) SYMBOL(n##0) SYMBOL(n##1) SYMBOL(n##2) SYMBOL(n##3) \
+                     SYMBOL(n##4) SYMBOL(n##5) SYMBOL(n##6) SYMBOL(n##7)
+
+SYMBOLS_8(1)
+SYMBOLS_8(2)
+SYMBOLS_8(3)
+SYMBOLS_8(4)
+SYMBOLS_8(5)
+SYMBOLS_8(6)
+SYMBOLS_8(7)
+SYMBOLS_8(8)
@@ -19,6 +19,9 @@
 #include <errno.h>
 #include <limits.h>
 #include <locale.h>
+#include <stdlib.h>
+
+#include <thread>
 
 TEST(locale, localeconv) {
   EXPECT_STREQ(".", localeconv()->decimal_point);
@@ -134,3 +137,34 @@ TEST(locale, mb_cur_max) {
   freelocale(cloc);
   freelocale(cloc_utf8);
 }
+
+TEST(locale, mb_cur_max_global_locale) {
+#if defined(__BIONIC__)
+  // A thread using the global locale sees changes to it, including one that
+  // has never called uselocale.
+  locale_t old_locale = uselocale(LC_GLOBAL_LOCALE);
+
+  ASSERT_STREQ("C", setlocale(LC_ALL, "C"));
+  ASSERT_EQ(1U, MB_CUR_MAX);
+  size_t other_thread_mb_cur_max = 0;
+  std::thread([&]() { other_thread_mb_cur_max = MB_CUR_MAX; }).join();
+  ASSERT_EQ(1U, other_thread_mb_cur_max);
+
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_ALL, "C.UTF-8"));
+  ASSERT_EQ(4U, MB_CUR_MAX);
+  std::thread([&]() { other_thread_mb_cur_max = MB_CUR_MAX; }).join();
+  ASSERT_EQ(4U, other_thread_mb_cur_max);
+
+  // A thread with a locale of its own doesn't.
+  locale_t cloc = newlocale(LC_ALL, "C", 0);
+  uselocale(cloc);
+  ASSERT_EQ(1U, MB_CUR_MAX);
+  uselocale(LC_GLOBAL_LOCALE);
+  ASSERT_EQ(4U, MB_CUR_MAX);
+
+  uselocale(old_locale);
+  freelocale(cloc);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
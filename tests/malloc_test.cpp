@@ -16,12 +16,17 @@
 
 #include <gtest/gtest.h>
 
+#include <errno.h>
 #include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <malloc.h>
 #include <unistd.h>
 
+#include <thread>
+#include <vector>
+
 #include <tinyxml2.h>
 
 #include "private/bionic_config.h"
@@ -354,6 +359,11 @@ TEST(malloc, malloc_info) {
               arena->FirstChildElement("allocated-huge")->QueryIntText(&val));
     ASSERT_EQ(tinyxml2::XML_SUCCESS,
               arena->FirstChildElement("allocated-bins")->QueryIntText(&val));
+    ASSERT_EQ(tinyxml2::XML_SUCCESS, arena->FirstChildElement("active")->QueryIntText(&val));
+    ASSERT_EQ(tinyxml2::XML_SUCCESS, arena->FirstChildElement("dirty")->QueryIntText(&val));
+    ASSERT_EQ(tinyxml2::XML_SUCCESS, arena->FirstChildElement("mapped")->QueryIntText(&val));
+    ASSERT_EQ(tinyxml2::XML_SUCCESS, arena->FirstChildElement("retained")->QueryIntText(&val));
+    ASSERT_EQ(tinyxml2::XML_SUCCESS, arena->FirstChildElement("huge-page")->QueryIntText(&val));
     ASSERT_EQ(tinyxml2::XML_SUCCESS,
               arena->FirstChildElement("bins-total")->QueryIntText(&val));
 
@@ -367,12 +377,54 @@ TEST(malloc, malloc_info) {
                   bin->FirstChildElement("nmalloc")->QueryIntText(&val));
         ASSERT_EQ(tinyxml2::XML_SUCCESS,
                   bin->FirstChildElement("ndalloc")->QueryIntText(&val));
+        ASSERT_EQ(tinyxml2::XML_SUCCESS, bin->FirstChildElement("size")->QueryIntText(&val));
+        ASSERT_EQ(tinyxml2::XML_SUCCESS, bin->FirstChildElement("regions")->QueryIntText(&val));
+        ASSERT_EQ(tinyxml2::XML_SUCCESS, bin->FirstChildElement("capacity")->QueryIntText(&val));
+        ASSERT_EQ(tinyxml2::XML_SUCCESS, bin->FirstChildElement("nfills")->QueryIntText(&val));
+        ASSERT_EQ(tinyxml2::XML_SUCCESS, bin->FirstChildElement("nflushes")->QueryIntText(&val));
       }
     }
   }
 #endif
 }
 
+TEST(malloc, malloc_stats) {
+#ifdef __BIONIC__
+  void* ptr = malloc(64);
+  ASSERT_TRUE(ptr != nullptr);
+
+  size_t narenas = malloc_stats_narenas();
+  ASSERT_NE(0U, narenas);
+  size_t nbins = malloc_stats_nbins();
+  ASSERT_NE(0U, nbins);
+
+  std::vector<malloc_bin_stats> bins(nbins);
+  size_t total_bins = 0;
+  for (size_t i = 0; i < narenas; i++) {
+    malloc_arena_stats arena;
+    ASSERT_EQ(0, malloc_stats_arena(i, &arena));
+    ASSERT_EQ(static_cast<int>(nbins), malloc_stats_bins(i, bins.data(), bins.size()));
+    for (const auto& bin : bins) {
+      ASSERT_NE(0U, bin.size);
+      ASSERT_LE(bin.regions, bin.capacity);
+      total_bins += bin.allocated;
+    }
+  }
+  ASSERT_NE(0U, total_bins);
+
+  errno = 0;
+  malloc_arena_stats arena;
+  ASSERT_EQ(-1, malloc_stats_arena(narenas, &arena));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(-1, malloc_stats_bins(narenas, bins.data(), bins.size()));
+  ASSERT_EQ(EINVAL, errno);
+
+  free(ptr);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(malloc, calloc_usable_size) {
   for (size_t size = 1; size <= 2048; size++) {
     void* pointer = malloc(size);
@@ -507,3 +559,216 @@ TEST(malloc, mallopt_smoke) {
   // mallopt doesn't set errno.
   ASSERT_EQ(0, errno);
 }
+
+TEST(malloc, mallopt_purge) {
+#if defined(__BIONIC__)
+  void* ptr = malloc(1024 * 1024);
+  ASSERT_TRUE(ptr != nullptr);
+  free(ptr);
+  ASSERT_EQ(1, mallopt(M_PURGE, 0));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, malloc_purge) {
+#if defined(__BIONIC__)
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < 64; i++) {
+    ptrs.push_back(malloc(64 * 1024));
+    memset(ptrs.back(), 1, 64 * 1024);
+  }
+  for (void* ptr : ptrs) {
+    free(ptr);
+  }
+  malloc_purge();
+  // Nothing's been freed since, so there's nothing left to release.
+  ASSERT_EQ(0U, malloc_purge());
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, mallopt_purge_on_memory_pressure) {
+#if defined(__BIONIC__)
+  ASSERT_EQ(0, mallopt(M_PURGE_ON_MEMORY_PRESSURE, -1));
+  if (access("/proc/pressure/memory", R_OK | W_OK) != 0) {
+    GTEST_LOG_(INFO) << "This kernel doesn't support pressure stall information.\n";
+    return;
+  }
+  ASSERT_EQ(1, mallopt(M_PURGE_ON_MEMORY_PRESSURE, 150));
+  ASSERT_EQ(1, mallopt(M_PURGE_ON_MEMORY_PRESSURE, 500));
+  ASSERT_EQ(1, mallopt(M_PURGE_ON_MEMORY_PRESSURE, 0));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, mallopt_huge_pages) {
+#if defined(__BIONIC__)
+  ASSERT_EQ(0, mallopt(M_HUGE_PAGE_THRESHOLD, -1));
+  ASSERT_EQ(0, mallopt(M_HUGE_PAGE_THRESHOLD, 4096));
+  ASSERT_EQ(0, mallopt(M_HUGE_PAGE_LIMIT, -1));
+  ASSERT_EQ(0, mallopt(M_HUGE_PAGE_ARENA, INT_MAX));
+
+  auto huge_page_bytes = []() {
+    size_t total = 0;
+    size_t narenas = malloc_stats_narenas();
+    for (size_t i = 0; i < narenas; i++) {
+      malloc_arena_stats arena;
+      EXPECT_EQ(0, malloc_stats_arena(i, &arena));
+      total += arena.huge_page;
+    }
+    return total;
+  };
+
+  ASSERT_EQ(1, mallopt(M_HUGE_PAGE_THRESHOLD, 2 * 1024 * 1024));
+  size_t before = huge_page_bytes();
+  void* ptr = malloc(8 * 1024 * 1024);
+  ASSERT_TRUE(ptr != nullptr);
+  if (access("/sys/kernel/mm/transparent_hugepage", F_OK) == 0) {
+    ASSERT_GE(huge_page_bytes(), before + 8 * 1024 * 1024);
+  }
+  free(ptr);
+  ASSERT_EQ(1, mallopt(M_HUGE_PAGE_THRESHOLD, 0));
+
+  // Nothing more is advised once the limit is reached.
+  ASSERT_EQ(1, mallopt(M_HUGE_PAGE_LIMIT, 0));
+  ASSERT_EQ(1, mallopt(M_HUGE_PAGE_THRESHOLD, 2 * 1024 * 1024));
+  before = huge_page_bytes();
+  ptr = malloc(8 * 1024 * 1024);
+  ASSERT_TRUE(ptr != nullptr);
+  ASSERT_LE(huge_page_bytes(), before);
+  free(ptr);
+  ASSERT_EQ(1, mallopt(M_HUGE_PAGE_THRESHOLD, 0));
+  ASSERT_EQ(1, mallopt(M_HUGE_PAGE_LIMIT, INT_MAX));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, mallopt_thread_arena) {
+#if defined(__BIONIC__)
+  std::thread thread([]() {
+    ASSERT_EQ(1, mallopt(M_THREAD_ARENA, -1));
+    void* ptr = malloc(128);
+    ASSERT_TRUE(ptr != nullptr);
+    free(ptr);
+    ASSERT_EQ(1, mallopt(M_THREAD_ARENA, 0));
+    ASSERT_EQ(0, mallopt(M_THREAD_ARENA, INT_MAX));
+  });
+  thread.join();
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, mallopt_thread_arena_node) {
+#if defined(__BIONIC__)
+  auto bind = []() {
+    ASSERT_EQ(1, mallopt(M_THREAD_ARENA_NODE, -1));
+    void* ptr = malloc(128);
+    ASSERT_TRUE(ptr != nullptr);
+    free(ptr);
+  };
+  // The second thread reuses the arena the first created for its node.
+  std::thread thread1(bind);
+  thread1.join();
+  std::thread thread2(bind);
+  thread2.join();
+  std::thread thread3([]() {
+    ASSERT_EQ(1, mallopt(M_THREAD_ARENA_NODE, 0));
+    ASSERT_EQ(0, mallopt(M_THREAD_ARENA_NODE, INT_MAX));
+  });
+  thread3.join();
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, mallopt_thread_cache) {
+#if defined(__BIONIC__)
+  std::thread thread([]() {
+    void* ptr = malloc(64);
+    ASSERT_TRUE(ptr != nullptr);
+    free(ptr);
+    ASSERT_EQ(1, mallopt(M_THREAD_CACHE_FLUSH, 0));
+    ASSERT_EQ(1, mallopt(M_THREAD_CACHE, 0));
+    ptr = malloc(64);
+    ASSERT_TRUE(ptr != nullptr);
+    free(ptr);
+    ASSERT_EQ(1, mallopt(M_THREAD_CACHE, 1));
+  });
+  thread.join();
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+#if defined(__BIONIC__)
+extern "C" int malloc_iterate_snapshot(uintptr_t base, size_t size,
+    void (*callback)(uintptr_t base, size_t size, void* arg), void* arg);
+#endif
+
+TEST(malloc, malloc_iterate_snapshot) {
+#if defined(__BIONIC__)
+  struct Found {
+    uintptr_t pointer;
+    bool found;
+  };
+  void* pointer = malloc(64);
+  ASSERT_TRUE(pointer != nullptr);
+  Found found = { reinterpret_cast<uintptr_t>(pointer), false };
+
+  // Walk the 64MiB around the allocation, which covers the chunk it's in.
+  uintptr_t base = found.pointer & ~((static_cast<uintptr_t>(1) << 26) - 1);
+  ASSERT_EQ(0, malloc_iterate_snapshot(base, 1 << 26,
+      [](uintptr_t base, size_t size, void* arg) {
+        Found* found = reinterpret_cast<Found*>(arg);
+        if (found->pointer >= base && found->pointer < base + size) {
+          found->found = true;
+        }
+        // The rest of the process isn't stopped, so it's fine to allocate.
+        free(malloc(32));
+      }, &found));
+  ASSERT_TRUE(found.found);
+  free(pointer);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+// The pointer tagging allocator is chosen at startup, so this only checks
+// anything when the tests are run with LIBC_MALLOC_POINTER_TAG=1.
+TEST(malloc, pointer_tag) {
+#if defined(__BIONIC__) && defined(__aarch64__)
+  const char* env = getenv("LIBC_MALLOC_POINTER_TAG");
+  if (env == nullptr || strcmp(env, "1") != 0) {
+    GTEST_LOG_(INFO) << "This test requires LIBC_MALLOC_POINTER_TAG=1.\n";
+    return;
+  }
+
+  char* ptr = reinterpret_cast<char*>(malloc(100));
+  ASSERT_TRUE(ptr != nullptr);
+  ASSERT_NE(0U, reinterpret_cast<uintptr_t>(ptr) >> 56);
+  ASSERT_LE(100U, malloc_usable_size(ptr));
+  memset(ptr, 0xaa, malloc_usable_size(ptr));
+
+  // Tagged pointers can be passed to system calls.
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(100, write(fds[1], ptr, 100));
+  ASSERT_EQ(100, read(fds[0], ptr, 100));
+  close(fds[0]);
+  close(fds[1]);
+
+  ptr = reinterpret_cast<char*>(realloc(ptr, 100000));
+  ASSERT_TRUE(ptr != nullptr);
+  ASSERT_EQ('\xaa', ptr[99]);
+  free(ptr);
+
+  ASSERT_DEATH(free(ptr), "pointer tag mismatch");
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
@@ -1870,6 +1870,43 @@ TEST(math, sincosf_intel) {
   DoMathDataTest<1>(g_sincosf_intel_data, sincosf);
 }
 
+TEST(math, sincos_matches_sin_cos) {
+  // sincos shares one argument reduction between its results, but should
+  // still give exactly what sin and cos give, including in every quadrant.
+  for (double x = -1000.0; x < 1000.0; x += 0.0123) {
+    double s, c;
+    sincos(x, &s, &c);
+    ASSERT_EQ(sin(x), s) << x;
+    ASSERT_EQ(cos(x), c) << x;
+  }
+  double s, c;
+  sincos(1e300, &s, &c);
+  ASSERT_EQ(sin(1e300), s);
+  ASSERT_EQ(cos(1e300), c);
+}
+
+TEST(math, sincosf_matches_sinf_cosf) {
+  for (float x = -1000.0f; x < 1000.0f; x += 0.0123f) {
+    float s, c;
+    sincosf(x, &s, &c);
+    ASSERT_EQ(sinf(x), s) << x;
+    ASSERT_EQ(cosf(x), c) << x;
+  }
+  float s, c;
+  sincosf(1e30f, &s, &c);
+  ASSERT_EQ(sinf(1e30f), s);
+  ASSERT_EQ(cosf(1e30f), c);
+}
+
+TEST(math, sincosl_matches_sinl_cosl) {
+  for (long double x = -1000.0L; x < 1000.0L; x += 0.0123L) {
+    long double s, c;
+    sincosl(x, &s, &c);
+    ASSERT_EQ(sinl(x), s) << static_cast<double>(x);
+    ASSERT_EQ(cosl(x), c) << static_cast<double>(x);
+  }
+}
+
 #include "math_data/sqrt_intel_data.h"
 TEST(math, sqrt_intel) {
   DoMathDataTest<1>(g_sqrt_intel_data, sqrt);
@@ -1909,3 +1946,134 @@ TEST(math, trunc_intel) {
 TEST(math, truncf_intel) {
   DoMathDataTest<1>(g_truncf_intel_data, truncf);
 }
+
+#if defined(__BIONIC__) && \
+    (defined(__x86_64__) || (defined(__aarch64__) && __has_attribute(aarch64_vector_pcs)))
+#define HAVE_VECTOR_MATH
+typedef float vector_float __attribute__((__vector_size__(16)));
+typedef double vector_double __attribute__((__vector_size__(16)));
+
+#if defined(__x86_64__)
+#define VECTOR_ATTRS
+#define VECTOR_FN(name, n) _ZGVbN ## n ## v_ ## name
+#else
+#define VECTOR_ATTRS __attribute__((aarch64_vector_pcs))
+#define VECTOR_FN(name, n) _ZGVnN ## n ## v_ ## name
+#endif
+
+// Wraps a vector variant as a scalar function for DoMathDataTest. The input
+// goes in the first lane, and NaN in the others, which the vector code passes
+// to the scalar function.
+#define VECTOR_MATH_WRAPPER(name, T, V, n) \
+  extern "C" VECTOR_ATTRS V VECTOR_FN(name, n)(V); \
+  static T vector_ ## name(T x) { \
+    V v = V{} + static_cast<T>(NAN); \
+    v[0] = x; \
+    V result = VECTOR_FN(name, n)(v); \
+    for (size_t i = 1; i < n; ++i) EXPECT_TRUE(isnan(result[i])); \
+    return result[0]; \
+  }
+
+VECTOR_MATH_WRAPPER(sinf, float, vector_float, 4)
+VECTOR_MATH_WRAPPER(cosf, float, vector_float, 4)
+VECTOR_MATH_WRAPPER(expf, float, vector_float, 4)
+VECTOR_MATH_WRAPPER(logf, float, vector_float, 4)
+VECTOR_MATH_WRAPPER(sin, double, vector_double, 2)
+VECTOR_MATH_WRAPPER(cos, double, vector_double, 2)
+VECTOR_MATH_WRAPPER(exp, double, vector_double, 2)
+VECTOR_MATH_WRAPPER(log, double, vector_double, 2)
+#endif
+
+TEST(math, vector_sin_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<2>(g_sin_intel_data, vector_sin);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_sinf_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<4>(g_sinf_intel_data, vector_sinf);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_cos_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<2>(g_cos_intel_data, vector_cos);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_cosf_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<4>(g_cosf_intel_data, vector_cosf);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_exp_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<2>(g_exp_intel_data, vector_exp);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_expf_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<4>(g_expf_intel_data, vector_expf);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_log_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<2>(g_log_intel_data, vector_log);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_logf_intel) {
+#if defined(HAVE_VECTOR_MATH)
+  DoMathDataTest<4>(g_logf_intel_data, vector_logf);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_sinf_sweep) {
+#if defined(HAVE_VECTOR_MATH)
+  // Every lane takes the vector path here, unlike in the tests above.
+  FpUlpEq<4, float> predicate;
+  for (float x = -4000.0f; x < 4000.0f; x += 0.37f) {
+    vector_float v = { x, x + 0.1f, x + 0.2f, x + 0.3f };
+    vector_float result = VECTOR_FN(sinf, 4)(v);
+    for (size_t i = 0; i < 4; ++i) {
+      EXPECT_PRED_FORMAT2(predicate, static_cast<float>(sin(v[i])), result[i]) << v[i];
+    }
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(math, vector_exp_sweep) {
+#if defined(HAVE_VECTOR_MATH)
+  FpUlpEq<2, double> predicate;
+  for (double x = -700.0; x < 700.0; x += 0.0123) {
+    vector_double v = { x, -x };
+    vector_double result = VECTOR_FN(exp, 2)(v);
+    EXPECT_PRED_FORMAT2(predicate, exp(v[0]), result[0]) << v[0];
+    EXPECT_PRED_FORMAT2(predicate, exp(v[1]), result[1]) << v[1];
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
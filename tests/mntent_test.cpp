@@ -17,6 +17,18 @@
 #include <gtest/gtest.h>
 
 #include <mntent.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BIONIC__)
+#include <android/mount_table.h>
+#endif
+
+#include "TemporaryFile.h"
+#include "utils.h"
 
 TEST(mntent, mntent_smoke) {
   FILE* fp = setmntent("/proc/mounts", "r");
@@ -55,3 +67,80 @@ TEST(mntent, hasmntopt) {
   EXPECT_EQ(nullptr, hasmntopt(&ent, "d"));
   EXPECT_EQ(nullptr, hasmntopt(&ent, "e"));
 }
+
+TEST(mntent, android_mount_table) {
+#if defined(__BIONIC__)
+  android_mount_table* table = android_mount_table_open();
+  ASSERT_TRUE(table != nullptr);
+  ASSERT_NE(-1, android_mount_table_fd(table));
+
+  size_t count;
+  const android_mount_entry* entries = android_mount_table_entries(table, &count);
+  ASSERT_NE(0U, count);
+  const android_mount_entry* proc = nullptr;
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_EQ('/', entries[i].mount_point[0]);
+    if (strcmp(entries[i].mount_point, "/proc") == 0) proc = &entries[i];
+  }
+  ASSERT_TRUE(proc != nullptr);
+  ASSERT_STREQ("proc", proc->fs_type);
+  ASSERT_TRUE(strncmp(proc->mount_options, "rw", 2) == 0 || strncmp(proc->mount_options, "ro", 2) == 0);
+
+  // The mount a path is on is found by its longest mount point.
+  ASSERT_EQ(proc, android_mount_table_find(table, "/proc"));
+  ASSERT_EQ(proc, android_mount_table_find(table, "/proc/self/status"));
+  const android_mount_entry* root = android_mount_table_find(table, "/");
+  ASSERT_TRUE(root != nullptr);
+  ASSERT_STREQ("/", root->mount_point);
+  ASSERT_EQ(root, android_mount_table_find(table, "/procfs-lookalike"));
+
+  // The device numbers are the ones stat reports.
+  struct stat sb;
+  ASSERT_EQ(0, stat("/proc", &sb));
+  ASSERT_EQ(sb.st_dev, proc->dev);
+
+  // Nothing's changed, so there's nothing to reread.
+  ASSERT_EQ(0, android_mount_table_refresh(table));
+  ASSERT_EQ(entries, android_mount_table_entries(table, &count));
+
+  android_mount_table_close(table);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(mntent, android_mount_table_refresh) {
+#if defined(__BIONIC__)
+  if (geteuid() != 0) {
+    GTEST_LOG_(INFO) << "This test must be run as root.\n";
+    return;
+  }
+
+  TemporaryDir dir;
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    // Mount in a private namespace, so nothing else sees it.
+    if (unshare(CLONE_NEWNS) == -1 || mount(nullptr, "/", nullptr, MS_REC | MS_PRIVATE, nullptr) == -1) {
+      _exit(1);
+    }
+    android_mount_table* table = android_mount_table_open();
+    if (table == nullptr) _exit(2);
+    if (mount("bionic test", dir.dirname, "tmpfs", 0, "size=4k") == -1) _exit(3);
+    if (android_mount_table_refresh(table) != 1) _exit(4);
+    if (android_mount_table_refresh(table) != 0) _exit(5);
+
+    // The space in the source is escaped by the kernel.
+    const android_mount_entry* e = android_mount_table_find(table, dir.dirname);
+    if (e == nullptr || strcmp(e->mount_point, dir.dirname) != 0 ||
+        strcmp(e->fs_type, "tmpfs") != 0 || strcmp(e->source, "bionic test") != 0) {
+      _exit(6);
+    }
+    android_mount_table_close(table);
+    _exit(0);
+  }
+  AssertChildExited(pid, 0);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
@@ -19,6 +19,9 @@
 #include <gtest/gtest.h>
 
 #include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -319,3 +322,108 @@ TEST(netdb, getservbyname) {
   ASSERT_EQ(7, ntohs(s->s_port));
   ASSERT_STREQ("udp", s->s_proto);
 }
+
+TEST(netdb, android_getaddrinfo_start_numeric) {
+#if defined(__BIONIC__)
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  int fd = android_getaddrinfo_start("127.0.0.1", "9999", &hints);
+  ASSERT_NE(-1, fd);
+
+  // A numeric host needs no lookup, so the result is ready straight away.
+  pollfd pfd = { fd, POLLIN, 0 };
+  ASSERT_EQ(1, poll(&pfd, 1, 0));
+
+  addrinfo* ai = NULL;
+  ASSERT_EQ(0, android_getaddrinfo_result(fd, &ai));
+  ASSERT_TRUE(ai != NULL);
+  ASSERT_EQ(AF_INET, ai->ai_family);
+  sockaddr_in* sin = reinterpret_cast<sockaddr_in*>(ai->ai_addr);
+  ASSERT_EQ(htonl(INADDR_LOOPBACK), sin->sin_addr.s_addr);
+  ASSERT_EQ(9999, ntohs(sin->sin_port));
+  freeaddrinfo(ai);
+
+  // The fd was closed for us.
+  ASSERT_EQ(-1, fcntl(fd, F_GETFD));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(netdb, android_getaddrinfo_start_error) {
+#if defined(__BIONIC__)
+  int fd = android_getaddrinfo_start(NULL, NULL, NULL);
+  ASSERT_NE(-1, fd);
+  addrinfo* ai = NULL;
+  ASSERT_EQ(EAI_NONAME, android_getaddrinfo_result(fd, &ai));
+  ASSERT_TRUE(ai == NULL);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(netdb, android_getaddrinfo_cancel) {
+#if defined(__BIONIC__)
+  int fd = android_getaddrinfo_start("localhost", NULL, NULL);
+  ASSERT_NE(-1, fd);
+  android_getaddrinfo_cancel(fd);
+  ASSERT_EQ(-1, fcntl(fd, F_GETFD));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(netdb, getservbyport) {
+  servent* s = getservbyport(htons(25), "tcp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("smtp", s->s_name);
+  ASSERT_EQ(25, ntohs(s->s_port));
+  ASSERT_STREQ("tcp", s->s_proto);
+
+  // Port 512 is exec over tcp, but biff over udp.
+  s = getservbyport(htons(512), "udp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("biff", s->s_name);
+
+  ASSERT_TRUE(getservbyport(htons(1), "udp") == NULL);
+}
+
+TEST(netdb, getservbyname_r) {
+  servent se;
+  servent* result;
+  char buf[256];
+  ASSERT_EQ(0, getservbyname_r("kerberos", "udp", &se, buf, sizeof(buf), &result));
+  ASSERT_EQ(&se, result);
+  ASSERT_STREQ("kerberos", se.s_name);
+  ASSERT_EQ(88, ntohs(se.s_port));
+  ASSERT_STREQ("udp", se.s_proto);
+  ASSERT_STREQ("kerberos5", se.s_aliases[0]);
+  ASSERT_STREQ("krb5", se.s_aliases[1]);
+  ASSERT_STREQ("kerberos-sec", se.s_aliases[2]);
+  ASSERT_TRUE(se.s_aliases[3] == NULL);
+
+  // The buffer isn't necessarily aligned.
+  ASSERT_EQ(0, getservbyname_r("smtp", NULL, &se, buf + 1, sizeof(buf) - 1, &result));
+  ASSERT_EQ(25, ntohs(se.s_port));
+
+  ASSERT_EQ(ERANGE, getservbyname_r("kerberos", "udp", &se, buf, 8, &result));
+  ASSERT_TRUE(result == NULL);
+
+  getservbyname_r("no-such-service", NULL, &se, buf, sizeof(buf), &result);
+  ASSERT_TRUE(result == NULL);
+}
+
+TEST(netdb, getservbyport_r) {
+  servent se;
+  servent* result;
+  char buf[256];
+  ASSERT_EQ(0, getservbyport_r(htons(53), "udp", &se, buf, sizeof(buf), &result));
+  ASSERT_EQ(&se, result);
+  ASSERT_STREQ("domain", se.s_name);
+  ASSERT_STREQ("udp", se.s_proto);
+
+  ASSERT_EQ(ERANGE, getservbyport_r(htons(53), "udp", &se, buf, 4, &result));
+  ASSERT_TRUE(result == NULL);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <thread>
+
+#if defined(__BIONIC__)
+#include <numaif.h>
+#endif
+
+#if defined(__BIONIC__)
+// Kernels built without CONFIG_NUMA don't have these system calls.
+static bool HaveNuma() {
+  int mode;
+  if (get_mempolicy(&mode, nullptr, 0, nullptr, 0) == -1) {
+    EXPECT_EQ(ENOSYS, errno);
+    GTEST_LOG_(INFO) << "This kernel doesn't support NUMA.\n";
+    return false;
+  }
+  return true;
+}
+#endif
+
+TEST(numaif, set_mempolicy_get_mempolicy) {
+#if defined(__BIONIC__)
+  if (!HaveNuma()) return;
+  // The policy belongs to the thread, so don't change the test runner's.
+  std::thread thread([]() {
+    int mode = -1;
+    ASSERT_EQ(0, get_mempolicy(&mode, nullptr, 0, nullptr, 0));
+    ASSERT_EQ(MPOL_DEFAULT, mode);
+
+    unsigned long nodes = 1;
+    ASSERT_EQ(0, set_mempolicy(MPOL_PREFERRED, &nodes, sizeof(nodes) * 8));
+    nodes = 0;
+    ASSERT_EQ(0, get_mempolicy(&mode, &nodes, sizeof(nodes) * 8, nullptr, 0));
+    ASSERT_EQ(MPOL_PREFERRED, mode);
+    ASSERT_EQ(1UL, nodes);
+
+    ASSERT_EQ(0, set_mempolicy(MPOL_DEFAULT, nullptr, 0));
+    ASSERT_EQ(0, get_mempolicy(&mode, nullptr, 0, nullptr, 0));
+    ASSERT_EQ(MPOL_DEFAULT, mode);
+
+    errno = 0;
+    ASSERT_EQ(-1, set_mempolicy(-1, nullptr, 0));
+    ASSERT_EQ(EINVAL, errno);
+  });
+  thread.join();
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(numaif, mbind_move_pages) {
+#if defined(__BIONIC__)
+  if (!HaveNuma()) return;
+  size_t page_size = getpagesize();
+  void* map = mmap(nullptr, page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, map);
+
+  unsigned long nodes = 1;
+  ASSERT_EQ(0, mbind(map, page_size, MPOL_BIND, &nodes, sizeof(nodes) * 8, 0));
+  int mode = -1;
+  nodes = 0;
+  ASSERT_EQ(0, get_mempolicy(&mode, &nodes, sizeof(nodes) * 8, map, MPOL_F_ADDR));
+  ASSERT_EQ(MPOL_BIND, mode);
+  ASSERT_EQ(1UL, nodes);
+
+  // With no target nodes, move_pages reports where each page is.
+  *reinterpret_cast<char*>(map) = 1;
+  void* pages[] = { map };
+  int status = -1;
+  ASSERT_EQ(0, move_pages(0, 1, pages, nullptr, &status, 0));
+  ASSERT_EQ(0, status);
+
+  ASSERT_EQ(0, munmap(map, page_size));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
@@ -21,6 +21,7 @@
 #include <limits.h>
 #include <malloc.h>
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <sys/mman.h>
@@ -31,11 +32,16 @@
 #include <unwind.h>
 
 #include <atomic>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "private/bionic_constants.h"
 #include "private/bionic_macros.h"
 #include "private/ScopeGuard.h"
+#if defined(__BIONIC__)
+#include "private/bionic_tls.h"
+#endif
 #include "BionicDeathTest.h"
 #include "ScopedSignalHandler.h"
 #include "utils.h"
@@ -189,6 +195,113 @@ TEST(pthread, static_pthread_key_used_before_creation) {
 #endif
 }
 
+TEST(pthread, pthread_getspecific_unchecked) {
+#if defined(__BIONIC__)
+  void* expected = reinterpret_cast<void*>(1234);
+  pthread_key_t key;
+  ASSERT_EQ(0, pthread_key_create(&key, NULL));
+  ASSERT_EQ(nullptr, __pthread_getspecific_unchecked(key));
+  ASSERT_EQ(0, pthread_setspecific(key, expected));
+  ASSERT_EQ(expected, __pthread_getspecific_unchecked(key));
+
+  // Other threads have their own values.
+  void* result = expected;
+  std::thread t([&]() { result = __pthread_getspecific_unchecked(key); });
+  t.join();
+  ASSERT_EQ(nullptr, result);
+
+  // A new key in the same slot mustn't see the value left for the deleted key.
+  ASSERT_EQ(0, pthread_key_delete(key));
+  pthread_key_t new_key;
+  ASSERT_EQ(0, pthread_key_create(&new_key, NULL));
+  ASSERT_EQ(nullptr, __pthread_getspecific_unchecked(new_key));
+  ASSERT_EQ(0, pthread_key_delete(new_key));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic pthread key implementation detail.\n";
+#endif
+}
+
+static pthread_key_t g_resetting_key;
+static int g_resetting_key_destructor_calls;
+
+static void ResettingKeyDestructor(void*) {
+  // Keep setting the key again, which is allowed for PTHREAD_DESTRUCTOR_ITERATIONS rounds.
+  if (++g_resetting_key_destructor_calls < PTHREAD_DESTRUCTOR_ITERATIONS) {
+    pthread_setspecific(g_resetting_key, &g_resetting_key);
+  }
+}
+
+TEST(pthread, pthread_key_destructor_sets_key_again) {
+  // Use other keys first, so the one with the destructor isn't in the first slot.
+  std::vector<pthread_key_t> other_keys(40);
+  for (auto& key : other_keys) {
+    ASSERT_EQ(0, pthread_key_create(&key, NULL));
+  }
+  ASSERT_EQ(0, pthread_key_create(&g_resetting_key, ResettingKeyDestructor));
+  g_resetting_key_destructor_calls = 0;
+
+  std::thread t([]() {
+    pthread_setspecific(g_resetting_key, &g_resetting_key);
+  });
+  t.join();
+  ASSERT_EQ(PTHREAD_DESTRUCTOR_ITERATIONS, g_resetting_key_destructor_calls);
+
+  ASSERT_EQ(0, pthread_key_delete(g_resetting_key));
+  for (auto& key : other_keys) {
+    ASSERT_EQ(0, pthread_key_delete(key));
+  }
+}
+
+static std::atomic<int> g_key_destructor_calls;
+
+static void CountingKeyDestructor(void*) {
+  ++g_key_destructor_calls;
+}
+
+TEST(pthread, pthread_key_many_threads_many_keys) {
+  // Most threads only use the first few key slots, so make sure the later ones work too,
+  // including after a thread that used them has exited.
+  std::vector<pthread_key_t> keys(100);
+  for (auto& key : keys) {
+    ASSERT_EQ(0, pthread_key_create(&key, CountingKeyDestructor));
+  }
+  g_key_destructor_calls = 0;
+
+  for (size_t round = 0; round < 2; ++round) {
+    std::vector<std::thread> threads;
+    std::atomic<bool> ok(true);
+    for (size_t i = 0; i < 8; ++i) {
+      threads.emplace_back([&keys, &ok, i]() {
+        for (size_t k = 0; k < keys.size(); ++k) {
+          if (pthread_getspecific(keys[k]) != nullptr) ok = false;
+        }
+        for (size_t k = i; k < keys.size(); k += 3) {
+          uintptr_t value = ((i + 1) << 16) | k;
+          if (pthread_setspecific(keys[k], reinterpret_cast<void*>(value)) != 0) ok = false;
+        }
+        for (size_t k = 0; k < keys.size(); ++k) {
+          uintptr_t expected = (k >= i && (k - i) % 3 == 0) ? (((i + 1) << 16) | k) : 0;
+          if (pthread_getspecific(keys[k]) != reinterpret_cast<void*>(expected)) ok = false;
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    ASSERT_TRUE(ok);
+  }
+
+  size_t expected_calls = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    expected_calls += (keys.size() - i + 2) / 3;
+  }
+  ASSERT_EQ(static_cast<int>(2 * expected_calls), g_key_destructor_calls);
+
+  for (auto& key : keys) {
+    ASSERT_EQ(0, pthread_key_delete(key));
+  }
+}
+
 static void* IdFn(void* arg) {
   return arg;
 }
@@ -251,6 +364,93 @@ TEST(pthread, pthread_create) {
   ASSERT_EQ(expected_result, result);
 }
 
+// Threads that exit may hand their stack, TLS and signal stack to the next thread created, so
+// check that every new thread still starts from a clean slate.
+static pthread_key_t g_reused_thread_key;
+
+static void* CheckCleanThreadState(void* arg) {
+  bool* clean = reinterpret_cast<bool*>(arg);
+  *clean = (pthread_getspecific(g_reused_thread_key) == nullptr) && (errno == 0);
+#if defined(__BIONIC__)
+  // bionic gives every thread an alternate signal stack.
+  stack_t ss;
+  *clean = *clean &&
+      (sigaltstack(nullptr, &ss) == 0) && (ss.ss_flags & SS_DISABLE) == 0 && ss.ss_sp != nullptr;
+#endif
+
+  // Leave some mess behind for the next thread.
+  pthread_setspecific(g_reused_thread_key, arg);
+  errno = EIO;
+  return nullptr;
+}
+
+TEST(pthread, pthread_create_reused_thread_is_clean) {
+  ASSERT_EQ(0, pthread_key_create(&g_reused_thread_key, nullptr));
+
+  for (size_t i = 0; i < 64; ++i) {
+    bool clean = false;
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, nullptr, CheckCleanThreadState, &clean));
+    ASSERT_EQ(0, pthread_join(t, nullptr));
+    ASSERT_TRUE(clean) << "thread " << i;
+  }
+
+  // Detached threads recycle their own stacks as they exit.
+  pthread_attr_t attr;
+  ASSERT_EQ(0, pthread_attr_init(&attr));
+  ASSERT_EQ(0, pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED));
+  for (size_t i = 0; i < 64; ++i) {
+    std::atomic<bool> done(false);
+    bool clean = false;
+    auto fn = [](void* arg) -> void* {
+      auto args = reinterpret_cast<std::pair<bool*, std::atomic<bool>*>*>(arg);
+      CheckCleanThreadState(args->first);
+      *args->second = true;
+      return nullptr;
+    };
+    std::pair<bool*, std::atomic<bool>*> args(&clean, &done);
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, &attr, fn, &args));
+    while (!done) {
+      sched_yield();
+    }
+    ASSERT_TRUE(clean) << "detached thread " << i;
+  }
+  ASSERT_EQ(0, pthread_attr_destroy(&attr));
+
+  ASSERT_EQ(0, pthread_key_delete(g_reused_thread_key));
+}
+
+static void* GetStackBase(void* arg) {
+  pthread_attr_t attr;
+  void* stack_base = nullptr;
+  size_t stack_size;
+  if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+    pthread_attr_getstack(&attr, &stack_base, &stack_size);
+    pthread_attr_destroy(&attr);
+  }
+  *reinterpret_cast<void**>(arg) = stack_base;
+  return nullptr;
+}
+
+TEST(pthread, pthread_create_reuses_default_thread_mapping) {
+#if defined(__BIONIC__)
+  // A thread with default attributes gets the mapping of the last such thread to be joined.
+  void* first_stack = nullptr;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, nullptr, GetStackBase, &first_stack));
+  ASSERT_EQ(0, pthread_join(t, nullptr));
+  ASSERT_TRUE(first_stack != nullptr);
+
+  void* second_stack = nullptr;
+  ASSERT_EQ(0, pthread_create(&t, nullptr, GetStackBase, &second_stack));
+  ASSERT_EQ(0, pthread_join(t, nullptr));
+  ASSERT_EQ(first_stack, second_stack);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(pthread, pthread_create_EAGAIN) {
   pthread_attr_t attributes;
   ASSERT_EQ(0, pthread_attr_init(&attributes));
@@ -739,6 +939,13 @@ TEST(pthread, pthread_rwlockattr_smoke) {
     ASSERT_EQ(kind_array[i], kind);
   }
 
+#if defined(__BIONIC__)
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_SCALABLE_READERS_NP));
+  int kind;
+  ASSERT_EQ(0, pthread_rwlockattr_getkind_np(&attr, &kind));
+  ASSERT_EQ(PTHREAD_RWLOCK_SCALABLE_READERS_NP, kind);
+#endif
+
   ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
 }
 
@@ -1069,6 +1276,162 @@ TEST(pthread, pthread_rwlock_kind_PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP)
   ASSERT_EQ(0, pthread_join(reader_thread, NULL));
 }
 
+#if defined(__BIONIC__)
+TEST(pthread, pthread_rwlock_kind_PTHREAD_RWLOCK_SCALABLE_READERS_NP) {
+  RwlockKindTestHelper helper(PTHREAD_RWLOCK_SCALABLE_READERS_NP);
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&helper.lock));
+
+  // A writer waiting for the readers to drain keeps new readers out.
+  pthread_t writer_thread;
+  std::atomic<pid_t> writer_tid;
+  helper.CreateWriterThread(writer_thread, writer_tid);
+  WaitUntilThreadSleep(writer_tid);
+
+  pthread_t reader_thread;
+  std::atomic<pid_t> reader_tid;
+  helper.CreateReaderThread(reader_thread, reader_tid);
+  WaitUntilThreadSleep(reader_tid);
+
+  ASSERT_EQ(0, pthread_rwlock_unlock(&helper.lock));
+  ASSERT_EQ(0, pthread_join(writer_thread, NULL));
+  ASSERT_EQ(0, pthread_join(reader_thread, NULL));
+}
+
+static void InitScalableReadersRwlock(pthread_rwlock_t* lock) {
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_SCALABLE_READERS_NP));
+  ASSERT_EQ(0, pthread_rwlock_init(lock, &attr));
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+}
+#endif
+
+TEST(pthread, pthread_rwlock_SCALABLE_READERS_smoke) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t l;
+  InitScalableReadersRwlock(&l);
+
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_tryrdlock(&l));
+  ASSERT_EQ(EBUSY, pthread_rwlock_trywrlock(&l));
+  ASSERT_EQ(EBUSY, pthread_rwlock_destroy(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(EPERM, pthread_rwlock_unlock(&l));
+
+  ASSERT_EQ(0, pthread_rwlock_wrlock(&l));
+  ASSERT_EQ(EBUSY, pthread_rwlock_tryrdlock(&l));
+  ASSERT_EQ(EDEADLK, pthread_rwlock_rdlock(&l));
+  ASSERT_EQ(EDEADLK, pthread_rwlock_wrlock(&l));
+  ASSERT_EQ(EBUSY, pthread_rwlock_destroy(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+
+  ASSERT_EQ(0, pthread_rwlock_trywrlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+
+  // The reader counters are private to this process.
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_SCALABLE_READERS_NP));
+  ASSERT_EQ(0, pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED));
+  ASSERT_EQ(ENOTSUP, pthread_rwlock_init(&l, &attr));
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic implementation details.";
+#endif
+}
+
+TEST(pthread, pthread_rwlock_SCALABLE_READERS_timedwrlock_timeout) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t l;
+  InitScalableReadersRwlock(&l);
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
+
+  std::atomic<int> result(-1);
+  std::thread writer([&]() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 10 * 1000000;
+    if (ts.tv_nsec >= NS_PER_S) {
+      ts.tv_sec++;
+      ts.tv_nsec -= NS_PER_S;
+    }
+    result = pthread_rwlock_timedwrlock(&l, &ts);
+  });
+  writer.join();
+  ASSERT_EQ(ETIMEDOUT, result);
+
+  // The timed-out writer must not have left readers locked out.
+  ASSERT_EQ(0, pthread_rwlock_tryrdlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic implementation details.";
+#endif
+}
+
+TEST(pthread, pthread_rwlock_SCALABLE_READERS_timedwrlock_invalid_timespec) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t l;
+  InitScalableReadersRwlock(&l);
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
+
+  std::atomic<int> result(-1);
+  std::thread writer([&]() {
+    timespec ts = { 0, -1 };
+    result = pthread_rwlock_timedwrlock(&l, &ts);
+  });
+  writer.join();
+  ASSERT_EQ(EINVAL, result);
+
+  ASSERT_EQ(0, pthread_rwlock_tryrdlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic implementation details.";
+#endif
+}
+
+TEST(pthread, pthread_rwlock_SCALABLE_READERS_contended) {
+#if defined(__BIONIC__)
+  pthread_rwlock_t l;
+  InitScalableReadersRwlock(&l);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  std::atomic<bool> done(false);
+  std::atomic<bool> torn(false);
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < 8; ++i) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        pthread_rwlock_rdlock(&l);
+        if (a != b) torn = true;
+        pthread_rwlock_unlock(&l);
+      }
+    });
+  }
+  for (size_t i = 0; i < 10000; ++i) {
+    ASSERT_EQ(0, pthread_rwlock_wrlock(&l));
+    ++a;
+    ++b;
+    ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_FALSE(torn);
+  ASSERT_EQ(10000U, a);
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic implementation details.";
+#endif
+}
+
 static int g_once_fn_call_count = 0;
 static void OnceFn() {
   ++g_once_fn_call_count;
@@ -1101,6 +1464,35 @@ TEST(pthread, pthread_once_1934122) {
   ASSERT_EQ("12", pthread_once_1934122_result);
 }
 
+static std::atomic<int> g_slow_once_fn_call_count;
+static std::atomic<bool> g_slow_once_fn_done;
+static void SlowOnceFn() {
+  ++g_slow_once_fn_call_count;
+  usleep(100000);
+  g_slow_once_fn_done = true;
+}
+
+TEST(pthread, pthread_once_contended) {
+  // Threads that arrive while the init routine is running have to wait for it to finish, and
+  // are all woken when it does.
+  static pthread_once_t once_control = PTHREAD_ONCE_INIT;
+  std::vector<std::thread> threads;
+  std::atomic<int> saw_done(0);
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&saw_done]() {
+      ASSERT_EQ(0, pthread_once(&once_control, SlowOnceFn));
+      if (g_slow_once_fn_done) {
+        ++saw_done;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(1, g_slow_once_fn_call_count);
+  ASSERT_EQ(8, saw_done);
+}
+
 static int g_atfork_prepare_calls = 0;
 static void AtForkPrepare1() { g_atfork_prepare_calls = (g_atfork_prepare_calls * 10) + 1; }
 static void AtForkPrepare2() { g_atfork_prepare_calls = (g_atfork_prepare_calls * 10) + 2; }
@@ -1313,6 +1705,93 @@ TEST(pthread, pthread_cond_timedwait_timeout) {
   ASSERT_EQ(0, pthread_mutex_unlock(&mutex));
 }
 
+// Every waiter has to get through the mutex after a broadcast, however many of them
+// are asleep at the time and whatever the mutex type.
+static void TestCondBroadcastWakesAllWaiters(int mutex_type, bool timed) {
+  constexpr int kWaiters = 16;
+  constexpr int kRounds = 50;
+
+  struct Shared {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    int generation = 0;
+    int waiting = 0;
+    int awake = 0;
+    bool timed;
+  } shared;
+  shared.timed = timed;
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, mutex_type));
+  ASSERT_EQ(0, pthread_mutex_init(&shared.mutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+
+  auto waiter = [](void* arg) -> void* {
+    Shared* shared = reinterpret_cast<Shared*>(arg);
+    pthread_mutex_lock(&shared->mutex);
+    for (int round = 1; round <= kRounds; ++round) {
+      ++shared->waiting;
+      while (shared->generation < round) {
+        if (shared->timed) {
+          timespec ts;
+          clock_gettime(CLOCK_REALTIME, &ts);
+          ts.tv_sec += 10;
+          pthread_cond_timedwait(&shared->cond, &shared->mutex, &ts);
+        } else {
+          pthread_cond_wait(&shared->cond, &shared->mutex);
+        }
+      }
+      ++shared->awake;
+    }
+    pthread_mutex_unlock(&shared->mutex);
+    return nullptr;
+  };
+
+  pthread_t threads[kWaiters];
+  for (pthread_t& thread : threads) {
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, waiter, &shared));
+  }
+  for (int round = 1; round <= kRounds; ++round) {
+    ASSERT_EQ(0, pthread_mutex_lock(&shared.mutex));
+    while (shared.waiting < kWaiters * round) {
+      ASSERT_EQ(0, pthread_mutex_unlock(&shared.mutex));
+      sched_yield();
+      ASSERT_EQ(0, pthread_mutex_lock(&shared.mutex));
+    }
+    shared.generation = round;
+    // Alternate between broadcasting with and without the mutex held.
+    if (round % 2 == 0) {
+      ASSERT_EQ(0, pthread_cond_broadcast(&shared.cond));
+      ASSERT_EQ(0, pthread_mutex_unlock(&shared.mutex));
+    } else {
+      ASSERT_EQ(0, pthread_mutex_unlock(&shared.mutex));
+      ASSERT_EQ(0, pthread_cond_broadcast(&shared.cond));
+    }
+  }
+  for (pthread_t& thread : threads) {
+    ASSERT_EQ(0, pthread_join(thread, nullptr));
+  }
+  ASSERT_EQ(kWaiters * kRounds, shared.awake);
+  ASSERT_EQ(0, pthread_cond_destroy(&shared.cond));
+  ASSERT_EQ(0, pthread_mutex_destroy(&shared.mutex));
+}
+
+TEST(pthread, pthread_cond_broadcast_wakes_all_waiters_NORMAL) {
+  TestCondBroadcastWakesAllWaiters(PTHREAD_MUTEX_NORMAL, false);
+}
+
+TEST(pthread, pthread_cond_broadcast_wakes_all_waiters_RECURSIVE) {
+  TestCondBroadcastWakesAllWaiters(PTHREAD_MUTEX_RECURSIVE, false);
+}
+
+TEST(pthread, pthread_cond_broadcast_wakes_all_waiters_ERRORCHECK) {
+  TestCondBroadcastWakesAllWaiters(PTHREAD_MUTEX_ERRORCHECK, false);
+}
+
+TEST(pthread, pthread_cond_broadcast_wakes_all_timedwait_waiters) {
+  TestCondBroadcastWakesAllWaiters(PTHREAD_MUTEX_NORMAL, true);
+}
+
 TEST(pthread, pthread_attr_getstack__main_thread) {
   // This test is only meaningful for the main thread, so make sure we're running on it!
   ASSERT_EQ(getpid(), syscall(__NR_gettid));
@@ -1589,14 +2068,18 @@ TEST(pthread, pthread_mutexattr_gettype) {
   ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &attr_type));
   ASSERT_EQ(PTHREAD_MUTEX_RECURSIVE, attr_type);
 
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP));
+  ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &attr_type));
+  ASSERT_EQ(PTHREAD_MUTEX_ADAPTIVE_NP, attr_type);
+
   ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
 }
 
 struct PthreadMutex {
   pthread_mutex_t lock;
 
-  explicit PthreadMutex(int mutex_type) {
-    init(mutex_type);
+  explicit PthreadMutex(int mutex_type, int protocol = PTHREAD_PRIO_NONE) {
+    init(mutex_type, protocol);
   }
 
   ~PthreadMutex() {
@@ -1604,10 +2087,11 @@ struct PthreadMutex {
   }
 
  private:
-  void init(int mutex_type) {
+  void init(int mutex_type, int protocol) {
     pthread_mutexattr_t attr;
     ASSERT_EQ(0, pthread_mutexattr_init(&attr));
     ASSERT_EQ(0, pthread_mutexattr_settype(&attr, mutex_type));
+    ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, protocol));
     ASSERT_EQ(0, pthread_mutex_init(&lock, &attr));
     ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
   }
@@ -1655,6 +2139,132 @@ TEST(pthread, pthread_mutex_lock_RECURSIVE) {
   ASSERT_EQ(EPERM, pthread_mutex_unlock(&m.lock));
 }
 
+TEST(pthread, pthread_mutex_lock_ADAPTIVE) {
+  PthreadMutex m(PTHREAD_MUTEX_ADAPTIVE_NP);
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+}
+
+TEST(pthread, pthread_mutexattr_protocol) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+
+  int protocol;
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_NONE, protocol);
+
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_INHERIT, protocol);
+
+#if defined(__BIONIC__)
+  ASSERT_EQ(ENOTSUP, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_PROTECT));
+#endif
+  ASSERT_EQ(EINVAL, pthread_mutexattr_setprotocol(&attr, 123));
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_INHERIT, protocol);
+
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_NONE));
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_NONE, protocol);
+
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+}
+
+TEST(pthread, pthread_mutex_lock_NORMAL_PI) {
+  PthreadMutex m(PTHREAD_MUTEX_NORMAL, PTHREAD_PRIO_INHERIT);
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+}
+
+TEST(pthread, pthread_mutex_lock_ERRORCHECK_PI) {
+  PthreadMutex m(PTHREAD_MUTEX_ERRORCHECK, PTHREAD_PRIO_INHERIT);
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(EDEADLK, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(EPERM, pthread_mutex_unlock(&m.lock));
+}
+
+TEST(pthread, pthread_mutex_lock_RECURSIVE_PI) {
+  PthreadMutex m(PTHREAD_MUTEX_RECURSIVE, PTHREAD_PRIO_INHERIT);
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_lock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_trylock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+  ASSERT_EQ(EPERM, pthread_mutex_unlock(&m.lock));
+}
+
+TEST(pthread, pthread_mutex_destroy_locked_PI) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+  pthread_mutex_t m;
+  ASSERT_EQ(0, pthread_mutex_init(&m, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+
+  ASSERT_EQ(0, pthread_mutex_lock(&m));
+#if defined(__BIONIC__)
+  ASSERT_EQ(EBUSY, pthread_mutex_destroy(&m));
+#endif
+  ASSERT_EQ(0, pthread_mutex_unlock(&m));
+  ASSERT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread, pthread_mutex_timedlock_PI) {
+  PthreadMutex m(PTHREAD_MUTEX_NORMAL, PTHREAD_PRIO_INHERIT);
+
+  // Another thread holds the mutex, so we should time out in the kernel.
+  pthread_barrier_t barrier;
+  ASSERT_EQ(0, pthread_barrier_init(&barrier, nullptr, 2));
+  std::pair<pthread_mutex_t*, pthread_barrier_t*> args(&m.lock, &barrier);
+  auto holder = [](void* arg) -> void* {
+    auto args = reinterpret_cast<std::pair<pthread_mutex_t*, pthread_barrier_t*>*>(arg);
+    pthread_mutex_lock(args->first);
+    pthread_barrier_wait(args->second);
+    pthread_barrier_wait(args->second);
+    pthread_mutex_unlock(args->first);
+    return nullptr;
+  };
+  pthread_t thread;
+  ASSERT_EQ(0, pthread_create(&thread, nullptr, holder, &args));
+  pthread_barrier_wait(&barrier);
+
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_REALTIME, &ts));
+  ts.tv_nsec += 10 * 1000 * 1000;
+  if (ts.tv_nsec >= NS_PER_S) {
+    ts.tv_sec++;
+    ts.tv_nsec -= NS_PER_S;
+  }
+  ASSERT_EQ(ETIMEDOUT, pthread_mutex_timedlock(&m.lock, &ts));
+
+  pthread_barrier_wait(&barrier);
+  ASSERT_EQ(0, pthread_join(thread, nullptr));
+  ASSERT_EQ(0, pthread_barrier_destroy(&barrier));
+
+  ASSERT_EQ(0, clock_gettime(CLOCK_REALTIME, &ts));
+  ts.tv_sec += 1;
+  ASSERT_EQ(0, pthread_mutex_timedlock(&m.lock, &ts));
+  ASSERT_EQ(0, pthread_mutex_unlock(&m.lock));
+}
+
 TEST(pthread, pthread_mutex_init_same_as_static_initializers) {
   pthread_mutex_t lock_normal = PTHREAD_MUTEX_INITIALIZER;
   PthreadMutex m1(PTHREAD_MUTEX_NORMAL);
@@ -1670,6 +2280,11 @@ TEST(pthread, pthread_mutex_init_same_as_static_initializers) {
   PthreadMutex m3(PTHREAD_MUTEX_RECURSIVE);
   ASSERT_EQ(0, memcmp(&lock_recursive, &m3.lock, sizeof(pthread_mutex_t)));
   ASSERT_EQ(0, pthread_mutex_destroy(&lock_recursive));
+
+  pthread_mutex_t lock_adaptive = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
+  PthreadMutex m4(PTHREAD_MUTEX_ADAPTIVE_NP);
+  ASSERT_EQ(0, memcmp(&lock_adaptive, &m4.lock, sizeof(pthread_mutex_t)));
+  ASSERT_EQ(0, pthread_mutex_destroy(&lock_adaptive));
 }
 class MutexWakeupHelper {
  private:
@@ -1696,7 +2311,8 @@ class MutexWakeupHelper {
   }
 
  public:
-  explicit MutexWakeupHelper(int mutex_type) : m(mutex_type) {
+  explicit MutexWakeupHelper(int mutex_type, int protocol = PTHREAD_PRIO_NONE)
+      : m(mutex_type, protocol) {
   }
 
   void test() {
@@ -1734,6 +2350,46 @@ TEST(pthread, pthread_mutex_RECURSIVE_wakeup) {
   helper.test();
 }
 
+TEST(pthread, pthread_mutex_NORMAL_PI_wakeup) {
+  MutexWakeupHelper helper(PTHREAD_MUTEX_NORMAL, PTHREAD_PRIO_INHERIT);
+  helper.test();
+}
+
+TEST(pthread, pthread_mutex_RECURSIVE_PI_wakeup) {
+  MutexWakeupHelper helper(PTHREAD_MUTEX_RECURSIVE, PTHREAD_PRIO_INHERIT);
+  helper.test();
+}
+
+TEST(pthread, pthread_mutex_ADAPTIVE_wakeup) {
+  MutexWakeupHelper helper(PTHREAD_MUTEX_ADAPTIVE_NP);
+  helper.test();
+}
+
+static void* MutexCounterThread(void* arg) {
+  auto args = reinterpret_cast<std::pair<pthread_mutex_t*, int*>*>(arg);
+  for (int i = 0; i < 100000; ++i) {
+    pthread_mutex_lock(args->first);
+    ++*args->second;
+    pthread_mutex_unlock(args->first);
+  }
+  return nullptr;
+}
+
+TEST(pthread, pthread_mutex_ADAPTIVE_contended) {
+  PthreadMutex m(PTHREAD_MUTEX_ADAPTIVE_NP);
+  int counter = 0;
+  std::pair<pthread_mutex_t*, int*> args(&m.lock, &counter);
+
+  pthread_t threads[4];
+  for (auto& t : threads) {
+    ASSERT_EQ(0, pthread_create(&t, nullptr, MutexCounterThread, &args));
+  }
+  for (auto& t : threads) {
+    ASSERT_EQ(0, pthread_join(t, nullptr));
+  }
+  ASSERT_EQ(4 * 100000, counter);
+}
+
 TEST(pthread, pthread_mutex_owner_tid_limit) {
 #if defined(__BIONIC__) && !defined(__LP64__)
   FILE* fp = fopen("/proc/sys/kernel/pid_max", "r");
@@ -1923,6 +2579,17 @@ TEST(pthread, big_enough_signal_stack) {
   ASSERT_TRUE(signal_handler_on_altstack_done);
 }
 
+TEST(pthread, big_enough_signal_stack_in_thread) {
+  // Threads whose stack pthread_create allocates get their signal stack from the same mapping.
+  std::thread t([]() {
+    signal_handler_on_altstack_done = false;
+    ScopedSignalHandler handler(SIGUSR1, SignalHandlerOnAltStack, SA_SIGINFO | SA_ONSTACK);
+    ASSERT_EQ(0, pthread_kill(pthread_self(), SIGUSR1));
+    ASSERT_TRUE(signal_handler_on_altstack_done);
+  });
+  t.join();
+}
+
 TEST(pthread, pthread_barrierattr_smoke) {
   pthread_barrierattr_t attr;
   ASSERT_EQ(0, pthread_barrierattr_init(&attr));
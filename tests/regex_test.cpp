@@ -19,6 +19,8 @@
 #include <sys/types.h>
 #include <regex.h>
 
+#include <string>
+
 TEST(regex, smoke) {
   // A quick test of all the regex functions.
   regex_t re;
@@ -57,3 +59,58 @@ TEST(regex, regerror_NULL_0) {
   int error_length = regerror(error, &re, nullptr, 0);
   ASSERT_GT(error_length, 0);
 }
+
+TEST(regex, REG_LINEAR) {
+#if defined(__BIONIC__)
+  regex_t re;
+  regmatch_t m[3];
+  ASSERT_EQ(0, regcomp(&re, "(a|ab)(c|bcd)(d*)", REG_EXTENDED | REG_LINEAR));
+  // Leftmost-longest, with the same submatches as without REG_LINEAR.
+  ASSERT_EQ(0, regexec(&re, "xabcd", 3, m, 0));
+  ASSERT_EQ(1, m[0].rm_so);
+  ASSERT_EQ(5, m[0].rm_eo);
+  ASSERT_EQ(1, m[1].rm_so);
+  ASSERT_EQ(3, m[1].rm_eo);
+  ASSERT_EQ(3, m[2].rm_so);
+  ASSERT_EQ(4, m[2].rm_eo);
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "xyz", 0, nullptr, 0));
+  regfree(&re);
+
+  ASSERT_EQ(0, regcomp(&re, "^[[:<:]]foo[[:>:]]", REG_LINEAR | REG_NEWLINE));
+  ASSERT_EQ(0, regexec(&re, "bar\nfoo\nbaz", 1, m, 0));
+  ASSERT_EQ(4, m[0].rm_so);
+  ASSERT_EQ(7, m[0].rm_eo);
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "foo", 0, nullptr, REG_NOTBOL));
+  ASSERT_EQ(REG_NOMATCH, regexec(&re, "foobar", 0, nullptr, 0));
+  regfree(&re);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(regex, REG_LINEAR_backrefs) {
+#if defined(__BIONIC__)
+  // Back references can't be matched in linear time.
+  regex_t re;
+  ASSERT_EQ(REG_BADPAT, regcomp(&re, "\\(a*\\)\\1", REG_LINEAR));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(regex, REG_LINEAR_long_input) {
+#if defined(__BIONIC__)
+  // Without REG_LINEAR this takes time quadratic in the number of 'a's.
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "(a+c|b)", REG_EXTENDED | REG_LINEAR));
+  std::string s(1000000, 'a');
+  s += 'b';
+  regmatch_t m[1];
+  ASSERT_EQ(0, regexec(&re, s.c_str(), 1, m, 0));
+  ASSERT_EQ(1000000, m[0].rm_so);
+  ASSERT_EQ(1000001, m[0].rm_eo);
+  regfree(&re);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
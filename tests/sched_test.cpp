@@ -18,9 +18,18 @@
 
 #include <errno.h>
 #include <sched.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <set>
+#include <thread>
+#include <vector>
+
+#if defined(__BIONIC__)
+#include "private/bionic_percpu.h"
+#endif
+
 static int child_fn(void* i_ptr) {
   *reinterpret_cast<int*>(i_ptr) = 42;
   return 123;
@@ -270,3 +279,88 @@ TEST(sched, cpu_equal_s) {
   CPU_FREE(set1);
   CPU_FREE(set2);
 }
+
+static void CheckSchedGetcpuFollowsAffinity() {
+  cpu_set_t original;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &original)) continue;
+    cpu_set_t just_this_one;
+    CPU_ZERO(&just_this_one);
+    CPU_SET(cpu, &just_this_one);
+    ASSERT_EQ(0, sched_setaffinity(0, sizeof(just_this_one), &just_this_one));
+    // Moving to the new CPU happens before sched_setaffinity returns.
+    ASSERT_EQ(cpu, sched_getcpu());
+  }
+
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original), &original));
+}
+
+TEST(sched, sched_getcpu) {
+  CheckSchedGetcpuFollowsAffinity();
+}
+
+TEST(sched, sched_getcpu_new_thread) {
+  // Threads other than the main thread get their own rseq area.
+  std::thread t(CheckSchedGetcpuFollowsAffinity);
+  t.join();
+}
+
+#if defined(__BIONIC__)
+TEST(sched, percpu_counter) {
+  static PerCpuCounter counter;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([]() {
+      for (size_t j = 0; j < 10000; ++j) {
+        counter.add(2);
+        counter.add(-1);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(80000, counter.sum());
+}
+
+TEST(sched, percpu_free_list) {
+  static PerCpuFreeList free_list;
+  ASSERT_EQ(nullptr, free_list.pop());
+
+  // Every object pushed comes back out exactly once, whichever CPU pushed it.
+  constexpr size_t kObjectsPerThread = 1000;
+  std::vector<void*> objects[4];
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&objects, i]() {
+      for (size_t j = 0; j < kObjectsPerThread; ++j) {
+        void* object = malloc(sizeof(void*) * 2);
+        objects[i].push_back(object);
+        free_list.push(object);
+        if (j % 3 == 0) {
+          free_list.push(free_list.pop());
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  std::set<void*> pushed;
+  for (auto& v : objects) {
+    pushed.insert(v.begin(), v.end());
+  }
+  std::set<void*> popped;
+  void* object;
+  while ((object = free_list.pop()) != nullptr) {
+    ASSERT_TRUE(popped.insert(object).second);
+  }
+  ASSERT_EQ(pushed, popped);
+  for (void* p : popped) {
+    free(p);
+  }
+}
+#endif  // __BIONIC__
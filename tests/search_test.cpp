@@ -18,6 +18,12 @@
 
 #include <search.h>
 
+#include <errno.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
 static int int_cmp(const void* lhs, const void* rhs) {
   return *reinterpret_cast<const int*>(rhs) - *reinterpret_cast<const int*>(lhs);
 }
@@ -135,6 +141,145 @@ TEST(search, tdelete) {
   ASSERT_NE(nullptr, tdelete(&n1, &root, pod_node_cmp));
 }
 
+static int g_max_level;
+static std::vector<int> g_walked_ints;
+
+static void int_walk(const void* p, VISIT order, int level) {
+  if (level > g_max_level) g_max_level = level;
+  if (order == postorder || order == leaf) {
+    g_walked_ints.push_back(**reinterpret_cast<int* const*>(p));
+  }
+}
+
+static int ascending_int_cmp(const void* lhs, const void* rhs) {
+  int a = *reinterpret_cast<const int*>(lhs);
+  int b = *reinterpret_cast<const int*>(rhs);
+  return (a > b) - (a < b);
+}
+
+TEST(search, tsearch_sorted_keys_stay_balanced) {
+  void* root = nullptr;
+  std::vector<int> keys(4096);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i;
+    ASSERT_NE(nullptr, tsearch(&keys[i], &root, ascending_int_cmp));
+  }
+
+  g_max_level = 0;
+  g_walked_ints.clear();
+  twalk(root, int_walk);
+  ASSERT_EQ(keys, g_walked_ints);
+  // An unbalanced tree would be 4095 levels deep; any balanced one is under 2*log2(n).
+  ASSERT_LT(g_max_level, 24);
+
+  tdestroy(root, [](void*) {});
+}
+
+TEST(search, tdelete_many) {
+  void* root = nullptr;
+  std::vector<int> keys(1000);
+  std::vector<void*> nodes(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = (i * 7919) % keys.size();
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    nodes[i] = tsearch(&keys[i], &root, ascending_int_cmp);
+    ASSERT_NE(nullptr, nodes[i]);
+  }
+
+  // Delete every other key, in a scattered order.
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    int key = keys[i];
+    ASSERT_NE(nullptr, tdelete(&key, &root, ascending_int_cmp));
+    ASSERT_EQ(nullptr, tdelete(&key, &root, ascending_int_cmp));
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    void* found = tfind(&keys[i], &root, ascending_int_cmp);
+    if (i % 2 == 0) {
+      ASSERT_EQ(nullptr, found);
+    } else {
+      ASSERT_EQ(&keys[i], *reinterpret_cast<int**>(found));
+#if defined(__BIONIC__)
+      // glibc moves keys between nodes when deleting, but we don't.
+      ASSERT_EQ(nodes[i], found);
+#endif
+    }
+  }
+
+  g_max_level = 0;
+  g_walked_ints.clear();
+  twalk(root, int_walk);
+  ASSERT_EQ(keys.size() / 2, g_walked_ints.size());
+  ASSERT_TRUE(std::is_sorted(g_walked_ints.begin(), g_walked_ints.end()));
+  ASSERT_LT(g_max_level, 18);
+
+  tdestroy(root, [](void*) {});
+}
+
+TEST(search, hcreate_hsearch_hdestroy) {
+  ASSERT_NE(0, hcreate(16));
+
+  char a[] = "alpha";
+  char b[] = "bravo";
+  ENTRY item = { a, reinterpret_cast<void*>(1) };
+  ENTRY* e = hsearch(item, ENTER);
+  ASSERT_NE(nullptr, e);
+  ASSERT_STREQ("alpha", e->key);
+  ASSERT_EQ(reinterpret_cast<void*>(1), e->data);
+
+  // ENTER of an existing key returns the existing entry without changing it.
+  item.data = reinterpret_cast<void*>(2);
+  e = hsearch(item, ENTER);
+  ASSERT_EQ(reinterpret_cast<void*>(1), e->data);
+
+  // FIND compares keys, not pointers.
+  char alpha_copy[] = "alpha";
+  item.key = alpha_copy;
+  e = hsearch(item, FIND);
+  ASSERT_NE(nullptr, e);
+  ASSERT_EQ(a, e->key);
+
+  item.key = b;
+  errno = 0;
+  ASSERT_EQ(nullptr, hsearch(item, FIND));
+  ASSERT_EQ(ESRCH, errno);
+
+  hdestroy();
+}
+
+TEST(search, hsearch_r) {
+  hsearch_data t1 = {};
+  hsearch_data t2 = {};
+  ASSERT_NE(0, hcreate_r(8, &t1));
+  ASSERT_NE(0, hcreate_r(8, &t2));
+
+  // More entries than the size hint.
+  size_t count = 6;
+#if defined(__BIONIC__)
+  count = 10000;  // The table grows; glibc's doesn't.
+#endif
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < count; ++i) keys.push_back("key" + std::to_string(i));
+
+  for (size_t i = 0; i < count; ++i) {
+    ENTRY item = { const_cast<char*>(keys[i].c_str()), reinterpret_cast<void*>(i) };
+    ENTRY* e;
+    ASSERT_NE(0, hsearch_r(item, ENTER, &e, &t1)) << i;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ENTRY item = { const_cast<char*>(keys[i].c_str()), nullptr };
+    ENTRY* e;
+    ASSERT_NE(0, hsearch_r(item, FIND, &e, &t1)) << i;
+    ASSERT_EQ(reinterpret_cast<void*>(i), e->data);
+    ASSERT_EQ(0, hsearch_r(item, FIND, &e, &t2));
+    ASSERT_EQ(nullptr, e);
+  }
+
+  hdestroy_r(&t1);
+  hdestroy_r(&t2);
+}
+
 struct q_node {
   explicit q_node(int i) : i(i) {}
 
@@ -17,12 +17,16 @@
 #include <semaphore.h>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <string>
+
 #include "private/bionic_constants.h"
 #include "ScopedSignalHandler.h"
 
@@ -227,3 +231,90 @@ TEST(semaphore, sem_wait_EINTR_in_sdk_greater_than_23) {
   ASSERT_EQ(0, pthread_join(thread, &result));
   ASSERT_EQ(2U, reinterpret_cast<uintptr_t>(result));
 }
+
+static bool HaveNamedSemaphores() {
+  // Named semaphores need a tmpfs at /dev/shm, which devices don't usually have.
+  if (access("/dev/shm", W_OK) == 0) return true;
+  GTEST_LOG_(INFO) << "This test does nothing: no writable /dev/shm.\n";
+  return false;
+}
+
+TEST(semaphore, sem_open_sem_close_sem_unlink) {
+  if (!HaveNamedSemaphores()) return;
+
+  const char* name = "/bionic-semaphore-test";
+  sem_unlink(name);
+
+  errno = 0;
+  ASSERT_EQ(SEM_FAILED, sem_open(name, 0));
+  ASSERT_EQ(ENOENT, errno);
+
+  sem_t* s = sem_open(name, O_CREAT | O_EXCL, 0600, 2);
+  ASSERT_NE(SEM_FAILED, s);
+  int i;
+  ASSERT_EQ(0, sem_getvalue(s, &i));
+  ASSERT_EQ(2, i);
+
+  errno = 0;
+  ASSERT_EQ(SEM_FAILED, sem_open(name, O_CREAT | O_EXCL, 0600, 0));
+  ASSERT_EQ(EEXIST, errno);
+
+  // Opening it again gives the same address, and needs as many closes.
+  sem_t* s2 = sem_open(name, O_CREAT, 0600, 0);
+  ASSERT_EQ(s, s2);
+  ASSERT_EQ(0, sem_close(s2));
+  ASSERT_EQ(0, sem_trywait(s));
+  ASSERT_EQ(0, sem_getvalue(s, &i));
+  ASSERT_EQ(1, i);
+
+  ASSERT_EQ(0, sem_unlink(name));
+  errno = 0;
+  ASSERT_EQ(-1, sem_unlink(name));
+  ASSERT_EQ(ENOENT, errno);
+
+  // It stays usable until closed.
+  ASSERT_EQ(0, sem_post(s));
+  ASSERT_EQ(0, sem_getvalue(s, &i));
+  ASSERT_EQ(2, i);
+  ASSERT_EQ(0, sem_close(s));
+}
+
+TEST(semaphore, sem_open_invalid) {
+  errno = 0;
+  ASSERT_EQ(SEM_FAILED, sem_open("/a/b", O_CREAT, 0600, 0));
+  ASSERT_EQ(EINVAL, errno);
+
+  errno = 0;
+  ASSERT_EQ(SEM_FAILED, sem_open(std::string(NAME_MAX + 1, 'a').c_str(), O_CREAT, 0600, 0));
+  ASSERT_EQ(ENAMETOOLONG, errno);
+
+  if (!HaveNamedSemaphores()) return;
+  errno = 0;
+  ASSERT_EQ(SEM_FAILED, sem_open("/bionic-semaphore-test-invalid", O_CREAT, 0600,
+                                 SEM_VALUE_MAX + 1U));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(semaphore, sem_open_across_fork) {
+  if (!HaveNamedSemaphores()) return;
+
+  const char* name = "/bionic-semaphore-test-fork";
+  sem_unlink(name);
+  sem_t* s = sem_open(name, O_CREAT | O_EXCL, 0600, 0);
+  ASSERT_NE(SEM_FAILED, s);
+  ASSERT_EQ(0, sem_unlink(name));
+
+  // The child posts through the mapping it inherited.
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    _exit(sem_post(s) == 0 ? 0 : 1);
+  }
+  ASSERT_EQ(0, sem_wait(s));
+
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+  ASSERT_EQ(0, sem_close(s));
+}
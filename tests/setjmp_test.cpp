@@ -18,6 +18,13 @@
 
 #include <setjmp.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "ScopedSignalHandler.h"
 
 TEST(setjmp, setjmp_smoke) {
   int value;
@@ -162,6 +169,35 @@ TEST(setjmp, sigsetjmp_1_signal_mask) {
   sigprocmask(SIG_SETMASK, &ss.original, NULL);
 }
 
+static sigjmp_buf g_handler_jmp_buf;
+
+static void siglongjmp_from_handler(int) {
+  siglongjmp(g_handler_jmp_buf, 1);
+}
+
+TEST(setjmp, sigsetjmp_1_signal_mask_from_handler) {
+  // The kernel blocks SIGUSR1 while its handler runs, so siglongjmp out of the handler
+  // has to unblock it again even though the mask sigsetjmp saved hasn't changed since.
+  // Check with the system call, in case sigprocmask only remembered what it last set.
+  SigSets ss;
+  sigprocmask(SIG_SETMASK, &ss.two, &ss.original);
+  ScopedSignalHandler ssh(SIGUSR1, siglongjmp_from_handler);
+  for (int i = 0; i < 2; ++i) {
+    if (sigsetjmp(g_handler_jmp_buf, 1) == 0) {
+      raise(SIGUSR1);
+      FAIL(); // Unreachable.
+    }
+    uint64_t actual[2] = {};
+    ASSERT_EQ(0, syscall(__NR_rt_sigprocmask, SIG_SETMASK, NULL, actual, sizeof(uint64_t)));
+    sigset_t actual_set;
+    sigemptyset(&actual_set);
+    memcpy(&actual_set, actual, std::min(sizeof(actual_set), sizeof(actual)));
+    EXPECT_EQ(0, sigismember(&actual_set, SIGUSR1));
+    EXPECT_EQ(1, sigismember(&actual_set, SIGUSR2));
+  }
+  sigprocmask(SIG_SETMASK, &ss.original, NULL);
+}
+
 #if defined(__aarch64__)
 #define SET_FREG(n, v) asm volatile("fmov d"#n ", "#v : : : "d"#n)
 #define CLEAR_FREG(n) asm volatile("fmov d"#n ", xzr" : : : "d"#n)
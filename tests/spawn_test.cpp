@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "TemporaryFile.h"
+#include "utils.h"
+
+#if defined(__GLIBC__)
+#define BIN_DIR "/bin/"
+#else
+#define BIN_DIR "/system/bin/"
+#endif
+
+// Runs the shell snippet 'script' with posix_spawnp and returns what it wrote
+// to stdout. The child's exit status must be 0.
+static std::string SpawnShell(const char* script, const posix_spawnattr_t* attr = nullptr) {
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+
+  posix_spawn_file_actions_t actions;
+  EXPECT_EQ(0, posix_spawn_file_actions_init(&actions));
+  EXPECT_EQ(0, posix_spawn_file_actions_addclose(&actions, fds[0]));
+  EXPECT_EQ(0, posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO));
+  EXPECT_EQ(0, posix_spawn_file_actions_addclose(&actions, fds[1]));
+
+  pid_t pid;
+  const char* argv[] = { "sh", "-c", script, nullptr };
+  EXPECT_EQ(0, posix_spawnp(&pid, "sh", &actions, attr, const_cast<char**>(argv), nullptr));
+  EXPECT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+  close(fds[1]);
+
+  std::string output;
+  char buf[128];
+  ssize_t n;
+  while ((n = TEMP_FAILURE_RETRY(read(fds[0], buf, sizeof(buf)))) > 0) output.append(buf, n);
+  close(fds[0]);
+  AssertChildExited(pid, 0);
+  return output;
+}
+
+TEST(spawn, posix_spawn_exit_status) {
+  pid_t pid;
+  const char* argv[] = { "sh", "-c", "exit 42", nullptr };
+  ASSERT_EQ(0, posix_spawn(&pid, BIN_DIR "sh", nullptr, nullptr, const_cast<char**>(argv),
+                           nullptr));
+  AssertChildExited(pid, 42);
+}
+
+TEST(spawn, posix_spawnp_searches_path) {
+  ASSERT_EQ("hello\n", SpawnShell("echo hello"));
+}
+
+TEST(spawn, posix_spawn_ENOENT) {
+  pid_t pid = 1234;
+  const char* argv[] = { "does-not-exist", nullptr };
+  ASSERT_EQ(ENOENT, posix_spawn(&pid, "/does/not/exist", nullptr, nullptr,
+                                const_cast<char**>(argv), nullptr));
+  ASSERT_EQ(ENOENT, posix_spawnp(&pid, "does-not-exist", nullptr, nullptr,
+                                 const_cast<char**>(argv), nullptr));
+  // Nothing was left behind for us to reap.
+  ASSERT_EQ(-1, waitpid(-1, nullptr, WNOHANG));
+  ASSERT_EQ(ECHILD, errno);
+}
+
+TEST(spawn, posix_spawn_envp) {
+  pid_t pid;
+  const char* argv[] = { "sh", "-c", "exit $SPAWN_TEST", nullptr };
+  const char* envp[] = { "SPAWN_TEST=7", nullptr };
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", nullptr, nullptr, const_cast<char**>(argv),
+                            const_cast<char**>(envp)));
+  AssertChildExited(pid, 7);
+}
+
+TEST(spawn, posix_spawn_file_actions_addopen) {
+  TemporaryFile tf;
+  posix_spawn_file_actions_t actions;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&actions));
+  ASSERT_EQ(0, posix_spawn_file_actions_addopen(&actions, 7, tf.filename, O_WRONLY | O_TRUNC, 0));
+
+  pid_t pid;
+  const char* argv[] = { "sh", "-c", "echo spawned >&7", nullptr };
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", &actions, nullptr, const_cast<char**>(argv), nullptr));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+  AssertChildExited(pid, 0);
+
+  char buf[32] = {};
+  ASSERT_EQ(8, TEMP_FAILURE_RETRY(pread(tf.fd, buf, sizeof(buf), 0)));
+  ASSERT_STREQ("spawned\n", buf);
+}
+
+TEST(spawn, posix_spawn_file_actions_open_failure) {
+  posix_spawn_file_actions_t actions;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&actions));
+  ASSERT_EQ(0, posix_spawn_file_actions_addopen(&actions, 7, "/does/not/exist", O_RDONLY, 0));
+
+  pid_t pid;
+  const char* argv[] = { "true", nullptr };
+  ASSERT_EQ(ENOENT, posix_spawnp(&pid, "true", &actions, nullptr, const_cast<char**>(argv),
+                                 nullptr));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+}
+
+TEST(spawn, posix_spawn_file_actions_adddup2_clears_cloexec) {
+  int fd = open("/proc/version", O_RDONLY | O_CLOEXEC);
+  ASSERT_NE(-1, fd);
+  posix_spawn_file_actions_t actions;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&actions));
+  ASSERT_EQ(0, posix_spawn_file_actions_adddup2(&actions, fd, fd));
+
+  pid_t pid;
+  std::string script = "test -e /proc/self/fd/" + std::to_string(fd);
+  const char* argv[] = { "sh", "-c", script.c_str(), nullptr };
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", &actions, nullptr, const_cast<char**>(argv), nullptr));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+  AssertChildExited(pid, 0);
+  close(fd);
+}
+
+TEST(spawn, posix_spawn_file_actions_bad_fd) {
+  posix_spawn_file_actions_t actions;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&actions));
+  ASSERT_EQ(EBADF, posix_spawn_file_actions_addclose(&actions, -1));
+  ASSERT_EQ(EBADF, posix_spawn_file_actions_adddup2(&actions, -1, 0));
+  ASSERT_EQ(EBADF, posix_spawn_file_actions_adddup2(&actions, 0, -1));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+}
+
+TEST(spawn, posix_spawnattr_round_trip) {
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+
+  short flags;
+  ASSERT_EQ(0, posix_spawnattr_getflags(&attr, &flags));
+  ASSERT_EQ(0, flags);
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK));
+  ASSERT_EQ(0, posix_spawnattr_getflags(&attr, &flags));
+  ASSERT_EQ(POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK, flags);
+
+  pid_t pgroup;
+  ASSERT_EQ(0, posix_spawnattr_setpgroup(&attr, 123));
+  ASSERT_EQ(0, posix_spawnattr_getpgroup(&attr, &pgroup));
+  ASSERT_EQ(123, pgroup);
+
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  ASSERT_EQ(0, posix_spawnattr_setsigmask(&attr, &set));
+  sigemptyset(&set);
+  ASSERT_EQ(0, posix_spawnattr_getsigmask(&attr, &set));
+  ASSERT_EQ(1, sigismember(&set, SIGUSR1));
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR2);
+  ASSERT_EQ(0, posix_spawnattr_setsigdefault(&attr, &set));
+  sigemptyset(&set);
+  ASSERT_EQ(0, posix_spawnattr_getsigdefault(&attr, &set));
+  ASSERT_EQ(1, sigismember(&set, SIGUSR2));
+
+  int policy;
+  ASSERT_EQ(0, posix_spawnattr_setschedpolicy(&attr, SCHED_BATCH));
+  ASSERT_EQ(0, posix_spawnattr_getschedpolicy(&attr, &policy));
+  ASSERT_EQ(SCHED_BATCH, policy);
+
+  sched_param param = {};
+  param.sched_priority = 0;
+  ASSERT_EQ(0, posix_spawnattr_setschedparam(&attr, &param));
+  param.sched_priority = 99;
+  ASSERT_EQ(0, posix_spawnattr_getschedparam(&attr, &param));
+  ASSERT_EQ(0, param.sched_priority);
+
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+}
+
+static std::string SigCgtOrBlk(const char* field, const posix_spawnattr_t* attr) {
+  std::string script = std::string("grep ^") + field + ": /proc/self/status | cut -f2";
+  return SpawnShell(script.c_str(), attr);
+}
+
+TEST(spawn, posix_spawn_SETSIGMASK) {
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK));
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGALRM);  // 14 -> bit 13 -> 0x2000.
+  ASSERT_EQ(0, posix_spawnattr_setsigmask(&attr, &mask));
+
+  std::string blocked = SigCgtOrBlk("SigBlk", &attr);
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+  ASSERT_EQ("0000000000002000\n", blocked);
+}
+
+TEST(spawn, posix_spawn_inherits_sigmask) {
+  sigset_t mask, old_mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGALRM);
+  ASSERT_EQ(0, sigprocmask(SIG_SETMASK, &mask, &old_mask));
+  std::string blocked = SigCgtOrBlk("SigBlk", nullptr);
+  ASSERT_EQ(0, sigprocmask(SIG_SETMASK, &old_mask, nullptr));
+  ASSERT_EQ("0000000000002000\n", blocked);
+}
+
+TEST(spawn, posix_spawn_SETSIGDEF) {
+  // SIGALRM is ignored and stays ignored in the child; SIGCONT is reset.
+  sighandler_t old_alrm = signal(SIGALRM, SIG_IGN);
+  sighandler_t old_cont = signal(SIGCONT, SIG_IGN);
+
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF));
+  sigset_t sigdefault;
+  sigemptyset(&sigdefault);
+  sigaddset(&sigdefault, SIGCONT);
+  ASSERT_EQ(0, posix_spawnattr_setsigdefault(&attr, &sigdefault));
+
+  std::string ignored = SigCgtOrBlk("SigIgn", &attr);
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+  signal(SIGALRM, old_alrm);
+  signal(SIGCONT, old_cont);
+  // The shell may ignore other signals itself, so only check ours.
+  unsigned long long bits = strtoull(ignored.c_str(), nullptr, 16);
+  ASSERT_NE(0u, bits & (1ULL << (SIGALRM - 1)));
+  ASSERT_EQ(0u, bits & (1ULL << (SIGCONT - 1)));
+}
+
+static void NoopHandler(int) {}
+
+TEST(spawn, posix_spawn_resets_caught_signals) {
+  struct sigaction sa = {};
+  sa.sa_handler = NoopHandler;
+  struct sigaction old_sa;
+  ASSERT_EQ(0, sigaction(SIGUSR1, &sa, &old_sa));
+  std::string caught = SigCgtOrBlk("SigCgt", nullptr);
+  ASSERT_EQ(0, sigaction(SIGUSR1, &old_sa, nullptr));
+  unsigned long long bits = strtoull(caught.c_str(), nullptr, 16);
+  ASSERT_EQ(0u, bits & (1ULL << (SIGUSR1 - 1)));
+}
+
+TEST(spawn, posix_spawn_SETPGROUP) {
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP));
+  ASSERT_EQ(0, posix_spawnattr_setpgroup(&attr, 0));
+
+  // With a pgroup of 0 the child leads a new group of its own.
+  std::string output = SpawnShell("echo $$ $(cut -d' ' -f5 /proc/$$/stat)", &attr);
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+  size_t space = output.find(' ');
+  ASSERT_NE(std::string::npos, space);
+  ASSERT_EQ(output.substr(0, space) + "\n", output.substr(space + 1));
+}
+
+TEST(spawn, posix_spawn_SETSID) {
+#if defined(POSIX_SPAWN_SETSID)
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID));
+
+  std::string output = SpawnShell("echo $$ $(cut -d' ' -f6 /proc/$$/stat)", &attr);
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+  size_t space = output.find(' ');
+  ASSERT_NE(std::string::npos, space);
+  ASSERT_EQ(output.substr(0, space) + "\n", output.substr(space + 1));
+#else
+  GTEST_LOG_(INFO) << "This test requires a libc with POSIX_SPAWN_SETSID.\n";
+#endif
+}
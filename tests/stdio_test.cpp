@@ -20,15 +20,22 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <wchar.h>
 #include <locale.h>
 
+#include <string>
 #include <vector>
 
+#include <android-base/file.h>
+
 #include "BionicDeathTest.h"
 #include "TemporaryFile.h"
 #include "utils.h"
@@ -188,6 +195,79 @@ TEST(STDIO_TEST, getdelim_directory) {
   fclose(fp);
 }
 
+TEST(STDIO_TEST, getdelim_view) {
+#if defined(__BIONIC__)
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+  // A small buffer, so that the long line can't fit.
+  ASSERT_EQ(0, setvbuf(fp, nullptr, _IOFBF, 16));
+  ASSERT_EQ(0, fputs("one\ntwo\nthis line is longer than the buffer\nlast", fp));
+  rewind(fp);
+
+  const char* line;
+  char* buf = nullptr;
+  size_t buf_size = 0;
+
+  // Short lines come straight from the FILE's buffer, and aren't copied.
+  ASSERT_EQ(4, getdelim_view(&line, &buf, &buf_size, '\n', fp));
+  ASSERT_EQ("one\n", std::string(line, 4));
+  ASSERT_EQ(nullptr, buf);
+  ASSERT_EQ(4, getdelim_view(&line, &buf, &buf_size, '\n', fp));
+  ASSERT_EQ("two\n", std::string(line, 4));
+  ASSERT_EQ(nullptr, buf);
+
+  // A line that doesn't fit is copied like getdelim.
+  ASSERT_EQ(36, getdelim_view(&line, &buf, &buf_size, '\n', fp));
+  ASSERT_EQ(buf, line);
+  ASSERT_STREQ("this line is longer than the buffer\n", line);
+
+  // So is the last line if it lacks a delimiter.
+  ASSERT_EQ('l', fgetc(fp));
+  ASSERT_EQ(3, getdelim_view(&line, &buf, &buf_size, '\n', fp));
+  ASSERT_STREQ("ast", line);
+  ASSERT_TRUE(feof(fp));
+
+  errno = 0;
+  ASSERT_EQ(-1, getdelim_view(&line, &buf, &buf_size, '\n', fp));
+  ASSERT_EQ(0, errno);
+
+  free(buf);
+  fclose(fp);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
+TEST(STDIO_TEST, getdelim_view_invalid) {
+#if defined(__BIONIC__)
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+
+  const char* line;
+  char* buf = nullptr;
+  size_t buf_size = 0;
+
+  errno = 0;
+  ASSERT_EQ(-1, getdelim_view(nullptr, &buf, &buf_size, ' ', fp));
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_EQ(-1, getdelim_view(&line, nullptr, &buf_size, ' ', fp));
+  ASSERT_EQ(EINVAL, errno);
+  errno = 0;
+  ASSERT_EQ(-1, getdelim_view(&line, &buf, nullptr, ' ', fp));
+  ASSERT_EQ(EINVAL, errno);
+
+  ASSERT_EQ(0, close(fileno(fp)));
+  errno = 0;
+  ASSERT_EQ(-1, getdelim_view(&line, &buf, &buf_size, ' ', fp));
+  ASSERT_EQ(EBADF, errno);
+  ASSERT_TRUE(ferror(fp));
+  fclose(fp);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
 TEST(STDIO_TEST, getline) {
   FILE* fp = tmpfile();
   ASSERT_TRUE(fp != NULL);
@@ -255,6 +335,83 @@ TEST(STDIO_TEST, getline_invalid) {
   fclose(fp);
 }
 
+TEST(STDIO_TEST, fputws_fgetws) {
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_CTYPE, "C.UTF-8"));
+  uselocale(LC_GLOBAL_LOCALE);
+
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+
+  // Mix ASCII with one-, two-, three- and four-byte characters, and make the
+  // file longer than the stdio buffer so characters get split across refills.
+  std::wstring line(L"h¢€\U00024b62 ascii\n");
+  std::wstring contents;
+  while (contents.size() < 3 * BUFSIZ) contents += line;
+  ASSERT_NE(-1, fputws(L"", fp));
+  ASSERT_NE(-1, fputws(contents.c_str(), fp));
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(static_cast<long>(wcstombs(nullptr, contents.c_str(), 0)), ftell(fp));
+
+  // Read it back with a buffer that's too small for a whole line.
+  rewind(fp);
+  wchar_t buf[5];
+  std::wstring read;
+  while (fgetws(buf, sizeof(buf) / sizeof(*buf), fp) != nullptr) {
+    ASSERT_LE(wcslen(buf), 4U);
+    read += buf;
+  }
+  ASSERT_TRUE(feof(fp));
+  ASSERT_FALSE(ferror(fp));
+  ASSERT_EQ(contents, read);
+
+  // fgetws stops after a newline, and sees characters pushed back with ungetwc.
+  rewind(fp);
+  wchar_t line_buf[64];
+  ASSERT_EQ(line_buf, fgetws(line_buf, 64, fp));
+  ASSERT_EQ(line, line_buf);
+  ASSERT_EQ(static_cast<wint_t>(L'€'), ungetwc(L'€', fp));
+  ASSERT_EQ(line_buf, fgetws(line_buf, 3, fp));
+  ASSERT_STREQ(L"€h", line_buf);
+
+  // A buffer of one only has room for the terminator.
+  ASSERT_EQ(line_buf, fgetws(line_buf, 1, fp));
+  ASSERT_STREQ(L"", line_buf);
+  errno = 0;
+  ASSERT_EQ(nullptr, fgetws(line_buf, 0, fp));
+#if defined(__BIONIC__)
+  ASSERT_EQ(EINVAL, errno);
+#endif
+  fclose(fp);
+
+#if defined(__BIONIC__)
+  // An invalid sequence is an error, but the characters before it are read.
+  // (glibc reports the error as soon as it decodes the buffer.)
+  fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(5, write(fileno(fp), "ab\xffz\n", 5));
+  ASSERT_EQ(static_cast<wint_t>(L'a'), fgetwc(fp));
+  errno = 0;
+  ASSERT_EQ(nullptr, fgetws(line_buf, 64, fp));
+  ASSERT_EQ(EILSEQ, errno);
+  ASSERT_TRUE(ferror(fp));
+  // The bad byte is skipped, as it would be by fgetwc.
+  clearerr(fp);
+  ASSERT_EQ(line_buf, fgetws(line_buf, 64, fp));
+  ASSERT_STREQ(L"z\n", line_buf);
+  fclose(fp);
+
+  // fputws writes what comes before a character that can't be encoded.
+  fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  wchar_t bad[] = { L'o', L'k', static_cast<wchar_t>(-1), L'x', 0 };
+  errno = 0;
+  ASSERT_EQ(-1, fputws(bad, fp));
+  ASSERT_EQ(EILSEQ, errno);
+  ASSERT_EQ(2, ftell(fp));
+  fclose(fp);
+#endif
+}
+
 TEST(STDIO_TEST, printf_ssize_t) {
   // http://b/8253769
   ASSERT_EQ(sizeof(ssize_t), sizeof(long int));
@@ -579,6 +736,42 @@ TEST(STDIO_TEST, snprintf_lld_LLONG_MIN) {
   EXPECT_STREQ("-9223372036854775808", buf);
 }
 
+TEST(STDIO_TEST, snprintf_simple_conversions) {
+  // Formats made only of these conversions and literal text take a fast path.
+  char buf[BUFSIZ];
+  EXPECT_EQ(15, snprintf(buf, sizeof(buf), "%u %x", 4000000000u, 0xbeefu));
+  EXPECT_STREQ("4000000000 beef", buf);
+  snprintf(buf, sizeof(buf), "%zu %zd %zx", static_cast<size_t>(123), static_cast<ssize_t>(-4),
+           static_cast<size_t>(0xfff));
+  EXPECT_STREQ("123 -4 fff", buf);
+  snprintf(buf, sizeof(buf), "%lx %llx %lu %llu", 0xabcUL, 0x123456789abcdefULL, 0UL, ULLONG_MAX);
+  EXPECT_STREQ("abc 123456789abcdef 0 18446744073709551615", buf);
+  snprintf(buf, sizeof(buf), "%i/%c/%%/%s/%s", -7, 'z', "str", static_cast<char*>(nullptr));
+  EXPECT_STREQ("-7/z/%/str/(null)", buf);
+  snprintf(buf, sizeof(buf), "<%p>", reinterpret_cast<void*>(0x1234));
+  EXPECT_STREQ("<0x1234>", buf);
+  EXPECT_EQ(0, snprintf(buf, sizeof(buf), "%s", ""));
+  EXPECT_STREQ("", buf);
+
+  // Anything else still works.
+  snprintf(buf, sizeof(buf), "%d %5d %-3s| %02x %ld", 1, 2, "a", 3, 4L);
+  EXPECT_STREQ("1     2 a  | 03 4", buf);
+}
+
+TEST(STDIO_TEST, snprintf_simple_conversions_truncation) {
+  char buf[8];
+  memset(buf, 'x', sizeof(buf));
+  EXPECT_EQ(14, snprintf(buf, 5, "%s %d", "hello", 12345678));
+  EXPECT_STREQ("hell", buf);
+  EXPECT_EQ('x', buf[5]);
+
+  EXPECT_EQ(11, snprintf(buf, 1, "%d", INT_MIN));
+  EXPECT_STREQ("", buf);
+  EXPECT_EQ(11, snprintf(nullptr, 0, "%d", INT_MIN));
+  EXPECT_EQ(7, snprintf(buf, sizeof(buf), "%s%s", "abc", "defg"));
+  EXPECT_STREQ("abcdefg", buf);
+}
+
 TEST(STDIO_TEST, snprintf_e) {
   char buf[BUFSIZ];
 
@@ -589,6 +782,57 @@ TEST(STDIO_TEST, snprintf_e) {
   EXPECT_STREQ("1.500000e+00", buf);
 }
 
+TEST(STDIO_TEST, snprintf_double_rounding) {
+  char buf[BUFSIZ];
+
+  // Exact ties round to even.
+  snprintf(buf, sizeof(buf), "%.0f %.0f %.0f %.1f %.2f", 0.5, 1.5, 2.5, 0.25, 1.125);
+  EXPECT_STREQ("0 2 2 0.2 1.12", buf);
+  snprintf(buf, sizeof(buf), "%.0e %.1e %.3e", 2.5, 1.25, 1234.5);
+  EXPECT_STREQ("2e+00 1.2e+00 1.234e+03", buf);
+
+  // Values that are just off a tie, which rounding in double arithmetic gets wrong.
+  snprintf(buf, sizeof(buf), "%.1f %.2f %.16e", 0.35, 2.675, 0.1);
+  EXPECT_STREQ("0.3 2.67 1.0000000000000001e-01", buf);
+
+  // Rounding that carries into a new digit.
+  snprintf(buf, sizeof(buf), "%.2f %.1e %g %g", 9.999, 9.96, 999999.5, 0.00099999999);
+  EXPECT_STREQ("10.00 1.0e+01 1e+06 0.001", buf);
+
+  snprintf(buf, sizeof(buf), "%.17g %.17g %.17g", 0.1, 1.0 / 3.0, 123456789012.34567);
+  EXPECT_STREQ("0.10000000000000001 0.33333333333333331 123456789012.34567", buf);
+  snprintf(buf, sizeof(buf), "%.20f", 0.1);
+  EXPECT_STREQ("0.10000000000000000555", buf);
+  snprintf(buf, sizeof(buf), "%f %g %e", 1e22, 9007199254740993.0, 1.7976931348623157e308);
+  EXPECT_STREQ("10000000000000000000000.000000 9.0072e+15 1.797693e+308", buf);
+  snprintf(buf, sizeof(buf), "%g %.3g %.10e", 1e-10, 4.9406564584124654e-324, 5e-300);
+  EXPECT_STREQ("1e-10 4.94e-324 5.0000000000e-300", buf);
+}
+
+TEST(STDIO_TEST, snprintf_strtod_round_trip) {
+  // Formatting with %.17g and parsing the result must give back the same double.
+  uint64_t bits = 0x123456789abcdef0ULL;
+  for (size_t i = 0; i < 100000; ++i) {
+    bits = bits * 6364136223846793005ULL + 1442695040888963407ULL;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    if (isnan(d)) {
+      continue;
+    }
+    // Mix in values of everyday magnitudes, which are the ones that take the fast paths.
+    if (i % 2 == 0) {
+      d = ldexp(static_cast<double>(bits >> 11), static_cast<int>(i % 120) - 90);
+    }
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.17g", d);
+    char* end;
+    double parsed = strtod(buf, &end);
+    ASSERT_EQ(0, memcmp(&d, &parsed, sizeof(d))) << buf;
+    ASSERT_EQ('\0', *end) << buf;
+  }
+}
+
 TEST(STDIO_TEST, snprintf_negative_zero_5084292) {
   char buf[BUFSIZ];
 
@@ -762,6 +1006,46 @@ TEST(STDIO_TEST, sscanf_swscanf) {
   s.Check();
 }
 
+TEST(STDIO_TEST, sscanf_integers_and_strings) {
+  // bionic scans formats with only these conversions straight from the string.
+  int i1, i2, i3;
+  unsigned u;
+  char s1[16], s2[16];
+  ASSERT_EQ(4, sscanf("  12 -34 +56 0x1f", "%d%d%i%x", &i1, &i2, &i3, &u));
+  ASSERT_EQ(12, i1);
+  ASSERT_EQ(-34, i2);
+  ASSERT_EQ(56, i3);
+  ASSERT_EQ(0x1fU, u);
+
+  ASSERT_EQ(2, sscanf("123456", "%3d%d", &i1, &i2));
+  ASSERT_EQ(123, i1);
+  ASSERT_EQ(456, i2);
+
+  ASSERT_EQ(2, sscanf("abc,def ghi", "%[^,],%s%n", s1, s2, &i1));
+  ASSERT_STREQ("abc", s1);
+  ASSERT_STREQ("def", s2);
+  ASSERT_EQ(7, i1);
+
+  memset(s1, 'x', sizeof(s1));
+  ASSERT_EQ(1, sscanf(" ab", "%2c", s1));
+  ASSERT_EQ(' ', s1[0]);
+  ASSERT_EQ('a', s1[1]);
+  ASSERT_EQ('x', s1[2]);
+
+  ASSERT_EQ(1, sscanf("7 8", "%*d %d", &i1));
+  ASSERT_EQ(8, i1);
+  ASSERT_EQ(1, sscanf("50%", "%d%%", &i1));
+  ASSERT_EQ(50, i1);
+
+  // An empty or all-space string is an input failure, anything else a match failure.
+  ASSERT_EQ(EOF, sscanf("", "%d", &i1));
+  ASSERT_EQ(EOF, sscanf("  ", "%d", &i1));
+  ASSERT_EQ(0, sscanf("-", "%d", &i1));
+  ASSERT_EQ(0, sscanf("x", "%d", &i1));
+  ASSERT_EQ(1, sscanf("1", "%d %d", &i1, &i2));
+  ASSERT_EQ(0, sscanf(",", "%[a-z]", s1));
+}
+
 TEST(STDIO_TEST, cantwrite_EBADF) {
   // If we open a file read-only...
   FILE* fp = fopen("/proc/version", "r");
@@ -993,6 +1277,102 @@ TEST(STDIO_TEST, open_memstream_EINVAL) {
 #endif
 }
 
+#if defined(__BIONIC__)
+static std::string IovToString(const struct iovec* iov, int iovcnt) {
+  std::string result;
+  for (int i = 0; i < iovcnt; ++i) {
+    EXPECT_NE(0U, iov[i].iov_len);
+    result.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+  return result;
+}
+#endif
+
+TEST(STDIO_TEST, open_iovstream) {
+#if defined(__BIONIC__)
+  FILE* fp = open_iovstream();
+  ASSERT_TRUE(fp != nullptr);
+
+  const struct iovec* iov;
+  int iovcnt;
+  ASSERT_EQ(0, iovstream_getiov(fp, &iov, &iovcnt));
+  ASSERT_EQ(0, iovcnt);
+
+  // Mix small buffered writes, which fill chunks in place, with big fwrites
+  // that bypass the buffer, so that both cross chunk boundaries.
+  std::string expected;
+  std::string big(100000, 'x');
+  for (size_t i = 0; i < 2000; ++i) {
+    ASSERT_LT(0, fprintf(fp, "line %zu\n", i));
+    expected += "line " + std::to_string(i) + "\n";
+    ASSERT_EQ('!', fputc('!', fp));
+    expected += '!';
+    if (i % 500 == 0) {
+      ASSERT_EQ(1U, fwrite(big.data(), big.size(), 1, fp));
+      expected += big;
+    }
+  }
+
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), iovstream_getiov(fp, &iov, &iovcnt));
+  ASSERT_GT(iovcnt, 1);
+  ASSERT_EQ(expected, IovToString(iov, iovcnt));
+
+  // Writing more after looking doesn't disturb what was there.
+  ASSERT_NE(EOF, fputs("more", fp));
+  expected += "more";
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), iovstream_getiov(fp, &iov, &iovcnt));
+  ASSERT_EQ(expected, IovToString(iov, iovcnt));
+
+  // The chunks can go straight to writev.
+  TemporaryFile tf;
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), writev(tf.fd, iov, iovcnt));
+  std::string content;
+  ASSERT_TRUE(android::base::ReadFileToString(tf.filename, &content));
+  ASSERT_EQ(expected, content);
+
+  ASSERT_EQ(0, fclose(fp));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
+TEST(STDIO_TEST, open_iovstream_setvbuf) {
+#if defined(__BIONIC__)
+  FILE* fp = open_iovstream();
+  ASSERT_TRUE(fp != nullptr);
+  char buf[16];
+  ASSERT_EQ(0, setvbuf(fp, buf, _IOFBF, sizeof(buf)));
+
+  std::string expected;
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_LT(0, fprintf(fp, "%zu,", i));
+    expected += std::to_string(i) + ",";
+  }
+  const struct iovec* iov;
+  int iovcnt;
+  ASSERT_EQ(static_cast<ssize_t>(expected.size()), iovstream_getiov(fp, &iov, &iovcnt));
+  ASSERT_EQ(expected, IovToString(iov, iovcnt));
+  ASSERT_EQ(0, fclose(fp));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
+TEST(STDIO_TEST, iovstream_getiov_EINVAL) {
+#if defined(__BIONIC__)
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != nullptr);
+  const struct iovec* iov;
+  int iovcnt;
+  errno = 0;
+  ASSERT_EQ(-1, iovstream_getiov(fp, &iov, &iovcnt));
+  ASSERT_EQ(EINVAL, errno);
+  fclose(fp);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
 TEST(STDIO_TEST, fdopen_CLOEXEC) {
   int fd = open("/proc/version", O_RDONLY);
   ASSERT_TRUE(fd != -1);
@@ -1041,6 +1421,85 @@ TEST(STDIO_TEST, fopen64_freopen64) {
   fclose(fp);
 }
 
+TEST(STDIO_TEST, fopen_fclose_reuses_FILEs) {
+  // Open enough streams that stdio has to allocate more FILEs, and check that
+  // they're all distinct, both before and after closing them all and reopening.
+  std::vector<FILE*> files;
+  for (size_t i = 0; i < 64; ++i) {
+    FILE* fp = fopen("/proc/version", "r");
+    ASSERT_TRUE(fp != nullptr);
+    for (FILE* other : files) {
+      ASSERT_NE(other, fp);
+    }
+    files.push_back(fp);
+  }
+  for (FILE* fp : files) {
+    ASSERT_EQ(0, fclose(fp));
+  }
+
+  std::vector<FILE*> reopened;
+  for (size_t i = 0; i < files.size(); ++i) {
+    FILE* fp = fopen("/proc/version", "r");
+    ASSERT_TRUE(fp != nullptr);
+    for (FILE* other : reopened) {
+      ASSERT_NE(other, fp);
+    }
+    reopened.push_back(fp);
+  }
+  for (FILE* fp : reopened) {
+    ASSERT_EQ(0, fclose(fp));
+  }
+}
+
+static void* fopen_fclose_fn(void* arg) {
+  const std::string& expected = *reinterpret_cast<std::string*>(arg);
+  for (size_t i = 0; i < 1000; ++i) {
+    // If two threads were given the same FILE, they'd read each other's data.
+    FILE* fp = fopen("/proc/self/cmdline", "r");
+    if (fp == nullptr) return arg;
+    setvbuf(fp, nullptr, _IOFBF, 16);
+    std::string content;
+    int ch;
+    while ((ch = fgetc(fp)) != EOF) content += static_cast<char>(ch);
+    if (fclose(fp) != 0 || content != expected) return arg;
+  }
+  return nullptr;
+}
+
+TEST(STDIO_TEST, fopen_fclose_threads) {
+  std::string expected;
+  ASSERT_TRUE(android::base::ReadFileToString("/proc/self/cmdline", &expected));
+
+  pthread_t threads[8];
+  for (pthread_t& t : threads) {
+    ASSERT_EQ(0, pthread_create(&t, nullptr, fopen_fclose_fn, &expected));
+  }
+  for (pthread_t& t : threads) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(t, &result));
+    ASSERT_EQ(nullptr, result);
+  }
+}
+
+TEST(STDIO_TEST, freopen_closed_FILE) {
+#if defined(__BIONIC__)
+  // bionic lets you freopen a FILE you've already closed. It mustn't also be handed
+  // out to the next fopen.
+  FILE* fp = fopen("/proc/version", "r");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_EQ(fp, freopen("/proc/version", "r", fp));
+
+  FILE* other = fopen("/proc/version", "r");
+  ASSERT_TRUE(other != nullptr);
+  ASSERT_NE(fp, other);
+  ASSERT_EQ(0, fclose(other));
+  ASSERT_EQ(0, fclose(fp));
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
 // https://code.google.com/p/android/issues/detail?id=81155
 // http://b/18556607
 TEST(STDIO_TEST, fread_unbuffered_pathological_performance) {
@@ -1185,6 +1644,229 @@ TEST(STDIO_TEST, fread_after_fseek) {
   fclose(fp);
 }
 
+// Sequential reads of a regular file grow the stream's buffer, so check that
+// reads stay correct across the growth and after seeks and ungetc.
+TEST(STDIO_TEST, fread_fgetc_large_file) {
+  TemporaryFile tf;
+
+  std::vector<char> file_data(1024 * 1024);
+  for (size_t i = 0; i < file_data.size(); i++) {
+    file_data[i] = i * 7 + i / 251;
+  }
+  FILE* fp = fopen(tf.filename, "w");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(file_data.size(), fwrite(file_data.data(), 1, file_data.size(), fp));
+  fclose(fp);
+
+  fp = fopen(tf.filename, "r");
+  ASSERT_TRUE(fp != nullptr);
+
+  // Small reads, so that every byte goes through the stream's buffer.
+  char buffer[333];
+  size_t offset = 0;
+  while (offset < file_data.size() / 2) {
+    size_t n = fread(buffer, 1, sizeof(buffer), fp);
+    ASSERT_EQ(sizeof(buffer), n);
+    ASSERT_EQ(0, memcmp(&file_data[offset], buffer, n)) << offset;
+    offset += n;
+  }
+
+  ASSERT_EQ(0, fseek(fp, 12345, SEEK_SET));
+  for (size_t i = 12345; i < file_data.size(); i++) {
+    int ch = fgetc(fp);
+    ASSERT_EQ(static_cast<unsigned char>(file_data[i]), ch) << i;
+    if (i % 100000 == 0) {
+      ASSERT_EQ('x', ungetc('x', fp));
+      ASSERT_EQ('x', fgetc(fp));
+    }
+  }
+  ASSERT_EQ(EOF, fgetc(fp));
+  ASSERT_TRUE(feof(fp));
+
+  fclose(fp);
+}
+
+static void test_fwrite_large(const char* mode, int buffering) {
+  TemporaryFile tf;
+  FILE* fp = fdopen(tf.fd, mode);
+  ASSERT_TRUE(fp != nullptr);
+  tf.fd = -1;  // fclose(fp) closes it.
+  if (buffering == _IONBF) ASSERT_EQ(0, setvbuf(fp, nullptr, _IONBF, 0));
+
+  // Leave something in the buffer, then write more than a buffer's worth at once.
+  std::string expected = "buffered";
+  ASSERT_EQ(static_cast<int>(expected.size()), fprintf(fp, "%s", expected.c_str()));
+  std::string big(256 * 1024, 'x');
+  for (size_t i = 0; i < big.size(); i += 1000) big[i] = '\n';
+  ASSERT_EQ(1U, fwrite(big.data(), big.size(), 1, fp));
+  expected += big;
+  ASSERT_EQ(static_cast<long>(expected.size()), ftell(fp));
+
+  // The stream is still usable for small writes afterwards.
+  ASSERT_EQ(4U, fwrite("tail", 1, 4, fp));
+  expected += "tail";
+  ASSERT_EQ(0, fclose(fp));
+
+  std::string actual;
+  ASSERT_TRUE(android::base::ReadFileToString(tf.filename, &actual));
+  ASSERT_EQ(expected.size(), actual.size());
+  ASSERT_TRUE(expected == actual);
+}
+
+TEST(STDIO_TEST, fwrite_large) {
+  test_fwrite_large("w", _IOFBF);
+}
+
+TEST(STDIO_TEST, fwrite_large_unbuffered) {
+  test_fwrite_large("w", _IONBF);
+}
+
+TEST(STDIO_TEST, fwrite_large_append) {
+  // The fd doesn't have O_APPEND, so stdio has to seek before each write.
+  test_fwrite_large("a", _IOFBF);
+}
+
+TEST(STDIO_TEST, fwrite_large_to_full_disk) {
+  FILE* fp = fopen("/dev/full", "w");
+  ASSERT_TRUE(fp != nullptr);
+  std::vector<char> big(256 * 1024);
+  errno = 0;
+  ASSERT_EQ(0U, fwrite(big.data(), big.size(), 1, fp));
+  ASSERT_EQ(ENOSPC, errno);
+  ASSERT_TRUE(ferror(fp));
+  fclose(fp);
+}
+
+TEST(STDIO_TEST, refill_flushes_line_buffered_output) {
+#if defined(__BIONIC__) // glibc only flushes stdout.
+  // Reading from an unbuffered stream flushes partial lines written to
+  // line-buffered streams, but not output to fully buffered ones.
+  TemporaryFile line_tf;
+  FILE* line_fp = fopen(line_tf.filename, "w");
+  ASSERT_TRUE(line_fp != nullptr);
+  ASSERT_EQ(0, setvbuf(line_fp, nullptr, _IOLBF, 1024));
+  TemporaryFile full_tf;
+  FILE* full_fp = fopen(full_tf.filename, "w");
+  ASSERT_TRUE(full_fp != nullptr);
+
+  ASSERT_EQ(7, fprintf(line_fp, "partial"));
+  ASSERT_EQ(7, fprintf(full_fp, "partial"));
+  struct stat sb;
+  ASSERT_EQ(0, stat(line_tf.filename, &sb));
+  ASSERT_EQ(0, sb.st_size);
+
+  FILE* in = fopen("/dev/zero", "r");
+  ASSERT_TRUE(in != nullptr);
+  setvbuf(in, nullptr, _IONBF, 0);
+  ASSERT_EQ(0, getc(in));
+
+  ASSERT_EQ(0, stat(line_tf.filename, &sb));
+  ASSERT_EQ(7, sb.st_size);
+  ASSERT_EQ(0, stat(full_tf.filename, &sb));
+  ASSERT_EQ(0, sb.st_size);
+
+  fclose(in);
+  fclose(full_fp);
+  fclose(line_fp);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific behavior.\n";
+#endif
+}
+
+TEST(STDIO_TEST, fopen_m_mode) {
+  TemporaryFile tf;
+  ASSERT_TRUE(android::base::WriteStringToFile("hello\nworld\nlast line", tf.filename));
+
+  FILE* fp = fopen(tf.filename, "rme");
+  ASSERT_TRUE(fp != nullptr);
+
+  char buf[16];
+  ASSERT_EQ(buf, fgets(buf, sizeof(buf), fp));
+  ASSERT_STREQ("hello\n", buf);
+  ASSERT_EQ(6, ftell(fp));
+
+  ASSERT_EQ('w', getc(fp));
+  ASSERT_EQ('w', ungetc('w', fp));
+  ASSERT_EQ('X', ungetc('X', fp));
+  ASSERT_EQ('X', getc(fp));
+  ASSERT_EQ('w', getc(fp));
+  ASSERT_EQ(7, ftell(fp));
+
+  char* line = nullptr;
+  size_t line_length = 0;
+  ASSERT_EQ(5, getline(&line, &line_length, fp));
+  ASSERT_STREQ("orld\n", line);
+  ASSERT_EQ(9, getline(&line, &line_length, fp));
+  ASSERT_STREQ("last line", line);
+  ASSERT_EQ(-1, getline(&line, &line_length, fp));
+  ASSERT_TRUE(feof(fp));
+  free(line);
+
+  // Seeking works, including past the end.
+  ASSERT_EQ(0, fseek(fp, -4, SEEK_END));
+  ASSERT_EQ(4U, fread(buf, 1, sizeof(buf), fp));
+  ASSERT_EQ(0, memcmp("line", buf, 4));
+  ASSERT_EQ(0, fseek(fp, 2, SEEK_SET));
+  ASSERT_EQ(3U, fread(buf, 1, 3, fp));
+  ASSERT_EQ(0, memcmp("llo", buf, 3));
+  ASSERT_EQ(-1, fseek(fp, -100, SEEK_CUR));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(0, fseek(fp, 100, SEEK_END));
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_EQ(121, ftell(fp));
+
+  // Reads bigger than the file bypass the buffer.
+  rewind(fp);
+  char big[64];
+  ASSERT_EQ(21U, fread(big, 1, sizeof(big), fp));
+  ASSERT_EQ(0, memcmp("hello\nworld\nlast line", big, 21));
+
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(STDIO_TEST, fopen_m_mode_not_mappable) {
+  // Empty files, devices, and streams that can write all work as usual.
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.filename, "rm");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(EOF, getc(fp));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  fp = fopen("/dev/zero", "rm");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, getc(fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  fp = fopen(tf.filename, "r+m");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+  rewind(fp);
+  char buf[16];
+  ASSERT_EQ(buf, fgets(buf, sizeof(buf), fp));
+  ASSERT_STREQ("hello", buf);
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(STDIO_TEST, fopen_m_mode_setvbuf_freopen) {
+  TemporaryFile tf;
+  ASSERT_TRUE(android::base::WriteStringToFile("abc", tf.filename));
+
+  FILE* fp = fopen(tf.filename, "rm");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, setvbuf(fp, nullptr, _IOFBF, 1024));
+  ASSERT_EQ('a', getc(fp));
+
+  fp = freopen(tf.filename, "rm", fp);
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ('a', getc(fp));
+  fp = freopen(tf.filename, "r", fp);
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ('a', getc(fp));
+  ASSERT_EQ('b', getc(fp));
+  ASSERT_EQ(0, fclose(fp));
+}
+
 // https://code.google.com/p/android/issues/detail?id=184847
 TEST(STDIO_TEST, fread_EOF_184847) {
   TemporaryFile tf;
@@ -29,8 +29,16 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
 
 // The random number generator tests all set the seed, get four values, reset the seed and check
 // that they get the first two values repeated, and then reset the seed and check two more values
@@ -221,6 +229,81 @@ TEST(stdlib, qsort) {
   ASSERT_STREQ("charlie", entries[2].name);
 }
 
+// An element of the given size, holding a key and some bytes derived from it, so that
+// a sort that mixes up the bytes of different elements gets noticed.
+static std::vector<char> MakeSortInput(size_t n, size_t size, uint32_t (*key)(size_t, size_t)) {
+  std::vector<char> v(n * size);
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t k = key(i, n);
+    memcpy(&v[i * size], &k, sizeof(k));
+    for (size_t j = sizeof(k); j < size; ++j) v[i * size + j] = static_cast<char>(k * 31 + j);
+  }
+  return v;
+}
+
+static int CompareSortKeys(const void* lhs, const void* rhs) {
+  uint32_t a, b;
+  memcpy(&a, lhs, sizeof(a));
+  memcpy(&b, rhs, sizeof(b));
+  return (a > b) - (a < b);
+}
+
+static void CheckSorted(const std::vector<char>& sorted, std::vector<char> original,
+                        size_t size) {
+  size_t n = original.size() / size;
+  for (size_t i = 1; i < n; ++i) {
+    ASSERT_LE(CompareSortKeys(&sorted[(i - 1) * size], &sorted[i * size]), 0) << i;
+  }
+  // Same elements, intact: sorting the original with a known-good sort matches.
+  std::vector<std::string> a, b;
+  for (size_t i = 0; i < n; ++i) {
+    a.emplace_back(&sorted[i * size], size);
+    b.emplace_back(&original[i * size], size);
+  }
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  ASSERT_EQ(a, b);
+}
+
+TEST(stdlib, qsort_patterns) {
+  uint32_t (*patterns[])(size_t, size_t) = {
+    [](size_t i, size_t) { return static_cast<uint32_t>(i); },
+    [](size_t i, size_t n) { return static_cast<uint32_t>(n - i); },
+    [](size_t, size_t) { return 7u; },
+    [](size_t i, size_t n) { return static_cast<uint32_t>(i < n / 2 ? i : n - i); },
+    [](size_t i, size_t) { return static_cast<uint32_t>(i % 3); },
+    [](size_t i, size_t) { return static_cast<uint32_t>((i * 2654435761u) % 1000); },
+  };
+  for (size_t size : { 4, 5, 8, 12, 16, 24 }) {
+    for (size_t n : { 0, 1, 2, 3, 15, 16, 17, 100, 1000, 5000 }) {
+      for (auto pattern : patterns) {
+        std::vector<char> original = MakeSortInput(n, size, pattern);
+        std::vector<char> v = original;
+        qsort(v.data(), n, size, CompareSortKeys);
+        CheckSorted(v, original, size);
+      }
+    }
+  }
+}
+
+TEST(stdlib, qsort_r) {
+  struct Context {
+    size_t calls;
+    static int Compare(const void* lhs, const void* rhs, void* arg) {
+      ++reinterpret_cast<Context*>(arg)->calls;
+      return CompareSortKeys(lhs, rhs);
+    }
+  };
+  std::vector<char> original = MakeSortInput(1000, sizeof(uint32_t), [](size_t i, size_t) {
+    return static_cast<uint32_t>((i * 2654435761u) % 997);
+  });
+  std::vector<char> v = original;
+  Context context = {};
+  qsort_r(v.data(), 1000, sizeof(uint32_t), Context::Compare, &context);
+  CheckSorted(v, original, sizeof(uint32_t));
+  ASSERT_GT(context.calls, 0U);
+}
+
 static void* TestBug57421_child(void* arg) {
   pthread_t main_thread = reinterpret_cast<pthread_t>(arg);
   pthread_join(main_thread, NULL);
@@ -372,6 +455,51 @@ TEST(stdlib, strtod_largest_subnormal) {
   ASSERT_EQ(-2.2250738585072014e-308, strtod("-2.2250738585072012e-308", NULL));
 }
 
+TEST(stdlib, strtod_rounding) {
+  // Halfway between two doubles, so this rounds to even.
+  ASSERT_EQ(9007199254740992.0, strtod("9007199254740993", nullptr));
+  ASSERT_EQ(9007199254740996.0, strtod("9007199254740995", nullptr));
+  // Just above halfway.
+  ASSERT_EQ(9007199254740994.0, strtod("9007199254740993.0000001", nullptr));
+  ASSERT_EQ(9007199254740994.0, strtod("9.007199254740993000001e15", nullptr));
+
+  ASSERT_EQ(0.1, strtod("0.1", nullptr));
+  ASSERT_EQ(0.1, strtod("0.10000000000000001", nullptr));
+  ASSERT_EQ(1.0 / 3.0, strtod("0.33333333333333331", nullptr));
+  ASSERT_EQ(1e-21, strtod("1e-21", nullptr));
+  ASSERT_EQ(1e22, strtod("1e22", nullptr));
+  ASSERT_EQ(1e23, strtod("1e23", nullptr));
+  ASSERT_EQ(123456789012345678.0, strtod("123456789012345678", nullptr));
+  ASSERT_EQ(-1.5e-5, strtod("-.000015", nullptr));
+  ASSERT_EQ(1.5, strtod("+1.5e+0", nullptr));
+}
+
+TEST(stdlib, strtod_end) {
+  const char* s = "  -12.5e3x";
+  char* end;
+  ASSERT_EQ(-12500.0, strtod(s, &end));
+  ASSERT_EQ(s + 9, end);
+
+  // An exponent with no digits isn't part of the number.
+  s = "1.5e+";
+  ASSERT_EQ(1.5, strtod(s, &end));
+  ASSERT_EQ(s + 3, end);
+
+  s = "-0.000e5,";
+  double d = strtod(s, &end);
+  ASSERT_EQ(0.0, d);
+  ASSERT_TRUE(signbit(d));
+  ASSERT_EQ(s + 8, end);
+
+  s = "0x10";
+  ASSERT_EQ(16.0, strtod(s, &end));
+  ASSERT_EQ(s + 4, end);
+
+  s = "-.e1";
+  ASSERT_EQ(0.0, strtod(s, &end));
+  ASSERT_EQ(s, end);
+}
+
 TEST(stdlib, quick_exit) {
   pid_t pid = fork();
   ASSERT_NE(-1, pid) << strerror(errno);
@@ -570,6 +698,65 @@ TEST(stdlib, strtoull_EINVAL) {
   ASSERT_EQ(EINVAL, errno);
 }
 
+// Long runs of decimal digits are parsed 8 at a time, so check that overflow
+// and the end pointer are right at every length, and when the string ends at
+// the end of a page.
+template <typename T>
+static void CheckStrToIDecimal(T fn(const char*, char**, int), const char* max, const char* over) {
+  std::string digits = max;
+  for (size_t len = 1; len <= digits.size(); ++len) {
+    std::string s = digits.substr(0, len) + "z";
+    char* end;
+    errno = 0;
+    T value = fn(s.c_str(), &end, 10);
+    ASSERT_EQ(0, errno) << s;
+    ASSERT_EQ(std::to_string(value), digits.substr(0, len)) << s;
+    ASSERT_EQ(s.c_str() + len, end) << s;
+  }
+
+  char* end;
+  errno = 0;
+  ASSERT_EQ(std::numeric_limits<T>::max(), fn(over, &end, 10));
+  ASSERT_EQ(ERANGE, errno);
+  ASSERT_EQ(over + strlen(over), end);
+
+  size_t page_size = sysconf(_SC_PAGE_SIZE);
+  char* page = reinterpret_cast<char*>(mmap(nullptr, 2 * page_size, PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(MAP_FAILED, page);
+  ASSERT_EQ(0, mprotect(page + page_size, page_size, PROT_NONE));
+  for (size_t len = 1; len <= 12; ++len) {
+    char* s = page + page_size - (len + 1);
+    memset(s, '1', len);
+    s[len] = '\0';
+    errno = 0;
+    ASSERT_EQ(std::stoull(s), static_cast<unsigned long long>(fn(s, &end, 10))) << s;
+    ASSERT_EQ(0, errno);
+    ASSERT_EQ(s + len, end);
+  }
+  munmap(page, 2 * page_size);
+}
+
+TEST(stdlib, strtol_decimal) {
+  if (sizeof(long) == 8) {
+    CheckStrToIDecimal(strtol, "9223372036854775807", "9223372036854775808");
+  } else {
+    CheckStrToIDecimal(strtol, "2147483647", "2147483648");
+  }
+  errno = 0;
+  ASSERT_EQ(std::numeric_limits<long long>::min(), strtoll("-9223372036854775808", nullptr, 10));
+  ASSERT_EQ(0, errno);
+  ASSERT_EQ(std::numeric_limits<long long>::min(), strtoll("-9223372036854775809", nullptr, 10));
+  ASSERT_EQ(ERANGE, errno);
+}
+
+TEST(stdlib, strtoull_decimal) {
+  CheckStrToIDecimal(strtoull, "18446744073709551615", "184467440737095516150000");
+  errno = 0;
+  ASSERT_EQ(1ULL + ~12345678901ULL, strtoull("  -12345678901", nullptr, 10));
+  ASSERT_EQ(0, errno);
+}
+
 TEST(stdlib, getsubopt) {
   char* const tokens[] = {
     const_cast<char*>("a"),
@@ -615,3 +802,61 @@ TEST(stdlib, mblen) {
   // "mblen() shall ... return 0 (if s points to the null byte)".
   EXPECT_EQ(0, mblen("", 1));
 }
+
+#if defined(__BIONIC__)
+static void* arc4random_buf_fn(void* arg) {
+  arc4random_buf(arg, 64);
+  return nullptr;
+}
+#endif
+
+TEST(stdlib, arc4random_buf_threads) {
+#if defined(__BIONIC__)
+  // Each thread has its own generator, and they must not share a keystream.
+  constexpr size_t kThreads = 8;
+  uint8_t bufs[kThreads][64];
+  pthread_t threads[kThreads];
+  for (size_t i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], nullptr, arc4random_buf_fn, bufs[i]));
+  }
+  for (size_t i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], nullptr));
+  }
+  for (size_t i = 0; i < kThreads; ++i) {
+    for (size_t j = i + 1; j < kThreads; ++j) {
+      ASSERT_NE(0, memcmp(bufs[i], bufs[j], sizeof(bufs[i])));
+    }
+  }
+#else
+  GTEST_LOG_(INFO) << "This test requires a libc with arc4random.\n";
+#endif
+}
+
+TEST(stdlib, arc4random_fork) {
+#if defined(__BIONIC__)
+  // Use this thread's generator before the fork, so the child inherits its state.
+  arc4random();
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    uint8_t buf[64];
+    arc4random_buf(buf, sizeof(buf));
+    _exit(write(fds[1], buf, sizeof(buf)) == sizeof(buf) ? 0 : 1);
+  }
+  uint8_t child_buf[64];
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(child_buf)),
+            TEMP_FAILURE_RETRY(read(fds[0], child_buf, sizeof(child_buf))));
+  AssertChildExited(pid, 0);
+  close(fds[0]);
+  close(fds[1]);
+
+  uint8_t parent_buf[64];
+  arc4random_buf(parent_buf, sizeof(parent_buf));
+  ASSERT_NE(0, memcmp(child_buf, parent_buf, sizeof(parent_buf)));
+#else
+  GTEST_LOG_(INFO) << "This test requires a libc with arc4random.\n";
+#endif
+}
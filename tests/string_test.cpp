@@ -23,8 +23,10 @@
 #include <malloc.h>
 #include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 #include "buffer_tests.h"
@@ -955,6 +957,29 @@ TEST(STRING_TEST, memmove_cache_size) {
   free(glob_ptr2);
 }
 
+// Sets and copies this big use non-temporal stores on some architectures.
+TEST(STRING_TEST, memset_memcpy_huge) {
+  const size_t len = 32 * 1024 * 1024 + 37;
+  std::vector<char> src(len + 16);
+  std::vector<char> dst(len + 16, 'x');
+
+  ASSERT_EQ(&src[3], memset(&src[3], 'S', len));
+  for (size_t i = 0; i < src.size(); ++i) {
+    ASSERT_EQ((i >= 3 && i < len + 3) ? 'S' : 0, src[i]) << i;
+  }
+  for (size_t i = 0; i < len; i += 4096) {
+    src[i + 3] = static_cast<char>(i / 4096);
+  }
+
+  ASSERT_EQ(&dst[5], memcpy(&dst[5], &src[3], len));
+  ASSERT_EQ('x', dst[4]);
+  ASSERT_EQ(0, memcmp(&dst[5], &src[3], len));
+  ASSERT_EQ('x', dst[len + 5]);
+
+  ASSERT_EQ(&dst[1], memmove(&dst[1], &src[3], len));
+  ASSERT_EQ(0, memcmp(&dst[1], &src[3], len));
+}
+
 static void verify_memmove(char* src_copy, char* dst, char* src, size_t size) {
   memset(dst, 0, size);
   memcpy(src, src_copy, size);
@@ -1484,3 +1509,46 @@ TEST(STRING_TEST, strstr_smoke) {
   ASSERT_EQ(haystack + 1, strstr(haystack, "i"));
   ASSERT_EQ(haystack + 4, strstr(haystack, "da"));
 }
+
+// Haystacks full of near misses make memmem and strstr give up on comparing at each
+// candidate and use the two-way algorithm.
+TEST(STRING_TEST, memmem_strstr_near_misses) {
+  std::string haystack(64 * 1024, 'a');
+  std::string needle = std::string(99, 'a') + "b";
+  ASSERT_EQ(nullptr, memmem(haystack.data(), haystack.size(), needle.data(), needle.size()));
+  ASSERT_EQ(nullptr, strstr(haystack.c_str(), needle.c_str()));
+
+  haystack.replace(haystack.size() - 300, needle.size(), needle);
+  const char* expected = haystack.c_str() + haystack.size() - 300;
+  ASSERT_EQ(expected, memmem(haystack.data(), haystack.size(), needle.data(), needle.size()));
+  ASSERT_EQ(expected, strstr(haystack.c_str(), needle.c_str()));
+
+  // A periodic needle, with a match that overlaps a near miss.
+  haystack.assign(64 * 1024, 'x');
+  for (size_t i = 0; i + 3 <= haystack.size(); i += 3) haystack.replace(i, 3, "aab");
+  needle = "aabaabaabaac";
+  ASSERT_EQ(nullptr, memmem(haystack.data(), haystack.size(), needle.data(), needle.size()));
+  ASSERT_EQ(nullptr, strstr(haystack.c_str(), needle.c_str()));
+  haystack.replace(39999, 3, "aac");
+  expected = haystack.c_str() + 39999 - 9;
+  ASSERT_EQ(expected, memmem(haystack.data(), haystack.size(), needle.data(), needle.size()));
+  ASSERT_EQ(expected, strstr(haystack.c_str(), needle.c_str()));
+}
+
+TEST(STRING_TEST, memmem_strstr_random) {
+  // Small alphabets give lots of partial matches.
+  srand(1234);
+  for (size_t iteration = 0; iteration < 20000; ++iteration) {
+    size_t alphabet = 1 + (iteration % 3);
+    std::string haystack(rand() % 300, 'a');
+    for (char& c : haystack) c = 'a' + rand() % alphabet;
+    std::string needle(1 + rand() % 12, 'a');
+    for (char& c : needle) c = 'a' + rand() % alphabet;
+
+    size_t pos = haystack.find(needle);
+    const char* expected = (pos == std::string::npos) ? nullptr : haystack.c_str() + pos;
+    ASSERT_EQ(expected, memmem(haystack.data(), haystack.size(), needle.data(), needle.size()))
+        << haystack << " " << needle;
+    ASSERT_EQ(expected, strstr(haystack.c_str(), needle.c_str())) << haystack << " " << needle;
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+
+#if defined(__BIONIC__)
+#include <sys/membarrier.h>
+
+#include "private/bionic_membarrier.h"
+#endif
+
+TEST(sys_membarrier, query) {
+#if defined(__BIONIC__)
+  int commands = membarrier(MEMBARRIER_CMD_QUERY, 0);
+  if (commands == -1) {
+    ASSERT_EQ(ENOSYS, errno);
+    GTEST_LOG_(INFO) << "This kernel doesn't support membarrier.\n";
+    return;
+  }
+  ASSERT_GE(commands, 0);
+
+  errno = 0;
+  ASSERT_EQ(-1, membarrier(MEMBARRIER_CMD_QUERY, 1));
+  ASSERT_EQ(EINVAL, errno);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(sys_membarrier, private_expedited) {
+#if defined(__BIONIC__)
+  int commands = membarrier(MEMBARRIER_CMD_QUERY, 0);
+  if (commands == -1 || (commands & BIONIC_MEMBARRIER_CMD_PRIVATE_EXPEDITED) == 0) {
+    GTEST_LOG_(INFO) << "This kernel doesn't support MEMBARRIER_CMD_PRIVATE_EXPEDITED.\n";
+    return;
+  }
+  // libc may have registered already; registering again is fine.
+  ASSERT_EQ(0, membarrier(BIONIC_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0));
+  ASSERT_EQ(0, membarrier(BIONIC_MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <sched.h>
 #include <sys/sysinfo.h>
 #include <unistd.h>
 
@@ -42,3 +43,37 @@ TEST(sys_sysinfo, sysinfo) {
   memset(&si, 0, sizeof(si));
   ASSERT_EQ(0, sysinfo(&si));
 }
+
+TEST(sys_sysinfo, get_nprocs_available) {
+#if defined(__BIONIC__)
+  int available = get_nprocs_available();
+  ASSERT_GT(available, 0);
+  ASSERT_LE(available, get_nprocs());
+
+  // It follows this thread's affinity.
+  cpu_set_t old_set;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(old_set), &old_set));
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(sched_getcpu(), &set);
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(set), &set));
+  ASSERT_EQ(1, get_nprocs_available());
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(old_set), &old_set));
+  ASSERT_EQ(available, get_nprocs_available());
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(sys_sysinfo, get_nprocs_repeated) {
+  // The counts are cached, but shouldn't go stale.
+  int nprocs = get_nprocs();
+  int nprocs_conf = get_nprocs_conf();
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(nprocs, get_nprocs());
+    ASSERT_EQ(nprocs_conf, get_nprocs_conf());
+  }
+  usleep(200000);
+  ASSERT_EQ(nprocs, get_nprocs());
+  ASSERT_EQ(nprocs_conf, get_nprocs_conf());
+}
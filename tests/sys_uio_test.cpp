@@ -68,6 +68,61 @@ TEST(sys_uio, preadv64_pwritev64) {
   TestPreadVPwriteV(preadv64, pwritev64);
 }
 
+TEST(sys_uio, preadv2_pwritev2) {
+#if defined(__BIONIC__)
+  TestPreadVPwriteV([](int fd, const iovec* ios, int count, off_t offset) {
+    return preadv2(fd, ios, count, offset, 0);
+  }, [](int fd, const iovec* ios, int count, off_t offset) {
+    return pwritev2(fd, ios, count, offset, 0);
+  });
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(sys_uio, preadv64v2_pwritev64v2) {
+#if defined(__BIONIC__)
+  TestPreadVPwriteV([](int fd, const iovec* ios, int count, off64_t offset) {
+    return preadv64v2(fd, ios, count, offset, 0);
+  }, [](int fd, const iovec* ios, int count, off64_t offset) {
+    return pwritev64v2(fd, ios, count, offset, 0);
+  });
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(sys_uio, preadv2_pwritev2_current_offset) {
+#if defined(__BIONIC__)
+  TemporaryFile tf;
+
+  char buf[] = "hello";
+  iovec ios[] = { { buf, 5 } };
+
+  // An offset of -1 uses and updates the file offset, like readv/writev.
+  ssize_t rc = pwritev2(tf.fd, ios, 1, -1, 0);
+  if (rc == -1 && errno == ENOSYS) {
+    GTEST_LOG_(INFO) << "This test requires a kernel with pwritev2.\n";
+    return;
+  }
+  ASSERT_EQ(5, rc);
+  ASSERT_EQ(5, lseek(tf.fd, 0, SEEK_CUR));
+
+  ASSERT_EQ(0, lseek(tf.fd, 0, SEEK_SET));
+  memset(buf, 0, sizeof(buf));
+  ASSERT_EQ(5, preadv2(tf.fd, ios, 1, -1, 0));
+  ASSERT_STREQ("hello", buf);
+  ASSERT_EQ(5, lseek(tf.fd, 0, SEEK_CUR));
+
+  // Unknown flags are rejected.
+  errno = 0;
+  ASSERT_EQ(-1, preadv2(tf.fd, ios, 1, 0, ~0));
+  ASSERT_TRUE(errno == EOPNOTSUPP || errno == EINVAL);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(sys_uio, process_vm_readv) {
   ASSERT_EQ(0, process_vm_readv(0, nullptr, 0, nullptr, 0, 0));
 
@@ -18,11 +18,14 @@
 #include "BionicDeathTest.h"
 
 #include <errno.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
 
 #if defined(__BIONIC__)
 
@@ -60,6 +63,7 @@ struct LocalPropertyTestState {
         rmdir(pa_dirname.c_str());
     }
 public:
+    const std::string& filename() const { return pa_filename; }
     bool valid;
 private:
     std::string pa_dirname;
@@ -147,6 +151,117 @@ TEST(properties, __system_property_add) {
 #endif // __BIONIC__
 }
 
+TEST(properties, __system_property_get_many) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(0, __system_property_add("ro.property", 11, "value2", 6));
+    ASSERT_EQ(0, __system_property_add("persist.property", 16, "value3", 6));
+
+    const char* names[] = { "property", "missing", "persist.property", "ro.property" };
+    char values[4][PROP_VALUE_MAX];
+    char* value_ptrs[] = { values[0], values[1], values[2], values[3] };
+    memset(values, 'x', sizeof(values));
+
+    ASSERT_EQ(3U, __system_property_get_many(names, value_ptrs, 4));
+    ASSERT_STREQ("value1", values[0]);
+    ASSERT_STREQ("", values[1]);
+    ASSERT_STREQ("value3", values[2]);
+    ASSERT_STREQ("value2", values[3]);
+
+    ASSERT_EQ(0U, __system_property_get_many(names, value_ptrs, 0));
+
+    // More names than are handled in one chunk.
+    std::vector<std::string> many_names;
+    for (size_t i = 0; i < 200; i++) {
+        many_names.push_back("property" + std::to_string(i));
+        if (i % 2 == 0) {
+            ASSERT_EQ(0, __system_property_add(many_names[i].c_str(), many_names[i].size(),
+                                               many_names[i].c_str(), many_names[i].size()));
+        }
+    }
+    std::vector<const char*> many_name_ptrs;
+    std::vector<std::vector<char>> many_values(many_names.size(),
+                                               std::vector<char>(PROP_VALUE_MAX));
+    std::vector<char*> many_value_ptrs;
+    for (size_t i = 0; i < many_names.size(); i++) {
+        many_name_ptrs.push_back(many_names[i].c_str());
+        many_value_ptrs.push_back(many_values[i].data());
+    }
+    ASSERT_EQ(100U, __system_property_get_many(many_name_ptrs.data(), many_value_ptrs.data(),
+                                               many_names.size()));
+    for (size_t i = 0; i < many_names.size(); i++) {
+        ASSERT_STREQ(i % 2 == 0 ? many_names[i].c_str() : "", many_value_ptrs[i]);
+    }
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, long_read_only_value) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    std::string long_value(1024, 'x');
+    ASSERT_EQ(0, __system_property_add("ro.long", 7, long_value.c_str(), long_value.size()));
+    // Only read-only properties can have long values.
+    ASSERT_EQ(-1, __system_property_add("long", 4, long_value.c_str(), long_value.size()));
+
+    const prop_info* pi = __system_property_find("ro.long");
+    ASSERT_TRUE(pi != nullptr);
+
+    __system_property_read_callback(pi,
+      [](void* cookie, const char* name, const char* value, unsigned /*serial*/) {
+        ASSERT_STREQ("ro.long", name);
+        ASSERT_EQ(*static_cast<std::string*>(cookie), value);
+    }, &long_value);
+
+    // The fixed-size APIs get a message rather than a truncated value.
+    char propvalue[PROP_VALUE_MAX];
+    ASSERT_EQ(50, __system_property_get("ro.long", propvalue));
+    ASSERT_STREQ("Must use __system_property_read_callback() to read", propvalue);
+
+    // Long values never change.
+    ASSERT_EQ(-1, __system_property_update(const_cast<prop_info*>(pi), "short", 5));
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, __system_property_read_stable) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    std::string long_value(200, 'y');
+    ASSERT_EQ(0, __system_property_add("ro.short", 8, "value", 5));
+    ASSERT_EQ(0, __system_property_add("ro.long", 7, long_value.c_str(), long_value.size()));
+    ASSERT_EQ(0, __system_property_add("property", 8, "value", 5));
+
+    const prop_info* pi = __system_property_find("ro.short");
+    ASSERT_TRUE(pi != nullptr);
+    uint32_t serial = 0;
+    const char* value = __system_property_read_stable(pi, &serial);
+    ASSERT_STREQ("value", value);
+    ASSERT_EQ(__system_property_serial(pi), serial);
+    // The same storage every time.
+    ASSERT_EQ(value, __system_property_read_stable(pi, nullptr));
+
+    pi = __system_property_find("ro.long");
+    ASSERT_TRUE(pi != nullptr);
+    ASSERT_EQ(long_value, __system_property_read_stable(pi, nullptr));
+
+    pi = __system_property_find("property");
+    ASSERT_TRUE(pi != nullptr);
+    ASSERT_TRUE(__system_property_read_stable(pi, nullptr) == nullptr);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, __system_property_update) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -182,6 +297,42 @@ TEST(properties, __system_property_update) {
 #endif // __BIONIC__
 }
 
+TEST(properties, read_during_update) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    // Readers racing with the writer see either the old value or the new one, whole.
+    const std::string short_value(20, 'a');
+    const std::string long_value(PROP_VALUE_MAX - 1, 'b');
+    ASSERT_EQ(0, __system_property_add("property", 8, short_value.c_str(), short_value.size()));
+    prop_info* pi = const_cast<prop_info*>(__system_property_find("property"));
+    ASSERT_TRUE(pi != nullptr);
+
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+      for (size_t i = 0; i < 20000; ++i) {
+        const std::string& value = (i % 2) ? short_value : long_value;
+        __system_property_update(pi, value.c_str(), value.size());
+      }
+      done = true;
+    });
+    while (!done) {
+      char value[PROP_VALUE_MAX];
+      int len = __system_property_read(pi, nullptr, value);
+      ASSERT_EQ(static_cast<size_t>(len), strlen(value));
+      ASSERT_TRUE(value == short_value || value == long_value) << value;
+      __system_property_read_callback(pi, [](void*, const char*, const char* value, uint32_t serial) {
+        ASSERT_EQ(0U, serial & 1);
+        ASSERT_EQ(serial >> 24, strlen(value));
+      }, nullptr);
+    }
+    writer.join();
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, fill) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -227,6 +378,37 @@ TEST(properties, fill) {
 #endif // __BIONIC__
 }
 
+TEST(properties, fill_short_names) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    char prop_name[PROP_NAME_MAX];
+    char prop_value[PROP_VALUE_MAX];
+    int count = 0;
+
+    // Short names fit more properties in an area than its hash index takes,
+    // so the later ones can only be found through the trie.
+    while (true) {
+        int len = snprintf(prop_name, sizeof(prop_name), "p%d", count);
+        if (__system_property_add(prop_name, len, "v", 1) < 0) {
+            break;
+        }
+        count++;
+    }
+    ASSERT_GE(count, 247);
+
+    for (int i = 0; i < count; i++) {
+        snprintf(prop_name, sizeof(prop_name), "p%d", i);
+        ASSERT_EQ(1, __system_property_get(prop_name, prop_value)) << prop_name;
+        ASSERT_STREQ("v", prop_value);
+    }
+    snprintf(prop_name, sizeof(prop_name), "p%d", count);
+    ASSERT_TRUE(__system_property_find(prop_name) == nullptr);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, __system_property_foreach) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -330,6 +512,54 @@ TEST(properties, fill_hierarchical) {
 #endif // __BIONIC__
 }
 
+TEST(properties, property_info) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    // The prefix to context map is written out for other processes to map.
+    struct stat sb;
+    ASSERT_EQ(0, stat((pa.filename() + "/property_info").c_str(), &sb));
+    ASSERT_GT(sb.st_size, 0);
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(0, __system_property_add("ro.property", 11, "value2", 6));
+    ASSERT_EQ(0, __system_property_add("persist.property", 16, "value3", 6));
+
+    char propvalue[PROP_VALUE_MAX];
+    ASSERT_EQ(6, __system_property_get("property", propvalue));
+    ASSERT_STREQ("value1", propvalue);
+    ASSERT_EQ(6, __system_property_get("ro.property", propvalue));
+    ASSERT_STREQ("value2", propvalue);
+    ASSERT_EQ(6, __system_property_get("persist.property", propvalue));
+    ASSERT_STREQ("value3", propvalue);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, __system_property_area_stats) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    char propvalue[PROP_VALUE_MAX];
+    ASSERT_EQ(6, __system_property_get("property", propvalue));
+
+    prop_area_stats stats;
+    ASSERT_EQ(0, __system_property_area_stats(&stats));
+    // At least the serial area and the area "property" lives in.
+    ASSERT_GE(stats.areas_mapped, 2U);
+    ASSERT_GT(stats.bytes_used, 0U);
+    ASSERT_LE(stats.bytes_used, stats.bytes_mapped);
+    ASSERT_GT(stats.bytes_resident, 0U);
+    ASSERT_LE(stats.bytes_resident, stats.bytes_mapped);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(properties, errors) {
 #if defined(__BIONIC__)
     LocalPropertyTestState pa;
@@ -425,6 +655,130 @@ TEST(properties, __system_property_wait) {
 #endif // __BIONIC__
 }
 
+TEST(properties, __system_property_wait_set) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    ASSERT_EQ(0, __system_property_add("property1", 9, "value1", 6));
+    ASSERT_EQ(0, __system_property_add("property2", 9, "value2", 6));
+    ASSERT_EQ(0, __system_property_add("other_property", 14, "value", 5));
+
+    const prop_info* pis[2];
+    pis[0] = __system_property_find("property1");
+    pis[1] = __system_property_find("property2");
+    ASSERT_TRUE(pis[0] != nullptr);
+    ASSERT_TRUE(pis[1] != nullptr);
+    uint32_t serials[2] = { __system_property_serial(pis[0]), __system_property_serial(pis[1]) };
+
+    // Changes to other properties don't end the wait.
+    std::thread thread([]() {
+        prop_info* other = const_cast<prop_info*>(__system_property_find("other_property"));
+        prop_info* pi = const_cast<prop_info*>(__system_property_find("property2"));
+        usleep(100000);
+        __system_property_update(other, "value-1", 7);
+        usleep(100000);
+        __system_property_update(pi, "value2-1", 8);
+    });
+
+    size_t changed;
+    ASSERT_TRUE(__system_property_wait_set(pis, serials, 2, &changed, nullptr));
+    ASSERT_EQ(1U, changed);
+    char value[PROP_VALUE_MAX];
+    ASSERT_EQ(8, __system_property_get("property2", value));
+    ASSERT_STREQ("value2-1", value);
+    thread.join();
+
+    // An already changed serial returns immediately.
+    ASSERT_TRUE(__system_property_wait_set(pis, serials, 2, &changed, nullptr));
+    ASSERT_EQ(1U, changed);
+
+    serials[1] = __system_property_serial(pis[1]);
+    timespec timeout = { 0, 10000000 };
+    ASSERT_FALSE(__system_property_wait_set(pis, serials, 2, &changed, &timeout));
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, __system_property_cache) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    // The property doesn't have to exist yet.
+    prop_cache* cache = __system_property_cache_create("property");
+    ASSERT_TRUE(cache != nullptr);
+
+    char value[PROP_VALUE_MAX];
+    ASSERT_EQ(0U, __system_property_cache_serial(cache));
+    ASSERT_EQ(0U, __system_property_cache_read(cache, value));
+    ASSERT_STREQ("", value);
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    uint32_t serial = __system_property_cache_read(cache, value);
+    ASSERT_STREQ("value1", value);
+    ASSERT_EQ(serial, __system_property_cache_serial(cache));
+
+    prop_info* pi = const_cast<prop_info*>(__system_property_find("property"));
+    ASSERT_TRUE(pi != nullptr);
+    ASSERT_EQ(0, __system_property_update(pi, "value2", 6));
+    uint32_t new_serial = __system_property_cache_serial(cache);
+    ASSERT_NE(serial, new_serial);
+    ASSERT_EQ(new_serial, __system_property_cache_read(cache, value));
+    ASSERT_STREQ("value2", value);
+
+    __system_property_cache_destroy(cache);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(properties, __system_property_cache_wait) {
+#if defined(__BIONIC__)
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+
+    prop_cache* cache = __system_property_cache_create("property");
+    ASSERT_TRUE(cache != nullptr);
+
+    // Wait for the property to be created...
+    std::thread add_thread([]() {
+        usleep(100000);
+        __system_property_add("other_property", 14, "value", 5);
+        usleep(100000);
+        __system_property_add("property", 8, "value1", 6);
+    });
+    uint32_t serial;
+    ASSERT_TRUE(__system_property_cache_wait(cache, 0, &serial, nullptr));
+    char value[PROP_VALUE_MAX];
+    ASSERT_EQ(serial, __system_property_cache_read(cache, value));
+    ASSERT_STREQ("value1", value);
+    add_thread.join();
+
+    // ...and then for it to change.
+    std::thread update_thread([]() {
+        usleep(100000);
+        prop_info* pi = const_cast<prop_info*>(__system_property_find("property"));
+        __system_property_update(pi, "value2", 6);
+    });
+    uint32_t new_serial;
+    ASSERT_TRUE(__system_property_cache_wait(cache, serial, &new_serial, nullptr));
+    ASSERT_NE(serial, new_serial);
+    __system_property_cache_read(cache, value);
+    ASSERT_STREQ("value2", value);
+    update_thread.join();
+
+    // Nothing changes, so this times out.
+    timespec timeout = { 0, 10000000 };
+    ASSERT_FALSE(__system_property_cache_wait(cache, new_serial, &serial, &timeout));
+
+    __system_property_cache_destroy(cache);
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 class KilledByFault {
     public:
         explicit KilledByFault() {};
@@ -23,7 +23,8 @@
 #include <string>
 
 #if defined(__BIONIC__)
-#include <sys/system_properties.h>
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h>
 
 static uint64_t NanoTime() {
   timespec now;
@@ -146,3 +147,39 @@ TEST(properties, empty_value) {
     GTEST_LOG_(INFO) << "This test does nothing.\n";
 #endif // __BIONIC__
 }
+
+TEST(properties, __system_property_set_many) {
+#if defined(__BIONIC__)
+    ASSERT_GE(__system_property_service_protocol_version(), 1U);
+
+    char propvalue[PROP_VALUE_MAX];
+
+    std::stringstream ss;
+    ss << "debug.test." << getpid() << "." << NanoTime() << ".";
+    const std::string property_prefix = ss.str();
+    const std::string name1 = property_prefix + "property1";
+    const std::string name2 = property_prefix + "property2";
+    const std::string name3 = property_prefix + "property3";
+
+    const char* keys[] = { name1.c_str(), name2.c_str(), name3.c_str() };
+    const char* values[] = { "value1", nullptr, "value3" };
+    ASSERT_EQ(0, __system_property_set_many(keys, values, 3));
+    ASSERT_EQ(6, __system_property_get(name1.c_str(), propvalue));
+    ASSERT_STREQ("value1", propvalue);
+    ASSERT_EQ(0, __system_property_get(name2.c_str(), propvalue));
+    ASSERT_STREQ("", propvalue);
+    ASSERT_EQ(6, __system_property_get(name3.c_str(), propvalue));
+    ASSERT_STREQ("value3", propvalue);
+
+    // A value that is too long is rejected before anything is sent.
+    std::string long_value(PROP_VALUE_MAX, 'y');
+    const char* bad_values[] = { "value1-1", long_value.c_str(), "value3-1" };
+    ASSERT_EQ(-1, __system_property_set_many(keys, bad_values, 3));
+    ASSERT_EQ(6, __system_property_get(name1.c_str(), propvalue));
+    ASSERT_STREQ("value1", propvalue);
+
+    ASSERT_EQ(0, __system_property_set_many(keys, values, 0));
+#else // __BIONIC__
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
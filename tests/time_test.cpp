@@ -25,12 +25,20 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <atomic>
+#include <set>
 
 #include "ScopedSignalHandler.h"
+#include "TemporaryFile.h"
 #include "utils.h"
 
 #include "private/bionic_constants.h"
 
+#if defined(__BIONIC__)
+#include <android/strftime.h>
+
+extern "C" int android_tzstate_write(int fd);
+#endif
+
 TEST(time, gmtime) {
   time_t t = 0;
   tm* broken_down = gmtime(&t);
@@ -224,6 +232,52 @@ TEST(time, strftime_l) {
   freelocale(cloc);
 }
 
+TEST(time, android_strftime_format) {
+#if defined(__BIONIC__)
+  setenv("TZ", "America/Los_Angeles", 1);
+  tzset();
+
+  const char* formats[] = {
+    "%Y-%m-%d %H:%M:%S", "%c", "%D %F %R %r %T %v %X %x %+", "%Ey %Od %_H %-M %0S %^a %#b %#Z",
+    "%A %a %B %b %C %d %e %G %g %h %I %j %k %l %m %n %P %p %s %t %U %u %V %W %w %y %z %Z %%",
+    "%-Y %_d %-m", "%q", "trailing %", "",
+  };
+  time_t times[] = { 0, 1, 1234567890, 1700000000, -1234567890, 4102444800 };
+  for (const char* format : formats) {
+    android_strftime_plan* plan = android_strftime_compile(format);
+    ASSERT_TRUE(plan != nullptr);
+    for (time_t t : times) {
+      struct tm tm;
+      localtime_r(&t, &tm);
+      for (size_t size : { 64, 16, 1, 0 }) {
+        char expected[64] = "";
+        char actual[64] = "";
+        SCOPED_TRACE(format);
+        ASSERT_EQ(strftime(expected, size, format, &tm),
+                  android_strftime_format(actual, size, plan, &tm));
+        ASSERT_STREQ(expected, actual);
+      }
+    }
+    android_strftime_plan_free(plan);
+  }
+
+  // Fields out of their usual ranges are formatted as strftime does them.
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_year = 20000;
+  tm.tm_mon = 11;
+  tm.tm_mday = -3;
+  tm.tm_sec = 123;
+  android_strftime_plan* plan = android_strftime_compile("%Y-%m-%d %H:%M:%S");
+  char buf[64];
+  EXPECT_EQ(21U, android_strftime_format(buf, sizeof(buf), plan, &tm));
+  EXPECT_STREQ("21900-12--3 00:00:123", buf);
+  android_strftime_plan_free(plan);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
 TEST(time, strptime) {
   setenv("TZ", "UTC", 1);
 
@@ -554,6 +608,76 @@ TEST(time, timer_delete_from_timer_thread) {
 #endif
 }
 
+struct SharedTimerData {
+  std::atomic<int> count;
+  std::atomic<bool> in_callback;
+  std::atomic<bool> overlapped;
+  std::atomic<pid_t> tid;
+};
+
+static void SharedTimerCallback(sigval_t value) {
+  SharedTimerData* data = reinterpret_cast<SharedTimerData*>(value.sival_ptr);
+  if (data->in_callback.exchange(true)) {
+    data->overlapped = true;
+  }
+  data->tid = gettid();
+  usleep(1000);
+  ++data->count;
+  data->in_callback = false;
+}
+
+TEST(time, timer_create_SIGEV_ANDROID_SHARED_THREAD) {
+#if defined(__BIONIC__)
+  constexpr size_t kTimerCount = 16;
+  SharedTimerData data[kTimerCount] = {};
+  timer_t timer_ids[kTimerCount];
+
+  // Each timer fires far more often than its callback can keep up with.
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    sigevent_t se;
+    memset(&se, 0, sizeof(se));
+    se.sigev_notify = SIGEV_ANDROID_SHARED_THREAD;
+    se.sigev_notify_function = SharedTimerCallback;
+    se.sigev_value.sival_ptr = &data[i];
+    ASSERT_EQ(0, timer_create(CLOCK_MONOTONIC, &se, &timer_ids[i]));
+    SetTime(timer_ids[i], 0, 1, 0, 100000);
+  }
+
+  time_t start = time(NULL);
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    while (data[i].count < 3 && (time(NULL) - start) < 5) {
+    }
+    ASSERT_GE(data[i].count, 3) << i;
+  }
+
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    ASSERT_EQ(0, timer_delete(timer_ids[i]));
+  }
+  // Let any callbacks that were already running finish.
+  usleep(100000);
+
+  // A timer's callbacks never overlap, and the timers share a few threads.
+  std::set<pid_t> tids;
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    EXPECT_FALSE(data[i].overlapped) << i;
+    tids.insert(data[i].tid);
+  }
+  EXPECT_LE(tids.size(), 4U);
+
+  // No callbacks run after timer_delete.
+  int counts[kTimerCount];
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    counts[i] = data[i].count;
+  }
+  usleep(100000);
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    EXPECT_EQ(counts[i], data[i].count) << i;
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 TEST(time, clock_gettime) {
   // Try to ensure that our vdso clock_gettime is working.
   timespec ts1;
@@ -574,6 +698,58 @@ TEST(time, clock_gettime) {
   ASSERT_LT(ts2.tv_nsec, 1000000);
 }
 
+TEST(time, clock_gettime_coarse) {
+  clockid_t clocks[][2] = {
+    { CLOCK_MONOTONIC_COARSE, CLOCK_MONOTONIC },
+    { CLOCK_REALTIME_COARSE, CLOCK_REALTIME },
+  };
+  for (auto& pair : clocks) {
+    timespec res;
+    ASSERT_EQ(0, clock_getres(pair[0], &res));
+    ASSERT_EQ(0, res.tv_sec);
+
+    // The coarse clock lags the precise one by about its resolution.
+    timespec coarse;
+    ASSERT_EQ(0, clock_gettime(pair[0], &coarse));
+    timespec precise;
+    ASSERT_EQ(0, clock_gettime(pair[1], &precise));
+    int64_t lag = (precise.tv_sec - coarse.tv_sec) * NS_PER_S + (precise.tv_nsec - coarse.tv_nsec);
+    ASSERT_GE(lag, 0);
+    // (Very generously, since ticks can be late or skipped on idle cpus.)
+    ASSERT_LT(lag, NS_PER_S);
+
+    // And it never goes backwards.
+    timespec later;
+    ASSERT_EQ(0, clock_gettime(pair[0], &later));
+    ASSERT_TRUE(later.tv_sec > coarse.tv_sec ||
+                (later.tv_sec == coarse.tv_sec && later.tv_nsec >= coarse.tv_nsec));
+  }
+}
+
+TEST(time, clock_getres) {
+  // Try to ensure that our vdso clock_getres agrees with the kernel.
+  timespec ts1;
+  ASSERT_EQ(0, clock_getres(CLOCK_MONOTONIC, &ts1));
+  timespec ts2;
+  ASSERT_EQ(0, syscall(__NR_clock_getres, CLOCK_MONOTONIC, &ts2));
+  ASSERT_EQ(ts2.tv_sec, ts1.tv_sec);
+  ASSERT_EQ(ts2.tv_nsec, ts1.tv_nsec);
+
+  errno = 0;
+  ASSERT_EQ(-1, clock_getres(-1, &ts1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(time, time) {
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_REALTIME, &ts));
+  time_t t1;
+  time_t t2 = time(&t1);
+  ASSERT_EQ(t1, t2);
+  ASSERT_GE(t1, ts.tv_sec);
+  ASSERT_LE(t1, ts.tv_sec + 1);
+}
+
 TEST(time, clock) {
   // clock(3) is hard to test, but a 1s sleep should cost less than 1ms.
   clock_t t0 = clock();
@@ -711,3 +887,43 @@ TEST(time, bug_31339449) {
   // The BSDs agree with us, but glibc gets this wrong.
 #endif
 }
+
+TEST(time, android_tzstate_write) {
+#if defined(__BIONIC__)
+  TemporaryFile tf;
+  ASSERT_EQ(0, android_tzstate_write(tf.fd));
+
+  char magic[8];
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(magic)), pread(tf.fd, magic, sizeof(magic), 0));
+  ASSERT_STREQ("tzstat1", magic);
+  ASSERT_GT(lseek(tf.fd, 0, SEEK_END), 1024);
+
+  // Zones still load the same way after writing an image.
+  time_t t = 1475619727;
+  setenv("TZ", "America/Los_Angeles", 1);
+  tzset();
+  struct tm tm = {};
+  localtime_r(&t, &tm);
+  EXPECT_EQ(15, tm.tm_hour);
+  EXPECT_STREQ("PDT", tm.tm_zone);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(time, localtime_r_many_zone_changes) {
+  // 2016-10-04 22:22:07 UTC.
+  time_t t = 1475619727;
+  // Go through more zones than are kept loaded, and then back through them.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int hours_west = 0; hours_west < 24; ++hours_west) {
+      char tz[16];
+      snprintf(tz, sizeof(tz), "GMT+%d", hours_west);
+      setenv("TZ", tz, 1);
+      struct tm tm = {};
+      ASSERT_TRUE(localtime_r(&t, &tm) != nullptr);
+      EXPECT_EQ((22 - hours_west + 24) % 24, tm.tm_hour) << tz;
+      EXPECT_EQ(t, mktime(&tm)) << tz;
+    }
+  }
+}
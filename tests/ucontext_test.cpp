@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <ucontext.h>
+
+#include <vector>
+
+#if !defined(__mips__)
+
+TEST(ucontext, getcontext_setcontext) {
+  volatile int calls = 0;
+  ucontext_t uc;
+  ASSERT_EQ(0, getcontext(&uc));
+  if (++calls < 3) {
+    setcontext(&uc);
+    FAIL(); // Unreachable.
+  }
+  ASSERT_EQ(3, calls);
+}
+
+static ucontext_t g_main_context;
+static ucontext_t g_func_context;
+static std::vector<long> g_args;
+static int g_switches;
+
+static void context_func(long a, long b, long c, long d, long e, long f, long g, long h, long i,
+                         long j) {
+  g_args = {a, b, c, d, e, f, g, h, i, j};
+  for (int n = 0; n < 3; ++n) {
+    ++g_switches;
+    swapcontext(&g_func_context, &g_main_context);
+  }
+  // Returning switches to uc_link.
+}
+
+TEST(ucontext, makecontext_swapcontext) {
+  std::vector<char> stack(64 * 1024);
+  ASSERT_EQ(0, getcontext(&g_func_context));
+  g_func_context.uc_stack.ss_sp = stack.data();
+  g_func_context.uc_stack.ss_size = stack.size();
+  g_func_context.uc_link = &g_main_context;
+  // More arguments than any architecture passes in registers.
+  makecontext(&g_func_context, reinterpret_cast<void (*)()>(context_func), 10,
+              1L, 2L, 3L, 4L, 5L, 6L, 7L, 8L, 9L, 10L);
+
+  g_switches = 0;
+  volatile double d = 1.25; // Callee-saved floating-point registers have to survive too.
+  for (int n = 1; n <= 3; ++n) {
+    ASSERT_EQ(0, swapcontext(&g_main_context, &g_func_context));
+    ASSERT_EQ(n, g_switches);
+  }
+  ASSERT_EQ(std::vector<long>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), g_args);
+  // This time context_func returns, to g_main_context.
+  ASSERT_EQ(0, swapcontext(&g_main_context, &g_func_context));
+  ASSERT_EQ(3, g_switches);
+  ASSERT_EQ(1.25, d * 1);
+}
+
+static void blocking_func() {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  sigprocmask(SIG_BLOCK, &set, nullptr);
+  swapcontext(&g_func_context, &g_main_context);
+}
+
+TEST(ucontext, swapcontext_signal_mask) {
+  sigset_t original;
+  sigprocmask(SIG_SETMASK, nullptr, &original);
+
+  std::vector<char> stack(64 * 1024);
+  ASSERT_EQ(0, getcontext(&g_func_context));
+  g_func_context.uc_stack.ss_sp = stack.data();
+  g_func_context.uc_stack.ss_size = stack.size();
+  g_func_context.uc_link = &g_main_context;
+  makecontext(&g_func_context, blocking_func, 0);
+
+  // The mask blocking_func set comes back with us, and goes with it.
+  ASSERT_EQ(0, swapcontext(&g_main_context, &g_func_context));
+  sigset_t current;
+  sigprocmask(SIG_SETMASK, nullptr, &current);
+  ASSERT_EQ(0, sigismember(&current, SIGUSR1));
+  ASSERT_EQ(1, sigismember(&g_func_context.uc_sigmask, SIGUSR1));
+
+  ASSERT_EQ(0, swapcontext(&g_main_context, &g_func_context));
+  sigprocmask(SIG_SETMASK, nullptr, &current);
+  ASSERT_EQ(0, sigismember(&current, SIGUSR1));
+
+  sigprocmask(SIG_SETMASK, &original, nullptr);
+}
+
+#endif
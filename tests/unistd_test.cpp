@@ -26,6 +26,7 @@
 #include <libgen.h>
 #include <limits.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <sys/capability.h>
 #include <sys/param.h>
 #include <sys/syscall.h>
@@ -375,6 +376,90 @@ TEST(UNISTD_TEST, clearenv) {
   EXPECT_EQ(0, unsetenv("test-variable"));
 }
 
+TEST(UNISTD_TEST, getenv_environ_assignment) {
+  extern char** environ;
+  char** old_environ = environ;
+  ASSERT_EQ(0, setenv("test-variable", "b", 1));
+
+  // POSIX lets programs replace the whole environment by assigning environ.
+  char a1[] = "A=1";
+  char b2[] = "B=2";
+  char* env[] = { a1, b2, nullptr };
+  environ = env;
+  EXPECT_STREQ("1", getenv("A"));
+  EXPECT_STREQ("2", getenv("B"));
+  EXPECT_EQ(nullptr, getenv("test-variable"));
+
+  // Including with a new array at the same address as the old one.
+  char a3[] = "A=3";
+  char c4[] = "C=4";
+  env[0] = c4;
+  env[1] = a3;
+  environ = env;
+  EXPECT_STREQ("3", getenv("A"));
+  EXPECT_EQ(nullptr, getenv("B"));
+  EXPECT_STREQ("4", getenv("C"));
+
+  environ = old_environ;
+  EXPECT_EQ(nullptr, getenv("A"));
+  EXPECT_STREQ("b", getenv("test-variable"));
+  ASSERT_EQ(0, unsetenv("test-variable"));
+}
+
+TEST(UNISTD_TEST, getenv_environ_assignment_repeated) {
+  extern char** environ;
+  char** old_environ = environ;
+
+  // Each new environ replaces getenv's index; this checks lookups stay right
+  // once it has stopped keeping the old ones around.
+  for (int i = 0; i < 64; ++i) {
+    char a[16];
+    snprintf(a, sizeof(a), "A=%d", i);
+    char* env[] = { a, nullptr };
+    environ = env;
+    for (int j = 0; j < 16; ++j) {
+      ASSERT_STREQ(std::to_string(i).c_str(), getenv("A"));
+    }
+    ASSERT_EQ(nullptr, getenv("B"));
+  }
+
+  environ = old_environ;
+  EXPECT_EQ(nullptr, getenv("A"));
+}
+
+TEST(UNISTD_TEST, getenv_many) {
+  // Enough variables, looked up often enough, for getenv to index them.
+  for (int i = 0; i < 500; ++i) {
+    std::string name = "test-variable-" + std::to_string(i);
+    ASSERT_EQ(0, setenv(name.c_str(), std::to_string(i).c_str(), 1));
+  }
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int i = 0; i < 500; ++i) {
+      std::string name = "test-variable-" + std::to_string(i);
+      ASSERT_STREQ(std::to_string(i).c_str(), getenv(name.c_str()));
+      // getenv ignores anything from an '='.
+      ASSERT_STREQ(std::to_string(i).c_str(), getenv((name + "=x").c_str()));
+    }
+    ASSERT_EQ(nullptr, getenv("test-variable-500"));
+  }
+  for (int i = 0; i < 500; i += 2) {
+    ASSERT_EQ(0, unsetenv(("test-variable-" + std::to_string(i)).c_str()));
+  }
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int i = 0; i < 500; ++i) {
+      std::string name = "test-variable-" + std::to_string(i);
+      if (i % 2 == 0) {
+        ASSERT_EQ(nullptr, getenv(name.c_str()));
+      } else {
+        ASSERT_STREQ(std::to_string(i).c_str(), getenv(name.c_str()));
+      }
+    }
+  }
+  for (int i = 1; i < 500; i += 2) {
+    ASSERT_EQ(0, unsetenv(("test-variable-" + std::to_string(i)).c_str()));
+  }
+}
+
 static void TestFsyncFunction(int (*fn)(int)) {
   int fd;
 
@@ -740,7 +825,7 @@ TEST(UNISTD_TEST, _POSIX_macros_smoke) {
   EXPECT_GT(_POSIX_THREAD_DESTRUCTOR_ITERATIONS, 0);
   EXPECT_EQ(_POSIX_THREAD_KEYS_MAX, 128);
   EXPECT_EQ(_POSIX_VERSION, _POSIX_THREAD_PRIORITY_SCHEDULING);
-  EXPECT_EQ(-1, _POSIX_THREAD_PRIO_INHERIT);
+  EXPECT_EQ(_POSIX_VERSION, _POSIX_THREAD_PRIO_INHERIT);
   EXPECT_EQ(-1, _POSIX_THREAD_PRIO_PROTECT);
   EXPECT_EQ(-1, _POSIX_THREAD_ROBUST_PRIO_PROTECT);
   EXPECT_EQ(_POSIX_VERSION, _POSIX_THREAD_SAFE_FUNCTIONS);
@@ -884,7 +969,7 @@ TEST(UNISTD_TEST, sysconf) {
   VERIFY_SYSCONF_POSIX_VERSION(_SC_THREAD_ATTR_STACKADDR);
   VERIFY_SYSCONF_POSIX_VERSION(_SC_THREAD_ATTR_STACKSIZE);
   VERIFY_SYSCONF_POSIX_VERSION(_SC_THREAD_PRIORITY_SCHEDULING);
-  VERIFY_SYSCONF_UNSUPPORTED(_SC_THREAD_PRIO_INHERIT);
+  VERIFY_SYSCONF_POSIX_VERSION(_SC_THREAD_PRIO_INHERIT);
   VERIFY_SYSCONF_UNSUPPORTED(_SC_THREAD_PRIO_PROTECT);
   VERIFY_SYSCONF_POSIX_VERSION(_SC_THREAD_SAFE_FUNCTIONS);
   VERIFY_SYSCONF_POSITIVE(_SC_NPROCESSORS_CONF);
@@ -22,6 +22,9 @@
 #include <stdint.h>
 #include <wchar.h>
 
+#include <string>
+#include <vector>
+
 #include "math_data_test.h"
 
 #define NUM_WCHARS(num_bytes) ((num_bytes)/sizeof(wchar_t))
@@ -447,6 +450,101 @@ TEST(wchar, mbsnrtowcs) {
   ASSERT_EQ(&s[3], src);
 }
 
+TEST(wchar, mbsnrtowcs_long_mixed) {
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_CTYPE, "C.UTF-8"));
+  uselocale(LC_GLOBAL_LOCALE);
+
+  // Long enough for the ASCII runs to be handled a word at a time, at every alignment.
+  std::string s;
+  for (size_t i = 0; i < 8; ++i) {
+    s += "The quick brown fox jumps over the lazy dog. ";
+    s += "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 ";
+    s += std::string(i, 'x');
+  }
+
+  for (size_t offset = 0; offset < 16; ++offset) {
+    std::string buf = std::string(offset, ' ') + s;
+    const char* str = buf.c_str() + offset;
+
+    std::vector<wchar_t> expected;
+    mbstate_t ps;
+    memset(&ps, 0, sizeof(ps));
+    for (const char* p = str; *p != '\0';) {
+      wchar_t wc;
+      size_t r = mbrtowc(&wc, p, MB_CUR_MAX, &ps);
+      ASSERT_GT(r, 0U);
+      ASSERT_LE(r, 4U);
+      expected.push_back(wc);
+      p += r;
+    }
+
+    const char* src = str;
+    ASSERT_EQ(expected.size(), mbsrtowcs(nullptr, &src, 0, nullptr));
+
+    std::vector<wchar_t> dst(expected.size() + 1, L'z');
+    src = str;
+    ASSERT_EQ(expected.size(), mbsrtowcs(dst.data(), &src, dst.size(), nullptr));
+    ASSERT_EQ(nullptr, src);
+    ASSERT_EQ(L'\0', dst[expected.size()]);
+    dst.pop_back();
+    ASSERT_EQ(expected, dst);
+
+    // Stop short, in the middle of an ASCII run.
+    src = str;
+    ASSERT_EQ(10U, mbsrtowcs(dst.data(), &src, 10, nullptr));
+    ASSERT_EQ(str + 10, src);
+  }
+}
+
+TEST(wchar, mbsnrtowcs_errors_after_ascii_runs) {
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_CTYPE, "C.UTF-8"));
+  uselocale(LC_GLOBAL_LOCALE);
+
+  std::string ascii(100, 'a');
+  wchar_t dst[256];
+
+  // An invalid sequence is reported where it starts.
+  std::string invalid = ascii + "\xc0\x80" + ascii;
+  const char* src = invalid.c_str();
+  errno = 0;
+  ASSERT_EQ(static_cast<size_t>(-1), mbsrtowcs(dst, &src, 256, nullptr));
+  ASSERT_EQ(EILSEQ, errno);
+  ASSERT_EQ(invalid.c_str() + 100, src);
+
+  // So is a surrogate.
+  std::string surrogate = ascii + "\xed\xa0\x80";
+  src = surrogate.c_str();
+  ASSERT_EQ(static_cast<size_t>(-1), mbsrtowcs(nullptr, &src, 0, nullptr));
+  ASSERT_EQ(EILSEQ, errno);
+
+  // A sequence cut short by the terminating NUL is invalid too.
+  std::string truncated = ascii + "\xe2\x82";
+  src = truncated.c_str();
+  ASSERT_EQ(static_cast<size_t>(-1), mbsrtowcs(dst, &src, 256, nullptr));
+  ASSERT_EQ(truncated.c_str() + 100, src);
+}
+
+TEST(wchar, mbsnrtowcs_continues_sequence_from_state) {
+  ASSERT_STREQ("C.UTF-8", setlocale(LC_CTYPE, "C.UTF-8"));
+  uselocale(LC_GLOBAL_LOCALE);
+
+  mbstate_t ps;
+  memset(&ps, 0, sizeof(ps));
+  wchar_t wc;
+  ASSERT_EQ(static_cast<size_t>(-2), mbrtowc(&wc, "\xe2\x82", 2, &ps));
+
+  std::string rest = "\xac" + std::string(40, 'a') + "\xc3\xa9";
+  const char* src = rest.c_str();
+  wchar_t dst[64];
+  ASSERT_EQ(42U, mbsrtowcs(dst, &src, 64, &ps));
+  ASSERT_EQ(nullptr, src);
+  ASSERT_EQ(L'\u20ac', dst[0]);
+  ASSERT_EQ(L'a', dst[1]);
+  ASSERT_EQ(L'a', dst[40]);
+  ASSERT_EQ(L'\u00e9', dst[41]);
+  ASSERT_TRUE(mbsinit(&ps));
+}
+
 TEST(wchar, wcsftime) {
   setenv("TZ", "UTC", 1);
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "utils.h"
+
+#if defined(__BIONIC__)
+#include <android/work_queue.h>
+
+static void Increment(void* arg) {
+  ++*reinterpret_cast<std::atomic<int>*>(arg);
+}
+
+struct Fanout {
+  android_work_group* group;
+  std::atomic<int> count;
+  std::atomic<int> budget;
+};
+
+// Submits two more items from inside a worker until the budget runs out, so that most of
+// the work is pushed onto workers' own deques and has to be stolen.
+static void FanoutFn(void* arg) {
+  Fanout* fanout = reinterpret_cast<Fanout*>(arg);
+  ++fanout->count;
+  if (fanout->budget.fetch_sub(1) > 0) {
+    android_work_group_submit(fanout->group, FanoutFn, fanout);
+    android_work_group_submit(fanout->group, FanoutFn, fanout);
+  }
+}
+#endif
+
+TEST(work_queue, smoke) {
+#if defined(__BIONIC__)
+  android_work_group* group = android_work_group_create();
+  ASSERT_TRUE(group != nullptr);
+  std::atomic<int> count(0);
+  for (size_t i = 0; i < 10000; ++i) {
+    android_work_group_submit(group, Increment, &count);
+  }
+  android_work_group_wait(group);
+  ASSERT_EQ(10000, count);
+
+  // A group can be reused after waiting.
+  android_work_group_submit(group, Increment, &count);
+  android_work_group_destroy(group);
+  ASSERT_EQ(10001, count);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}
+
+TEST(work_queue, wait_without_work) {
+#if defined(__BIONIC__)
+  android_work_group* group = android_work_group_create();
+  ASSERT_TRUE(group != nullptr);
+  android_work_group_wait(group);
+  android_work_group_destroy(group);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}
+
+TEST(work_queue, submit_from_work) {
+#if defined(__BIONIC__)
+  android_work_group* group = android_work_group_create();
+  ASSERT_TRUE(group != nullptr);
+  Fanout fanout;
+  fanout.group = group;
+  fanout.count = 0;
+  fanout.budget = 1000;
+  android_work_group_submit(group, FanoutFn, &fanout);
+  android_work_group_wait(group);
+  // Each of the first 1000 items to run adds two more.
+  ASSERT_EQ(2001, fanout.count);
+  android_work_group_destroy(group);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}
+
+TEST(work_queue, fork) {
+#if defined(__BIONIC__)
+  // Start the workers in the parent, then check that the child gets its own.
+  android_work_group* group = android_work_group_create();
+  ASSERT_TRUE(group != nullptr);
+  std::atomic<int> count(0);
+  android_work_group_submit(group, Increment, &count);
+  android_work_group_wait(group);
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    for (size_t i = 0; i < 1000; ++i) {
+      android_work_group_submit(group, Increment, &count);
+    }
+    android_work_group_wait(group);
+    _exit(count == 1001 ? 0 : 1);
+  }
+  AssertChildExited(pid, 0);
+
+  android_work_group_submit(group, Increment, &count);
+  android_work_group_destroy(group);
+  ASSERT_EQ(2, count);
+#else
+  GTEST_LOG_(INFO) << "This test tests bionic-specific API.\n";
+#endif
+}